@@ -0,0 +1,314 @@
+// Times the phases of a conflict analysis on synthetic data, without MySQL:
+// protection zones of N procedures with M vertices each are parsed into
+// ProtectionGeometryCache and indexed, then project FeatureCollections of
+// points, lines, polygons and a mix of them are parsed, matched against the
+// index (built, and updated for one edited zone) and evaluated zone by zone with ZoneEvaluator in the three storage
+// modes (predicates only, triage metrics, materialized intersections),
+// with and without GEOS prepared zones. Everything derives from the seed,
+// so two runs on one build see the same geometries.
+// Allocation counts are C++ operator new calls (GDAL's own CPLMalloc and
+// GEOS internals are not seen), taken from the first run of each phase.
+// Parsing and evaluation also run on an AnalysisArena as analyzeProject
+// does ("arena" cases); the arena's own counts are printed below them.
+// Run: ./bench_conflicts [procedures] [vertices] [features] [iterations] [seed]
+#include "AnalysisArena.h"
+#include "ConflictMetrics.h"
+#include "GeoJsonReader.h"
+#include "OgrHandles.h"
+#include "ProtectionGeometryCache.h"
+#include "ProtectionIndex.h"
+#include "ZoneEvaluator.h"
+#include "ogr_api.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::atomic<uint64_t> allocation_count{0};
+std::atomic<uint64_t> allocation_bytes{0};
+
+} // namespace
+
+void* operator new(std::size_t size) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    allocation_bytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+using namespace aeronautical;
+
+namespace {
+
+// Zones and features fall in this box (degrees), dense enough for overlaps
+constexpr double kMinLng = 0.0, kMaxLng = 10.0, kMinLat = 40.0, kMaxLat = 50.0;
+
+struct Measurement {
+    double best_us = 1e300;
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;
+};
+
+template <typename F>
+Measurement measure(int iterations, F&& run) {
+    Measurement m;
+    for (int i = 0; i < iterations; i++) {
+        const uint64_t count = allocation_count.load(std::memory_order_relaxed);
+        const uint64_t bytes = allocation_bytes.load(std::memory_order_relaxed);
+        auto start = std::chrono::steady_clock::now();
+        run();
+        std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+        if (i == 0) {
+            m.allocations = allocation_count.load(std::memory_order_relaxed) - count;
+            m.bytes = allocation_bytes.load(std::memory_order_relaxed) - bytes;
+        }
+        m.best_us = std::min(m.best_us, elapsed.count());
+    }
+    return m;
+}
+
+void report(const char* phase, const char* detail, const Measurement& m) {
+    std::printf("  %-12s %-24s %12.1f %12llu %12llu\n", phase, detail, m.best_us,
+                static_cast<unsigned long long>(m.allocations), static_cast<unsigned long long>(m.bytes));
+}
+
+void appendPosition(std::string& out, double lng, double lat) {
+    char buffer[64];
+    std::snprintf(buffer, sizeof(buffer), "[%.6f,%.6f]", lng, lat);
+    out += buffer;
+}
+
+// Star-shaped ring (angles increase, radius jitters), so it never self-intersects
+std::string ring(std::mt19937& rng, double lng, double lat, double radius, size_t vertices) {
+    std::uniform_real_distribution<double> jitter(0.8, 1.2);
+    std::string out = "[";
+    std::string first;
+    for (size_t i = 0; i < vertices; i++) {
+        const double angle = 2.0 * M_PI * static_cast<double>(i) / static_cast<double>(vertices);
+        const double r = radius * jitter(rng);
+        std::string position;
+        appendPosition(position, lng + r * std::cos(angle), lat + r * std::sin(angle));
+        if (i == 0) first = position;
+        out += position + ",";
+    }
+    out += first + "]";
+    return out;
+}
+
+std::string protectionGeoJson(std::mt19937& rng, size_t vertices) {
+    std::uniform_real_distribution<double> lng(kMinLng, kMaxLng), lat(kMinLat, kMaxLat), radius(0.05, 0.5);
+    return R"({"type":"Polygon","coordinates":[)" + ring(rng, lng(rng), lat(rng), radius(rng), vertices) + "]}";
+}
+
+enum class FeatureMix { Points, Lines, Polygons, Mixed };
+
+const char* mixName(FeatureMix mix) {
+    switch (mix) {
+        case FeatureMix::Points: return "points";
+        case FeatureMix::Lines: return "lines";
+        case FeatureMix::Polygons: return "polygons";
+        case FeatureMix::Mixed: return "mixed";
+    }
+    return "?";
+}
+
+std::string projectGeoJson(std::mt19937& rng, size_t features, FeatureMix mix) {
+    std::uniform_real_distribution<double> lng(kMinLng, kMaxLng), lat(kMinLat, kMaxLat);
+    std::uniform_real_distribution<double> step(-0.01, 0.01), radius(0.01, 0.1);
+    std::uniform_int_distribution<int> line_vertices(2, 20), polygon_vertices(8, 64), kind(0, 2);
+
+    std::string out = R"({"type":"FeatureCollection","features":[)";
+    for (size_t i = 0; i < features; i++) {
+        if (i > 0) out += ",";
+        out += R"({"type":"Feature","properties":{},"geometry":)";
+        const int type = mix == FeatureMix::Mixed ? kind(rng) : static_cast<int>(mix);
+        double x = lng(rng), y = lat(rng);
+        if (type == 0) {
+            out += R"({"type":"Point","coordinates":)";
+            appendPosition(out, x, y);
+        } else if (type == 1) {
+            out += R"({"type":"LineString","coordinates":[)";
+            const int count = line_vertices(rng);
+            for (int v = 0; v < count; v++) {
+                if (v > 0) out += ",";
+                appendPosition(out, x, y);
+                x += step(rng);
+                y += step(rng);
+            }
+            out += "]";
+        } else {
+            out += R"({"type":"Polygon","coordinates":[)" +
+                   ring(rng, x, y, radius(rng), static_cast<size_t>(polygon_vertices(rng))) + "]";
+        }
+        out += "}}";
+    }
+    out += "]}";
+    return out;
+}
+
+std::vector<GeometryHandle> parseFeatures(const std::string& geojson,
+                                          std::pmr::memory_resource* resource = std::pmr::get_default_resource()) {
+    std::vector<GeoJsonFeature> features;
+    std::string error;
+    std::vector<GeometryHandle> geometries;
+    if (!GeoJsonReader::read(geojson, features, error, nullptr, resource)) {
+        std::fprintf(stderr, "synthetic FeatureCollection rejected: %s\n", error.c_str());
+        std::exit(1);
+    }
+    for (const auto& feature : features) {
+        if (feature.geometry) geometries.push_back(toHandle(feature.geometry->toOGR()));
+    }
+    return geometries;
+}
+
+void reportArena(const AnalysisArena& arena) {
+    const auto stats = arena.stats();
+    std::printf("  %-12s %-24s arena: %zu allocations, %zu bytes in %zu blocks of %zu bytes\n", "", "",
+                stats.allocations, stats.bytes, stats.blocks, stats.reserved);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const size_t procedures = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 500;
+    const size_t vertices = argc > 2 ? std::max<size_t>(3, std::strtoul(argv[2], nullptr, 10)) : 256;
+    const size_t features = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 200;
+    const int iterations = argc > 4 ? std::max(1, std::atoi(argv[4])) : 5;
+    const unsigned seed = argc > 5 ? static_cast<unsigned>(std::strtoul(argv[5], nullptr, 10)) : 7;
+
+    OGRRegisterAll();
+    std::mt19937 rng(seed);
+    std::vector<std::string> zone_texts;
+    zone_texts.reserve(procedures);
+    for (size_t i = 0; i < procedures; i++) zone_texts.push_back(protectionGeoJson(rng, vertices));
+    std::vector<std::string> projects;
+    for (FeatureMix mix : {FeatureMix::Points, FeatureMix::Lines, FeatureMix::Polygons, FeatureMix::Mixed}) {
+        projects.push_back(projectGeoJson(rng, features, mix));
+    }
+
+    std::printf("%zu procedures x %zu vertices, %zu features per project, best of %d, seed %u\n", procedures,
+                vertices, features, iterations, seed);
+    std::printf("  %-12s %-24s %12s %12s %12s\n", "phase", "case", "best us", "allocs", "alloc bytes");
+
+    auto& cache = ProtectionGeometryCache::getInstance();
+    const auto version = std::chrono::system_clock::time_point(std::chrono::seconds(1700000000));
+    for (bool prepared : {false, true}) {
+        cache.setPreparedGeometryEnabled(prepared);
+        const char* zones_case = prepared ? "zones, prepared" : "zones";
+
+        std::vector<std::shared_ptr<const CachedProtectionGeometry>> zones;
+        report("load_zones", zones_case, measure(iterations, [&]() {
+                   cache.clear();
+                   zones.clear();
+                   for (size_t i = 0; i < zone_texts.size(); i++) {
+                       zones.push_back(cache.insert(static_cast<int>(i) + 1, version, zone_texts[i]));
+                   }
+               }));
+        zones.erase(std::remove(zones.begin(), zones.end(), nullptr), zones.end());
+
+        std::vector<OGREnvelope> envelopes;
+        for (const auto& zone : zones) envelopes.push_back(zone->envelope);
+        ProtectionIndex index;
+        report("index", zones_case, measure(iterations, [&]() { index.build(envelopes); }));
+        {
+            // One procedure edited: its zone leaves the tree and comes back as an insert
+            std::vector<uint32_t> slot_map(envelopes.size());
+            std::iota(slot_map.begin(), slot_map.end(), 0u);
+            std::vector<std::pair<size_t, OGREnvelope>> added;
+            if (!envelopes.empty()) {
+                slot_map[0] = ProtectionIndex::kRemoved;
+                added.emplace_back(0, envelopes[0]);
+            }
+            const std::string label = std::string(zones_case) + ", one edit";
+            ProtectionIndex edited;
+            report("index", label.c_str(), measure(iterations, [&]() { edited = index.updated(slot_map, added); }));
+        }
+
+        for (size_t p = 0; p < projects.size(); p++) {
+            const char* mix = mixName(static_cast<FeatureMix>(p));
+            std::vector<GeometryHandle> geometries;
+            report("parse", mix, measure(iterations, [&]() {
+                       geometries.clear();
+                       geometries = parseFeatures(projects[p]);
+                   }));
+            {
+                std::unique_ptr<AnalysisArena> arena;
+                const std::string label = std::string(mix) + ", arena";
+                report("parse", label.c_str(), measure(iterations, [&]() {
+                           geometries.clear();
+                           arena = std::make_unique<AnalysisArena>();
+                           geometries = parseFeatures(projects[p], arena.get());
+                       }));
+                reportArena(*arena);
+            }
+
+            std::vector<std::vector<size_t>> features_by_zone(zones.size());
+            size_t pairs = 0;
+            report("candidates", mix, measure(iterations, [&]() {
+                       for (auto& list : features_by_zone) list.clear();
+                       pairs = 0;
+                       std::vector<size_t> hits;
+                       for (size_t i = 0; i < geometries.size(); i++) {
+                           OGREnvelope envelope;
+                           OGR_G_GetEnvelope(geometries[i].get(), &envelope);
+                           index.query(envelope, hits);
+                           for (size_t slot : hits) features_by_zone[slot].push_back(i);
+                           pairs += hits.size();
+                       }
+                   }));
+
+            struct Mode {
+                const char* name;
+                bool materialize;
+                bool metrics;
+            };
+            for (const Mode& mode : {Mode{"predicates", false, false}, Mode{"triage", false, true},
+                                     Mode{"materialize", true, true}}) {
+                size_t conflicts = 0;
+                const std::string label = std::string(mix) + ", " + mode.name;
+                report("evaluate", label.c_str(), measure(iterations, [&]() {
+                           conflicts = 0;
+                           for (size_t slot = 0; slot < zones.size(); slot++) {
+                               if (features_by_zone[slot].empty()) continue;
+                               auto result = ZoneEvaluator::evaluate(*zones[slot], zones[slot]->procedure_id, geometries,
+                                                                     features_by_zone[slot], mode.materialize,
+                                                                     mode.metrics);
+                               conflicts += result.conflict ? 1 : 0;
+                           }
+                       }));
+                std::printf("  %-12s %-24s %zu candidate pairs, %zu zones in conflict\n", "", "", pairs, conflicts);
+
+                // Results kept until the run ends, as analyzeProject keeps them
+                std::unique_ptr<AnalysisArena> arena;
+                const std::string arena_label = label + ", arena";
+                report("evaluate", arena_label.c_str(), measure(iterations, [&]() {
+                           arena = std::make_unique<AnalysisArena>();
+                           std::pmr::vector<std::optional<ZoneEvaluator::Result>> results(zones.size(), arena.get());
+                           for (size_t slot = 0; slot < zones.size(); slot++) {
+                               if (features_by_zone[slot].empty()) continue;
+                               results[slot].emplace(ZoneEvaluator::evaluate(
+                                   *zones[slot], zones[slot]->procedure_id, geometries, features_by_zone[slot],
+                                   mode.materialize, mode.metrics, arena.get()));
+                           }
+                       }));
+                reportArena(*arena);
+            }
+        }
+    }
+    return 0;
+}
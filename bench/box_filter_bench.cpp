@@ -0,0 +1,96 @@
+// Compares the scalar point-in-box loop with the kernel BoxFilter picks on
+// this CPU, over random latitude/longitude columns and boxes from a few
+// degrees wide to the whole globe (plus one across the antimeridian), then
+// times SpatialGrid::query on the same points.
+// Run: ./box_filter_bench [count] [iterations]
+#include "BoxFilter.h"
+#include "SpatialGrid.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace aeronautical;
+
+namespace {
+
+struct Point {
+    double latitude;
+    double longitude;
+};
+
+template <typename F>
+double bestOfUs(int iterations, F&& run) {
+    double best = 1e300;
+    for (int i = 0; i < iterations; i++) {
+        auto start = std::chrono::steady_clock::now();
+        run();
+        std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+        if (elapsed.count() < best) best = elapsed.count();
+    }
+    return best;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    int iterations = argc > 2 ? std::atoi(argv[2]) : 20;
+
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<double> lat_dist(-90.0, 90.0), lng_dist(-180.0, 180.0);
+    std::vector<Point> points(count);
+    std::vector<double> lat(count), lng(count);
+    for (size_t i = 0; i < count; i++) {
+        points[i] = {lat_dist(rng), lng_dist(rng)};
+        lat[i] = points[i].latitude;
+        lng[i] = points[i].longitude;
+    }
+    SpatialGrid grid;
+    grid.build(points);
+
+    struct Case {
+        const char* label;
+        double min_lat, max_lat, min_lng, max_lng;
+    };
+    const Case cases[] = {
+        {"5x5 deg", 30.0, 35.0, -10.0, -5.0},
+        {"30x60 deg", 20.0, 50.0, -20.0, 40.0},
+        {"antimeridian", -20.0, 20.0, 170.0, -170.0},
+        {"globe", -90.0, 90.0, -180.0, 180.0},
+    };
+
+    const BoxFilter::Kernel active = BoxFilter::active();
+    std::printf("%zu points, best of %d, kernel %s\n", count, iterations, BoxFilter::name(active));
+    std::printf("  %-14s %10s %12s %12s %8s %12s\n", "box", "hits", "scalar us", "kernel us", "speedup", "grid us");
+
+    std::vector<uint32_t> expected(count), actual(count);
+    size_t sink = 0;
+    for (const Case& c : cases) {
+        auto bounds = GeoBounds::fromBox(c.min_lat, c.max_lat, c.min_lng, c.max_lng);
+        if (!bounds) continue;
+
+        size_t hits = BoxFilter::select(BoxFilter::Kernel::Scalar, lat.data(), lng.data(), count, *bounds,
+                                        expected.data());
+        size_t got = BoxFilter::select(active, lat.data(), lng.data(), count, *bounds, actual.data());
+        if (got != hits || !std::equal(expected.begin(), expected.begin() + hits, actual.begin())) {
+            std::fprintf(stderr, "%s kernel differs from scalar on %s\n", BoxFilter::name(active), c.label);
+            return 1;
+        }
+
+        double scalar_us = bestOfUs(iterations, [&] {
+            sink += BoxFilter::select(BoxFilter::Kernel::Scalar, lat.data(), lng.data(), count, *bounds,
+                                      expected.data());
+        });
+        double kernel_us = bestOfUs(iterations, [&] {
+            sink += BoxFilter::select(active, lat.data(), lng.data(), count, *bounds, actual.data());
+        });
+        double grid_us = bestOfUs(iterations, [&] { sink += grid.query(*bounds).size(); });
+        std::printf("  %-14s %10zu %12.1f %12.1f %7.1fx %12.1f\n", c.label, hits, scalar_us, kernel_us,
+                    scalar_us / kernel_us, grid_us);
+    }
+    return sink == 0;
+}
@@ -0,0 +1,612 @@
+// Generates a synthetic dataset of controlled size for scale and load
+// testing: airports with runways, waypoints, flight procedures whose
+// trajectories leave a runway end and whose protection areas are splayed
+// corridors around them, and projects with mixed point, line and polygon
+// features near the airports. Everything derives from the seed, so a size
+// and a seed always name the same dataset.
+//
+// --sql writes bulk INSERT statements (multi-row, at most 4 MB each, one
+// transaction) for airports, airport_runways, waypoints, flight_procedures,
+// projects and their project_geometries collections; "-" streams them to
+// stdout for piping into the mysql client. Airport, runway and waypoint
+// ids are explicit, so load into empty tables. Protection footprints and
+// WKB are not written: the backend fills them in as it would after an
+// import.
+// --snapshot writes the airports, runways and waypoints as a reference
+// snapshot file (see ReferenceSnapshotFile) that a backend started with
+// REFERENCE_SNAPSHOT_PATH serves without MySQL; procedures and projects
+// are not part of that format.
+//
+// Counts default to a 1x dataset and are multiplied by --scale.
+// Run: ./generate_dataset [--scale X] [--airports N] [--waypoints N]
+//                         [--procedures N] [--vertices N] [--projects N]
+//                         [--features N] [--seed S] [--sql PATH|-]
+//                         [--snapshot PATH]
+#include "Airport.h"
+#include "Project.h"
+#include "ReferenceDataStore.h"
+#include "ReferenceSnapshotFile.h"
+#include "Waypoint.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace aeronautical;
+
+namespace {
+
+constexpr double kDegToRad = M_PI / 180.0;
+constexpr double kKmPerDegree = 111.32;
+constexpr size_t kMaxStatementBytes = 4 * 1024 * 1024;
+
+struct Options {
+    double scale = 1.0;
+    size_t airports = 4000;
+    size_t waypoints = 25000;
+    size_t procedures = 3000;
+    size_t vertices = 400; // median per protection area
+    size_t projects = 500;
+    size_t features = 12;  // median per project
+    unsigned seed = 7;
+    std::string sql_path;
+    std::string snapshot_path;
+};
+
+struct Country {
+    const char* code;
+    const char* name;
+    const char* region;
+    char icao_prefix;
+    double lat;
+    double lng;
+    double spread; // degrees
+};
+
+// Airports and waypoints cluster around these, as real traffic does
+const Country kCountries[] = {
+    {"MA", "Morocco", "GMMM", 'G', 32.0, -6.5, 3.5},  {"ES", "Spain", "LECM", 'L', 40.2, -3.7, 3.5},
+    {"FR", "France", "LFFF", 'L', 46.5, 2.4, 3.5},    {"DE", "Germany", "EDWW", 'E', 51.0, 10.3, 3.0},
+    {"GB", "United Kingdom", "EGTT", 'E', 53.0, -1.8, 2.5}, {"IT", "Italy", "LIRR", 'L', 42.8, 12.5, 3.0},
+    {"US", "United States", "KZNY", 'K', 39.0, -96.0, 12.0}, {"BR", "Brazil", "SBBS", 'S', -12.0, -50.0, 9.0},
+    {"IN", "India", "VIDF", 'V', 22.0, 79.0, 7.0},    {"AU", "Australia", "YMMM", 'Y', -27.0, 134.0, 10.0},
+};
+
+struct Rng {
+    std::mt19937 engine;
+
+    explicit Rng(unsigned seed) : engine(seed) {}
+
+    double uniform(double lo, double hi) { return std::uniform_real_distribution<double>(lo, hi)(engine); }
+    int integer(int lo, int hi) { return std::uniform_int_distribution<int>(lo, hi)(engine); }
+    double normal(double mean, double sd) { return std::normal_distribution<double>(mean, sd)(engine); }
+    bool chance(double p) { return uniform(0.0, 1.0) < p; }
+    // Median m, most values within a factor of 3 either way
+    size_t around(size_t m, size_t lo) {
+        return std::max(lo, static_cast<size_t>(static_cast<double>(m) * std::exp(normal(0.0, 0.55))));
+    }
+};
+
+// Base-26 code of n with the given width, e.g. code(0, 3) == "AAA"
+std::string code(size_t n, size_t width) {
+    std::string out(width, 'A');
+    for (size_t i = width; i-- > 0; n /= 26) out[i] = static_cast<char>('A' + n % 26);
+    return out;
+}
+
+// Point at distance km along bearing (degrees) from (lat, lng); flat-earth, fine at these distances
+void move(double& lat, double& lng, double bearing, double km) {
+    lat += km * std::cos(bearing * kDegToRad) / kKmPerDegree;
+    lng += km * std::sin(bearing * kDegToRad) / (kKmPerDegree * std::max(std::cos(lat * kDegToRad), 0.05));
+}
+
+void appendPosition(std::string& out, double lng, double lat) {
+    char buffer[64];
+    std::snprintf(buffer, sizeof(buffer), "[%.6f,%.6f]", lng, lat);
+    out += buffer;
+}
+
+struct Dataset {
+    std::vector<Airport> airports;
+    std::vector<AirportRunway> runways;
+    std::vector<Waypoint> waypoints;
+
+    struct Procedure {
+        std::string code;
+        std::string name;
+        const char* type;
+        std::string airport_icao;
+        std::string runway;
+        std::string trajectory;
+        std::string protection;
+        bool is_active;
+    };
+    std::vector<Procedure> procedures;
+
+    struct GeneratedProject {
+        std::string code;
+        std::string title;
+        ProjectStatus status;
+        ProjectPriority priority;
+        int altitude_max;
+        std::string geometry; // FeatureCollection
+    };
+    std::vector<GeneratedProject> projects;
+};
+
+void generateAirports(Rng& rng, size_t count, Dataset& data) {
+    static const char* surfaces[] = {"ASP", "CON", "ASP", "GRS"};
+    const size_t countries = std::size(kCountries);
+    for (size_t i = 0; i < count; i++) {
+        const Country& country = kCountries[i % countries];
+        Airport a{};
+        a.id = static_cast<int>(i + 1);
+        // Country prefix while three-letter suffixes last, then a letter no country uses
+        static const char spare[] = "ABCDFHIJMNOPQRTUWXZ";
+        a.icao_code = i < 17576 ? country.icao_prefix + code(i, 3)
+                                : spare[(i / 17576 - 1) % (sizeof(spare) - 1)] + code(i, 3);
+        const double kind = rng.uniform(0.0, 1.0);
+        a.airport_type = kind < 0.05 ? "large_airport" : kind < 0.25 ? "medium_airport" : kind < 0.9 ? "small_airport" : "heliport";
+        a.iata_code = (a.airport_type == "large_airport" || a.airport_type == "medium_airport") && i < 17576 ? code(i, 3) : "";
+        a.municipality = "Town " + code(i, 4);
+        a.name = a.municipality + " Airport";
+        a.full_name = a.name + " (" + country.name + ")";
+        a.latitude = std::clamp(country.lat + rng.normal(0.0, country.spread), -85.0, 85.0);
+        a.longitude = std::clamp(country.lng + rng.normal(0.0, country.spread), -179.9, 179.9);
+        a.elevation_ft = std::max(0, static_cast<int>(rng.normal(800.0, 900.0)));
+        a.region = country.region;
+        a.country_code = country.code;
+        a.country_name = country.name;
+        a.is_active = rng.chance(0.97);
+        a.has_tower = a.airport_type != "small_airport" && a.airport_type != "heliport";
+        a.has_ils = a.airport_type == "large_airport" || (a.airport_type == "medium_airport" && rng.chance(0.6));
+
+        const int runway_count = a.airport_type == "large_airport" ? rng.integer(2, 4)
+                                 : a.airport_type == "heliport" ? 0
+                                 : a.airport_type == "medium_airport" ? rng.integer(1, 2)
+                                                                      : 1;
+        a.runway_count = runway_count;
+        a.longest_runway_ft = 0;
+        const double base_heading = rng.uniform(0.0, 180.0);
+        for (int r = 0; r < runway_count; r++) {
+            AirportRunway rw{};
+            rw.id = static_cast<int>(data.runways.size() + 1);
+            rw.airport_id = a.id;
+            // Parallel runways share a heading; crossing ones are rotated
+            rw.le_heading_deg = std::fmod(base_heading + (r % 2 == 1 ? 60.0 : 0.0), 180.0);
+            rw.he_heading_deg = rw.le_heading_deg + 180.0;
+            const int le_number = std::max(1, static_cast<int>(std::lround(rw.le_heading_deg / 10.0)));
+            const char* side = runway_count > 2 ? (r < 2 ? "L" : "R") : "";
+            char le_ident[16], he_ident[16];
+            std::snprintf(le_ident, sizeof(le_ident), "%02d%s", le_number, side);
+            std::snprintf(he_ident, sizeof(he_ident), "%02d%s", le_number + 18, *side ? (*side == 'L' ? "R" : "L") : "");
+            rw.le_ident = le_ident;
+            rw.he_ident = he_ident;
+            rw.runway_identifier = rw.le_ident + "/" + rw.he_ident;
+            rw.length_ft = a.airport_type == "large_airport" ? rng.integer(8000, 13000) : rng.integer(2500, 8000);
+            rw.width_ft = rw.length_ft > 8000 ? 150 : 100;
+            rw.surface_type = surfaces[rng.integer(0, 3)];
+            const double half_km = rw.length_ft * 0.0003048 / 2.0;
+            const double offset_km = 1.2 * (r / 2) + (r % 2 == 1 ? 0.8 : 0.0);
+            double lat = a.latitude, lng = a.longitude;
+            move(lat, lng, rw.le_heading_deg + 90.0, offset_km);
+            rw.le_latitude = lat, rw.le_longitude = lng;
+            move(rw.le_latitude, rw.le_longitude, rw.he_heading_deg, half_km);
+            rw.he_latitude = lat, rw.he_longitude = lng;
+            move(rw.he_latitude, rw.he_longitude, rw.le_heading_deg, half_km);
+            rw.is_active = true;
+            a.longest_runway_ft = std::max(a.longest_runway_ft, rw.length_ft);
+            data.runways.push_back(std::move(rw));
+        }
+        data.airports.push_back(std::move(a));
+    }
+}
+
+void generateWaypoints(Rng& rng, size_t count, Dataset& data) {
+    static const char* usages[] = {"ENROUTE", "TERMINAL", "APPROACH", "SID", "STAR"};
+    for (size_t i = 0; i < count; i++) {
+        // Terminal fixes sit near an airport, the rest spread over the country
+        const Airport& near = data.airports[static_cast<size_t>(rng.integer(0, static_cast<int>(data.airports.size()) - 1))];
+        const bool terminal = rng.chance(0.6);
+        Waypoint w{};
+        w.id = static_cast<int>(i + 1);
+        const double kind = rng.uniform(0.0, 1.0);
+        w.waypoint_type = kind < 0.7 ? "FIX" : kind < 0.82 ? "VOR" : kind < 0.9 ? "NDB" : kind < 0.96 ? "DME" : "TACAN";
+        const bool navaid = w.waypoint_type != "FIX";
+        w.waypoint_code = navaid ? code(i, 3) + code(i / 17576, 1) : code(i * 7919 % 11881376, 5);
+        w.name = navaid ? "Navaid " + code(i, 4) : w.waypoint_code;
+        w.latitude = std::clamp(near.latitude + rng.normal(0.0, terminal ? 0.3 : 2.0), -85.0, 85.0);
+        w.longitude = std::clamp(near.longitude + rng.normal(0.0, terminal ? 0.3 : 2.0), -179.9, 179.9);
+        w.elevation_ft = navaid ? near.elevation_ft : 0;
+        w.country_code = near.country_code;
+        w.country_name = near.country_name;
+        w.region = near.region;
+        if (w.waypoint_type == "VOR" || w.waypoint_type == "DME" || w.waypoint_type == "TACAN") {
+            char frequency[16];
+            std::snprintf(frequency, sizeof(frequency), "%.2f", 108.0 + 0.05 * rng.integer(0, 199));
+            w.frequency = frequency;
+        } else if (w.waypoint_type == "NDB") {
+            w.frequency = std::to_string(rng.integer(190, 535));
+        }
+        w.usage_type = terminal ? usages[rng.integer(1, 4)] : "ENROUTE";
+        w.is_active = rng.chance(0.98);
+        data.waypoints.push_back(std::move(w));
+    }
+    // Codes repeat now and then (FIX codes are hashed); keep the first, as the unique key would
+    std::stable_sort(data.waypoints.begin(), data.waypoints.end(),
+                     [](const Waypoint& a, const Waypoint& b) { return a.waypoint_code < b.waypoint_code; });
+    data.waypoints.erase(std::unique(data.waypoints.begin(), data.waypoints.end(),
+                                     [](const Waypoint& a, const Waypoint& b) { return a.waypoint_code == b.waypoint_code; }),
+                         data.waypoints.end());
+}
+
+// A curving path of segments from (lat, lng) along bearing; positions as (lat, lng)
+std::vector<std::pair<double, double>> path(Rng& rng, double lat, double lng, double bearing, size_t points,
+                                            double length_km) {
+    std::vector<std::pair<double, double>> out;
+    out.reserve(points);
+    // At most a quarter turn over the whole path keeps the corridor simple
+    const double turn = rng.uniform(-90.0, 90.0) / static_cast<double>(std::max<size_t>(points - 1, 1));
+    const double step = length_km / static_cast<double>(std::max<size_t>(points - 1, 1));
+    for (size_t i = 0; i < points; i++) {
+        out.emplace_back(lat, lng);
+        move(lat, lng, bearing, step);
+        bearing += turn;
+    }
+    return out;
+}
+
+// Closed ring around the path, its half-width splaying from start_km to end_km
+std::string corridor(const std::vector<std::pair<double, double>>& points, double start_km, double end_km) {
+    std::vector<std::pair<double, double>> left, right;
+    for (size_t i = 0; i < points.size(); i++) {
+        const auto& a = points[i > 0 ? i - 1 : 0];
+        const auto& b = points[i + 1 < points.size() ? i + 1 : i];
+        const double bearing = std::atan2((b.second - a.second) * std::cos(a.first * kDegToRad), b.first - a.first) /
+                               kDegToRad;
+        const double width = start_km + (end_km - start_km) * static_cast<double>(i) /
+                                            static_cast<double>(std::max<size_t>(points.size() - 1, 1));
+        auto l = points[i], r = points[i];
+        move(l.first, l.second, bearing - 90.0, width);
+        move(r.first, r.second, bearing + 90.0, width);
+        left.push_back(l);
+        right.push_back(r);
+    }
+    std::string out = "[";
+    for (const auto& p : left) {
+        appendPosition(out, p.second, p.first);
+        out += ",";
+    }
+    for (size_t i = right.size(); i-- > 0;) {
+        appendPosition(out, right[i].second, right[i].first);
+        out += ",";
+    }
+    appendPosition(out, left.front().second, left.front().first);
+    out += "]";
+    return out;
+}
+
+void generateProcedures(Rng& rng, const Options& options, size_t count, Dataset& data) {
+    static const char* types[] = {"SID", "STAR", "APPROACH"};
+    std::vector<size_t> with_runways;
+    for (size_t i = 0; i < data.airports.size(); i++) {
+        if (data.airports[i].runway_count > 0) with_runways.push_back(i);
+    }
+    if (with_runways.empty()) return;
+    // Runways are contiguous per airport, in airport order
+    std::vector<size_t> first_runway(data.airports.size() + 1, 0);
+    for (const auto& rw : data.runways) first_runway[static_cast<size_t>(rw.airport_id)]++;
+    for (size_t i = 1; i < first_runway.size(); i++) first_runway[i] += first_runway[i - 1];
+
+    for (size_t i = 0; i < count; i++) {
+        // Busy airports carry most procedures: pick the lower ids more often
+        const double pick = std::pow(rng.uniform(0.0, 1.0), 2.0);
+        const Airport& airport = data.airports[with_runways[static_cast<size_t>(pick * static_cast<double>(with_runways.size() - 1))]];
+        const size_t runway_index = first_runway[static_cast<size_t>(airport.id - 1)] +
+                                    static_cast<size_t>(rng.integer(0, airport.runway_count - 1));
+        const AirportRunway& rw = data.runways[runway_index];
+        const bool reverse = rng.chance(0.5);
+
+        Dataset::Procedure p;
+        p.type = types[i % 3];
+        p.airport_icao = airport.icao_code;
+        p.runway = reverse ? rw.he_ident : rw.le_ident;
+        p.code = airport.icao_code + "-" + p.type + "-" + code(i, 4);
+        p.name = std::string(p.type) + " " + p.runway + " " + code(i, 4);
+        p.is_active = rng.chance(0.95);
+
+        // Departures leave the far runway end along the runway heading; arrivals
+        // are drawn outward from the landing threshold, against it
+        const bool departure = std::strcmp(p.type, "SID") == 0;
+        const double heading = reverse ? rw.he_heading_deg : rw.le_heading_deg;
+        const double start_lat = departure == reverse ? rw.le_latitude : rw.he_latitude;
+        const double start_lng = departure == reverse ? rw.le_longitude : rw.he_longitude;
+        const size_t vertices = std::min<size_t>(options.vertices * 20, rng.around(options.vertices, 16));
+        const double length_km = rng.uniform(15.0, 60.0);
+        const auto points = path(rng, start_lat, start_lng, departure ? heading : heading + 180.0, vertices / 2,
+                                 length_km);
+
+        p.trajectory = R"({"type":"LineString","coordinates":[)";
+        const size_t stride = std::max<size_t>(1, points.size() / 12);
+        for (size_t k = 0; k < points.size(); k += stride) {
+            if (k > 0) p.trajectory += ",";
+            appendPosition(p.trajectory, points[k].second, points[k].first);
+        }
+        p.trajectory += "]}";
+
+        // Primary area, and for most procedures a wider secondary one
+        p.protection = R"({"type":"FeatureCollection","features":[)";
+        p.protection += R"({"type":"Feature","properties":{"area":"primary"},"geometry":{"type":"Polygon","coordinates":[)" +
+                        corridor(points, 0.9, rng.uniform(3.0, 5.0)) + "]}}";
+        if (rng.chance(0.7)) {
+            p.protection += R"(,{"type":"Feature","properties":{"area":"secondary"},"geometry":{"type":"Polygon","coordinates":[)" +
+                            corridor(points, 1.8, rng.uniform(6.0, 9.0)) + "]}}";
+        }
+        p.protection += "]}";
+        data.procedures.push_back(std::move(p));
+    }
+}
+
+void generateProjects(Rng& rng, const Options& options, size_t count, Dataset& data) {
+    static const char* titles[] = {"Crane", "Wind turbine", "Antenna mast", "Drone survey", "Building", "Power line"};
+    for (size_t i = 0; i < count; i++) {
+        const Airport& near = data.airports[static_cast<size_t>(rng.integer(0, static_cast<int>(data.airports.size()) - 1))];
+        Dataset::GeneratedProject project;
+        project.code = "SYN-" + std::to_string(options.seed) + "-" + std::to_string(i + 1);
+        project.title = std::string(titles[i % std::size(titles)]) + " near " + near.name;
+        const double status = rng.uniform(0.0, 1.0);
+        project.status = status < 0.4 ? ProjectStatus::Pending : status < 0.7 ? ProjectStatus::UnderReview
+                         : status < 0.9 ? ProjectStatus::Accepted : ProjectStatus::Refused;
+        const double priority = rng.uniform(0.0, 1.0);
+        project.priority = priority < 0.2 ? ProjectPriority::Low : priority < 0.8 ? ProjectPriority::Normal
+                           : priority < 0.95 ? ProjectPriority::High : ProjectPriority::Critical;
+        project.altitude_max = rng.integer(20, 300);
+
+        // Features within ~15 km of the airport, where procedures are dense
+        const size_t features = rng.around(options.features, 1);
+        project.geometry = R"({"type":"FeatureCollection","features":[)";
+        for (size_t f = 0; f < features; f++) {
+            double lat = near.latitude, lng = near.longitude;
+            move(lat, lng, rng.uniform(0.0, 360.0), rng.uniform(0.5, 15.0));
+            if (f > 0) project.geometry += ",";
+            project.geometry += R"({"type":"Feature","id":)" + std::to_string(f + 1) + R"(,"properties":{"max_height_m":)" +
+                                std::to_string(rng.integer(10, project.altitude_max)) + R"(},"geometry":)";
+            const double kind = rng.uniform(0.0, 1.0);
+            if (kind < 0.4) {
+                project.geometry += R"({"type":"Point","coordinates":)";
+                appendPosition(project.geometry, lng, lat);
+            } else if (kind < 0.7) {
+                project.geometry += R"({"type":"LineString","coordinates":[)";
+                const auto points = path(rng, lat, lng, rng.uniform(0.0, 360.0), static_cast<size_t>(rng.integer(2, 30)),
+                                         rng.uniform(0.2, 8.0));
+                for (size_t k = 0; k < points.size(); k++) {
+                    if (k > 0) project.geometry += ",";
+                    appendPosition(project.geometry, points[k].second, points[k].first);
+                }
+                project.geometry += "]";
+            } else {
+                // A small star-shaped footprint never self-intersects
+                project.geometry += R"({"type":"Polygon","coordinates":[[)";
+                const int vertices = rng.integer(4, 64);
+                const double radius = rng.uniform(0.05, 1.5);
+                std::string first;
+                for (int v = 0; v < vertices; v++) {
+                    double y = lat, x = lng;
+                    move(y, x, 360.0 * v / vertices, radius * rng.uniform(0.7, 1.0));
+                    std::string position;
+                    appendPosition(position, x, y);
+                    if (v == 0) first = position;
+                    project.geometry += position + ",";
+                }
+                project.geometry += first + "]]";
+            }
+            project.geometry += "}}";
+        }
+        project.geometry += "]}";
+        data.projects.push_back(std::move(project));
+    }
+}
+
+// Quoted SQL literal; escapes what mysql_real_escape_string does
+std::string text(const std::string& value) {
+    std::string out = "'";
+    out.reserve(value.size() + 2);
+    for (char c : value) {
+        switch (c) {
+            case '\0': out += "\\0"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\\': out += "\\\\"; break;
+            case '\'': out += "\\'"; break;
+            case '"': out += "\\\""; break;
+            case '\x1a': out += "\\Z"; break;
+            default: out += c;
+        }
+    }
+    return out + "'";
+}
+
+// Multi-row INSERTs of at most kMaxStatementBytes each
+class BulkInsert {
+public:
+    BulkInsert(std::ostream& out, std::string prefix) : out_(out), prefix_(std::move(prefix)) {}
+    ~BulkInsert() { flush(); }
+
+    void add(const std::string& row) {
+        if (rows_ > 0 && statement_.size() + row.size() + 2 > kMaxStatementBytes) flush();
+        statement_ += rows_ == 0 ? prefix_ : ",\n";
+        statement_ += row;
+        rows_++;
+    }
+
+    void flush() {
+        if (rows_ == 0) return;
+        out_ << statement_ << ";\n";
+        statement_.clear();
+        rows_ = 0;
+    }
+
+private:
+    std::ostream& out_;
+    std::string prefix_;
+    std::string statement_;
+    size_t rows_ = 0;
+};
+
+std::string number(double value) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.8f", value);
+    return buffer;
+}
+
+void writeSql(const Dataset& data, std::ostream& out) {
+    out << "SET autocommit = 0;\nSET unique_checks = 0;\nSET foreign_key_checks = 0;\n";
+    {
+        BulkInsert insert(out, "INSERT INTO airports (id, icao_code, iata_code, name, full_name, latitude, longitude, "
+                               "elevation_ft, airport_type, municipality, region, country_code, country_name, is_active, "
+                               "has_tower, has_ils, runway_count, longest_runway_ft) VALUES\n");
+        for (const Airport& a : data.airports) {
+            insert.add("(" + std::to_string(a.id) + ", " + text(a.icao_code) + ", " + text(a.iata_code) + ", " +
+                       text(a.name) + ", " + text(a.full_name) + ", " + number(a.latitude) + ", " + number(a.longitude) +
+                       ", " + std::to_string(a.elevation_ft) + ", " + text(a.airport_type) + ", " + text(a.municipality) +
+                       ", " + text(a.region) + ", " + text(a.country_code) + ", " + text(a.country_name) + ", " +
+                       (a.is_active ? "1" : "0") + ", " + (a.has_tower ? "1" : "0") + ", " + (a.has_ils ? "1" : "0") +
+                       ", " + std::to_string(a.runway_count) + ", " + std::to_string(a.longest_runway_ft) + ")");
+        }
+    }
+    {
+        BulkInsert insert(out, "INSERT INTO airport_runways (id, airport_id, runway_identifier, length_ft, width_ft, "
+                               "surface_type, le_ident, le_heading_deg, le_latitude, le_longitude, he_ident, "
+                               "he_heading_deg, he_latitude, he_longitude, is_active) VALUES\n");
+        for (const AirportRunway& rw : data.runways) {
+            insert.add("(" + std::to_string(rw.id) + ", " + std::to_string(rw.airport_id) + ", " +
+                       text(rw.runway_identifier) + ", " + std::to_string(rw.length_ft) + ", " +
+                       std::to_string(rw.width_ft) + ", " + text(rw.surface_type) + ", " + text(rw.le_ident) + ", " +
+                       number(rw.le_heading_deg) + ", " + number(rw.le_latitude) + ", " + number(rw.le_longitude) +
+                       ", " + text(rw.he_ident) + ", " + number(rw.he_heading_deg) + ", " + number(rw.he_latitude) +
+                       ", " + number(rw.he_longitude) + ", " + (rw.is_active ? "1" : "0") + ")");
+        }
+    }
+    {
+        BulkInsert insert(out, "INSERT INTO waypoints (id, waypoint_code, name, latitude, longitude, elevation_ft, "
+                               "waypoint_type, country_code, country_name, region, frequency, usage_type, is_active) "
+                               "VALUES\n");
+        for (const Waypoint& w : data.waypoints) {
+            insert.add("(" + std::to_string(w.id) + ", " + text(w.waypoint_code) + ", " + text(w.name) + ", " +
+                       number(w.latitude) + ", " + number(w.longitude) + ", " + std::to_string(w.elevation_ft) + ", " +
+                       text(w.waypoint_type) + ", " + text(w.country_code) + ", " + text(w.country_name) + ", " +
+                       text(w.region) + ", " + text(w.frequency) + ", " + text(w.usage_type) + ", " +
+                       (w.is_active ? "1" : "0") + ")");
+        }
+    }
+    {
+        BulkInsert insert(out, "INSERT INTO flight_procedures (procedure_code, name, type, airport_icao, runway, "
+                               "description, trajectory_geometry, protection_geometry, is_active, created_at, "
+                               "updated_at) VALUES\n");
+        for (const auto& p : data.procedures) {
+            insert.add("(" + text(p.code) + ", " + text(p.name) + ", " + text(p.type) + ", " + text(p.airport_icao) +
+                       ", " + text(p.runway) + ", 'Synthetic', " + text(p.trajectory) + ", " + text(p.protection) +
+                       ", " + (p.is_active ? "1" : "0") + ", NOW(), NOW())");
+        }
+    }
+    {
+        BulkInsert insert(out, "INSERT INTO projects (project_code, title, demander_id, demander_name, "
+                               "demander_email, status, priority, altitude_max) VALUES\n");
+        for (const auto& p : data.projects) {
+            insert.add("(" + text(p.code) + ", " + text(p.title) + ", 1, 'Synthetic Demander', "
+                       "'synthetic@example.com', " + text(statusToString(p.status)) + ", " +
+                       text(priorityToString(p.priority)) + ", " + std::to_string(p.altitude_max) + ")");
+        }
+    }
+    // Project ids are the database's; each collection finds its project by code
+    for (const auto& p : data.projects) {
+        out << "INSERT INTO project_geometries (project_id, name, geometry_data, is_primary, geometry_type, "
+               "created_at, updated_at) SELECT id, 'Aggregated Project Geometry', " << text(p.geometry)
+            << ", 1, 'collection', NOW(), NOW() FROM projects WHERE project_code = " << text(p.code) << ";\n";
+    }
+    out << "COMMIT;\n";
+}
+
+bool writeSnapshot(const Dataset& data, const std::string& path) {
+    ReferenceSnapshot snapshot;
+    snapshot.airports = data.airports;
+    snapshot.runways = data.runways;
+    std::sort(snapshot.runways.begin(), snapshot.runways.end(), [](const AirportRunway& a, const AirportRunway& b) {
+        return a.airport_id != b.airport_id ? a.airport_id < b.airport_id : a.runway_identifier < b.runway_identifier;
+    });
+    snapshot.waypoints = data.waypoints; // already in waypoint_code order
+    snapshot.loaded_at = std::chrono::system_clock::now();
+    snapshot.version = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(snapshot.loaded_at.time_since_epoch()).count());
+    return ReferenceSnapshotFile::save(snapshot, path);
+}
+
+[[noreturn]] void usage(const char* reason) {
+    std::fprintf(stderr, "%s\nusage: generate_dataset [--scale X] [--airports N] [--waypoints N] [--procedures N] "
+                         "[--vertices N] [--projects N] [--features N] [--seed S] [--sql PATH|-] "
+                         "[--snapshot PATH]\n", reason);
+    std::exit(2);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (i + 1 >= argc) usage(("missing value for " + arg).c_str());
+        const char* value = argv[++i];
+        if (arg == "--scale") options.scale = std::strtod(value, nullptr);
+        else if (arg == "--airports") options.airports = std::strtoul(value, nullptr, 10);
+        else if (arg == "--waypoints") options.waypoints = std::strtoul(value, nullptr, 10);
+        else if (arg == "--procedures") options.procedures = std::strtoul(value, nullptr, 10);
+        else if (arg == "--vertices") options.vertices = std::max<size_t>(8, std::strtoul(value, nullptr, 10));
+        else if (arg == "--projects") options.projects = std::strtoul(value, nullptr, 10);
+        else if (arg == "--features") options.features = std::max<size_t>(1, std::strtoul(value, nullptr, 10));
+        else if (arg == "--seed") options.seed = static_cast<unsigned>(std::strtoul(value, nullptr, 10));
+        else if (arg == "--sql") options.sql_path = value;
+        else if (arg == "--snapshot") options.snapshot_path = value;
+        else usage(("unknown option " + arg).c_str());
+    }
+    if (options.sql_path.empty() && options.snapshot_path.empty()) usage("give --sql, --snapshot or both");
+    if (options.scale <= 0.0) usage("--scale must be positive");
+    auto scaled = [&](size_t n) { return static_cast<size_t>(std::llround(static_cast<double>(n) * options.scale)); };
+
+    Rng rng(options.seed);
+    Dataset data;
+    generateAirports(rng, std::max<size_t>(1, scaled(options.airports)), data);
+    generateWaypoints(rng, scaled(options.waypoints), data);
+    generateProcedures(rng, options, scaled(options.procedures), data);
+    generateProjects(rng, options, scaled(options.projects), data);
+    std::fprintf(stderr, "%zu airports, %zu runways, %zu waypoints, %zu procedures, %zu projects (seed %u)\n",
+                 data.airports.size(), data.runways.size(), data.waypoints.size(), data.procedures.size(),
+                 data.projects.size(), options.seed);
+
+    if (!options.sql_path.empty()) {
+        if (options.sql_path == "-") {
+            writeSql(data, std::cout);
+            std::cout.flush();
+        } else {
+            std::ofstream out(options.sql_path, std::ios::binary | std::ios::trunc);
+            writeSql(data, out);
+            if (!out) {
+                std::fprintf(stderr, "failed to write %s\n", options.sql_path.c_str());
+                return 1;
+            }
+        }
+    }
+    if (!options.snapshot_path.empty() && !writeSnapshot(data, options.snapshot_path)) {
+        std::fprintf(stderr, "failed to write snapshot %s\n", options.snapshot_path.c_str());
+        return 1;
+    }
+    return 0;
+}
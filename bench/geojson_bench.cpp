@@ -0,0 +1,205 @@
+// Compares the GeoJSON paths of a conflict analysis side by side on seeded
+// synthetic data:
+//   - protection FeatureCollections to one OGR geometry: nlohmann parse with
+//     OGR_G_CreateGeometryFromJson per feature (the original path), the
+//     single-pass GeoJsonReader, parseProtectionGeometry as the cache runs it
+//     (reader plus folding into one geometry), and decoding the stored WKB;
+//   - one project feature geometry: OGR_G_CreateGeometryFromJson against
+//     GeoJsonReader::readGeometry;
+//   - intersections out of the overlay: OGR_G_ExportToJson as stored today
+//     against exportToWkb.
+// Waypoint serialization is in json_serialization_bench.
+// Run: ./geojson_bench [collections] [features] [vertices] [iterations] [seed]
+#include "GeoJsonReader.h"
+#include "ProtectionGeometryCache.h"
+#include "OgrHandles.h"
+#include "ogr_api.h"
+#include <json.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace aeronautical;
+
+namespace {
+
+template <typename F>
+double bestOfMs(int iterations, F&& run) {
+    double best = 1e300;
+    for (int i = 0; i < iterations; i++) {
+        auto start = std::chrono::steady_clock::now();
+        run();
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        if (elapsed.count() < best) best = elapsed.count();
+    }
+    return best;
+}
+
+void appendPosition(std::string& out, double lng, double lat) {
+    char buffer[64];
+    std::snprintf(buffer, sizeof(buffer), "[%.6f,%.6f]", lng, lat);
+    out += buffer;
+}
+
+// Star-shaped ring (angles increase, radius jitters), so it never self-intersects
+std::string ring(std::mt19937& rng, double lng, double lat, double radius, size_t vertices) {
+    std::uniform_real_distribution<double> jitter(0.8, 1.2);
+    std::string out = "[";
+    std::string first;
+    for (size_t i = 0; i < vertices; i++) {
+        const double angle = 2.0 * M_PI * static_cast<double>(i) / static_cast<double>(vertices);
+        const double r = radius * jitter(rng);
+        std::string position;
+        appendPosition(position, lng + r * std::cos(angle), lat + r * std::sin(angle));
+        if (i == 0) first = position;
+        out += position + ",";
+    }
+    out += first + "]";
+    return out;
+}
+
+// Overlapping polygons around one point, as a procedure's protection areas are
+std::string protectionCollection(std::mt19937& rng, size_t features, size_t vertices) {
+    std::uniform_real_distribution<double> lng(0.0, 10.0), lat(40.0, 50.0), offset(-0.05, 0.05), radius(0.05, 0.3);
+    const double x = lng(rng), y = lat(rng);
+    std::string out = R"({"type":"FeatureCollection","features":[)";
+    for (size_t i = 0; i < features; i++) {
+        if (i > 0) out += ",";
+        out += R"({"type":"Feature","properties":{"name":"area )" + std::to_string(i) +
+               R"(","type":"primary"},"geometry":{"type":"Polygon","coordinates":[)" +
+               ring(rng, x + offset(rng), y + offset(rng), radius(rng), vertices) + "]}}";
+    }
+    out += "]}";
+    return out;
+}
+
+// The original path: a DOM, then each geometry dumped and read again by OGR
+GeometryHandle nlohmannPath(const std::string& text) {
+    GeometryHandle collection(OGR_G_CreateGeometry(wkbGeometryCollection));
+    const auto document = nlohmann::json::parse(text);
+    for (const auto& feature : document["features"]) {
+        if (OGRGeometryH geometry = OGR_G_CreateGeometryFromJson(feature["geometry"].dump().c_str())) {
+            OGR_G_AddGeometryDirectly(collection.get(), geometry);
+        }
+    }
+    return collection;
+}
+
+GeometryHandle readerPath(const std::string& text) {
+    GeometryHandle collection(OGR_G_CreateGeometry(wkbGeometryCollection));
+    std::vector<GeoJsonFeature> features;
+    std::string error;
+    GeoJsonReader::read(text, features, error);
+    for (const auto& feature : features) {
+        if (feature.geometry) {
+            if (auto geometry = feature.geometry->toOGR()) {
+                OGR_G_AddGeometryDirectly(collection.get(), (OGRGeometryH)geometry.release());
+            }
+        }
+    }
+    return collection;
+}
+
+void row(const char* name, double ms, double baseline_ms, size_t count) {
+    std::printf("  %-30s %10.2f ms %10.1f us each  (%.1fx)\n", name, ms, 1000.0 * ms / static_cast<double>(count),
+                baseline_ms / ms);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const size_t collections = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200;
+    const size_t features = argc > 2 ? std::max<size_t>(1, std::strtoul(argv[2], nullptr, 10)) : 6;
+    const size_t vertices = argc > 3 ? std::max<size_t>(3, std::strtoul(argv[3], nullptr, 10)) : 256;
+    const int iterations = argc > 4 ? std::max(1, std::atoi(argv[4])) : 5;
+    const unsigned seed = argc > 5 ? static_cast<unsigned>(std::strtoul(argv[5], nullptr, 10)) : 7;
+
+    OGRRegisterAll();
+    std::mt19937 rng(seed);
+    std::vector<std::string> texts;
+    size_t text_bytes = 0;
+    for (size_t i = 0; i < collections; i++) {
+        texts.push_back(protectionCollection(rng, features, vertices));
+        text_bytes += texts.back().size();
+    }
+
+    std::vector<std::string> wkbs;
+    std::vector<std::string> geometry_texts;
+    for (const auto& text : texts) {
+        auto geometry = ProtectionGeometryCache::parseProtectionGeometry(text);
+        if (!geometry) {
+            std::fprintf(stderr, "synthetic protection rejected by parseProtectionGeometry\n");
+            return 1;
+        }
+        wkbs.push_back(ProtectionGeometryCache::toWkb(*geometry));
+        const auto document = nlohmann::json::parse(text);
+        geometry_texts.push_back(document["features"][0]["geometry"].dump());
+    }
+
+    size_t sink = 0;
+    std::printf("%zu protection collections of %zu polygons x %zu vertices (%.1f MB), best of %d, seed %u\n",
+                collections, features, vertices, static_cast<double>(text_bytes) / 1e6, iterations, seed);
+    const double nlohmann_ms = bestOfMs(iterations, [&] {
+        for (const auto& text : texts) {
+            auto geometry = nlohmannPath(text);
+            sink += static_cast<size_t>(OGR_G_GetGeometryCount(geometry.get()));
+        }
+    });
+    const double reader_ms = bestOfMs(iterations, [&] {
+        for (const auto& text : texts) {
+            auto geometry = readerPath(text);
+            sink += static_cast<size_t>(OGR_G_GetGeometryCount(geometry.get()));
+        }
+    });
+    const double cache_ms = bestOfMs(iterations, [&] {
+        for (const auto& text : texts) sink += ProtectionGeometryCache::parseProtectionGeometry(text) ? 1 : 0;
+    });
+    const double wkb_ms = bestOfMs(iterations, [&] {
+        for (const auto& wkb : wkbs) sink += ProtectionGeometryCache::parseProtectionWkb(wkb) ? 1 : 0;
+    });
+    row("nlohmann + OGR JSON", nlohmann_ms, nlohmann_ms, collections);
+    row("GeoJsonReader", reader_ms, nlohmann_ms, collections);
+    row("parseProtectionGeometry", cache_ms, nlohmann_ms, collections);
+    row("stored WKB", wkb_ms, nlohmann_ms, collections);
+
+    std::printf("%zu feature geometries\n", geometry_texts.size());
+    const double ogr_json_ms = bestOfMs(iterations, [&] {
+        for (const auto& text : geometry_texts) {
+            GeometryHandle geometry(OGR_G_CreateGeometryFromJson(text.c_str()));
+            sink += geometry ? 1 : 0;
+        }
+    });
+    const double read_geometry_ms = bestOfMs(iterations, [&] {
+        for (const auto& text : geometry_texts) sink += GeoJsonReader::readGeometry(text) ? 1 : 0;
+    });
+    row("OGR_G_CreateGeometryFromJson", ogr_json_ms, ogr_json_ms, geometry_texts.size());
+    row("GeoJsonReader::readGeometry", read_geometry_ms, ogr_json_ms, geometry_texts.size());
+
+    // Intersections of each collection's first two areas, as the overlay returns them
+    std::vector<GeometryHandle> intersections;
+    for (const auto& text : texts) {
+        auto collection = readerPath(text);
+        OGRGeometryH a = OGR_G_GetGeometryRef(collection.get(), 0);
+        const int count = OGR_G_GetGeometryCount(collection.get());
+        OGRGeometryH b = OGR_G_GetGeometryRef(collection.get(), std::min(1, count - 1));
+        if (GeometryHandle intersection{OGR_G_Intersection(a, b)}) intersections.push_back(std::move(intersection));
+    }
+    size_t json_bytes = 0;
+    for (const auto& geometry : intersections) json_bytes += exportJson(geometry.get()).size();
+    std::printf("%zu intersections (%.1f MB as GeoJSON)\n", intersections.size(), static_cast<double>(json_bytes) / 1e6);
+    const double export_json_ms = bestOfMs(iterations, [&] {
+        for (const auto& geometry : intersections) sink += exportJson(geometry.get()).size();
+    });
+    const double export_wkb_ms = bestOfMs(iterations, [&] {
+        for (const auto& geometry : intersections) sink += ProtectionGeometryCache::toWkb(*geometryOf(geometry)).size();
+    });
+    row("OGR_G_ExportToJson", export_json_ms, export_json_ms, intersections.size());
+    row("exportToWkb", export_wkb_ms, export_json_ms, intersections.size());
+    return sink == 0;
+}
@@ -0,0 +1,107 @@
+// Compares the nlohmann DOM path (toJson().dump()) with the direct
+// writeJson() path on a generated waypoint list, the shape /api/waypoints
+// returns; 10k and 100k waypoints unless a count is given.
+// Run: ./json_serialization_bench [count] [iterations]
+#include "Waypoint.h"
+#include "JsonWriter.h"
+#include <json.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace aeronautical;
+
+namespace {
+
+std::vector<Waypoint> makeWaypoints(size_t count) {
+    static const char* types[] = {"VOR", "NDB", "FIX", "DME", "TACAN"};
+    static const char* usages[] = {"ENROUTE", "TERMINAL", "APPROACH", "SID", "STAR"};
+    std::vector<Waypoint> waypoints;
+    waypoints.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        Waypoint w{};
+        w.id = static_cast<int>(i + 1);
+        w.waypoint_code = "WP" + std::to_string(i);
+        w.name = "Waypoint \"" + std::to_string(i) + "\" Médiane";
+        w.latitude = -60.0 + static_cast<double>(i % 12000) * 0.01;
+        w.longitude = -170.0 + static_cast<double>(i % 34000) * 0.01;
+        w.elevation_ft = static_cast<int>(i % 9000);
+        w.waypoint_type = types[i % 5];
+        w.country_code = "MA";
+        w.country_name = "Morocco";
+        w.region = "GMMM";
+        w.frequency = i % 3 == 0 ? "113.90" : "";
+        w.usage_type = usages[i % 5];
+        w.is_active = i % 7 != 0;
+        waypoints.push_back(std::move(w));
+    }
+    return waypoints;
+}
+
+std::string domPath(const std::vector<Waypoint>& waypoints) {
+    nlohmann::json data = nlohmann::json::array();
+    for (const auto& w : waypoints) {
+        data.push_back(w.toJson());
+    }
+    return nlohmann::json{{"status", "success"}, {"data", data}}.dump();
+}
+
+std::string writerPath(const std::vector<Waypoint>& waypoints, size_t reserve) {
+    std::string body;
+    body.reserve(reserve);
+    JsonWriter writer(body);
+    writer.beginObject().rawKey("data").beginArray();
+    for (const auto& w : waypoints) {
+        w.writeJson(writer);
+    }
+    writer.endArray().rawField("status", "success").endObject();
+    return body;
+}
+
+template <typename F>
+double bestOfMs(int iterations, F&& run) {
+    double best = 1e300;
+    for (int i = 0; i < iterations; i++) {
+        auto start = std::chrono::steady_clock::now();
+        run();
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        if (elapsed.count() < best) best = elapsed.count();
+    }
+    return best;
+}
+
+int compare(size_t count, int iterations) {
+    auto waypoints = makeWaypoints(count);
+
+    std::string expected = domPath(waypoints);
+    std::string actual = writerPath(waypoints, expected.size());
+    if (expected != actual) {
+        std::fprintf(stderr, "writeJson output differs from toJson().dump()\n");
+        return 1;
+    }
+
+    size_t sink = 0;
+    double dom_ms = bestOfMs(iterations, [&] { sink += domPath(waypoints).size(); });
+    double writer_ms = bestOfMs(iterations, [&] { sink += writerPath(waypoints, 0).size(); });
+
+    std::printf("%zu waypoints, %zu bytes, best of %d\n", count, expected.size(), iterations);
+    std::printf("  toJson().dump(): %8.2f ms\n", dom_ms);
+    std::printf("  writeJson():     %8.2f ms  (%.1fx)\n", writer_ms, dom_ms / writer_ms);
+    return sink == 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int iterations = argc > 2 ? std::atoi(argv[2]) : 10;
+    if (argc > 1) {
+        return compare(std::strtoul(argv[1], nullptr, 10), iterations);
+    }
+    for (size_t count : {10000, 100000}) {
+        if (int failed = compare(count, iterations)) return failed;
+    }
+    return 0;
+}
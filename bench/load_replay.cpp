@@ -0,0 +1,405 @@
+// Replays a captured request log against a running backend and reports
+// throughput, latency percentiles and error rates per route.
+//
+// The log has one JSON object per line (blank lines and lines starting with
+// # are skipped):
+//   {"at_ms": 0, "method": "GET", "path": "/api/airports?limit=500"}
+//   {"at_ms": 900, "method": "POST", "path": "/api/projects/${project}/submit",
+//    "body": {...}, "route": "submit"}
+// at_ms is the offset from the start of the capture. route names the line
+// in the report; by default it is the path without its query, numeric
+// segments shown as :id. ${name} in a path or body is replaced by the value
+// given with --set name=value. Streaming routes (SSE) do not belong in a log.
+//
+// By default requests go out at their recorded offsets, scaled by --speed;
+// --rate sends that many requests per second instead, in log order. Latency
+// counts from when a request was due rather than from when a connection
+// was free to send it, so a backend that falls behind shows in the
+// percentiles instead of silently lowering the offered load. A request is
+// an error when the connection fails or the status is 400 or above.
+//
+// Run: ./load_replay [--target host:port] [--concurrency N] [--speed X]
+//                    [--rate N] [--loops N] [--duration S] [--timeout S]
+//                    [--header 'Name: value'] [--set name=value] log.jsonl
+#include <asio.hpp>
+#include <json.hpp>
+
+#include <sys/socket.h>
+#include <sys/time.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    std::string host = "127.0.0.1";
+    std::string port = "8080";
+    size_t concurrency = 16;
+    double speed = 1.0;
+    double rate = 0.0; // requests per second; 0 replays the recorded offsets
+    size_t loops = 1;
+    double duration_s = 0.0;
+    int timeout_s = 30;
+    std::vector<std::string> headers;
+    std::map<std::string, std::string> vars;
+    std::string log_path;
+};
+
+struct LoggedRequest {
+    double at_ms = 0.0;
+    std::string method;
+    std::string path;
+    std::string body;
+    size_t route = 0;
+};
+
+struct Sample {
+    size_t route = 0;
+    double latency_ms = 0.0;
+    int status = 0; // 0 when the connection failed
+};
+
+struct Response {
+    int status = 0;
+    bool keep_alive = true;
+};
+
+[[noreturn]] void usage(const char* reason) {
+    std::fprintf(stderr, "%s\nusage: load_replay [--target host:port] [--concurrency N] [--speed X] [--rate N] "
+                         "[--loops N] [--duration S] [--timeout S] [--header 'Name: value'] [--set name=value] "
+                         "log.jsonl\n", reason);
+    std::exit(2);
+}
+
+Options parseOptions(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) usage(("missing value for " + arg).c_str());
+            return argv[++i];
+        };
+        if (arg == "--target") {
+            const std::string target = value();
+            const size_t colon = target.rfind(':');
+            if (colon == std::string::npos) usage("--target takes host:port");
+            options.host = target.substr(0, colon);
+            options.port = target.substr(colon + 1);
+        } else if (arg == "--concurrency") {
+            options.concurrency = std::max<size_t>(1, std::strtoul(value().c_str(), nullptr, 10));
+        } else if (arg == "--speed") {
+            options.speed = std::strtod(value().c_str(), nullptr);
+            if (options.speed <= 0.0) usage("--speed must be positive");
+        } else if (arg == "--rate") {
+            options.rate = std::strtod(value().c_str(), nullptr);
+        } else if (arg == "--loops") {
+            options.loops = std::max<size_t>(1, std::strtoul(value().c_str(), nullptr, 10));
+        } else if (arg == "--duration") {
+            options.duration_s = std::strtod(value().c_str(), nullptr);
+        } else if (arg == "--timeout") {
+            options.timeout_s = std::max(1, std::atoi(value().c_str()));
+        } else if (arg == "--header") {
+            options.headers.push_back(value());
+        } else if (arg == "--set") {
+            const std::string assignment = value();
+            const size_t eq = assignment.find('=');
+            if (eq == std::string::npos) usage("--set takes name=value");
+            options.vars[assignment.substr(0, eq)] = assignment.substr(eq + 1);
+        } else if (!arg.empty() && arg[0] == '-') {
+            usage(("unknown option " + arg).c_str());
+        } else {
+            options.log_path = arg;
+        }
+    }
+    if (options.log_path.empty()) usage("no request log given");
+    return options;
+}
+
+std::string substitute(std::string text, const std::map<std::string, std::string>& vars) {
+    for (const auto& [name, value] : vars) {
+        const std::string token = "${" + name + "}";
+        for (size_t at = text.find(token); at != std::string::npos; at = text.find(token, at + value.size())) {
+            text.replace(at, token.size(), value);
+        }
+    }
+    return text;
+}
+
+// "/api/projects/42/conflicts?x=1" -> "/api/projects/:id/conflicts"
+std::string defaultRoute(const std::string& method, const std::string& path) {
+    std::string route = method + " ";
+    const std::string bare = path.substr(0, path.find('?'));
+    size_t start = 0;
+    while (start < bare.size()) {
+        size_t end = bare.find('/', start + 1);
+        if (end == std::string::npos) end = bare.size();
+        const std::string segment = bare.substr(start, end - start); // includes its leading '/'
+        const bool numeric = segment.size() > 1 &&
+                             std::all_of(segment.begin() + 1, segment.end(), [](char c) { return c >= '0' && c <= '9'; });
+        route += numeric ? "/:id" : segment;
+        start = end;
+    }
+    return route;
+}
+
+std::vector<LoggedRequest> loadLog(const Options& options, std::vector<std::string>& routes) {
+    std::ifstream in(options.log_path);
+    if (!in) {
+        std::fprintf(stderr, "cannot open %s\n", options.log_path.c_str());
+        std::exit(2);
+    }
+    std::map<std::string, size_t> route_ids;
+    std::vector<LoggedRequest> requests;
+    std::string line;
+    for (size_t number = 1; std::getline(in, line); number++) {
+        const size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#') continue;
+        try {
+            const auto entry = nlohmann::json::parse(line);
+            LoggedRequest request;
+            request.at_ms = entry.value("at_ms", 0.0);
+            request.method = entry.value("method", std::string("GET"));
+            request.path = substitute(entry.at("path").get<std::string>(), options.vars);
+            if (entry.contains("body")) {
+                const auto& body = entry["body"];
+                request.body = substitute(body.is_string() ? body.get<std::string>() : body.dump(), options.vars);
+            }
+            const std::string route = entry.value("route", defaultRoute(request.method, request.path));
+            auto [it, added] = route_ids.emplace(route, routes.size());
+            if (added) routes.push_back(route);
+            request.route = it->second;
+            requests.push_back(std::move(request));
+        } catch (const std::exception& e) {
+            std::fprintf(stderr, "%s:%zu: %s\n", options.log_path.c_str(), number, e.what());
+            std::exit(2);
+        }
+    }
+    if (requests.empty()) usage("the request log is empty");
+    std::stable_sort(requests.begin(), requests.end(),
+                     [](const LoggedRequest& a, const LoggedRequest& b) { return a.at_ms < b.at_ms; });
+    return requests;
+}
+
+// One keep-alive connection, blocking, with send and receive timeouts
+class Connection {
+public:
+    Connection(const Options& options, const asio::ip::tcp::resolver::results_type& endpoints)
+        : options_(options), endpoints_(endpoints), socket_(io_) {}
+
+    Response send(const LoggedRequest& request) {
+        if (!socket_.is_open()) connect();
+        std::string head = request.method + " " + request.path + " HTTP/1.1\r\nHost: " + options_.host +
+                           "\r\nConnection: keep-alive\r\nAccept: application/json\r\n";
+        for (const auto& header : options_.headers) head += header + "\r\n";
+        if (!request.body.empty() || request.method == "POST" || request.method == "PUT") {
+            head += "Content-Type: application/json\r\nContent-Length: " + std::to_string(request.body.size()) + "\r\n";
+        }
+        head += "\r\n";
+        asio::write(socket_, std::vector<asio::const_buffer>{asio::buffer(head), asio::buffer(request.body)});
+
+        Response response = readResponse();
+        if (!response.keep_alive) close();
+        return response;
+    }
+
+    void close() {
+        asio::error_code ignored;
+        socket_.close(ignored);
+        buffer_.consume(buffer_.size());
+    }
+
+private:
+    void connect() {
+        asio::connect(socket_, endpoints_);
+        socket_.set_option(asio::ip::tcp::no_delay(true));
+        timeval timeout{options_.timeout_s, 0};
+        setsockopt(socket_.native_handle(), SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(socket_.native_handle(), SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    }
+
+    std::string readLine() {
+        asio::read_until(socket_, buffer_, "\r\n");
+        std::istream in(&buffer_);
+        std::string line;
+        std::getline(in, line);
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        return line;
+    }
+
+    void discard(size_t bytes) {
+        if (buffer_.size() < bytes) asio::read(socket_, buffer_, asio::transfer_exactly(bytes - buffer_.size()));
+        buffer_.consume(bytes);
+    }
+
+    Response readResponse() {
+        Response response;
+        const std::string status_line = readLine();
+        const size_t space = status_line.find(' ');
+        if (status_line.compare(0, 5, "HTTP/") != 0 || space == std::string::npos) {
+            throw std::runtime_error("malformed status line");
+        }
+        response.status = std::atoi(status_line.c_str() + space + 1);
+        response.keep_alive = status_line.compare(0, 8, "HTTP/1.0") != 0;
+
+        std::optional<size_t> content_length;
+        bool chunked = false;
+        for (std::string line = readLine(); !line.empty(); line = readLine()) {
+            const size_t colon = line.find(':');
+            if (colon == std::string::npos) continue;
+            std::string name = line.substr(0, colon);
+            std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return std::tolower(c); });
+            std::string value = line.substr(line.find_first_not_of(' ', colon + 1));
+            std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c) { return std::tolower(c); });
+            if (name == "content-length") content_length = std::strtoull(value.c_str(), nullptr, 10);
+            else if (name == "transfer-encoding") chunked = value.find("chunked") != std::string::npos;
+            else if (name == "connection") response.keep_alive = value.find("close") == std::string::npos;
+        }
+
+        if (chunked) {
+            for (size_t size = std::strtoull(readLine().c_str(), nullptr, 16); size > 0;
+                 size = std::strtoull(readLine().c_str(), nullptr, 16)) {
+                discard(size + 2);
+            }
+            while (!readLine().empty()) {} // trailers
+        } else if (content_length) {
+            discard(*content_length);
+        } else if (response.status >= 200 && response.status != 204 && response.status != 304) {
+            asio::error_code ec;
+            asio::read(socket_, buffer_, asio::transfer_all(), ec); // body runs to the end of the connection
+            response.keep_alive = false;
+        }
+        return response;
+    }
+
+    const Options& options_;
+    const asio::ip::tcp::resolver::results_type& endpoints_;
+    asio::io_context io_;
+    asio::ip::tcp::socket socket_;
+    asio::streambuf buffer_;
+};
+
+double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    const size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * static_cast<double>(sorted.size())));
+    return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const Options options = parseOptions(argc, argv);
+    std::vector<std::string> routes;
+    const std::vector<LoggedRequest> log = loadLog(options, routes);
+
+    asio::io_context resolver_io;
+    asio::ip::tcp::resolver::results_type endpoints;
+    try {
+        endpoints = asio::ip::tcp::resolver(resolver_io).resolve(options.host, options.port);
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "cannot resolve %s:%s: %s\n", options.host.c_str(), options.port.c_str(), e.what());
+        return 2;
+    }
+
+    // Each loop of a recorded replay starts one mean gap after the last request of the previous one
+    const double span_ms = log.back().at_ms - log.front().at_ms;
+    const double loop_ms = span_ms + (log.size() > 1 ? span_ms / static_cast<double>(log.size() - 1) : 1000.0);
+    const size_t total = log.size() * options.loops;
+    auto dueOffset = [&](size_t i) {
+        const double ms = options.rate > 0.0
+                              ? 1000.0 * static_cast<double>(i) / options.rate
+                              : (static_cast<double>(i / log.size()) * loop_ms + log[i % log.size()].at_ms -
+                                 log.front().at_ms) / options.speed;
+        return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(ms));
+    };
+
+    char pacing[64];
+    if (options.rate > 0.0) std::snprintf(pacing, sizeof(pacing), "%g req/s", options.rate);
+    else std::snprintf(pacing, sizeof(pacing), "recorded pacing x%g", options.speed);
+    std::printf("Replaying %zu requests (%zu routes) x %zu against %s:%s, %zu connections, %s\n", log.size(),
+                routes.size(), options.loops, options.host.c_str(), options.port.c_str(), options.concurrency, pacing);
+
+    std::atomic<size_t> next{0};
+    std::vector<std::vector<Sample>> samples(options.concurrency);
+    const Clock::time_point start = Clock::now() + std::chrono::milliseconds(100);
+    const Clock::time_point deadline = options.duration_s > 0.0
+                                           ? start + std::chrono::duration_cast<Clock::duration>(
+                                                         std::chrono::duration<double>(options.duration_s))
+                                           : Clock::time_point::max();
+    std::vector<std::thread> workers;
+    for (size_t w = 0; w < options.concurrency; w++) {
+        workers.emplace_back([&, w]() {
+            Connection connection(options, endpoints);
+            for (size_t i = next.fetch_add(1); i < total; i = next.fetch_add(1)) {
+                const Clock::time_point due = start + dueOffset(i);
+                if (due >= deadline) break;
+                std::this_thread::sleep_until(due);
+                const LoggedRequest& request = log[i % log.size()];
+                Sample sample;
+                sample.route = request.route;
+                try {
+                    sample.status = connection.send(request).status;
+                } catch (const std::exception&) {
+                    connection.close();
+                }
+                sample.latency_ms = std::chrono::duration<double, std::milli>(Clock::now() - due).count();
+                samples[w].push_back(sample);
+            }
+        });
+    }
+    for (auto& worker : workers) worker.join();
+    const double elapsed_s = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::vector<std::vector<double>> latencies(routes.size());
+    std::vector<size_t> errors(routes.size(), 0);
+    std::map<int, size_t> statuses;
+    std::vector<double> all;
+    size_t failed = 0;
+    for (const auto& worker_samples : samples) {
+        for (const Sample& sample : worker_samples) {
+            latencies[sample.route].push_back(sample.latency_ms);
+            all.push_back(sample.latency_ms);
+            statuses[sample.status]++;
+            if (sample.status == 0 || sample.status >= 400) {
+                errors[sample.route]++;
+                failed++;
+            }
+        }
+    }
+    std::sort(all.begin(), all.end());
+
+    std::printf("\n%zu requests in %.1f s: %.1f req/s, %zu errors (%.2f%%)\n", all.size(), elapsed_s,
+                static_cast<double>(all.size()) / elapsed_s, failed,
+                all.empty() ? 0.0 : 100.0 * static_cast<double>(failed) / static_cast<double>(all.size()));
+    std::printf("status:");
+    for (const auto& [status, count] : statuses) {
+        if (status == 0) std::printf(" failed=%zu", count);
+        else std::printf(" %d=%zu", status, count);
+    }
+    std::printf("\n\n  %-44s %8s %8s %7s %9s %9s %9s %9s\n", "route", "count", "req/s", "err %", "p50 ms",
+                "p90 ms", "p99 ms", "max ms");
+    auto row = [&](const std::string& name, std::vector<double>& values, size_t route_errors) {
+        std::sort(values.begin(), values.end());
+        std::printf("  %-44s %8zu %8.1f %7.2f %9.1f %9.1f %9.1f %9.1f\n", name.c_str(), values.size(),
+                    static_cast<double>(values.size()) / elapsed_s,
+                    values.empty() ? 0.0 : 100.0 * static_cast<double>(route_errors) / static_cast<double>(values.size()),
+                    percentile(values, 50), percentile(values, 90), percentile(values, 99),
+                    values.empty() ? 0.0 : values.back());
+    };
+    for (size_t r = 0; r < routes.size(); r++) row(routes[r], latencies[r], errors[r]);
+    row("all", all, failed);
+    return 0;
+}
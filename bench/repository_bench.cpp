@@ -0,0 +1,270 @@
+// Times the repository methods against a real MySQL loaded with a
+// generate_dataset dataset (bench/repository_bench.sh starts one in a
+// container): procedure lists and lookups, airport and waypoint bounds and
+// search, findAllActiveProtections, project lookups and conflict inserts.
+// Each case runs its warm-up calls, then `iterations` timed calls with
+// arguments drawn from the loaded rows by the seed, and reports latency
+// percentiles together with the statements, rows and bytes one call costs
+// as QueryStats counts them, so pool, prepared-statement and batching
+// changes show per call site. Conflict inserts go to the first project and
+// are deleted again at the end.
+//
+// The connection comes from DB_HOST, DB_PORT, DB_USER, DB_PASS and DB_NAME
+// as for the backend, with DB_POOL_SIZE connections. Schema migrations run
+// first unless DB_MIGRATIONS=0.
+// Run: ./repository_bench [--iterations N] [--warmup N] [--seed S]
+//                         [--only name[,name...]]
+#include "AirportRepository.h"
+#include "ConflictRepository.h"
+#include "DatabaseManager.h"
+#include "FlightProcedureRepository.h"
+#include "ProjectRepository.h"
+#include "QueryStats.h"
+#include "SchemaMigrations.h"
+#include "WaypointRepository.h"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace aeronautical;
+
+namespace {
+
+struct Options {
+    size_t iterations = 200;
+    size_t warmup = 10;
+    unsigned seed = 7;
+    std::vector<std::string> only;
+};
+
+[[noreturn]] void usage(const char* reason) {
+    std::fprintf(stderr, "%s\nusage: repository_bench [--iterations N] [--warmup N] [--seed S] "
+                         "[--only name[,name...]]\n", reason);
+    std::exit(2);
+}
+
+Options parseOptions(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) usage(("missing value for " + arg).c_str());
+            return argv[++i];
+        };
+        if (arg == "--iterations") {
+            options.iterations = std::max<size_t>(1, std::strtoul(value().c_str(), nullptr, 10));
+        } else if (arg == "--warmup") {
+            options.warmup = std::strtoul(value().c_str(), nullptr, 10);
+        } else if (arg == "--seed") {
+            options.seed = static_cast<unsigned>(std::strtoul(value().c_str(), nullptr, 10));
+        } else if (arg == "--only") {
+            std::stringstream names(value());
+            for (std::string name; std::getline(names, name, ',');) {
+                if (!name.empty()) options.only.push_back(name);
+            }
+        } else {
+            usage(("unknown option " + arg).c_str());
+        }
+    }
+    return options;
+}
+
+std::string env(const char* name, const char* fallback) {
+    const char* value = std::getenv(name);
+    return value && *value ? value : fallback;
+}
+
+// Statements, rows and bytes QueryStats has recorded so far
+struct Counters {
+    uint64_t statements = 0;
+    uint64_t rows = 0;
+    uint64_t bytes = 0;
+};
+
+Counters counters() {
+    Counters c;
+    const auto snapshot = QueryStats::getInstance().snapshot(std::numeric_limits<size_t>::max());
+    for (const auto& shape : snapshot["shapes"]) {
+        c.statements += shape.value("calls", uint64_t{0});
+        c.rows += shape.value("rows", uint64_t{0});
+        c.bytes += shape.value("bytes", uint64_t{0});
+    }
+    return c;
+}
+
+// First column of each row
+std::vector<std::string> column(const std::string& sql) {
+    std::vector<std::string> values;
+    MysqlResult result = DatabaseManager::getInstance().executeSelectQuery(sql);
+    MYSQL_ROW row;
+    while (result && (row = mysql_fetch_row(result.get()))) {
+        if (row[0]) values.emplace_back(row[0]);
+    }
+    return values;
+}
+
+double percentile(const std::vector<double>& sorted, double q) {
+    if (sorted.empty()) return 0.0;
+    const size_t rank = static_cast<size_t>(q * static_cast<double>(sorted.size() - 1) + 0.5);
+    return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+struct Case {
+    std::string name;
+    size_t iterations; // 0: the --iterations default
+    std::function<size_t()> run; // returns the items the call produced
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const Options options = parseOptions(argc, argv);
+    spdlog::set_level(spdlog::level::warn);
+
+    PoolSettings pool;
+    pool.max_size = static_cast<size_t>(std::max(1, std::atoi(env("DB_POOL_SIZE", "4").c_str())));
+    auto& db = DatabaseManager::getInstance();
+    try {
+        db.initialize(env("DB_HOST", "127.0.0.1"), std::atoi(env("DB_PORT", "3306").c_str()), env("DB_USER", "root"),
+                      env("DB_PASS", "oper"), env("DB_NAME", "aeronautical_platform"), pool);
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "cannot connect: %s\n", e.what());
+        return 1;
+    }
+    if (env("DB_MIGRATIONS", "1") != "0") {
+        SchemaMigrations::getInstance().run();
+    } else {
+        SchemaMigrations::getInstance().loadCatalog();
+    }
+
+    const std::vector<std::string> procedure_ids = column("SELECT id FROM flight_procedures LIMIT 100000");
+    const std::vector<std::string> airport_codes = column("SELECT icao_code FROM airports LIMIT 100000");
+    const std::vector<std::string> waypoint_codes = column("SELECT waypoint_code FROM waypoints LIMIT 100000");
+    const std::vector<std::string> project_ids = column("SELECT id FROM projects ORDER BY id LIMIT 100000");
+    if (procedure_ids.empty() || airport_codes.empty() || waypoint_codes.empty() || project_ids.empty()) {
+        std::fprintf(stderr, "the database holds no dataset; load one with generate_dataset --sql\n");
+        return 1;
+    }
+    std::printf("Dataset: %zu procedures, %zu airports, %zu waypoints, %zu projects; pool of %zu\n",
+                procedure_ids.size(), airport_codes.size(), waypoint_codes.size(), project_ids.size(), pool.max_size);
+
+    std::mt19937 rng(options.seed);
+    auto pick = [&](const std::vector<std::string>& values) -> const std::string& {
+        return values[std::uniform_int_distribution<size_t>(0, values.size() - 1)(rng)];
+    };
+    // A 2 x 2 degree box around a random airport
+    const std::vector<std::string> airport_positions =
+        column("SELECT CONCAT(latitude, ' ', longitude) FROM airports LIMIT 100000");
+    auto box = [&](auto&& query) {
+        double lat = 0.0, lng = 0.0;
+        std::sscanf(pick(airport_positions).c_str(), "%lf %lf", &lat, &lng);
+        return query(lat - 1.0, lat + 1.0, lng - 1.0, lng + 1.0);
+    };
+    auto prefix = [&](const std::vector<std::string>& codes) { return pick(codes).substr(0, 2); };
+
+    FlightProcedureRepository procedures;
+    AirportRepository airports;
+    WaypointRepository waypoints;
+    ProjectRepository projects;
+    ConflictRepository conflicts;
+    const int conflict_project = std::atoi(project_ids.front().c_str());
+
+    std::vector<Case> cases = {
+        {"procedures.findAll", 0, [&]() { return procedures.findAll().size(); }},
+        {"procedures.findAll.light", 0,
+         [&]() {
+             FlightProcedureFilter filter;
+             filter.include_segments = false;
+             filter.include_protections = false;
+             filter.include_trajectory_geometry = false;
+             filter.include_protection_geometry = false;
+             return procedures.findAll(filter).size();
+         }},
+        {"procedures.findById", 0,
+         [&]() { return procedures.findById(std::atoi(pick(procedure_ids).c_str())) ? size_t{1} : size_t{0}; }},
+        {"procedures.findGeometries", 0,
+         [&]() {
+             std::vector<int> ids;
+             for (int i = 0; i < 50; i++) ids.push_back(std::atoi(pick(procedure_ids).c_str()));
+             return procedures.findGeometries(ids).size();
+         }},
+        {"procedures.findAllActiveProtections", std::min<size_t>(options.iterations, 5),
+         [&]() { return procedures.findAllActiveProtections().size(); }},
+        {"airports.inBounds", 0,
+         [&]() {
+             return box([&](double a, double b, double c, double d) {
+                 return airports.fetchAirportsInBounds(a, b, c, d, "").size();
+             });
+         }},
+        {"airports.byIcao", 0,
+         [&]() { return airports.fetchAirportByIcao(pick(airport_codes)).icao_code.empty() ? size_t{0} : size_t{1}; }},
+        {"airports.search", 0, [&]() { return airports.searchAirportsByQuery(prefix(airport_codes), 20).size(); }},
+        {"waypoints.inBounds", 0,
+         [&]() {
+             return box([&](double a, double b, double c, double d) {
+                 return waypoints.fetchWaypointsInBounds(a, b, c, d).size();
+             });
+         }},
+        {"waypoints.search", 0, [&]() { return waypoints.searchWaypointsByQuery(prefix(waypoint_codes), 20).size(); }},
+        {"projects.findAll", 0, [&]() { return projects.findAll().size(); }},
+        {"projects.findById", 0,
+         [&]() { return projects.findById(std::atoi(pick(project_ids).c_str())) ? size_t{1} : size_t{0}; }},
+        {"conflicts.create", 0,
+         [&]() {
+             return conflicts.create(conflict_project, std::atoi(pick(procedure_ids).c_str()), "repository_bench",
+                                     "{\"type\":\"Point\",\"coordinates\":[2.35,48.85]}")
+                        ? size_t{1}
+                        : size_t{0};
+         }},
+    };
+
+    std::printf("\n  %-36s %6s %9s %9s %9s %9s %9s %8s %9s %10s\n", "case", "calls", "mean ms", "p50 ms", "p95 ms",
+                "p99 ms", "max ms", "stmt/call", "rows/call", "KB/call");
+    for (const Case& c : cases) {
+        if (!options.only.empty() && std::find(options.only.begin(), options.only.end(), c.name) == options.only.end()) {
+            continue;
+        }
+        const size_t iterations = c.iterations ? c.iterations : options.iterations;
+        try {
+            for (size_t i = 0; i < std::min(options.warmup, iterations); i++) c.run();
+
+            std::vector<double> ms;
+            ms.reserve(iterations);
+            size_t items = 0;
+            const Counters before = counters();
+            for (size_t i = 0; i < iterations; i++) {
+                const auto start = std::chrono::steady_clock::now();
+                items += c.run();
+                ms.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+            }
+            const Counters after = counters();
+            std::sort(ms.begin(), ms.end());
+            double total = 0;
+            for (double v : ms) total += v;
+            const double n = static_cast<double>(iterations);
+            std::printf("  %-36s %6zu %9.3f %9.3f %9.3f %9.3f %9.3f %8.1f %9.1f %10.1f\n", c.name.c_str(), iterations,
+                        total / n, percentile(ms, 0.50), percentile(ms, 0.95), percentile(ms, 0.99), ms.back(),
+                        static_cast<double>(after.statements - before.statements) / n,
+                        static_cast<double>(after.rows - before.rows) / n,
+                        static_cast<double>(after.bytes - before.bytes) / n / 1024.0);
+            if (items == 0) std::printf("    (no results; check the dataset)\n");
+        } catch (const std::exception& e) {
+            std::printf("  %-36s failed: %s\n", c.name.c_str(), e.what());
+        }
+    }
+
+    // Leaves the project as the dataset had it
+    db.executeQuery("DELETE FROM conflicts WHERE project_id = " + std::to_string(conflict_project) +
+                    " AND description = 'repository_bench'");
+    return 0;
+}
@@ -0,0 +1,37 @@
+#!/bin/sh
+# Starts a throwaway MySQL 8 container, creates the base schema from
+# SCHEMA_SQL (the platform's table definitions, which are managed outside
+# this repository), loads a generate_dataset dataset of the given scale and
+# runs repository_bench against it. The container is removed on exit.
+#
+# Run from the build directory:
+#   SCHEMA_SQL=/path/to/schema.sql ../bench/repository_bench.sh [scale] [repository_bench options]
+set -eu
+
+: "${SCHEMA_SQL:?SCHEMA_SQL must name the base schema file}"
+SCALE="${1:-1}"
+[ $# -gt 0 ] && shift
+BIN="${BIN:-./bin}"
+IMAGE="${MYSQL_IMAGE:-mysql:8.0}"
+PORT="${BENCH_DB_PORT:-33306}"
+NAME="repository-bench-$$"
+PASS=bench
+
+docker run -d --rm --name "$NAME" -p "127.0.0.1:$PORT:3306" \
+    -e MYSQL_ROOT_PASSWORD="$PASS" -e MYSQL_DATABASE=aeronautical_platform \
+    "$IMAGE" --innodb-buffer-pool-size=1G >/dev/null
+trap 'docker rm -f "$NAME" >/dev/null 2>&1' EXIT
+
+printf 'Waiting for MySQL'
+until docker exec "$NAME" mysql -uroot -p"$PASS" -e 'SELECT 1' aeronautical_platform >/dev/null 2>&1; do
+    printf '.'
+    sleep 2
+done
+echo
+
+docker exec -i "$NAME" mysql -uroot -p"$PASS" aeronautical_platform <"$SCHEMA_SQL"
+"$BIN/generate_dataset" --scale "$SCALE" --sql - |
+    docker exec -i "$NAME" mysql -uroot -p"$PASS" --max-allowed-packet=64M aeronautical_platform
+
+DB_HOST=127.0.0.1 DB_PORT="$PORT" DB_USER=root DB_PASS="$PASS" DB_NAME=aeronautical_platform \
+    "$BIN/repository_bench" "$@"
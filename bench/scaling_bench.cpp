@@ -0,0 +1,501 @@
+// Measures whether more cores help: the conflict engine and the HTTP
+// controllers are each run at 1, 2, 4 ... N threads, and every step
+// reports throughput, speedup over one thread and the contended
+// acquisitions of the instrumented locks (LockStats) during the step. A
+// lock whose count climbs with the thread count while the speedup flattens
+// is the shared cache or pool that stops the scaling.
+//
+// analysis: synthetic protection zones (as bench_conflicts) are loaded into
+// ProtectionGeometryCache and indexed once; each step analyses the same
+// projects, each twice as resubmissions are, on a ThreadPool of that many
+// threads: parse, index query, ConflictMemo lookups and ZoneEvaluator for
+// the pairs the memo does not know. The memo is cleared between steps.
+//
+// http: the airport and waypoint controllers serve a reference snapshot
+// file (generate_dataset --snapshot) from a Crow app with that many
+// threads, under keep-alive connections sending bounds and search requests
+// for --duration seconds. The clients run in this process too, so on a
+// small machine they take cores from the server; compare steps, not
+// absolute numbers.
+//
+// Run: ./scaling_bench [--mode analysis|http|both] [--threads 1,2,4,...]
+//                      [--procedures N] [--vertices N] [--projects N]
+//                      [--features N] [--snapshot PATH] [--clients N]
+//                      [--duration S] [--port P] [--seed S]
+#include "AirportController.h"
+#include "ConflictMemo.h"
+#include "GeoJsonReader.h"
+#include "HttpApp.h"
+#include "LockStats.h"
+#include "OgrHandles.h"
+#include "ProtectionGeometryCache.h"
+#include "ProtectionIndex.h"
+#include "ReferenceDataStore.h"
+#include "ThreadPool.h"
+#include "WaypointController.h"
+#include "ZoneEvaluator.h"
+#include "ogr_api.h"
+
+#include <asio.hpp>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace aeronautical;
+
+namespace {
+
+// Zones and features fall in this box (degrees), dense enough for overlaps
+constexpr double kMinLng = 0.0, kMaxLng = 10.0, kMinLat = 40.0, kMaxLat = 50.0;
+
+struct Options {
+    bool analysis = true;
+    bool http = true;
+    std::vector<size_t> threads;
+    size_t procedures = 500;
+    size_t vertices = 256;
+    size_t projects = 64;
+    size_t features = 100;
+    std::string snapshot;
+    size_t clients = 32;
+    double duration_s = 5.0;
+    unsigned short port = 18181;
+    unsigned seed = 7;
+};
+
+[[noreturn]] void usage(const char* reason) {
+    std::fprintf(stderr, "%s\nusage: scaling_bench [--mode analysis|http|both] [--threads 1,2,4,...] "
+                         "[--procedures N] [--vertices N] [--projects N] [--features N] [--snapshot PATH] "
+                         "[--clients N] [--duration S] [--port P] [--seed S]\n", reason);
+    std::exit(2);
+}
+
+Options parseOptions(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) usage(("missing value for " + arg).c_str());
+            return argv[++i];
+        };
+        auto count = [&]() { return std::max<size_t>(1, std::strtoul(value().c_str(), nullptr, 10)); };
+        if (arg == "--mode") {
+            const std::string mode = value();
+            if (mode != "analysis" && mode != "http" && mode != "both") usage("--mode takes analysis, http or both");
+            options.analysis = mode != "http";
+            options.http = mode != "analysis";
+        } else if (arg == "--threads") {
+            std::stringstream list(value());
+            for (std::string item; std::getline(list, item, ',');) {
+                if (const size_t n = std::strtoul(item.c_str(), nullptr, 10)) options.threads.push_back(n);
+            }
+        } else if (arg == "--procedures") {
+            options.procedures = count();
+        } else if (arg == "--vertices") {
+            options.vertices = std::max<size_t>(3, count());
+        } else if (arg == "--projects") {
+            options.projects = count();
+        } else if (arg == "--features") {
+            options.features = count();
+        } else if (arg == "--snapshot") {
+            options.snapshot = value();
+        } else if (arg == "--clients") {
+            options.clients = count();
+        } else if (arg == "--duration") {
+            options.duration_s = std::max(0.5, std::strtod(value().c_str(), nullptr));
+        } else if (arg == "--port") {
+            options.port = static_cast<unsigned short>(std::atoi(value().c_str()));
+        } else if (arg == "--seed") {
+            options.seed = static_cast<unsigned>(std::strtoul(value().c_str(), nullptr, 10));
+        } else {
+            usage(("unknown option " + arg).c_str());
+        }
+    }
+    if (options.threads.empty()) {
+        const size_t cores = std::max(1u, std::thread::hardware_concurrency());
+        for (size_t n = 1; n < cores; n *= 2) options.threads.push_back(n);
+        options.threads.push_back(cores);
+    }
+    if (options.http && options.snapshot.empty()) {
+        if (options.analysis) {
+            std::fprintf(stderr, "no --snapshot given; skipping the http steps\n");
+            options.http = false;
+        } else {
+            usage("--mode http needs --snapshot");
+        }
+    }
+    return options;
+}
+
+// Contended acquisitions and wait per lock since the last call
+class ContentionDelta {
+public:
+    ContentionDelta() { reset(); }
+
+    // Counts from now on
+    void reset() { take(); }
+
+    void report() {
+        const auto before = last_;
+        take();
+        bool any = false;
+        for (const auto& [name, now] : last_) {
+            const auto it = before.find(name);
+            const LockStats::Sample was = it != before.end() ? it->second : LockStats::Sample{};
+            if (now.contended == was.contended) continue;
+            std::printf("%s %s %llu (%.1f ms)", any ? "," : "    contended:", name.c_str(),
+                        static_cast<unsigned long long>(now.contended - was.contended),
+                        static_cast<double>(now.wait_ns - was.wait_ns) / 1e6);
+            any = true;
+        }
+        std::printf(any ? "\n" : "    contended: none\n");
+    }
+
+private:
+    void take() {
+        last_.clear();
+        for (auto& sample : LockStats::samples()) last_[sample.name] = sample;
+    }
+    std::map<std::string, LockStats::Sample> last_;
+};
+
+void printHeader(const char* unit) {
+    std::printf("  %8s %12s %9s %11s\n", "threads", unit, "speedup", "efficiency");
+}
+
+// base: the first step's rate per thread
+void printStep(size_t threads, double rate, double base) {
+    const double speedup = base > 0.0 ? rate / base : 0.0;
+    std::printf("  %8zu %12.1f %8.2fx %10.0f%%\n", threads, rate, speedup,
+                100.0 * speedup / static_cast<double>(threads));
+}
+
+void appendPosition(std::string& out, double lng, double lat) {
+    char buffer[64];
+    std::snprintf(buffer, sizeof(buffer), "[%.6f,%.6f]", lng, lat);
+    out += buffer;
+}
+
+// Star-shaped ring (angles increase, radius jitters), so it never self-intersects
+std::string ring(std::mt19937& rng, double lng, double lat, double radius, size_t vertices) {
+    std::uniform_real_distribution<double> jitter(0.8, 1.2);
+    std::string out = "[";
+    std::string first;
+    for (size_t i = 0; i < vertices; i++) {
+        const double angle = 2.0 * M_PI * static_cast<double>(i) / static_cast<double>(vertices);
+        const double r = radius * jitter(rng);
+        std::string position;
+        appendPosition(position, lng + r * std::cos(angle), lat + r * std::sin(angle));
+        if (i == 0) first = position;
+        out += position + ",";
+    }
+    out += first + "]";
+    return out;
+}
+
+std::string protectionGeoJson(std::mt19937& rng, size_t vertices) {
+    std::uniform_real_distribution<double> lng(kMinLng, kMaxLng), lat(kMinLat, kMaxLat), radius(0.05, 0.5);
+    return R"({"type":"Polygon","coordinates":[)" + ring(rng, lng(rng), lat(rng), radius(rng), vertices) + "]}";
+}
+
+// Points, lines and polygons in equal parts
+std::string projectGeoJson(std::mt19937& rng, size_t features) {
+    std::uniform_real_distribution<double> lng(kMinLng, kMaxLng), lat(kMinLat, kMaxLat);
+    std::uniform_real_distribution<double> step(-0.01, 0.01), radius(0.01, 0.1);
+    std::uniform_int_distribution<int> line_vertices(2, 20), polygon_vertices(8, 64);
+
+    std::string out = R"({"type":"FeatureCollection","features":[)";
+    for (size_t i = 0; i < features; i++) {
+        if (i > 0) out += ",";
+        out += R"({"type":"Feature","properties":{},"geometry":)";
+        double x = lng(rng), y = lat(rng);
+        if (i % 3 == 0) {
+            out += R"({"type":"Point","coordinates":)";
+            appendPosition(out, x, y);
+        } else if (i % 3 == 1) {
+            out += R"({"type":"LineString","coordinates":[)";
+            const int count = line_vertices(rng);
+            for (int v = 0; v < count; v++) {
+                if (v > 0) out += ",";
+                appendPosition(out, x, y);
+                x += step(rng);
+                y += step(rng);
+            }
+            out += "]";
+        } else {
+            out += R"({"type":"Polygon","coordinates":[)" +
+                   ring(rng, x, y, radius(rng), static_cast<size_t>(polygon_vertices(rng))) + "]";
+        }
+        out += "}}";
+    }
+    out += "]}";
+    return out;
+}
+
+struct Engine {
+    std::vector<std::shared_ptr<const CachedProtectionGeometry>> zones;
+    ProtectionIndex index;
+    int64_t zone_version = 0;
+};
+
+// One project's analysis; returns the zones in conflict
+size_t analyse(const Engine& engine, const std::string& project) {
+    std::vector<GeoJsonFeature> features;
+    std::string error;
+    if (!GeoJsonReader::read(project, features, error)) {
+        throw std::runtime_error("synthetic FeatureCollection rejected: " + error);
+    }
+    std::vector<GeometryHandle> geometries;
+    for (const auto& feature : features) {
+        if (feature.geometry) geometries.push_back(toHandle(feature.geometry->toOGR()));
+    }
+
+    auto& memo = ConflictMemo::getInstance();
+    std::vector<size_t> hashes(geometries.size());
+    std::map<size_t, std::vector<size_t>> features_by_zone;
+    std::vector<size_t> hits;
+    for (size_t i = 0; i < geometries.size(); i++) {
+        OGREnvelope envelope;
+        OGR_G_GetEnvelope(geometries[i].get(), &envelope);
+        hashes[i] = ConflictMemo::geometryHash(*geometryOf(geometries[i]));
+        engine.index.query(envelope, hits);
+        for (size_t slot : hits) features_by_zone[slot].push_back(i);
+    }
+
+    size_t conflicts = 0;
+    for (auto& [slot, pending] : features_by_zone) {
+        const auto& zone = *engine.zones[slot];
+        auto key = [&](size_t i) { return ConflictMemo::Key{hashes[i], zone.procedure_id, engine.zone_version, 3}; };
+        bool conflict = false;
+        pending.erase(std::remove_if(pending.begin(), pending.end(),
+                                     [&](size_t i) {
+                                         auto outcome = memo.find(key(i));
+                                         if (outcome) conflict |= outcome->conflict;
+                                         return outcome != nullptr;
+                                     }),
+                      pending.end());
+        if (!pending.empty()) {
+            auto result = ZoneEvaluator::evaluate(zone, zone.procedure_id, geometries, pending, false, false);
+            conflict |= result.conflict;
+            std::vector<char> hit(geometries.size(), 0);
+            for (const auto& h : result.hits) hit[h.feature] = 1;
+            for (size_t i : pending) {
+                auto outcome = std::make_shared<ConflictMemo::Outcome>();
+                outcome->conflict = hit[i] != 0;
+                memo.store(key(i), std::move(outcome));
+            }
+        }
+        conflicts += conflict ? 1 : 0;
+    }
+    return conflicts;
+}
+
+void runAnalysis(const Options& options) {
+    OGRRegisterAll();
+    std::mt19937 rng(options.seed);
+    Engine engine;
+    auto& cache = ProtectionGeometryCache::getInstance();
+    const auto version = std::chrono::system_clock::time_point(std::chrono::seconds(1700000000));
+    engine.zone_version = ConflictMemo::zoneVersion(version);
+    std::vector<OGREnvelope> envelopes;
+    for (size_t i = 0; i < options.procedures; i++) {
+        if (auto zone = cache.insert(static_cast<int>(i) + 1, version, protectionGeoJson(rng, options.vertices))) {
+            envelopes.push_back(zone->envelope);
+            engine.zones.push_back(std::move(zone));
+        }
+    }
+    engine.index.build(envelopes);
+
+    std::vector<std::string> projects;
+    for (size_t i = 0; i < options.projects; i++) projects.push_back(projectGeoJson(rng, options.features));
+    // Each project comes back once, as a resubmission would
+    std::vector<const std::string*> work;
+    for (const auto& project : projects) work.push_back(&project);
+    for (const auto& project : projects) work.push_back(&project);
+
+    std::printf("\nanalysis: %zu zones x %zu vertices, %zu projects x %zu features, each analysed twice\n",
+                engine.zones.size(), options.vertices, projects.size(), options.features);
+    printHeader("projects/s");
+    auto& memo = ConflictMemo::getInstance();
+    if (!memo.enabled()) memo.setCapacity(size_t{64} << 20);
+    ContentionDelta contention;
+    double base = 0.0;
+    for (size_t threads : options.threads) {
+        memo.clear();
+        contention.reset();
+        ThreadPool pool(threads, "scaling");
+        std::atomic<size_t> conflicts{0};
+        const auto started = std::chrono::steady_clock::now();
+        std::vector<std::future<void>> done;
+        done.reserve(work.size());
+        for (const std::string* project : work) {
+            done.push_back(pool.submit([&engine, &conflicts, project]() {
+                conflicts.fetch_add(analyse(engine, *project), std::memory_order_relaxed);
+            }));
+        }
+        for (auto& f : done) f.get();
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+        const double rate = static_cast<double>(work.size()) / seconds;
+        if (base == 0.0) base = rate / static_cast<double>(threads);
+        printStep(threads, rate, base);
+        contention.report();
+    }
+}
+
+struct ClientResult {
+    uint64_t responses = 0;
+    uint64_t errors = 0;
+};
+
+// Keep-alive GETs until the deadline, reconnecting after a failure
+ClientResult runClient(unsigned short port, const std::vector<std::string>& paths, unsigned seed,
+                       std::chrono::steady_clock::time_point deadline) {
+    ClientResult result;
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<size_t> pick(0, paths.size() - 1);
+    asio::io_context io;
+    const asio::ip::tcp::endpoint endpoint(asio::ip::address_v4::loopback(), port);
+    while (std::chrono::steady_clock::now() < deadline) {
+        asio::ip::tcp::socket socket(io);
+        asio::error_code ec;
+        socket.connect(endpoint, ec);
+        if (ec) {
+            result.errors++;
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            continue;
+        }
+        socket.set_option(asio::ip::tcp::no_delay(true));
+        asio::streambuf buffer;
+        while (std::chrono::steady_clock::now() < deadline) {
+            const std::string request = "GET " + paths[pick(rng)] + " HTTP/1.1\r\nHost: localhost\r\n\r\n";
+            asio::write(socket, asio::buffer(request), ec);
+            const size_t header_end = ec ? 0 : asio::read_until(socket, buffer, "\r\n\r\n", ec);
+            if (ec) break;
+            std::string headers(asio::buffers_begin(buffer.data()), asio::buffers_begin(buffer.data()) + header_end);
+            buffer.consume(header_end);
+            size_t length = 0;
+            for (const char* name : {"Content-Length: ", "content-length: "}) {
+                if (const size_t at = headers.find(name); at != std::string::npos) {
+                    length = std::strtoul(headers.c_str() + at + std::strlen(name), nullptr, 10);
+                }
+            }
+            if (buffer.size() < length) asio::read(socket, buffer, asio::transfer_exactly(length - buffer.size()), ec);
+            if (ec) break;
+            buffer.consume(length);
+            if (headers.compare(9, 1, "2") == 0) {
+                result.responses++;
+            } else {
+                result.errors++;
+            }
+        }
+        if (ec) result.errors++;
+    }
+    return result;
+}
+
+void runHttp(const Options& options) {
+    auto& store = ReferenceDataStore::getInstance();
+    store.setSnapshotPath(options.snapshot);
+    if (!store.restoreFromFile()) {
+        std::fprintf(stderr, "cannot read the reference snapshot %s\n", options.snapshot.c_str());
+        std::exit(1);
+    }
+    const auto snapshot = store.snapshot();
+    if (snapshot->airports.empty() || snapshot->waypoints.empty()) {
+        std::fprintf(stderr, "the reference snapshot holds no airports or waypoints\n");
+        std::exit(1);
+    }
+
+    // Bounds around airports and two-letter searches, drawn once so every step sends the same mix
+    std::mt19937 rng(options.seed);
+    std::vector<std::string> paths;
+    for (size_t i = 0; i < 2000; i++) {
+        const auto& airport = snapshot->airports[rng() % snapshot->airports.size()];
+        const auto& waypoint = snapshot->waypoints[rng() % snapshot->waypoints.size()];
+        char bounds[160];
+        std::snprintf(bounds, sizeof(bounds), "bounds?min_lat=%.3f&max_lat=%.3f&min_lng=%.3f&max_lng=%.3f",
+                      airport.latitude - 1.0, airport.latitude + 1.0, airport.longitude - 1.0,
+                      airport.longitude + 1.0);
+        switch (i % 5) {
+            case 0:
+            case 1: paths.push_back(std::string("/api/waypoints/") + bounds); break;
+            case 2: paths.push_back(std::string("/api/airports/") + bounds); break;
+            case 3: paths.push_back("/api/airports/search?q=" + airport.icao_code.substr(0, 2)); break;
+            default: paths.push_back("/api/waypoints/search?q=" + waypoint.waypoint_code.substr(0, 2)); break;
+        }
+    }
+
+    AirportController airports;
+    WaypointController waypoints;
+    spdlog::set_level(spdlog::level::warn);
+
+    std::printf("\nhttp: %zu airports, %zu waypoints, %zu keep-alive clients, %.1f s per step\n",
+                snapshot->airports.size(), snapshot->waypoints.size(), options.clients, options.duration_s);
+    printHeader("requests/s");
+    ContentionDelta contention;
+    double base = 0.0;
+    for (size_t step = 0; step < options.threads.size(); step++) {
+        const size_t threads = options.threads[step];
+        const auto port = static_cast<unsigned short>(options.port + step);
+        auto app = std::make_unique<HttpApp>();
+        airports.registerRoutes(*app);
+        waypoints.registerRoutes(*app);
+        app->loglevel(crow::LogLevel::Warning);
+        auto server = app->bindaddr("127.0.0.1").port(port).concurrency(static_cast<unsigned int>(threads))
+                          .signal_clear().run_async();
+        app->wait_for_server_start(std::chrono::seconds(10));
+        contention.reset();
+
+        const auto started = std::chrono::steady_clock::now();
+        const auto deadline = started + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                            std::chrono::duration<double>(options.duration_s));
+        std::vector<std::future<ClientResult>> clients;
+        for (size_t c = 0; c < options.clients; c++) {
+            clients.push_back(std::async(std::launch::async, runClient, port, std::cref(paths),
+                                         options.seed + static_cast<unsigned>(c), deadline));
+        }
+        ClientResult total;
+        for (auto& client : clients) {
+            const ClientResult r = client.get();
+            total.responses += r.responses;
+            total.errors += r.errors;
+        }
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+        app->stop();
+        server.wait();
+
+        const double rate = static_cast<double>(total.responses) / seconds;
+        if (base == 0.0) base = rate / static_cast<double>(threads);
+        printStep(threads, rate, base);
+        if (total.errors) std::printf("    errors: %llu\n", static_cast<unsigned long long>(total.errors));
+        contention.report();
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const Options options = parseOptions(argc, argv);
+    spdlog::set_level(spdlog::level::warn);
+    std::printf("threads:");
+    for (size_t n : options.threads) std::printf(" %zu", n);
+    std::printf(" (%u cores)\n", std::thread::hardware_concurrency());
+    if (options.analysis) runAnalysis(options);
+    if (options.http) runHttp(options);
+    return 0;
+}
@@ -0,0 +1,107 @@
+// Client of the backend's analysis event WebSocket (/ws/projects, see
+// AnalysisEventHub). Keeps one connection per tab, reconnects with
+// exponential backoff and re-sends the project subscription after each
+// reconnect. Listeners get the parsed event ({event, project_id, ...});
+// 'connected' and 'disconnected' report the channel itself, so pollers can
+// stand down while it is up.
+
+const RECONNECT_MIN_MS = 1000;
+const RECONNECT_MAX_MS = 60000;
+
+class AnalysisEvents {
+    constructor() {
+        this.socket = null;
+        this.connected = false;
+        this.listeners = new Map(); // event name -> Set of callbacks
+        this.projectIds = new Set();
+        this.reconnectDelay = RECONNECT_MIN_MS;
+        this.reconnectTimer = null;
+        this.available = typeof WebSocket !== 'undefined';
+    }
+
+    connect() {
+        if (!this.available || this.socket) return;
+
+        const protocol = window.location.protocol === 'https:' ? 'wss:' : 'ws:';
+        const socket = new WebSocket(`${protocol}//${window.location.host}/ws/projects`);
+        this.socket = socket;
+
+        socket.onopen = () => {
+            console.log('📡 Analysis event channel connected');
+            this.connected = true;
+            this.reconnectDelay = RECONNECT_MIN_MS;
+            this.sendSubscription();
+            this.emit('connected', {});
+        };
+
+        socket.onmessage = (message) => {
+            try {
+                const event = JSON.parse(message.data);
+                if (event && event.event) this.emit(event.event, event);
+            } catch (error) {
+                console.warn('⚠️ Ignoring malformed analysis event:', error);
+            }
+        };
+
+        socket.onclose = () => {
+            const wasConnected = this.connected;
+            this.socket = null;
+            this.connected = false;
+            if (wasConnected) {
+                console.warn('⚠️ Analysis event channel closed');
+                this.emit('disconnected', {});
+            }
+            this.scheduleReconnect();
+        };
+
+        // onclose follows every error
+        socket.onerror = () => {};
+    }
+
+    scheduleReconnect() {
+        clearTimeout(this.reconnectTimer);
+        const delay = this.reconnectDelay;
+        this.reconnectDelay = Math.min(this.reconnectDelay * 2, RECONNECT_MAX_MS);
+        this.reconnectTimer = setTimeout(() => this.connect(), delay);
+    }
+
+    // Only these projects' events are delivered; none until one is watched
+    sendSubscription() {
+        if (!this.connected) return;
+        this.socket.send(JSON.stringify({ action: 'subscribe', project_ids: [...this.projectIds] }));
+    }
+
+    watch(projectId) {
+        const id = Number(projectId);
+        if (!Number.isInteger(id) || this.projectIds.has(id)) return;
+        this.projectIds.add(id);
+        this.sendSubscription();
+    }
+
+    unwatch(projectId) {
+        const id = Number(projectId);
+        if (!this.projectIds.delete(id) || !this.connected) return;
+        this.socket.send(JSON.stringify({ action: 'unsubscribe', project_ids: [id] }));
+    }
+
+    // Returns a function that removes the listener
+    on(eventName, callback) {
+        if (!this.listeners.has(eventName)) this.listeners.set(eventName, new Set());
+        this.listeners.get(eventName).add(callback);
+        return () => this.listeners.get(eventName)?.delete(callback);
+    }
+
+    emit(eventName, event) {
+        this.listeners.get(eventName)?.forEach(callback => {
+            try {
+                callback(event);
+            } catch (error) {
+                console.error(`❌ Analysis event listener for ${eventName} failed:`, error);
+            }
+        });
+    }
+}
+
+const analysisEvents = new AnalysisEvents();
+
+export default analysisEvents;
@@ -1,11 +1,20 @@
 // API communication module with enhanced database connectivity
 import authManager from './auth.js';
+import ReferenceCache from './referenceCache.js';
+import analysisEvents from './analysisEvents.js';
+import geometryPool from './geometryPool.js';
+
+// Documents above this go through a chunked upload session (DocumentPipeline)
+const DOCUMENT_CHUNK_BYTES = 1024 * 1024;
+const DOCUMENT_CHUNK_RETRIES = 5;
 
 class ApiClient {
     constructor() {
         this.baseUrl = '/api';
         this.timeout = 10000;
         this.dataSource = 'unknown'; // Track data source for debugging
+        // Airports and waypoints served from IndexedDB, kept current by delta sync
+        this.referenceCache = new ReferenceCache(endpoint => this.request(endpoint));
     }
 
     async request(endpoint, options = {}) {
@@ -65,9 +74,56 @@ class ApiClient {
         }
     }
 
+    // GET for geometry-heavy responses: a worker fetches the body, decodes
+    // it (JSON or CBOR), parses parseFields holding GeoJSON text and packs
+    // the geometries, so the main thread only builds layers. Same result
+    // and errors as request().
+    async requestDecoded(endpoint, parseFields = []) {
+        if (!geometryPool.available) {
+            return this.request(endpoint);
+        }
+
+        const headers = {};
+        const authHeader = authManager.getAuthHeader();
+        if (authHeader) {
+            headers.Authorization = authHeader;
+        }
+
+        try {
+            return await geometryPool.fetch(`${this.baseUrl}${endpoint}`, { headers, timeout: this.timeout, parseFields });
+        } catch (error) {
+            if (error.status === 401) {
+                console.log('Unauthorized request, redirecting to login...');
+                await authManager.login();
+                return;
+            }
+            console.error(`❌ API request failed: ${endpoint}`, error);
+            throw error;
+        }
+    }
+
+    parseGeometryField(value) {
+        return typeof value === 'string' ? JSON.parse(value) : value;
+    }
+
     async getAirports(filters = {}) {
         console.log('🛩️ Fetching airports...');
         
+        const cached = await this.referenceCache.query('airports', 'list', {
+            filter_type: filters.type,
+            active_only: filters.active_only === undefined || String(filters.active_only) !== 'false'
+        });
+        if (cached) {
+            this.dataSource = 'cache';
+            const processedAirports = this.processAirportsForMap(cached);
+            processedAirports._metadata = {
+                source: 'cache',
+                timestamp: new Date().toISOString(),
+                count: cached.length
+            };
+            return processedAirports;
+        }
+        
         try {
             console.log('🔄 Attempting to fetch airports from database...');
             
@@ -139,6 +195,12 @@ class ApiClient {
     async getAirportByIcao(icaoCode) {
         console.log(`🛩️ Fetching airport by ICAO: ${icaoCode}`);
         
+        const cached = await this.referenceCache.query('airports', 'code', { code: icaoCode });
+        if (cached) {
+            this.dataSource = 'cache';
+            return this.processAirportForMap(cached);
+        }
+        
         try {
             console.log('🔄 Attempting to fetch from database...');
             const response = await this.request(`/airports/icao/${icaoCode}`);
@@ -171,6 +233,12 @@ class ApiClient {
     async searchAirports(query, limit = 20) {
         console.log(`🔍 Searching airports for: ${query}`);
         
+        const cached = await this.referenceCache.query('airports', 'search', { query, limit });
+        if (cached) {
+            this.dataSource = 'cache';
+            return this.processAirportsForMap(cached);
+        }
+        
         try {
             console.log('🔄 Attempting to search in database...');
             const queryParams = new URLSearchParams({
@@ -205,6 +273,48 @@ class ApiClient {
         }
     }
 
+    // Active airports inside {min_lat, max_lat, min_lng, max_lng}
+    async getAirportsInBounds(bounds, type = '') {
+        const cached = await this.referenceCache.query('airports', 'bounds', { bounds, filter_type: type });
+        if (cached) {
+            this.dataSource = 'cache';
+            return this.processAirportsForMap(cached);
+        }
+        
+        const queryParams = new URLSearchParams({ ...bounds });
+        if (type) queryParams.append('type', type);
+        const response = await this.request(`/airports/bounds?${queryParams.toString()}`);
+        this.dataSource = 'database';
+        return this.processAirportsForMap(response.data || response);
+    }
+
+    async searchWaypoints(query, limit = 20) {
+        const cached = await this.referenceCache.query('waypoints', 'search', { query, limit });
+        if (cached) {
+            this.dataSource = 'cache';
+            return cached;
+        }
+        
+        const queryParams = new URLSearchParams({ q: query, limit: limit.toString() });
+        const response = await this.request(`/waypoints/search?${queryParams.toString()}`);
+        this.dataSource = 'database';
+        return response.data || response;
+    }
+
+    async getWaypointsInBounds(bounds, type = '') {
+        const cached = await this.referenceCache.query('waypoints', 'bounds', { bounds, filter_type: type });
+        if (cached) {
+            this.dataSource = 'cache';
+            return cached;
+        }
+        
+        const queryParams = new URLSearchParams({ ...bounds });
+        if (type) queryParams.append('type', type);
+        const response = await this.request(`/waypoints/bounds?${queryParams.toString()}`);
+        this.dataSource = 'database';
+        return response.data || response;
+    }
+
     async getAirportRunways(icaoCode) {
         console.log(`🛬 Fetching runways for airport: ${icaoCode}`);
         
@@ -417,6 +527,19 @@ class ApiClient {
 
 
     // Enhanced Projects API with database priority
+    // Ranked search over project code, title, description and demander;
+    // filters: status, priority, operation_type, limit, offset. Resolves to
+    // { data, total, facets: { status, priority, operation_type } }
+    async searchProjects(query, filters = {}) {
+        const queryParams = new URLSearchParams({ q: query });
+        for (const key of ['status', 'priority', 'operation_type', 'limit', 'offset']) {
+            if (filters[key] !== undefined && filters[key] !== null && filters[key] !== '') {
+                queryParams.append(key, filters[key]);
+            }
+        }
+        return this.request(`/projects/search?${queryParams.toString()}`);
+    }
+
     async getProjects(filters = {}) {
         console.log('📂 Fetching projects...');
         
@@ -432,6 +555,14 @@ class ApiClient {
             if (filters.demander_id) {
                 queryParams.append('demander_id', filters.demander_id);
             }
+            // bbox: [minLng, minLat, maxLng, maxLat]; near: { lat, lng, radiusKm }
+            if (filters.bbox) {
+                queryParams.append('bbox', filters.bbox.join(','));
+            }
+            if (filters.near) {
+                const { lat, lng, radiusKm } = filters.near;
+                queryParams.append('near', `${lat},${lng},${radiusKm}`);
+            }
             
             const endpoint = `/projects${queryParams.toString() ? '?' + queryParams.toString() : ''}`;
             const response = await this.request(endpoint);
@@ -550,25 +681,6 @@ class ApiClient {
     }
 
     // Project Geometries API
-    async getProjectGeometries(projectId) {
-        console.log(`📐 Fetching geometries for project ${projectId}`);
-        
-        try {
-            console.log('🔄 Attempting to fetch from database...');
-            const response = await this.request(`/projects/${projectId}/geometries`);
-            const geometries = response.data || response;
-            
-            this.dataSource = 'database';
-            console.log(`✅ Successfully fetched ${geometries.length} geometries from DATABASE`);
-            return geometries;
-            
-        } catch (error) {
-            console.warn(`⚠️ Database fetch failed for geometries: ${error.message}`);
-            console.log('🔄 Returning empty geometries array');
-            return [];
-        }
-    }
-
     async createProjectGeometry(projectId, geometryData) {
         console.log(`📐 Creating geometry for project ${projectId}`, geometryData);
         
@@ -618,10 +730,12 @@ class ApiClient {
             // queryParams.append('include_protections', 'true');
             
             if (filters.limit) queryParams.append('limit', filters.limit);
+            // Geometry simplified for this map zoom (served from the backend's cache)
+            if (filters.zoom !== undefined && filters.zoom !== null) queryParams.append('zoom', filters.zoom);
             if (filters.offset) queryParams.append('offset', filters.offset);
             
             const endpoint = `/procedures${queryParams.toString() ? '?' + queryParams.toString() : ''}`;
-            const response = await this.request(endpoint);
+            const response = await this.requestDecoded(endpoint, ['trajectory_geometry', 'protection_geometry']);
             
             // Success - we got data from database
             const procedures = response.data || response;
@@ -922,10 +1036,11 @@ processProcedureForMap(procedure) {
         name: procedure.name,
         type: procedure.type,
         // Direct GeoJSON - no processing needed
+        // Already parsed (and packed) when fetched through the geometry workers
         geometry: procedure.trajectory_geometry ? 
-                  JSON.parse(procedure.trajectory_geometry) : null,
+                  this.parseGeometryField(procedure.trajectory_geometry) : null,
         protections: procedure.protection_geometry ? 
-                    JSON.parse(procedure.protection_geometry) : null
+                    this.parseGeometryField(procedure.protection_geometry) : null
     };
 }
 
@@ -1215,7 +1330,7 @@ getMockProcedures() {
             });
             
             console.log('✅ Project submitted successfully, status received:', result);
-            return this.pollForAnalysisCompletion(projectId);
+            return this.pollForAnalysisCompletion(projectId, result.job_id);
     
         } catch (error) {
             console.error(`❌ Failed to submit project ${projectId}:`, error);
@@ -1224,51 +1339,305 @@ getMockProcedures() {
         }
     }
 
-    // --- NEW POLLING FUNCTION ---
-    async pollForAnalysisCompletion(projectId, timeout = 60000, interval = 2000) {
-        const startTime = Date.now();
+    // Dry-run conflict check of the zones being edited; nothing is stored.
+    // cycle ("YYNN") checks against the zones of that AIRAC cycle instead
+    async previewConflicts(geometries, cycle = null) {
+        const payload = {
+            geometry: {
+                type: "FeatureCollection",
+                features: geometries.map(zone => zone.geometry)
+            }
+        };
+        const query = cycle ? `?cycle=${encodeURIComponent(cycle)}` : '';
+        const response = await this.request(`/analysis/preview${query}`, {
+            method: 'POST',
+            body: JSON.stringify(payload)
+        });
+        return response.data || response;
+    }
+
+    // Polls the in-memory job status endpoint; project and conflicts are
+    // fetched once, after the job has finished. With wait (seconds) the
+    // server answers as soon as the job finishes, or when wait is over
+    async getAnalysisJob(jobId, wait = 0) {
+        const query = wait > 0 ? `?wait=${wait}` : '';
+        const response = await this.request(`/analysis/jobs/${jobId}${query}`);
+        return response.data || response;
+    }
+
+    // Sends an image to the backend document pipeline (thumbnail, OCR and
+    // coordinate extraction on the server). Resolves with {cached, data}
+    // when the same bytes were processed before, else with the accepted
+    // job ({job_id, status_url}).
+    async submitDocument(blob) {
+        return this.request('/documents', {
+            method: 'POST',
+            headers: { 'Content-Type': blob.type || 'application/octet-stream' },
+            body: blob
+        });
+    }
+
+    // Like submitDocument, but a document larger than one chunk is sent
+    // through an upload session, chunk by chunk. A failed chunk is retried
+    // with backoff from the count the server reports, so a dropped
+    // connection costs at most the chunk in flight. onProgress gets the
+    // fraction sent.
+    async uploadDocument(blob, { onProgress } = {}) {
+        if (blob.size <= DOCUMENT_CHUNK_BYTES) return this.submitDocument(blob);
+
+        const opened = await this.request('/documents/uploads', {
+            method: 'POST',
+            body: JSON.stringify({ size: blob.size })
+        });
+        const { upload_id: uploadId, chunk_bytes: chunkBytes = DOCUMENT_CHUNK_BYTES } = opened.data;
+        let received = 0;
+        let failures = 0;
+        try {
+            while (received < blob.size) {
+                try {
+                    received = await this.putDocumentChunk(uploadId, blob, received, chunkBytes);
+                    failures = 0;
+                    if (onProgress) onProgress(received / blob.size);
+                } catch (error) {
+                    if (error.status === 404 || ++failures > DOCUMENT_CHUNK_RETRIES) throw error;
+                    const delay = Math.min(1000 * 2 ** (failures - 1), 15000);
+                    console.warn(`⚠️ Upload chunk at ${received} failed (${error.message}); retrying in ${delay} ms`);
+                    await new Promise(resolve => setTimeout(resolve, delay));
+                    const status = await this.request(`/documents/uploads/${uploadId}`).catch(() => null);
+                    if (status && status.data) received = status.data.received;
+                }
+            }
+        } catch (error) {
+            this.request(`/documents/uploads/${uploadId}`, { method: 'DELETE' }).catch(() => {});
+            throw error;
+        }
+        return this.request(`/documents/uploads/${uploadId}/complete`, { method: 'POST' });
+    }
+
+    // Sends the chunk at offset; resolves with the bytes the server now has,
+    // which is also the answer to a chunk it did not expect (409)
+    async putDocumentChunk(uploadId, blob, offset, chunkBytes) {
+        const headers = { 'Content-Type': 'application/octet-stream' };
+        const authHeader = authManager.getAuthHeader();
+        if (authHeader) headers.Authorization = authHeader;
+
+        const controller = new AbortController();
+        const timeoutId = setTimeout(() => controller.abort(), 60000);
+        try {
+            const response = await fetch(`${this.baseUrl}/documents/uploads/${uploadId}?offset=${offset}`, {
+                method: 'PUT',
+                headers,
+                body: blob.slice(offset, offset + chunkBytes),
+                signal: controller.signal
+            });
+            const body = await response.json().catch(() => ({}));
+            if (response.status === 409 && typeof body.received === 'number') return body.received;
+            if (!response.ok) {
+                const error = new Error(body.message || `HTTP ${response.status}: ${response.statusText}`);
+                error.status = response.status;
+                throw error;
+            }
+            return body.data.received;
+        } finally {
+            clearTimeout(timeoutId);
+        }
+    }
+
+    async getDocumentJob(jobId) {
+        const response = await this.request(`/documents/jobs/${jobId}`);
+        return response.data || response;
+    }
+
+    // Resolves with the document result once the job completes, asking
+    // every interval ms and backing off to 5 s; onStage gets each new stage
+    async waitForDocument(jobId, { timeout = 120000, interval = 500, onStage } = {}) {
+        const deadline = Date.now() + timeout;
+        let delay = interval;
+        let stage = null;
+        while (Date.now() < deadline) {
+            const job = await this.getDocumentJob(jobId);
+            if (job.stage !== stage) {
+                stage = job.stage;
+                if (onStage) onStage(stage);
+            }
+            if (job.state === 'completed') return job.result;
+            if (job.state === 'failed') throw new Error(job.error || 'Document processing failed');
+            await new Promise(resolve => setTimeout(resolve, delay));
+            delay = Math.min(delay * 2, 5000);
+        }
+        throw new Error('Document processing timed out');
+    }
+
+    // kind: 'conflicts' | 'protections'; format: 'gpkg' | 'shp' | 'kml' | 'geojson';
+    // scope: { projectId } or { airportIcao }, nothing for every conflict
+    async createExport(kind, format, { projectId = null, airportIcao = null } = {}) {
+        return this.request('/exports', {
+            method: 'POST',
+            body: JSON.stringify({ kind, format, project_id: projectId, airport_icao: airportIcao })
+        });
+    }
+
+    // state, stage, written of total, and file_url once completed
+    async getExportJob(jobId) {
+        const response = await this.request(`/exports/${jobId}`);
+        return response.data || response;
+    }
+
+    exportFileUrl(jobId) {
+        return `${this.baseUrl}/exports/${jobId}/file`;
+    }
+
+    // Offline MBTiles pack of bounds [west, south, east, north] for the
+    // zoom range; layers default to every map layer
+    async createTilePack(bounds, minZoom, maxZoom, { layers = null, name = null } = {}) {
+        const body = { bounds, min_zoom: minZoom, max_zoom: maxZoom };
+        if (layers) body.layers = layers;
+        if (name) body.name = name;
+        return this.request('/tile-packs', { method: 'POST', body: JSON.stringify(body) });
+    }
+
+    // state, stage, done of total tiles, and file_url once completed
+    async getTilePackJob(jobId) {
+        const response = await this.request(`/tile-packs/${jobId}`);
+        return response.data || response;
+    }
+
+    tilePackFileUrl(jobId) {
+        return `${this.baseUrl}/tile-packs/${jobId}/file`;
+    }
+
+    // Primary and secondary protection areas for a trajectory (GeoJSON line),
+    // as they would be saved with generate_protection; nothing is written
+    async generateProtection(type, airportIcao, trajectoryGeometry) {
+        const body = { type, airport_icao: airportIcao, trajectory_geometry: trajectoryGeometry };
+        const response = await this.request('/procedures/protection/generate', { method: 'POST', body: JSON.stringify(body) });
+        return response.data || response;
+    }
+
+    // Trajectory and protection geometry of many procedures in one request,
+    // simplified for the map zoom; {data: [{id, updated_at, ...}], missing}
+    async getProcedureGeometries(ids, zoom) {
+        const body = { ids, zoom: Math.max(0, Math.min(24, Math.round(zoom))) };
+        return this.request('/procedures/geometries', { method: 'POST', body: JSON.stringify(body) });
+    }
+
+    // Resolves with the URL of the project's review dossier (PDF) once it
+    // is written; a dossier cached for the current revision resolves at once
+    async getProjectDossier(projectId, { timeout = 120000, interval = 1000 } = {}) {
+        const url = `${this.baseUrl}/projects/${projectId}/dossier`;
+        const headers = {};
+        const authHeader = authManager.getAuthHeader();
+        if (authHeader) headers.Authorization = authHeader;
+        const deadline = Date.now() + timeout;
+        while (Date.now() < deadline) {
+            const response = await fetch(url, { method: 'HEAD', headers });
+            if (response.status === 200) return url;
+            if (response.status !== 202) throw new Error(`Dossier unavailable (${response.status})`);
+            await new Promise(resolve => setTimeout(resolve, interval));
+        }
+        throw new Error('Dossier generation timed out');
+    }
+
+    // Resolves with {project, conflicts} once the job has finished. The
+    // analysis event channel reports that; the job status endpoint is asked
+    // once up front (the job may be done before the subscription) and after
+    // that only while the channel is down, backing off from interval.
+    async pollForAnalysisCompletion(projectId, jobId, timeout = 60000, interval = 2000) {
+        const wasWatched = analysisEvents.projectIds.has(Number(projectId));
+        analysisEvents.watch(projectId);
+        analysisEvents.connect();
 
         return new Promise((resolve, reject) => {
-            const checkStatus = async () => {
-                // Check for timeout
-                if (Date.now() - startTime > timeout) {
-                    clearInterval(intervalId);
-                    reject(new Error('Analysis timed out. Please check the project status later.'));
+            const hasJob = jobId !== undefined && jobId !== null;
+            const unsubscribe = [];
+            let done = false;
+            let pollTimer = null;
+            let delay = interval;
+
+            const finish = async (error) => {
+                if (done) return;
+                done = true;
+                clearTimeout(pollTimer);
+                clearTimeout(deadline);
+                unsubscribe.forEach(off => off());
+                if (!wasWatched) analysisEvents.unwatch(projectId);
+                if (error) {
+                    reject(error);
                     return;
                 }
-
                 try {
                     const project = await this.getProject(projectId);
-                    console.log(`Polling... Project ${projectId} status is: ${project.status}`);
+                    const conflicts = await this.getConflicts(projectId);
+                    console.log(`✅ Analysis complete! Status: ${project.status}`);
 
-                    // The analysis is done when the status is no longer "Pending"
-                    if (project.status !== 'Pending') {
-                        clearInterval(intervalId);
-                        console.log(`✅ Analysis complete! Status: ${project.status}`);
+                    // Resolve with the complete report data
+                    resolve({
+                        project: project,
+                        conflicts: conflicts
+                    });
+                } catch (fetchError) {
+                    reject(fetchError);
+                }
+            };
 
-                        // Fetch the final conflicts
-                        const conflicts = await this.getConflicts(projectId);
+            const deadline = setTimeout(() => {
+                finish(new Error('Analysis timed out. Please check the project status later.'));
+            }, timeout);
 
-                        // Resolve with the complete report data
-                        resolve({
-                            project: project,
-                            conflicts: conflicts
-                        });
+            const checkStatus = async (wait = 0) => {
+                try {
+                    let finished;
+                    if (hasJob) {
+                        const job = await this.getAnalysisJob(jobId, wait);
+                        console.log(`Polling... Job ${jobId} is ${job.state} (${job.protections_scanned}/${job.protections_total})`);
+                        if (job.state === 'failed') {
+                            finish(new Error(job.error || 'Analysis failed.'));
+                            return;
+                        }
+                        finished = job.state === 'completed';
+                    } else {
+                        // Older backends do not return a job id
+                        const project = await this.getProject(projectId);
+                        finished = project.status !== 'Pending';
                     }
+                    if (finished) finish(null);
                 } catch (error) {
-                    clearInterval(intervalId);
-                    reject(error);
+                    finish(error);
+                }
+            };
+
+            const poll = async () => {
+                if (done) return;
+                if (!analysisEvents.connected) {
+                    // Without the event channel a job is long-polled: the
+                    // server holds the request until the job finishes
+                    await checkStatus(hasJob ? 20 : 0);
+                    delay = hasJob ? interval : Math.min(delay * 2, 30000);
                 }
+                if (!done) pollTimer = setTimeout(poll, delay);
             };
 
-            const intervalId = setInterval(checkStatus, interval);
+            const isThisJob = event => event.project_id == projectId && (!hasJob || event.job_id == jobId);
+            unsubscribe.push(analysisEvents.on('analysis_finished', event => {
+                if (!isThisJob(event)) return;
+                finish(event.aborted ? new Error(event.reason || 'Analysis failed.') : null);
+            }));
+            unsubscribe.push(analysisEvents.on('analysis_cancelled', event => {
+                if (isThisJob(event)) finish(new Error('Analysis was replaced by a newer submission.'));
+            }));
+            // Events sent while the channel was down are lost; ask once
+            unsubscribe.push(analysisEvents.on('connected', () => checkStatus()));
+
+            checkStatus().then(() => {
+                if (!done) pollTimer = setTimeout(poll, delay);
+            });
         });
     }
 
     async getProjectGeometries(projectId) {
         console.log(`🗺️ Fetching geometries for project ${projectId}...`);
         try {
-            const response = await this.request(`/projects/${projectId}/geometries`);
+            const response = await this.requestDecoded(`/projects/${projectId}/geometries`);
             // The response is already the FeatureCollection object
             return response;
         } catch (error) {
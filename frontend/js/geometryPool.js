@@ -0,0 +1,163 @@
+// Pool of geometry workers (geometryWorker.js) that fetch and decode large
+// API responses off the main thread. Geometries come back packed in typed
+// arrays and are revived as PackedGeometry, which Leaflet layers are built
+// from directly; code that reads geometry.coordinates or serializes the
+// geometry still sees plain GeoJSON, unpacked on first use.
+
+const MAX_WORKERS = 4;
+
+export class PackedGeometry {
+    constructor({ type, stride, coords, ringEnds, partEnds, bbox }) {
+        this.type = type;
+        this.stride = stride;
+        this.coords = coords;
+        this.ringEnds = ringEnds;
+        this.partEnds = partEnds;
+        this.bbox = bbox;
+        this._coordinates = null;
+    }
+
+    position(i) {
+        const base = i * this.stride;
+        return this.stride === 3
+            ? [this.coords[base], this.coords[base + 1], this.coords[base + 2]]
+            : [this.coords[base], this.coords[base + 1]];
+    }
+
+    latLng(i) {
+        const base = i * this.stride;
+        return L.latLng(this.coords[base + 1], this.coords[base]);
+    }
+
+    range(begin, end, read) {
+        const out = new Array(end - begin);
+        for (let i = begin; i < end; i++) out[i - begin] = read(i);
+        return out;
+    }
+
+    // Rings (or lines) as arrays of whatever read returns
+    rings(read) {
+        let begin = 0;
+        return Array.from(this.ringEnds, end => {
+            const ring = this.range(begin, end, read);
+            begin = end;
+            return ring;
+        });
+    }
+
+    polygons(read) {
+        const rings = this.rings(read);
+        let begin = 0;
+        return Array.from(this.partEnds, end => {
+            const polygon = rings.slice(begin, end);
+            begin = end;
+            return polygon;
+        });
+    }
+
+    shape(read) {
+        const count = this.coords.length / this.stride;
+        switch (this.type) {
+            case 'Point': return read(0);
+            case 'MultiPoint':
+            case 'LineString': return this.range(0, count, read);
+            case 'MultiLineString':
+            case 'Polygon': return this.rings(read);
+            case 'MultiPolygon': return this.polygons(read);
+            default: return [];
+        }
+    }
+
+    get coordinates() {
+        if (!this._coordinates) this._coordinates = this.shape(i => this.position(i));
+        return this._coordinates;
+    }
+
+    toJSON() {
+        return { type: this.type, coordinates: this.coordinates };
+    }
+
+    getBounds() {
+        if (!this.bbox) return null;
+        const [west, south, east, north] = this.bbox;
+        return L.latLngBounds([south, west], [north, east]);
+    }
+
+    // The layer L.geoJSON would make, built from the arrays without GeoJSON
+    toLayer(options = {}) {
+        const latLngs = this.shape(i => this.latLng(i));
+        switch (this.type) {
+            case 'Point': return L.marker(latLngs, options);
+            case 'MultiPoint': return L.featureGroup(latLngs.map(latLng => L.marker(latLng, options)));
+            case 'LineString':
+            case 'MultiLineString': return L.polyline(latLngs, options);
+            case 'Polygon':
+            case 'MultiPolygon': return L.polygon(latLngs, options);
+            default: return L.featureGroup();
+        }
+    }
+}
+
+// Swaps the packed objects the worker sent for PackedGeometry, in place
+function revive(value) {
+    if (!value || typeof value !== 'object' || ArrayBuffer.isView(value)) return value;
+    if (value.__packed) return new PackedGeometry(value);
+    const keys = Array.isArray(value) ? value.keys() : Object.keys(value);
+    for (const key of keys) {
+        value[key] = revive(value[key]);
+    }
+    return value;
+}
+
+class GeometryPool {
+    constructor() {
+        this.available = typeof Worker !== 'undefined';
+        this.size = Math.min(MAX_WORKERS, Math.max(1, (navigator.hardwareConcurrency || 2) - 1));
+        this.workers = []; // { worker, busy }
+        this.pending = new Map();
+        this.nextRequest = 1;
+    }
+
+    // Least busy worker, started on demand up to size
+    pick() {
+        const idle = this.workers.find(entry => entry.busy === 0);
+        if (idle || this.workers.length >= this.size) {
+            return idle || this.workers.reduce((a, b) => (b.busy < a.busy ? b : a));
+        }
+        const entry = { worker: new Worker(new URL('./geometryWorker.js', import.meta.url)), busy: 0 };
+        entry.worker.onmessage = (event) => this.settle(entry, event.data);
+        this.workers.push(entry);
+        return entry;
+    }
+
+    settle(entry, { id, result, error, status, stats }) {
+        entry.busy--;
+        const request = this.pending.get(id);
+        if (!request) return;
+        this.pending.delete(id);
+        if (error) {
+            const failure = new Error(error);
+            failure.status = status;
+            request.reject(failure);
+            return;
+        }
+        console.log(`🧵 Decoded ${request.url} off the main thread: ${stats.bytes} bytes, ${stats.geometries} geometries in ${stats.ms.toFixed(0)} ms`);
+        request.resolve(revive(result));
+    }
+
+    // GET url in a worker; rejects with error.status set for HTTP errors.
+    // String fields named in parseFields holding GeoJSON text are parsed too.
+    fetch(url, { headers = {}, timeout = 10000, parseFields = [] } = {}) {
+        const entry = this.pick();
+        const id = this.nextRequest++;
+        entry.busy++;
+        return new Promise((resolve, reject) => {
+            this.pending.set(id, { resolve, reject, url });
+            entry.worker.postMessage({ id, url, headers, timeout, parseFields });
+        });
+    }
+}
+
+const geometryPool = new GeometryPool();
+
+export default geometryPool;
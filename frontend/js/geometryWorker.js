@@ -0,0 +1,226 @@
+// Fetches and decodes API responses off the main thread (see geometryPool.js).
+// The body is read as JSON or CBOR (BinaryFormat on the backend), string
+// fields named in parseFields that hold GeoJSON text are parsed too, and
+// every GeoJSON geometry is packed into typed arrays with its bounding box.
+// The arrays are transferred back, not copied.
+
+const GEOMETRY_TYPES = new Set(['Point', 'MultiPoint', 'LineString', 'MultiLineString', 'Polygon', 'MultiPolygon']);
+
+// --- CBOR (RFC 8949), as written by nlohmann::json::to_cbor ---
+
+function decodeCbor(buffer) {
+    const view = new DataView(buffer);
+    const bytes = new Uint8Array(buffer);
+    const text = new TextDecoder();
+    let offset = 0;
+
+    const halfToFloat = (half) => {
+        const exponent = (half >> 10) & 0x1f;
+        const mantissa = half & 0x3ff;
+        const sign = half & 0x8000 ? -1 : 1;
+        if (exponent === 0) return sign * Math.pow(2, -14) * (mantissa / 1024);
+        if (exponent === 31) return mantissa ? NaN : sign * Infinity;
+        return sign * Math.pow(2, exponent - 15) * (1 + mantissa / 1024);
+    };
+
+    const readLength = (info) => {
+        if (info < 24) return info;
+        if (info === 24) return view.getUint8(offset++);
+        if (info === 25) { const v = view.getUint16(offset); offset += 2; return v; }
+        if (info === 26) { const v = view.getUint32(offset); offset += 4; return v; }
+        if (info === 27) { const v = Number(view.getBigUint64(offset)); offset += 8; return v; }
+        if (info === 31) return -1; // indefinite
+        throw new Error(`Invalid CBOR length ${info}`);
+    };
+
+    const isBreak = () => bytes[offset] === 0xff && (offset++, true);
+
+    const read = () => {
+        const initial = view.getUint8(offset++);
+        const major = initial >> 5;
+        const info = initial & 0x1f;
+
+        switch (major) {
+            case 0: return readLength(info);
+            case 1: return -1 - readLength(info);
+            case 2:
+            case 3: {
+                const length = readLength(info);
+                if (length < 0) {
+                    const chunks = [];
+                    while (!isBreak()) chunks.push(read());
+                    return major === 3 ? chunks.join('') : chunks;
+                }
+                const slice = bytes.subarray(offset, offset + length);
+                offset += length;
+                return major === 3 ? text.decode(slice) : slice.slice();
+            }
+            case 4: {
+                const length = readLength(info);
+                const array = [];
+                if (length < 0) {
+                    while (!isBreak()) array.push(read());
+                } else {
+                    for (let i = 0; i < length; i++) array.push(read());
+                }
+                return array;
+            }
+            case 5: {
+                const length = readLength(info);
+                const object = {};
+                if (length < 0) {
+                    while (!isBreak()) { const key = read(); object[key] = read(); }
+                } else {
+                    for (let i = 0; i < length; i++) { const key = read(); object[key] = read(); }
+                }
+                return object;
+            }
+            case 6:
+                readLength(info); // tag number; the tagged item is returned as is
+                return read();
+            default:
+                if (info === 20) return false;
+                if (info === 21) return true;
+                if (info === 22 || info === 23) return null;
+                if (info === 25) { const v = view.getUint16(offset); offset += 2; return halfToFloat(v); }
+                if (info === 26) { const v = view.getFloat32(offset); offset += 4; return v; }
+                if (info === 27) { const v = view.getFloat64(offset); offset += 8; return v; }
+                throw new Error(`Unsupported CBOR simple value ${info}`);
+        }
+    };
+
+    return read();
+}
+
+// --- Geometry packing ---
+
+// Not push(...ring): a long ring would exceed the argument limit
+function appendRing(positions, ring) {
+    for (const position of ring) positions.push(position);
+}
+
+// Positions go to one Float64Array with stride 2 or 3 (GeoJSON order,
+// lng/lat[/alt]); ringEnds holds the position index where each ring or
+// line ends, partEnds the ring index where each polygon of a MultiPolygon
+// ends. bbox is [west, south, east, north].
+function packGeometry(geometry, transfer) {
+    const { type, coordinates } = geometry;
+    let positions;
+    const ringEnds = [];
+    const partEnds = [];
+
+    switch (type) {
+        case 'Point': positions = [coordinates]; break;
+        case 'MultiPoint':
+        case 'LineString': positions = coordinates; break;
+        case 'MultiLineString':
+        case 'Polygon':
+            positions = [];
+            coordinates.forEach(ring => { appendRing(positions, ring); ringEnds.push(positions.length); });
+            break;
+        case 'MultiPolygon':
+            positions = [];
+            coordinates.forEach(polygon => {
+                polygon.forEach(ring => { appendRing(positions, ring); ringEnds.push(positions.length); });
+                partEnds.push(ringEnds.length);
+            });
+            break;
+    }
+
+    const stride = positions.some(position => position.length > 2) ? 3 : 2;
+    const coords = new Float64Array(positions.length * stride);
+    const bbox = [Infinity, Infinity, -Infinity, -Infinity];
+    positions.forEach((position, i) => {
+        const [lng, lat] = position;
+        coords[i * stride] = lng;
+        coords[i * stride + 1] = lat;
+        if (stride === 3) coords[i * stride + 2] = position.length > 2 ? position[2] : 0;
+        if (lng < bbox[0]) bbox[0] = lng;
+        if (lat < bbox[1]) bbox[1] = lat;
+        if (lng > bbox[2]) bbox[2] = lng;
+        if (lat > bbox[3]) bbox[3] = lat;
+    });
+
+    const packed = {
+        __packed: true,
+        type,
+        stride,
+        coords,
+        ringEnds: new Uint32Array(ringEnds),
+        partEnds: new Uint32Array(partEnds),
+        bbox: positions.length ? bbox : null
+    };
+    transfer.push(coords.buffer, packed.ringEnds.buffer, packed.partEnds.buffer);
+    return packed;
+}
+
+function isGeometry(value) {
+    return value && typeof value === 'object' && GEOMETRY_TYPES.has(value.type) && Array.isArray(value.coordinates);
+}
+
+// Replaces geometries in place, depth first; returns the number packed
+function packAll(value, parseFields, transfer) {
+    if (!value || typeof value !== 'object') return 0;
+    let packed = 0;
+    const keys = Array.isArray(value) ? value.keys() : Object.keys(value);
+    for (const key of keys) {
+        let child = value[key];
+        if (typeof child === 'string' && parseFields.includes(key)) {
+            try {
+                child = value[key] = JSON.parse(child);
+            } catch (error) {
+                continue;
+            }
+        }
+        if (isGeometry(child)) {
+            value[key] = packGeometry(child, transfer);
+            packed++;
+        } else {
+            packed += packAll(child, parseFields, transfer);
+        }
+    }
+    return packed;
+}
+
+function decodeBody(buffer, contentType) {
+    if (contentType.includes('application/cbor')) return decodeCbor(buffer);
+    return JSON.parse(new TextDecoder().decode(buffer));
+}
+
+self.onmessage = async (event) => {
+    const { id, url, headers, timeout, parseFields = [] } = event.data;
+    const controller = new AbortController();
+    const timer = setTimeout(() => controller.abort(), timeout);
+    try {
+        const response = await fetch(url, {
+            headers: { Accept: 'application/cbor, application/json;q=0.9', ...headers },
+            signal: controller.signal
+        });
+        const buffer = await response.arrayBuffer();
+        const contentType = response.headers.get('Content-Type') || '';
+        if (!response.ok) {
+            let message = `HTTP ${response.status}: ${response.statusText}`;
+            try {
+                message = decodeBody(buffer, contentType).message || message;
+            } catch (error) {
+                // keep the status line
+            }
+            self.postMessage({ id, error: message, status: response.status });
+            return;
+        }
+
+        const started = performance.now();
+        const result = decodeBody(buffer, contentType);
+        const transfer = [];
+        const geometries = packAll(result, parseFields, transfer);
+        self.postMessage({
+            id,
+            result,
+            stats: { bytes: buffer.byteLength, geometries, ms: performance.now() - started }
+        }, transfer);
+    } catch (error) {
+        self.postMessage({ id, error: error.name === 'AbortError' ? 'Request timeout' : error.message });
+    } finally {
+        clearTimeout(timer);
+    }
+};
@@ -1,5 +1,21 @@
 // Enhanced Image Editor with OCR Processing Modal
 import { showNotification } from './ui.js';
+import apiClient from './api.js';
+
+// Scans larger than this on their longest side are downscaled as they are
+// decoded, unless turned off in the editor (remembered in localStorage)
+const MAX_IMAGE_PX = 4096;
+const DOWNSCALE_KEY = 'image_editor_downscale';
+
+// Document pipeline stages (DocumentPipeline on the backend) as shown in the modal
+const SERVER_STAGES = {
+    queued: 'Waiting for a server worker...',
+    decoding: 'Decoding image...',
+    thumbnail: 'Creating thumbnail...',
+    ocr: 'Recognizing text...',
+    coordinates: 'Extracting coordinates...',
+    done: 'Finishing...'
+};
 
 // OCR Modal Manager Class
 class OCRModalManager {
@@ -139,6 +155,10 @@ class ImageEditor {
         this.rotation = 0;
         this.selection = null;
         this.isSelecting = false;
+        // Coordinate pairs the server read from its OCR text, used while the text is unedited
+        this.serverCoordinates = null;
+        // Set once the backend reports it was built without OCR
+        this.serverOcrUnavailable = false;
 
         // Initialize OCR Modal
         this.ocrModal = new OCRModalManager();
@@ -164,6 +184,15 @@ class ImageEditor {
             this.drawImage();
         });
 
+        // Downscaling applies to the next image opened
+        const downscaleToggle = this.modal.querySelector('#downscale-toggle');
+        if (downscaleToggle) {
+            downscaleToggle.checked = localStorage.getItem(DOWNSCALE_KEY) !== 'false';
+            downscaleToggle.addEventListener('change', (e) => {
+                localStorage.setItem(DOWNSCALE_KEY, String(e.target.checked));
+            });
+        }
+
         // OCR button - Enhanced with better feedback
         this.modal.querySelector('#run-ocr-btn').addEventListener('click', () => this.runEnhancedOCR());
 
@@ -233,26 +262,64 @@ class ImageEditor {
         });
     }
 
-    show(imageFile) {
-        const reader = new FileReader();
-        reader.onload = (e) => {
-            this.image = new Image();
-            this.image.onload = () => {
-                // Set canvas resolution to match image
-                this.canvas.width = this.image.width;
-                this.canvas.height = this.image.height;
-                this.drawImage();
-                this.modal.classList.remove('hidden');
-                this.modal.style.display = 'flex';
-                
-                // Reset controls
-                this.resetControls();
-                
-                showNotification(`Image loaded: ${this.image.width}×${this.image.height}px`, 'info');
-            };
-            this.image.src = e.target.result;
-        };
-        reader.readAsDataURL(imageFile);
+    async show(imageFile) {
+        let original;
+        try {
+            ({ image: this.image, original } = await this.decodeImage(imageFile));
+        } catch (error) {
+            console.error('Image decode error:', error);
+            showNotification('Could not read the image', 'error');
+            return;
+        }
+
+        // Set canvas resolution to match image
+        this.canvas.width = this.image.width;
+        this.canvas.height = this.image.height;
+        this.drawImage();
+        this.modal.classList.remove('hidden');
+        this.modal.style.display = 'flex';
+
+        // Reset controls
+        this.resetControls();
+
+        const size = `${this.image.width}×${this.image.height}px`;
+        showNotification(original
+            ? `Image loaded: ${size} (downscaled from ${original.width}×${original.height}px)`
+            : `Image loaded: ${size}`, 'info');
+    }
+
+    // {image, original}: the file decoded to something drawImage takes, and
+    // its size before downscaling when it was downscaled. A large scan is
+    // resized once here, so the canvas, OCR crops and uploads stay small.
+    async decodeImage(file) {
+        const downscale = localStorage.getItem(DOWNSCALE_KEY) !== 'false';
+        if (typeof createImageBitmap === 'function') {
+            const full = await createImageBitmap(file);
+            const scale = MAX_IMAGE_PX / Math.max(full.width, full.height);
+            if (!downscale || scale >= 1) return { image: full, original: null };
+            const resized = await createImageBitmap(full, {
+                resizeWidth: Math.round(full.width * scale),
+                resizeHeight: Math.round(full.height * scale),
+                resizeQuality: 'high'
+            });
+            const original = { width: full.width, height: full.height };
+            full.close();
+            return { image: resized, original };
+        }
+
+        // No ImageBitmap: decode at full size
+        const url = URL.createObjectURL(file);
+        try {
+            const image = new Image();
+            await new Promise((resolve, reject) => {
+                image.onload = resolve;
+                image.onerror = () => reject(new Error('Image decode failed'));
+                image.src = url;
+            });
+            return { image, original: null };
+        } finally {
+            URL.revokeObjectURL(url);
+        }
     }
 
     hide() {
@@ -262,9 +329,11 @@ class ImageEditor {
     }
 
     reset() {
+        if (this.image && this.image.close) this.image.close();
         this.image = null;
         this.rotation = 0;
         this.selection = null;
+        this.serverCoordinates = null;
         this.ctx.clearRect(0, 0, this.canvas.width, this.canvas.height);
         this.resetControls();
     }
@@ -350,35 +419,13 @@ class ImageEditor {
             const statusEl = this.modal.querySelector('#ocr-status');
             if (statusEl) statusEl.textContent = 'Processing...';
 
-            // Phase 1: Initialize OCR
-            await this.delay(500);
-            this.ocrModal.showProgress('Initializing OCR engine...', 'Loading Tesseract.js workers...');
-
-            // Phase 2: Crop image
-            await this.delay(800);
             this.ocrModal.showProgress('Preparing image...', 'Cropping selected region...');
             const croppedCanvas = this.getCroppedCanvas();
+            this.serverCoordinates = null;
 
-            // Phase 3: Start OCR
-            await this.delay(500);
-            this.ocrModal.showProgress('Analyzing image...', 'Detecting text regions...');
-
-            // Run actual OCR
-            const { data: { text, confidence } } = await Tesseract.recognize(
-                croppedCanvas,
-                'eng',
-                { 
-                    logger: m => {
-                        if (m.status === 'recognizing text') {
-                            const progress = Math.round(m.progress * 100);
-                            this.ocrModal.showProgress(
-                                'Recognizing text...', 
-                                `Progress: ${progress}% - Processing characters...`
-                            );
-                        }
-                    }
-                }
-            );
+            // The backend pipeline when it can, else Tesseract.js in this tab
+            const { text, confidence } =
+                (await this.recognizeOnServer(croppedCanvas)) || (await this.recognizeInBrowser(croppedCanvas));
 
             // Phase 4: Process results
             await this.delay(300);
@@ -432,6 +479,65 @@ class ImageEditor {
         }
     }
 
+    // {text, confidence} from the backend document pipeline, or null when
+    // it cannot help (disabled, unreachable or built without OCR) so the
+    // caller falls back to the browser. An image sent before is answered
+    // from the server's cache.
+    async recognizeOnServer(canvas) {
+        if (this.serverOcrUnavailable) return null;
+        try {
+            this.ocrModal.showProgress('Uploading image...', 'Sending the selected region to the server...');
+            const blob = await new Promise(resolve => canvas.toBlob(resolve, 'image/png'));
+            if (!blob) return null;
+
+            const submitted = await apiClient.uploadDocument(blob, {
+                onProgress: sent => this.ocrModal.showProgress('Uploading image...', `${Math.round(sent * 100)}% sent`)
+            });
+            const result = submitted.data || await apiClient.waitForDocument(submitted.job_id, {
+                onStage: stage => this.ocrModal.showProgress('Processing on server...', SERVER_STAGES[stage] || stage)
+            });
+            if (!result.ocr_available) {
+                console.log('ℹ️ Server has no OCR engine; using Tesseract.js');
+                this.serverOcrUnavailable = true;
+                return null;
+            }
+
+            this.serverCoordinates = {
+                text: result.text,
+                coordinates: result.coordinates.map(coordinate => coordinate.values)
+            };
+            return { text: result.text, confidence: result.confidence };
+        } catch (error) {
+            console.warn('⚠️ Server OCR failed, using Tesseract.js:', error.message);
+            return null;
+        }
+    }
+
+    async recognizeInBrowser(canvas) {
+        await this.delay(500);
+        this.ocrModal.showProgress('Initializing OCR engine...', 'Loading Tesseract.js workers...');
+
+        await this.delay(500);
+        this.ocrModal.showProgress('Analyzing image...', 'Detecting text regions...');
+
+        const { data: { text, confidence } } = await Tesseract.recognize(
+            canvas,
+            'eng',
+            {
+                logger: m => {
+                    if (m.status === 'recognizing text') {
+                        const progress = Math.round(m.progress * 100);
+                        this.ocrModal.showProgress(
+                            'Recognizing text...',
+                            `Progress: ${progress}% - Processing characters...`
+                        );
+                    }
+                }
+            }
+        );
+        return { text, confidence };
+    }
+
     delay(ms) {
         return new Promise(resolve => setTimeout(resolve, ms));
     }
@@ -492,32 +598,41 @@ class ImageEditor {
         const lines = ocrText.split('\n').filter(line => line.trim() !== '');
         const coordinates = [];
         const errors = [];
-        
-        lines.forEach((line, index) => {
-            try {
-                // Enhanced regex for coordinate detection
-                const coordPatterns = [
-                    /-?\d+\.\d+/g, // Decimal coordinates
-                    /\d+°\d+'[\d.]+"/g, // DMS coordinates
-                    /[-+]?\d*\.?\d+/g // General numbers
-                ];
+
+        // The server's pairs (degrees-minutes-seconds already converted) while
+        // the text is as it came back; an edited text is parsed again here
+        const serverPairs = this.serverCoordinates && this.serverCoordinates.text === ocrText
+            ? this.serverCoordinates.coordinates
+            : null;
+        if (serverPairs && serverPairs.length > 0) {
+            coordinates.push(...serverPairs);
+        } else {
+            lines.forEach((line, index) => {
+                try {
+                    // Enhanced regex for coordinate detection
+                    const coordPatterns = [
+                        /-?\d+\.\d+/g, // Decimal coordinates
+                        /\d+°\d+'[\d.]+"/g, // DMS coordinates
+                        /[-+]?\d*\.?\d+/g // General numbers
+                    ];
                 
-                let matches = null;
-                for (const pattern of coordPatterns) {
-                    matches = line.match(pattern);
-                    if (matches && matches.length >= 2) break;
-                }
+                    let matches = null;
+                    for (const pattern of coordPatterns) {
+                        matches = line.match(pattern);
+                        if (matches && matches.length >= 2) break;
+                    }
                 
-                if (matches && matches.length >= 2) {
-                    const coord = matches.slice(0, 2).map(parseFloat);
-                    if (!isNaN(coord[0]) && !isNaN(coord[1])) {
-                        coordinates.push(coord);
+                    if (matches && matches.length >= 2) {
+                        const coord = matches.slice(0, 2).map(parseFloat);
+                        if (!isNaN(coord[0]) && !isNaN(coord[1])) {
+                            coordinates.push(coord);
+                        }
                     }
+                } catch (error) {
+                    errors.push(`Line ${index + 1}: ${line}`);
                 }
-            } catch (error) {
-                errors.push(`Line ${index + 1}: ${line}`);
-            }
-        });
+            });
+        }
 
         if (coordinates.length === 0) {
             showNotification('No valid coordinates found in OCR text', 'error');
@@ -2,6 +2,7 @@
 import authManager from './auth.js';
 import mapManager from './map.js';
 import apiClient from './api.js';
+import analysisEvents from './analysisEvents.js';
 import coordinateEntryManager from './coordinateEntry.js';
 import uiManager, { 
     showLoading, 
@@ -358,7 +359,9 @@ debugApplicationState() {
         const project = this.projects.find(p => p.id == projectId);
     
         if (project) {
+            if (this.activeProject) analysisEvents.unwatch(this.activeProject.id);
             this.activeProject = project;
+            analysisEvents.watch(project.id);
             updateProjectBar(this.activeProject);
             hideProjectListModal(); // Hide the modal first for better UX
     
@@ -393,6 +396,7 @@ debugApplicationState() {
         
         console.log(`🚪 Closing project: ${this.activeProject.title}`);
         const closedProjectTitle = this.activeProject.title;
+        analysisEvents.unwatch(this.activeProject.id);
         this.activeProject = null;
         updateProjectBar(null);
         showNotification(`Project "${closedProjectTitle}" closed.`, 'info');
@@ -495,12 +499,40 @@ debugApplicationState() {
         }
     }
 
+    // Conflicts change when an analysis finishes, which the event channel
+    // pushes. The poll only runs while the channel is down, and backs off
+    // from 30 s to 5 min so an idle tab costs next to nothing.
     setupConflictRefresh() {
-        this.conflictRefreshInterval = setInterval(async () => {
+        const refresh = async () => {
             if (window.mapManager?.refreshConflicts) {
                 await window.mapManager.refreshConflicts();
             }
-        }, 30000);
+        };
+        const resetDelay = () => { this.conflictRefreshDelay = 30000; };
+        const schedulePoll = () => {
+            clearTimeout(this.conflictRefreshTimer);
+            if (analysisEvents.connected) return;
+            this.conflictRefreshTimer = setTimeout(async () => {
+                await refresh();
+                this.conflictRefreshDelay = Math.min(this.conflictRefreshDelay * 2, 300000);
+                schedulePoll();
+            }, this.conflictRefreshDelay);
+        };
+
+        analysisEvents.on('analysis_finished', event => {
+            if (event.project_id == this.activeProject?.id) refresh();
+        });
+        analysisEvents.on('connected', () => {
+            clearTimeout(this.conflictRefreshTimer);
+            resetDelay();
+            // Catch up on whatever finished while the channel was down
+            refresh();
+        });
+        analysisEvents.on('disconnected', schedulePoll);
+
+        resetDelay();
+        analysisEvents.connect();
+        schedulePoll();
     }
 
     // --- NEW FUNCTION TO SET UP THE EVENT LISTENER ---
@@ -1,8 +1,13 @@
 // Map management and drawing functionality
 import apiClient from './api.js';
+import { PackedGeometry } from './geometryPool.js';
 // import { showDroneZoneForm, updateConflictPanel } from './ui.js';
 import { showDroneZoneForm, updateConflictPanel, showNotification } from './ui.js';
 
+// Zooms of the backend's simplified geometry levels (SimplifiedGeometry::kLevelZooms);
+// deeper zooms get the stored geometry
+const SIMPLIFICATION_ZOOMS = [4, 6, 8, 10, 12];
+
 class MapManager {
     constructor() {
         this.map = null;
@@ -21,8 +26,17 @@ class MapManager {
         this.runways = {};  
         this.droneZones = [];
         this.conflicts = [];
+        this.previewTimer = null;
+        this.previewSequence = 0;
         this.currentDrawer = null;
         this.selectedAirport = null;
+        // 'canvas' draws procedures, protections and conflicts on one shared
+        // canvas, adds only the procedures in view and fetches geometry
+        // simplified for the zoom; 'svg' keeps one SVG element per feature
+        this.renderMode = localStorage.getItem('map_render_mode') === 'svg' ? 'svg' : 'canvas';
+        this.canvasRenderer = L.canvas({ padding: 0.5, tolerance: 4 });
+        this.procedureLayers = new Map(); // procedure id -> { layer, bounds }
+        this.procedureZoom = null;        // zoom the loaded geometry was simplified for
     }
 
     init(mapElementId) {
@@ -60,6 +74,8 @@ class MapManager {
         // Setup drawing controls
         this.setupDrawingControls();
 
+        this.setupRenderMode();
+
         // Load initial data
         this.loadData();
 
@@ -102,6 +118,55 @@ class MapManager {
         });
     }
 
+    setupRenderMode() {
+        const selector = document.getElementById('render-mode');
+        if (selector) {
+            selector.value = this.renderMode;
+            selector.addEventListener('change', () => this.setRenderMode(selector.value));
+        }
+
+        this.map.on('moveend', () => this.onViewChanged());
+    }
+
+    async setRenderMode(mode) {
+        if (mode === this.renderMode) return;
+        console.log(`🖌️ Switching map rendering to ${mode}`);
+        this.renderMode = mode;
+        localStorage.setItem('map_render_mode', mode);
+
+        // Simplified geometry is only fetched in canvas mode
+        if (this.simplificationZoom() !== this.procedureZoom) {
+            await this.loadProceduresFromDatabase();
+        }
+        this.renderProcedures();
+        this.renderConflicts();
+    }
+
+    // Options for dense vector layers: the shared canvas in canvas mode
+    vectorOptions(options = {}) {
+        return this.renderMode === 'canvas' ? { ...options, renderer: this.canvasRenderer } : options;
+    }
+
+    // Zoom to request simplified procedure geometry for, or null for full
+    // resolution; the same for every zoom of one simplification level
+    simplificationZoom() {
+        if (this.renderMode !== 'canvas' || !this.map) return null;
+        const zoom = Math.round(this.map.getZoom());
+        const level = SIMPLIFICATION_ZOOMS.find(levelZoom => levelZoom >= zoom);
+        return level === undefined ? null : level;
+    }
+
+    async onViewChanged() {
+        if (this.renderMode !== 'canvas') return;
+
+        if (this.simplificationZoom() !== this.procedureZoom) {
+            await this.loadProceduresFromDatabase();
+            this.renderProcedures();
+        } else {
+            this.updateVisibleProcedures();
+        }
+    }
+
     setupCoordinateDisplay() {
         const coordsElement = document.getElementById('map-coords');
         
@@ -1228,15 +1293,23 @@ class MapManager {
         try {
             console.log('✈️ Loading flight procedures from database...');
             
+            const zoom = this.simplificationZoom();
             const procedures = await apiClient.getProcedures({
                 is_active: true,
-                limit: 100
+                limit: 100,
+                zoom: zoom
             });
             
             const dataSource = apiClient.getDataSource();
             console.log(`📊 Loaded ${procedures.length} procedures from ${dataSource}`);
             
+            // A reload at another zoom keeps what the user has hidden
+            const hidden = new Set(this.procedures.filter(p => p.isVisible === false).map(p => p.id));
+            procedures.forEach(procedure => {
+                if (hidden.has(procedure.id)) procedure.isVisible = false;
+            });
             this.procedures = procedures;
+            this.procedureZoom = zoom;
             
             procedures.forEach(procedure => {
                 console.log(`✈️ Loaded procedure: ${procedure.procedure_code} (${procedure.type})`);
@@ -1399,6 +1472,7 @@ loadAndRenderProjectGeometries(geometryCollection) {
     renderProcedures() {
         console.log('✈️ Rendering flight procedures on map:', this.procedures.length);
         this.layers.procedures.clearLayers();
+        this.procedureLayers.clear();
     
         if (!this.procedures || this.procedures.length === 0) {
             console.warn('⚠️ No procedures to render');
@@ -1412,10 +1486,12 @@ loadAndRenderProjectGeometries(geometryCollection) {
             }
             
             try {
-                console.log(`🎨 Rendering procedure: ${procedure.procedure_code}`);
+                // Each procedure is built once into its own group; canvas mode
+                // adds to the map only the groups inside the view
+                const group = L.featureGroup();
                 
                 // Render main procedure trajectory
-                this.renderProcedureTrajectory(procedure);
+                this.renderProcedureTrajectory(procedure, group);
                 
                 // Render individual segments if available
                 // if (procedure.segments && procedure.segments.length > 0) {
@@ -1424,17 +1500,38 @@ loadAndRenderProjectGeometries(geometryCollection) {
                 
                 // Render protection areas if available
                 if (procedure.protections) {
-                    this.renderProcedureProtections(procedure);
+                    this.renderProcedureProtections(procedure, group);
                 }
                 
+                const bounds = group.getLayers().length > 0 ? group.getBounds() : null;
+                this.procedureLayers.set(procedure.id, { layer: group, bounds: bounds });
+                
             } catch (error) {
                 console.error(`❌ Error rendering procedure ${procedure.procedure_code}:`, error);
             }
         });
         
+        this.updateVisibleProcedures();
         console.log('✅ Procedures rendered on map');
     }
 
+    // Keeps on the map the procedures whose bounds reach the view, with a
+    // margin so a short pan does not redraw; SVG mode keeps all of them
+    updateVisibleProcedures() {
+        const view = this.renderMode === 'canvas' ? this.map.getBounds().pad(0.25) : null;
+        let shown = 0;
+        this.procedureLayers.forEach(({ layer, bounds }) => {
+            const inView = !view || (bounds && bounds.isValid() && view.intersects(bounds));
+            if (inView) {
+                shown++;
+                if (!this.layers.procedures.hasLayer(layer)) this.layers.procedures.addLayer(layer);
+            } else if (this.layers.procedures.hasLayer(layer)) {
+                this.layers.procedures.removeLayer(layer);
+            }
+        });
+        console.log(`👁️ ${shown}/${this.procedureLayers.size} procedures in view`);
+    }
+
     // renderProcedureTrajectory(procedure) {
     //     if (!procedure.geometry) {
     //         console.warn(`⚠️ No geometry for procedure ${procedure.procedure_code}`);
@@ -1497,11 +1594,53 @@ loadAndRenderProjectGeometries(geometryCollection) {
     //     }
     // }
     
-    renderProcedureTrajectory(procedure) {
+    hasPackedGeometry(geojson) {
+        return geojson.type === 'FeatureCollection' &&
+            geojson.features.some(feature => feature.geometry instanceof PackedGeometry);
+    }
+
+    // L.geoJSON for plain GeoJSON. Packed geometries (geometryPool.js) are
+    // made into layers straight from their typed arrays, with the same
+    // style and onEachFeature handling, grouped in one FeatureGroup.
+    geometryLayer(geojson, options = {}) {
+        const features = geojson.type === 'FeatureCollection' ? geojson.features : [geojson];
+        const geometryOf = feature => (feature && feature.type === 'Feature' ? feature.geometry : feature);
+        if (!features.some(feature => geometryOf(feature) instanceof PackedGeometry)) {
+            return L.geoJSON(geojson, options);
+        }
+
+        const { style, onEachFeature, ...pathOptions } = options;
+        const group = L.featureGroup();
+        features.forEach(feature => {
+            const geometry = geometryOf(feature);
+            if (!geometry) return;
+            if (!(geometry instanceof PackedGeometry)) {
+                group.addLayer(L.geoJSON(feature, options));
+                return;
+            }
+            const featureStyle = typeof style === 'function' ? style(feature) : style;
+            const layer = geometry.toLayer({ ...pathOptions, ...featureStyle });
+            layer.feature = feature.type === 'Feature' ? feature : { type: 'Feature', properties: {}, geometry };
+            if (onEachFeature) onEachFeature(layer.feature, layer);
+            group.addLayer(layer);
+        });
+        return group;
+    }
+
+    renderProcedureTrajectory(procedure, target = this.layers.procedures) {
         if (!procedure.geometry) return;
         
         let geometryToRender = procedure.geometry;
         
+        // Packed lines (decoded in a worker) become layers straight from their arrays
+        if (this.hasPackedGeometry(geometryToRender)) {
+            const lines = geometryToRender.features.filter(f => f.geometry && f.geometry.type === 'LineString');
+            target.addLayer(this.geometryLayer({ type: 'FeatureCollection', features: lines }, this.vectorOptions({
+                style: this.getProcedureStyle(procedure)
+            })));
+            return;
+        }
+        
         // Handle FeatureCollection case
         if (geometryToRender.type === 'FeatureCollection') {
             // Convert to MultiLineString or handle multiple features
@@ -1515,11 +1654,11 @@ loadAndRenderProjectGeometries(geometryCollection) {
             };
         }
         
-        const layer = L.geoJSON(geometryToRender, {
+        const layer = this.geometryLayer(geometryToRender, this.vectorOptions({
             style: this.getProcedureStyle(procedure)
-        });
+        }));
         
-        this.layers.procedures.addLayer(layer);
+        target.addLayer(layer);
     }
 
 
@@ -1683,7 +1822,7 @@ loadAndRenderProjectGeometries(geometryCollection) {
     //     this.layers.procedures.addLayer(layer);
     // }
 
-    renderProcedureProtections(procedure) {
+    renderProcedureProtections(procedure, target = this.layers.procedures) {
         if (!procedure.protections || !procedure.protections.features || procedure.protections.features.length === 0) {
             return;
         }
@@ -1691,8 +1830,14 @@ loadAndRenderProjectGeometries(geometryCollection) {
         let geometryToRender = procedure.protections;
     
         // ** NEW ROBUST LOGIC **
-        // Check if it's a FeatureCollection and rebuild it into a single MultiPolygon
-        if (geometryToRender.type === 'FeatureCollection') {
+        // Check if it's a FeatureCollection and rebuild it into a single MultiPolygon;
+        // packed polygons are drawn one layer each, without unpacking
+        if (this.hasPackedGeometry(geometryToRender)) {
+            geometryToRender = {
+                type: 'FeatureCollection',
+                features: geometryToRender.features.filter(f => f.geometry && (f.geometry.type === 'Polygon' || f.geometry.type === 'MultiPolygon'))
+            };
+        } else if (geometryToRender.type === 'FeatureCollection') {
             const coordinates = geometryToRender.features
                 // Filter for features that are Polygons or MultiPolygons
                 .filter(f => f.geometry && (f.geometry.type === 'Polygon' || f.geometry.type === 'MultiPolygon'))
@@ -1709,16 +1854,16 @@ loadAndRenderProjectGeometries(geometryCollection) {
             };
         }
     
-        const layer = L.geoJSON(geometryToRender, {
+        const layer = this.geometryLayer(geometryToRender, this.vectorOptions({
             style: feature => this.getProtectionStyle(procedure), // Use procedure properties for styling
             onEachFeature: (feature, layer) => {
                 // The popup now gets properties from the parent procedure
                 const popupContent = this.createProtectionPopup(procedure, procedure);
                 layer.bindPopup(popupContent);
             }
-        });
+        }));
     
-        this.layers.procedures.addLayer(layer);
+        target.addLayer(layer);
     }
     
     
@@ -1779,6 +1924,7 @@ loadAndRenderProjectGeometries(geometryCollection) {
                 window.uiManager.renderProjectTree();
             }
 
+            this.schedulePreviewConflicts();
             return newZone;
             
         } catch (error) {
@@ -1859,7 +2005,7 @@ loadAndRenderProjectGeometries(geometryCollection) {
             }
             
             // Continue with normal polygon creation
-            const layer = L.geoJSON(zone.geometry, {
+            const layer = this.geometryLayer(zone.geometry, {
                 style: style,
                 onEachFeature: (feature, layerFeature) => {
                     // ... existing event handlers ...
@@ -1911,7 +2057,7 @@ loadAndRenderProjectGeometries(geometryCollection) {
 
         this.conflicts.forEach(conflict => {
             if (conflict.geometry) {
-                const layer = L.geoJSON(conflict.geometry, {
+                const layer = L.geoJSON(conflict.geometry, this.vectorOptions({
                     style: {
                         color: '#dc2626',
                         weight: 3,
@@ -1923,7 +2069,7 @@ loadAndRenderProjectGeometries(geometryCollection) {
                         const popupContent = this.createConflictPopup(conflict);
                         layer.bindPopup(popupContent);
                     }
-                });
+                }));
 
                 this.layers.conflicts.addLayer(layer);
             }
@@ -2164,6 +2310,18 @@ loadAndRenderProjectGeometries(geometryCollection) {
                 color = '#3b82f6';
         }
 
+        // Zones the last preview found in conflict get a dashed red outline
+        if (zone.previewConflicts && zone.previewConflicts.length > 0) {
+            return {
+                color: '#dc2626',
+                weight: 3,
+                opacity: 0.9,
+                dashArray: '6 4',
+                fillOpacity: fillOpacity,
+                fillColor: color
+            };
+        }
+
         return {
             color: color,
             weight: 2,
@@ -2173,6 +2331,42 @@ loadAndRenderProjectGeometries(geometryCollection) {
         };
     }
 
+    // Debounced so a burst of edits sends one preview request
+    schedulePreviewConflicts(delay = 250) {
+        clearTimeout(this.previewTimer);
+        this.previewTimer = setTimeout(() => this.previewConflicts(), delay);
+    }
+
+    async previewConflicts() {
+        const sequence = ++this.previewSequence;
+        const zones = this.droneZones.slice();
+        try {
+            const result = zones.length > 0
+                ? await window.apiClient.previewConflicts(zones)
+                : { conflicts: [] };
+            // A newer edit has already asked again
+            if (sequence !== this.previewSequence || !result) {
+                return;
+            }
+
+            zones.forEach(zone => { zone.previewConflicts = []; });
+            (result.conflicts || []).forEach(conflict => {
+                conflict.features.forEach(index => {
+                    if (zones[index]) {
+                        zones[index].previewConflicts.push(conflict.protection_name);
+                    }
+                });
+            });
+            this.renderDroneZones();
+
+            document.dispatchEvent(new CustomEvent('conflictPreview', {
+                detail: { conflicts: result.conflicts || [], elapsedMs: result.elapsed_ms }
+            }));
+        } catch (error) {
+            console.warn('⚠️ Conflict preview failed:', error);
+        }
+    }
+
 
     createDroneZonePopup(zone) {
         return `
@@ -2220,6 +2414,7 @@ loadAndRenderProjectGeometries(geometryCollection) {
                     console.log('🌳 Updating project tree after zone deletion...');
                     window.uiManager.renderProjectTree();
                 }
+                this.schedulePreviewConflicts();
                 console.log('✅ Drone zone deleted successfully');
             } else {
                 console.warn('⚠️ Zone not found in array:', zoneId);
@@ -2344,7 +2539,7 @@ loadAndRenderProjectGeometries(geometryCollection) {
         }
         
         try {
-            const layer = L.geoJSON(procedure.geometry);
+            const layer = this.geometryLayer(procedure.geometry);
             const bounds = layer.getBounds();
             
             if (bounds.isValid()) {
@@ -0,0 +1,156 @@
+// Browser-side copy of the reference tables (airports, waypoints) kept in
+// IndexedDB across sessions. Each table stores the backend data version it
+// was synced to; a session asks /<table>/changes?since=<version> and fetches
+// only the rows it names (?ids=), or everything when the backend answers
+// reset. Lists, bounds and searches then run in a Web Worker over the local
+// rows, without a request.
+
+const DB_NAME = 'aeronautical-reference';
+const DB_VERSION = 1;
+const TABLES = ['airports', 'waypoints'];
+const IDS_PER_REQUEST = 1000; // ChangeLog::kMaxIds
+
+function promisify(request) {
+    return new Promise((resolve, reject) => {
+        request.onsuccess = () => resolve(request.result);
+        request.onerror = () => reject(request.error);
+    });
+}
+
+function transactionDone(transaction) {
+    return new Promise((resolve, reject) => {
+        transaction.oncomplete = () => resolve();
+        transaction.onerror = () => reject(transaction.error);
+        transaction.onabort = () => reject(transaction.error);
+    });
+}
+
+class ReferenceCache {
+    // fetchJson(endpoint) resolves to the parsed {data: ...} body of an /api request
+    constructor(fetchJson) {
+        this.fetchJson = fetchJson;
+        this.available = typeof indexedDB !== 'undefined' && typeof Worker !== 'undefined';
+        this.db = null;
+        this.worker = null;
+        this.pending = new Map();
+        this.nextRequest = 1;
+        this.synced = {}; // table -> promise of the session's sync
+    }
+
+    openDatabase() {
+        if (!this.db) {
+            const request = indexedDB.open(DB_NAME, DB_VERSION);
+            request.onupgradeneeded = () => {
+                const db = request.result;
+                TABLES.forEach(table => {
+                    if (!db.objectStoreNames.contains(table)) db.createObjectStore(table, { keyPath: 'id' });
+                });
+                if (!db.objectStoreNames.contains('meta')) db.createObjectStore('meta', { keyPath: 'table' });
+            };
+            this.db = promisify(request);
+        }
+        return this.db;
+    }
+
+    startWorker() {
+        if (!this.worker) {
+            this.worker = new Worker(new URL('./referenceWorker.js', import.meta.url));
+            this.worker.onmessage = (event) => {
+                const { id, result, error } = event.data;
+                const request = this.pending.get(id);
+                if (!request) return;
+                this.pending.delete(id);
+                if (error) request.reject(new Error(error));
+                else request.resolve(result);
+            };
+        }
+        return this.worker;
+    }
+
+    post(message) {
+        const worker = this.startWorker();
+        const id = this.nextRequest++;
+        return new Promise((resolve, reject) => {
+            this.pending.set(id, { resolve, reject });
+            worker.postMessage({ ...message, id });
+        });
+    }
+
+    // Once per session and table; resolves false when the cache cannot be used
+    ready(table) {
+        if (!this.available) return Promise.resolve(false);
+        if (!this.synced[table]) {
+            this.synced[table] = this.sync(table).then(() => true).catch(error => {
+                console.warn(`⚠️ Reference cache for ${table} unavailable: ${error.message}`);
+                delete this.synced[table];
+                return false;
+            });
+        }
+        return this.synced[table];
+    }
+
+    async sync(table) {
+        const db = await this.openDatabase();
+        const meta = await promisify(db.transaction('meta').objectStore('meta').get(table));
+
+        const changes = await this.fetchJson(`/${table}/changes?since=${meta ? meta.version : 0}`);
+        if (!changes || !changes.data) throw new Error('no change set');
+        const { version, reset, inserted, updated, deleted } = changes.data;
+
+        if (!meta || reset) {
+            console.log(`🔄 Reference cache: loading all ${table}`);
+            const response = await this.fetchJson(`/${table}?active_only=false`);
+            if (!response || !Array.isArray(response.data)) throw new Error(`no ${table} list`);
+            await this.write(db, table, response.data, null, version);
+        } else {
+            const ids = [...inserted, ...updated];
+            const rows = [];
+            for (let i = 0; i < ids.length; i += IDS_PER_REQUEST) {
+                const chunk = ids.slice(i, i + IDS_PER_REQUEST);
+                const response = await this.fetchJson(`/${table}?ids=${chunk.join(',')}`);
+                if (!response || !Array.isArray(response.data)) throw new Error(`no ${table} rows`);
+                rows.push(...response.data);
+            }
+            await this.write(db, table, rows, deleted, version);
+            console.log(`✅ Reference cache: ${table} +${rows.length} -${deleted.length} since ${meta.version}`);
+        }
+
+        const all = await promisify(db.transaction(table).objectStore(table).getAll());
+        await this.post({ type: 'load', table, rows: all });
+    }
+
+    // deleted === null replaces the whole table
+    async write(db, table, rows, deleted, version) {
+        const transaction = db.transaction([table, 'meta'], 'readwrite');
+        const store = transaction.objectStore(table);
+        if (deleted === null) store.clear();
+        else deleted.forEach(id => store.delete(id));
+        rows.forEach(row => store.put(row));
+        transaction.objectStore('meta').put({ table, version });
+        await transactionDone(transaction);
+    }
+
+    // Rows from the local copy, or null when the caller should ask the backend
+    async query(table, type, params = {}) {
+        if (!(await this.ready(table))) return null;
+        try {
+            return await this.post({ type, table, ...params });
+        } catch (error) {
+            console.warn(`⚠️ Reference cache query failed: ${error.message}`);
+            return null;
+        }
+    }
+
+    // Drops the local copy; the next query loads everything again
+    async clear() {
+        if (!this.available) return;
+        const db = await this.openDatabase();
+        const transaction = db.transaction([...TABLES, 'meta'], 'readwrite');
+        TABLES.forEach(table => transaction.objectStore(table).clear());
+        transaction.objectStore('meta').clear();
+        await transactionDone(transaction);
+        this.synced = {};
+    }
+}
+
+export default ReferenceCache;
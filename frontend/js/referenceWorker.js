@@ -0,0 +1,78 @@
+// Queries over the reference rows ReferenceCache loads, off the main thread.
+// Filters follow the backend: types compare case-insensitively, inactive
+// rows only show in lists asked for with active_only=false, and searches
+// cover active rows only.
+
+const tables = {
+    airports: { rows: [], codes: ['icao_code', 'iata_code'], text: ['name', 'municipality'], type: 'airport_type' },
+    waypoints: { rows: [], codes: ['waypoint_code'], text: ['name'], type: 'waypoint_type' }
+};
+
+const AIRPORT_TIERS = { large_airport: 0, medium_airport: 1, small_airport: 2 };
+
+function sameType(table, row, type) {
+    return !type || String(row[table.type] || '').toUpperCase() === type.toUpperCase();
+}
+
+function list(table, { filter_type, active_only = true }) {
+    return table.rows.filter(row => (!active_only || row.is_active) && sameType(table, row, filter_type));
+}
+
+function inBounds(table, { bounds, filter_type }) {
+    const { min_lat, max_lat, min_lng, max_lng } = bounds;
+    // A box across the antimeridian has min_lng > max_lng
+    const lngMatches = min_lng <= max_lng
+        ? lng => lng >= min_lng && lng <= max_lng
+        : lng => lng >= min_lng || lng <= max_lng;
+    return table.rows.filter(row => row.is_active && row.latitude >= min_lat && row.latitude <= max_lat &&
+        lngMatches(row.longitude) && sameType(table, row, filter_type));
+}
+
+// Exact code, code prefix, word prefix, then anywhere; larger airports first
+function rank(table, row, query) {
+    const codes = table.codes.map(field => String(row[field] || '').toUpperCase());
+    if (codes.includes(query)) return 0;
+    if (codes.some(code => code.startsWith(query))) return 1;
+    const text = table.text.map(field => String(row[field] || '').toUpperCase());
+    if (text.some(value => value.startsWith(query) || value.includes(' ' + query))) return 2;
+    if (text.some(value => value.includes(query))) return 3;
+    return -1;
+}
+
+function search(table, { query, limit = 20 }) {
+    const needle = String(query || '').trim().toUpperCase();
+    if (!needle) return [];
+    const tier = row => AIRPORT_TIERS[row.airport_type] ?? 3;
+    return table.rows
+        .filter(row => row.is_active)
+        .map(row => ({ row, score: rank(table, row, needle) }))
+        .filter(match => match.score >= 0)
+        .sort((a, b) => a.score - b.score || tier(a.row) - tier(b.row))
+        .slice(0, limit)
+        .map(match => match.row);
+}
+
+function byCode(table, { code }) {
+    const needle = String(code || '').toUpperCase();
+    return table.rows.find(row => String(row[table.codes[0]] || '').toUpperCase() === needle) || null;
+}
+
+const handlers = { list, bounds: inBounds, search, code: byCode };
+
+self.onmessage = (event) => {
+    const { id, type, table: name, ...params } = event.data;
+    try {
+        const table = tables[name];
+        if (!table) throw new Error(`Unknown table: ${name}`);
+        if (type === 'load') {
+            table.rows = params.rows;
+            self.postMessage({ id, result: table.rows.length });
+            return;
+        }
+        const handler = handlers[type];
+        if (!handler) throw new Error(`Unknown query: ${type}`);
+        self.postMessage({ id, result: handler(table, params) });
+    } catch (error) {
+        self.postMessage({ id, error: error.message });
+    }
+};
@@ -647,6 +647,9 @@ class UIManager {
                                 <label for="rotate-slider">Rotate (<span>0</span>&deg;)</label>
                                 <input type="range" id="rotate-slider" min="-180" max="180" value="0" class="slider">
                             </div>
+                            <div class="control-group">
+                                <label><input type="checkbox" id="downscale-toggle" checked> Downscale large scans (max 4096 px)</label>
+                            </div>
                             <h4>2. Select Area & Run OCR</h4>
                             <p class="instructions">Click and drag on the image to select a region for text recognition.</p>
                             <button id="run-ocr-btn" class="button primary full-width" disabled>Run OCR on Selection</button>
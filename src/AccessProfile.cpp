@@ -0,0 +1,251 @@
+#include "AccessProfile.h"
+#include "ReferenceDataStore.h"
+#include <spdlog/spdlog.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <optional>
+
+namespace aeronautical {
+
+namespace {
+
+constexpr std::array<AccessProfile::Kind, AccessProfile::kKinds> kAllKinds{
+    AccessProfile::Kind::Tile, AccessProfile::Kind::Airport, AccessProfile::Kind::Procedure};
+
+// How often the thread looks at the snapshot version between saves
+constexpr std::chrono::seconds kVersionCheck{10};
+
+uint64_t snapshotVersion() {
+    auto snapshot = ReferenceDataStore::getInstance().snapshot();
+    return snapshot ? snapshot->version : 0;
+}
+
+} // namespace
+
+const char* AccessProfile::name(Kind kind) {
+    switch (kind) {
+        case Kind::Tile: return "tile";
+        case Kind::Airport: return "airport";
+        case Kind::Procedure: return "procedure";
+    }
+    return "unknown";
+}
+
+AccessProfile& AccessProfile::getInstance() {
+    static AccessProfile instance;
+    return instance;
+}
+
+AccessProfile::~AccessProfile() {
+    stop();
+}
+
+void AccessProfile::setWarmer(Kind kind, Warmer warmer) {
+    warmers_[static_cast<size_t>(kind)] = std::move(warmer);
+}
+
+void AccessProfile::start(const AccessProfileSettings& settings) {
+    std::lock_guard<std::mutex> lock(thread_mutex_);
+    if (thread_.joinable()) {
+        return;
+    }
+    settings_ = settings;
+    stopping_ = false;
+    if (settings_.path.empty()) {
+        spdlog::info("Access profile off");
+        return;
+    }
+    load();
+    recording_.store(true, std::memory_order_relaxed);
+    thread_ = std::thread([this]() { loop(); });
+    spdlog::info("Access profile: {} entries of each kind prewarmed, saved to {} every {} s", settings_.top,
+                 settings_.path, settings_.interval.count());
+}
+
+void AccessProfile::stop() {
+    {
+        std::lock_guard<std::mutex> lock(thread_mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+        save();
+    }
+    recording_.store(false, std::memory_order_relaxed);
+}
+
+void AccessProfile::record(Kind kind, const std::string& key) {
+    if (!recording_.load(std::memory_order_relaxed)) {
+        return;
+    }
+    Counts& counts = counts_[static_cast<size_t>(kind)];
+    std::lock_guard<std::mutex> lock(counts.mutex);
+    auto [it, inserted] = counts.hits.try_emplace(key, 0);
+    it->second++;
+    if (!inserted || counts.hits.size() <= kMaxKeys) {
+        return;
+    }
+    // Halve every count; keys hit once since the last halving go
+    for (auto entry = counts.hits.begin(); entry != counts.hits.end();) {
+        entry->second /= 2;
+        entry = entry->second == 0 ? counts.hits.erase(entry) : std::next(entry);
+    }
+}
+
+std::vector<std::pair<std::string, uint64_t>> AccessProfile::top(Kind kind, size_t limit) const {
+    std::vector<std::pair<std::string, uint64_t>> entries;
+    {
+        const Counts& counts = counts_[static_cast<size_t>(kind)];
+        std::lock_guard<std::mutex> lock(counts.mutex);
+        entries.assign(counts.hits.begin(), counts.hits.end());
+    }
+    auto more_hits = [](const auto& a, const auto& b) {
+        return a.second != b.second ? a.second > b.second : a.first < b.first;
+    };
+    if (entries.size() > limit) {
+        std::partial_sort(entries.begin(), entries.begin() + static_cast<std::ptrdiff_t>(limit), entries.end(), more_hits);
+        entries.resize(limit);
+    } else {
+        std::sort(entries.begin(), entries.end(), more_hits);
+    }
+    return entries;
+}
+
+bool AccessProfile::save() const {
+    if (settings_.path.empty()) {
+        return false;
+    }
+    nlohmann::json document = nlohmann::json::object();
+    for (Kind kind : kAllKinds) {
+        nlohmann::json entries = nlohmann::json::array();
+        for (auto& [key, hits] : top(kind, settings_.top)) {
+            entries.push_back({key, hits});
+        }
+        document[name(kind)] = std::move(entries);
+    }
+
+    const std::string tmp_path = settings_.path + ".tmp";
+    {
+        std::ofstream out(tmp_path, std::ios::trunc);
+        out << document.dump();
+        if (!out) {
+            spdlog::error("Access profile: failed to write {}", tmp_path);
+            std::remove(tmp_path.c_str());
+            return false;
+        }
+    }
+    if (std::rename(tmp_path.c_str(), settings_.path.c_str()) != 0) {
+        spdlog::error("Access profile: failed to rename {} to {}", tmp_path, settings_.path);
+        std::remove(tmp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+void AccessProfile::load() {
+    std::ifstream in(settings_.path);
+    if (!in) {
+        return;
+    }
+    size_t loaded = 0;
+    try {
+        const auto document = nlohmann::json::parse(in);
+        for (Kind kind : kAllKinds) {
+            auto it = document.find(name(kind));
+            if (it == document.end()) continue;
+            Counts& counts = counts_[static_cast<size_t>(kind)];
+            std::lock_guard<std::mutex> lock(counts.mutex);
+            for (const auto& entry : *it) {
+                counts.hits[entry.at(0).get<std::string>()] += entry.at(1).get<uint64_t>();
+                loaded++;
+            }
+        }
+    } catch (const std::exception& e) {
+        spdlog::error("Access profile {} is unreadable: {}", settings_.path, e.what());
+        return;
+    }
+    spdlog::info("Access profile: {} entries loaded from {}", loaded, settings_.path);
+}
+
+void AccessProfile::loop() {
+    // Only this thread: the warmers' work yields to every request thread
+    if (setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 19) != 0) {
+        spdlog::debug("Access profile: could not lower the prewarm thread's priority");
+    }
+
+    std::optional<uint64_t> warmed_version;
+    auto last_save = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lock(thread_mutex_);
+    do {
+        lock.unlock();
+        // Tiles and bundles are cached under the snapshot version, so a new one starts cold
+        const uint64_t version = snapshotVersion();
+        if (warmed_version != version) {
+            warmed_version = version;
+            prewarm();
+        }
+        if (std::chrono::steady_clock::now() - last_save >= settings_.interval) {
+            save();
+            last_save = std::chrono::steady_clock::now();
+        }
+        lock.lock();
+    } while (!wake_.wait_for(lock, std::min<std::chrono::seconds>(settings_.interval, kVersionCheck),
+                             [this]() { return stopping_; }));
+}
+
+void AccessProfile::prewarm() {
+    const auto started = std::chrono::steady_clock::now();
+    std::array<size_t, kKinds> filled{};
+    for (Kind kind : kAllKinds) {
+        const Warmer& warmer = warmers_[static_cast<size_t>(kind)];
+        if (!warmer) continue;
+        for (const auto& [key, hits] : top(kind, settings_.top)) {
+            if (waitStopping(settings_.pause)) {
+                return;
+            }
+            try {
+                if (warmer(key)) {
+                    filled[static_cast<size_t>(kind)]++;
+                    warmed_[static_cast<size_t>(kind)].fetch_add(1, std::memory_order_relaxed);
+                }
+            } catch (const std::exception& e) {
+                warm_failures_.fetch_add(1, std::memory_order_relaxed);
+                spdlog::debug("Access profile: prewarming {} {} failed: {}", name(kind), key, e.what());
+            }
+        }
+    }
+    passes_.fetch_add(1, std::memory_order_relaxed);
+    spdlog::info("Access profile: prewarmed {} tiles, {} airport bundles and {} procedures in {} ms", filled[0],
+                 filled[1], filled[2],
+                 std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started).count());
+}
+
+bool AccessProfile::waitStopping(std::chrono::milliseconds delay) {
+    std::unique_lock<std::mutex> lock(thread_mutex_);
+    return wake_.wait_for(lock, delay, [this]() { return stopping_; });
+}
+
+nlohmann::json AccessProfile::stats() const {
+    nlohmann::json keys = nlohmann::json::object();
+    nlohmann::json warmed = nlohmann::json::object();
+    for (Kind kind : kAllKinds) {
+        const Counts& counts = counts_[static_cast<size_t>(kind)];
+        {
+            std::lock_guard<std::mutex> lock(counts.mutex);
+            keys[name(kind)] = counts.hits.size();
+        }
+        warmed[name(kind)] = this->warmed(kind);
+    }
+    return {{"enabled", recording_.load(std::memory_order_relaxed)},
+            {"keys", std::move(keys)},
+            {"passes", passes()},
+            {"warmed", std::move(warmed)},
+            {"failures", warm_failures_.load(std::memory_order_relaxed)}};
+}
+
+} // namespace aeronautical
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <json.hpp>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace aeronautical {
+
+struct AccessProfileSettings {
+    std::string path;                  // where the profile is kept; empty: off
+    std::chrono::seconds interval{300}; // how often it is saved and the snapshot version checked
+    size_t top = 500;                  // entries of each kind saved and prewarmed
+    std::chrono::milliseconds pause{5}; // between two prewarmed entries
+};
+
+// Which tiles, airport bundles and procedures the clients ask for, counted
+// per key and saved every interval as the `top` most hit of each kind, so
+// the next start knows what its first users will want. After loading the
+// saved profile, and again whenever the reference snapshot version moves
+// (every cached tile and bundle is keyed by it), a background thread at
+// the lowest CPU priority replays the top entries through the warmers main
+// registers, which fill the same caches a request would. Serving does not
+// wait for it. Counts are kept in a bounded map per kind; when one fills,
+// every count is halved and the keys left at zero dropped, so the profile
+// follows what is being viewed now.
+class AccessProfile {
+public:
+    enum class Kind { Tile, Airport, Procedure };
+    static constexpr size_t kKinds = 3;
+    static const char* name(Kind kind);
+
+    // Fills the cache entry a key stands for; returns false when there was nothing to fill
+    using Warmer = std::function<bool(const std::string& key)>;
+
+    static AccessProfile& getInstance();
+
+    AccessProfile(const AccessProfile&) = delete;
+    AccessProfile& operator=(const AccessProfile&) = delete;
+
+    // Set before start()
+    void setWarmer(Kind kind, Warmer warmer);
+
+    // Loads the saved profile and starts the thread that prewarms and saves
+    void start(const AccessProfileSettings& settings);
+    // Saves the profile and stops the thread, ending a prewarm pass early
+    void stop();
+
+    // Counts one hit; does nothing unless started
+    void record(Kind kind, const std::string& key);
+
+    // The most hit keys of a kind with their counts, most hit first
+    std::vector<std::pair<std::string, uint64_t>> top(Kind kind, size_t limit) const;
+    bool save() const;
+
+    // {"enabled", "keys": {kind: n}, "passes", "warmed": {kind: n}, ...} for /health
+    nlohmann::json stats() const;
+    uint64_t warmed(Kind kind) const { return warmed_[static_cast<size_t>(kind)].load(std::memory_order_relaxed); }
+    uint64_t passes() const { return passes_.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr size_t kMaxKeys = 50000; // per kind, before counts are halved
+
+    AccessProfile() = default;
+    ~AccessProfile();
+
+    struct Counts {
+        mutable std::mutex mutex;
+        std::unordered_map<std::string, uint64_t> hits;
+    };
+
+    void load();
+    void loop();
+    // Replays the top entries of each kind, stopping early on stop()
+    void prewarm();
+    // Whether stop() was called; waits out the pause between entries
+    bool waitStopping(std::chrono::milliseconds delay);
+
+    AccessProfileSettings settings_;
+    std::atomic<bool> recording_{false};
+    std::array<Counts, kKinds> counts_;
+    std::array<Warmer, kKinds> warmers_;
+
+    std::array<std::atomic<uint64_t>, kKinds> warmed_{};
+    std::atomic<uint64_t> passes_{0};
+    std::atomic<uint64_t> warm_failures_{0};
+
+    std::mutex thread_mutex_;
+    std::condition_variable wake_;
+    bool stopping_ = false;
+    std::thread thread_;
+};
+
+} // namespace aeronautical
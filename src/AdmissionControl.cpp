@@ -0,0 +1,177 @@
+#include "AdmissionControl.h"
+#include "Lifecycle.h"
+#include "ReadRouting.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+namespace aeronautical {
+
+namespace {
+
+bool startsWith(const std::string& text, const char* prefix) {
+    return text.rfind(prefix, 0) == 0;
+}
+
+bool endsWith(const std::string& text, const char* suffix) {
+    const size_t length = std::char_traits<char>::length(suffix);
+    return text.size() >= length && text.compare(text.size() - length, length, suffix) == 0;
+}
+
+} // namespace
+
+AdmissionControl::AdmissionControl() {
+    settings_.publish(std::make_shared<const AdmissionSettings>());
+}
+
+void AdmissionControl::configure(const AdmissionSettings& settings) {
+    settings_.publish(std::make_shared<const AdmissionSettings>(settings));
+}
+
+AdmissionControl::RouteClass AdmissionControl::classify(const crow::request& req) {
+    if (req.method == crow::HTTPMethod::OPTIONS) return RouteClass::Exempt;
+    const std::string path = req.url.substr(0, req.url.find('?'));
+    // Profiles are wanted most when the server is overloaded
+    if (path == "/api/health" || startsWith(path, "/api/health/") || path == "/metrics" ||
+        startsWith(path, "/api/metrics/") || startsWith(path, "/api/admin/profile")) {
+        return RouteClass::Exempt;
+    }
+
+    // A batch only carries GET sub-requests, each admitted on its own by BatchController
+    const bool read = req.method == crow::HTTPMethod::GET || req.method == crow::HTTPMethod::HEAD ||
+                      (req.method == crow::HTTPMethod::POST && path == "/api/batch");
+    // Routes that run the conflict engine or build obstacle surfaces
+    if (startsWith(path, "/api/analysis/preview") || endsWith(path, "/submit") ||
+        (read && startsWith(path, "/api/projects/") && endsWith(path, "/surfaces"))) {
+        return RouteClass::Analysis;
+    }
+    if (!read) return RouteClass::Write;
+    if (startsWith(path, "/api/airports") || startsWith(path, "/api/waypoints") ||
+        startsWith(path, "/api/procedures") || startsWith(path, "/tiles/")) {
+        return RouteClass::Reference;
+    }
+    return RouteClass::Read;
+}
+
+const char* AdmissionControl::name(RouteClass route_class) {
+    switch (route_class) {
+        case RouteClass::Reference: return "reference";
+        case RouteClass::Read: return "read";
+        case RouteClass::Write: return "write";
+        case RouteClass::Analysis: return "analysis";
+        default: return "exempt";
+    }
+}
+
+std::string AdmissionControl::clientKey(const crow::request& req, const AdmissionSettings& settings) {
+    // An unknown key would buy a fresh bucket per request
+    const std::string& api_key = req.get_header_value("X-API-Key");
+    if (!api_key.empty() && settings.api_keys.count(api_key)) return "k:" + api_key;
+    return ReadRouting::clientKey(req);
+}
+
+int AdmissionControl::takeToken(const std::string& client, const AdmissionSettings& settings) {
+    const auto now = std::chrono::steady_clock::now();
+    Shard& shard = shards_[std::hash<std::string>{}(client) % kShards];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto it = shard.buckets.find(client);
+    if (it == shard.buckets.end()) {
+        const size_t per_shard = std::max<size_t>(1, settings.max_clients / kShards);
+        if (shard.buckets.size() >= per_shard) {
+            // Buckets that have refilled completely carry no state worth keeping
+            const auto idle = std::chrono::duration<double>(settings.client_burst / settings.client_rate);
+            std::erase_if(shard.buckets, [&](const auto& entry) { return now - entry.second.updated >= idle; });
+        }
+        if (shard.buckets.size() >= per_shard) return 0; // untracked clients are let through
+        it = shard.buckets.emplace(client, Bucket{settings.client_burst, now}).first;
+    }
+
+    Bucket& bucket = it->second;
+    const double elapsed = std::chrono::duration<double>(now - bucket.updated).count();
+    bucket.tokens = std::min(settings.client_burst, bucket.tokens + elapsed * settings.client_rate);
+    bucket.updated = now;
+    if (bucket.tokens >= 1) {
+        bucket.tokens -= 1;
+        return 0;
+    }
+    return std::max(1, static_cast<int>(std::ceil((1 - bucket.tokens) / settings.client_rate)));
+}
+
+size_t AdmissionControl::limit(RouteClass route_class, const AdmissionSettings& settings) {
+    switch (route_class) {
+        case RouteClass::Reference: return settings.max_reference;
+        case RouteClass::Read: return settings.max_read;
+        case RouteClass::Write: return settings.max_write;
+        case RouteClass::Analysis: return settings.max_analysis;
+        default: return 0;
+    }
+}
+
+void AdmissionControl::reject(crow::response& res, int code, int retry_after, const char* message) {
+    nlohmann::json body;
+    body["error"] = true;
+    body["message"] = message;
+    res = crow::response(code, body.dump());
+    res.add_header("Content-Type", "application/json");
+    res.add_header("Retry-After", std::to_string(retry_after));
+    res.end();
+}
+
+void AdmissionControl::before_handle(crow::request& req, crow::response& res, context& ctx) {
+    const RouteClass route_class = classify(req);
+    if (route_class == RouteClass::Exempt) return;
+    if (!Lifecycle::getInstance().accepting()) {
+        reject(res, 503, 5, "Server is shutting down, please retry");
+        return;
+    }
+    const auto settings = settings_.load();
+    if (!settings->enabled) return;
+
+    if (settings->client_rate > 0) {
+        if (const int retry_after = takeToken(clientKey(req, *settings), *settings)) {
+            rate_limited_.fetch_add(1, std::memory_order_relaxed);
+            reject(res, 429, retry_after, "Too many requests, please slow down");
+            return;
+        }
+    }
+
+    const size_t cap = limit(route_class, *settings);
+    auto& in_flight = in_flight_[index(route_class)];
+    if (in_flight.fetch_add(1, std::memory_order_relaxed) >= cap && cap > 0) {
+        in_flight.fetch_sub(1, std::memory_order_relaxed);
+        overloaded_[index(route_class)].fetch_add(1, std::memory_order_relaxed);
+        reject(res, 503, 1, "Server busy, please retry later");
+        return;
+    }
+    ctx.admitted = route_class;
+}
+
+void AdmissionControl::after_handle(crow::request&, crow::response&, context& ctx) {
+    if (ctx.admitted == RouteClass::Exempt) return;
+    in_flight_[index(ctx.admitted)].fetch_sub(1, std::memory_order_relaxed);
+    ctx.admitted = RouteClass::Exempt;
+}
+
+nlohmann::json AdmissionControl::stats() const {
+    const auto settings = settings_.load();
+    nlohmann::json j;
+    j["enabled"] = settings->enabled;
+    j["client_rate"] = settings->client_rate;
+    j["client_burst"] = settings->client_burst;
+    j["rate_limited"] = rateLimited();
+    size_t clients = 0;
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        clients += shard.buckets.size();
+    }
+    j["tracked_clients"] = clients;
+    for (RouteClass route_class : {RouteClass::Reference, RouteClass::Read, RouteClass::Write, RouteClass::Analysis}) {
+        j["classes"][name(route_class)] = {{"in_flight", inFlight(route_class)},
+                                           {"limit", limit(route_class, *settings)},
+                                           {"rejected", overloaded(route_class)}};
+    }
+    return j;
+}
+
+} // namespace aeronautical
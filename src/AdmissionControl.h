@@ -0,0 +1,93 @@
+#pragma once
+
+#include <crow.h>
+#include "SnapshotPublisher.h"
+#include <json.hpp>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace aeronautical {
+
+struct AdmissionSettings {
+    bool enabled = true;
+    double client_rate = 50;     // requests per second refilled per client; 0 disables rate limiting
+    double client_burst = 100;   // bucket size
+    size_t max_clients = 50000;  // buckets kept; idle ones are dropped first
+    std::unordered_set<std::string> api_keys; // X-API-Key values that name a client; others are ignored
+    // Requests in progress per route class at once; 0 leaves a class uncapped
+    size_t max_reference = 512;
+    size_t max_read = 256;
+    size_t max_write = 64;
+    size_t max_analysis = 8;
+};
+
+// Crow middleware turning requests away before a handler runs, so an
+// overloaded server spends no DB or GEOS time on them. Each client (its
+// X-API-Key when listed in api_keys, else as ReadRouting tells clients
+// apart) has a token bucket; an empty bucket answers 429. Each route class
+// has a cap on requests in progress, held until the response ends (also
+// for DbExecutor handlers); a full class answers 503. Both carry Retry-After. Once a drain stops
+// accepting (see Lifecycle) every request answers 503. Health, metrics
+// and CORS preflight requests are never limited.
+class AdmissionControl {
+public:
+    enum class RouteClass { Exempt, Reference, Read, Write, Analysis };
+
+    struct context {
+        RouteClass admitted = RouteClass::Exempt;
+    };
+
+    AdmissionControl();
+
+    // Takes effect with the next request, also while serving
+    void configure(const AdmissionSettings& settings);
+
+    void before_handle(crow::request& req, crow::response& res, context& ctx);
+    void after_handle(crow::request& req, crow::response& res, context& ctx);
+
+    static RouteClass classify(const crow::request& req);
+    static const char* name(RouteClass route_class);
+
+    uint64_t rateLimited() const { return rate_limited_.load(std::memory_order_relaxed); }
+    uint64_t overloaded(RouteClass route_class) const {
+        return overloaded_[index(route_class)].load(std::memory_order_relaxed);
+    }
+    size_t inFlight(RouteClass route_class) const {
+        return in_flight_[index(route_class)].load(std::memory_order_relaxed);
+    }
+    nlohmann::json stats() const;
+
+private:
+    static constexpr size_t kClasses = 5;
+    static constexpr size_t kShards = 16;
+
+    struct Bucket {
+        double tokens = 0;
+        std::chrono::steady_clock::time_point updated;
+    };
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<std::string, Bucket> buckets;
+    };
+
+    static size_t index(RouteClass route_class) { return static_cast<size_t>(route_class); }
+    static std::string clientKey(const crow::request& req, const AdmissionSettings& settings);
+    // 0 when a token was taken, else seconds until one is available
+    int takeToken(const std::string& client, const AdmissionSettings& settings);
+    static size_t limit(RouteClass route_class, const AdmissionSettings& settings);
+    static void reject(crow::response& res, int code, int retry_after, const char* message);
+
+    SnapshotPublisher<AdmissionSettings> settings_;
+    mutable std::array<Shard, kShards> shards_;
+    std::array<std::atomic<size_t>, kClasses> in_flight_{};
+    std::array<std::atomic<uint64_t>, kClasses> overloaded_{};
+    std::atomic<uint64_t> rate_limited_{0};
+};
+
+} // namespace aeronautical
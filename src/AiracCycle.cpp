@@ -0,0 +1,67 @@
+#include "AiracCycle.h"
+#include <cctype>
+#include <cstdio>
+
+namespace aeronautical {
+
+namespace {
+
+using Days = std::chrono::sys_days;
+
+// Effective date of cycle 2001
+constexpr Days kEpoch{std::chrono::year{2020} / std::chrono::January / 2};
+
+int64_t floorDiv(int64_t a, int64_t b) {
+    return a / b - ((a % b != 0) && ((a < 0) != (b < 0)) ? 1 : 0);
+}
+
+// First cycle effective in year
+Days firstOfYear(int year) {
+    const Days january_first{std::chrono::year{year} / std::chrono::January / 1};
+    const int64_t offset = (january_first - kEpoch).count();
+    const int64_t cycles = floorDiv(offset + AiracCycle::kDays - 1, AiracCycle::kDays);
+    return kEpoch + std::chrono::days(cycles * AiracCycle::kDays);
+}
+
+} // namespace
+
+AiracCycle AiracCycle::at(std::chrono::system_clock::time_point t) {
+    const auto day = std::chrono::floor<std::chrono::days>(t);
+    const int64_t cycles = floorDiv((Days(day) - kEpoch).count(), kDays);
+    const Days effective = kEpoch + std::chrono::days(cycles * kDays);
+    const int year = static_cast<int>(std::chrono::year_month_day(effective).year());
+
+    AiracCycle cycle;
+    cycle.year = year;
+    cycle.number = static_cast<int>((effective - firstOfYear(year)).count() / kDays) + 1;
+    cycle.effective = effective;
+    return cycle;
+}
+
+std::optional<AiracCycle> AiracCycle::parse(std::string_view ident) {
+    if (ident.size() != 4 && ident.size() != 6) {
+        return std::nullopt;
+    }
+    for (char c : ident) {
+        if (!std::isdigit(static_cast<unsigned char>(c))) return std::nullopt;
+    }
+    int year = std::stoi(std::string(ident.substr(0, ident.size() - 2)));
+    if (ident.size() == 4) year += 2000;
+    const int number = std::stoi(std::string(ident.substr(ident.size() - 2)));
+    if (number < 1) {
+        return std::nullopt;
+    }
+    const Days effective = firstOfYear(year) + std::chrono::days((number - 1) * kDays);
+    if (static_cast<int>(std::chrono::year_month_day(effective).year()) != year) {
+        return std::nullopt; // past the last cycle of the year
+    }
+    return AiracCycle{year, number, effective};
+}
+
+std::string AiracCycle::ident() const {
+    char text[8];
+    std::snprintf(text, sizeof(text), "%02d%02d", year % 100, number);
+    return text;
+}
+
+} // namespace aeronautical
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <chrono>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace aeronautical {
+
+// One AIRAC cycle: aeronautical data changes on a fixed 28-day schedule,
+// cycle 2001 taking effect on 2020-01-02 00:00 UTC. Cycles are named YYNN,
+// the year of their effective date and their number within that year.
+struct AiracCycle {
+    int year = 0;
+    int number = 0;
+    std::chrono::system_clock::time_point effective; // 00:00 UTC
+
+    static constexpr int kDays = 28;
+
+    // Cycle in force at t
+    static AiracCycle at(std::chrono::system_clock::time_point t);
+    // From "YYNN" (or "YYYYNN"); nullopt for a malformed or nonexistent cycle
+    static std::optional<AiracCycle> parse(std::string_view ident);
+
+    std::string ident() const;
+    AiracCycle next() const { return at(end()); }
+    std::chrono::system_clock::time_point end() const { return effective + std::chrono::hours(24 * kDays); }
+};
+
+} // namespace aeronautical
@@ -1,4 +1,5 @@
 #include "Airport.h"
+#include "JsonWriter.h"
 #include <json.hpp>
 
 namespace aeronautical {
@@ -20,11 +21,11 @@ nlohmann::json Airport::toJson() const {
         json_obj["elevation_ft"] = elevation_ft;
         
         // String fields
-        json_obj["airport_type"] = airport_type.empty() ? "" : airport_type;
+        json_obj["airport_type"] = airport_type.str();
         json_obj["municipality"] = municipality.empty() ? "" : municipality;
-        json_obj["region"] = region.empty() ? "" : region;
-        json_obj["country_code"] = country_code.empty() ? "" : country_code;
-        json_obj["country_name"] = country_name.empty() ? "" : country_name;
+        json_obj["region"] = region.str();
+        json_obj["country_code"] = country_code.str();
+        json_obj["country_name"] = country_name.str();
         
         // Boolean fields
         json_obj["is_active"] = is_active;
@@ -48,6 +49,51 @@ nlohmann::json Airport::toJson() const {
     }
 }
 
+// Keys in sorted order, as nlohmann's object dumps them
+void Airport::writeJson(JsonWriter& writer) const {
+    writer.beginObject()
+          .rawField("airport_type", airport_type)
+          .rawField("country_code", country_code)
+          .rawField("country_name", country_name)
+          .rawField("elevation_ft", elevation_ft)
+          .rawField("full_name", full_name)
+          .rawField("has_ils", has_ils)
+          .rawField("has_tower", has_tower)
+          .rawField("iata_code", iata_code)
+          .rawField("icao_code", icao_code)
+          .rawField("id", id)
+          .rawField("is_active", is_active)
+          .rawField("latitude", std::isfinite(latitude) ? latitude : 0.0)
+          .rawField("longest_runway_ft", longest_runway_ft)
+          .rawField("longitude", std::isfinite(longitude) ? longitude : 0.0)
+          .rawField("municipality", municipality)
+          .rawField("name", name)
+          .rawField("region", region)
+          .rawField("runway_count", runway_count)
+          .endObject();
+}
+
+void AirportRunway::writeJson(JsonWriter& writer) const {
+    auto finite = [](double v) { return std::isfinite(v) ? v : 0.0; };
+    writer.beginObject()
+          .rawField("airport_id", airport_id)
+          .rawField("he_heading_deg", finite(he_heading_deg))
+          .rawField("he_ident", he_ident)
+          .rawField("he_latitude", finite(he_latitude))
+          .rawField("he_longitude", finite(he_longitude))
+          .rawField("id", id)
+          .rawField("is_active", is_active)
+          .rawField("le_heading_deg", finite(le_heading_deg))
+          .rawField("le_ident", le_ident)
+          .rawField("le_latitude", finite(le_latitude))
+          .rawField("le_longitude", finite(le_longitude))
+          .rawField("length_ft", length_ft)
+          .rawField("runway_identifier", runway_identifier)
+          .rawField("surface_type", surface_type)
+          .rawField("width_ft", width_ft)
+          .endObject();
+}
+
 nlohmann::json AirportRunway::toJson() const {
     try {
         nlohmann::json json_obj = nlohmann::json::object();
@@ -57,7 +103,7 @@ nlohmann::json AirportRunway::toJson() const {
         json_obj["runway_identifier"] = runway_identifier.empty() ? "" : runway_identifier;
         json_obj["length_ft"] = length_ft;
         json_obj["width_ft"] = width_ft;
-        json_obj["surface_type"] = surface_type.empty() ? "" : surface_type;
+        json_obj["surface_type"] = surface_type.str();
         
         // Low end
         json_obj["le_ident"] = le_ident.empty() ? "" : le_ident;
@@ -1,10 +1,13 @@
 #pragma once
 
 #include <string>
+#include "InternedString.h"
 #include <json.hpp>
 
 namespace aeronautical {
 
+class JsonWriter;
+
 struct Airport {
     int id;
     std::string icao_code;
@@ -14,11 +17,11 @@ struct Airport {
     double latitude;
     double longitude;
     int elevation_ft;
-    std::string airport_type;
+    InternedString airport_type;
     std::string municipality;
-    std::string region;
-    std::string country_code;
-    std::string country_name;
+    InternedString region;
+    InternedString country_code;
+    InternedString country_name;
     bool is_active;
     bool has_tower;
     bool has_ils;
@@ -26,6 +29,8 @@ struct Airport {
     int longest_runway_ft;
     
     nlohmann::json toJson() const;
+    // Same output as toJson().dump(), written straight into the writer
+    void writeJson(JsonWriter& writer) const;
 };
 
 struct AirportRunway {
@@ -34,7 +39,7 @@ struct AirportRunway {
     std::string runway_identifier;
     int length_ft;
     int width_ft;
-    std::string surface_type;
+    InternedString surface_type;
     std::string le_ident;
     double le_heading_deg;
     double le_latitude;
@@ -46,6 +51,8 @@ struct AirportRunway {
     bool is_active;
     
     nlohmann::json toJson() const;
+    // Same output as toJson().dump(), written straight into the writer
+    void writeJson(JsonWriter& writer) const;
 };
 
 } // namespace aeronautical
\ No newline at end of file
@@ -1,61 +1,138 @@
 #include "AirportController.h"
+#include "AccessProfile.h"
+#include "JsonWriter.h"
+#include "ReferenceDataStore.h"
+#include "ChangeLog.h"
+#include "ConditionalGet.h"
+#include "ResultCache.h"
+#include "SimplifiedGeometryCache.h"
+#include "TileCover.h"
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <functional>
 #include <string>
 #include <spdlog/sinks/stdout_color_sinks.h>
 
 namespace aeronautical {
 
-AirportController::AirportController() {
+namespace {
+
+// Simplification level of a bundle without ?zoom= or ?simplify= (zoom 10,
+// an aerodrome on screen)
+constexpr size_t kBundleLevel = 3;
+constexpr int kBundleMaxProcedures = 2000;
+// Radio navaids (those with a frequency) within this distance of the
+// reference point, nearest first
+constexpr double kBundleNavaidRadiusKm = 120.0;
+constexpr size_t kBundleMaxNavaids = 40;
+constexpr size_t kBundleNavaidCandidates = 400;
+
+std::string levelName(std::optional<size_t> level) {
+    return level ? std::to_string(*level) : "full";
+}
+
+} // namespace
+
+// One airport's bundle body as served, with the validator built from it
+struct AirportBundle {
+    std::string body;
+    CacheValidator validator;
+};
+
+AirportController::AirportController()
+    : procedureRepository_(std::make_unique<FlightProcedureRepository>()) {
     logger_ = spdlog::stdout_color_mt("AirportController");
     logger_->set_level(spdlog::level::debug);
 }
 
-void AirportController::registerRoutes(crow::SimpleApp& app) {
+void AirportController::registerRoutes(HttpApp& app) {
+    // Reference reads answer 304 while the snapshot version is unchanged
     CROW_ROUTE(app, "/api/airports")([this](const crow::request& req) { 
-        return getAllAirports(req); 
+        return ConditionalGet::serve(req, ConditionalGet::forReferenceData(), [&] { return getAllAirports(req); }); 
     });
     
-    CROW_ROUTE(app, "/api/airports/icao/<string>")([this](const std::string& icao) { 
-        return getAirportByIcao(icao); 
+    CROW_ROUTE(app, "/api/airports/icao/<string>")([this](const crow::request& req, const std::string& icao) { 
+        return ConditionalGet::serve(req, ConditionalGet::forReferenceData(), [&] { return getAirportByIcao(icao); }); 
     });
     
-    CROW_ROUTE(app, "/api/airports/country/<string>")([this](const std::string& country) { 
-        return getAirportsByCountry(country); 
+    CROW_ROUTE(app, "/api/airports/country/<string>")([this](const crow::request& req, const std::string& country) { 
+        return ConditionalGet::serve(req, ConditionalGet::forReferenceData(), [&] { return getAirportsByCountry(country); }); 
     });
     
+    // GET /api/airports/bounds?min_lat=&max_lat=&min_lng=&max_lng=[&type=&zoom=&snap=tiles|none]
     CROW_ROUTE(app, "/api/airports/bounds")([this](const crow::request& req) { 
-        return getAirportsInBounds(req); 
+        return ConditionalGet::serve(req, ConditionalGet::forReferenceData(), [&] { return getAirportsInBounds(req); }); 
     });
     
     CROW_ROUTE(app, "/api/airports/search")([this](const crow::request& req) { 
-        return searchAirports(req); 
+        return ConditionalGet::serve(req, ConditionalGet::forReferenceData(), [&] { return searchAirports(req); }); 
     });
     
-    CROW_ROUTE(app, "/api/airports/runways/<string>")([this](const std::string& icao) { 
-        return getAirportRunways(icao); 
+    CROW_ROUTE(app, "/api/airports/runways/<string>")([this](const crow::request& req, const std::string& icao) { 
+        return ConditionalGet::serve(req, ConditionalGet::forReferenceData(), [&] { return getAirportRunways(icao); }); 
+    });
+    
+    // GET /api/airports/changes?since=<version>
+    CROW_ROUTE(app, "/api/airports/changes")([this](const crow::request& req) {
+        return getAirportChanges(req);
+    });
+
+    // GET /api/airports/<icao>/bundle?zoom=|simplify= - airport, runways,
+    // procedures and nearby navaids in one payload
+    CROW_ROUTE(app, "/api/airports/<string>/bundle")([this](const crow::request& req, const std::string& icao) {
+        return getAirportBundle(req, icao);
     });
 }
 
 crow::response AirportController::getAllAirports(const crow::request& req) {
     try {
-        logger_->debug("Getting all airports");
+        SPDLOG_LOGGER_DEBUG(logger_, "Getting all airports");
         
         std::string filter_type = req.url_params.get("type") ? req.url_params.get("type") : "";
         bool active_only = !req.url_params.get("active_only") || std::string(req.url_params.get("active_only")) != "false";
         
-        auto airports = airportRepository_.fetchAllAirports(filter_type, active_only);
-        nlohmann::json json_airports = nlohmann::json::array();
+        // ?ids= fetches the rows a delta sync (/changes) named, whatever their state
+        if (const char* ids_param = req.url_params.get("ids")) {
+            auto ids = ChangeLog::parseIds(ids_param);
+            if (!ids) {
+                return crow::response(400, createErrorResponse("Invalid parameter: ids (at most " +
+                                                               std::to_string(ChangeLog::kMaxIds) + " comma-separated ids)").dump());
+            }
+            // Without the store /changes always resets, so there is no delta to fetch
+            auto snapshot = ReferenceDataStore::getInstance().snapshot();
+            if (!snapshot) {
+                return crow::response(503, createErrorResponse("Reference data store not loaded", 503).dump());
+            }
+            return listResponse(snapshot->airportsByIds(*ids));
+        }
+
+        if (auto snapshot = ReferenceDataStore::getInstance().snapshot()) {
+            return listResponse(snapshot->allAirports(filter_type, active_only));
+        }
         
-        for (const auto& airport : airports) {
+        // Serialize rows straight into the body as they stream from MySQL;
+        // same layout as createSuccessResponse(...).dump()
+        std::string body;
+        JsonWriter writer(body);
+        writer.beginObject().key("data").beginArray();
+        size_t count = 0;
+        bool ok = airportRepository_.streamAllAirports(filter_type, active_only, [&](const Airport& airport) {
             try {
-                json_airports.push_back(airport.toJson());
+                airport.writeJson(writer);
+                count++;
             } catch (const std::exception& e) {
                 logger_->warn("Error serializing airport {}: {}", airport.icao_code, e.what());
-                continue; // Skip this airport and continue with others
             }
+        });
+        
+        if (!ok) {
+            return crow::response(500, createErrorResponse("Internal server error", 500).dump());
         }
+        writer.endArray().field("status", "success").endObject();
         
-        logger_->debug("Successfully serialized {} airports", json_airports.size());
-        return crow::response(200, createSuccessResponse(json_airports).dump());
+        SPDLOG_LOGGER_DEBUG(logger_, "Successfully serialized {} airports", count);
+        return crow::response(200, body);
         
     } catch (const std::exception& e) {
         logger_->error("Error in getAllAirports: {}", e.what());
@@ -65,7 +142,15 @@ crow::response AirportController::getAllAirports(const crow::request& req) {
 
 crow::response AirportController::getAirportByIcao(const std::string& icao_code) {
     try {
-        logger_->debug("Getting airport by ICAO: {}", icao_code);
+        SPDLOG_LOGGER_DEBUG(logger_, "Getting airport by ICAO: {}", icao_code);
+        
+        if (auto snapshot = ReferenceDataStore::getInstance().snapshot()) {
+            const Airport* airport = snapshot->airportByIcao(icao_code);
+            if (!airport) {
+                return crow::response(404, createErrorResponse("Airport not found").dump());
+            }
+            return crow::response(200, createSuccessResponse(airport->toJson()).dump());
+        }
         
         auto airport = airportRepository_.fetchAirportByIcao(icao_code);
         return crow::response(200, createSuccessResponse(airport.toJson()).dump());
@@ -81,7 +166,11 @@ crow::response AirportController::getAirportByIcao(const std::string& icao_code)
 
 crow::response AirportController::getAirportsByCountry(const std::string& country_code) {
     try {
-        logger_->debug("Getting airports by country: {}", country_code);
+        SPDLOG_LOGGER_DEBUG(logger_, "Getting airports by country: {}", country_code);
+        
+        if (auto snapshot = ReferenceDataStore::getInstance().snapshot()) {
+            return listResponse(snapshot->airportsByCountry(country_code, true));
+        }
         
         auto airports = airportRepository_.fetchAirportsByCountry(country_code, true);
         nlohmann::json json_airports = nlohmann::json::array();
@@ -95,7 +184,7 @@ crow::response AirportController::getAirportsByCountry(const std::string& countr
             }
         }
         
-        logger_->debug("Successfully found {} airports for country {}", json_airports.size(), country_code);
+        SPDLOG_LOGGER_DEBUG(logger_, "Successfully found {} airports for country {}", json_airports.size(), country_code);
         return crow::response(200, createSuccessResponse(json_airports).dump());
         
     } catch (const std::exception& e) {
@@ -106,7 +195,7 @@ crow::response AirportController::getAirportsByCountry(const std::string& countr
 
 crow::response AirportController::getAirportsInBounds(const crow::request& req) {
     try {
-        logger_->debug("Getting airports in bounds with params: {}", req.url);
+        SPDLOG_LOGGER_DEBUG(logger_, "Getting airports in bounds with params: {}", req.url);
         
         // Validate required parameters exist
         const char* min_lat_param = req.url_params.get("min_lat");
@@ -134,16 +223,44 @@ crow::response AirportController::getAirportsInBounds(const crow::request& req)
             return crow::response(400, createErrorResponse("Boundary parameter out of range").dump());
         }
         
-        // Validate bounds
-        if (!validateBounds(min_lat, max_lat, min_lng, max_lng)) {
+        // Validate bounds; boxes across the antimeridian come back split in two
+        auto bounds = normalizeBounds(min_lat, max_lat, min_lng, max_lng);
+        if (!bounds) {
             logger_->warn("Invalid boundary values: lat({}, {}), lng({}, {})", min_lat, max_lat, min_lng, max_lng);
             return crow::response(400, createErrorResponse("Invalid boundary values").dump());
         }
         
-        logger_->debug("Validated bounds: lat({}, {}), lng({}, {})", min_lat, max_lat, min_lng, max_lng);
+        SPDLOG_LOGGER_DEBUG(logger_, "Validated bounds: lat({}, {}), lng({}, {})", min_lat, max_lat, min_lng, max_lng);
         
         std::string filter_type = req.url_params.get("type") ? req.url_params.get("type") : "";
-        auto airports = airportRepository_.fetchAirportsInBounds(min_lat, max_lat, min_lng, max_lng, filter_type);
+        if (auto snapshot = ReferenceDataStore::getInstance().snapshot()) {
+            // ?zoom=N at or below ClusterIndex::kMaxZoom returns clusters instead of every row
+            const char* zoom_param = req.url_params.get("zoom");
+            if (zoom_param) {
+                int zoom = 0;
+                auto res = std::from_chars(zoom_param, zoom_param + std::strlen(zoom_param), zoom);
+                if (res.ec != std::errc() || zoom < 0) {
+                    return crow::response(400, createErrorResponse("Invalid zoom").dump());
+                }
+                if (zoom <= ClusterIndex::kMaxZoom) {
+                    return clusterResponse(*snapshot, snapshot->airportClusters(*bounds, zoom, filter_type));
+                }
+            }
+            // ?snap=tiles answers with the rows of the tiles covering the box, each cached on its own
+            if (TileCover::snaps(req.url_params.get("snap"))) {
+                const std::string prefix = "airports.tile:" + std::to_string(snapshot->version) + ":" + filter_type + ":";
+                return crow::response(200, TileCover::of(*bounds).body(prefix, [&](int zoom, TileCover::Tile tile) {
+                    return TileCover::rowsIn(zoom, tile,
+                                             snapshot->airportsInBounds(TileCover::tileBounds(zoom, tile), filter_type));
+                }));
+            }
+            return listResponse(snapshot->airportsInBounds(*bounds, filter_type));
+        }
+        std::vector<Airport> airports;
+        for (const auto& range : bounds->lng_ranges) {
+            auto part = airportRepository_.fetchAirportsInBounds(bounds->min_lat, bounds->max_lat, range.min, range.max, filter_type);
+            airports.insert(airports.end(), part.begin(), part.end());
+        }
 
         nlohmann::json json_airports = nlohmann::json::array();
         for (const auto& airport : airports) {
@@ -155,7 +272,7 @@ crow::response AirportController::getAirportsInBounds(const crow::request& req)
             }
         }
         
-        logger_->debug("Successfully found {} airports in bounds", json_airports.size());
+        SPDLOG_LOGGER_DEBUG(logger_, "Successfully found {} airports in bounds", json_airports.size());
         return crow::response(200, createSuccessResponse(json_airports).dump());
         
     } catch (const std::exception& e) {
@@ -166,7 +283,7 @@ crow::response AirportController::getAirportsInBounds(const crow::request& req)
 
 crow::response AirportController::searchAirports(const crow::request& req) {
     try {
-        logger_->debug("Searching airports with params: {}", req.url);
+        SPDLOG_LOGGER_DEBUG(logger_, "Searching airports with params: {}", req.url);
         
         auto query = req.url_params.get("q");
         if (!query) {
@@ -187,7 +304,11 @@ crow::response AirportController::searchAirports(const crow::request& req) {
             }
         }
 
-        logger_->debug("Searching for '{}' with limit {}", query, limit);
+        SPDLOG_LOGGER_DEBUG(logger_, "Searching for '{}' with limit {}", query, limit);
+        
+        if (auto snapshot = ReferenceDataStore::getInstance().snapshot()) {
+            return listResponse(snapshot->searchAirports(query, limit));
+        }
         
         auto airports = airportRepository_.searchAirportsByQuery(query, limit);
         nlohmann::json json_airports = nlohmann::json::array();
@@ -201,7 +322,7 @@ crow::response AirportController::searchAirports(const crow::request& req) {
             }
         }
         
-        logger_->debug("Search for '{}' returned {} airports", query, json_airports.size());
+        SPDLOG_LOGGER_DEBUG(logger_, "Search for '{}' returned {} airports", query, json_airports.size());
         return crow::response(200, createSuccessResponse(json_airports).dump());
         
     } catch (const std::exception& e) {
@@ -212,13 +333,35 @@ crow::response AirportController::searchAirports(const crow::request& req) {
 
 crow::response AirportController::getAirportRunways(const std::string& icao_code) {
     try {
-        logger_->debug("Getting runways for airport: {}", icao_code);
+        SPDLOG_LOGGER_DEBUG(logger_, "Getting runways for airport: {}", icao_code);
+        
+        if (auto snapshot = ReferenceDataStore::getInstance().snapshot()) {
+            const Airport* airport = snapshot->airportByIcao(icao_code);
+            if (!airport) {
+                return crow::response(404, createErrorResponse("Airport not found").dump());
+            }
+            std::vector<const AirportRunway*> runways;
+            for (const auto& runway : snapshot->runwaysForAirport(airport->id)) {
+                if (runway.is_active) runways.push_back(&runway);
+            }
+            return runwayResponse(runways);
+        }
         
-        // For now, return a not implemented response with proper JSON structure
-        nlohmann::json empty_runways = nlohmann::json::array();
+        Airport airport;
+        try {
+            airport = airportRepository_.fetchAirportByIcao(icao_code);
+        } catch (const std::runtime_error& e) {
+            logger_->warn("Could not find airport with ICAO '{}': {}", icao_code, e.what());
+            return crow::response(404, createErrorResponse("Airport not found").dump());
+        }
         
-        logger_->debug("Runway endpoint not yet implemented for {}", icao_code);
-        return crow::response(200, createSuccessResponse(empty_runways).dump());
+        auto runways = airportRepository_.fetchRunwaysByAirportId(airport.id, true);
+        std::vector<const AirportRunway*> pointers;
+        for (const auto& runway : runways) {
+            pointers.push_back(&runway);
+        }
+        SPDLOG_LOGGER_DEBUG(logger_, "Found {} runways for {}", runways.size(), icao_code);
+        return runwayResponse(pointers);
         
     } catch (const std::exception& e) {
         logger_->error("Error in getAirportRunways for '{}': {}", icao_code, e.what());
@@ -226,21 +369,212 @@ crow::response AirportController::getAirportRunways(const std::string& icao_code
     }
 }
 
+crow::response AirportController::getAirportChanges(const crow::request& req) {
+    try {
+        auto since = ChangeLog::parseVersion(req.url_params.get("since"));
+        if (!since) {
+            return crow::response(400, createErrorResponse("Missing or invalid parameter: since").dump());
+        }
+
+        // Without the in-memory store nothing tracks changes, so always reload
+        ChangeSet changes;
+        if (ReferenceDataStore::getInstance().snapshot()) {
+            changes = ChangeLog::getInstance().changesSince(ChangeLog::Table::Airports, *since);
+        } else {
+            changes.since = *since;
+            changes.version = ChangeLog::getInstance().version();
+            changes.reset = true;
+        }
+        return crow::response(200, createSuccessResponse(changes.toJson()).dump());
+
+    } catch (const std::exception& e) {
+        logger_->error("Error in getAirportChanges: {}", e.what());
+        return crow::response(500, createErrorResponse("Internal server error", 500).dump());
+    }
+}
+
 // Helper Methods
-bool AirportController::validateBounds(double min_lat, double max_lat, double min_lng, double max_lng) {
-    // Check latitude bounds
-    if (min_lat < -90.0 || min_lat > 90.0) return false;
-    if (max_lat < -90.0 || max_lat > 90.0) return false;
-    if (min_lat > max_lat) return false;
-    
-    // Check longitude bounds
-    if (min_lng < -180.0 || min_lng > 180.0) return false;
-    if (max_lng < -180.0 || max_lng > 180.0) return false;
-    if (min_lng > max_lng) return false;
-    
+// Built once per airport, reference snapshot version and level and kept in
+// ResultCache until a procedure write drops it through the airport or
+// procedure tags (also those of other instances, see CacheEvents). The ETag
+// hashes the body, and ResponseCompression keeps the compressed form per
+// ETag, so a repeated open is served from memory without a query or a
+// compression pass.
+crow::response AirportController::getAirportBundle(const crow::request& req, const std::string& icao_code) {
+    try {
+        std::optional<size_t> level;
+        std::string error;
+        if (!SimplifiedGeometryCache::fromRequest(req, level, error)) {
+            return crow::response(400, createErrorResponse(error).dump());
+        }
+        if (!req.url_params.get("zoom") && !req.url_params.get("simplify")) {
+            level = kBundleLevel;
+        }
+
+        auto snapshot = ReferenceDataStore::getInstance().snapshot();
+        if (!snapshot) {
+            return crow::response(503, createErrorResponse("Reference data not loaded", 503).dump());
+        }
+        const Airport* airport = snapshot->airportByIcao(icao_code);
+        if (!airport) {
+            return crow::response(404, createErrorResponse("Airport not found").dump());
+        }
+
+        AccessProfile::getInstance().record(AccessProfile::Kind::Airport, airport->icao_code + ":" + levelName(level));
+        auto cached = bundle(*snapshot, *airport, level);
+
+        if (ConditionalGet::isCurrent(req, cached->validator)) {
+            return ConditionalGet::notModified(cached->validator);
+        }
+        crow::response res(200, cached->body);
+        ConditionalGet::tag(res, cached->validator);
+        return res;
+
+    } catch (const std::exception& e) {
+        logger_->error("Error in getAirportBundle for '{}': {}", icao_code, e.what());
+        return crow::response(500, createErrorResponse("Internal server error", 500).dump());
+    }
+}
+
+std::shared_ptr<const AirportBundle> AirportController::bundle(const ReferenceSnapshot& snapshot, const Airport& airport,
+                                                               std::optional<size_t> level) {
+    const std::string key = "airport.bundle:" + airport.icao_code + ":" + std::to_string(snapshot.version) + ":" +
+                            levelName(level);
+    std::vector<std::string> tags{ResultCache::airportTag(airport.icao_code)};
+    return ResultCache::getInstance().get<AirportBundle>(key, tags, [&]() {
+        FlightProcedureFilter filter;
+        filter.airport_icao = airport.icao_code;
+        filter.is_active = true;
+        filter.limit = kBundleMaxProcedures;
+        auto procedures = procedureRepository_->findAll(filter);
+
+        AirportBundle built;
+        JsonWriter writer(built.body);
+        writer.beginObject().rawKey("data").beginObject().rawKey("airport");
+        airport.writeJson(writer);
+
+        writer.rawKey("runways").beginArray();
+        for (const auto& runway : snapshot.runwaysForAirport(airport.id)) {
+            if (runway.is_active) runway.writeJson(writer);
+        }
+        writer.endArray();
+
+        writer.rawKey("procedures").beginArray();
+        for (auto& procedure : procedures) {
+            tags.push_back(ResultCache::procedureTag(procedure.id));
+            if (level) {
+                SimplifiedGeometryCache::getInstance().apply(procedure, *level);
+            }
+            procedure.writeJson(writer);
+        }
+        writer.endArray();
+
+        writer.rawKey("navaids").beginArray();
+        size_t navaids = 0;
+        for (const auto& [waypoint, distance_km] :
+             snapshot.nearestWaypoints(airport.latitude, airport.longitude, kBundleNavaidCandidates, "")) {
+            if (distance_km > kBundleNavaidRadiusKm || navaids == kBundleMaxNavaids) break;
+            if (waypoint->frequency.empty()) continue;
+            writer.beginObject()
+                  .rawField("distance_km", distance_km)
+                  .rawField("distance_nm", distance_km / 1.852);
+            writer.rawKey("waypoint");
+            waypoint->writeJson(writer);
+            writer.endObject();
+            navaids++;
+        }
+        writer.endArray().endObject();
+
+        const size_t hash = std::hash<std::string>{}(built.body);
+        char hex[17];
+        std::snprintf(hex, sizeof(hex), "%016zx", hash);
+        writer.rawField("version", hex).rawField("status", "success").endObject();
+        built.validator = ConditionalGet::fromVersion("bundle-" + airport.icao_code, hex);
+
+        SPDLOG_LOGGER_DEBUG(logger_, "Built bundle for {}: {} procedures, {} navaids, {} bytes",
+                            airport.icao_code, procedures.size(), navaids, built.body.size());
+        return built;
+    });
+}
+
+bool AirportController::warmBundle(const std::string& profile_key) {
+    // "<icao>:<level>", as getAirportBundle records it
+    const auto colon = profile_key.rfind(':');
+    if (colon == std::string::npos) {
+        return false;
+    }
+    std::optional<size_t> level;
+    if (std::string_view(profile_key).substr(colon + 1) != "full") {
+        size_t parsed = 0;
+        const char* first = profile_key.data() + colon + 1;
+        const char* last = profile_key.data() + profile_key.size();
+        auto result = std::from_chars(first, last, parsed);
+        if (result.ec != std::errc() || result.ptr != last || parsed >= SimplifiedGeometry::kLevelZooms.size()) {
+            return false;
+        }
+        level = parsed;
+    }
+    auto snapshot = ReferenceDataStore::getInstance().snapshot();
+    const Airport* airport = snapshot ? snapshot->airportByIcao(profile_key.substr(0, colon)) : nullptr;
+    if (!airport) {
+        return false;
+    }
+    bundle(*snapshot, *airport, level);
     return true;
 }
 
+crow::response AirportController::listResponse(const std::vector<const Airport*>& airports) {
+    // Same layout as createSuccessResponse(...).dump()
+    std::string body;
+    JsonWriter writer(body);
+    writer.beginObject().rawKey("data").beginArray();
+    for (const Airport* airport : airports) {
+        airport->writeJson(writer);
+    }
+    writer.endArray().rawField("status", "success").endObject();
+    return crow::response(200, body);
+}
+
+crow::response AirportController::runwayResponse(const std::vector<const AirportRunway*>& runways) {
+    std::string body;
+    JsonWriter writer(body);
+    writer.beginObject().rawKey("data").beginArray();
+    for (const AirportRunway* runway : runways) {
+        runway->writeJson(writer);
+    }
+    writer.endArray().rawField("status", "success").endObject();
+    return crow::response(200, body);
+}
+
+crow::response AirportController::clusterResponse(const ReferenceSnapshot& snapshot,
+                                                 const std::vector<ClusterIndex::Cluster>& clusters) {
+    // Single-member clusters are sent as the airport itself; the rest carry "cluster": true
+    std::string body;
+    JsonWriter writer(body);
+    writer.beginObject().rawField("clustered", true).rawKey("data").beginArray();
+    for (const auto& cluster : clusters) {
+        if (cluster.count == 1) {
+            snapshot.airports[cluster.first_row].writeJson(writer);
+            continue;
+        }
+        writer.beginObject()
+              .rawField("cluster", true)
+              .rawField("count", static_cast<int64_t>(cluster.count))
+              .rawField("latitude", cluster.latitude)
+              .rawField("longitude", cluster.longitude)
+              .rawField("airport_type", *cluster.dominant_type)
+              .endObject();
+    }
+    writer.endArray().rawField("status", "success").endObject();
+    return crow::response(200, body);
+}
+
+std::optional<GeoBounds> AirportController::normalizeBounds(double min_lat, double max_lat, double min_lng, double max_lng) {
+    // Latitudes must at least overlap the globe; the map's padded box may overshoot the poles
+    if (max_lat < -90.0 || min_lat > 90.0) return std::nullopt;
+    return GeoBounds::fromBox(min_lat, max_lat, min_lng, max_lng);
+}
+
 nlohmann::json AirportController::createErrorResponse(const std::string& message, int code) {
     try {
         return nlohmann::json{
@@ -1,26 +1,39 @@
 #pragma once
 
 #include <crow.h>
+#include "HttpApp.h"
 #include <json.hpp>
 #include <string>
 #include <vector>
 #include <memory>
+#include <optional>
 #include <spdlog/spdlog.h>
 #include "Airport.h"         // Include the Airport definitions
+#include "SpatialGrid.h"
+#include "ClusterIndex.h"
 #include "AirportRepository.h" // Include the repository
+#include "FlightProcedureRepository.h"
 
 namespace aeronautical {
 
+struct ReferenceSnapshot;
+struct AirportBundle;
+
 class AirportController {
 public:
     AirportController();
     ~AirportController() = default;
     
-    void registerRoutes(crow::SimpleApp& app);
+    void registerRoutes(HttpApp& app);
+
+    // Builds the bundle an AccessProfile airport key ("<icao>:<level>")
+    // names into ResultCache; false when the airport is not in the snapshot
+    bool warmBundle(const std::string& profile_key);
     
 private:
     std::shared_ptr<spdlog::logger> logger_;
     AirportRepository airportRepository_; // Add repository member
+    std::unique_ptr<FlightProcedureRepository> procedureRepository_;
 
     // API handlers
     crow::response getAllAirports(const crow::request& req);
@@ -29,9 +42,17 @@ private:
     crow::response getAirportsInBounds(const crow::request& req);
     crow::response getAirportRunways(const std::string& icao_code);
     crow::response searchAirports(const crow::request& req);
+    crow::response getAirportChanges(const crow::request& req);
+    crow::response getAirportBundle(const crow::request& req, const std::string& icao_code);
+    // The bundle from ResultCache, built on a miss
+    std::shared_ptr<const AirportBundle> bundle(const ReferenceSnapshot& snapshot, const Airport& airport,
+                                                std::optional<size_t> level);
         
     // Helper methods
-    bool validateBounds(double min_lat, double max_lat, double min_lng, double max_lng);
+    crow::response listResponse(const std::vector<const Airport*>& airports);
+    crow::response runwayResponse(const std::vector<const AirportRunway*>& runways);
+    crow::response clusterResponse(const ReferenceSnapshot& snapshot, const std::vector<ClusterIndex::Cluster>& clusters);
+    std::optional<GeoBounds> normalizeBounds(double min_lat, double max_lat, double min_lng, double max_lng);
     nlohmann::json createErrorResponse(const std::string& message, int code = 400);
     nlohmann::json createSuccessResponse(const nlohmann::json& data);
 };
@@ -1,6 +1,8 @@
 #include "AirportRepository.h"
 #include "DatabaseManager.h"
+#include "RowDecoder.h"
 #include <mysql/mysql.h>
+#include <optional>
 #include <sstream>
 #include <stdexcept>
 
@@ -18,33 +20,61 @@ static std::string escapeString(MYSQL* con, const std::string& str) {
     return result;
 }
 
-// Helper to populate an Airport struct from a MYSQL_ROW
-static void populateAirportFromRow(Airport& airport, MYSQL_ROW row) {
-    airport.id = row[0] ? std::stoi(row[0]) : 0;
-    airport.icao_code = row[1] ? row[1] : "";
-    airport.iata_code = row[2] ? row[2] : "";
-    airport.name = row[3] ? row[3] : "";
-    airport.full_name = row[4] ? row[4] : "";
-    airport.latitude = row[5] ? std::stod(row[5]) : 0.0;
-    airport.longitude = row[6] ? std::stod(row[6]) : 0.0;
-    airport.elevation_ft = row[7] ? std::stoi(row[7]) : 0;
-    airport.airport_type = row[8] ? row[8] : "";
-    airport.municipality = row[9] ? row[9] : "";
-    airport.region = row[10] ? row[10] : "";
-    airport.country_code = row[11] ? row[11] : "";
-    airport.country_name = row[12] ? row[12] : "";
-    airport.is_active = row[14] ? (std::string(row[14]) == "1") : false;
-    airport.has_tower = row[15] ? (std::string(row[15]) == "1") : false;
-    airport.has_ils = row[16] ? (std::string(row[16]) == "1") : false;
-    airport.runway_count = row[17] ? std::stoi(row[17]) : 0;
-    airport.longest_runway_ft = row[18] ? std::stoi(row[18]) : 0;
+// Column map for "SELECT * FROM airports"; column 13 is not part of Airport
+using AirportRow = RowMap<Airport,
+    Field<&Airport::id>,
+    Field<&Airport::icao_code>,
+    Field<&Airport::iata_code>,
+    Field<&Airport::name>,
+    Field<&Airport::full_name>,
+    Field<&Airport::latitude>,
+    Field<&Airport::longitude>,
+    Field<&Airport::elevation_ft>,
+    Field<&Airport::airport_type>,
+    Field<&Airport::municipality>,
+    Field<&Airport::region>,
+    Field<&Airport::country_code>,
+    Field<&Airport::country_name>,
+    Skip,
+    Field<&Airport::is_active>,
+    Field<&Airport::has_tower>,
+    Field<&Airport::has_ils>,
+    Field<&Airport::runway_count>,
+    Field<&Airport::longest_runway_ft>>;
+
+// Column map for runwaysQuery()
+using RunwayRow = RowMap<AirportRunway,
+    Field<&AirportRunway::id>,
+    Field<&AirportRunway::airport_id>,
+    Field<&AirportRunway::runway_identifier>,
+    Field<&AirportRunway::length_ft>,
+    Field<&AirportRunway::width_ft>,
+    Field<&AirportRunway::surface_type>,
+    Field<&AirportRunway::le_ident>,
+    Field<&AirportRunway::le_heading_deg>,
+    Field<&AirportRunway::le_latitude>,
+    Field<&AirportRunway::le_longitude>,
+    Field<&AirportRunway::he_ident>,
+    Field<&AirportRunway::he_heading_deg>,
+    Field<&AirportRunway::he_latitude>,
+    Field<&AirportRunway::he_longitude>,
+    Field<&AirportRunway::is_active>>;
+
+static std::string runwaysQuery(const std::string& where) {
+    return "SELECT id, airport_id, runway_identifier, length_ft, width_ft, surface_type, "
+           "le_ident, le_heading_deg, le_latitude, le_longitude, "
+           "he_ident, he_heading_deg, he_latitude, he_longitude, is_active "
+           "FROM airport_runways" + where + " ORDER BY airport_id, runway_identifier";
 }
 
-AirportRepository::AirportRepository() {}
+AirportRepository::AirportRepository() : logger_(spdlog::get("aeronautical")) {
+    if (!logger_) {
+        logger_ = spdlog::default_logger();
+    }
+}
 
-std::vector<Airport> AirportRepository::fetchAllAirports(const std::string& filter_type, bool active_only) {
-    std::vector<Airport> airports;
-    MYSQL* con = DatabaseManager::getInstance().getConnection();
+// SELECT shared by fetchAllAirports and streamAllAirports
+static std::string allAirportsQuery(MYSQL* con, const std::string& filter_type, bool active_only) {
     std::stringstream ss;
     ss << "SELECT * FROM airports WHERE 1=1";
     if (active_only) {
@@ -53,53 +83,63 @@ std::vector<Airport> AirportRepository::fetchAllAirports(const std::string& filt
     if (!filter_type.empty()) {
         ss << " AND airport_type = '" << escapeString(con, filter_type) << "'";
     }
+    return ss.str();
+}
+
+std::vector<Airport> AirportRepository::fetchAllAirports(const std::string& filter_type, bool active_only) {
+    std::vector<Airport> airports;
+    DatabaseManager::ReadScope scope(DatabaseManager::getInstance());
+    MYSQL* con = scope.get();
 
-    if (mysql_query(con, ss.str().c_str())) {
+    if (mysql_query(con, allAirportsQuery(con, filter_type, active_only).c_str())) {
         // In a real application, you'd log this error
         return airports;
     }
 
-    MYSQL_RES* result = mysql_store_result(con);
+    MysqlResult result(mysql_store_result(con));
     if (result == NULL) {
         return airports;
     }
 
     MYSQL_ROW row;
-    while ((row = mysql_fetch_row(result))) {
-        Airport airport;
-        populateAirportFromRow(airport, row);
-        airports.push_back(airport);
+    while ((row = mysql_fetch_row(result.get()))) {
+        airports.push_back(AirportRow::decode(row, mysql_fetch_lengths(result.get())));
     }
-    mysql_free_result(result);
     return airports;
 }
 
-Airport AirportRepository::fetchAirportByIcao(const std::string& icao_code) {
-    MYSQL* con = DatabaseManager::getInstance().getConnection();
-    std::stringstream ss;
-    ss << "SELECT * FROM airports WHERE icao_code = '" << escapeString(con, icao_code) << "' LIMIT 1";
+bool AirportRepository::streamAllAirports(const std::string& filter_type, bool active_only,
+                                          const std::function<void(const Airport&)>& on_airport) {
+    auto& db = DatabaseManager::getInstance();
+    DatabaseManager::ReadScope scope(db);
+    std::string query = allAirportsQuery(scope.get(), filter_type, active_only);
+
+    return db.streamSelectQuery(query, [&](MYSQL_ROW row, unsigned long* lengths) {
+        on_airport(AirportRow::decode(row, lengths));
+        return true;
+    });
+}
 
-    if (mysql_query(con, ss.str().c_str())) {
+Airport AirportRepository::fetchAirportByIcao(const std::string& icao_code) {
+    PreparedResult result;
+    try {
+        result = DatabaseManager::getInstance().executePrepared(
+            "SELECT * FROM airports WHERE icao_code = ? LIMIT 1", {icao_code});
+    } catch (const SqlError&) {
         throw std::runtime_error("Database query failed");
     }
 
-    MYSQL_RES* result = mysql_store_result(con);
-    if (result == NULL || mysql_num_rows(result) == 0) {
-        if(result) mysql_free_result(result);
+    if (result.rows.empty()) {
         throw std::runtime_error("Airport not found");
     }
 
-    MYSQL_ROW row = mysql_fetch_row(result);
-    Airport airport;
-    populateAirportFromRow(airport, row);
-    
-    mysql_free_result(result);
-    return airport;
+    return AirportRow::decode(result.rows.front());
 }
 
 std::vector<Airport> AirportRepository::fetchAirportsByCountry(const std::string& country_code, bool active_only) {
     std::vector<Airport> airports;
-    MYSQL* con = DatabaseManager::getInstance().getConnection();
+    DatabaseManager::ReadScope scope(DatabaseManager::getInstance());
+    MYSQL* con = scope.get();
     std::stringstream ss;
     ss << "SELECT * FROM airports WHERE country_code = '" << escapeString(con, country_code) << "'";
     if (active_only) {
@@ -108,22 +148,20 @@ std::vector<Airport> AirportRepository::fetchAirportsByCountry(const std::string
     
     if (mysql_query(con, ss.str().c_str())) return airports;
 
-    MYSQL_RES* result = mysql_store_result(con);
+    MysqlResult result(mysql_store_result(con));
     if (result == NULL) return airports;
 
     MYSQL_ROW row;
-    while ((row = mysql_fetch_row(result))) {
-        Airport airport;
-        populateAirportFromRow(airport, row);
-        airports.push_back(airport);
+    while ((row = mysql_fetch_row(result.get()))) {
+        airports.push_back(AirportRow::decode(row, mysql_fetch_lengths(result.get())));
     }
-    mysql_free_result(result);
     return airports;
 }
 
 std::vector<Airport> AirportRepository::fetchAirportsInBounds(double min_lat, double max_lat, double min_lng, double max_lng, const std::string& filter_type) {
     std::vector<Airport> airports;
-    MYSQL* con = DatabaseManager::getInstance().getConnection();
+    DatabaseManager::ReadScope scope(DatabaseManager::getInstance());
+    MYSQL* con = scope.get();
     std::stringstream ss;
     ss << "SELECT * FROM airports WHERE (latitude BETWEEN " << min_lat << " AND " << max_lat 
        << ") AND (longitude BETWEEN " << min_lng << " AND " << max_lng << ")";
@@ -134,22 +172,20 @@ std::vector<Airport> AirportRepository::fetchAirportsInBounds(double min_lat, do
     
     if (mysql_query(con, ss.str().c_str())) return airports;
     
-    MYSQL_RES* result = mysql_store_result(con);
+    MysqlResult result(mysql_store_result(con));
     if (result == NULL) return airports;
 
     MYSQL_ROW row;
-    while ((row = mysql_fetch_row(result))) {
-        Airport airport;
-        populateAirportFromRow(airport, row);
-        airports.push_back(airport);
+    while ((row = mysql_fetch_row(result.get()))) {
+        airports.push_back(AirportRow::decode(row, mysql_fetch_lengths(result.get())));
     }
-    mysql_free_result(result);
     return airports;
 }
 
 std::vector<Airport> AirportRepository::searchAirportsByQuery(const std::string& query, int limit) {
     std::vector<Airport> airports;
-    MYSQL* con = DatabaseManager::getInstance().getConnection();
+    DatabaseManager::ReadScope scope(DatabaseManager::getInstance());
+    MYSQL* con = scope.get();
     std::string search_query = "%" + escapeString(con, query) + "%";
     std::stringstream ss;
     ss << "SELECT * FROM airports WHERE (name LIKE '" << search_query 
@@ -160,17 +196,112 @@ std::vector<Airport> AirportRepository::searchAirportsByQuery(const std::string&
 
     if (mysql_query(con, ss.str().c_str())) return airports;
     
-    MYSQL_RES* result = mysql_store_result(con);
+    MysqlResult result(mysql_store_result(con));
     if (result == NULL) return airports;
 
     MYSQL_ROW row;
-    while ((row = mysql_fetch_row(result))) {
-        Airport airport;
-        populateAirportFromRow(airport, row);
-        airports.push_back(airport);
+    while ((row = mysql_fetch_row(result.get()))) {
+        airports.push_back(AirportRow::decode(row, mysql_fetch_lengths(result.get())));
     }
-    mysql_free_result(result);
     return airports;
 }
 
-} // namespace aeronautical
\ No newline at end of file
+bool AirportRepository::streamAllRunways(bool active_only,
+                                         const std::function<void(const AirportRunway&)>& on_runway) {
+    return DatabaseManager::getInstance().streamSelectQuery(
+        runwaysQuery(active_only ? " WHERE is_active = TRUE" : ""), [&](MYSQL_ROW row, unsigned long* lengths) {
+            on_runway(RunwayRow::decode(row, lengths));
+            return true;
+        });
+}
+
+std::vector<AirportRunway> AirportRepository::fetchRunwaysByAirportId(int airport_id, bool active_only) {
+    std::vector<AirportRunway> runways;
+    PreparedResult result;
+    try {
+        result = DatabaseManager::getInstance().executePrepared(
+            runwaysQuery(active_only ? " WHERE airport_id = ? AND is_active = TRUE" : " WHERE airport_id = ?"),
+            {static_cast<int64_t>(airport_id)});
+    } catch (const SqlError&) {
+        throw std::runtime_error("Database query failed");
+    }
+
+    runways.reserve(result.rows.size());
+    for (const auto& row : result.rows) {
+        runways.push_back(RunwayRow::decode(row));
+    }
+    return runways;
+}
+
+bool AirportRepository::upsertBatch(const std::vector<Airport>& airports,
+                                    const std::vector<std::string>& update_columns) {
+    auto& db = DatabaseManager::getInstance();
+
+    std::string suffix = " ON DUPLICATE KEY UPDATE ";
+    for (size_t i = 0; i < update_columns.size(); i++) {
+        suffix += (i ? ", " : "") + update_columns[i] + " = VALUES(" + update_columns[i] + ")";
+    }
+    if (update_columns.empty()) {
+        suffix += "id = id";
+    }
+
+    try {
+        DatabaseManager::Transaction transaction(db);
+        MYSQL* con = transaction.get();
+
+        auto rowSql = [con](const Airport& a) {
+            std::stringstream row;
+            row.precision(10);
+            row << "(" << (a.id > 0 ? std::to_string(a.id) : "NULL") << ", '" << escapeString(con, a.icao_code)
+                << "', '" << escapeString(con, a.iata_code) << "', '" << escapeString(con, a.name) << "', '"
+                << escapeString(con, a.full_name) << "', " << a.latitude << ", " << a.longitude << ", "
+                << a.elevation_ft << ", '" << escapeString(con, a.airport_type) << "', '"
+                << escapeString(con, a.municipality) << "', '" << escapeString(con, a.region) << "', '"
+                << escapeString(con, a.country_code) << "', '" << escapeString(con, a.country_name) << "', "
+                << (a.is_active ? 1 : 0) << ", " << (a.has_tower ? 1 : 0) << ", " << (a.has_ils ? 1 : 0) << ", "
+                << a.runway_count << ", " << a.longest_runway_ft << ")";
+            return row.str();
+        };
+
+        const std::string prefix =
+            "INSERT INTO airports (id, icao_code, iata_code, name, full_name, latitude, longitude, elevation_ft, "
+            "airport_type, municipality, region, country_code, country_name, is_active, has_tower, has_ils, "
+            "runway_count, longest_runway_ft) VALUES ";
+        std::string statement;
+        size_t rows_in_statement = 0;
+        bool ok = true;
+        for (size_t i = 0; ok && i < airports.size(); i++) {
+            std::string row = rowSql(airports[i]);
+            // Flush before this row would push the statement past the size limit
+            if (rows_in_statement > 0 &&
+                statement.size() + row.size() + suffix.size() + 1 > kMaxInsertStatementBytes) {
+                ok = db.executeQuery(statement + suffix);
+                statement.clear();
+                rows_in_statement = 0;
+            }
+            statement += rows_in_statement == 0 ? prefix : ",";
+            statement += row;
+            rows_in_statement++;
+        }
+        if (ok && rows_in_statement > 0) {
+            ok = db.executeQuery(statement + suffix);
+        }
+
+        if (!ok) {
+            transaction.rollback();
+            logger_->error("Rolled back import of {} airports", airports.size());
+            return false;
+        }
+        if (!transaction.commit()) {
+            logger_->error("Failed to commit import of {} airports", airports.size());
+            return false;
+        }
+        return true;
+
+    } catch (const std::exception& err) {
+        logger_->error("Exception importing airports: {}", err.what());
+        return false;
+    }
+}
+
+} // namespace aeronautical
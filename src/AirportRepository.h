@@ -4,6 +4,7 @@
 
 #include <vector>
 #include <string>
+#include <functional>
 #include <spdlog/spdlog.h>
 
 
@@ -13,11 +14,26 @@ class AirportRepository {
 public:
     AirportRepository();
     std::vector<Airport> fetchAllAirports(const std::string& filter_type, bool active_only);
+    // Same rows as fetchAllAirports, handed over one at a time as they stream from MySQL
+    bool streamAllAirports(const std::string& filter_type, bool active_only,
+                           const std::function<void(const Airport&)>& on_airport);
     Airport fetchAirportByIcao(const std::string& icao_code);
     std::vector<Airport> fetchAirportsByCountry(const std::string& country_code, bool active_only);
     std::vector<Airport> fetchAirportsInBounds(double min_lat, double max_lat, double min_lng, double max_lng, const std::string& filter_type);
     std::vector<Airport> searchAirportsByQuery(const std::string& query, int limit);
 
+    // Runways of every airport ordered by airport_id, runway_identifier
+    bool streamAllRunways(bool active_only, const std::function<void(const AirportRunway&)>& on_runway);
+    std::vector<AirportRunway> fetchRunwaysByAirportId(int airport_id, bool active_only);
+
+    // Writes airports in one transaction as multi-row INSERT ... ON DUPLICATE
+    // KEY UPDATE statements of at most kMaxInsertStatementBytes each. Rows
+    // with an id replace that row, id 0 gets a new one; a row that already
+    // exists only takes update_columns. Nothing is written on failure.
+    bool upsertBatch(const std::vector<Airport>& airports, const std::vector<std::string>& update_columns);
+
+    static constexpr size_t kMaxInsertStatementBytes = 4 * 1024 * 1024;
+
 private:
     // You can add a logger here if you wish, similar to controllers
     std::shared_ptr<spdlog::logger> logger_; 
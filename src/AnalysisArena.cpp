@@ -0,0 +1,31 @@
+#include "AnalysisArena.h"
+
+namespace aeronautical {
+
+void* AnalysisArena::Upstream::do_allocate(size_t bytes, size_t alignment) {
+    void* p = std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    blocks++;
+    reserved += bytes;
+    return p;
+}
+
+void AnalysisArena::Upstream::do_deallocate(void* p, size_t bytes, size_t alignment) {
+    std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+}
+
+AnalysisArena::AnalysisArena(size_t initial_bytes) : monotonic_(initial_bytes, &upstream_) {}
+
+AnalysisArena::Stats AnalysisArena::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return Stats{allocations_, bytes_, upstream_.blocks, upstream_.reserved};
+}
+
+void* AnalysisArena::do_allocate(size_t bytes, size_t alignment) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    void* p = monotonic_.allocate(bytes, alignment);
+    allocations_++;
+    bytes_ += bytes;
+    return p;
+}
+
+} // namespace aeronautical
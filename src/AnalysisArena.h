@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <mutex>
+
+namespace aeronautical {
+
+// Memory of one analysis run. The engine's scratch structures (candidate
+// lists, per-zone hits, the parsed project coordinates) come from it through
+// std::pmr containers and are released in one piece when the run ends, so a
+// run leaves no trail of small frees across the global heap. Freeing a single
+// allocation is a no-op. Safe to allocate from the analysis pool's threads at
+// once. Anything that outlives the run (stored conflicts, the reuse state)
+// must stay on the global heap; OGR geometries are GDAL's and never come here.
+class AnalysisArena : public std::pmr::memory_resource {
+public:
+    static constexpr size_t kInitialBytes = 64 << 10;
+
+    explicit AnalysisArena(size_t initial_bytes = kInitialBytes);
+    AnalysisArena(const AnalysisArena&) = delete;
+    AnalysisArena& operator=(const AnalysisArena&) = delete;
+
+    struct Stats {
+        size_t allocations = 0; // served by the arena
+        size_t bytes = 0;       // requested, before alignment
+        size_t blocks = 0;      // taken from the global heap
+        size_t reserved = 0;    // bytes of those blocks
+    };
+    Stats stats() const;
+
+private:
+    // Counts what the monotonic resource asks of the global heap
+    class Upstream : public std::pmr::memory_resource {
+    public:
+        size_t blocks = 0;
+        size_t reserved = 0;
+
+    private:
+        void* do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+    };
+
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void*, size_t, size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    mutable std::mutex mutex_;
+    Upstream upstream_;
+    std::pmr::monotonic_buffer_resource monotonic_;
+    size_t allocations_ = 0;
+    size_t bytes_ = 0;
+};
+
+} // namespace aeronautical
@@ -0,0 +1,122 @@
+#include "AnalysisController.h"
+#include "AnalysisJobQueue.h"
+#include "AnalysisProfile.h"
+#include "AsyncHandler.h"
+#include <algorithm>
+#include <cstdlib>
+#include <spdlog/sinks/stdout_color_sinks.h>
+
+namespace aeronautical {
+
+AnalysisController::AnalysisController() {
+    try {
+        logger_ = spdlog::get("aeronautical");
+        if (!logger_) {
+            auto console_sink = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
+            logger_ = std::make_shared<spdlog::logger>("aeronautical", console_sink);
+            spdlog::register_logger(logger_);
+        }
+    } catch (const std::exception& e) {
+        logger_ = spdlog::default_logger();
+    }
+}
+
+void AnalysisController::registerRoutes(HttpApp& app) {
+    // GET /api/analysis/jobs/:id[?wait=seconds] - with wait, answers once
+    // the job has finished or the time is up, whichever comes first
+    CROW_ROUTE(app, "/api/analysis/jobs/<uint>")
+        .methods(crow::HTTPMethod::GET)
+        ([this](const crow::request& req, crow::response& res, uint64_t job_id) {
+            const bool explain = explainRequested(req);
+            const auto wait = waitRequested(req);
+            AsyncHandler::spawn(req, res, [this, job_id, explain, wait]() {
+                return awaitJob([job_id]() { return AnalysisJobQueue::getInstance().getJob(job_id); }, wait,
+                                explain, "Analysis job not found");
+            });
+        });
+
+    // GET /api/projects/:id/analysis[?wait=seconds] - latest job for the project
+    CROW_ROUTE(app, "/api/projects/<int>/analysis")
+        .methods(crow::HTTPMethod::GET)
+        ([this](const crow::request& req, crow::response& res, int project_id) {
+            const bool explain = explainRequested(req);
+            const auto wait = waitRequested(req);
+            AsyncHandler::spawn(req, res, [this, project_id, explain, wait]() {
+                return awaitJob([project_id]() { return AnalysisJobQueue::getInstance().getLatestJobForProject(project_id); },
+                                wait, explain, "No analysis job recorded for this project");
+            });
+        });
+
+    logger_->info("Analysis routes registered");
+}
+
+bool AnalysisController::explainRequested(const crow::request& req) {
+    const char* explain = req.url_params.get("explain");
+    return explain && std::string(explain) == "true";
+}
+
+std::chrono::seconds AnalysisController::waitRequested(const crow::request& req) {
+    const char* wait = req.url_params.get("wait");
+    if (!wait) {
+        return std::chrono::seconds(0);
+    }
+    return std::chrono::seconds(std::clamp(std::atoi(wait), 0, static_cast<int>(kMaxWait.count())));
+}
+
+// The job table is in memory unless jobs are persisted, in which case a job
+// of another instance is read from MySQL: that read goes to a DB thread
+asio::awaitable<crow::response> AnalysisController::awaitJob(std::function<std::optional<AnalysisJobStatus>()> lookup,
+                                                             std::chrono::seconds wait, bool explain,
+                                                             std::string not_found) {
+    auto& queue = AnalysisJobQueue::getInstance();
+    auto read = [&]() -> asio::awaitable<std::optional<AnalysisJobStatus>> {
+        if (queue.persistent()) {
+            co_return co_await AsyncHandler::offload<std::optional<AnalysisJobStatus>>(lookup);
+        }
+        co_return lookup();
+    };
+    auto finished = [](const AnalysisJobStatus& status) {
+        return status.state != AnalysisJobState::Queued && status.state != AnalysisJobState::Running;
+    };
+
+    const auto deadline = std::chrono::steady_clock::now() + wait;
+    auto status = co_await read();
+    while (status && !finished(*status) && std::chrono::steady_clock::now() < deadline) {
+        co_await AsyncHandler::sleepFor(queue.persistent() ? kStorePollInterval : kPollInterval);
+        status = co_await read();
+    }
+    if (!status) {
+        co_return errorResponse(404, not_found);
+    }
+
+    nlohmann::json response;
+    response["data"] = statusJson(*status, explain);
+    co_return successResponse(response);
+}
+
+nlohmann::json AnalysisController::statusJson(const AnalysisJobStatus& status, bool explain) {
+    nlohmann::json data = status.toJson();
+    if (explain) {
+        // Null for a job run by another instance or before a restart
+        data["explain"] = status.profile ? status.profile->toJson() : nlohmann::json(nullptr);
+    }
+    return data;
+}
+
+crow::response AnalysisController::errorResponse(int code, const std::string& message) {
+    nlohmann::json response;
+    response["error"] = true;
+    response["message"] = message;
+
+    crow::response res(code, response.dump());
+    res.add_header("Content-Type", "application/json");
+    return res;
+}
+
+crow::response AnalysisController::successResponse(const nlohmann::json& data) {
+    crow::response res(200, data.dump());
+    res.add_header("Content-Type", "application/json");
+    return res;
+}
+
+} // namespace aeronautical
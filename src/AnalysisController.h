@@ -0,0 +1,51 @@
+#pragma once
+
+#include <crow.h>
+#include "HttpApp.h"
+#include <asio/awaitable.hpp>
+#include <json.hpp>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <spdlog/spdlog.h>
+
+namespace aeronautical {
+
+struct AnalysisJobStatus;
+
+// Read-only view of the in-memory analysis job table. Handlers are
+// coroutines (see AsyncHandler), so a request waiting for a job to finish
+// holds no thread.
+class AnalysisController {
+public:
+    AnalysisController();
+    ~AnalysisController() = default;
+
+    void registerRoutes(HttpApp& app);
+
+private:
+    std::shared_ptr<spdlog::logger> logger_;
+
+    // Longest ?wait= honoured, and how often a waiting request looks at the
+    // job again: the in-memory table is cheap, the store is a query
+    static constexpr std::chrono::seconds kMaxWait{30};
+    static constexpr std::chrono::milliseconds kPollInterval{100};
+    static constexpr std::chrono::milliseconds kStorePollInterval{1000};
+
+    // Route handler coroutine: the job lookup returns, polled without
+    // holding a thread until it has finished or wait is over. With explain
+    // (?explain=true) the status carries the run's AnalysisProfile.
+    asio::awaitable<crow::response> awaitJob(std::function<std::optional<AnalysisJobStatus>()> lookup,
+                                             std::chrono::seconds wait, bool explain, std::string not_found);
+
+    // Helper methods
+    static bool explainRequested(const crow::request& req);
+    static std::chrono::seconds waitRequested(const crow::request& req);
+    static nlohmann::json statusJson(const AnalysisJobStatus& status, bool explain);
+    crow::response errorResponse(int code, const std::string& message);
+    crow::response successResponse(const nlohmann::json& data);
+};
+
+} // namespace aeronautical
@@ -0,0 +1,99 @@
+#include "AnalysisEventHub.h"
+#include <spdlog/spdlog.h>
+#include <chrono>
+
+namespace aeronautical {
+
+AnalysisEventHub& AnalysisEventHub::getInstance() {
+    static AnalysisEventHub instance;
+    return instance;
+}
+
+void AnalysisEventHub::registerRoutes(HttpApp& app) {
+    CROW_WEBSOCKET_ROUTE(app, "/ws/projects")
+        .onaccept([](const crow::request& req, void** userdata) {
+            // Carry an initial project filter from the URL into onopen
+            const char* project_id = req.url_params.get("project_id");
+            *userdata = project_id ? new int(std::atoi(project_id)) : nullptr;
+            return true;
+        })
+        .onopen([this](crow::websocket::connection& conn) {
+            Subscription subscription;
+            if (auto* project_id = static_cast<int*>(conn.userdata())) {
+                subscription.all_projects = false;
+                subscription.project_ids.insert(*project_id);
+                delete project_id;
+                conn.userdata(nullptr);
+            }
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            connections_[&conn] = std::move(subscription);
+            spdlog::debug("Analysis event client connected from {} ({} open)", conn.get_remote_ip(), connections_.size());
+        })
+        .onclose([this](crow::websocket::connection& conn, const std::string& reason, uint16_t) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            connections_.erase(&conn);
+            spdlog::debug("Analysis event client disconnected: {}", reason);
+        })
+        .onmessage([this](crow::websocket::connection& conn, const std::string& data, bool is_binary) {
+            if (!is_binary) {
+                handleMessage(conn, data);
+            }
+        });
+
+    spdlog::info("Analysis event WebSocket registered at /ws/projects");
+}
+
+void AnalysisEventHub::handleMessage(crow::websocket::connection& conn, const std::string& data) {
+    try {
+        auto message = nlohmann::json::parse(data);
+        std::string action = message.value("action", "");
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = connections_.find(&conn);
+        if (it == connections_.end()) {
+            return;
+        }
+
+        if (action == "subscribe" && message.contains("project_ids") && message["project_ids"].is_array()) {
+            it->second.all_projects = false;
+            for (const auto& id : message["project_ids"]) {
+                if (id.is_number_integer()) it->second.project_ids.insert(id.get<int>());
+            }
+        } else if (action == "unsubscribe" && message.contains("project_ids") && message["project_ids"].is_array()) {
+            for (const auto& id : message["project_ids"]) {
+                if (id.is_number_integer()) it->second.project_ids.erase(id.get<int>());
+            }
+        } else if (action == "subscribe_all") {
+            it->second.all_projects = true;
+            it->second.project_ids.clear();
+        }
+    } catch (const std::exception& e) {
+        spdlog::debug("Ignoring malformed analysis event message: {}", e.what());
+    }
+}
+
+void AnalysisEventHub::publish(const std::string& event, int project_id, const nlohmann::json& payload) {
+    nlohmann::json message = payload.is_object() ? payload : nlohmann::json::object();
+    message["event"] = event;
+    message["project_id"] = project_id;
+    message["timestamp"] = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    const std::string text = message.dump();
+
+    // send_text only queues the frame on the connection's io context, so
+    // holding the lock here also keeps onclose from freeing a connection mid-send
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& [conn, subscription] : connections_) {
+        if (subscription.all_projects || subscription.project_ids.count(project_id)) {
+            conn->send_text(text);
+        }
+    }
+}
+
+size_t AnalysisEventHub::connectionCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return connections_.size();
+}
+
+} // namespace aeronautical
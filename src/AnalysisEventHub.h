@@ -0,0 +1,46 @@
+#pragma once
+
+#include <crow.h>
+#include "HttpApp.h"
+#include <json.hpp>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace aeronautical {
+
+// Pushes analysis lifecycle events to browsers over the /ws/projects
+// WebSocket. A client receives every project's events until it sends
+//   {"action": "subscribe", "project_ids": [12, 14]}
+// after which only those projects are delivered. {"action": "subscribe_all"}
+// restores the default; "?project_id=12" on the URL subscribes at connect time.
+class AnalysisEventHub {
+public:
+    static AnalysisEventHub& getInstance();
+
+    AnalysisEventHub(const AnalysisEventHub&) = delete;
+    AnalysisEventHub& operator=(const AnalysisEventHub&) = delete;
+
+    void registerRoutes(HttpApp& app);
+
+    // Sends {"event": name, "project_id": id, ...payload} to interested clients.
+    // Safe to call from any thread.
+    void publish(const std::string& event, int project_id, const nlohmann::json& payload = nlohmann::json::object());
+
+    size_t connectionCount() const;
+
+private:
+    struct Subscription {
+        bool all_projects = true;
+        std::unordered_set<int> project_ids;
+    };
+
+    AnalysisEventHub() = default;
+
+    void handleMessage(crow::websocket::connection& conn, const std::string& data);
+
+    mutable std::mutex mutex_;
+    std::unordered_map<crow::websocket::connection*, Subscription> connections_;
+};
+
+} // namespace aeronautical
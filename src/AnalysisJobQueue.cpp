@@ -0,0 +1,747 @@
+#include "AnalysisJobQueue.h"
+#include "AnalysisJobStore.h"
+#include "AnalysisProfile.h"
+#include "MemoryArenas.h"
+#include "Metrics.h"
+#include "Project.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
+namespace aeronautical {
+
+std::string analysisJobStateToString(AnalysisJobState state) {
+    switch (state) {
+        case AnalysisJobState::Queued: return "queued";
+        case AnalysisJobState::Running: return "running";
+        case AnalysisJobState::Completed: return "completed";
+        case AnalysisJobState::Failed: return "failed";
+        case AnalysisJobState::Cancelled: return "cancelled";
+    }
+    return "unknown";
+}
+
+AnalysisProgress::AnalysisProgress() : profile(std::make_shared<AnalysisProfile>()) {}
+
+nlohmann::json AnalysisJobStatus::toJson() const {
+    nlohmann::json j;
+    j["job_id"] = id;
+    j["project_id"] = project_id;
+    j["priority"] = priorityToString(priority);
+    j["state"] = analysisJobStateToString(state);
+    j["queued_at"] = timePointToString(queued_at);
+    j["started_at"] = started_at ? nlohmann::json(timePointToString(*started_at)) : nlohmann::json(nullptr);
+    j["finished_at"] = finished_at ? nlohmann::json(timePointToString(*finished_at)) : nlohmann::json(nullptr);
+    j["protections_total"] = protections_total;
+    j["protections_scanned"] = protections_scanned;
+    j["conflicts_found"] = conflicts_found;
+    if (error) j["error"] = *error;
+    return j;
+}
+
+double OrganizationShares::weightOf(const std::string& organization) const {
+    auto it = weights.find(organization);
+    const double weight = it != weights.end() ? it->second : default_weight;
+    return weight > 0 ? weight : 1.0;
+}
+
+size_t OrganizationShares::maxRunningOf(const std::string& organization) const {
+    auto it = max_running.find(organization);
+    return it != max_running.end() ? it->second : default_max_running;
+}
+
+std::unordered_map<std::string, double> OrganizationShares::parseList(const std::string& text) {
+    std::unordered_map<std::string, double> values;
+    size_t begin = 0;
+    while (begin <= text.size()) {
+        size_t end = text.find(';', begin);
+        if (end == std::string::npos) end = text.size();
+        const std::string entry = text.substr(begin, end - begin);
+        const size_t equals = entry.rfind('=');
+        if (equals != std::string::npos && equals > 0) {
+            const std::string value = entry.substr(equals + 1);
+            char* parsed_end = nullptr;
+            const double number = std::strtod(value.c_str(), &parsed_end);
+            if (!value.empty() && parsed_end == value.c_str() + value.size()) {
+                values[entry.substr(0, equals)] = number;
+            }
+        }
+        begin = end + 1;
+    }
+    return values;
+}
+
+AnalysisJobQueue& AnalysisJobQueue::getInstance() {
+    static AnalysisJobQueue instance;
+    return instance;
+}
+
+AnalysisJobQueue::~AnalysisJobQueue() {
+    shutdown();
+}
+
+void AnalysisJobQueue::persistTo(std::unique_ptr<AnalysisJobStore> store) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_) {
+        return;
+    }
+    store_ = std::move(store);
+}
+
+void AnalysisJobQueue::start(size_t workers, size_t capacity, Handler handler, CpuSet cpus) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_) {
+        return;
+    }
+
+    handler_ = std::move(handler);
+    capacity_ = capacity == 0 ? 1 : capacity;
+    running_ = true;
+
+    if (workers == 0 && !store_) {
+        workers = 1;
+    }
+    worker_slots_ = workers;
+    idle_.assign(workers, 0);
+    for (size_t i = 0; i < workers; i++) {
+        workers_.emplace_back([this, cpus, i]() {
+            pinCurrentThread(cpus);
+            MemoryArenas::getInstance().bindCurrentThread("analysis");
+            workerLoop(i);
+        });
+    }
+    if (store_) {
+        lease_stop_ = false;
+        lease_thread_ = std::thread([this]() { leaseLoop(); });
+    }
+
+    spdlog::info("Analysis job queue started: {} workers, capacity {}", workers, capacity_);
+}
+
+void AnalysisJobQueue::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // After drain() the workers may still be running
+        if (!running_ && workers_.empty()) {
+            return;
+        }
+        running_ = false;
+    }
+    not_empty_.notify_all();
+
+    for (auto& worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    workers_.clear();
+    // Leases of running jobs are kept until they finished
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        lease_stop_ = true;
+    }
+    lease_wake_.notify_all();
+    if (lease_thread_.joinable()) {
+        lease_thread_.join();
+    }
+    spdlog::info("Analysis job queue stopped");
+}
+
+std::vector<int> AnalysisJobQueue::drain() {
+    std::vector<int> project_ids;
+    size_t released = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+        if (store_) {
+            // Left queued in the store, for another instance or the next start
+            released = queue_.size();
+            queue_.clear();
+        }
+        const auto now = std::chrono::system_clock::now();
+        for (const AnalysisJob& job : queue_) {
+            project_ids.push_back(job.project_id);
+            auto it = jobs_.find(job.id);
+            if (it != jobs_.end()) {
+                it->second.state = AnalysisJobState::Failed;
+                it->second.finished_at = now;
+                it->second.error = "Server shut down before the analysis started";
+                finished_count_++;
+            }
+        }
+        queue_.clear();
+        pruneFinishedJobs();
+    }
+    not_empty_.notify_all();
+    if (store_) {
+        persist("release", [this]() { store_->release(); });
+    }
+    if (!project_ids.empty() || released > 0) {
+        spdlog::info("Analysis job queue drained: {} queued jobs not started",
+                     project_ids.size() + released);
+    }
+    return project_ids;
+}
+
+bool AnalysisJobQueue::writeCheckpoint(const std::string& path, const std::vector<int>& project_ids) {
+    if (project_ids.empty()) {
+        std::remove(path.c_str());
+        return true;
+    }
+    const std::string tmp_path = path + ".tmp";
+    {
+        std::ofstream out(tmp_path, std::ios::trunc);
+        out << nlohmann::json{{"project_ids", project_ids}}.dump();
+        if (!out) {
+            spdlog::error("Analysis checkpoint: failed to write {}", tmp_path);
+            std::remove(tmp_path.c_str());
+            return false;
+        }
+    }
+    if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+        spdlog::error("Analysis checkpoint: failed to rename {} to {}", tmp_path, path);
+        std::remove(tmp_path.c_str());
+        return false;
+    }
+    spdlog::info("Analysis checkpoint: {} queued projects saved to {}", project_ids.size(), path);
+    return true;
+}
+
+size_t AnalysisJobQueue::resumeCheckpoint(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) {
+        return 0;
+    }
+    std::vector<int> project_ids;
+    try {
+        project_ids = nlohmann::json::parse(in).at("project_ids").get<std::vector<int>>();
+    } catch (const std::exception& e) {
+        spdlog::error("Analysis checkpoint {} is unreadable: {}", path, e.what());
+        return 0;
+    }
+    in.close();
+
+    size_t resumed = 0;
+    std::vector<int> left;
+    for (int project_id : project_ids) {
+        if (enqueue(project_id)) {
+            resumed++;
+        } else {
+            left.push_back(project_id);
+        }
+    }
+    // Whatever did not fit stays for the next start
+    writeCheckpoint(path, left);
+    spdlog::info("Analysis checkpoint: {} queued projects resumed from {}", resumed, path);
+    return resumed;
+}
+
+std::optional<uint64_t> AnalysisJobQueue::enqueue(int project_id, ProjectPriority priority,
+                                                  std::optional<std::chrono::system_clock::time_point> deadline,
+                                                  const std::string& organization) {
+    AnalysisJob job;
+    job.project_id = project_id;
+    job.priority = priority;
+    job.deadline = deadline;
+    job.organization = organization;
+    job.queued_at = std::chrono::system_clock::now();
+    job.progress = std::make_shared<AnalysisProgress>();
+    job.trace = Tracer::current();
+    if (region_key_) job.region = region_key_(project_id);
+
+    if (store_) {
+        // The row is written before the caller hears of the job, so it
+        // survives a crash from then on
+        bool submit_only = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!running_ || queue_.size() >= capacity_) {
+                return std::nullopt;
+            }
+            submit_only = workers_.empty();
+        }
+        try {
+            job.id = store_->insert(job, !submit_only);
+        } catch (const std::exception& e) {
+            spdlog::error("Failed to store analysis job for project {}: {}", project_id, e.what());
+            return std::nullopt;
+        }
+        // Older rows of the project, wherever they run; their runners see it at the next lease renewal
+        persist("supersede", [this, &job]() { store_->supersede(job.project_id, job.id); });
+        if (submit_only) {
+            // Run elsewhere; status is read back from the store
+            spdlog::debug("Stored analysis job {} for project {} for the analysis workers", job.id, project_id);
+            return job.id;
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!store_) {
+            if (!running_ || queue_.size() >= capacity_) {
+                return std::nullopt;
+            }
+            job.id = next_id_++;
+        }
+        job.progress->job_id = job.id;
+        supersede(project_id, job.id);
+        // The lease thread may have claimed the new row first
+        if (!jobs_.count(job.id)) {
+            queue_.push_back(job);
+            jobs_[job.id].job = job;
+        }
+        latest_by_project_[project_id] = job.id;
+    }
+    // Any worker may take a job without a region; one with a region should wake its own
+    if (job.region != 0) {
+        not_empty_.notify_all();
+    } else {
+        not_empty_.notify_one();
+    }
+
+    spdlog::debug("Queued analysis job {} for project {}", job.id, project_id);
+    return job.id;
+}
+
+size_t AnalysisJobQueue::adoptClaimed(const std::vector<ClaimedAnalysisJob>& claimed) {
+    size_t adopted = 0;
+    for (const auto& row : claimed) {
+        if (jobs_.count(row.id)) continue;
+        if (queue_.size() >= capacity_) break; // the rest stay leased here until there is room
+
+        AnalysisJob job;
+        job.id = row.id;
+        job.project_id = row.project_id;
+        job.priority = row.priority;
+        job.deadline = row.deadline;
+        job.queued_at = row.queued_at;
+        job.organization = row.organization;
+        if (region_key_) job.region = region_key_(job.project_id);
+        job.progress = std::make_shared<AnalysisProgress>();
+        job.progress->job_id = job.id;
+        queue_.push_back(job);
+        jobs_[job.id].job = job;
+        auto& latest = latest_by_project_[job.project_id];
+        latest = std::max(latest, job.id);
+        adopted++;
+    }
+    return adopted;
+}
+
+void AnalysisJobQueue::leaseLoop() {
+    persist("resume", [this]() { store_->resumeOwn(kMaxAttempts); });
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!lease_stop_) {
+        std::vector<std::pair<uint64_t, std::shared_ptr<AnalysisProgress>>> running;
+        std::vector<uint64_t> live;
+        for (const auto& [id, record] : jobs_) {
+            if (record.state == AnalysisJobState::Running && record.job.progress) {
+                running.emplace_back(id, record.job.progress);
+            }
+            if (record.state == AnalysisJobState::Queued || record.state == AnalysisJobState::Running) {
+                live.push_back(id);
+            }
+        }
+        const size_t room = running_ && !workers_.empty() && queue_.size() < capacity_ ? capacity_ - queue_.size() : 0;
+        lock.unlock();
+
+        for (const auto& [id, progress] : running) {
+            persist("progress", [this, id = id, &progress = progress]() { store_->saveProgress(id, *progress); });
+        }
+        persist("lease renewal", [this]() { store_->renew(); });
+        // Superseded through another instance
+        std::vector<uint64_t> cancelled;
+        if (!live.empty()) {
+            persist("cancellation check", [this, &live, &cancelled]() { cancelled = store_->cancelledAmong(live); });
+        }
+        std::vector<ClaimedAnalysisJob> claimed;
+        if (room > 0) {
+            persist("claim", [this, room, &claimed]() { claimed = store_->claim(room, kMaxAttempts, aging()); });
+        }
+
+        lock.lock();
+        for (uint64_t id : cancelled) {
+            auto record = jobs_.find(id);
+            if (record == jobs_.end()) continue;
+            if (record->second.state == AnalysisJobState::Running) {
+                record->second.job.progress->cancelled.store(true, std::memory_order_relaxed);
+            } else if (record->second.state == AnalysisJobState::Queued) {
+                auto queued = std::find_if(queue_.begin(), queue_.end(), [id = id](const AnalysisJob& job) { return job.id == id; });
+                if (queued != queue_.end()) cancelQueued(queued, "Superseded by a newer submission");
+            }
+        }
+        if (!cancelled.empty()) {
+            pruneFinishedJobs();
+        }
+        if (running_ && adoptClaimed(claimed) > 0) {
+            not_empty_.notify_all();
+        }
+        lease_wake_.wait_for(lock, store_->lease() / 3, [this]() { return lease_stop_; });
+    }
+}
+
+void AnalysisJobQueue::supersede(int project_id, uint64_t job_id) {
+    const std::string reason = "Superseded by job " + std::to_string(job_id);
+    for (auto it = queue_.begin(); it != queue_.end();) {
+        it = it->project_id == project_id && it->id != job_id ? cancelQueued(it, reason) : std::next(it);
+    }
+    auto running = running_projects_.find(project_id);
+    if (running != running_projects_.end() && running->second->job_id != job_id && !running->second->isCancelled()) {
+        running->second->cancelled.store(true, std::memory_order_relaxed);
+        spdlog::info("Analysis job {} for project {} asked to stop: {}", running->second->job_id, project_id, reason);
+    }
+    pruneFinishedJobs();
+}
+
+std::deque<AnalysisJob>::iterator AnalysisJobQueue::cancelQueued(std::deque<AnalysisJob>::iterator it,
+                                                                 const std::string& reason) {
+    auto record = jobs_.find(it->id);
+    if (record != jobs_.end()) {
+        record->second.state = AnalysisJobState::Cancelled;
+        record->second.finished_at = std::chrono::system_clock::now();
+        record->second.error = reason;
+        finished_count_++;
+    }
+    spdlog::info("Analysis job {} for project {} cancelled: {}", it->id, it->project_id, reason);
+    return queue_.erase(it);
+}
+
+void AnalysisJobQueue::setRegionKey(RegionKey key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    region_key_ = std::move(key);
+}
+
+void AnalysisJobQueue::setAging(std::chrono::seconds interval) {
+    aging_.store(std::max(interval, std::chrono::seconds(0)), std::memory_order_relaxed);
+}
+
+void AnalysisJobQueue::setOrganizationShares(OrganizationShares shares) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    shares_ = std::move(shares);
+}
+
+std::vector<OrganizationLoad> AnalysisJobQueue::organizationLoads() const {
+    std::map<std::string, OrganizationLoad> loads;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& [name, state] : organizations_) {
+        OrganizationLoad& load = loads[name];
+        load.running = state.running;
+        load.started = state.started;
+    }
+    for (const AnalysisJob& job : queue_) {
+        loads[job.organization].queued++;
+    }
+    std::vector<OrganizationLoad> result;
+    result.reserve(loads.size());
+    for (auto& [name, load] : loads) {
+        load.organization = name;
+        result.push_back(std::move(load));
+    }
+    return result;
+}
+
+bool AnalysisJobQueue::atCap(const std::string& organization) const {
+    const size_t cap = shares_.maxRunningOf(organization);
+    if (cap == 0) {
+        return false;
+    }
+    auto it = organizations_.find(organization);
+    return it != organizations_.end() && it->second.running >= cap;
+}
+
+bool AnalysisJobQueue::preferredBy(const AnalysisJob& job, size_t worker) const {
+    return job.region != 0 && worker_slots_ > 1 && job.region % worker_slots_ == worker;
+}
+
+std::deque<AnalysisJob>::iterator AnalysisJobQueue::nextJob(size_t worker) {
+    const auto now = std::chrono::system_clock::now();
+    const int64_t aging = aging_.load(std::memory_order_relaxed).count();
+    auto level = [&](const AnalysisJob& job) {
+        int64_t value = static_cast<int64_t>(job.priority);
+        if (aging > 0) {
+            value += std::chrono::duration_cast<std::chrono::seconds>(now - job.queued_at).count() / aging;
+        }
+        return value;
+    };
+    // Whether a runs before b: higher level, then the earlier deadline
+    auto ahead = [](int64_t a_level, const AnalysisJob& a, int64_t b_level, const AnalysisJob& b) {
+        if (a_level != b_level) return a_level > b_level;
+        return a.deadline && (!b.deadline || *a.deadline < *b.deadline);
+    };
+
+    // Virtual time of the organization's next job
+    auto start_time = [this](const AnalysisJob& job) {
+        auto it = organizations_.find(job.organization);
+        return it != organizations_.end() ? std::max(it->second.finish, virtual_clock_) : virtual_clock_;
+    };
+    auto eligible = [&](const AnalysisJob& job) {
+        if (running_projects_.count(job.project_id)) {
+            return false; // waits for the superseded run to return
+        }
+        if (job.region != 0 && worker_slots_ > 1 && !preferredBy(job, worker) && idle_[job.region % worker_slots_]) {
+            return false; // its own worker is free to take it
+        }
+        return !atCap(job.organization);
+    };
+
+    // Bounded by the capacity, so a scan is cheaper than keeping a heap whose keys change with time
+    auto best = queue_.end();
+    int64_t best_level = 0;
+    for (auto it = queue_.begin(); it != queue_.end(); ++it) {
+        if (!eligible(*it)) continue;
+        const int64_t candidate = level(*it);
+        if (best == queue_.end() || ahead(candidate, *it, best_level, *best)) {
+            best = it;
+            best_level = candidate;
+        }
+    }
+    if (best == queue_.end()) {
+        return best;
+    }
+
+    // Organizations take turns among the jobs level with the first in line or
+    // of its priority, so one that queued earlier does not pass others by aging
+    auto contends = [&](const AnalysisJob& job, int64_t job_level) {
+        return job_level == best_level || job.priority == best->priority;
+    };
+    auto chosen = best;
+    int64_t chosen_level = best_level;
+    double chosen_time = start_time(*best);
+    for (auto it = queue_.begin(); it != queue_.end(); ++it) {
+        if (it == best || !eligible(*it)) continue;
+        const int64_t candidate = level(*it);
+        if (!contends(*it, candidate)) continue;
+        const double time = start_time(*it);
+        if (time < chosen_time || (time == chosen_time && ahead(candidate, *it, chosen_level, *chosen))) {
+            chosen = it;
+            chosen_level = candidate;
+            chosen_time = time;
+        }
+    }
+
+    // Within that organization, the region's job only replaces one that merely queued earlier
+    auto own = queue_.end();
+    int64_t own_level = 0;
+    for (auto it = queue_.begin(); it != queue_.end(); ++it) {
+        if (!preferredBy(*it, worker) || it->organization != chosen->organization || !eligible(*it)) continue;
+        const int64_t candidate = level(*it);
+        if (!contends(*it, candidate)) continue;
+        if (own == queue_.end() || ahead(candidate, *it, own_level, *own)) {
+            own = it;
+            own_level = candidate;
+        }
+    }
+    if (own != queue_.end() && !ahead(chosen_level, *chosen, own_level, *own)) {
+        return own;
+    }
+    return chosen;
+}
+
+void AnalysisJobQueue::persist(const char* what, const std::function<void()>& write) {
+    try {
+        write();
+    } catch (const std::exception& e) {
+        spdlog::error("Analysis job store {} failed: {}", what, e.what());
+    }
+}
+
+AnalysisJobStatus AnalysisJobQueue::snapshot(const JobRecord& record) const {
+    AnalysisJobStatus status;
+    status.id = record.job.id;
+    status.project_id = record.job.project_id;
+    status.priority = record.job.priority;
+    status.state = record.state;
+    status.queued_at = record.job.queued_at;
+    status.started_at = record.started_at;
+    status.finished_at = record.finished_at;
+    status.error = record.error;
+    if (record.job.progress) {
+        status.protections_total = record.job.progress->protections_total.load(std::memory_order_relaxed);
+        status.protections_scanned = record.job.progress->protections_scanned.load(std::memory_order_relaxed);
+        status.conflicts_found = record.job.progress->conflicts_found.load(std::memory_order_relaxed);
+        status.profile = record.job.progress->profile;
+    }
+    return status;
+}
+
+std::optional<AnalysisJobStatus> AnalysisJobQueue::getJob(uint64_t job_id) const {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = jobs_.find(job_id);
+        if (it != jobs_.end()) {
+            return snapshot(it->second);
+        }
+    }
+    // Queued by another instance, or before a restart
+    if (store_) {
+        try {
+            return store_->find(job_id);
+        } catch (const std::exception& e) {
+            spdlog::error("Failed to read analysis job {}: {}", job_id, e.what());
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<AnalysisJobStatus> AnalysisJobQueue::getLatestJobForProject(int project_id) const {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto latest = latest_by_project_.find(project_id);
+        if (latest != latest_by_project_.end()) {
+            auto it = jobs_.find(latest->second);
+            if (it != jobs_.end()) {
+                return snapshot(it->second);
+            }
+        }
+    }
+    if (store_) {
+        try {
+            return store_->findLatestForProject(project_id);
+        } catch (const std::exception& e) {
+            spdlog::error("Failed to read the analysis jobs of project {}: {}", project_id, e.what());
+        }
+    }
+    return std::nullopt;
+}
+
+bool AnalysisJobQueue::full() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queue_.size() >= capacity_;
+}
+
+size_t AnalysisJobQueue::depth() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queue_.size();
+}
+
+void AnalysisJobQueue::finishJob(uint64_t job_id, AnalysisJobState state, std::optional<std::string> error) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = jobs_.find(job_id);
+        if (it == jobs_.end()) {
+            return;
+        }
+        auto running = running_projects_.find(it->second.job.project_id);
+        if (running != running_projects_.end() && running->second == it->second.job.progress) {
+            running_projects_.erase(running);
+        }
+        if (it->second.state == AnalysisJobState::Running) {
+            auto organization = organizations_.find(it->second.job.organization);
+            if (organization != organizations_.end() && organization->second.running > 0) {
+                organization->second.running--;
+            }
+        }
+        it->second.state = state;
+        it->second.finished_at = std::chrono::system_clock::now();
+        it->second.error = std::move(error);
+        finished_count_++;
+        pruneFinishedJobs();
+    }
+    // A newer job of the project may have been waiting for this one
+    not_empty_.notify_all();
+}
+
+// Called with mutex_ held. Drops the oldest finished jobs beyond the retention limit.
+void AnalysisJobQueue::pruneFinishedJobs() {
+    for (auto it = jobs_.begin(); it != jobs_.end() && finished_count_ > kMaxFinishedJobs;) {
+        const AnalysisJobState state = it->second.state;
+        if (state == AnalysisJobState::Completed || state == AnalysisJobState::Failed ||
+            state == AnalysisJobState::Cancelled) {
+            auto latest = latest_by_project_.find(it->second.job.project_id);
+            if (latest != latest_by_project_.end() && latest->second == it->first) {
+                latest_by_project_.erase(latest);
+            }
+            it = jobs_.erase(it);
+            finished_count_--;
+        } else {
+            ++it;
+        }
+    }
+}
+
+void AnalysisJobQueue::workerLoop(size_t worker) {
+    while (true) {
+        AnalysisJob job;
+        bool steal = false;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            auto next = queue_.end();
+            idle_[worker] = 1;
+            not_empty_.wait(lock, [this, &next, worker]() {
+                next = nextJob(worker);
+                return next != queue_.end() || (!running_ && queue_.empty());
+            });
+            idle_[worker] = 0;
+            if (next == queue_.end()) {
+                return; // stopped and drained
+            }
+            if (next->region != 0 && worker_slots_ > 1) {
+                (preferredBy(*next, worker) ? started_local_ : started_elsewhere_).fetch_add(1, std::memory_order_relaxed);
+            }
+            job = std::move(*next);
+            queue_.erase(next);
+            running_projects_[job.project_id] = job.progress;
+            {
+                OrganizationState& organization = organizations_[job.organization];
+                virtual_clock_ = std::max(organization.finish, virtual_clock_);
+                organization.finish = virtual_clock_ + 1.0 / shares_.weightOf(job.organization);
+                organization.running++;
+                organization.started++;
+            }
+            // Jobs left to this worker while it was idle are anyone's now
+            steal = region_key_ && !queue_.empty();
+
+            auto it = jobs_.find(job.id);
+            if (it != jobs_.end()) {
+                it->second.state = AnalysisJobState::Running;
+                it->second.started_at = std::chrono::system_clock::now();
+            }
+        }
+        if (steal) {
+            not_empty_.notify_all();
+        }
+
+        // A job queued outside a request starts a trace of its own, with the job span as root
+        TraceContext trace = job.trace;
+        if (!trace.valid()) {
+            uint64_t no_parent = 0;
+            trace = Tracer::getInstance().startTrace("", no_parent);
+            trace.span_id = 0;
+        }
+        if (store_) {
+            persist("start", [this, &job]() { store_->markRunning(job.id); });
+        }
+        TraceScope trace_scope(trace);
+        Span span("analysis.job");
+        span.setAttribute("job.id", static_cast<int64_t>(job.id));
+        span.setAttribute("project.id", static_cast<int64_t>(job.project_id));
+
+        const auto started = std::chrono::steady_clock::now();
+        try {
+            handler_(job);
+            Metrics::getInstance().analysisJobFinished(false, std::chrono::steady_clock::now() - started);
+            if (job.progress->isCancelled()) {
+                finishJob(job.id, AnalysisJobState::Cancelled, std::string("Superseded by a newer submission"));
+            } else {
+                finishJob(job.id, AnalysisJobState::Completed, std::nullopt);
+            }
+        } catch (const std::exception& e) {
+            Metrics::getInstance().analysisJobFinished(true, std::chrono::steady_clock::now() - started);
+            span.setError(e.what());
+            spdlog::error("Analysis job {} for project {} failed: {}", job.id, job.project_id, e.what());
+            finishJob(job.id, AnalysisJobState::Failed, std::string(e.what()));
+        }
+        if (store_) {
+            if (auto status = getJob(job.id)) {
+                persist("finish", [this, &job, &status]() {
+                    store_->saveProgress(job.id, *job.progress);
+                    store_->finish(job.id, status->state, status->error);
+                });
+            }
+        }
+    }
+}
+
+} // namespace aeronautical
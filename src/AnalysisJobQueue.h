@@ -0,0 +1,282 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <json.hpp>
+#include "Tracing.h"
+#include "Project.h"
+#include "CpuAffinity.h"
+
+namespace aeronautical {
+
+enum class AnalysisJobState {
+    Queued,
+    Running,
+    Completed,
+    Failed,
+    Cancelled // superseded by a newer submission of the project
+};
+
+std::string analysisJobStateToString(AnalysisJobState state);
+
+class AnalysisProfile;
+
+// Live counters written by the analysis and read by the status API, and
+// the job's cancellation token: the analysis checks it between zone
+// evaluations and stops without storing anything once it is set
+struct AnalysisProgress {
+    AnalysisProgress();
+
+    uint64_t job_id = 0;
+    std::atomic<size_t> protections_total{0};
+    std::atomic<size_t> protections_scanned{0};
+    std::atomic<size_t> conflicts_found{0};
+    std::atomic<bool> cancelled{false};
+    // Where the run spends its time, for ?explain=true on the job status
+    const std::shared_ptr<AnalysisProfile> profile;
+
+    bool isCancelled() const { return cancelled.load(std::memory_order_relaxed); }
+};
+
+struct AnalysisJob {
+    uint64_t id = 0;
+    int project_id = 0;
+    ProjectPriority priority = ProjectPriority::Normal;
+    std::optional<std::chrono::system_clock::time_point> deadline; // the project's review deadline
+    std::chrono::system_clock::time_point queued_at;
+    std::shared_ptr<AnalysisProgress> progress;
+    TraceContext trace; // of the request that queued it, if any
+    uint64_t region = 0; // locality key (see setRegionKey), 0 for none
+    std::string organization; // the project's demander organization, "" for none
+};
+
+// Point-in-time copy of a job's record, safe to serialize
+struct AnalysisJobStatus {
+    uint64_t id = 0;
+    int project_id = 0;
+    ProjectPriority priority = ProjectPriority::Normal;
+    AnalysisJobState state = AnalysisJobState::Queued;
+    std::chrono::system_clock::time_point queued_at;
+    std::optional<std::chrono::system_clock::time_point> started_at;
+    std::optional<std::chrono::system_clock::time_point> finished_at;
+    size_t protections_total = 0;
+    size_t protections_scanned = 0;
+    size_t conflicts_found = 0;
+    std::optional<std::string> error;
+    // Only for jobs run by this instance
+    std::shared_ptr<const AnalysisProfile> profile;
+
+    nlohmann::json toJson() const;
+};
+
+// How the analysis capacity is shared between demander organizations
+struct OrganizationShares {
+    double default_weight = 1;
+    std::unordered_map<std::string, double> weights;
+    size_t default_max_running = 0; // jobs running at once; 0: no cap
+    std::unordered_map<std::string, size_t> max_running;
+
+    double weightOf(const std::string& organization) const;
+    size_t maxRunningOf(const std::string& organization) const;
+
+    // "name=value;name=value"; entries without a name or number are skipped
+    static std::unordered_map<std::string, double> parseList(const std::string& text);
+};
+
+// Jobs of one organization at this instance
+struct OrganizationLoad {
+    std::string organization;
+    size_t queued = 0;
+    size_t running = 0;
+    uint64_t started = 0;
+};
+
+class AnalysisJobStore;
+struct ClaimedAnalysisJob;
+
+// Bounded queue of project analysis jobs served by dedicated worker threads.
+// Submitting never waits for the analysis; a full queue is reported to the
+// caller so it can answer 429 instead of piling up work. Every job is also
+// tracked in an in-memory table so status polls never reach MySQL.
+//
+// Workers take the job of highest project priority first, the earliest
+// review deadline among equals, then the oldest. A job gains one priority
+// level per aging interval spent waiting, so a steady stream of urgent work
+// delays low-priority jobs but never starves them.
+//
+// Among the jobs level with the first in line, or of its priority, workers
+// take turns between demander organizations by weighted fair queuing: each
+// organization has a virtual time that every job it starts moves on by one
+// over its weight, and the organization furthest behind goes next. One
+// returning after a quiet spell starts from the current virtual time, so
+// idling earns it no credit. A batch of hundreds of projects from one
+// organization thus takes its weight's share of the workers while others
+// have work queued, and all of them when nobody else has. An organization
+// with max_running jobs running starts no more until one finishes. With a
+// store, fairness holds among the jobs this instance has claimed.
+//
+// With a region key, jobs of one region (projects near the same airports)
+// prefer one worker: among the jobs a worker could take with nothing
+// ahead of them by priority or deadline, it takes its own region's first,
+// so nearby projects run back to back on the thread whose caches and
+// arena already hold their zones' index nodes and prepared geometries.
+// A job waiting for its idle worker is left to it; once that worker is
+// busy, any idle one takes the job rather than leave it queued.
+//
+// A project has at most one live job: a new submission cancels the queued
+// job of the same project and signals the running one to stop, and the new
+// job does not start before the old one has returned.
+//
+// With a store (persistTo) every job is also a row of analysis_jobs, and its
+// id is the row's: a lease thread renews this process's leases, saves the
+// progress of running jobs and claims jobs other instances gave up, so
+// work survives restarts and spreads over every instance. Status of a job
+// this process does not know is read from the store. Started with no
+// workers, the queue only writes jobs for dedicated analysis workers
+// (aeronautical_backend --worker) to claim.
+class AnalysisJobQueue {
+public:
+    using Handler = std::function<void(const AnalysisJob&)>;
+
+    static AnalysisJobQueue& getInstance();
+
+    AnalysisJobQueue(const AnalysisJobQueue&) = delete;
+    AnalysisJobQueue& operator=(const AnalysisJobQueue&) = delete;
+
+    // Before start(): keep jobs in store from now on
+    void persistTo(std::unique_ptr<AnalysisJobStore> store);
+    bool persistent() const { return store_ != nullptr; }
+
+    // Workers are pinned to cpus when it is not empty. Zero workers is
+    // only honoured with a store, else one is started.
+    void start(size_t workers, size_t capacity, Handler handler, CpuSet cpus = {});
+    // Stops accepting jobs, lets workers finish the queue, and joins them
+    void shutdown();
+    // Stops accepting jobs and takes out the ones not started yet, so a
+    // following shutdown() only waits for running analyses. Returns the
+    // project ids taken out, in queue order; persisted jobs are released to
+    // the store instead and not returned.
+    std::vector<int> drain();
+
+    // Project ids left queued by a drain, kept across a restart; writing
+    // an empty list removes the file. Resuming enqueues them and removes it.
+    static bool writeCheckpoint(const std::string& path, const std::vector<int>& project_ids);
+    size_t resumeCheckpoint(const std::string& path);
+
+    // Returns the job id, or std::nullopt when the queue is full or stopped
+    std::optional<uint64_t> enqueue(int project_id, ProjectPriority priority = ProjectPriority::Normal,
+                                    std::optional<std::chrono::system_clock::time_point> deadline = std::nullopt,
+                                    const std::string& organization = "");
+
+    void setOrganizationShares(OrganizationShares shares);
+    // Every organization with a job queued, running or started, by name
+    std::vector<OrganizationLoad> organizationLoads() const;
+
+    // Locality key of a project's jobs, 0 for none; set before start().
+    // It may be called with the queue locked, so must not call back into it.
+    using RegionKey = std::function<uint64_t(int project_id)>;
+    void setRegionKey(RegionKey key);
+    // Jobs started by their region's worker, and by another one
+    uint64_t startedLocal() const { return started_local_.load(std::memory_order_relaxed); }
+    uint64_t startedElsewhere() const { return started_elsewhere_.load(std::memory_order_relaxed); }
+
+    // Waiting time worth one priority level; zero turns aging off
+    void setAging(std::chrono::seconds interval);
+    std::chrono::seconds aging() const { return aging_.load(std::memory_order_relaxed); }
+
+    std::optional<AnalysisJobStatus> getJob(uint64_t job_id) const;
+    // Most recent job submitted for the project
+    std::optional<AnalysisJobStatus> getLatestJobForProject(int project_id) const;
+
+    bool full() const;
+    size_t depth() const;
+    size_t capacity() const { return capacity_; }
+    size_t workerCount() const { return workers_.size(); }
+
+private:
+    struct JobRecord {
+        AnalysisJob job;
+        AnalysisJobState state = AnalysisJobState::Queued;
+        std::optional<std::chrono::system_clock::time_point> started_at;
+        std::optional<std::chrono::system_clock::time_point> finished_at;
+        std::optional<std::string> error;
+    };
+
+    AnalysisJobQueue() = default;
+    ~AnalysisJobQueue();
+
+    void workerLoop(size_t worker);
+    // Position in queue_ of the job the worker runs next, end() when every
+    // queued project still has a job running; caller holds mutex_
+    std::deque<AnalysisJob>::iterator nextJob(size_t worker);
+    // Whether the job's region belongs to the worker
+    bool preferredBy(const AnalysisJob& job, size_t worker) const;
+    // Cancels the other jobs of the project in favour of job_id; caller holds mutex_
+    void supersede(int project_id, uint64_t job_id);
+    // Takes a queued job out as cancelled; caller holds mutex_. Returns the next position
+    std::deque<AnalysisJob>::iterator cancelQueued(std::deque<AnalysisJob>::iterator it, const std::string& reason);
+    void leaseLoop();
+    // Queues the store's jobs not known here yet; caller holds mutex_
+    size_t adoptClaimed(const std::vector<ClaimedAnalysisJob>& claimed);
+    // Store writes never fail a job; errors are logged
+    void persist(const char* what, const std::function<void()>& write);
+    void finishJob(uint64_t job_id, AnalysisJobState state, std::optional<std::string> error);
+    void pruneFinishedJobs();
+    // Whether the organization has as many jobs running as it may; caller holds mutex_
+    bool atCap(const std::string& organization) const;
+    AnalysisJobStatus snapshot(const JobRecord& record) const;
+
+    // Finished jobs kept for status queries before the oldest are dropped
+    static constexpr size_t kMaxFinishedJobs = 1000;
+    // Takeovers of a job before it is failed rather than run again
+    static constexpr int kMaxAttempts = 3;
+
+    mutable std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::deque<AnalysisJob> queue_; // in submission order; nextJob() picks by priority
+    std::atomic<std::chrono::seconds> aging_{std::chrono::minutes(5)};
+    std::vector<std::thread> workers_;
+    Handler handler_;
+    size_t capacity_ = 0;
+    size_t worker_slots_ = 0; // workers started, for region placement
+    std::vector<char> idle_;  // by worker, while it waits for a job
+    RegionKey region_key_;
+    std::atomic<uint64_t> started_local_{0};
+    std::atomic<uint64_t> started_elsewhere_{0};
+
+    struct OrganizationState {
+        double finish = 0; // virtual time its next job starts at, unless the clock is past it
+        size_t running = 0;
+        uint64_t started = 0;
+    };
+    OrganizationShares shares_;
+    std::unordered_map<std::string, OrganizationState> organizations_;
+    double virtual_clock_ = 0; // start time of the last job started
+
+    uint64_t next_id_ = 1;
+    bool running_ = false;
+
+    std::map<uint64_t, JobRecord> jobs_; // ordered by id, i.e. by submission
+    std::unordered_map<int, uint64_t> latest_by_project_;
+    std::unordered_map<int, std::shared_ptr<AnalysisProgress>> running_projects_; // project id -> running job
+    size_t finished_count_ = 0;
+
+    std::unique_ptr<AnalysisJobStore> store_;
+    std::thread lease_thread_;
+    std::condition_variable lease_wake_;
+    bool lease_stop_ = false;
+};
+
+} // namespace aeronautical
@@ -0,0 +1,226 @@
+#include "AnalysisJobStore.h"
+#include "DatabaseManager.h"
+#include "SchemaMigrations.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cstdlib>
+#include <mutex>
+
+namespace aeronautical {
+
+namespace {
+
+constexpr const char* kStatusColumns =
+    "SELECT id, project_id, state, queued_at, started_at, finished_at, protections_total, "
+    "protections_scanned, conflicts_found, error, priority FROM analysis_jobs ";
+
+AnalysisJobState stateFromString(const std::string& state) {
+    if (state == "running") return AnalysisJobState::Running;
+    if (state == "completed") return AnalysisJobState::Completed;
+    if (state == "failed") return AnalysisJobState::Failed;
+    if (state == "cancelled") return AnalysisJobState::Cancelled;
+    return AnalysisJobState::Queued;
+}
+
+ProjectPriority priorityFromLevel(int64_t level) {
+    return static_cast<ProjectPriority>(std::clamp<int64_t>(level, static_cast<int64_t>(ProjectPriority::Low),
+                                                            static_cast<int64_t>(ProjectPriority::Critical)));
+}
+
+} // namespace
+
+AnalysisJobStore::AnalysisJobStore(std::string owner, std::chrono::seconds lease)
+    : owner_(std::move(owner)),
+      lease_(std::max(lease, std::chrono::seconds(3))),
+      lease_expiry_("NOW(3) + INTERVAL " + std::to_string(lease_.count()) + " SECOND") {}
+
+bool AnalysisJobStore::probeTable() {
+    static std::once_flag once;
+    static bool available = false;
+
+    std::call_once(once, []() {
+        available = SchemaMigrations::hasTable("analysis_jobs");
+        spdlog::info("Analysis jobs {}", available ? "persisted in analysis_jobs" : "kept in memory only");
+    });
+
+    return available;
+}
+
+uint64_t AnalysisJobStore::insert(const AnalysisJob& job, bool owned) {
+    auto result = DatabaseManager::getInstance().executePrepared(
+        "INSERT INTO analysis_jobs (project_id, priority, review_deadline, state, owner, lease_expires_at, queued_at) "
+        "VALUES (?, ?, ?, 'queued', ?, " + (owned ? lease_expiry_ : std::string("NULL")) + ", NOW(3))",
+        {static_cast<int64_t>(job.project_id), static_cast<int64_t>(job.priority),
+         job.deadline ? SqlParam(timePointToString(*job.deadline)) : SqlParam(nullptr),
+         owned ? SqlParam(owner_) : SqlParam(nullptr)});
+    return result.insert_id;
+}
+
+void AnalysisJobStore::markRunning(uint64_t job_id) {
+    DatabaseManager::getInstance().executePrepared(
+        "UPDATE analysis_jobs SET state = 'running', started_at = NOW(3), attempts = attempts + 1, "
+        "lease_expires_at = " + lease_expiry_ + " WHERE id = ? AND owner = ?",
+        {static_cast<int64_t>(job_id), owner_});
+}
+
+void AnalysisJobStore::finish(uint64_t job_id, AnalysisJobState state, const std::optional<std::string>& error) {
+    DatabaseManager::getInstance().executePrepared(
+        "UPDATE analysis_jobs SET state = ?, owner = NULL, lease_expires_at = NULL, finished_at = NOW(3), "
+        "error = ? WHERE id = ?",
+        {analysisJobStateToString(state), error ? SqlParam(*error) : SqlParam(nullptr), static_cast<int64_t>(job_id)});
+}
+
+void AnalysisJobStore::renew() {
+    DatabaseManager::getInstance().executePrepared(
+        "UPDATE analysis_jobs SET lease_expires_at = " + lease_expiry_ +
+        " WHERE owner = ? AND state IN ('queued', 'running')",
+        {owner_});
+}
+
+void AnalysisJobStore::saveProgress(uint64_t job_id, const AnalysisProgress& progress) {
+    DatabaseManager::getInstance().executePrepared(
+        "UPDATE analysis_jobs SET protections_total = ?, protections_scanned = ?, conflicts_found = ? WHERE id = ?",
+        {static_cast<int64_t>(progress.protections_total.load(std::memory_order_relaxed)),
+         static_cast<int64_t>(progress.protections_scanned.load(std::memory_order_relaxed)),
+         static_cast<int64_t>(progress.conflicts_found.load(std::memory_order_relaxed)),
+         static_cast<int64_t>(job_id)});
+}
+
+void AnalysisJobStore::release() {
+    auto result = DatabaseManager::getInstance().executePrepared(
+        "UPDATE analysis_jobs SET owner = NULL, lease_expires_at = NULL WHERE owner = ? AND state = 'queued'",
+        {owner_});
+    if (result.affected_rows > 0) {
+        spdlog::info("Released {} queued analysis jobs for other instances", result.affected_rows);
+    }
+}
+
+void AnalysisJobStore::supersede(int project_id, uint64_t job_id) {
+    auto result = DatabaseManager::getInstance().executePrepared(
+        "UPDATE analysis_jobs SET state = 'cancelled', owner = NULL, lease_expires_at = NULL, finished_at = NOW(3), "
+        "error = ? WHERE project_id = ? AND id < ? AND state IN ('queued', 'running')",
+        {"Superseded by job " + std::to_string(job_id), static_cast<int64_t>(project_id), static_cast<int64_t>(job_id)});
+    if (result.affected_rows > 0) {
+        spdlog::info("{} stored analysis jobs of project {} superseded by job {}", result.affected_rows, project_id, job_id);
+    }
+}
+
+std::vector<uint64_t> AnalysisJobStore::cancelledAmong(const std::vector<uint64_t>& job_ids) {
+    std::vector<uint64_t> cancelled;
+    if (job_ids.empty()) {
+        return cancelled;
+    }
+    // Ids are numbers, written inline; the list is bounded by the queue capacity
+    std::string query = "SELECT id FROM analysis_jobs WHERE state = 'cancelled' AND id IN (";
+    for (size_t i = 0; i < job_ids.size(); i++) {
+        if (i > 0) query += ",";
+        query += std::to_string(job_ids[i]);
+    }
+    query += ")";
+    MysqlResult result = DatabaseManager::getInstance().executeSelectQuery(query);
+    if (!result) {
+        throw std::runtime_error("failed to read cancelled analysis jobs");
+    }
+    MYSQL_ROW row;
+    while ((row = mysql_fetch_row(result.get()))) {
+        if (row[0]) cancelled.push_back(std::strtoull(row[0], nullptr, 10));
+    }
+    return cancelled;
+}
+
+void AnalysisJobStore::resumeOwn(int max_attempts) {
+    auto& db = DatabaseManager::getInstance();
+    db.executePrepared(
+        "UPDATE analysis_jobs SET state = 'failed', owner = NULL, lease_expires_at = NULL, finished_at = NOW(3), "
+        "error = 'Analysis did not finish after repeated attempts' "
+        "WHERE owner = ? AND state = 'running' AND attempts >= ?",
+        {owner_, static_cast<int64_t>(max_attempts)});
+    auto resumed = db.executePrepared(
+        "UPDATE analysis_jobs SET state = 'queued', lease_expires_at = " + lease_expiry_ +
+        " WHERE owner = ? AND state = 'running'",
+        {owner_});
+    if (resumed.affected_rows > 0) {
+        spdlog::info("{} analysis jobs interrupted by the last shutdown queued again", resumed.affected_rows);
+    }
+}
+
+std::vector<ClaimedAnalysisJob> AnalysisJobStore::claim(size_t limit, int max_attempts, std::chrono::seconds aging) {
+    auto& db = DatabaseManager::getInstance();
+
+    // A job that keeps taking its runner down is not handed out again
+    auto abandoned = db.executePrepared(
+        "UPDATE analysis_jobs SET state = 'failed', owner = NULL, lease_expires_at = NULL, finished_at = NOW(3), "
+        "error = 'Analysis did not finish after repeated attempts' "
+        "WHERE state = 'running' AND lease_expires_at < NOW(3) AND attempts >= ?",
+        {static_cast<int64_t>(max_attempts)});
+    if (abandoned.affected_rows > 0) {
+        spdlog::warn("{} analysis jobs failed after {} attempts", abandoned.affected_rows, max_attempts);
+    }
+
+    if (limit > 0) {
+        // Row locks make the takeover atomic: two instances never claim the same job.
+        // A running job whose lease ran out goes back to queued for its new owner.
+        const std::string level =
+            aging.count() > 0
+                ? "priority + TIMESTAMPDIFF(SECOND, queued_at, NOW(3)) DIV " + std::to_string(aging.count())
+                : std::string("priority");
+        auto taken = db.executePrepared(
+            "UPDATE analysis_jobs SET owner = ?, state = 'queued', lease_expires_at = " + lease_expiry_ +
+            " WHERE state IN ('queued', 'running') AND (owner IS NULL OR lease_expires_at < NOW(3)) "
+            "ORDER BY " + level + " DESC, review_deadline IS NULL, review_deadline, id LIMIT ?",
+            {owner_, static_cast<int64_t>(limit)});
+        if (taken.affected_rows > 0) {
+            spdlog::info("Claimed {} analysis jobs as {}", taken.affected_rows, owner_);
+        }
+    }
+
+    auto owned = db.executePrepared(
+        "SELECT j.id, j.project_id, j.queued_at, j.priority, j.review_deadline, p.demander_organization "
+        "FROM analysis_jobs j LEFT JOIN projects p ON p.id = j.project_id "
+        "WHERE j.owner = ? AND j.state = 'queued' ORDER BY j.id",
+        {owner_});
+    std::vector<ClaimedAnalysisJob> jobs;
+    jobs.reserve(owned.rows.size());
+    for (const auto& row : owned.rows) {
+        ClaimedAnalysisJob job;
+        job.id = static_cast<uint64_t>(row.getInt(0));
+        job.project_id = static_cast<int>(row.getInt(1));
+        job.queued_at = row.getTimePoint(2).value_or(std::chrono::system_clock::now());
+        job.priority = priorityFromLevel(row.getInt(3, static_cast<int64_t>(ProjectPriority::Normal)));
+        job.deadline = row.getTimePoint(4);
+        job.organization = row.getString(5);
+        jobs.push_back(job);
+    }
+    return jobs;
+}
+
+std::optional<AnalysisJobStatus> AnalysisJobStore::find(uint64_t job_id) {
+    return findOne("WHERE id = ?", static_cast<int64_t>(job_id));
+}
+
+std::optional<AnalysisJobStatus> AnalysisJobStore::findLatestForProject(int project_id) {
+    return findOne("WHERE project_id = ? ORDER BY id DESC LIMIT 1", project_id);
+}
+
+std::optional<AnalysisJobStatus> AnalysisJobStore::findOne(const std::string& where, int64_t key) {
+    auto result = DatabaseManager::getInstance().executePrepared(kStatusColumns + where, {key});
+    if (result.rows.empty()) {
+        return std::nullopt;
+    }
+    const auto& row = result.rows.front();
+    AnalysisJobStatus status;
+    status.id = static_cast<uint64_t>(row.getInt(0));
+    status.project_id = static_cast<int>(row.getInt(1));
+    status.state = stateFromString(row.getString(2));
+    status.queued_at = row.getTimePoint(3).value_or(std::chrono::system_clock::time_point{});
+    status.started_at = row.getTimePoint(4);
+    status.finished_at = row.getTimePoint(5);
+    status.protections_total = static_cast<size_t>(row.getInt(6));
+    status.protections_scanned = static_cast<size_t>(row.getInt(7));
+    status.conflicts_found = static_cast<size_t>(row.getInt(8));
+    status.error = row.getOptionalString(9);
+    status.priority = priorityFromLevel(row.getInt(10, static_cast<int64_t>(ProjectPriority::Normal)));
+    return status;
+}
+
+} // namespace aeronautical
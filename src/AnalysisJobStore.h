@@ -0,0 +1,99 @@
+#pragma once
+
+#include "AnalysisJobQueue.h"
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace aeronautical {
+
+// A job row this process now owns and should run
+struct ClaimedAnalysisJob {
+    uint64_t id = 0;
+    int project_id = 0;
+    ProjectPriority priority = ProjectPriority::Normal;
+    std::optional<std::chrono::system_clock::time_point> deadline;
+    std::chrono::system_clock::time_point queued_at;
+    std::string organization; // the project's demander organization, "" for none
+};
+
+// Analysis jobs kept in MySQL so they outlive the process and can be run by
+// any backend instance sharing the database. Used when the table exists:
+//
+//   CREATE TABLE analysis_jobs (
+//     id BIGINT UNSIGNED AUTO_INCREMENT PRIMARY KEY,
+//     project_id INT NOT NULL,
+//     priority TINYINT NOT NULL DEFAULT 1,        -- ProjectPriority, Low = 0
+//     review_deadline DATETIME(3) NULL,
+//     state ENUM('queued','running','completed','failed','cancelled') NOT NULL DEFAULT 'queued',
+//     owner VARCHAR(64) NULL,
+//     lease_expires_at DATETIME(3) NULL,
+//     attempts INT NOT NULL DEFAULT 0,
+//     queued_at DATETIME(3) NOT NULL,
+//     started_at DATETIME(3) NULL,
+//     finished_at DATETIME(3) NULL,
+//     protections_total INT NOT NULL DEFAULT 0,
+//     protections_scanned INT NOT NULL DEFAULT 0,
+//     conflicts_found INT NOT NULL DEFAULT 0,
+//     error TEXT NULL,
+//     KEY idx_analysis_jobs_lease (state, lease_expires_at),
+//     KEY idx_analysis_jobs_project (project_id, id)
+//   );
+//
+// Every queued or running job has an owner holding a lease on it, renewed
+// while the owner is alive. Once a lease runs out - the owner crashed, hung
+// or released its queue on shutdown - the next instance to claim takes the
+// job over. Lease times use the database clock, so instance clocks need not
+// agree.
+class AnalysisJobStore {
+public:
+    // owner names this process and must be stable across its restarts, so
+    // a restarted instance resumes its own jobs without waiting for a lease
+    AnalysisJobStore(std::string owner, std::chrono::seconds lease);
+
+    // Checks once whether the analysis_jobs table exists
+    static bool probeTable();
+
+    const std::string& owner() const { return owner_; }
+    std::chrono::seconds lease() const { return lease_; }
+
+    // New queued row for job (project, priority and deadline), owned by this
+    // process or left for any instance to claim; throws SqlError on failure
+    uint64_t insert(const AnalysisJob& job, bool owned = true);
+    void markRunning(uint64_t job_id);
+    void finish(uint64_t job_id, AnalysisJobState state, const std::optional<std::string>& error);
+    // Extends the lease of every job this process owns
+    void renew();
+    void saveProgress(uint64_t job_id, const AnalysisProgress& progress);
+    // Hands this process's queued jobs back for any instance to claim
+    void release();
+    // Cancels the project's jobs older than job_id, whoever runs them
+    void supersede(int project_id, uint64_t job_id);
+    // Those of job_ids cancelled since, e.g. superseded through another instance
+    std::vector<uint64_t> cancelledAmong(const std::vector<uint64_t>& job_ids);
+
+    // At start: jobs this owner was running when it went down are queued
+    // again at once (failed instead past max_attempts)
+    void resumeOwn(int max_attempts);
+    // Takes over up to limit jobs whose lease ran out (or that this owner
+    // left behind before a restart) and returns every queued job this
+    // process owns, oldest first. Jobs are taken in the queue's order:
+    // priority raised one level per aging interval waited, then deadline.
+    // Jobs taken over max_attempts times without finishing are failed
+    // instead.
+    std::vector<ClaimedAnalysisJob> claim(size_t limit, int max_attempts, std::chrono::seconds aging);
+
+    std::optional<AnalysisJobStatus> find(uint64_t job_id);
+    std::optional<AnalysisJobStatus> findLatestForProject(int project_id);
+
+private:
+    std::optional<AnalysisJobStatus> findOne(const std::string& where, int64_t key);
+
+    std::string owner_;
+    std::chrono::seconds lease_;
+    std::string lease_expiry_; // SQL expression for a lease taken now
+};
+
+} // namespace aeronautical
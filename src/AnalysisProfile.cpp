@@ -0,0 +1,126 @@
+#include "AnalysisProfile.h"
+#include <algorithm>
+
+namespace aeronautical {
+
+namespace {
+
+double milliseconds(std::chrono::nanoseconds elapsed) {
+    return std::chrono::duration<double, std::milli>(elapsed).count();
+}
+
+// Adds to the named entry, keeping first-seen order
+template <typename T>
+void accumulate(std::vector<std::pair<std::string, T>>& entries, const std::string& name, T value) {
+    auto it = std::find_if(entries.begin(), entries.end(), [&](const auto& entry) { return entry.first == name; });
+    if (it == entries.end()) {
+        entries.emplace_back(name, value);
+    } else {
+        it->second += value;
+    }
+}
+
+} // namespace
+
+AnalysisProfile::AnalysisProfile() = default;
+
+void AnalysisProfile::enter(std::string name) {
+    const auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (phases_.empty() && current_.empty()) {
+        started_ = now;
+    }
+    finishLocked(now);
+    current_ = std::move(name);
+    phase_started_ = now;
+}
+
+void AnalysisProfile::finish() {
+    const auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(mutex_);
+    finishLocked(now);
+    finished_ = now;
+}
+
+void AnalysisProfile::finishLocked(std::chrono::steady_clock::time_point now) {
+    if (!current_.empty()) {
+        accumulate(phases_, current_, std::chrono::nanoseconds(now - phase_started_));
+        current_.clear();
+    }
+}
+
+void AnalysisProfile::addWork(const std::string& name, std::chrono::nanoseconds elapsed) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    accumulate(work_, name, elapsed);
+}
+
+void AnalysisProfile::addWork(const ZoneEvaluator::Timing& timing) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    accumulate(work_, std::string("predicate"), timing.predicate);
+    accumulate(work_, std::string("intersection"), timing.intersection);
+    accumulate(work_, std::string("export"), timing.export_json);
+}
+
+void AnalysisProfile::setCount(const std::string& name, int64_t value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = std::find_if(counts_.begin(), counts_.end(), [&](const auto& entry) { return entry.first == name; });
+    if (it == counts_.end()) {
+        counts_.emplace_back(name, value);
+    } else {
+        it->second = value;
+    }
+}
+
+void AnalysisProfile::addZone(int procedure_id, const std::string& name, size_t features,
+                              std::chrono::nanoseconds elapsed, const ZoneEvaluator::Timing& timing) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (zones_.size() == kTopZones && zones_.back().elapsed >= elapsed) {
+        return;
+    }
+    Zone zone{procedure_id, name, features, elapsed, timing};
+    auto at = std::upper_bound(zones_.begin(), zones_.end(), elapsed,
+                               [](std::chrono::nanoseconds value, const Zone& other) { return value > other.elapsed; });
+    zones_.insert(at, std::move(zone));
+    if (zones_.size() > kTopZones) {
+        zones_.pop_back();
+    }
+}
+
+nlohmann::json AnalysisProfile::toJson() const {
+    const auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    nlohmann::json phases = nlohmann::json::object();
+    for (const auto& [name, elapsed] : phases_) {
+        phases[name] = milliseconds(elapsed);
+    }
+    // A phase still running is reported up to now
+    if (!current_.empty()) {
+        phases[current_] = phases.value(current_, 0.0) + milliseconds(now - phase_started_);
+    }
+    nlohmann::json work = nlohmann::json::object();
+    for (const auto& [name, elapsed] : work_) {
+        work[name] = milliseconds(elapsed);
+    }
+    nlohmann::json counts = nlohmann::json::object();
+    for (const auto& [name, value] : counts_) {
+        counts[name] = value;
+    }
+    nlohmann::json zones = nlohmann::json::array();
+    for (const auto& zone : zones_) {
+        zones.push_back({{"procedure_id", zone.procedure_id},
+                         {"protection_name", zone.name},
+                         {"features", zone.features},
+                         {"ms", milliseconds(zone.elapsed)},
+                         {"predicate_ms", milliseconds(zone.timing.predicate)},
+                         {"intersection_ms", milliseconds(zone.timing.intersection)},
+                         {"export_ms", milliseconds(zone.timing.export_json)}});
+    }
+    return {{"total_ms", milliseconds(finished_.value_or(now) - started_)},
+            {"phases_ms", std::move(phases)},
+            {"work_ms", std::move(work)},
+            {"counts", std::move(counts)},
+            {"slowest_protections", std::move(zones)}};
+}
+
+} // namespace aeronautical
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "ZoneEvaluator.h"
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+#include <json.hpp>
+
+namespace aeronautical {
+
+// Where one analysis or preview spent its time, for ?explain=true. Phases
+// are wall time in the order they ran; work is time summed over the threads
+// doing it, so it can exceed the phase it belongs to. Counts record how many
+// zones and pairs were left after each filter, and only the slowest zones
+// are kept. The total runs from the first phase, so a profile can be made
+// before the work is queued. Filled from several threads and readable while
+// it is filled.
+class AnalysisProfile {
+public:
+    static constexpr size_t kTopZones = 10;
+
+    AnalysisProfile();
+
+    // Ends the current phase, if any, and starts the named one
+    void enter(std::string name);
+    // Ends the current phase and the total
+    void finish();
+
+    void addWork(const std::string& name, std::chrono::nanoseconds elapsed);
+    void addWork(const ZoneEvaluator::Timing& timing);
+    void setCount(const std::string& name, int64_t value);
+    // One zone's evaluation; elapsed is its wall time
+    void addZone(int procedure_id, const std::string& name, size_t features, std::chrono::nanoseconds elapsed,
+                 const ZoneEvaluator::Timing& timing);
+
+    nlohmann::json toJson() const;
+
+private:
+    struct Zone {
+        int procedure_id = 0;
+        std::string name;
+        size_t features = 0;
+        std::chrono::nanoseconds elapsed{0};
+        ZoneEvaluator::Timing timing;
+    };
+
+    void finishLocked(std::chrono::steady_clock::time_point now);
+
+    mutable std::mutex mutex_;
+    std::chrono::steady_clock::time_point started_{};
+    std::chrono::steady_clock::time_point phase_started_{};
+    std::optional<std::chrono::steady_clock::time_point> finished_;
+    std::string current_;
+    std::vector<std::pair<std::string, std::chrono::nanoseconds>> phases_;
+    std::vector<std::pair<std::string, std::chrono::nanoseconds>> work_;
+    std::vector<std::pair<std::string, int64_t>> counts_;
+    std::vector<Zone> zones_; // slowest first, at most kTopZones
+};
+
+} // namespace aeronautical
@@ -0,0 +1,130 @@
+#include "AnalysisShadow.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+namespace aeronautical {
+
+namespace {
+
+// Areas below this many m² are equal whatever their ratio (points, lines)
+constexpr double kAreaSlackM2 = 1.0;
+
+} // namespace
+
+const char* AnalysisShadow::name(Mismatch mismatch) {
+    switch (mismatch) {
+        case Mismatch::Missing: return "missing";
+        case Mismatch::Extra: return "extra";
+        case Mismatch::Severity: return "severity";
+        case Mismatch::Area: return "area";
+    }
+    return "unknown";
+}
+
+AnalysisShadow& AnalysisShadow::getInstance() {
+    static AnalysisShadow instance;
+    return instance;
+}
+
+void AnalysisShadow::configure(double sample, double area_tolerance) {
+    sample_.store(std::clamp(sample, 0.0, 1.0), std::memory_order_relaxed);
+    area_tolerance_.store(std::max(area_tolerance, 0.0), std::memory_order_relaxed);
+    if (sample > 0) {
+        spdlog::info("Shadow analysis: {:.1f}% of analyses rerun by the reference engine, area tolerance {:.2f}%",
+                     sample_.load() * 100, area_tolerance_.load() * 100);
+    }
+}
+
+bool AnalysisShadow::sample() {
+    const double rate = sample_.load(std::memory_order_relaxed);
+    if (rate <= 0) {
+        return false;
+    }
+    const uint64_t n = candidates_.fetch_add(1, std::memory_order_relaxed);
+    return std::floor(static_cast<double>(n + 1) * rate) > std::floor(static_cast<double>(n) * rate);
+}
+
+size_t AnalysisShadow::compare(int project_id, const std::vector<Conflict>& fast, std::chrono::nanoseconds fast_time,
+                               const std::vector<Conflict>& reference, std::chrono::nanoseconds reference_time) {
+    auto by_procedure = [](const Conflict& a, const Conflict& b) { return a.procedure_id < b.procedure_id; };
+    std::vector<Conflict> stored(fast);
+    std::vector<Conflict> expected(reference);
+    std::sort(stored.begin(), stored.end(), by_procedure);
+    std::sort(expected.begin(), expected.end(), by_procedure);
+
+    const double tolerance = area_tolerance_.load(std::memory_order_relaxed);
+    std::array<size_t, kMismatchKinds> found{};
+    std::string details;
+    auto mismatch = [&](Mismatch kind, int procedure_id) {
+        found[static_cast<size_t>(kind)]++;
+        if (!details.empty()) details += ", ";
+        details += std::string(name(kind)) + " " + std::to_string(procedure_id);
+    };
+
+    size_t i = 0;
+    size_t j = 0;
+    while (i < stored.size() || j < expected.size()) {
+        if (j == expected.size() || (i < stored.size() && stored[i].procedure_id < expected[j].procedure_id)) {
+            mismatch(Mismatch::Extra, stored[i++].procedure_id);
+            continue;
+        }
+        if (i == stored.size() || expected[j].procedure_id < stored[i].procedure_id) {
+            mismatch(Mismatch::Missing, expected[j++].procedure_id);
+            continue;
+        }
+        const Conflict& got = stored[i++];
+        const Conflict& want = expected[j++];
+        if (got.severity && want.severity && *got.severity != *want.severity) {
+            mismatch(Mismatch::Severity, got.procedure_id);
+        }
+        if (got.overlap_area && want.overlap_area) {
+            const double difference = std::abs(*got.overlap_area - *want.overlap_area);
+            if (difference > kAreaSlackM2 && difference > tolerance * std::max(*got.overlap_area, *want.overlap_area)) {
+                mismatch(Mismatch::Area, got.procedure_id);
+            }
+        }
+    }
+
+    size_t total = 0;
+    for (size_t k = 0; k < kMismatchKinds; k++) {
+        mismatches_[k].fetch_add(found[k], std::memory_order_relaxed);
+        total += found[k];
+    }
+    runs_.fetch_add(1, std::memory_order_relaxed);
+    fast_ns_.fetch_add(static_cast<uint64_t>(fast_time.count()), std::memory_order_relaxed);
+    reference_ns_.fetch_add(static_cast<uint64_t>(reference_time.count()), std::memory_order_relaxed);
+
+    const double ratio = reference_time.count() > 0
+                             ? static_cast<double>(fast_time.count()) / static_cast<double>(reference_time.count())
+                             : 0.0;
+    if (total > 0) {
+        mismatched_runs_.fetch_add(1, std::memory_order_relaxed);
+        spdlog::warn("Shadow analysis of project {}: {} stored and {} reference conflicts disagree ({})", project_id,
+                     fast.size(), reference.size(), details);
+    } else {
+        spdlog::debug("Shadow analysis of project {}: {} conflicts agree, fast engine at {:.2f}x the reference time",
+                      project_id, fast.size(), ratio);
+    }
+    return total;
+}
+
+nlohmann::json AnalysisShadow::stats() const {
+    nlohmann::json mismatches = nlohmann::json::object();
+    for (size_t k = 0; k < kMismatchKinds; k++) {
+        mismatches[name(static_cast<Mismatch>(k))] = mismatches_[k].load(std::memory_order_relaxed);
+    }
+    const double reference = referenceSeconds();
+    return {{"sample", sampleRate()},
+            {"area_tolerance", area_tolerance_.load(std::memory_order_relaxed)},
+            {"runs", runs()},
+            {"mismatched_runs", mismatchedRuns()},
+            {"mismatches", std::move(mismatches)},
+            {"failures", failures()},
+            {"fast_seconds", fastSeconds()},
+            {"reference_seconds", reference},
+            {"time_ratio", reference > 0 ? fastSeconds() / reference : 0.0}};
+}
+
+} // namespace aeronautical
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "FlightProcedure.h"
+#include <json.hpp>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace aeronautical {
+
+// Shadow runs of the conflict analysis. For a sample of the analyses that
+// store their results, ConflictController recomputes the project's
+// conflicts afterwards with a reference engine kept deliberately plain:
+// every zone of the shards the features reach, checked on its envelope and
+// then with OGR's own predicates and overlay on the zone geometry, without
+// the spatial index, coverage mask, ConflictMemo, reused feature results or
+// ZoneEvaluator's prepared, ring and tile shortcuts. Nothing it finds is
+// stored, cached or remembered. This class decides which runs are sampled
+// and compares the two conflict sets: by procedure, then the severity where
+// the analysis classified its conflicts, and the overlap area, within a
+// relative tolerance, where it computed them exactly. Mismatches are
+// counted per kind and logged; the time of both engines is summed, so the
+// ratio shows what the fast one saves.
+class AnalysisShadow {
+public:
+    // One conflict as compared; fields the analysis did not compute are empty
+    struct Conflict {
+        int procedure_id = 0;
+        std::optional<ConflictSeverity> severity;
+        std::optional<double> overlap_area; // m²
+    };
+
+    enum class Mismatch { Missing, Extra, Severity, Area };
+    static constexpr size_t kMismatchKinds = 4;
+    static const char* name(Mismatch mismatch);
+
+    static AnalysisShadow& getInstance();
+
+    AnalysisShadow(const AnalysisShadow&) = delete;
+    AnalysisShadow& operator=(const AnalysisShadow&) = delete;
+
+    // Share of stored analyses shadowed, 0..1 (0: off); area tolerance relative to the larger area
+    void configure(double sample, double area_tolerance);
+    double sampleRate() const { return sample_.load(std::memory_order_relaxed); }
+
+    // Whether the analysis finishing now is shadowed: spread evenly, one
+    // in every 1 / sample
+    bool sample();
+
+    // Compares the stored conflicts (fast) with the reference engine's and
+    // records the outcome; returns the mismatches found
+    size_t compare(int project_id, const std::vector<Conflict>& fast, std::chrono::nanoseconds fast_time,
+                   const std::vector<Conflict>& reference, std::chrono::nanoseconds reference_time);
+    // A shadow run that could not finish (unparsable project, zone failing to load)
+    void recordFailure() { failures_.fetch_add(1, std::memory_order_relaxed); }
+
+    uint64_t runs() const { return runs_.load(std::memory_order_relaxed); }
+    uint64_t mismatchedRuns() const { return mismatched_runs_.load(std::memory_order_relaxed); }
+    uint64_t mismatches(Mismatch kind) const {
+        return mismatches_[static_cast<size_t>(kind)].load(std::memory_order_relaxed);
+    }
+    uint64_t failures() const { return failures_.load(std::memory_order_relaxed); }
+    double fastSeconds() const { return fast_ns_.load(std::memory_order_relaxed) / 1e9; }
+    double referenceSeconds() const { return reference_ns_.load(std::memory_order_relaxed) / 1e9; }
+
+    // {"sample", "area_tolerance", "runs", "mismatched_runs", "mismatches": {...}, "time_ratio", ...}
+    nlohmann::json stats() const;
+
+private:
+    AnalysisShadow() = default;
+
+    std::atomic<double> sample_{0};
+    std::atomic<double> area_tolerance_{0.01};
+    std::atomic<uint64_t> candidates_{0};
+
+    std::atomic<uint64_t> runs_{0};
+    std::atomic<uint64_t> mismatched_runs_{0};
+    std::array<std::atomic<uint64_t>, kMismatchKinds> mismatches_{};
+    std::atomic<uint64_t> failures_{0};
+    std::atomic<uint64_t> fast_ns_{0};
+    std::atomic<uint64_t> reference_ns_{0};
+};
+
+} // namespace aeronautical
@@ -0,0 +1,16 @@
+#include "AnalysisSources.h"
+#include "ConflictRepository.h"
+#include "FlightProcedureRepository.h"
+#include "ProjectRepository.h"
+
+namespace aeronautical {
+
+AnalysisSources AnalysisSources::mysql() {
+    AnalysisSources sources;
+    sources.protections = std::make_shared<FlightProcedureRepository>();
+    sources.projects = std::make_shared<ProjectRepository>();
+    sources.results = std::make_shared<ConflictRepository>();
+    return sources;
+}
+
+} // namespace aeronautical
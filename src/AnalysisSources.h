@@ -0,0 +1,135 @@
+#pragma once
+
+#include "FlightProcedure.h"
+#include "Project.h"
+#include "ogr_core.h"
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace aeronautical {
+
+// One procedure's protection geometry as loaded for analysis; exactly one is set
+struct StoredProtectionGeometry {
+    std::string wkb;     // validated geometry, current for the procedure's revision
+    std::string geojson; // protection_geometry text when no current WKB is stored
+    std::string hash;    // content hash of wkb when it came from geometry_blobs
+};
+
+// A conflict detected by one analysis run, not yet written
+struct PendingConflict {
+    int procedure_id = 0;
+    std::string description;
+    std::string conflicting_geometry_json;
+    // Overlap metrics, when the analysis computed them
+    std::optional<ConflictSeverity> severity{};
+    std::optional<double> overlap_area{};  // m²
+    std::optional<double> overlap_ratio{};
+    // Vertical relation to the zone in feet (see Conflict)
+    std::optional<double> vertical_clearance_ft{};
+    std::optional<double> penetration_depth_ft{};
+    // Protection snapshot of the run; empty when not known
+    std::string protection_snapshot{};
+    // Identifies the result across runs: the features in conflict, the
+    // procedure, its revision and every value stored with the row. 0 when
+    // not computed; such a conflict is always written as new.
+    uint64_t signature = 0;
+};
+
+// How a run's conflicts compare with the previous run's, matched by signature.
+// Unchanged conflicts keep their row; resolved ones are those the run no
+// longer found.
+struct ConflictDiff {
+    struct Entry {
+        int conflict_id = 0; // 0 when not known, as for rows just inserted
+        int procedure_id = 0;
+        std::string description;
+    };
+    std::vector<Entry> added;
+    std::vector<Entry> unchanged;
+    std::vector<Entry> resolved;
+};
+
+// Where conflict analysis reads the active protection zones. The MySQL
+// source is FlightProcedureRepository; InMemoryProtectionSource holds them
+// in the process. Implementations are called from several analyses at once.
+class ProtectionSource {
+public:
+    virtual ~ProtectionSource() = default;
+
+    // Active protections without their geometry; updated_at versions the
+    // geometry, footprint is set where a current envelope is known
+    virtual std::vector<ProcedureProtection> findActiveProtectionHeaders() = 0;
+    virtual std::unordered_map<int, StoredProtectionGeometry> findProtectionGeometries(
+        const std::vector<int>& procedure_ids) = 0;
+    // Segments of each procedure in segment order, for the vertical profile
+    // of its zone (see VerticalProfile); a source without them returns none
+    virtual std::unordered_map<int, std::vector<ProcedureSegment>> findProcedureSegments(const std::vector<int>&) {
+        return {};
+    }
+
+    // Data derived from a parsed geometry, handed back so the next load can
+    // skip the parse; a source that keeps none says so and ignores them
+    virtual bool storesFootprints() { return false; }
+    virtual bool saveProtectionFootprint(int, int64_t, const ProtectionFootprint&) { return false; }
+    virtual bool storesWkb() { return false; }
+    virtual bool saveProtectionWkb(int, int64_t, const std::string&) { return false; }
+};
+
+// Where conflict analysis reads projects and their feature collections;
+// ProjectRepository for MySQL, InMemoryProjectSource otherwise
+// An envelope of a project's features kept by the source
+struct StoredProjectEnvelope {
+    std::string revision; // geometry revision it was computed at
+    bool overlaps = false; // with the envelope asked about
+};
+
+class ProjectGeometrySource {
+public:
+    virtual ~ProjectGeometrySource() = default;
+
+    virtual std::optional<Project> findById(int id) = 0;
+    // Primary feature collection; validated tells whether it was repaired when saved
+    virtual std::optional<std::string> findGeometriesByProjectId(int project_id, bool* validated = nullptr) = 0;
+    // Project id and a geometry revision that changes with every save
+    virtual std::vector<std::pair<int, std::string>> findGeometryRevisions(ProjectStatus status) = 0;
+
+    // Stored envelopes of the projects in status, with whether each overlaps
+    // envelope, so callers can skip parsing projects that cannot reach it.
+    // An envelope whose revision is not the project's current one says
+    // nothing. nullopt when the source keeps none.
+    virtual std::optional<std::unordered_map<int, StoredProjectEnvelope>> findStoredEnvelopes(ProjectStatus,
+                                                                                               const OGREnvelope&) {
+        return std::nullopt;
+    }
+    virtual bool saveEnvelope(int, const std::string&, const OGREnvelope&) { return false; }
+};
+
+// Where an analysis run leaves its outcome; ConflictRepository for MySQL
+class AnalysisResultSink {
+public:
+    virtual ~AnalysisResultSink() = default;
+
+    // Replaces every conflict of the project with these. With under_review
+    // the project moves to UnderReview in the same commit, so a reader never
+    // sees the new conflicts on a pending project or the reverse. diff, when
+    // given, receives how they compare with the conflicts they replace.
+    virtual bool storeAnalysis(int project_id, const std::vector<PendingConflict>& conflicts, bool under_review,
+                               ConflictDiff* diff = nullptr) = 0;
+};
+
+// The three together, as ConflictController uses them
+struct AnalysisSources {
+    std::shared_ptr<ProtectionSource> protections;
+    std::shared_ptr<ProjectGeometrySource> projects;
+    std::shared_ptr<AnalysisResultSink> results;
+
+    // The repositories, reading and writing MySQL through DatabaseManager
+    static AnalysisSources mysql();
+};
+
+} // namespace aeronautical
@@ -0,0 +1,46 @@
+#include "AsyncHandler.h"
+#include <spdlog/spdlog.h>
+#include <optional>
+
+namespace aeronautical {
+
+namespace {
+
+crow::response errorResponse(int code, const std::string& message) {
+    crow::response res(code, nlohmann::json{{"error", true}, {"message", message}}.dump());
+    res.add_header("Content-Type", "application/json");
+    return res;
+}
+
+} // namespace
+
+void AsyncHandler::spawn(const crow::request& req, crow::response& res,
+                         std::function<asio::awaitable<crow::response>()> handler) {
+    // A batch sub-request has no connection, and its response is read as soon as the handler returns
+    std::optional<asio::io_context> local;
+    if (DbExecutor::respondsInline()) local.emplace(1);
+    asio::co_spawn(local ? *local : *req.io_context, std::move(handler),
+                   [&res](std::exception_ptr error, crow::response out) {
+                       if (error) {
+                           try {
+                               std::rethrow_exception(error);
+                           } catch (const Busy&) {
+                               out = errorResponse(503, "Database busy, please retry later");
+                               out.add_header("Retry-After", "1");
+                           } catch (const std::exception& e) {
+                               spdlog::error("Request failed: {}", e.what());
+                               out = errorResponse(500, "Internal server error");
+                           }
+                       }
+                       res = std::move(out);
+                       res.end();
+                   });
+    if (local) local->run();
+}
+
+asio::awaitable<void> AsyncHandler::sleepFor(std::chrono::steady_clock::duration delay) {
+    asio::steady_timer timer(co_await asio::this_coro::executor, delay);
+    co_await timer.async_wait(asio::use_awaitable);
+}
+
+} // namespace aeronautical
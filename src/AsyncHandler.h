@@ -0,0 +1,79 @@
+#pragma once
+
+#include "DbExecutor.h"
+#include <asio/awaitable.hpp>
+#include <asio/co_spawn.hpp>
+#include <asio/post.hpp>
+#include <asio/steady_timer.hpp>
+#include <asio/use_awaitable.hpp>
+#include <crow.h>
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+
+namespace aeronautical {
+
+// Coroutine handlers on the connection's own io_context. A handler that
+// waits (for a query, a job, a timer) co_awaits instead of blocking: the
+// Crow worker serves other connections meanwhile, and a query occupies a
+// DB thread only while it runs. Route lambdas take crow::response& and
+// hand a coroutine to spawn():
+//
+//   ([this](const crow::request& req, crow::response& res, int id) {
+//       AsyncHandler::spawn(req, res, [this, id]() -> asio::awaitable<crow::response> {
+//           auto project = co_await AsyncHandler::offload<std::optional<Project>>(
+//               [this, id]() { return repository_.findById(id); });
+//           ...
+//       });
+//   })
+class AsyncHandler {
+public:
+    // Thrown by offload() when DbExecutor has max_pending requests waiting;
+    // spawn() answers it with 503
+    struct Busy : std::runtime_error {
+        Busy() : std::runtime_error("Database busy") {}
+    };
+
+    // Runs handler on req's io_context and ends res with what it returns;
+    // an exception escaping it is a 500. req and res stay valid until then.
+    // Inside DbExecutor::parallel() (a batch sub-request) the handler runs
+    // to completion on the calling thread instead, as respond() does there.
+    static void spawn(const crow::request& req, crow::response& res,
+                      std::function<asio::awaitable<crow::response>()> handler);
+
+    // Runs work on a DB thread (see DbExecutor::post) and resumes the
+    // coroutine on its own executor with the result; exceptions thrown by
+    // work are rethrown at the co_await
+    template <typename T>
+    static asio::awaitable<T> offload(std::function<T()> work) {
+        auto executor = co_await asio::this_coro::executor;
+        co_return co_await asio::async_initiate<const asio::use_awaitable_t<>&, void(std::exception_ptr, T)>(
+            [executor, work = std::move(work)](auto handler) mutable {
+                // std::function needs a copyable callable
+                auto shared = std::make_shared<decltype(handler)>(std::move(handler));
+                auto resume = [executor, shared](std::exception_ptr error, T value) {
+                    asio::post(executor, [shared, error, value = std::move(value)]() mutable {
+                        std::move (*shared)(error, std::move(value));
+                    });
+                };
+                const bool queued = DbExecutor::getInstance().post([work = std::move(work), resume]() {
+                    try {
+                        resume(nullptr, work());
+                    } catch (...) {
+                        resume(std::current_exception(), T{});
+                    }
+                });
+                if (!queued) {
+                    resume(std::make_exception_ptr(Busy()), T{});
+                }
+            },
+            asio::use_awaitable);
+    }
+
+    // Suspends the coroutine for delay without holding any thread
+    static asio::awaitable<void> sleepFor(std::chrono::steady_clock::duration delay);
+};
+
+} // namespace aeronautical
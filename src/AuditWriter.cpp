@@ -0,0 +1,214 @@
+#include "AuditWriter.h"
+#include "DatabaseManager.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+
+namespace aeronautical {
+
+namespace {
+
+std::string quoted(MYSQL* con, const std::string& text) {
+    std::string escaped(text.size() * 2 + 1, '\0');
+    escaped.resize(mysql_real_escape_string(con, escaped.data(), text.c_str(), text.size()));
+    return "'" + escaped + "'";
+}
+
+std::string statusSql(const std::optional<ProjectStatus>& status) {
+    return status ? "'" + statusToString(*status) + "'" : std::string("NULL");
+}
+
+} // namespace
+
+AuditWriter& AuditWriter::getInstance() {
+    static AuditWriter instance;
+    return instance;
+}
+
+AuditWriter::~AuditWriter() {
+    stop();
+}
+
+void AuditWriter::start(const AuditSettings& settings) {
+    std::lock_guard<std::mutex> lock(thread_mutex_);
+    if (writer_.joinable() || !settings.async) {
+        return;
+    }
+    settings_ = settings;
+    settings_.max_batch = std::max<size_t>(1, settings_.max_batch);
+    stopping_ = false;
+    running_.store(true, std::memory_order_release);
+    writer_ = std::thread([this]() { writeLoop(); });
+    spdlog::info("Audit events written every {} ms in batches of up to {}", settings_.flush_interval.count(),
+                 settings_.max_batch);
+}
+
+void AuditWriter::stop() {
+    {
+        std::lock_guard<std::mutex> lock(thread_mutex_);
+        stopping_ = true;
+    }
+    running_.store(false, std::memory_order_release);
+    wake_.notify_all();
+    if (writer_.joinable()) {
+        writer_.join();
+    }
+    // Events pushed while the writer finished
+    takePushed();
+    while (!backlog_.empty() && !writeBacklog()) {
+    }
+}
+
+bool AuditWriter::record(AuditEvent event, Durability durability) {
+    if (durability == Durability::Durable) {
+        durable_.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (!running_.load(std::memory_order_acquire)) {
+        const bool ok = insert({&event});
+        (ok ? written_ : dropped_).fetch_add(1, std::memory_order_relaxed);
+        return ok;
+    }
+
+    // A full queue holds callers back instead of growing without bound
+    const bool wait = durability == Durability::Durable ||
+                      pending_.load(std::memory_order_relaxed) >= settings_.max_queue;
+    const int project_id = event.project_id;
+    auto node = std::make_unique<Node>();
+    node->event = std::move(event);
+    std::future<bool> written;
+    if (wait) {
+        node->written = std::make_shared<std::promise<bool>>();
+        written = node->written->get_future();
+    }
+
+    Node* pushed = node.release();
+    pushed->next = head_.load(std::memory_order_relaxed);
+    while (!head_.compare_exchange_weak(pushed->next, pushed, std::memory_order_release, std::memory_order_relaxed)) {
+    }
+    pending_.fetch_add(1, std::memory_order_relaxed);
+    if (pushed_.fetch_add(1, std::memory_order_relaxed) + 1 >= settings_.max_batch) {
+        wake_.notify_one();
+    }
+
+    if (!wait) {
+        return true;
+    }
+    if (written.wait_for(settings_.durable_timeout) != std::future_status::ready) {
+        spdlog::warn("Audit event for project {} not written after {} ms", project_id,
+                     settings_.durable_timeout.count());
+        return false;
+    }
+    return written.get();
+}
+
+void AuditWriter::writeLoop() {
+    auto delay = settings_.flush_interval;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(thread_mutex_);
+            wake_.wait_for(lock, delay, [this]() {
+                return stopping_ || pushed_.load(std::memory_order_relaxed) >= settings_.max_batch;
+            });
+            if (stopping_) break;
+        }
+        takePushed();
+        delay = writeBacklog() ? settings_.flush_interval
+                               : std::chrono::duration_cast<std::chrono::milliseconds>(kRetryDelay);
+    }
+    // Stopping: what is queued gets its remaining attempts
+    takePushed();
+    while (!backlog_.empty() && !writeBacklog()) {
+    }
+}
+
+void AuditWriter::takePushed() {
+    Node* node = head_.exchange(nullptr, std::memory_order_acquire);
+    // The stack is newest first; backlog_ is oldest first
+    std::vector<std::unique_ptr<Node>> taken;
+    while (node) {
+        Node* next = node->next;
+        taken.emplace_back(node);
+        node = next;
+    }
+    pushed_.fetch_sub(taken.size(), std::memory_order_relaxed);
+    for (auto it = taken.rbegin(); it != taken.rend(); ++it) {
+        backlog_.push_back(std::move(*it));
+    }
+}
+
+bool AuditWriter::writeBacklog() {
+    while (!backlog_.empty()) {
+        const size_t count = std::min(settings_.max_batch, backlog_.size());
+        std::vector<const AuditEvent*> events;
+        events.reserve(count);
+        for (size_t i = 0; i < count; i++) {
+            events.push_back(&backlog_[i]->event);
+        }
+
+        const bool ok = insert(events);
+        batches_.fetch_add(1, std::memory_order_relaxed);
+        if (!ok) {
+            failed_batches_.fetch_add(1, std::memory_order_relaxed);
+            if (++backlog_.front()->attempts < kMaxAttempts) {
+                return false;
+            }
+            spdlog::error("Dropped {} audit events after {} failed attempts", count, kMaxAttempts);
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            if (backlog_.front()->written) backlog_.front()->written->set_value(ok);
+            backlog_.pop_front();
+        }
+        (ok ? written_ : dropped_).fetch_add(count, std::memory_order_relaxed);
+        pending_.fetch_sub(count, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+bool AuditWriter::insert(const std::vector<const AuditEvent*>& events) {
+    if (events.empty()) return true;
+    try {
+        auto& db = DatabaseManager::getInstance();
+        // A batch split over several INSERTs is still written whole or not at all
+        DatabaseManager::Transaction transaction(db);
+        MYSQL* con = transaction.get();
+        const std::string prefix = "INSERT INTO project_comments "
+                                   "(project_id, user_id, comment_type, comment, old_status, new_status, is_internal) "
+                                   "VALUES ";
+        std::string statement;
+        for (const AuditEvent* event : events) {
+            std::string row = "(" + std::to_string(event->project_id) + ", " + std::to_string(event->user_id) + ", " +
+                              quoted(con, event->comment_type) + ", " + quoted(con, event->comment) + ", " +
+                              statusSql(event->old_status) + ", " + statusSql(event->new_status) + ", " +
+                              (event->is_internal ? "1" : "0") + ")";
+            if (!statement.empty() && statement.size() + row.size() + 1 > kMaxStatementBytes) {
+                if (!db.executeQuery(statement)) {
+                    transaction.rollback();
+                    return false;
+                }
+                statement.clear();
+            }
+            statement += statement.empty() ? prefix : ",";
+            statement += row;
+        }
+        if (!db.executeQuery(statement)) {
+            transaction.rollback();
+            return false;
+        }
+        return transaction.commit();
+    } catch (const std::exception& e) {
+        spdlog::error("Failed to write {} audit events: {}", events.size(), e.what());
+        return false;
+    }
+}
+
+nlohmann::json AuditWriter::stats() const {
+    return {{"async", running_.load(std::memory_order_acquire)},
+            {"pending", pending_.load(std::memory_order_relaxed)},
+            {"written", written_.load(std::memory_order_relaxed)},
+            {"batches", batches_.load(std::memory_order_relaxed)},
+            {"failed_batches", failed_batches_.load(std::memory_order_relaxed)},
+            {"dropped", dropped_.load(std::memory_order_relaxed)},
+            {"durable", durable_.load(std::memory_order_relaxed)}};
+}
+
+} // namespace aeronautical
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "Project.h"
+#include <json.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace aeronautical {
+
+struct AuditSettings {
+    bool async = true;                                // false: every event is written by its caller
+    std::chrono::milliseconds flush_interval{5};      // longest an event waits for its batch
+    size_t max_batch = 256;                           // rows per INSERT; a full batch is written at once
+    size_t max_queue = 10000;                         // past this, callers wait as for durable events
+    std::chrono::milliseconds durable_timeout{5000};  // longest a durable caller waits
+};
+
+// One row of project_comments
+struct AuditEvent {
+    int project_id = 0;
+    int user_id = 1;
+    std::string comment_type = "status_change";
+    std::string comment;
+    std::optional<ProjectStatus> old_status;
+    std::optional<ProjectStatus> new_status;
+    bool is_internal = false;
+};
+
+// Writes project_comments rows off the request path. Callers push events on
+// a lock-free stack; a writer thread takes the whole stack every
+// flush_interval, or as soon as max_batch events are waiting, and writes it
+// in multi-row INSERTs. A failed batch is retried on the next flushes, then
+// dropped with an error.
+//
+// A Durable event returns only once its batch is committed (or failed), for
+// transitions that must not be lost: it still shares the batch, so many
+// durable callers cost one INSERT. Before start() and after stop(), and
+// with async off, every event is written by its caller.
+class AuditWriter {
+public:
+    enum class Durability { Async, Durable };
+
+    static AuditWriter& getInstance();
+
+    AuditWriter(const AuditWriter&) = delete;
+    AuditWriter& operator=(const AuditWriter&) = delete;
+
+    void start(const AuditSettings& settings);
+    // Writes what is queued, then joins the writer
+    void stop();
+
+    // False when a durable or synchronous write failed; an async event that
+    // is later dropped is only logged
+    bool record(AuditEvent event, Durability durability = Durability::Async);
+
+    nlohmann::json stats() const;
+
+private:
+    struct Node {
+        AuditEvent event;
+        std::shared_ptr<std::promise<bool>> written; // set for callers that wait
+        int attempts = 0;
+        Node* next = nullptr;
+    };
+
+    static constexpr int kMaxAttempts = 3;
+    // Between attempts at a failed batch
+    static constexpr std::chrono::milliseconds kRetryDelay{1000};
+    // Keeps each INSERT well under max_allowed_packet
+    static constexpr size_t kMaxStatementBytes = 1024 * 1024;
+
+    AuditWriter() = default;
+    ~AuditWriter();
+
+    void writeLoop();
+    // Moves the pushed events to backlog_ in the order they came
+    void takePushed();
+    // Writes backlog_ a batch at a time; false when a batch failed and stays queued
+    bool writeBacklog();
+    // Multi-row INSERTs of the events; no throw
+    static bool insert(const std::vector<const AuditEvent*>& events);
+
+    AuditSettings settings_;
+    std::atomic<Node*> head_{nullptr};          // pushed, newest first
+    std::atomic<size_t> pushed_{0};             // on the stack
+    std::atomic<size_t> pending_{0};            // pushed and not yet written or dropped
+    std::deque<std::unique_ptr<Node>> backlog_; // writer thread only, oldest first
+
+    std::atomic<bool> running_{false};
+    std::mutex thread_mutex_;
+    std::condition_variable wake_;
+    std::thread writer_;
+    bool stopping_ = false;
+
+    std::atomic<uint64_t> written_{0};
+    std::atomic<uint64_t> batches_{0};
+    std::atomic<uint64_t> failed_batches_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<uint64_t> durable_{0};
+};
+
+} // namespace aeronautical
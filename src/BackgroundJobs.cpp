@@ -0,0 +1,47 @@
+#include "BackgroundJobs.h"
+#include "FlightProcedure.h"
+#include <filesystem>
+
+namespace aeronautical {
+
+std::string backgroundJobStateToString(BackgroundJobState state) {
+    switch (state) {
+        case BackgroundJobState::Queued: return "queued";
+        case BackgroundJobState::Running: return "running";
+        case BackgroundJobState::Completed: return "completed";
+        case BackgroundJobState::Failed: return "failed";
+        case BackgroundJobState::Cancelled: return "cancelled";
+    }
+    return "unknown";
+}
+
+nlohmann::json BackgroundJob::toJson() const {
+    nlohmann::json j;
+    j["job_id"] = id;
+    j["state"] = backgroundJobStateToString(state);
+    j["stage"] = stage;
+    j["queued_at"] = timePointToString(queued_at);
+    j["finished_at"] = finished_at ? nlohmann::json(timePointToString(*finished_at)) : nlohmann::json(nullptr);
+    if (error) j["error"] = *error;
+    return j;
+}
+
+bool prepareJobDirectory(const std::string& directory, const std::string& prefix, std::error_code& ec) {
+    std::filesystem::create_directories(directory, ec);
+    for (const auto& entry : std::filesystem::directory_iterator(directory, ec)) {
+        if (entry.path().filename().string().rfind(prefix, 0) == 0) {
+            std::filesystem::remove(entry.path(), ec);
+        }
+    }
+    return !ec;
+}
+
+void removeJobFile(const std::string& path) {
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+    for (const char* suffix : {"-journal", "-wal", "-shm"}) {
+        std::filesystem::remove(path + suffix, ec);
+    }
+}
+
+} // namespace aeronautical
@@ -0,0 +1,298 @@
+#pragma once
+
+#include <crow.h>
+#include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <json.hpp>
+
+namespace aeronautical {
+
+enum class BackgroundJobState {
+    Queued,
+    Running,
+    Completed,
+    Failed,
+    Cancelled
+};
+
+std::string backgroundJobStateToString(BackgroundJobState state);
+
+// What every background job records; a service's job derives from it and
+// adds its parameters and results
+struct BackgroundJob {
+    uint64_t id = 0;
+    BackgroundJobState state = BackgroundJobState::Queued;
+    std::string stage = "queued";
+    std::chrono::system_clock::time_point queued_at;
+    std::optional<std::chrono::system_clock::time_point> finished_at;
+    std::optional<std::string> error;
+    // Shared with the copy the pool runs, which stops once it is set
+    std::shared_ptr<std::atomic<bool>> cancelled = std::make_shared<std::atomic<bool>>(false);
+
+    bool isCancelled() const { return cancelled->load(std::memory_order_relaxed); }
+    // job_id, state, stage, queued_at, finished_at and the error, if any
+    nlohmann::json toJson() const;
+};
+
+// Creates the directory a service writes its job files to and removes the
+// files named prefix... a previous run left there: its jobs went with it.
+// False, with ec set, when the directory is not usable.
+bool prepareJobDirectory(const std::string& directory, const std::string& prefix, std::error_code& ec);
+// Removes a job's file, and the journal a SQLite writer (GeoPackage,
+// MBTiles) stopped mid-write leaves beside it
+void removeJobFile(const std::string& path);
+
+// Jobs a service runs on a pool of its own while clients poll their
+// status: the ids, the table the polls read, the cap on jobs queued or
+// running, and how long finished jobs are kept, retention after they
+// finished (when not zero) and no more than kMaxFinishedJobs of them. A job
+// submitted with a key (a content hash, a project revision) is joined by
+// the submissions of the same key until it finishes.
+template <typename Job>
+class BackgroundJobs {
+    static_assert(std::is_base_of_v<BackgroundJob, Job>);
+
+public:
+    struct Submission {
+        uint64_t id = 0;
+        bool joined = false; // an unfinished job of the same key
+    };
+
+    // The job's status body; and what leaves with a finished job dropped
+    // from the table, called with the table locked
+    using Describe = std::function<nlohmann::json(const Job&)>;
+    using Dropped = std::function<void(const Job&)>;
+
+    static constexpr size_t kMaxFinishedJobs = 200;
+
+    // noun names the jobs in messages ("Export job")
+    BackgroundJobs(std::string noun, Describe describe, Dropped dropped = nullptr)
+        : noun_(std::move(noun)), describe_(std::move(describe)), dropped_(std::move(dropped)) {}
+    ~BackgroundJobs() { shutdown(false); }
+
+    BackgroundJobs(const BackgroundJobs&) = delete;
+    BackgroundJobs& operator=(const BackgroundJobs&) = delete;
+
+    void start(size_t workers, const std::string& pool_name, size_t max_active,
+               std::chrono::seconds retention = std::chrono::seconds(0)) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        max_active_ = std::max<size_t>(1, max_active);
+        retention_ = retention;
+        if (!pool_) pool_ = std::make_unique<ThreadPool>(std::max<size_t>(1, workers), pool_name);
+    }
+
+    // Takes the pool out and joins it; with cancel, the unfinished jobs are
+    // told to stop first, else the running ones are waited for
+    void shutdown(bool cancel) {
+        std::unique_ptr<ThreadPool> pool;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pool = std::move(pool_);
+            if (cancel) {
+                for (auto& [id, record] : jobs_) {
+                    if (!record.job.finished_at) record.job.cancelled->store(true, std::memory_order_relaxed);
+                }
+            }
+        }
+        pool.reset();
+    }
+
+    bool running() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return pool_ != nullptr;
+    }
+
+    // The pool, for jobs that spread their work over it; null once shut down
+    ThreadPool* pool() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return pool_.get();
+    }
+
+    // Records job under a new id and posts run(id) to the pool, or joins the
+    // unfinished job of key; nullopt when max_active jobs are queued or
+    // running, or the pool is shut down
+    std::optional<Submission> submit(Job job, std::function<void(uint64_t)> run, const std::string& key = "") {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!key.empty()) {
+            auto running = in_flight_.find(key);
+            if (running != in_flight_.end()) return Submission{running->second, true};
+        }
+        expire();
+        if (active_ >= max_active_ || !pool_) return std::nullopt;
+        const uint64_t id = next_id_++;
+        job.id = id;
+        job.queued_at = std::chrono::system_clock::now();
+        jobs_.emplace(id, Record{std::move(job), key});
+        if (!key.empty()) in_flight_[key] = id;
+        ++active_;
+        pool_->post([run = std::move(run), id]() { run(id); });
+        return Submission{id, false};
+    }
+
+    // A copy of the job, nullopt once it left the table
+    std::optional<Job> get(uint64_t id) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        expire();
+        auto it = jobs_.find(id);
+        if (it == jobs_.end()) return std::nullopt;
+        return it->second.job;
+    }
+
+    // Applies fn to the job with the table locked; false once it left the table
+    bool update(uint64_t id, const std::function<void(Job&)>& fn) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = jobs_.find(id);
+        if (it == jobs_.end()) return false;
+        fn(it->second.job);
+        return true;
+    }
+
+    void setStage(uint64_t id, const char* stage) {
+        update(id, [stage](Job& job) {
+            job.state = BackgroundJobState::Running;
+            job.stage = stage;
+        });
+    }
+
+    // Completed without an error, Cancelled when it was told to stop, else
+    // Failed with the error; returns the state recorded
+    BackgroundJobState finish(uint64_t id, std::optional<std::string> error) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = jobs_.find(id);
+        if (it == jobs_.end()) return BackgroundJobState::Cancelled;
+        Job& job = it->second.job;
+        const bool cancelled = job.isCancelled();
+        job.state = cancelled ? BackgroundJobState::Cancelled
+                    : error   ? BackgroundJobState::Failed
+                              : BackgroundJobState::Completed;
+        job.stage = cancelled ? "cancelled" : error ? "failed" : "done";
+        if (!cancelled) job.error = std::move(error);
+        job.finished_at = std::chrono::system_clock::now();
+        if (job.state == BackgroundJobState::Completed) ++completed_;
+        if (job.state == BackgroundJobState::Failed) ++failed_;
+        if (!it->second.key.empty()) in_flight_.erase(it->second.key);
+        if (active_ > 0) --active_;
+        const BackgroundJobState state = job.state;
+        expire();
+        return state;
+    }
+
+    // GET of a job: 200 with its description, 404 once it left the table
+    crow::response status(uint64_t id) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        expire();
+        auto it = jobs_.find(id);
+        if (it == jobs_.end()) {
+            return errorResponse(404, noun_ + " not found");
+        }
+        nlohmann::json response;
+        response["data"] = describe_(it->second.job);
+        return jsonResponse(200, response);
+    }
+
+    // DELETE of a job: an unfinished one is told to stop (202) and cleans
+    // up after itself when it does; a finished one is dropped (204)
+    crow::response remove(uint64_t id) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = jobs_.find(id);
+        if (it == jobs_.end()) {
+            return errorResponse(404, noun_ + " not found");
+        }
+        Job& job = it->second.job;
+        if (!job.finished_at) {
+            job.cancelled->store(true, std::memory_order_relaxed);
+            nlohmann::json response;
+            response["data"] = describe_(job);
+            return jsonResponse(202, response);
+        }
+        if (dropped_) dropped_(job);
+        jobs_.erase(it);
+        return crow::response(204);
+    }
+
+    // Job counts and the pool's
+    nlohmann::json stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        nlohmann::json j = {{"jobs_active", active_},
+                            {"jobs_capacity", max_active_},
+                            {"jobs", jobs_.size()},
+                            {"completed", completed_},
+                            {"failed", failed_}};
+        if (pool_) {
+            const auto stats = pool_->stats();
+            j["threads"] = stats.threads;
+            j["busy"] = stats.busy;
+            j["queued"] = stats.queued;
+            j["executed"] = stats.executed;
+        } else {
+            j["threads"] = 0;
+        }
+        return j;
+    }
+
+private:
+    struct Record {
+        Job job;
+        std::string key;
+    };
+
+    // Drops finished jobs past retention or kMaxFinishedJobs, oldest first; caller holds mutex_
+    void expire() {
+        const auto now = std::chrono::system_clock::now();
+        size_t finished = jobs_.size() - active_;
+        for (auto it = jobs_.begin(); it != jobs_.end();) {
+            const Job& job = it->second.job;
+            if (job.finished_at && (finished > kMaxFinishedJobs ||
+                                    (retention_.count() > 0 && now - *job.finished_at > retention_))) {
+                if (dropped_) dropped_(job);
+                it = jobs_.erase(it);
+                --finished;
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    static crow::response errorResponse(int code, const std::string& message) {
+        nlohmann::json response;
+        response["error"] = true;
+        response["message"] = message;
+        return jsonResponse(code, response);
+    }
+
+    static crow::response jsonResponse(int code, const nlohmann::json& body) {
+        crow::response res(code, body.dump());
+        res.add_header("Content-Type", "application/json");
+        return res;
+    }
+
+    const std::string noun_;
+    const Describe describe_;
+    const Dropped dropped_;
+
+    mutable std::mutex mutex_;
+    std::unique_ptr<ThreadPool> pool_;
+    size_t max_active_ = 1;
+    std::chrono::seconds retention_{0};
+    uint64_t next_id_ = 1;
+    std::map<uint64_t, Record> jobs_; // by id, i.e. oldest first
+    std::unordered_map<std::string, uint64_t> in_flight_; // key -> unfinished job
+    size_t active_ = 0;
+    uint64_t completed_ = 0;
+    uint64_t failed_ = 0;
+};
+
+} // namespace aeronautical
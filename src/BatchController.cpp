@@ -0,0 +1,185 @@
+#include "BatchController.h"
+#include "DbExecutor.h"
+#include "JsonWriter.h"
+#include "Metrics.h"
+#include "Tracing.h"
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include <chrono>
+#include <vector>
+
+namespace aeronautical {
+
+namespace {
+
+struct SubRequest {
+    std::string id;
+    crow::request request;
+    crow::response response;
+};
+
+// Outer headers that describe the batch body rather than the client
+bool inheritedHeader(const std::string& name) {
+    return !crow::utility::string_equals(name, "Content-Length") &&
+           !crow::utility::string_equals(name, "Content-Type") &&
+           !crow::utility::string_equals(name, "Accept-Encoding") &&
+           !crow::utility::string_equals(name, "Transfer-Encoding");
+}
+
+bool isJson(const crow::response& res) {
+    return crow::get_header_value(res.headers, "Content-Type").find("json") != std::string::npos;
+}
+
+bool isText(const crow::response& res) {
+    const std::string& type = crow::get_header_value(res.headers, "Content-Type");
+    return type.empty() || type.rfind("text/", 0) == 0;
+}
+
+} // namespace
+
+BatchController::BatchController() {
+    try {
+        logger_ = spdlog::get("aeronautical");
+        if (!logger_) {
+            auto console_sink = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
+            logger_ = std::make_shared<spdlog::logger>("aeronautical", console_sink);
+            spdlog::register_logger(logger_);
+        }
+    } catch (const std::exception& e) {
+        logger_ = spdlog::default_logger();
+    }
+}
+
+void BatchController::registerRoutes(HttpApp& app) {
+    app_ = &app;
+
+    // POST /api/batch - {"requests": [{"id": "...", "url": "/api/...", "headers": {...}}]}
+    CROW_ROUTE(app, "/api/batch")
+        .methods(crow::HTTPMethod::POST)
+        ([this](const crow::request& req, crow::response& res) {
+            DbExecutor::getInstance().respond(req, res, [this, &req]() { return runBatch(req); });
+        });
+
+    logger_->info("Batch route registered");
+}
+
+crow::response BatchController::runBatch(const crow::request& req) {
+    nlohmann::json body;
+    try {
+        body = nlohmann::json::parse(req.body);
+    } catch (const nlohmann::json::exception& e) {
+        return errorResponse(400, "Invalid JSON format");
+    }
+    if (!body.is_object() || !body.contains("requests") || !body["requests"].is_array()) {
+        return errorResponse(400, "Body must be an object with a requests array");
+    }
+    const auto& requests = body["requests"];
+    if (requests.size() > kMaxRequests) {
+        return errorResponse(400, "At most " + std::to_string(kMaxRequests) + " requests per batch");
+    }
+
+    std::vector<SubRequest> batch(requests.size());
+    for (size_t i = 0; i < requests.size(); i++) {
+        const auto& entry = requests[i];
+        if (!entry.is_object() || !entry.contains("url") || !entry["url"].is_string()) {
+            return errorResponse(400, "Request " + std::to_string(i) + " has no url");
+        }
+        const std::string method = entry.value("method", "GET");
+        if (method != "GET") {
+            return errorResponse(400, "Request " + std::to_string(i) + ": only GET requests can be batched");
+        }
+        const std::string raw_url = entry["url"].get<std::string>();
+        const std::string path = raw_url.substr(0, raw_url.find('?'));
+        if (raw_url.empty() || raw_url[0] != '/' || path == "/api/batch") {
+            return errorResponse(400, "Request " + std::to_string(i) + " has an invalid url");
+        }
+
+        SubRequest& sub = batch[i];
+        sub.id = entry.contains("id") && entry["id"].is_string() ? entry["id"].get<std::string>() : std::to_string(i);
+        sub.request.method = crow::HTTPMethod::GET;
+        sub.request.raw_url = raw_url;
+        sub.request.url = path;
+        sub.request.url_params = crow::query_string(raw_url);
+        sub.request.remote_ip_address = req.remote_ip_address;
+        sub.request.http_ver_major = req.http_ver_major;
+        sub.request.http_ver_minor = req.http_ver_minor;
+        for (const auto& [name, value] : req.headers) {
+            if (inheritedHeader(name)) sub.request.add_header(name, value);
+        }
+        if (entry.contains("headers") && entry["headers"].is_object()) {
+            for (const auto& [name, value] : entry["headers"].items()) {
+                if (!value.is_string()) continue;
+                sub.request.headers.erase(name);
+                sub.request.add_header(name, value.get<std::string>());
+            }
+        }
+    }
+
+    AdmissionControl& admission = app_->get_middleware<AdmissionControl>();
+    DbExecutor::getInstance().parallel(batch.size(), [this, &batch, &admission](size_t i) {
+        SubRequest& sub = batch[i];
+        auto& metrics = Metrics::getInstance();
+        const auto started = std::chrono::steady_clock::now();
+        const uint16_t route = metrics.routeSlot("GET", sub.request.url);
+        metrics.requestStarted();
+        Span span("http.batch_request");
+        span.setAttribute("http.url", sub.request.raw_url);
+
+        // Charged to the client and its route class like the request it stands for
+        AdmissionControl::context admitted;
+        admission.before_handle(sub.request, sub.response, admitted);
+        if (!sub.response.is_completed()) {
+            try {
+                app_->handle_full(sub.request, sub.response);
+            } catch (const std::exception& e) {
+                logger_->error("Batch sub-request {} failed: {}", sub.request.raw_url, e.what());
+                sub.response = errorResponse(500, "Internal server error");
+            }
+            admission.after_handle(sub.request, sub.response, admitted);
+        }
+        span.setAttribute("http.status_code", static_cast<int64_t>(sub.response.code));
+        metrics.requestFinished(route, sub.response.code, std::chrono::steady_clock::now() - started);
+    });
+
+    std::string out;
+    JsonWriter writer(out);
+    writer.beginObject().rawKey("responses").beginArray();
+    for (const SubRequest& sub : batch) {
+        const crow::response& res = sub.response;
+        writer.beginObject();
+        writer.rawField("id", sub.id);
+        writer.rawField("status", res.code);
+        writer.rawKey("headers").beginObject();
+        for (const auto& [name, value] : res.headers) {
+            writer.field(name, value);
+        }
+        writer.endObject();
+        if (res.body.empty()) {
+            writer.rawKey("body").nullValue();
+        } else if (isJson(res) && JsonWriter::looksLikeContainer(res.body)) {
+            writer.rawKey("body").raw(res.body);
+        } else if (isText(res)) {
+            writer.rawField("body", res.body);
+        } else {
+            writer.rawField("body", crow::utility::base64encode(res.body, res.body.size()));
+            writer.rawField("body_encoding", "base64");
+        }
+        writer.endObject();
+    }
+    writer.endArray().endObject();
+
+    crow::response res(200, std::move(out));
+    res.add_header("Content-Type", "application/json");
+    return res;
+}
+
+crow::response BatchController::errorResponse(int code, const std::string& message) {
+    nlohmann::json response;
+    response["error"] = true;
+    response["message"] = message;
+
+    crow::response res(code, response.dump());
+    res.add_header("Content-Type", "application/json");
+    return res;
+}
+
+} // namespace aeronautical
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <crow.h>
+#include "HttpApp.h"
+#include <json.hpp>
+#include <memory>
+#include <spdlog/spdlog.h>
+
+namespace aeronautical {
+
+// POST /api/batch: several GET requests in one round trip, for the
+// frontend's startup fan-out. Sub-requests go through the app's router
+// in parallel on the DB threads and come back in request order in one
+// envelope. The middlewares are not applied to them; instead each one is
+// admitted by AdmissionControl (a token of the client's bucket and a slot
+// of its route class, a 429 or 503 in its place otherwise), counted in
+// Metrics under its own route and traced as a span of the batch.
+// Sub-requests missing on the same result cache key share a single load.
+class BatchController {
+public:
+    static constexpr size_t kMaxRequests = 32;
+
+    BatchController();
+    ~BatchController() = default;
+
+    void registerRoutes(HttpApp& app);
+
+private:
+    std::shared_ptr<spdlog::logger> logger_;
+    HttpApp* app_ = nullptr;
+
+    crow::response runBatch(const crow::request& req);
+
+    crow::response errorResponse(int code, const std::string& message);
+};
+
+} // namespace aeronautical
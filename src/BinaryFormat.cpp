@@ -0,0 +1,134 @@
+#include "BinaryFormat.h"
+#include <algorithm>
+#include <cstdlib>
+
+namespace aeronautical {
+
+namespace {
+
+char asciiLower(char c) { return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c; }
+
+std::string_view trim(std::string_view text) {
+    while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) text.remove_prefix(1);
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\t')) text.remove_suffix(1);
+    return text;
+}
+
+bool isJsonType(std::string_view content_type) {
+    // Handlers that set no type send JSON
+    if (content_type.empty()) return true;
+    std::string lower(content_type.substr(0, content_type.find(';')));
+    std::transform(lower.begin(), lower.end(), lower.begin(), asciiLower);
+    lower = std::string(trim(lower));
+    return lower == "application/json" || lower == "application/geo+json";
+}
+
+} // namespace
+
+void BinaryFormat::configure(const BinaryFormatSettings& settings) {
+    settings_ = settings;
+    cache_.setCapacity(settings.cache_bytes);
+}
+
+BinaryFormat::Format BinaryFormat::negotiate(std::string_view accept) {
+    // -1: not named; wildcards only ever select JSON
+    double q_cbor = -1, q_msgpack = -1, q_json = -1;
+    while (!accept.empty()) {
+        size_t comma = accept.find(',');
+        std::string_view item = trim(accept.substr(0, comma));
+        accept = comma == std::string_view::npos ? std::string_view{} : accept.substr(comma + 1);
+
+        size_t semi = item.find(';');
+        std::string type(trim(item.substr(0, semi)));
+        std::transform(type.begin(), type.end(), type.begin(), asciiLower);
+        double q = 1.0;
+        while (semi != std::string_view::npos) {
+            item = item.substr(semi + 1);
+            semi = item.find(';');
+            std::string_view param = trim(item.substr(0, semi));
+            if (param.size() > 2 && asciiLower(param[0]) == 'q' && param[1] == '=') {
+                q = std::strtod(std::string(param.substr(2)).c_str(), nullptr);
+            }
+        }
+        if (type == "application/cbor") q_cbor = q;
+        else if (type == "application/msgpack" || type == "application/x-msgpack" || type == "application/vnd.msgpack") q_msgpack = q;
+        else if (type == "application/json" || type == "application/geo+json") q_json = std::max(q_json, q);
+    }
+
+    // JSON wins ties so a browser's broad Accept never changes the format
+    if (q_cbor > 0 && q_cbor > q_json && q_cbor >= q_msgpack) return Format::Cbor;
+    if (q_msgpack > 0 && q_msgpack > q_json) return Format::MessagePack;
+    return Format::Json;
+}
+
+std::string BinaryFormat::encode(std::string_view json_body, Format format) {
+    if (format == Format::Json) {
+        return {};
+    }
+    nlohmann::json document = nlohmann::json::parse(json_body, nullptr, false);
+    if (document.is_discarded()) {
+        return {};
+    }
+    std::string out;
+    if (format == Format::Cbor) {
+        nlohmann::json::to_cbor(document, out);
+    } else {
+        nlohmann::json::to_msgpack(document, out);
+    }
+    return out;
+}
+
+const char* BinaryFormat::contentType(Format format) {
+    switch (format) {
+        case Format::Cbor: return "application/cbor";
+        case Format::MessagePack: return "application/msgpack";
+        default: return "application/json";
+    }
+}
+
+void BinaryFormat::before_handle(crow::request&, crow::response&, context&) {}
+
+void BinaryFormat::after_handle(crow::request& req, crow::response& res, context&) {
+    if (!settings_.enabled || res.body.empty() || res.is_static_type() ||
+        !res.get_header_value("Content-Encoding").empty() || !isJsonType(res.get_header_value("Content-Type"))) {
+        return;
+    }
+    res.add_header("Vary", "Accept");
+    Format format = negotiate(req.get_header_value("Accept"));
+    if (format == Format::Json) {
+        return;
+    }
+
+    const std::string& etag = res.get_header_value("ETag");
+    std::string key;
+    if (!etag.empty() && settings_.cache_bytes > 0) {
+        key = std::string(contentType(format)) + " " + etag + " " + req.raw_url;
+        if (auto hit = cache_.get(key)) {
+            cache_hits_.fetch_add(1, std::memory_order_relaxed);
+            res.body = *hit;
+            res.set_header("Content-Type", contentType(format));
+            return;
+        }
+    }
+
+    std::string encoded = encode(res.body, format);
+    if (encoded.empty()) {
+        return;
+    }
+    encoded_.fetch_add(1, std::memory_order_relaxed);
+    if (!key.empty()) {
+        cache_.put(key, std::make_shared<const std::string>(encoded));
+    }
+    res.body = std::move(encoded);
+    res.set_header("Content-Type", contentType(format));
+}
+
+nlohmann::json BinaryFormat::stats() const {
+    nlohmann::json j;
+    j["enabled"] = settings_.enabled;
+    j["encoded_responses"] = encoded_.load(std::memory_order_relaxed);
+    j["cache_hits"] = cache_hits_.load(std::memory_order_relaxed);
+    return j;
+}
+
+} // namespace aeronautical
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "BodyCache.h"
+#include <crow.h>
+#include <json.hpp>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace aeronautical {
+
+struct BinaryFormatSettings {
+    bool enabled = true;
+    size_t cache_bytes = 32u << 20;  // encoded bodies of ETag-tagged responses
+};
+
+// Crow middleware that re-encodes JSON response bodies as CBOR or
+// MessagePack when the client's Accept header prefers one of them.
+// Handlers keep producing JSON text; only the wire form changes. As with
+// ResponseCompression, the encoded form of an ETag-tagged body is cached.
+// It must run before compression, i.e. be listed after it in HttpApp.
+class BinaryFormat {
+public:
+    enum class Format { Json, Cbor, MessagePack };
+
+    struct context {};
+
+    void configure(const BinaryFormatSettings& settings);
+
+    void before_handle(crow::request& req, crow::response& res, context& ctx);
+    void after_handle(crow::request& req, crow::response& res, context& ctx);
+
+    // Json unless a binary type is acceptable and not ranked below JSON
+    static Format negotiate(std::string_view accept);
+    // Empty when the body is not valid JSON
+    static std::string encode(std::string_view json_body, Format format);
+    static const char* contentType(Format format);
+
+    nlohmann::json stats() const;
+    // Encoded bodies kept for reuse
+    BodyCache& cache() { return cache_; }
+
+private:
+    BinaryFormatSettings settings_;
+    BodyCache cache_;
+
+    std::atomic<uint64_t> encoded_{0};
+    std::atomic<uint64_t> cache_hits_{0};
+};
+
+} // namespace aeronautical
@@ -0,0 +1,55 @@
+#include "BodyCache.h"
+
+namespace aeronautical {
+
+void BodyCache::setCapacity(size_t bytes) {
+    std::lock_guard lock(mutex_);
+    capacity_ = bytes;
+    evictLocked(capacity_);
+}
+
+size_t BodyCache::bytes() const {
+    std::lock_guard lock(mutex_);
+    return size_;
+}
+
+size_t BodyCache::trim(size_t target) {
+    std::lock_guard lock(mutex_);
+    const size_t before = size_;
+    evictLocked(target);
+    return before - size_;
+}
+
+void BodyCache::evictLocked(size_t limit) {
+    while (size_ > limit && !lru_.empty()) {
+        size_ -= lru_.back().second->size();
+        index_.erase(lru_.back().first);
+        lru_.pop_back();
+    }
+}
+
+std::shared_ptr<const std::string> BodyCache::get(const std::string& key) {
+    std::lock_guard lock(mutex_);
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+        return nullptr;
+    }
+    lru_.splice(lru_.begin(), lru_, it->second);
+    return it->second->second;
+}
+
+void BodyCache::put(const std::string& key, std::shared_ptr<const std::string> body) {
+    std::lock_guard lock(mutex_);
+    if (body->size() > capacity_ / 4) {
+        return; // one body should not flush the whole cache
+    }
+    if (index_.count(key)) {
+        return;
+    }
+    size_ += body->size();
+    lru_.emplace_front(key, std::move(body));
+    index_[key] = lru_.begin();
+    evictLocked(capacity_);
+}
+
+} // namespace aeronautical
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "LockStats.h"
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace aeronautical {
+
+// Byte-bounded LRU of encoded response bodies shared by the response
+// middlewares. Keys name the encoding, ETag and URL, so an entry never
+// goes stale; it only ages out.
+class BodyCache {
+public:
+    void setCapacity(size_t bytes);
+    size_t bytes() const;
+    // Drops least recent bodies until at most target bytes are held, without
+    // lowering the capacity; returns the bytes dropped
+    size_t trim(size_t target);
+
+    std::shared_ptr<const std::string> get(const std::string& key);
+    void put(const std::string& key, std::shared_ptr<const std::string> body);
+
+private:
+    // Front is most recent
+    using List = std::list<std::pair<std::string, std::shared_ptr<const std::string>>>;
+    void evictLocked(size_t limit);
+
+    mutable InstrumentedMutex<std::mutex> mutex_{"body_cache"};
+    List lru_;
+    std::unordered_map<std::string, List::iterator> index_;
+    size_t size_ = 0;
+    size_t capacity_ = 0;
+};
+
+} // namespace aeronautical
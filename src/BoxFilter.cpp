@@ -0,0 +1,145 @@
+#include "BoxFilter.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define AERONAUTICAL_BOX_AVX2 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define AERONAUTICAL_BOX_NEON 1
+#endif
+
+namespace aeronautical {
+
+namespace {
+
+// One box as up to two longitude ranges; a single range is repeated
+struct Box {
+    double min_lat, max_lat;
+    double min_lng0, max_lng0;
+    double min_lng1, max_lng1;
+};
+
+Box flatten(const GeoBounds& bounds) {
+    const auto& first = bounds.lng_ranges.front();
+    const auto& second = bounds.lng_ranges.back();
+    return Box{bounds.min_lat, bounds.max_lat, first.min, first.max, second.min, second.max};
+}
+
+size_t selectScalar(const double* lat, const double* lng, size_t n, const Box& box, uint32_t* out, size_t start = 0) {
+    size_t count = 0;
+    for (size_t i = start; i < n; i++) {
+        bool in_lat = (lat[i] >= box.min_lat) & (lat[i] <= box.max_lat);
+        bool in_lng = ((lng[i] >= box.min_lng0) & (lng[i] <= box.max_lng0)) |
+                      ((lng[i] >= box.min_lng1) & (lng[i] <= box.max_lng1));
+        out[count] = static_cast<uint32_t>(i);
+        count += in_lat & in_lng;
+    }
+    return count;
+}
+
+#if AERONAUTICAL_BOX_AVX2
+__attribute__((target("avx2"))) size_t selectAvx2(const double* lat, const double* lng, size_t n, const Box& box,
+                                                  uint32_t* out) {
+    const __m256d min_lat = _mm256_set1_pd(box.min_lat);
+    const __m256d max_lat = _mm256_set1_pd(box.max_lat);
+    const __m256d min_lng0 = _mm256_set1_pd(box.min_lng0);
+    const __m256d max_lng0 = _mm256_set1_pd(box.max_lng0);
+    const __m256d min_lng1 = _mm256_set1_pd(box.min_lng1);
+    const __m256d max_lng1 = _mm256_set1_pd(box.max_lng1);
+
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d la = _mm256_loadu_pd(lat + i);
+        __m256d lo = _mm256_loadu_pd(lng + i);
+        // Ordered compares: NaN is never inside
+        __m256d in_lat = _mm256_and_pd(_mm256_cmp_pd(la, min_lat, _CMP_GE_OQ), _mm256_cmp_pd(la, max_lat, _CMP_LE_OQ));
+        __m256d in0 = _mm256_and_pd(_mm256_cmp_pd(lo, min_lng0, _CMP_GE_OQ), _mm256_cmp_pd(lo, max_lng0, _CMP_LE_OQ));
+        __m256d in1 = _mm256_and_pd(_mm256_cmp_pd(lo, min_lng1, _CMP_GE_OQ), _mm256_cmp_pd(lo, max_lng1, _CMP_LE_OQ));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_pd(_mm256_and_pd(in_lat, _mm256_or_pd(in0, in1))));
+        while (mask) {
+            out[count++] = static_cast<uint32_t>(i + __builtin_ctz(mask));
+            mask &= mask - 1;
+        }
+    }
+    // Leave no dirty upper state behind for the SSE code that follows
+    _mm256_zeroupper();
+    return count + selectScalar(lat, lng, n, box, out + count, i);
+}
+#endif
+
+#if AERONAUTICAL_BOX_NEON
+size_t selectNeon(const double* lat, const double* lng, size_t n, const Box& box, uint32_t* out) {
+    const float64x2_t min_lat = vdupq_n_f64(box.min_lat);
+    const float64x2_t max_lat = vdupq_n_f64(box.max_lat);
+    const float64x2_t min_lng0 = vdupq_n_f64(box.min_lng0);
+    const float64x2_t max_lng0 = vdupq_n_f64(box.max_lng0);
+    const float64x2_t min_lng1 = vdupq_n_f64(box.min_lng1);
+    const float64x2_t max_lng1 = vdupq_n_f64(box.max_lng1);
+
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        float64x2_t la = vld1q_f64(lat + i);
+        float64x2_t lo = vld1q_f64(lng + i);
+        uint64x2_t in_lat = vandq_u64(vcgeq_f64(la, min_lat), vcleq_f64(la, max_lat));
+        uint64x2_t in0 = vandq_u64(vcgeq_f64(lo, min_lng0), vcleq_f64(lo, max_lng0));
+        uint64x2_t in1 = vandq_u64(vcgeq_f64(lo, min_lng1), vcleq_f64(lo, max_lng1));
+        uint64x2_t in = vandq_u64(in_lat, vorrq_u64(in0, in1));
+        out[count] = static_cast<uint32_t>(i);
+        count += vgetq_lane_u64(in, 0) & 1;
+        out[count] = static_cast<uint32_t>(i + 1);
+        count += vgetq_lane_u64(in, 1) & 1;
+    }
+    return count + selectScalar(lat, lng, n, box, out + count, i);
+}
+#endif
+
+BoxFilter::Kernel detect() {
+#if AERONAUTICAL_BOX_AVX2
+    if (__builtin_cpu_supports("avx2")) return BoxFilter::Kernel::Avx2;
+#elif AERONAUTICAL_BOX_NEON
+    return BoxFilter::Kernel::Neon;
+#endif
+    return BoxFilter::Kernel::Scalar;
+}
+
+} // namespace
+
+BoxFilter::Kernel BoxFilter::active() {
+    static const Kernel kernel = detect();
+    return kernel;
+}
+
+const char* BoxFilter::name(Kernel kernel) {
+    switch (kernel) {
+        case Kernel::Avx2: return "avx2";
+        case Kernel::Neon: return "neon";
+        default: return "scalar";
+    }
+}
+
+size_t BoxFilter::select(const double* lat, const double* lng, size_t n, const GeoBounds& bounds, uint32_t* out) {
+    return select(active(), lat, lng, n, bounds, out);
+}
+
+size_t BoxFilter::select(Kernel kernel, const double* lat, const double* lng, size_t n, const GeoBounds& bounds,
+                         uint32_t* out) {
+    if (bounds.lng_ranges.empty()) {
+        return 0;
+    }
+    Box box = flatten(bounds);
+    if (kernel == Kernel::Avx2 && active() == Kernel::Avx2) {
+#if AERONAUTICAL_BOX_AVX2
+        return selectAvx2(lat, lng, n, box, out);
+#endif
+    }
+    if (kernel == Kernel::Neon && active() == Kernel::Neon) {
+#if AERONAUTICAL_BOX_NEON
+        return selectNeon(lat, lng, n, box, out);
+#endif
+    }
+    return selectScalar(lat, lng, n, box, out);
+}
+
+} // namespace aeronautical
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "SpatialGrid.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace aeronautical {
+
+// "Which of these points lie in this box" over latitude/longitude columns.
+// An AVX2 (x86-64) or NEON (aarch64) kernel is picked once at startup from
+// what the CPU supports, with a scalar loop everywhere else. All kernels
+// give the same answer as GeoBounds::contains, NaN coordinates included.
+class BoxFilter {
+public:
+    enum class Kernel { Scalar, Avx2, Neon };
+
+    // Writes the positions i in [0, n) whose point is inside bounds to out,
+    // ascending, and returns how many; out needs room for n entries
+    static size_t select(const double* lat, const double* lng, size_t n, const GeoBounds& bounds, uint32_t* out);
+
+    // Same, forced through one kernel (benchmarks); falls back to scalar if unsupported
+    static size_t select(Kernel kernel, const double* lat, const double* lng, size_t n, const GeoBounds& bounds,
+                         uint32_t* out);
+
+    static Kernel active();
+    static const char* name(Kernel kernel);
+};
+
+} // namespace aeronautical
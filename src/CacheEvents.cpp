@@ -0,0 +1,238 @@
+#include "CacheEvents.h"
+#include "ChangeLog.h"
+#include "DatabaseManager.h"
+#include "ListPage.h"
+#include "ProtectionGeometryCache.h"
+#include "ReferenceDataStore.h"
+#include "ResultCache.h"
+#include "SchemaMigrations.h"
+#include "SimplifiedGeometryCache.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+
+namespace aeronautical {
+
+namespace {
+
+const char* kindName(CacheEvents::Kind kind) {
+    switch (kind) {
+        case CacheEvents::Kind::Inserted: return "inserted";
+        case CacheEvents::Kind::Updated: return "updated";
+        case CacheEvents::Kind::Deleted: return "deleted";
+    }
+    return "updated";
+}
+
+// Rows of one INSERT, written in batches of kBatchSize
+void insertEvents(const std::string& origin, const std::string& table, const std::string& kind,
+                  const std::vector<CacheEvents::ProcedureChange>& changes) {
+    auto& db = DatabaseManager::getInstance();
+    const std::string head = "INSERT INTO cache_events (origin, table_name, kind, row_id, airport_icao, created_at) VALUES ";
+    for (size_t start = 0; start < changes.size(); start += CacheEvents::kBatchSize) {
+        const size_t end = std::min(changes.size(), start + CacheEvents::kBatchSize);
+        std::string sql = head;
+        std::vector<SqlParam> params;
+        params.reserve((end - start) * 5);
+        for (size_t i = start; i < end; i++) {
+            if (i > start) sql += ", ";
+            sql += "(?, ?, ?, ?, ?, NOW(3))";
+            params.emplace_back(origin);
+            params.emplace_back(table);
+            params.emplace_back(kind);
+            params.emplace_back(changes[i].id > 0 ? SqlParam(static_cast<int64_t>(changes[i].id)) : SqlParam(nullptr));
+            params.emplace_back(changes[i].airport_icao.empty() ? SqlParam(nullptr) : SqlParam(changes[i].airport_icao));
+        }
+        db.executePrepared(sql, params);
+    }
+}
+
+} // namespace
+
+CacheEvents& CacheEvents::getInstance() {
+    static CacheEvents instance;
+    return instance;
+}
+
+CacheEvents::~CacheEvents() {
+    stop();
+}
+
+bool CacheEvents::probeTable() {
+    static std::once_flag once;
+    static bool available = false;
+
+    std::call_once(once, []() {
+        available = SchemaMigrations::hasTable("cache_events");
+        spdlog::info("Cache invalidations {}", available ? "shared through cache_events" : "local to this instance");
+    });
+
+    return available;
+}
+
+void CacheEvents::start(std::string origin, std::chrono::milliseconds poll_interval) {
+    if (poll_interval.count() <= 0 || !probeTable()) {
+        return;
+    }
+    try {
+        auto newest = DatabaseManager::getInstance().executePrepared("SELECT COALESCE(MAX(id), 0) FROM cache_events");
+        last_id_ = newest.rows.empty() ? 0 : static_cast<uint64_t>(newest.rows[0].getInt(0));
+    } catch (const std::exception& e) {
+        spdlog::error("Could not read cache_events, invalidations stay local: {}", e.what());
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(thread_mutex_);
+    if (poll_thread_.joinable()) {
+        return;
+    }
+    origin_ = std::move(origin);
+    poll_interval_ = poll_interval;
+    stopping_ = false;
+    enabled_.store(true, std::memory_order_release);
+    poll_thread_ = std::thread([this]() { pollLoop(); });
+    spdlog::info("Cache events polled every {} ms as {}", poll_interval_.count(), origin_);
+}
+
+void CacheEvents::stop() {
+    {
+        std::lock_guard<std::mutex> lock(thread_mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    if (poll_thread_.joinable()) {
+        poll_thread_.join();
+    }
+    enabled_.store(false, std::memory_order_release);
+}
+
+void CacheEvents::publishProcedures(Kind kind, const std::vector<ProcedureChange>& changes) {
+    if (!enabled() || changes.empty()) {
+        return;
+    }
+    try {
+        insertEvents(origin_, "procedures", kindName(kind), changes);
+        published_.fetch_add(changes.size(), std::memory_order_relaxed);
+    } catch (const std::exception& e) {
+        publish_failures_.fetch_add(1, std::memory_order_relaxed);
+        spdlog::error("Could not publish {} procedure changes to other instances: {}", changes.size(), e.what());
+    }
+}
+
+void CacheEvents::publishReload(const std::string& table) {
+    if (!enabled()) {
+        return;
+    }
+    try {
+        insertEvents(origin_, table, "reloaded", {ProcedureChange{}});
+        published_.fetch_add(1, std::memory_order_relaxed);
+    } catch (const std::exception& e) {
+        publish_failures_.fetch_add(1, std::memory_order_relaxed);
+        spdlog::error("Could not publish the {} reload to other instances: {}", table, e.what());
+    }
+}
+
+void CacheEvents::pollLoop() {
+    auto next_prune = std::chrono::steady_clock::now();
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(thread_mutex_);
+            wake_.wait_for(lock, poll_interval_, [this]() { return stopping_; });
+            if (stopping_) {
+                return;
+            }
+        }
+        // A full batch means more are waiting
+        while (poll()) {
+        }
+        if (std::chrono::steady_clock::now() >= next_prune) {
+            prune();
+            next_prune = std::chrono::steady_clock::now() + std::chrono::minutes(10);
+        }
+    }
+}
+
+bool CacheEvents::poll() {
+    PreparedResult events;
+    try {
+        events = DatabaseManager::getInstance().executePrepared(
+            "SELECT id, origin, table_name, kind, row_id, airport_icao FROM cache_events WHERE id > ? ORDER BY id LIMIT ?",
+            {static_cast<int64_t>(last_id_), static_cast<int64_t>(kBatchSize)});
+    } catch (const std::exception& e) {
+        poll_failures_.fetch_add(1, std::memory_order_relaxed);
+        spdlog::warn("Could not read cache_events: {}", e.what());
+        return false;
+    }
+
+    std::vector<int> inserted, updated, deleted;
+    std::vector<std::string> tags;
+    bool reload_reference = false;
+    size_t applied = 0;
+    for (const auto& row : events.rows) {
+        last_id_ = std::max(last_id_, static_cast<uint64_t>(row.getInt(0)));
+        if (row.getString(1) == origin_) continue;
+        applied++;
+
+        const std::string table = row.getString(2);
+        if (table != "procedures") {
+            reload_reference = true;
+            continue;
+        }
+        const std::string kind = row.getString(3);
+        const int id = static_cast<int>(row.getInt(4));
+        if (id <= 0) continue;
+        auto& ids = kind == "inserted" ? inserted : kind == "deleted" ? deleted : updated;
+        ids.push_back(id);
+        if (kind != "inserted") tags.push_back(ResultCache::procedureTag(id));
+        if (auto airport = row.getOptionalString(5)) tags.push_back(ResultCache::airportTag(*airport));
+    }
+
+    // The same invalidations FlightProcedureController makes for a local write
+    if (!inserted.empty() || !updated.empty() || !deleted.empty()) {
+        std::vector<int> changed = inserted;
+        changed.insert(changed.end(), updated.begin(), updated.end());
+        changed.insert(changed.end(), deleted.begin(), deleted.end());
+        ProtectionGeometryCache::getInstance().invalidate(changed);
+        for (int id : changed) SimplifiedGeometryCache::getInstance().invalidate(id);
+        if (!inserted.empty() || !deleted.empty()) {
+            ListCountCache::getInstance().bump(ListCountCache::Table::Procedures);
+        }
+        ChangeLog::getInstance().record(ChangeLog::Table::Procedures, std::move(inserted), std::move(updated),
+                                        std::move(deleted));
+        ResultCache::getInstance().invalidate(tags);
+    }
+    if (reload_reference && ReferenceDataStore::getInstance().snapshot()) {
+        ReferenceDataStore::getInstance().refresh();
+    }
+    if (applied > 0) {
+        applied_.fetch_add(applied, std::memory_order_relaxed);
+        spdlog::debug("Applied {} cache events from other instances", applied);
+    }
+    return events.rows.size() == kBatchSize;
+}
+
+void CacheEvents::prune() {
+    try {
+        auto pruned = DatabaseManager::getInstance().executePrepared(
+            "DELETE FROM cache_events WHERE created_at < NOW(3) - INTERVAL ? SECOND",
+            {static_cast<int64_t>(std::chrono::seconds(kRetention).count())});
+        if (pruned.affected_rows > 0) {
+            spdlog::debug("Pruned {} old cache events", pruned.affected_rows);
+        }
+    } catch (const std::exception& e) {
+        spdlog::warn("Could not prune cache_events: {}", e.what());
+    }
+}
+
+nlohmann::json CacheEvents::status() const {
+    nlohmann::json j;
+    j["enabled"] = enabled();
+    j["published"] = published_.load(std::memory_order_relaxed);
+    j["applied"] = applied_.load(std::memory_order_relaxed);
+    j["publish_failures"] = publish_failures_.load(std::memory_order_relaxed);
+    j["poll_failures"] = poll_failures_.load(std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(thread_mutex_);
+    j["poll_interval_ms"] = poll_interval_.count();
+    return j;
+}
+
+} // namespace aeronautical
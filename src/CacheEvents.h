@@ -0,0 +1,92 @@
+#pragma once
+
+#include <json.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace aeronautical {
+
+// Cache invalidations shared between backend instances through MySQL. An
+// instance that changes procedures or reference tables invalidates its own
+// caches as before, then appends what it changed here; every other instance
+// polls the table and applies the same targeted invalidations, so caches
+// can keep long TTLs without serving another node's stale data. Used when
+// the table exists:
+//
+//   CREATE TABLE cache_events (
+//     id BIGINT UNSIGNED AUTO_INCREMENT PRIMARY KEY,
+//     origin VARCHAR(64) NOT NULL,
+//     table_name ENUM('airports','waypoints','procedures') NOT NULL,
+//     kind ENUM('inserted','updated','deleted','reloaded') NOT NULL,
+//     row_id INT NULL,
+//     airport_icao VARCHAR(8) NULL,
+//     created_at DATETIME(3) NOT NULL,
+//     KEY idx_cache_events_created (created_at)
+//   );
+//
+// An instance starts reading after the newest event at start, since its
+// caches are empty then. Events are deleted after kRetention.
+class CacheEvents {
+public:
+    enum class Kind { Inserted, Updated, Deleted };
+
+    struct ProcedureChange {
+        int id = 0;
+        std::string airport_icao; // empty when unknown
+    };
+
+    static constexpr std::chrono::hours kRetention{1};
+    static constexpr size_t kBatchSize = 500;
+
+    static CacheEvents& getInstance();
+
+    CacheEvents(const CacheEvents&) = delete;
+    CacheEvents& operator=(const CacheEvents&) = delete;
+
+    // Checks once whether the cache_events table exists
+    static bool probeTable();
+
+    // origin names this process in the events it writes, which it skips when
+    // reading them back; it must differ between running instances
+    void start(std::string origin, std::chrono::milliseconds poll_interval);
+    void stop();
+    bool enabled() const { return enabled_.load(std::memory_order_acquire); }
+
+    // Tell the other instances; a failure is logged, never thrown
+    void publishProcedures(Kind kind, const std::vector<ProcedureChange>& changes);
+    // The table was reloaded; other instances reload their reference snapshot
+    void publishReload(const std::string& table);
+
+    nlohmann::json status() const;
+
+private:
+    CacheEvents() = default;
+    ~CacheEvents();
+
+    void pollLoop();
+    // Applies the events of other instances written since the last poll
+    bool poll();
+    void prune();
+
+    std::string origin_;
+    std::atomic<bool> enabled_{false};
+    uint64_t last_id_ = 0; // poll thread only
+    std::atomic<uint64_t> published_{0};
+    std::atomic<uint64_t> applied_{0};
+    std::atomic<uint64_t> poll_failures_{0};
+    std::atomic<uint64_t> publish_failures_{0};
+
+    mutable std::mutex thread_mutex_;
+    std::condition_variable wake_;
+    std::thread poll_thread_;
+    std::chrono::milliseconds poll_interval_{0};
+    bool stopping_ = false;
+};
+
+} // namespace aeronautical
@@ -0,0 +1,173 @@
+#include "ChangeLog.h"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <unordered_map>
+
+namespace aeronautical {
+
+namespace {
+
+uint64_t wallClockMs() {
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(now).count());
+}
+
+enum class Net { Inserted, Updated, Deleted };
+
+} // namespace
+
+nlohmann::json ChangeSet::toJson() const {
+    return nlohmann::json{
+        {"since", since},
+        {"version", version},
+        {"reset", reset},
+        {"inserted", inserted},
+        {"updated", updated},
+        {"deleted", deleted},
+    };
+}
+
+ChangeLog& ChangeLog::getInstance() {
+    static ChangeLog instance;
+    return instance;
+}
+
+ChangeLog::ChangeLog() : version_(wallClockMs()) {
+    for (auto& history : tables_) {
+        history.base = version_;
+        history.latest = version_;
+    }
+}
+
+uint64_t ChangeLog::version() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return version_;
+}
+
+uint64_t ChangeLog::version(Table table) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return tables_[static_cast<size_t>(table)].latest;
+}
+
+uint64_t ChangeLog::nextVersion() {
+    version_ = std::max(version_ + 1, wallClockMs());
+    return version_;
+}
+
+uint64_t ChangeLog::record(Table table, std::vector<int> inserted, std::vector<int> updated,
+                           std::vector<int> deleted) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (inserted.empty() && updated.empty() && deleted.empty()) {
+        return version_;
+    }
+    History& history = tables_[static_cast<size_t>(table)];
+    Entry entry{nextVersion(), std::move(inserted), std::move(updated), std::move(deleted)};
+    history.ids += entry.inserted.size() + entry.updated.size() + entry.deleted.size();
+    history.entries.push_back(std::move(entry));
+    history.latest = version_;
+
+    // Forget the oldest batches; a client behind them reloads
+    while (history.ids > kMaxIdsPerTable && history.entries.size() > 1) {
+        const Entry& oldest = history.entries.front();
+        history.ids -= oldest.inserted.size() + oldest.updated.size() + oldest.deleted.size();
+        history.base = oldest.version;
+        history.entries.pop_front();
+    }
+    return version_;
+}
+
+uint64_t ChangeLog::restart(Table table) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    History& history = tables_[static_cast<size_t>(table)];
+    history.entries.clear();
+    history.ids = 0;
+    history.base = nextVersion();
+    history.latest = history.base;
+    return version_;
+}
+
+ChangeSet ChangeLog::changesSince(Table table, uint64_t since) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const History& history = tables_[static_cast<size_t>(table)];
+    ChangeSet changes;
+    changes.since = since;
+    changes.version = version_;
+    if (since < history.base || since > version_) {
+        changes.reset = true;
+        return changes;
+    }
+
+    // Fold the batches after since into one net change per id
+    std::unordered_map<int, Net> net;
+    for (auto it = std::upper_bound(history.entries.begin(), history.entries.end(), since,
+                                    [](uint64_t v, const Entry& e) { return v < e.version; });
+         it != history.entries.end(); ++it) {
+        for (int id : it->inserted) {
+            auto found = net.find(id);
+            // Deleted then inserted again reads as an update
+            net[id] = found != net.end() && found->second == Net::Deleted ? Net::Updated : Net::Inserted;
+        }
+        for (int id : it->updated) {
+            auto found = net.find(id);
+            if (found == net.end()) net.emplace(id, Net::Updated);
+        }
+        for (int id : it->deleted) {
+            auto found = net.find(id);
+            if (found != net.end() && found->second == Net::Inserted) {
+                net.erase(found); // never seen by this client
+            } else {
+                net[id] = Net::Deleted;
+            }
+        }
+    }
+
+    for (const auto& [id, change] : net) {
+        switch (change) {
+            case Net::Inserted: changes.inserted.push_back(id); break;
+            case Net::Updated: changes.updated.push_back(id); break;
+            case Net::Deleted: changes.deleted.push_back(id); break;
+        }
+    }
+    std::sort(changes.inserted.begin(), changes.inserted.end());
+    std::sort(changes.updated.begin(), changes.updated.end());
+    std::sort(changes.deleted.begin(), changes.deleted.end());
+    return changes;
+}
+
+std::optional<uint64_t> ChangeLog::parseVersion(const char* text) {
+    if (!text) {
+        return std::nullopt;
+    }
+    uint64_t value = 0;
+    const char* end = text + std::strlen(text);
+    auto res = std::from_chars(text, end, value);
+    if (res.ec != std::errc() || res.ptr != end) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+std::optional<std::vector<int>> ChangeLog::parseIds(const char* text) {
+    if (!text) {
+        return std::nullopt;
+    }
+    std::vector<int> ids;
+    const char* end = text + std::strlen(text);
+    for (const char* p = text; p < end;) {
+        int id = 0;
+        auto res = std::from_chars(p, end, id);
+        if (res.ec != std::errc() || ids.size() == kMaxIds) {
+            return std::nullopt;
+        }
+        ids.push_back(id);
+        p = res.ptr;
+        if (p < end && (*p != ',' || ++p == end)) {
+            return std::nullopt;
+        }
+    }
+    return ids;
+}
+
+} // namespace aeronautical
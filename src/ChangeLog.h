@@ -0,0 +1,86 @@
+#pragma once
+
+#include <json.hpp>
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace aeronautical {
+
+// Net row changes of one table between two data versions
+struct ChangeSet {
+    uint64_t since = 0;
+    uint64_t version = 0;
+    // since is older than the kept history (or unknown): reload everything
+    bool reset = false;
+    std::vector<int> inserted;
+    std::vector<int> updated;
+    std::vector<int> deleted;
+
+    nlohmann::json toJson() const;
+};
+
+// Process-wide history of inserted, updated and deleted ids per table under
+// one data version that only grows. Versions are seeded from the wall clock
+// in milliseconds, so a version handed out before a restart is older than
+// any after it and simply asks the client to reload. History is bounded;
+// asking for changes since a version that has been dropped also resets.
+class ChangeLog {
+public:
+    enum class Table { Airports, Waypoints, Procedures };
+
+    static ChangeLog& getInstance();
+
+    ChangeLog(const ChangeLog&) = delete;
+    ChangeLog& operator=(const ChangeLog&) = delete;
+
+    uint64_t version() const;
+    // Version of the table's last recorded change (or restart)
+    uint64_t version(Table table) const;
+
+    // Records one batch and returns its version; an empty batch changes nothing
+    uint64_t record(Table table, std::vector<int> inserted, std::vector<int> updated, std::vector<int> deleted);
+
+    // The table was reloaded without a diff; every earlier version resets
+    uint64_t restart(Table table);
+
+    ChangeSet changesSince(Table table, uint64_t since) const;
+
+    // "since" query parameter; nullopt when missing or not a number
+    static std::optional<uint64_t> parseVersion(const char* text);
+
+    // "ids" query parameter of a delta fetch ("3,17,42"), at most kMaxIds;
+    // nullopt when malformed or too long
+    static constexpr size_t kMaxIds = 1000;
+    static std::optional<std::vector<int>> parseIds(const char* text);
+
+private:
+    ChangeLog();
+
+    static constexpr size_t kMaxIdsPerTable = 200000;
+
+    struct Entry {
+        uint64_t version = 0;
+        std::vector<int> inserted;
+        std::vector<int> updated;
+        std::vector<int> deleted;
+    };
+
+    struct History {
+        uint64_t base = 0; // entries hold every change after this version
+        uint64_t latest = 0;
+        std::deque<Entry> entries;
+        size_t ids = 0;
+    };
+
+    uint64_t nextVersion();
+
+    mutable std::mutex mutex_;
+    uint64_t version_ = 0;
+    std::array<History, 3> tables_;
+};
+
+} // namespace aeronautical
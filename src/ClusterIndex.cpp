@@ -0,0 +1,139 @@
+#include "ClusterIndex.h"
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+namespace aeronautical {
+
+namespace {
+
+constexpr double kMaxMercatorLat = 85.05112878;
+
+double mercatorX(double lng) {
+    return (lng + 180.0) / 360.0;
+}
+
+double mercatorY(double lat) {
+    double clamped = std::clamp(lat, -kMaxMercatorLat, kMaxMercatorLat);
+    double rad = clamped * M_PI / 180.0;
+    return (1.0 - std::log(std::tan(rad) + 1.0 / std::cos(rad)) / M_PI) / 2.0;
+}
+
+uint32_t cellIndex(double unit, uint32_t cells) {
+    double scaled = std::floor(unit * cells);
+    if (scaled < 0.0) return 0;
+    if (scaled >= cells) return cells - 1;
+    return static_cast<uint32_t>(scaled);
+}
+
+uint64_t cellKey(uint32_t x, uint32_t y) {
+    return (static_cast<uint64_t>(y) << 32) | x;
+}
+
+void addTypes(std::vector<std::pair<uint16_t, uint32_t>>& into, uint16_t type, uint32_t count) {
+    for (auto& entry : into) {
+        if (entry.first == type) {
+            entry.second += count;
+            return;
+        }
+    }
+    into.emplace_back(type, count);
+}
+
+} // namespace
+
+void ClusterIndex::build(const std::vector<Point>& points) {
+    levels_.assign(kMaxZoom + 1, {});
+    type_names_.clear();
+
+    std::unordered_map<std::string_view, uint16_t> type_ids;
+    const uint32_t finest = (1u << kMaxZoom) * kCellsPerTile;
+
+    // Finest level straight from the points
+    std::unordered_map<uint64_t, size_t> slots;
+    std::vector<Cell>& base = levels_[kMaxZoom];
+    for (const auto& p : points) {
+        if (!std::isfinite(p.lat) || !std::isfinite(p.lng)) {
+            continue;
+        }
+        auto [type_it, added] = type_ids.emplace(p.type, static_cast<uint16_t>(type_names_.size()));
+        if (added) {
+            type_names_.emplace_back(p.type);
+        }
+
+        uint32_t x = cellIndex(mercatorX(p.lng), finest);
+        uint32_t y = cellIndex(mercatorY(p.lat), finest);
+        auto [slot, inserted] = slots.emplace(cellKey(x, y), base.size());
+        if (inserted) {
+            base.push_back(Cell{y, x, 0, p.row, 0.0, 0.0, {}});
+        }
+        Cell& cell = base[slot->second];
+        cell.count++;
+        cell.first_row = std::min(cell.first_row, p.row);
+        cell.sum_lat += p.lat;
+        cell.sum_lng += p.lng;
+        addTypes(cell.type_counts, type_it->second, 1);
+    }
+
+    // Each coarser level merges 2x2 cells of the finer one
+    for (int zoom = kMaxZoom - 1; zoom >= 0; zoom--) {
+        slots.clear();
+        std::vector<Cell>& parents = levels_[zoom];
+        for (const Cell& child : levels_[zoom + 1]) {
+            uint32_t x = child.x >> 1;
+            uint32_t y = child.y >> 1;
+            auto [slot, inserted] = slots.emplace(cellKey(x, y), parents.size());
+            if (inserted) {
+                parents.push_back(Cell{y, x, 0, child.first_row, 0.0, 0.0, {}});
+            }
+            Cell& parent = parents[slot->second];
+            parent.count += child.count;
+            parent.first_row = std::min(parent.first_row, child.first_row);
+            parent.sum_lat += child.sum_lat;
+            parent.sum_lng += child.sum_lng;
+            for (const auto& [type, count] : child.type_counts) {
+                addTypes(parent.type_counts, type, count);
+            }
+        }
+    }
+
+    for (auto& level : levels_) {
+        std::sort(level.begin(), level.end(), [](const Cell& a, const Cell& b) {
+            return a.y != b.y ? a.y < b.y : a.x < b.x;
+        });
+    }
+}
+
+std::vector<ClusterIndex::Cluster> ClusterIndex::query(const GeoBounds& bounds, int zoom) const {
+    std::vector<Cluster> clusters;
+    if (levels_.empty()) {
+        return clusters;
+    }
+    zoom = std::clamp(zoom, 0, kMaxZoom);
+    const std::vector<Cell>& level = levels_[zoom];
+    const uint32_t cells = (1u << zoom) * kCellsPerTile;
+
+    // North is the smaller y
+    uint32_t y_first = cellIndex(mercatorY(bounds.max_lat), cells);
+    uint32_t y_last = cellIndex(mercatorY(bounds.min_lat), cells);
+    for (uint32_t y = y_first; y <= y_last; y++) {
+        for (const auto& range : bounds.lng_ranges) {
+            uint32_t x_first = cellIndex(mercatorX(range.min), cells);
+            uint32_t x_last = cellIndex(mercatorX(range.max), cells);
+            auto it = std::lower_bound(level.begin(), level.end(), std::make_pair(y, x_first),
+                                       [](const Cell& cell, const std::pair<uint32_t, uint32_t>& key) {
+                                           return cell.y != key.first ? cell.y < key.first : cell.x < key.second;
+                                       });
+            for (; it != level.end() && it->y == y && it->x <= x_last; ++it) {
+                const auto dominant = std::max_element(
+                    it->type_counts.begin(), it->type_counts.end(),
+                    [](const auto& a, const auto& b) { return a.second < b.second; });
+                clusters.push_back(Cluster{it->sum_lat / it->count, it->sum_lng / it->count, it->count,
+                                           it->first_row, &type_names_[dominant->first]});
+            }
+        }
+    }
+    return clusters;
+}
+
+} // namespace aeronautical
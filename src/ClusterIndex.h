@@ -0,0 +1,59 @@
+#pragma once
+
+#include "SpatialGrid.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace aeronautical {
+
+// Point clusters for zoomed-out map views. Points are binned into Web
+// Mercator cells of kCellsPerTile x kCellsPerTile per 256px tile (about
+// 64px each), so a response holds at most a few clusters per screen cell
+// however dense the data is. The finest level is binned from the points;
+// each coarser level merges 2x2 cells of the one below.
+class ClusterIndex {
+public:
+    static constexpr int kMaxZoom = 10;      // above this, callers return the rows themselves
+    static constexpr int kCellsPerTile = 4;
+
+    struct Point {
+        double lat;
+        double lng;
+        uint32_t row;          // caller's row index
+        std::string_view type; // grouping value reported as the dominant type
+    };
+
+    struct Cluster {
+        double latitude;  // centroid of the member points
+        double longitude;
+        uint32_t count;
+        uint32_t first_row;             // lowest member row; the row itself when count == 1
+        const std::string* dominant_type;
+    };
+
+    void build(const std::vector<Point>& points);
+
+    // Clusters in cells touching bounds at this zoom (0..kMaxZoom), ordered north to south, west to east
+    std::vector<Cluster> query(const GeoBounds& bounds, int zoom) const;
+
+    bool empty() const { return levels_.empty(); }
+
+private:
+    struct Cell {
+        uint32_t y;
+        uint32_t x;
+        uint32_t count;
+        uint32_t first_row;
+        double sum_lat;
+        double sum_lng;
+        std::vector<std::pair<uint16_t, uint32_t>> type_counts; // type id, members
+    };
+
+    std::vector<std::vector<Cell>> levels_; // by zoom, each sorted by (y, x)
+    std::vector<std::string> type_names_;
+};
+
+} // namespace aeronautical
@@ -0,0 +1,108 @@
+#include "ConditionalGet.h"
+#include "ReferenceDataStore.h"
+#include <ctime>
+
+namespace aeronautical {
+
+namespace {
+
+std::string_view trim(std::string_view text) {
+    while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) text.remove_prefix(1);
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\t')) text.remove_suffix(1);
+    return text;
+}
+
+std::string_view opaqueTag(std::string_view tag) {
+    if (tag.substr(0, 2) == "W/") tag.remove_prefix(2);
+    return tag;
+}
+
+// If-None-Match is "*" or a comma-separated list of entity tags
+bool matchesAny(std::string_view header, std::string_view etag) {
+    while (!header.empty()) {
+        size_t comma = header.find(',');
+        std::string_view candidate = trim(header.substr(0, comma));
+        if (candidate == "*" || opaqueTag(candidate) == opaqueTag(etag)) {
+            return true;
+        }
+        if (comma == std::string_view::npos) break;
+        header.remove_prefix(comma + 1);
+    }
+    return false;
+}
+
+} // namespace
+
+CacheValidator ConditionalGet::fromVersion(std::string_view scope, std::string_view version,
+                                           std::optional<std::chrono::system_clock::time_point> last_modified) {
+    CacheValidator validator;
+    validator.etag.reserve(scope.size() + version.size() + 3);
+    validator.etag += '"';
+    validator.etag += scope;
+    validator.etag += '-';
+    validator.etag += version;
+    validator.etag += '"';
+    validator.last_modified = last_modified;
+    return validator;
+}
+
+std::optional<CacheValidator> ConditionalGet::forReferenceData() {
+    auto snapshot = ReferenceDataStore::getInstance().snapshot();
+    if (!snapshot || snapshot->version == 0) {
+        return std::nullopt;
+    }
+    auto changed = std::chrono::system_clock::time_point(std::chrono::milliseconds(snapshot->version));
+    return fromVersion("ref", std::to_string(snapshot->version), changed);
+}
+
+bool ConditionalGet::isCurrent(const crow::request& req, const CacheValidator& validator) {
+    const std::string& if_none_match = req.get_header_value("If-None-Match");
+    if (!if_none_match.empty()) {
+        return matchesAny(if_none_match, validator.etag);
+    }
+    const std::string& if_modified_since = req.get_header_value("If-Modified-Since");
+    if (!if_modified_since.empty() && validator.last_modified) {
+        auto since = parseHttpDate(if_modified_since);
+        return since && std::chrono::floor<std::chrono::seconds>(*validator.last_modified) <= *since;
+    }
+    return false;
+}
+
+crow::response ConditionalGet::notModified(const CacheValidator& validator) {
+    crow::response res(304);
+    res.add_header("ETag", validator.etag);
+    if (validator.last_modified) {
+        res.add_header("Last-Modified", httpDate(*validator.last_modified));
+    }
+    return res;
+}
+
+void ConditionalGet::tag(crow::response& res, const CacheValidator& validator) {
+    if (res.code != 200) {
+        return;
+    }
+    res.set_header("ETag", validator.etag);
+    if (validator.last_modified) {
+        res.set_header("Last-Modified", httpDate(*validator.last_modified));
+    }
+}
+
+std::string ConditionalGet::httpDate(std::chrono::system_clock::time_point time) {
+    std::time_t seconds = std::chrono::system_clock::to_time_t(time);
+    std::tm tm{};
+    gmtime_r(&seconds, &tm);
+    char buffer[32];
+    size_t length = std::strftime(buffer, sizeof(buffer), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+    return std::string(buffer, length);
+}
+
+std::optional<std::chrono::system_clock::time_point> ConditionalGet::parseHttpDate(const std::string& text) {
+    std::tm tm{};
+    const char* end = strptime(text.c_str(), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+    if (!end) {
+        return std::nullopt;
+    }
+    return std::chrono::system_clock::from_time_t(timegm(&tm));
+}
+
+} // namespace aeronautical
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <crow.h>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace aeronautical {
+
+// What a GET response is validated against: a strong ETag and, when known,
+// the time the data last changed
+struct CacheValidator {
+    std::string etag; // quoted, e.g. "\"ref-1791234567890\""
+    std::optional<std::chrono::system_clock::time_point> last_modified;
+};
+
+// Conditional GET from data versions. Handlers name the version their
+// response is built from (reference snapshot, procedure updated_at, project
+// geometry revision) instead of hashing the body, so a client that already
+// holds that version gets a 304 before any repository query or serialization.
+class ConditionalGet {
+public:
+    // "\"<scope>-<version>\""; the same version must always give the same body
+    static CacheValidator fromVersion(std::string_view scope, std::string_view version,
+                                      std::optional<std::chrono::system_clock::time_point> last_modified = std::nullopt);
+
+    // The in-memory reference snapshot; nullopt while it is not loaded
+    static std::optional<CacheValidator> forReferenceData();
+
+    // If-None-Match matches (weak comparison, as RFC 9110 asks for GET), or
+    // without If-None-Match, If-Modified-Since is not older than last_modified
+    static bool isCurrent(const crow::request& req, const CacheValidator& validator);
+
+    static crow::response notModified(const CacheValidator& validator);
+
+    // Adds ETag and Last-Modified to a 200 response; other codes are left alone
+    static void tag(crow::response& res, const CacheValidator& validator);
+
+    // 304 when the client copy is current, otherwise handler() tagged with the validator
+    template <typename Handler>
+    static crow::response serve(const crow::request& req, const std::optional<CacheValidator>& validator,
+                                Handler&& handler) {
+        if (validator && isCurrent(req, *validator)) {
+            return notModified(*validator);
+        }
+        crow::response res = handler();
+        if (validator) {
+            tag(res, *validator);
+        }
+        return res;
+    }
+
+    // IMF-fixdate, second precision
+    static std::string httpDate(std::chrono::system_clock::time_point time);
+    static std::optional<std::chrono::system_clock::time_point> parseHttpDate(const std::string& text);
+};
+
+} // namespace aeronautical
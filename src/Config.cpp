@@ -0,0 +1,232 @@
+#include "Config.h"
+#include "Timestamp.h"
+#include "TokenVerifier.h"
+#include <spdlog/spdlog.h>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace aeronautical {
+
+namespace {
+
+crow::response jsonResponse(int code, const nlohmann::json& body) {
+    crow::response res(code, body.dump());
+    res.add_header("Content-Type", "application/json");
+    return res;
+}
+
+// Values never shown by GET /api/admin/config
+bool secret(const std::string& key) {
+    return key.find("PASS") != std::string::npos || key.find("SECRET") != std::string::npos;
+}
+
+} // namespace
+
+Config& Config::getInstance() {
+    static Config instance;
+    return instance;
+}
+
+bool Config::readFile(std::map<std::string, std::string>& values, std::string& error) const {
+    std::ifstream in(path_);
+    if (!in) {
+        error = "cannot read " + path_;
+        return false;
+    }
+    std::stringstream text;
+    text << in.rdbuf();
+    const nlohmann::json file = nlohmann::json::parse(text.str(), nullptr, false);
+    if (!file.is_object()) {
+        error = path_ + " is not a JSON object";
+        return false;
+    }
+    for (const auto& [key, value] : file.items()) {
+        if (value.is_null()) continue;
+        if (value.is_string()) {
+            values[key] = value.get<std::string>();
+        } else if (value.is_boolean()) {
+            values[key] = value.get<bool>() ? "true" : "false";
+        } else if (value.is_number()) {
+            values[key] = value.dump();
+        } else {
+            error = key + " in " + path_ + " must be a string, number or boolean";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Config::load(const std::string& path, bool required, std::string& error) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    path_ = path;
+    if (!required && !std::filesystem::exists(path)) {
+        return true;
+    }
+    std::map<std::string, std::string> values;
+    if (!readFile(values, error)) {
+        return false;
+    }
+    for (const auto& [key, value] : values) {
+        if (std::getenv(key.c_str())) {
+            environment_.insert(key);
+        } else {
+            setenv(key.c_str(), value.c_str(), 1);
+            exported_.insert(key);
+        }
+    }
+    values_ = std::move(values);
+    loaded_ = true;
+    return true;
+}
+
+void Config::unexport() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& key : exported_) {
+        unsetenv(key.c_str());
+    }
+}
+
+bool Config::loaded() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return loaded_;
+}
+
+bool Config::fromEnvironment(const std::string& key) const {
+    return environment_.count(key) || (!exported_.count(key) && std::getenv(key.c_str()));
+}
+
+std::optional<std::string> Config::get(const std::string& key) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!fromEnvironment(key)) {
+        auto it = values_.find(key);
+        if (it != values_.end()) return it->second;
+        // Put there from the file, since removed from it
+        if (exported_.count(key)) return std::nullopt;
+    }
+    const char* value = std::getenv(key.c_str());
+    return value ? std::optional<std::string>(value) : std::nullopt;
+}
+
+void Config::onChange(std::vector<std::string> keys, std::function<void()> apply) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    handlers_.push_back({std::move(keys), std::move(apply)});
+}
+
+nlohmann::json Config::reload() {
+    std::lock_guard<std::mutex> reloading(reload_mutex_);
+    std::map<std::string, std::string> values;
+    std::string error;
+    if (path_.empty() || !readFile(values, error)) {
+        if (path_.empty()) error = "no configuration file";
+        spdlog::error("Configuration not reloaded: {}", error);
+        return {{"ok", false}, {"error", error}};
+    }
+
+    std::set<std::string> changed;
+    std::vector<Handler> run;
+    nlohmann::json applied = nlohmann::json::array();
+    nlohmann::json restart = nlohmann::json::array();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto differs = [&](const std::string& key) {
+            auto before = values_.find(key);
+            auto after = values.find(key);
+            if (before == values_.end() || after == values.end()) return (before == values_.end()) != (after == values.end());
+            return before->second != after->second;
+        };
+        for (const auto& [key, value] : values_) {
+            if (!fromEnvironment(key) && differs(key)) changed.insert(key);
+        }
+        for (const auto& [key, value] : values) {
+            if (!fromEnvironment(key) && differs(key)) changed.insert(key);
+        }
+        values_ = std::move(values);
+        loaded_ = true;
+        reloads_++;
+        reloaded_at_ = std::chrono::system_clock::now();
+
+        std::set<std::string> live;
+        for (const auto& handler : handlers_) {
+            bool hit = false;
+            for (const auto& key : handler.keys) {
+                if (changed.count(key)) {
+                    hit = true;
+                    live.insert(key);
+                }
+            }
+            if (hit) run.push_back(handler);
+        }
+        for (const auto& key : changed) {
+            if (live.count(key)) {
+                applied.push_back(key);
+            } else {
+                pending_.insert(key);
+                restart.push_back(key);
+            }
+        }
+    }
+
+    // Outside the lock: handlers read the new values through get()
+    bool ok = true;
+    for (const auto& handler : run) {
+        try {
+            handler.apply();
+        } catch (const std::exception& e) {
+            ok = false;
+            spdlog::error("Applying reloaded setting {} failed: {}", handler.keys.front(), e.what());
+        }
+    }
+    spdlog::info("Configuration reloaded from {}: {} applied, {} take effect at restart", path_, applied.size(),
+                 restart.size());
+    return {{"ok", ok}, {"applied", applied}, {"restart_required", restart}};
+}
+
+nlohmann::json Config::describe() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::set<std::string> live;
+    for (const auto& handler : handlers_) {
+        live.insert(handler.keys.begin(), handler.keys.end());
+    }
+
+    nlohmann::json j;
+    j["file"] = path_;
+    j["loaded"] = loaded_;
+    j["reloads"] = reloads_;
+    j["reloaded_at"] = reloaded_at_ ? nlohmann::json(formatTimestamp(*reloaded_at_)) : nlohmann::json(nullptr);
+    j["live"] = live;
+    j["settings"] = nlohmann::json::object();
+    for (const auto& [key, value] : values_) {
+        const bool environment = fromEnvironment(key);
+        j["settings"][key] = {{"value", secret(key) ? "***" : value},
+                              {"source", environment ? "environment" : "file"},
+                              {"live", live.count(key) > 0},
+                              {"restart_required", pending_.count(key) > 0}};
+    }
+    return j;
+}
+
+void Config::registerRoutes(HttpApp& app) {
+    CROW_ROUTE(app, "/api/admin/config")
+        .methods(crow::HTTPMethod::GET)
+        ([this]() {
+            return jsonResponse(200, describe());
+        });
+
+    CROW_ROUTE(app, "/api/admin/config/reload")
+        .methods(crow::HTTPMethod::POST)
+        ([this](const crow::request& req) {
+            std::string error;
+            if (!TokenVerifier::getInstance().authorizes(req.get_header_value("Authorization"), error)) {
+                return jsonResponse(401, {{"error", true}, {"message", error}});
+            }
+            nlohmann::json result = reload();
+            if (result.contains("error")) {
+                return jsonResponse(400, {{"error", true}, {"message", result["error"]}});
+            }
+            return jsonResponse(200, result);
+        });
+}
+
+} // namespace aeronautical
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <crow.h>
+#include "HttpApp.h"
+#include <json.hpp>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace aeronautical {
+
+// Settings file: a JSON object whose keys are the environment variables
+// main() reads, with string, number or boolean values, e.g.
+//
+//   {"LOG_LEVEL": "debug", "DB_POOL_SIZE": 32, "RATE_LIMIT_RPS": 20}
+//
+// A variable set in the environment wins over the file. load() runs before
+// anything reads a setting and puts the file's values into the environment,
+// so every setting can come from either. reload() (SIGHUP, or
+// POST /api/admin/config/reload) reads the file again; a changed key with a
+// live handler is applied at once, any other waits for the next restart and
+// is listed as such in GET /api/admin/config.
+class Config {
+public:
+    static Config& getInstance();
+
+    Config(const Config&) = delete;
+    Config& operator=(const Config&) = delete;
+
+    // Reads path into the environment; a missing file is not an error
+    // unless required. Call before other threads start.
+    bool load(const std::string& path, bool required, std::string& error);
+
+    // Takes the file's values out of the environment again, for a child
+    // process about to exec the server, which loads the file itself
+    void unexport() const;
+
+    // Whether a file was read
+    bool loaded() const;
+
+    // Current value: the environment's when set there, else the file's
+    std::optional<std::string> get(const std::string& key) const;
+
+    // apply runs (on the reloading thread) after any of keys changed; it
+    // reads the new values through get()
+    void onChange(std::vector<std::string> keys, std::function<void()> apply);
+
+    // {"ok", "applied": [...], "restart_required": [...]} or the error
+    nlohmann::json reload();
+
+    nlohmann::json describe() const;
+
+    void registerRoutes(HttpApp& app);
+
+private:
+    Config() = default;
+
+    bool readFile(std::map<std::string, std::string>& values, std::string& error) const;
+    bool fromEnvironment(const std::string& key) const; // caller holds mutex_
+
+    struct Handler {
+        std::vector<std::string> keys;
+        std::function<void()> apply;
+    };
+
+    std::mutex reload_mutex_; // one reload at a time
+    mutable std::mutex mutex_;
+    std::string path_;
+    bool loaded_ = false;
+    std::map<std::string, std::string> values_;        // from the file
+    std::set<std::string> environment_;                // file keys the environment overrides
+    std::set<std::string> exported_;                   // file keys load() put into the environment
+    std::set<std::string> pending_;                    // changed since start, applied at restart
+    std::vector<Handler> handlers_;
+    uint64_t reloads_ = 0;
+    std::optional<std::chrono::system_clock::time_point> reloaded_at_;
+};
+
+} // namespace aeronautical
@@ -0,0 +1,84 @@
+#include "ConflictArchiver.h"
+#include "ConflictRepository.h"
+#include "DatabaseManager.h"
+#include <spdlog/spdlog.h>
+#include <cstdlib>
+
+namespace aeronautical {
+
+ConflictArchiver& ConflictArchiver::getInstance() {
+    static ConflictArchiver instance;
+    return instance;
+}
+
+ConflictArchiver::~ConflictArchiver() {
+    stop();
+}
+
+void ConflictArchiver::start(const ConflictArchiveSettings& settings) {
+    std::lock_guard<std::mutex> lock(thread_mutex_);
+    if (thread_.joinable()) {
+        return;
+    }
+    settings_ = settings;
+    stopping_ = false;
+    if (settings_.after.count() <= 0 || !ConflictRepository::probeArchiveTable()) {
+        spdlog::info("Conflict archiving off");
+        return;
+    }
+    thread_ = std::thread([this]() { loop(); });
+    spdlog::info("Conflict archiving: closed projects after {} days, checked every {} min", settings_.after.count() / 24,
+                 settings_.interval.count());
+}
+
+void ConflictArchiver::stop() {
+    {
+        std::lock_guard<std::mutex> lock(thread_mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void ConflictArchiver::loop() {
+    std::unique_lock<std::mutex> lock(thread_mutex_);
+    while (!wake_.wait_for(lock, settings_.interval, [this]() { return stopping_; })) {
+        lock.unlock();
+        try {
+            runOnce();
+        } catch (const std::exception& e) {
+            spdlog::error("Conflict archiving failed: {}", e.what());
+        }
+        lock.lock();
+    }
+}
+
+size_t ConflictArchiver::runOnce() {
+    auto& db = DatabaseManager::getInstance();
+    // GET_LOCK belongs to the connection, so the pass runs on one
+    DatabaseManager::ConnectionScope scope(db);
+    MysqlResult lock = db.executeSelectQuery("SELECT GET_LOCK('conflict_archive', 0)");
+    MYSQL_ROW lock_row = lock ? mysql_fetch_row(lock.get()) : nullptr;
+    if (!lock_row || !lock_row[0] || std::atoi(lock_row[0]) != 1) {
+        return 0;
+    }
+
+    size_t archived = 0;
+    try {
+        ConflictRepository repository;
+        archived = repository.archiveClosedProjects(settings_.after, settings_.batch);
+    } catch (const std::exception& e) {
+        spdlog::error("Conflict archiving failed: {}", e.what());
+    }
+    db.executeQuery("DO RELEASE_LOCK('conflict_archive')");
+
+    if (archived > 0) {
+        archived_.fetch_add(archived, std::memory_order_relaxed);
+        spdlog::info("Archived the conflicts of {} closed projects", archived);
+    }
+    return archived;
+}
+
+} // namespace aeronautical
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+namespace aeronautical {
+
+struct ConflictArchiveSettings {
+    std::chrono::hours after{24 * 30}; // closed projects untouched this long are archived; 0: never
+    std::chrono::minutes interval{60};
+    size_t batch = 50;                  // projects moved per pass
+};
+
+// Keeps the conflicts table to the projects still being worked on. Every
+// interval it moves the conflicts of Accepted, Refused and Cancelled
+// projects not updated for `after` into conflicts_archive (compressed,
+// schema migration 11), one transaction per project under the project's
+// row lock. Reads find the rows through ConflictRepository::tableOf, and a
+// write to an archived project moves them back first. Of several
+// instances only the one holding the conflict_archive advisory lock works.
+class ConflictArchiver {
+public:
+    static ConflictArchiver& getInstance();
+
+    ConflictArchiver(const ConflictArchiver&) = delete;
+    ConflictArchiver& operator=(const ConflictArchiver&) = delete;
+
+    void start(const ConflictArchiveSettings& settings);
+    void stop();
+
+    // One pass; returns the projects archived
+    size_t runOnce();
+
+    // Projects archived since start, for /metrics
+    uint64_t archivedProjects() const { return archived_.load(std::memory_order_relaxed); }
+
+private:
+    ConflictArchiver() = default;
+    ~ConflictArchiver();
+
+    void loop();
+
+    ConflictArchiveSettings settings_;
+    std::atomic<uint64_t> archived_{0};
+
+    std::mutex thread_mutex_;
+    std::condition_variable wake_;
+    bool stopping_ = false;
+    std::thread thread_;
+};
+
+} // namespace aeronautical
@@ -1,12 +1,37 @@
 #include "ConflictController.h"
+#include "ConflictMemo.h"
+#include "Corridor.h"
 #include <spdlog/spdlog.h>
 #include "gdal.h"
 #include "ogr_api.h"
 
 #include "ogr_spatialref.h"
 #include "ProjectRepository.h"
+#include "AnalysisArena.h"
+#include "AnalysisEventHub.h"
+#include "AnalysisProfile.h"
+#include "JsonWriter.h"
+#include "GeoJsonReader.h"
+#include "ListPage.h"
+#include "LocalProjection.h"
+#include "ObstacleSurfaces.h"
+#include "ProjectSpatialIndex.h"
+#include "ReferenceDataStore.h"
+#include "ResultCache.h"
+#include "ZoneEvaluator.h"
+#include "Tracing.h"
+#include "TokenVerifier.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
 #include <mutex>
 #include <memory>
+#include <numeric>
+#include <tuple>
 #include <json.hpp>
 
 namespace aeronautical {
@@ -16,9 +41,7 @@ std::unique_ptr<ConflictController> ConflictController::instance_ = nullptr;
 std::once_flag ConflictController::once_flag_;
 
 ConflictController::ConflictController() 
-    : repository_(std::make_unique<ConflictRepository>()) {
-    GDALAllRegister();
-}
+    : repository_(std::make_unique<ConflictRepository>()), sources_(AnalysisSources::mysql()) {}
 
 // Singleton getInstance method
 ConflictController& ConflictController::getInstance() {
@@ -28,31 +51,165 @@ ConflictController& ConflictController::getInstance() {
     return *instance_;
 }
 
-void ConflictController::registerRoutes(crow::SimpleApp& app) {
+void ConflictController::setSources(AnalysisSources sources) {
+    sources_ = std::move(sources);
+}
+
+void ConflictController::setAnalysisThreads(size_t threads, CpuSet cpus, bool numa_aware) {
+    std::call_once(pool_once_flag_, [this, threads, &cpus, numa_aware]() {
+        pool_ = std::make_unique<ThreadPool>(threads, "analysis", std::move(cpus), numa_aware);
+    });
+}
+
+ThreadPool& ConflictController::analysisPool() {
+    // Falls back to one worker per core when main() did not size the pool
+    setAnalysisThreads(std::max(1u, std::thread::hardware_concurrency()));
+    return *pool_;
+}
+
+void ConflictController::registerRoutes(HttpApp& app) {
     auto logger_ = spdlog::get("aeronautical");
 
     // GET /api/projects/:id/conflicts
     CROW_ROUTE(app, "/api/projects/<int>/conflicts")
+        .methods(crow::HTTPMethod::GET)
+        ([this](const crow::request& req, int project_id) {
+            return getConflictsByProject(req, project_id);
+        });
+
+    // GET /api/projects/:id/conflicts/summary
+    CROW_ROUTE(app, "/api/projects/<int>/conflicts/summary")
+        .methods(crow::HTTPMethod::GET)
+        ([this](int project_id) {
+            return getConflictSummary(project_id);
+        });
+
+    // GET /api/projects/:id/conflicts/changes - new, unchanged and resolved since the previous analysis
+    CROW_ROUTE(app, "/api/projects/<int>/conflicts/changes")
+        .methods(crow::HTTPMethod::GET)
+        ([this](int project_id) {
+            return getConflictChanges(project_id);
+        });
+
+    // GET /api/projects/:id/conflicts/:conflict_id/geometry
+    CROW_ROUTE(app, "/api/projects/<int>/conflicts/<int>/geometry")
+        .methods(crow::HTTPMethod::GET)
+        ([this](int project_id, int conflict_id) {
+            return getConflictGeometry(project_id, conflict_id);
+        });
+
+    // POST /api/admin/analysis/open-projects - re-analyze every open project (bearer token)
+    CROW_ROUTE(app, "/api/admin/analysis/open-projects")
+        .methods(crow::HTTPMethod::POST)
+        ([this](const crow::request& req) {
+            std::string error;
+            if (!TokenVerifier::getInstance().authorizes(req.get_header_value("Authorization"), error)) {
+                return crow::response(401, nlohmann::json{{"error", true}, {"message", error}}.dump());
+            }
+            if (!scheduleOpenProjectsAnalysis()) {
+                return crow::response(409, "{\"error\":true,\"message\":\"A re-analysis of open projects is already running\"}");
+            }
+            return crow::response(202, "{\"message\":\"Re-analysis of open projects started\"}");
+        });
+
+    // GET /api/reports/conflicts - conflicts of every open project in a region
+    CROW_ROUTE(app, "/api/reports/conflicts")
+        .methods(crow::HTTPMethod::GET)
+        ([this](const crow::request& req) {
+            return getConflictReport(req);
+        });
+
+    // GET /api/projects/:id/surfaces - obstacle limitation surface penetrations
+    CROW_ROUTE(app, "/api/projects/<int>/surfaces")
         .methods(crow::HTTPMethod::GET)
         ([this](int project_id) {
-            return getConflictsByProject(project_id);
+            return getSurfacePenetrations(project_id);
+        });
+
+    // GET /api/protections/at?lat=&lng=&alt= - zones covering one point
+    CROW_ROUTE(app, "/api/protections/at")
+        .methods(crow::HTTPMethod::GET)
+        ([this](const crow::request& req) {
+            return getProtectionsAt(req);
+        });
+
+    // POST /api/corridor - zones, projects and waypoints near a trajectory
+    CROW_ROUTE(app, "/api/corridor")
+        .methods(crow::HTTPMethod::POST)
+        ([this](const crow::request& req) {
+            return queryCorridor(req);
+        });
+
+    // POST /api/analysis/preview - conflicts of a FeatureCollection, not stored
+    CROW_ROUTE(app, "/api/analysis/preview")
+        .methods(crow::HTTPMethod::POST)
+        ([this](const crow::request& req) {
+            return previewConflicts(req);
         });
 
     logger_->info("Conflict routes registered");
 }
 
-crow::response ConflictController::getConflictsByProject(int project_id) {
+crow::response ConflictController::getConflictsByProject(const crow::request& req, int project_id) {
     auto logger_ = spdlog::get("aeronautical");
     try {
-        
-        auto conflicts = repository_->findByProjectId(project_id);
-        
-        nlohmann::json response_data = nlohmann::json::array();
-        for (const auto& conflict : conflicts) {
-            response_data.push_back(conflict.toJson());
+        // Intersections are the bulk of a conflict row; the map fetches them
+        // one at a time from .../geometry, so the list leaves them out unless asked
+        const char* include = req.url_params.get("include_geometry");
+        const bool geometry = include && std::string(include) == "true";
+        const std::string key = std::string(geometry ? "conflicts.byProject.geometry:" : "conflicts.byProject:") +
+                                std::to_string(project_id);
+
+        // Paged only when asked, so existing clients keep getting the bare array
+        const char* limit_text = req.url_params.get("limit");
+        const char* after_text = req.url_params.get("after");
+        if (!limit_text && !after_text) {
+            auto conflicts = ResultCache::getInstance().get<std::vector<Conflict>>(
+                key, {ResultCache::projectTag(project_id)},
+                [&]() { return repository_->findByProjectId(project_id, 0, 0, geometry); });
+
+            std::string body;
+            JsonWriter writer(body);
+            writer.beginArray();
+            for (const auto& conflict : *conflicts) {
+                conflict.writeJson(writer, geometry);
+            }
+            writer.endArray();
+
+            return crow::response(200, body);
         }
-        
-        return crow::response(200, response_data.dump());
+
+        int limit = 100;
+        if (limit_text) {
+            limit = std::clamp(std::atoi(limit_text), 1, 500);
+        }
+        std::optional<PageCursor> after;
+        if (after_text) {
+            after = PageCursor::decode(after_text);
+            if (!after || !after->key.empty()) {
+                return crow::response(400, "{\"error\":\"Invalid after cursor\"}");
+            }
+        }
+
+        const int after_id = after ? after->id : 0;
+        auto conflicts = ResultCache::getInstance().get<std::vector<Conflict>>(
+            key + ":" + std::to_string(after_id) + ":" + std::to_string(limit), {ResultCache::projectTag(project_id)},
+            [&]() { return repository_->findByProjectId(project_id, after_id, limit + 1, geometry); });
+        const size_t count = std::min(conflicts->size(), static_cast<size_t>(limit));
+        std::optional<std::string> next;
+        if (conflicts->size() > count) {
+            next = PageCursor{"", (*conflicts)[count - 1].id}.encode();
+        }
+
+        std::string body;
+        JsonWriter writer(body);
+        writer.beginObject().key("data").beginArray();
+        for (size_t i = 0; i < count; i++) {
+            (*conflicts)[i].writeJson(writer, geometry);
+        }
+        writer.endArray().field("limit", limit).field("next_cursor", next).endObject();
+
+        return crow::response(200, body);
 
     } catch (const std::exception& e) {
         logger_->error("Failed to get conflicts for project {}: {}", project_id, e.what());
@@ -60,339 +217,2741 @@ crow::response ConflictController::getConflictsByProject(int project_id) {
     }
 }
 
-// Helper function to create geometry from GeoJSON - FIXED to handle FeatureCollections
-OGRGeometryH createGeometryFromGeoJSON(const std::string& geojson) {
+crow::response ConflictController::getConflictSummary(int project_id) {
+    auto logger_ = spdlog::get("aeronautical");
     try {
-        // Parse the JSON to check if it's a FeatureCollection
-        nlohmann::json j = nlohmann::json::parse(geojson);
-        
-        if (j.contains("type") && j["type"] == "FeatureCollection") {
-            // It's a FeatureCollection - we need to extract and merge geometries
-            if (!j.contains("features") || !j["features"].is_array() || j["features"].empty()) {
-                spdlog::error("FeatureCollection has no features");
-                return nullptr;
-            }
-            
-            OGRGeometryCollection* collection = new OGRGeometryCollection();
-            
-            for (const auto& feature : j["features"]) {
-                if (!feature.contains("geometry")) continue;
-                
-                std::string geom_str = feature["geometry"].dump();
-                OGRGeometry* geom = OGRGeometryFactory::createFromGeoJson(geom_str.c_str());
-                
-                if (geom) {
-                    // Fix invalid geometries before adding
-                    if (!geom->IsValid()) {
-                        spdlog::warn("Fixing invalid geometry in FeatureCollection");
-                        OGRGeometry* fixed = geom->Buffer(0); // Buffer(0) can fix self-intersections
-                        if (fixed) {
-                            delete geom;
-                            geom = fixed;
-                        }
-                    }
-                    collection->addGeometry(geom);
-                    delete geom; // Collection takes ownership, but we need to clean up our pointer
-                }
-            }
-            
-            // If we only have one geometry, return it directly
-            // Otherwise, return a union of all geometries
-            if (collection->getNumGeometries() == 1) {
-                OGRGeometry* single = collection->getGeometryRef(0)->clone();
-                delete collection;
-                return (OGRGeometryH)single;
-            } else if (collection->getNumGeometries() > 1) {
-                // Create a union of all geometries
-                OGRGeometry* unionGeom = collection->UnionCascaded();
-                delete collection;
-                return (OGRGeometryH)unionGeom;
-            } else {
-                delete collection;
-                return nullptr;
-            }
-        } else if (j.contains("type") && j["type"] == "Feature") {
-            // It's a single Feature - extract the geometry
-            if (!j.contains("geometry")) {
-                spdlog::error("Feature has no geometry");
-                return nullptr;
-            }
-            
-            std::string geom_str = j["geometry"].dump();
-            OGRGeometry* geometry = OGRGeometryFactory::createFromGeoJson(geom_str.c_str());
-            
-            // Fix invalid geometry
-            if (geometry && !geometry->IsValid()) {
-                spdlog::warn("Fixing invalid Feature geometry");
-                OGRGeometry* fixed = geometry->Buffer(0);
-                if (fixed) {
-                    delete geometry;
-                    geometry = fixed;
-                }
-            }
-            
-            return (OGRGeometryH)geometry;
-        } else {
-            // Try to parse it as a direct geometry
-            OGRGeometry* geometry = OGRGeometryFactory::createFromGeoJson(geojson.c_str());
-            
-            // Fix invalid geometry
-            if (geometry && !geometry->IsValid()) {
-                spdlog::warn("Fixing invalid direct geometry");
-                OGRGeometry* fixed = geometry->Buffer(0);
-                if (fixed) {
-                    delete geometry;
-                    geometry = fixed;
-                }
-            }
-            
-            if (geometry) {
-                return (OGRGeometryH)geometry;
-            }
-            
-            // Fallback to C API
-            OGRGeometryH hGeom = OGR_G_CreateGeometryFromJson(geojson.c_str());
-            if (hGeom) {
-                return hGeom;
+        auto summary = ResultCache::getInstance().get<ConflictSummary>(
+            summaryKey(project_id), {ResultCache::projectTag(project_id)},
+            [&]() { return repository_->summarize(project_id); });
+
+        std::string body;
+        JsonWriter writer(body);
+        summary->writeJson(writer, project_id);
+        return crow::response(200, body);
+
+    } catch (const std::exception& e) {
+        logger_->error("Failed to summarize conflicts of project {}: {}", project_id, e.what());
+        return crow::response(500, "{\"error\":\"Internal server error\"}");
+    }
+}
+
+crow::response ConflictController::getConflictChanges(int project_id) {
+    auto logger_ = spdlog::get("aeronautical");
+    try {
+        auto changes = ResultCache::getInstance().get<ConflictDiff>(
+            changesKey(project_id), {ResultCache::projectTag(project_id)},
+            [&]() { return repository_->findChanges(project_id); });
+
+        nlohmann::json body = changesToJson(*changes);
+        body["project_id"] = project_id;
+        return crow::response(200, body.dump());
+
+    } catch (const std::exception& e) {
+        logger_->error("Failed to read conflict changes of project {}: {}", project_id, e.what());
+        return crow::response(500, "{\"error\":\"Internal server error\"}");
+    }
+}
+
+// Helper function to create geometry from GeoJSON - FIXED to handle FeatureCollections
+GeometryHandle createGeometryFromGeoJSON(const std::string& geojson) {
+    std::vector<GeoJsonFeature> features;
+    std::string error;
+    if (!GeoJsonReader::read(geojson, features, error)) {
+        spdlog::error("Failed to create geometry from GeoJSON: {}", error);
+        return nullptr;
+    }
+
+    // Merge the features' geometries; a single one is returned directly
+    auto collection = std::make_unique<OGRGeometryCollection>();
+    for (const auto& feature : features) {
+        if (!feature.geometry) continue;
+        if (auto geometry = ConflictController::validGeometry(feature.geometry->toOGR())) {
+            if (collection->addGeometryDirectly(geometryOf(geometry)) == OGRERR_NONE) {
+                geometry.release();
             }
         }
-    } catch (const std::exception& e) {
-        spdlog::error("Exception while parsing GeoJSON: {}", e.what());
     }
-    
+
+    if (collection->getNumGeometries() == 1) {
+        // Taken out of the collection rather than copied
+        OGRGeometry* only = collection->getGeometryRef(0);
+        collection->removeGeometry(0, FALSE);
+        return GeometryHandle((OGRGeometryH)only);
+    } else if (collection->getNumGeometries() > 1) {
+        return GeometryHandle((OGRGeometryH)collection->UnionCascaded());
+    }
     spdlog::error("Failed to create geometry from GeoJSON");
     return nullptr;
 }
 
-void ConflictController::analyzeProject(int project_id) {
-    spdlog::info("Starting C++ conflict analysis for project ID: {}", project_id);
+std::shared_ptr<const ConflictController::ProtectionSet>
+ConflictController::currentProtectionSet(ProtectionSource& proc_repo) {
+    auto set = protection_set_.load();
+    if (set && set->generation == ProtectionGeometryCache::getInstance().generation()) {
+        return set;
+    }
+    return getProtectionSet(proc_repo);
+}
 
-    // 1. Setup
-    repository_->deleteByProjectId(project_id);
-    ProjectRepository proj_repo;
-    FlightProcedureRepository proc_repo;
+uint64_t ConflictController::regionOf(const OGREnvelope& envelope) const {
+    auto set = protection_set_.load();
+    if (!set) return 0;
+    uint64_t key = 0;
+    for (const auto& shard : set->shards) {
+        if (!shard->envelope.Intersects(envelope)) continue;
+        key = key * 0x100000001b3ull ^ std::hash<std::string>{}(shard->airport_icao);
+    }
+    // Mixed so keys spread over the workers; 0 stays "none"
+    key *= 0x9E3779B97F4A7C15ull;
+    return key ? (key ^ (key >> 29)) | 1 : 0;
+}
 
-    // 2. Fetch Geometries
-    auto project_geom_json = proj_repo.findGeometriesByProjectId(project_id);
-    auto all_protections = proc_repo.findAllActiveProtections();
+// Returns the current protection set when no procedure version changed,
+// otherwise rebuilds it from the geometry cache, loading only missing geometries
+std::shared_ptr<const ConflictController::ProtectionSet>
+ConflictController::getProtectionSet(ProtectionSource& proc_repo) {
+    auto& cache = ProtectionGeometryCache::getInstance();
+    auto headers = proc_repo.findActiveProtectionHeaders();
 
-    if (!project_geom_json || all_protections.empty()) {
-        spdlog::warn("No project geometry or no protection zones found. Aborting analysis for project {}.", project_id);
-        return;
+    const uint64_t generation = cache.generation();
+    size_t signature = headers.size() ^ std::hash<uint64_t>{}(generation);
+    for (const auto& header : headers) {
+        size_t h = std::hash<int>{}(header.procedure_id) ^
+                   (std::hash<int64_t>{}(header.updated_at.time_since_epoch().count()) << 1);
+        signature ^= h + 0x9e3779b97f4a7c15ULL + (signature << 6) + (signature >> 2);
     }
 
-    // 3. Parse the project FeatureCollection
-    std::vector<OGRGeometryH> project_geometries;
-    
-    try {
-        nlohmann::json project_json = nlohmann::json::parse(*project_geom_json);
-        
-        if (project_json.contains("type") && project_json["type"] == "FeatureCollection") {
-            if (!project_json.contains("features") || !project_json["features"].is_array()) {
-                spdlog::error("Invalid FeatureCollection for project {}", project_id);
-                return;
+    if (auto current = protection_set_.load(); current && current->signature == signature) {
+        return current;
+    }
+    std::lock_guard<std::mutex> lock(protection_mutex_);
+    auto previous = protection_set_.load();
+    if (previous && previous->signature == signature) {
+        return previous;
+    }
+
+    // Fetch geometry text only for procedures we have not parsed at this
+    // version and whose envelope is not stored either
+    std::vector<std::shared_ptr<const CachedProtectionGeometry>> cached(headers.size());
+    std::vector<int> missing;
+    for (size_t i = 0; i < headers.size(); i++) {
+        cached[i] = cache.find(headers[i].procedure_id, headers[i].updated_at);
+        if (!cached[i]) {
+            // Edited without touching the geometry, or sharing another procedure's
+            cached[i] = cache.adopt(headers[i].procedure_id, headers[i].updated_at, headers[i].geometry_hash);
+        }
+        if (!cached[i] && !headers[i].footprint) {
+            missing.push_back(headers[i].procedure_id);
+        }
+    }
+
+    size_t stored_footprints = 0;
+    if (!missing.empty()) {
+        auto stored = proc_repo.findProtectionGeometries(missing);
+        for (size_t i = 0; i < headers.size(); i++) {
+            if (cached[i] || headers[i].footprint) continue;
+            auto it = stored.find(headers[i].procedure_id);
+            if (it != stored.end()) {
+                cached[i] = loadProtectionGeometry(headers[i], it->second, proc_repo);
             }
-            
-            // Parse each feature individually
-            for (size_t i = 0; i < project_json["features"].size(); i++) {
-                const auto& feature = project_json["features"][i];
-                
-                if (!feature.contains("geometry")) {
-                    spdlog::warn("Feature {} missing geometry, skipping", i);
-                    continue;
+            // Write the footprint back so the next rebuild can skip the parse
+            if (cached[i] && proc_repo.storesFootprints()) {
+                auto footprint = ProtectionFootprint::compute(*cached[i]->geometry);
+                if (proc_repo.saveProtectionFootprint(headers[i].procedure_id, headers[i].revision, footprint)) {
+                    stored_footprints++;
                 }
-                
-                std::string geom_str = feature["geometry"].dump();
-                OGRGeometryH hGeom = createSimpleGeometryFromGeoJSON(geom_str);
-                
-                if (hGeom) {
-                    project_geometries.push_back(hGeom);
-                    spdlog::debug("Successfully parsed project geometry {} of type {}", 
-                                i, ((OGRGeometry*)hGeom)->getGeometryName());
-                } else {
-                    spdlog::warn("Failed to parse project geometry {}", i);
-                }
-            }
-        } else {
-            // Handle single geometry
-            OGRGeometryH hGeom = createSimpleGeometryFromGeoJSON(*project_geom_json);
-            if (hGeom) {
-                project_geometries.push_back(hGeom);
             }
         }
-        
-        if (project_geometries.empty()) {
-            spdlog::error("No valid geometries found for project {}", project_id);
-            return;
-        }
-        
-        spdlog::info("Found {} valid geometries for project {}", project_geometries.size(), project_id);
-        
-    } catch (const std::exception& e) {
-        spdlog::error("Exception parsing project geometries for project {}: {}", project_id, e.what());
-        return;
     }
 
-    int conflicts_found = 0;
-    
-    // 4. Test each project geometry against each protection zone
-    for (const auto& protection : all_protections) {
-        OGRGeometryH hProtGeom = createSimpleGeometryFromGeoJSON(protection.protection_geometry);
-        if (!hProtGeom) {
-            spdlog::warn("Could not parse protection geometry for procedure {}, skipping", protection.procedure_id);
+    auto set = std::make_shared<ProtectionSet>();
+    set->signature = signature;
+    set->generation = generation;
+    std::vector<OGREnvelope> envelopes;
+
+    // Zones without an envelope are left out; the rest are grouped by airport
+    std::vector<size_t> order;
+    for (size_t i = 0; i < headers.size(); i++) {
+        OGREnvelope envelope;
+        if (cached[i]) {
+            envelope = cached[i]->envelope;
+        } else if (headers[i].footprint) {
+            envelope.MinX = headers[i].footprint->min_lng;
+            envelope.MinY = headers[i].footprint->min_lat;
+            envelope.MaxX = headers[i].footprint->max_lng;
+            envelope.MaxY = headers[i].footprint->max_lat;
+        } else {
             continue;
         }
-        
-        OGRGeometry* protection_geometry = (OGRGeometry*)hProtGeom;
-        
-        // Validate and fix protection geometry if needed
-        if (!protection_geometry->IsValid()) {
-            spdlog::warn("Protection geometry for procedure {} is invalid, attempting to fix", protection.procedure_id);
-            OGRGeometry* fixed = protection_geometry->Buffer(0);
-            if (fixed) {
-                OGR_G_DestroyGeometry(hProtGeom);
-                hProtGeom = (OGRGeometryH)fixed;
-                protection_geometry = fixed;
-            }
+        envelopes.push_back(envelope);
+        order.push_back(i);
+    }
+    std::vector<size_t> by_airport(order.size());
+    for (size_t k = 0; k < by_airport.size(); k++) by_airport[k] = k;
+    std::stable_sort(by_airport.begin(), by_airport.end(), [&](size_t a, size_t b) {
+        return headers[order[a]].airport_icao < headers[order[b]].airport_icao;
+    });
+
+    std::unordered_map<std::string, std::shared_ptr<const ProtectionShard>> previous_shards;
+    if (previous) {
+        for (const auto& shard : previous->shards) {
+            previous_shards.emplace(shard->airport_icao, shard);
         }
-        
-        bool conflict_found = false;
-        std::vector<OGRGeometryH> intersections;
-        
-        // Test intersection with each project geometry
-        for (size_t i = 0; i < project_geometries.size(); i++) {
-            OGRGeometry* project_geometry = (OGRGeometry*)project_geometries[i];
-            
-            try {
-                if (project_geometry->Intersects(protection_geometry)) {
-                    conflict_found = true;
-                    
-                    // Compute intersection for this specific geometry pair
-                    OGRGeometryH hIntersection = OGR_G_Intersection(project_geometries[i], hProtGeom);
-                    if (hIntersection) {
-                        intersections.push_back(hIntersection);
-                        spdlog::debug("Conflict found between project geometry {} and procedure {}", 
-                                    i, protection.procedure_id);
-                    }
-                }
-            } catch (const std::exception& e) {
-                spdlog::error("Exception during intersection check between project geometry {} and procedure {}: {}", 
-                            i, protection.procedure_id, e.what());
-            }
+    }
+
+    size_t rebuilt_shards = 0;
+    size_t updated_shards = 0;
+    for (size_t start = 0; start < by_airport.size();) {
+        const std::string airport = headers[order[by_airport[start]]].airport_icao;
+        size_t end = start;
+        size_t shard_signature = std::hash<std::string>{}(airport);
+        std::vector<OGREnvelope> shard_envelopes;
+        std::vector<std::pair<int, int64_t>> zones;
+        for (; end < by_airport.size() && headers[order[by_airport[end]]].airport_icao == airport; end++) {
+            const auto& header = headers[order[by_airport[end]]];
+            const int64_t version = header.updated_at.time_since_epoch().count();
+            size_t h = std::hash<int>{}(header.procedure_id) ^ (std::hash<int64_t>{}(version) << 1);
+            shard_signature ^= h + 0x9e3779b97f4a7c15ULL + (shard_signature << 6) + (shard_signature >> 2);
+            shard_envelopes.push_back(envelopes[by_airport[end]]);
+            zones.emplace_back(header.procedure_id, version);
         }
-        
-        // If any conflicts found, save them
-        if (conflict_found) {
-            conflicts_found++;
-            
-            // Combine all intersections into a single geometry collection for storage
-            std::string intersection_json = "{}";
-            
-            if (!intersections.empty()) {
-                try {
-                    if (intersections.size() == 1) {
-                        // Single intersection
-                        char* json_str = OGR_G_ExportToJson(intersections[0]);
-                        if (json_str) {
-                            intersection_json = json_str;
-                            CPLFree(json_str);
-                        }
+
+        auto it = previous_shards.find(airport);
+        std::shared_ptr<const ProtectionShard> shard;
+        if (it != previous_shards.end() && it->second->signature == shard_signature) {
+            shard = it->second;
+        } else {
+            auto built = std::make_shared<ProtectionShard>();
+            built->airport_icao = airport;
+            built->signature = shard_signature;
+            built->envelope = shard_envelopes.front();
+            for (const auto& envelope : shard_envelopes) built->envelope.Merge(envelope);
+            if (it != previous_shards.end()) {
+                // Renumber the zones kept from the previous shard and insert
+                // the new or edited ones; the index rebuilds itself when the
+                // edits pile up
+                const auto& before = *it->second;
+                std::unordered_map<int, size_t> previous_slots;
+                for (size_t k = 0; k < before.zones.size(); k++) previous_slots.emplace(before.zones[k].first, k);
+                std::vector<uint32_t> slot_map(before.zones.size(), ProtectionIndex::kRemoved);
+                std::vector<std::pair<size_t, OGREnvelope>> added;
+                for (size_t k = 0; k < zones.size(); k++) {
+                    auto kept = previous_slots.find(zones[k].first);
+                    if (kept != previous_slots.end() && before.zones[kept->second] == zones[k]) {
+                        slot_map[kept->second] = static_cast<uint32_t>(k);
                     } else {
-                        // Multiple intersections - create a GeometryCollection
-                        OGRGeometryCollection* collection = new OGRGeometryCollection();
-                        for (auto hInt : intersections) {
-                            OGRGeometry* geom = ((OGRGeometry*)hInt)->clone();
-                            collection->addGeometry(geom);
-                            delete geom; // addGeometry takes ownership but we need to clean up our clone
-                        }
-                        
-                        char* json_str = OGR_G_ExportToJson((OGRGeometryH)collection);
-                        if (json_str) {
-                            intersection_json = json_str;
-                            CPLFree(json_str);
-                        }
-                        delete collection;
+                        added.emplace_back(k, shard_envelopes[k]);
                     }
-                } catch (const std::exception& e) {
-                    spdlog::warn("Failed to export intersection geometry to JSON: {}", e.what());
-                    intersection_json = "{}";
                 }
-            }
-            
-            // Clean up intersection geometries
-            for (auto hInt : intersections) {
-                OGR_G_DestroyGeometry(hInt);
-            }
-            
-            std::string description = "Conflict with procedure " + std::to_string(protection.procedure_id) 
-                                    + " in protection area '" + protection.protection_name + "'.";
-            
-            if (!repository_->create(project_id, protection.procedure_id, description, intersection_json)) {
-                spdlog::error("Failed to save conflict to database for project {} and procedure {}", 
-                             project_id, protection.procedure_id);
+                built->index = before.index.updated(slot_map, added);
+                updated_shards++;
             } else {
-                spdlog::info("Saved conflict for project {} with procedure {}", 
-                            project_id, protection.procedure_id);
+                built->index.build(shard_envelopes);
+                rebuilt_shards++;
             }
+            built->zones = std::move(zones);
+            shard = std::move(built);
         }
-        
-        OGR_G_DestroyGeometry(hProtGeom);
+        set->shards.push_back(std::move(shard));
+        set->shard_first.push_back(start);
+
+        for (size_t k = start; k < end; k++) {
+            const size_t i = order[by_airport[k]];
+            set->geometries.push_back(cached[i]);
+            set->protections.push_back(std::move(headers[i]));
+        }
+        start = end;
     }
 
-    // Clean up project geometries
-    for (auto hGeom : project_geometries) {
-        OGR_G_DestroyGeometry(hGeom);
+    // Vertical profiles of the procedures whose version is unchanged are
+    // carried over; the segments of the others are read in one batch
+    std::unordered_map<int, std::pair<int64_t, std::shared_ptr<const VerticalProfile>>> previous_profiles;
+    if (previous) {
+        for (size_t slot = 0; slot < previous->protections.size(); slot++) {
+            const auto& protection = previous->protections[slot];
+            previous_profiles.emplace(protection.procedure_id,
+                                      std::pair{protection.updated_at.time_since_epoch().count(),
+                                                previous->profiles[slot]});
+        }
+    }
+    set->profiles.resize(set->protections.size());
+    set->schedules.resize(set->protections.size());
+    for (size_t slot = 0; slot < set->protections.size(); slot++) {
+        const auto& restriction = set->protections[slot].time_restriction;
+        if (restriction) set->schedules[slot] = TimeScheduleCache::getInstance().get(*restriction);
+    }
+    std::vector<int> unprofiled;
+    for (size_t slot = 0; slot < set->protections.size(); slot++) {
+        const auto& protection = set->protections[slot];
+        auto it = previous_profiles.find(protection.procedure_id);
+        if (it != previous_profiles.end() && it->second.first == protection.updated_at.time_since_epoch().count()) {
+            set->profiles[slot] = it->second.second;
+        } else {
+            unprofiled.push_back(protection.procedure_id);
+        }
+    }
+    size_t profiled = 0;
+    if (!unprofiled.empty()) {
+        auto segments = proc_repo.findProcedureSegments(unprofiled);
+        for (size_t slot = 0; slot < set->protections.size() && !segments.empty(); slot++) {
+            auto it = segments.find(set->protections[slot].procedure_id);
+            if (it == segments.end()) continue;
+            set->profiles[slot] = VerticalProfile::build(it->second);
+            profiled += set->profiles[slot] ? 1 : 0;
+        }
     }
 
-    spdlog::info("C++ conflict analysis for project {} complete. Found {} conflicts.", project_id, conflicts_found);
+    spdlog::info("Built protection index over {} zones in {} airport shards ({} rebuilt, {} updated, {} parsed, "
+                 "{} footprints stored, {} vertical profiles built)",
+                 set->protections.size(), set->shards.size(), rebuilt_shards, updated_shards, missing.size(),
+                 stored_footprints, profiled);
 
-    // Update project status
-    auto projectToUpdateOpt = proj_repo.findById(project_id);
-    if (projectToUpdateOpt) {
-        Project projectToUpdate = *projectToUpdateOpt;
-        projectToUpdate.status = ProjectStatus::UnderReview;
-        
-        if (proj_repo.update(project_id, projectToUpdate)) {
-            spdlog::info("Successfully updated project {} status to UnderReview.", project_id);
-        } else {
-            spdlog::error("Failed to update project {} status after analysis.", project_id);
+    protection_set_.publish(set);
+    return set;
+}
+
+void ConflictController::ProtectionSet::query(const OGREnvelope& envelope, std::vector<size_t>& out) const {
+    out.clear();
+    std::vector<size_t> local;
+    for (size_t k = 0; k < shards.size(); k++) {
+        if (!shards[k]->envelope.Intersects(envelope)) continue;
+        shards[k]->index.query(envelope, local);
+        for (size_t slot : local) {
+            // A subdivided zone's envelope is refined by its tiles'
+            const auto& geometry = geometries[shard_first[k] + slot];
+            if (geometry && !geometry->touches(envelope)) continue;
+            out.push_back(shard_first[k] + slot);
         }
-    } else {
-        spdlog::error("Could not find project {} to update its status after analysis.", project_id);
     }
 }
 
-// Simplified geometry creation function that avoids union operations
-OGRGeometryH ConflictController::createSimpleGeometryFromGeoJSON(const std::string& geojson) {
+bool ConflictController::ProtectionSet::inForceAt(size_t slot, std::chrono::system_clock::time_point now) const {
+    const auto& protection = protections[slot];
+    if ((protection.expiry_date && *protection.expiry_date <= now) ||
+        (protection.effective_date && *protection.effective_date > now)) {
+        return false;
+    }
+    return !schedules[slot] || schedules[slot]->activeAt(now);
+}
+
+bool ConflictController::ProtectionSet::inForceDuring(size_t slot, const AiracCycle& cycle) const {
+    const auto& protection = protections[slot];
+    if ((protection.expiry_date && *protection.expiry_date <= cycle.effective) ||
+        (protection.effective_date && *protection.effective_date >= cycle.end())) {
+        return false;
+    }
+    return !schedules[slot] || !schedules[slot]->isNever();
+}
+
+std::string ConflictController::ProtectionSet::snapshot(const AiracCycle& cycle) const {
+    const int key = cycle.year * 100 + cycle.number;
+    std::lock_guard<std::mutex> lock(snapshot_mutex_);
+    if (auto it = snapshots_.find(key); it != snapshots_.end()) {
+        return it->second;
+    }
+    // Slots follow the airport shards, so order by procedure first
+    std::vector<std::pair<int, int64_t>> versions;
+    for (size_t slot = 0; slot < protections.size(); slot++) {
+        if (!inForceDuring(slot, cycle)) continue;
+        const auto& protection = protections[slot];
+        versions.emplace_back(protection.procedure_id, protection.revision ? protection.revision
+                                                                           : ConflictMemo::zoneVersion(protection.updated_at));
+    }
+    std::sort(versions.begin(), versions.end());
+    // FNV-1a, which std::hash does not promise to be across builds
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    auto mix = [&hash](uint64_t value) {
+        for (int byte = 0; byte < 8; byte++) {
+            hash ^= (value >> (byte * 8)) & 0xff;
+            hash *= 0x100000001b3ULL;
+        }
+    };
+    for (const auto& [procedure_id, revision] : versions) {
+        mix(static_cast<uint64_t>(procedure_id));
+        mix(static_cast<uint64_t>(revision));
+    }
+    char text[40];
+    std::snprintf(text, sizeof(text), "%s-%016llx", cycle.ident().c_str(), static_cast<unsigned long long>(hash));
+    return snapshots_.emplace(key, text).first->second;
+}
+
+// A project without dates runs from now on, so expired zones never apply.
+// Weather-dependent zones are kept: the weather of the project's dates is
+// not known.
+bool ConflictController::overlapsInTime(const ProcedureProtection& protection, const Project& project,
+                                        std::chrono::system_clock::time_point now, const TimeSchedule* schedule) {
+    const auto start = project.start_date.value_or(now);
+    if (protection.expiry_date && *protection.expiry_date <= start) {
+        return false;
+    }
+    if (project.end_date && protection.effective_date && *protection.effective_date > *project.end_date) {
+        return false;
+    }
+    if (schedule && project.end_date) {
+        return schedule->activeBetween(start, *project.end_date);
+    }
+    return !schedule || !schedule->isNever();
+}
+
+// Both bands in feet; flight levels are taken at standard pressure. An AGL
+// band is raised by the terrain under the project, its floor over the lowest
+// point and its ceiling over the highest; without terrain it is never excluded
+std::optional<ConflictController::ZoneBand> ConflictController::zoneBand(const ProcedureProtection& protection,
+                                                                         const std::optional<ElevationRange>& terrain) {
+    const double scale = protection.altitude_reference == AltitudeReference::FL ? 100.0 : 1.0;
+    double floor_offset = 0;
+    double ceiling_offset = 0;
+    if (protection.altitude_reference == AltitudeReference::AGL) {
+        if (!terrain) {
+            return std::nullopt;
+        }
+        floor_offset = terrain->min_m / 0.3048;
+        ceiling_offset = terrain->max_m / 0.3048;
+    }
+    ZoneBand band;
+    if (protection.altitude_min) band.floor_ft = *protection.altitude_min * scale + floor_offset;
+    if (protection.altitude_max) band.ceiling_ft = *protection.altitude_max * scale + ceiling_offset;
+    return band;
+}
+
+bool ConflictController::overlapsVertically(const ProcedureProtection& protection, const Project& project,
+                                            const std::optional<ElevationRange>& terrain) {
+    auto band = zoneBand(protection, terrain);
+    if (!band) {
+        return true;
+    }
+    if (band->floor_ft && project.altitude_max && *band->floor_ft > *project.altitude_max) {
+        return false;
+    }
+    if (band->ceiling_ft && project.altitude_min && *band->ceiling_ft < *project.altitude_min) {
+        return false;
+    }
+    return true;
+}
+
+// Clearance is the zone floor minus the project top, negative once the
+// project rises into the zone; the depth is how far it does, capped by the
+// zone's ceiling and the project's own base where those are known
+void ConflictController::addVerticalRelation(PendingConflict& conflict, const ProcedureProtection& protection,
+                                             const Project& project, const std::optional<ElevationRange>& terrain) {
+    auto band = zoneBand(protection, terrain);
+    if (!band || !band->floor_ft || !project.altitude_max) {
+        return;
+    }
+    const double top = band->ceiling_ft ? std::min<double>(*project.altitude_max, *band->ceiling_ft) : *project.altitude_max;
+    const double base = project.altitude_min ? std::max<double>(*project.altitude_min, *band->floor_ft) : *band->floor_ft;
+    conflict.vertical_clearance_ft = *band->floor_ft - *project.altitude_max;
+    conflict.penetration_depth_ft = std::max(0.0, top - base);
+}
+
+std::optional<double> ConflictController::profileClearance(const ProtectionSet& set, size_t slot,
+                                                           const Project& project, const OGRGeometry& feature) const {
+    const auto& profile = set.profiles[slot];
+    if (!profile || !project.altitude_max) {
+        return std::nullopt;
+    }
+    return profile->clearance(feature, *project.altitude_max, profileMargin());
+}
+
+std::optional<double> ConflictController::filterByProfile(const ProtectionSet& set, size_t slot,
+                                                          const Project& project,
+                                                          const std::vector<GeometryHandle>& features,
+                                                          ZoneResult& result) const {
+    if (!set.profiles[slot] || !project.altitude_max) {
+        return std::nullopt;
+    }
+    std::optional<double> least;
+    auto& hits = result.hits;
+    hits.erase(std::remove_if(hits.begin(), hits.end(),
+                              [&](const FeatureHit& hit) {
+                                  auto clearance = profileClearance(set, slot, project, *geometryOf(features[hit.feature]));
+                                  if (*clearance > 0) return true;
+                                  least = least ? std::min(*least, *clearance) : *clearance;
+                                  return false;
+                              }),
+               hits.end());
+    result.conflict = !hits.empty();
+    return least;
+}
+
+// Clearance is the profile floor (less the margin) minus the project top
+// over the features in conflict, so it is never positive
+void ConflictController::addProfileRelation(PendingConflict& conflict, double clearance_ft) {
+    conflict.vertical_clearance_ft = clearance_ft;
+    conflict.penetration_depth_ft = std::max(0.0, -clearance_ft);
+}
+
+// Feature hashes are sorted, so the order features are listed in does not
+// matter; everything else written to the row is mixed in, so a signature
+// match means the stored row is already what this run would write
+uint64_t ConflictController::resultSignature(const PendingConflict& conflict, int64_t zone_version, int mode,
+                                             std::span<size_t> feature_hashes) {
+    std::sort(feature_hashes.begin(), feature_hashes.end());
+    uint64_t seed = 0;
+    auto mix = [&seed](uint64_t value) { seed ^= value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2); };
+    auto mixNumber = [&mix](const std::optional<double>& value) {
+        mix(value ? std::hash<double>{}(*value) : 0x5bd1e995ULL);
+    };
+    mix(static_cast<uint64_t>(conflict.procedure_id));
+    mix(static_cast<uint64_t>(zone_version));
+    mix(static_cast<uint64_t>(mode));
+    for (size_t hash : feature_hashes) mix(hash);
+    mix(std::hash<std::string>{}(conflict.description));
+    mix(conflict.severity ? static_cast<uint64_t>(*conflict.severity) + 1 : 0);
+    mixNumber(conflict.overlap_area);
+    mixNumber(conflict.overlap_ratio);
+    mixNumber(conflict.vertical_clearance_ft);
+    mixNumber(conflict.penetration_depth_ft);
+    return seed ? seed : 1; // 0 means none
+}
+
+nlohmann::json ConflictController::changesToJson(const ConflictDiff& changes) {
+    auto entries = [](const std::vector<ConflictDiff::Entry>& list) {
+        nlohmann::json array = nlohmann::json::array();
+        for (const auto& entry : list) {
+            nlohmann::json item = {{"procedure_id", entry.procedure_id}, {"description", entry.description}};
+            if (entry.conflict_id) item["conflict_id"] = entry.conflict_id;
+            array.push_back(std::move(item));
+        }
+        return array;
+    };
+    return {{"new", entries(changes.added)},
+            {"unchanged", entries(changes.unchanged)},
+            {"resolved", entries(changes.resolved)}};
+}
+
+std::optional<ElevationRange> ConflictController::terrainUnder(const std::vector<GeometryHandle>& geometries) {
+    auto& terrain = TerrainService::getInstance();
+    if (!terrain.enabled()) {
+        return std::nullopt;
+    }
+    std::vector<const OGRGeometry*> features;
+    features.reserve(geometries.size());
+    for (const auto& geometry : geometries) features.push_back(geometryOf(geometry));
+    return terrain.rangeUnder(features);
+}
+
+size_t ConflictController::warmUp() {
+    auto& proc_repo = *sources_.protections;
+    auto protection_set = getProtectionSet(proc_repo);
+    std::vector<size_t> slots(protection_set->protections.size());
+    for (size_t slot = 0; slot < slots.size(); slot++) slots[slot] = slot;
+    auto geometries = resolveGeometries(*protection_set, slots, proc_repo);
+    // Every zone is parsed now, so the coverage mask is ready with the index
+    bool build = false;
+    if (coverage_enabled_.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(coverage_mutex_);
+        build = !std::exchange(coverage_building_, true);
+    }
+    if (build) {
+        buildCoverage(protection_set);
+    }
+    return static_cast<size_t>(std::count_if(geometries.begin(), geometries.end(),
+                                             [](const auto& geometry) { return geometry != nullptr; }));
+}
+
+std::shared_ptr<const CoverageMask>
+ConflictController::coverageOf(const std::shared_ptr<const ProtectionSet>& set) {
+    if (!coverage_enabled_.load(std::memory_order_relaxed)) return nullptr;
+    auto coverage = coverage_.load();
+    if (coverage && coverage->signature == set->signature) {
+        return std::shared_ptr<const CoverageMask>(coverage, &coverage->mask);
+    }
+    {
+        std::lock_guard<std::mutex> lock(coverage_mutex_);
+        if (std::exchange(coverage_building_, true)) return nullptr;
+    }
+    analysisPool().post([this, set]() { buildCoverage(set); });
+    return nullptr;
+}
+
+void ConflictController::buildCoverage(const std::shared_ptr<const ProtectionSet>& set) {
+    const auto started = std::chrono::steady_clock::now();
+    auto coverage = std::make_shared<Coverage>();
+    coverage->signature = set->signature;
+    std::unordered_map<std::string, std::shared_ptr<const CoverageMask>> parts;
+    size_t rasterized = 0;
     try {
-        nlohmann::json j = nlohmann::json::parse(geojson);
-        
-        if (j.contains("type") && j["type"] == "Feature") {
-            if (!j.contains("geometry")) {
-                spdlog::error("Feature has no geometry");
-                return nullptr;
-            }
-            std::string geom_str = j["geometry"].dump();
-            return createSimpleGeometryFromGeoJSON(geom_str);
+        std::unordered_map<std::string, std::shared_ptr<const CoverageMask>> previous;
+        {
+            std::lock_guard<std::mutex> lock(coverage_mutex_);
+            previous = shard_coverage_;
         }
-        
-        // Direct geometry parsing
-        OGRGeometry* geometry = OGRGeometryFactory::createFromGeoJson(geojson.c_str());
-        
-        if (geometry && !geometry->IsValid()) {
-            spdlog::warn("Fixing invalid geometry");
-            OGRGeometry* fixed = geometry->Buffer(0);
-            if (fixed) {
-                delete geometry;
-                geometry = fixed;
+        for (size_t s = 0; s < set->shards.size(); s++) {
+            const auto& shard = *set->shards[s];
+            std::string key = shard.airport_icao + ":" + std::to_string(shard.signature);
+            std::shared_ptr<const CoverageMask> part;
+            if (auto it = previous.find(key); it != previous.end()) {
+                part = it->second;
+            } else {
+                std::vector<size_t> slots(shard.zones.size());
+                std::iota(slots.begin(), slots.end(), set->shard_first[s]);
+                auto geometries = resolveGeometries(*set, slots, *sources_.protections);
+                auto mask = std::make_shared<CoverageMask>();
+                for (size_t slot : slots) {
+                    // A zone left out would let features over it through
+                    if (!geometries[slot]) {
+                        throw std::runtime_error("zone of procedure " +
+                                                 std::to_string(set->protections[slot].procedure_id) +
+                                                 " could not be loaded");
+                    }
+                    mask->add(*geometries[slot]);
+                }
+                part = std::move(mask);
+                rasterized++;
             }
+            coverage->mask.merge(*part);
+            parts.emplace(std::move(key), std::move(part));
         }
-        
-        return (OGRGeometryH)geometry;
-        
     } catch (const std::exception& e) {
-        spdlog::error("Exception while parsing GeoJSON: {}", e.what());
-        return nullptr;
+        spdlog::warn("Protection coverage mask not built: {}", e.what());
+        std::lock_guard<std::mutex> lock(coverage_mutex_);
+        coverage_building_ = false;
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(coverage_mutex_);
+        shard_coverage_ = std::move(parts);
+        coverage_building_ = false;
+    }
+    const size_t cells = coverage->mask.cells();
+    coverage_.publish(std::move(coverage));
+    spdlog::info("Protection coverage mask: {} cells over {} shards ({} rasterized) in {:.0f} ms", cells,
+                 set->shards.size(), rasterized,
+                 std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count());
+}
+
+bool ConflictController::outsideCoverage(const std::shared_ptr<const ProtectionSet>& set,
+                                         const std::vector<OGREnvelope>& envelopes) {
+    if (envelopes.empty()) return false;
+    auto mask = coverageOf(set);
+    if (!mask) return false;
+    // Points and lines are buffered before they are tested; degrees of that
+    // many metres, longitude at the feature's poleward edge
+    const double buffer_m = obstacleBuffer();
+    for (OGREnvelope envelope : envelopes) {
+        if (buffer_m > 0) {
+            const double dlat = buffer_m / 111320.0;
+            const double latitude = std::min(89.0, std::max(std::fabs(envelope.MinY), std::fabs(envelope.MaxY)) + dlat);
+            const double dlng = dlat / std::cos(latitude * M_PI / 180.0);
+            envelope.MinX -= dlng;
+            envelope.MaxX += dlng;
+            envelope.MinY -= dlat;
+            envelope.MaxY += dlat;
+        }
+        if (mask->touches(envelope)) return false;
+    }
+    coverage_rejections_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+nlohmann::json ConflictController::protectionIndexStats() {
+    nlohmann::json j;
+    auto set = protection_set_.load();
+    j["zones"] = set ? set->protections.size() : 0;
+    j["shards"] = set ? set->shards.size() : 0;
+    j["parsed"] = set ? std::count_if(set->geometries.begin(), set->geometries.end(),
+                                      [](const auto& geometry) { return geometry != nullptr; })
+                      : 0;
+    j["generation"] = set ? set->generation : 0;
+    j["current"] = set && set->generation == ProtectionGeometryCache::getInstance().generation();
+    if (set) {
+        const auto cycle = AiracCycle::at(std::chrono::system_clock::now());
+        j["airac_cycle"] = cycle.ident();
+        j["snapshot"] = set->snapshot(cycle);
+        j["next_snapshot"] = set->snapshot(cycle.next());
+    }
+    auto coverage = coverage_.load();
+    j["coverage"] = {{"enabled", coverage_enabled_.load(std::memory_order_relaxed)},
+                     {"current", set && coverage && coverage->signature == set->signature},
+                     {"cells", coverage ? coverage->mask.cells() : 0},
+                     {"rejections", coverage_rejections_.load(std::memory_order_relaxed)}};
+    {
+        std::lock_guard<std::mutex> lock(analysis_state_mutex_);
+        j["analysis_states"] = analysis_states_.size();
+        j["max_analysis_states"] = kMaxAnalysisStates;
+    }
+    return j;
+}
+
+void ConflictController::resetProtectionIndex() {
+    {
+        std::lock_guard<std::mutex> lock(protection_mutex_);
+        protection_set_.publish(nullptr);
+    }
+    std::lock_guard<std::mutex> lock(analysis_state_mutex_);
+    analysis_states_.clear();
+}
+
+std::vector<std::shared_ptr<const CachedProtectionGeometry>>
+ConflictController::resolveGeometries(const ProtectionSet& set, std::span<const size_t> slots,
+                                      ProtectionSource& proc_repo) {
+    auto& cache = ProtectionGeometryCache::getInstance();
+    std::vector<std::shared_ptr<const CachedProtectionGeometry>> geometries(set.protections.size());
+    std::vector<int> missing;
+    for (size_t slot : slots) {
+        const auto& protection = set.protections[slot];
+        geometries[slot] = set.geometries[slot] ? set.geometries[slot]
+                                                : cache.find(protection.procedure_id, protection.updated_at);
+        if (!geometries[slot]) {
+            geometries[slot] = cache.adopt(protection.procedure_id, protection.updated_at, protection.geometry_hash);
+        }
+        if (!geometries[slot]) {
+            missing.push_back(protection.procedure_id);
+        }
+    }
+    if (missing.empty()) {
+        return geometries;
+    }
+
+    auto stored = proc_repo.findProtectionGeometries(missing);
+    for (size_t slot : slots) {
+        if (geometries[slot]) continue;
+        const auto& protection = set.protections[slot];
+        auto it = stored.find(protection.procedure_id);
+        if (it != stored.end()) {
+            geometries[slot] = loadProtectionGeometry(protection, it->second, proc_repo);
+        }
+        if (!geometries[slot]) {
+            spdlog::warn("Protection geometry of procedure {} could not be loaded", protection.procedure_id);
+        }
+    }
+    return geometries;
+}
+
+std::shared_ptr<const CachedProtectionGeometry>
+ConflictController::loadProtectionGeometry(const ProcedureProtection& protection, const StoredProtectionGeometry& stored,
+                                           ProtectionSource& proc_repo) {
+    auto& cache = ProtectionGeometryCache::getInstance();
+    if (!stored.wkb.empty()) {
+        return cache.insertWkb(protection.procedure_id, protection.updated_at, stored.wkb, stored.hash);
+    }
+    auto geometry = cache.insert(protection.procedure_id, protection.updated_at, stored.geojson);
+    // Rows written before the WKB columns existed are converted on first use
+    if (geometry && proc_repo.storesWkb()) {
+        proc_repo.saveProtectionWkb(protection.procedure_id, protection.revision,
+                                    ProtectionGeometryCache::toWkb(*geometry->geometry));
+    }
+    return geometry;
+}
+
+void ConflictController::analyzeProject(int project_id, AnalysisProgress* progress) {
+    analyzeProject(project_id, progress, nullptr);
+}
+
+void ConflictController::analyzeProject(int project_id, AnalysisProgress* progress,
+                                        std::shared_ptr<const ProtectionSet> protection_set) {
+    spdlog::info("Starting C++ conflict analysis for project ID: {}", project_id);
+    const auto run_started = std::chrono::steady_clock::now();
+
+    auto& events = AnalysisEventHub::getInstance();
+    const uint64_t job_id = progress ? progress->job_id : 0;
+    // A newer submission of the project supersedes this run: nothing is
+    // stored, the previous results stay until the new run replaces them
+    auto cancelled = [&]() { return progress && progress->isCancelled(); };
+    // The job's ?explain=true view; follows the stages of the spans below
+    AnalysisProfile* profile = progress ? progress->profile.get() : nullptr;
+    auto publishCancelled = [&]() {
+        if (profile) profile->finish();
+        spdlog::info("Analysis of project {} (job {}) cancelled by a newer submission", project_id, job_id);
+        events.publish("analysis_cancelled", project_id, {{"job_id", job_id}});
+    };
+    auto publishAborted = [&](const std::string& reason) {
+        if (profile) profile->finish();
+        // Results of the previous run no longer describe this submission
+        sources_.results->storeAnalysis(project_id, {}, false);
+        ResultCache::getInstance().invalidate(ResultCache::projectTag(project_id));
+        storeAnalysisState(project_id, nullptr);
+        events.publish("analysis_finished", project_id,
+                       {{"job_id", job_id}, {"aborted", true}, {"reason", reason}, {"conflicts_found", 0}});
+    };
+
+    // 1. Setup (old conflicts are replaced in one transaction at the end)
+    auto& proj_repo = *sources_.projects;
+    auto& proc_repo = *sources_.protections;
+
+    // One span per stage; entering the next one ends the previous
+    std::optional<Span> phase;
+    auto enterPhase = [&](const char* name) {
+        phase.emplace(std::string("analysis.") + name);
+        if (profile) profile->enter(name);
+    };
+    // Scratch of this run, released in one piece when it returns
+    AnalysisArena arena;
+
+    // 2. Fetch Geometries
+    enterPhase("fetch");
+    bool validated = false;
+    auto project_geom_json = proj_repo.findGeometriesByProjectId(project_id, &validated);
+    if (!protection_set) {
+        protection_set = getProtectionSet(proc_repo);
+    }
+
+    if (!project_geom_json || protection_set->protections.empty()) {
+        spdlog::warn("No project geometry or no protection zones found. Aborting analysis for project {}.", project_id);
+        publishAborted("No project geometry or no protection zones found");
+        return;
+    }
+
+    // Features nowhere near a zone: no conflict, found from their envelopes
+    // in the text without parsing anything
+    if (outsideCoverage(protection_set, ProjectSpatialIndex::featureEnvelopes(*project_geom_json))) {
+        const size_t protection_count = protection_set->protections.size();
+        enterPhase("store");
+        phase->setAttribute("outside_coverage", "true");
+        phase->setAttribute("conflicts", static_cast<int64_t>(0));
+        if (progress) {
+            progress->protections_total = protection_count;
+            progress->protections_scanned = protection_count;
+            progress->conflicts_found = 0;
+        }
+        ConflictDiff changes;
+        const auto fast_time = std::chrono::steady_clock::now() - run_started;
+        const bool stored = sources_.results->storeAnalysis(project_id, {}, true, &changes);
+        if (stored) {
+            ResultCache::getInstance().invalidate(ResultCache::projectTag(project_id));
+            ResultCache::getInstance().get<ConflictSummary>(summaryKey(project_id), {ResultCache::projectTag(project_id)},
+                                                            []() { return ConflictSummary{}; });
+            if (AnalysisShadow::getInstance().sample()) {
+                shadowAnalysis(project_id, protection_set, *project_geom_json, {}, fast_time);
+            }
+        } else {
+            phase->setError("analysis not stored");
+        }
+        phase.reset();
+        if (profile) {
+            profile->setCount("protections_total", static_cast<int64_t>(protection_count));
+            profile->setCount("conflicts", 0);
+            profile->finish();
+        }
+        storeAnalysisState(project_id, nullptr);
+        spdlog::info("Project {} lies outside every protection zone; no conflicts", project_id);
+
+        const auto cycle = AiracCycle::at(std::chrono::system_clock::now());
+        events.publish("analysis_finished", project_id,
+                       {{"job_id", job_id},
+                        {"status", statusToString(ProjectStatus::UnderReview)},
+                        {"conflicts_found", 0},
+                        {"outside_coverage", true},
+                        {"airac_cycle", cycle.ident()},
+                        {"protection_snapshot", protection_set->snapshot(cycle)},
+                        {"conflicts", nlohmann::json::array()},
+                        {"changes", changesToJson(changes)}});
+        return;
+    }
+
+    // 3. Parse the project FeatureCollection
+    enterPhase("parse");
+    phase->setAttribute("validated", validated ? "true" : "false");
+    std::string parse_error;
+    std::vector<size_t> geometry_hashes;
+    std::vector<GeometryHandle> project_geometries =
+        parseProjectGeometries(project_id, *project_geom_json, parse_error, &geometry_hashes, validated, &arena,
+                               profile);
+    if (project_geometries.empty()) {
+        publishAborted(parse_error);
+        return;
+    }
+
+    phase->setAttribute("features", static_cast<int64_t>(project_geometries.size()));
+
+    // 4. Zones outside the project's altitude band or dates cannot conflict
+    enterPhase("filter");
+    const size_t protection_count = protection_set->protections.size();
+    std::pmr::vector<char> eligible(protection_count, 1, &arena);
+    size_t excluded = 0;
+    // Terrain is sampled once, at the first zone with an AGL band
+    std::optional<ElevationRange> terrain;
+    auto project = proj_repo.findById(project_id);
+    if (project) {
+        const auto now = std::chrono::system_clock::now();
+        bool terrain_sampled = false;
+        for (size_t slot = 0; slot < protection_count; slot++) {
+            const auto& protection = protection_set->protections[slot];
+            if (protection.altitude_reference == AltitudeReference::AGL && !terrain_sampled) {
+                terrain = terrainUnder(project_geometries);
+                terrain_sampled = true;
+            }
+            if (!overlapsInTime(protection, *project, now, protection_set->schedules[slot].get()) ||
+                !overlapsVertically(protection, *project, terrain)) {
+                eligible[slot] = 0;
+                excluded++;
+            }
+        }
+    }
+    if (excluded > 0) {
+        spdlog::debug("{} of {} zones are outside the altitude band or dates of project {}",
+                      excluded, protection_count, project_id);
+    }
+
+    // 5. Features whose geometry was analyzed under the same zones last time
+    //    keep their results; only new or modified ones are evaluated
+    enterPhase("candidates");
+    const bool triage_metrics = triage_.load(std::memory_order_relaxed);
+    const bool materialize = !triage_metrics && !deferred_intersections_.load(std::memory_order_relaxed);
+    const bool metrics = materialize || triage_metrics;
+    size_t context = protection_set->signature ^ (materialize ? 1 : metrics ? 2 : 3);
+    context ^= std::hash<std::string>{}(std::string(eligible.begin(), eligible.end())) + 0x9e3779b97f4a7c15ULL +
+               (context << 6) + (context >> 2);
+    context ^= std::hash<double>{}(obstacleBuffer()) + 0x9e3779b97f4a7c15ULL + (context << 6) + (context >> 2);
+    auto previous = analysisState(project_id);
+    if (previous && previous->context != context) {
+        previous.reset();
+    }
+
+    auto state = std::make_shared<ProjectAnalysisState>();
+    state->context = context;
+    std::pmr::vector<size_t> fresh_features(&arena);
+    for (size_t i = 0; i < project_geometries.size(); i++) {
+        const size_t hash = geometry_hashes[i];
+        if (state->features.count(hash)) continue; // same geometry listed twice
+        if (previous) {
+            auto found = previous->features.find(hash);
+            if (found != previous->features.end()) {
+                state->features.emplace(hash, found->second);
+                continue;
+            }
+        }
+        state->features.emplace(hash, FeatureOutcome{});
+        fresh_features.push_back(i);
+    }
+    const size_t reused_features = project_geometries.size() - fresh_features.size();
+    if (previous) {
+        spdlog::debug("Reusing results of {} of {} features for project {}", reused_features,
+                      project_geometries.size(), project_id);
+    }
+
+    // 6. Resolve candidate protections of the fresh features through the spatial index
+    std::pmr::vector<std::pmr::vector<size_t>> features_by_slot(protection_count, &arena);
+    std::vector<size_t> candidates;
+    size_t candidate_pairs = 0;
+
+    for (size_t i : fresh_features) {
+        OGREnvelope envelope;
+        geometryOf(project_geometries[i])->getEnvelope(&envelope);
+        protection_set->query(envelope, candidates);
+
+        for (size_t slot : candidates) {
+            if (!eligible[slot]) continue;
+            features_by_slot[slot].push_back(i);
+            candidate_pairs++;
+        }
+    }
+
+    std::pmr::vector<size_t> candidate_slots(&arena);
+    for (size_t slot = 0; slot < protection_count; slot++) {
+        if (!features_by_slot[slot].empty()) {
+            candidate_slots.push_back(slot);
+        }
+    }
+    // Every zone with candidates, in order, including those answered below
+    const std::pmr::vector<size_t> indexed_slots(candidate_slots, &arena);
+
+    // Pairs some analysis already evaluated, for this project or another,
+    // are taken from ConflictMemo; a zone left with nothing to evaluate is
+    // not even loaded
+    auto& memo = ConflictMemo::getInstance();
+    const int memo_mode = materialize ? 1 : metrics ? 2 : 3;
+    std::pmr::vector<size_t> canonical_hashes(&arena);
+    auto memoKey = [&](size_t i, size_t slot) {
+        const auto& protection = protection_set->protections[slot];
+        return ConflictMemo::Key{canonical_hashes[i], protection.procedure_id,
+                                 ConflictMemo::zoneVersion(protection.updated_at), memo_mode};
+    };
+    using Remembered = std::pair<size_t, std::shared_ptr<const ConflictMemo::Outcome>>;
+    std::pmr::vector<std::pmr::vector<Remembered>> remembered(&arena);
+    std::pmr::vector<char> remembered_conflict(protection_count, 0, &arena);
+    size_t remembered_pairs = 0;
+    if (memo.enabled() && !candidate_slots.empty()) {
+        canonical_hashes.assign(project_geometries.size(), 0);
+        for (size_t i : fresh_features) {
+            canonical_hashes[i] = ConflictMemo::geometryHash(*geometryOf(project_geometries[i]));
+        }
+        remembered.resize(protection_count);
+        for (size_t slot : candidate_slots) {
+            auto& pending = features_by_slot[slot];
+            pending.erase(std::remove_if(pending.begin(), pending.end(),
+                                         [&](size_t i) {
+                                             auto outcome = memo.find(memoKey(i, slot));
+                                             if (!outcome) return false;
+                                             remembered_conflict[slot] |= outcome->conflict ? 1 : 0;
+                                             remembered[slot].emplace_back(i, std::move(outcome));
+                                             return true;
+                                         }),
+                          pending.end());
+            remembered_pairs += remembered[slot].size();
+        }
+        candidate_slots.erase(std::remove_if(candidate_slots.begin(), candidate_slots.end(),
+                                             [&](size_t slot) { return features_by_slot[slot].empty(); }),
+                              candidate_slots.end());
+    }
+
+    phase->setAttribute("reused_features", static_cast<int64_t>(reused_features));
+    phase->setAttribute("candidate_pairs", static_cast<int64_t>(candidate_pairs));
+    phase->setAttribute("remembered_pairs", static_cast<int64_t>(remembered_pairs));
+    if (profile) {
+        profile->setCount("features", static_cast<int64_t>(project_geometries.size()));
+        profile->setCount("features_reused", static_cast<int64_t>(reused_features));
+        profile->setCount("protections_total", static_cast<int64_t>(protection_count));
+        profile->setCount("protections_in_band", static_cast<int64_t>(protection_count - excluded));
+        profile->setCount("protections_indexed", static_cast<int64_t>(indexed_slots.size()));
+        profile->setCount("candidate_pairs", static_cast<int64_t>(candidate_pairs));
+        profile->setCount("remembered_pairs", static_cast<int64_t>(remembered_pairs));
+    }
+
+    if (cancelled()) {
+        publishCancelled();
+        return;
+    }
+
+    // Only candidates need their geometry; one that fails to load is skipped
+    enterPhase("load_zones");
+    auto geometries = resolveGeometries(*protection_set, candidate_slots, proc_repo);
+    const size_t candidate_count = candidate_slots.size();
+    candidate_slots.erase(std::remove_if(candidate_slots.begin(), candidate_slots.end(),
+                                         [&](size_t slot) { return !geometries[slot]; }),
+                          candidate_slots.end());
+    if (profile) {
+        profile->setCount("protections_evaluated", static_cast<int64_t>(candidate_slots.size()));
+    }
+
+    spdlog::debug("Spatial index returned {} candidate pairs out of {} for project {}",
+                 candidate_pairs, fresh_features.size() * protection_count, project_id);
+
+    // Zones the index ruled out or the memo answered count as scanned straight away
+    size_t remembered_zones_in_conflict = 0;
+    for (size_t slot : indexed_slots) {
+        if (remembered_conflict[slot] && features_by_slot[slot].empty()) remembered_zones_in_conflict++;
+    }
+    std::atomic<size_t> scanned{protection_count - candidate_slots.size()};
+    std::atomic<size_t> zones_in_conflict{remembered_zones_in_conflict};
+    std::atomic<int> reported_decile{0};
+    if (progress) {
+        progress->protections_total = protection_count;
+        progress->protections_scanned = scanned.load();
+        progress->conflicts_found.fetch_add(remembered_zones_in_conflict, std::memory_order_relaxed);
+    }
+
+    events.publish("analysis_started", project_id,
+                   {{"job_id", job_id},
+                    {"project_features", project_geometries.size()},
+                    {"protections_total", protection_count},
+                    {"reused_features", reused_features},
+                    {"remembered_pairs", remembered_pairs},
+                    {"candidate_protections", candidate_slots.size()},
+                    {"excluded_protections", excluded}});
+
+    // 7. Evaluate each candidate zone as a pool task. Every task writes only
+    //    its own result entry, so no locking is needed until the merge below.
+    //    In deferred mode only the predicates run; the intersection geometry
+    //    is built when a reviewer asks for it (getConflictGeometry).
+    enterPhase("evaluate");
+    phase->setAttribute("zones", static_cast<int64_t>(candidate_slots.size()));
+    phase->setAttribute("materialize", materialize ? "true" : "false");
+    // Filled in place, so each hit list stays in the arena
+    std::pmr::vector<std::optional<ZoneResult>> results(candidate_slots.size(), &arena);
+    // Fresh features in GEOS form for the whole job, not once per zone
+    const auto geos_features = ZoneEvaluator::toGeos(project_geometries, fresh_features);
+
+    auto evaluateZone = [&](size_t k) {
+        if (cancelled()) {
+            return; // remaining zones are skipped, the run is discarded below
+        }
+        const size_t slot = candidate_slots[k];
+        const auto& protection = protection_set->protections[slot];
+        const auto zone_started = std::chrono::steady_clock::now();
+        ZoneEvaluator::Timing timing;
+        const ZoneResult& result = results[k].emplace(
+            ZoneEvaluator::evaluate(*geometries[slot], protection.procedure_id, project_geometries,
+                                    features_by_slot[slot], materialize, metrics, &arena, geos_features,
+                                    profile ? &timing : nullptr));
+        if (profile) {
+            profile->addWork(timing);
+            profile->addZone(protection.procedure_id, protection.protection_name, features_by_slot[slot].size(),
+                             std::chrono::steady_clock::now() - zone_started, timing);
+        }
+
+        const bool conflict = result.conflict || remembered_conflict[slot];
+        const size_t done = scanned.fetch_add(1, std::memory_order_relaxed) + 1;
+        const size_t in_conflict = zones_in_conflict.fetch_add(conflict ? 1 : 0, std::memory_order_relaxed)
+                                 + (conflict ? 1 : 0);
+        if (progress) {
+            progress->protections_scanned.fetch_add(1, std::memory_order_relaxed);
+            if (conflict) {
+                progress->conflicts_found.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        // Push a progress event each time another tenth of the zones is done
+        int decile = static_cast<int>(done * 10 / protection_count);
+        int previous = reported_decile.load(std::memory_order_relaxed);
+        while (decile > previous && !reported_decile.compare_exchange_weak(previous, decile)) {}
+        if (decile > previous) {
+            events.publish("analysis_progress", project_id,
+                           {{"job_id", job_id},
+                            {"protections_scanned", done},
+                            {"protections_total", protection_count},
+                            {"conflicts_found", in_conflict}});
+        }
+    };
+
+    analysisPool().parallelFor(candidate_slots.size(), evaluateZone);
+    if (cancelled()) {
+        phase->setError("cancelled");
+        publishCancelled();
+        return;
+    }
+
+    // Fresh and remembered results join the reused ones, per feature in zone
+    // order. Every pair evaluated here goes to the memo, conflicting or not,
+    // unless its zone had a failed check that left a feature out.
+    std::pmr::vector<size_t> result_of_slot(protection_count, SIZE_MAX, &arena);
+    for (size_t k = 0; k < candidate_slots.size(); k++) {
+        result_of_slot[candidate_slots[k]] = k;
+    }
+    for (size_t slot : indexed_slots) {
+        if (!remembered.empty()) {
+            for (const auto& [i, outcome] : remembered[slot]) {
+                if (!outcome->conflict) continue;
+                state->features[geometry_hashes[i]].hits.push_back(
+                    {slot, outcome->inside, outcome->intersection_json, outcome->overlap});
+            }
+        }
+        const size_t k = result_of_slot[slot];
+        if (k == SIZE_MAX) continue;
+        auto& hits = results[k]->hits;
+        if (!canonical_hashes.empty() && results[k]->errors == 0) {
+            // Hits follow the features' order
+            auto hit = hits.begin();
+            for (size_t i : features_by_slot[slot]) {
+                auto outcome = std::make_shared<ConflictMemo::Outcome>();
+                if (hit != hits.end() && hit->feature == i) {
+                    *outcome = {true, hit->inside, hit->intersection_json, hit->overlap};
+                    ++hit;
+                }
+                memo.store(memoKey(i, slot), std::move(outcome));
+            }
+        }
+        for (auto& hit : hits) {
+            state->features[geometry_hashes[hit.feature]].hits.push_back(
+                {slot, hit.inside, std::move(hit.intersection_json), hit.overlap});
+        }
+    }
+
+    // 8. Save one conflict per intersected protection zone, in protection order,
+    //    replacing the previous run's conflicts in a single transaction
+    enterPhase("assemble");
+    std::pmr::vector<std::pmr::vector<const FeatureOutcome::Hit*>> hits_by_slot(protection_count, &arena);
+    std::pmr::vector<std::pmr::vector<size_t>> features_in_slot(protection_count, &arena);
+    // Under a vertical profile only the features reaching up to it count;
+    // the per-feature results stay two-dimensional, so they are reused as is
+    std::pmr::vector<std::optional<double>> profile_clearance(protection_count, &arena);
+    size_t profile_cleared = 0;
+    for (size_t i = 0; i < project_geometries.size(); i++) {
+        for (const auto& hit : state->features[geometry_hashes[i]].hits) {
+            if (project) {
+                auto clearance = profileClearance(*protection_set, hit.slot, *project, *geometryOf(project_geometries[i]));
+                if (clearance && *clearance > 0) {
+                    profile_cleared++;
+                    continue;
+                }
+                if (clearance) {
+                    auto& least = profile_clearance[hit.slot];
+                    least = least ? std::min(*least, *clearance) : *clearance;
+                }
+            }
+            hits_by_slot[hit.slot].push_back(&hit);
+            features_in_slot[hit.slot].push_back(geometry_hashes[i]);
+        }
+    }
+    phase->setAttribute("profile_cleared", static_cast<int64_t>(profile_cleared));
+
+    std::vector<PendingConflict> pending;
+    nlohmann::json conflict_summary = nlohmann::json::array();
+    // Every conflict of the run names the zones it was found against
+    const auto cycle = AiracCycle::at(std::chrono::system_clock::now());
+    const std::string snapshot = protection_set->snapshot(cycle);
+    phase->setAttribute("protection_snapshot", snapshot);
+
+    for (size_t slot = 0; slot < protection_count; slot++) {
+        const auto& hits = hits_by_slot[slot];
+        if (hits.empty()) {
+            continue;
+        }
+        const auto& protection = protection_set->protections[slot];
+        size_t features_inside = 0;
+        std::pmr::vector<const std::string*> parts(&arena);
+        ConflictMetrics overlap;
+        for (const auto* hit : hits) {
+            features_inside += hit->inside ? 1 : 0;
+            if (!hit->intersection_json.empty()) {
+                parts.push_back(&hit->intersection_json);
+            }
+            if (hit->overlap) {
+                overlap.add(*hit->overlap, protection.conflict_severity);
+            }
+        }
+
+        std::string description = "Conflict with procedure " + std::to_string(protection.procedure_id)
+                                + " in protection area '" + protection.protection_name + "'.";
+        nlohmann::json summary = {{"procedure_id", protection.procedure_id},
+                                  {"protection_name", protection.protection_name},
+                                  {"description", description},
+                                  {"features_in_conflict", hits.size()},
+                                  {"features_inside", features_inside}};
+        PendingConflict conflict{protection.procedure_id, std::move(description),
+                                 materialize ? combineIntersections(parts) : std::string(kDeferredGeometry)};
+        if (metrics) {
+            summary.update(overlap.toJson());
+            conflict.severity = overlap.severity;
+            conflict.overlap_area = overlap.overlap_area;
+            conflict.overlap_ratio = overlap.overlap_ratio;
+        }
+        if (project) {
+            if (profile_clearance[slot]) {
+                addProfileRelation(conflict, *profile_clearance[slot]);
+                summary["vertical_profile"] = true;
+            } else {
+                addVerticalRelation(conflict, protection, *project, terrain);
+            }
+            if (conflict.vertical_clearance_ft) summary["vertical_clearance_ft"] = *conflict.vertical_clearance_ft;
+            if (conflict.penetration_depth_ft) summary["penetration_depth_ft"] = *conflict.penetration_depth_ft;
+        }
+        conflict.protection_snapshot = snapshot;
+        conflict.signature = resultSignature(conflict, ConflictMemo::zoneVersion(protection.updated_at), memo_mode,
+                                             features_in_slot[slot]);
+        conflict_summary.push_back(std::move(summary));
+        pending.push_back(std::move(conflict));
+    }
+
+    const auto arena_stats = arena.stats();
+    phase->setAttribute("arena_allocations", static_cast<int64_t>(arena_stats.allocations));
+    phase->setAttribute("arena_bytes", static_cast<int64_t>(arena_stats.reserved));
+    spdlog::debug("Analysis of project {} made {} arena allocations in {} blocks ({} KiB)", project_id,
+                  arena_stats.allocations, arena_stats.blocks, arena_stats.reserved >> 10);
+
+    const int conflicts_found = static_cast<int>(pending.size());
+    if (profile) {
+        profile->setCount("conflicts", conflicts_found);
+    }
+    if (progress) {
+        progress->conflicts_found.store(pending.size(), std::memory_order_relaxed);
+    }
+    // Results missing a zone that failed to load must not be reused
+    const bool complete = candidate_slots.size() == candidate_count;
+
+    // Clean up project geometries
+    project_geometries.clear();
+
+    spdlog::info("C++ conflict analysis for project {} complete. Found {} conflicts.", project_id, conflicts_found);
+
+    // Conflicts and the status change commit together, so a reader never
+    // sees the new conflicts on a pending project or the reverse
+    enterPhase("store");
+    phase->setAttribute("conflicts", static_cast<int64_t>(conflicts_found));
+    ConflictDiff changes;
+    const auto fast_time = std::chrono::steady_clock::now() - run_started;
+    const bool stored = sources_.results->storeAnalysis(project_id, pending, true, &changes);
+    // A run missing a zone that failed to load is not the engine's answer
+    if (stored && complete && AnalysisShadow::getInstance().sample()) {
+        std::vector<AnalysisShadow::Conflict> fast;
+        fast.reserve(pending.size());
+        for (const auto& conflict : pending) {
+            // Triage areas are bounds; only materialized ones are exact
+            fast.push_back({conflict.procedure_id, conflict.severity,
+                            materialize ? conflict.overlap_area : std::nullopt});
+        }
+        shadowAnalysis(project_id, protection_set, *project_geom_json, std::move(fast), fast_time);
+    }
+    if (stored) {
+        ResultCache::getInstance().invalidate(ResultCache::projectTag(project_id));
+        phase->setAttribute("conflicts_new", static_cast<int64_t>(changes.added.size()));
+        phase->setAttribute("conflicts_resolved", static_cast<int64_t>(changes.resolved.size()));
+        // The summary is known without reading the rows back
+        ResultCache::getInstance().get<ConflictSummary>(
+            summaryKey(project_id), {ResultCache::projectTag(project_id)}, [&]() {
+                ConflictSummary summary;
+                for (const auto& conflict : pending) {
+                    summary.add(conflict.procedure_id, conflict.severity ? conflictSeverityToString(*conflict.severity)
+                                                                         : ConflictSummary::kUnclassified);
+                }
+                return summary;
+            });
+    } else {
+        phase->setError("analysis not stored");
+    }
+    phase.reset();
+    if (profile) profile->finish();
+    storeAnalysisState(project_id, stored && complete ? std::move(state) : nullptr);
+
+    events.publish("analysis_finished", project_id,
+                   {{"job_id", job_id},
+                    {"status", statusToString(ProjectStatus::UnderReview)},
+                    {"conflicts_found", conflicts_found},
+                    {"airac_cycle", cycle.ident()},
+                    {"protection_snapshot", snapshot},
+                    {"conflicts", conflict_summary},
+                    {"changes", changesToJson(changes)}});
+}
+
+void ConflictController::shadowAnalysis(int project_id, std::shared_ptr<const ProtectionSet> set,
+                                        std::string project_geojson, std::vector<AnalysisShadow::Conflict> fast,
+                                        std::chrono::nanoseconds fast_time) {
+    analysisPool().post([this, project_id, set, project_geojson, fast, fast_time]() {
+        auto& shadow = AnalysisShadow::getInstance();
+        Span span("analysis.shadow");
+        span.setAttribute("project_id", static_cast<int64_t>(project_id));
+        try {
+            const auto started = std::chrono::steady_clock::now();
+            auto reference = referenceConflicts(project_id, *set, project_geojson);
+            if (!reference) {
+                span.setError("reference run incomplete");
+                shadow.recordFailure();
+                return;
+            }
+            const size_t mismatches = shadow.compare(project_id, fast, fast_time, *reference,
+                                                     std::chrono::steady_clock::now() - started);
+            span.setAttribute("mismatches", static_cast<int64_t>(mismatches));
+        } catch (const std::exception& e) {
+            span.setError(e.what());
+            shadow.recordFailure();
+            spdlog::error("Shadow analysis of project {} failed: {}", project_id, e.what());
+        }
+    });
+}
+
+std::optional<std::vector<AnalysisShadow::Conflict>>
+ConflictController::referenceConflicts(int project_id, const ProtectionSet& set, const std::string& project_geojson) {
+    std::string error;
+    auto features = parseProjectGeometries(project_id, project_geojson, error);
+    if (features.empty()) {
+        return std::nullopt;
+    }
+    std::vector<OGREnvelope> envelopes(features.size());
+    for (size_t i = 0; i < features.size(); i++) {
+        geometryOf(features[i])->getEnvelope(&envelopes[i]);
+    }
+
+    // Every zone of a shard some feature reaches, in force for the project
+    auto project = sources_.projects->findById(project_id);
+    const auto now = std::chrono::system_clock::now();
+    std::optional<ElevationRange> terrain;
+    bool terrain_sampled = false;
+    std::vector<size_t> slots;
+    for (size_t k = 0; k < set.shards.size(); k++) {
+        const auto& shard = *set.shards[k];
+        if (std::none_of(envelopes.begin(), envelopes.end(),
+                         [&](const OGREnvelope& envelope) { return shard.envelope.Intersects(envelope); })) {
+            continue;
+        }
+        for (size_t slot = set.shard_first[k]; slot < set.shard_first[k] + shard.zones.size(); slot++) {
+            const auto& protection = set.protections[slot];
+            if (project) {
+                if (protection.altitude_reference == AltitudeReference::AGL && !terrain_sampled) {
+                    terrain = terrainUnder(features);
+                    terrain_sampled = true;
+                }
+                if (!overlapsInTime(protection, *project, now, set.schedules[slot].get()) ||
+                    !overlapsVertically(protection, *project, terrain)) {
+                    continue;
+                }
+            }
+            slots.push_back(slot);
+        }
+    }
+
+    auto geometries = resolveGeometries(set, slots, *sources_.protections);
+    std::vector<AnalysisShadow::Conflict> conflicts;
+    for (size_t slot : slots) {
+        const auto& zone = geometries[slot];
+        if (!zone) {
+            return std::nullopt;
+        }
+        const auto& protection = set.protections[slot];
+        ConflictMetrics overlap;
+        bool conflict = false;
+        for (size_t i = 0; i < features.size(); i++) {
+            const OGRGeometry* feature = geometryOf(features[i]);
+            if (!zone->envelope.Intersects(envelopes[i]) || !zone->geometry->Intersects(feature)) continue;
+            if (project) {
+                auto clearance = profileClearance(set, slot, *project, *feature);
+                if (clearance && *clearance > 0) continue;
+            }
+            OGRGeometryH handle = features[i].get();
+            if (zone->geometry->Contains(feature)) {
+                overlap.add(FeatureOverlap::whole(handle), protection.conflict_severity);
+            } else {
+                GeometryHandle intersection(OGR_G_Intersection(handle, (OGRGeometryH)zone->geometry.get()));
+                overlap.add(FeatureOverlap::fromIntersection(handle, intersection.get()), protection.conflict_severity);
+            }
+            conflict = true;
+        }
+        if (conflict) {
+            conflicts.push_back({protection.procedure_id, overlap.severity, overlap.overlap_area});
+        }
+    }
+    return conflicts;
+}
+
+void ConflictController::scheduleImpactAnalysis(int procedure_id) {
+    analysisPool().post([this, procedure_id]() {
+        try {
+            analyzeProcedureImpact(procedure_id);
+        } catch (const std::exception& e) {
+            spdlog::error("Impact analysis of procedure {} failed: {}", procedure_id, e.what());
+        }
+    });
+}
+
+std::vector<std::pair<int, OGREnvelope>> ConflictController::projectEnvelopes(ProjectGeometrySource& proj_repo) {
+    return projectEnvelopes(proj_repo, {ProjectStatus::UnderReview});
+}
+
+std::vector<std::pair<int, OGREnvelope>>
+ConflictController::projectEnvelopes(ProjectGeometrySource& proj_repo, std::initializer_list<ProjectStatus> statuses) {
+    std::vector<std::pair<int, std::string>> revisions;
+    for (ProjectStatus status : statuses) {
+        auto found = proj_repo.findGeometryRevisions(status);
+        revisions.insert(revisions.end(), std::make_move_iterator(found.begin()), std::make_move_iterator(found.end()));
+    }
+
+    std::lock_guard<std::mutex> lock(project_envelope_mutex_);
+    std::unordered_map<int, ProjectEnvelope> current;
+    std::vector<std::pair<int, OGREnvelope>> envelopes;
+    for (auto& [project_id, revision] : revisions) {
+        auto it = project_envelopes_.find(project_id);
+        if (it != project_envelopes_.end() && it->second.revision == revision) {
+            current.emplace(project_id, it->second);
+        } else if (auto envelope = parseProjectEnvelope(proj_repo, project_id)) {
+            proj_repo.saveEnvelope(project_id, revision, *envelope);
+            current.emplace(project_id, ProjectEnvelope{revision, *envelope});
+        } else {
+            continue;
+        }
+        envelopes.emplace_back(project_id, current[project_id].envelope);
+    }
+    // Projects no longer in those statuses drop out
+    project_envelopes_ = std::move(current);
+    return envelopes;
+}
+
+std::optional<OGREnvelope> ConflictController::parseProjectEnvelope(ProjectGeometrySource& proj_repo, int project_id) {
+    bool validated = false;
+    auto geojson = proj_repo.findGeometriesByProjectId(project_id, &validated);
+    if (!geojson) {
+        return std::nullopt;
+    }
+    std::string parse_error;
+    auto geometries = parseProjectGeometries(project_id, *geojson, parse_error, nullptr, validated);
+    if (geometries.empty()) {
+        return std::nullopt;
+    }
+    OGREnvelope envelope;
+    for (const auto& geometry : geometries) {
+        OGREnvelope feature_envelope;
+        geometryOf(geometry)->getEnvelope(&feature_envelope);
+        envelope.Merge(feature_envelope);
+    }
+    return envelope;
+}
+
+std::vector<int> ConflictController::projectsOverlapping(ProjectGeometrySource& proj_repo, ProjectStatus status,
+                                                         const OGREnvelope& envelope) {
+    bool cold;
+    {
+        std::lock_guard<std::mutex> lock(project_envelope_mutex_);
+        cold = project_envelopes_.empty();
+    }
+    auto stored = cold ? proj_repo.findStoredEnvelopes(status, envelope) : std::nullopt;
+
+    std::vector<int> overlapping;
+    if (!stored) {
+        for (const auto& [project_id, project_envelope] : projectEnvelopes(proj_repo, {status})) {
+            if (project_envelope.Intersects(envelope)) overlapping.push_back(project_id);
+        }
+        return overlapping;
+    }
+    size_t parsed = 0;
+    for (const auto& [project_id, revision] : proj_repo.findGeometryRevisions(status)) {
+        auto it = stored->find(project_id);
+        if (it != stored->end() && it->second.revision == revision) {
+            if (it->second.overlaps) overlapping.push_back(project_id);
+            continue;
+        }
+        auto project_envelope = parseProjectEnvelope(proj_repo, project_id);
+        if (!project_envelope) continue;
+        parsed++;
+        proj_repo.saveEnvelope(project_id, revision, *project_envelope);
+        if (project_envelope->Intersects(envelope)) overlapping.push_back(project_id);
+    }
+    spdlog::debug("{} projects overlap from stored envelopes, {} parsed for lack of a current one",
+                  overlapping.size(), parsed);
+    return overlapping;
+}
+
+namespace {
+
+// Position of a point along a Z-order curve over the whole globe, 16 bits
+// per axis; nearby points mostly get nearby codes
+uint32_t zOrder(double lng, double lat) {
+    auto cell = [](double value, double min, double max) {
+        return static_cast<uint32_t>(std::clamp((value - min) / (max - min), 0.0, 1.0) * 65535.0);
+    };
+    auto spread = [](uint32_t v) {
+        v = (v | (v << 8)) & 0x00FF00FFu;
+        v = (v | (v << 4)) & 0x0F0F0F0Fu;
+        v = (v | (v << 2)) & 0x33333333u;
+        v = (v | (v << 1)) & 0x55555555u;
+        return v;
+    };
+    return spread(cell(lng, -180.0, 180.0)) | (spread(cell(lat, -90.0, 90.0)) << 1);
+}
+
+} // namespace
+
+size_t ConflictController::analyzeOpenProjects() {
+    const auto started = std::chrono::steady_clock::now();
+    auto& proc_repo = *sources_.protections;
+    auto protection_set = getProtectionSet(proc_repo);
+
+    auto envelopes = projectEnvelopes(*sources_.projects, {ProjectStatus::Pending, ProjectStatus::UnderReview});
+    // A queued or running job analyzes the project against current data anyway
+    auto& jobs = AnalysisJobQueue::getInstance();
+    size_t skipped = 0;
+    std::erase_if(envelopes, [&](const std::pair<int, OGREnvelope>& entry) {
+        auto job = jobs.getLatestJobForProject(entry.first);
+        const bool live = job && (job->state == AnalysisJobState::Queued || job->state == AnalysisJobState::Running);
+        skipped += live ? 1 : 0;
+        return live;
+    });
+
+    std::vector<std::pair<uint32_t, int>> order;
+    order.reserve(envelopes.size());
+    for (const auto& [project_id, envelope] : envelopes) {
+        order.emplace_back(zOrder((envelope.MinX + envelope.MaxX) / 2, (envelope.MinY + envelope.MaxY) / 2), project_id);
+    }
+    std::sort(order.begin(), order.end());
+
+    spdlog::info("Re-analyzing {} open projects against {} protection zones ({} left to their queued jobs)",
+                 order.size(), protection_set->protections.size(), skipped);
+    std::atomic<size_t> failed{0};
+    analysisPool().parallelFor(order.size(), [&](size_t i) {
+        try {
+            analyzeProject(order[i].second, nullptr, protection_set);
+        } catch (const std::exception& e) {
+            failed.fetch_add(1, std::memory_order_relaxed);
+            spdlog::error("Re-analysis of project {} failed: {}", order[i].second, e.what());
+        }
+    });
+
+    const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+    spdlog::info("Re-analysis of open projects finished in {} ms: {} analyzed, {} failed", elapsed.count(),
+                 order.size() - failed.load(), failed.load());
+    return order.size() - failed.load();
+}
+
+bool ConflictController::scheduleOpenProjectsAnalysis() {
+    if (open_projects_running_.exchange(true)) {
+        return false;
+    }
+    analysisPool().post([this]() {
+        try {
+            analyzeOpenProjects();
+        } catch (const std::exception& e) {
+            spdlog::error("Re-analysis of open projects failed: {}", e.what());
+        }
+        open_projects_running_.store(false);
+    });
+    return true;
+}
+
+size_t ConflictController::joinOpenProjects(const std::optional<OGREnvelope>& region,
+                                            const std::function<void(const JoinedConflict&)>& emit) {
+    const auto started = std::chrono::steady_clock::now();
+    auto& proj_repo = *sources_.projects;
+    auto& proc_repo = *sources_.protections;
+    auto protection_set = getProtectionSet(proc_repo);
+    auto& pool = analysisPool();
+
+    // 1. Features of every open project, parsed in parallel; with a region,
+    //    projects whose stored envelope misses it are left out unparsed
+    struct OpenProject {
+        int id;
+        std::string revision;
+        bool envelope_stored; // at this revision
+    };
+    std::vector<OpenProject> project_ids;
+    size_t outside = 0;
+    for (ProjectStatus status : {ProjectStatus::Pending, ProjectStatus::UnderReview}) {
+        auto stored = region ? proj_repo.findStoredEnvelopes(status, *region) : std::nullopt;
+        for (auto& [project_id, revision] : proj_repo.findGeometryRevisions(status)) {
+            bool current = false;
+            if (stored) {
+                auto it = stored->find(project_id);
+                current = it != stored->end() && it->second.revision == revision;
+                if (current && !it->second.overlaps) {
+                    outside++;
+                    continue;
+                }
+            }
+            project_ids.push_back({project_id, std::move(revision), current});
+        }
+    }
+    struct JoinProject {
+        std::optional<Project> project;
+        std::vector<GeometryHandle> features;
+        std::optional<ElevationRange> terrain;
+    };
+    std::vector<JoinProject> projects(project_ids.size());
+    pool.parallelFor(project_ids.size(), [&](size_t k) {
+        auto& entry = projects[k];
+        const int project_id = project_ids[k].id;
+        entry.project = proj_repo.findById(project_id);
+        bool validated = false;
+        auto geojson = entry.project ? proj_repo.findGeometriesByProjectId(project_id, &validated) : std::nullopt;
+        if (!geojson) return;
+        std::string parse_error;
+        entry.features = parseProjectGeometries(project_id, *geojson, parse_error, nullptr, validated);
+        entry.terrain = terrainUnder(entry.features);
+        if (entry.features.empty() || project_ids[k].envelope_stored) return;
+        OGREnvelope envelope;
+        for (const auto& feature : entry.features) {
+            OGREnvelope feature_envelope;
+            geometryOf(feature)->getEnvelope(&feature_envelope);
+            envelope.Merge(feature_envelope);
+        }
+        proj_repo.saveEnvelope(project_id, project_ids[k].revision, envelope);
+    });
+
+    // 2. One tree over the features reaching the region; slot i is feature_refs[i]
+    std::vector<std::pair<uint32_t, uint32_t>> feature_refs; // project, feature
+    std::vector<OGREnvelope> feature_envelopes;
+    for (size_t k = 0; k < projects.size(); k++) {
+        for (size_t i = 0; i < projects[k].features.size(); i++) {
+            OGREnvelope envelope;
+            geometryOf(projects[k].features[i])->getEnvelope(&envelope);
+            if (region && !region->Intersects(envelope)) continue;
+            feature_refs.emplace_back(static_cast<uint32_t>(k), static_cast<uint32_t>(i));
+            feature_envelopes.push_back(envelope);
+        }
+    }
+    ProtectionIndex feature_index;
+    feature_index.build(feature_envelopes);
+
+    // 3. Candidate (zone, feature) pairs, each shard's tree joined with the
+    //    feature tree in parts spread over the pool
+    const auto& shards = protection_set->shards;
+    struct ShardTask {
+        size_t shard;
+        ProtectionIndex::JoinTask task;
+    };
+    std::vector<ShardTask> tasks;
+    const size_t tasks_per_shard = std::max<size_t>(1, pool.size() * 4 / std::max<size_t>(1, shards.size()));
+    for (size_t s = 0; s < shards.size() && !feature_index.empty(); s++) {
+        if (region && !shards[s]->envelope.Intersects(*region)) continue;
+        for (const auto& task : shards[s]->index.joinTasks(feature_index, tasks_per_shard)) {
+            tasks.push_back({s, task});
+        }
+    }
+    std::vector<std::vector<std::pair<uint32_t, uint32_t>>> found(tasks.size());
+    pool.parallelFor(tasks.size(), [&](size_t t) {
+        shards[tasks[t].shard]->index.joinTask(feature_index, tasks[t].task, found[t]);
+    });
+
+    struct Candidate {
+        uint32_t project;
+        uint32_t slot;
+        uint32_t feature;
+        bool operator<(const Candidate& other) const {
+            return std::tie(project, slot, feature) < std::tie(other.project, other.slot, other.feature);
+        }
+    };
+    std::vector<Candidate> candidates;
+    for (size_t t = 0; t < tasks.size(); t++) {
+        const auto first = static_cast<uint32_t>(protection_set->shard_first[tasks[t].shard]);
+        for (const auto& [slot, feature] : found[t]) {
+            const auto& ref = feature_refs[feature];
+            candidates.push_back({ref.first, first + slot, ref.second});
+        }
+        found[t] = {};
+    }
+    std::sort(candidates.begin(), candidates.end());
+
+    // Runs of one project and zone
+    std::vector<std::pair<size_t, size_t>> groups;
+    std::vector<size_t> slots;
+    for (size_t start = 0; start < candidates.size();) {
+        size_t end = start + 1;
+        while (end < candidates.size() && candidates[end].project == candidates[start].project &&
+               candidates[end].slot == candidates[start].slot) {
+            end++;
+        }
+        groups.emplace_back(start, end);
+        slots.push_back(candidates[start].slot);
+        start = end;
+    }
+    std::sort(slots.begin(), slots.end());
+    slots.erase(std::unique(slots.begin(), slots.end()), slots.end());
+    auto geometries = resolveGeometries(*protection_set, slots, proc_repo);
+
+    // 4. Evaluate and emit in order, one chunk of groups at a time
+    constexpr size_t kChunk = 256;
+    const auto now = std::chrono::system_clock::now();
+    size_t emitted = 0;
+    std::vector<std::optional<JoinedConflict>> rows;
+    for (size_t start = 0; start < groups.size(); start += kChunk) {
+        const size_t count = std::min(kChunk, groups.size() - start);
+        rows.assign(count, std::nullopt);
+        pool.parallelFor(count, [&](size_t g) {
+            const auto [first, last] = groups[start + g];
+            const auto& entry = projects[candidates[first].project];
+            const size_t slot = candidates[first].slot;
+            const auto& protection = protection_set->protections[slot];
+            if (!geometries[slot] ||
+                !overlapsInTime(protection, *entry.project, now, protection_set->schedules[slot].get()) ||
+                !overlapsVertically(protection, *entry.project, entry.terrain)) {
+                return;
+            }
+            std::vector<size_t> features;
+            for (size_t i = first; i < last; i++) features.push_back(candidates[i].feature);
+            auto result = ZoneEvaluator::evaluate(*geometries[slot], protection.procedure_id, entry.features, features,
+                                                  false, true);
+            const auto clearance = filterByProfile(*protection_set, slot, *entry.project, entry.features, result);
+            if (!result.conflict) return;
+
+            const size_t shard = std::upper_bound(protection_set->shard_first.begin(),
+                                                  protection_set->shard_first.end(), slot) -
+                                 protection_set->shard_first.begin() - 1;
+            JoinedConflict row{entry.project->id, protection.procedure_id, shards[shard]->airport_icao,
+                               protection.protection_name, result.hits.size()};
+            for (const auto& hit : result.hits) {
+                row.features_inside += hit.inside ? 1 : 0;
+                if (hit.overlap) row.metrics.add(*hit.overlap, protection.conflict_severity);
+            }
+            PendingConflict vertical;
+            if (clearance) {
+                addProfileRelation(vertical, *clearance);
+            } else {
+                addVerticalRelation(vertical, protection, *entry.project, entry.terrain);
+            }
+            row.vertical_clearance_ft = vertical.vertical_clearance_ft;
+            row.penetration_depth_ft = vertical.penetration_depth_ft;
+            rows[g] = std::move(row);
+        });
+        for (const auto& row : rows) {
+            if (!row) continue;
+            emit(*row);
+            emitted++;
+        }
+    }
+
+    const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+    spdlog::info("Joined {} features of {} open projects ({} outside the region unparsed) with {} zones in {} ms: "
+                 "{} candidate pairs, {} conflicts",
+                 feature_refs.size(), projects.size(), outside, protection_set->protections.size(), elapsed.count(),
+                 candidates.size(), emitted);
+    return emitted;
+}
+
+crow::response ConflictController::getConflictReport(const crow::request& req) {
+    auto logger_ = spdlog::get("aeronautical");
+    auto error = [](int code, const std::string& message) {
+        crow::response res(code, nlohmann::json{{"error", true}, {"message", message}}.dump());
+        res.add_header("Content-Type", "application/json");
+        return res;
+    };
+
+    std::optional<OGREnvelope> region;
+    const char* bounds[] = {req.url_params.get("min_lat"), req.url_params.get("max_lat"),
+                            req.url_params.get("min_lng"), req.url_params.get("max_lng")};
+    const size_t given = std::count_if(std::begin(bounds), std::end(bounds), [](const char* p) { return p != nullptr; });
+    if (given != 0) {
+        if (given != 4) {
+            return error(400, "min_lat, max_lat, min_lng and max_lng go together");
+        }
+        try {
+            OGREnvelope envelope;
+            envelope.MinY = std::stod(bounds[0]);
+            envelope.MaxY = std::stod(bounds[1]);
+            envelope.MinX = std::stod(bounds[2]);
+            envelope.MaxX = std::stod(bounds[3]);
+            if (!(envelope.MinY <= envelope.MaxY && envelope.MinX <= envelope.MaxX)) {
+                return error(400, "Invalid region");
+            }
+            region = envelope;
+        } catch (const std::exception&) {
+            return error(400, "Invalid region");
+        }
+    }
+
+    try {
+        std::string body;
+        JsonWriter writer(body);
+        writer.beginObject().key("conflicts").beginArray();
+        const size_t count = joinOpenProjects(region, [&](const JoinedConflict& conflict) {
+            writer.beginObject()
+                .field("project_id", conflict.project_id)
+                .field("procedure_id", conflict.procedure_id)
+                .field("airport_icao", conflict.airport_icao)
+                .field("protection_name", conflict.protection_name)
+                .field("features_in_conflict", static_cast<uint64_t>(conflict.features_in_conflict))
+                .field("features_inside", static_cast<uint64_t>(conflict.features_inside))
+                .field("severity", conflictSeverityToString(conflict.metrics.severity))
+                .field("overlap_area_m2", conflict.metrics.overlap_area)
+                .field("overlap_ratio", conflict.metrics.overlap_ratio)
+                .field("overlap_exact", conflict.metrics.exact)
+                .field("vertical_clearance_ft", conflict.vertical_clearance_ft)
+                .field("penetration_depth_ft", conflict.penetration_depth_ft)
+                .endObject();
+        });
+        writer.endArray().field("count", static_cast<uint64_t>(count)).endObject();
+
+        crow::response res(200, body);
+        res.add_header("Content-Type", "application/json");
+        return res;
+
+    } catch (const std::exception& e) {
+        logger_->error("Failed to build the conflict report: {}", e.what());
+        return error(500, "Internal server error");
+    }
+}
+
+size_t ConflictController::analyzeProcedureImpact(int procedure_id) {
+    auto& proj_repo = *sources_.projects;
+    auto& proc_repo = *sources_.protections;
+    auto protection_set = getProtectionSet(proc_repo);
+
+    // The procedure's current zone; none when it was removed or deactivated
+    std::shared_ptr<const CachedProtectionGeometry> zone;
+    const ProcedureProtection* protection = nullptr;
+    size_t zone_slot = 0;
+    for (size_t slot = 0; slot < protection_set->protections.size(); slot++) {
+        if (protection_set->protections[slot].procedure_id == procedure_id) {
+            zone = resolveGeometries(*protection_set, std::span<const size_t>(&slot, 1), proc_repo)[slot];
+            protection = zone ? &protection_set->protections[slot] : nullptr;
+            zone_slot = slot;
+            break;
+        }
+    }
+
+    // Projects that conflicted with the old zone are all in the table; the
+    // ones the new zone may reach come from an index over project envelopes
+    std::vector<int> affected = repository_->findProjectIdsByProcedure(procedure_id);
+    if (zone) {
+        auto overlapping = projectsOverlapping(proj_repo, ProjectStatus::UnderReview, zone->envelope);
+        affected.insert(affected.end(), overlapping.begin(), overlapping.end());
+    }
+    std::sort(affected.begin(), affected.end());
+    affected.erase(std::unique(affected.begin(), affected.end()), affected.end());
+
+    auto& events = AnalysisEventHub::getInstance();
+    const bool triage_metrics = triage_.load(std::memory_order_relaxed);
+    const bool materialize = !triage_metrics && !deferred_intersections_.load(std::memory_order_relaxed);
+    const bool metrics = materialize || triage_metrics;
+    const auto now = std::chrono::system_clock::now();
+    const std::string snapshot = protection_set->snapshot(AiracCycle::at(now));
+    std::atomic<size_t> evaluated{0};
+    std::atomic<size_t> in_conflict{0};
+
+    auto evaluateProject = [&](size_t k) {
+        const int project_id = affected[k];
+        auto& repo = *sources_.projects;
+        auto project = repo.findById(project_id);
+        if (!project || project->status != ProjectStatus::UnderReview) {
+            return;
+        }
+
+        std::optional<PendingConflict> conflict;
+        ZoneResult result;
+        std::optional<ElevationRange> terrain;
+        std::optional<double> clearance;
+        if (zone && overlapsInTime(*protection, *project, now, protection_set->schedules[zone_slot].get()) &&
+            overlapsVertically(*protection, *project)) {
+            bool validated = false;
+            auto geojson = repo.findGeometriesByProjectId(project_id, &validated);
+            std::string parse_error;
+            auto project_geometries =
+                geojson ? parseProjectGeometries(project_id, *geojson, parse_error, nullptr, validated)
+                        : std::vector<GeometryHandle>{};
+            // An AGL band could only be checked once the features were known
+            if (protection->altitude_reference == AltitudeReference::AGL) {
+                terrain = terrainUnder(project_geometries);
+            }
+            const bool vertical = protection->altitude_reference != AltitudeReference::AGL ||
+                                  overlapsVertically(*protection, *project, terrain);
+            std::vector<size_t> features;
+            for (size_t i = 0; vertical && i < project_geometries.size(); i++) {
+                OGREnvelope envelope;
+                geometryOf(project_geometries[i])->getEnvelope(&envelope);
+                if (envelope.Intersects(zone->envelope)) {
+                    features.push_back(i);
+                }
+            }
+            result = ZoneEvaluator::evaluate(*zone, procedure_id, project_geometries, features, materialize, metrics);
+            clearance = filterByProfile(*protection_set, zone_slot, *project, project_geometries, result);
+        }
+
+        size_t features_inside = 0;
+        ConflictMetrics overlap;
+        if (result.conflict) {
+            std::vector<const std::string*> parts;
+            for (const auto& hit : result.hits) {
+                features_inside += hit.inside ? 1 : 0;
+                if (!hit.intersection_json.empty()) parts.push_back(&hit.intersection_json);
+                if (hit.overlap) overlap.add(*hit.overlap, protection->conflict_severity);
+            }
+            conflict = PendingConflict{procedure_id,
+                                       "Conflict with procedure " + std::to_string(procedure_id) +
+                                           " in protection area '" + protection->protection_name + "'.",
+                                       materialize ? combineIntersections(parts) : std::string(kDeferredGeometry)};
+            if (metrics) {
+                conflict->severity = overlap.severity;
+                conflict->overlap_area = overlap.overlap_area;
+                conflict->overlap_ratio = overlap.overlap_ratio;
+            }
+            if (clearance) {
+                addProfileRelation(*conflict, *clearance);
+            } else {
+                addVerticalRelation(*conflict, *protection, *project, terrain);
+            }
+            conflict->protection_snapshot = snapshot;
+        }
+        if (!repository_->replaceForProcedure(project_id, procedure_id, conflict)) {
+            return;
+        }
+        ResultCache::getInstance().invalidate(ResultCache::projectTag(project_id));
+        // Cached per-feature results still name the old zone
+        storeAnalysisState(project_id, nullptr);
+        evaluated.fetch_add(1, std::memory_order_relaxed);
+        in_conflict.fetch_add(result.conflict ? 1 : 0, std::memory_order_relaxed);
+
+        nlohmann::json update = {{"procedure_id", procedure_id},
+                                 {"conflict", result.conflict},
+                                 {"features_in_conflict", result.hits.size()},
+                                 {"features_inside", features_inside},
+                                 {"protection_snapshot", snapshot}};
+        if (result.conflict && metrics) {
+            update.update(overlap.toJson());
+        }
+        events.publish("conflicts_updated", project_id, update);
+    };
+
+    analysisPool().parallelFor(affected.size(), evaluateProject);
+
+    spdlog::info("Impact analysis of procedure {}: {} projects re-evaluated, {} in conflict",
+                 procedure_id, evaluated.load(), in_conflict.load());
+    return evaluated.load();
+}
+
+std::vector<GeometryHandle> ConflictController::parseProjectGeometries(int project_id, const std::string& geojson,
+                                                                       std::string& error,
+                                                                       std::vector<size_t>* geometry_hashes, bool validated,
+                                                                       std::pmr::memory_resource* resource,
+                                                                       AnalysisProfile* profile) {
+    std::vector<GeometryHandle> project_geometries;
+    try {
+        std::vector<GeoJsonFeature> features;
+        std::string type;
+        if (!GeoJsonReader::read(geojson, features, error, &type, resource)) {
+            spdlog::error("Invalid project geometry for project {}: {}", project_id, error);
+            error = type == "FeatureCollection" ? "Invalid FeatureCollection" : "Could not parse project geometries";
+            return {};
+        }
+
+        // Each geometry is built straight from its coordinates
+        for (size_t i = 0; i < features.size(); i++) {
+            if (!features[i].geometry) {
+                spdlog::warn("Feature {} missing geometry, skipping", i);
+                continue;
+            }
+
+            auto geometry = features[i].geometry->toOGR();
+            const auto validating = profile ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+            GeometryHandle hGeom = withObstacleBuffer(validated ? toHandle(std::move(geometry))
+                                                                : validGeometry(std::move(geometry)));
+            if (profile) {
+                profile->addWork("validate", std::chrono::steady_clock::now() - validating);
+            }
+            if (hGeom) {
+                spdlog::debug("Successfully parsed project geometry {} of type {}",
+                            i, geometryOf(hGeom)->getGeometryName());
+                project_geometries.push_back(std::move(hGeom));
+                if (geometry_hashes) {
+                    geometry_hashes->push_back(std::hash<std::string_view>{}(features[i].geometry_text));
+                }
+            } else {
+                spdlog::warn("Failed to parse project geometry {}", i);
+            }
+        }
+        
+        if (project_geometries.empty()) {
+            spdlog::error("No valid geometries found for project {}", project_id);
+            error = "No valid project geometries";
+            return {};
+        }
+        
+        spdlog::info("Found {} valid geometries for project {}", project_geometries.size(), project_id);
+        
+    } catch (const std::exception& e) {
+        spdlog::error("Exception parsing project geometries for project {}: {}", project_id, e.what());
+        if (geometry_hashes) geometry_hashes->clear();
+        error = "Could not parse project geometries";
+        return {};
+    }
+    return project_geometries;
+}
+
+std::string ConflictController::combineIntersections(std::span<const std::string* const> parts) {
+    if (parts.empty()) {
+        return "{}";
+    }
+    if (parts.size() == 1) {
+        return *parts[0];
+    }
+    // Same compact layout GeometryJson writes the parts in
+    size_t size = 48;
+    for (const auto* part : parts) size += part->size() + 1;
+    std::string json;
+    json.reserve(size);
+    json += R"({"type":"GeometryCollection","geometries":[)";
+    for (size_t i = 0; i < parts.size(); i++) {
+        if (i > 0) json += ',';
+        json += *parts[i];
+    }
+    json += "]}";
+    return json;
+}
+
+std::shared_ptr<const ConflictController::ProjectAnalysisState> ConflictController::analysisState(int project_id) {
+    std::lock_guard<std::mutex> lock(analysis_state_mutex_);
+    auto it = analysis_states_.find(project_id);
+    if (it == analysis_states_.end()) {
+        return nullptr;
+    }
+    it->second.last_used = ++analysis_state_clock_;
+    return it->second.state;
+}
+
+void ConflictController::storeAnalysisState(int project_id, std::shared_ptr<const ProjectAnalysisState> state) {
+    std::lock_guard<std::mutex> lock(analysis_state_mutex_);
+    if (!state) {
+        analysis_states_.erase(project_id);
+        return;
+    }
+    analysis_states_[project_id] = {std::move(state), ++analysis_state_clock_};
+
+    // Forget the least recently analyzed project beyond the bound
+    if (analysis_states_.size() > kMaxAnalysisStates) {
+        auto oldest = std::min_element(analysis_states_.begin(), analysis_states_.end(),
+                                       [](const auto& a, const auto& b) { return a.second.last_used < b.second.last_used; });
+        analysis_states_.erase(oldest);
+    }
+}
+
+bool ConflictController::isDeferredGeometry(const std::string& geojson) {
+    // Spatial columns read back through ST_AsGeoJSON, so compare parsed
+    nlohmann::json j = nlohmann::json::parse(geojson, nullptr, false);
+    return j.is_object() && j.value("type", "") == "GeometryCollection" && j.contains("geometries") &&
+           j["geometries"].is_array() && j["geometries"].empty();
+}
+
+crow::response ConflictController::previewConflicts(const crow::request& req) {
+    auto error = [](int code, const std::string& message) {
+        crow::response res(code, nlohmann::json{{"error", true}, {"message", message}}.dump());
+        res.add_header("Content-Type", "application/json");
+        return res;
+    };
+
+    try {
+        const auto started = std::chrono::steady_clock::now();
+        const char* explain = req.url_params.get("explain");
+        std::optional<AnalysisProfile> profile;
+        if (explain && std::string(explain) == "true") {
+            profile.emplace();
+        }
+        auto enterPhase = [&](const char* name) {
+            if (profile) profile->enter(name);
+        };
+
+        // Same payload shape as a submission, or the FeatureCollection alone
+        enterPhase("parse");
+        std::vector<GeoJsonFeature> features;
+        std::string read_error;
+        std::string type;
+        const bool parsed = GeoJsonReader::read(req.body, features, read_error, &type);
+        if (!parsed || type != "FeatureCollection") {
+            return error(400, parsed ? "Expected a GeoJSON FeatureCollection" : read_error);
+        }
+        if (features.size() > kMaxPreviewFeatures) {
+            return error(413, "Too many features for a preview");
+        }
+        const char* include = req.url_params.get("include_geometry");
+        const bool materialize = include && std::string(include) == "true";
+        // ?cycle=YYNN previews against the zones of that AIRAC cycle, e.g.
+        // the next one once its procedures are loaded; the current by default
+        auto cycle = AiracCycle::at(std::chrono::system_clock::now());
+        const bool other_cycle = req.url_params.get("cycle") != nullptr;
+        if (other_cycle) {
+            auto requested = AiracCycle::parse(req.url_params.get("cycle"));
+            if (!requested) {
+                return error(400, "Invalid AIRAC cycle, expected YYNN");
+            }
+            cycle = *requested;
+        }
+
+        auto& proc_repo = *sources_.protections;
+        auto protection_set = currentProtectionSet(proc_repo);
+        const size_t protection_count = protection_set->protections.size();
+        // Nothing to test when no feature comes near a zone
+        const auto envelopes = ProjectSpatialIndex::featureEnvelopes(features);
+        if (outsideCoverage(protection_set, envelopes)) {
+            nlohmann::json response;
+            response["data"] = {{"conflicts", nlohmann::json::array()},
+                                {"features", envelopes.size()},
+                                {"protections_total", protection_count},
+                                {"candidate_protections", 0},
+                                {"outside_coverage", true},
+                                {"airac_cycle", cycle.ident()},
+                                {"protection_snapshot", protection_set->snapshot(cycle)},
+                                {"elapsed_ms", std::chrono::duration<double, std::milli>(
+                                                   std::chrono::steady_clock::now() - started).count()}};
+            if (profile) {
+                profile->finish();
+                profile->setCount("protections_total", static_cast<int64_t>(protection_count));
+                profile->setCount("conflicts", 0);
+                response["data"]["explain"] = profile->toJson();
+            }
+            crow::response res(200, response.dump());
+            res.add_header("Content-Type", "application/json");
+            return res;
+        }
+
+        // Keep the request's feature positions so results can point back at them
+        enterPhase("validate");
+        std::vector<GeometryHandle> geometries;
+        std::vector<size_t> positions;
+        for (size_t i = 0; i < features.size(); i++) {
+            if (!features[i].geometry) continue;
+            if (auto hGeom = withObstacleBuffer(validGeometry(features[i].geometry->toOGR()))) {
+                geometries.push_back(std::move(hGeom));
+                positions.push_back(i);
+            }
+        }
+
+        enterPhase("index_query");
+
+        std::vector<std::vector<size_t>> features_by_slot(protection_count);
+        size_t candidate_pairs = 0;
+        std::vector<size_t> candidates;
+        for (size_t i = 0; i < geometries.size(); i++) {
+            OGREnvelope envelope;
+            geometryOf(geometries[i])->getEnvelope(&envelope);
+            protection_set->query(envelope, candidates);
+            for (size_t slot : candidates) {
+                features_by_slot[slot].push_back(i);
+            }
+            candidate_pairs += candidates.size();
+        }
+        std::vector<size_t> candidate_slots;
+        for (size_t slot = 0; slot < protection_count; slot++) {
+            if (features_by_slot[slot].empty()) continue;
+            if (other_cycle && !protection_set->inForceDuring(slot, cycle)) continue;
+            candidate_slots.push_back(slot);
+        }
+        enterPhase("load_zones");
+        auto zones = resolveGeometries(*protection_set, candidate_slots, proc_repo);
+
+        enterPhase("evaluate");
+
+        std::vector<size_t> all_features(geometries.size());
+        std::iota(all_features.begin(), all_features.end(), size_t{0});
+        const auto geos_features = ZoneEvaluator::toGeos(geometries, all_features);
+
+        std::vector<ZoneResult> results(candidate_slots.size());
+        analysisPool().parallelFor(candidate_slots.size(), [&](size_t k) {
+            const size_t slot = candidate_slots[k];
+            if (zones[slot]) {
+                const auto& protection = protection_set->protections[slot];
+                const auto zone_started = std::chrono::steady_clock::now();
+                ZoneEvaluator::Timing timing;
+                results[k] = ZoneEvaluator::evaluate(*zones[slot], protection.procedure_id, geometries,
+                                                     features_by_slot[slot], materialize, true,
+                                                     std::pmr::get_default_resource(), geos_features,
+                                                     profile ? &timing : nullptr);
+                if (profile) {
+                    profile->addWork(timing);
+                    profile->addZone(protection.procedure_id, protection.protection_name,
+                                     features_by_slot[slot].size(), std::chrono::steady_clock::now() - zone_started,
+                                     timing);
+                }
+            }
+        });
+
+        enterPhase("assemble");
+        nlohmann::json conflicts = nlohmann::json::array();
+        for (size_t k = 0; k < candidate_slots.size(); k++) {
+            if (!results[k].conflict) continue;
+            const auto& protection = protection_set->protections[candidate_slots[k]];
+            nlohmann::json in_conflict = nlohmann::json::array();
+            size_t features_inside = 0;
+            std::vector<const std::string*> parts;
+            ConflictMetrics overlap;
+            for (const auto& hit : results[k].hits) {
+                in_conflict.push_back(positions[hit.feature]);
+                features_inside += hit.inside ? 1 : 0;
+                if (!hit.intersection_json.empty()) parts.push_back(&hit.intersection_json);
+                if (hit.overlap) overlap.add(*hit.overlap, protection.conflict_severity);
+            }
+            nlohmann::json conflict = {{"procedure_id", protection.procedure_id},
+                                       {"protection_name", protection.protection_name},
+                                       {"features", in_conflict},
+                                       {"features_inside", features_inside}};
+            conflict.update(overlap.toJson());
+            if (materialize) {
+                conflict["conflicting_geometry"] = nlohmann::json::parse(combineIntersections(parts), nullptr, false);
+            }
+            conflicts.push_back(std::move(conflict));
+        }
+
+        const double elapsed_ms = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - started).count();
+        nlohmann::json response;
+        response["data"] = {{"conflicts", conflicts},
+                            {"features", geometries.size()},
+                            {"protections_total", protection_count},
+                            {"candidate_protections", candidate_slots.size()},
+                            {"outside_coverage", false},
+                            {"airac_cycle", cycle.ident()},
+                            {"protection_snapshot", protection_set->snapshot(cycle)},
+                            {"elapsed_ms", elapsed_ms}};
+        if (profile) {
+            profile->finish();
+            profile->setCount("features", static_cast<int64_t>(geometries.size()));
+            profile->setCount("protections_total", static_cast<int64_t>(protection_count));
+            profile->setCount("candidate_pairs", static_cast<int64_t>(candidate_pairs));
+            profile->setCount("protections_indexed", static_cast<int64_t>(candidate_slots.size()));
+            profile->setCount("protections_evaluated", static_cast<int64_t>(std::count_if(
+                candidate_slots.begin(), candidate_slots.end(), [&](size_t slot) { return zones[slot] != nullptr; })));
+            profile->setCount("conflicts", static_cast<int64_t>(conflicts.size()));
+            response["data"]["explain"] = profile->toJson();
+        }
+        crow::response res(200, response.dump());
+        res.add_header("Content-Type", "application/json");
+        return res;
+
+    } catch (const std::exception& e) {
+        spdlog::error("Conflict preview failed: {}", e.what());
+        return error(500, "Internal server error");
+    }
+}
+
+crow::response ConflictController::getProtectionsAt(const crow::request& req) {
+    auto error = [](int code, const std::string& message) {
+        crow::response res(code, nlohmann::json{{"error", true}, {"message", message}}.dump());
+        res.add_header("Content-Type", "application/json");
+        return res;
+    };
+    auto number = [&](const char* name) -> std::optional<double> {
+        const char* text = req.url_params.get(name);
+        if (!text) return std::nullopt;
+        char* end = nullptr;
+        const double value = std::strtod(text, &end);
+        if (end == text || *end != '\0' || !std::isfinite(value)) throw std::invalid_argument(name);
+        return value;
+    };
+
+    try {
+        const auto started = std::chrono::steady_clock::now();
+        std::optional<double> lat, lng, alt;
+        try {
+            lat = number("lat");
+            lng = number("lng");
+            alt = number("alt");
+        } catch (const std::invalid_argument& e) {
+            return error(400, std::string("Invalid parameter: ") + e.what());
+        }
+        if (!lat || !lng) {
+            return error(400, "Missing required parameters: lat, lng");
+        }
+        if (*lat < -90.0 || *lat > 90.0 || *lng < -180.0 || *lng > 180.0) {
+            return error(400, "Invalid coordinates");
+        }
+
+        auto& proc_repo = *sources_.protections;
+        auto protection_set = currentProtectionSet(proc_repo);
+
+        OGREnvelope envelope;
+        envelope.MinX = envelope.MaxX = *lng;
+        envelope.MinY = envelope.MaxY = *lat;
+        std::vector<size_t> candidates;
+        protection_set->query(envelope, candidates);
+
+        // Time and band first, so only zones that can apply are parsed
+        const auto now = std::chrono::system_clock::now();
+        std::optional<ElevationRange> terrain;
+        bool terrain_sampled = false;
+        std::vector<size_t> slots;
+        std::vector<ZoneBand> bands;
+        for (size_t slot : candidates) {
+            const auto& protection = protection_set->protections[slot];
+            if (!protection_set->inForceAt(slot, now)) {
+                continue;
+            }
+            if (protection.altitude_reference == AltitudeReference::AGL && !terrain_sampled) {
+                terrain_sampled = true;
+                auto& dem = TerrainService::getInstance();
+                if (dem.enabled()) {
+                    double elevation = std::numeric_limits<double>::quiet_NaN();
+                    dem.sample(std::span(&*lng, 1), std::span(&*lat, 1), std::span(&elevation, 1));
+                    if (!std::isnan(elevation)) terrain = ElevationRange{elevation, elevation};
+                }
+            }
+            auto band = zoneBand(protection, terrain);
+            if (alt && band && ((band->floor_ft && *alt < *band->floor_ft) ||
+                                (band->ceiling_ft && *alt > *band->ceiling_ft))) {
+                continue;
+            }
+            slots.push_back(slot);
+            bands.push_back(band.value_or(ZoneBand{}));
+        }
+
+        auto zones = resolveGeometries(*protection_set, slots, proc_repo);
+        OGRPoint point(*lng, *lat);
+        std::string body;
+        JsonWriter writer(body);
+        writer.beginObject().rawKey("data").beginObject().rawKey("protections").beginArray();
+        size_t covering = 0;
+        for (size_t k = 0; k < slots.size(); k++) {
+            const auto& zone = zones[slots[k]];
+            if (!zone) continue;
+            auto relation = zone->relate(point);
+            const bool covers = relation ? *relation != PolygonRings::Relation::Disjoint : zone->intersects(point);
+            if (!covers) continue;
+            const auto& protection = protection_set->protections[slots[k]];
+            writer.beginObject()
+                  .rawField("procedure_id", protection.procedure_id)
+                  .field("airport_icao", protection.airport_icao)
+                  .field("protection_name", protection.protection_name)
+                  .rawField("protection_type", protectionTypeName(protection.protection_type))
+                  .rawField("restriction_level", restrictionLevelName(protection.restriction_level))
+                  .rawField("conflict_severity", conflictSeverityName(protection.conflict_severity))
+                  .rawField("altitude_min", protection.altitude_min)
+                  .rawField("altitude_max", protection.altitude_max)
+                  .rawField("altitude_reference", altitudeReferenceName(protection.altitude_reference))
+                  .rawField("floor_ft", bands[k].floor_ft)
+                  .rawField("ceiling_ft", bands[k].ceiling_ft)
+                  .endObject();
+            covering++;
+        }
+        const double elapsed_ms = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - started).count();
+        writer.endArray()
+              .rawField("count", static_cast<int64_t>(covering))
+              .rawField("candidate_protections", static_cast<int64_t>(candidates.size()))
+              .rawField("elapsed_ms", elapsed_ms)
+              .endObject()
+              .rawField("status", "success")
+              .endObject();
+
+        crow::response res(200, body);
+        res.add_header("Content-Type", "application/json");
+        return res;
+
+    } catch (const std::exception& e) {
+        spdlog::error("Protection lookup at point failed: {}", e.what());
+        return error(500, "Internal server error");
+    }
+}
+
+// Body: {"trajectory": <LineString or Feature>, "width_nm": 5,
+//        "layers": ["protections", "projects", "waypoints"]}
+crow::response ConflictController::queryCorridor(const crow::request& req) {
+    auto error = [](int code, const std::string& message) {
+        crow::response res(code, nlohmann::json{{"error", true}, {"message", message}}.dump());
+        res.add_header("Content-Type", "application/json");
+        return res;
+    };
+
+    try {
+        const auto started = std::chrono::steady_clock::now();
+        nlohmann::json body;
+        try {
+            body = nlohmann::json::parse(req.body);
+        } catch (const nlohmann::json::exception&) {
+            return error(400, "Invalid JSON format");
+        }
+        if (!body.is_object() || !body.contains("trajectory") || !body.contains("width_nm") ||
+            !body["width_nm"].is_number()) {
+            return error(400, "Body must hold a trajectory and a numeric width_nm");
+        }
+        const double width_nm = body["width_nm"].get<double>();
+        if (!(width_nm > 0) || width_nm > kMaxCorridorWidthNm) {
+            return error(400, "width_nm must be above 0 and at most " + std::to_string(static_cast<int>(kMaxCorridorWidthNm)));
+        }
+        bool want_protections = true, want_projects = true, want_waypoints = true;
+        if (body.contains("layers")) {
+            if (!body["layers"].is_array()) {
+                return error(400, "layers must be an array");
+            }
+            want_protections = want_projects = want_waypoints = false;
+            for (const auto& layer : body["layers"]) {
+                const std::string name = layer.is_string() ? layer.get<std::string>() : std::string();
+                if (name == "protections") want_protections = true;
+                else if (name == "projects") want_projects = true;
+                else if (name == "waypoints") want_waypoints = true;
+                else return error(400, "Unknown layer: " + name);
+            }
+        }
+
+        auto trajectory = GeoJsonReader::readGeometry(body["trajectory"].dump());
+        if (!trajectory || wkbFlatten(trajectory->getGeometryType()) != wkbLineString) {
+            return error(400, "trajectory must be a GeoJSON LineString");
+        }
+        if (trajectory->toLineString()->getNumPoints() > kMaxCorridorVertices) {
+            return error(413, "Too many trajectory vertices");
+        }
+        auto corridor = Corridor::build(*trajectory->toLineString(), width_nm * 1852.0);
+        if (!corridor) {
+            return error(400, "trajectory needs two distinct vertices");
+        }
+
+        struct Hit {
+            Corridor::Position position;
+            enum class Kind { Protection, Project, Waypoint } kind;
+            size_t index; // slot, position in projects, or waypoint row
+        };
+        std::vector<Hit> hits;
+        std::vector<size_t> candidates;
+
+        std::shared_ptr<const ProtectionSet> protection_set;
+        if (want_protections) {
+            // Walk the zone trees with each segment's envelope; a zone seen
+            // from several segments is tested once
+            auto& proc_repo = *sources_.protections;
+            protection_set = currentProtectionSet(proc_repo);
+            const auto now = std::chrono::system_clock::now();
+            std::vector<uint8_t> seen(protection_set->protections.size(), 0);
+            std::vector<size_t> slots;
+            for (size_t segment = 0; segment < corridor->segmentCount(); segment++) {
+                protection_set->query(corridor->segmentEnvelope(segment), candidates);
+                for (size_t slot : candidates) {
+                    if (seen[slot]) continue;
+                    seen[slot] = 1;
+                    if (!protection_set->inForceAt(slot, now)) {
+                        continue;
+                    }
+                    slots.push_back(slot);
+                }
+            }
+            auto zones = resolveGeometries(*protection_set, slots, proc_repo);
+            for (size_t slot : slots) {
+                if (!zones[slot] || !zones[slot]->intersects(corridor->polygon())) continue;
+                if (auto contact = corridor->firstContact(*zones[slot]->geometry)) {
+                    hits.push_back({*contact, Hit::Kind::Protection, slot});
+                }
+            }
+        }
+
+        struct ProjectHit {
+            int project_id = 0;
+            std::optional<Project> project;
+        };
+        std::vector<ProjectHit> projects;
+        if (want_projects) {
+            auto& proj_repo = *sources_.projects;
+            for (const auto& [project_id, envelope] :
+                 projectEnvelopes(proj_repo, {ProjectStatus::Pending, ProjectStatus::UnderReview, ProjectStatus::Accepted})) {
+                corridor->segmentsOverlapping(envelope, candidates);
+                if (candidates.empty()) continue;
+                bool validated = false;
+                auto geojson = proj_repo.findGeometriesByProjectId(project_id, &validated);
+                if (!geojson) continue;
+                std::string parse_error;
+                std::optional<Corridor::Position> first;
+                for (const auto& feature : parseProjectGeometries(project_id, *geojson, parse_error, nullptr, validated)) {
+                    const OGRGeometry* geometry = geometryOf(feature);
+                    if (!geometry->Intersects(&corridor->polygon())) continue;
+                    auto contact = corridor->firstContact(*geometry);
+                    if (contact && (!first || contact->along_track_m < first->along_track_m)) first = contact;
+                }
+                if (first) {
+                    hits.push_back({*first, Hit::Kind::Project, projects.size()});
+                    projects.push_back({project_id, proj_repo.findById(project_id)});
+                }
+            }
+        }
+
+        auto snapshot = want_waypoints ? ReferenceDataStore::getInstance().snapshot() : nullptr;
+        if (snapshot) {
+            const auto& envelope = corridor->envelope();
+            if (auto bounds = GeoBounds::fromBox(envelope.MinY, envelope.MaxY, envelope.MinX, envelope.MaxX)) {
+                for (const Waypoint* waypoint : snapshot->waypointsInBounds(*bounds, "")) {
+                    OGREnvelope point;
+                    point.MinX = point.MaxX = waypoint->longitude;
+                    point.MinY = point.MaxY = waypoint->latitude;
+                    corridor->segmentsOverlapping(point, candidates);
+                    if (candidates.empty()) continue;
+                    auto position = corridor->locate(waypoint->longitude, waypoint->latitude);
+                    if (position.cross_track_m <= corridor->halfWidth()) {
+                        hits.push_back({position, Hit::Kind::Waypoint,
+                                        static_cast<size_t>(waypoint - snapshot->waypoints.data())});
+                    }
+                }
+            }
+        }
+
+        std::stable_sort(hits.begin(), hits.end(), [](const Hit& a, const Hit& b) {
+            return a.position.along_track_m < b.position.along_track_m;
+        });
+
+        std::string out;
+        JsonWriter writer(out);
+        writer.beginObject().rawKey("data").beginObject().rawKey("results").beginArray();
+        for (const auto& hit : hits) {
+            writer.beginObject();
+            switch (hit.kind) {
+                case Hit::Kind::Protection: {
+                    const auto& protection = protection_set->protections[hit.index];
+                    writer.rawField("type", "protection")
+                          .rawField("procedure_id", protection.procedure_id)
+                          .field("airport_icao", protection.airport_icao)
+                          .field("protection_name", protection.protection_name)
+                          .rawField("protection_type", protectionTypeName(protection.protection_type))
+                          .rawField("altitude_min", protection.altitude_min)
+                          .rawField("altitude_max", protection.altitude_max)
+                          .rawField("altitude_reference", altitudeReferenceName(protection.altitude_reference));
+                    break;
+                }
+                case Hit::Kind::Project: {
+                    const auto& project = projects[hit.index];
+                    writer.rawField("type", "project").rawField("project_id", project.project_id);
+                    if (project.project) {
+                        writer.field("project_code", project.project->project_code)
+                              .field("title", project.project->title)
+                              .rawField("status", statusName(project.project->status))
+                              .rawField("altitude_min", project.project->altitude_min)
+                              .rawField("altitude_max", project.project->altitude_max);
+                    }
+                    break;
+                }
+                case Hit::Kind::Waypoint:
+                    writer.rawField("type", "waypoint").rawKey("waypoint");
+                    snapshot->waypoints[hit.index].writeJson(writer);
+                    break;
+            }
+            writer.rawField("segment", static_cast<int64_t>(hit.position.segment))
+                  .rawField("along_track_nm", hit.position.along_track_m / 1852.0)
+                  .rawField("cross_track_nm", hit.position.cross_track_m / 1852.0)
+                  .endObject();
+        }
+        const double elapsed_ms = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - started).count();
+        writer.endArray()
+              .rawField("count", static_cast<int64_t>(hits.size()))
+              .rawField("width_nm", width_nm)
+              .rawField("length_nm", corridor->length() / 1852.0)
+              .rawField("segments", static_cast<int64_t>(corridor->segmentCount()))
+              .rawField("elapsed_ms", elapsed_ms)
+              .endObject()
+              .rawField("status", "success")
+              .endObject();
+
+        crow::response res(200, out);
+        res.add_header("Content-Type", "application/json");
+        return res;
+
+    } catch (const std::exception& e) {
+        spdlog::error("Corridor query failed: {}", e.what());
+        return error(500, "Internal server error");
+    }
+}
+
+crow::response ConflictController::getConflictGeometry(int project_id, int conflict_id) {
+    try {
+        auto conflict = repository_->findById(project_id, conflict_id);
+        if (!conflict) {
+            return crow::response(404, "{\"error\":\"Conflict not found\"}");
+        }
+
+        // Computed once; the result replaces the placeholder in the row
+        if (!isDeferredGeometry(conflict->conflicting_geometry)) {
+            crow::response res(200, conflict->conflicting_geometry);
+            res.add_header("Content-Type", "application/json");
+            return res;
+        }
+
+        auto& proj_repo = *sources_.projects;
+        auto& proc_repo = *sources_.protections;
+        bool validated = false;
+        auto project_geom_json = proj_repo.findGeometriesByProjectId(project_id, &validated);
+        auto stored = proc_repo.findProtectionGeometries({conflict->flight_procedure_id});
+        auto it = stored.find(conflict->flight_procedure_id);
+        if (!project_geom_json || it == stored.end()) {
+            return crow::response(404, "{\"error\":\"Project or protection geometry no longer exists\"}");
+        }
+        auto zone_geometry = it->second.wkb.empty()
+                                 ? ProtectionGeometryCache::parseProtectionGeometry(it->second.geojson)
+                                 : ProtectionGeometryCache::parseProtectionWkb(it->second.wkb);
+        std::string parse_error;
+        auto project_geometries = parseProjectGeometries(project_id, *project_geom_json, parse_error, nullptr, validated);
+        if (!zone_geometry || project_geometries.empty()) {
+            return crow::response(422, "{\"error\":\"Geometry could not be parsed\"}");
+        }
+
+        CachedProtectionGeometry zone;
+        zone.procedure_id = conflict->flight_procedure_id;
+        zone.geometry = std::move(zone_geometry);
+        zone.geometry->getEnvelope(&zone.envelope);
+        std::vector<size_t> features;
+        for (size_t i = 0; i < project_geometries.size(); i++) {
+            OGREnvelope envelope;
+            geometryOf(project_geometries[i])->getEnvelope(&envelope);
+            if (envelope.Intersects(zone.envelope)) {
+                features.push_back(i);
+            }
+        }
+        ZoneResult result = ZoneEvaluator::evaluate(zone, zone.procedure_id, project_geometries, features, true, false);
+
+        std::vector<const std::string*> parts;
+        for (const auto& hit : result.hits) {
+            if (!hit.intersection_json.empty()) parts.push_back(&hit.intersection_json);
+        }
+        std::string intersection_json = combineIntersections(parts);
+        if (result.conflict) {
+            if (repository_->updateGeometry(conflict_id, intersection_json)) {
+                ResultCache::getInstance().invalidate(ResultCache::projectTag(project_id));
+            } else {
+                spdlog::warn("Could not store the intersection geometry of conflict {}", conflict_id);
+            }
+        }
+        crow::response res(200, intersection_json);
+        res.add_header("Content-Type", "application/json");
+        return res;
+
+    } catch (const std::exception& e) {
+        spdlog::error("Failed to get geometry of conflict {} for project {}: {}", conflict_id, project_id, e.what());
+        return crow::response(500, "{\"error\":\"Internal server error\"}");
+    }
+}
+
+crow::response ConflictController::getSurfacePenetrations(int project_id) {
+    try {
+        auto& proj_repo = *sources_.projects;
+        auto project = proj_repo.findById(project_id);
+        if (!project) {
+            return crow::response(404, "{\"error\":\"Project not found\"}");
+        }
+        if (!project->altitude_max) {
+            return crow::response(422, "{\"error\":\"Project has no maximum altitude\"}");
+        }
+        auto snapshot = ReferenceDataStore::getInstance().snapshot();
+        if (!snapshot) {
+            return crow::response(503, "{\"error\":\"Reference data not loaded\"}");
+        }
+
+        bool validated = false;
+        auto geojson = proj_repo.findGeometriesByProjectId(project_id, &validated);
+        std::string parse_error;
+        auto geometries = geojson ? parseProjectGeometries(project_id, *geojson, parse_error, nullptr, validated)
+                                  : std::vector<GeometryHandle>{};
+        if (geometries.empty()) {
+            return crow::response(404, "{\"error\":\"Project has no usable geometry\"}");
+        }
+
+        OGREnvelope envelope;
+        for (const auto& geometry : geometries) {
+            OGREnvelope feature_envelope;
+            geometryOf(geometry)->getEnvelope(&feature_envelope);
+            envelope.Merge(feature_envelope);
+        }
+        const double centre_lat = (envelope.MinY + envelope.MaxY) / 2;
+        const double centre_lng = (envelope.MinX + envelope.MaxX) / 2;
+        const double radius_km = greatCircleKm(centre_lat, centre_lng, envelope.MaxY, envelope.MaxX) +
+                                 ObstacleSurfaceCache::kReachKm;
+
+        // Project altitudes are feet above sea level, surfaces metres
+        const double top_m = *project->altitude_max * 0.3048;
+        nlohmann::json airports = nlohmann::json::array();
+        std::vector<std::pair<std::shared_ptr<const AirportSurfaces>, SurfacePenetration>> found;
+        auto& cache = ObstacleSurfaceCache::getInstance();
+        auto bounds = GeoBounds::aroundPoint(centre_lat, centre_lng, radius_km);
+        for (const Airport* airport : bounds ? snapshot->airportsInBounds(*bounds, "") : std::vector<const Airport*>{}) {
+            auto surfaces = cache.get(snapshot->version, *airport, snapshot->runwaysForAirport(airport->id));
+            if (!surfaces || !surfaces->envelope.Intersects(envelope)) continue;
+            airports.push_back(airport->icao_code);
+
+            std::vector<SurfacePenetration> penetrations;
+            for (size_t i = 0; i < geometries.size(); i++) {
+                surfaces->check(*geometryOf(geometries[i]), i, top_m, penetrations);
+            }
+            for (const auto& penetration : penetrations) found.emplace_back(surfaces, penetration);
+        }
+
+        std::sort(found.begin(), found.end(), [](const auto& a, const auto& b) {
+            return a.second.penetration_m > b.second.penetration_m;
+        });
+        nlohmann::json penetrations = nlohmann::json::array();
+        for (const auto& [surfaces, penetration] : found) {
+            penetrations.push_back({{"airport", surfaces->icao_code},
+                                    {"surface", surfaceKindToString(penetration.facet->kind)},
+                                    {"runway", penetration.facet->runway},
+                                    {"feature", penetration.feature},
+                                    {"lng", penetration.lng},
+                                    {"lat", penetration.lat},
+                                    {"limit_m", penetration.limit_m},
+                                    {"penetration_m", penetration.penetration_m}});
+        }
+
+        crow::response res(200, nlohmann::json{{"project_id", project_id},
+                                               {"altitude_max_ft", *project->altitude_max},
+                                               {"airports", airports},
+                                               {"penetrations", penetrations}}.dump());
+        res.add_header("Content-Type", "application/json");
+        return res;
+
+    } catch (const std::exception& e) {
+        spdlog::error("Failed to check obstacle surfaces for project {}: {}", project_id, e.what());
+        return crow::response(500, "{\"error\":\"Internal server error\"}");
+    }
+}
+
+// Simplified geometry creation function that avoids union operations
+GeometryHandle ConflictController::createSimpleGeometryFromGeoJSON(const std::string& geojson) {
+    try {
+        auto geometry = GeoJsonReader::readGeometry(geojson);
+        if (!geometry) {
+            spdlog::error("Could not read a geometry from GeoJSON");
+            return nullptr;
+        }
+        return validGeometry(std::move(geometry));
+
+    } catch (const std::exception& e) {
+        spdlog::error("Exception while parsing GeoJSON: {}", e.what());
+        return nullptr;
+    }
+}
+
+GeometryHandle ConflictController::withObstacleBuffer(GeometryHandle geometry) const {
+    const double metres = obstacleBuffer();
+    if (!geometry || metres <= 0 || geometryOf(geometry)->getDimension() > 1) {
+        return geometry;
+    }
+    auto grown = LocalProjection::buffer(*geometryOf(geometry), metres);
+    if (!grown) {
+        spdlog::warn("Could not buffer a {} feature by {} m, testing it as drawn",
+                     geometryOf(geometry)->getGeometryName(), metres);
+        return geometry;
+    }
+    return toHandle(std::move(grown));
+}
+
+GeometryHandle ConflictController::validGeometry(std::unique_ptr<OGRGeometry> geometry) {
+    if (geometry && !geometry->IsValid()) {
+        spdlog::warn("Fixing invalid geometry");
+        if (OGRGeometry* fixed = geometry->Buffer(0)) {
+            geometry.reset(fixed);
+        }
     }
+    return toHandle(std::move(geometry));
 }
 } // namespace aeronautical
\ No newline at end of file
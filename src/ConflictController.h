@@ -1,15 +1,38 @@
 #pragma once
 
 #include <crow.h>
+#include "HttpApp.h"
 #include "ogr_geometry.h"
 #include "ConflictRepository.h"
 #include "ProjectRepository.h"
 #include "FlightProcedureRepository.h"
+#include "ProtectionIndex.h"
+#include "SnapshotPublisher.h"
+#include "ProtectionGeometryCache.h"
+#include "ThreadPool.h"
+#include "AnalysisJobQueue.h"
+#include "ConflictMetrics.h"
+#include "CoverageMask.h"
+#include "OgrHandles.h"
+#include "ZoneEvaluator.h"
+#include "TerrainService.h"
+#include "VerticalProfile.h"
+#include "TimeSchedule.h"
+#include "AiracCycle.h"
+#include "AnalysisShadow.h"
+#include <algorithm>
+#include <atomic>
+#include <functional>
 #include <memory>
+#include <optional>
+#include <span>
+#include <unordered_map>
 #include <mutex> // Include for thread-safety
 
 namespace aeronautical {
 
+class AnalysisProfile;
+
 class ConflictController {
 public:
     // Make the instance accessible via a static method
@@ -19,16 +42,372 @@ public:
     ConflictController(const ConflictController&) = delete;
     ConflictController& operator=(const ConflictController&) = delete;
 
-    void analyzeProject(int project_id);
-    OGRGeometryH createSimpleGeometryFromGeoJSON(const std::string& geojson);
+    // Progress, when given, is updated as protection zones are evaluated
+    void analyzeProject(int project_id, AnalysisProgress* progress = nullptr);
+    GeometryHandle createSimpleGeometryFromGeoJSON(const std::string& geojson);
+    // Takes ownership; an invalid geometry is repaired with Buffer(0)
+    static GeometryHandle validGeometry(std::unique_ptr<OGRGeometry> geometry);
     
-    void registerRoutes(crow::SimpleApp& app);
-    crow::response getConflictsByProject(int project_id);
+    void registerRoutes(HttpApp& app);
+    // The whole list as an array, or with ?limit= / ?after= one page of it;
+    // conflicting_geometry only with ?include_geometry=true
+    crow::response getConflictsByProject(const crow::request& req, int project_id);
+    // Count, per-severity breakdown and affected procedures, kept in
+    // ResultCache and primed by analyzeProject when it stores the results
+    crow::response getConflictSummary(int project_id);
+    crow::response getConflictChanges(int project_id);
+    // Intersection geometry of one conflict, built now if analysis deferred it
+    crow::response getConflictGeometry(int project_id, int conflict_id);
+
+    // Vertices of the project's features whose top (altitude_max) rises
+    // above an obstacle limitation surface of a nearby airport, the worst
+    // per feature and surface facet (see ObstacleSurfaces)
+    crow::response getSurfacePenetrations(int project_id);
+
+    // Dry run of a FeatureCollection against the current protection set;
+    // nothing is written. ?include_geometry=true adds the intersections.
+    crow::response previewConflicts(const crow::request& req);
+    static constexpr size_t kMaxPreviewFeatures = 1000;
+
+    // Active zones covering lat/lng (boundary included) and in force now;
+    // with alt (feet MSL) only those whose band holds it. Read from the
+    // current protection set and cached geometries, so once warm a call
+    // needs no query and no GEOS parse.
+    crow::response getProtectionsAt(const crow::request& req);
+
+    // Everything within width_nm of a trajectory LineString: active zones,
+    // projects under review or accepted (existing obstacles) and active
+    // waypoints, ordered by along-track distance of their first contact
+    // with the corridor (see Corridor). Nothing is stored.
+    crow::response queryCorridor(const crow::request& req);
+    static constexpr double kMaxCorridorWidthNm = 50.0;
+    static constexpr int kMaxCorridorVertices = 10000;
+
+    // Deferred mode stores each conflict with kDeferredGeometry and summary
+    // counts only; the intersection is computed on first request
+    void setDeferredIntersections(bool deferred) { deferred_intersections_.store(deferred, std::memory_order_relaxed); }
+    bool deferredIntersections() const { return deferred_intersections_.load(std::memory_order_relaxed); }
+    static constexpr const char* kDeferredGeometry = R"({"type":"GeometryCollection","geometries":[]})";
+
+    // Triage stores conflicts with overlap area, ratio and severity but
+    // defers the intersection geometry; polygons are clipped only where the
+    // envelope bound leaves the severity open. Takes precedence over deferred mode.
+    void setTriage(bool triage) { triage_.store(triage, std::memory_order_relaxed); }
+    bool triage() const { return triage_.load(std::memory_order_relaxed); }
+
+    // With the coverage mask, analyses and previews first check the
+    // features' envelopes against the dissolved footprint of every active
+    // zone (see CoverageMask) and, when none meets it, answer "no conflict"
+    // before any geometry is parsed. The mask is built in the background
+    // for each protection set, rasterizing only shards that changed.
+    void setCoverageMask(bool enabled) { coverage_enabled_.store(enabled, std::memory_order_relaxed); }
+    bool coverageMask() const { return coverage_enabled_.load(std::memory_order_relaxed); }
+
+    // Lateral buffer in metres around point and line features (obstacles)
+    // before they are tested; 0 tests them as drawn. Buffering runs in a
+    // local metric projection (see LocalProjection).
+    void setObstacleBuffer(double metres) { obstacle_buffer_m_.store(std::max(metres, 0.0), std::memory_order_relaxed); }
+    double obstacleBuffer() const { return obstacle_buffer_m_.load(std::memory_order_relaxed); }
+
+    // A zone whose procedure has segment altitude constraints is checked
+    // against the floor of that vertical profile (see VerticalProfile) less
+    // this margin in feet, the obstacle clearance: features of a project
+    // whose top stays below it are not in conflict, and the clearance of
+    // the others is taken from the profile instead of the flat band
+    void setProfileMargin(double feet) { profile_margin_ft_.store(std::max(feet, 0.0), std::memory_order_relaxed); }
+    double profileMargin() const { return profile_margin_ft_.load(std::memory_order_relaxed); }
+    static constexpr double kDefaultProfileMarginFt = 246.0; // 75 m, final approach MOC
+
+    // Queues an impact analysis on the analysis pool after a procedure's
+    // protection changed (see analyzeProcedureImpact)
+    void scheduleImpactAnalysis(int procedure_id);
+    // Re-evaluates only the (project, procedure) pairs the change can affect:
+    // projects under review that held a conflict with the procedure, plus
+    // those whose envelope touches its current protection. Returns how many
+    // projects were re-evaluated.
+    size_t analyzeProcedureImpact(int procedure_id);
+
+    // Re-analyzes every Pending and UnderReview project, e.g. after a new
+    // AIRAC cycle. The protection set is loaded once for the whole batch and
+    // projects run in parallel on the analysis pool, taken in Z-order of
+    // their envelope centres so neighbours run together and share the zones
+    // in ProtectionGeometryCache. Projects with a queued or running job are
+    // left to it. Returns the number of projects analyzed.
+    size_t analyzeOpenProjects();
+    // Runs analyzeOpenProjects on the analysis pool; false when one is already running
+    bool scheduleOpenProjectsAnalysis();
+
+    // One zone an open project crosses, as found by joinOpenProjects
+    struct JoinedConflict {
+        int project_id = 0;
+        int procedure_id = 0;
+        std::string airport_icao;
+        std::string protection_name;
+        size_t features_in_conflict = 0;
+        size_t features_inside = 0;
+        ConflictMetrics metrics{}; // bounds first, see FeatureOverlap::estimate
+        std::optional<double> vertical_clearance_ft{};
+        std::optional<double> penetration_depth_ft{};
+    };
+    // Every conflict between the Pending and UnderReview projects and the
+    // active zones, restricted to features reaching region when given, from
+    // one spatial join instead of one analysis per project: the features of
+    // all projects go into one R-tree, which is descended together with
+    // each airport's zone tree in parts run on the analysis pool. Candidate
+    // pairs are then evaluated like an analysis does, without intersection
+    // geometry, and handed to emit ordered by project and zone, a few hundred
+    // at a time. Nothing is stored. Returns the number emitted.
+    size_t joinOpenProjects(const std::optional<OGREnvelope>& region,
+                            const std::function<void(const JoinedConflict&)>& emit);
+    // joinOpenProjects as a report; min_lat, max_lat, min_lng and max_lng
+    // together give the region
+    crow::response getConflictReport(const crow::request& req);
+
+    // Locality key of an envelope for AnalysisJobQueue: a hash of the
+    // airports whose shard of the published protection set it meets, 0
+    // when it meets none or no set is published yet. Never queries.
+    uint64_t regionOf(const OGREnvelope& envelope) const;
+
+    // Builds the protection zone index and parses every zone's geometry
+    // into ProtectionGeometryCache, so the first analysis after a start
+    // does not pay for it. Returns the number of zones loaded.
+    size_t warmUp();
+    // Zones, shards and generation of the published protection index, and
+    // the projects whose analysis state is kept
+    nlohmann::json protectionIndexStats();
+    // Drops the published index and every project's analysis state; the
+    // next analysis (or warmUp) builds them again
+    void resetProtectionIndex();
+
+    // Sizes the analysis worker pool (separate from Crow's HTTP workers),
+    // split between NUMA nodes when numa_aware (see ThreadPool).
+    // Only the first call takes effect; call before the first analysis.
+    void setAnalysisThreads(size_t threads, CpuSet cpus = {}, bool numa_aware = false);
+    // Where analyses read protections and projects and store their results;
+    // MySQL unless replaced (InMemorySources.h). Call before the first analysis.
+    void setSources(AnalysisSources sources);
+    ThreadPool& analysisPool();
 
 private:
     ConflictController(); // Make the constructor private
+
+    static std::string summaryKey(int project_id) { return "conflicts.summary:" + std::to_string(project_id); }
+    static std::string changesKey(int project_id) { return "conflicts.changes:" + std::to_string(project_id); }
+
+    // The zones of one airport: an R-tree over their envelopes, with slots
+    // relative to the shard's first zone, and the envelope of them all
+    struct ProtectionShard {
+        std::string airport_icao;
+        size_t signature = 0; // procedure ids and versions, in slot order
+        std::vector<std::pair<int, int64_t>> zones; // procedure id and version of each slot
+        OGREnvelope envelope;
+        ProtectionIndex index;
+    };
+
+    // Active protection zones, grouped by airport into shards. Envelopes
+    // come from stored footprints where they are current, so zones with one
+    // are parsed only once an analysis needs them. Kept between runs and
+    // rebuilt only when a procedure version changes or the cache is
+    // invalidated; a shard whose zones are unchanged is carried over as is,
+    // and one with a few edited zones updates its tree instead of rebuilding.
+    // A published set is never modified, so analyses load it without a lock.
+    struct ProtectionSet {
+        std::vector<ProcedureProtection> protections;
+        // Parallel to protections; null until the geometry has been parsed
+        std::vector<std::shared_ptr<const CachedProtectionGeometry>> geometries;
+        // Parallel to protections; null for a procedure without altitude constraints
+        std::vector<std::shared_ptr<const VerticalProfile>> profiles;
+        // Parallel to protections; time_restriction compiled once, null without one
+        std::vector<std::shared_ptr<const TimeSchedule>> schedules;
+        std::vector<std::shared_ptr<const ProtectionShard>> shards;
+        std::vector<size_t> shard_first; // slot of each shard's first zone
+        size_t signature = 0;
+        uint64_t generation = 0; // ProtectionGeometryCache generation it was built at
+
+        // Slots whose envelope overlaps envelope, in ascending order; shards
+        // whose envelope misses it are skipped without touching their tree,
+        // and a parsed subdivided zone is kept only when one of its tiles meets it
+        void query(const OGREnvelope& envelope, std::vector<size_t>& out) const;
+        // Effective, not expired and within its hours at now
+        bool inForceAt(size_t slot, std::chrono::system_clock::time_point now) const;
+        // Effective at some point of the cycle; the weekly hours do not
+        // matter over 28 days
+        bool inForceDuring(size_t slot, const AiracCycle& cycle) const;
+        // "YYNN-" and a content hash of the zones in force during cycle at
+        // their revisions: unlike signature it depends on nothing but the
+        // data, so it is the same on every instance and after a restart.
+        // Worked out once per cycle.
+        std::string snapshot(const AiracCycle& cycle) const;
+
+    private:
+        mutable std::mutex snapshot_mutex_;
+        mutable std::unordered_map<int, std::string> snapshots_; // by year * 100 + number
+    };
+
+    std::shared_ptr<const ProtectionSet> getProtectionSet(ProtectionSource& proc_repo);
+    // The last built set while no procedure has been invalidated since, without
+    // asking the database; getProtectionSet otherwise
+    std::shared_ptr<const ProtectionSet> currentProtectionSet(ProtectionSource& proc_repo);
+    // Geometries of the given slots, parsed through ProtectionGeometryCache as
+    // needed; a slot whose geometry cannot be loaded stays null
+    std::vector<std::shared_ptr<const CachedProtectionGeometry>>
+    resolveGeometries(const ProtectionSet& set, std::span<const size_t> slots, ProtectionSource& proc_repo);
+    // Publishes one stored geometry in the cache, decoding its WKB when
+    // current; a geometry parsed from GeoJSON has its WKB written back
+    std::shared_ptr<const CachedProtectionGeometry> loadProtectionGeometry(const ProcedureProtection& protection,
+                                                                           const StoredProtectionGeometry& stored,
+                                                                           ProtectionSource& proc_repo);
+
+    // The set's coverage mask once built for it; null while disabled or
+    // while it is being built, which this starts on the analysis pool
+    std::shared_ptr<const CoverageMask> coverageOf(const std::shared_ptr<const ProtectionSet>& set);
+    // Rasterizes the shards with no mask yet and publishes the set's mask
+    void buildCoverage(const std::shared_ptr<const ProtectionSet>& set);
+    // Whether features with these envelopes, widened by the obstacle
+    // buffer, meet no zone of set; false without envelopes or a mask
+    bool outsideCoverage(const std::shared_ptr<const ProtectionSet>& set, const std::vector<OGREnvelope>& envelopes);
+
+    using FeatureHit = ZoneEvaluator::Hit;
+    using ZoneResult = ZoneEvaluator::Result;
+
+    // One geometry, or a GeometryCollection of several; "{}" for none
+    static std::string combineIntersections(std::span<const std::string* const> parts);
+    // Features of a stored project FeatureCollection (or single geometry);
+    // empty with error set when none can be used.
+    // geometry_hashes, when given, receives a hash of each returned feature's geometry.
+    // A validated collection was repaired when saved and is not checked again.
+    // Coordinates are read into resource on their way to OGR. profile, when
+    // given, is charged the validation time.
+    std::vector<GeometryHandle> parseProjectGeometries(int project_id, const std::string& geojson, std::string& error,
+                                                       std::vector<size_t>* geometry_hashes = nullptr,
+                                                       bool validated = false,
+                                                       std::pmr::memory_resource* resource = std::pmr::get_default_resource(),
+                                                       AnalysisProfile* profile = nullptr);
+
+    // Per-feature results of a project's last analysis, keyed by geometry
+    // hash. Valid while the protection set, the zones eligible for the
+    // project and the deferred mode are unchanged (context); a resubmission
+    // then evaluates only the features whose geometry is new.
+    struct FeatureOutcome {
+        struct Hit {
+            size_t slot = 0;
+            bool inside = false;
+            std::string intersection_json;
+            std::optional<FeatureOverlap> overlap;
+        };
+        std::vector<Hit> hits;
+    };
+    struct ProjectAnalysisState {
+        size_t context = 0;
+        std::unordered_map<size_t, FeatureOutcome> features;
+    };
+    static constexpr size_t kMaxAnalysisStates = 128;
+
+    // Envelope of every project under review, reparsed only when a project's
+    // geometry revision changes
+    std::vector<std::pair<int, OGREnvelope>> projectEnvelopes(ProjectGeometrySource& proj_repo);
+    // Same for projects in any of statuses; the envelopes of other projects are dropped
+    std::vector<std::pair<int, OGREnvelope>> projectEnvelopes(ProjectGeometrySource& proj_repo,
+                                                              std::initializer_list<ProjectStatus> statuses);
+    // Envelope of a project's features, parsed now; nullopt without usable features
+    std::optional<OGREnvelope> parseProjectEnvelope(ProjectGeometrySource& proj_repo, int project_id);
+    // Projects in status whose envelope overlaps envelope. While the envelopes
+    // above are cold, the source's stored envelopes answer in MySQL and only
+    // projects without a current one are parsed (and theirs stored).
+    std::vector<int> projectsOverlapping(ProjectGeometrySource& proj_repo, ProjectStatus status,
+                                         const OGREnvelope& envelope);
+
+    // analyzeProject against a protection set the caller already holds
+    void analyzeProject(int project_id, AnalysisProgress* progress,
+                        std::shared_ptr<const ProtectionSet> protection_set);
+
+    // Queues a shadow run of an analysis that stored fast (see
+    // AnalysisShadow) on the analysis pool; nothing it computes is stored
+    void shadowAnalysis(int project_id, std::shared_ptr<const ProtectionSet> set, std::string project_geojson,
+                        std::vector<AnalysisShadow::Conflict> fast, std::chrono::nanoseconds fast_time);
+    // The reference engine: the project's conflicts against set, found
+    // without the analysis's shortcuts; nullopt when the features cannot be
+    // parsed or a zone they reach cannot be loaded
+    std::optional<std::vector<AnalysisShadow::Conflict>> referenceConflicts(int project_id, const ProtectionSet& set,
+                                                                            const std::string& project_geojson);
+
+    std::shared_ptr<const ProjectAnalysisState> analysisState(int project_id);
+    void storeAnalysisState(int project_id, std::shared_ptr<const ProjectAnalysisState> state);
+    static bool isDeferredGeometry(const std::string& geojson);
+    // Takes ownership; a point or line feature comes back grown by the
+    // obstacle buffer, anything else (or a failed buffer) unchanged
+    GeometryHandle withObstacleBuffer(GeometryHandle geometry) const;
+
+    // Cheap checks before any geometry work; a bound that is not set never excludes
+    // the zone's hours when given are checked over the project's dates
+    static bool overlapsInTime(const ProcedureProtection& protection, const Project& project,
+                               std::chrono::system_clock::time_point now, const TimeSchedule* schedule = nullptr);
+    static bool overlapsVertically(const ProcedureProtection& protection, const Project& project,
+                                   const std::optional<ElevationRange>& terrain = std::nullopt);
+    // Floor and ceiling of a zone in feet; nullopt for an AGL band without terrain
+    struct ZoneBand {
+        std::optional<double> floor_ft;
+        std::optional<double> ceiling_ft;
+    };
+    static std::optional<ZoneBand> zoneBand(const ProcedureProtection& protection,
+                                            const std::optional<ElevationRange>& terrain);
+    // Sets the vertical clearance and penetration depth of a conflict from
+    // the same bands; left unset without the project top or the zone floor
+    static void addVerticalRelation(PendingConflict& conflict, const ProcedureProtection& protection,
+                                    const Project& project, const std::optional<ElevationRange>& terrain);
+    // PendingConflict::signature of a conflict found for these feature
+    // geometry hashes against a zone revision, in the given result mode
+    static uint64_t resultSignature(const PendingConflict& conflict, int64_t zone_version, int mode,
+                                    std::span<size_t> feature_hashes);
+    static nlohmann::json changesToJson(const ConflictDiff& changes);
+    // Clearance in feet of a feature under the vertical profile of slot's
+    // zone; nullopt without a profile or the project's top
+    std::optional<double> profileClearance(const ProtectionSet& set, size_t slot, const Project& project,
+                                           const OGRGeometry& feature) const;
+    // Drops the hits whose feature clears the profile (conflict follows the
+    // hits left) and returns the least clearance of those kept
+    std::optional<double> filterByProfile(const ProtectionSet& set, size_t slot, const Project& project,
+                                          const std::vector<GeometryHandle>& features, ZoneResult& result) const;
+    // The vertical relation of a conflict under a profile, replacing the band's
+    static void addProfileRelation(PendingConflict& conflict, double clearance_ft);
+    // Terrain under the project features' vertices (see TerrainService)
+    static std::optional<ElevationRange> terrainUnder(const std::vector<GeometryHandle>& geometries);
     
     std::unique_ptr<ConflictRepository> repository_;
+    AnalysisSources sources_;
+    SnapshotPublisher<ProtectionSet> protection_set_;
+    std::mutex protection_mutex_; // one rebuild at a time; readers never take it
+    struct Coverage {
+        size_t signature = 0; // of the protection set it was built for
+        CoverageMask mask;
+    };
+    SnapshotPublisher<Coverage> coverage_;
+    std::mutex coverage_mutex_; // guards the two below
+    // Masks of the last built set's shards by airport and shard signature
+    std::unordered_map<std::string, std::shared_ptr<const CoverageMask>> shard_coverage_;
+    bool coverage_building_ = false;
+    std::atomic<bool> coverage_enabled_{true};
+    std::atomic<uint64_t> coverage_rejections_{0};
+    struct StoredAnalysisState {
+        std::shared_ptr<const ProjectAnalysisState> state;
+        uint64_t last_used = 0;
+    };
+    std::unordered_map<int, StoredAnalysisState> analysis_states_;
+    uint64_t analysis_state_clock_ = 0;
+    std::mutex analysis_state_mutex_;
+    struct ProjectEnvelope {
+        std::string revision;
+        OGREnvelope envelope;
+    };
+    std::unordered_map<int, ProjectEnvelope> project_envelopes_;
+    std::mutex project_envelope_mutex_;
+    std::atomic<bool> open_projects_running_{false};
+    std::atomic<bool> deferred_intersections_{false};
+    std::atomic<bool> triage_{false};
+    std::atomic<double> obstacle_buffer_m_{0};
+    std::atomic<double> profile_margin_ft_{kDefaultProfileMarginFt};
+    std::unique_ptr<ThreadPool> pool_;
+    std::once_flag pool_once_flag_;
     static std::unique_ptr<ConflictController> instance_;
     static std::once_flag once_flag_;
 };
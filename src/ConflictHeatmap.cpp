@@ -0,0 +1,387 @@
+#include "ConflictHeatmap.h"
+#include "ConflictRepository.h"
+#include "DatabaseManager.h"
+#include "GeoJsonReader.h"
+#include "JsonWriter.h"
+#include "SchemaMigrations.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace aeronautical {
+
+namespace {
+
+// Conflicts located per backfill transaction
+constexpr size_t kBackfillBatch = 500;
+constexpr int kDefaultDays = 30;
+constexpr int kMaxZoom = 22;
+
+crow::response jsonError(int code, const std::string& message) {
+    crow::response res(code, nlohmann::json{{"error", true}, {"message", message}}.dump());
+    res.add_header("Content-Type", "application/json");
+    return res;
+}
+
+std::string formatDay(std::chrono::sys_days day) {
+    const std::chrono::year_month_day ymd(day);
+    char text[16];
+    std::snprintf(text, sizeof(text), "%04d-%02u-%02u", static_cast<int>(ymd.year()),
+                  static_cast<unsigned>(ymd.month()), static_cast<unsigned>(ymd.day()));
+    return text;
+}
+
+std::optional<std::chrono::sys_days> parseDay(const char* text) {
+    int year = 0;
+    unsigned month = 0, day = 0;
+    char tail = 0;
+    if (std::sscanf(text, "%4d-%2u-%2u%c", &year, &month, &day, &tail) != 3) return std::nullopt;
+    const std::chrono::year_month_day ymd{std::chrono::year(year), std::chrono::month(month), std::chrono::day(day)};
+    if (!ymd.ok()) return std::nullopt;
+    return std::chrono::sys_days(ymd);
+}
+
+// from and to of the request as YYYY-MM-DD; the last kDefaultDays days by default
+bool dayRange(const crow::request& req, std::string& from, std::string& to, std::string& error) {
+    const auto today = std::chrono::floor<std::chrono::days>(std::chrono::system_clock::now());
+    auto last = today;
+    if (const char* text = req.url_params.get("to")) {
+        auto parsed = parseDay(text);
+        if (!parsed) {
+            error = "to must be a date as YYYY-MM-DD";
+            return false;
+        }
+        last = *parsed;
+    }
+    auto first = last - std::chrono::days(kDefaultDays - 1);
+    if (const char* text = req.url_params.get("from")) {
+        auto parsed = parseDay(text);
+        if (!parsed) {
+            error = "from must be a date as YYYY-MM-DD";
+            return false;
+        }
+        first = *parsed;
+    }
+    if (first > last) {
+        error = "from is after to";
+        return false;
+    }
+    from = formatDay(first);
+    to = formatDay(last);
+    return true;
+}
+
+// severity= and airport= as conditions on conflict_heat, their values appended to params
+std::string filterSql(const crow::request& req, std::vector<SqlParam>& params) {
+    std::string sql;
+    if (const char* severity = req.url_params.get("severity")) {
+        sql += " AND severity = ?";
+        params.emplace_back(std::string(severity));
+    }
+    if (const char* airport = req.url_params.get("airport")) {
+        sql += " AND airport_icao = ?";
+        params.emplace_back(std::string(airport));
+    }
+    return sql;
+}
+
+std::string levelsSql() {
+    std::string sql;
+    for (int level : ConflictHeatmap::kLevels) {
+        sql += (sql.empty() ? "SELECT " : " UNION ALL SELECT ") + std::to_string(level) + (sql.empty() ? " AS level" : "");
+    }
+    return sql;
+}
+
+} // namespace
+
+ConflictHeatmap& ConflictHeatmap::getInstance() {
+    static ConflictHeatmap instance;
+    return instance;
+}
+
+bool ConflictHeatmap::probeTables() {
+    static std::once_flag once;
+    static bool has_tables = false;
+
+    std::call_once(once, []() {
+        has_tables = SchemaMigrations::hasColumn("conflicts", "heat_cell") &&
+                     SchemaMigrations::hasTable("conflict_heat");
+        spdlog::info("Conflict heatmap {}", has_tables ? "maintained" : "not maintained (no conflict_heat table)");
+    });
+
+    return has_tables;
+}
+
+int64_t ConflictHeatmap::cellOf(std::string_view geojson) {
+    auto geometry = GeoJsonReader::readGeometry(geojson);
+    if (!geometry || geometry->IsEmpty()) return -1;
+    OGREnvelope envelope;
+    geometry->getEnvelope(&envelope);
+    const double lng = (envelope.MinX + envelope.MaxX) / 2;
+    const double lat = std::clamp((envelope.MinY + envelope.MaxY) / 2, -85.0511, 85.0511);
+    if (!std::isfinite(lng) || !std::isfinite(lat)) return -1;
+
+    constexpr int64_t n = int64_t{1} << kFinestLevel;
+    const double lat_rad = lat * M_PI / 180.0;
+    const double fx = (lng + 180.0) / 360.0;
+    const double fy = (1.0 - std::log(std::tan(lat_rad) + 1.0 / std::cos(lat_rad)) / M_PI) / 2.0;
+    const int64_t x = std::clamp<int64_t>(static_cast<int64_t>(std::floor(fx * n)), 0, n - 1);
+    const int64_t y = std::clamp<int64_t>(static_cast<int64_t>(std::floor(fy * n)), 0, n - 1);
+    return x * n + y;
+}
+
+bool ConflictHeatmap::record(const std::string& where, bool opened, const std::string& day_sql) {
+    if (!probeTables()) return true;
+    const std::string n = std::to_string(int64_t{1} << kFinestLevel);
+    const std::string shift = " >> (" + std::to_string(kFinestLevel) + " - l.level)";
+    const std::string count = opened ? "COUNT(*), 0" : "0, COUNT(*)";
+    return DatabaseManager::getInstance().executeQuery(
+        "INSERT INTO conflict_heat (level, x, y, day, severity, airport_icao, opened, resolved)"
+        " SELECT l.level, (c.heat_cell DIV " + n + ")" + shift + ", (c.heat_cell MOD " + n + ")" + shift + ", " +
+        day_sql + ", COALESCE(c.severity, ''), COALESCE(fp.airport_icao, ''), " + count +
+        " FROM conflicts c LEFT JOIN flight_procedures fp ON fp.id = c.flight_procedure_id"
+        " CROSS JOIN (" + levelsSql() + ") l"
+        " WHERE c.heat_cell >= 0 AND (" + where + ")"
+        " GROUP BY 1, 2, 3, 4, 5, 6"
+        " ON DUPLICATE KEY UPDATE opened = opened + VALUES(opened), resolved = resolved + VALUES(resolved)");
+}
+
+bool ConflictHeatmap::backfill() {
+    if (!probeTables()) return false;
+    std::lock_guard<std::mutex> guard(backfill_mutex_);
+    auto& db = DatabaseManager::getInstance();
+    const std::string geometry =
+        ConflictRepository::probeSpatialSupport() ? "ST_AsGeoJSON(conflicting_geometry)" : "conflicting_geometry";
+    uint64_t located = 0;
+
+    try {
+        while (true) {
+            DatabaseManager::Transaction transaction(db);
+            // Locked so a backfill on another instance cannot count them too
+            MysqlResult result = db.executeSelectQuery("SELECT id, " + geometry +
+                                                       " FROM conflicts WHERE heat_cell IS NULL ORDER BY id LIMIT " +
+                                                       std::to_string(kBackfillBatch) + " FOR UPDATE");
+            if (!result) return false;
+            std::string ids;
+            std::string cases;
+            MYSQL_ROW row;
+            size_t rows = 0;
+            while ((row = mysql_fetch_row(result.get()))) {
+                unsigned long* lengths = mysql_fetch_lengths(result.get());
+                const int64_t cell = row[1] ? cellOf(std::string_view(row[1], lengths[1])) : -1;
+                ids += (ids.empty() ? "" : ",") + std::string(row[0]);
+                cases += " WHEN " + std::string(row[0]) + " THEN " + std::to_string(cell);
+                rows++;
+            }
+            if (rows == 0) break;
+
+            const bool ok = db.executeQuery("UPDATE conflicts SET heat_cell = CASE id" + cases + " END WHERE id IN (" +
+                                            ids + ")") &&
+                            record("c.id IN (" + ids + ")", true, "DATE(c.created_at)");
+            if (!ok) {
+                transaction.rollback();
+                spdlog::error("Conflict heatmap backfill failed after {} conflicts", located);
+                return false;
+            }
+            if (!transaction.commit()) return false;
+            located += rows;
+            if (rows < kBackfillBatch) break;
+        }
+    } catch (const std::exception& e) {
+        spdlog::error("Conflict heatmap backfill failed: {}", e.what());
+        return false;
+    }
+
+    backfilled_.fetch_add(located, std::memory_order_relaxed);
+    last_backfill_ms_.store(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                std::chrono::system_clock::now().time_since_epoch()).count(),
+                            std::memory_order_relaxed);
+    if (located > 0) {
+        spdlog::info("Conflict heatmap: located {} conflicts stored without a cell", located);
+    }
+    return true;
+}
+
+bool ConflictHeatmap::rebuild() {
+    if (!probeTables()) return false;
+    auto& db = DatabaseManager::getInstance();
+    try {
+        std::lock_guard<std::mutex> guard(backfill_mutex_);
+        DatabaseManager::Transaction transaction(db);
+        if (!db.executeQuery("DELETE FROM conflict_heat") ||
+            !db.executeQuery("UPDATE conflicts SET heat_cell = NULL")) {
+            transaction.rollback();
+            return false;
+        }
+        if (!transaction.commit()) return false;
+    } catch (const std::exception& e) {
+        spdlog::error("Conflict heatmap rebuild failed: {}", e.what());
+        return false;
+    }
+    return backfill();
+}
+
+void ConflictHeatmap::registerRoutes(HttpApp& app) {
+    // GET /api/conflicts/heatmap/:z/:x/:y - conflict counts of the cells in a map tile
+    CROW_ROUTE(app, "/api/conflicts/heatmap/<int>/<int>/<int>")
+        .methods(crow::HTTPMethod::GET)
+        ([this](const crow::request& req, int z, int x, int y) {
+            return tile(req, z, x, y);
+        });
+
+    // GET /api/conflicts/heatmap/airports - conflict counts per airport and day
+    CROW_ROUTE(app, "/api/conflicts/heatmap/airports")
+        .methods(crow::HTTPMethod::GET)
+        ([this](const crow::request& req) {
+            return airports(req);
+        });
+}
+
+crow::response ConflictHeatmap::tile(const crow::request& req, int z, int x, int y) const {
+    if (!probeTables()) {
+        return jsonError(503, "The conflict heatmap needs schema migration 7");
+    }
+    if (z < 0 || z > kMaxZoom || x < 0 || y < 0 || x >= (1 << z) || y >= (1 << z)) {
+        return jsonError(400, "No such tile");
+    }
+    std::string from, to, message;
+    if (!dayRange(req, from, to, message)) {
+        return jsonError(400, message);
+    }
+
+    // About 8x8 cells per tile, from the levels kept
+    int level = kFinestLevel;
+    for (int candidate : kLevels) {
+        if (candidate >= z + 3) {
+            level = candidate;
+            break;
+        }
+    }
+    int64_t x0, x1, y0, y1;
+    if (z >= level) {
+        x0 = x1 = x >> (z - level);
+        y0 = y1 = y >> (z - level);
+    } else {
+        const int shift = level - z;
+        x0 = int64_t{x} << shift;
+        y0 = int64_t{y} << shift;
+        x1 = x0 + (int64_t{1} << shift) - 1;
+        y1 = y0 + (int64_t{1} << shift) - 1;
+    }
+
+    std::vector<SqlParam> params = {from, from, int64_t{level}, x0, x1, y0, y1, to};
+    const std::string filters = filterSql(req, params);
+    try {
+        DatabaseManager::ReadScope scope(DatabaseManager::getInstance());
+        auto result = DatabaseManager::getInstance().executePrepared(
+            "SELECT x, y, SUM(opened) - SUM(resolved),"
+            " SUM(CASE WHEN day >= ? THEN opened ELSE 0 END), SUM(CASE WHEN day >= ? THEN resolved ELSE 0 END)"
+            " FROM conflict_heat WHERE level = ? AND x BETWEEN ? AND ? AND y BETWEEN ? AND ? AND day <= ?" +
+                filters + " GROUP BY x, y ORDER BY x, y",
+            params);
+
+        // Cells as [x, y, open on to, opened and resolved from..to] at level
+        std::string body;
+        JsonWriter writer(body);
+        writer.beginObject()
+            .field("z", z)
+            .field("x", x)
+            .field("y", y)
+            .field("level", level)
+            .field("from", from)
+            .field("to", to)
+            .key("cells")
+            .beginArray();
+        for (const auto& row : result.rows) {
+            const int64_t open = row.getInt(2), opened = row.getInt(3), resolved = row.getInt(4);
+            if (open == 0 && opened == 0 && resolved == 0) continue;
+            writer.beginArray().value(row.getInt(0)).value(row.getInt(1)).value(open).value(opened).value(resolved)
+                .endArray();
+        }
+        writer.endArray().endObject();
+
+        crow::response res(200, body);
+        res.add_header("Content-Type", "application/json");
+        res.add_header("Cache-Control", "private, max-age=60");
+        return res;
+    } catch (const std::exception& e) {
+        spdlog::error("Failed to read conflict heatmap tile {}/{}/{}: {}", z, x, y, e.what());
+        return jsonError(500, "Internal server error");
+    }
+}
+
+crow::response ConflictHeatmap::airports(const crow::request& req) const {
+    if (!probeTables()) {
+        return jsonError(503, "The conflict heatmap needs schema migration 7");
+    }
+    std::string from, to, message;
+    if (!dayRange(req, from, to, message)) {
+        return jsonError(400, message);
+    }
+
+    // Every level holds every conflict; the coarsest has the fewest rows
+    const std::string coarsest = std::to_string(kLevels[0]);
+    std::vector<SqlParam> open_params = {to};
+    const std::string open_filters = filterSql(req, open_params);
+    std::vector<SqlParam> day_params = {from, to};
+    const std::string day_filters = filterSql(req, day_params);
+    try {
+        auto& db = DatabaseManager::getInstance();
+        DatabaseManager::ReadScope scope(db);
+        auto open = db.executePrepared("SELECT airport_icao, SUM(opened) - SUM(resolved) FROM conflict_heat"
+                                       " WHERE level = " + coarsest + " AND day <= ?" + open_filters +
+                                       " GROUP BY airport_icao ORDER BY airport_icao",
+                                       open_params);
+        auto days = db.executePrepared("SELECT airport_icao, day, SUM(opened), SUM(resolved) FROM conflict_heat"
+                                       " WHERE level = " + coarsest + " AND day BETWEEN ? AND ?" + day_filters +
+                                       " GROUP BY airport_icao, day ORDER BY airport_icao, day",
+                                       day_params);
+
+        // airports: {icao: {open on to, days: [[YYYY-MM-DD, opened, resolved], ...]}}; "" holds
+        // conflicts whose procedure has no airport
+        nlohmann::json airports = nlohmann::json::object();
+        for (const auto& row : open.rows) {
+            const int64_t count = row.getInt(1);
+            if (count != 0) airports[row.getString(0)] = {{"open", count}, {"days", nlohmann::json::array()}};
+        }
+        for (const auto& row : days.rows) {
+            auto& airport = airports[row.getString(0)];
+            if (!airport.contains("open")) airport = {{"open", 0}, {"days", nlohmann::json::array()}};
+            std::string day = row.getString(1);
+            day.resize(std::min<size_t>(day.size(), 10));
+            airport["days"].push_back({day, row.getInt(2), row.getInt(3)});
+        }
+
+        crow::response res(200, nlohmann::json{{"from", from}, {"to", to}, {"airports", airports}}.dump());
+        res.add_header("Content-Type", "application/json");
+        res.add_header("Cache-Control", "private, max-age=60");
+        return res;
+    } catch (const std::exception& e) {
+        spdlog::error("Failed to read conflict counts per airport: {}", e.what());
+        return jsonError(500, "Internal server error");
+    }
+}
+
+nlohmann::json ConflictHeatmap::stats() const {
+    nlohmann::json stats = {{"maintained", probeTables()},
+                            {"backfilled", backfilled_.load(std::memory_order_relaxed)},
+                            {"last_backfill_ms", last_backfill_ms_.load(std::memory_order_relaxed)}};
+    if (!probeTables()) return stats;
+    try {
+        auto result = DatabaseManager::getInstance().executePrepared(
+            "SELECT level, COUNT(*), SUM(opened), SUM(resolved) FROM conflict_heat GROUP BY level ORDER BY level");
+        for (const auto& row : result.rows) {
+            stats["levels"][std::to_string(row.getInt(0))] = {
+                {"rows", row.getInt(1)}, {"opened", row.getInt(2)}, {"resolved", row.getInt(3)}};
+        }
+    } catch (const std::exception& e) {
+        stats["error"] = e.what();
+    }
+    return stats;
+}
+
+} // namespace aeronautical
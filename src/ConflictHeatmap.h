@@ -0,0 +1,74 @@
+#pragma once
+
+#include <crow.h>
+#include "HttpApp.h"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <json.hpp>
+
+namespace aeronautical {
+
+// Conflict counts per map cell, per day, severity and airport, for density
+// maps and trends without scanning the conflicts table. Cells are Web
+// Mercator tiles at zooms 6, 9 and 12; each conflict stores the zoom-12 tile
+// of its geometry's envelope centre in conflicts.heat_cell and the coarser
+// cells follow by shifting. The conflict writers call record() inside the
+// transaction that changes the rows: rows counted as opened the day they
+// are inserted and as resolved the day they are deleted, so the conflicts
+// open on a day are the opened minus resolved up to it.
+//
+//   GET /api/conflicts/heatmap/<z>/<x>/<y>   cells of the tile at the zoom that fits it
+//   GET /api/conflicts/heatmap/airports      per airport, per day
+//
+// Both take from=YYYY-MM-DD and to=YYYY-MM-DD (default: the last 30 days up
+// to today) and optional severity= and airport= filters.
+class ConflictHeatmap {
+public:
+    static constexpr int kLevels[] = {6, 9, 12};
+    static constexpr int kFinestLevel = 12;
+
+    static ConflictHeatmap& getInstance();
+
+    ConflictHeatmap(const ConflictHeatmap&) = delete;
+    ConflictHeatmap& operator=(const ConflictHeatmap&) = delete;
+
+    // Checks once for conflicts.heat_cell and the conflict_heat table (schema migration 7)
+    static bool probeTables();
+
+    // Zoom-12 tile of the envelope centre, packed as x * 4096 + y; -1 for
+    // geometry without coordinates
+    static int64_t cellOf(std::string_view geojson);
+
+    // Counts the conflicts matching where, a condition on "conflicts c", as
+    // opened or resolved on day_sql. Runs on the caller's transaction: after
+    // inserting them when opened, before deleting them when not. True
+    // without the tables.
+    static bool record(const std::string& where, bool opened, const std::string& day_sql = "UTC_DATE()");
+
+    // Locates conflicts stored without a cell (before migration 7 or by
+    // another writer) and counts them as opened on their creation day
+    bool backfill();
+    // Empties the counters and backfills them from the stored conflicts;
+    // resolutions counted so far are lost
+    bool rebuild();
+
+    void registerRoutes(HttpApp& app);
+
+    nlohmann::json stats() const;
+
+private:
+    ConflictHeatmap() = default;
+
+    crow::response tile(const crow::request& req, int z, int x, int y) const;
+    crow::response airports(const crow::request& req) const;
+
+    // Rows located by the backfills so far and when the last one finished
+    std::mutex backfill_mutex_; // one backfill at a time
+    std::atomic<uint64_t> backfilled_{0};
+    std::atomic<int64_t> last_backfill_ms_{0}; // since the epoch; 0 before the first
+};
+
+} // namespace aeronautical
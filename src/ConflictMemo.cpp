@@ -0,0 +1,113 @@
+#include "ConflictMemo.h"
+#include <string_view>
+#include <vector>
+
+namespace aeronautical {
+
+ConflictMemo& ConflictMemo::getInstance() {
+    static ConflictMemo instance;
+    return instance;
+}
+
+size_t ConflictMemo::KeyHash::operator()(const Key& key) const {
+    size_t seed = key.geometry;
+    for (size_t part : {std::hash<int>{}(key.procedure_id), std::hash<int64_t>{}(key.zone_version),
+                        std::hash<int>{}(key.mode)}) {
+        seed ^= part + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2);
+    }
+    return seed;
+}
+
+void ConflictMemo::setCapacity(size_t bytes) {
+    std::lock_guard lock(mutex_);
+    capacity_ = bytes;
+    evictLocked(capacity_);
+}
+
+bool ConflictMemo::enabled() const {
+    std::lock_guard lock(mutex_);
+    return capacity_ > 0;
+}
+
+std::shared_ptr<const ConflictMemo::Outcome> ConflictMemo::find(const Key& key) {
+    std::lock_guard lock(mutex_);
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+        misses_++;
+        return nullptr;
+    }
+    hits_++;
+    lru_.splice(lru_.begin(), lru_, it->second);
+    return it->second->second;
+}
+
+void ConflictMemo::store(const Key& key, std::shared_ptr<const Outcome> outcome) {
+    const size_t bytes = footprint(*outcome);
+    std::lock_guard lock(mutex_);
+    if (bytes > capacity_ / 64) {
+        return; // one large intersection should not flush the memo
+    }
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+        size_ -= footprint(*it->second->second);
+        lru_.erase(it->second);
+        index_.erase(it);
+    }
+    size_ += bytes;
+    lru_.emplace_front(key, std::move(outcome));
+    index_[key] = lru_.begin();
+    evictLocked(capacity_);
+}
+
+void ConflictMemo::clear() {
+    std::lock_guard lock(mutex_);
+    lru_.clear();
+    index_.clear();
+    size_ = 0;
+}
+
+size_t ConflictMemo::trim(size_t target) {
+    std::lock_guard lock(mutex_);
+    const size_t before = size_;
+    evictLocked(target);
+    return before - size_;
+}
+
+void ConflictMemo::evictLocked(size_t limit) {
+    while (size_ > limit && !lru_.empty()) {
+        size_ -= footprint(*lru_.back().second);
+        index_.erase(lru_.back().first);
+        lru_.pop_back();
+        evicted_++;
+    }
+}
+
+size_t ConflictMemo::geometryHash(const OGRGeometry& geometry) {
+    std::vector<unsigned char> wkb(geometry.WkbSize());
+    geometry.exportToWkb(wkbNDR, wkb.data(), wkbVariantIso);
+    return std::hash<std::string_view>{}(std::string_view(reinterpret_cast<const char*>(wkb.data()), wkb.size()));
+}
+
+size_t ConflictMemo::size() const {
+    std::lock_guard lock(mutex_);
+    return index_.size();
+}
+
+size_t ConflictMemo::bytes() const {
+    std::lock_guard lock(mutex_);
+    return size_;
+}
+
+nlohmann::json ConflictMemo::stats() const {
+    std::lock_guard lock(mutex_);
+    nlohmann::json j;
+    j["entries"] = index_.size();
+    j["bytes"] = size_;
+    j["max_bytes"] = capacity_;
+    j["hits"] = hits_;
+    j["misses"] = misses_;
+    j["evicted"] = evicted_;
+    return j;
+}
+
+} // namespace aeronautical
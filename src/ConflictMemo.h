@@ -0,0 +1,98 @@
+#pragma once
+
+#include "ConflictMetrics.h"
+#include "LockStats.h"
+#include "ogr_geometry.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <json.hpp>
+
+namespace aeronautical {
+
+// Byte-bounded LRU of (feature, protection zone) results shared by every
+// project's analyses. Obstacle projects are often resubmitted or copied with
+// the same features; a feature whose geometry was already evaluated against a
+// zone version takes that result without any geometry work.
+//
+// Features are keyed by a hash of their WKB as evaluated (validated and
+// grown by the obstacle buffer), so the same geometry under different
+// GeoJSON formatting or in another project meets the same entry. Zones are
+// keyed by procedure and updated_at, like ProtectionGeometryCache, so an
+// edited zone is never answered from a stale entry; its old entries age out.
+class ConflictMemo {
+public:
+    struct Key {
+        size_t geometry = 0;
+        int procedure_id = 0;
+        int64_t zone_version = 0;
+        int mode = 0; // what the result holds: intersection geometry, metrics or predicates only
+
+        bool operator==(const Key&) const = default;
+    };
+
+    // A pair evaluated as no conflict is remembered too
+    struct Outcome {
+        bool conflict = false;
+        bool inside = false;
+        std::string intersection_json;
+        std::optional<FeatureOverlap> overlap;
+    };
+
+    static ConflictMemo& getInstance();
+
+    ConflictMemo(const ConflictMemo&) = delete;
+    ConflictMemo& operator=(const ConflictMemo&) = delete;
+
+    // 0 disables the memo and drops its entries
+    void setCapacity(size_t bytes);
+    bool enabled() const;
+
+    std::shared_ptr<const Outcome> find(const Key& key);
+    void store(const Key& key, std::shared_ptr<const Outcome> outcome);
+    void clear();
+    // Drops least recent outcomes until at most target bytes are held,
+    // without lowering the capacity; returns the bytes dropped
+    size_t trim(size_t target);
+
+    static size_t geometryHash(const OGRGeometry& geometry);
+    static int64_t zoneVersion(std::chrono::system_clock::time_point updated_at) {
+        return updated_at.time_since_epoch().count();
+    }
+
+    size_t size() const;
+    size_t bytes() const;
+    // Entries, bytes and the hit, miss and eviction counts
+    nlohmann::json stats() const;
+
+private:
+    ConflictMemo() = default;
+
+    struct KeyHash {
+        size_t operator()(const Key& key) const;
+    };
+    // Front is most recent
+    using List = std::list<std::pair<Key, std::shared_ptr<const Outcome>>>;
+
+    static size_t footprint(const Outcome& outcome) {
+        return sizeof(Outcome) + sizeof(Key) + outcome.intersection_json.size();
+    }
+    void evictLocked(size_t limit);
+
+    mutable InstrumentedMutex<std::mutex> mutex_{"conflict_memo"};
+    List lru_;
+    std::unordered_map<Key, List::iterator, KeyHash> index_;
+    size_t size_ = 0;
+    size_t capacity_ = 0;
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+    uint64_t evicted_ = 0;
+};
+
+} // namespace aeronautical
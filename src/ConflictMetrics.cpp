@@ -0,0 +1,97 @@
+#include "ConflictMetrics.h"
+#include "OgrHandles.h"
+#include <algorithm>
+#include <cmath>
+
+namespace aeronautical {
+
+namespace {
+
+constexpr double kMetresPerDegree = 111320.0;
+
+double squareMetresPerDegree(double latitude) {
+    return kMetresPerDegree * kMetresPerDegree * std::max(std::cos(latitude * M_PI / 180.0), 1e-6);
+}
+
+double centreLatitude(OGRGeometryH geometry) {
+    OGREnvelope envelope;
+    OGR_G_GetEnvelope(geometry, &envelope);
+    return (envelope.MinY + envelope.MaxY) / 2;
+}
+
+} // namespace
+
+double FeatureOverlap::ratio() const {
+    return area > 0 ? std::min(1.0, overlap / area) : 1.0;
+}
+
+FeatureOverlap FeatureOverlap::whole(OGRGeometryH feature) {
+    FeatureOverlap result;
+    result.area = OGR_G_Area(feature) * squareMetresPerDegree(centreLatitude(feature));
+    result.overlap = result.area;
+    return result;
+}
+
+FeatureOverlap FeatureOverlap::fromIntersection(OGRGeometryH feature, OGRGeometryH intersection) {
+    const double scale = squareMetresPerDegree(centreLatitude(feature));
+    FeatureOverlap result;
+    result.area = OGR_G_Area(feature) * scale;
+    result.overlap = intersection ? std::min(result.area, OGR_G_Area(intersection) * scale) : 0;
+    return result;
+}
+
+FeatureOverlap FeatureOverlap::estimate(OGRGeometryH feature, OGRGeometryH zone, const OGREnvelope& zone_envelope) {
+    OGREnvelope envelope;
+    OGR_G_GetEnvelope(feature, &envelope);
+    const double scale = squareMetresPerDegree((envelope.MinY + envelope.MaxY) / 2);
+
+    FeatureOverlap result;
+    result.area = OGR_G_Area(feature) * scale;
+    if (result.area <= 0) {
+        return result;
+    }
+
+    // The part inside the zone lies within both envelopes
+    const double width = std::min(envelope.MaxX, zone_envelope.MaxX) - std::max(envelope.MinX, zone_envelope.MinX);
+    const double height = std::min(envelope.MaxY, zone_envelope.MaxY) - std::max(envelope.MinY, zone_envelope.MinY);
+    const double bound = std::min(result.area, std::max(width, 0.0) * std::max(height, 0.0) * scale);
+    if (bound < ConflictMetrics::kMinorRatio * result.area) {
+        result.overlap = bound;
+        result.exact = false;
+        return result;
+    }
+
+    GeometryHandle intersection(OGR_G_Intersection(feature, zone));
+    result.overlap = intersection ? std::min(result.area, OGR_G_Area(intersection.get()) * scale) : 0;
+    return result;
+}
+
+int ConflictMetrics::ratioClass(double ratio) {
+    return ratio < kMinorRatio ? 0 : ratio < kMajorRatio ? 1 : 2;
+}
+
+ConflictSeverity ConflictMetrics::classify(ConflictSeverity zone_severity, double ratio) {
+    // Enumerators run from Critical to Informational
+    const int milder = 2 - ratioClass(ratio);
+    return static_cast<ConflictSeverity>(std::min(static_cast<int>(zone_severity) + milder,
+                                                  static_cast<int>(ConflictSeverity::Informational)));
+}
+
+void ConflictMetrics::add(const FeatureOverlap& feature, ConflictSeverity zone_severity) {
+    overlap_area += feature.overlap;
+    feature_area_ += feature.area;
+    exact = exact && feature.exact;
+    overlap_ratio = feature_area_ > 0 ? std::min(1.0, overlap_area / feature_area_) : 1.0;
+    severity = std::min(severity, classify(zone_severity, feature.ratio()));
+}
+
+nlohmann::json ConflictMetrics::toJson() const {
+    return nlohmann::json{
+        {"severity", conflictSeverityToString(severity)},
+        {"overlap_area_m2", overlap_area},
+        {"overlap_ratio", overlap_ratio},
+        {"overlap_exact", exact},
+    };
+}
+
+} // namespace aeronautical
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "FlightProcedure.h"
+#include "ogr_api.h"
+#include "ogr_core.h"
+#include <json.hpp>
+
+namespace aeronautical {
+
+// How much of one project feature a protection zone covers. Areas are in
+// square metres, scaled from degrees at the feature's latitude, which is
+// plenty for ratios. Features without area (points, lines) count as fully
+// covered once they intersect.
+struct FeatureOverlap {
+    double area = 0;
+    double overlap = 0;
+    bool exact = true; // false: overlap is an upper bound from envelopes
+
+    double ratio() const;
+
+    // Feature lying inside the zone
+    static FeatureOverlap whole(OGRGeometryH feature);
+    // From an intersection the caller already computed
+    static FeatureOverlap fromIntersection(OGRGeometryH feature, OGRGeometryH intersection);
+    // Bounds first: the envelope overlap caps the ratio, and the feature is
+    // clipped against the zone only when that cap would not settle its class
+    static FeatureOverlap estimate(OGRGeometryH feature, OGRGeometryH zone, const OGREnvelope& zone_envelope);
+};
+
+// Overlap of the features of one conflict. The severity starts from the
+// zone's conflict_severity for a major overlap and is one step milder per
+// ratio class below it; the worst feature decides.
+struct ConflictMetrics {
+    static constexpr double kMinorRatio = 0.05;
+    static constexpr double kMajorRatio = 0.5;
+
+    ConflictSeverity severity = ConflictSeverity::Informational;
+    double overlap_area = 0; // m²
+    double overlap_ratio = 0;
+    bool exact = true;
+
+    void add(const FeatureOverlap& feature, ConflictSeverity zone_severity);
+    nlohmann::json toJson() const;
+
+    // 0 below kMinorRatio, 1 below kMajorRatio, 2 otherwise
+    static int ratioClass(double ratio);
+    static ConflictSeverity classify(ConflictSeverity zone_severity, double ratio);
+
+private:
+    double feature_area_ = 0;
+};
+
+} // namespace aeronautical
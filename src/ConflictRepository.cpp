@@ -1,6 +1,16 @@
 #include "ConflictRepository.h"
+#include "AuditWriter.h"
+#include "ConflictHeatmap.h"
 #include "DatabaseManager.h"
+#include "ProjectRepository.h"
+#include "RowDecoder.h"
+#include "SchemaMigrations.h"
+#include <cstdlib>
 #include <sstream>
+#include <string_view>
+#include <unordered_map>
+#include <mutex>
+#include <optional>
 #include <spdlog/sinks/stdout_color_sinks.h>
 
 namespace aeronautical {
@@ -22,72 +32,233 @@ ConflictRepository::ConflictRepository() {
 void ConflictRepository::deleteByProjectId(int project_id) {
     try {
         auto& db = DatabaseManager::getInstance();
-        std::string query = "DELETE FROM conflicts WHERE project_id = " + std::to_string(project_id);
-        db.executeQuery(query);
-        logger_->debug("Deleted existing conflicts for project {}", project_id);
+        DatabaseManager::Transaction transaction(db);
+        const std::string project = std::to_string(project_id);
+        if (restoreArchived(project_id) && ConflictHeatmap::record("c.project_id = " + project, false) &&
+            db.executeQuery("DELETE FROM conflicts WHERE project_id = " + project)) {
+            ProjectRepository::updateCounter(project_id, "conflict_count", "0");
+            transaction.commit();
+        } else {
+            transaction.rollback();
+        }
+        SPDLOG_LOGGER_DEBUG(logger_, "Deleted existing conflicts for project {}", project_id);
     } catch (const std::exception& err) {
         logger_->error("Failed to delete old conflicts for project {}: {}", project_id, err.what());
     }
 }
 
-bool ConflictRepository::create(int project_id, int procedure_id, const std::string& description, const std::string& conflicting_geometry_json) {
-    try {
+static std::string escapeString(MYSQL* con, const std::string& str) {
+    if (str.empty()) {
+        return "";
+    }
+    std::string escaped(str.length() * 2 + 1, '\0');
+    unsigned long len = mysql_real_escape_string(con, escaped.data(), str.c_str(), str.length());
+    escaped.resize(len);
+    return escaped;
+}
+
+// Recount for the conflict_count counter, for writers that change only some rows
+static std::string conflictCountSql(int project_id) {
+    return "(SELECT COUNT(*) FROM conflicts WHERE project_id = " + std::to_string(project_id) + ")";
+}
+
+bool ConflictRepository::probeSpatialSupport() {
+    static std::once_flag once;
+    static bool use_spatial = false;
+
+    std::call_once(once, []() {
         auto& db = DatabaseManager::getInstance();
-        
-        // Properly escape strings for SQL
-        std::string escaped_desc = description;
-        size_t pos = 0;
-        while ((pos = escaped_desc.find("'", pos)) != std::string::npos) {
-            escaped_desc.replace(pos, 1, "\\'");
-            pos += 2;
+        MysqlResult result = db.executeSelectQuery("SHOW FUNCTION STATUS WHERE name = 'ST_GeomFromGeoJSON'");
+        if (result) {
+            use_spatial = mysql_num_rows(result.get()) > 0;
         }
-        
-        std::string escaped_geom = conflicting_geometry_json;
-        pos = 0;
-        while ((pos = escaped_geom.find("'", pos)) != std::string::npos) {
-            escaped_geom.replace(pos, 1, "\\'");
-            pos += 2;
+        spdlog::info("Conflict geometries stored {}", use_spatial ? "through ST_GeomFromGeoJSON" : "as GeoJSON text");
+    });
+
+    return use_spatial;
+}
+
+bool ConflictRepository::probeMetricColumns() {
+    static std::once_flag once;
+    static bool has_metrics = false;
+
+    std::call_once(once, []() {
+        has_metrics = SchemaMigrations::hasColumn("conflicts", "overlap_ratio");
+        spdlog::info("Conflict overlap metrics {}", has_metrics ? "stored" : "not stored (no overlap_ratio column)");
+    });
+
+    return has_metrics;
+}
+
+bool ConflictRepository::probeVerticalColumns() {
+    static std::once_flag once;
+    static bool has_vertical = false;
+
+    std::call_once(once, []() {
+        has_vertical = SchemaMigrations::hasColumn("conflicts", "penetration_depth_ft");
+        spdlog::info("Conflict vertical clearance {}",
+                     has_vertical ? "stored" : "not stored (no penetration_depth_ft column)");
+    });
+
+    return has_vertical;
+}
+
+bool ConflictRepository::probeChangeColumns() {
+    static std::once_flag once;
+    static bool has_changes = false;
+
+    std::call_once(once, []() {
+        has_changes = SchemaMigrations::hasColumn("conflicts", "change_state") &&
+                      SchemaMigrations::hasColumn("resolved_conflicts", "result_signature");
+        spdlog::info("Conflict changes between runs {}",
+                     has_changes ? "tracked" : "not tracked (no change_state column)");
+    });
+
+    return has_changes;
+}
+
+bool ConflictRepository::probeSnapshotColumn() {
+    static std::once_flag once;
+    static bool has_snapshot = false;
+
+    std::call_once(once, []() {
+        has_snapshot = SchemaMigrations::hasColumn("conflicts", "protection_snapshot");
+        spdlog::info("Conflict protection snapshots {}",
+                     has_snapshot ? "stored" : "not stored (no protection_snapshot column)");
+    });
+
+    return has_snapshot;
+}
+
+bool ConflictRepository::probeArchiveTable() {
+    static std::once_flag once;
+    static bool has_archive = false;
+
+    std::call_once(once, []() {
+        has_archive = SchemaMigrations::hasTable("conflicts_archive");
+        spdlog::info("Conflicts of closed projects {}",
+                     has_archive ? "archivable" : "kept in the hot table (no conflicts_archive table)");
+    });
+
+    return has_archive;
+}
+
+std::string ConflictRepository::insertColumnsSql() {
+    return std::string("INSERT INTO conflicts (project_id, flight_procedure_id, description, conflicting_geometry")
+         + (probeMetricColumns() ? ", severity, overlap_area, overlap_ratio" : "")
+         + (probeVerticalColumns() ? ", vertical_clearance_ft, penetration_depth_ft" : "")
+         + (probeChangeColumns() ? ", result_signature, change_state" : "")
+         + (probeSnapshotColumn() ? ", protection_snapshot" : "")
+         + (ConflictHeatmap::probeTables() ? ", heat_cell" : "") + ") VALUES ";
+}
+
+std::string ConflictRepository::rowValuesSql(MYSQL* con, int project_id, const PendingConflict& conflict) const {
+    std::string row = "(" + std::to_string(project_id) + ", " + std::to_string(conflict.procedure_id) + ", '"
+                    + escapeString(con, conflict.description) + "', "
+                    + geometryValueSql(con, conflict.conflicting_geometry_json);
+    auto number = [](const std::optional<double>& value) {
+        return value ? std::to_string(*value) : std::string("NULL");
+    };
+    if (probeMetricColumns()) {
+        row += ", " + (conflict.severity ? "'" + conflictSeverityToString(*conflict.severity) + "'" : std::string("NULL"))
+             + ", " + number(conflict.overlap_area) + ", " + number(conflict.overlap_ratio);
+    }
+    if (probeVerticalColumns()) {
+        row += ", " + number(conflict.vertical_clearance_ft) + ", " + number(conflict.penetration_depth_ft);
+    }
+    if (probeChangeColumns()) {
+        row += ", " + (conflict.signature ? std::to_string(conflict.signature) : std::string("NULL")) + ", 'new'";
+    }
+    if (probeSnapshotColumn()) {
+        row += ", " + (conflict.protection_snapshot.empty()
+                           ? std::string("NULL")
+                           : "'" + escapeString(con, conflict.protection_snapshot) + "'");
+    }
+    if (ConflictHeatmap::probeTables()) {
+        row += ", " + std::to_string(ConflictHeatmap::cellOf(conflict.conflicting_geometry_json));
+    }
+    return row + ")";
+}
+
+bool ConflictRepository::insertRows(MYSQL* con, int project_id, const std::vector<const PendingConflict*>& conflicts) {
+    auto& db = DatabaseManager::getInstance();
+    const std::string prefix = insertColumnsSql();
+    std::string statement;
+    size_t rows_in_statement = 0;
+    bool ok = true;
+
+    for (size_t i = 0; ok && i < conflicts.size(); i++) {
+        std::string row = rowValuesSql(con, project_id, *conflicts[i]);
+
+        // Flush before this row would push the statement past the size limit
+        if (rows_in_statement > 0 && statement.size() + row.size() + 1 > kMaxInsertStatementBytes) {
+            ok = db.executeQuery(statement);
+            statement.clear();
+            rows_in_statement = 0;
+        }
+
+        if (rows_in_statement == 0) {
+            statement = prefix;
+        } else {
+            statement += ",";
         }
+        statement += row;
+        rows_in_statement++;
+    }
+
+    if (ok && rows_in_statement > 0) {
+        ok = db.executeQuery(statement);
+    }
+    return ok;
+}
+
+static std::string idListSql(const std::vector<ConflictDiff::Entry>& entries) {
+    std::string list;
+    for (const auto& entry : entries) {
+        list += (list.empty() ? "" : ",") + std::to_string(entry.conflict_id);
+    }
+    return list;
+}
+
+std::string ConflictRepository::geometryValueSql(MYSQL* con, const std::string& geojson) const {
+    std::string escaped = "'" + escapeString(con, geojson) + "'";
+    if (probeSpatialSupport()) {
+        return "ST_GeomFromGeoJSON(" + escaped + ")";
+    }
+    // Store as text if spatial functions not available
+    return escaped;
+}
+
+bool ConflictRepository::create(int project_id, int procedure_id, const std::string& description, const std::string& conflicting_geometry_json) {
+    try {
+        auto& db = DatabaseManager::getInstance();
+        DatabaseManager::Transaction transaction(db);
+        MYSQL* con = transaction.get();
+        const bool heat = ConflictHeatmap::probeTables();
 
         std::stringstream query;
-        
-        // Check if the conflicts table uses a geometry column or just stores JSON
-        // For MySQL without PostGIS, we'll store the geometry as JSON text
-        query << "INSERT INTO conflicts (project_id, flight_procedure_id, description, conflicting_geometry) "
+        query << "INSERT INTO conflicts (project_id, flight_procedure_id, description, conflicting_geometry"
+              << (heat ? ", heat_cell" : "") << ") "
               << "VALUES ("
               << project_id << ", "
               << procedure_id << ", "
-              << "'" << escaped_desc << "', ";
-        
-        // Try to use ST_GeomFromGeoJSON if available, otherwise store as text
-        // First, let's check if we can use spatial functions
-        bool use_spatial = false;
-        
-        MYSQL_RES* result = db.executeSelectQuery("SELECT VERSION()");
-        if (result) {
-            mysql_free_result(result);
-            // Check if ST_GeomFromGeoJSON exists
-            result = db.executeSelectQuery("SHOW FUNCTION STATUS WHERE name = 'ST_GeomFromGeoJSON'");
-            if (result && mysql_num_rows(result) > 0) {
-                use_spatial = true;
-            }
-            if (result) mysql_free_result(result);
+              << "'" << escapeString(con, description) << "', "
+              << geometryValueSql(con, conflicting_geometry_json);
+        if (heat) {
+            query << ", " << ConflictHeatmap::cellOf(conflicting_geometry_json);
         }
+        query << ");";
         
-        if (use_spatial) {
-            query << "ST_GeomFromGeoJSON('" << escaped_geom << "')";
+        bool success = restoreArchived(project_id) && db.executeQuery(query.str()) &&
+                       ConflictHeatmap::record("c.id = " + std::to_string(mysql_insert_id(con)), true);
+        if (success) {
+            success = transaction.commit();
         } else {
-            // Store as text if spatial functions not available
-            query << "'" << escaped_geom << "'";
+            transaction.rollback();
         }
         
-        query << ");";
-        
-        logger_->debug("Executing conflict insert query: {}", query.str());
-        
-        bool success = db.executeQuery(query.str());
-        
         if (success) {
+            ProjectRepository::updateCounter(project_id, "conflict_count", conflictCountSql(project_id));
             logger_->info("Successfully created conflict record for project {} and procedure {}", 
                          project_id, procedure_id);
         } else {
@@ -103,45 +274,486 @@ bool ConflictRepository::create(int project_id, int procedure_id, const std::str
     }
 }
 
+bool ConflictRepository::replaceForProject(int project_id, const std::vector<PendingConflict>& conflicts,
+                                           ConflictDiff* diff) {
+    auto& db = DatabaseManager::getInstance();
 
-// Maps a MYSQL_ROW to a Conflict struct
-Conflict ConflictRepository::rowToConflict(MYSQL_ROW row) {
-    Conflict conflict;
-    // Column order: id, project_id, flight_procedure_id, conflicting_geometry, description, created_at, updated_at
-    conflict.id = row[0] ? std::stoi(row[0]) : 0;
-    conflict.project_id = row[1] ? std::stoi(row[1]) : 0;
-    conflict.flight_procedure_id = row[2] ? std::stoi(row[2]) : 0;
-    conflict.conflicting_geometry = row[3] ? row[3] : "";
-    
-    if (row[4]) {
-        conflict.description = std::string(row[4]);
-    } else {
-        conflict.description = std::nullopt;
+    try {
+        DatabaseManager::Transaction transaction(db);
+        MYSQL* con = transaction.get();
+
+        const std::string project = std::to_string(project_id);
+        ConflictDiff changes;
+        std::vector<const PendingConflict*> inserts;
+        bool ok = restoreArchived(project_id);
+
+        if (ok && probeChangeColumns()) {
+            // Stored rows by signature; a row without one never matches
+            std::unordered_multimap<uint64_t, ConflictDiff::Entry> stored;
+            MysqlResult result = db.executeSelectQuery(
+                "SELECT id, flight_procedure_id, result_signature, description FROM conflicts WHERE project_id = " +
+                project + " FOR UPDATE");
+            ok = static_cast<bool>(result);
+            MYSQL_ROW row;
+            while (ok && (row = mysql_fetch_row(result.get()))) {
+                stored.emplace(row[2] ? std::strtoull(row[2], nullptr, 10) : 0,
+                               ConflictDiff::Entry{std::atoi(row[0]), row[1] ? std::atoi(row[1]) : 0,
+                                                   row[3] ? row[3] : ""});
+            }
+
+            for (const auto& conflict : conflicts) {
+                auto match = conflict.signature ? stored.find(conflict.signature) : stored.end();
+                if (match != stored.end()) {
+                    changes.unchanged.push_back(std::move(match->second));
+                    stored.erase(match);
+                } else {
+                    changes.added.push_back({0, conflict.procedure_id, conflict.description});
+                    inserts.push_back(&conflict);
+                }
+            }
+            for (auto& [signature, entry] : stored) {
+                changes.resolved.push_back(std::move(entry));
+            }
+
+            // The previous run's resolved list gives way to this run's
+            if (ok) {
+                ok = db.executeQuery("DELETE FROM resolved_conflicts WHERE project_id = " + project);
+            }
+            if (ok && !changes.resolved.empty()) {
+                std::string statement = "INSERT INTO resolved_conflicts (project_id, conflict_id, flight_procedure_id, "
+                                        "description, result_signature, resolved_at) SELECT project_id, id, "
+                                        "flight_procedure_id, description, result_signature, NOW(3) FROM conflicts "
+                                        "WHERE id IN (" + idListSql(changes.resolved) + ")";
+                ok = db.executeQuery(statement) &&
+                     ConflictHeatmap::record("c.id IN (" + idListSql(changes.resolved) + ")", false) &&
+                     db.executeQuery("DELETE FROM conflicts WHERE id IN (" + idListSql(changes.resolved) + ")");
+            }
+            // Unchanged rows are only touched the first time they stay unchanged
+            if (ok && !changes.unchanged.empty()) {
+                ok = db.executeQuery("UPDATE conflicts SET change_state = 'unchanged' WHERE id IN (" +
+                                     idListSql(changes.unchanged) + ") AND NOT (change_state <=> 'unchanged')");
+            }
+            // A kept row was found again against this run's snapshot
+            if (ok && !changes.unchanged.empty() && probeSnapshotColumn() &&
+                !conflicts.front().protection_snapshot.empty()) {
+                const std::string snapshot = "'" + escapeString(con, conflicts.front().protection_snapshot) + "'";
+                ok = db.executeQuery("UPDATE conflicts SET protection_snapshot = " + snapshot + " WHERE id IN (" +
+                                     idListSql(changes.unchanged) + ") AND NOT (protection_snapshot <=> " +
+                                     snapshot + ")");
+            }
+        } else if (ok) {
+            ok = ConflictHeatmap::record("c.project_id = " + project, false) &&
+                 db.executeQuery("DELETE FROM conflicts WHERE project_id = " + project);
+            for (const auto& conflict : conflicts) {
+                changes.added.push_back({0, conflict.procedure_id, conflict.description});
+                inserts.push_back(&conflict);
+            }
+        }
+
+        if (ok) {
+            ok = insertRows(con, project_id, inserts);
+        }
+        // Only the rows just inserted are still 'new'; without change columns that is all of them
+        if (ok && !inserts.empty()) {
+            ok = ConflictHeatmap::record("c.project_id = " + project +
+                                             (probeChangeColumns() ? " AND c.change_state = 'new'" : ""),
+                                         true);
+        }
+        if (ok) {
+            ok = ProjectRepository::updateCounter(project_id, "conflict_count", std::to_string(conflicts.size()));
+        }
+
+        if (!ok) {
+            transaction.rollback();
+            logger_->error("Rolled back conflict write for project {}", project_id);
+            return false;
+        }
+
+        if (!transaction.commit()) {
+            logger_->error("Failed to commit conflicts for project {}", project_id);
+            return false;
+        }
+
+        logger_->info("Stored {} conflicts for project {}: {} new, {} unchanged, {} resolved", conflicts.size(),
+                      project_id, changes.added.size(), changes.unchanged.size(), changes.resolved.size());
+        if (diff) {
+            *diff = std::move(changes);
+        }
+        return true;
+
+    } catch (const std::exception& err) {
+        logger_->error("Exception writing conflicts for project {}: {}", project_id, err.what());
+        return false;
     }
+}
 
-    conflict.created_at = row[5] ? stringToTimePoint(row[5]) : std::chrono::system_clock::now();
-    conflict.updated_at = row[6] ? stringToTimePoint(row[6]) : std::chrono::system_clock::now();
-    
-    return conflict;
+bool ConflictRepository::storeAnalysis(int project_id, const std::vector<PendingConflict>& conflicts,
+                                       bool under_review, ConflictDiff* diff) {
+    try {
+        DatabaseManager::Transaction transaction(DatabaseManager::getInstance());
+        if (!replaceForProject(project_id, conflicts, diff)) {
+            logger_->error("Failed to save {} conflicts to database for project {}", conflicts.size(), project_id);
+            return false;
+        }
+
+        std::optional<AuditEvent> audit;
+        if (under_review) {
+            ProjectRepository proj_repo;
+            auto projectToUpdateOpt = proj_repo.findById(project_id);
+            if (projectToUpdateOpt) {
+                Project projectToUpdate = *projectToUpdateOpt;
+                if (projectToUpdate.status != ProjectStatus::UnderReview) {
+                    audit.emplace();
+                    audit->project_id = project_id;
+                    audit->comment = "Conflict analysis completed with " + std::to_string(conflicts.size()) +
+                                     " conflicts";
+                    audit->old_status = projectToUpdate.status;
+                    audit->new_status = ProjectStatus::UnderReview;
+                }
+                projectToUpdate.status = ProjectStatus::UnderReview;
+
+                if (proj_repo.update(project_id, projectToUpdate)) {
+                    logger_->info("Successfully updated project {} status to UnderReview.", project_id);
+                } else {
+                    logger_->error("Failed to update project {} status after analysis.", project_id);
+                    transaction.rollback();
+                    return false;
+                }
+            } else {
+                logger_->error("Could not find project {} to update its status after analysis.", project_id);
+            }
+        }
+        if (!transaction.commit()) {
+            return false;
+        }
+        if (audit) {
+            AuditWriter::getInstance().record(std::move(*audit));
+        }
+        return true;
+    } catch (const std::exception& err) {
+        logger_->error("Failed to store the analysis of project {}: {}", project_id, err.what());
+        return false;
+    }
+}
+
+bool ConflictRepository::replaceForProcedure(int project_id, int procedure_id,
+                                             const std::optional<PendingConflict>& conflict) {
+    auto& db = DatabaseManager::getInstance();
+
+    try {
+        DatabaseManager::Transaction transaction(db);
+        MYSQL* con = transaction.get();
+
+        const std::string rows = "project_id = " + std::to_string(project_id) +
+                                 " AND flight_procedure_id = " + std::to_string(procedure_id);
+        bool ok = restoreArchived(project_id) && ConflictHeatmap::record("c." + rows, false) &&
+                  db.executeQuery("DELETE FROM conflicts WHERE " + rows);
+        if (ok && conflict) {
+            ok = db.executeQuery(insertColumnsSql() + rowValuesSql(con, project_id, *conflict)) &&
+                 ConflictHeatmap::record("c." + rows, true);
+        }
+        if (ok) {
+            ok = ProjectRepository::updateCounter(project_id, "conflict_count", conflictCountSql(project_id));
+        }
+
+        if (!ok) {
+            transaction.rollback();
+            logger_->error("Rolled back conflict write for project {} and procedure {}", project_id, procedure_id);
+            return false;
+        }
+        if (!transaction.commit()) {
+            logger_->error("Failed to commit conflict for project {} and procedure {}", project_id, procedure_id);
+            return false;
+        }
+        return true;
+
+    } catch (const std::exception& err) {
+        logger_->error("Exception writing conflict for project {} and procedure {}: {}", project_id, procedure_id,
+                       err.what());
+        return false;
+    }
+}
+
+ConflictDiff ConflictRepository::findChanges(int project_id) {
+    ConflictDiff changes;
+    if (!probeChangeColumns()) {
+        return changes;
+    }
+    try {
+        auto& db = DatabaseManager::getInstance();
+        DatabaseManager::ReadScope scope(db);
+        const std::string project = std::to_string(project_id);
+        MysqlResult current = db.executeSelectQuery(
+            "SELECT id, flight_procedure_id, description, change_state FROM conflicts WHERE project_id = " + project +
+            " ORDER BY id");
+        MYSQL_ROW row;
+        while (current && (row = mysql_fetch_row(current.get()))) {
+            ConflictDiff::Entry entry{std::atoi(row[0]), row[1] ? std::atoi(row[1]) : 0, row[2] ? row[2] : ""};
+            const bool unchanged = row[3] && std::string_view(row[3]) == "unchanged";
+            (unchanged ? changes.unchanged : changes.added).push_back(std::move(entry));
+        }
+        MysqlResult resolved = db.executeSelectQuery(
+            "SELECT conflict_id, flight_procedure_id, description FROM resolved_conflicts WHERE project_id = " +
+            project + " ORDER BY conflict_id");
+        while (resolved && (row = mysql_fetch_row(resolved.get()))) {
+            changes.resolved.push_back({std::atoi(row[0]), row[1] ? std::atoi(row[1]) : 0, row[2] ? row[2] : ""});
+        }
+    } catch (const std::exception& err) {
+        logger_->error("Failed to read the conflict changes of project {}: {}", project_id, err.what());
+    }
+    return changes;
+}
+
+std::vector<int> ConflictRepository::findProjectIdsByProcedure(int procedure_id) {
+    std::vector<int> project_ids;
+    try {
+        auto& db = DatabaseManager::getInstance();
+        MysqlResult result = db.executeSelectQuery("SELECT DISTINCT project_id FROM conflicts WHERE flight_procedure_id = " +
+                                                   std::to_string(procedure_id));
+        if (!result) {
+            return project_ids;
+        }
+        MYSQL_ROW row;
+        while ((row = mysql_fetch_row(result.get()))) {
+            if (row[0]) project_ids.push_back(std::atoi(row[0]));
+        }
+    } catch (const std::exception& err) {
+        logger_->error("Failed to find projects in conflict with procedure {}: {}", procedure_id, err.what());
+    }
+    return project_ids;
+}
+
+
+// Missing timestamps fall back to "now", as before
+static std::chrono::system_clock::time_point timestampOrNow(std::string_view text) {
+    if (text.empty()) {
+        return std::chrono::system_clock::now();
+    }
+    std::chrono::system_clock::time_point tp;
+    rowdecode::parseText(text.data(), text.size(), tp);
+    return tp;
+}
+
+// Column order: id, project_id, flight_procedure_id, conflicting_geometry, description, created_at, updated_at
+using ConflictRow = RowMap<Conflict,
+    Field<&Conflict::id>,
+    Field<&Conflict::project_id>,
+    Field<&Conflict::flight_procedure_id>,
+    Field<&Conflict::conflicting_geometry>,
+    Field<&Conflict::description>,
+    Converted<&Conflict::created_at, timestampOrNow>,
+    Converted<&Conflict::updated_at, timestampOrNow>>;
+
+// Maps a MYSQL_ROW to a Conflict struct
+Conflict ConflictRepository::rowToConflict(MYSQL_ROW row, unsigned long* lengths) {
+    return ConflictRow::decode(row, lengths);
+}
+
+// Metric columns follow the mapped ones when probeMetricColumns() holds,
+// then the vertical ones when probeVerticalColumns() does, then the snapshot
+static std::string metricColumnsSql() {
+    return std::string(ConflictRepository::probeMetricColumns() ? ", severity, overlap_area, overlap_ratio" : "")
+         + (ConflictRepository::probeVerticalColumns() ? ", vertical_clearance_ft, penetration_depth_ft" : "")
+         + (ConflictRepository::probeSnapshotColumn() ? ", protection_snapshot" : "");
+}
+
+static void decodeMetrics(MYSQL_ROW row, size_t first, Conflict& conflict) {
+    if (ConflictRepository::probeMetricColumns()) {
+        if (row[first]) conflict.severity = std::string(row[first]);
+        if (row[first + 1]) conflict.overlap_area = std::atof(row[first + 1]);
+        if (row[first + 2]) conflict.overlap_ratio = std::atof(row[first + 2]);
+        first += 3;
+    }
+    if (ConflictRepository::probeVerticalColumns()) {
+        if (row[first]) conflict.vertical_clearance_ft = std::atof(row[first]);
+        if (row[first + 1]) conflict.penetration_depth_ft = std::atof(row[first + 1]);
+        first += 2;
+    }
+    if (ConflictRepository::probeSnapshotColumn() && row[first]) {
+        conflict.protection_snapshot = std::string(row[first]);
+    }
 }
 
 
 std::vector<Conflict> ConflictRepository::findByProjectId(int project_id) {
+    return findByProjectId(project_id, 0, 0);
+}
+
+std::vector<Conflict> ConflictRepository::findByProjectId(int project_id, int after_id, int limit, bool with_geometry) {
     std::vector<Conflict> conflicts;
     auto& db = DatabaseManager::getInstance();
     
+    const bool metrics = probeMetricColumns() || probeVerticalColumns() || probeSnapshotColumn();
     std::stringstream query;
-    query << "SELECT * FROM conflicts WHERE project_id = " << project_id;
+    if (metrics || !with_geometry) {
+        query << "SELECT id, project_id, flight_procedure_id, " << (with_geometry ? "conflicting_geometry" : "NULL")
+              << ", description, created_at, updated_at" << metricColumnsSql()
+              << " FROM " << tableOf(project_id) << " WHERE project_id = " << project_id;
+    } else {
+        query << "SELECT * FROM " << tableOf(project_id) << " WHERE project_id = " << project_id;
+    }
+    // limit 0 is the whole list in table order
+    if (limit > 0) {
+        query << " AND id > " << after_id << " ORDER BY id LIMIT " << limit;
+    }
 
-    MYSQL_RES* result = db.executeSelectQuery(query.str());
+    MysqlResult result = db.executeSelectQuery(query.str());
     if (result) {
         MYSQL_ROW row;
-        while ((row = mysql_fetch_row(result))) {
-            conflicts.push_back(rowToConflict(row));
+        while ((row = mysql_fetch_row(result.get()))) {
+            conflicts.push_back(rowToConflict(row, mysql_fetch_lengths(result.get())));
+            if (metrics) decodeMetrics(row, 7, conflicts.back());
         }
-        mysql_free_result(result);
     }
     return conflicts;
 }
 
-} // namespace aeronautical
\ No newline at end of file
+ConflictSummary ConflictRepository::summarize(int project_id) {
+    auto& db = DatabaseManager::getInstance();
+
+    std::stringstream query;
+    query << "SELECT flight_procedure_id, " << (probeMetricColumns() ? "severity" : "NULL")
+          << ", COUNT(*) FROM " << tableOf(project_id) << " WHERE project_id = " << project_id << " GROUP BY 1, 2";
+
+    MysqlResult result = db.executeSelectQuery(query.str());
+    if (!result) {
+        throw std::runtime_error("Database query failed");
+    }
+    ConflictSummary summary;
+    MYSQL_ROW row;
+    while ((row = mysql_fetch_row(result.get()))) {
+        summary.add(row[0] ? std::atoi(row[0]) : 0, row[1] ? row[1] : ConflictSummary::kUnclassified,
+                    row[2] ? std::strtoull(row[2], nullptr, 10) : 0);
+    }
+    return summary;
+}
+
+std::optional<Conflict> ConflictRepository::findById(int project_id, int conflict_id) {
+    auto& db = DatabaseManager::getInstance();
+
+    std::stringstream query;
+    query << "SELECT id, project_id, flight_procedure_id, "
+          << (probeSpatialSupport() ? "ST_AsGeoJSON(conflicting_geometry)" : "conflicting_geometry")
+          << ", description" << metricColumnsSql()
+          << " FROM " << tableOf(project_id) << " WHERE id = " << conflict_id << " AND project_id = " << project_id;
+
+    MysqlResult result = db.executeSelectQuery(query.str());
+    if (!result) {
+        return std::nullopt;
+    }
+    std::optional<Conflict> conflict;
+    MYSQL_ROW row = mysql_fetch_row(result.get());
+    if (row) {
+        unsigned long* lengths = mysql_fetch_lengths(result.get());
+        Conflict c;
+        c.id = row[0] ? std::atoi(row[0]) : 0;
+        c.project_id = row[1] ? std::atoi(row[1]) : 0;
+        c.flight_procedure_id = row[2] ? std::atoi(row[2]) : 0;
+        c.conflicting_geometry = row[3] ? std::string(row[3], lengths[3]) : "{}";
+        if (row[4]) c.description = std::string(row[4], lengths[4]);
+        decodeMetrics(row, 5, c);
+        conflict = std::move(c);
+    }
+    return conflict;
+}
+
+bool ConflictRepository::updateGeometry(int conflict_id, const std::string& conflicting_geometry_json) {
+    try {
+        auto& db = DatabaseManager::getInstance();
+        DatabaseManager::ConnectionScope scope(db);
+        MYSQL* con = scope.get();
+
+        // Ids stay unique across both tables, so the row is in one of them
+        const std::string assignment = " SET conflicting_geometry = " + geometryValueSql(con, conflicting_geometry_json) +
+                                       " WHERE id = " + std::to_string(conflict_id);
+        return db.executeQuery("UPDATE conflicts" + assignment) &&
+               (!probeArchiveTable() || db.executeQuery("UPDATE conflicts_archive" + assignment));
+
+    } catch (const std::exception& err) {
+        logger_->error("Failed to update geometry of conflict {}: {}", conflict_id, err.what());
+        return false;
+    }
+}
+
+std::string ConflictRepository::tableOf(int project_id) {
+    if (!probeArchiveTable()) {
+        return "conflicts";
+    }
+    MysqlResult result = DatabaseManager::getInstance().executeSelectQuery(
+        "SELECT 1 FROM conflicts_archive WHERE project_id = " + std::to_string(project_id) + " LIMIT 1");
+    return result && mysql_fetch_row(result.get()) ? "conflicts_archive" : "conflicts";
+}
+
+bool ConflictRepository::restoreArchived(int project_id) {
+    if (!probeArchiveTable()) {
+        return true;
+    }
+    auto& db = DatabaseManager::getInstance();
+    const std::string project = std::to_string(project_id);
+    MysqlResult locked = db.executeSelectQuery("SELECT id FROM projects WHERE id = " + project + " FOR UPDATE");
+    MysqlResult archived = locked ? db.executeSelectQuery("SELECT COUNT(*) FROM conflicts_archive WHERE project_id = " +
+                                                          project) : MysqlResult();
+    MYSQL_ROW row = archived ? mysql_fetch_row(archived.get()) : nullptr;
+    if (!row) {
+        return false;
+    }
+    if (!row[0] || std::atoi(row[0]) == 0) {
+        return true;
+    }
+    if (!db.executeQuery("INSERT INTO conflicts SELECT * FROM conflicts_archive WHERE project_id = " + project) ||
+        !db.executeQuery("DELETE FROM conflicts_archive WHERE project_id = " + project)) {
+        return false;
+    }
+    logger_->info("Restored {} archived conflicts of project {}", row[0], project_id);
+    return true;
+}
+
+size_t ConflictRepository::archiveClosedProjects(std::chrono::hours min_age, size_t max_projects) {
+    if (!probeArchiveTable() || max_projects == 0) {
+        return 0;
+    }
+    auto& db = DatabaseManager::getInstance();
+    const std::string closed = " p.status IN ('" + statusToString(ProjectStatus::Accepted) + "', '" +
+                               statusToString(ProjectStatus::Refused) + "', '" +
+                               statusToString(ProjectStatus::Cancelled) + "')";
+
+    std::vector<int> candidates;
+    MysqlResult result = db.executeSelectQuery(
+        "SELECT p.id FROM projects p WHERE" + closed + " AND p.updated_at < NOW() - INTERVAL " +
+        std::to_string(min_age.count()) + " HOUR AND EXISTS (SELECT 1 FROM conflicts c WHERE c.project_id = p.id)"
+        " LIMIT " + std::to_string(max_projects));
+    if (!result) {
+        return 0;
+    }
+    MYSQL_ROW row;
+    while ((row = mysql_fetch_row(result.get()))) {
+        if (row[0]) candidates.push_back(std::atoi(row[0]));
+    }
+
+    size_t archived = 0;
+    for (int project_id : candidates) {
+        const std::string project = std::to_string(project_id);
+        try {
+            DatabaseManager::Transaction transaction(db);
+            // The writers' lock; the status is checked again under it
+            MysqlResult locked = db.executeSelectQuery("SELECT p.id FROM projects p WHERE p.id = " + project + " AND" +
+                                                       closed + " FOR UPDATE");
+            if (!locked || !mysql_fetch_row(locked.get())) {
+                transaction.rollback();
+                continue;
+            }
+            if (db.executeQuery("INSERT INTO conflicts_archive SELECT * FROM conflicts WHERE project_id = " + project) &&
+                db.executeQuery("DELETE FROM conflicts WHERE project_id = " + project) && transaction.commit()) {
+                archived++;
+            } else {
+                transaction.rollback();
+                logger_->warn("Could not archive the conflicts of project {}", project_id);
+            }
+        } catch (const std::exception& err) {
+            logger_->error("Failed to archive the conflicts of project {}: {}", project_id, err.what());
+        }
+    }
+    return archived;
+}
+
+} // namespace aeronautical
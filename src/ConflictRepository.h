@@ -1,27 +1,98 @@
 #pragma once
 
 #include <spdlog/spdlog.h>
+#include <chrono>
 #include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include "AnalysisSources.h"
 #include "FlightProcedure.h"
 #include <mysql/mysql.h> 
 
 namespace aeronautical {
 
-class ConflictRepository {
+class ConflictRepository : public AnalysisResultSink {
 public:
     ConflictRepository();
+
+    // Checks once whether the server has ST_GeomFromGeoJSON; later calls reuse the answer
+    static bool probeSpatialSupport();
+    // Checks once for the severity, overlap_area and overlap_ratio columns
+    static bool probeMetricColumns();
+    // Checks once for the vertical_clearance_ft and penetration_depth_ft columns:
+    //   ALTER TABLE conflicts ADD vertical_clearance_ft DOUBLE NULL,
+    //                         ADD penetration_depth_ft DOUBLE NULL;
+    static bool probeVerticalColumns();
+    // Checks once for the result_signature and change_state columns and the
+    // resolved_conflicts table (schema migration 6)
+    static bool probeChangeColumns();
+    // Checks once for the protection_snapshot column (schema migration 9)
+    static bool probeSnapshotColumn();
+    // Checks once for the conflicts_archive table (schema migration 11)
+    static bool probeArchiveTable();
+    // Table holding a project's conflicts: conflicts_archive once
+    // ConflictArchiver has moved them there, conflicts otherwise
+    static std::string tableOf(int project_id);
+    // Moves the conflicts of up to max_projects projects that are Accepted,
+    // Refused or Cancelled and unchanged for min_age into conflicts_archive,
+    // one transaction per project; returns the projects moved
+    size_t archiveClosedProjects(std::chrono::hours min_age, size_t max_projects);
     
         // Deletes all existing conflicts for a project before re-analysis
     void deleteByProjectId(int project_id);
     std::vector<Conflict> findByProjectId(int project_id); // Add this function declaration
+    // Up to limit conflicts of a project by id, starting after after_id;
+    // without geometry conflicting_geometry is not read
+    std::vector<Conflict> findByProjectId(int project_id, int after_id, int limit, bool with_geometry = true);
+    // Count, severities and procedures of a project's conflicts, aggregated by the server
+    ConflictSummary summarize(int project_id);
+    // One conflict of a project; conflicting_geometry is read back as GeoJSON
+    std::optional<Conflict> findById(int project_id, int conflict_id);
+    // Replaces the stored intersection geometry of one conflict
+    bool updateGeometry(int conflict_id, const std::string& conflicting_geometry_json);
 
     
     // Creates a single new conflict record
     bool create(int project_id, int procedure_id, const std::string& description, const std::string& conflicting_geometry_json);
-    Conflict rowToConflict(MYSQL_ROW row);
+
+    // Replaces all conflicts of a project in one transaction. Rolled back on
+    // any failure. With probeChangeColumns() the stored rows are matched to
+    // the pending ones by signature: matches keep their row, the others are
+    // deleted and recorded as resolved, and only new conflicts are inserted.
+    // Without it every row is deleted and inserted again.
+    bool replaceForProject(int project_id, const std::vector<PendingConflict>& conflicts,
+                           ConflictDiff* diff = nullptr);
+    // replaceForProject and, with under_review, the project's status change
+    // in one transaction
+    bool storeAnalysis(int project_id, const std::vector<PendingConflict>& conflicts, bool under_review,
+                       ConflictDiff* diff = nullptr) override;
+    // How the last analysis changed the project's conflicts; conflicts stored
+    // outside a full analysis count as added
+    ConflictDiff findChanges(int project_id);
+    // Replaces the conflict of one project with one procedure; none removes it
+    bool replaceForProcedure(int project_id, int procedure_id, const std::optional<PendingConflict>& conflict);
+    // Projects holding a conflict with the procedure
+    std::vector<int> findProjectIdsByProcedure(int procedure_id);
+    Conflict rowToConflict(MYSQL_ROW row, unsigned long* lengths);
 
 private:
     std::shared_ptr<spdlog::logger> logger_;
+
+    // Keeps each INSERT statement well under max_allowed_packet
+    static constexpr size_t kMaxInsertStatementBytes = 4 * 1024 * 1024;
+
+    // Run first inside each writer's transaction: locks the project row, as
+    // the archiver does, and moves archived conflicts back into the hot
+    // table, so a re-analysis compares against them and counts them
+    bool restoreArchived(int project_id);
+
+    std::string geometryValueSql(MYSQL* con, const std::string& geojson) const;
+    // Column list and values of one row for the conflicts INSERTs
+    static std::string insertColumnsSql();
+    std::string rowValuesSql(MYSQL* con, int project_id, const PendingConflict& conflict) const;
+    // Multi-row INSERTs of the conflicts, each under kMaxInsertStatementBytes
+    bool insertRows(MYSQL* con, int project_id, const std::vector<const PendingConflict*>& conflicts);
 };
 
 } // namespace aeronautical
\ No newline at end of file
@@ -0,0 +1,334 @@
+#include "ConnectionPool.h"
+#include "Timestamp.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <stdexcept>
+
+namespace aeronautical {
+
+PreparedStatement& ConnectionPool::Connection::statement(const std::string& sql) {
+    auto it = statements.find(sql);
+    if (it != statements.end()) {
+        return *it->second;
+    }
+
+    // Repositories use a small fixed set of statements, so a full cache
+    // means something builds SQL dynamically; start over rather than grow
+    if (statements.size() >= kMaxCachedStatements) {
+        statements.clear();
+    }
+    auto prepared = std::make_unique<PreparedStatement>(mysql, sql);
+    return *statements.emplace(sql, std::move(prepared)).first->second;
+}
+
+ConnectionPool::Lease& ConnectionPool::Lease::operator=(Lease&& other) noexcept {
+    if (this != &other) {
+        release();
+        pool_ = other.pool_;
+        connection_ = other.connection_;
+        broken_ = other.broken_;
+        other.pool_ = nullptr;
+        other.connection_ = nullptr;
+    }
+    return *this;
+}
+
+void ConnectionPool::Lease::release() {
+    if (pool_ && connection_) {
+        pool_->giveBack(connection_, broken_);
+    }
+    pool_ = nullptr;
+    connection_ = nullptr;
+    broken_ = false;
+}
+
+ConnectionPool::ConnectionPool(std::string host, int port, std::string user, std::string password,
+                               std::string database, PoolSettings settings)
+    : host_(std::move(host)), port_(port), user_(std::move(user)), password_(std::move(password)),
+      database_(std::move(database)), settings_(settings) {
+    if (settings_.max_size == 0) {
+        settings_.max_size = 1;
+    }
+    if (settings_.min_idle > settings_.max_size) {
+        settings_.min_idle = settings_.max_size;
+    }
+
+    maintenance_thread_ = std::thread([this]() { maintenanceLoop(); });
+}
+
+ConnectionPool::~ConnectionPool() {
+    shutdown();
+}
+
+MYSQL* ConnectionPool::openConnection() {
+    MYSQL* conn = mysql_init(nullptr);
+    if (!conn) {
+        spdlog::error("Failed to initialize MySQL connection");
+        return nullptr;
+    }
+
+    // Set connection options
+    unsigned int timeout = 10;
+    mysql_options(conn, MYSQL_OPT_CONNECT_TIMEOUT, &timeout);
+
+    // Set charset
+    mysql_options(conn, MYSQL_SET_CHARSET_NAME, "utf8mb4");
+    // DATETIME text is read and written as UTC (see Timestamp.h)
+    if (timestampZone() == TimestampZone::Utc) {
+        mysql_options(conn, MYSQL_INIT_COMMAND, "SET time_zone = '+00:00'");
+    }
+
+    // Connect to database
+    if (!mysql_real_connect(conn, host_.c_str(), user_.c_str(),
+                           password_.c_str(), database_.c_str(), port_, nullptr, 0)) {
+        spdlog::error("Failed to connect to database: {} (Code: {})", mysql_error(conn), mysql_errno(conn));
+        mysql_close(conn);
+        return nullptr;
+    }
+
+    return conn;
+}
+
+bool ConnectionPool::isExpired(const Connection& connection, std::chrono::steady_clock::time_point now) const {
+    return now - connection.created_at > settings_.max_lifetime;
+}
+
+void ConnectionPool::destroy(Connection* connection) {
+    // Statements must be closed before their connection
+    connection->statements.clear();
+    if (connection->mysql) {
+        mysql_close(connection->mysql);
+    }
+    delete connection;
+}
+
+ConnectionPool::Lease ConnectionPool::acquire() {
+    const auto start = std::chrono::steady_clock::now();
+    const auto deadline = start + settings_.acquire_timeout;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    waiters_++;
+
+    Connection* connection = nullptr;
+    while (!connection) {
+        if (stopping_) {
+            waiters_--;
+            throw std::runtime_error("Connection pool is shut down");
+        }
+
+        if (!idle_.empty()) {
+            Connection* candidate = idle_.back();
+            idle_.pop_back();
+
+            if (isExpired(*candidate, std::chrono::steady_clock::now())) {
+                total_--;
+                closed_++;
+                lock.unlock();
+                destroy(candidate);
+                lock.lock();
+                continue;
+            }
+            connection = candidate;
+            break;
+        }
+
+        if (total_ + opening_ < settings_.max_size) {
+            // Open outside the lock; connecting can take a while
+            opening_++;
+            lock.unlock();
+            MYSQL* mysql = openConnection();
+            lock.lock();
+            opening_--;
+
+            if (!mysql) {
+                waiters_--;
+                available_.notify_one();
+                throw std::runtime_error("Failed to open MySQL connection");
+            }
+
+            auto now = std::chrono::steady_clock::now();
+            connection = new Connection{mysql, now, now, {}};
+            total_++;
+            created_++;
+            break;
+        }
+
+        if (available_.wait_until(lock, deadline) == std::cv_status::timeout &&
+            idle_.empty() && total_ + opening_ >= settings_.max_size) {
+            waiters_--;
+            timeouts_++;
+            throw std::runtime_error("Timed out waiting for a database connection");
+        }
+    }
+
+    waiters_--;
+    acquisitions_++;
+    double wait_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    total_wait_ms_ += wait_ms;
+    if (wait_ms > max_wait_ms_) {
+        max_wait_ms_ = wait_ms;
+    }
+
+    return Lease(this, connection);
+}
+
+void ConnectionPool::giveBack(Connection* connection, bool broken) {
+    auto now = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!broken && !stopping_ && !isExpired(*connection, now)) {
+            connection->last_used = now;
+            idle_.push_back(connection);
+            available_.notify_one();
+            return;
+        }
+        total_--;
+        closed_++;
+    }
+
+    destroy(connection);
+    // A slot is free again, so a waiter may open a fresh connection
+    available_.notify_one();
+}
+
+void ConnectionPool::closeIdle() {
+    std::vector<Connection*> victims;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        victims.swap(idle_);
+        total_ -= victims.size();
+        closed_ += victims.size();
+    }
+    for (auto* connection : victims) {
+        destroy(connection);
+    }
+    available_.notify_all();
+}
+
+void ConnectionPool::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) {
+            return;
+        }
+        stopping_ = true;
+    }
+    maintenance_wake_.notify_all();
+    available_.notify_all();
+
+    if (maintenance_thread_.joinable()) {
+        maintenance_thread_.join();
+    }
+
+    // Leased connections are closed as they come back
+    closeIdle();
+}
+
+void ConnectionPool::maintenanceLoop() {
+    while (true) {
+        std::vector<Connection*> to_check;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            maintenance_wake_.wait_for(lock, settings_.validation_interval, [this]() { return stopping_; });
+            if (stopping_) {
+                return;
+            }
+
+            // Take out the connections that sat idle for a whole interval
+            auto now = std::chrono::steady_clock::now();
+            for (auto it = idle_.begin(); it != idle_.end();) {
+                if (now - (*it)->last_used >= settings_.validation_interval || isExpired(**it, now)) {
+                    to_check.push_back(*it);
+                    it = idle_.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+
+        std::vector<Connection*> healthy;
+        size_t dropped = 0;
+        auto now = std::chrono::steady_clock::now();
+        for (auto* connection : to_check) {
+            if (!isExpired(*connection, now) && mysql_ping(connection->mysql) == 0) {
+                connection->last_used = now;
+                healthy.push_back(connection);
+            } else {
+                destroy(connection);
+                dropped++;
+            }
+        }
+
+        size_t missing = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            total_ -= dropped;
+            closed_ += dropped;
+            idle_.insert(idle_.end(), healthy.begin(), healthy.end());
+            missing = reserveMissing();
+        }
+        if (!healthy.empty() || dropped > 0) {
+            available_.notify_all();
+        }
+        if (dropped > 0) {
+            spdlog::info("Connection pool retired {} idle connections", dropped);
+        }
+
+        // Keep a few warm connections ready
+        openIdle(missing);
+    }
+}
+
+size_t ConnectionPool::reserveMissing() {
+    size_t missing = 0;
+    if (idle_.size() < settings_.min_idle && total_ + opening_ < settings_.max_size) {
+        missing = std::min(settings_.min_idle - idle_.size(), settings_.max_size - total_ - opening_);
+        opening_ += missing;
+    }
+    return missing;
+}
+
+void ConnectionPool::openIdle(size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        MYSQL* mysql = openConnection();
+        std::lock_guard<std::mutex> lock(mutex_);
+        opening_--;
+        if (mysql) {
+            auto opened = std::chrono::steady_clock::now();
+            idle_.push_back(new Connection{mysql, opened, opened, {}});
+            total_++;
+            created_++;
+            available_.notify_one();
+        }
+    }
+}
+
+size_t ConnectionPool::warmUp() {
+    size_t missing = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) return 0;
+        missing = reserveMissing();
+    }
+    openIdle(missing);
+    std::lock_guard<std::mutex> lock(mutex_);
+    return idle_.size();
+}
+
+PoolMetrics ConnectionPool::metrics() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    PoolMetrics m;
+    m.total = total_;
+    m.idle = idle_.size();
+    m.in_use = total_ - idle_.size();
+    m.waiters = waiters_;
+    m.acquisitions = acquisitions_;
+    m.timeouts = timeouts_;
+    m.created = created_;
+    m.closed = closed_;
+    m.total_wait_ms = total_wait_ms_;
+    m.max_wait_ms = max_wait_ms_;
+    return m;
+}
+
+} // namespace aeronautical
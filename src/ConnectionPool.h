@@ -0,0 +1,126 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <json.hpp>
+#include <mysql/mysql.h>
+#include "PoolSettings.h"
+#include "PreparedStatement.h"
+
+namespace aeronautical {
+
+// Bounded pool of MySQL C API connections shared by HTTP and analysis
+// threads. Connections are checked out through RAII leases, validated by a
+// background timer rather than on every query, and retired after max_lifetime.
+class ConnectionPool {
+public:
+    struct Connection {
+        MYSQL* mysql = nullptr;
+        std::chrono::steady_clock::time_point created_at;
+        std::chrono::steady_clock::time_point last_used;
+        // Prepared statements live as long as the session that prepared them
+        std::unordered_map<std::string, std::unique_ptr<PreparedStatement>> statements;
+
+        // Cached statement for sql, prepared on first use
+        PreparedStatement& statement(const std::string& sql);
+        void forgetStatement(const std::string& sql) { statements.erase(sql); }
+    };
+
+    // Exclusive use of one pooled connection; returns it on destruction
+    class Lease {
+    public:
+        Lease() = default;
+        Lease(ConnectionPool* pool, Connection* connection) : pool_(pool), connection_(connection) {}
+        ~Lease() { release(); }
+
+        Lease(Lease&& other) noexcept : pool_(other.pool_), connection_(other.connection_), broken_(other.broken_) {
+            other.pool_ = nullptr;
+            other.connection_ = nullptr;
+        }
+        Lease& operator=(Lease&& other) noexcept;
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+
+        MYSQL* get() const { return connection_ ? connection_->mysql : nullptr; }
+        Connection* connection() const { return connection_; }
+        explicit operator bool() const { return connection_ != nullptr; }
+
+        // The connection is unusable (server gone, protocol error); close it on release
+        void invalidate() { broken_ = true; }
+        void release();
+
+    private:
+        ConnectionPool* pool_ = nullptr;
+        Connection* connection_ = nullptr;
+        bool broken_ = false;
+    };
+
+    ConnectionPool(std::string host, int port, std::string user, std::string password,
+                   std::string database, PoolSettings settings);
+    ~ConnectionPool();
+
+    ConnectionPool(const ConnectionPool&) = delete;
+    ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+    // Blocks up to acquire_timeout for a free connection; throws std::runtime_error on timeout
+    Lease acquire();
+
+    // Opens connections up to min_idle now instead of at the next
+    // maintenance pass; returns how many idle connections there are
+    size_t warmUp();
+
+    // Closes idle connections so the next checkouts reconnect
+    void closeIdle();
+    void shutdown();
+
+    PoolMetrics metrics() const;
+    const PoolSettings& settings() const { return settings_; }
+
+private:
+    MYSQL* openConnection();
+    void giveBack(Connection* connection, bool broken);
+    void destroy(Connection* connection);
+    void maintenanceLoop();
+    // Connections to open for min_idle, reserved in opening_; caller holds mutex_
+    size_t reserveMissing();
+    // Opens reserved connections into the idle list
+    void openIdle(size_t count);
+    bool isExpired(const Connection& connection, std::chrono::steady_clock::time_point now) const;
+
+    // Per-connection cap; the cache is flushed when a new statement would exceed it
+    static constexpr size_t kMaxCachedStatements = 128;
+
+    std::string host_;
+    int port_;
+    std::string user_;
+    std::string password_;
+    std::string database_;
+    PoolSettings settings_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable available_;
+    std::vector<Connection*> idle_;
+    size_t total_ = 0;
+    size_t opening_ = 0;  // connections being opened outside the lock
+    size_t waiters_ = 0;
+    bool stopping_ = false;
+
+    uint64_t acquisitions_ = 0;
+    uint64_t timeouts_ = 0;
+    uint64_t created_ = 0;
+    uint64_t closed_ = 0;
+    double total_wait_ms_ = 0.0;
+    double max_wait_ms_ = 0.0;
+
+    std::condition_variable maintenance_wake_;
+    std::thread maintenance_thread_;
+};
+
+} // namespace aeronautical
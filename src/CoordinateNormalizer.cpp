@@ -0,0 +1,166 @@
+#include "CoordinateNormalizer.h"
+#include <array>
+
+namespace aeronautical {
+
+namespace {
+
+using Type = GeoJsonGeometry::Type;
+
+// Coordinate nesting above the positions, as in GeoJsonReader
+int depthOf(Type type) {
+    switch (type) {
+        case Type::Point: return 0;
+        case Type::LineString:
+        case Type::MultiPoint: return 1;
+        case Type::Polygon:
+        case Type::MultiLineString: return 2;
+        case Type::MultiPolygon: return 3;
+        case Type::GeometryCollection: break;
+    }
+    return -1;
+}
+
+// The loops below run over every position of an upload without branches,
+// so they vectorize; NaN fails every comparison and counts as invalid
+size_t countInvalid(const double* c, size_t positions) {
+    size_t invalid = 0;
+    for (size_t i = 0; i < positions; i++) {
+        const double x = c[3 * i];
+        const double y = c[3 * i + 1];
+        const unsigned ok = (x >= -180.0) & (x <= 180.0) & (y >= -90.0) & (y <= 90.0);
+        invalid += 1u - ok;
+    }
+    return invalid;
+}
+
+// Positions equal to the one before; pairs across two lines count too,
+// which only costs a compaction pass that finds nothing
+size_t countRepeats(const double* c, size_t positions) {
+    size_t repeats = 0;
+    for (size_t i = 1; i < positions; i++) {
+        repeats += static_cast<unsigned>(c[3 * i] == c[3 * i - 3]) & static_cast<unsigned>(c[3 * i + 1] == c[3 * i - 2]);
+    }
+    return repeats;
+}
+
+bool samePosition(const double* a, const double* b) {
+    return a[0] == b[0] && a[1] == b[1];
+}
+
+bool ringsClosed(const GeoJsonGeometry& geometry, size_t level) {
+    size_t start = 0;
+    for (uint32_t count : geometry.counts[level]) {
+        if (count >= 3 && !samePosition(&geometry.coordinates[3 * start], &geometry.coordinates[3 * (start + count - 1)])) {
+            return false;
+        }
+        start += count;
+    }
+    return true;
+}
+
+// Rewrites the lines (or rings) counted at level without repeated vertices,
+// closing rings that end short of their first vertex
+void compact(GeoJsonGeometry& geometry, size_t level, bool rings, CoordinateNormalizer::Result& result) {
+    auto& lines = geometry.counts[level];
+    std::pmr::vector<double> out(geometry.coordinates.get_allocator());
+    out.reserve(geometry.coordinates.size() + (rings ? 3 * lines.size() : 0));
+    const double* in = geometry.coordinates.data();
+    size_t position = 0;
+    for (uint32_t& count : lines) {
+        const size_t start = out.size();
+        for (uint32_t i = 0; i < count; i++, position++) {
+            const double* p = in + 3 * position;
+            if (out.size() > start && samePosition(&out[out.size() - 3], p)) {
+                result.duplicates_removed++;
+                continue;
+            }
+            out.insert(out.end(), p, p + 3);
+        }
+        uint32_t kept = static_cast<uint32_t>((out.size() - start) / 3);
+        if (rings && kept >= 3 && !samePosition(&out[start], &out[out.size() - 3])) {
+            out.insert(out.end(), out.begin() + start, out.begin() + start + 3);
+            result.rings_closed++;
+            kept++;
+        }
+        if (!rings && count > 0 && kept < 2) {
+            result.collapsed = true;
+        }
+        count = kept;
+    }
+    geometry.coordinates = std::move(out);
+}
+
+void normalizeInto(GeoJsonGeometry& geometry, CoordinateNormalizer::Result& result) {
+    if (geometry.type == Type::GeometryCollection) {
+        for (auto& member : geometry.geometries) {
+            normalizeInto(member, result);
+        }
+        return;
+    }
+
+    const size_t positions = geometry.positionCount();
+    const size_t invalid = countInvalid(geometry.coordinates.data(), positions);
+    result.invalid_positions += invalid;
+    if (invalid > 0) return;
+
+    // Points carry no lines; otherwise lines or rings are counted one level
+    // above the positions
+    const int depth = depthOf(geometry.type);
+    if (geometry.type == Type::Point || geometry.type == Type::MultiPoint) return;
+    const bool rings = geometry.type == Type::Polygon || geometry.type == Type::MultiPolygon;
+    const size_t level = static_cast<size_t>(depth - 1);
+    result.has_rings = result.has_rings || (rings && positions > 0);
+
+    const bool repeats = countRepeats(geometry.coordinates.data(), positions) > 0;
+    if (repeats || (rings && !ringsClosed(geometry, level))) {
+        compact(geometry, level, rings, result);
+    } else if (!rings) {
+        for (uint32_t count : geometry.counts[level]) {
+            if (count == 1) result.collapsed = true;
+        }
+    }
+}
+
+struct Writer {
+    const GeoJsonGeometry& geometry;
+    size_t position = 0;
+    std::array<size_t, 3> index = {0, 0, 0};
+
+    nlohmann::json array(size_t level, int depth) {
+        if (depth == 0) {
+            const double* p = &geometry.coordinates[3 * position++];
+            nlohmann::json coordinates = {p[0], p[1]};
+            if (geometry.dimensions == 3) coordinates.push_back(p[2]);
+            return coordinates;
+        }
+        nlohmann::json children = nlohmann::json::array();
+        for (uint32_t i = geometry.counts[level][index[level]++]; i > 0; i--) {
+            children.push_back(array(level + 1, depth - 1));
+        }
+        return children;
+    }
+};
+
+} // namespace
+
+CoordinateNormalizer::Result CoordinateNormalizer::normalize(GeoJsonGeometry& geometry) {
+    Result result;
+    normalizeInto(geometry, result);
+    return result;
+}
+
+void CoordinateNormalizer::writeCoordinates(const GeoJsonGeometry& geometry, nlohmann::json& object) {
+    if (geometry.type == Type::GeometryCollection) {
+        auto members = object.find("geometries");
+        if (members == object.end() || !members->is_array() || members->size() != geometry.geometries.size()) return;
+        for (size_t i = 0; i < geometry.geometries.size(); i++) {
+            writeCoordinates(geometry.geometries[i], (*members)[i]);
+        }
+        return;
+    }
+    Writer writer{geometry};
+    object["coordinates"] = writer.array(0, depthOf(geometry.type));
+}
+
+} // namespace aeronautical
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "GeoJsonReader.h"
+#include <json.hpp>
+#include <cstddef>
+
+namespace aeronautical {
+
+// Cheap checks on submitted geometry, run over the flat coordinate arrays
+// before anything reaches GEOS. Non-finite or out-of-range lng/lat make a
+// geometry unusable; repeated consecutive vertices and unclosed polygon
+// rings are fixed in place. What is left for IsValid()/Buffer(0) is ring
+// topology (self-intersections, bad nesting), which only polygons have.
+class CoordinateNormalizer {
+public:
+    struct Result {
+        size_t invalid_positions = 0; // NaN, infinite, or lng/lat out of range
+        size_t duplicates_removed = 0;
+        size_t rings_closed = 0;
+        // A line left with fewer than 2 distinct vertices
+        bool collapsed = false;
+        // Has polygon rings, whose topology only GEOS can check
+        bool has_rings = false;
+
+        bool usable() const { return invalid_positions == 0 && !collapsed; }
+        bool changed() const { return duplicates_removed > 0 || rings_closed > 0; }
+    };
+
+    // Checks geometry and, unless a position is invalid, normalizes it
+    static Result normalize(GeoJsonGeometry& geometry);
+
+    // Writes the coordinates of geometry back into its GeoJSON object
+    // ("coordinates", or "geometries" members for a collection)
+    static void writeCoordinates(const GeoJsonGeometry& geometry, nlohmann::json& object);
+};
+
+} // namespace aeronautical
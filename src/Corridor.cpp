@@ -0,0 +1,145 @@
+#include "Corridor.h"
+#include "LocalProjection.h"
+#include <algorithm>
+#include <cmath>
+
+namespace aeronautical {
+
+namespace {
+
+constexpr double kEarthRadiusM = 6371008.8;
+constexpr double kMetresPerDegree = kEarthRadiusM * M_PI / 180.0;
+
+// Metres per degree of longitude and latitude in the tangent plane at lat
+std::pair<double, double> planeScale(double lat) {
+    return {kMetresPerDegree * std::cos(lat * M_PI / 180.0), kMetresPerDegree};
+}
+
+template <typename Vertex>
+void forEachVertex(const OGRGeometry& geometry, Vertex&& vertex) {
+    auto visit = [&](const OGRGeometry& part, auto& self) -> void {
+        switch (wkbFlatten(part.getGeometryType())) {
+            case wkbPoint: {
+                const auto* point = part.toPoint();
+                if (!point->IsEmpty()) vertex(point->getX(), point->getY());
+                break;
+            }
+            case wkbLineString:
+            case wkbLinearRing: {
+                const auto* line = part.toLineString();
+                for (int i = 0; i < line->getNumPoints(); i++) vertex(line->getX(i), line->getY(i));
+                break;
+            }
+            case wkbPolygon:
+                for (const auto* ring : *part.toPolygon()) self(*ring, self);
+                break;
+            case wkbMultiPoint:
+            case wkbMultiLineString:
+            case wkbMultiPolygon:
+            case wkbGeometryCollection: {
+                const auto* collection = part.toGeometryCollection();
+                for (int i = 0; i < collection->getNumGeometries(); i++) self(*collection->getGeometryRef(i), self);
+                break;
+            }
+            default:
+                break;
+        }
+    };
+    visit(geometry, visit);
+}
+
+} // namespace
+
+std::optional<Corridor> Corridor::build(const OGRLineString& line, double half_width_m) {
+    Corridor corridor;
+    corridor.half_width_m_ = half_width_m;
+    // Repeated vertices would make zero-length segments
+    for (int i = 0; i < line.getNumPoints(); i++) {
+        const double lng = line.getX(i);
+        const double lat = line.getY(i);
+        if (!std::isfinite(lng) || !std::isfinite(lat)) return std::nullopt;
+        if (!corridor.lng_.empty() && corridor.lng_.back() == lng && corridor.lat_.back() == lat) continue;
+        corridor.lng_.push_back(lng);
+        corridor.lat_.push_back(lat);
+    }
+    if (corridor.lng_.size() < 2) {
+        return std::nullopt;
+    }
+
+    corridor.polygon_ = LocalProjection::buffer(line, half_width_m);
+    if (!corridor.polygon_ || corridor.polygon_->IsEmpty()) {
+        return std::nullopt;
+    }
+    corridor.polygon_->getEnvelope(&corridor.envelope_);
+
+    const size_t segments = corridor.lng_.size() - 1;
+    corridor.cumulative_m_.assign(1, 0.0);
+    corridor.segment_envelopes_.reserve(segments);
+    const double dlat = half_width_m / kMetresPerDegree;
+    for (size_t i = 0; i < segments; i++) {
+        const double lat0 = (corridor.lat_[i] + corridor.lat_[i + 1]) / 2;
+        const auto [kx, ky] = planeScale(lat0);
+        const double dx = (corridor.lng_[i + 1] - corridor.lng_[i]) * kx;
+        const double dy = (corridor.lat_[i + 1] - corridor.lat_[i]) * ky;
+        corridor.cumulative_m_.push_back(corridor.cumulative_m_.back() + std::hypot(dx, dy));
+
+        // Widened at the segment's latitude farthest from the equator
+        const double far_lat = std::min(89.0, std::max(std::abs(corridor.lat_[i]), std::abs(corridor.lat_[i + 1])) + dlat);
+        const double dlng = half_width_m / (kMetresPerDegree * std::cos(far_lat * M_PI / 180.0));
+        OGREnvelope envelope;
+        envelope.MinX = std::min(corridor.lng_[i], corridor.lng_[i + 1]) - dlng;
+        envelope.MaxX = std::max(corridor.lng_[i], corridor.lng_[i + 1]) + dlng;
+        envelope.MinY = std::min(corridor.lat_[i], corridor.lat_[i + 1]) - dlat;
+        envelope.MaxY = std::max(corridor.lat_[i], corridor.lat_[i + 1]) + dlat;
+        corridor.segment_envelopes_.push_back(envelope);
+    }
+    corridor.segment_index_.build(corridor.segment_envelopes_);
+    return corridor;
+}
+
+void Corridor::segmentsOverlapping(const OGREnvelope& envelope, std::vector<size_t>& out) const {
+    out.clear();
+    if (!envelope_.Intersects(envelope)) return;
+    segment_index_.query(envelope, out);
+}
+
+Corridor::Position Corridor::locateOnSegment(size_t segment, double lng, double lat) const {
+    const double lat0 = (lat_[segment] + lat_[segment + 1]) / 2;
+    const auto [kx, ky] = planeScale(lat0);
+    const double bx = (lng_[segment + 1] - lng_[segment]) * kx;
+    const double by = (lat_[segment + 1] - lat_[segment]) * ky;
+    const double px = (lng - lng_[segment]) * kx;
+    const double py = (lat - lat_[segment]) * ky;
+    const double length2 = bx * bx + by * by;
+    const double t = length2 > 0 ? std::clamp((px * bx + py * by) / length2, 0.0, 1.0) : 0.0;
+
+    Position position;
+    position.segment = segment;
+    position.along_track_m = cumulative_m_[segment] + t * (cumulative_m_[segment + 1] - cumulative_m_[segment]);
+    position.cross_track_m = std::hypot(px - t * bx, py - t * by);
+    return position;
+}
+
+Corridor::Position Corridor::locate(double lng, double lat) const {
+    Position best = locateOnSegment(0, lng, lat);
+    for (size_t segment = 1; segment < segmentCount(); segment++) {
+        Position position = locateOnSegment(segment, lng, lat);
+        if (position.cross_track_m < best.cross_track_m) best = position;
+    }
+    return best;
+}
+
+std::optional<Corridor::Position> Corridor::firstContact(const OGRGeometry& geometry) const {
+    std::unique_ptr<OGRGeometry> meeting(polygon_->Intersection(&geometry));
+    if (!meeting || meeting->IsEmpty()) {
+        return std::nullopt;
+    }
+    std::optional<Position> first;
+    forEachVertex(*meeting, [&](double lng, double lat) {
+        Position position = locate(lng, lat);
+        if (!first || position.along_track_m < first->along_track_m) first = position;
+    });
+    return first;
+}
+
+} // namespace aeronautical
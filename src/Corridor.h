@@ -0,0 +1,67 @@
+#pragma once
+
+#include "ProtectionIndex.h"
+#include "ogr_geometry.h"
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace aeronautical {
+
+// A trajectory grown by a half-width on both sides, for "everything within
+// X NM of this line" queries. The line is buffered once in a local metric
+// projection (see LocalProjection); each segment keeps its own envelope,
+// widened by the half-width, in an R-tree, so callers walk their spatial
+// indexes with the segment envelopes rather than the envelope of the whole
+// corridor, which for a turning trajectory covers far more ground.
+//
+// Positions along the line are in metres: along-track from the first vertex
+// and cross-track to the nearest point of the line, each segment measured
+// in a tangent plane at its midpoint. Trajectories crossing the
+// antimeridian are not supported.
+class Corridor {
+public:
+    struct Position {
+        size_t segment = 0;
+        double along_track_m = 0;
+        double cross_track_m = 0;
+    };
+
+    // nullopt for fewer than two distinct vertices or when the buffer fails
+    static std::optional<Corridor> build(const OGRLineString& line, double half_width_m);
+
+    const OGRGeometry& polygon() const { return *polygon_; }
+    const OGREnvelope& envelope() const { return envelope_; }
+    double halfWidth() const { return half_width_m_; }
+    double length() const { return cumulative_m_.back(); }
+
+    size_t segmentCount() const { return segment_envelopes_.size(); }
+    const OGREnvelope& segmentEnvelope(size_t segment) const { return segment_envelopes_[segment]; }
+    // Segments whose widened envelope overlaps envelope, ascending
+    void segmentsOverlapping(const OGREnvelope& envelope, std::vector<size_t>& out) const;
+
+    // Nearest point of the line to (lng, lat)
+    Position locate(double lng, double lat) const;
+    // Where the corridor first meets geometry: the vertex of their
+    // intersection with the smallest along-track distance; nullopt when
+    // they do not meet
+    std::optional<Position> firstContact(const OGRGeometry& geometry) const;
+
+private:
+    Corridor() = default;
+
+    // Position of (lng, lat) against one segment
+    Position locateOnSegment(size_t segment, double lng, double lat) const;
+
+    std::vector<double> lng_;
+    std::vector<double> lat_;
+    std::vector<double> cumulative_m_; // along-track distance of each vertex
+    std::vector<OGREnvelope> segment_envelopes_;
+    ProtectionIndex segment_index_;
+    std::unique_ptr<OGRGeometry> polygon_;
+    OGREnvelope envelope_;
+    double half_width_m_ = 0;
+};
+
+} // namespace aeronautical
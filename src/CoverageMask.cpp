@@ -0,0 +1,115 @@
+#include "CoverageMask.h"
+#include "ProtectionGeometryCache.h"
+#include "ogr_geometry.h"
+
+namespace aeronautical {
+
+namespace {
+
+constexpr uint64_t kCoordinateMask = (uint64_t(1) << 29) - 1;
+
+OGRPolygon rectangle(const OGREnvelope& envelope) {
+    OGRLinearRing ring;
+    ring.addPoint(envelope.MinX, envelope.MinY);
+    ring.addPoint(envelope.MaxX, envelope.MinY);
+    ring.addPoint(envelope.MaxX, envelope.MaxY);
+    ring.addPoint(envelope.MinX, envelope.MaxY);
+    ring.addPoint(envelope.MinX, envelope.MinY);
+    OGRPolygon polygon;
+    polygon.addRing(&ring);
+    return polygon;
+}
+
+bool insideWorld(const OGREnvelope& envelope) {
+    return envelope.MinX >= -180.0 && envelope.MaxX <= 180.0 && envelope.MinY >= -90.0 && envelope.MaxY <= 90.0;
+}
+
+} // namespace
+
+OGREnvelope CoverageMask::bounds(int level, uint32_t x, uint32_t y) {
+    const double width = 360.0 / static_cast<double>(uint64_t(1) << level);
+    const double height = 180.0 / static_cast<double>(uint64_t(1) << level);
+    OGREnvelope envelope;
+    envelope.MinX = -180.0 + x * width;
+    envelope.MaxX = envelope.MinX + width;
+    envelope.MinY = -90.0 + y * height;
+    envelope.MaxY = envelope.MinY + height;
+    return envelope;
+}
+
+void CoverageMask::add(const CachedProtectionGeometry& zone) {
+    if (!insideWorld(zone.envelope)) {
+        // Not in lon/lat degrees; no cell can stand for it
+        unbounded_ = true;
+        return;
+    }
+    addCell(zone, 0, 0, 0);
+}
+
+void CoverageMask::addCell(const CachedProtectionGeometry& zone, int level, uint32_t x, uint32_t y) {
+    const OGREnvelope cell = bounds(level, x, y);
+    if (!cell.Intersects(zone.envelope) || !zone.touches(cell)) return;
+    if (auto it = cells_.find(key(level, x, y)); it != cells_.end() && it->second == Cell::Whole) return;
+
+    // A cell holding the whole zone meets it and cannot be covered by it,
+    // so only cells the zone's envelope crosses are tested against it
+    if (!cell.Contains(zone.envelope)) {
+        const OGRPolygon rect = rectangle(cell);
+        if (!zone.intersects(rect)) return;
+        if (level == kMaxLevel || zone.contains(rect)) {
+            mark(level, x, y);
+            return;
+        }
+    } else if (level == kMaxLevel) {
+        mark(level, x, y);
+        return;
+    }
+    for (uint32_t dy = 0; dy < 2; dy++) {
+        for (uint32_t dx = 0; dx < 2; dx++) {
+            addCell(zone, level + 1, 2 * x + dx, 2 * y + dy);
+        }
+    }
+}
+
+void CoverageMask::mark(int level, uint32_t x, uint32_t y) {
+    cells_[key(level, x, y)] = Cell::Whole;
+    // Every ancestor of a marked cell is present; stop at the first one that was
+    while (level > 0) {
+        level--;
+        x >>= 1;
+        y >>= 1;
+        if (!cells_.try_emplace(key(level, x, y), Cell::Partial).second) break;
+    }
+}
+
+void CoverageMask::merge(const CoverageMask& other) {
+    unbounded_ = unbounded_ || other.unbounded_;
+    for (const auto& [k, cell] : other.cells_) {
+        if (cell != Cell::Whole) continue; // implied by the whole cells below it
+        mark(static_cast<int>(k >> 58), static_cast<uint32_t>((k >> 29) & kCoordinateMask),
+             static_cast<uint32_t>(k & kCoordinateMask));
+    }
+}
+
+bool CoverageMask::touches(const OGREnvelope& envelope) const {
+    if (unbounded_) return true;
+    return touchesCell(envelope, 0, 0, 0);
+}
+
+bool CoverageMask::touchesCell(const OGREnvelope& envelope, int level, uint32_t x, uint32_t y) const {
+    auto it = cells_.find(key(level, x, y));
+    if (it == cells_.end()) return false;
+    if (it->second == Cell::Whole) return true;
+    for (uint32_t dy = 0; dy < 2; dy++) {
+        for (uint32_t dx = 0; dx < 2; dx++) {
+            const uint32_t cx = 2 * x + dx;
+            const uint32_t cy = 2 * y + dy;
+            if (bounds(level + 1, cx, cy).Intersects(envelope) && touchesCell(envelope, level + 1, cx, cy)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+} // namespace aeronautical
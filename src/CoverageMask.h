@@ -0,0 +1,51 @@
+#pragma once
+
+#include "ogr_core.h"
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+namespace aeronautical {
+
+struct CachedProtectionGeometry;
+
+// The dissolved footprint of a set of protection zones as a quadtree of
+// longitude/latitude cells: a cell a zone covers entirely is marked whole,
+// one a zone only crosses is split down to kMaxLevel, where any cell the
+// zone touches is marked. So the mask never misses a point of a zone, and
+// an envelope meeting no marked cell cannot meet any zone added to it;
+// the converse does not hold, the leaf cells being about 20 x 10 km.
+// Answering touches() costs a few hash lookups and no geometry work.
+// A mask is filled once and then only read, by any number of threads.
+class CoverageMask {
+public:
+    static constexpr int kMaxLevel = 11; // 360 / 2^11 degrees of longitude, half that of latitude
+
+    // Marks the cells the zone meets; a zone reaching outside longitude
+    // -180..180 or latitude -90..90 makes every envelope touch the mask
+    void add(const CachedProtectionGeometry& zone);
+    // Marks every cell another mask marked
+    void merge(const CoverageMask& other);
+
+    // Whether any marked cell meets envelope (boundaries included)
+    bool touches(const OGREnvelope& envelope) const;
+
+    size_t cells() const { return cells_.size(); }
+
+private:
+    enum class Cell : uint8_t { Partial, Whole };
+
+    static uint64_t key(int level, uint32_t x, uint32_t y) {
+        return static_cast<uint64_t>(level) << 58 | static_cast<uint64_t>(x) << 29 | y;
+    }
+    static OGREnvelope bounds(int level, uint32_t x, uint32_t y);
+
+    void addCell(const CachedProtectionGeometry& zone, int level, uint32_t x, uint32_t y);
+    void mark(int level, uint32_t x, uint32_t y);
+    bool touchesCell(const OGREnvelope& envelope, int level, uint32_t x, uint32_t y) const;
+
+    std::unordered_map<uint64_t, Cell> cells_; // absent: no zone meets the cell
+    bool unbounded_ = false;
+};
+
+} // namespace aeronautical
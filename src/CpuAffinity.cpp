@@ -0,0 +1,102 @@
+#include "CpuAffinity.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace aeronautical {
+
+CpuSet parseCpuList(const std::string& spec) {
+    CpuSet cpus;
+    size_t start = 0;
+    while (start < spec.size()) {
+        size_t comma = spec.find(',', start);
+        if (comma == std::string::npos) comma = spec.size();
+        const std::string range = spec.substr(start, comma - start);
+        start = comma + 1;
+        if (range.empty()) continue;
+
+        size_t consumed = 0;
+        const int first = std::stoi(range, &consumed);
+        int last = first;
+        if (consumed < range.size()) {
+            if (range[consumed] != '-') throw std::invalid_argument("bad cpu range '" + range + "'");
+            size_t rest = 0;
+            last = std::stoi(range.substr(consumed + 1), &rest);
+            if (consumed + 1 + rest != range.size()) throw std::invalid_argument("bad cpu range '" + range + "'");
+        }
+        if (first < 0 || last < first) throw std::invalid_argument("bad cpu range '" + range + "'");
+        for (int cpu = first; cpu <= last; cpu++) cpus.push_back(cpu);
+    }
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    return cpus;
+}
+
+bool pinCurrentThread(const CpuSet& cpus) {
+    if (cpus.empty()) return true;
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        if (cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    return false;
+#endif
+}
+
+std::string formatCpuList(const CpuSet& cpus) {
+    std::string out;
+    for (size_t i = 0; i < cpus.size();) {
+        size_t j = i;
+        while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1) j++;
+        if (!out.empty()) out += ',';
+        out += std::to_string(cpus[i]);
+        if (j > i) out += '-' + std::to_string(cpus[j]);
+        i = j + 1;
+    }
+    return out;
+}
+
+std::vector<NumaNode> numaNodes() {
+    std::vector<NumaNode> nodes;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator("/sys/devices/system/node", ec)) {
+        const std::string name = entry.path().filename().string();
+        if (name.rfind("node", 0) != 0 || name.size() == 4 ||
+            !std::all_of(name.begin() + 4, name.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+            continue;
+        }
+        std::ifstream in(entry.path() / "cpulist");
+        std::string list;
+        if (!std::getline(in, list)) continue;
+        try {
+            CpuSet cpus = parseCpuList(list);
+            if (!cpus.empty()) nodes.push_back(NumaNode{std::stoi(name.substr(4)), std::move(cpus)});
+        } catch (const std::exception&) {
+            continue;
+        }
+    }
+    if (nodes.size() < 2) return {};
+    std::sort(nodes.begin(), nodes.end(), [](const NumaNode& a, const NumaNode& b) { return a.id < b.id; });
+    return nodes;
+}
+
+int currentNumaNode() {
+#ifdef __linux__
+    unsigned cpu = 0;
+    unsigned node = 0;
+    if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0) return static_cast<int>(node);
+#endif
+    return -1;
+}
+
+} // namespace aeronautical
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace aeronautical {
+
+// CPU numbers a pool's threads are confined to; empty means any CPU
+using CpuSet = std::vector<int>;
+
+// Parses a Linux cpulist such as "0-7,16-23". Throws std::invalid_argument
+// on malformed input so a typo in the configuration fails at startup.
+CpuSet parseCpuList(const std::string& spec);
+
+// Binds the calling thread, and threads it creates afterwards, to cpus.
+// Does nothing for an empty set; returns false if the kernel refused it.
+bool pinCurrentThread(const CpuSet& cpus);
+
+std::string formatCpuList(const CpuSet& cpus);
+
+struct NumaNode {
+    int id = 0;
+    CpuSet cpus;
+};
+
+// NUMA nodes with CPUs, by id, read from /sys/devices/system/node. A
+// machine with one node, or a kernel that does not say, gives none.
+std::vector<NumaNode> numaNodes();
+
+// Node of the CPU the calling thread is running on; -1 when unknown
+int currentNumaNode();
+
+} // namespace aeronautical
@@ -1,6 +1,12 @@
 #include "DatabaseManager.h"
+#include "QueryStats.h"
+#include "Tracing.h"
+#include "Timestamp.h"
+#include "SchemaMigrations.h"
+#include <charconv>
 #include <chrono>
 #include <iomanip>
+#include <limits>
 #include <sstream>
 #include <stdexcept>
 #include <spdlog/sinks/stdout_color_sinks.h>
@@ -8,10 +14,58 @@
 namespace aeronautical {
 
 #ifdef USE_MYSQL_C_API
-// Static member definitions for thread-local storage
-thread_local MYSQL* DatabaseManager::thread_connection_ = nullptr;
-std::mutex DatabaseManager::connections_mutex_;
-std::unordered_map<std::thread::id, MYSQL*> DatabaseManager::active_connections_;
+thread_local ConnectionPool::Lease DatabaseManager::scoped_lease_;
+thread_local int DatabaseManager::scope_depth_ = 0;
+thread_local int DatabaseManager::read_depth_ = 0;
+thread_local bool DatabaseManager::replica_reads_allowed_ = false;
+thread_local int DatabaseManager::transaction_depth_ = 0;
+thread_local bool DatabaseManager::rollback_only_ = false;
+#endif
+
+#ifdef USE_MYSQL_C_API
+namespace {
+
+// Bytes of column data in a buffered result; leaves the row cursor at the start
+uint64_t resultBytes(MYSQL_RES* result) {
+    uint64_t bytes = 0;
+    const unsigned int num_fields = mysql_num_fields(result);
+    while (mysql_fetch_row(result)) {
+        const unsigned long* lengths = mysql_fetch_lengths(result);
+        for (unsigned int i = 0; i < num_fields; i++) bytes += lengths[i];
+    }
+    mysql_data_seek(result, 0);
+    return bytes;
+}
+
+// Timings for QueryStats, and a db.query span when the current trace is sampled
+void recordQuery(std::string_view sql, std::chrono::steady_clock::time_point started, uint64_t rows, uint64_t bytes,
+                 bool failed) {
+    const auto ended = std::chrono::steady_clock::now();
+    QueryStats::getInstance().record(sql, ended - started, rows, bytes, failed);
+    if (Tracer::current().sampled) {
+        Tracer::getInstance().recordSpan("db.query", started, ended,
+                                         {{"db.system", "mysql"},
+                                          {"db.statement", QueryStats::normalize(sql)},
+                                          {"db.rows", std::to_string(rows)}},
+                                         failed);
+    }
+}
+
+uint64_t resultBytes(const PreparedResult& result) {
+    uint64_t bytes = 0;
+    for (const auto& row : result.rows) {
+        for (size_t i = 0; i < row.size(); i++) {
+            if (const auto* text = std::get_if<std::string>(&row.value(i))) {
+                bytes += text->size();
+            } else if (!row.isNull(i)) {
+                bytes += 8;
+            }
+        }
+    }
+    return bytes;
+}
+
+} // namespace
 #endif
 
 DatabaseManager& DatabaseManager::getInstance() {
@@ -32,9 +86,17 @@ DatabaseManager::~DatabaseManager() {
     cleanup();
 }
 
+#ifdef USE_MYSQL_C_API
 void DatabaseManager::initialize(const std::string& host, int port, 
                                 const std::string& user, const std::string& password, 
-                                const std::string& database) {
+                                const std::string& database,
+                                const PoolSettings& pool_settings) {
+#else
+void DatabaseManager::initialize(const std::string& host, int port, 
+                                const std::string& user, const std::string& password, 
+                                const std::string& database,
+                                const PoolSettings& pool_settings) {
+#endif
     try {
         // Initialize logger with mutex protection
         std::lock_guard<std::mutex> logger_lock(logger_mutex_);
@@ -50,33 +112,43 @@ void DatabaseManager::initialize(const std::string& host, int port,
         }
         
 #ifdef USE_MYSQL_C_API
-        // Store connection parameters for thread-local connections
-        host_ = host;
-        port_ = port;
+        database_name_ = database;
         user_ = user;
         password_ = password;
-        database_name_ = database;
-        
-        // Test initial connection to verify parameters
-        MYSQL* test_conn = createNewConnection();
-        if (!test_conn) {
-            throw std::runtime_error("Failed to establish initial test connection");
+        pool_settings_ = pool_settings;
+        pool_ = std::make_unique<ConnectionPool>(host, port, user, password, database, pool_settings);
+
+        // Test initial connection to verify parameters; it stays in the pool
+        {
+            auto lease = pool_->acquire();
+            if (mysql_ping(lease.get()) != 0) {
+                throw std::runtime_error("Failed to establish initial test connection");
+            }
         }
-        
-        // Close test connection - each thread will create its own
-        mysql_close(test_conn);
-        
-        logger_->info("Database connection parameters validated for {}:{}/{} (MySQL C API)", host, port, database);
+
+        logger_->info("Database connection pool ready for {}:{}/{} (MySQL C API, max {} connections)",
+                      host, port, database, pool_settings.max_size);
         
 #else
         std::stringstream ss;
         ss << "mysqlx://" << user << ":" << password << "@" 
            << host << ":" << port << "/" << database;
         
-        session_ = std::make_unique<mysqlx::Session>(ss.str());
         database_name_ = database;
-        
-        logger_->info("Database connection established to {}:{}/{} (MySQL Connector/C++)", host, port, database);
+        pool_settings_ = pool_settings;
+        client_ = std::make_unique<mysqlx::Client>(
+            ss.str(), mysqlx::ClientOption::POOLING, true,
+            mysqlx::ClientOption::POOL_MAX_SIZE, static_cast<int>(pool_settings.max_size),
+            mysqlx::ClientOption::POOL_QUEUE_TIMEOUT, static_cast<int>(pool_settings.acquire_timeout.count()),
+            mysqlx::ClientOption::POOL_MAX_IDLE_TIME,
+            static_cast<int>(std::chrono::milliseconds(pool_settings.max_lifetime).count()));
+        initialized_ = true;
+
+        // Test initial session to verify parameters; it goes back to the pool
+        acquireSession()->sql("SELECT 1").execute();
+
+        logger_->info("Database session pool ready for {}:{}/{} (MySQL Connector/C++, max {} sessions)",
+                      host, port, database, pool_settings.max_size);
 #endif
 
         initialized_ = true;
@@ -91,282 +163,376 @@ void DatabaseManager::initialize(const std::string& host, int port,
 
 #ifdef USE_MYSQL_C_API
 
-MYSQL* DatabaseManager::createNewConnection() {
-    MYSQL* conn = mysql_init(nullptr);
-    if (!conn) {
-        if (logger_) logger_->error("Failed to initialize MySQL connection");
-        return nullptr;
+ConnectionPool& DatabaseManager::pool() {
+    if (!initialized_ || !pool_) {
+        throw std::runtime_error("DatabaseManager not initialized");
     }
-    
-    // Set connection options
-    unsigned int timeout = 10;
-    mysql_options(conn, MYSQL_OPT_CONNECT_TIMEOUT, &timeout);
-    
-    // Enable auto-reconnect for this connection
-    my_bool reconnect = 1;
-    mysql_options(conn, MYSQL_OPT_RECONNECT, &reconnect);
-    
-    // Set charset
-    mysql_options(conn, MYSQL_SET_CHARSET_NAME, "utf8mb4");
-    
-    // Connect to database
-    if (!mysql_real_connect(conn, host_.c_str(), user_.c_str(), 
-                           password_.c_str(), database_name_.c_str(), port_, nullptr, 0)) {
-        std::string error = mysql_error(conn);
-        unsigned int error_code = mysql_errno(conn);
-        
-        if (logger_) {
-            logger_->error("Failed to connect to database: {} (Code: {})", error, error_code);
+    return *pool_;
+}
+
+ConnectionPool::Lease DatabaseManager::acquireConnection() {
+    return pool().acquire();
+}
+
+void DatabaseManager::enableReplicas(const ReplicaSettings& settings) {
+    if (settings.endpoints.empty()) {
+        return;
+    }
+    pool();
+    replicas_ = std::make_unique<ReplicaRouter>(user_, password_, database_name_, settings, pool_settings_);
+    if (logger_) {
+        logger_->info("Reads routed over {} replicas (max lag {} s)", settings.endpoints.size(),
+                      settings.max_lag.count());
+    }
+}
+
+void DatabaseManager::setReplicaReadsAllowed(bool allowed) {
+    replica_reads_allowed_ = allowed;
+}
+
+bool DatabaseManager::replicaReadsAllowed() {
+    return replica_reads_allowed_;
+}
+
+ConnectionPool::Lease DatabaseManager::acquireReadConnection() {
+    if (replicas_ && replica_reads_allowed_) {
+        if (auto lease = replicas_->acquire()) {
+            return lease;
         }
-        
-        mysql_close(conn);
-        return nullptr;
     }
-    
-    return conn;
+    return acquireConnection();
 }
 
-void DatabaseManager::ensureThreadConnection() {
-    if (!initialized_) {
-        throw std::runtime_error("DatabaseManager not initialized");
+DatabaseManager::ReadScope::ReadScope(DatabaseManager& db) {
+    read_depth_++;
+    try {
+        scope_.emplace(db);
+    } catch (...) {
+        read_depth_--;
+        throw;
     }
-    
-    // Check if we already have a valid connection for this thread
-    if (thread_connection_) {
-        // Test connection health
-        if (mysql_ping(thread_connection_) == 0) {
-            return; // Connection is healthy
-        }
-        
-        // Connection is dead, clean it up
-        if (logger_) {
-            std::ostringstream oss;
-            oss << std::this_thread::get_id();
-            logger_->warn("Thread connection lost, reconnecting... Thread ID: {}", oss.str());
-        }
-        cleanupThreadConnection();
+}
+
+DatabaseManager::ReadScope::~ReadScope() {
+    scope_.reset();
+    read_depth_--;
+}
+
+DatabaseManager::ConnectionScope::ConnectionScope(DatabaseManager& db) {
+    if (scope_depth_ == 0) {
+        scoped_lease_ = read_depth_ > 0 ? db.acquireReadConnection() : db.acquireConnection();
+        owner_ = true;
     }
-    
-    // Create new connection for this thread
-    thread_connection_ = createNewConnection();
-    if (!thread_connection_) {
-        throw std::runtime_error("Failed to create thread-local MySQL connection");
+    scope_depth_++;
+}
+
+DatabaseManager::ConnectionScope::~ConnectionScope() {
+    scope_depth_--;
+    if (owner_) {
+        scoped_lease_.release();
     }
-    
-    // Register this connection for cleanup tracking
-    registerConnection(thread_connection_);
-    
-    if (logger_) {
-        std::ostringstream oss;
-        oss << std::this_thread::get_id();
-        logger_->debug("Created thread-local connection for thread: {}", oss.str());
+}
+
+MYSQL* DatabaseManager::ConnectionScope::get() const {
+    return scoped_lease_.get();
+}
+
+ConnectionPool::Connection* DatabaseManager::ConnectionScope::connection() const {
+    return scoped_lease_.connection();
+}
+
+void DatabaseManager::ConnectionScope::invalidate() {
+    scoped_lease_.invalidate();
+}
+
+DatabaseManager::Transaction::Transaction(DatabaseManager& db) : db_(db), scope_(db) {
+    if (transaction_depth_ == 0) {
+        if (!db_.executeQuery("START TRANSACTION")) {
+            throw std::runtime_error("Could not start a transaction");
+        }
+        owner_ = true;
+        rollback_only_ = false;
     }
+    transaction_depth_++;
 }
 
-void DatabaseManager::registerConnection(MYSQL* conn) {
-    std::lock_guard<std::mutex> lock(connections_mutex_);
-    active_connections_[std::this_thread::get_id()] = conn;
+DatabaseManager::Transaction::~Transaction() {
+    if (!finished_) {
+        rollback();
+    }
+    transaction_depth_--;
 }
 
-void DatabaseManager::unregisterConnection(MYSQL* conn) {
-    std::lock_guard<std::mutex> lock(connections_mutex_);
-    auto thread_id = std::this_thread::get_id();
-    auto it = active_connections_.find(thread_id);
-    if (it != active_connections_.end() && it->second == conn) {
-        active_connections_.erase(it);
+bool DatabaseManager::Transaction::commit() {
+    if (finished_) {
+        return false;
+    }
+    if (!owner_) {
+        finished_ = true;
+        return !rollback_only_;
+    }
+    if (rollback_only_) {
+        rollback();
+        return false;
     }
+    finished_ = true;
+    if (!db_.executeQuery("COMMIT")) {
+        // The server ends a transaction whose COMMIT failed; roll back in case it did not
+        db_.executeQuery("ROLLBACK");
+        return false;
+    }
+    return true;
 }
 
-void DatabaseManager::cleanupThreadConnection() {
-    if (thread_connection_) {
-        unregisterConnection(thread_connection_);
-        mysql_close(thread_connection_);
-        thread_connection_ = nullptr;
+void DatabaseManager::Transaction::rollback() {
+    if (finished_) {
+        return;
+    }
+    finished_ = true;
+    if (owner_) {
+        db_.executeQuery("ROLLBACK");
+        rollback_only_ = false;
+    } else {
+        rollback_only_ = true;
     }
 }
 
 MYSQL* DatabaseManager::getConnection() {
-    ensureThreadConnection();
-    return thread_connection_;
+    if (!scoped_lease_) {
+        throw std::runtime_error("getConnection() called outside a DatabaseManager::ConnectionScope");
+    }
+    return scoped_lease_.get();
+}
+
+void DatabaseManager::markScopedConnectionBroken(unsigned int error_code) {
+    // Don't hand a dead connection to the next caller
+    if (error_code == CR_SERVER_GONE_ERROR || error_code == CR_SERVER_LOST) {
+        scoped_lease_.invalidate();
+    }
+}
+
+PoolMetrics DatabaseManager::poolMetrics() const {
+    return pool_ ? pool_->metrics() : PoolMetrics{};
+}
+
+size_t DatabaseManager::warmUpPool() {
+    return pool_ ? pool_->warmUp() : 0;
 }
 
 bool DatabaseManager::executeQuery(const std::string& query) {
     try {
-        ensureThreadConnection();
+        ConnectionScope scope(*this);
+        MYSQL* conn = scope.get();
         
-        if (logger_) {
-            std::ostringstream oss;
-            oss << std::this_thread::get_id();
-            logger_->debug("Executing query on thread {}: {}", oss.str(), query);
-        }
+        SPDLOG_LOGGER_DEBUG(logger_, "Executing query: {}", query);
         
-        if (mysql_query(thread_connection_, query.c_str())) {
-            unsigned int error_code = mysql_errno(thread_connection_);
-            const char* error_msg = mysql_error(thread_connection_);
-            const char* sqlstate = mysql_sqlstate(thread_connection_);
+        const auto started = std::chrono::steady_clock::now();
+        if (mysql_query(conn, query.c_str())) {
+            recordQuery(query, started, 0, 0, true);
+            unsigned int error_code = mysql_errno(conn);
+            const char* error_msg = mysql_error(conn);
+            const char* sqlstate = mysql_sqlstate(conn);
             
             if (logger_) {
-                std::ostringstream oss;
-                oss << std::this_thread::get_id();
-                logger_->error("Query failed on thread {}: {} - Error Code: {}, SQLSTATE: {}, Message: '{}'", 
-                             oss.str(), query, error_code, 
+                logger_->error("Query failed: {} - Error Code: {}, SQLSTATE: {}, Message: '{}'", 
+                             query, error_code, 
                              sqlstate ? sqlstate : "unknown", 
                              error_msg ? error_msg : "no error message");
             }
             
-            // If it's a connection error, force reconnection on next call
-            if (error_code == CR_SERVER_GONE_ERROR || error_code == CR_SERVER_LOST) {
-                cleanupThreadConnection();
-            }
-            
+            markScopedConnectionBroken(error_code);
             return false;
         }
+        const my_ulonglong affected = mysql_affected_rows(conn);
+        recordQuery(query, started, affected == static_cast<my_ulonglong>(-1) ? 0 : affected, 0, false);
         
-        if (logger_) {
-            std::ostringstream oss;
-            oss << std::this_thread::get_id();
-            logger_->debug("Query executed successfully on thread {}", oss.str());
-        }
+        SPDLOG_LOGGER_DEBUG(logger_, "Query executed successfully");
         return true;
         
     } catch (const std::exception& e) {
         if (logger_) {
-            std::ostringstream oss;
-            oss << std::this_thread::get_id();
-            logger_->error("Exception in executeQuery on thread {}: {}", oss.str(), e.what());
+            logger_->error("Exception in executeQuery: {}", e.what());
         }
         return false;
     }
 }
 
-MYSQL_RES* DatabaseManager::executeSelectQuery(const std::string& query) {
+MysqlResult DatabaseManager::executeSelectQuery(const std::string& query) {
     try {
-        ensureThreadConnection();
-        
-        if (logger_) {
-            std::ostringstream oss;
-            oss << std::this_thread::get_id();
-            logger_->info("=== EXECUTING SELECT QUERY ON THREAD {} ===", oss.str());
-            logger_->debug("Query: {}", query);
-            logger_->debug("Query length: {} characters", query.length());
-        }
-        
-        if (mysql_query(thread_connection_, query.c_str())) {
-            unsigned int error_code = mysql_errno(thread_connection_);
-            const char* error_msg = mysql_error(thread_connection_);
-            const char* sqlstate = mysql_sqlstate(thread_connection_);
+        // The result is fully buffered, so the connection can go back right after
+        ConnectionScope scope(*this);
+        MYSQL* conn = scope.get();
+        
+        SPDLOG_LOGGER_DEBUG(logger_, "Executing SELECT query ({} characters): {}", query.length(), query);
+        
+        const auto started = std::chrono::steady_clock::now();
+        if (mysql_query(conn, query.c_str())) {
+            recordQuery(query, started, 0, 0, true);
+            unsigned int error_code = mysql_errno(conn);
+            const char* error_msg = mysql_error(conn);
+            const char* sqlstate = mysql_sqlstate(conn);
             
             if (logger_) {
-                std::ostringstream oss;
-                oss << std::this_thread::get_id();
-                logger_->error("SELECT query failed on thread {}: {} - Error Code: {}, SQLSTATE: {}, Message: '{}'", 
-                             oss.str(), query, error_code, 
+                logger_->error("SELECT query failed: {} - Error Code: {}, SQLSTATE: {}, Message: '{}'", 
+                             query, error_code, 
                              sqlstate ? sqlstate : "unknown", 
                              error_msg ? error_msg : "no error message");
             }
             
-            // If it's a connection error, force reconnection on next call
-            if (error_code == CR_SERVER_GONE_ERROR || error_code == CR_SERVER_LOST) {
-                cleanupThreadConnection();
-            }
-            
+            markScopedConnectionBroken(error_code);
             return nullptr;
         }
         
-        if (logger_) {
-            std::ostringstream oss;
-            oss << std::this_thread::get_id();
-            logger_->debug("mysql_query executed successfully on thread {}", oss.str());
+        MysqlResult result(mysql_store_result(conn));
+        if (result) {
+            recordQuery(query, started, mysql_num_rows(result.get()), resultBytes(result.get()), false);
+        } else {
+            recordQuery(query, started, 0, 0, mysql_field_count(conn) > 0);
         }
-        
-        MYSQL_RES* result = mysql_store_result(thread_connection_);
         if (!result) {
             // Check if this was supposed to return a result set
-            if (mysql_field_count(thread_connection_) > 0) {
-                if (logger_) {
-                    std::ostringstream oss;
-                    oss << std::this_thread::get_id();
-                    logger_->error("Failed to store result for query on thread {}: {} - Error: '{}'", 
-                                 oss.str(), query, mysql_error(thread_connection_));
-                }
-                return nullptr;
-            } else {
-                // Query didn't return a result set (e.g., INSERT, UPDATE, DELETE)
+            if (mysql_field_count(conn) > 0) {
                 if (logger_) {
-                    std::ostringstream oss;
-                    oss << std::this_thread::get_id();
-                    logger_->debug("Query completed without result set on thread {} (non-SELECT query)", 
-                                 oss.str());
+                    logger_->error("Failed to store result for query: {} - Error: '{}'", 
+                                 query, mysql_error(conn));
                 }
+                markScopedConnectionBroken(mysql_errno(conn));
                 return nullptr;
             }
-        } else {
-            unsigned long num_rows = mysql_num_rows(result);
-            unsigned int num_fields = mysql_num_fields(result);
-            
+            // Query didn't return a result set (e.g., INSERT, UPDATE, DELETE)
+            SPDLOG_LOGGER_DEBUG(logger_, "Query completed without result set (non-SELECT query)");
+            return nullptr;
+        }
+        
+        SPDLOG_LOGGER_DEBUG(logger_, "Query returned {} rows, {} fields", mysql_num_rows(result.get()),
+                            mysql_num_fields(result.get()));
+        return result;
+        
+    } catch (const std::exception& e) {
+        if (logger_) {
+            logger_->error("Exception in executeSelectQuery: {}", e.what());
+        }
+        return nullptr;
+    }
+}
+
+bool DatabaseManager::streamSelectQuery(const std::string& query, const RowCallback& on_row) {
+    try {
+        ConnectionScope scope(*this);
+        MYSQL* conn = scope.get();
+        
+        SPDLOG_LOGGER_DEBUG(logger_, "Streaming query: {}", query);
+        
+        const auto started = std::chrono::steady_clock::now();
+        if (mysql_query(conn, query.c_str())) {
+            recordQuery(query, started, 0, 0, true);
+            unsigned int error_code = mysql_errno(conn);
             if (logger_) {
-                std::ostringstream oss;
-                oss << std::this_thread::get_id();
-                logger_->info("Query returned {} rows, {} fields on thread {}", 
-                            num_rows, num_fields, oss.str());
-                
-                if (num_rows == 0) {
-                    logger_->warn("WARNING: Query returned 0 rows on thread {}!", oss.str());
+                logger_->error("Streaming query failed: {} - Error Code: {}, Message: '{}'", 
+                             query, error_code, mysql_error(conn));
+            }
+            markScopedConnectionBroken(error_code);
+            return false;
+        }
+        
+        MysqlResult result(mysql_use_result(conn));
+        if (!result) {
+            if (mysql_field_count(conn) > 0) {
+                if (logger_) {
+                    logger_->error("Failed to start streaming result for query: {} - Error: '{}'", 
+                                 query, mysql_error(conn));
                 }
-                
-                // Log field names for debugging
-                MYSQL_FIELD* fields = mysql_fetch_fields(result);
-                if (fields) {
-                    logger_->debug("Field names on thread {}: ", oss.str());
-                    for (unsigned int i = 0; i < num_fields; i++) {
-                        logger_->debug("  {}: {}", i, fields[i].name ? fields[i].name : "NULL");
-                    }
+                markScopedConnectionBroken(mysql_errno(conn));
+                return false;
+            }
+            return true;
+        }
+        
+        size_t rows = 0;
+        uint64_t bytes = 0;
+        const unsigned int num_fields = mysql_num_fields(result.get());
+        try {
+            MYSQL_ROW row;
+            while ((row = mysql_fetch_row(result.get()))) {
+                rows++;
+                unsigned long* lengths = mysql_fetch_lengths(result.get());
+                for (unsigned int i = 0; i < num_fields; i++) bytes += lengths[i];
+                if (!on_row(row, lengths)) {
+                    break;
                 }
             }
+        } catch (...) {
+            // Frees (and drains) the result so the connection is reusable
+            result.reset();
+            recordQuery(query, started, rows, bytes, true);
+            throw;
         }
         
-        if (logger_) {
-            std::ostringstream oss;
-            oss << std::this_thread::get_id();
-            logger_->info("=== SELECT QUERY COMPLETED SUCCESSFULLY ON THREAD {} ===", oss.str());
+        // mysql_fetch_row also returns NULL when the stream breaks off
+        unsigned int error_code = mysql_errno(conn);
+        result.reset();
+        // Includes the time the callback spent on each row
+        recordQuery(query, started, rows, bytes, error_code != 0);
+        if (error_code != 0) {
+            if (logger_) {
+                logger_->error("Streaming query aborted after {} rows: {} - Error Code: {}, Message: '{}'", 
+                             rows, query, error_code, mysql_error(conn));
+            }
+            markScopedConnectionBroken(error_code);
+            return false;
         }
-        return result;
+        
+        SPDLOG_LOGGER_DEBUG(logger_, "Streamed {} rows", rows);
+        return true;
         
     } catch (const std::exception& e) {
         if (logger_) {
-            std::ostringstream oss;
-            oss << std::this_thread::get_id();
-            logger_->error("Exception in executeSelectQuery on thread {}: {}", oss.str(), e.what());
+            logger_->error("Exception in streamSelectQuery: {}", e.what());
         }
-        return nullptr;
+        return false;
     }
 }
 
-bool DatabaseManager::isConnected() {
+PreparedResult DatabaseManager::executePrepared(const std::string& sql, const std::vector<SqlParam>& params) {
+    ConnectionScope scope(*this);
+    ConnectionPool::Connection* connection = scope.connection();
+
+    const auto started = std::chrono::steady_clock::now();
     try {
-        if (!thread_connection_) {
-            return false;
+        PreparedResult result = connection->statement(sql).execute(params);
+        recordQuery(sql, started, result.rows.empty() ? result.affected_rows : result.rows.size(),
+                    resultBytes(result), false);
+        return result;
+    } catch (const SqlError& e) {
+        recordQuery(sql, started, 0, 0, true);
+        if (logger_) {
+            logger_->error("Prepared statement failed: {} - Error Code: {}, Message: '{}'", sql, e.code(), e.what());
         }
+        // A failed statement may be stale (schema change); re-prepare next time
+        connection->forgetStatement(sql);
+        markScopedConnectionBroken(e.code());
+        throw;
+    }
+}
+
+bool DatabaseManager::isConnected() {
+    try {
+        ConnectionScope scope(*this);
+        MYSQL* conn = scope.get();
         
         // Use ping to test connection
-        int ping_result = mysql_ping(thread_connection_);
+        int ping_result = mysql_ping(conn);
         if (ping_result != 0) {
-            if (logger_) {
-                unsigned int error_code = mysql_errno(thread_connection_);
-                std::ostringstream oss;
-                oss << std::this_thread::get_id();
-                logger_->debug("Connection ping failed on thread {} with error code: {}, message: '{}'", 
-                             oss.str(), error_code, mysql_error(thread_connection_));
-            }
+            SPDLOG_LOGGER_DEBUG(logger_, "Connection ping failed with error code: {}, message: '{}'", 
+                                mysql_errno(conn), mysql_error(conn));
+            scope.invalidate();
             return false;
         }
         
         return true;
     } catch (const std::exception& e) {
         if (logger_) {
-            std::ostringstream oss;
-            oss << std::this_thread::get_id();
-            logger_->error("Exception in isConnected on thread {}: {}", oss.str(), e.what());
+            logger_->error("Exception in isConnected: {}", e.what());
         }
         return false;
     }
@@ -374,13 +540,10 @@ bool DatabaseManager::isConnected() {
 
 void DatabaseManager::reconnect() {
     if (logger_) {
-        std::ostringstream oss;
-        oss << std::this_thread::get_id();
-        logger_->info("Reconnecting database on thread {}...", oss.str());
+        logger_->info("Reconnecting database: closing idle pooled connections...");
     }
     
-    cleanupThreadConnection();
-    ensureThreadConnection();
+    pool().closeIdle();
 }
 
 void DatabaseManager::cleanup() {
@@ -389,18 +552,11 @@ void DatabaseManager::cleanup() {
             logger_->info("Cleaning up DatabaseManager...");
         }
         
-        // Clean up thread-local connection
-        cleanupThreadConnection();
-        
-        // Clean up all tracked connections
-        {
-            std::lock_guard<std::mutex> lock(connections_mutex_);
-            for (auto& [thread_id, conn] : active_connections_) {
-                if (conn) {
-                    mysql_close(conn);
-                }
-            }
-            active_connections_.clear();
+        if (replicas_) {
+            replicas_->shutdown();
+        }
+        if (pool_) {
+            pool_->shutdown();
         }
         
         // Cleanup MySQL library
@@ -419,22 +575,69 @@ void DatabaseManager::cleanup() {
 
 #else
 
-mysqlx::Session& DatabaseManager::getSession() {
-    ensureConnected();
-    return *session_;
+DatabaseManager::SessionLease::SessionLease(DatabaseManager& db, mysqlx::Session session)
+    : db_(&db), session_(std::move(session)) {
+    db_->sessions_in_use_.fetch_add(1, std::memory_order_relaxed);
+}
+
+DatabaseManager::SessionLease::SessionLease(SessionLease&& other) noexcept
+    : db_(other.db_), session_(std::move(other.session_)) {
+    other.db_ = nullptr;
+    other.session_.reset();
+}
+
+mysqlx::Schema DatabaseManager::SessionLease::schema() {
+    return session_->getSchema(db_->database_name_);
 }
 
-mysqlx::Schema DatabaseManager::getSchema() {
+void DatabaseManager::SessionLease::release() {
+    if (!session_) return;
+    try {
+        session_->close();
+    } catch (const mysqlx::Error&) {
+        // A broken session is dropped by the client instead of reused
+    }
+    session_.reset();
+    db_->sessions_in_use_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+DatabaseManager::SessionLease DatabaseManager::acquireSession() {
     ensureConnected();
-    return session_->getSchema(database_name_);
+    const auto started = std::chrono::steady_clock::now();
+    try {
+        SessionLease lease(*this, client_->getSession());
+        const auto waited = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started).count());
+        acquisitions_.fetch_add(1, std::memory_order_relaxed);
+        total_wait_us_.fetch_add(waited, std::memory_order_relaxed);
+        uint64_t highest = max_wait_us_.load(std::memory_order_relaxed);
+        while (waited > highest && !max_wait_us_.compare_exchange_weak(highest, waited, std::memory_order_relaxed)) {
+        }
+        return lease;
+    } catch (const mysqlx::Error& err) {
+        timeouts_.fetch_add(1, std::memory_order_relaxed);
+        throw std::runtime_error(std::string("No database session available: ") + err.what());
+    }
+}
+
+PoolMetrics DatabaseManager::poolMetrics() const {
+    PoolMetrics metrics;
+    // The connector does not report its idle sessions
+    metrics.in_use = sessions_in_use_.load(std::memory_order_relaxed);
+    metrics.total = metrics.in_use;
+    metrics.acquisitions = acquisitions_.load(std::memory_order_relaxed);
+    metrics.timeouts = timeouts_.load(std::memory_order_relaxed);
+    metrics.total_wait_ms = static_cast<double>(total_wait_us_.load(std::memory_order_relaxed)) / 1000.0;
+    metrics.max_wait_ms = static_cast<double>(max_wait_us_.load(std::memory_order_relaxed)) / 1000.0;
+    return metrics;
 }
 
 bool DatabaseManager::isConnected() {
-    if (!session_) return false;
+    if (!client_) return false;
     try {
-        session_->sql("SELECT 1").execute();
+        acquireSession()->sql("SELECT 1").execute();
         return true;
-    } catch (const mysqlx::Error&) {
+    } catch (const std::exception&) {
         return false;
     }
 }
@@ -444,9 +647,9 @@ void DatabaseManager::reconnect() {
 }
 
 void DatabaseManager::cleanup() {
-    if (session_) {
-        session_->close();
-        session_.reset();
+    if (client_) {
+        client_->close();
+        client_.reset();
     }
 }
 
@@ -458,52 +661,96 @@ void DatabaseManager::ensureConnected() {
     }
 
 #ifdef USE_MYSQL_C_API
-    ensureThreadConnection();
+    pool();
 #else
-    if (!session_) {
-        throw std::runtime_error("Database session not available");
+    // Sessions are checked by the client when they are handed out
+    if (!client_) {
+        throw std::runtime_error("Database session pool not available");
     }
-    
-    try {
-        session_->sql("SELECT 1").execute();
-    } catch (const mysqlx::Error& err) {
-        if (logger_) {
-            logger_->warn("Database connection lost, attempting to reconnect...");
+#endif
+}
+
+#ifdef USE_MYSQL_C_API
+int DatabaseManager::storedProjectSequence(int year) {
+    MysqlResult result = executeSelectQuery(
+        "SELECT COALESCE(MAX(CAST(SUBSTRING_INDEX(project_code, '-', -1) AS UNSIGNED)), 0) "
+        "FROM projects WHERE project_code LIKE 'PROJ-" + std::to_string(year) + "-%'");
+    if (!result) {
+        throw std::runtime_error("Failed to read the highest project code");
+    }
+    int highest = 0;
+    MYSQL_ROW row = mysql_fetch_row(result.get());
+    if (row && row[0]) {
+        highest = std::atoi(row[0]);
+    }
+    return highest;
+}
+
+void DatabaseManager::reserveProjectCodes(int year) {
+    static std::once_flag once;
+    static bool has_table = false;
+    std::call_once(once, []() {
+        has_table = SchemaMigrations::hasTable("project_code_sequences");
+        spdlog::info("Project codes reserved {}", has_table ? "in blocks from project_code_sequences"
+                                                            : "by this process only");
+    });
+
+    // Without the table one scan per year seeds an in-process counter
+    if (!has_table) {
+        if (code_year_ != year) {
+            code_next_ = storedProjectSequence(year) + 1;
         }
-        throw std::runtime_error("Database connection lost");
+        code_year_ = year;
+        code_end_ = std::numeric_limits<int>::max();
+        return;
     }
-#endif
+
+    // A connection of its own, so the block commits even when the caller
+    // is inside a transaction that later rolls back. LAST_INSERT_ID(expr)
+    // hands the new end of the block back through mysql_insert_id, so the
+    // row is read and bumped in one statement.
+    auto lease = acquireConnection();
+    MYSQL* con = lease.get();
+    const std::string bump = "UPDATE project_code_sequences SET next_value = LAST_INSERT_ID(next_value + " +
+                             std::to_string(kProjectCodeBlock) + ") WHERE year = " + std::to_string(year);
+    if (mysql_query(con, bump.c_str()) != 0) {
+        throw std::runtime_error(std::string("Failed to reserve project codes: ") + mysql_error(con));
+    }
+    if (mysql_affected_rows(con) == 0) {
+        // First block of the year: start past codes created before the row
+        const std::string seed = "INSERT IGNORE INTO project_code_sequences (year, next_value) VALUES (" +
+                                 std::to_string(year) + ", " + std::to_string(storedProjectSequence(year) + 1) + ")";
+        if (mysql_query(con, seed.c_str()) != 0 || mysql_query(con, bump.c_str()) != 0 ||
+            mysql_affected_rows(con) == 0) {
+            throw std::runtime_error("Failed to start the project code sequence of " + std::to_string(year));
+        }
+    }
+    code_end_ = static_cast<int>(mysql_insert_id(con));
+    code_next_ = code_end_ - kProjectCodeBlock;
+    code_year_ = year;
 }
+#endif
 
 std::string DatabaseManager::generateProjectCode() {
     auto now = std::chrono::system_clock::now();
-    auto time_t = std::chrono::system_clock::to_time_t(now);
+    char today[kTimestampLength];
+    formatTimestamp(now, today);
+    int year = 0;
+    std::from_chars(today, today + 4, year);
     
     std::stringstream ss;
-    ss << "PROJ-" << std::put_time(std::localtime(&time_t), "%Y") << "-";
+    ss << "PROJ-" << year << "-";
     
     try {
 #ifdef USE_MYSQL_C_API
-        std::string query = 
-            "SELECT MAX(CAST(SUBSTRING(project_code, -3) AS UNSIGNED)) as max_seq "
-            "FROM projects WHERE project_code LIKE CONCAT('PROJ-', YEAR(NOW()), '-%')";
-        
-        MYSQL_RES* result = executeSelectQuery(query);
-        if (!result) {
-            throw std::runtime_error("Failed to execute query for project code generation");
-        }
-        
-        int next_seq = 1;
-        MYSQL_ROW row = mysql_fetch_row(result);
-        if (row && row[0]) {
-            next_seq = std::atoi(row[0]) + 1;
+        std::lock_guard<std::mutex> lock(code_mutex_);
+        if (code_year_ != year || code_next_ >= code_end_) {
+            reserveProjectCodes(year);
         }
-        
-        mysql_free_result(result);
-        ss << std::setfill('0') << std::setw(3) << next_seq;
+        ss << std::setfill('0') << std::setw(3) << code_next_++;
 #else
-        auto& session = getSession();
-        auto result = session.sql(
+        auto session = acquireSession();
+        auto result = session->sql(
             "SELECT MAX(CAST(SUBSTRING(project_code, -3) AS UNSIGNED)) as max_seq "
             "FROM projects WHERE project_code LIKE CONCAT('PROJ-', YEAR(NOW()), '-%')"
         ).execute();
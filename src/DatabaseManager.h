@@ -5,14 +5,22 @@
 #include <spdlog/spdlog.h>
 #include <thread>
 #include <mutex>
+#include <functional>
+#include <optional>
 #include <unordered_map>
+#include <vector>
 
 // Conditional includes based on available MySQL API
 #ifdef USE_MYSQL_C_API
     #include <mysql/mysql.h>
     #include <mysql/errmsg.h>
+    #include "ConnectionPool.h"
+    #include "MysqlResult.h"
+    #include "ReplicaRouter.h"
 #else
     #include <mysqlx/xdevapi.h>
+    #include <atomic>
+    #include "PoolSettings.h"
 #endif
 
 namespace aeronautical {
@@ -25,16 +33,146 @@ public:
     DatabaseManager(const DatabaseManager&) = delete;
     DatabaseManager& operator=(const DatabaseManager&) = delete;
     
-    void initialize(const std::string& host, int port, const std::string& user, 
-                   const std::string& password, const std::string& database);
-    
 #ifdef USE_MYSQL_C_API
+    void initialize(const std::string& host, int port, const std::string& user, 
+                   const std::string& password, const std::string& database,
+                   const PoolSettings& pool_settings = PoolSettings{});
+
+    // Pins one pooled connection to the current thread for the lifetime of
+    // the scope. Needed when several statements must share a connection
+    // (transactions, mysql_insert_id, escaping). Nested scopes reuse it.
+    class ConnectionScope {
+    public:
+        explicit ConnectionScope(DatabaseManager& db);
+        ~ConnectionScope();
+
+        ConnectionScope(const ConnectionScope&) = delete;
+        ConnectionScope& operator=(const ConnectionScope&) = delete;
+
+        MYSQL* get() const;
+        ConnectionPool::Connection* connection() const;
+        // Drop the connection instead of returning it to the pool
+        void invalidate();
+
+    private:
+        bool owner_ = false;
+    };
+
+    // Transaction on the pinned connection of this thread: START
+    // TRANSACTION on construction, ROLLBACK on destruction unless commit()
+    // succeeded. A Transaction opened while another is active on the
+    // thread joins it instead, so a repository write run inside a caller's
+    // transaction commits with it: the inner commit() only returns true,
+    // and an inner rollback makes the outer commit() roll back and fail.
+    // Throws when the transaction cannot be started.
+    class Transaction {
+    public:
+        explicit Transaction(DatabaseManager& db);
+        ~Transaction();
+
+        Transaction(const Transaction&) = delete;
+        Transaction& operator=(const Transaction&) = delete;
+
+        MYSQL* get() const { return scope_.get(); }
+        // false when COMMIT failed or a joined transaction rolled back
+        bool commit();
+        void rollback();
+
+    private:
+        DatabaseManager& db_;
+        ConnectionScope scope_;
+        bool owner_ = false;
+        bool finished_ = false;
+    };
+
+    // Marks the reads inside it as fine to serve from a replica. The
+    // connection it pins goes to a healthy replica when replicas are
+    // configured and the current request allows it (see
+    // setReplicaReadsAllowed), else to the primary; a connection already
+    // pinned on the thread, such as a Transaction's, is reused. Nothing
+    // inside may write.
+    class ReadScope {
+    public:
+        explicit ReadScope(DatabaseManager& db);
+        ~ReadScope();
+
+        ReadScope(const ReadScope&) = delete;
+        ReadScope& operator=(const ReadScope&) = delete;
+
+        MYSQL* get() const { return scope_->get(); }
+
+    private:
+        std::optional<ConnectionScope> scope_;
+    };
+
+    // Starts routing ReadScope reads to the replicas; call after initialize
+    void enableReplicas(const ReplicaSettings& settings);
+    bool hasReplicas() const { return replicas_ != nullptr; }
+    // Nullptr without replicas
+    ReplicaRouter* replicas() { return replicas_.get(); }
+    // Whether ReadScopes on this thread may use a replica; off unless the
+    // HTTP layer turns it on for a request (ReadRouting), so background
+    // jobs always read what they or a request just wrote
+    static void setReplicaReadsAllowed(bool allowed);
+    static bool replicaReadsAllowed();
+
+    ConnectionPool::Lease acquireConnection();
+    // Replica lease for a ReadScope when allowed and one is healthy, else primary
+    ConnectionPool::Lease acquireReadConnection();
+    // Connection of the innermost ConnectionScope on this thread; throws without one
     MYSQL* getConnection();
     bool executeQuery(const std::string& query);
-    MYSQL_RES* executeSelectQuery(const std::string& query);
+    // Buffered result set; nullptr on failure or for a statement without one
+    MysqlResult executeSelectQuery(const std::string& query);
+
+    // Runs query with mysql_use_result and hands each row to on_row as it
+    // comes off the socket, so nothing is buffered client-side. on_row
+    // returns false to stop early. The connection stays leased until the
+    // stream ends, so keep the callback cheap and never query from it.
+    using RowCallback = std::function<bool(MYSQL_ROW row, unsigned long* lengths)>;
+    bool streamSelectQuery(const std::string& query, const RowCallback& on_row);
+
+    // Runs sql as a server-side prepared statement cached on the connection.
+    // Use '?' placeholders for params; throws SqlError on failure.
+    PreparedResult executePrepared(const std::string& sql, const std::vector<SqlParam>& params = {});
+
+    PoolMetrics poolMetrics() const;
+    // Opens the pool's min_idle connections ahead of the first requests
+    size_t warmUpPool();
 #else
-    mysqlx::Session& getSession();
-    mysqlx::Schema getSchema();
+    void initialize(const std::string& host, int port, const std::string& user, 
+                   const std::string& password, const std::string& database,
+                   const PoolSettings& pool_settings = PoolSettings{});
+
+    // Exclusive use of one session from the mysqlx::Client pool; closing
+    // it on destruction hands it back, and the client resets it before
+    // the next checkout. Mirrors ConnectionPool::Lease of the C API build.
+    class SessionLease {
+    public:
+        SessionLease(DatabaseManager& db, mysqlx::Session session);
+        ~SessionLease() { release(); }
+
+        SessionLease(SessionLease&& other) noexcept;
+        SessionLease& operator=(SessionLease&&) = delete;
+        SessionLease(const SessionLease&) = delete;
+        SessionLease& operator=(const SessionLease&) = delete;
+
+        mysqlx::Session& get() { return *session_; }
+        mysqlx::Session* operator->() { return &*session_; }
+        mysqlx::Schema schema();
+        explicit operator bool() const { return session_.has_value(); }
+
+        void release();
+
+    private:
+        DatabaseManager* db_ = nullptr;
+        std::optional<mysqlx::Session> session_;
+    };
+
+    // Blocks up to acquire_timeout for a free session; throws std::runtime_error on timeout
+    SessionLease acquireSession();
+
+    PoolMetrics poolMetrics() const;
 #endif
     
     // Generate unique project code
@@ -52,28 +190,52 @@ private:
     ~DatabaseManager();
 
 #ifdef USE_MYSQL_C_API
-    // Thread-local connection management
-    static thread_local MYSQL* thread_connection_;
-    static std::mutex connections_mutex_;
-    static std::unordered_map<std::thread::id, MYSQL*> active_connections_;
-    
-    // Connection parameters
-    std::string host_;
-    int port_;
+    // Lease held by the outermost ConnectionScope on this thread
+    static thread_local ConnectionPool::Lease scoped_lease_;
+    static thread_local int scope_depth_;
+    static thread_local int read_depth_;
+    static thread_local bool replica_reads_allowed_;
+    // Open Transaction objects on this thread, and whether one rolled back
+    static thread_local int transaction_depth_;
+    static thread_local bool rollback_only_;
+
+    std::unique_ptr<ConnectionPool> pool_;
+    std::unique_ptr<ReplicaRouter> replicas_;
+    // Credentials and pool settings the replica pools reuse
     std::string user_;
     std::string password_;
+    PoolSettings pool_settings_;
     std::string database_name_;
-    
-    // Thread-safe connection methods
-    void ensureThreadConnection();
-    MYSQL* createNewConnection();
-    void cleanupThreadConnection();
-    void registerConnection(MYSQL* conn);
-    void unregisterConnection(MYSQL* conn);
-    
+
+    ConnectionPool& pool();
+    void markScopedConnectionBroken(unsigned int error_code);
+
+    // Project code numbers handed out from a block reserved per year: with
+    // a project_code_sequences table (year primary key, next_value) each
+    // block is claimed by one UPDATE, so processes never share a number;
+    // without it this process counts on from the highest stored code.
+    // Numbers of a block left unused at shutdown are skipped.
+    static constexpr int kProjectCodeBlock = 50;
+    std::mutex code_mutex_;
+    int code_year_ = 0;
+    int code_next_ = 0;
+    int code_end_ = 0; // exclusive
+    // Refills the block for year; caller holds code_mutex_. Throws on failure
+    void reserveProjectCodes(int year);
+    // Highest number of a stored PROJ-<year>-n code, 0 without one
+    int storedProjectSequence(int year);
+
 #else
-    std::unique_ptr<mysqlx::Session> session_;
+    // Pooling client; sessions are opened on demand up to max_size and the
+    // ones idle longer than max_lifetime are closed by the connector
+    std::unique_ptr<mysqlx::Client> client_;
     std::string database_name_;
+    PoolSettings pool_settings_;
+    std::atomic<size_t> sessions_in_use_{0};
+    std::atomic<uint64_t> acquisitions_{0};
+    std::atomic<uint64_t> timeouts_{0};
+    std::atomic<uint64_t> total_wait_us_{0};
+    std::atomic<uint64_t> max_wait_us_{0};
 #endif
     
     std::shared_ptr<spdlog::logger> logger_;
@@ -0,0 +1,211 @@
+#include "DbExecutor.h"
+#include "DatabaseManager.h"
+#include "RequestAccounting.h"
+#include "Tracing.h"
+#include <spdlog/spdlog.h>
+
+namespace aeronautical {
+
+namespace {
+
+// Set while parallel() runs a task; respond() then stays on the thread
+thread_local bool respond_inline = false;
+// Share key of the next respond() on this thread
+thread_local std::string next_share_key;
+
+crow::response run(const std::function<crow::response()>& work) {
+    try {
+        return work();
+    } catch (const std::exception& e) {
+        spdlog::error("Database request failed: {}", e.what());
+        crow::response res(500, "{\"error\":true,\"message\":\"Internal server error\"}");
+        res.add_header("Content-Type", "application/json");
+        return res;
+    }
+}
+
+} // namespace
+
+DbExecutor& DbExecutor::getInstance() {
+    static DbExecutor instance;
+    return instance;
+}
+
+void DbExecutor::start(size_t threads, size_t max_pending, CpuSet cpus) {
+    if (pool_) {
+        return;
+    }
+    max_pending_ = std::max<size_t>(1, max_pending);
+    pool_ = std::make_unique<ThreadPool>(std::max<size_t>(1, threads), "db-io", std::move(cpus));
+    spdlog::info("Database requests run on {} threads ({} may wait)", pool_->size(), max_pending_);
+}
+
+void DbExecutor::shutdown() {
+    pool_.reset();
+}
+
+void DbExecutor::shareNext(std::string key) {
+    next_share_key = std::move(key);
+}
+
+void DbExecutor::respond(const crow::request& req, crow::response& res, std::function<crow::response()> work) {
+    std::string share_key = std::move(next_share_key);
+    next_share_key.clear();
+    if (!pool_ || respond_inline) {
+        res = run(work);
+        res.end();
+        return;
+    }
+    if (pending_.fetch_add(1, std::memory_order_relaxed) >= max_pending_) {
+        pending_.fetch_sub(1, std::memory_order_relaxed);
+        rejected_.fetch_add(1, std::memory_order_relaxed);
+        res = crow::response(503, "{\"error\":true,\"message\":\"Database busy, please retry later\"}");
+        res.add_header("Content-Type", "application/json");
+        res.add_header("Retry-After", "1");
+        res.end();
+        return;
+    }
+    if (!share_key.empty()) {
+        std::lock_guard<std::mutex> lock(flights_mutex_);
+        auto [flight, leader] = flights_.try_emplace(share_key);
+        if (!leader) {
+            flight->second.push_back(Waiter{&res, req.io_context, RequestAccounting::end()});
+            pending_.fetch_sub(1, std::memory_order_relaxed);
+            shared_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+
+    // The routing decision ReadRouting made on this thread goes along, as do the trace
+    // and the request's accounting
+    const bool replica_reads = DatabaseManager::replicaReadsAllowed();
+    const TraceContext trace = Tracer::current();
+    std::shared_ptr<RequestAccounting::Tally> tally = RequestAccounting::end();
+    const auto queued_at = std::chrono::steady_clock::now();
+    asio::io_context* io_context = req.io_context;
+    pool_->post([this, io_context, &res, replica_reads, trace, tally = std::move(tally), queued_at,
+                 share_key = std::move(share_key), work = std::move(work)]() {
+        DatabaseManager::setReplicaReadsAllowed(replica_reads);
+        TraceScope trace_scope(trace);
+        std::shared_ptr<crow::response> out;
+        {
+            // Closed before the response goes back, so after_handle reads the whole tally
+            RequestAccounting::Scope accounting(tally);
+            Span span("handler");
+            span.setAttribute("queue_wait_us", static_cast<int64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                                                   std::chrono::steady_clock::now() - queued_at).count()));
+            out = std::make_shared<crow::response>(run(work));
+            if (out->code >= 500) span.setError("HTTP " + std::to_string(out->code));
+        }
+        DatabaseManager::setReplicaReadsAllowed(false);
+        pending_.fetch_sub(1, std::memory_order_relaxed);
+        completed_.fetch_add(1, std::memory_order_relaxed);
+
+        if (!share_key.empty()) {
+            std::vector<Waiter> waiters;
+            {
+                std::lock_guard<std::mutex> lock(flights_mutex_);
+                auto flight = flights_.find(share_key);
+                waiters = std::move(flight->second);
+                flights_.erase(flight);
+            }
+            // crow::response cannot be copied, so each waiter gets its own
+            for (const Waiter& waiter : waiters) {
+                auto copy = std::make_shared<crow::response>(out->code, out->body);
+                copy->headers = out->headers;
+                asio::post(*waiter.io_context, [res = waiter.res, copy, tally = waiter.tally]() {
+                    RequestAccounting::begin(tally);
+                    *res = std::move(*copy);
+                    res->end();
+                    RequestAccounting::end(tally.get());
+                });
+            }
+        }
+
+        // Written and finished on the connection's thread, like a synchronous handler;
+        // the encoding middlewares running there are charged to the request too
+        asio::post(*io_context, [&res, out, tally]() {
+            RequestAccounting::begin(tally);
+            res = std::move(*out);
+            res.end();
+            RequestAccounting::end(tally.get());
+        });
+    });
+}
+
+bool DbExecutor::post(std::function<void()> work) {
+    // A parallel() task waiting for work queued behind it could hold the last free thread
+    if (!pool_ || respond_inline) {
+        work();
+        return true;
+    }
+    if (pending_.fetch_add(1, std::memory_order_relaxed) >= max_pending_) {
+        pending_.fetch_sub(1, std::memory_order_relaxed);
+        rejected_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    const bool replica_reads = DatabaseManager::replicaReadsAllowed();
+    const TraceContext trace = Tracer::current();
+    pool_->post([this, replica_reads, trace, tally = RequestAccounting::current(), work = std::move(work)]() {
+        DatabaseManager::setReplicaReadsAllowed(replica_reads);
+        {
+            TraceScope trace_scope(trace);
+            RequestAccounting::Scope accounting(tally);
+            work();
+        }
+        DatabaseManager::setReplicaReadsAllowed(false);
+        pending_.fetch_sub(1, std::memory_order_relaxed);
+        completed_.fetch_add(1, std::memory_order_relaxed);
+    });
+    return true;
+}
+
+void DbExecutor::parallel(size_t count, const std::function<void(size_t)>& fn) {
+    const bool replica_reads = DatabaseManager::replicaReadsAllowed();
+    const TraceContext trace = Tracer::current();
+    const std::shared_ptr<RequestAccounting::Tally> tally = RequestAccounting::current();
+    auto task = [&](size_t i) {
+        const bool was_inline = respond_inline;
+        const bool was_replica = DatabaseManager::replicaReadsAllowed();
+        respond_inline = true;
+        DatabaseManager::setReplicaReadsAllowed(replica_reads);
+        TraceScope trace_scope(trace);
+        RequestAccounting::Scope accounting(tally);
+        try {
+            fn(i);
+        } catch (...) {
+            respond_inline = was_inline;
+            DatabaseManager::setReplicaReadsAllowed(was_replica);
+            throw;
+        }
+        respond_inline = was_inline;
+        DatabaseManager::setReplicaReadsAllowed(was_replica);
+    };
+    if (!pool_) {
+        for (size_t i = 0; i < count; i++) task(i);
+        return;
+    }
+    pool_->parallelFor(count, task);
+}
+
+bool DbExecutor::respondsInline() {
+    return respond_inline;
+}
+
+nlohmann::json DbExecutor::stats() const {
+    nlohmann::json j;
+    j["threads"] = pool_ ? pool_->size() : 0;
+    if (pool_) {
+        const ThreadPool::Stats pool = pool_->stats();
+        j["busy"] = pool.busy;
+        j["queued"] = pool.queued;
+    }
+    j["pending"] = pending_.load(std::memory_order_relaxed);
+    j["max_pending"] = max_pending_;
+    j["completed"] = completed_.load(std::memory_order_relaxed);
+    j["rejected"] = rejected_.load(std::memory_order_relaxed);
+    j["shared"] = shared_.load(std::memory_order_relaxed);
+    return j;
+}
+
+} // namespace aeronautical
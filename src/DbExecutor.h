@@ -0,0 +1,86 @@
+#pragma once
+
+#include "RequestAccounting.h"
+#include "ThreadPool.h"
+#include <crow.h>
+#include <json.hpp>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace aeronautical {
+
+// Threads of their own for the blocking MySQL work of HTTP handlers. A
+// handler taking crow::response& passes its work to respond() and
+// returns at once; the Crow worker goes back to serving other requests
+// (cached responses, health checks) while a DB thread runs the queries,
+// and the finished response is handed back to the connection's own
+// thread to be written. Past max_pending queued requests respond()
+// answers 503 straight away instead of queueing more. A request may be
+// marked as sharable (see shareNext()): while an identical one is still
+// running, it waits for that one's response instead of running again.
+class DbExecutor {
+public:
+    static DbExecutor& getInstance();
+
+    DbExecutor(const DbExecutor&) = delete;
+    DbExecutor& operator=(const DbExecutor&) = delete;
+
+    // Until started, respond() runs the work on the calling thread
+    void start(size_t threads, size_t max_pending, CpuSet cpus = {});
+    void shutdown();
+
+    // Runs work on a DB thread and ends res with what it returns. req and
+    // res stay valid until then: the connection holds them until res.end().
+    // The request's RequestAccounting segment follows the work there.
+    void respond(const crow::request& req, crow::response& res, std::function<crow::response()> work);
+
+    // Runs work on a DB thread with this thread's trace and replica routing
+    // and counts it as pending like respond(); false, without running it,
+    // past max_pending. Until started, or inside parallel(), work runs on
+    // the calling thread. work must not throw.
+    bool post(std::function<void()> work);
+
+    // Runs fn(i) for every i in [0, count) across the DB threads, the caller
+    // taking part, with its trace and replica routing. respond() called
+    // inside fn runs the work right there, so a handler dispatched from fn
+    // has its response complete when fn returns.
+    void parallel(size_t count, const std::function<void(size_t)>& fn);
+    // Whether this thread runs a parallel() task, where handlers must have
+    // their response complete before they return
+    static bool respondsInline();
+
+    // Key under which the next respond() on this thread may share the
+    // response of a running identical request; empty to share nothing.
+    // Set by ResponseCache for every request it sees.
+    static void shareNext(std::string key);
+
+    nlohmann::json stats() const;
+
+private:
+    DbExecutor() = default;
+
+    // A request waiting for another's response
+    struct Waiter {
+        crow::response* res;
+        asio::io_context* io_context;
+        std::shared_ptr<RequestAccounting::Tally> tally;
+    };
+
+    std::unique_ptr<ThreadPool> pool_;
+    size_t max_pending_ = 0;
+    std::atomic<size_t> pending_{0};
+    std::atomic<uint64_t> completed_{0};
+    std::atomic<uint64_t> rejected_{0};
+    std::atomic<uint64_t> shared_{0};
+
+    std::mutex flights_mutex_;
+    std::unordered_map<std::string, std::vector<Waiter>> flights_; // by share key, while its leader runs
+};
+
+} // namespace aeronautical
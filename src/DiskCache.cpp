@@ -0,0 +1,326 @@
+#include "DiskCache.h"
+#include <openssl/evp.h>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <vector>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace aeronautical {
+
+namespace {
+
+constexpr char kMagic[4] = {'A', 'E', 'D', 'C'};
+constexpr size_t kHeaderBytes = sizeof(kMagic) + sizeof(uint32_t);
+
+std::string sha256(std::string_view data) {
+    std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> ctx(EVP_MD_CTX_new(), EVP_MD_CTX_free);
+    EVP_DigestInit_ex(ctx.get(), EVP_sha256(), nullptr);
+    EVP_DigestUpdate(ctx.get(), data.data(), data.size());
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int length = 0;
+    EVP_DigestFinal_ex(ctx.get(), digest, &length);
+    static const char* hex = "0123456789abcdef";
+    std::string out;
+    out.reserve(length * 2);
+    for (unsigned int i = 0; i < length; i++) {
+        out += hex[digest[i] >> 4];
+        out += hex[digest[i] & 0xF];
+    }
+    return out;
+}
+
+struct Fd {
+    int fd = -1;
+    ~Fd() {
+        if (fd >= 0) ::close(fd);
+    }
+};
+
+bool preadAll(int fd, char* into, size_t bytes, off_t offset) {
+    while (bytes > 0) {
+        ssize_t n = ::pread(fd, into, bytes, offset);
+        if (n <= 0) return false;
+        into += n;
+        bytes -= static_cast<size_t>(n);
+        offset += n;
+    }
+    return true;
+}
+
+bool writeAll(int fd, const char* from, size_t bytes) {
+    while (bytes > 0) {
+        ssize_t n = ::write(fd, from, bytes);
+        if (n <= 0) return false;
+        from += n;
+        bytes -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool isHash(const std::string& text, size_t length) {
+    return text.size() == length &&
+           std::all_of(text.begin(), text.end(), [](char c) { return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'); });
+}
+
+} // namespace
+
+DiskCache& DiskCache::getInstance() {
+    static DiskCache instance;
+    return instance;
+}
+
+void DiskCache::configure(const DiskCacheSettings& settings) {
+    namespace fs = std::filesystem;
+    std::lock_guard<std::mutex> lock(mutex_);
+    settings_ = settings;
+    if (settings_.directory.empty()) {
+        settings_.directory = (fs::temp_directory_path() / "aero-cache").string();
+    }
+    index_.clear();
+    lru_.clear();
+    bytes_ = 0;
+    if (!settings_.enabled) {
+        enabled_.store(false, std::memory_order_release);
+        spdlog::info("Disk cache disabled");
+        return;
+    }
+
+    const auto started = std::chrono::steady_clock::now();
+    std::error_code ec;
+    const fs::path root(settings_.directory);
+    fs::create_directories(root, ec);
+
+    // A directory the cache did not create may hold anything, so it is left alone
+    const fs::path version_file = root / "VERSION";
+    if (!fs::exists(version_file, ec) && !ec && !fs::is_empty(root, ec) && !ec) {
+        spdlog::error("Disk cache directory {} is not empty and has no VERSION file; disk cache disabled",
+                      settings_.directory);
+        enabled_.store(false, std::memory_order_release);
+        return;
+    }
+    // Entries of another layout are not read, only removed: the shards, tmp/ and VERSION
+    int version = 0;
+    {
+        std::ifstream in(version_file);
+        in >> version;
+    }
+    if (version != kLayoutVersion) {
+        for (const auto& entry : fs::directory_iterator(root, ec)) {
+            const std::string name = entry.path().filename().string();
+            if (name == "tmp" || name == "VERSION" || (entry.is_directory(ec) && isHash(name, 2))) {
+                fs::remove_all(entry.path(), ec);
+            }
+        }
+        std::ofstream(version_file) << kLayoutVersion << "\n";
+    }
+    fs::remove_all(root / "tmp", ec);
+    fs::create_directories(root / "tmp", ec);
+    if (ec) {
+        spdlog::error("Disk cache directory {} is not usable: {}", settings_.directory, ec.message());
+        enabled_.store(false, std::memory_order_release);
+        return;
+    }
+
+    struct Found {
+        fs::file_time_type mtime;
+        std::string hash;
+        uint64_t bytes;
+    };
+    std::vector<Found> found;
+    for (const auto& shard : fs::directory_iterator(root, ec)) {
+        const std::string prefix = shard.path().filename().string();
+        if (!shard.is_directory(ec) || !isHash(prefix, 2)) continue;
+        for (const auto& file : fs::directory_iterator(shard.path(), ec)) {
+            const std::string rest = file.path().filename().string();
+            if (!file.is_regular_file(ec) || !isHash(rest, 62)) continue;
+            found.push_back({file.last_write_time(ec), prefix + rest, static_cast<uint64_t>(file.file_size(ec))});
+        }
+    }
+    std::sort(found.begin(), found.end(), [](const Found& a, const Found& b) { return a.mtime > b.mtime; });
+    for (const auto& entry : found) {
+        lru_.push_back(entry.hash);
+        index_[entry.hash] = Entry{entry.bytes, std::prev(lru_.end())};
+        bytes_ += entry.bytes;
+    }
+    evict();
+    enabled_.store(true, std::memory_order_release);
+
+    const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - started;
+    spdlog::info("Disk cache in {}: {} entries, {} of {} MB, indexed in {:.0f} ms", settings_.directory,
+                 index_.size(), bytes_ >> 20, settings_.max_bytes >> 20, elapsed.count());
+}
+
+std::string DiskCache::pathOf(const std::string& hash) const {
+    return settings_.directory + "/" + hash.substr(0, 2) + "/" + hash.substr(2);
+}
+
+std::optional<std::string> DiskCache::get(std::string_view key) {
+    if (!enabled()) return std::nullopt;
+    const std::string hash = sha256(key);
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!index_.count(hash)) {
+            misses_.fetch_add(1, std::memory_order_relaxed);
+            return std::nullopt;
+        }
+        path = pathOf(hash);
+    }
+
+    Fd file;
+    file.fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st {};
+    char header[kHeaderBytes];
+    uint32_t key_bytes = 0;
+    bool ok = file.fd >= 0 && ::fstat(file.fd, &st) == 0 && static_cast<size_t>(st.st_size) >= kHeaderBytes &&
+              preadAll(file.fd, header, kHeaderBytes, 0) && std::memcmp(header, kMagic, sizeof(kMagic)) == 0;
+    if (ok) {
+        std::memcpy(&key_bytes, header + sizeof(kMagic), sizeof(key_bytes));
+        ok = key_bytes == key.size() && static_cast<size_t>(st.st_size) >= kHeaderBytes + key_bytes;
+    }
+    std::string value;
+    if (ok) {
+        // The stored key guards against a truncated or foreign file
+        std::string stored(key_bytes, '\0');
+        ok = preadAll(file.fd, stored.data(), key_bytes, kHeaderBytes) && stored == key;
+    }
+    if (ok) {
+        value.resize(static_cast<size_t>(st.st_size) - kHeaderBytes - key_bytes);
+        ok = preadAll(file.fd, value.data(), value.size(), static_cast<off_t>(kHeaderBytes + key_bytes));
+    }
+    if (!ok) {
+        errors_.fetch_add(1, std::memory_order_relaxed);
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        forget(hash);
+        return std::nullopt;
+    }
+    // Recency survives a restart through the mtime
+    ::futimens(file.fd, nullptr);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (index_.count(hash)) touch(hash, static_cast<uint64_t>(st.st_size));
+    }
+    hits_.fetch_add(1, std::memory_order_relaxed);
+    return value;
+}
+
+void DiskCache::put(std::string_view key, std::string_view value) {
+    if (!enabled()) return;
+    static std::atomic<uint64_t> temp_counter{0};
+    const std::string hash = sha256(key);
+    std::string path;
+    std::string temp;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        path = pathOf(hash);
+        temp = settings_.directory + "/tmp/" + hash + "." + std::to_string(temp_counter.fetch_add(1));
+    }
+
+    char header[kHeaderBytes];
+    std::memcpy(header, kMagic, sizeof(kMagic));
+    const uint32_t key_bytes = static_cast<uint32_t>(key.size());
+    std::memcpy(header + sizeof(kMagic), &key_bytes, sizeof(key_bytes));
+
+    bool ok = false;
+    {
+        Fd file;
+        file.fd = ::open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        ok = file.fd >= 0 && writeAll(file.fd, header, kHeaderBytes) && writeAll(file.fd, key.data(), key.size()) &&
+             writeAll(file.fd, value.data(), value.size());
+    }
+    if (ok) {
+        std::error_code ec;
+        std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
+        ok = ::rename(temp.c_str(), path.c_str()) == 0;
+    }
+    if (!ok) {
+        ::unlink(temp.c_str());
+        if (errors_.fetch_add(1, std::memory_order_relaxed) == 0) {
+            spdlog::warn("Disk cache: writing {} failed: {}", path, std::strerror(errno));
+        }
+        return;
+    }
+    writes_.fetch_add(1, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    touch(hash, kHeaderBytes + key.size() + value.size());
+    evict();
+}
+
+void DiskCache::remove(std::string_view key) {
+    if (!enabled()) return;
+    forget(sha256(key));
+}
+
+void DiskCache::touch(const std::string& hash, uint64_t bytes) {
+    auto it = index_.find(hash);
+    if (it != index_.end()) {
+        bytes_ -= it->second.bytes;
+        it->second.bytes = bytes;
+        lru_.splice(lru_.begin(), lru_, it->second.position);
+    } else {
+        lru_.push_front(hash);
+        index_[hash] = Entry{bytes, lru_.begin()};
+    }
+    bytes_ += bytes;
+}
+
+void DiskCache::evict() {
+    while (bytes_ > settings_.max_bytes && !lru_.empty()) {
+        const std::string& hash = lru_.back();
+        ::unlink(pathOf(hash).c_str());
+        auto it = index_.find(hash);
+        bytes_ -= it->second.bytes;
+        index_.erase(it);
+        lru_.pop_back();
+        evictions_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void DiskCache::forget(const std::string& hash) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ::unlink(pathOf(hash).c_str());
+    auto it = index_.find(hash);
+    if (it == index_.end()) return;
+    bytes_ -= it->second.bytes;
+    lru_.erase(it->second.position);
+    index_.erase(it);
+}
+
+nlohmann::json DiskCache::stats() const {
+    nlohmann::json j;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        j["enabled"] = enabled();
+        j["directory"] = settings_.directory;
+        j["entries"] = index_.size();
+        j["bytes"] = bytes_;
+        j["max_bytes"] = settings_.max_bytes;
+    }
+    j["hits"] = hits_.load(std::memory_order_relaxed);
+    j["misses"] = misses_.load(std::memory_order_relaxed);
+    j["writes"] = writes_.load(std::memory_order_relaxed);
+    j["evicted"] = evictions_.load(std::memory_order_relaxed);
+    j["errors"] = errors_.load(std::memory_order_relaxed);
+    return j;
+}
+
+void DiskCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& hash : lru_) {
+        ::unlink(pathOf(hash).c_str());
+    }
+    index_.clear();
+    lru_.clear();
+    bytes_ = 0;
+}
+
+} // namespace aeronautical
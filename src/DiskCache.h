@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <json.hpp>
+
+namespace aeronautical {
+
+struct DiskCacheSettings {
+    bool enabled = false;
+    std::string directory;            // empty: <temp>/aero-cache
+    uint64_t max_bytes = 1ull << 30;  // file bytes kept before the least recent are removed
+};
+
+// Second-level cache on disk behind the in-memory ones, so a restart or
+// deploy does not start from cold: encoded vector tiles (VectorTileService)
+// and simplified procedure geometries (SimplifiedGeometryCache).
+//
+// Content-addressed: an entry is the file <dir>/<h[0..2]>/<h[2..]> where h
+// is the SHA-256 of its key, holding the key and the value. Keys carry the
+// version of the data they were built from (snapshot version, procedure
+// updated_at), so a change simply stops matching the old entries and
+// leaves them to eviction. Values are written to a temporary file and
+// renamed into place; a hit is read with pread(2) into the result and its
+// mtime bumped, which is the recency order rebuilt from the directory at
+// startup. Past max_bytes the least recently used files are removed.
+class DiskCache {
+public:
+    static DiskCache& getInstance();
+
+    DiskCache(const DiskCache&) = delete;
+    DiskCache& operator=(const DiskCache&) = delete;
+
+    // Creates the directory and indexes the entries already in it; a
+    // directory written by another layout version is emptied first
+    void configure(const DiskCacheSettings& settings);
+    bool enabled() const { return enabled_.load(std::memory_order_acquire); }
+
+    std::optional<std::string> get(std::string_view key);
+    void put(std::string_view key, std::string_view value);
+    void remove(std::string_view key);
+
+    // Entries, bytes and the hit, miss, write and eviction counts
+    nlohmann::json stats() const;
+    // Removes every entry
+    void clear();
+
+private:
+    struct Entry {
+        uint64_t bytes = 0;
+        std::list<std::string>::iterator position; // in lru_
+    };
+
+    DiskCache() = default;
+
+    std::string pathOf(const std::string& hash) const;
+    // Marks hash most recent; caller holds mutex_
+    void touch(const std::string& hash, uint64_t bytes);
+    // Unlinks the least recent files past max_bytes; caller holds mutex_
+    void evict();
+    void forget(const std::string& hash);
+
+    static constexpr int kLayoutVersion = 1;
+
+    DiskCacheSettings settings_;
+    std::atomic<bool> enabled_{false};
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Entry> index_;
+    std::list<std::string> lru_; // hashes, most recent first
+    uint64_t bytes_ = 0;
+
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+    std::atomic<uint64_t> writes_{0};
+    std::atomic<uint64_t> evictions_{0};
+    std::atomic<uint64_t> errors_{0};
+};
+
+} // namespace aeronautical
@@ -0,0 +1,708 @@
+#include "DocumentPipeline.h"
+#include "FlightProcedure.h"
+#include "GdalDrivers.h"
+#include "gdal.h"
+#include "cpl_conv.h"
+#include "cpl_vsi.h"
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <regex>
+#include <sstream>
+#include <stdexcept>
+#ifdef HAVE_TESSERACT
+#include <tesseract/capi.h>
+#endif
+
+namespace aeronautical {
+
+namespace {
+
+// Raised for uploads that are not a readable image (the job fails, not the server)
+struct DocumentError : std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+std::string sha256(const std::string& data) {
+    std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> ctx(EVP_MD_CTX_new(), EVP_MD_CTX_free);
+    EVP_DigestInit_ex(ctx.get(), EVP_sha256(), nullptr);
+    EVP_DigestUpdate(ctx.get(), data.data(), data.size());
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int length = 0;
+    EVP_DigestFinal_ex(ctx.get(), digest, &length);
+    static const char* hex = "0123456789abcdef";
+    std::string out;
+    out.reserve(length * 2);
+    for (unsigned int i = 0; i < length; ++i) {
+        out.push_back(hex[digest[i] >> 4]);
+        out.push_back(hex[digest[i] & 0xf]);
+    }
+    return out;
+}
+
+// 128 random bits as hex, for upload session ids
+std::string randomId() {
+    unsigned char bytes[16];
+    if (RAND_bytes(bytes, sizeof(bytes)) != 1) {
+        throw std::runtime_error("No randomness for an upload id");
+    }
+    static const char* hex = "0123456789abcdef";
+    std::string out;
+    for (unsigned char b : bytes) {
+        out.push_back(hex[b >> 4]);
+        out.push_back(hex[b & 0xf]);
+    }
+    return out;
+}
+
+bool isHash(const std::string& value) {
+    return value.size() == 64 &&
+           std::all_of(value.begin(), value.end(), [](char c) { return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'); });
+}
+
+crow::response errorResponse(int code, const std::string& message) {
+    nlohmann::json response;
+    response["error"] = true;
+    response["message"] = message;
+    crow::response res(code, response.dump());
+    res.add_header("Content-Type", "application/json");
+    return res;
+}
+
+crow::response jsonResponse(int code, const nlohmann::json& body) {
+    crow::response res(code, body.dump());
+    res.add_header("Content-Type", "application/json");
+    return res;
+}
+
+// Upload exposed to GDAL as /vsimem file without a copy; unlinked on scope exit
+struct MemFile {
+    std::string path;
+    MemFile(std::string p, const std::string& bytes) : path(std::move(p)) {
+        VSILFILE* file = VSIFileFromMemBuffer(path.c_str(),
+                                              reinterpret_cast<GByte*>(const_cast<char*>(bytes.data())),
+                                              bytes.size(), FALSE);
+        if (file) VSIFCloseL(file);
+    }
+    ~MemFile() { VSIUnlink(path.c_str()); }
+};
+
+struct Dataset {
+    GDALDatasetH handle = nullptr;
+    ~Dataset() {
+        if (handle) GDALClose(handle);
+    }
+};
+
+// 8-bit pixels, bands interleaved by pixel (1 = grey, 3 = RGB)
+struct Raster {
+    int width = 0;
+    int height = 0;
+    int bands = 0;
+    std::vector<uint8_t> pixels;
+};
+
+// Size with the longest side at most max_px, keeping the aspect; never enlarged
+std::pair<int, int> fitWithin(int width, int height, int max_px) {
+    const int longest = std::max(width, height);
+    if (max_px <= 0 || longest <= max_px) return {width, height};
+    const double scale = static_cast<double>(max_px) / longest;
+    return {std::max(1, static_cast<int>(std::lround(width * scale))),
+            std::max(1, static_cast<int>(std::lround(height * scale)))};
+}
+
+// The image at width x height: RGB when it has three colour bands, else
+// grey (an alpha band is ignored); palette images go through their colour
+// table. Downscaling averages the source pixels.
+Raster readRaster(GDALDatasetH dataset, int width, int height) {
+    Raster raster;
+    raster.width = width;
+    raster.height = height;
+
+    GDALRasterBandH first = GDALGetRasterBand(dataset, 1);
+    GDALColorTableH palette =
+        GDALGetRasterColorInterpretation(first) == GCI_PaletteIndex ? GDALGetRasterColorTable(first) : nullptr;
+    const int source_bands = GDALGetRasterCount(dataset);
+    int band_map[3] = {1, 2, 3};
+    const int read_bands = palette || source_bands < 3 ? 1 : 3;
+    raster.bands = palette ? 3 : read_bands;
+
+    GDALRasterIOExtraArg extra;
+    INIT_RASTERIO_EXTRA_ARG(extra);
+    // Averaging palette indices would mix unrelated colours
+    extra.eResampleAlg = palette ? GRIORA_NearestNeighbour : GRIORA_Average;
+
+    std::vector<uint8_t> read(static_cast<size_t>(width) * height * read_bands);
+    CPLErr err = GDALDatasetRasterIOEx(dataset, GF_Read, 0, 0, GDALGetRasterXSize(dataset), GDALGetRasterYSize(dataset),
+                                       read.data(), width, height, GDT_Byte, read_bands, band_map, read_bands,
+                                       static_cast<GSpacing>(read_bands) * width, 1, &extra);
+    if (err != CE_None) {
+        throw DocumentError(std::string("Cannot read image pixels: ") + CPLGetLastErrorMsg());
+    }
+
+    if (!palette) {
+        raster.pixels = std::move(read);
+        return raster;
+    }
+    raster.pixels.resize(read.size() * 3);
+    for (size_t i = 0; i < read.size(); ++i) {
+        const GDALColorEntry* entry = GDALGetColorEntry(palette, read[i]);
+        raster.pixels[i * 3] = entry ? static_cast<uint8_t>(entry->c1) : 0;
+        raster.pixels[i * 3 + 1] = entry ? static_cast<uint8_t>(entry->c2) : 0;
+        raster.pixels[i * 3 + 2] = entry ? static_cast<uint8_t>(entry->c3) : 0;
+    }
+    return raster;
+}
+
+std::vector<uint8_t> toGrey(const Raster& raster) {
+    if (raster.bands == 1) return raster.pixels;
+    std::vector<uint8_t> grey(static_cast<size_t>(raster.width) * raster.height);
+    for (size_t i = 0; i < grey.size(); ++i) {
+        const uint8_t* rgb = &raster.pixels[i * 3];
+        grey[i] = static_cast<uint8_t>((77 * rgb[0] + 150 * rgb[1] + 29 * rgb[2]) >> 8);
+    }
+    return grey;
+}
+
+// PNG through a MEM dataset, written to /vsimem and taken over
+std::string encodePng(const Raster& raster, uint64_t job_id) {
+    GDALDriverH mem = GDALGetDriverByName("MEM");
+    GDALDriverH png = GDALGetDriverByName("PNG");
+    if (!mem || !png) {
+        throw std::runtime_error("GDAL MEM or PNG driver is not available");
+    }
+    Dataset source;
+    source.handle = GDALCreate(mem, "", raster.width, raster.height, raster.bands, GDT_Byte, nullptr);
+    if (!source.handle) {
+        throw std::runtime_error("Cannot create thumbnail raster");
+    }
+    int band_map[3] = {1, 2, 3};
+    GDALDatasetRasterIO(source.handle, GF_Write, 0, 0, raster.width, raster.height,
+                        const_cast<uint8_t*>(raster.pixels.data()), raster.width, raster.height, GDT_Byte,
+                        raster.bands, band_map, raster.bands, static_cast<GSpacing>(raster.bands) * raster.width, 1);
+
+    const std::string path = "/vsimem/documents/thumbnail-" + std::to_string(job_id) + ".png";
+    Dataset encoded;
+    encoded.handle = GDALCreateCopy(png, path.c_str(), source.handle, FALSE, nullptr, nullptr, nullptr);
+    if (!encoded.handle) {
+        throw std::runtime_error(std::string("Cannot encode thumbnail: ") + CPLGetLastErrorMsg());
+    }
+    GDALClose(encoded.handle); // flushes the file
+    encoded.handle = nullptr;
+
+    vsi_l_offset size = 0;
+    GByte* data = VSIGetMemFileBuffer(path.c_str(), &size, TRUE);
+    if (!data) {
+        throw std::runtime_error("Thumbnail was not written");
+    }
+    std::string out(reinterpret_cast<const char*>(data), static_cast<size_t>(size));
+    CPLFree(data);
+    return out;
+}
+
+#ifdef HAVE_TESSERACT
+// Loading the language data takes a noticeable time, so each worker keeps its engine
+struct TesseractEngine {
+    TessBaseAPI* api = nullptr;
+    std::string language;
+    std::string datapath;
+
+    ~TesseractEngine() { reset(); }
+
+    void reset() {
+        if (api) {
+            TessBaseAPIEnd(api);
+            TessBaseAPIDelete(api);
+            api = nullptr;
+        }
+    }
+
+    TessBaseAPI* get(const std::string& lang, const std::string& path) {
+        if (api && lang == language && path == datapath) return api;
+        reset();
+        api = TessBaseAPICreate();
+        if (TessBaseAPIInit3(api, path.empty() ? nullptr : path.c_str(), lang.c_str()) != 0) {
+            reset();
+            throw std::runtime_error("Cannot load Tesseract language data for " + lang);
+        }
+        language = lang;
+        datapath = path;
+        return api;
+    }
+};
+
+thread_local TesseractEngine tesseract_engine;
+#endif
+
+// Text and mean confidence of a grey image; false when OCR is not built in
+bool recognise(const std::vector<uint8_t>& grey, int width, int height, const DocumentSettings& settings,
+               std::string& text, double& confidence) {
+#ifdef HAVE_TESSERACT
+    TessBaseAPI* api = tesseract_engine.get(settings.ocr_language, settings.tessdata_path);
+    TessBaseAPISetImage(api, grey.data(), width, height, 1, width);
+    TessBaseAPISetSourceResolution(api, 300);
+    char* utf8 = TessBaseAPIGetUTF8Text(api);
+    text = utf8 ? utf8 : "";
+    if (utf8) TessDeleteText(utf8);
+    confidence = TessBaseAPIMeanTextConf(api);
+    TessBaseAPIClear(api);
+    return true;
+#else
+    (void)grey;
+    (void)width;
+    (void)height;
+    (void)settings;
+    text.clear();
+    confidence = 0;
+    return false;
+#endif
+}
+
+// Coordinate pairs, one per line, as the image editor reads them: degrees
+// minutes seconds (a S or W hemisphere makes the value negative), else
+// decimal numbers, else any numbers; the first two found on a line
+std::vector<DocumentCoordinate> extractCoordinates(const std::string& text) {
+    static const std::regex dms(R"((\d{1,3})\s*(?:°|º)\s*(\d{1,2})\s*(?:'|’|′)\s*(\d{1,2}(?:\.\d+)?)\s*(?:"|”|″|'')?\s*([NSEWnsew])?)");
+    static const std::regex decimal(R"([-+]?\d+\.\d+)");
+    static const std::regex number(R"([-+]?\d*\.?\d+)");
+
+    std::vector<DocumentCoordinate> coordinates;
+    std::istringstream lines(text);
+    std::string line;
+    int line_number = 0;
+    while (std::getline(lines, line)) {
+        if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+        ++line_number;
+
+        std::vector<double> values;
+        for (auto it = std::sregex_iterator(line.begin(), line.end(), dms); it != std::sregex_iterator() && values.size() < 2; ++it) {
+            const auto& m = *it;
+            double value = std::stod(m[1].str()) + std::stod(m[2].str()) / 60.0 + std::stod(m[3].str()) / 3600.0;
+            const std::string hemisphere = m[4].str();
+            if (hemisphere == "S" || hemisphere == "s" || hemisphere == "W" || hemisphere == "w") value = -value;
+            values.push_back(value);
+        }
+        for (const auto* pattern : {&decimal, &number}) {
+            if (values.size() >= 2) break;
+            values.clear();
+            for (auto it = std::sregex_iterator(line.begin(), line.end(), *pattern);
+                 it != std::sregex_iterator() && values.size() < 2; ++it) {
+                values.push_back(std::stod(it->str()));
+            }
+        }
+        if (values.size() >= 2 && std::isfinite(values[0]) && std::isfinite(values[1])) {
+            coordinates.push_back({values[0], values[1], line_number});
+        }
+    }
+    return coordinates;
+}
+
+} // namespace
+
+nlohmann::json DocumentResult::toJson() const {
+    nlohmann::json coords = nlohmann::json::array();
+    for (const auto& c : coordinates) {
+        coords.push_back({{"values", {c.first, c.second}}, {"line", c.line}});
+    }
+    return {{"hash", hash},
+            {"width", width},
+            {"height", height},
+            {"ocr_width", ocr_width},
+            {"ocr_height", ocr_height},
+            {"ocr_available", ocr_available},
+            {"text", text},
+            {"confidence", confidence},
+            {"coordinates", coords},
+            {"thumbnail_url", "/api/documents/" + hash + "/thumbnail"},
+            {"elapsed_ms", elapsed_ms}};
+}
+
+DocumentPipeline& DocumentPipeline::getInstance() {
+    static DocumentPipeline instance;
+    return instance;
+}
+
+DocumentPipeline::DocumentPipeline() : jobs_("Document job", [this](const Job& job) { return jobJson(job); }) {}
+
+DocumentPipeline::~DocumentPipeline() {
+    shutdown();
+}
+
+void DocumentPipeline::configure(const DocumentSettings& settings) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    settings_ = settings;
+    settings_.workers = std::max<size_t>(1, settings_.workers);
+    settings_.cache_entries = std::max<size_t>(1, settings_.cache_entries);
+    if (settings_.enabled) {
+        jobs_.start(settings_.workers, "documents", settings_.max_queue);
+    }
+#ifdef HAVE_TESSERACT
+    const bool ocr = true;
+#else
+    const bool ocr = false;
+#endif
+    spdlog::info("Document pipeline {}: {} workers, queue {}, cache {} results, OCR {}",
+                 settings_.enabled ? "enabled" : "disabled", settings_.workers, settings_.max_queue,
+                 settings_.cache_entries, ocr ? "Tesseract (" + settings_.ocr_language + ")" : "not built in");
+}
+
+void DocumentPipeline::shutdown() {
+    jobs_.shutdown(false); // joins after the running documents
+}
+
+bool DocumentPipeline::enabled() const {
+    return jobs_.running();
+}
+
+void DocumentPipeline::registerRoutes(HttpApp& app) {
+    CROW_ROUTE(app, "/api/documents")
+        .methods(crow::HTTPMethod::POST)
+        ([this](const crow::request& req) { return submit(req); });
+
+    CROW_ROUTE(app, "/api/documents/jobs/<uint>")
+        .methods(crow::HTTPMethod::GET)
+        ([this](uint64_t id) { return jobs_.status(id); });
+
+    CROW_ROUTE(app, "/api/documents/<string>/thumbnail")
+        .methods(crow::HTTPMethod::GET)
+        ([this](const std::string& hash) { return thumbnail(hash); });
+
+    CROW_ROUTE(app, "/api/documents/uploads")
+        .methods(crow::HTTPMethod::POST)
+        ([this](const crow::request& req) { return openUpload(req); });
+
+    CROW_ROUTE(app, "/api/documents/uploads/<string>")
+        .methods(crow::HTTPMethod::PUT, crow::HTTPMethod::GET, crow::HTTPMethod::DELETE)
+        ([this](const crow::request& req, const std::string& upload_id) {
+            if (req.method == crow::HTTPMethod::PUT) return appendChunk(req, upload_id);
+            if (req.method == crow::HTTPMethod::DELETE) return abandonUpload(upload_id);
+            return uploadStatus(upload_id);
+        });
+
+    CROW_ROUTE(app, "/api/documents/uploads/<string>/complete")
+        .methods(crow::HTTPMethod::POST)
+        ([this](const std::string& upload_id) { return completeUpload(upload_id); });
+}
+
+crow::response DocumentPipeline::submit(const crow::request& req) {
+    if (!enabled()) {
+        return errorResponse(503, "Document processing is disabled");
+    }
+    if (req.body.empty()) {
+        return errorResponse(400, "Expected the image as the request body");
+    }
+    if (req.body.size() > settings_.max_upload_bytes) {
+        return errorResponse(413, "Document exceeds " + std::to_string(settings_.max_upload_bytes / (1024 * 1024)) +
+                                      " MB");
+    }
+
+    return accept(std::make_shared<const std::string>(req.body));
+}
+
+crow::response DocumentPipeline::accept(std::shared_ptr<const std::string> bytes) {
+    const std::string hash = sha256(*bytes);
+    if (auto result = cached(hash)) {
+        nlohmann::json response;
+        response["data"] = result->toJson();
+        response["cached"] = true;
+        return jsonResponse(200, response);
+    }
+
+    Job job;
+    job.hash = hash;
+    const auto submitted =
+        jobs_.submit(std::move(job), [this, hash, bytes](uint64_t id) { process(id, hash, bytes); }, hash);
+    if (!submitted) {
+        auto res = errorResponse(429, "Document queue is full, please retry later");
+        res.add_header("Retry-After", "10");
+        return res;
+    }
+    const uint64_t id = submitted->id;
+    if (!submitted->joined) {
+        spdlog::info("Queued document job {} ({} bytes, {})", id, bytes->size(), hash.substr(0, 12));
+    }
+
+    nlohmann::json response;
+    response["message"] = "Document accepted. Processing is in progress.";
+    response["job_id"] = id;
+    response["hash"] = hash;
+    response["status_url"] = "/api/documents/jobs/" + std::to_string(id);
+    return jsonResponse(202, response);
+}
+
+crow::response DocumentPipeline::openUpload(const crow::request& req) {
+    if (!enabled()) {
+        return errorResponse(503, "Document processing is disabled");
+    }
+    size_t size = 0;
+    try {
+        auto body = nlohmann::json::parse(req.body);
+        size = body.at("size").get<size_t>();
+    } catch (const nlohmann::json::exception&) {
+        return errorResponse(400, "Expected {\"size\": <bytes>}");
+    }
+    if (size == 0) {
+        return errorResponse(400, "Upload size must be positive");
+    }
+    if (size > settings_.max_upload_bytes) {
+        return errorResponse(413, "Document exceeds " + std::to_string(settings_.max_upload_bytes / (1024 * 1024)) +
+                                      " MB");
+    }
+
+    std::string id = randomId();
+    {
+        std::lock_guard<std::mutex> lock(uploads_mutex_);
+        expireUploads();
+        if (uploads_.size() >= settings_.max_upload_sessions) {
+            auto res = errorResponse(429, "Too many uploads in progress, please retry later");
+            res.add_header("Retry-After", "10");
+            return res;
+        }
+        UploadSession session;
+        session.size = size;
+        session.data.reserve(size);
+        session.touched = std::chrono::steady_clock::now();
+        uploads_.emplace(id, std::move(session));
+    }
+
+    nlohmann::json response;
+    response["data"] = {{"upload_id", id},
+                        {"size", size},
+                        {"received", 0},
+                        {"chunk_bytes", kChunkBytes},
+                        {"upload_url", "/api/documents/uploads/" + id}};
+    return jsonResponse(201, response);
+}
+
+crow::response DocumentPipeline::appendChunk(const crow::request& req, const std::string& upload_id) {
+    const char* offset_param = req.url_params.get("offset");
+    size_t offset = 0;
+    try {
+        offset = offset_param ? std::stoull(offset_param) : 0;
+    } catch (const std::exception&) {
+        return errorResponse(400, "Invalid offset");
+    }
+    if (req.body.empty()) {
+        return errorResponse(400, "Expected the chunk as the request body");
+    }
+    if (req.body.size() > kMaxChunkBytes) {
+        return errorResponse(413, "Chunk exceeds " + std::to_string(kMaxChunkBytes / (1024 * 1024)) + " MB");
+    }
+
+    std::lock_guard<std::mutex> lock(uploads_mutex_);
+    auto it = uploads_.find(upload_id);
+    if (it == uploads_.end()) {
+        return errorResponse(404, "Upload not found or expired");
+    }
+    UploadSession& session = it->second;
+    session.touched = std::chrono::steady_clock::now();
+    // A retried chunk that did arrive, or one sent ahead of a lost one:
+    // the client continues from the count in the answer
+    if (offset != session.data.size()) {
+        nlohmann::json response;
+        response["error"] = true;
+        response["message"] = "Expected offset " + std::to_string(session.data.size());
+        response["received"] = session.data.size();
+        return jsonResponse(409, response);
+    }
+    if (offset + req.body.size() > session.size) {
+        return errorResponse(413, "Chunk runs past the declared upload size");
+    }
+    session.data.append(req.body);
+
+    nlohmann::json response;
+    response["data"] = {{"upload_id", upload_id}, {"size", session.size}, {"received", session.data.size()}};
+    return jsonResponse(200, response);
+}
+
+crow::response DocumentPipeline::uploadStatus(const std::string& upload_id) {
+    std::lock_guard<std::mutex> lock(uploads_mutex_);
+    auto it = uploads_.find(upload_id);
+    if (it == uploads_.end()) {
+        return errorResponse(404, "Upload not found or expired");
+    }
+    nlohmann::json response;
+    response["data"] = {{"upload_id", upload_id}, {"size", it->second.size}, {"received", it->second.data.size()}};
+    return jsonResponse(200, response);
+}
+
+crow::response DocumentPipeline::completeUpload(const std::string& upload_id) {
+    std::shared_ptr<const std::string> bytes;
+    {
+        std::lock_guard<std::mutex> lock(uploads_mutex_);
+        auto it = uploads_.find(upload_id);
+        if (it == uploads_.end()) {
+            return errorResponse(404, "Upload not found or expired");
+        }
+        if (it->second.data.size() != it->second.size) {
+            nlohmann::json response;
+            response["error"] = true;
+            response["message"] = "Upload is incomplete";
+            response["received"] = it->second.data.size();
+            return jsonResponse(409, response);
+        }
+        bytes = std::make_shared<const std::string>(std::move(it->second.data));
+        uploads_.erase(it);
+    }
+    if (!enabled()) {
+        return errorResponse(503, "Document processing is disabled");
+    }
+    return accept(std::move(bytes));
+}
+
+crow::response DocumentPipeline::abandonUpload(const std::string& upload_id) {
+    std::lock_guard<std::mutex> lock(uploads_mutex_);
+    if (uploads_.erase(upload_id) == 0) {
+        return errorResponse(404, "Upload not found or expired");
+    }
+    return crow::response(204);
+}
+
+void DocumentPipeline::expireUploads() {
+    const auto cutoff = std::chrono::steady_clock::now() - settings_.upload_idle;
+    for (auto it = uploads_.begin(); it != uploads_.end();) {
+        if (it->second.touched < cutoff) {
+            spdlog::info("Dropping idle document upload {} ({} of {} bytes)", it->first, it->second.data.size(),
+                         it->second.size);
+            it = uploads_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+crow::response DocumentPipeline::thumbnail(const std::string& hash) const {
+    if (!isHash(hash)) {
+        return errorResponse(400, "Expected a document hash");
+    }
+    auto result = cached(hash);
+    if (!result || result->thumbnail_png.empty()) {
+        return errorResponse(404, "Thumbnail not found");
+    }
+    crow::response res(200, result->thumbnail_png);
+    res.add_header("Content-Type", "image/png");
+    // Named by content hash, so it never changes
+    res.add_header("Cache-Control", "public, max-age=86400, immutable");
+    return res;
+}
+
+nlohmann::json DocumentPipeline::jobJson(const Job& job) const {
+    nlohmann::json j = job.toJson();
+    j["hash"] = job.hash;
+    j["result"] = job.result ? job.result->toJson() : nlohmann::json(nullptr);
+    return j;
+}
+
+void DocumentPipeline::process(uint64_t job_id, const std::string& hash, std::shared_ptr<const std::string> bytes) {
+    try {
+        auto result = std::make_shared<const DocumentResult>(run(job_id, hash, *bytes));
+        spdlog::info("Document job {} done in {:.0f} ms: {}x{}, {} characters, {} coordinate pairs", job_id,
+                     result->elapsed_ms, result->width, result->height, result->text.size(), result->coordinates.size());
+        remember(result);
+        jobs_.update(job_id, [&result](Job& job) { job.result = std::move(result); });
+        jobs_.finish(job_id, std::nullopt);
+    } catch (const DocumentError& e) {
+        spdlog::info("Document job {} rejected: {}", job_id, e.what());
+        jobs_.finish(job_id, e.what());
+    } catch (const std::exception& e) {
+        spdlog::error("Document job {} failed: {}", job_id, e.what());
+        jobs_.finish(job_id, std::string("Processing failed: ") + e.what());
+    }
+}
+
+DocumentResult DocumentPipeline::run(uint64_t job_id, const std::string& hash, const std::string& bytes) {
+    const auto started = std::chrono::steady_clock::now();
+    DocumentSettings settings;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        settings = settings_;
+    }
+
+    jobs_.setStage(job_id, "decoding");
+    registerGdalDrivers();
+    MemFile file("/vsimem/documents/upload-" + std::to_string(job_id), bytes);
+    Dataset dataset;
+    dataset.handle = GDALOpenEx(file.path.c_str(), GDAL_OF_RASTER | GDAL_OF_READONLY, nullptr, nullptr, nullptr);
+    if (!dataset.handle || GDALGetRasterCount(dataset.handle) == 0) {
+        throw DocumentError("Not a readable image");
+    }
+
+    DocumentResult result;
+    result.hash = hash;
+    result.width = GDALGetRasterXSize(dataset.handle);
+    result.height = GDALGetRasterYSize(dataset.handle);
+
+    jobs_.setStage(job_id, "thumbnail");
+    auto [thumb_w, thumb_h] = fitWithin(result.width, result.height, settings.thumbnail_px);
+    result.thumbnail_png = encodePng(readRaster(dataset.handle, thumb_w, thumb_h), job_id);
+
+    jobs_.setStage(job_id, "ocr");
+    auto [ocr_w, ocr_h] = fitWithin(result.width, result.height, settings.ocr_max_px);
+    result.ocr_width = ocr_w;
+    result.ocr_height = ocr_h;
+    const auto grey = toGrey(readRaster(dataset.handle, ocr_w, ocr_h));
+    result.ocr_available = recognise(grey, ocr_w, ocr_h, settings, result.text, result.confidence);
+
+    jobs_.setStage(job_id, "coordinates");
+    result.coordinates = extractCoordinates(result.text);
+
+    const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - started;
+    result.elapsed_ms = elapsed.count();
+    return result;
+}
+
+std::shared_ptr<const DocumentResult> DocumentPipeline::cached(const std::string& hash) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = cache_index_.find(hash);
+    if (it == cache_index_.end()) {
+        ++cache_misses_;
+        return nullptr;
+    }
+    cache_lru_.splice(cache_lru_.begin(), cache_lru_, it->second);
+    ++cache_hits_;
+    return *it->second;
+}
+
+void DocumentPipeline::remember(std::shared_ptr<const DocumentResult> result) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = cache_index_.find(result->hash);
+    if (it != cache_index_.end()) {
+        cache_lru_.erase(it->second);
+    }
+    cache_lru_.push_front(result);
+    cache_index_[result->hash] = cache_lru_.begin();
+    while (cache_lru_.size() > settings_.cache_entries) {
+        cache_index_.erase(cache_lru_.back()->hash);
+        cache_lru_.pop_back();
+        ++cache_evictions_;
+    }
+}
+
+nlohmann::json DocumentPipeline::cacheStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t bytes = 0;
+    for (const auto& result : cache_lru_) {
+        bytes += result->thumbnail_png.size() + result->text.size();
+    }
+    return {{"entries", cache_lru_.size()},
+            {"capacity", settings_.cache_entries},
+            {"bytes", bytes},
+            {"hits", cache_hits_},
+            {"misses", cache_misses_},
+            {"evictions", cache_evictions_}};
+}
+
+void DocumentPipeline::clearCache() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cache_lru_.clear();
+    cache_index_.clear();
+}
+
+nlohmann::json DocumentPipeline::poolStats() const {
+    return jobs_.stats();
+}
+
+} // namespace aeronautical
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <crow.h>
+#include "BackgroundJobs.h"
+#include "HttpApp.h"
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <json.hpp>
+
+namespace aeronautical {
+
+struct DocumentSettings {
+    bool enabled = true;
+    size_t workers = 2;
+    size_t max_queue = 16;                     // documents queued or running before 429
+    size_t max_upload_bytes = 20 * 1024 * 1024;
+    size_t cache_entries = 64;                 // results kept by content hash
+    int thumbnail_px = 512;                    // longest side of the thumbnail
+    int ocr_max_px = 2500;                     // longest side the page is read at for OCR
+    std::string ocr_language = "eng";
+    std::string tessdata_path;                 // empty: Tesseract's default location
+    size_t max_upload_sessions = 16;           // chunked uploads open at once
+    std::chrono::seconds upload_idle{15 * 60}; // an upload with no chunk for this long is dropped
+};
+
+// A coordinate pair read from one line of recognised text, in the order the
+// numbers appear (the plan decides which one is latitude)
+struct DocumentCoordinate {
+    double first = 0;
+    double second = 0;
+    int line = 0; // 1-based, among the non-empty lines
+};
+
+struct DocumentResult {
+    std::string hash; // sha256 of the uploaded bytes
+    int width = 0;    // source image, pixels
+    int height = 0;
+    int ocr_width = 0; // after downscaling for OCR
+    int ocr_height = 0;
+    bool ocr_available = false; // built without Tesseract: text stays empty
+    std::string text;
+    double confidence = 0; // Tesseract's mean word confidence, 0-100
+    std::vector<DocumentCoordinate> coordinates;
+    std::string thumbnail_png;
+    double elapsed_ms = 0;
+
+    // Everything but the thumbnail, which has its own URL
+    nlohmann::json toJson() const;
+};
+
+// Server-side processing of uploaded plans and documents (images in any
+// format GDAL reads): decode, downscale to a thumbnail and to the OCR
+// working size, recognise the text with Tesseract when the build has it,
+// and read coordinate pairs out of the text. Uploads are hashed; a result
+// already in the LRU is answered at once, a document already being
+// processed is joined, and anything else becomes a job on a bounded pool.
+//
+// Large scans can instead be sent in chunks: each PUT holds an HTTP worker
+// only for its chunk, and after a dropped connection the client asks how
+// much arrived and continues from there. Chunks are kept in memory until
+// the upload is completed, abandoned or idle for upload_idle.
+//
+//   POST   /api/documents                          image bytes; 200 with the result or 202 with the job
+//   GET    /api/documents/jobs/<id>                job state, and the result once completed
+//   GET    /api/documents/<hash>/thumbnail         PNG
+//   POST   /api/documents/uploads                  {"size": bytes}; opens an upload session
+//   PUT    /api/documents/uploads/<id>?offset=N    next chunk; 409 with the received count when N is not it
+//   GET    /api/documents/uploads/<id>             bytes received so far
+//   POST   /api/documents/uploads/<id>/complete    as POST /api/documents with the assembled bytes
+//   DELETE /api/documents/uploads/<id>             abandons the upload
+class DocumentPipeline {
+public:
+    static DocumentPipeline& getInstance();
+
+    DocumentPipeline(const DocumentPipeline&) = delete;
+    DocumentPipeline& operator=(const DocumentPipeline&) = delete;
+
+    // Starts the workers; routes answer 503 until then or when disabled
+    void configure(const DocumentSettings& settings);
+    // Lets running documents finish and joins the workers
+    void shutdown();
+    bool enabled() const;
+
+    void registerRoutes(HttpApp& app);
+
+    // Results held, their bytes and the hit, miss and eviction counts
+    nlohmann::json cacheStats() const;
+    void clearCache();
+    nlohmann::json poolStats() const;
+
+private:
+    struct Job : BackgroundJob {
+        std::string hash;
+        std::shared_ptr<const DocumentResult> result;
+    };
+
+    struct UploadSession {
+        size_t size = 0;
+        std::string data; // the chunks received, in order
+        std::chrono::steady_clock::time_point touched;
+    };
+
+    DocumentPipeline();
+    ~DocumentPipeline();
+
+    crow::response submit(const crow::request& req);
+    // Answers from the cache, joins the job in flight or queues a new one
+    crow::response accept(std::shared_ptr<const std::string> bytes);
+    crow::response openUpload(const crow::request& req);
+    crow::response appendChunk(const crow::request& req, const std::string& upload_id);
+    crow::response uploadStatus(const std::string& upload_id);
+    crow::response completeUpload(const std::string& upload_id);
+    crow::response abandonUpload(const std::string& upload_id);
+    // Drops sessions idle past upload_idle; caller holds uploads_mutex_
+    void expireUploads();
+    crow::response thumbnail(const std::string& hash) const;
+
+    // Runs on the pool
+    void process(uint64_t job_id, const std::string& hash, std::shared_ptr<const std::string> bytes);
+    DocumentResult run(uint64_t job_id, const std::string& hash, const std::string& bytes);
+
+    std::shared_ptr<const DocumentResult> cached(const std::string& hash) const;
+    void remember(std::shared_ptr<const DocumentResult> result);
+    nlohmann::json jobJson(const Job& job) const;
+
+    static constexpr size_t kChunkBytes = 1024 * 1024;   // suggested to clients
+    static constexpr size_t kMaxChunkBytes = 8 * 1024 * 1024;
+
+    DocumentSettings settings_;
+    // Keyed by content hash, so uploads of one document share its job
+    BackgroundJobs<Job> jobs_;
+
+    mutable std::mutex mutex_; // settings and cache
+
+    // LRU of results; front is most recent
+    using CacheList = std::list<std::shared_ptr<const DocumentResult>>;
+    mutable CacheList cache_lru_;
+    std::unordered_map<std::string, CacheList::iterator> cache_index_;
+    mutable uint64_t cache_hits_ = 0;
+    mutable uint64_t cache_misses_ = 0;
+    uint64_t cache_evictions_ = 0;
+
+    std::mutex uploads_mutex_;
+    std::unordered_map<std::string, UploadSession> uploads_;
+};
+
+} // namespace aeronautical
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <string_view>
+#include <utility>
+
+namespace aeronautical {
+
+// Name table of a domain enum, built at compile time. Entries are listed in
+// declaration order, so name() is an array index; parse() binary-searches a
+// sorted copy of the names. Neither allocates.
+//
+//   constexpr EnumNames<TurnDirection, 3> kTurnDirections(
+//       {{{TurnDirection::Left, "left"}, {TurnDirection::Right, "right"},
+//         {TurnDirection::Straight, "straight"}}},
+//       TurnDirection::Straight);
+template <typename E, size_t N>
+class EnumNames {
+public:
+    using Entry = std::pair<E, std::string_view>;
+
+    // fallback is what an unknown value or name maps to
+    constexpr EnumNames(std::array<Entry, N> entries, E fallback) : by_value_(entries), fallback_(fallback) {
+        for (size_t i = 0; i < N; i++) {
+            // Not a constant expression when an entry is out of order
+            if (static_cast<size_t>(by_value_[i].first) != i) throw "EnumNames entries must follow the enum order";
+        }
+        by_name_ = by_value_;
+        std::sort(by_name_.begin(), by_name_.end(),
+                  [](const Entry& a, const Entry& b) { return a.second < b.second; });
+    }
+
+    constexpr std::string_view name(E value) const {
+        const auto index = static_cast<size_t>(value);
+        return index < N ? by_value_[index].second : by_value_[static_cast<size_t>(fallback_)].second;
+    }
+
+    constexpr std::optional<E> find(std::string_view text) const {
+        auto it = std::lower_bound(by_name_.begin(), by_name_.end(), text,
+                                   [](const Entry& entry, std::string_view key) { return entry.second < key; });
+        if (it != by_name_.end() && it->second == text) return it->first;
+        return std::nullopt;
+    }
+
+    constexpr E parse(std::string_view text) const { return find(text).value_or(fallback_); }
+
+private:
+    std::array<Entry, N> by_value_;
+    std::array<Entry, N> by_name_{};
+    E fallback_;
+};
+
+} // namespace aeronautical
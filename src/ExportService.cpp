@@ -0,0 +1,450 @@
+#include "ExportService.h"
+#include "ConflictRepository.h"
+#include "DatabaseManager.h"
+#include "FileResponse.h"
+#include "FlightProcedure.h"
+#include "GdalDrivers.h"
+#include "GeoJsonReader.h"
+#include "GeometryBlob.h"
+#include "gdal.h"
+#include "ogrsf_frmts.h"
+#include "cpl_string.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+
+namespace aeronautical {
+
+namespace {
+
+crow::response errorResponse(int code, const std::string& message) {
+    nlohmann::json response;
+    response["error"] = true;
+    response["message"] = message;
+    crow::response res(code, response.dump());
+    res.add_header("Content-Type", "application/json");
+    return res;
+}
+
+crow::response jsonResponse(int code, const nlohmann::json& body) {
+    crow::response res(code, body.dump());
+    res.add_header("Content-Type", "application/json");
+    return res;
+}
+
+// ICAO location indicator, upper-cased; nullopt when it is not one
+std::optional<std::string> airportCode(std::string code) {
+    if (code.size() < 3 || code.size() > 4) return std::nullopt;
+    for (char& c : code) {
+        if (!std::isalnum(static_cast<unsigned char>(c))) return std::nullopt;
+        c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    }
+    return code;
+}
+
+std::string column(MYSQL_ROW row, unsigned long* lengths, int i) {
+    return row[i] ? std::string(row[i], lengths[i]) : std::string();
+}
+
+void addField(OGRLayer& layer, const char* name, OGRFieldType type, int width = 0) {
+    OGRFieldDefn field(name, type);
+    if (width > 0) field.SetWidth(width);
+    layer.CreateField(&field);
+}
+
+// Closes the dataset on every path out of the export
+struct Output {
+    GDALDataset* dataset = nullptr;
+    bool in_transaction = false;
+
+    // False when the last transaction could not be committed
+    bool close() {
+        if (!dataset) return true;
+        bool ok = true;
+        if (in_transaction) ok = dataset->CommitTransaction() == OGRERR_NONE;
+        in_transaction = false;
+        // Shapefile zips and GeoPackage indexes are finished here
+        GDALClose(GDALDataset::ToHandle(dataset));
+        dataset = nullptr;
+        return ok;
+    }
+    ~Output() { close(); }
+};
+
+const ExportFormat kFormats[] = {
+    {"gpkg", "GPKG", ".gpkg", "application/geopackage+sqlite3", false},
+    // The driver writes the .shp, .shx, .dbf and .prj into one zip (GDAL 3.1+)
+    {"shp", "ESRI Shapefile", ".shp.zip", "application/zip", true},
+    {"kml", "KML", ".kml", "application/vnd.google-earth.kml+xml", false},
+    {"geojson", "GeoJSON", ".geojson", "application/geo+json", false},
+};
+
+const ExportFormat* findFormat(const std::string& name) {
+    for (const auto& format : kFormats) {
+        if (name == format.name) return &format;
+    }
+    return nullptr;
+}
+
+} // namespace
+
+ExportService& ExportService::getInstance() {
+    static ExportService instance;
+    return instance;
+}
+
+ExportService::ExportService()
+    : jobs_("Export job", [this](const Job& job) { return jobJson(job); },
+            [this](const Job& job) { removeJobFile(pathOf(job)); }) {}
+
+ExportService::~ExportService() {
+    shutdown();
+}
+
+void ExportService::configure(const ExportSettings& settings) {
+    settings_ = settings;
+    settings_.workers = std::max<size_t>(1, settings_.workers);
+    settings_.max_jobs = std::max<size_t>(1, settings_.max_jobs);
+    if (settings_.directory.empty()) {
+        settings_.directory = (std::filesystem::temp_directory_path() / "aero-exports").string();
+    }
+    if (settings_.enabled) {
+        std::error_code ec;
+        if (!prepareJobDirectory(settings_.directory, "export-", ec)) {
+            spdlog::error("Export directory {} is not usable: {}", settings_.directory, ec.message());
+            settings_.enabled = false;
+        }
+    }
+    if (settings_.enabled) {
+        jobs_.start(settings_.workers, "exports", settings_.max_jobs, settings_.retention);
+    }
+    spdlog::info("Geospatial exports {}: {} workers, {} jobs at once, files in {}",
+                 settings_.enabled ? "enabled" : "disabled", settings_.workers, settings_.max_jobs,
+                 settings_.directory);
+}
+
+void ExportService::shutdown() {
+    jobs_.shutdown(true); // joins once the cursors noticed
+}
+
+bool ExportService::enabled() const {
+    return jobs_.running();
+}
+
+void ExportService::registerRoutes(HttpApp& app) {
+    CROW_ROUTE(app, "/api/exports")
+        .methods(crow::HTTPMethod::POST)
+        ([this](const crow::request& req) { return submit(req); });
+
+    CROW_ROUTE(app, "/api/exports/<uint>")
+        .methods(crow::HTTPMethod::GET, crow::HTTPMethod::DELETE)
+        ([this](const crow::request& req, uint64_t id) {
+            if (req.method == crow::HTTPMethod::DELETE) return jobs_.remove(id);
+            return jobs_.status(id);
+        });
+
+    CROW_ROUTE(app, "/api/exports/<uint>/file")
+        .methods(crow::HTTPMethod::GET)
+        ([this](const crow::request& req, crow::response& res, uint64_t id) {
+            download(req, res, id);
+            res.end();
+        });
+}
+
+crow::response ExportService::submit(const crow::request& req) {
+    if (!enabled()) {
+        return errorResponse(503, "Geospatial exports are disabled");
+    }
+
+    Job job;
+    try {
+        auto body = nlohmann::json::parse(req.body);
+        const std::string kind = body.value("kind", "conflicts");
+        if (kind == "conflicts") {
+            job.kind = Kind::Conflicts;
+        } else if (kind == "protections") {
+            job.kind = Kind::Protections;
+        } else {
+            return errorResponse(400, "kind must be conflicts or protections");
+        }
+        job.format = findFormat(body.value("format", "gpkg"));
+        if (!job.format) {
+            return errorResponse(400, "format must be gpkg, shp, kml or geojson");
+        }
+        if (body.contains("project_id") && !body["project_id"].is_null()) {
+            if (job.kind == Kind::Protections) {
+                return errorResponse(400, "Protections are exported per airport or nationwide");
+            }
+            job.project_id = body["project_id"].get<int>();
+        }
+        if (body.contains("airport_icao") && !body["airport_icao"].is_null()) {
+            job.airport_icao = airportCode(body["airport_icao"].get<std::string>());
+            if (!job.airport_icao) {
+                return errorResponse(400, "airport_icao must be an ICAO location indicator");
+            }
+        }
+    } catch (const nlohmann::json::exception&) {
+        return errorResponse(400, "Expected {\"kind\": ..., \"format\": ..., \"project_id\"?: ..., \"airport_icao\"?: ...}");
+    }
+
+    const auto submitted = jobs_.submit(std::move(job), [this](uint64_t id) { process(id); });
+    if (!submitted) {
+        auto res = errorResponse(429, "Too many exports in progress, please retry later");
+        res.add_header("Retry-After", "30");
+        return res;
+    }
+    const uint64_t id = submitted->id;
+    spdlog::info("Queued export job {}", id);
+
+    nlohmann::json response;
+    response["message"] = "Export accepted. Writing is in progress.";
+    response["job_id"] = id;
+    response["status_url"] = "/api/exports/" + std::to_string(id);
+    return jsonResponse(202, response);
+}
+
+void ExportService::download(const crow::request& req, crow::response& res, uint64_t id) {
+    const auto job = jobs_.get(id);
+    if (!job) {
+        res = errorResponse(404, "Export job not found");
+        return;
+    }
+    if (job->state != BackgroundJobState::Completed) {
+        res = errorResponse(409, "Export is " + backgroundJobStateToString(job->state));
+        return;
+    }
+    const std::string filename = std::string(job->kind == Kind::Conflicts ? "conflicts" : "protections") +
+                                 (job->project_id ? "-project-" + std::to_string(*job->project_id) : "") +
+                                 (job->airport_icao ? "-" + *job->airport_icao : "") + job->format->extension;
+    // A DELETE meanwhile unlinks the path; the open file is still sent whole
+    FileResponse::prepare(req, res, pathOf(*job), job->format->content_type,
+                          "\"export-" + std::to_string(id) + "\"");
+    res.add_header("Content-Disposition", "attachment; filename=\"" + filename + "\"");
+}
+
+nlohmann::json ExportService::jobJson(const Job& job) const {
+    nlohmann::json j = job.toJson();
+    j["kind"] = job.kind == Kind::Conflicts ? "conflicts" : "protections";
+    j["format"] = job.format->name;
+    j["project_id"] = job.project_id ? nlohmann::json(*job.project_id) : nlohmann::json(nullptr);
+    j["airport_icao"] = job.airport_icao ? nlohmann::json(*job.airport_icao) : nlohmann::json(nullptr);
+    j["total"] = job.progress->total.load(std::memory_order_relaxed);
+    j["written"] = job.progress->written.load(std::memory_order_relaxed);
+    j["skipped"] = job.progress->skipped.load(std::memory_order_relaxed);
+    if (job.state == BackgroundJobState::Completed) {
+        j["bytes"] = job.bytes;
+        j["file_url"] = "/api/exports/" + std::to_string(job.id) + "/file";
+        j["expires_at"] = timePointToString(*job.finished_at + settings_.retention);
+    }
+    return j;
+}
+
+std::string ExportService::pathOf(const Job& job) const {
+    return settings_.directory + "/export-" + std::to_string(job.id) + job.format->extension;
+}
+
+void ExportService::process(uint64_t id) {
+    const auto queued = jobs_.get(id);
+    if (!queued) return;
+    const Job& job = *queued;
+    const std::string path = pathOf(job);
+    if (job.isCancelled()) {
+        jobs_.finish(id, std::nullopt);
+        return;
+    }
+    const auto started = std::chrono::steady_clock::now();
+    std::optional<std::string> error;
+    try {
+        error = write(job);
+    } catch (const std::exception& e) {
+        error = std::string("Export failed: ") + e.what();
+    }
+    const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - started;
+    if (error) {
+        spdlog::error("Export job {} failed after {:.0f} ms: {}", id, elapsed.count(), *error);
+    } else {
+        spdlog::info("Export job {} done in {:.0f} ms: {} features ({} skipped) to {}", id, elapsed.count(),
+                     job.progress->written.load(), job.progress->skipped.load(), path);
+        std::error_code ec;
+        const auto bytes = static_cast<size_t>(std::filesystem::file_size(path, ec));
+        jobs_.update(id, [bytes](Job& finished) { finished.bytes = bytes; });
+    }
+    if (jobs_.finish(id, std::move(error)) != BackgroundJobState::Completed) {
+        removeJobFile(path);
+    }
+}
+
+std::optional<std::string> ExportService::write(const Job& job) {
+    Progress& progress = *job.progress;
+    const std::string path = pathOf(job);
+    auto& db = DatabaseManager::getInstance();
+
+    std::string from;
+    std::string columns;
+    if (job.kind == Kind::Conflicts) {
+        // One project's rows are all in one table; the whole set spans both
+        std::string conflicts = "conflicts";
+        if (job.project_id) {
+            conflicts = ConflictRepository::tableOf(*job.project_id);
+        } else if (ConflictRepository::probeArchiveTable()) {
+            conflicts = "(SELECT * FROM conflicts UNION ALL SELECT * FROM conflicts_archive)";
+        }
+        from = " FROM " + conflicts + " c JOIN projects p ON p.id = c.project_id"
+               " LEFT JOIN flight_procedures fp ON fp.id = c.flight_procedure_id WHERE 1 = 1";
+        if (job.project_id) from += " AND c.project_id = " + std::to_string(*job.project_id);
+        if (job.airport_icao) from += " AND fp.airport_icao = '" + *job.airport_icao + "'";
+        columns = std::string("c.id, c.project_id, p.project_code, c.flight_procedure_id, fp.procedure_code, "
+                              "fp.airport_icao, ") +
+                  (ConflictRepository::probeMetricColumns() ? "c.severity, c.overlap_area, c.overlap_ratio"
+                                                            : "NULL, NULL, NULL") +
+                  ", c.description, c.created_at, " +
+                  (ConflictRepository::probeSpatialSupport() ? "ST_AsGeoJSON(c.conflicting_geometry)"
+                                                             : "c.conflicting_geometry");
+    } else {
+        from = " FROM flight_procedures fp WHERE fp.is_active = 1 AND fp.protection_geometry IS NOT NULL"
+               " AND fp.protection_geometry != ''";
+        if (job.airport_icao) from += " AND fp.airport_icao = '" + *job.airport_icao + "'";
+        columns = "fp.id, fp.procedure_code, fp.name, fp.type, fp.airport_icao, fp.runway, fp.protection_geometry";
+    }
+
+    jobs_.setStage(job.id, "counting");
+    {
+        MysqlResult count = db.executeSelectQuery("SELECT COUNT(*)" + from);
+        MYSQL_ROW row = count ? mysql_fetch_row(count.get()) : nullptr;
+        if (!row) return "Could not count the features to export";
+        progress.total.store(row[0] ? std::strtoull(row[0], nullptr, 10) : 0, std::memory_order_relaxed);
+    }
+
+    registerGdalDrivers();
+    GDALDriver* driver = GetGDALDriverManager()->GetDriverByName(job.format->driver);
+    if (!driver) {
+        return std::string("GDAL was built without the ") + job.format->driver + " driver";
+    }
+
+    Output output;
+    output.dataset = driver->Create(path.c_str(), 0, 0, 0, GDT_Unknown, nullptr);
+    if (!output.dataset) {
+        return std::string("Could not create the export file: ") + CPLGetLastErrorMsg();
+    }
+    OGRSpatialReference wgs84;
+    wgs84.importFromEPSG(4326);
+    wgs84.SetAxisMappingStrategy(OAMS_TRADITIONAL_GIS_ORDER);
+    char** layer_options = nullptr;
+    if (job.format->polygons_only) layer_options = CSLSetNameValue(layer_options, "ENCODING", "UTF-8");
+    const char* layer_name = job.kind == Kind::Conflicts ? "conflicts" : "protections";
+    OGRLayer* layer = output.dataset->CreateLayer(
+        layer_name, &wgs84, job.format->polygons_only ? wkbMultiPolygon : wkbUnknown, layer_options);
+    CSLDestroy(layer_options);
+    if (!layer) {
+        return std::string("Could not create the export layer: ") + CPLGetLastErrorMsg();
+    }
+
+    if (job.kind == Kind::Conflicts) {
+        addField(*layer, "id", OFTInteger);
+        addField(*layer, "project_id", OFTInteger);
+        addField(*layer, "project", OFTString, 64);
+        addField(*layer, "proc_id", OFTInteger);
+        addField(*layer, "procedure", OFTString, 64);
+        addField(*layer, "airport", OFTString, 4);
+        addField(*layer, "severity", OFTString, 16);
+        addField(*layer, "overlap_m2", OFTReal);
+        addField(*layer, "overlap_r", OFTReal);
+        addField(*layer, "descr", OFTString, 254);
+        addField(*layer, "created", OFTDateTime);
+    } else {
+        addField(*layer, "id", OFTInteger);
+        addField(*layer, "procedure", OFTString, 64);
+        addField(*layer, "name", OFTString, 254);
+        addField(*layer, "type", OFTString, 32);
+        addField(*layer, "airport", OFTString, 4);
+        addField(*layer, "runway", OFTString, 8);
+    }
+
+    // GeoPackage commits every feature on its own unless told otherwise
+    const bool transactions = output.dataset->TestCapability(ODsCTransactions);
+    size_t in_transaction = 0;
+    std::optional<std::string> error;
+
+    jobs_.setStage(job.id, "writing");
+    const bool streamed = db.streamSelectQuery(
+        "SELECT " + columns + from + (job.kind == Kind::Conflicts ? " ORDER BY c.id" : " ORDER BY fp.id"),
+        [&](MYSQL_ROW row, unsigned long* lengths) {
+            if (job.isCancelled()) return false;
+
+            const int geometry_column = job.kind == Kind::Conflicts ? 11 : 6;
+            std::unique_ptr<OGRGeometry> geometry;
+            if (row[geometry_column]) {
+                geometry = GeoJsonReader::readGeometry(
+                    job.kind == Kind::Conflicts
+                        ? std::string_view(row[geometry_column], lengths[geometry_column])
+                        : GeometryBlob::view(row[geometry_column], lengths[geometry_column]));
+            }
+            const auto family = geometry ? wkbFlatten(geometry->getGeometryType()) : wkbUnknown;
+            if (!geometry || (job.format->polygons_only && family != wkbPolygon && family != wkbMultiPolygon)) {
+                progress.skipped.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+
+            OGRFeature feature(layer->GetLayerDefn());
+            if (job.kind == Kind::Conflicts) {
+                feature.SetField("id", std::atoi(row[0]));
+                if (row[1]) feature.SetField("project_id", std::atoi(row[1]));
+                feature.SetField("project", column(row, lengths, 2).c_str());
+                if (row[3]) feature.SetField("proc_id", std::atoi(row[3]));
+                if (row[4]) feature.SetField("procedure", column(row, lengths, 4).c_str());
+                if (row[5]) feature.SetField("airport", column(row, lengths, 5).c_str());
+                if (row[6]) feature.SetField("severity", column(row, lengths, 6).c_str());
+                if (row[7]) feature.SetField("overlap_m2", std::atof(row[7]));
+                if (row[8]) feature.SetField("overlap_r", std::atof(row[8]));
+                if (row[9]) feature.SetField("descr", column(row, lengths, 9).c_str());
+                if (row[10]) feature.SetField("created", row[10]);
+            } else {
+                feature.SetField("id", std::atoi(row[0]));
+                feature.SetField("procedure", column(row, lengths, 1).c_str());
+                if (row[2]) feature.SetField("name", column(row, lengths, 2).c_str());
+                if (row[3]) feature.SetField("type", column(row, lengths, 3).c_str());
+                if (row[4]) feature.SetField("airport", column(row, lengths, 4).c_str());
+                if (row[5]) feature.SetField("runway", column(row, lengths, 5).c_str());
+            }
+            feature.SetGeometryDirectly(geometry.release());
+
+            if (transactions && !output.in_transaction) {
+                output.in_transaction = output.dataset->StartTransaction() == OGRERR_NONE;
+            }
+            if (layer->CreateFeature(&feature) != OGRERR_NONE) {
+                error = std::string("Could not write feature: ") + CPLGetLastErrorMsg();
+                return false;
+            }
+            if (output.in_transaction && ++in_transaction >= kTransactionRows) {
+                output.dataset->CommitTransaction();
+                output.in_transaction = false;
+                in_transaction = 0;
+            }
+            progress.written.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        });
+
+    if (job.isCancelled()) {
+        return "Export cancelled";
+    }
+    if (error) return error;
+    if (!streamed) return "Reading the features failed";
+
+    jobs_.setStage(job.id, "closing");
+    std::error_code ec;
+    if (!output.close() || !std::filesystem::is_regular_file(path, ec)) {
+        return std::string("Could not finish the export file: ") + CPLGetLastErrorMsg();
+    }
+    features_.fetch_add(progress.written.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    return std::nullopt;
+}
+
+nlohmann::json ExportService::poolStats() const {
+    nlohmann::json j = jobs_.stats();
+    j["enabled"] = enabled();
+    j["features"] = features_.load(std::memory_order_relaxed);
+    return j;
+}
+
+} // namespace aeronautical
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <crow.h>
+#include "BackgroundJobs.h"
+#include "HttpApp.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <json.hpp>
+
+namespace aeronautical {
+
+struct ExportSettings {
+    bool enabled = true;
+    size_t workers = 1;
+    size_t max_jobs = 4;                  // exports queued or running before 429
+    std::string directory;                // empty: <temp>/aero-exports
+    std::chrono::seconds retention{3600}; // finished files are downloadable this long
+};
+
+struct ExportFormat {
+    const char* name;         // as requested
+    const char* driver;       // GDAL short name
+    const char* extension;
+    const char* content_type;
+    bool polygons_only;       // the Shapefile's single geometry family
+};
+
+// Conflicts or protection areas written to a GeoPackage, zipped Shapefile,
+// KML or GeoJSON file for regulators, per project, per airport or for the
+// whole country. Each export is a job on a small pool: it counts the rows,
+// then reads them through an unbuffered cursor (mysql_use_result) and
+// hands every feature to the GDAL driver as it arrives, so neither the rows
+// nor the features are ever held together in memory. Files live in
+// directory until retention has passed since the job finished.
+//
+// A Shapefile holds one geometry family, so its export keeps the polygons
+// and counts the rest as skipped; field names are at most ten characters
+// for the same reason, in every format alike.
+//
+//   POST   /api/exports              {"kind": "conflicts"|"protections", "format": "gpkg"|"shp"|"kml"|"geojson",
+//                                     "project_id"?: n, "airport_icao"?: "LFPG"}; 202 with the job
+//   GET    /api/exports/<id>         state, stage and features written of the total
+//   GET    /api/exports/<id>/file    the file, once completed
+//   DELETE /api/exports/<id>         cancels the job and removes its file
+class ExportService {
+public:
+    static ExportService& getInstance();
+
+    ExportService(const ExportService&) = delete;
+    ExportService& operator=(const ExportService&) = delete;
+
+    // Starts the workers and removes files left by a previous run; routes
+    // answer 503 until then or when disabled
+    void configure(const ExportSettings& settings);
+    // Cancels the running exports and joins the workers
+    void shutdown();
+    bool enabled() const;
+
+    void registerRoutes(HttpApp& app);
+
+    nlohmann::json poolStats() const;
+
+private:
+    enum class Kind { Conflicts, Protections };
+
+    // Written by the job, read by status polls
+    struct Progress {
+        std::atomic<size_t> total{0};
+        std::atomic<size_t> written{0};
+        std::atomic<size_t> skipped{0};
+    };
+
+    struct Job : BackgroundJob {
+        Kind kind = Kind::Conflicts;
+        const ExportFormat* format = nullptr;
+        std::optional<int> project_id;
+        std::optional<std::string> airport_icao;
+        size_t bytes = 0;
+        std::shared_ptr<Progress> progress = std::make_shared<Progress>();
+    };
+
+    ExportService();
+    ~ExportService();
+
+    crow::response submit(const crow::request& req);
+    void download(const crow::request& req, crow::response& res, uint64_t id);
+
+    // Runs on the pool
+    void process(uint64_t id);
+    // Writes the file; returns the error, if any
+    std::optional<std::string> write(const Job& job);
+
+    nlohmann::json jobJson(const Job& job) const;
+    std::string pathOf(const Job& job) const;
+
+    // Features per GeoPackage transaction
+    static constexpr size_t kTransactionRows = 10000;
+
+    // Written by configure() before the jobs start
+    ExportSettings settings_;
+    BackgroundJobs<Job> jobs_;
+
+    std::atomic<uint64_t> features_{0};
+};
+
+} // namespace aeronautical
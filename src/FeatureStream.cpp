@@ -0,0 +1,159 @@
+#include "FeatureStream.h"
+#include <cstdint>
+#include <vector>
+
+namespace aeronautical {
+
+namespace {
+
+// Builds the DOM the way nlohmann's own SAX DOM parser does, except for the
+// elements of geometry.features, which go to the callback one at a time
+class SubmissionSax {
+public:
+    SubmissionSax(nlohmann::json& root, const UploadLimits& limits, const FeatureStream::OnFeature& on_feature)
+        : root_(root), limits_(limits), on_feature_(on_feature) {}
+
+    bool null() { return value(nullptr); }
+    bool boolean(bool v) { return value(v); }
+    bool number_integer(int64_t v) { return number(v); }
+    bool number_unsigned(uint64_t v) { return number(v); }
+    bool number_float(double v, const std::string&) { return number(v); }
+    bool string(std::string& v) { return value(std::move(v)); }
+    bool binary(nlohmann::json::binary_t& v) { return value(std::move(v)); }
+
+    bool start_object(size_t) { return open(nlohmann::json::value_t::object); }
+    bool start_array(size_t) { return open(nlohmann::json::value_t::array); }
+    bool end_object() { return close(); }
+    bool end_array() { return close(); }
+
+    bool key(std::string& name) {
+        key_ = name;
+        member_ = &(*stack_.back().value)[name];
+        return true;
+    }
+
+    bool parse_error(size_t, const std::string&, const nlohmann::json::exception& e) {
+        status_ = FeatureStream::Status::Malformed;
+        error_ = e.what();
+        return false;
+    }
+
+    FeatureStream::Status status() const { return status_; }
+    const std::string& error() const { return error_; }
+    size_t vertices() const { return vertices_; }
+
+private:
+    struct Frame {
+        nlohmann::json* value = nullptr;
+        bool geometry = false;    // the submission's geometry object
+        bool features = false;    // its features array, never filled
+        bool feature = false;     // an element of features
+        bool in_geometry = false; // anywhere below the geometry member
+        bool has_number = false;
+    };
+
+    nlohmann::json* insert(nlohmann::json&& v) {
+        if (stack_.empty()) {
+            root_ = std::move(v);
+            return &root_;
+        }
+        Frame& top = stack_.back();
+        if (top.features) {
+            feature_ = std::move(v);
+            return &feature_;
+        }
+        if (top.value->is_array()) {
+            top.value->push_back(std::move(v));
+            return &top.value->back();
+        }
+        *member_ = std::move(v);
+        return member_;
+    }
+
+    bool value(nlohmann::json&& v) {
+        const bool feature = !stack_.empty() && stack_.back().features;
+        insert(std::move(v));
+        return feature ? deliver() : true;
+    }
+
+    bool number(nlohmann::json&& v) {
+        if (!stack_.empty()) stack_.back().has_number = true;
+        return value(std::move(v));
+    }
+
+    bool open(nlohmann::json::value_t type) {
+        const bool in_object = !stack_.empty() && stack_.back().value->is_object();
+        Frame frame;
+        frame.feature = !stack_.empty() && stack_.back().features;
+        frame.geometry = type == nlohmann::json::value_t::object && stack_.size() == 1 && in_object &&
+                         key_ == "geometry";
+        frame.features = type == nlohmann::json::value_t::array && stack_.size() == 2 && stack_[1].geometry &&
+                         in_object && key_ == "features";
+        frame.in_geometry = frame.geometry || (!stack_.empty() && stack_.back().in_geometry);
+        frame.value = insert(nlohmann::json(type));
+        stack_.push_back(frame);
+        return true;
+    }
+
+    bool close() {
+        const Frame frame = stack_.back();
+        stack_.pop_back();
+        // An array of numbers in the geometry is one position
+        if (frame.has_number && frame.in_geometry && frame.value->is_array() && ++vertices_ > limits_.max_vertices) {
+            status_ = FeatureStream::Status::TooLarge;
+            error_ = "More than " + std::to_string(limits_.max_vertices) + " vertices";
+            return false;
+        }
+        return frame.feature ? deliver() : true;
+    }
+
+    bool deliver() {
+        std::string rejection;
+        if (!on_feature_(feature_, rejection)) {
+            status_ = FeatureStream::Status::Rejected;
+            error_ = std::move(rejection);
+            return false;
+        }
+        feature_ = nullptr;
+        return true;
+    }
+
+    nlohmann::json& root_;
+    const UploadLimits& limits_;
+    const FeatureStream::OnFeature& on_feature_;
+    std::vector<Frame> stack_;
+    nlohmann::json* member_ = nullptr;
+    std::string key_;
+    nlohmann::json feature_;
+    size_t vertices_ = 0;
+    FeatureStream::Status status_ = FeatureStream::Status::Ok;
+    std::string error_;
+};
+
+} // namespace
+
+FeatureStream::Status FeatureStream::read(std::string_view body, const UploadLimits& limits, nlohmann::json& rest,
+                                          const OnFeature& on_feature, std::string& error, size_t* vertices) {
+    if (body.size() > limits.max_body_bytes) {
+        error = "Body larger than " + std::to_string(limits.max_body_bytes) + " bytes";
+        return Status::TooLarge;
+    }
+    SubmissionSax sax(rest, limits, on_feature);
+    const bool parsed = nlohmann::json::sax_parse(body.begin(), body.end(), &sax);
+    if (vertices) *vertices = sax.vertices();
+    if (sax.status() != Status::Ok) {
+        error = sax.error();
+        return sax.status();
+    }
+    if (!parsed) {
+        error = "Malformed JSON";
+        return Status::Malformed;
+    }
+    if (!rest.is_object()) {
+        error = "Body must be a JSON object";
+        return Status::Malformed;
+    }
+    return Status::Ok;
+}
+
+} // namespace aeronautical
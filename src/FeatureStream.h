@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <json.hpp>
+
+namespace aeronautical {
+
+struct UploadLimits {
+    size_t max_body_bytes = size_t(64) << 20;
+    size_t max_vertices = 5000000; // positions over all features of one upload
+};
+
+// Reads a project submission ({"geometry": FeatureCollection, ...}) with a
+// SAX parser: each element of geometry.features is built on its own and
+// handed to on_feature as soon as it is complete, then dropped, so only one
+// feature is ever held as a DOM. Everything else lands in rest, with
+// geometry.features left empty. Positions are counted as they are read and
+// the parse stops once there are more than max_vertices.
+class FeatureStream {
+public:
+    enum class Status { Ok, Malformed, TooLarge, Rejected };
+
+    // Returns false, with error set, to reject the upload
+    using OnFeature = std::function<bool(nlohmann::json& feature, std::string& error)>;
+
+    static Status read(std::string_view body, const UploadLimits& limits, nlohmann::json& rest,
+                       const OnFeature& on_feature, std::string& error, size_t* vertices = nullptr);
+};
+
+} // namespace aeronautical
@@ -0,0 +1,93 @@
+#include "FileResponse.h"
+#include <charconv>
+#include <optional>
+#include <string_view>
+
+namespace aeronautical {
+
+namespace {
+
+struct ByteRange {
+    off_t offset = 0;
+    off_t length = 0;
+};
+
+// A non-negative decimal; from_chars would take a sign into off_t, and
+// bytes=--5 would then end past the file
+std::optional<off_t> parseOffset(std::string_view text) {
+    if (text.empty() || text.front() == '-') return std::nullopt;
+    off_t value = 0;
+    auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (ec != std::errc() || end != text.data() + text.size() || value < 0) return std::nullopt;
+    return value;
+}
+
+// nullopt when the header is absent, malformed or names several ranges
+// (all served as a full response); length 0 when it cannot be satisfied
+std::optional<ByteRange> parseRange(std::string_view header, off_t size) {
+    if (header.substr(0, 6) != "bytes=" || header.find(',') != std::string_view::npos) return std::nullopt;
+    header.remove_prefix(6);
+    const size_t dash = header.find('-');
+    if (dash == std::string_view::npos) return std::nullopt;
+    const std::string_view first = header.substr(0, dash);
+    const std::string_view last = header.substr(dash + 1);
+
+    ByteRange range;
+    if (first.empty()) {
+        // bytes=-N: the final N bytes
+        auto suffix = parseOffset(last);
+        if (!suffix) return std::nullopt;
+        range.length = std::min(*suffix, size);
+        range.offset = size - range.length;
+        return range;
+    }
+    auto start = parseOffset(first);
+    if (!start) return std::nullopt;
+    if (*start >= size) return range;
+    off_t end = size - 1;
+    if (!last.empty()) {
+        auto stop = parseOffset(last);
+        if (!stop || *stop < *start) return std::nullopt;
+        end = std::min(*stop, size - 1);
+    }
+    range.offset = *start;
+    range.length = end - *start + 1;
+    return range;
+}
+
+} // namespace
+
+void FileResponse::prepare(const crow::request& req, crow::response& res, const std::string& path,
+                           const std::string& content_type, const std::string& etag) {
+    res.set_static_file_info_unsafe(path);
+    if (!res.is_static_type()) {
+        res.code = 404;
+        res.body = "{\"error\":true,\"message\":\"File not found\"}";
+        res.set_header("Content-Type", "application/json");
+        return;
+    }
+    if (!content_type.empty()) res.set_header("Content-Type", content_type);
+    if (!etag.empty()) res.set_header("ETag", etag);
+    res.set_header("Accept-Ranges", "bytes");
+
+    const std::string& if_range = req.get_header_value("If-Range");
+    if (!if_range.empty() && (etag.empty() || if_range != etag)) return;
+    auto size = parseOffset(res.get_header_value("Content-Length"));
+    if (!size) return;
+    auto range = parseRange(req.get_header_value("Range"), *size);
+    if (!range) return;
+    if (range->length == 0) {
+        res.code = 416;
+        res.set_header("Content-Range", "bytes */" + std::to_string(*size));
+        res.set_header("Content-Length", "0");
+        res.set_static_file_range(0, 0);
+        return;
+    }
+    res.code = 206;
+    res.set_static_file_range(range->offset, range->length);
+    res.set_header("Content-Range", "bytes " + std::to_string(range->offset) + "-" +
+                                        std::to_string(range->offset + range->length - 1) + "/" + std::to_string(*size));
+    res.set_header("Content-Length", std::to_string(range->length));
+}
+
+} // namespace aeronautical
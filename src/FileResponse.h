@@ -0,0 +1,21 @@
+#pragma once
+
+#include <crow.h>
+#include <string>
+
+namespace aeronautical {
+
+// Responses whose body is a file on disk. The connection writes the file
+// itself with sendfile(2) on plain sockets (see do_write_static in the
+// vendored Crow), so its contents never pass through user space, and the
+// response middlewares leave such bodies alone. A single "bytes=" Range is
+// answered with 206 and that slice; several ranges get the whole file.
+class FileResponse {
+public:
+    // Sets res up to send path, or 404 when it is not a regular file. etag
+    // (quoted) is compared with If-Range; without one, ranges always apply.
+    static void prepare(const crow::request& req, crow::response& res, const std::string& path,
+                        const std::string& content_type = {}, const std::string& etag = {});
+};
+
+} // namespace aeronautical
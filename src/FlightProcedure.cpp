@@ -1,4 +1,8 @@
 #include "FlightProcedure.h"
+#include "EnumNames.h"
+#include "JsonWriter.h"
+#include <algorithm>
+#include <iterator>
 #include <sstream>
 #include <iomanip>
 #include <ctime>
@@ -6,152 +10,166 @@
 namespace aeronautical {
 
 // Enum conversion functions
+namespace {
+
+constexpr EnumNames<ProcedureType, 5> kProcedureTypes({{
+    {ProcedureType::SID, "SID"},
+    {ProcedureType::STAR, "STAR"},
+    {ProcedureType::APPROACH, "APPROACH"},
+    {ProcedureType::DEPARTURE, "DEPARTURE"},
+    {ProcedureType::ARRIVAL, "ARRIVAL"}}},
+    ProcedureType::SID);
+
+constexpr EnumNames<AltitudeRestriction, 4> kAltitudeRestrictions({{
+    {AltitudeRestriction::At, "at"},
+    {AltitudeRestriction::AtOrAbove, "at_or_above"},
+    {AltitudeRestriction::AtOrBelow, "at_or_below"},
+    {AltitudeRestriction::Between, "between"}}},
+    AltitudeRestriction::At);
+
+constexpr EnumNames<SpeedRestriction, 3> kSpeedRestrictions({{
+    {SpeedRestriction::At, "at"},
+    {SpeedRestriction::AtOrBelow, "at_or_below"},
+    {SpeedRestriction::AtOrAbove, "at_or_above"}}},
+    SpeedRestriction::At);
+
+constexpr EnumNames<TurnDirection, 3> kTurnDirections({{
+    {TurnDirection::Left, "left"},
+    {TurnDirection::Right, "right"},
+    {TurnDirection::Straight, "straight"}}},
+    TurnDirection::Straight);
+
+constexpr EnumNames<ProtectionType, 10> kProtectionTypes({{
+    {ProtectionType::OverallPrimary, "overall_primary"},
+    {ProtectionType::OverallSecondary, "overall_secondary"},
+    {ProtectionType::NoiseAbatement, "noise_abatement"},
+    {ProtectionType::Environmental, "environmental"},
+    {ProtectionType::ObstacleClearance, "obstacle_clearance"},
+    {ProtectionType::TerrainClearance, "terrain_clearance"},
+    {ProtectionType::CommunicationZone, "communication_zone"},
+    {ProtectionType::SurveillanceZone, "surveillance_zone"},
+    {ProtectionType::BufferZone, "buffer_zone"},
+    {ProtectionType::RestrictedArea, "restricted_area"}}},
+    ProtectionType::OverallPrimary);
+
+constexpr EnumNames<RestrictionLevel, 5> kRestrictionLevels({{
+    {RestrictionLevel::Prohibited, "prohibited"},
+    {RestrictionLevel::Restricted, "restricted"},
+    {RestrictionLevel::Caution, "caution"},
+    {RestrictionLevel::Advisory, "advisory"},
+    {RestrictionLevel::Monitoring, "monitoring"}}},
+    RestrictionLevel::Restricted);
+
+constexpr EnumNames<ConflictSeverity, 5> kConflictSeverities({{
+    {ConflictSeverity::Critical, "critical"},
+    {ConflictSeverity::High, "high"},
+    {ConflictSeverity::Medium, "medium"},
+    {ConflictSeverity::Low, "low"},
+    {ConflictSeverity::Informational, "informational"}}},
+    ConflictSeverity::Medium);
+
+constexpr EnumNames<AltitudeReference, 3> kAltitudeReferences({{
+    {AltitudeReference::MSL, "MSL"},
+    {AltitudeReference::AGL, "AGL"},
+    {AltitudeReference::FL, "FL"}}},
+    AltitudeReference::MSL);
+
+} // namespace
+
+std::string_view procedureTypeName(ProcedureType type) {
+    return kProcedureTypes.name(type);
+}
+
 std::string procedureTypeToString(ProcedureType type) {
-    switch (type) {
-        case ProcedureType::SID: return "SID";
-        case ProcedureType::STAR: return "STAR";
-        case ProcedureType::APPROACH: return "APPROACH";
-        case ProcedureType::DEPARTURE: return "DEPARTURE";
-        case ProcedureType::ARRIVAL: return "ARRIVAL";
-        default: return "SID";
-    }
+    return std::string(kProcedureTypes.name(type));
+}
+
+ProcedureType stringToProcedureType(std::string_view str) {
+    return kProcedureTypes.parse(str);
 }
 
-ProcedureType stringToProcedureType(const std::string& str) {
-    if (str == "STAR") return ProcedureType::STAR;
-    if (str == "APPROACH") return ProcedureType::APPROACH;
-    if (str == "DEPARTURE") return ProcedureType::DEPARTURE;
-    if (str == "ARRIVAL") return ProcedureType::ARRIVAL;
-    return ProcedureType::SID;
+std::string_view altitudeRestrictionName(AltitudeRestriction restriction) {
+    return kAltitudeRestrictions.name(restriction);
 }
 
 std::string altitudeRestrictionToString(AltitudeRestriction restriction) {
-    switch (restriction) {
-        case AltitudeRestriction::At: return "at";
-        case AltitudeRestriction::AtOrAbove: return "at_or_above";
-        case AltitudeRestriction::AtOrBelow: return "at_or_below";
-        case AltitudeRestriction::Between: return "between";
-        default: return "at";
-    }
+    return std::string(kAltitudeRestrictions.name(restriction));
+}
+
+AltitudeRestriction stringToAltitudeRestriction(std::string_view str) {
+    return kAltitudeRestrictions.parse(str);
 }
 
-AltitudeRestriction stringToAltitudeRestriction(const std::string& str) {
-    if (str == "at_or_above") return AltitudeRestriction::AtOrAbove;
-    if (str == "at_or_below") return AltitudeRestriction::AtOrBelow;
-    if (str == "between") return AltitudeRestriction::Between;
-    return AltitudeRestriction::At;
+std::string_view speedRestrictionName(SpeedRestriction restriction) {
+    return kSpeedRestrictions.name(restriction);
 }
 
 std::string speedRestrictionToString(SpeedRestriction restriction) {
-    switch (restriction) {
-        case SpeedRestriction::At: return "at";
-        case SpeedRestriction::AtOrBelow: return "at_or_below";
-        case SpeedRestriction::AtOrAbove: return "at_or_above";
-        default: return "at";
-    }
+    return std::string(kSpeedRestrictions.name(restriction));
+}
+
+SpeedRestriction stringToSpeedRestriction(std::string_view str) {
+    return kSpeedRestrictions.parse(str);
 }
 
-SpeedRestriction stringToSpeedRestriction(const std::string& str) {
-    if (str == "at_or_below") return SpeedRestriction::AtOrBelow;
-    if (str == "at_or_above") return SpeedRestriction::AtOrAbove;
-    return SpeedRestriction::At;
+std::string_view turnDirectionName(TurnDirection direction) {
+    return kTurnDirections.name(direction);
 }
 
 std::string turnDirectionToString(TurnDirection direction) {
-    switch (direction) {
-        case TurnDirection::Left: return "left";
-        case TurnDirection::Right: return "right";
-        case TurnDirection::Straight: return "straight";
-        default: return "straight";
-    }
+    return std::string(kTurnDirections.name(direction));
+}
+
+TurnDirection stringToTurnDirection(std::string_view str) {
+    return kTurnDirections.parse(str);
 }
 
-TurnDirection stringToTurnDirection(const std::string& str) {
-    if (str == "left") return TurnDirection::Left;
-    if (str == "right") return TurnDirection::Right;
-    return TurnDirection::Straight;
+std::string_view protectionTypeName(ProtectionType type) {
+    return kProtectionTypes.name(type);
 }
 
 std::string protectionTypeToString(ProtectionType type) {
-    switch (type) {
-        case ProtectionType::OverallPrimary: return "overall_primary";
-        case ProtectionType::OverallSecondary: return "overall_secondary";
-        case ProtectionType::NoiseAbatement: return "noise_abatement";
-        case ProtectionType::Environmental: return "environmental";
-        case ProtectionType::ObstacleClearance: return "obstacle_clearance";
-        case ProtectionType::TerrainClearance: return "terrain_clearance";
-        case ProtectionType::CommunicationZone: return "communication_zone";
-        case ProtectionType::SurveillanceZone: return "surveillance_zone";
-        case ProtectionType::BufferZone: return "buffer_zone";
-        case ProtectionType::RestrictedArea: return "restricted_area";
-        default: return "overall_primary";
-    }
+    return std::string(kProtectionTypes.name(type));
 }
 
-ProtectionType stringToProtectionType(const std::string& str) {
-    if (str == "overall_secondary") return ProtectionType::OverallSecondary;
-    if (str == "noise_abatement") return ProtectionType::NoiseAbatement;
-    if (str == "environmental") return ProtectionType::Environmental;
-    if (str == "obstacle_clearance") return ProtectionType::ObstacleClearance;
-    if (str == "terrain_clearance") return ProtectionType::TerrainClearance;
-    if (str == "communication_zone") return ProtectionType::CommunicationZone;
-    if (str == "surveillance_zone") return ProtectionType::SurveillanceZone;
-    if (str == "buffer_zone") return ProtectionType::BufferZone;
-    if (str == "restricted_area") return ProtectionType::RestrictedArea;
-    return ProtectionType::OverallPrimary;
+ProtectionType stringToProtectionType(std::string_view str) {
+    return kProtectionTypes.parse(str);
+}
+
+std::string_view restrictionLevelName(RestrictionLevel level) {
+    return kRestrictionLevels.name(level);
 }
 
 std::string restrictionLevelToString(RestrictionLevel level) {
-    switch (level) {
-        case RestrictionLevel::Prohibited: return "prohibited";
-        case RestrictionLevel::Restricted: return "restricted";
-        case RestrictionLevel::Caution: return "caution";
-        case RestrictionLevel::Advisory: return "advisory";
-        case RestrictionLevel::Monitoring: return "monitoring";
-        default: return "restricted";
-    }
+    return std::string(kRestrictionLevels.name(level));
 }
 
-RestrictionLevel stringToRestrictionLevel(const std::string& str) {
-    if (str == "prohibited") return RestrictionLevel::Prohibited;
-    if (str == "caution") return RestrictionLevel::Caution;
-    if (str == "advisory") return RestrictionLevel::Advisory;
-    if (str == "monitoring") return RestrictionLevel::Monitoring;
-    return RestrictionLevel::Restricted;
+RestrictionLevel stringToRestrictionLevel(std::string_view str) {
+    return kRestrictionLevels.parse(str);
+}
+
+std::string_view conflictSeverityName(ConflictSeverity severity) {
+    return kConflictSeverities.name(severity);
 }
 
 std::string conflictSeverityToString(ConflictSeverity severity) {
-    switch (severity) {
-        case ConflictSeverity::Critical: return "critical";
-        case ConflictSeverity::High: return "high";
-        case ConflictSeverity::Medium: return "medium";
-        case ConflictSeverity::Low: return "low";
-        case ConflictSeverity::Informational: return "informational";
-        default: return "medium";
-    }
+    return std::string(kConflictSeverities.name(severity));
 }
 
-ConflictSeverity stringToConflictSeverity(const std::string& str) {
-    if (str == "critical") return ConflictSeverity::Critical;
-    if (str == "high") return ConflictSeverity::High;
-    if (str == "low") return ConflictSeverity::Low;
-    if (str == "informational") return ConflictSeverity::Informational;
-    return ConflictSeverity::Medium;
+ConflictSeverity stringToConflictSeverity(std::string_view str) {
+    return kConflictSeverities.parse(str);
+}
+
+std::string_view altitudeReferenceName(AltitudeReference ref) {
+    return kAltitudeReferences.name(ref);
 }
 
 std::string altitudeReferenceToString(AltitudeReference ref) {
-    switch (ref) {
-        case AltitudeReference::MSL: return "MSL";
-        case AltitudeReference::AGL: return "AGL";
-        case AltitudeReference::FL: return "FL";
-        default: return "MSL";
-    }
+    return std::string(kAltitudeReferences.name(ref));
 }
 
-AltitudeReference stringToAltitudeReference(const std::string& str) {
-    if (str == "AGL") return AltitudeReference::AGL;
-    if (str == "FL") return AltitudeReference::FL;
-    return AltitudeReference::MSL;
+AltitudeReference stringToAltitudeReference(std::string_view str) {
+    return kAltitudeReferences.parse(str);
 }
 
 // ProcedureSegment implementation
@@ -201,11 +219,11 @@ ProcedureSegment ProcedureSegment::fromJson(const nlohmann::json& j) {
     if (j.contains("altitude_max") && !j["altitude_max"].is_null()) 
         s.altitude_max = j["altitude_max"];
     if (j.contains("altitude_restriction") && !j["altitude_restriction"].is_null()) 
-        s.altitude_restriction = stringToAltitudeRestriction(j["altitude_restriction"]);
+        s.altitude_restriction = stringToAltitudeRestriction(j["altitude_restriction"].get_ref<const std::string&>());
     if (j.contains("speed_limit") && !j["speed_limit"].is_null()) 
         s.speed_limit = j["speed_limit"];
     if (j.contains("speed_restriction") && !j["speed_restriction"].is_null()) 
-        s.speed_restriction = stringToSpeedRestriction(j["speed_restriction"]);
+        s.speed_restriction = stringToSpeedRestriction(j["speed_restriction"].get_ref<const std::string&>());
     if (j.contains("trajectory_geometry")) {
         if (j["trajectory_geometry"].is_string()) {
             s.trajectory_geometry = j["trajectory_geometry"];
@@ -218,7 +236,7 @@ ProcedureSegment ProcedureSegment::fromJson(const nlohmann::json& j) {
     if (j.contains("magnetic_course") && !j["magnetic_course"].is_null()) 
         s.magnetic_course = j["magnetic_course"];
     if (j.contains("turn_direction")) 
-        s.turn_direction = stringToTurnDirection(j["turn_direction"]);
+        s.turn_direction = stringToTurnDirection(j["turn_direction"].get_ref<const std::string&>());
     if (j.contains("is_mandatory")) 
         s.is_mandatory = j["is_mandatory"];
     
@@ -275,7 +293,7 @@ ProcedureProtection ProcedureProtection::fromJson(const nlohmann::json& j) {
     if (j.contains("id")) p.id = j["id"];
     if (j.contains("procedure_id")) p.procedure_id = j["procedure_id"];
     if (j.contains("protection_name")) p.protection_name = j["protection_name"];
-    if (j.contains("protection_type")) p.protection_type = stringToProtectionType(j["protection_type"]);
+    if (j.contains("protection_type")) p.protection_type = stringToProtectionType(j["protection_type"].get_ref<const std::string&>());
     if (j.contains("description") && !j["description"].is_null()) 
         p.description = j["description"];
     if (j.contains("protection_geometry")) {
@@ -290,7 +308,7 @@ ProcedureProtection ProcedureProtection::fromJson(const nlohmann::json& j) {
     if (j.contains("altitude_max") && !j["altitude_max"].is_null()) 
         p.altitude_max = j["altitude_max"];
     if (j.contains("altitude_reference")) 
-        p.altitude_reference = stringToAltitudeReference(j["altitude_reference"]);
+        p.altitude_reference = stringToAltitudeReference(j["altitude_reference"].get_ref<const std::string&>());
     if (j.contains("area_size") && !j["area_size"].is_null()) 
         p.area_size = j["area_size"];
     if (j.contains("center_lat") && !j["center_lat"].is_null()) 
@@ -300,9 +318,9 @@ ProcedureProtection ProcedureProtection::fromJson(const nlohmann::json& j) {
     if (j.contains("buffer_distance") && !j["buffer_distance"].is_null()) 
         p.buffer_distance = j["buffer_distance"];
     if (j.contains("restriction_level")) 
-        p.restriction_level = stringToRestrictionLevel(j["restriction_level"]);
+        p.restriction_level = stringToRestrictionLevel(j["restriction_level"].get_ref<const std::string&>());
     if (j.contains("conflict_severity")) 
-        p.conflict_severity = stringToConflictSeverity(j["conflict_severity"]);
+        p.conflict_severity = stringToConflictSeverity(j["conflict_severity"].get_ref<const std::string&>());
     if (j.contains("analysis_priority")) 
         p.analysis_priority = j["analysis_priority"];
     if (j.contains("time_restriction") && !j["time_restriction"].is_null()) 
@@ -339,28 +357,119 @@ nlohmann::json FlightProcedure::toJson() const {
 
     if (trajectory_geometry) j["trajectory_geometry"] = *trajectory_geometry;
     if (protection_geometry) j["protection_geometry"] = *protection_geometry;
-    
-    // // Add segments and protections
-    // j["segments"] = nlohmann::json::array();
-    // for (const auto& segment : segments) {
-    //     j["segments"].push_back(segment.toJson());
-    // }
-    
-    // j["protections"] = nlohmann::json::array();
-    // for (const auto& protection : protections) {
-    //     j["protections"].push_back(protection.toJson());
-    // }
+
+    // Only when loaded, so procedures without related rows read as before
+    if (!segments.empty()) {
+        j["segments"] = nlohmann::json::array();
+        for (const auto& segment : segments) {
+            j["segments"].push_back(segment.toJson());
+        }
+    }
+    if (!protections.empty()) {
+        j["protections"] = nlohmann::json::array();
+        for (const auto& protection : protections) {
+            j["protections"].push_back(protection.toJson());
+        }
+    }
     
     return j;
 }
 
+// Keys in sorted order, as nlohmann's object dumps them; unset optionals are omitted
+std::optional<uint32_t> FlightProcedure::parseFields(std::string_view list) {
+    // Bit i is names[i]
+    static constexpr std::string_view names[] = {
+        "airport_icao", "created_at", "description", "effective_date", "expiry_date", "id", "is_active",
+        "name", "procedure_code", "protection_geometry", "runway", "trajectory_geometry", "type", "updated_at",
+        "protections", "segments"};
+    uint32_t fields = 0;
+    while (!list.empty()) {
+        const size_t comma = list.find(',');
+        std::string_view name = list.substr(0, comma);
+        list = comma == std::string_view::npos ? std::string_view() : list.substr(comma + 1);
+        while (!name.empty() && name.front() == ' ') name.remove_prefix(1);
+        while (!name.empty() && name.back() == ' ') name.remove_suffix(1);
+        if (name.empty()) continue;
+        const auto* it = std::find(std::begin(names), std::end(names), name);
+        if (it == std::end(names)) return std::nullopt;
+        fields |= 1u << (it - std::begin(names));
+    }
+    return fields;
+}
+
+void FlightProcedure::writeJson(JsonWriter& writer, uint32_t fields) const {
+    writer.beginObject();
+    if (fields & kAirportIcao) writer.rawField("airport_icao", airport_icao);
+    if (fields & kCreatedAt) writer.rawField("created_at", created_at);
+    if (description && (fields & kDescription)) writer.rawField("description", *description);
+    if (effective_date && (fields & kEffectiveDate)) writer.rawField("effective_date", *effective_date);
+    if (expiry_date && (fields & kExpiryDate)) writer.rawField("expiry_date", *expiry_date);
+    if (fields & kId) writer.rawField("id", id);
+    if (fields & kIsActive) writer.rawField("is_active", is_active);
+    if (fields & kName) writer.rawField("name", name);
+    if (fields & kProcedureCode) writer.rawField("procedure_code", procedure_code);
+    if (protection_geometry && (fields & kProtectionGeometry)) writer.rawField("protection_geometry", *protection_geometry);
+    if (!protections.empty() && (fields & kProtections)) {
+        writer.rawKey("protections").beginArray();
+        for (const auto& protection : protections) writer.value(protection.toJson());
+        writer.endArray();
+    }
+    if (runway && (fields & kRunway)) writer.rawField("runway", *runway);
+    if (!segments.empty() && (fields & kSegments)) {
+        writer.rawKey("segments").beginArray();
+        for (const auto& segment : segments) writer.value(segment.toJson());
+        writer.endArray();
+    }
+    if (trajectory_geometry && (fields & kTrajectoryGeometry)) writer.rawField("trajectory_geometry", *trajectory_geometry);
+    if (fields & kType) writer.rawField("type", procedureTypeName(type));
+    if (fields & kUpdatedAt) writer.rawField("updated_at", updated_at);
+    writer.endObject();
+}
+
+void Conflict::writeJson(JsonWriter& writer, bool geometry) const {
+    writer.beginObject();
+    if (geometry) writer.rawField("conflicting_geometry", conflicting_geometry);
+    writer.rawField("created_at", created_at)
+          .rawField("description", description)
+          .rawField("flight_procedure_id", flight_procedure_id)
+          .rawField("id", id);
+    if (overlap_area) writer.rawField("overlap_area", *overlap_area);
+    if (overlap_ratio) writer.rawField("overlap_ratio", *overlap_ratio);
+    if (penetration_depth_ft) writer.rawField("penetration_depth_ft", *penetration_depth_ft);
+    writer.rawField("project_id", project_id);
+    if (protection_snapshot) writer.rawField("protection_snapshot", *protection_snapshot);
+    if (severity) writer.rawField("severity", *severity);
+    writer.rawField("updated_at", updated_at);
+    if (vertical_clearance_ft) writer.rawField("vertical_clearance_ft", *vertical_clearance_ft);
+    writer.endObject();
+}
+
+void ConflictSummary::add(int procedure_id, const std::string& severity, size_t conflicts) {
+    count += conflicts;
+    by_severity[severity] += conflicts;
+    procedure_ids.insert(procedure_id);
+}
+
+void ConflictSummary::writeJson(JsonWriter& writer, int project_id) const {
+    writer.beginObject().field("project_id", project_id).field("count", static_cast<uint64_t>(count));
+    writer.key("by_severity").beginObject();
+    for (const auto& [severity, conflicts] : by_severity) {
+        writer.field(severity, static_cast<uint64_t>(conflicts));
+    }
+    writer.endObject().key("procedure_ids").beginArray();
+    for (int id : procedure_ids) {
+        writer.value(id);
+    }
+    writer.endArray().endObject();
+}
+
 FlightProcedure FlightProcedure::fromJson(const nlohmann::json& j) {
     FlightProcedure p;
     
     if (j.contains("id")) p.id = j["id"];
     if (j.contains("procedure_code")) p.procedure_code = j["procedure_code"];
     if (j.contains("name")) p.name = j["name"];
-    if (j.contains("type")) p.type = stringToProcedureType(j["type"]);
+    if (j.contains("type")) p.type = stringToProcedureType(j["type"].get_ref<const std::string&>());
     if (j.contains("airport_icao")) p.airport_icao = j["airport_icao"];
     if (j.contains("runway") && !j["runway"].is_null()) 
         p.runway = j["runway"];
@@ -1,13 +1,20 @@
 #pragma once
 
+#include "ProtectionFootprint.h"
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <optional>
 #include <chrono>
+#include <map>
+#include <set>
 #include <vector>
 #include <json.hpp>
 
 namespace aeronautical {
 
+class JsonWriter;
+
 enum class ProcedureType {
     SID,
     STAR,
@@ -70,23 +77,32 @@ enum class AltitudeReference {
     FL
 };
 
-// Convert enums to/from strings
+// Convert enums to/from strings. *Name returns a view of a static string;
+// unknown names parse to the enum's default.
+std::string_view procedureTypeName(ProcedureType type);
 std::string procedureTypeToString(ProcedureType type);
-ProcedureType stringToProcedureType(const std::string& str);
+ProcedureType stringToProcedureType(std::string_view str);
+std::string_view altitudeRestrictionName(AltitudeRestriction restriction);
 std::string altitudeRestrictionToString(AltitudeRestriction restriction);
-AltitudeRestriction stringToAltitudeRestriction(const std::string& str);
+AltitudeRestriction stringToAltitudeRestriction(std::string_view str);
+std::string_view speedRestrictionName(SpeedRestriction restriction);
 std::string speedRestrictionToString(SpeedRestriction restriction);
-SpeedRestriction stringToSpeedRestriction(const std::string& str);
+SpeedRestriction stringToSpeedRestriction(std::string_view str);
+std::string_view turnDirectionName(TurnDirection direction);
 std::string turnDirectionToString(TurnDirection direction);
-TurnDirection stringToTurnDirection(const std::string& str);
+TurnDirection stringToTurnDirection(std::string_view str);
+std::string_view protectionTypeName(ProtectionType type);
 std::string protectionTypeToString(ProtectionType type);
-ProtectionType stringToProtectionType(const std::string& str);
+ProtectionType stringToProtectionType(std::string_view str);
+std::string_view restrictionLevelName(RestrictionLevel level);
 std::string restrictionLevelToString(RestrictionLevel level);
-RestrictionLevel stringToRestrictionLevel(const std::string& str);
+RestrictionLevel stringToRestrictionLevel(std::string_view str);
+std::string_view conflictSeverityName(ConflictSeverity severity);
 std::string conflictSeverityToString(ConflictSeverity severity);
-ConflictSeverity stringToConflictSeverity(const std::string& str);
+ConflictSeverity stringToConflictSeverity(std::string_view str);
+std::string_view altitudeReferenceName(AltitudeReference ref);
 std::string altitudeReferenceToString(AltitudeReference ref);
-AltitudeReference stringToAltitudeReference(const std::string& str);
+AltitudeReference stringToAltitudeReference(std::string_view str);
 
 struct ProcedureSegment {
     int id;
@@ -116,7 +132,7 @@ struct ProcedureProtection {
     std::string protection_name;
     ProtectionType protection_type;
     std::optional<std::string> description;
-    std::string protection_geometry; // GeoJSON Polygon
+    std::string protection_geometry; // GeoJSON geometry or FeatureCollection
     std::optional<int> altitude_min;
     std::optional<int> altitude_max;
     AltitudeReference altitude_reference = AltitudeReference::MSL;
@@ -142,6 +158,14 @@ struct ProcedureProtection {
     std::optional<int> last_reviewed_by;
     std::optional<std::chrono::system_clock::time_point> last_review_date;
     
+    // Filled by findActiveProtectionHeaders: UNIX_TIMESTAMP(updated_at), the
+    // stored footprint when it was computed from this version, the
+    // procedure's airport and the content hash of its stored WKB when current
+    int64_t revision = 0;
+    std::optional<ProtectionFootprint> footprint;
+    std::string airport_icao;
+    std::string geometry_hash;
+    
     nlohmann::json toJson() const;
     static ProcedureProtection fromJson(const nlohmann::json& j);
 };
@@ -167,10 +191,39 @@ struct FlightProcedure {
     std::optional<std::string> trajectory_geometry;  // GeoJSON LineString
     std::optional<std::string> protection_geometry;  // GeoJSON FeatureCollection
     
-    // std::vector<ProcedureSegment> segments;
-    // std::vector<ProcedureProtection> protections;
+    // Rows of procedure_segments and flight_procedure_protection, filled by
+    // the repository's batched loaders when those tables exist
+    std::vector<ProcedureSegment> segments;
+    std::vector<ProcedureProtection> protections;
     
+    // One bit per JSON member, for writing a projection of them
+    enum JsonField : uint32_t {
+        kAirportIcao = 1u << 0,
+        kCreatedAt = 1u << 1,
+        kDescription = 1u << 2,
+        kEffectiveDate = 1u << 3,
+        kExpiryDate = 1u << 4,
+        kId = 1u << 5,
+        kIsActive = 1u << 6,
+        kName = 1u << 7,
+        kProcedureCode = 1u << 8,
+        kProtectionGeometry = 1u << 9,
+        kRunway = 1u << 10,
+        kTrajectoryGeometry = 1u << 11,
+        kType = 1u << 12,
+        kUpdatedAt = 1u << 13,
+        kProtections = 1u << 14,
+        kSegments = 1u << 15,
+    };
+    static constexpr uint32_t kAllFields = (1u << 16) - 1;
+    // Bits of a comma-separated list of member names ("fields" query
+    // parameter); nullopt when a name is unknown
+    static std::optional<uint32_t> parseFields(std::string_view list);
+
     nlohmann::json toJson() const;
+    // Same output as toJson().dump(), written straight into the writer;
+    // fields limits it to those members
+    void writeJson(JsonWriter& writer, uint32_t fields = kAllFields) const;
     static FlightProcedure fromJson(const nlohmann::json& j);
 };
 
@@ -184,6 +237,16 @@ struct Conflict {
     int flight_procedure_id;
     std::string conflicting_geometry; // Storing as a string (e.g., WKT or GeoJSON)
     std::optional<std::string> description;
+    // Set when the analysis stored overlap metrics (see ConflictMetrics)
+    std::optional<std::string> severity;
+    std::optional<double> overlap_area;
+    std::optional<double> overlap_ratio;
+    // Feet from the project top up to the zone floor (negative inside the
+    // zone) and how deep the project reaches into it, when both bands are known
+    std::optional<double> vertical_clearance_ft;
+    std::optional<double> penetration_depth_ft;
+    // Protection snapshot the analysis ran against (see ConflictController::ProtectionSet)
+    std::optional<std::string> protection_snapshot;
     
     // Timestamps are managed by the database but can be useful to hold in the object
     std::chrono::system_clock::time_point created_at;
@@ -206,11 +269,22 @@ struct Conflict {
             j["description"] = nullptr;
         }
 
+        if (severity) j["severity"] = *severity;
+        if (overlap_area) j["overlap_area"] = *overlap_area;
+        if (overlap_ratio) j["overlap_ratio"] = *overlap_ratio;
+        if (vertical_clearance_ft) j["vertical_clearance_ft"] = *vertical_clearance_ft;
+        if (penetration_depth_ft) j["penetration_depth_ft"] = *penetration_depth_ft;
+        if (protection_snapshot) j["protection_snapshot"] = *protection_snapshot;
+
         j["created_at"] = timePointToString(created_at);
         j["updated_at"] = timePointToString(updated_at);
         return j;
     }
 
+    // Same output as toJson().dump(), written straight into the writer;
+    // without geometry conflicting_geometry is left out
+    void writeJson(JsonWriter& writer, bool geometry = true) const;
+
     /**
      * @brief Creates a Conflict struct from a JSON object.
      * * @param j The JSON object to parse.
@@ -239,6 +313,19 @@ struct Conflict {
     }
 };
 
+// Conflicts of one project without their geometry: what a reviewer needs
+// before opening any of them
+struct ConflictSummary {
+    static constexpr const char* kUnclassified = "unclassified"; // stored without metrics
+
+    size_t count = 0;
+    std::map<std::string, size_t> by_severity;
+    std::set<int> procedure_ids;
+
+    void add(int procedure_id, const std::string& severity, size_t conflicts = 1);
+    void writeJson(JsonWriter& writer, int project_id) const;
+};
+
 
 
 
@@ -1,5 +1,23 @@
 #include "FlightProcedureController.h"
+#include "AccessProfile.h"
+#include "JsonWriter.h"
+#include "ProtectionGeometryCache.h"
+#include "CacheEvents.h"
+#include "ChangeLog.h"
+#include "ConditionalGet.h"
+#include "GeometryEncoder.h"
+#include "SimplifiedGeometryCache.h"
+#include "ConflictController.h"
+#include "ProtectionGenerator.h"
+#include "DbExecutor.h"
+#include "ResultCache.h"
+#include "TokenVerifier.h"
 #include <json.hpp>
+#include <algorithm>
+#include <chrono>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
 #include <spdlog/sinks/stdout_color_sinks.h>
 
 namespace aeronautical {
@@ -21,33 +39,40 @@ FlightProcedureController::FlightProcedureController()
     }
 }
 
-void FlightProcedureController::registerRoutes(crow::SimpleApp& app) {
+void FlightProcedureController::registerRoutes(HttpApp& app) {
     // GET /api/procedures
     CROW_ROUTE(app, "/api/procedures")
         .methods(crow::HTTPMethod::GET)
-        ([this](const crow::request& req) {
-            return getProcedures(req);
+        ([this](const crow::request& req, crow::response& res) {
+            DbExecutor::getInstance().respond(req, res, [this, &req]() { return getProcedures(req); });
+        });
+    
+    // GET /api/procedures/changes?since=<version>
+    CROW_ROUTE(app, "/api/procedures/changes")
+        .methods(crow::HTTPMethod::GET)
+        ([this](const crow::request& req, crow::response& res) {
+            DbExecutor::getInstance().respond(req, res, [this, &req]() { return getProcedureChanges(req); });
         });
     
     // GET /api/procedures/:id
     CROW_ROUTE(app, "/api/procedures/<int>")
         .methods(crow::HTTPMethod::GET)
-        ([this](int id) {
-            return getProcedure(id);
+        ([this](const crow::request& req, crow::response& res, int id) {
+            DbExecutor::getInstance().respond(req, res, [this, &req, id]() { return getProcedure(req, id); });
         });
     
     // GET /api/procedures/code/:code
     CROW_ROUTE(app, "/api/procedures/code/<string>")
         .methods(crow::HTTPMethod::GET)
-        ([this](const std::string& code) {
-            return getProcedureByCode(code);
+        ([this](const crow::request& req, crow::response& res, const std::string& code) {
+            DbExecutor::getInstance().respond(req, res, [this, code]() { return getProcedureByCode(code); });
         });
     
     // GET /api/procedures/airport/:airport_icao
     CROW_ROUTE(app, "/api/procedures/airport/<string>")
         .methods(crow::HTTPMethod::GET)
-        ([this](const std::string& airport_icao) {
-            return getProceduresByAirport(airport_icao);
+        ([this](const crow::request& req, crow::response& res, const std::string& airport_icao) {
+            DbExecutor::getInstance().respond(req, res, [this, airport_icao]() { return getProceduresByAirport(airport_icao); });
         });
     
     // POST /api/procedures
@@ -57,6 +82,27 @@ void FlightProcedureController::registerRoutes(crow::SimpleApp& app) {
             return createProcedure(req);
         });
     
+    // POST /api/procedures/geometries - {"ids": [...], "zoom": z} or "simplify": tolerance
+    CROW_ROUTE(app, "/api/procedures/geometries")
+        .methods(crow::HTTPMethod::POST)
+        ([this](const crow::request& req, crow::response& res) {
+            DbExecutor::getInstance().respond(req, res, [this, &req]() { return getGeometries(req); });
+        });
+    
+    // POST /api/procedures/import - bulk load, one JSON procedure per line
+    CROW_ROUTE(app, "/api/procedures/import")
+        .methods(crow::HTTPMethod::POST)
+        ([this](const crow::request& req) {
+            return importProcedures(req);
+        });
+    
+    // POST /api/procedures/protection/generate - preview of the generated areas
+    CROW_ROUTE(app, "/api/procedures/protection/generate")
+        .methods(crow::HTTPMethod::POST)
+        ([this](const crow::request& req) {
+            return generateProtection(req);
+        });
+    
     // PUT /api/procedures/:id
     CROW_ROUTE(app, "/api/procedures/<int>")
         .methods(crow::HTTPMethod::PUT)
@@ -141,45 +187,120 @@ crow::response FlightProcedureController::getProcedures(const crow::request& req
         // Parse query parameters (existing code...)
         auto query = crow::query_string(req.url_params);
         
+        std::optional<int> precision;
+        std::optional<size_t> level;
+        std::string encodingError;
+        if (!GeometryEncoder::fromRequest(req, precision, encodingError) ||
+            !SimplifiedGeometryCache::fromRequest(req, level, encodingError)) {
+            return errorResponse(400, encodingError);
+        }
+        
         if (query.get("is_active")) {
             std::string active_str = query.get("is_active");
             filter.is_active = (active_str == "true" || active_str == "1");
-            logger_->debug("Parsed is_active filter: {}", *filter.is_active);
+            SPDLOG_LOGGER_DEBUG(logger_, "Parsed is_active filter: {}", *filter.is_active);
         } else {
             // DEFAULT: Set is_active to true if not specified
             filter.is_active = true;
-            logger_->debug("Using default is_active = true");
+            SPDLOG_LOGGER_DEBUG(logger_, "Using default is_active = true");
+        }
+        
+        // fields= picks the members written per procedure; include_geometry=false
+        // is shorthand for everything but the two geometries
+        uint32_t fields = FlightProcedure::kAllFields;
+        if (query.get("fields")) {
+            auto parsed = FlightProcedure::parseFields(query.get("fields"));
+            if (!parsed || *parsed == 0) {
+                return errorResponse(400, "Unknown or empty fields list");
+            }
+            fields = *parsed;
+        }
+        if (query.get("include_geometry")) {
+            std::string include = query.get("include_geometry");
+            if (include == "false" || include == "0") {
+                fields &= ~(FlightProcedure::kTrajectoryGeometry | FlightProcedure::kProtectionGeometry);
+            }
+        }
+        // Geometry that is not written is not read either
+        filter.include_trajectory_geometry = fields & FlightProcedure::kTrajectoryGeometry;
+        filter.include_protection_geometry = fields & FlightProcedure::kProtectionGeometry;
+        const bool any_geometry = filter.include_trajectory_geometry || filter.include_protection_geometry;
+
+        if (query.get("limit")) {
+            filter.limit = std::clamp(std::stoi(query.get("limit")), 1, 500);
+        }
+        if (query.get("offset")) {
+            filter.offset = std::max(std::stoi(query.get("offset")), 0);
+        }
+        if (query.get("after")) {
+            filter.after = PageCursor::decode(query.get("after"));
+            if (!filter.after) {
+                return errorResponse(400, "Invalid after cursor");
+            }
+        }
+        auto total_mode = parseTotalMode(query.get("total"));
+        if (!total_mode) {
+            return errorResponse(400, "total must be exact, approx or none");
         }
         
-        logger_->debug("Calling repository findAll...");
+        // One row past the page tells whether there is a next one
+        const int limit = filter.limit;
+        filter.limit = limit + 1;
+        SPDLOG_LOGGER_DEBUG(logger_, "Calling repository findAll...");
         auto procedures = repository_->findAll(filter);
         logger_->info("Repository returned {} procedures", procedures.size());
+        std::optional<PageCursor> next;
+        if (procedures.size() > static_cast<size_t>(limit)) {
+            procedures.resize(limit);
+            next = FlightProcedureRepository::cursorAfter(procedures.back());
+        }
+        filter.limit = limit;
         
-        int total = repository_->count(filter);
-        logger_->debug("Repository count returned: {}", total);
+        std::optional<int> total;
+        if (*total_mode == TotalMode::Exact) {
+            total = repository_->count(filter);
+        } else if (*total_mode == TotalMode::Approximate) {
+            const std::string key = (filter.is_active ? (*filter.is_active ? "1" : "0") : std::string()) + "|" +
+                                    filter.airport_icao.value_or("");
+            total = ListCountCache::getInstance().get(ListCountCache::Table::Procedures, key,
+                                                      [&]() { return repository_->count(filter); });
+        }
         
-        nlohmann::json response;
-        response["data"] = nlohmann::json::array();
+        // Write each procedure straight into the body instead of a DOM of the page
+        std::string body;
+        JsonWriter writer(body);
+        writer.beginObject().key("data").beginArray();
         
+        size_t written = 0;
         for (size_t i = 0; i < procedures.size(); i++) {
             try {
-                auto proc_json = procedures[i].toJson();
-                response["data"].push_back(proc_json);
-                logger_->debug("Converted procedure {} to JSON: {}", i, procedures[i].procedure_code);
+                if (level && any_geometry) {
+                    SimplifiedGeometryCache::getInstance().apply(procedures[i], *level);
+                }
+                if (precision && any_geometry) {
+                    encodeGeometries(procedures[i], *precision, level);
+                }
+                procedures[i].writeJson(writer, fields);
+                written++;
+                SPDLOG_LOGGER_DEBUG(logger_, "Converted procedure {} to JSON: {}", i, procedures[i].procedure_code);
             } catch (const std::exception& e) {
                 logger_->error("Error converting procedure {} to JSON: {}", i, e.what());
                 continue;
             }
         }
         
-        response["total"] = total;
-        response["limit"] = filter.limit;
-        response["offset"] = filter.offset;
+        writer.endArray()
+              .field("limit", filter.limit)
+              .field("offset", filter.after ? 0 : filter.offset)
+              .field("next_cursor", next ? std::optional<std::string>(next->encode()) : std::nullopt);
+        if (total) {
+            writer.field("total", *total).field("total_approximate", *total_mode == TotalMode::Approximate);
+        }
+        writer.endObject();
         
-        logger_->info("Final response JSON array size: {}", response["data"].size());
-        logger_->debug("Full response: {}", response.dump());
+        logger_->info("Final response JSON array size: {}", written);
         
-        auto crow_response = successResponse(response);
+        auto crow_response = successResponse(std::move(body));
         logger_->info("=== COMPLETED getProcedures - returning HTTP response ===");
         
         return crow_response;
@@ -189,18 +310,135 @@ crow::response FlightProcedureController::getProcedures(const crow::request& req
         return errorResponse(500, "Internal server error");
     }
 }
-crow::response FlightProcedureController::getProcedure(int id) {
+crow::response FlightProcedureController::getGeometries(const crow::request& req) {
+    try {
+        auto body = nlohmann::json::parse(req.body);
+        if (!body.is_object() || !body.contains("ids") || !body["ids"].is_array()) {
+            return errorResponse(400, "ids must be an array of procedure ids");
+        }
+        std::vector<int> ids;
+        std::unordered_set<int> seen;
+        for (const auto& id : body["ids"]) {
+            if (!id.is_number_integer()) {
+                return errorResponse(400, "ids must be an array of procedure ids");
+            }
+            if (seen.insert(id.get<int>()).second) {
+                ids.push_back(id.get<int>());
+            }
+        }
+        if (ids.size() > kMaxGeometryIds) {
+            return errorResponse(400, "At most " + std::to_string(kMaxGeometryIds) + " ids per request");
+        }
+
+        std::optional<int> precision;
+        std::optional<size_t> level;
+        std::string error;
+        if (!GeometryEncoder::fromRequest(req, precision, error) || !SimplifiedGeometryCache::fromJson(body, level, error)) {
+            return errorResponse(400, error);
+        }
+
+        // Full resolution is not cached, so everything is read then
+        auto& cache = SimplifiedGeometryCache::getInstance();
+        std::unordered_map<int, FlightProcedure> found;
+        std::vector<int> misses;
+        for (int id : ids) {
+            auto entry = level ? cache.current(id) : nullptr;
+            if (!entry || !entry->trajectory[*level] || !entry->protection[*level]) {
+                misses.push_back(id);
+                continue;
+            }
+            FlightProcedure& procedure = found[id];
+            procedure.id = id;
+            procedure.updated_at = entry->updated_at;
+            procedure.trajectory_geometry = *entry->trajectory[*level];
+            procedure.protection_geometry = *entry->protection[*level];
+        }
+        const size_t cached = found.size();
+        for (auto& procedure : repository_->findGeometries(misses)) {
+            if (level) {
+                cache.apply(procedure, *level);
+            }
+            found[procedure.id] = std::move(procedure);
+        }
+
+        constexpr uint32_t fields = FlightProcedure::kId | FlightProcedure::kUpdatedAt |
+                                    FlightProcedure::kTrajectoryGeometry | FlightProcedure::kProtectionGeometry;
+        std::string out;
+        JsonWriter writer(out);
+        writer.beginObject().key("data").beginArray();
+        std::vector<int> missing;
+        for (int id : ids) {
+            auto it = found.find(id);
+            if (it == found.end()) {
+                missing.push_back(id);
+                continue;
+            }
+            if (precision) {
+                encodeGeometries(it->second, *precision, level);
+            }
+            it->second.writeJson(writer, fields);
+        }
+        writer.endArray().key("missing").beginArray();
+        for (int id : missing) {
+            writer.value(id);
+        }
+        writer.endArray()
+              .field("level", level ? std::optional<int>(static_cast<int>(*level)) : std::nullopt)
+              .field("cached", static_cast<int>(cached))
+              .endObject();
+        return successResponse(std::move(out));
+
+    } catch (const nlohmann::json::exception& e) {
+        logger_->error("Invalid JSON in procedure geometries request: {}", e.what());
+        return errorResponse(400, "Invalid JSON format");
+    } catch (const std::exception& e) {
+        logger_->error("Failed to read procedure geometries: {}", e.what());
+        return errorResponse(500, "Internal server error");
+    }
+}
+
+crow::response FlightProcedureController::getProcedure(const crow::request& req, int id) {
     try {
+        std::optional<int> precision;
+        std::optional<size_t> level;
+        std::string encodingError;
+        if (!GeometryEncoder::fromRequest(req, precision, encodingError) ||
+            !SimplifiedGeometryCache::fromRequest(req, level, encodingError)) {
+            return errorResponse(400, encodingError);
+        }
+        
+        // updated_at alone has second precision, so writes through this process
+        // also count; a restart changes the tag once
+        std::optional<CacheValidator> validator;
+        if (auto revision = repository_->findRevision(id)) {
+            uint64_t written = ChangeLog::getInstance().version(ChangeLog::Table::Procedures);
+            validator = ConditionalGet::fromVersion("proc-" + std::to_string(id), *revision + "." + std::to_string(written));
+            if (ConditionalGet::isCurrent(req, *validator)) {
+                return ConditionalGet::notModified(*validator);
+            }
+        }
+        
         auto procedure = repository_->findById(id);
         
         if (!procedure) {
             return errorResponse(404, "Procedure not found");
         }
+        if (level) {
+            SimplifiedGeometryCache::getInstance().apply(*procedure, *level);
+            AccessProfile::getInstance().record(AccessProfile::Kind::Procedure, std::to_string(id));
+        }
+        if (precision) {
+            encodeGeometries(*procedure, *precision, level);
+        }
         
         nlohmann::json response;
         response["data"] = procedure->toJson();
         
-        return successResponse(response);
+        auto res = successResponse(response);
+        if (validator) {
+            ConditionalGet::tag(res, *validator);
+        }
+        return res;
         
     } catch (const std::exception& e) {
         logger_->error("Failed to get procedure {}: {}", id, e.what());
@@ -229,14 +467,23 @@ crow::response FlightProcedureController::getProcedureByCode(const std::string&
 
 crow::response FlightProcedureController::getProceduresByAirport(const std::string& airport_icao) {
     try {
-        auto procedures = repository_->findByAirport(airport_icao);
+        // Tagged with every listed procedure too, so an update moving one
+        // to another airport drops this list as well
+        auto& cache = ResultCache::getInstance();
+        std::vector<std::string> tags{ResultCache::airportTag(airport_icao)};
+        auto procedures = cache.get<std::vector<FlightProcedure>>(
+            "procedures.byAirport:" + airport_icao, tags, [&]() {
+                auto found = repository_->findByAirport(airport_icao);
+                for (const auto& procedure : found) tags.push_back(ResultCache::procedureTag(procedure.id));
+                return found;
+            });
         
         nlohmann::json response;
         response["data"] = nlohmann::json::array();
-        for (const auto& procedure : procedures) {
+        for (const auto& procedure : *procedures) {
             response["data"].push_back(procedure.toJson());
         }
-        response["total"] = procedures.size();
+        response["total"] = procedures->size();
         response["airport_icao"] = airport_icao;
         
         return successResponse(response);
@@ -247,6 +494,25 @@ crow::response FlightProcedureController::getProceduresByAirport(const std::stri
     }
 }
 
+// Only writes made through this process are seen; the table has no delete history
+crow::response FlightProcedureController::getProcedureChanges(const crow::request& req) {
+    try {
+        auto since = ChangeLog::parseVersion(req.url_params.get("since"));
+        if (!since) {
+            return errorResponse(400, "Missing or invalid parameter: since");
+        }
+        
+        nlohmann::json response;
+        response["data"] = ChangeLog::getInstance().changesSince(ChangeLog::Table::Procedures, *since).toJson();
+        
+        return successResponse(response);
+        
+    } catch (const std::exception& e) {
+        logger_->error("Failed to get procedure changes: {}", e.what());
+        return errorResponse(500, "Internal server error");
+    }
+}
+
 crow::response FlightProcedureController::createProcedure(const crow::request& req) {
     try {
         // Check authorization
@@ -266,9 +532,19 @@ crow::response FlightProcedureController::createProcedure(const crow::request& r
         
         // Create procedure from JSON
         FlightProcedure procedure = FlightProcedure::fromJson(body);
+        if (!applyGeometryInput(body, procedure, validationError)) {
+            return errorResponse(400, validationError);
+        }
         
         // Save to database
         auto created = repository_->create(procedure);
+        ProtectionGeometryCache::getInstance().invalidate(created.id);
+        SimplifiedGeometryCache::getInstance().insert(created);
+        storeDerivedProtection(created);
+        ChangeLog::getInstance().record(ChangeLog::Table::Procedures, {created.id}, {}, {});
+        ListCountCache::getInstance().bump(ListCountCache::Table::Procedures);
+        ResultCache::getInstance().invalidate(ResultCache::airportTag(created.airport_icao));
+        CacheEvents::getInstance().publishProcedures(CacheEvents::Kind::Inserted, {{created.id, created.airport_icao}});
         
         nlohmann::json response;
         response["data"] = created.toJson();
@@ -287,6 +563,123 @@ crow::response FlightProcedureController::createProcedure(const crow::request& r
     }
 }
 
+crow::response FlightProcedureController::importProcedures(const crow::request& req) {
+    try {
+        std::string authError;
+        if (!checkAuthorization(req, authError)) {
+            return errorResponse(401, authError);
+        }
+        const auto started = std::chrono::steady_clock::now();
+
+        // Line numbers are kept for error reports; blank lines are skipped
+        std::vector<std::pair<size_t, std::string_view>> lines;
+        std::string_view body(req.body);
+        for (size_t start = 0, number = 1; start < body.size(); number++) {
+            size_t end = body.find('\n', start);
+            if (end == std::string_view::npos) end = body.size();
+            std::string_view line = body.substr(start, end - start);
+            if (line.find_first_not_of(" \t\r") != std::string_view::npos) {
+                lines.emplace_back(number, line);
+            }
+            start = end + 1;
+        }
+        if (lines.empty()) {
+            return errorResponse(400, "No procedures to import");
+        }
+        if (lines.size() > kMaxImportProcedures) {
+            return errorResponse(413, "Too many procedures for one import");
+        }
+
+        // Parse, validate and derive the protection columns chunk by chunk
+        const bool footprints = FlightProcedureRepository::probeFootprintColumns();
+        const bool wkb = FlightProcedureRepository::probeWkbColumns();
+        std::vector<ImportedProcedure> imported(lines.size());
+        std::vector<std::string> errors(lines.size());
+        const size_t chunks = (lines.size() + kImportChunkLines - 1) / kImportChunkLines;
+        ConflictController::getInstance().analysisPool().parallelFor(chunks, [&](size_t chunk) {
+            const size_t end = std::min(lines.size(), (chunk + 1) * kImportChunkLines);
+            for (size_t i = chunk * kImportChunkLines; i < end; i++) {
+                try {
+                    auto input = nlohmann::json::parse(lines[i].second, nullptr, false);
+                    if (!input.is_object()) {
+                        errors[i] = "Invalid JSON format";
+                        continue;
+                    }
+                    if (!validateProcedureInput(input, errors[i])) {
+                        continue;
+                    }
+                    auto& procedure = imported[i].procedure;
+                    procedure = FlightProcedure::fromJson(input);
+                    if (!applyGeometryInput(input, procedure, errors[i])) {
+                        continue;
+                    }
+                    if (procedure.protection_geometry) {
+                        auto geometry = ProtectionGeometryCache::parseProtectionGeometry(*procedure.protection_geometry);
+                        if (!geometry) {
+                            errors[i] = "Protection geometry could not be parsed";
+                            continue;
+                        }
+                        if (footprints) imported[i].footprint = ProtectionFootprint::compute(*geometry);
+                        if (wkb) imported[i].wkb = ProtectionGeometryCache::toWkb(*geometry);
+                    }
+                } catch (const std::exception& e) {
+                    errors[i] = e.what();
+                }
+            }
+        });
+
+        nlohmann::json invalid = nlohmann::json::array();
+        for (size_t i = 0; i < lines.size(); i++) {
+            if (errors[i].empty()) continue;
+            if (invalid.size() < 100) invalid.push_back({{"line", lines[i].first}, {"error", errors[i]}});
+        }
+        if (!invalid.empty()) {
+            crow::response res(400, nlohmann::json{{"error", true},
+                                                   {"message", "Import rejected, no procedure was written"},
+                                                   {"invalid", invalid}}.dump());
+            res.add_header("Content-Type", "application/json");
+            return res;
+        }
+        const auto parsed = std::chrono::steady_clock::now();
+
+        const int64_t revision = std::chrono::duration_cast<std::chrono::seconds>(
+                                     std::chrono::system_clock::now().time_since_epoch()).count();
+        auto ids = repository_->insertBatch(imported, revision);
+        if (!ids) {
+            return errorResponse(500, "Import failed, no procedure was written");
+        }
+        ProtectionGeometryCache::getInstance().invalidate(*ids);
+        ChangeLog::getInstance().record(ChangeLog::Table::Procedures, *ids, {}, {});
+        ListCountCache::getInstance().bump(ListCountCache::Table::Procedures);
+        {
+            std::vector<std::string> airports;
+            std::vector<CacheEvents::ProcedureChange> changes;
+            for (size_t i = 0; i < imported.size(); i++) {
+                airports.push_back(ResultCache::airportTag(imported[i].procedure.airport_icao));
+                changes.push_back({(*ids)[i], imported[i].procedure.airport_icao});
+            }
+            ResultCache::getInstance().invalidate(airports);
+            CacheEvents::getInstance().publishProcedures(CacheEvents::Kind::Inserted, changes);
+        }
+        const auto written = std::chrono::steady_clock::now();
+
+        auto ms = [](auto from, auto to) { return std::chrono::duration<double, std::milli>(to - from).count(); };
+        const double total_ms = ms(started, written);
+        nlohmann::json response;
+        response["data"] = {{"imported", ids->size()},
+                            {"parse_ms", ms(started, parsed)},
+                            {"write_ms", ms(parsed, written)},
+                            {"procedures_per_second", total_ms > 0 ? ids->size() * 1000.0 / total_ms : 0.0}};
+        response["message"] = "Procedures imported successfully";
+        logger_->info("Imported {} procedures in {:.0f} ms", ids->size(), total_ms);
+        return crow::response(201, response.dump());
+
+    } catch (const std::exception& e) {
+        logger_->error("Failed to import procedures: {}", e.what());
+        return errorResponse(500, "Internal server error");
+    }
+}
+
 crow::response FlightProcedureController::updateProcedure(int id, const crow::request& req) {
     try {
         // Check authorization
@@ -313,6 +706,9 @@ crow::response FlightProcedureController::updateProcedure(int id, const crow::re
         // Update procedure from JSON
         FlightProcedure procedure = FlightProcedure::fromJson(body);
         procedure.id = id; // Ensure ID is not changed
+        if (!applyGeometryInput(body, procedure, validationError)) {
+            return errorResponse(400, validationError);
+        }
         
         // Save to database
         bool updated = repository_->update(id, procedure);
@@ -320,13 +716,33 @@ crow::response FlightProcedureController::updateProcedure(int id, const crow::re
         if (!updated) {
             return errorResponse(500, "Failed to update procedure");
         }
+        ProtectionGeometryCache::getInstance().invalidate(id);
+        ChangeLog::getInstance().record(ChangeLog::Table::Procedures, {}, {id}, {});
+        ListCountCache::getInstance().bump(ListCountCache::Table::Procedures);
+        ResultCache::getInstance().invalidate(
+            {ResultCache::procedureTag(id), ResultCache::airportTag(procedure.airport_icao)});
+        CacheEvents::getInstance().publishProcedures(CacheEvents::Kind::Updated, {{id, procedure.airport_icao}});
         
         // Get updated procedure
         auto updatedProcedure = repository_->findById(id);
+        if (updatedProcedure) {
+            SimplifiedGeometryCache::getInstance().insert(*updatedProcedure);
+            storeDerivedProtection(*updatedProcedure);
+        } else {
+            SimplifiedGeometryCache::getInstance().invalidate(id);
+        }
+
+        // Conflicts of projects under review with the old zone are now stale
+        const bool protection_changed = !updatedProcedure ||
+                                        existing->protection_geometry != updatedProcedure->protection_geometry;
+        if (protection_changed) {
+            ConflictController::getInstance().scheduleImpactAnalysis(id);
+        }
         
         nlohmann::json response;
         response["data"] = updatedProcedure->toJson();
         response["message"] = "Procedure updated successfully";
+        response["impact_analysis"] = protection_changed;
         
         logger_->info("Updated procedure: {} - {}", updatedProcedure->procedure_code, updatedProcedure->name);
         
@@ -341,6 +757,47 @@ crow::response FlightProcedureController::updateProcedure(int id, const crow::re
     }
 }
 
+crow::response FlightProcedureController::generateProtection(const crow::request& req) {
+    try {
+        std::string authError;
+        if (!checkAuthorization(req, authError)) {
+            return errorResponse(401, authError);
+        }
+        auto body = nlohmann::json::parse(req.body);
+        if (!body.contains("type") || !body["type"].is_string() ||
+            !body.contains("trajectory_geometry") || body["trajectory_geometry"].is_null()) {
+            return errorResponse(400, "Procedure type and trajectory_geometry are required");
+        }
+        const auto& trajectory = body["trajectory_geometry"];
+        const std::string text = trajectory.is_string() ? trajectory.get<std::string>() : trajectory.dump();
+
+        std::string error;
+        auto generated = ProtectionGenerator::getInstance().generate(
+            stringToProcedureType(body["type"].get<std::string>()), body.value("airport_icao", std::string()), text,
+            error);
+        if (!generated) {
+            return errorResponse(400, error);
+        }
+
+        nlohmann::json response;
+        response["data"] = {{"protection_geometry", nlohmann::json::parse(generated->geojson)},
+                            {"revision", generated->revision},
+                            {"segments", generated->segments},
+                            {"primary_area_m2", generated->primary_area_m2},
+                            {"secondary_area_m2", generated->secondary_area_m2},
+                            {"max_semi_width_nm", generated->max_semi_width_nm},
+                            {"elapsed_ms", generated->elapsed_ms}};
+        return successResponse(response);
+
+    } catch (const nlohmann::json::exception& e) {
+        logger_->error("Invalid JSON in generate protection request: {}", e.what());
+        return errorResponse(400, "Invalid JSON format");
+    } catch (const std::exception& e) {
+        logger_->error("Failed to generate protection: {}", e.what());
+        return errorResponse(500, "Internal server error");
+    }
+}
+
 crow::response FlightProcedureController::deleteProcedure(int id) {
     try {
         // Check authorization
@@ -354,6 +811,12 @@ crow::response FlightProcedureController::deleteProcedure(int id) {
         if (!deleted) {
             return errorResponse(404, "Procedure not found");
         }
+        ProtectionGeometryCache::getInstance().invalidate(id);
+        SimplifiedGeometryCache::getInstance().invalidate(id);
+        ChangeLog::getInstance().record(ChangeLog::Table::Procedures, {}, {}, {id});
+        ListCountCache::getInstance().bump(ListCountCache::Table::Procedures);
+        ResultCache::getInstance().invalidate(ResultCache::procedureTag(id));
+        CacheEvents::getInstance().publishProcedures(CacheEvents::Kind::Deleted, {{id, ""}});
         
         nlohmann::json response;
         response["message"] = "Procedure deleted successfully";
@@ -371,7 +834,7 @@ crow::response FlightProcedureController::deleteProcedure(int id) {
 crow::response FlightProcedureController::getProcedureSegments(int procedure_id) {
         // FIXED: Just return empty segments instead of querying non-existent table
             std::vector<ProcedureSegment> segments;
-    logger_->debug("getSegments called for procedure {} - returning empty (segments table removed)", procedure_id);
+    SPDLOG_LOGGER_DEBUG(logger_, "getSegments called for procedure {} - returning empty (segments table removed)", procedure_id);
     // Convert to JSON array
     nlohmann::json j = nlohmann::json::array();
     for (const auto& segment : segments) {
@@ -400,7 +863,7 @@ crow::response FlightProcedureController::getProcedureSegments(int procedure_id)
 
 crow::response FlightProcedureController::getProcedureProtections(int procedure_id) {
     std::vector<ProcedureProtection> protections;
-    logger_->debug("getProtections called for procedure {} - returning empty (protections table removed)", procedure_id);
+    SPDLOG_LOGGER_DEBUG(logger_, "getProtections called for procedure {} - returning empty (protections table removed)", procedure_id);
     // Convert to JSON array
     nlohmann::json j = nlohmann::json::array();
     for (const auto& segment : protections) {
@@ -468,6 +931,84 @@ crow::response FlightProcedureController::successResponse(const nlohmann::json&
     return res;
 }
 
+crow::response FlightProcedureController::successResponse(std::string&& body) {
+    crow::response res(200, std::move(body));
+    res.add_header("Content-Type", "application/json");
+    return res;
+}
+
+void FlightProcedureController::encodeGeometries(FlightProcedure& procedure, int precision,
+                                                 std::optional<size_t> level) {
+    // updated_at has second precision; the procedures version covers writes within that second
+    auto updated_ms = std::chrono::duration_cast<std::chrono::milliseconds>(procedure.updated_at.time_since_epoch()).count();
+    std::string revision = "proc-" + std::to_string(procedure.id) + "-" + std::to_string(updated_ms) + "." +
+                           std::to_string(ChangeLog::getInstance().version(ChangeLog::Table::Procedures)) +
+                           (level ? "-l" + std::to_string(*level) : std::string());
+    auto& encoder = GeometryEncoder::getInstance();
+    if (procedure.trajectory_geometry) {
+        procedure.trajectory_geometry = encoder.encode(revision + "-trajectory", *procedure.trajectory_geometry, precision);
+    }
+    if (procedure.protection_geometry) {
+        procedure.protection_geometry = encoder.encode(revision + "-protection", *procedure.protection_geometry, precision);
+    }
+}
+
+void FlightProcedureController::storeDerivedProtection(const FlightProcedure& procedure) {
+    const bool footprints = FlightProcedureRepository::probeFootprintColumns();
+    const bool wkb = FlightProcedureRepository::probeWkbColumns();
+    if (!procedure.protection_geometry || (!footprints && !wkb)) {
+        return;
+    }
+    auto geometry = ProtectionGeometryCache::parseProtectionGeometry(*procedure.protection_geometry);
+    auto revision = repository_->findRevision(procedure.id);
+    if (!geometry || !revision) {
+        // The analysis rebuild computes them from the geometry instead
+        return;
+    }
+    if (footprints) {
+        repository_->saveProtectionFootprint(procedure.id, std::stoll(*revision), ProtectionFootprint::compute(*geometry));
+    }
+    if (wkb) {
+        repository_->saveProtectionWkb(procedure.id, std::stoll(*revision), ProtectionGeometryCache::toWkb(*geometry));
+    }
+}
+
+bool FlightProcedureController::applyGeometryInput(const nlohmann::json& input, FlightProcedure& procedure,
+                                                   std::string& error) {
+    for (auto [key, field] : {std::pair{"trajectory_geometry", &procedure.trajectory_geometry},
+                              std::pair{"protection_geometry", &procedure.protection_geometry}}) {
+        if (!input.contains(key) || input[key].is_null()) continue;
+        *field = input[key].is_string() ? input[key].get<std::string>() : input[key].dump();
+    }
+    if (!procedure.trajectory_geometry) {
+        if (input.value("generate_protection", false)) {
+            error = "generate_protection needs a trajectory_geometry";
+            return false;
+        }
+        return true;
+    }
+
+    // A drawn protection is kept unless a generated one is asked for; a
+    // generated one follows its trajectory (same revision: from the cache)
+    const bool asked = input.value("generate_protection", false);
+    if (!asked && procedure.protection_geometry && !ProtectionGenerator::isGenerated(*procedure.protection_geometry)) {
+        return true;
+    }
+    std::string generate_error;
+    auto generated = ProtectionGenerator::getInstance().generate(procedure.type, procedure.airport_icao,
+                                                                 *procedure.trajectory_geometry, generate_error);
+    if (!generated) {
+        if (asked) {
+            error = "Protection could not be generated: " + generate_error;
+            return false;
+        }
+        logger_->warn("No protection generated for procedure {}: {}", procedure.procedure_code, generate_error);
+        return true;
+    }
+    procedure.protection_geometry = generated->geojson;
+    return true;
+}
+
 bool FlightProcedureController::validateProcedureInput(const nlohmann::json& input, std::string& error) {
     // Required fields
     if (!input.contains("procedure_code") || input["procedure_code"].get<std::string>().empty()) {
@@ -575,9 +1116,6 @@ bool FlightProcedureController::validateProtectionInput(const nlohmann::json& in
 }
 
 bool FlightProcedureController::checkAuthorization(const crow::request& req, std::string& error) {
-    // TODO: Implement proper JWT token validation
-    // For now, just check for presence of Authorization header
-    
     auto auth_header = req.get_header_value("Authorization");
     if (auth_header.empty()) {
         error = "Authorization header required";
@@ -590,9 +1128,7 @@ bool FlightProcedureController::checkAuthorization(const crow::request& req, std
         return false;
     }
     
-    // TODO: Validate JWT token
-    // For now, accept any bearer token
-    
-    return true;
+    // Signature and claims are checked once per token, then served from the verification cache
+    return TokenVerifier::getInstance().verify(std::string_view(auth_header).substr(7), error);
 }
 }
\ No newline at end of file
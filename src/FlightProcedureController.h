@@ -1,8 +1,10 @@
 #pragma once
 
 #include <crow.h>
+#include "HttpApp.h"
 #include "FlightProcedureRepository.h"
 #include <memory>
+#include <optional>
 #include <spdlog/spdlog.h>
 
 namespace aeronautical {
@@ -12,7 +14,7 @@ public:
     FlightProcedureController();
     ~FlightProcedureController() = default;
     
-    void registerRoutes(crow::SimpleApp& app);
+    void registerRoutes(HttpApp& app);
     
 private:
     std::unique_ptr<FlightProcedureRepository> repository_;
@@ -20,12 +22,26 @@ private:
     
     // Route handlers
     crow::response getProcedures(const crow::request& req);
-    crow::response getProcedure(int id);
+    crow::response getProcedure(const crow::request& req, int id);
     crow::response getProcedureByCode(const std::string& code);
     crow::response getProceduresByAirport(const std::string& airport_icao);
+    crow::response getProcedureChanges(const crow::request& req);
+    // Trajectory and protection geometry of a list of procedures at one
+    // simplification level, taken from SimplifiedGeometryCache where it has
+    // them and from one database query for the rest
+    crow::response getGeometries(const crow::request& req);
+    static constexpr size_t kMaxGeometryIds = FlightProcedureRepository::kRelatedBatchSize;
     crow::response createProcedure(const crow::request& req);
+    // Newline-delimited procedures, each shaped like a createProcedure body,
+    // parsed in parallel and written in one transaction; nothing is written
+    // unless every line is valid
+    crow::response importProcedures(const crow::request& req);
+    static constexpr size_t kMaxImportProcedures = 50000;
+    static constexpr size_t kImportChunkLines = 256;
     crow::response updateProcedure(int id, const crow::request& req);
     crow::response deleteProcedure(int id);
+    // Protection areas generated from a trajectory, without saving them
+    crow::response generateProtection(const crow::request& req);
     
     // Segment route handlers
     crow::response getProcedureSegments(int procedure_id);
@@ -42,10 +58,24 @@ private:
     // Helper methods
     crow::response errorResponse(int code, const std::string& message);
     crow::response successResponse(const nlohmann::json& data);
+    // Body already serialized as JSON text
+    crow::response successResponse(std::string&& body);
     bool validateProcedureInput(const nlohmann::json& input, std::string& error);
     bool validateSegmentInput(const nlohmann::json& input, std::string& error);
     bool validateProtectionInput(const nlohmann::json& input, std::string& error);
     bool checkAuthorization(const crow::request& req, std::string& error);
+    // Swaps the geometries for their polyline encoding (GeometryEncoder);
+    // level names the simplified copy they were taken from, if any
+    void encodeGeometries(FlightProcedure& procedure, int precision, std::optional<size_t> level);
+    // Envelope, vertex count, covering and WKB of the saved protection
+    // geometry, each where its columns exist
+    void storeDerivedProtection(const FlightProcedure& procedure);
+    // Copies the trajectory and protection geometries of the input into
+    // procedure, generating the protection (ProtectionGenerator) when asked
+    // with generate_protection, when only a trajectory is given, or when the
+    // given protection is an earlier generated one. False with error set
+    // when an asked generation fails.
+    bool applyGeometryInput(const nlohmann::json& input, FlightProcedure& procedure, std::string& error);
 };
 
 } // namespace aeronautical
\ No newline at end of file
@@ -1,6 +1,13 @@
 #include "FlightProcedureRepository.h"
 #include "DatabaseManager.h"
+#include "GeometryBlob.h"
+#include "ProtectionGeometryCache.h"
+#include "SchemaMigrations.h"
+#include <algorithm>
+#include <cstdlib>
+#include <mutex>
 #include <sstream>
+#include <unordered_set>
 #include <spdlog/sinks/stdout_color_sinks.h>
 
 namespace aeronautical {
@@ -154,24 +161,22 @@ std::optional<FlightProcedure> FlightProcedureRepository::findById(int id) {
         std::stringstream query;
         query << buildSelectQuery() << " WHERE fp.id = " << id;
         
-        MYSQL_RES* result = db.executeSelectQuery(query.str());
+        MysqlResult result = db.executeSelectQuery(query.str());
         if (!result) {
             throw std::runtime_error("Failed to execute query");
         }
         
-        MYSQL_ROW row = mysql_fetch_row(result);
+        MYSQL_ROW row = mysql_fetch_row(result.get());
         if (row) {
-            unsigned long* lengths = mysql_fetch_lengths(result);
+            unsigned long* lengths = mysql_fetch_lengths(result.get());
             FlightProcedure procedure = rowToProcedure(row, lengths);
-            mysql_free_result(result);
             
             // Load related data
-            loadRelatedData(procedure, true, true);
+            loadRelatedData(std::span(&procedure, 1), true, true);
             
             return procedure;
         }
         
-        mysql_free_result(result);
     } catch (const std::exception& err) {
         logger_->error("Failed to find flight procedure by id {}: {}", id, err.what());
         throw;
@@ -187,24 +192,22 @@ std::optional<FlightProcedure> FlightProcedureRepository::findByCode(const std::
         std::stringstream query;
         query << buildSelectQuery() << " WHERE fp.procedure_code = '" << code << "'";
         
-        MYSQL_RES* result = db.executeSelectQuery(query.str());
+        MysqlResult result = db.executeSelectQuery(query.str());
         if (!result) {
             throw std::runtime_error("Failed to execute query");
         }
         
-        MYSQL_ROW row = mysql_fetch_row(result);
+        MYSQL_ROW row = mysql_fetch_row(result.get());
         if (row) {
-            unsigned long* lengths = mysql_fetch_lengths(result);
+            unsigned long* lengths = mysql_fetch_lengths(result.get());
             FlightProcedure procedure = rowToProcedure(row, lengths);
-            mysql_free_result(result);
             
             // Load related data
-            loadRelatedData(procedure, true, true);
+            loadRelatedData(std::span(&procedure, 1), true, true);
             
             return procedure;
         }
         
-        mysql_free_result(result);
     } catch (const std::exception& err) {
         logger_->error("Failed to find flight procedure by code {}: {}", code, err.what());
         throw;
@@ -220,102 +223,100 @@ std::vector<FlightProcedure> FlightProcedureRepository::findByAirport(const std:
     return findAll(filter);
 }
 
+namespace {
+
+// "1,2,3" of ids[begin, end)
+std::string idList(const std::vector<int>& ids, size_t begin, size_t end) {
+    std::string list;
+    for (size_t i = begin; i < end; i++) {
+        if (i > begin) list += ",";
+        list += std::to_string(ids[i]);
+    }
+    return list;
+}
+
+} // namespace
+
 std::vector<ProcedureSegment> FlightProcedureRepository::getSegments(int procedure_id) {
-    std::vector<ProcedureSegment> segments;
-    
+    auto grouped = findSegments({procedure_id});
+    auto it = grouped.find(procedure_id);
+    return it == grouped.end() ? std::vector<ProcedureSegment>() : std::move(it->second);
+}
+
+std::unordered_map<int, std::vector<ProcedureSegment>> FlightProcedureRepository::findSegments(
+    const std::vector<int>& procedure_ids) {
+    std::unordered_map<int, std::vector<ProcedureSegment>> segments;
+    if (procedure_ids.empty() || !SchemaMigrations::hasTable("procedure_segments")) {
+        return segments;
+    }
+
     try {
         auto& db = DatabaseManager::getInstance();
-        
-        // Check if procedure_segments table exists
-        MYSQL_RES* tableCheck = db.executeSelectQuery("SHOW TABLES LIKE 'procedure_segments'");
-        if (!tableCheck) {
-            logger_->warn("Cannot check if procedure_segments table exists");
-            return segments;
-        }
-        
-        MYSQL_ROW tableRow = mysql_fetch_row(tableCheck);
-        if (!tableRow) {
-            logger_->warn("procedure_segments table does not exist");
-            mysql_free_result(tableCheck);
-            return segments;
-        }
-        mysql_free_result(tableCheck);
-        
-        std::stringstream query;
-        query << buildSegmentSelectQuery() << " WHERE ps.procedure_id = " << procedure_id;
-        query << " ORDER BY ps.segment_order ASC";
-        
-        MYSQL_RES* result = db.executeSelectQuery(query.str());
-        if (!result) {
-            logger_->warn("Segments query failed for procedure {}", procedure_id);
-            return segments;
-        }
-        
-        MYSQL_ROW row;
-        while ((row = mysql_fetch_row(result))) {
-            unsigned long* lengths = mysql_fetch_lengths(result);
-            segments.push_back(rowToSegment(row, lengths));
+        for (size_t start = 0; start < procedure_ids.size(); start += kRelatedBatchSize) {
+            const size_t end = std::min(procedure_ids.size(), start + kRelatedBatchSize);
+            std::string query = buildSegmentSelectQuery() + " WHERE ps.procedure_id IN (" +
+                                idList(procedure_ids, start, end) + ") ORDER BY ps.segment_order ASC";
+
+            MysqlResult result = db.executeSelectQuery(query);
+            if (!result) {
+                logger_->warn("Segments query failed for {} procedures", end - start);
+                continue;
+            }
+            MYSQL_ROW row;
+            while ((row = mysql_fetch_row(result.get()))) {
+                unsigned long* lengths = mysql_fetch_lengths(result.get());
+                ProcedureSegment segment = rowToSegment(row, lengths);
+                segments[segment.procedure_id].push_back(std::move(segment));
+            }
         }
-        
-        mysql_free_result(result);
-        
-        logger_->debug("Found {} segments for procedure {}", segments.size(), procedure_id);
+        SPDLOG_LOGGER_DEBUG(logger_, "Found segments of {} of {} procedures", segments.size(), procedure_ids.size());
     } catch (const std::exception& err) {
-        logger_->error("Failed to fetch segments for procedure {}: {}", procedure_id, err.what());
-        // Return empty list instead of throwing
-        return std::vector<ProcedureSegment>();
+        logger_->error("Failed to fetch segments of {} procedures: {}", procedure_ids.size(), err.what());
+        // Return empty lists instead of throwing
+        segments.clear();
     }
-    
     return segments;
 }
 
 std::vector<ProcedureProtection> FlightProcedureRepository::getProtections(int procedure_id) {
-    std::vector<ProcedureProtection> protections;
-    
+    auto grouped = findProtections({procedure_id});
+    auto it = grouped.find(procedure_id);
+    return it == grouped.end() ? std::vector<ProcedureProtection>() : std::move(it->second);
+}
+
+std::unordered_map<int, std::vector<ProcedureProtection>> FlightProcedureRepository::findProtections(
+    const std::vector<int>& procedure_ids) {
+    std::unordered_map<int, std::vector<ProcedureProtection>> protections;
+    if (procedure_ids.empty() || !SchemaMigrations::hasTable("flight_procedure_protection")) {
+        return protections;
+    }
+
     try {
         auto& db = DatabaseManager::getInstance();
-        
-        // Check if flight_procedure_protection table exists
-        MYSQL_RES* tableCheck = db.executeSelectQuery("SHOW TABLES LIKE 'flight_procedure_protection'");
-        if (!tableCheck) {
-            logger_->warn("Cannot check if flight_procedure_protection table exists");
-            return protections;
-        }
-        
-        MYSQL_ROW tableRow = mysql_fetch_row(tableCheck);
-        if (!tableRow) {
-            logger_->warn("flight_procedure_protection table does not exist");
-            mysql_free_result(tableCheck);
-            return protections;
-        }
-        mysql_free_result(tableCheck);
-        
-        std::stringstream query;
-        query << buildProtectionSelectQuery() << " WHERE fpp.procedure_id = " << procedure_id;
-        query << " AND fpp.is_active = 1";
-        query << " ORDER BY fpp.analysis_priority DESC, fpp.protection_name ASC";
-        
-        MYSQL_RES* result = db.executeSelectQuery(query.str());
-        if (!result) {
-            logger_->warn("Protections query failed for procedure {}", procedure_id);
-            return protections;
-        }
-        
-        MYSQL_ROW row;
-        while ((row = mysql_fetch_row(result))) {
-            unsigned long* lengths = mysql_fetch_lengths(result);
-            protections.push_back(rowToProtection(row, lengths));
+        for (size_t start = 0; start < procedure_ids.size(); start += kRelatedBatchSize) {
+            const size_t end = std::min(procedure_ids.size(), start + kRelatedBatchSize);
+            std::string query = buildProtectionSelectQuery() + " WHERE fpp.procedure_id IN (" +
+                                idList(procedure_ids, start, end) + ") AND fpp.is_active = 1" +
+                                " ORDER BY fpp.analysis_priority DESC, fpp.protection_name ASC";
+
+            MysqlResult result = db.executeSelectQuery(query);
+            if (!result) {
+                logger_->warn("Protections query failed for {} procedures", end - start);
+                continue;
+            }
+            MYSQL_ROW row;
+            while ((row = mysql_fetch_row(result.get()))) {
+                unsigned long* lengths = mysql_fetch_lengths(result.get());
+                ProcedureProtection protection = rowToProtection(row, lengths);
+                protections[protection.procedure_id].push_back(std::move(protection));
+            }
         }
-        
-        mysql_free_result(result);
-        
-        logger_->debug("Found {} protections for procedure {}", protections.size(), procedure_id);
+        SPDLOG_LOGGER_DEBUG(logger_, "Found protections of {} of {} procedures", protections.size(), procedure_ids.size());
     } catch (const std::exception& err) {
-        logger_->error("Failed to fetch protections for procedure {}: {}", procedure_id, err.what());
-        // Return empty list instead of throwing
-        return std::vector<ProcedureProtection>();
+        logger_->error("Failed to fetch protections of {} procedures: {}", procedure_ids.size(), err.what());
+        // Return empty lists instead of throwing
+        protections.clear();
     }
-    
     return protections;
 }
 
@@ -365,6 +366,7 @@ std::vector<ProcedureProtection> FlightProcedureRepository::getProtections(int p
 int FlightProcedureRepository::count(const FlightProcedureFilter& filter) {
     try {
         auto& db = DatabaseManager::getInstance();
+        DatabaseManager::ReadScope read(db);
         
         std::stringstream query;
         query << "SELECT COUNT(*) FROM flight_procedures fp WHERE 1=1";
@@ -385,22 +387,21 @@ int FlightProcedureRepository::count(const FlightProcedureFilter& filter) {
             query << " AND fp.is_active = " << (*filter.is_active ? 1 : 0);
         }
         
-        logger_->debug("Executing count query: {}", query.str());
+        SPDLOG_LOGGER_DEBUG(logger_, "Executing count query: {}", query.str());
         
-        MYSQL_RES* result = db.executeSelectQuery(query.str());
+        MysqlResult result = db.executeSelectQuery(query.str());
         if (!result) {
             logger_->warn("Count query failed, returning 0");
             return 0;
         }
         
-        MYSQL_ROW row = mysql_fetch_row(result);
+        MYSQL_ROW row = mysql_fetch_row(result.get());
         int count = 0;
         if (row && row[0]) {
             count = std::atoi(row[0]);
-            logger_->debug("Count query returned: {}", count);
+            SPDLOG_LOGGER_DEBUG(logger_, "Count query returned: {}", count);
         }
         
-        mysql_free_result(result);
         return count;
         
     } catch (const std::exception& err) {
@@ -409,14 +410,31 @@ int FlightProcedureRepository::count(const FlightProcedureFilter& filter) {
     }
 }
 
-void FlightProcedureRepository::loadRelatedData(FlightProcedure& procedure, bool include_segments, bool include_protections) {
-    // if (include_segments) {
-    //     procedure.segments = getSegments(procedure.id);
-    // }
-    
-    // if (include_protections) {
-    //     procedure.protections = getProtections(procedure.id);
-    // }
+void FlightProcedureRepository::loadRelatedData(std::span<FlightProcedure> procedures, bool include_segments,
+                                                bool include_protections) {
+    if (procedures.empty() || (!include_segments && !include_protections)) {
+        return;
+    }
+    std::vector<int> ids;
+    ids.reserve(procedures.size());
+    for (const auto& procedure : procedures) {
+        ids.push_back(procedure.id);
+    }
+
+    if (include_segments) {
+        auto segments = findSegments(ids);
+        for (auto& procedure : procedures) {
+            if (auto it = segments.find(procedure.id); it != segments.end()) procedure.segments = std::move(it->second);
+        }
+    }
+    if (include_protections) {
+        auto protections = findProtections(ids);
+        for (auto& procedure : procedures) {
+            if (auto it = protections.find(procedure.id); it != protections.end()) {
+                procedure.protections = std::move(it->second);
+            }
+        }
+    }
 }
 
 FlightProcedure FlightProcedureRepository::rowToProcedure(MYSQL_ROW row, unsigned long* lengths) {
@@ -426,7 +444,7 @@ FlightProcedure FlightProcedureRepository::rowToProcedure(MYSQL_ROW row, unsigne
     p.id = row[col] ? std::atoi(row[col]) : 0; col++;
     p.procedure_code = row[col] ? std::string(row[col]) : ""; col++;
     p.name = row[col] ? std::string(row[col]) : ""; col++;
-    p.type = row[col] ? stringToProcedureType(std::string(row[col])) : ProcedureType::SID; col++;
+    p.type = row[col] ? stringToProcedureType(row[col]) : ProcedureType::SID; col++;
     p.airport_icao = row[col] ? std::string(row[col]) : ""; col++;
     if (row[col]) p.runway = std::string(row[col]); col++;
     if (row[col]) p.description = std::string(row[col]); col++;
@@ -451,13 +469,13 @@ ProcedureSegment FlightProcedureRepository::rowToSegment(MYSQL_ROW row, unsigned
     if (row[col]) s.waypoint_to = std::string(row[col]); col++;
     if (row[col]) s.altitude_min = std::atoi(row[col]); col++;
     if (row[col]) s.altitude_max = std::atoi(row[col]); col++;
-    if (row[col]) s.altitude_restriction = stringToAltitudeRestriction(std::string(row[col])); col++;
+    if (row[col]) s.altitude_restriction = stringToAltitudeRestriction(row[col]); col++;
     if (row[col]) s.speed_limit = std::atoi(row[col]); col++;
-    if (row[col]) s.speed_restriction = stringToSpeedRestriction(std::string(row[col])); col++;
+    if (row[col]) s.speed_restriction = stringToSpeedRestriction(row[col]); col++;
     s.trajectory_geometry = row[col] ? std::string(row[col]) : ""; col++;
     if (row[col]) s.segment_length = std::atof(row[col]); col++;
     if (row[col]) s.magnetic_course = std::atoi(row[col]); col++;
-    s.turn_direction = row[col] ? stringToTurnDirection(std::string(row[col])) : TurnDirection::Straight; col++;
+    s.turn_direction = row[col] ? stringToTurnDirection(row[col]) : TurnDirection::Straight; col++;
     s.is_mandatory = row[col] ? (std::atoi(row[col]) != 0) : true; col++;
     
     return s;
@@ -470,18 +488,18 @@ ProcedureProtection FlightProcedureRepository::rowToProtection(MYSQL_ROW row, un
     p.id = row[col] ? std::atoi(row[col]) : 0; col++;
     p.procedure_id = row[col] ? std::atoi(row[col]) : 0; col++;
     p.protection_name = row[col] ? std::string(row[col]) : ""; col++;
-    p.protection_type = row[col] ? stringToProtectionType(std::string(row[col])) : ProtectionType::OverallPrimary; col++;
+    p.protection_type = row[col] ? stringToProtectionType(row[col]) : ProtectionType::OverallPrimary; col++;
     if (row[col]) p.description = std::string(row[col]); col++;
     p.protection_geometry = row[col] ? std::string(row[col]) : ""; col++;
     if (row[col]) p.altitude_min = std::atoi(row[col]); col++;
     if (row[col]) p.altitude_max = std::atoi(row[col]); col++;
-    p.altitude_reference = row[col] ? stringToAltitudeReference(std::string(row[col])) : AltitudeReference::MSL; col++;
+    p.altitude_reference = row[col] ? stringToAltitudeReference(row[col]) : AltitudeReference::MSL; col++;
     if (row[col]) p.area_size = std::atof(row[col]); col++;
     if (row[col]) p.center_lat = std::atof(row[col]); col++;
     if (row[col]) p.center_lng = std::atof(row[col]); col++;
     if (row[col]) p.buffer_distance = std::atof(row[col]); col++;
-    p.restriction_level = row[col] ? stringToRestrictionLevel(std::string(row[col])) : RestrictionLevel::Restricted; col++;
-    p.conflict_severity = row[col] ? stringToConflictSeverity(std::string(row[col])) : ConflictSeverity::Medium; col++;
+    p.restriction_level = row[col] ? stringToRestrictionLevel(row[col]) : RestrictionLevel::Restricted; col++;
+    p.conflict_severity = row[col] ? stringToConflictSeverity(row[col]) : ConflictSeverity::Medium; col++;
     p.analysis_priority = row[col] ? std::atoi(row[col]) : 50; col++;
     if (row[col]) p.time_restriction = std::string(row[col]); col++;
     p.weather_dependent = row[col] ? (std::atoi(row[col]) != 0) : false; col++;
@@ -508,6 +526,7 @@ std::vector<FlightProcedure> FlightProcedureRepository::findAll(const FlightProc
         logger_->info("=== STARTING FlightProcedureRepository::findAll ===");
         
         auto& db = DatabaseManager::getInstance();
+        DatabaseManager::ReadScope read(db);
         
         // Test database connection first
         // if (!db.isConnected()) {
@@ -517,102 +536,111 @@ std::vector<FlightProcedure> FlightProcedureRepository::findAll(const FlightProc
         // logger_->debug("Database connection confirmed");
         
         // Build the query
+        // Unwanted geometry columns are selected as NULL so positions stay put
         std::string query = "SELECT fp.id, fp.procedure_code, fp.name, fp.type, "
-                           "fp.airport_icao, fp.runway, fp.description, "
-                           "fp.trajectory_geometry, fp.protection_geometry, "
-                           "fp.effective_date, fp.expiry_date, fp.is_active, "
-                           "fp.created_at, fp.updated_at "
-                           "FROM flight_procedures fp WHERE 1=1";
+                           "fp.airport_icao, fp.runway, fp.description, ";
+        query += filter.include_trajectory_geometry ? "fp.trajectory_geometry, " : "NULL, ";
+        query += filter.include_protection_geometry ? "fp.protection_geometry, " : "NULL, ";
+        query += "fp.effective_date, fp.expiry_date, fp.is_active, "
+                 "fp.created_at, fp.updated_at "
+                 "FROM flight_procedures fp WHERE 1=1";
         
         if (filter.is_active.has_value()) {
             query += " AND fp.is_active = " + std::to_string(*filter.is_active ? 1 : 0);
-            logger_->debug("Added is_active filter: {}", *filter.is_active);
+            SPDLOG_LOGGER_DEBUG(logger_, "Added is_active filter: {}", *filter.is_active);
         }
         
         if (filter.airport_icao) {
             query += " AND fp.airport_icao = '" + *filter.airport_icao + "'";
-            logger_->debug("Added airport_icao filter: {}", *filter.airport_icao);
+            SPDLOG_LOGGER_DEBUG(logger_, "Added airport_icao filter: {}", *filter.airport_icao);
         }
 
-        query += " ORDER BY fp.procedure_code ASC";
-        query += " LIMIT " + std::to_string(filter.limit) + " OFFSET " + std::to_string(filter.offset);
+        // Keyset condition; the cursor comes from the client, so it is escaped
+        if (filter.after) {
+            DatabaseManager::ConnectionScope scope(db);
+            std::string code(filter.after->key.size() * 2 + 1, '\0');
+            code.resize(mysql_real_escape_string(scope.get(), code.data(), filter.after->key.c_str(),
+                                                 filter.after->key.size()));
+            query += " AND (fp.procedure_code > '" + code + "' OR (fp.procedure_code = '" + code +
+                     "' AND fp.id > " + std::to_string(filter.after->id) + "))";
+        }
+
+        query += " ORDER BY fp.procedure_code ASC, fp.id ASC";
+        query += " LIMIT " + std::to_string(filter.limit);
+        if (!filter.after) {
+            query += " OFFSET " + std::to_string(filter.offset);
+        }
         
         logger_->info("Final query: {}", query);
         
         // Execute the query
-        logger_->debug("About to execute query...");
-        MYSQL_RES* result = db.executeSelectQuery(query);
+        SPDLOG_LOGGER_DEBUG(logger_, "About to execute query...");
+        MysqlResult result = db.executeSelectQuery(query);
         
         if (!result) {
+            // executeSelectQuery already logged the MySQL error details
             logger_->error("executeSelectQuery returned NULL!");
-            
-            // Get MySQL error details
-            MYSQL* conn = db.getConnection();
-            if (conn) {
-                unsigned int error_code = mysql_errno(conn);
-                const char* error_msg = mysql_error(conn);
-                logger_->error("MySQL Error Code: {}, Message: '{}'", error_code, error_msg ? error_msg : "no error message");
-            }
             return procedures;
         }
         
-        logger_->debug("Query executed successfully, got result set");
+        SPDLOG_LOGGER_DEBUG(logger_, "Query executed successfully, got result set");
         
         // Check number of rows
-        unsigned long num_rows = mysql_num_rows(result);
+        unsigned long num_rows = mysql_num_rows(result.get());
         logger_->info("Query returned {} rows", num_rows);
         
         if (num_rows == 0) {
             logger_->warn("Query returned 0 rows - this is likely why frontend shows no procedures");
-            mysql_free_result(result);
             return procedures;
         }
         
         // Check number of fields
-        unsigned int num_fields = mysql_num_fields(result);
-        logger_->debug("Query returned {} fields", num_fields);
+        unsigned int num_fields = mysql_num_fields(result.get());
+        SPDLOG_LOGGER_DEBUG(logger_, "Query returned {} fields", num_fields);
         
         // Get field information
-        MYSQL_FIELD* fields = mysql_fetch_fields(result);
-        logger_->debug("Field names:");
+        // Read only by the debug log, compiled out below SPDLOG_ACTIVE_LEVEL=DEBUG
+        [[maybe_unused]] MYSQL_FIELD* fields = mysql_fetch_fields(result.get());
+        SPDLOG_LOGGER_DEBUG(logger_, "Field names:");
         for (unsigned int i = 0; i < num_fields; i++) {
-            logger_->debug("  Field {}: {}", i, fields[i].name ? fields[i].name : "NULL");
+            SPDLOG_LOGGER_DEBUG(logger_, "  Field {}: {}", i, fields[i].name ? fields[i].name : "NULL");
         }
         
         // Process rows
         MYSQL_ROW row;
         int row_count = 0;
-        while ((row = mysql_fetch_row(result))) {
+        while ((row = mysql_fetch_row(result.get()))) {
             row_count++;
-            logger_->debug("Processing row {}", row_count);
+            SPDLOG_LOGGER_DEBUG(logger_, "Processing row {}", row_count);
             
             // Log raw row data
             for (unsigned int i = 0; i < num_fields; i++) {
-                logger_->debug("  Row {} Field {}: '{}'", row_count, i, row[i] ? row[i] : "NULL");
+                SPDLOG_LOGGER_DEBUG(logger_, "  Row {} Field {}: '{}'", row_count, i, row[i] ? row[i] : "NULL");
             }
             
             try {
                 FlightProcedure procedure;
+                unsigned long* lengths = mysql_fetch_lengths(result.get());
                 
                 int col = 0;
                 procedure.id = row[col] ? std::atoi(row[col]) : 0; 
-                logger_->debug("  Parsed ID: {}", procedure.id);
+                SPDLOG_LOGGER_DEBUG(logger_, "  Parsed ID: {}", procedure.id);
                 col++;
                 
                 procedure.procedure_code = row[col] ? std::string(row[col]) : ""; 
-                logger_->debug("  Parsed code: '{}'", procedure.procedure_code);
+                SPDLOG_LOGGER_DEBUG(logger_, "  Parsed code: '{}'", procedure.procedure_code);
                 col++;
                 
                 procedure.name = row[col] ? std::string(row[col]) : ""; 
-                logger_->debug("  Parsed name: '{}'", procedure.name);
+                SPDLOG_LOGGER_DEBUG(logger_, "  Parsed name: '{}'", procedure.name);
                 col++;
                 
-                procedure.type = row[col] ? stringToProcedureType(std::string(row[col])) : ProcedureType::SID; 
-                logger_->debug("  Parsed type: '{}'", row[col] ? row[col] : "NULL");
+                procedure.type = row[col] ? stringToProcedureType(row[col]) : ProcedureType::SID; 
+                SPDLOG_LOGGER_DEBUG(logger_, "  Parsed type: '{}'", row[col] ? row[col] : "NULL");
                 col++;
                 
                 procedure.airport_icao = row[col] ? std::string(row[col]) : ""; 
-                logger_->debug("  Parsed airport: '{}'", procedure.airport_icao);
+                SPDLOG_LOGGER_DEBUG(logger_, "  Parsed airport: '{}'", procedure.airport_icao);
                 col++;
                 
                 if (row[col]) procedure.runway = std::string(row[col]); col++;
@@ -620,7 +648,7 @@ std::vector<FlightProcedure> FlightProcedureRepository::findAll(const FlightProc
                 
                 // Geometry fields
                 if (row[col]) procedure.trajectory_geometry = std::string(row[col]); col++;
-                if (row[col]) procedure.protection_geometry = std::string(row[col]); col++;
+                if (row[col]) procedure.protection_geometry = GeometryBlob::text(row[col], lengths[col]); col++;
                 
                 // Skip date parsing for now to isolate the issue
                 col += 5; // Skip the remaining columns
@@ -634,9 +662,10 @@ std::vector<FlightProcedure> FlightProcedureRepository::findAll(const FlightProc
             }
         }
         
-        mysql_free_result(result);
-        
         logger_->info("=== COMPLETED: Successfully loaded {} flight procedures ===", procedures.size());
+
+        // One query per child table for the whole page
+        loadRelatedData(procedures, filter.include_segments, filter.include_protections);
         
     } catch (const std::exception& err) {
         logger_->error("=== EXCEPTION in findAll: {} ===", err.what());
@@ -661,14 +690,15 @@ std::vector<ProcedureProtection> FlightProcedureRepository::findAllActiveProtect
                            "WHERE fp.is_active = 1 AND fp.protection_geometry IS NOT NULL "
                            "AND fp.protection_geometry != ''";
         
-        logger_->debug("Executing active protections query: {}", query);
+        SPDLOG_LOGGER_DEBUG(logger_, "Executing active protections query: {}", query);
         
-        MYSQL_RES* result = db.executeSelectQuery(query);
+        MysqlResult result = db.executeSelectQuery(query);
         if (result) {
             MYSQL_ROW row;
-            while ((row = mysql_fetch_row(result))) {
+            while ((row = mysql_fetch_row(result.get()))) {
                 // Convert flight_procedures row to ProcedureProtection
                 ProcedureProtection protection;
+                unsigned long* lengths = mysql_fetch_lengths(result.get());
                 
                 int col = 0;
                 protection.procedure_id = row[col] ? std::atoi(row[col]) : 0; col++; // id -> procedure_id
@@ -680,34 +710,9 @@ std::vector<ProcedureProtection> FlightProcedureRepository::findAllActiveProtect
                 std::string description = row[col] ? std::string(row[col]) : ""; col++; // description (optional)
                 
                 // The protection_geometry field - this is what we need!
-                std::string protection_geometry_str = row[col] ? std::string(row[col]) : "{}"; col++;
-
-                try {
-                    nlohmann::json feature_collection = nlohmann::json::parse(protection_geometry_str);
-                    
-                    if (feature_collection.contains("features") && feature_collection["features"].is_array()) {
-                        nlohmann::json multi_polygon_coords = nlohmann::json::array();
-                        
-                        for (const auto& feature : feature_collection["features"]) {
-                            if (feature.contains("geometry") && feature["geometry"]["type"] == "Polygon") {
-                                multi_polygon_coords.push_back(feature["geometry"]["coordinates"]);
-                            }
-                        }
-                        
-                        nlohmann::json multi_polygon_geom = {
-                            {"type", "MultiPolygon"},
-                            {"coordinates", multi_polygon_coords}
-                        };
-                        
-                        protection.protection_geometry = multi_polygon_geom.dump();
-                    } else {
-                        // If it's not a FeatureCollection, use it as is (or handle as an error)
-                        protection.protection_geometry = protection_geometry_str;
-                    }
-                } catch (const std::exception& e) {
-                    logger_->warn("Could not parse protection geometry for procedure {}: {}", protection.procedure_id, e.what());
-                    protection.protection_geometry = "{}"; // Assign empty geometry
-                }
+                // Kept as stored: ProtectionGeometryCache::parseProtectionGeometry folds the
+                // polygon features into one MultiPolygon in its single pass over the text
+                protection.protection_geometry = row[col] ? GeometryBlob::text(row[col], lengths[col]) : "{}"; col++;
 
                 // Set default values for protection-specific fields
                 protection.id = protection.procedure_id; // Use same ID
@@ -731,7 +736,6 @@ std::vector<ProcedureProtection> FlightProcedureRepository::findAllActiveProtect
                 
                 protections.push_back(protection);
             }
-            mysql_free_result(result);
         } else {
             logger_->warn("Failed to execute active protections query");
         }
@@ -743,6 +747,474 @@ std::vector<ProcedureProtection> FlightProcedureRepository::findAllActiveProtect
     return protections;
 }
 
+std::vector<ProcedureProtection> FlightProcedureRepository::findActiveProtectionHeaders() {
+    std::vector<ProcedureProtection> protections;
+    try {
+        auto& db = DatabaseManager::getInstance();
+
+        const bool footprints = probeFootprintColumns();
+        const bool store = probeGeometryStore();
+        const bool applicability = probeApplicabilityColumns();
+        std::string query = "SELECT id, procedure_code, name, type, airport_icao, "
+                           "description, effective_date, expiry_date, updated_at, UNIX_TIMESTAMP(updated_at)";
+        if (applicability) {
+            query += ", time_restriction, weather_dependent";
+        }
+        if (footprints) {
+            query += ", protection_footprint_version, protection_min_lng, protection_min_lat, "
+                     "protection_max_lng, protection_max_lat, protection_vertex_count, protection_cells";
+        }
+        if (store) {
+            // Lets the cache pick up a geometry another procedure already loaded
+            query += ", IF(protection_wkb_version = UNIX_TIMESTAMP(updated_at), protection_geometry_hash, NULL)";
+        }
+        query += " FROM flight_procedures fp "
+                 "WHERE fp.is_active = 1 AND fp.protection_geometry IS NOT NULL "
+                 "AND fp.protection_geometry != ''";
+
+        MysqlResult result = db.executeSelectQuery(query);
+        if (result) {
+            MYSQL_ROW row;
+            while ((row = mysql_fetch_row(result.get()))) {
+                ProcedureProtection protection;
+
+                int col = 0;
+                protection.procedure_id = row[col] ? std::atoi(row[col]) : 0; col++;
+                std::string procedure_code = row[col] ? std::string(row[col]) : ""; col++;
+                std::string procedure_name = row[col] ? std::string(row[col]) : ""; col++;
+                std::string procedure_type = row[col] ? std::string(row[col]) : ""; col++;
+                std::string airport_icao = row[col] ? std::string(row[col]) : ""; col++;
+                std::string description = row[col] ? std::string(row[col]) : ""; col++;
+                if (row[col]) protection.effective_date = stringToTimePoint(std::string(row[col])); col++;
+                if (row[col]) protection.expiry_date = stringToTimePoint(std::string(row[col])); col++;
+                if (row[col]) protection.updated_at = stringToTimePoint(std::string(row[col])); col++;
+                protection.revision = row[col] ? std::atoll(row[col]) : 0; col++;
+                if (applicability) {
+                    if (row[col]) protection.time_restriction = std::string(row[col]); col++;
+                    protection.weather_dependent = row[col] && std::atoi(row[col]) != 0; col++;
+                }
+                // A footprint is only trusted for the geometry version it was computed from
+                if (footprints && row[col] && std::atoll(row[col]) == protection.revision && row[col + 5]) {
+                    ProtectionFootprint footprint;
+                    footprint.min_lng = row[col + 1] ? std::atof(row[col + 1]) : 0;
+                    footprint.min_lat = row[col + 2] ? std::atof(row[col + 2]) : 0;
+                    footprint.max_lng = row[col + 3] ? std::atof(row[col + 3]) : 0;
+                    footprint.max_lat = row[col + 4] ? std::atof(row[col + 4]) : 0;
+                    footprint.vertex_count = std::atoi(row[col + 5]);
+                    if (row[col + 6]) footprint.cells = ProtectionFootprint::parseCells(row[col + 6]);
+                    protection.footprint = std::move(footprint);
+                }
+                if (footprints) col += 7;
+                if (store && row[col]) protection.geometry_hash = row[col];
+
+                // Same defaults as findAllActiveProtections
+                protection.id = protection.procedure_id;
+                protection.protection_name = procedure_code + " - " + procedure_name + " Protection Zone";
+                protection.protection_type = ProtectionType::OverallPrimary;
+                protection.description = description.empty() ?
+                    ("Protection zone for " + procedure_type + " procedure at " + airport_icao) :
+                    description;
+                protection.altitude_reference = AltitudeReference::MSL;
+                protection.restriction_level = RestrictionLevel::Restricted;
+                protection.conflict_severity = ConflictSeverity::High;
+                protection.analysis_priority = 80;
+                protection.is_active = true;
+                protection.airport_icao = airport_icao;
+
+                protections.push_back(protection);
+            }
+        } else {
+            logger_->warn("Failed to execute active protection headers query");
+        }
+    } catch (const std::exception& err) {
+        logger_->error("Failed to find active protection headers: {}", err.what());
+    }
+
+    return protections;
+}
+
+std::unordered_map<int, StoredProtectionGeometry> FlightProcedureRepository::findProtectionGeometries(const std::vector<int>& procedure_ids) {
+    std::unordered_map<int, StoredProtectionGeometry> geometries;
+    if (procedure_ids.empty()) {
+        return geometries;
+    }
+
+    try {
+        auto& db = DatabaseManager::getInstance();
+
+        // Only one of the representations is transferred per row
+        std::stringstream query;
+        if (probeGeometryStore()) {
+            // A referenced blob first, then WKB of rows written before the store
+            const char* version = "fp.protection_wkb_version = UNIX_TIMESTAMP(fp.updated_at)";
+            const std::string by_hash = std::string("gb.wkb IS NOT NULL AND ") + version;
+            const std::string inline_wkb = std::string("fp.protection_wkb IS NOT NULL AND ") + version;
+            query << "SELECT fp.id, IF(" << by_hash << " OR " << inline_wkb << ", NULL, fp.protection_geometry), "
+                  << "IF(" << by_hash << ", gb.wkb, IF(" << inline_wkb << ", fp.protection_wkb, NULL)), "
+                  << "IF(" << by_hash << ", fp.protection_geometry_hash, NULL) "
+                  << "FROM flight_procedures fp LEFT JOIN geometry_blobs gb ON gb.hash = fp.protection_geometry_hash "
+                  << "WHERE fp.id IN (";
+        } else if (probeWkbColumns()) {
+            const char* current = "protection_wkb IS NOT NULL AND protection_wkb_version = UNIX_TIMESTAMP(updated_at)";
+            query << "SELECT id, IF(" << current << ", NULL, protection_geometry), IF(" << current
+                  << ", protection_wkb, NULL), NULL FROM flight_procedures WHERE id IN (";
+        } else {
+            query << "SELECT id, protection_geometry, NULL, NULL FROM flight_procedures WHERE id IN (";
+        }
+        for (size_t i = 0; i < procedure_ids.size(); i++) {
+            if (i > 0) query << ",";
+            query << procedure_ids[i];
+        }
+        query << ")";
+
+        MysqlResult result = db.executeSelectQuery(query.str());
+        if (result) {
+            MYSQL_ROW row;
+            while ((row = mysql_fetch_row(result.get()))) {
+                unsigned long* lengths = mysql_fetch_lengths(result.get());
+                if (!row[0] || (!row[1] && !row[2])) continue;
+                StoredProtectionGeometry stored;
+                if (row[2]) {
+                    stored.wkb.assign(row[2], lengths[2]);
+                    if (row[3]) stored.hash.assign(row[3], lengths[3]);
+                } else {
+                    stored.geojson = GeometryBlob::text(row[1], lengths[1]);
+                }
+                geometries.emplace(std::atoi(row[0]), std::move(stored));
+            }
+        } else {
+            logger_->warn("Failed to load protection geometries");
+        }
+    } catch (const std::exception& err) {
+        logger_->error("Failed to load protection geometries: {}", err.what());
+    }
+
+    return geometries;
+}
+
+std::vector<FlightProcedure> FlightProcedureRepository::findGeometries(const std::vector<int>& ids) {
+    std::vector<FlightProcedure> procedures;
+    if (ids.empty()) {
+        return procedures;
+    }
+
+    try {
+        auto& db = DatabaseManager::getInstance();
+        DatabaseManager::ReadScope read(db);
+        for (size_t start = 0; start < ids.size(); start += kRelatedBatchSize) {
+            const size_t end = std::min(ids.size(), start + kRelatedBatchSize);
+            std::string query = "SELECT id, trajectory_geometry, protection_geometry, updated_at "
+                                "FROM flight_procedures WHERE id IN (" + idList(ids, start, end) + ")";
+
+            MysqlResult result = db.executeSelectQuery(query);
+            if (!result) {
+                throw std::runtime_error("Failed to execute query");
+            }
+            MYSQL_ROW row;
+            while ((row = mysql_fetch_row(result.get()))) {
+                unsigned long* lengths = mysql_fetch_lengths(result.get());
+                FlightProcedure procedure;
+                procedure.id = std::atoi(row[0]);
+                if (row[1]) procedure.trajectory_geometry = std::string(row[1], lengths[1]);
+                if (row[2]) procedure.protection_geometry = GeometryBlob::text(row[2], lengths[2]);
+                if (row[3]) procedure.updated_at = stringToTimePoint(std::string(row[3]));
+                procedures.push_back(std::move(procedure));
+            }
+        }
+    } catch (const std::exception& err) {
+        logger_->error("Failed to read geometries of {} flight procedures: {}", ids.size(), err.what());
+        throw;
+    }
+    return procedures;
+}
+
+std::optional<std::string> FlightProcedureRepository::findRevision(int id) {
+    try {
+        auto& db = DatabaseManager::getInstance();
+
+        std::string query = "SELECT UNIX_TIMESTAMP(updated_at) FROM flight_procedures WHERE id = " + std::to_string(id);
+        MysqlResult result = db.executeSelectQuery(query);
+        if (!result) {
+            return std::nullopt;
+        }
+        std::optional<std::string> revision;
+        MYSQL_ROW row = mysql_fetch_row(result.get());
+        if (row) {
+            revision = row[0] ? std::string(row[0]) : "0";
+        }
+        return revision;
+    } catch (const std::exception& err) {
+        logger_->error("Failed to read revision of flight procedure {}: {}", id, err.what());
+    }
+    return std::nullopt;
+}
+
+bool FlightProcedureRepository::probeFootprintColumns() {
+    static std::once_flag once;
+    static bool available = false;
+
+    std::call_once(once, []() {
+        available = SchemaMigrations::hasColumn("flight_procedures", "protection_footprint_version");
+        spdlog::info("Protection footprints {}", available ? "stored with flight_procedures" : "computed in memory only");
+    });
+
+    return available;
+}
+
+bool FlightProcedureRepository::probeApplicabilityColumns() {
+    static std::once_flag once;
+    static bool available = false;
+
+    std::call_once(once, []() {
+        available = SchemaMigrations::hasColumn("flight_procedures", "time_restriction") &&
+                    SchemaMigrations::hasColumn("flight_procedures", "weather_dependent");
+        spdlog::info("Protection time restrictions {}", available ? "read from flight_procedures" : "not stored");
+    });
+
+    return available;
+}
+
+bool FlightProcedureRepository::saveProtectionFootprint(int procedure_id, int64_t revision,
+                                                        const ProtectionFootprint& footprint) {
+    if (!probeFootprintColumns()) {
+        return false;
+    }
+    try {
+        auto& db = DatabaseManager::getInstance();
+
+        // Envelope bounds are written exactly so a prefilter never cuts the geometry
+        std::stringstream query;
+        query.precision(17);
+        query << "UPDATE flight_procedures SET "
+              << "protection_min_lng = " << footprint.min_lng << ", "
+              << "protection_min_lat = " << footprint.min_lat << ", "
+              << "protection_max_lng = " << footprint.max_lng << ", "
+              << "protection_max_lat = " << footprint.max_lat << ", "
+              << "protection_vertex_count = " << footprint.vertex_count << ", "
+              << "protection_cells = '" << footprint.cellsText() << "', "
+              << "protection_footprint_version = " << revision << ", "
+              << "updated_at = updated_at "
+              << "WHERE id = " << procedure_id << " AND UNIX_TIMESTAMP(updated_at) = " << revision;
+        return db.executeQuery(query.str());
+    } catch (const std::exception& err) {
+        logger_->error("Failed to store protection footprint of flight procedure {}: {}", procedure_id, err.what());
+    }
+    return false;
+}
+
+bool FlightProcedureRepository::probeWkbColumns() {
+    static std::once_flag once;
+    static bool available = false;
+
+    std::call_once(once, []() {
+        available = SchemaMigrations::hasColumn("flight_procedures", "protection_wkb_version");
+        spdlog::info("Protection geometries {}", available ? "loaded from stored WKB" : "parsed from GeoJSON");
+    });
+
+    return available;
+}
+
+bool FlightProcedureRepository::probeGeometryStore() {
+    static std::once_flag once;
+    static bool available = false;
+
+    std::call_once(once, []() {
+        available = probeWkbColumns() && SchemaMigrations::hasTable("geometry_blobs") &&
+                    SchemaMigrations::hasColumn("flight_procedures", "protection_geometry_hash");
+        spdlog::info("Protection WKB {}", available ? "stored once per distinct geometry" : "stored per procedure");
+    });
+
+    return available;
+}
+
+bool FlightProcedureRepository::saveProtectionWkb(int procedure_id, int64_t revision, const std::string& wkb) {
+    if (!probeWkbColumns()) {
+        return false;
+    }
+    try {
+        auto& db = DatabaseManager::getInstance();
+
+        if (probeGeometryStore()) {
+            // A blob is never rewritten: the same hash is the same bytes
+            const std::string hash = ProtectionGeometryCache::contentHash(wkb);
+            db.executePrepared("INSERT IGNORE INTO geometry_blobs (hash, wkb, created_at) VALUES (?, ?, NOW(3))",
+                               {hash, wkb});
+            db.executePrepared("UPDATE flight_procedures SET protection_geometry_hash = ?, protection_wkb = NULL, "
+                               "protection_wkb_version = ?, updated_at = updated_at "
+                               "WHERE id = ? AND UNIX_TIMESTAMP(updated_at) = ?",
+                               {hash, revision, static_cast<int64_t>(procedure_id), revision});
+            return true;
+        }
+
+        // Bound as a parameter: the binary protocol carries the blob unescaped
+        db.executePrepared("UPDATE flight_procedures SET protection_wkb = ?, protection_wkb_version = ?, "
+                           "updated_at = updated_at WHERE id = ? AND UNIX_TIMESTAMP(updated_at) = ?",
+                           {wkb, revision, static_cast<int64_t>(procedure_id), revision});
+        return true;
+    } catch (const std::exception& err) {
+        logger_->error("Failed to store protection WKB of flight procedure {}: {}", procedure_id, err.what());
+    }
+    return false;
+}
+
+std::optional<std::vector<int>> FlightProcedureRepository::insertBatch(const std::vector<ImportedProcedure>& procedures,
+                                                                      int64_t revision) {
+    auto& db = DatabaseManager::getInstance();
+    const bool footprints = probeFootprintColumns();
+    const bool wkb = probeWkbColumns();
+    const bool store = probeGeometryStore();
+
+    std::string prefix = "INSERT INTO flight_procedures (procedure_code, name, type, airport_icao, runway, description, "
+                         "trajectory_geometry, protection_geometry, effective_date, expiry_date, is_active, "
+                         "created_at, updated_at";
+    if (footprints) {
+        prefix += ", protection_min_lng, protection_min_lat, protection_max_lng, protection_max_lat, "
+                  "protection_vertex_count, protection_cells, protection_footprint_version";
+    }
+    if (wkb) {
+        prefix += store ? ", protection_geometry_hash, protection_wkb_version" : ", protection_wkb, protection_wkb_version";
+    }
+    prefix += ") VALUES ";
+
+    try {
+        DatabaseManager::Transaction transaction(db);
+        MYSQL* con = transaction.get();
+
+        auto text = [con](const std::string& value) {
+            std::string escaped(value.size() * 2 + 1, '\0');
+            escaped.resize(mysql_real_escape_string(con, escaped.data(), value.c_str(), value.size()));
+            return "'" + escaped + "'";
+        };
+        auto optionalText = [&](const std::optional<std::string>& value) {
+            return value ? text(*value) : std::string("NULL");
+        };
+        auto date = [&](const std::optional<std::chrono::system_clock::time_point>& value) {
+            return value ? text(timePointToString(*value)) : std::string("NULL");
+        };
+        auto geometry = [&](const std::optional<std::string>& value) {
+            if (!value) return std::string("NULL");
+            auto packed = GeometryBlob::packedLiteral(*value, "flight_procedures", "protection_geometry");
+            return packed ? std::move(*packed) : text(*value);
+        };
+        const std::string stamp = "FROM_UNIXTIME(" + std::to_string(revision) + ")";
+        // Hex literal: binary safe without escaping
+        auto hexLiteral = [](const std::string& bytes) {
+            std::string hex(bytes.size() * 2 + 1, '\0');
+            hex.resize(mysql_hex_string(hex.data(), bytes.data(), bytes.size()));
+            return hex;
+        };
+
+        // With the store each distinct geometry is written once, ahead of the
+        // rows referencing it; procedures sharing a protection share the blob
+        std::unordered_map<const ImportedProcedure*, std::string> hashes;
+        if (wkb && store) {
+            std::unordered_set<std::string> written;
+            const std::string blob_prefix = "INSERT IGNORE INTO geometry_blobs (hash, wkb, created_at) VALUES ";
+            std::string blobs;
+            for (const auto& imported : procedures) {
+                if (imported.wkb.empty()) continue;
+                std::string hash = ProtectionGeometryCache::contentHash(imported.wkb);
+                if (written.insert(hash).second) {
+                    std::string value = "('" + hash + "', X'" + hexLiteral(imported.wkb) + "', NOW(3))";
+                    if (!blobs.empty() && blobs.size() + value.size() + 1 > kMaxInsertStatementBytes) {
+                        if (!db.executeQuery(blobs)) {
+                            transaction.rollback();
+                            logger_->error("Rolled back import of {} flight procedures: geometry blobs not written",
+                                           procedures.size());
+                            return std::nullopt;
+                        }
+                        blobs.clear();
+                    }
+                    blobs += blobs.empty() ? blob_prefix : ",";
+                    blobs += value;
+                }
+                hashes.emplace(&imported, std::move(hash));
+            }
+            if (!blobs.empty() && !db.executeQuery(blobs)) {
+                transaction.rollback();
+                logger_->error("Rolled back import of {} flight procedures: geometry blobs not written",
+                               procedures.size());
+                return std::nullopt;
+            }
+        }
+
+        auto rowSql = [&](const ImportedProcedure& imported) {
+            const auto& p = imported.procedure;
+            std::stringstream row;
+            row.precision(17);
+            row << "(" << text(p.procedure_code) << ", " << text(p.name) << ", " << text(procedureTypeToString(p.type))
+                << ", " << text(p.airport_icao) << ", " << optionalText(p.runway) << ", " << optionalText(p.description)
+                << ", " << optionalText(p.trajectory_geometry) << ", " << geometry(p.protection_geometry) << ", "
+                << date(p.effective_date) << ", " << date(p.expiry_date) << ", " << (p.is_active ? 1 : 0) << ", "
+                << stamp << ", " << stamp;
+            if (footprints) {
+                if (const auto& f = imported.footprint) {
+                    row << ", " << f->min_lng << ", " << f->min_lat << ", " << f->max_lng << ", " << f->max_lat << ", "
+                        << f->vertex_count << ", '" << f->cellsText() << "', " << revision;
+                } else {
+                    row << ", NULL, NULL, NULL, NULL, NULL, NULL, NULL";
+                }
+            }
+            if (wkb) {
+                if (!imported.wkb.empty() && store) {
+                    row << ", '" << hashes.at(&imported) << "', " << revision;
+                } else if (!imported.wkb.empty()) {
+                    row << ", X'" << hexLiteral(imported.wkb) << "', " << revision;
+                } else {
+                    row << ", NULL, NULL";
+                }
+            }
+            row << ")";
+            return row.str();
+        };
+
+        // A multi-row INSERT takes consecutive auto-increment ids, the first
+        // of them reported by mysql_insert_id
+        std::vector<int> ids;
+        ids.reserve(procedures.size());
+        std::string statement;
+        size_t rows_in_statement = 0;
+        auto flush = [&]() {
+            if (!db.executeQuery(statement)) return false;
+            const int first = static_cast<int>(mysql_insert_id(con));
+            for (size_t k = 0; k < rows_in_statement; k++) ids.push_back(first + static_cast<int>(k));
+            statement.clear();
+            rows_in_statement = 0;
+            return true;
+        };
+
+        bool ok = true;
+        for (size_t i = 0; ok && i < procedures.size(); i++) {
+            std::string row = rowSql(procedures[i]);
+            // Flush before this row would push the statement past the size limit
+            if (rows_in_statement > 0 && statement.size() + row.size() + 1 > kMaxInsertStatementBytes) {
+                ok = flush();
+            }
+            statement += rows_in_statement == 0 ? prefix : ",";
+            statement += row;
+            rows_in_statement++;
+        }
+        if (ok && rows_in_statement > 0) {
+            ok = flush();
+        }
+
+        if (!ok) {
+            transaction.rollback();
+            logger_->error("Rolled back import of {} flight procedures", procedures.size());
+            return std::nullopt;
+        }
+        if (!transaction.commit()) {
+            logger_->error("Failed to commit import of {} flight procedures", procedures.size());
+            return std::nullopt;
+        }
+        return ids;
+
+    } catch (const std::exception& err) {
+        logger_->error("Exception importing flight procedures: {}", err.what());
+        return std::nullopt;
+    }
+}
+
 // Create, Update, Delete operations (simplified for brevity)
 FlightProcedure FlightProcedureRepository::create(const FlightProcedure& procedure) {
     // Implementation would go here
@@ -1,9 +1,13 @@
 #pragma once
 
+#include "AnalysisSources.h"
 #include "FlightProcedure.h"
+#include "ListPage.h"
 #include <vector>
+#include <unordered_map>
 #include <optional>
 #include <memory>
+#include <span>
 #include <spdlog/spdlog.h>
 
 // Conditional includes based on available MySQL API
@@ -22,40 +26,111 @@ struct FlightProcedureFilter {
     std::optional<bool> is_active;
     bool include_segments = true;
     bool include_protections = true;
+    // Geometry text is read only when wanted; left unset otherwise
+    bool include_trajectory_geometry = true;
+    bool include_protection_geometry = true;
     int limit = 100;
     int offset = 0;
+    // Rows after this (procedure_code, id) in list order; offset is then ignored
+    std::optional<PageCursor> after;
 };
 
-class FlightProcedureRepository {
+// A procedure read by a bulk import, with what was derived from its
+// protection geometry where the columns for it exist
+struct ImportedProcedure {
+    FlightProcedure procedure;
+    std::optional<ProtectionFootprint> footprint;
+    std::string wkb; // empty when not stored
+};
+
+class FlightProcedureRepository : public ProtectionSource {
 public:
     FlightProcedureRepository();
-    ~FlightProcedureRepository() = default;
+    ~FlightProcedureRepository() override = default;
     
     // CRUD operations
+    // By procedure_code, ties by id
     std::vector<FlightProcedure> findAll(const FlightProcedureFilter& filter = {});
     std::optional<FlightProcedure> findById(int id);
     std::optional<FlightProcedure> findByCode(const std::string& code);
     std::vector<FlightProcedure> findByAirport(const std::string& airport_icao);
+    // id, updated_at and both geometries of each procedure, with one IN query
+    // per kRelatedBatchSize ids; ids that do not exist are left out
+    std::vector<FlightProcedure> findGeometries(const std::vector<int>& ids);
     FlightProcedure create(const FlightProcedure& procedure);
     bool update(int id, const FlightProcedure& procedure);
     bool deleteById(int id);
     
     // Segment operations
     std::vector<ProcedureSegment> getSegments(int procedure_id);
+    // Segments of each procedure in segment order, read with one IN query
+    // per kRelatedBatchSize ids; empty without the procedure_segments table
+    std::unordered_map<int, std::vector<ProcedureSegment>> findSegments(const std::vector<int>& procedure_ids);
     ProcedureSegment createSegment(const ProcedureSegment& segment);
     bool updateSegment(int id, const ProcedureSegment& segment);
     bool deleteSegment(int id);
     
     // Protection operations
     std::vector<ProcedureProtection> getProtections(int procedure_id);
+    // Active flight_procedure_protection rows of each procedure, batched the same way
+    std::unordered_map<int, std::vector<ProcedureProtection>> findProtections(const std::vector<int>& procedure_ids);
+    static constexpr size_t kRelatedBatchSize = 1000;
     ProcedureProtection createProtection(const ProcedureProtection& protection);
     bool updateProtection(int id, const ProcedureProtection& protection);
     bool deleteProtection(int id);
     
     // Statistics
     int count(const FlightProcedureFilter& filter = {});
+    // Cursor after procedure in findAll order
+    static PageCursor cursorAfter(const FlightProcedure& procedure) { return {procedure.procedure_code, procedure.id}; }
 
     std::vector<ProcedureProtection> findAllActiveProtections();
+
+    // Active protections without the geometry blob; updated_at is filled so
+    // callers can check their cached geometry version, and the procedure's
+    // effective and expiry dates for the conflict prefilter
+    std::vector<ProcedureProtection> findActiveProtectionHeaders() override;
+    // Stored protection geometry for the given procedure ids: the WKB when
+    // it is current for the procedure's revision, the GeoJSON text otherwise
+    std::unordered_map<int, StoredProtectionGeometry> findProtectionGeometries(
+        const std::vector<int>& procedure_ids) override;
+    std::unordered_map<int, std::vector<ProcedureSegment>> findProcedureSegments(
+        const std::vector<int>& procedure_ids) override {
+        return findSegments(procedure_ids);
+    }
+    // updated_at of one procedure as epoch seconds, for ETags; nullopt if
+    // the procedure does not exist or the lookup failed
+    std::optional<std::string> findRevision(int id);
+
+    // Footprint columns of flight_procedures (protection_min_lng, _min_lat,
+    // _max_lng, _max_lat, _vertex_count, _cells, _footprint_version); probed
+    // once, and everything footprint-related is skipped without them
+    static bool probeFootprintColumns();
+    bool storesFootprints() override { return probeFootprintColumns(); }
+    // Stores the footprint of the geometry at revision; keeps updated_at and
+    // writes nothing if the row has changed since
+    bool saveProtectionFootprint(int procedure_id, int64_t revision, const ProtectionFootprint& footprint) override;
+
+    // WKB columns of flight_procedures (protection_wkb, protection_wkb_version);
+    // probed once like the footprint columns
+    static bool probeWkbColumns();
+    // time_restriction and weather_dependent of flight_procedures, read into
+    // the protection headers when present
+    static bool probeApplicabilityColumns();
+    bool storesWkb() override { return probeWkbColumns(); }
+    // Content-addressed store (geometry_blobs, protection_geometry_hash);
+    // with it WKB is written once per distinct geometry and rows reference
+    // it by hash, without it into protection_wkb of each row
+    static bool probeGeometryStore();
+    // Stores the validated geometry at revision as WKB, under the same rules
+    bool saveProtectionWkb(int procedure_id, int64_t revision, const std::string& wkb) override;
+
+    // Inserts the procedures in one transaction with multi-row INSERTs of at
+    // most kMaxInsertStatementBytes each. Every row gets updated_at =
+    // revision (epoch seconds), so footprints and WKB written with it are
+    // current from the start. New ids in input order; nullopt after a rollback.
+    std::optional<std::vector<int>> insertBatch(const std::vector<ImportedProcedure>& procedures, int64_t revision);
+    static constexpr size_t kMaxInsertStatementBytes = 4 * 1024 * 1024;
     
 private:
     std::shared_ptr<spdlog::logger> logger_;
@@ -74,7 +149,8 @@ private:
     ProcedureProtection rowToProtection(mysqlx::Row& row);
 #endif
     
-    void loadRelatedData(FlightProcedure& procedure, bool include_segments, bool include_protections);
+    // Fills segments and protections of all the procedures with one query per child table
+    void loadRelatedData(std::span<FlightProcedure> procedures, bool include_segments, bool include_protections);
 };
 
 } // namespace aeronautical
\ No newline at end of file
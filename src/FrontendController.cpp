@@ -0,0 +1,317 @@
+#include "FrontendController.h"
+#include "ConditionalGet.h"
+#include "FileResponse.h"
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include <openssl/evp.h>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <vector>
+
+namespace aeronautical {
+
+namespace {
+
+constexpr size_t kMinCompressBytes = 256;
+
+std::string hexDigest(EVP_MD_CTX* ctx) {
+    static const char hex[] = "0123456789abcdef";
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int length = 0;
+    EVP_DigestFinal_ex(ctx, digest, &length);
+    std::string out;
+    for (unsigned int i = 0; i < length; i++) {
+        out += hex[digest[i] >> 4];
+        out += hex[digest[i] & 0xf];
+    }
+    return out;
+}
+
+std::string sha256(std::string_view data) {
+    std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> ctx(EVP_MD_CTX_new(), EVP_MD_CTX_free);
+    EVP_DigestInit_ex(ctx.get(), EVP_sha256(), nullptr);
+    EVP_DigestUpdate(ctx.get(), data.data(), data.size());
+    return hexDigest(ctx.get());
+}
+
+// Hash of a file too large to read in one piece; empty when unreadable
+std::string sha256File(const std::filesystem::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return {};
+    std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> ctx(EVP_MD_CTX_new(), EVP_MD_CTX_free);
+    EVP_DigestInit_ex(ctx.get(), EVP_sha256(), nullptr);
+    std::vector<char> buffer(64 * 1024);
+    while (in.read(buffer.data(), buffer.size()) || in.gcount() > 0) {
+        EVP_DigestUpdate(ctx.get(), buffer.data(), static_cast<size_t>(in.gcount()));
+    }
+    return hexDigest(ctx.get());
+}
+
+std::string contentType(const std::filesystem::path& path) {
+    std::string extension = path.extension().string();
+    if (!extension.empty()) extension.erase(0, 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    auto it = crow::mime_types.find(extension);
+    std::string type = it != crow::mime_types.end() ? it->second : "application/octet-stream";
+    if (type.rfind("text/", 0) == 0 || type == "application/javascript") type += "; charset=utf-8";
+    return type;
+}
+
+bool compressible(const std::string& content_type) {
+    return content_type.rfind("text/", 0) == 0 || content_type.find("javascript") != std::string::npos ||
+           content_type.find("json") != std::string::npos || content_type.find("svg") != std::string::npos ||
+           content_type.find("icon") != std::string::npos;
+}
+
+// Types whose local references are versioned
+bool rewritable(const std::string& content_type) {
+    return content_type.rfind("text/html", 0) == 0 || content_type.rfind("text/css", 0) == 0 ||
+           content_type.find("javascript") != std::string::npos;
+}
+
+crow::response notFound() {
+    crow::response res(404, "{\"error\":true,\"message\":\"Not found\"}");
+    res.add_header("Content-Type", "application/json");
+    return res;
+}
+
+} // namespace
+
+FrontendController::FrontendController() {
+    try {
+        logger_ = spdlog::get("aeronautical");
+        if (!logger_) {
+            auto console_sink = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
+            logger_ = std::make_shared<spdlog::logger>("aeronautical", console_sink);
+            spdlog::register_logger(logger_);
+        }
+    } catch (const std::exception& e) {
+        logger_ = spdlog::default_logger();
+    }
+}
+
+bool FrontendController::load(const FrontendSettings& settings) {
+    namespace fs = std::filesystem;
+    settings_ = settings;
+    assets_.clear();
+    memory_bytes_ = 0;
+
+    std::error_code ec;
+    if (settings_.root.empty() || !fs::is_directory(settings_.root, ec)) {
+        return false;
+    }
+
+    // Raw contents and hashes first: rewriting needs the full set of files
+    // and the build hash over all of them
+    std::map<std::string, std::string> raw; // kept files by URL path
+    std::map<std::string, std::string> hashes;
+    for (auto it = fs::recursive_directory_iterator(settings_.root, ec); !ec && it != fs::recursive_directory_iterator();
+         it.increment(ec)) {
+        const fs::path& path = it->path();
+        if (path.filename().string().front() == '.') {
+            if (it->is_directory()) it.disable_recursion_pending();
+            continue;
+        }
+        if (!it->is_regular_file()) continue;
+
+        const std::string url = "/" + fs::relative(path, settings_.root).generic_string();
+        Asset asset;
+        asset.content_type = contentType(path);
+        asset.html = asset.content_type.rfind("text/html", 0) == 0;
+        if (it->file_size() > settings_.stream_bytes) {
+            asset.path = path.string();
+            hashes[url] = sha256File(path);
+            asset.etag = "\"" + hashes[url].substr(0, 20) + "\"";
+        } else {
+            std::ifstream in(path, std::ios::binary);
+            std::string body((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            hashes[url] = sha256(body);
+            raw[url] = std::move(body);
+        }
+        assets_[url] = std::move(asset);
+    }
+    if (ec) {
+        logger_->error("Failed to read frontend directory {}: {}", settings_.root, ec.message());
+        return false;
+    }
+
+    std::string manifest;
+    for (const auto& [url, hash] : hashes) manifest += url + " " + hash + "\n";
+    build_ = sha256(manifest).substr(0, 12);
+
+    for (auto& [url, body] : raw) {
+        Asset& asset = assets_[url];
+        if (rewritable(asset.content_type)) body = rewriteReferences(url, body);
+        asset.etag = "\"" + sha256(body).substr(0, 20) + "\"";
+        if (compressible(asset.content_type) && body.size() >= kMinCompressBytes) {
+            for (auto encoding : {ResponseCompression::Encoding::Brotli, ResponseCompression::Encoding::Gzip,
+                                  ResponseCompression::Encoding::Deflate}) {
+                std::string compressed = ResponseCompression::compress(body, encoding, 9);
+                if (compressed.empty() || compressed.size() >= body.size()) continue;
+                memory_bytes_ += compressed.size();
+                asset.bodies[static_cast<size_t>(encoding)] = std::make_shared<const std::string>(std::move(compressed));
+            }
+        }
+        memory_bytes_ += body.size();
+        asset.bodies[static_cast<size_t>(ResponseCompression::Encoding::Identity)] =
+            std::make_shared<const std::string>(std::move(body));
+    }
+
+    logger_->info("Frontend {} loaded: {} files, {} KB in memory, build {}", settings_.root, assets_.size(),
+                  memory_bytes_ >> 10, build_);
+    return true;
+}
+
+std::string FrontendController::resolve(const std::string& file, const std::string& reference) const {
+    if (reference.empty() || reference.find("://") != std::string::npos || reference.rfind("//", 0) == 0 ||
+        reference.find_first_of("?#") != std::string::npos || reference.rfind("data:", 0) == 0 ||
+        reference.rfind("mailto:", 0) == 0) {
+        return {};
+    }
+    const std::string joined = reference.front() == '/' ? reference : file.substr(0, file.rfind('/') + 1) + reference;
+
+    std::vector<std::string> segments;
+    size_t start = 1;
+    while (start <= joined.size()) {
+        size_t end = joined.find('/', start);
+        if (end == std::string::npos) end = joined.size();
+        const std::string segment = joined.substr(start, end - start);
+        if (segment == "..") {
+            if (segments.empty()) return {};
+            segments.pop_back();
+        } else if (!segment.empty() && segment != ".") {
+            segments.push_back(segment);
+        }
+        start = end + 1;
+    }
+    std::string path;
+    for (const auto& segment : segments) path += "/" + segment;
+    return assets_.count(path) ? path : std::string();
+}
+
+std::string FrontendController::rewriteReferences(const std::string& file, const std::string& text) const {
+    static const std::array<std::string_view, 5> markers{"src=", "href=", "from ", "import(", "url("};
+    std::string out;
+    out.reserve(text.size() + 256);
+    size_t copied = 0;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        // Earliest marker from pos
+        size_t found = std::string::npos;
+        size_t marker_length = 0;
+        for (auto marker : markers) {
+            size_t at = text.find(marker, pos);
+            if (at < found) {
+                found = at;
+                marker_length = marker.size();
+            }
+        }
+        if (found == std::string::npos) break;
+
+        size_t begin = found + marker_length;
+        while (begin < text.size() && text[begin] == ' ') begin++;
+        if (begin >= text.size()) break;
+        char terminator = ')';
+        if (text[begin] == '"' || text[begin] == '\'') {
+            terminator = text[begin++];
+        } else if (text[found + marker_length - 1] != '(') {
+            pos = begin;
+            continue;
+        }
+        const size_t end = text.find(terminator, begin);
+        if (end == std::string::npos) break;
+        const std::string reference = text.substr(begin, end - begin);
+        if (reference.find('\n') == std::string::npos && !resolve(file, reference).empty()) {
+            out.append(text, copied, end - copied);
+            out += "?v=" + build_;
+            copied = end;
+        }
+        pos = end;
+    }
+    out.append(text, copied, std::string::npos);
+    return out;
+}
+
+void FrontendController::registerRoutes(HttpApp& app) {
+    // Every path no API route claims; the router calls this before any middleware
+    CROW_CATCHALL_ROUTE(app)([this](const crow::request& req, crow::response& res) {
+        serve(req, res);
+        res.end();
+    });
+
+    logger_->info("Frontend routes registered");
+}
+
+void FrontendController::serve(const crow::request& req, crow::response& res) const {
+    std::string path = req.url.substr(0, req.url.find('?'));
+    if (req.method != crow::HTTPMethod::GET || path.rfind("/api/", 0) == 0) {
+        const int code = res.code;
+        res = notFound();
+        if (code == 405) res.code = 405;
+        return;
+    }
+    if (path.empty() || path.back() == '/') {
+        path += "index.html";
+    }
+    auto it = assets_.find(path);
+    if (it == assets_.end()) {
+        it = assets_.find(path + "/index.html");
+    }
+    if (it == assets_.end()) {
+        res = notFound();
+        return;
+    }
+    const Asset& asset = it->second;
+
+    const char* version = req.url_params.get("v");
+    const char* cache_control = !asset.html && version && build_ == version
+                                    ? "public, max-age=31536000, immutable"
+                                    : "no-cache";
+    if (ConditionalGet::isCurrent(req, CacheValidator{asset.etag, std::nullopt})) {
+        not_modified_.fetch_add(1, std::memory_order_relaxed);
+        res = ConditionalGet::notModified(CacheValidator{asset.etag, std::nullopt});
+        res.add_header("Cache-Control", cache_control);
+        return;
+    }
+    served_.fetch_add(1, std::memory_order_relaxed);
+
+    if (!asset.path.empty()) {
+        // Sent from disk by the connection, never held in memory
+        FileResponse::prepare(req, res, asset.path, asset.content_type, asset.etag);
+        res.add_header("Cache-Control", cache_control);
+        return;
+    }
+
+    auto encoding = ResponseCompression::negotiate(req.get_header_value("Accept-Encoding"));
+    if (!asset.bodies[static_cast<size_t>(encoding)]) {
+        encoding = ResponseCompression::Encoding::Identity;
+    }
+    res = crow::response(200);
+    res.body = *asset.bodies[static_cast<size_t>(encoding)];
+    res.add_header("Content-Type", asset.content_type);
+    res.add_header("ETag", asset.etag);
+    res.add_header("Cache-Control", cache_control);
+    if (encoding != ResponseCompression::Encoding::Identity) {
+        res.add_header("Content-Encoding", ResponseCompression::name(encoding));
+    }
+    if (asset.bodies[static_cast<size_t>(ResponseCompression::Encoding::Gzip)] ||
+        asset.bodies[static_cast<size_t>(ResponseCompression::Encoding::Brotli)]) {
+        res.add_header("Vary", "Accept-Encoding");
+    }
+}
+
+nlohmann::json FrontendController::stats() const {
+    nlohmann::json j;
+    j["enabled"] = !assets_.empty();
+    j["root"] = settings_.root;
+    j["build"] = build_;
+    j["files"] = assets_.size();
+    j["memory_bytes"] = memory_bytes_;
+    j["served"] = served_.load(std::memory_order_relaxed);
+    j["not_modified"] = not_modified_.load(std::memory_order_relaxed);
+    return j;
+}
+
+} // namespace aeronautical
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <crow.h>
+#include "HttpApp.h"
+#include "ResponseCompression.h"
+#include <json.hpp>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <spdlog/spdlog.h>
+#include <string>
+#include <unordered_map>
+
+namespace aeronautical {
+
+struct FrontendSettings {
+    std::string root;                // directory served at /; empty leaves the frontend to another server
+    size_t stream_bytes = 1u << 20;  // larger files stay on disk and are sent from it
+};
+
+// Serves the frontend/ directory for requests no API route matches. Files
+// are read once at startup, hashed and, when text-like, compressed ahead
+// of time with every coding ResponseCompression offers. Local references
+// in HTML, CSS and JS (src/href attributes, url(), module imports) get
+// ?v=<build> appended, where the build hash covers every file, so a
+// versioned URL always names the same bytes and is cached as immutable;
+// HTML and unversioned URLs revalidate against a content ETag instead.
+class FrontendController {
+public:
+    FrontendController();
+    ~FrontendController() = default;
+
+    // Reads every file under settings.root; false when it is not a directory
+    bool load(const FrontendSettings& settings);
+    void registerRoutes(HttpApp& app);
+
+    nlohmann::json stats() const;
+
+private:
+    struct Asset {
+        std::string content_type;
+        std::string etag; // quoted content hash
+        bool html = false;
+        std::string path; // on disk, for files too large to keep
+        // Indexed by ResponseCompression::Encoding; empty when not kept
+        std::array<std::shared_ptr<const std::string>, 4> bodies;
+    };
+
+    void serve(const crow::request& req, crow::response& res) const;
+    std::string rewriteReferences(const std::string& file, const std::string& text) const;
+    std::string resolve(const std::string& file, const std::string& reference) const;
+
+    std::shared_ptr<spdlog::logger> logger_;
+    FrontendSettings settings_;
+    std::unordered_map<std::string, Asset> assets_; // by URL path, e.g. /js/main.js
+    std::string build_;
+    size_t memory_bytes_ = 0;
+
+    mutable std::atomic<uint64_t> served_{0};
+    mutable std::atomic<uint64_t> not_modified_{0};
+};
+
+} // namespace aeronautical
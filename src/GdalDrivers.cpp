@@ -0,0 +1,70 @@
+#include "GdalDrivers.h"
+#include "gdal.h"
+#include <spdlog/spdlog.h>
+#include <atomic>
+#include <chrono>
+#include <dlfcn.h>
+#include <mutex>
+
+namespace aeronautical {
+
+namespace {
+
+std::atomic<bool> all_drivers{false};
+std::once_flag registered;
+
+struct Driver {
+    const char* name;        // GDAL short name
+    const char* register_fn; // exported by libgdal when the driver is built in
+};
+
+const Driver kDrivers[] = {
+    {"GTiff", "GDALRegister_GTiff"},
+    {"VRT", "GDALRegister_VRT"},
+    {"MVT", "RegisterOGRMVT"},
+    {"MEM", "GDALRegister_MEM"}, // document thumbnails (DocumentPipeline)
+    {"PNG", "GDALRegister_PNG"},
+    {"JPEG", "GDALRegister_JPEG"},
+    {"GPKG", "RegisterOGRGeoPackage"}, // geospatial exports (ExportService)
+    {"ESRI Shapefile", "RegisterOGRShape"},
+    {"KML", "RegisterOGRKML"},
+    {"GeoJSON", "RegisterOGRGeoJSON"},
+    {"SQLite", "RegisterOGRSQLite"}, // offline MBTiles packs (TilePackService)
+};
+
+// Looked up at run time: a driver built as a plugin, or left out of the
+// build, has no registration function to link against
+bool registerBuiltIn(const Driver& driver) {
+    if (GDALGetDriverByName(driver.name)) return true;
+    auto* fn = reinterpret_cast<void (*)()>(dlsym(RTLD_DEFAULT, driver.register_fn));
+    if (!fn) return false;
+    fn();
+    return GDALGetDriverByName(driver.name) != nullptr;
+}
+
+} // namespace
+
+void setGdalAllDrivers(bool all) {
+    all_drivers.store(all, std::memory_order_relaxed);
+}
+
+void registerGdalDrivers() {
+    std::call_once(registered, []() {
+        const auto started = std::chrono::steady_clock::now();
+        bool complete = !all_drivers.load(std::memory_order_relaxed);
+        for (const auto& driver : kDrivers) {
+            if (!complete) break;
+            if (!registerBuiltIn(driver)) {
+                spdlog::info("GDAL driver {} is not built in; registering every driver", driver.name);
+                complete = false;
+            }
+        }
+        if (!complete) {
+            GDALAllRegister();
+        }
+        const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - started;
+        spdlog::info("GDAL drivers registered in {:.1f} ms ({} drivers)", elapsed.count(), GDALGetDriverCount());
+    });
+}
+
+} // namespace aeronautical
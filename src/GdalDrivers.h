@@ -0,0 +1,16 @@
+#pragma once
+
+namespace aeronautical {
+
+// Registers, once, the GDAL drivers the backend opens or creates: GTiff
+// and VRT for the DEM, MVT for vector tiles, MEM, PNG and JPEG for
+// uploaded documents, GPKG, ESRI Shapefile, KML and GeoJSON for exports,
+// and SQLite for offline MBTiles packs. Geometry parsing and the conflict
+// engine need no driver at all, so nothing is registered until the first
+// DEM, tile, document, export or pack needs it. A driver missing from
+// libgdal, or all = true (GDAL_ALL_DRIVERS=1, e.g. for a DEM in another
+// format), falls back to GDALAllRegister().
+void setGdalAllDrivers(bool all);
+void registerGdalDrivers();
+
+} // namespace aeronautical
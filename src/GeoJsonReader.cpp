@@ -0,0 +1,514 @@
+#include "GeoJsonReader.h"
+#include <charconv>
+#include <memory>
+#include <utility>
+
+namespace aeronautical {
+
+namespace {
+
+constexpr int kMaxNesting = 128;
+
+// Coordinate nesting each geometry type expects above its positions
+int expectedDepth(GeoJsonGeometry::Type type) {
+    switch (type) {
+        case GeoJsonGeometry::Type::Point: return 0;
+        case GeoJsonGeometry::Type::LineString:
+        case GeoJsonGeometry::Type::MultiPoint: return 1;
+        case GeoJsonGeometry::Type::Polygon:
+        case GeoJsonGeometry::Type::MultiLineString: return 2;
+        case GeoJsonGeometry::Type::MultiPolygon: return 3;
+        case GeoJsonGeometry::Type::GeometryCollection: break;
+    }
+    return -1;
+}
+
+std::optional<GeoJsonGeometry::Type> geometryType(std::string_view name) {
+    using Type = GeoJsonGeometry::Type;
+    if (name == "Point") return Type::Point;
+    if (name == "LineString") return Type::LineString;
+    if (name == "Polygon") return Type::Polygon;
+    if (name == "MultiPoint") return Type::MultiPoint;
+    if (name == "MultiLineString") return Type::MultiLineString;
+    if (name == "MultiPolygon") return Type::MultiPolygon;
+    if (name == "GeometryCollection") return Type::GeometryCollection;
+    return std::nullopt;
+}
+
+// Members of one JSON object that matter to GeoJSON. "type" may come after
+// the other members, so an object is only interpreted once it is closed.
+struct Node {
+    explicit Node(std::pmr::memory_resource* resource) : shape(resource), geometries(resource) {}
+
+    std::string_view type;
+    bool has_coordinates = false;
+    int coordinate_depth = -1; // -1 while only empty arrays were seen
+    GeoJsonGeometry shape;     // coordinates and counts; type is set later
+    bool has_geometries = false;
+    bool geometries_ok = true;
+    std::pmr::vector<GeoJsonGeometry> geometries;
+    bool has_features = false;
+    std::vector<GeoJsonFeature> features;
+    std::unique_ptr<Node> geometry;
+    std::string_view geometry_text;
+};
+
+std::optional<GeoJsonGeometry> toGeometry(Node& node) {
+    auto type = geometryType(node.type);
+    if (!type) return std::nullopt;
+
+    GeoJsonGeometry geometry(node.shape.coordinates.get_allocator().resource());
+    geometry.type = *type;
+    if (*type == GeoJsonGeometry::Type::GeometryCollection) {
+        if (!node.has_geometries || !node.geometries_ok) return std::nullopt;
+        geometry.geometries = std::move(node.geometries);
+        return geometry;
+    }
+
+    if (!node.has_coordinates) return std::nullopt;
+    const int depth = expectedDepth(*type);
+    if (node.coordinate_depth != depth && node.coordinate_depth != -1) return std::nullopt;
+    // Arrays at or below the position level would be empty positions
+    for (size_t level = depth; level < node.shape.counts.size(); level++) {
+        if (!node.shape.counts[level].empty()) return std::nullopt;
+    }
+    if (depth == 0 && node.shape.positionCount() != 1) return std::nullopt;
+
+    geometry.dimensions = node.shape.dimensions;
+    geometry.coordinates = std::move(node.shape.coordinates);
+    geometry.counts = std::move(node.shape.counts);
+    return geometry;
+}
+
+GeoJsonFeature toFeature(Node& node) {
+    GeoJsonFeature feature;
+    if (node.geometry) {
+        feature.geometry = toGeometry(*node.geometry);
+        feature.geometry_text = node.geometry_text;
+    }
+    return feature;
+}
+
+class Parser {
+public:
+    Parser(std::string_view text, std::pmr::memory_resource* resource) : text_(text), resource_(resource) {}
+
+    bool failed() const { return failed_; }
+    size_t offset() const { return pos_; }
+
+    bool atEnd() {
+        skipWhitespace();
+        return pos_ == text_.size();
+    }
+
+    // Reads the object at the cursor; false (and failed) for anything else
+    bool readObject(Node& node) {
+        skipWhitespace();
+        if (!consume('{')) return fail();
+        if (++nesting_ > kMaxNesting) return fail();
+
+        skipWhitespace();
+        if (!consume('}')) {
+            do {
+                skipWhitespace();
+                std::string_view key;
+                if (!readString(key)) return fail();
+                skipWhitespace();
+                if (!consume(':')) return fail();
+                skipWhitespace();
+                if (!readMember(key, node)) return fail();
+                skipWhitespace();
+            } while (consume(','));
+            if (!consume('}')) return fail();
+        }
+        nesting_--;
+        return true;
+    }
+
+private:
+    bool readMember(std::string_view key, Node& node) {
+        if (key == "type") {
+            if (peek() == '"') return readString(node.type);
+        } else if (key == "coordinates") {
+            if (peek() == '[') {
+                // A shape that is no coordinate array is skipped, not fatal
+                const size_t start = pos_;
+                GeoJsonGeometry shape(resource_);
+                int depth = -1;
+                if (readCoordinates(shape, 0, depth)) {
+                    node.has_coordinates = true;
+                    node.coordinate_depth = depth;
+                    node.shape = std::move(shape);
+                    return true;
+                }
+                if (failed_) return false;
+                pos_ = start;
+            }
+        } else if (key == "geometries") {
+            if (peek() == '[') return readGeometries(node);
+        } else if (key == "features") {
+            if (peek() == '[') return readFeatures(node);
+        } else if (key == "geometry") {
+            const size_t start = pos_;
+            if (peek() == '{') {
+                node.geometry = std::make_unique<Node>(resource_);
+                if (!readObject(*node.geometry)) return false;
+                node.geometry_text = text_.substr(start, pos_ - start);
+                return true;
+            }
+        }
+        return skipValue();
+    }
+
+    bool readGeometries(Node& node) {
+        consume('[');
+        if (++nesting_ > kMaxNesting) return fail();
+        node.has_geometries = true;
+        skipWhitespace();
+        if (!consume(']')) {
+            do {
+                skipWhitespace();
+                if (peek() == '{') {
+                    Node member(resource_);
+                    if (!readObject(member)) return false;
+                    if (auto geometry = toGeometry(member)) {
+                        node.geometries.push_back(std::move(*geometry));
+                        continue;
+                    }
+                } else if (!skipValue()) {
+                    return false;
+                }
+                node.geometries_ok = false;
+            } while (skipWhitespace(), consume(','));
+            if (!consume(']')) return fail();
+        }
+        nesting_--;
+        return true;
+    }
+
+    bool readFeatures(Node& node) {
+        consume('[');
+        if (++nesting_ > kMaxNesting) return fail();
+        node.has_features = true;
+        skipWhitespace();
+        if (!consume(']')) {
+            do {
+                skipWhitespace();
+                if (peek() == '{') {
+                    Node feature(resource_);
+                    if (!readObject(feature)) return false;
+                    node.features.push_back(toFeature(feature));
+                } else {
+                    if (!skipValue()) return false;
+                    node.features.emplace_back();
+                }
+                skipWhitespace();
+            } while (consume(','));
+            if (!consume(']')) return fail();
+        }
+        nesting_--;
+        return true;
+    }
+
+    // Reads one coordinate array at nesting level. depth receives how many
+    // array levels lie between it and its positions (0 for a position,
+    // -1 when only empty arrays were found). Returns false without failing
+    // the parse when the array is well-formed JSON but no coordinate shape.
+    bool readCoordinates(GeoJsonGeometry& shape, size_t level, int& depth) {
+        consume('[');
+        skipWhitespace();
+        const char next = peek();
+
+        if (next == '-' || (next >= '0' && next <= '9')) {
+            double values[3] = {0, 0, 0};
+            int count = 0;
+            do {
+                skipWhitespace();
+                double value;
+                if (!readNumber(value)) return false;
+                if (count < 3) values[count] = value;
+                count++;
+                skipWhitespace();
+            } while (consume(','));
+            if (!consume(']') || count < 2) return false;
+            if (count > 2) shape.dimensions = 3;
+            shape.coordinates.insert(shape.coordinates.end(), values, values + 3);
+            depth = 0;
+            return true;
+        }
+
+        if (level >= shape.counts.size()) return false;
+        const size_t slot = shape.counts[level].size();
+        shape.counts[level].push_back(0);
+        depth = -1;
+        if (consume(']')) return true;
+        if (next != '[') return false;
+
+        uint32_t children = 0;
+        do {
+            skipWhitespace();
+            if (peek() != '[') return false;
+            int child_depth = -1;
+            if (!readCoordinates(shape, level + 1, child_depth)) return false;
+            if (child_depth != -1) {
+                if (depth != -1 && depth != child_depth + 1) return false;
+                depth = child_depth + 1;
+            }
+            children++;
+            skipWhitespace();
+        } while (consume(','));
+        if (!consume(']')) return false;
+        shape.counts[level][slot] = children;
+        return true;
+    }
+
+    bool skipValue() {
+        skipWhitespace();
+        const char c = peek();
+        if (c == '"') {
+            std::string_view ignored;
+            return readString(ignored);
+        }
+        if (c == '{' || c == '[') {
+            const char close = c == '{' ? '}' : ']';
+            pos_++;
+            if (++nesting_ > kMaxNesting) return fail();
+            skipWhitespace();
+            if (!consume(close)) {
+                do {
+                    skipWhitespace();
+                    if (c == '{') {
+                        std::string_view key;
+                        if (!readString(key)) return fail();
+                        skipWhitespace();
+                        if (!consume(':')) return fail();
+                    }
+                    if (!skipValue()) return false;
+                    skipWhitespace();
+                } while (consume(','));
+                if (!consume(close)) return fail();
+            }
+            nesting_--;
+            return true;
+        }
+        if (c == '-' || (c >= '0' && c <= '9')) {
+            double ignored;
+            return readNumber(ignored) || fail();
+        }
+        return readLiteral("true") || readLiteral("false") || readLiteral("null") || fail();
+    }
+
+    // Raw string contents; escapes are checked but not decoded
+    bool readString(std::string_view& value) {
+        if (!consume('"')) return fail();
+        const size_t start = pos_;
+        while (pos_ < text_.size()) {
+            const char c = text_[pos_];
+            if (c == '"') {
+                value = text_.substr(start, pos_ - start);
+                pos_++;
+                return true;
+            }
+            if (static_cast<unsigned char>(c) < 0x20) return fail();
+            if (c == '\\') {
+                if (++pos_ >= text_.size()) return fail();
+                if (text_[pos_] == 'u') pos_ += 4;
+            }
+            pos_++;
+        }
+        return fail();
+    }
+
+    bool readNumber(double& value) {
+        const size_t start = pos_;
+        if (pos_ < text_.size() && text_[pos_] == '-') pos_++;
+        while (pos_ < text_.size()) {
+            const char c = text_[pos_];
+            if ((c >= '0' && c <= '9') || c == '.' || c == 'e' || c == 'E' || c == '+' || c == '-') {
+                pos_++;
+            } else {
+                break;
+            }
+        }
+        const char* first = text_.data() + start;
+        const char* last = text_.data() + pos_;
+        auto [end, ec] = std::from_chars(first, last, value);
+        return ec == std::errc() && end == last && pos_ > start;
+    }
+
+    bool readLiteral(std::string_view literal) {
+        if (text_.substr(pos_, literal.size()) != literal) return false;
+        pos_ += literal.size();
+        return true;
+    }
+
+    void skipWhitespace() {
+        while (pos_ < text_.size()) {
+            const char c = text_[pos_];
+            if (c != ' ' && c != '\t' && c != '\n' && c != '\r') break;
+            pos_++;
+        }
+    }
+
+    char peek() const { return pos_ < text_.size() ? text_[pos_] : '\0'; }
+
+    bool consume(char c) {
+        if (peek() != c) return false;
+        pos_++;
+        return true;
+    }
+
+    bool fail() {
+        failed_ = true;
+        return false;
+    }
+
+    std::string_view text_;
+    std::pmr::memory_resource* resource_;
+    size_t pos_ = 0;
+    int nesting_ = 0;
+    bool failed_ = false;
+};
+
+// Walks the flattened positions and counts in document order
+struct Cursor {
+    const GeoJsonGeometry& geometry;
+    size_t position = 0;
+    std::array<size_t, 3> index = {0, 0, 0};
+
+    uint32_t next(size_t level) { return geometry.counts[level][index[level]++]; }
+
+    OGRPoint* point() {
+        const double* p = &geometry.coordinates[3 * position++];
+        return geometry.dimensions == 3 ? new OGRPoint(p[0], p[1], p[2]) : new OGRPoint(p[0], p[1]);
+    }
+
+    void curve(size_t level, OGRSimpleCurve& curve) {
+        const uint32_t count = next(level);
+        curve.setNumPoints(static_cast<int>(count), FALSE);
+        for (uint32_t i = 0; i < count; i++) {
+            const double* p = &geometry.coordinates[3 * position++];
+            if (geometry.dimensions == 3) {
+                curve.setPoint(static_cast<int>(i), p[0], p[1], p[2]);
+            } else {
+                curve.setPoint(static_cast<int>(i), p[0], p[1]);
+            }
+        }
+    }
+
+    OGRPolygon* polygon(size_t level) {
+        auto* polygon = new OGRPolygon();
+        const uint32_t rings = next(level);
+        for (uint32_t i = 0; i < rings; i++) {
+            auto* ring = new OGRLinearRing();
+            curve(level + 1, *ring);
+            polygon->addRingDirectly(ring);
+        }
+        return polygon;
+    }
+};
+
+} // namespace
+
+std::unique_ptr<OGRGeometry> GeoJsonGeometry::toOGR() const {
+    Cursor cursor{*this};
+    switch (type) {
+        case Type::Point:
+            return std::unique_ptr<OGRGeometry>(cursor.point());
+        case Type::LineString: {
+            auto line = std::make_unique<OGRLineString>();
+            cursor.curve(0, *line);
+            return line;
+        }
+        case Type::Polygon:
+            return std::unique_ptr<OGRGeometry>(cursor.polygon(0));
+        case Type::MultiPoint: {
+            auto multi = std::make_unique<OGRMultiPoint>();
+            for (uint32_t i = cursor.next(0); i > 0; i--) {
+                multi->addGeometryDirectly(cursor.point());
+            }
+            return multi;
+        }
+        case Type::MultiLineString: {
+            auto multi = std::make_unique<OGRMultiLineString>();
+            for (uint32_t i = cursor.next(0); i > 0; i--) {
+                auto* line = new OGRLineString();
+                cursor.curve(1, *line);
+                multi->addGeometryDirectly(line);
+            }
+            return multi;
+        }
+        case Type::MultiPolygon: {
+            auto multi = std::make_unique<OGRMultiPolygon>();
+            for (uint32_t i = cursor.next(0); i > 0; i--) {
+                multi->addGeometryDirectly(cursor.polygon(1));
+            }
+            return multi;
+        }
+        case Type::GeometryCollection: {
+            auto collection = std::make_unique<OGRGeometryCollection>();
+            for (const auto& member : geometries) {
+                auto part = member.toOGR();
+                if (!part || collection->addGeometryDirectly(part.get()) != OGRERR_NONE) {
+                    return nullptr;
+                }
+                part.release();
+            }
+            return collection;
+        }
+    }
+    return nullptr;
+}
+
+bool GeoJsonReader::read(std::string_view text, std::vector<GeoJsonFeature>& features, std::string& error,
+                         std::string* type, std::pmr::memory_resource* resource) {
+    Parser parser(text, resource);
+    Node root(resource);
+    if (!parser.readObject(root) || !parser.atEnd()) {
+        error = parser.failed() ? "Malformed JSON at offset " + std::to_string(parser.offset())
+                                : "Expected a GeoJSON object";
+        return false;
+    }
+
+    // A submission payload wraps the collection in its geometry member
+    Node* node = &root;
+    if (root.type.empty() && root.geometry && root.geometry->type == "FeatureCollection") {
+        node = root.geometry.get();
+    }
+    if (type) *type = std::string(node->type);
+
+    if (node->type == "FeatureCollection") {
+        if (!node->has_features) {
+            error = "FeatureCollection has no features array";
+            return false;
+        }
+        features = std::move(node->features);
+        return true;
+    }
+    if (node->type == "Feature") {
+        features.push_back(toFeature(*node));
+        return true;
+    }
+    if (geometryType(node->type)) {
+        GeoJsonFeature feature;
+        feature.geometry = toGeometry(*node);
+        feature.geometry_text = text;
+        features.push_back(std::move(feature));
+        return true;
+    }
+    error = "Expected a GeoJSON FeatureCollection, Feature or geometry";
+    return false;
+}
+
+std::unique_ptr<OGRGeometry> GeoJsonReader::readGeometry(std::string_view text) {
+    std::vector<GeoJsonFeature> features;
+    std::string error;
+    std::string type;
+    if (!read(text, features, error, &type) || type == "FeatureCollection" || features.size() != 1 ||
+        !features[0].geometry) {
+        return nullptr;
+    }
+    return features[0].geometry->toOGR();
+}
+
+} // namespace aeronautical
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "ogr_geometry.h"
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace aeronautical {
+
+// Geometry read straight from GeoJSON coordinate tokens. Positions are kept
+// flat as x, y, z triples (z is 0 when absent); counts[l] holds, in document
+// order, the number of children of every coordinate array at nesting level
+// l above the positions (level 0 is the "coordinates" array itself).
+// The arrays live in the memory resource given at construction (the global
+// heap by default, an AnalysisArena during an analysis).
+struct GeoJsonGeometry {
+    enum class Type { Point, LineString, Polygon, MultiPoint, MultiLineString, MultiPolygon, GeometryCollection };
+
+    GeoJsonGeometry() : GeoJsonGeometry(std::pmr::get_default_resource()) {}
+    explicit GeoJsonGeometry(std::pmr::memory_resource* resource)
+        : coordinates(resource), counts{std::pmr::vector<uint32_t>(resource), std::pmr::vector<uint32_t>(resource),
+                                        std::pmr::vector<uint32_t>(resource)},
+          geometries(resource) {}
+
+    Type type = Type::Point;
+    int dimensions = 2;
+    std::pmr::vector<double> coordinates;
+    std::array<std::pmr::vector<uint32_t>, 3> counts;
+    std::pmr::vector<GeoJsonGeometry> geometries; // GeometryCollection members
+
+    size_t positionCount() const { return coordinates.size() / 3; }
+
+    // Builds the OGR geometry; nullptr only if OGR refuses a part
+    std::unique_ptr<OGRGeometry> toOGR() const;
+};
+
+struct GeoJsonFeature {
+    // Unset when the member is null or not a usable geometry
+    std::optional<GeoJsonGeometry> geometry;
+    // Source text of the geometry member, e.g. for hashing; points into the input
+    std::string_view geometry_text;
+};
+
+// Single-pass GeoJSON reader: walks the text once and collects coordinates
+// without building a JSON DOM, so no geometry is dumped back to text and
+// parsed a second time by OGR. Properties and unknown members are skipped.
+class GeoJsonReader {
+public:
+    // Reads a FeatureCollection, a Feature or a bare geometry. A submission
+    // payload ({"geometry": FeatureCollection}) reads as its collection.
+    // Every feature keeps its position. Returns false, with error set, only
+    // for malformed JSON or a top-level value that is none of these.
+    // type, when given, receives the top-level "type". Coordinates are kept
+    // in resource, which must outlive features.
+    static bool read(std::string_view text, std::vector<GeoJsonFeature>& features, std::string& error,
+                     std::string* type = nullptr,
+                     std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    // The geometry of a Feature or bare geometry text; nullptr otherwise
+    static std::unique_ptr<OGRGeometry> readGeometry(std::string_view text);
+};
+
+} // namespace aeronautical
@@ -0,0 +1,101 @@
+#include "GeometryBlob.h"
+#include "SchemaMigrations.h"
+#include <spdlog/spdlog.h>
+#include <zlib.h>
+#include <cstdint>
+
+namespace aeronautical {
+
+std::atomic<size_t> GeometryBlob::min_bytes_{4096};
+
+namespace {
+
+uint32_t storedLength(const char* data) {
+    const auto* bytes = reinterpret_cast<const unsigned char*>(data) + GeometryBlob::kMagic.size();
+    return static_cast<uint32_t>(bytes[0]) | static_cast<uint32_t>(bytes[1]) << 8 |
+           static_cast<uint32_t>(bytes[2]) << 16 | static_cast<uint32_t>(bytes[3]) << 24;
+}
+
+// Inflates a packed value into out, which must hold storedLength bytes
+bool inflateInto(const char* data, size_t size, char* out, size_t length) {
+    uLongf written = static_cast<uLongf>(length);
+    const int code = uncompress(reinterpret_cast<Bytef*>(out), &written,
+                                reinterpret_cast<const Bytef*>(data + GeometryBlob::kHeaderSize),
+                                static_cast<uLong>(size - GeometryBlob::kHeaderSize));
+    if (code != Z_OK || written != length) {
+        spdlog::error("Stored geometry of {} bytes could not be inflated (zlib {})", size, code);
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+std::string GeometryBlob::pack(std::string_view geojson) {
+    const size_t min_bytes = minBytes();
+    if (min_bytes == 0 || geojson.size() < min_bytes || geojson.size() > UINT32_MAX) {
+        return std::string(geojson);
+    }
+    uLongf bound = compressBound(static_cast<uLong>(geojson.size()));
+    std::string packed(kHeaderSize + bound, '\0');
+    packed.replace(0, kMagic.size(), kMagic);
+    const auto length = static_cast<uint32_t>(geojson.size());
+    for (int i = 0; i < 4; i++) {
+        packed[kMagic.size() + i] = static_cast<char>((length >> (8 * i)) & 0xff);
+    }
+    if (compress2(reinterpret_cast<Bytef*>(packed.data() + kHeaderSize), &bound,
+                  reinterpret_cast<const Bytef*>(geojson.data()), static_cast<uLong>(geojson.size()),
+                  Z_DEFAULT_COMPRESSION) != Z_OK ||
+        kHeaderSize + bound >= geojson.size()) {
+        return std::string(geojson);
+    }
+    packed.resize(kHeaderSize + bound);
+    return packed;
+}
+
+std::optional<std::string> GeometryBlob::packedLiteral(std::string_view geojson, const char* table, const char* column) {
+    if (minBytes() == 0 || geojson.size() < minBytes() ||
+        SchemaMigrations::columnType(table, column).find("blob") == std::string::npos) {
+        return std::nullopt;
+    }
+    const std::string packed = pack(geojson);
+    if (!isPacked(packed.data(), packed.size())) {
+        return std::nullopt;
+    }
+    static constexpr char kHex[] = "0123456789ABCDEF";
+    std::string literal;
+    literal.reserve(packed.size() * 2 + 3);
+    literal += "X'";
+    for (unsigned char byte : packed) {
+        literal += kHex[byte >> 4];
+        literal += kHex[byte & 0x0f];
+    }
+    literal += "'";
+    return literal;
+}
+
+std::string_view GeometryBlob::view(const char* data, size_t size) {
+    if (!isPacked(data, size)) {
+        return std::string_view(data, size);
+    }
+    thread_local std::string buffer;
+    const size_t length = storedLength(data);
+    buffer.resize(length);
+    if (!inflateInto(data, size, buffer.data(), length)) {
+        return {};
+    }
+    return buffer;
+}
+
+std::string GeometryBlob::text(const char* data, size_t size) {
+    if (!isPacked(data, size)) {
+        return std::string(data, size);
+    }
+    std::string out(storedLength(data), '\0');
+    if (!inflateInto(data, size, out.data(), out.size())) {
+        return {};
+    }
+    return out;
+}
+
+} // namespace aeronautical
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace aeronautical {
+
+// GeoJSON kept compressed at rest in project_geometries.geometry_data and
+// flight_procedures.protection_geometry, so reads move a fraction of the
+// bytes from the server's buffer pool over the wire. A stored value is
+// either plain GeoJSON text or
+//
+//   "\0AZ1" | uint32 little-endian length of the text | zlib stream
+//
+// GeoJSON never starts with a NUL byte, so both forms read back through the
+// same path and rows written before compression stay readable as they are.
+// Values are compressed only when the column is binary (LONGBLOB, see
+// schema migration 4), the text is at least minBytes long and compression
+// saves something.
+class GeometryBlob {
+public:
+    static constexpr std::string_view kMagic{"\0AZ1", 4};
+    static constexpr size_t kHeaderSize = 8;
+
+    // 0 turns compression off for new writes; stored values still read
+    static void setMinBytes(size_t min_bytes) { min_bytes_.store(min_bytes, std::memory_order_relaxed); }
+    static size_t minBytes() { return min_bytes_.load(std::memory_order_relaxed); }
+
+    static bool isPacked(const char* data, size_t size) {
+        return size >= kHeaderSize && std::string_view(data, kMagic.size()) == kMagic;
+    }
+
+    // Stored form of geojson; plain text when compression does not apply
+    static std::string pack(std::string_view geojson);
+    // SQL literal (X'...') of the compressed value for writing into
+    // table.column, or nullopt when it should be written as plain text
+    static std::optional<std::string> packedLiteral(std::string_view geojson, const char* table, const char* column);
+
+    // GeoJSON text of a stored value. A compressed one is inflated into a
+    // buffer owned by the calling thread and reused by its next call, so the
+    // view lasts until then; plain text is returned in place.
+    static std::string_view view(const char* data, size_t size);
+    // The same as a string of its own, sized from the header in one allocation
+    static std::string text(const char* data, size_t size);
+
+private:
+    static std::atomic<size_t> min_bytes_;
+};
+
+} // namespace aeronautical
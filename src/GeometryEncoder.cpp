@@ -0,0 +1,179 @@
+#include "GeometryEncoder.h"
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+namespace aeronautical {
+
+namespace {
+
+bool isPosition(const nlohmann::json& j) {
+    if (!j.is_array() || j.size() < 2) return false;
+    for (const auto& v : j) {
+        if (!v.is_number()) return false;
+    }
+    return true;
+}
+
+// Flattens a list of positions; false when they do not share one dimension
+bool flattenPositions(const nlohmann::json& list, std::vector<double>& values, size_t& dimensions) {
+    dimensions = list.front().size();
+    values.clear();
+    values.reserve(list.size() * dimensions);
+    for (const auto& position : list) {
+        if (!isPosition(position) || position.size() != dimensions) return false;
+        for (const auto& v : position) values.push_back(v.get<double>());
+    }
+    return true;
+}
+
+// Replaces every position list under coordinates with its polyline string
+bool encodeCoordinates(nlohmann::json& coordinates, int precision, size_t& dimensions) {
+    if (!coordinates.is_array() || coordinates.empty()) return false;
+    std::vector<double> values;
+    size_t dims = 0;
+    if (isPosition(coordinates)) {
+        // Point: a single position
+        dims = coordinates.size();
+        for (const auto& v : coordinates) values.push_back(v.get<double>());
+    } else if (isPosition(coordinates.front())) {
+        if (!flattenPositions(coordinates, values, dims)) return false;
+    } else {
+        for (auto& child : coordinates) {
+            if (!encodeCoordinates(child, precision, dimensions)) return false;
+        }
+        return true;
+    }
+    if (dimensions != 0 && dims != dimensions) return false;
+    dimensions = dims;
+    std::string encoded;
+    GeometryEncoder::appendPolyline(encoded, values.data(), values.size(), dims, precision);
+    coordinates = std::move(encoded);
+    return true;
+}
+
+bool isCoordinateGeometry(const std::string& type) {
+    return type == "Point" || type == "MultiPoint" || type == "LineString" || type == "MultiLineString" ||
+           type == "Polygon" || type == "MultiPolygon";
+}
+
+void encodeNode(nlohmann::json& node, int precision) {
+    if (node.is_array()) {
+        for (auto& child : node) encodeNode(child, precision);
+        return;
+    }
+    if (!node.is_object()) return;
+
+    auto type = node.find("type");
+    auto coordinates = node.find("coordinates");
+    if (type != node.end() && type->is_string() && isCoordinateGeometry(type->get<std::string>()) &&
+        coordinates != node.end()) {
+        nlohmann::json encoded = *coordinates;
+        size_t dimensions = 0;
+        // A malformed geometry is passed through as it was stored
+        if (encodeCoordinates(encoded, precision, dimensions)) {
+            *coordinates = std::move(encoded);
+            node["encoding"] = "polyline";
+            node["precision"] = precision;
+            node["dimensions"] = dimensions;
+        }
+        return;
+    }
+    for (const char* member : {"features", "geometry", "geometries"}) {
+        auto child = node.find(member);
+        if (child != node.end()) encodeNode(*child, precision);
+    }
+}
+
+} // namespace
+
+GeometryEncoder& GeometryEncoder::getInstance() {
+    static GeometryEncoder instance;
+    return instance;
+}
+
+GeometryEncoder::GeometryEncoder() {
+    cache_.setCapacity(32u << 20);
+}
+
+void GeometryEncoder::setCacheCapacity(size_t bytes) {
+    cache_.setCapacity(bytes);
+}
+
+bool GeometryEncoder::fromRequest(const crow::request& req, std::optional<int>& precision, std::string& error) {
+    precision.reset();
+    const char* encoding = req.url_params.get("geometry_encoding");
+    if (!encoding || std::string_view(encoding) == "geojson") {
+        return true;
+    }
+    if (std::string_view(encoding) != "polyline") {
+        error = "Unsupported geometry_encoding (expected polyline or geojson)";
+        return false;
+    }
+    int value = kDefaultPrecision;
+    if (const char* text = req.url_params.get("precision")) {
+        try {
+            size_t used = 0;
+            value = std::stoi(text, &used);
+            if (text[used] != '\0') throw std::invalid_argument(text);
+        } catch (const std::exception&) {
+            error = "Invalid precision";
+            return false;
+        }
+        if (value < 0 || value > kMaxPrecision) {
+            error = "precision must be between 0 and 9";
+            return false;
+        }
+    }
+    precision = value;
+    return true;
+}
+
+std::string GeometryEncoder::encode(const std::string& key, const std::string& geojson, int precision) {
+    std::string cache_key;
+    if (!key.empty()) {
+        cache_key = std::to_string(precision) + " " + key;
+        if (auto hit = cache_.get(cache_key)) {
+            return *hit;
+        }
+    }
+    std::string encoded = encodeGeoJson(geojson, precision);
+    if (encoded.empty()) {
+        return geojson;
+    }
+    if (!cache_key.empty()) {
+        cache_.put(cache_key, std::make_shared<const std::string>(encoded));
+    }
+    return encoded;
+}
+
+std::string GeometryEncoder::encodeGeoJson(std::string_view geojson, int precision) {
+    nlohmann::json document = nlohmann::json::parse(geojson, nullptr, false);
+    if (document.is_discarded()) {
+        return {};
+    }
+    encodeNode(document, precision);
+    return document.dump();
+}
+
+void GeometryEncoder::appendPolyline(std::string& out, const double* values, size_t count, size_t dimensions,
+                                     int precision) {
+    const double scale = std::pow(10.0, precision);
+    std::vector<int64_t> last(dimensions, 0);
+    for (size_t i = 0; i < count; i++) {
+        size_t dim = i % dimensions;
+        int64_t quantized = std::llround(values[i] * scale);
+        int64_t delta = quantized - last[dim];
+        last[dim] = quantized;
+        // Zig-zag, then 5-bit groups low first, each offset into printable ASCII
+        uint64_t bits = (static_cast<uint64_t>(delta) << 1) ^ static_cast<uint64_t>(delta >> 63);
+        while (bits >= 0x20) {
+            out.push_back(static_cast<char>((0x20 | (bits & 0x1f)) + 63));
+            bits >>= 5;
+        }
+        out.push_back(static_cast<char>(bits + 63));
+    }
+}
+
+} // namespace aeronautical
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "BodyCache.h"
+#include <crow.h>
+#include <json.hpp>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace aeronautical {
+
+// Compact coordinate encoding for GeoJSON responses. Each position list is
+// quantized to 10^-precision degrees and written as one polyline string:
+// the zig-zag varint deltas of Google's encoded polyline, applied to every
+// value of a position in GeoJSON order (lng, lat[, alt]). Geometries that
+// were encoded carry "encoding": "polyline", "precision" and "dimensions";
+// the nesting of coordinates is kept down to the position lists.
+//
+// Requested with ?geometry_encoding=polyline[&precision=0..9]. Results are
+// cached by a caller-supplied key that names the geometry revision.
+class GeometryEncoder {
+public:
+    static constexpr int kDefaultPrecision = 6;  // ~0.1 m
+    static constexpr int kMaxPrecision = 9;
+
+    static GeometryEncoder& getInstance();
+
+    GeometryEncoder(const GeometryEncoder&) = delete;
+    GeometryEncoder& operator=(const GeometryEncoder&) = delete;
+
+    void setCacheCapacity(size_t bytes);
+    BodyCache& cache() { return cache_; }
+
+    // precision is left empty when no encoding was asked for; false with
+    // error set for an unknown encoding or a precision out of range
+    static bool fromRequest(const crow::request& req, std::optional<int>& precision, std::string& error);
+
+    // Encoded GeoJSON text; the input unchanged when it does not parse.
+    // An empty key skips the cache.
+    std::string encode(const std::string& key, const std::string& geojson, int precision);
+
+    static std::string encodeGeoJson(std::string_view geojson, int precision);
+    static void appendPolyline(std::string& out, const double* values, size_t count, size_t dimensions,
+                               int precision);
+
+private:
+    GeometryEncoder();
+
+    BodyCache cache_;
+};
+
+} // namespace aeronautical
@@ -0,0 +1,168 @@
+#include "GeometryJson.h"
+#include "OgrHandles.h"
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cmath>
+
+namespace aeronautical {
+
+namespace {
+
+std::atomic<int> g_precision{GeometryJson::kDefaultPrecision};
+
+// Above this a thread gives its buffer back after a write instead of keeping it
+constexpr size_t kMaxKeptBuffer = size_t(4) << 20;
+
+void appendNumber(std::string& out, double value, int decimals) {
+    if (!std::isfinite(value)) {
+        out += "null";
+        return;
+    }
+    char text[64];
+    auto [end, ec] = std::to_chars(text, text + sizeof(text), value, std::chars_format::fixed, decimals);
+    if (ec != std::errc()) {
+        end = std::to_chars(text, text + sizeof(text), value).ptr;
+    } else if (decimals > 0) {
+        while (end[-1] == '0') end--;
+        if (end[-1] == '.') end--;
+    }
+    // Rounding can leave "-0"
+    if (end - text == 2 && text[0] == '-' && text[1] == '0') {
+        out += '0';
+        return;
+    }
+    out.append(text, end);
+}
+
+void appendPosition(std::string& out, double x, double y, const double* z, int decimals) {
+    out += '[';
+    appendNumber(out, x, decimals);
+    out += ',';
+    appendNumber(out, y, decimals);
+    if (z) {
+        out += ',';
+        appendNumber(out, *z, decimals);
+    }
+    out += ']';
+}
+
+void appendCurve(std::string& out, const OGRSimpleCurve& curve, int decimals) {
+    const bool z = curve.Is3D();
+    out += '[';
+    for (int i = 0; i < curve.getNumPoints(); i++) {
+        if (i > 0) out += ',';
+        const double zi = z ? curve.getZ(i) : 0.0;
+        appendPosition(out, curve.getX(i), curve.getY(i), z ? &zi : nullptr, decimals);
+    }
+    out += ']';
+}
+
+void appendPolygon(std::string& out, const OGRPolygon& polygon, int decimals) {
+    out += '[';
+    if (const OGRLinearRing* exterior = polygon.getExteriorRing()) {
+        appendCurve(out, *exterior, decimals);
+        for (int i = 0; i < polygon.getNumInteriorRings(); i++) {
+            out += ',';
+            appendCurve(out, *polygon.getInteriorRing(i), decimals);
+        }
+    }
+    out += ']';
+}
+
+void appendPoint(std::string& out, const OGRPoint& point, int decimals) {
+    if (point.IsEmpty()) {
+        out += "[]";
+        return;
+    }
+    const double z = point.getZ();
+    appendPosition(out, point.getX(), point.getY(), point.Is3D() ? &z : nullptr, decimals);
+}
+
+} // namespace
+
+void GeometryJson::setPrecision(int decimals) {
+    g_precision.store(std::clamp(decimals, 0, kMaxPrecision), std::memory_order_relaxed);
+}
+
+int GeometryJson::precision() {
+    return g_precision.load(std::memory_order_relaxed);
+}
+
+bool GeometryJson::append(std::string& out, const OGRGeometry& geometry, int decimals) {
+    const size_t start = out.size();
+    auto coordinates = [&](const char* type) {
+        out += R"({"type":")";
+        out += type;
+        out += R"(","coordinates":)";
+    };
+    auto members = [&](const OGRGeometryCollection& collection, auto&& each) {
+        out += '[';
+        for (int i = 0; i < collection.getNumGeometries(); i++) {
+            if (i > 0) out += ',';
+            each(*collection.getGeometryRef(i));
+        }
+        out += "]}";
+    };
+
+    switch (wkbFlatten(geometry.getGeometryType())) {
+        case wkbPoint:
+            coordinates("Point");
+            appendPoint(out, *geometry.toPoint(), decimals);
+            out += '}';
+            return true;
+        case wkbLineString:
+            coordinates("LineString");
+            appendCurve(out, *geometry.toLineString(), decimals);
+            out += '}';
+            return true;
+        case wkbPolygon:
+            coordinates("Polygon");
+            appendPolygon(out, *geometry.toPolygon(), decimals);
+            out += '}';
+            return true;
+        case wkbMultiPoint:
+            coordinates("MultiPoint");
+            members(*geometry.toGeometryCollection(),
+                    [&](const OGRGeometry& member) { appendPoint(out, *member.toPoint(), decimals); });
+            return true;
+        case wkbMultiLineString:
+            coordinates("MultiLineString");
+            members(*geometry.toGeometryCollection(),
+                    [&](const OGRGeometry& member) { appendCurve(out, *member.toLineString(), decimals); });
+            return true;
+        case wkbMultiPolygon:
+            coordinates("MultiPolygon");
+            members(*geometry.toGeometryCollection(),
+                    [&](const OGRGeometry& member) { appendPolygon(out, *member.toPolygon(), decimals); });
+            return true;
+        case wkbGeometryCollection: {
+            out += R"({"type":"GeometryCollection","geometries":)";
+            bool ok = true;
+            members(*geometry.toGeometryCollection(),
+                    [&](const OGRGeometry& member) { ok = ok && append(out, member, decimals); });
+            if (ok) return true;
+            break;
+        }
+        default:
+            break;
+    }
+    out.resize(start);
+    return false;
+}
+
+std::string GeometryJson::write(OGRGeometryH geometry) {
+    if (!geometry) return std::string();
+    thread_local std::string buffer;
+    buffer.clear();
+    if (!append(buffer, *reinterpret_cast<const OGRGeometry*>(geometry), precision())) {
+        return exportJson(geometry);
+    }
+    std::string json(buffer);
+    if (buffer.capacity() > kMaxKeptBuffer) {
+        std::string().swap(buffer);
+    }
+    return json;
+}
+
+} // namespace aeronautical
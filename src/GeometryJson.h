@@ -0,0 +1,31 @@
+#pragma once
+
+#include "ogr_api.h"
+#include "ogr_geometry.h"
+#include <string>
+
+namespace aeronautical {
+
+// GeoJSON text of OGR geometries, written straight from their points.
+// Coordinates are rounded to a fixed number of decimals with trailing
+// zeros dropped, where OGR_G_ExportToJson prints 15 significant digits, and
+// the text is built in a buffer each thread keeps, where OGR allocates a C
+// string per call and the caller copies it. Curved types go through OGR.
+class GeometryJson {
+public:
+    static constexpr int kDefaultPrecision = 7; // ~1 cm
+    static constexpr int kMaxPrecision = 15;
+
+    // Decimals written from now on, clamped to 0..kMaxPrecision
+    static void setPrecision(int decimals);
+    static int precision();
+
+    // Appends the geometry to out; false, with out unchanged, for a type
+    // written through OGR instead
+    static bool append(std::string& out, const OGRGeometry& geometry, int decimals);
+
+    // GeoJSON of the geometry at precision(); empty when it cannot be exported
+    static std::string write(OGRGeometryH geometry);
+};
+
+} // namespace aeronautical
@@ -0,0 +1,183 @@
+#include "GeosBackend.h"
+#include <spdlog/spdlog.h>
+#include <cstdarg>
+#include <cstdio>
+#include <stdexcept>
+#include <vector>
+
+#ifdef HAVE_GEOS
+#include <geos_c.h>
+#endif
+
+namespace aeronautical {
+
+#ifdef HAVE_GEOS
+std::atomic<bool> GeosBackend::enabled_{true};
+#else
+std::atomic<bool> GeosBackend::enabled_{false};
+#endif
+
+bool GeosBackend::available() {
+#ifdef HAVE_GEOS
+    return enabled_.load(std::memory_order_relaxed);
+#else
+    return false;
+#endif
+}
+
+void GeosBackend::setEnabled(bool enabled) {
+#ifdef HAVE_GEOS
+    enabled_.store(enabled, std::memory_order_relaxed);
+#else
+    if (enabled) {
+        spdlog::warn("Built without GEOS, geometry predicates go through OGR");
+    }
+#endif
+}
+
+#ifdef HAVE_GEOS
+
+namespace {
+
+void logGeosMessage(const char* format, va_list args, bool error) {
+    char message[512];
+    std::vsnprintf(message, sizeof(message), format, args);
+    if (error) {
+        spdlog::warn("GEOS: {}", message);
+    } else {
+        spdlog::debug("GEOS: {}", message);
+    }
+}
+
+void onGeosError(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    logGeosMessage(format, args, true);
+    va_end(args);
+}
+
+void onGeosNotice(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    logGeosMessage(format, args, false);
+    va_end(args);
+}
+
+struct ThreadContext {
+    GEOSContextHandle_t handle;
+
+    ThreadContext() : handle(GEOS_init_r()) {
+        GEOSContext_setErrorHandler_r(handle, onGeosError);
+        GEOSContext_setNoticeHandler_r(handle, onGeosNotice);
+    }
+    ~ThreadContext() { GEOS_finish_r(handle); }
+};
+
+// 0 false, 1 true, 2 exception
+bool predicate(char result, const char* name) {
+    if (result == 2) {
+        throw std::runtime_error(std::string("GEOS ") + name + " failed");
+    }
+    return result == 1;
+}
+
+} // namespace
+
+GEOSContextHandle_HS* GeosBackend::context() {
+    thread_local ThreadContext context;
+    return context.handle;
+}
+
+// Any thread's context may free a geometry; it only reports errors
+void GeosBackend::GeometryDeleter::operator()(GEOSGeom_t* geometry) const {
+    GEOSGeom_destroy_r(context(), geometry);
+}
+
+void GeosBackend::PreparedDeleter::operator()(const GEOSPrepGeom_t* prepared) const {
+    GEOSPreparedGeom_destroy_r(context(), prepared);
+}
+
+GeosBackend::Geometry GeosBackend::fromOgr(const OGRGeometry& geometry) {
+    if (!available()) {
+        return nullptr;
+    }
+    std::vector<unsigned char> wkb(geometry.WkbSize());
+    if (geometry.exportToWkb(wkbNDR, wkb.data(), wkbVariantIso) != OGRERR_NONE) {
+        return nullptr;
+    }
+    GEOSContextHandle_t handle = context();
+    GEOSWKBReader* reader = GEOSWKBReader_create_r(handle);
+    GEOSGeometry* converted = GEOSWKBReader_read_r(handle, reader, wkb.data(), wkb.size());
+    GEOSWKBReader_destroy_r(handle, reader);
+    return Geometry(converted);
+}
+
+GeometryHandle GeosBackend::toOgr(const GEOSGeom_t* geometry) {
+    if (!geometry) {
+        return nullptr;
+    }
+    GEOSContextHandle_t handle = context();
+    GEOSWKBWriter* writer = GEOSWKBWriter_create_r(handle);
+    GEOSWKBWriter_setByteOrder_r(handle, writer, GEOS_WKB_NDR);
+    size_t size = 0;
+    unsigned char* wkb = GEOSWKBWriter_write_r(handle, writer, geometry, &size);
+    GEOSWKBWriter_destroy_r(handle, writer);
+    if (!wkb) {
+        return nullptr;
+    }
+    OGRGeometry* converted = nullptr;
+    OGRGeometryFactory::createFromWkb(wkb, nullptr, &converted, size, wkbVariantIso);
+    GEOSFree_r(handle, wkb);
+    return GeometryHandle((OGRGeometryH)converted);
+}
+
+GeosBackend::Prepared GeosBackend::prepare(const GEOSGeom_t* geometry) {
+    return Prepared(geometry ? GEOSPrepare_r(context(), geometry) : nullptr);
+}
+
+bool GeosBackend::intersects(const GEOSGeom_t* a, const GEOSGeom_t* b) {
+    return predicate(GEOSIntersects_r(context(), a, b), "intersects");
+}
+
+bool GeosBackend::contains(const GEOSGeom_t* a, const GEOSGeom_t* b) {
+    return predicate(GEOSContains_r(context(), a, b), "contains");
+}
+
+bool GeosBackend::preparedIntersects(const GEOSPrepGeom_t* a, const GEOSGeom_t* b) {
+    return predicate(GEOSPreparedIntersects_r(context(), a, b), "prepared intersects");
+}
+
+bool GeosBackend::preparedContains(const GEOSPrepGeom_t* a, const GEOSGeom_t* b) {
+    return predicate(GEOSPreparedContains_r(context(), a, b), "prepared contains");
+}
+
+GeosBackend::Geometry GeosBackend::intersection(const GEOSGeom_t* a, const GEOSGeom_t* b) {
+    return Geometry(GEOSIntersection_r(context(), a, b));
+}
+
+#else
+
+GEOSContextHandle_HS* GeosBackend::context() { return nullptr; }
+void GeosBackend::GeometryDeleter::operator()(GEOSGeom_t*) const {}
+void GeosBackend::PreparedDeleter::operator()(const GEOSPrepGeom_t*) const {}
+GeosBackend::Geometry GeosBackend::fromOgr(const OGRGeometry&) { return nullptr; }
+GeometryHandle GeosBackend::toOgr(const GEOSGeom_t*) { return nullptr; }
+GeosBackend::Prepared GeosBackend::prepare(const GEOSGeom_t*) { return nullptr; }
+
+bool GeosBackend::intersects(const GEOSGeom_t*, const GEOSGeom_t*) {
+    throw std::runtime_error("Built without GEOS");
+}
+bool GeosBackend::contains(const GEOSGeom_t*, const GEOSGeom_t*) {
+    throw std::runtime_error("Built without GEOS");
+}
+bool GeosBackend::preparedIntersects(const GEOSPrepGeom_t*, const GEOSGeom_t*) {
+    throw std::runtime_error("Built without GEOS");
+}
+bool GeosBackend::preparedContains(const GEOSPrepGeom_t*, const GEOSGeom_t*) {
+    throw std::runtime_error("Built without GEOS");
+}
+GeosBackend::Geometry GeosBackend::intersection(const GEOSGeom_t*, const GEOSGeom_t*) { return nullptr; }
+
+#endif
+
+} // namespace aeronautical
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "OgrHandles.h"
+#include "ogr_geometry.h"
+#include <atomic>
+#include <memory>
+
+// Opaque GEOS types, as geos_c.h declares them
+struct GEOSGeom_t;
+struct GEOSPrepGeom_t;
+struct GEOSContextHandle_HS;
+
+namespace aeronautical {
+
+// Direct use of the reentrant GEOS C API (GEOS*_r) for the conflict engine.
+// Going through OGR, every Intersects, Contains or Intersection converts
+// both operands to GEOS in a context created for that call and the result
+// back again. Here each thread keeps one context for its lifetime, zones are
+// converted once when they are cached and project features once per
+// analysis, so a predicate is a single GEOS call.
+//
+// Built when CMake finds geos_c (HAVE_GEOS); without it available() is
+// false and callers keep the OGR path. A GEOS geometry is only read after
+// it is built, so zones are shared between threads like their OGR form;
+// prepared geometries are not safe for concurrent calls and are locked by
+// their owner.
+class GeosBackend {
+public:
+    struct GeometryDeleter {
+        void operator()(GEOSGeom_t* geometry) const;
+    };
+    using Geometry = std::unique_ptr<GEOSGeom_t, GeometryDeleter>;
+
+    struct PreparedDeleter {
+        void operator()(const GEOSPrepGeom_t* prepared) const;
+    };
+    using Prepared = std::unique_ptr<const GEOSPrepGeom_t, PreparedDeleter>;
+
+    // Compiled in and switched on; set before the first analysis
+    static bool available();
+    static void setEnabled(bool enabled);
+
+    // The calling thread's context, created on first use and finished when
+    // the thread exits. GEOS errors go to the log.
+    static GEOSContextHandle_HS* context();
+
+    // Through WKB; nullptr when unavailable or the geometry cannot be read
+    static Geometry fromOgr(const OGRGeometry& geometry);
+    static GeometryHandle toOgr(const GEOSGeom_t* geometry);
+
+    static Prepared prepare(const GEOSGeom_t* geometry);
+
+    // Throw std::runtime_error when GEOS fails
+    static bool intersects(const GEOSGeom_t* a, const GEOSGeom_t* b);
+    static bool contains(const GEOSGeom_t* a, const GEOSGeom_t* b);
+    static bool preparedIntersects(const GEOSPrepGeom_t* a, const GEOSGeom_t* b);
+    static bool preparedContains(const GEOSPrepGeom_t* a, const GEOSGeom_t* b);
+    // nullptr when GEOS fails
+    static Geometry intersection(const GEOSGeom_t* a, const GEOSGeom_t* b);
+
+private:
+    static std::atomic<bool> enabled_;
+};
+
+} // namespace aeronautical
@@ -0,0 +1,48 @@
+#include "HilbertCurve.h"
+#include <algorithm>
+#include <cmath>
+
+namespace aeronautical {
+
+namespace {
+
+constexpr uint32_t kCells = 1u << HilbertCurve::kOrder;
+
+uint32_t cellOf(double value, double min, double scale) {
+    const double cell = (value - min) * scale;
+    if (!(cell > 0.0)) return 0; // NaN too
+    return static_cast<uint32_t>(std::min(cell, static_cast<double>(kCells - 1)));
+}
+
+} // namespace
+
+HilbertCurve::HilbertCurve(double min_x, double min_y, double max_x, double max_y)
+    : min_x_(min_x), min_y_(min_y),
+      scale_x_(max_x > min_x ? kCells / (max_x - min_x) : 0.0),
+      scale_y_(max_y > min_y ? kCells / (max_y - min_y) : 0.0) {
+}
+
+uint32_t HilbertCurve::key(double x, double y) const {
+    return index(cellOf(x, min_x_, scale_x_), cellOf(y, min_y_, scale_y_));
+}
+
+// Quadrant by quadrant from the top, rotating the rest of the way into the
+// quadrant's frame
+uint32_t HilbertCurve::index(uint32_t x, uint32_t y) {
+    uint32_t d = 0;
+    for (uint32_t s = kCells / 2; s > 0; s /= 2) {
+        const uint32_t rx = (x & s) ? 1 : 0;
+        const uint32_t ry = (y & s) ? 1 : 0;
+        d += s * s * ((3 * rx) ^ ry);
+        if (ry == 0) {
+            if (rx == 1) {
+                x = s - 1 - (x & (s - 1));
+                y = s - 1 - (y & (s - 1));
+            }
+            std::swap(x, y);
+        }
+    }
+    return d;
+}
+
+} // namespace aeronautical
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+
+namespace aeronautical {
+
+// Positions along a Hilbert curve through a 65536 x 65536 grid laid over a
+// box. Points close on the curve are close in the box, and unlike row or
+// Z order the curve never jumps across it, so data sorted by key keeps
+// neighbours together in memory.
+class HilbertCurve {
+public:
+    static constexpr int kOrder = 16;
+
+    // Over [min_x, max_x] x [min_y, max_y]; points outside clamp to its edge
+    HilbertCurve(double min_x, double min_y, double max_x, double max_y);
+    // Over the whole lng/lat range
+    static HilbertCurve world() { return HilbertCurve(-180.0, -90.0, 180.0, 90.0); }
+
+    uint32_t key(double x, double y) const;
+
+    // Position of grid cell (x, y), both below 2^kOrder
+    static uint32_t index(uint32_t x, uint32_t y);
+
+private:
+    double min_x_;
+    double min_y_;
+    double scale_x_;
+    double scale_y_;
+};
+
+} // namespace aeronautical
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "AdmissionControl.h"
+#include "BinaryFormat.h"
+#include "ReadRouting.h"
+#include "RequestMetrics.h"
+#include "RequestTracing.h"
+#include "ResponseCache.h"
+#include "ResponseCompression.h"
+#include <crow.h>
+
+namespace aeronautical {
+
+// The server's Crow application; its middlewares run around every route.
+// after_handle runs in reverse order, so bodies are re-encoded first and
+// compressed last. ReadRouting only sets per-request state for handlers;
+// RequestTracing and RequestMetrics wrap everything, so their timings
+// include the encoding, and they see requests AdmissionControl rejects.
+// ResponseCache sits outside the response middlewares so it stores, and
+// answers hits with, bodies already encoded and compressed.
+using HttpApp = crow::App<RequestTracing, RequestMetrics, AdmissionControl, ResponseCache, ReadRouting,
+                          ResponseCompression, BinaryFormat>;
+
+} // namespace aeronautical
@@ -0,0 +1,197 @@
+#include "InMemorySources.h"
+#include <algorithm>
+
+namespace aeronautical {
+
+void InMemoryProtectionSource::put(ProcedureProtection protection, std::string wkb) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Versions only move forward, even for two puts within one clock tick
+    const auto now = std::chrono::time_point_cast<std::chrono::microseconds>(std::chrono::system_clock::now());
+    last_version_ = std::max<std::chrono::system_clock::time_point>(now, last_version_ + std::chrono::microseconds(1));
+
+    Entry entry;
+    entry.geojson = std::move(protection.protection_geometry);
+    entry.wkb = std::move(wkb);
+    protection.protection_geometry.clear();
+    protection.updated_at = last_version_;
+    protection.revision = std::chrono::duration_cast<std::chrono::microseconds>(last_version_.time_since_epoch()).count();
+    protection.footprint.reset();
+    entry.header = std::move(protection);
+    protections_[entry.header.procedure_id] = std::move(entry);
+}
+
+bool InMemoryProtectionSource::remove(int procedure_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return protections_.erase(procedure_id) > 0;
+}
+
+void InMemoryProtectionSource::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    protections_.clear();
+}
+
+size_t InMemoryProtectionSource::size() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return protections_.size();
+}
+
+std::vector<ProcedureProtection> InMemoryProtectionSource::findActiveProtectionHeaders() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<ProcedureProtection> headers;
+    headers.reserve(protections_.size());
+    for (const auto& [procedure_id, entry] : protections_) {
+        if (entry.header.is_active && (!entry.geojson.empty() || !entry.wkb.empty())) {
+            headers.push_back(entry.header);
+        }
+    }
+    return headers;
+}
+
+std::unordered_map<int, StoredProtectionGeometry>
+InMemoryProtectionSource::findProtectionGeometries(const std::vector<int>& procedure_ids) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::unordered_map<int, StoredProtectionGeometry> geometries;
+    for (int procedure_id : procedure_ids) {
+        auto it = protections_.find(procedure_id);
+        if (it == protections_.end()) continue;
+        StoredProtectionGeometry stored;
+        if (!it->second.wkb.empty()) {
+            stored.wkb = it->second.wkb;
+        } else {
+            stored.geojson = it->second.geojson;
+        }
+        geometries.emplace(procedure_id, std::move(stored));
+    }
+    return geometries;
+}
+
+bool InMemoryProtectionSource::saveProtectionFootprint(int procedure_id, int64_t revision,
+                                                       const ProtectionFootprint& footprint) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = protections_.find(procedure_id);
+    if (it == protections_.end() || it->second.header.revision != revision) {
+        return false;
+    }
+    it->second.header.footprint = footprint;
+    return true;
+}
+
+bool InMemoryProtectionSource::saveProtectionWkb(int procedure_id, int64_t revision, const std::string& wkb) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = protections_.find(procedure_id);
+    if (it == protections_.end() || it->second.header.revision != revision) {
+        return false;
+    }
+    it->second.wkb = wkb;
+    return true;
+}
+
+void InMemoryProjectSource::put(Project project, std::string geojson, bool validated) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry entry;
+    entry.geojson = std::move(geojson);
+    entry.validated = validated;
+    entry.revision = ++next_revision_;
+    entry.project = std::move(project);
+    projects_[entry.project.id] = std::move(entry);
+}
+
+bool InMemoryProjectSource::setStatus(int project_id, ProjectStatus status) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = projects_.find(project_id);
+    if (it == projects_.end()) {
+        return false;
+    }
+    it->second.project.status = status;
+    it->second.project.updated_at = std::chrono::system_clock::now();
+    return true;
+}
+
+bool InMemoryProjectSource::remove(int project_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return projects_.erase(project_id) > 0;
+}
+
+std::optional<Project> InMemoryProjectSource::findById(int id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = projects_.find(id);
+    if (it == projects_.end()) {
+        return std::nullopt;
+    }
+    return it->second.project;
+}
+
+std::optional<std::string> InMemoryProjectSource::findGeometriesByProjectId(int project_id, bool* validated) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = projects_.find(project_id);
+    if (it == projects_.end() || it->second.geojson.empty()) {
+        return std::nullopt;
+    }
+    if (validated) {
+        *validated = it->second.validated;
+    }
+    return it->second.geojson;
+}
+
+std::vector<std::pair<int, std::string>> InMemoryProjectSource::findGeometryRevisions(ProjectStatus status) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::pair<int, std::string>> revisions;
+    for (const auto& [project_id, entry] : projects_) {
+        if (entry.project.status == status && !entry.geojson.empty()) {
+            revisions.emplace_back(project_id, "m" + std::to_string(entry.revision));
+        }
+    }
+    return revisions;
+}
+
+InMemoryResultSink::InMemoryResultSink(std::shared_ptr<InMemoryProjectSource> projects)
+    : projects_(std::move(projects)) {}
+
+bool InMemoryResultSink::storeAnalysis(int project_id, const std::vector<PendingConflict>& conflicts,
+                                       bool under_review, ConflictDiff* diff) {
+    // Both under the sink's lock, so readers of conflicts() see them together;
+    // like ConflictRepository, a project that is gone does not fail the store
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (under_review && projects_) {
+        projects_->setStatus(project_id, ProjectStatus::UnderReview);
+    }
+    auto& stored = conflicts_[project_id];
+    if (diff) {
+        *diff = ConflictDiff{};
+        std::vector<char> matched(stored.size(), 0);
+        for (const auto& conflict : conflicts) {
+            ConflictDiff::Entry entry{0, conflict.procedure_id, conflict.description};
+            size_t i = 0;
+            while (conflict.signature != 0 && i < stored.size() &&
+                   (matched[i] || stored[i].signature != conflict.signature)) {
+                i++;
+            }
+            if (conflict.signature != 0 && i < stored.size()) {
+                matched[i] = 1;
+                diff->unchanged.push_back(std::move(entry));
+            } else {
+                diff->added.push_back(std::move(entry));
+            }
+        }
+        for (size_t i = 0; i < stored.size(); i++) {
+            if (!matched[i]) {
+                diff->resolved.push_back({0, stored[i].procedure_id, stored[i].description});
+            }
+        }
+    }
+    stored = conflicts;
+    return true;
+}
+
+std::vector<PendingConflict> InMemoryResultSink::conflicts(int project_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = conflicts_.find(project_id);
+    return it == conflicts_.end() ? std::vector<PendingConflict>{} : it->second;
+}
+
+void InMemoryResultSink::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    conflicts_.clear();
+}
+
+} // namespace aeronautical
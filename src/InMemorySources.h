@@ -0,0 +1,91 @@
+#pragma once
+
+#include "AnalysisSources.h"
+#include <chrono>
+#include <map>
+#include <mutex>
+
+namespace aeronautical {
+
+// Analysis sources held in the process, for runs without MySQL (benchmarks,
+// replaying a snapshot, a backend embedded in a tool). Wire them up with
+// ConflictController::setSources; all of them are safe to share between
+// analyses running at once.
+
+class InMemoryProtectionSource : public ProtectionSource {
+public:
+    // Adds or replaces the protection of protection.procedure_id. Its
+    // protection_geometry is the GeoJSON analysed; wkb, when given, is used
+    // instead. Every put is a new version (updated_at, revision), so the
+    // geometry cache never serves the previous one.
+    void put(ProcedureProtection protection, std::string wkb = {});
+    bool remove(int procedure_id);
+    void clear();
+    size_t size();
+
+    std::vector<ProcedureProtection> findActiveProtectionHeaders() override;
+    std::unordered_map<int, StoredProtectionGeometry> findProtectionGeometries(
+        const std::vector<int>& procedure_ids) override;
+
+    // Kept with the protection while it is at revision
+    bool storesFootprints() override { return true; }
+    bool saveProtectionFootprint(int procedure_id, int64_t revision, const ProtectionFootprint& footprint) override;
+    bool storesWkb() override { return true; }
+    bool saveProtectionWkb(int procedure_id, int64_t revision, const std::string& wkb) override;
+
+private:
+    struct Entry {
+        ProcedureProtection header; // protection_geometry moved to geojson
+        std::string geojson;
+        std::string wkb;
+    };
+
+    std::mutex mutex_;
+    std::map<int, Entry> protections_;
+    std::chrono::system_clock::time_point last_version_{};
+};
+
+class InMemoryProjectSource : public ProjectGeometrySource {
+public:
+    // Adds or replaces a project with its primary feature collection;
+    // validated as ProjectRepository reports it
+    void put(Project project, std::string geojson, bool validated = false);
+    bool setStatus(int project_id, ProjectStatus status);
+    bool remove(int project_id);
+
+    std::optional<Project> findById(int id) override;
+    std::optional<std::string> findGeometriesByProjectId(int project_id, bool* validated = nullptr) override;
+    std::vector<std::pair<int, std::string>> findGeometryRevisions(ProjectStatus status) override;
+
+private:
+    struct Entry {
+        Project project;
+        std::string geojson;
+        bool validated = false;
+        uint64_t revision = 0;
+    };
+
+    std::mutex mutex_;
+    std::map<int, Entry> projects_;
+    uint64_t next_revision_ = 0;
+};
+
+class InMemoryResultSink : public AnalysisResultSink {
+public:
+    // Status changes go to projects; without one, under_review only stores
+    explicit InMemoryResultSink(std::shared_ptr<InMemoryProjectSource> projects = nullptr);
+
+    bool storeAnalysis(int project_id, const std::vector<PendingConflict>& conflicts, bool under_review,
+                       ConflictDiff* diff = nullptr) override;
+
+    // Conflicts of the project's last stored analysis
+    std::vector<PendingConflict> conflicts(int project_id);
+    void clear();
+
+private:
+    std::shared_ptr<InMemoryProjectSource> projects_;
+    std::mutex mutex_;
+    std::unordered_map<int, std::vector<PendingConflict>> conflicts_;
+};
+
+} // namespace aeronautical
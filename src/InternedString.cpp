@@ -0,0 +1,65 @@
+#include "InternedString.h"
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace aeronautical {
+
+namespace {
+
+struct Pool {
+    std::shared_mutex mutex;
+    std::deque<std::string> values; // stable addresses
+    std::unordered_map<std::string_view, const std::string*> by_text;
+    size_t bytes = 0;
+};
+
+Pool& pool() {
+    static Pool instance;
+    return instance;
+}
+
+} // namespace
+
+const std::string& InternedString::emptyValue() {
+    static const std::string instance;
+    return instance;
+}
+
+const std::string* InternedString::intern(std::string_view text) {
+    if (text.empty()) {
+        return &emptyValue();
+    }
+    // Loads intern the same few values over and over; a per-thread cache of
+    // recent hits skips the shared lock for them
+    thread_local const std::string* recent[64] = {};
+    const size_t hash = std::hash<std::string_view>{}(text);
+    const std::string*& slot = recent[hash % 64];
+    if (slot && *slot == text) {
+        return slot;
+    }
+
+    Pool& p = pool();
+    {
+        std::shared_lock<std::shared_mutex> lock(p.mutex);
+        auto it = p.by_text.find(text);
+        if (it != p.by_text.end()) return slot = it->second;
+    }
+    std::unique_lock<std::shared_mutex> lock(p.mutex);
+    auto it = p.by_text.find(text);
+    if (it != p.by_text.end()) return slot = it->second;
+    const std::string& value = p.values.emplace_back(text);
+    p.by_text.emplace(value, &value);
+    p.bytes += value.size();
+    return slot = &value;
+}
+
+InternedString::PoolStats InternedString::poolStats() {
+    Pool& p = pool();
+    std::shared_lock<std::shared_mutex> lock(p.mutex);
+    return PoolStats{p.values.size(), p.bytes};
+}
+
+} // namespace aeronautical
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace aeronautical {
+
+// Handle to one shared copy of a string value. Reference columns such as
+// waypoint_type, country_name or usage_type have a few hundred distinct values
+// across hundreds of thousands of rows; rows hold an 8-byte handle instead of
+// their own std::string, and copying a row copies pointers. Values live in a
+// process-wide pool that only grows, so handles never dangle; it is meant for
+// low-cardinality columns, not free text. Interning is thread-safe.
+class InternedString {
+public:
+    InternedString() : text_(&emptyValue()) {}
+    InternedString(std::string_view text) : text_(intern(text)) {}
+    InternedString(const std::string& text) : text_(intern(text)) {}
+    InternedString(const char* text) : text_(intern(text)) {}
+
+    const std::string& str() const { return *text_; }
+    std::string_view view() const { return *text_; }
+    const char* c_str() const { return text_->c_str(); }
+    size_t size() const { return text_->size(); }
+    bool empty() const { return text_->empty(); }
+
+    operator const std::string&() const { return *text_; }
+    operator std::string_view() const { return *text_; }
+
+    // Equal values share one copy, so two handles compare by address first
+    friend bool operator==(const InternedString& a, std::string_view b) {
+        return (a.text_->data() == b.data() && a.size() == b.size()) || a.view() == b;
+    }
+
+    // Distinct values pooled so far and the bytes they hold
+    struct PoolStats {
+        size_t values = 0;
+        size_t bytes = 0;
+    };
+    static PoolStats poolStats();
+
+private:
+    static const std::string& emptyValue();
+    static const std::string* intern(std::string_view text);
+
+    const std::string* text_;
+};
+
+} // namespace aeronautical
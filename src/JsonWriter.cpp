@@ -0,0 +1,229 @@
+#include "JsonWriter.h"
+#include "Timestamp.h"
+#include <charconv>
+#include <cmath>
+
+namespace aeronautical {
+
+namespace {
+
+// Length of the valid UTF-8 sequence starting at text[i], or 0 if invalid
+size_t utf8SequenceLength(std::string_view text, size_t i) {
+    const auto byte = [&](size_t k) { return static_cast<unsigned char>(text[k]); };
+    const auto continuation = [&](size_t k) { return k < text.size() && (byte(k) & 0xC0) == 0x80; };
+
+    unsigned char lead = byte(i);
+    if (lead < 0x80) return 1;
+    if (lead >= 0xC2 && lead <= 0xDF) return continuation(i + 1) ? 2 : 0;
+    if (lead >= 0xE0 && lead <= 0xEF) {
+        if (!continuation(i + 1) || !continuation(i + 2)) return 0;
+        unsigned char second = byte(i + 1);
+        if (lead == 0xE0 && second < 0xA0) return 0; // overlong
+        if (lead == 0xED && second > 0x9F) return 0; // surrogates
+        return 3;
+    }
+    if (lead >= 0xF0 && lead <= 0xF4) {
+        if (!continuation(i + 1) || !continuation(i + 2) || !continuation(i + 3)) return 0;
+        unsigned char second = byte(i + 1);
+        if (lead == 0xF0 && second < 0x90) return 0;
+        if (lead == 0xF4 && second > 0x8F) return 0;
+        return 4;
+    }
+    return 0;
+}
+
+} // namespace
+
+void JsonWriter::appendEscaped(std::string& out, std::string_view text) {
+    static const char* hex = "0123456789abcdef";
+    out += '"';
+    size_t i = 0;
+    while (i < text.size()) {
+        // Copy runs of plain characters in one go
+        size_t run = i;
+        while (run < text.size()) {
+            unsigned char c = static_cast<unsigned char>(text[run]);
+            if (c < 0x20 || c == '"' || c == '\\' || c >= 0x80) break;
+            run++;
+        }
+        out.append(text.data() + i, run - i);
+        i = run;
+        if (i >= text.size()) break;
+
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        if (c >= 0x80) {
+            size_t len = utf8SequenceLength(text, i);
+            if (len == 0) {
+                out += "\xEF\xBF\xBD"; // U+FFFD
+                i++;
+            } else {
+                out.append(text.data() + i, len);
+                i += len;
+            }
+            continue;
+        }
+
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                out += "\\u00";
+                out += hex[c >> 4];
+                out += hex[c & 0x0F];
+                break;
+        }
+        i++;
+    }
+    out += '"';
+}
+
+void JsonWriter::beforeValue() {
+    if (after_key_) {
+        after_key_ = false;
+        return;
+    }
+    if (!has_items_.empty()) {
+        if (has_items_.back()) {
+            out_ += ',';
+        }
+        has_items_.back() = true;
+    }
+}
+
+JsonWriter& JsonWriter::beginObject() {
+    beforeValue();
+    out_ += '{';
+    has_items_.push_back(false);
+    return *this;
+}
+
+JsonWriter& JsonWriter::endObject() {
+    out_ += '}';
+    has_items_.pop_back();
+    return *this;
+}
+
+JsonWriter& JsonWriter::beginArray() {
+    beforeValue();
+    out_ += '[';
+    has_items_.push_back(false);
+    return *this;
+}
+
+JsonWriter& JsonWriter::endArray() {
+    out_ += ']';
+    has_items_.pop_back();
+    return *this;
+}
+
+JsonWriter& JsonWriter::key(std::string_view name) {
+    beforeValue();
+    appendEscaped(out_, name);
+    out_ += ':';
+    after_key_ = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::rawKey(std::string_view name) {
+    beforeValue();
+    out_ += '"';
+    out_ += name;
+    out_ += "\":";
+    after_key_ = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(std::string_view text) {
+    beforeValue();
+    appendEscaped(out_, text);
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(int64_t number) {
+    beforeValue();
+    char buf[24];
+    auto res = std::to_chars(buf, buf + sizeof(buf), number);
+    out_.append(buf, res.ptr);
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(uint64_t number) {
+    beforeValue();
+    char buf[24];
+    auto res = std::to_chars(buf, buf + sizeof(buf), number);
+    out_.append(buf, res.ptr);
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(double number) {
+    beforeValue();
+    if (!std::isfinite(number)) {
+        out_ += "null"; // as nlohmann does
+        return *this;
+    }
+    // Shortest round-trip form; keep a ".0" on integral values like nlohmann
+    char buf[32];
+    auto res = std::to_chars(buf, buf + sizeof(buf), number);
+    std::string_view text(buf, res.ptr - buf);
+    out_ += text;
+    if (text.find_first_of(".e") == std::string_view::npos) {
+        out_ += ".0";
+    }
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(bool flag) {
+    beforeValue();
+    out_ += flag ? "true" : "false";
+    return *this;
+}
+
+JsonWriter& JsonWriter::nullValue() {
+    beforeValue();
+    out_ += "null";
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(std::chrono::system_clock::time_point tp) {
+    char buf[kTimestampLength + 2];
+    buf[0] = '"';
+    formatTimestamp(tp, buf + 1);
+    buf[kTimestampLength + 1] = '"';
+
+    beforeValue();
+    out_.append(buf, sizeof(buf));
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(const nlohmann::json& json) {
+    // Serialize first so a dump() failure leaves the buffer untouched
+    std::string text = json.dump();
+    beforeValue();
+    out_ += text;
+    return *this;
+}
+
+bool JsonWriter::looksLikeContainer(std::string_view json) {
+    const auto blank = [](char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; };
+    size_t first = 0;
+    while (first < json.size() && blank(json[first])) first++;
+    size_t last = json.size();
+    while (last > first && blank(json[last - 1])) last--;
+    if (last - first < 2) return false;
+    char open = json[first];
+    char close = json[last - 1];
+    return (open == '{' && close == '}') || (open == '[' && close == ']');
+}
+
+JsonWriter& JsonWriter::raw(std::string_view json) {
+    beforeValue();
+    out_ += json;
+    return *this;
+}
+
+} // namespace aeronautical
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <json.hpp>
+#include "InternedString.h"
+
+namespace aeronautical {
+
+// Forward-only JSON text writer that appends to a caller-owned buffer, so
+// list endpoints can serialize one entity at a time instead of building a
+// nlohmann::json DOM for the whole response. Commas are inserted
+// automatically; output matches nlohmann's dump() apart from key order,
+// which is whatever order the caller writes.
+class JsonWriter {
+public:
+    explicit JsonWriter(std::string& out) : out_(out) {}
+
+    JsonWriter& beginObject();
+    JsonWriter& endObject();
+    JsonWriter& beginArray();
+    JsonWriter& endArray();
+
+    JsonWriter& key(std::string_view name);
+    // Key copied verbatim; for literals that need no escaping
+    JsonWriter& rawKey(std::string_view name);
+
+    JsonWriter& value(std::string_view text);
+    JsonWriter& value(const std::string& text) { return value(std::string_view(text)); }
+    JsonWriter& value(const char* text) { return value(std::string_view(text)); }
+    JsonWriter& value(const InternedString& text) { return value(text.view()); }
+    JsonWriter& value(int64_t number);
+    JsonWriter& value(int number) { return value(static_cast<int64_t>(number)); }
+    JsonWriter& value(uint64_t number);
+    JsonWriter& value(double number);
+    JsonWriter& value(bool flag);
+    JsonWriter& nullValue();
+    // "YYYY-MM-DD HH:MM:SS" in the TimestampZone, same text as timePointToString
+    JsonWriter& value(std::chrono::system_clock::time_point tp);
+    // Embeds an existing DOM value
+    JsonWriter& value(const nlohmann::json& json);
+
+    template <typename T>
+    JsonWriter& value(const std::optional<T>& maybe) {
+        return maybe ? value(*maybe) : nullValue();
+    }
+
+    template <typename T>
+    JsonWriter& field(std::string_view name, const T& v) {
+        key(name);
+        return value(v);
+    }
+
+    template <typename T>
+    JsonWriter& rawField(std::string_view name, const T& v) {
+        rawKey(name);
+        return value(v);
+    }
+
+    // Appends pre-serialized JSON text as the next value
+    JsonWriter& raw(std::string_view json);
+
+    std::string& buffer() { return out_; }
+
+    // Cheap envelope check for stored JSON about to be spliced in with raw():
+    // first and last non-blank characters are a matching {} or [] pair.
+    // Not a validator; text we stored ourselves was validated on write.
+    static bool looksLikeContainer(std::string_view json);
+
+    // JSON string escaping as in nlohmann::json::dump(); invalid UTF-8 becomes U+FFFD
+    static void appendEscaped(std::string& out, std::string_view text);
+
+private:
+    void beforeValue();
+
+    std::string& out_;
+    std::vector<bool> has_items_; // one entry per open object/array
+    bool after_key_ = false;
+};
+
+} // namespace aeronautical
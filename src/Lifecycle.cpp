@@ -0,0 +1,125 @@
+#include "Lifecycle.h"
+#include <spdlog/spdlog.h>
+#include <thread>
+
+namespace aeronautical {
+
+Lifecycle& Lifecycle::getInstance() {
+    static Lifecycle instance;
+    return instance;
+}
+
+const char* Lifecycle::name(Phase phase) {
+    switch (phase) {
+        case Phase::Starting: return "starting";
+        case Phase::Ready: return "ready";
+        case Phase::Draining: return "draining";
+    }
+    return "unknown";
+}
+
+void Lifecycle::startupPhase(const std::string& name) {
+    const auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(mutex_);
+    endStartupPhase(now);
+    current_phase_ = name;
+    phase_started_ = now;
+}
+
+void Lifecycle::endStartupPhase(std::chrono::steady_clock::time_point now) {
+    if (current_phase_.empty()) return;
+    const auto took = std::chrono::duration_cast<std::chrono::milliseconds>(now - phase_started_);
+    spdlog::info("Startup phase {} took {} ms", current_phase_, took.count());
+    phases_.push_back(StartupPhase{current_phase_, took});
+    current_phase_.clear();
+}
+
+void Lifecycle::warmUp(const std::string& name, const Step& step) {
+    const auto started = std::chrono::steady_clock::now();
+    bool ok = false;
+    try {
+        ok = step();
+    } catch (const std::exception& e) {
+        spdlog::error("Warm-up step {} failed: {}", name, e.what());
+    }
+    const auto took = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+    if (ok) {
+        spdlog::info("Warm-up step {} done in {} ms", name, took.count());
+    } else {
+        spdlog::warn("Warm-up step {} did not complete ({} ms); continuing cold", name, took.count());
+    }
+    const auto at = std::chrono::duration_cast<std::chrono::milliseconds>(started - started_at_);
+    std::lock_guard<std::mutex> lock(mutex_);
+    steps_.push_back(WarmUpStep{name, ok, at, took});
+}
+
+void Lifecycle::warmUpConcurrently(const std::vector<std::pair<std::string, Step>>& steps) {
+    std::vector<std::thread> threads;
+    threads.reserve(steps.size());
+    for (const auto& [name, step] : steps) {
+        threads.emplace_back([this, &name, &step]() { warmUp(name, step); });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+void Lifecycle::markReady() {
+    Phase expected = Phase::Starting;
+    if (!phase_.compare_exchange_strong(expected, Phase::Ready)) return;
+    const auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(mutex_);
+    endStartupPhase(now);
+    startup_ = std::chrono::duration_cast<std::chrono::milliseconds>(now - started_at_);
+    spdlog::info("Ready after {} ms", startup_.count());
+}
+
+void Lifecycle::beginDrain() {
+    phase_.store(Phase::Draining, std::memory_order_release);
+}
+
+void Lifecycle::registerRoutes(HttpApp& app) {
+    CROW_ROUTE(app, "/api/health/live")
+        .methods(crow::HTTPMethod::GET)
+        ([this]() {
+            nlohmann::json body;
+            body["status"] = "alive";
+            body["phase"] = name(phase());
+            crow::response res(200, body.dump());
+            res.add_header("Content-Type", "application/json");
+            res.add_header("Cache-Control", "no-store");
+            return res;
+        });
+
+    CROW_ROUTE(app, "/api/health/ready")
+        .methods(crow::HTTPMethod::GET)
+        ([this]() {
+            crow::response res(ready() ? 200 : 503, status().dump());
+            res.add_header("Content-Type", "application/json");
+            res.add_header("Cache-Control", "no-store");
+            return res;
+        });
+}
+
+nlohmann::json Lifecycle::status() const {
+    nlohmann::json j;
+    j["ready"] = ready();
+    j["phase"] = name(phase());
+    j["accepting"] = accepting();
+    j["uptime_s"] = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - started_at_).count();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (startup_.count() > 0) j["startup_ms"] = startup_.count();
+    nlohmann::json phases = nlohmann::json::array();
+    for (const auto& phase : phases_) {
+        phases.push_back({{"name", phase.name}, {"ms", phase.took.count()}});
+    }
+    j["startup_phases"] = std::move(phases);
+    nlohmann::json steps = nlohmann::json::array();
+    for (const auto& step : steps_) {
+        steps.push_back({{"name", step.name}, {"ok", step.ok}, {"at_ms", step.at.count()}, {"ms", step.took.count()}});
+    }
+    j["warm_up"] = std::move(steps);
+    return j;
+}
+
+} // namespace aeronautical
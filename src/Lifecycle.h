@@ -0,0 +1,83 @@
+#pragma once
+
+#include "HttpApp.h"
+#include <json.hpp>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace aeronautical {
+
+// Where the process is between start and exit, for load balancers and
+// orchestrators. Starting until the warm-up steps ran, then Ready; a
+// termination signal moves it to Draining, during which readiness fails
+// so traffic moves away, and after the drain delay new requests are
+// refused while those in progress finish. The readiness body lists how
+// long each startup phase and warm-up step took.
+//   GET /api/health/live  - 200 while the process serves HTTP at all
+//   GET /api/health/ready - 200 only when Ready, else 503
+class Lifecycle {
+public:
+    enum class Phase { Starting, Ready, Draining };
+
+    static Lifecycle& getInstance();
+
+    Lifecycle(const Lifecycle&) = delete;
+    Lifecycle& operator=(const Lifecycle&) = delete;
+
+    using Step = std::function<bool()>;
+
+    // Ends the current startup phase, if any, and starts the named one;
+    // markReady ends the last
+    void startupPhase(const std::string& name);
+    // Runs step and records its outcome, start offset and duration; a step
+    // that throws or returns false is logged and does not stop the start
+    void warmUp(const std::string& name, const Step& step);
+    // Independent steps, each on its own thread; returns when all finished
+    void warmUpConcurrently(const std::vector<std::pair<std::string, Step>>& steps);
+    void markReady();
+    void beginDrain();
+    // New requests are answered 503 from here on
+    void stopAccepting() { accepting_.store(false, std::memory_order_release); }
+
+    Phase phase() const { return phase_.load(std::memory_order_acquire); }
+    bool ready() const { return phase() == Phase::Ready; }
+    bool accepting() const { return accepting_.load(std::memory_order_acquire); }
+    static const char* name(Phase phase);
+
+    void registerRoutes(HttpApp& app);
+    nlohmann::json status() const;
+
+private:
+    Lifecycle() : started_at_(std::chrono::steady_clock::now()) {}
+
+    struct WarmUpStep {
+        std::string name;
+        bool ok = false;
+        std::chrono::milliseconds at{0}; // since the process started
+        std::chrono::milliseconds took{0};
+    };
+    void endStartupPhase(std::chrono::steady_clock::time_point now);
+
+    struct StartupPhase {
+        std::string name;
+        std::chrono::milliseconds took{0};
+    };
+
+    std::atomic<Phase> phase_{Phase::Starting};
+    std::atomic<bool> accepting_{true};
+    std::chrono::steady_clock::time_point started_at_;
+    std::chrono::milliseconds startup_{0};
+
+    mutable std::mutex mutex_;
+    std::vector<StartupPhase> phases_;
+    std::string current_phase_;
+    std::chrono::steady_clock::time_point phase_started_;
+    std::vector<WarmUpStep> steps_;
+};
+
+} // namespace aeronautical
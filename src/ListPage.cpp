@@ -0,0 +1,74 @@
+#include "ListPage.h"
+#include <crow/utility.h>
+#include <charconv>
+#include <cstring>
+
+namespace aeronautical {
+
+std::string PageCursor::encode() const {
+    const std::string payload = std::to_string(id) + ":" + key;
+    // Unpadded, so the token needs no escaping in a query string
+    std::string token = crow::utility::base64encode_urlsafe(payload, payload.size());
+    while (!token.empty() && token.back() == '=') token.pop_back();
+    return token;
+}
+
+std::optional<PageCursor> PageCursor::decode(std::string_view token) {
+    if (token.empty() || token.size() > 1024) return std::nullopt;
+    for (char c : token) {
+        const bool valid = (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') ||
+                           c == '-' || c == '_' || c == '=';
+        if (!valid) return std::nullopt;
+    }
+    const std::string payload = crow::utility::base64decode(token.data(), token.size());
+    const size_t colon = payload.find(':');
+    if (colon == std::string::npos) return std::nullopt;
+
+    PageCursor cursor;
+    auto [end, ec] = std::from_chars(payload.data(), payload.data() + colon, cursor.id);
+    if (ec != std::errc() || end != payload.data() + colon || cursor.id <= 0) return std::nullopt;
+    cursor.key = payload.substr(colon + 1);
+    return cursor;
+}
+
+std::optional<TotalMode> parseTotalMode(const char* text) {
+    if (!text || std::strcmp(text, "approx") == 0) return TotalMode::Approximate;
+    if (std::strcmp(text, "exact") == 0) return TotalMode::Exact;
+    if (std::strcmp(text, "none") == 0) return TotalMode::None;
+    return std::nullopt;
+}
+
+ListCountCache& ListCountCache::getInstance() {
+    static ListCountCache instance;
+    return instance;
+}
+
+int ListCountCache::get(Table table, const std::string& filter_key, const std::function<int()>& count) {
+    const size_t index = static_cast<size_t>(table);
+    const std::string key = std::to_string(index) + "|" + filter_key;
+    uint64_t generation;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        generation = generations_[index];
+        auto it = entries_.find(key);
+        if (it != entries_.end() && it->second.generation == generation &&
+            std::chrono::steady_clock::now() - it->second.counted_at < kTtl) {
+            return it->second.count;
+        }
+    }
+
+    // Counted outside the lock; concurrent misses each count once
+    const int counted = count();
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Few distinct filters exist in practice; clearing bounds a flood of them
+    if (entries_.size() >= 4096) entries_.clear();
+    entries_[key] = Entry{counted, generation, std::chrono::steady_clock::now()};
+    return counted;
+}
+
+void ListCountCache::bump(Table table) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    generations_[static_cast<size_t>(table)]++;
+}
+
+} // namespace aeronautical
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace aeronautical {
+
+// Position after the last row of a page in a list ordered by (key, id):
+// the sort column's text and the row id. Clients get it as an opaque
+// base64url token and pass it back as ?after= for the next page, which
+// the repository turns into a range condition instead of an OFFSET, so
+// every page costs the same however deep it is.
+struct PageCursor {
+    std::string key;
+    int id = 0;
+
+    std::string encode() const;
+    // nullopt for a token that was not produced by encode()
+    static std::optional<PageCursor> decode(std::string_view token);
+};
+
+// How a list response reports its total: exact runs COUNT(*) on every
+// request, approximate serves it from ListCountCache, none leaves it out.
+// ?total=exact|approx|none, approx by default; nullopt for other values.
+enum class TotalMode { Exact, Approximate, None };
+std::optional<TotalMode> parseTotalMode(const char* text);
+
+// Row counts of filtered list queries, so paging through a list does not
+// run COUNT(*) for every page. An entry is reused until it is kTtl old or
+// the table's generation moves; this process bumps it on inserts and
+// deletes, and the TTL bounds how stale a total gets when rows change
+// anywhere else.
+class ListCountCache {
+public:
+    enum class Table { Projects, Procedures };
+
+    static ListCountCache& getInstance();
+
+    ListCountCache(const ListCountCache&) = delete;
+    ListCountCache& operator=(const ListCountCache&) = delete;
+
+    static constexpr std::chrono::seconds kTtl{60};
+
+    // Cached count for the filter key, else count() stored under it
+    int get(Table table, const std::string& filter_key, const std::function<int()>& count);
+    void bump(Table table);
+
+private:
+    ListCountCache() = default;
+
+    struct Entry {
+        int count = 0;
+        uint64_t generation = 0;
+        std::chrono::steady_clock::time_point counted_at;
+    };
+
+    std::mutex mutex_;
+    uint64_t generations_[2] = {0, 0};
+    std::unordered_map<std::string, Entry> entries_; // table index prefixed
+};
+
+} // namespace aeronautical
@@ -0,0 +1,87 @@
+#include "LocalProjection.h"
+#include "ogr_spatialref.h"
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+namespace aeronautical {
+
+namespace {
+
+// Segments per quarter circle of a buffered point or line end
+constexpr int kQuadrantSegments = 8;
+
+struct TransformDeleter {
+    void operator()(OGRCoordinateTransformation* transform) const { OGRCoordinateTransformation::DestroyCT(transform); }
+};
+using TransformPtr = std::unique_ptr<OGRCoordinateTransformation, TransformDeleter>;
+
+struct Projection {
+    TransformPtr to_local;
+    TransformPtr to_wgs84;
+};
+
+// UTM zones are keyed +zone north and -zone south; the polar caps outside
+// the UTM latitudes are kPolarKey and -kPolarKey
+constexpr int kPolarKey = 100;
+
+int projectionKey(double longitude, double latitude) {
+    if (latitude >= 84) return kPolarKey;
+    if (latitude < -80) return -kPolarKey;
+    const int zone = std::clamp(static_cast<int>(std::floor((longitude + 180) / 6)) + 1, 1, 60);
+    return latitude >= 0 ? zone : -zone;
+}
+
+const Projection* projectionFor(int key) {
+    // A failed creation is cached too, as an empty entry
+    thread_local std::unordered_map<int, Projection> projections;
+    auto it = projections.find(key);
+    if (it == projections.end()) {
+        OGRSpatialReference wgs84;
+        wgs84.SetWellKnownGeogCS("WGS84");
+        wgs84.SetAxisMappingStrategy(OAMS_TRADITIONAL_GIS_ORDER);
+
+        OGRSpatialReference local;
+        if (std::abs(key) == kPolarKey) {
+            local.SetAE(key > 0 ? 90 : -90, 0, 0, 0);
+        } else {
+            local.SetUTM(std::abs(key), key > 0);
+        }
+        local.SetWellKnownGeogCS("WGS84");
+        local.SetAxisMappingStrategy(OAMS_TRADITIONAL_GIS_ORDER);
+
+        // Both transformations keep their own copies of the references
+        Projection projection;
+        projection.to_local.reset(OGRCreateCoordinateTransformation(&wgs84, &local));
+        projection.to_wgs84.reset(OGRCreateCoordinateTransformation(&local, &wgs84));
+        it = projections.emplace(key, std::move(projection)).first;
+    }
+    const Projection& projection = it->second;
+    return projection.to_local && projection.to_wgs84 ? &projection : nullptr;
+}
+
+} // namespace
+
+std::unique_ptr<OGRGeometry> LocalProjection::buffer(const OGRGeometry& geometry, double metres) {
+    if (geometry.IsEmpty()) return nullptr;
+
+    OGREnvelope envelope;
+    geometry.getEnvelope(&envelope);
+    const Projection* projection =
+        projectionFor(projectionKey((envelope.MinX + envelope.MaxX) / 2, (envelope.MinY + envelope.MaxY) / 2));
+    if (!projection) return nullptr;
+
+    std::unique_ptr<OGRGeometry> projected(geometry.clone());
+    if (projected->transform(projection->to_local.get()) != OGRERR_NONE) {
+        return nullptr;
+    }
+    std::unique_ptr<OGRGeometry> grown(projected->Buffer(metres, kQuadrantSegments));
+    if (!grown || grown->transform(projection->to_wgs84.get()) != OGRERR_NONE) {
+        return nullptr;
+    }
+    // Project geometries carry no reference system elsewhere either
+    grown->assignSpatialReference(nullptr);
+    return grown;
+}
+
+} // namespace aeronautical
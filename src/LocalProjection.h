@@ -0,0 +1,19 @@
+#pragma once
+
+#include "ogr_geometry.h"
+#include <memory>
+
+namespace aeronautical {
+
+// Metric operations on WGS84 geometries through a local projection: the UTM
+// zone of the geometry's centre, or an azimuthal equidistant projection
+// centred on the pole beyond the UTM latitudes. Transformations are created once per
+// thread and zone and reused, since building one costs far more than using it.
+class LocalProjection {
+public:
+    // The geometry grown by metres on every side; nullptr if it cannot be
+    // projected. Each line or ring goes through one batched transform call.
+    static std::unique_ptr<OGRGeometry> buffer(const OGRGeometry& geometry, double metres);
+};
+
+} // namespace aeronautical
@@ -0,0 +1,48 @@
+#include "LockStats.h"
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string_view>
+
+namespace aeronautical {
+
+namespace {
+
+struct Registry {
+    std::mutex mutex;
+    std::deque<LockStats::Site> sites; // stable addresses
+    std::map<std::string, LockStats::Site*, std::less<>> by_name;
+};
+
+Registry& registry() {
+    // Never destroyed: locks in other statics may record during exit
+    static Registry* instance = new Registry;
+    return *instance;
+}
+
+} // namespace
+
+LockStats::Site& LockStats::site(const char* name) {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    auto it = r.by_name.find(std::string_view(name));
+    if (it != r.by_name.end()) return *it->second;
+    Site& site = r.sites.emplace_back();
+    site.name = name;
+    r.by_name.emplace(site.name, &site);
+    return site;
+}
+
+std::vector<LockStats::Sample> LockStats::samples() {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    std::vector<Sample> out;
+    out.reserve(r.by_name.size());
+    for (const auto& [name, site] : r.by_name) {
+        out.push_back({name, site->contended.load(std::memory_order_relaxed),
+                       site->wait_ns.load(std::memory_order_relaxed)});
+    }
+    return out;
+}
+
+} // namespace aeronautical
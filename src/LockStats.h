@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace aeronautical {
+
+// Contended acquisitions of the shared caches' and pools' locks, by name.
+// Only an acquisition that finds the lock taken is counted, with the time
+// it waited, so an uncontended lock costs one try_lock more than a plain
+// one and no shared counter is written on the fast path. Several instances
+// of one kind of lock (a pool's per-worker queues, one per zone) add up
+// under one name. Read by bench/scaling_bench and /metrics.
+class LockStats {
+public:
+    struct Site {
+        std::string name;
+        std::atomic<uint64_t> contended{0};
+        std::atomic<uint64_t> wait_ns{0};
+
+        void record(std::chrono::steady_clock::duration waited) {
+            contended.fetch_add(1, std::memory_order_relaxed);
+            wait_ns.fetch_add(static_cast<uint64_t>(std::chrono::nanoseconds(waited).count()),
+                              std::memory_order_relaxed);
+        }
+    };
+
+    struct Sample {
+        std::string name;
+        uint64_t contended = 0;
+        uint64_t wait_ns = 0;
+    };
+
+    // The site of a name, created on first use and never freed
+    static Site& site(const char* name);
+    // Every site so far, by name
+    static std::vector<Sample> samples();
+};
+
+// A mutex that reports contended acquisitions to a LockStats site. It
+// meets Lockable (and SharedLockable when Mutex does), so lock_guard,
+// unique_lock and shared_lock take it as they take Mutex; it does not work
+// with std::condition_variable.
+template <typename Mutex>
+class InstrumentedMutex {
+public:
+    explicit InstrumentedMutex(const char* name) : site_(&LockStats::site(name)) {}
+
+    InstrumentedMutex(const InstrumentedMutex&) = delete;
+    InstrumentedMutex& operator=(const InstrumentedMutex&) = delete;
+
+    void lock() {
+        if (mutex_.try_lock()) return;
+        const auto started = std::chrono::steady_clock::now();
+        mutex_.lock();
+        site_->record(std::chrono::steady_clock::now() - started);
+    }
+    bool try_lock() { return mutex_.try_lock(); }
+    void unlock() { mutex_.unlock(); }
+
+    void lock_shared()
+        requires requires(Mutex& m) { m.lock_shared(); }
+    {
+        if (mutex_.try_lock_shared()) return;
+        const auto started = std::chrono::steady_clock::now();
+        mutex_.lock_shared();
+        site_->record(std::chrono::steady_clock::now() - started);
+    }
+    bool try_lock_shared()
+        requires requires(Mutex& m) { m.try_lock_shared(); }
+    {
+        return mutex_.try_lock_shared();
+    }
+    void unlock_shared()
+        requires requires(Mutex& m) { m.unlock_shared(); }
+    {
+        mutex_.unlock_shared();
+    }
+
+private:
+    Mutex mutex_;
+    LockStats::Site* site_;
+};
+
+} // namespace aeronautical
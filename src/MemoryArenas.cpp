@@ -0,0 +1,200 @@
+#include "MemoryArenas.h"
+#include "CpuAffinity.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cstdint>
+#if defined(HAVE_JEMALLOC)
+#include <jemalloc/jemalloc.h>
+#elif defined(HAVE_MIMALLOC)
+#include <mimalloc.h>
+#elif defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+namespace aeronautical {
+
+namespace {
+
+const char* const kArenaNames[] = {"analysis", "reference", "http"};
+
+#ifdef HAVE_JEMALLOC
+template <typename T>
+T readCtl(const std::string& name) {
+    T value{};
+    size_t size = sizeof(value);
+    if (mallctl(name.c_str(), &value, &size, nullptr, 0) != 0) {
+        return T{};
+    }
+    return value;
+}
+
+// jemalloc's statistics are a snapshot refreshed by bumping the epoch
+void refreshEpoch() {
+    uint64_t epoch = 1;
+    size_t size = sizeof(epoch);
+    mallctl("epoch", &epoch, &size, &epoch, size);
+}
+#endif
+
+} // namespace
+
+MemoryArenas& MemoryArenas::getInstance() {
+    static MemoryArenas instance;
+    return instance;
+}
+
+void MemoryArenas::configure(bool separate) {
+#ifdef HAVE_JEMALLOC
+    if (separate && arenas_.empty()) {
+        auto create = [this](const std::string& name) {
+            unsigned index = 0;
+            size_t size = sizeof(index);
+            if (mallctl("arenas.create", &index, &size, nullptr, 0) != 0) {
+                spdlog::warn("Could not create the jemalloc arena for {}", name);
+                return;
+            }
+            arenas_.push_back(Arena{name, index});
+        };
+        for (const char* name : kArenaNames) {
+            create(name);
+        }
+        for (const auto& node : numaNodes()) {
+            create(nodeArena("analysis", node.id));
+        }
+    }
+#else
+    (void)separate;
+    (void)kArenaNames;
+#endif
+    spdlog::info("Allocator: {} ({} subsystem arenas)", allocator(), arenas_.size());
+}
+
+const char* MemoryArenas::allocator() const {
+#if defined(HAVE_JEMALLOC)
+    return "jemalloc";
+#elif defined(HAVE_MIMALLOC)
+    return "mimalloc";
+#elif defined(__GLIBC__)
+    return "glibc";
+#else
+    return "system";
+#endif
+}
+
+std::vector<std::string> MemoryArenas::arenas() const {
+    std::vector<std::string> names;
+    for (const auto& arena : arenas_) {
+        names.push_back(arena.name);
+    }
+    return names;
+}
+
+int MemoryArenas::bindCurrentThread(const std::string& name) {
+#ifdef HAVE_JEMALLOC
+    for (const auto& arena : arenas_) {
+        if (arena.name != name) continue;
+        unsigned previous = 0;
+        size_t size = sizeof(previous);
+        unsigned index = arena.index;
+        if (mallctl("thread.arena", &previous, &size, &index, sizeof(index)) != 0) {
+            return -1;
+        }
+        return static_cast<int>(previous);
+    }
+#else
+    (void)name;
+#endif
+    return -1;
+}
+
+void MemoryArenas::release() {
+#if defined(HAVE_JEMALLOC)
+    const std::string purge = "arena." + std::to_string(MALLCTL_ARENAS_ALL) + ".purge";
+    mallctl(purge.c_str(), nullptr, nullptr, nullptr, 0);
+#elif defined(HAVE_MIMALLOC)
+    mi_collect(true);
+#elif defined(__GLIBC__)
+    malloc_trim(0);
+#endif
+}
+
+std::string MemoryArenas::nodeArena(const std::string& name, int node) {
+    return name + ".node" + std::to_string(node);
+}
+
+void MemoryArenas::restoreBinding(int previous) {
+#ifdef HAVE_JEMALLOC
+    if (previous < 0) return;
+    unsigned index = static_cast<unsigned>(previous);
+    mallctl("thread.arena", nullptr, nullptr, &index, sizeof(index));
+#else
+    (void)previous;
+#endif
+}
+
+nlohmann::json MemoryArenas::stats() const {
+    nlohmann::json j;
+    j["allocator"] = allocator();
+    j["arenas"] = nlohmann::json::object();
+#if defined(HAVE_JEMALLOC)
+    refreshEpoch();
+    const size_t page = readCtl<size_t>("arenas.page");
+    uint64_t named_allocated = 0;
+    uint64_t named_active = 0;
+    uint64_t named_resident = 0;
+    for (const auto& arena : arenas_) {
+        const std::string prefix = "stats.arenas." + std::to_string(arena.index) + ".";
+        const uint64_t allocated =
+            readCtl<size_t>(prefix + "small.allocated") + readCtl<size_t>(prefix + "large.allocated");
+        const uint64_t active = readCtl<size_t>(prefix + "pactive") * page;
+        const uint64_t resident = readCtl<size_t>(prefix + "resident");
+        named_allocated += allocated;
+        named_active += active;
+        named_resident += resident;
+        j["arenas"][arena.name] = {{"allocated", allocated},
+                                   {"active", active},
+                                   {"resident", resident},
+                                   {"dirty", readCtl<size_t>(prefix + "pdirty") * page},
+                                   {"mapped", readCtl<size_t>(prefix + "mapped")},
+                                   {"threads", readCtl<unsigned>(prefix + "nthreads")}};
+    }
+    const uint64_t allocated = readCtl<size_t>("stats.allocated");
+    const uint64_t active = readCtl<size_t>("stats.active");
+    const uint64_t resident = readCtl<size_t>("stats.resident");
+    if (!arenas_.empty()) {
+        // The automatic arenas, plus metadata counted only in the totals
+        j["arenas"]["other"] = {{"allocated", allocated - std::min(allocated, named_allocated)},
+                                {"active", active - std::min(active, named_active)},
+                                {"resident", resident - std::min(resident, named_resident)}};
+    }
+    j["total"] = {{"allocated", allocated},
+                  {"active", active},
+                  {"resident", resident},
+                  {"mapped", readCtl<size_t>("stats.mapped")},
+                  {"retained", readCtl<size_t>("stats.retained")},
+                  {"metadata", readCtl<size_t>("stats.metadata")}};
+#elif defined(HAVE_MIMALLOC)
+    size_t elapsed = 0, user = 0, system = 0, rss = 0, peak_rss = 0, commit = 0, peak_commit = 0, faults = 0;
+    mi_process_info(&elapsed, &user, &system, &rss, &peak_rss, &commit, &peak_commit, &faults);
+    j["total"] = {{"resident", rss}, {"peak_resident", peak_rss}, {"committed", commit}, {"peak_committed", peak_commit}};
+#elif defined(__GLIBC__) && __GLIBC_PREREQ(2, 33)
+    const struct mallinfo2 info = mallinfo2();
+    j["total"] = {{"allocated", info.uordblks + info.hblkhd},
+                  {"arena", info.arena},       // obtained with brk/sbrk
+                  {"mapped", info.hblkhd},     // in mmapped chunks
+                  {"free", info.fordblks},
+                  {"releasable", info.keepcost}, // at the top of the heap
+                  {"free_chunks", info.ordblks}};
+#else
+    j["total"] = nlohmann::json::object();
+#endif
+    return j;
+}
+
+double MemoryArenas::bytes(const std::string& arena, const std::string& kind) const {
+    const nlohmann::json j = stats();
+    const nlohmann::json& section = arena == "total" ? j["total"] : j["arenas"].value(arena, nlohmann::json::object());
+    return section.contains(kind) ? section[kind].get<double>() : 0.0;
+}
+
+} // namespace aeronautical
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <json.hpp>
+
+namespace aeronautical {
+
+// The allocator the process was linked with (ALLOCATOR=jemalloc|mimalloc in
+// CMake, glibc otherwise) and, with jemalloc, one arena per subsystem:
+// analysis workers, reference data loads and HTTP workers each allocate
+// from their own arena, so the churn of analyses cannot fragment the pages
+// holding the long-lived reference snapshot, and each subsystem's memory
+// can be told apart in /metrics. Threads not bound to an arena use
+// jemalloc's automatic ones, reported as "other". mimalloc already keeps a
+// heap per thread, and glibc cannot bind threads to an arena, so with them
+// binding does nothing and only process totals are reported. On a NUMA
+// machine analysis also gets an arena per node ("analysis.node1"), used by
+// the analysis pool's workers on that node.
+class MemoryArenas {
+public:
+    static MemoryArenas& getInstance();
+
+    MemoryArenas(const MemoryArenas&) = delete;
+    MemoryArenas& operator=(const MemoryArenas&) = delete;
+
+    // Call once at startup, before the pools start; with separate = false
+    // every thread stays on jemalloc's automatic arenas
+    void configure(bool separate);
+
+    const char* allocator() const;
+    // Subsystem arena names, empty unless arenas are in use
+    std::vector<std::string> arenas() const;
+
+    // Binds the calling thread to the named arena; unknown names and
+    // allocators without arenas are ignored. Returns the previous binding
+    // for ArenaScope, or -1 when nothing changed.
+    int bindCurrentThread(const std::string& name);
+    void restoreBinding(int previous);
+
+    // Returns freed pages to the kernel now instead of when the allocator
+    // gets to it, so the resident set drops after caches were trimmed
+    void release();
+
+    // Name of a subsystem's arena for one NUMA node
+    static std::string nodeArena(const std::string& name, int node);
+
+    // {"allocator", "arenas": {name: {allocated, active, resident, ...}}, "total": {...}}
+    nlohmann::json stats() const;
+    // One value of stats(), for /metrics: kind is allocated, active or resident
+    double bytes(const std::string& arena, const std::string& kind) const;
+
+private:
+    MemoryArenas() = default;
+
+    struct Arena {
+        std::string name;
+        unsigned index = 0;
+    };
+    std::vector<Arena> arenas_;
+};
+
+// Binds the current thread to a subsystem arena for its lifetime, e.g.
+// around a reference data load on a thread that serves other work too
+class ArenaScope {
+public:
+    explicit ArenaScope(const std::string& name) : previous_(MemoryArenas::getInstance().bindCurrentThread(name)) {}
+    ~ArenaScope() { MemoryArenas::getInstance().restoreBinding(previous_); }
+
+    ArenaScope(const ArenaScope&) = delete;
+    ArenaScope& operator=(const ArenaScope&) = delete;
+
+private:
+    int previous_;
+};
+
+} // namespace aeronautical
@@ -0,0 +1,222 @@
+#include "MemoryGovernor.h"
+#include "MemoryArenas.h"
+#include "Timestamp.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+namespace aeronautical {
+
+namespace {
+
+// A number from a cgroup file; 0 when missing or "max"
+size_t readBytes(const char* path) {
+    std::ifstream in(path);
+    std::string value;
+    if (!(in >> value) || value == "max") return 0;
+    try {
+        return static_cast<size_t>(std::stoull(value));
+    } catch (const std::exception&) {
+        return 0;
+    }
+}
+
+// A field of memory.stat
+size_t readStat(const char* path, const std::string& field) {
+    std::ifstream in(path);
+    std::string name;
+    size_t value = 0;
+    while (in >> name >> value) {
+        if (name == field) return value;
+    }
+    return 0;
+}
+
+size_t residentBytes() {
+    std::ifstream statm("/proc/self/statm");
+    size_t pages = 0;
+    size_t resident = 0;
+    if (!(statm >> pages >> resident)) return 0;
+    return resident * static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+}
+
+// v1 reports no limit as a number near 2^63
+constexpr size_t kUnlimited = size_t(1) << 60;
+
+} // namespace
+
+MemoryGovernor& MemoryGovernor::getInstance() {
+    static MemoryGovernor instance;
+    return instance;
+}
+
+MemoryGovernor::~MemoryGovernor() {
+    stop();
+}
+
+void MemoryGovernor::add(const std::string& name, Cache cache) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    caches_[name] = Registered{std::move(cache), 0};
+}
+
+void MemoryGovernor::start(const MemorySettings& settings) {
+    std::lock_guard<std::mutex> lock(thread_mutex_);
+    if (thread_.joinable()) {
+        return;
+    }
+    settings_ = settings;
+    stopping_ = false;
+    const Usage now = usage();
+    if (settings_.cache_budget == 0 && now.limit == 0) {
+        spdlog::info("Memory governor off: no cache budget and no memory limit");
+        return;
+    }
+    thread_ = std::thread([this]() { loop(); });
+    spdlog::info("Memory governor: cache budget {}, limit {} ({}), trimming above {:.0f}%",
+                 settings_.cache_budget ? fmt::format("{} MB", settings_.cache_budget >> 20) : "none",
+                 now.limit ? fmt::format("{} MB", now.limit >> 20) : "none", now.source, settings_.high_watermark * 100);
+}
+
+void MemoryGovernor::stop() {
+    {
+        std::lock_guard<std::mutex> lock(thread_mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void MemoryGovernor::loop() {
+    std::unique_lock<std::mutex> lock(thread_mutex_);
+    while (!wake_.wait_for(lock, settings_.interval, [this]() { return stopping_; })) {
+        lock.unlock();
+        try {
+            enforce();
+        } catch (const std::exception& e) {
+            spdlog::error("Memory governor check failed: {}", e.what());
+        }
+        lock.lock();
+    }
+}
+
+MemoryGovernor::Usage MemoryGovernor::usage() const {
+    Usage u;
+    // Working set as the OOM killer sees it: charged memory less the page
+    // cache the kernel can drop
+    if (const size_t current = readBytes("/sys/fs/cgroup/memory.current")) {
+        const size_t inactive = readStat("/sys/fs/cgroup/memory.stat", "inactive_file");
+        u.used = current - std::min(current, inactive);
+        u.limit = readBytes("/sys/fs/cgroup/memory.max");
+        u.source = "cgroup";
+    } else if (const size_t current = readBytes("/sys/fs/cgroup/memory/memory.usage_in_bytes")) {
+        const size_t inactive = readStat("/sys/fs/cgroup/memory/memory.stat", "total_inactive_file");
+        u.used = current - std::min(current, inactive);
+        u.limit = readBytes("/sys/fs/cgroup/memory/memory.limit_in_bytes");
+        if (u.limit >= kUnlimited) u.limit = 0;
+        u.source = "cgroup";
+    } else {
+        u.used = residentBytes();
+        u.source = "rss";
+    }
+    if (settings_.limit > 0 && (u.limit == 0 || settings_.limit < u.limit)) {
+        u.limit = settings_.limit;
+        u.source = "configured";
+        if (u.used == 0) u.used = residentBytes();
+    }
+    return u;
+}
+
+size_t MemoryGovernor::enforce() {
+    const Usage now = usage();
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    std::vector<std::pair<Registered*, size_t>> held;
+    size_t total = 0;
+    for (auto& [name, registered] : caches_) {
+        const size_t bytes = registered.cache.bytes();
+        held.emplace_back(&registered, bytes);
+        total += bytes;
+    }
+
+    size_t need = 0;
+    if (settings_.cache_budget > 0 && total > settings_.cache_budget) {
+        need = total - settings_.cache_budget;
+    }
+    const auto high = static_cast<size_t>(static_cast<double>(now.limit) * settings_.high_watermark);
+    if (now.limit > 0 && now.used > high) {
+        need = std::max(need, now.used - high);
+    }
+    need = std::min(need, total);
+    if (need == 0) {
+        return 0;
+    }
+
+    // Shares in proportion to bytes / cost; a cache that frees less than its
+    // share (entries in use, or smaller than counted) leaves the rest to the
+    // next round
+    size_t freed = 0;
+    for (int round = 0; round < 3 && freed < need; round++) {
+        double weight = 0;
+        for (const auto& [registered, bytes] : held) {
+            weight += static_cast<double>(bytes) / std::max(registered->cache.cost, 0.01);
+        }
+        if (weight <= 0) break;
+        const size_t remaining = need - freed;
+        size_t freed_this_round = 0;
+        for (auto& [registered, bytes] : held) {
+            if (bytes == 0) continue;
+            const double share = static_cast<double>(bytes) / std::max(registered->cache.cost, 0.01) / weight;
+            const size_t cut = std::min(bytes, static_cast<size_t>(static_cast<double>(remaining) * share) + 1);
+            const size_t released = registered->cache.trim(bytes - cut);
+            registered->trimmed += released;
+            bytes -= std::min(bytes, released);
+            freed_this_round += released;
+        }
+        freed += freed_this_round;
+        if (freed_this_round == 0) break;
+    }
+
+    passes_++;
+    trimmed_ += freed;
+    last_trim_ = std::chrono::system_clock::now();
+    MemoryArenas::getInstance().release();
+    spdlog::warn("Memory governor trimmed {} KB of cache (caches {} KB, usage {} MB of {} MB)", freed >> 10, total >> 10,
+                 now.used >> 20, now.limit >> 20);
+    return freed;
+}
+
+nlohmann::json MemoryGovernor::stats() const {
+    const Usage now = usage();
+    std::lock_guard<std::mutex> lock(mutex_);
+    nlohmann::json j;
+    j["cache_budget"] = settings_.cache_budget;
+    j["limit"] = now.limit;
+    j["usage"] = now.used;
+    j["usage_source"] = now.source;
+    j["high_watermark"] = settings_.high_watermark;
+    j["trim_passes"] = passes_;
+    j["trimmed_bytes"] = trimmed_;
+    j["last_trim"] = passes_ ? nlohmann::json(formatTimestamp(last_trim_)) : nlohmann::json(nullptr);
+    size_t total = 0;
+    j["caches"] = nlohmann::json::object();
+    for (const auto& [name, registered] : caches_) {
+        const size_t bytes = registered.cache.bytes();
+        total += bytes;
+        j["caches"][name] = {{"bytes", bytes}, {"cost", registered.cache.cost}, {"trimmed_bytes", registered.trimmed}};
+    }
+    j["cache_bytes"] = total;
+    return j;
+}
+
+double MemoryGovernor::cacheBytes(const std::string& name) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = caches_.find(name);
+    return it == caches_.end() ? 0.0 : static_cast<double>(it->second.cache.bytes());
+}
+
+} // namespace aeronautical
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <json.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace aeronautical {
+
+struct MemorySettings {
+    size_t cache_budget = 0;  // bytes all registered caches may hold together; 0: no shared budget
+    size_t limit = 0;         // memory the process may use; 0: the cgroup's limit, if any
+    double high_watermark = 0.85; // caches are trimmed when usage passes this share of limit
+    std::chrono::milliseconds interval{1000};
+};
+
+// One memory budget for the caches that can give memory back. Each cache
+// keeps its own capacity as a ceiling; the governor checks, every interval,
+// the caches' total against cache_budget and the process's memory against
+// the cgroup limit (memory.current / memory.max, or v1's usage and limit,
+// else the resident set against `limit`). When either is exceeded the
+// caches are trimmed, least recently used entries first, each by a share
+// of the excess in proportion to bytes / cost: a cache whose entries are
+// cheap to rebuild (encoded response bodies) gives up more than one whose
+// entries took an analysis to compute. Freed pages are then returned to
+// the kernel, so a batch re-analysis that grows the heap makes the caches
+// shrink before the cgroup OOM-kills the process.
+class MemoryGovernor {
+public:
+    struct Cache {
+        std::function<size_t()> bytes;
+        // Evicts down to at most target bytes; returns the bytes freed
+        std::function<size_t(size_t target)> trim;
+        double cost = 1.0; // relative cost of refilling a byte
+    };
+
+    static MemoryGovernor& getInstance();
+
+    MemoryGovernor(const MemoryGovernor&) = delete;
+    MemoryGovernor& operator=(const MemoryGovernor&) = delete;
+
+    void add(const std::string& name, Cache cache);
+
+    void start(const MemorySettings& settings);
+    void stop();
+
+    // One check, trimming when over budget or limit; returns the bytes freed
+    size_t enforce();
+
+    // {"cache_budget", "limit", "usage", "caches": {name: {bytes, cost, trimmed_bytes}}, ...}
+    nlohmann::json stats() const;
+    // Bytes a registered cache holds now, for /metrics
+    double cacheBytes(const std::string& name) const;
+
+private:
+    MemoryGovernor() = default;
+    ~MemoryGovernor();
+
+    struct Registered {
+        Cache cache;
+        uint64_t trimmed = 0;
+    };
+
+    // Memory charged to the process and the limit it is held to; limit 0 when unknown
+    struct Usage {
+        size_t used = 0;
+        size_t limit = 0;
+        const char* source = "none";
+    };
+    Usage usage() const;
+
+    void loop();
+
+    MemorySettings settings_;
+    mutable std::mutex mutex_; // caches_, counters; held while trimming
+    std::map<std::string, Registered> caches_;
+    uint64_t passes_ = 0;      // checks that trimmed anything
+    uint64_t trimmed_ = 0;
+    std::chrono::system_clock::time_point last_trim_;
+
+    std::mutex thread_mutex_;
+    std::condition_variable wake_;
+    bool stopping_ = false;
+    std::thread thread_;
+};
+
+} // namespace aeronautical
@@ -0,0 +1,350 @@
+#include "Metrics.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <unistd.h>
+
+namespace aeronautical {
+
+namespace {
+
+// Path segments under these hold a value, whatever it looks like
+bool isParameterParent(const std::string& segment) {
+    static const char* const parents[] = {"airport", "code",  "country", "icao", "import",
+                                          "runways", "tiles", "type",    "usage"};
+    for (const char* parent : parents) {
+        if (segment == parent) return true;
+    }
+    return false;
+}
+
+void appendNumber(std::string& out, double value) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.15g", value);
+    out += buffer;
+}
+
+void appendSample(std::string& out, const std::string& name, const std::string& labels, double value) {
+    out += name;
+    if (!labels.empty()) {
+        out += '{';
+        out += labels;
+        out += '}';
+    }
+    out += ' ';
+    appendNumber(out, value);
+    out += '\n';
+}
+
+void appendHeader(std::string& out, const std::string& name, const std::string& help, const char* type) {
+    out += "# HELP " + name + " " + help + "\n";
+    out += "# TYPE " + name + " " + type + "\n";
+}
+
+std::string escapeLabel(const std::string& value) {
+    std::string escaped;
+    for (char c : value) {
+        if (c == '\\' || c == '"') escaped += '\\';
+        if (c == '\n') {
+            escaped += "\\n";
+            continue;
+        }
+        escaped += c;
+    }
+    return escaped;
+}
+
+// Cumulative histogram lines from per-bucket counts
+template <typename Bounds, typename Counts>
+void appendHistogram(std::string& out, const std::string& name, const std::string& labels, const Bounds& bounds,
+                     const Counts& counts, uint64_t sum_us) {
+    const std::string prefix = labels.empty() ? "" : labels + ",";
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i < bounds.size(); i++) {
+        cumulative += counts[i];
+        char le[32];
+        std::snprintf(le, sizeof(le), "%g", bounds[i]);
+        appendSample(out, name + "_bucket", prefix + "le=\"" + le + "\"", static_cast<double>(cumulative));
+    }
+    cumulative += counts[bounds.size()];
+    appendSample(out, name + "_bucket", prefix + "le=\"+Inf\"", static_cast<double>(cumulative));
+    appendSample(out, name + "_sum", labels, static_cast<double>(sum_us) / 1e6);
+    appendSample(out, name + "_count", labels, static_cast<double>(cumulative));
+}
+
+template <typename Bounds>
+size_t bucketOf(const Bounds& bounds, double seconds) {
+    size_t bucket = 0;
+    while (bucket < bounds.size() && seconds > bounds[bucket]) bucket++;
+    return bucket;
+}
+
+// Resident and virtual size from /proc/self/statm; zeros elsewhere
+std::pair<double, double> processMemory() {
+    std::ifstream statm("/proc/self/statm");
+    double pages_virtual = 0;
+    double pages_resident = 0;
+    if (!(statm >> pages_virtual >> pages_resident)) return {0, 0};
+    const double page = static_cast<double>(sysconf(_SC_PAGESIZE));
+    return {pages_resident * page, pages_virtual * page};
+}
+
+} // namespace
+
+std::string Metrics::foldPath(const std::string& path) {
+    std::string folded;
+    std::string previous;
+    size_t start = 0;
+    const size_t end = std::min(path.find('?'), path.size());
+    while (start < end) {
+        size_t slash = path.find('/', start);
+        if (slash == std::string::npos || slash > end) slash = end;
+        std::string segment = path.substr(start, slash - start);
+        if (!segment.empty()) {
+            bool value = isParameterParent(previous);
+            for (char c : segment) {
+                if ((c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z')) value = true;
+            }
+            folded += '/';
+            folded += value ? "{param}" : segment;
+            previous = std::move(segment);
+        }
+        start = slash + 1;
+    }
+    return folded.empty() ? "/" : folded;
+}
+
+Metrics& Metrics::getInstance() {
+    static Metrics instance;
+    return instance;
+}
+
+Metrics::Metrics() : started_at_(std::chrono::system_clock::now()) {
+    routes_.push_back("other");
+}
+
+Metrics::Shard& Metrics::shard() {
+    thread_local Shard* local = nullptr;
+    if (!local) {
+        auto created = std::make_unique<Shard>();
+        local = created.get();
+        std::lock_guard<std::mutex> lock(mutex_);
+        shards_.push_back(std::move(created));
+    }
+    return *local;
+}
+
+uint16_t Metrics::routeSlot(const std::string& method, const std::string& path) {
+    const std::string key = method + " " + foldPath(path);
+    // Each thread resolves a route once; the shared table is only locked on a miss
+    thread_local std::unordered_map<std::string, uint16_t> cached;
+    if (auto it = cached.find(key); it != cached.end()) return it->second;
+
+    uint16_t slot = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (auto it = route_slots_.find(key); it != route_slots_.end()) {
+            slot = it->second;
+        } else if (routes_.size() < kMaxRoutes) {
+            slot = static_cast<uint16_t>(routes_.size());
+            routes_.push_back(key);
+            route_slots_.emplace(key, slot);
+        }
+    }
+    if (cached.size() < kMaxRoutes * 4) cached.emplace(key, slot);
+    return slot;
+}
+
+void Metrics::requestStarted() {
+    add(shard().started, 1);
+}
+
+void Metrics::requestFinished(uint16_t route, int status, std::chrono::steady_clock::duration elapsed) {
+    Shard& local = shard();
+    RouteCounters& counters = local.routes[route < kMaxRoutes ? route : 0];
+    const double seconds = std::chrono::duration<double>(elapsed).count();
+    const int status_class = std::clamp(status / 100 - 2, 0, 3);
+    add(counters.responses[status_class], 1);
+    add(counters.buckets[bucketOf(kLatencyBounds, seconds)], 1);
+    add(counters.sum_us, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count()));
+    add(local.finished, 1);
+}
+
+void Metrics::requestCost(uint16_t route, uint64_t alloc_bytes, uint64_t allocations, std::chrono::nanoseconds cpu) {
+    RouteCounters& counters = shard().routes[route < kMaxRoutes ? route : 0];
+    add(counters.alloc_bytes, alloc_bytes);
+    add(counters.allocations, allocations);
+    add(counters.cpu_us, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(cpu).count()));
+}
+
+void Metrics::analysisJobFinished(bool failed, std::chrono::steady_clock::duration elapsed) {
+    JobCounters& counters = shard().jobs[failed ? 1 : 0];
+    const double seconds = std::chrono::duration<double>(elapsed).count();
+    add(counters.buckets[bucketOf(kJobBounds, seconds)], 1);
+    add(counters.sum_us, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count()));
+}
+
+void Metrics::expose(const std::string& name, const std::string& help, Kind kind, std::function<double()> read,
+                     const std::string& labels) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& family : families_) {
+        if (family.name == name) {
+            family.samples.push_back(Sample{labels, std::move(read)});
+            return;
+        }
+    }
+    families_.push_back(Family{name, help, kind, {Sample{labels, std::move(read)}}});
+}
+
+void Metrics::exposeLabelled(const std::string& name, const std::string& help, Kind kind, const std::string& label,
+                             LabelledRead read) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& family : families_) {
+        if (family.name == name) {
+            family.samples.push_back(Sample{label, nullptr, std::move(read)});
+            return;
+        }
+    }
+    families_.push_back(Family{name, help, kind, {Sample{label, nullptr, std::move(read)}}});
+}
+
+uint64_t Metrics::inFlight() const {
+    uint64_t started = 0;
+    uint64_t finished = 0;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& shard : shards_) {
+        started += shard->started.load(std::memory_order_relaxed);
+        finished += shard->finished.load(std::memory_order_relaxed);
+    }
+    return started - std::min(started, finished);
+}
+
+std::string Metrics::render() const {
+    // Totals first, so the lock is not held while callbacks run
+    std::vector<std::string> routes;
+    std::vector<std::array<uint64_t, 4>> responses;
+    std::vector<std::array<uint64_t, kLatencyBounds.size() + 1>> latency;
+    std::vector<uint64_t> latency_sum;
+    std::vector<std::array<uint64_t, 3>> cost; // alloc bytes, allocations, CPU us
+    std::array<std::array<uint64_t, kJobBounds.size() + 1>, 2> jobs{};
+    std::array<uint64_t, 2> jobs_sum{};
+    uint64_t started = 0;
+    uint64_t finished = 0;
+    std::vector<Family> families;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        routes = routes_;
+        responses.assign(routes.size(), {});
+        latency.assign(routes.size(), {});
+        latency_sum.assign(routes.size(), 0);
+        cost.assign(routes.size(), {});
+        for (const auto& shard : shards_) {
+            for (size_t r = 0; r < routes.size(); r++) {
+                const RouteCounters& counters = shard->routes[r];
+                for (size_t i = 0; i < 4; i++) responses[r][i] += counters.responses[i].load(std::memory_order_relaxed);
+                for (size_t i = 0; i < latency[r].size(); i++) {
+                    latency[r][i] += counters.buckets[i].load(std::memory_order_relaxed);
+                }
+                latency_sum[r] += counters.sum_us.load(std::memory_order_relaxed);
+                cost[r][0] += counters.alloc_bytes.load(std::memory_order_relaxed);
+                cost[r][1] += counters.allocations.load(std::memory_order_relaxed);
+                cost[r][2] += counters.cpu_us.load(std::memory_order_relaxed);
+            }
+            for (size_t j = 0; j < 2; j++) {
+                for (size_t i = 0; i < jobs[j].size(); i++) {
+                    jobs[j][i] += shard->jobs[j].buckets[i].load(std::memory_order_relaxed);
+                }
+                jobs_sum[j] += shard->jobs[j].sum_us.load(std::memory_order_relaxed);
+            }
+            started += shard->started.load(std::memory_order_relaxed);
+            finished += shard->finished.load(std::memory_order_relaxed);
+        }
+        families = families_;
+    }
+
+    std::string out;
+    out.reserve(16384);
+    static const char* const classes[] = {"2xx", "3xx", "4xx", "5xx"};
+
+    auto routeLabels = [&](size_t r) {
+        const size_t space = routes[r].find(' ');
+        if (space == std::string::npos) return std::string("method=\"\",route=\"") + escapeLabel(routes[r]) + "\"";
+        return "method=\"" + routes[r].substr(0, space) + "\",route=\"" + escapeLabel(routes[r].substr(space + 1)) +
+               "\"";
+    };
+
+    appendHeader(out, "http_requests_total", "HTTP responses by route and status class.", "counter");
+    for (size_t r = 0; r < routes.size(); r++) {
+        for (size_t i = 0; i < 4; i++) {
+            if (responses[r][i] == 0) continue;
+            appendSample(out, "http_requests_total", routeLabels(r) + ",status=\"" + classes[i] + "\"",
+                         static_cast<double>(responses[r][i]));
+        }
+    }
+
+    appendHeader(out, "http_request_duration_seconds", "Time from request parsed to response complete.",
+                 "histogram");
+    for (size_t r = 0; r < routes.size(); r++) {
+        uint64_t count = 0;
+        for (uint64_t c : latency[r]) count += c;
+        if (count == 0) continue;
+        appendHistogram(out, "http_request_duration_seconds", routeLabels(r), kLatencyBounds, latency[r],
+                        latency_sum[r]);
+    }
+
+    // Only routes requests were accounted on; empty unless REQUEST_ACCOUNTING is on
+    static const struct {
+        const char* name;
+        const char* help;
+        double scale;
+    } costs[] = {
+        {"aeronautical_http_request_alloc_bytes_total", "Bytes allocated through operator new by requests.", 1},
+        {"aeronautical_http_request_allocations_total", "Allocations through operator new by requests.", 1},
+        {"aeronautical_http_request_cpu_seconds_total", "CPU time of the threads serving requests.", 1e-6},
+    };
+    for (size_t k = 0; k < 3; k++) {
+        bool header = false;
+        for (size_t r = 0; r < routes.size(); r++) {
+            if (cost[r][k] == 0) continue;
+            if (!header) appendHeader(out, costs[k].name, costs[k].help, "counter");
+            header = true;
+            appendSample(out, costs[k].name, routeLabels(r), static_cast<double>(cost[r][k]) * costs[k].scale);
+        }
+    }
+
+    appendHeader(out, "http_requests_in_flight", "Requests received and not yet answered.", "gauge");
+    appendSample(out, "http_requests_in_flight", "", static_cast<double>(started - std::min(started, finished)));
+
+    appendHeader(out, "aeronautical_analysis_job_duration_seconds", "Run time of finished analysis jobs.",
+                 "histogram");
+    appendHistogram(out, "aeronautical_analysis_job_duration_seconds", "outcome=\"completed\"", kJobBounds, jobs[0],
+                    jobs_sum[0]);
+    appendHistogram(out, "aeronautical_analysis_job_duration_seconds", "outcome=\"failed\"", kJobBounds, jobs[1],
+                    jobs_sum[1]);
+
+    for (const auto& family : families) {
+        appendHeader(out, family.name, family.help, family.kind == Kind::Counter ? "counter" : "gauge");
+        for (const auto& sample : family.samples) {
+            if (!sample.read_labelled) {
+                appendSample(out, family.name, sample.labels, sample.read());
+                continue;
+            }
+            for (const auto& [value, number] : sample.read_labelled()) {
+                appendSample(out, family.name, sample.labels + "=\"" + escapeLabel(value) + "\"", number);
+            }
+        }
+    }
+
+    const auto [resident, virtual_size] = processMemory();
+    appendHeader(out, "process_resident_memory_bytes", "Resident memory size in bytes.", "gauge");
+    appendSample(out, "process_resident_memory_bytes", "", resident);
+    appendHeader(out, "process_virtual_memory_bytes", "Virtual memory size in bytes.", "gauge");
+    appendSample(out, "process_virtual_memory_bytes", "", virtual_size);
+    appendHeader(out, "process_start_time_seconds", "Start time of the process since unix epoch in seconds.",
+                 "gauge");
+    appendSample(out, "process_start_time_seconds", "",
+                 std::chrono::duration<double>(started_at_.time_since_epoch()).count());
+    return out;
+}
+
+} // namespace aeronautical
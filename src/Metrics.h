@@ -0,0 +1,114 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace aeronautical {
+
+// Prometheus metrics of the process, rendered in the text exposition
+// format for GET /metrics. Request and analysis job counters live in one
+// shard per thread that only that thread writes, so recording is a few
+// relaxed stores with no lock or shared cache line; a scrape sums the
+// shards. Gauges and counters owned by other components (pool, queues,
+// caches) are read through callbacks registered with expose().
+class Metrics {
+public:
+    enum class Kind { Counter, Gauge };
+
+    static Metrics& getInstance();
+
+    Metrics(const Metrics&) = delete;
+    Metrics& operator=(const Metrics&) = delete;
+
+    // Route label for a request path and method; ids and codes in the path
+    // are folded so the label set stays small. Returns a slot index.
+    uint16_t routeSlot(const std::string& method, const std::string& path);
+
+    void requestStarted();
+    void requestFinished(uint16_t route, int status, std::chrono::steady_clock::duration elapsed);
+    // What a finished request cost, when RequestMetrics accounts for it
+    void requestCost(uint16_t route, uint64_t alloc_bytes, uint64_t allocations, std::chrono::nanoseconds cpu);
+    void analysisJobFinished(bool failed, std::chrono::steady_clock::duration elapsed);
+    // Requests started and not finished yet
+    uint64_t inFlight() const;
+
+    // Adds a sample read at scrape time; samples sharing a name form one
+    // family. labels is the inside of the braces, e.g. cache="result".
+    void expose(const std::string& name, const std::string& help, Kind kind, std::function<double()> read,
+                const std::string& labels = "");
+    // Adds the samples of a label whose values are known only at scrape
+    // time, e.g. one per organization: read returns (label value, sample)
+    using LabelledRead = std::function<std::vector<std::pair<std::string, double>>()>;
+    void exposeLabelled(const std::string& name, const std::string& help, Kind kind, const std::string& label,
+                        LabelledRead read);
+
+    std::string render() const;
+
+    // Path with ids and codes folded to {param}, e.g. /api/projects/{param}
+    static std::string foldPath(const std::string& path);
+
+private:
+    Metrics();
+
+    static constexpr size_t kMaxRoutes = 128; // slot 0 collects everything past the cap
+    static constexpr std::array<double, 11> kLatencyBounds{0.005, 0.01, 0.025, 0.05, 0.1, 0.25,
+                                                             0.5,   1,    2.5,   5,    10};
+    static constexpr std::array<double, 11> kJobBounds{0.1, 0.5, 1, 2.5, 5, 10, 30, 60, 120, 300, 600};
+
+    // Written by the owning thread only; stores need no read-modify-write
+    using Cell = std::atomic<uint64_t>;
+    static void add(Cell& cell, uint64_t value) {
+        cell.store(cell.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    struct RouteCounters {
+        std::array<Cell, 4> responses{}; // 2xx..5xx, anything below 200 as 2xx
+        std::array<Cell, kLatencyBounds.size() + 1> buckets{};
+        Cell sum_us{0};
+        Cell alloc_bytes{0};
+        Cell allocations{0};
+        Cell cpu_us{0};
+    };
+    struct JobCounters {
+        std::array<Cell, kJobBounds.size() + 1> buckets{};
+        Cell sum_us{0};
+    };
+    struct Shard {
+        std::array<RouteCounters, kMaxRoutes> routes;
+        std::array<JobCounters, 2> jobs; // completed, failed
+        Cell started{0};
+        Cell finished{0};
+    };
+    Shard& shard();
+
+    struct Sample {
+        std::string labels;
+        std::function<double()> read;
+        LabelledRead read_labelled{}; // instead of read: labels names the label
+    };
+    struct Family {
+        std::string name;
+        std::string help;
+        Kind kind;
+        std::vector<Sample> samples;
+    };
+
+    mutable std::mutex mutex_;
+    // Shards outlive their threads, so totals never go backwards
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::vector<std::string> routes_; // "method path" by slot
+    std::unordered_map<std::string, uint16_t> route_slots_;
+    std::vector<Family> families_;
+    std::chrono::system_clock::time_point started_at_;
+};
+
+} // namespace aeronautical
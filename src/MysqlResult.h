@@ -0,0 +1,17 @@
+#pragma once
+
+#include <memory>
+#include <mysql/mysql.h>
+
+namespace aeronautical {
+
+struct MysqlResultDeleter {
+    void operator()(MYSQL_RES* result) const { mysql_free_result(result); }
+};
+
+// Owns a result set from mysql_store_result / mysql_use_result and frees it on
+// every path out, early returns and exceptions included. Pass .get() to the
+// mysql_fetch_* calls.
+using MysqlResult = std::unique_ptr<MYSQL_RES, MysqlResultDeleter>;
+
+} // namespace aeronautical
@@ -0,0 +1,344 @@
+#include "ObstacleSurfaces.h"
+#include "ogr_geometry.h"
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <tuple>
+#include <utility>
+
+namespace aeronautical {
+
+namespace {
+
+constexpr double kMetresPerDegree = 111320.0;
+constexpr double kMetresPerFoot = 0.3048;
+constexpr int kArcSegments = 16; // per half circle of the inner horizontal surface
+
+// Annex 14 tables 4-1 and 4-2 for one aerodrome code number
+struct SurfaceParameters {
+    double strip_half_width;
+    double strip_extension;
+    double approach_inner_edge;
+    double approach_offset;
+    double approach_divergence;
+    double approach_first_length;
+    double approach_first_slope;
+    double approach_second_length; // 0 when the first section is the only sloped one
+    double approach_second_slope;
+    double approach_total_length;
+    double takeoff_inner_edge;
+    double takeoff_offset;
+    double takeoff_divergence;
+    double takeoff_final_width;
+    double takeoff_length;
+    double takeoff_slope;
+    double transitional_slope;
+    double inner_horizontal_height;
+    double inner_horizontal_radius;
+};
+
+constexpr SurfaceParameters kCode1{70, 30, 140, 60, 0.15, 2500, 0.0333, 0, 0, 2500,
+                                   60, 30, 0.10, 380, 1600, 0.05, 0.20, 45, 3500};
+constexpr SurfaceParameters kCode2{70, 60, 140, 60, 0.15, 2500, 0.0333, 0, 0, 2500,
+                                   80, 60, 0.10, 580, 2500, 0.04, 0.20, 45, 3500};
+constexpr SurfaceParameters kCode34{140, 60, 280, 60, 0.15, 3000, 0.02, 3600, 0.025, 15000,
+                                    180, 60, 0.125, 1200, 15000, 0.02, 0.143, 45, 4000};
+
+// Code number from the reference field length, approximated by the runway length
+const SurfaceParameters& parametersFor(double length_m) {
+    if (length_m >= 1200) return kCode34;
+    if (length_m >= 800) return kCode2;
+    return kCode1;
+}
+
+struct Vec {
+    double x = 0;
+    double y = 0;
+};
+
+Vec operator+(Vec a, Vec b) { return {a.x + b.x, a.y + b.y}; }
+Vec operator-(Vec a, Vec b) { return {a.x - b.x, a.y - b.y}; }
+Vec operator*(Vec a, double s) { return {a.x * s, a.y * s}; }
+double dot(Vec a, Vec b) { return a.x * b.x + a.y * b.y; }
+
+class FacetBuilder {
+public:
+    explicit FacetBuilder(AirportSurfaces& surfaces) : surfaces_(surfaces) {}
+
+    // Plane rising at slope along direction from origin, at base height there
+    void add(SurfaceKind kind, const std::string& runway, const std::vector<Vec>& vertices, Vec origin, Vec direction,
+             double slope, double base) {
+        SurfaceFacet facet;
+        facet.kind = kind;
+        facet.runway = runway;
+        double area = 0;
+        for (size_t i = 0; i < vertices.size(); i++) {
+            const Vec& a = vertices[i];
+            const Vec& b = vertices[(i + 1) % vertices.size()];
+            area += a.x * b.y - b.x * a.y;
+        }
+        for (const auto& vertex : vertices) {
+            facet.x.push_back(vertex.x);
+            facet.y.push_back(vertex.y);
+        }
+        if (area < 0) {
+            std::reverse(facet.x.begin(), facet.x.end());
+            std::reverse(facet.y.begin(), facet.y.end());
+        }
+        facet.min_x = *std::min_element(facet.x.begin(), facet.x.end());
+        facet.max_x = *std::max_element(facet.x.begin(), facet.x.end());
+        facet.min_y = *std::min_element(facet.y.begin(), facet.y.end());
+        facet.max_y = *std::max_element(facet.y.begin(), facet.y.end());
+        facet.slope_x = slope * direction.x;
+        facet.slope_y = slope * direction.y;
+        facet.height = base - slope * dot(origin, direction);
+        surfaces_.facets.push_back(std::move(facet));
+    }
+
+    // Trapezoid from half width w0 at centre c to w1 at c + length * d
+    void addTrapezoid(SurfaceKind kind, const std::string& runway, Vec c, Vec d, double w0, double w1, double length,
+                      double slope, double base) {
+        const Vec n{-d.y, d.x};
+        const Vec far = c + d * length;
+        add(kind, runway, {c - n * w0, far - n * w1, far + n * w1, c + n * w0}, c, d, slope, base);
+    }
+
+private:
+    AirportSurfaces& surfaces_;
+};
+
+} // namespace
+
+std::string surfaceKindToString(SurfaceKind kind) {
+    switch (kind) {
+        case SurfaceKind::Strip: return "strip";
+        case SurfaceKind::Approach: return "approach";
+        case SurfaceKind::TakeOffClimb: return "take_off_climb";
+        case SurfaceKind::Transitional: return "transitional";
+        case SurfaceKind::InnerHorizontal: return "inner_horizontal";
+        default: return "strip";
+    }
+}
+
+bool SurfaceFacet::contains(double px, double py) const {
+    if (px < min_x || px > max_x || py < min_y || py > max_y) {
+        return false;
+    }
+    const size_t n = x.size();
+    for (size_t i = 0; i < n; i++) {
+        const size_t j = (i + 1) % n;
+        if ((x[j] - x[i]) * (py - y[i]) - (y[j] - y[i]) * (px - x[i]) < 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+AirportSurfaces AirportSurfaces::build(const Airport& airport, std::span<const AirportRunway> runways) {
+    AirportSurfaces surfaces;
+    surfaces.airport_id = airport.id;
+    surfaces.icao_code = airport.icao_code;
+    surfaces.ref_lat = airport.latitude;
+    surfaces.ref_lng = airport.longitude;
+    surfaces.elevation_m = airport.elevation_ft * kMetresPerFoot;
+
+    const double metres_x = kMetresPerDegree * std::cos(airport.latitude * M_PI / 180.0);
+    auto local = [&](double lat, double lng) {
+        return Vec{(lng - airport.longitude) * metres_x, (lat - airport.latitude) * kMetresPerDegree};
+    };
+
+    FacetBuilder builder(surfaces);
+    const double elevation = surfaces.elevation_m;
+    for (const auto& runway : runways) {
+        if (!runway.is_active) continue;
+
+        // Ends from their coordinates, or the low end and heading when the
+        // high end is missing
+        const Vec low = local(runway.le_latitude, runway.le_longitude);
+        Vec high = local(runway.he_latitude, runway.he_longitude);
+        double length = std::hypot(high.x - low.x, high.y - low.y);
+        if ((runway.he_latitude == 0 && runway.he_longitude == 0) || length < 1) {
+            length = runway.length_ft * kMetresPerFoot;
+            const double heading = runway.le_heading_deg * M_PI / 180.0;
+            high = low + Vec{std::sin(heading), std::cos(heading)} * length;
+        }
+        if ((runway.le_latitude == 0 && runway.le_longitude == 0) || length < 1) continue;
+
+        const Vec u = (high - low) * (1 / length);
+        const Vec n{-u.y, u.x};
+        const auto& p = parametersFor(length);
+
+        // Strip, flat at the runway
+        const Vec strip_low = low - u * p.strip_extension;
+        const Vec strip_high = high + u * p.strip_extension;
+        const double strip_length = length + 2 * p.strip_extension;
+        builder.addTrapezoid(SurfaceKind::Strip, runway.runway_identifier, strip_low, u, p.strip_half_width,
+                             p.strip_half_width, strip_length, 0, elevation);
+
+        // Transitional, from the strip edges up to the inner horizontal surface
+        const double transitional_width = p.inner_horizontal_height / p.transitional_slope;
+        for (double side : {1.0, -1.0}) {
+            const Vec edge = n * (side * p.strip_half_width);
+            const Vec outer = n * (side * (p.strip_half_width + transitional_width));
+            builder.add(SurfaceKind::Transitional, runway.runway_identifier,
+                        {strip_low + edge, strip_high + edge, strip_high + outer, strip_low + outer},
+                        strip_low + edge, n * side, p.transitional_slope, elevation);
+        }
+
+        // Approach and take-off climb leave each end outwards
+        const bool ils = airport.has_ils && &p == &kCode34;
+        const double approach_inner = ils ? 300 : p.approach_inner_edge;
+        for (const auto& [end, outward, ident] : {std::tuple{low, u * -1, runway.le_ident},
+                                                  std::tuple{high, u, runway.he_ident}}) {
+            const std::string name = runway.runway_identifier + " " + ident;
+
+            Vec c = end + outward * p.approach_offset;
+            double width = approach_inner / 2;
+            double base = elevation;
+            for (const auto& [section, slope] : {std::pair{p.approach_first_length, p.approach_first_slope},
+                                                 std::pair{p.approach_second_length, p.approach_second_slope},
+                                                 std::pair{p.approach_total_length - p.approach_first_length -
+                                                               p.approach_second_length, 0.0}}) {
+                if (section <= 0) continue;
+                const double next_width = width + p.approach_divergence * section;
+                builder.addTrapezoid(SurfaceKind::Approach, name, c, outward, width, next_width, section, slope, base);
+                c = c + outward * section;
+                width = next_width;
+                base += slope * section;
+            }
+
+            const Vec t = end + outward * p.takeoff_offset;
+            const double t0 = p.takeoff_inner_edge / 2;
+            const double spread = std::min(p.takeoff_length, (p.takeoff_final_width / 2 - t0) / p.takeoff_divergence);
+            const double t1 = t0 + p.takeoff_divergence * spread;
+            builder.addTrapezoid(SurfaceKind::TakeOffClimb, name, t, outward, t0, t1, spread, p.takeoff_slope, elevation);
+            if (spread < p.takeoff_length) {
+                builder.addTrapezoid(SurfaceKind::TakeOffClimb, name, t + outward * spread, outward, t1, t1,
+                                     p.takeoff_length - spread, p.takeoff_slope, elevation + p.takeoff_slope * spread);
+            }
+        }
+
+        // Inner horizontal: circles around both ends joined by their tangents
+        std::vector<Vec> ring;
+        for (int i = 0; i <= 2 * kArcSegments + 1; i++) {
+            const bool high_side = i <= kArcSegments;
+            const double angle = M_PI * ((high_side ? i : i - 1) / static_cast<double>(kArcSegments) - 0.5);
+            ring.push_back((high_side ? high : low) + (u * std::cos(angle) + n * std::sin(angle)) * p.inner_horizontal_radius);
+        }
+        builder.add(SurfaceKind::InnerHorizontal, runway.runway_identifier, ring, low, u, 0,
+                    elevation + p.inner_horizontal_height);
+    }
+
+    surfaces.envelope = OGREnvelope();
+    for (const auto& facet : surfaces.facets) {
+        OGREnvelope box;
+        box.MinX = airport.longitude + facet.min_x / metres_x;
+        box.MaxX = airport.longitude + facet.max_x / metres_x;
+        box.MinY = airport.latitude + facet.min_y / kMetresPerDegree;
+        box.MaxY = airport.latitude + facet.max_y / kMetresPerDegree;
+        surfaces.envelope.Merge(box);
+    }
+    return surfaces;
+}
+
+const SurfaceFacet* AirportSurfaces::limitAt(double lng, double lat, double* height_m) const {
+    const double x = (lng - ref_lng) * kMetresPerDegree * std::cos(ref_lat * M_PI / 180.0);
+    const double y = (lat - ref_lat) * kMetresPerDegree;
+    const SurfaceFacet* lowest = nullptr;
+    double lowest_height = 0;
+    for (const auto& facet : facets) {
+        if (!facet.contains(x, y)) continue;
+        const double height = facet.heightAt(x, y);
+        if (!lowest || height < lowest_height) {
+            lowest = &facet;
+            lowest_height = height;
+        }
+    }
+    if (lowest && height_m) *height_m = lowest_height;
+    return lowest;
+}
+
+void AirportSurfaces::check(const OGRGeometry& feature, size_t feature_index, double top_m,
+                            std::vector<SurfacePenetration>& out) const {
+    OGREnvelope feature_envelope;
+    feature.getEnvelope(&feature_envelope);
+    if (!feature_envelope.Intersects(envelope)) {
+        return;
+    }
+
+    std::map<const SurfaceFacet*, SurfacePenetration> worst;
+    auto vertex = [&](double lng, double lat) {
+        double limit = 0;
+        const SurfaceFacet* facet = limitAt(lng, lat, &limit);
+        if (!facet || top_m <= limit) return;
+        auto& entry = worst[facet];
+        if (!entry.facet || top_m - limit > entry.penetration_m) {
+            entry = {feature_index, facet, lng, lat, limit, top_m - limit};
+        }
+    };
+    auto visit = [&](const OGRGeometry& geometry, auto& self) -> void {
+        switch (wkbFlatten(geometry.getGeometryType())) {
+            case wkbPoint: {
+                const auto* point = geometry.toPoint();
+                if (!point->IsEmpty()) vertex(point->getX(), point->getY());
+                break;
+            }
+            case wkbLineString:
+            case wkbLinearRing: {
+                const auto* line = geometry.toLineString();
+                for (int i = 0; i < line->getNumPoints(); i++) vertex(line->getX(i), line->getY(i));
+                break;
+            }
+            case wkbPolygon:
+                for (const auto* ring : *geometry.toPolygon()) self(*ring, self);
+                break;
+            case wkbMultiPoint:
+            case wkbMultiLineString:
+            case wkbMultiPolygon:
+            case wkbGeometryCollection: {
+                const auto* collection = geometry.toGeometryCollection();
+                for (int i = 0; i < collection->getNumGeometries(); i++) self(*collection->getGeometryRef(i), self);
+                break;
+            }
+            default:
+                break;
+        }
+    };
+    visit(feature, visit);
+
+    for (const auto& entry : worst) {
+        out.push_back(entry.second);
+    }
+}
+
+ObstacleSurfaceCache& ObstacleSurfaceCache::getInstance() {
+    static ObstacleSurfaceCache instance;
+    return instance;
+}
+
+std::shared_ptr<const AirportSurfaces> ObstacleSurfaceCache::get(uint64_t snapshot_version, const Airport& airport,
+                                                                 std::span<const AirportRunway> runways) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (version_ != snapshot_version) {
+            surfaces_.clear();
+            version_ = snapshot_version;
+        }
+        auto it = surfaces_.find(airport.id);
+        if (it != surfaces_.end()) {
+            return it->second;
+        }
+    }
+
+    // Built outside the lock; a concurrent build of the same airport is equal
+    auto built = std::make_shared<AirportSurfaces>(AirportSurfaces::build(airport, runways));
+    std::shared_ptr<const AirportSurfaces> surfaces = built->facets.empty() ? nullptr : std::move(built);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (version_ == snapshot_version) {
+        surfaces_.emplace(airport.id, surfaces);
+    }
+    return surfaces;
+}
+
+} // namespace aeronautical
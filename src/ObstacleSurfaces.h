@@ -0,0 +1,102 @@
+#pragma once
+
+#include "Airport.h"
+#include "ogr_core.h"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class OGRGeometry;
+
+namespace aeronautical {
+
+enum class SurfaceKind { Strip, Approach, TakeOffClimb, Transitional, InnerHorizontal };
+
+std::string surfaceKindToString(SurfaceKind kind);
+
+// One plane of an obstacle limitation surface over a convex footprint.
+// Coordinates are metres east and north of the airport reference point,
+// heights metres above mean sea level.
+struct SurfaceFacet {
+    SurfaceKind kind = SurfaceKind::Strip;
+    std::string runway; // runway_identifier, and the end ident for approach and take-off
+    std::vector<double> x; // counter-clockwise vertices
+    std::vector<double> y;
+    double height = 0; // at the reference point
+    double slope_x = 0;
+    double slope_y = 0;
+    double min_x = 0, min_y = 0, max_x = 0, max_y = 0;
+
+    bool contains(double px, double py) const;
+    double heightAt(double px, double py) const { return height + slope_x * px + slope_y * py; }
+};
+
+// Worst vertex of one project feature above one facet
+struct SurfacePenetration {
+    size_t feature = 0;
+    const SurfaceFacet* facet = nullptr;
+    double lng = 0;
+    double lat = 0;
+    double limit_m = 0; // surface height at the vertex, MSL
+    double penetration_m = 0;
+};
+
+// Annex 14 obstacle limitation surfaces of one airport, derived from its
+// runways as piecewise-planar facets: runway strip, approach (sloped
+// sections then horizontal), take-off climb, transitional along the strip
+// sides, and inner horizontal. Dimensions follow the aerodrome code number
+// from the runway length, with non-precision approach values (precision
+// inner edge with ILS). Runway ends are taken at the airport elevation.
+// Positions use an equirectangular frame at the reference point, which is
+// well within a metre over the 15 km the surfaces reach.
+struct AirportSurfaces {
+    int airport_id = 0;
+    std::string icao_code;
+    double ref_lat = 0;
+    double ref_lng = 0;
+    double elevation_m = 0;
+    std::vector<SurfaceFacet> facets;
+    OGREnvelope envelope; // degrees
+
+    static AirportSurfaces build(const Airport& airport, std::span<const AirportRunway> runways);
+
+    // Lowest facet over a position, nullptr outside every surface
+    const SurfaceFacet* limitAt(double lng, double lat, double* height_m) const;
+
+    // Vertices of feature whose top (m MSL) exceeds the surface over them,
+    // the worst one per facet
+    void check(const OGRGeometry& feature, size_t feature_index, double top_m,
+               std::vector<SurfacePenetration>& out) const;
+};
+
+// Process-wide AirportSurfaces by airport, built on first use and kept
+// while the reference snapshot version they came from is current, so
+// every project check reuses them.
+class ObstacleSurfaceCache {
+public:
+    static ObstacleSurfaceCache& getInstance();
+
+    ObstacleSurfaceCache(const ObstacleSurfaceCache&) = delete;
+    ObstacleSurfaceCache& operator=(const ObstacleSurfaceCache&) = delete;
+
+    // Farthest a surface reaches from its airport reference point, in km,
+    // for the longest runways; used to find the airports near a project
+    static constexpr double kReachKm = 22.0;
+
+    // nullptr for an airport without usable runways
+    std::shared_ptr<const AirportSurfaces> get(uint64_t snapshot_version, const Airport& airport,
+                                               std::span<const AirportRunway> runways);
+
+private:
+    ObstacleSurfaceCache() = default;
+
+    std::mutex mutex_;
+    uint64_t version_ = 0;
+    std::unordered_map<int, std::shared_ptr<const AirportSurfaces>> surfaces_;
+};
+
+} // namespace aeronautical
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "cpl_conv.h"
+#include "ogr_api.h"
+#include "ogr_geometry.h"
+#include <memory>
+#include <string>
+#include <type_traits>
+
+namespace aeronautical {
+
+// Move-only owners for what the GDAL C API hands out, so each geometry or
+// buffer is freed exactly once on every path and code that used to copy a
+// geometry "to be safe" can take it over instead.
+
+struct GeometryHandleDeleter {
+    void operator()(OGRGeometryH geometry) const { OGR_G_DestroyGeometry(geometry); }
+};
+
+// An OGRGeometryH from OGR_G_Intersection, a parser, etc.
+using GeometryHandle = std::unique_ptr<std::remove_pointer_t<OGRGeometryH>, GeometryHandleDeleter>;
+
+inline GeometryHandle toHandle(std::unique_ptr<OGRGeometry> geometry) {
+    return GeometryHandle((OGRGeometryH)geometry.release());
+}
+
+inline OGRGeometry* geometryOf(const GeometryHandle& handle) {
+    return (OGRGeometry*)handle.get();
+}
+
+struct CplFreeDeleter {
+    void operator()(char* text) const { CPLFree(text); }
+};
+
+// A string the C API allocates with CPLMalloc, e.g. from OGR_G_ExportToJson
+using CplString = std::unique_ptr<char, CplFreeDeleter>;
+
+// GeoJSON text of a geometry; empty when it cannot be exported
+inline std::string exportJson(OGRGeometryH geometry) {
+    CplString json(OGR_G_ExportToJson(geometry));
+    return json ? std::string(json.get()) : std::string();
+}
+
+} // namespace aeronautical
@@ -0,0 +1,253 @@
+#include "PdfWriter.h"
+#include <zlib.h>
+#include <cstdio>
+#include <stdexcept>
+
+namespace aeronautical {
+
+namespace {
+
+// Helvetica advance widths of ' ' .. '~' in 1/1000 em (Adobe AFM)
+constexpr short kHelvetica[95] = {
+    278, 278, 355, 556, 556, 889, 667, 191, 333, 333, 389, 584, 278, 333, 278, 278,  // ' ' .. '/'
+    556, 556, 556, 556, 556, 556, 556, 556, 556, 556, 278, 278, 584, 584, 584, 556,  // '0' .. '?'
+    1015, 667, 667, 722, 722, 667, 611, 778, 722, 278, 500, 667, 556, 833, 722, 778, // '@' .. 'O'
+    667, 778, 722, 667, 611, 722, 667, 944, 667, 667, 611, 278, 278, 278, 469, 556,  // 'P' .. '_'
+    333, 556, 556, 500, 556, 556, 278, 556, 556, 222, 222, 500, 222, 833, 556, 556,  // '`' .. 'o'
+    556, 556, 333, 500, 278, 556, 500, 722, 500, 500, 500, 334, 260, 334, 584};      // 'p' .. '~'
+// Helvetica-Bold runs about this much wider
+constexpr double kBoldFactor = 1.08;
+
+// WinAnsi bytes of UTF-8 text: U+00A0..U+00FF map to themselves
+std::string winAnsi(std::string_view utf8) {
+    std::string out;
+    out.reserve(utf8.size());
+    for (size_t i = 0; i < utf8.size(); i++) {
+        const auto c = static_cast<unsigned char>(utf8[i]);
+        if (c < 0x80) {
+            out += (c < 0x20) ? ' ' : static_cast<char>(c);
+        } else if ((c == 0xC2 || c == 0xC3) && i + 1 < utf8.size()) {
+            out += static_cast<char>(((c & 0x03) << 6) | (static_cast<unsigned char>(utf8[++i]) & 0x3F));
+        } else if (c >= 0xC0) {
+            // Skips the continuation bytes of a character WinAnsi lacks
+            while (i + 1 < utf8.size() && (static_cast<unsigned char>(utf8[i + 1]) & 0xC0) == 0x80) i++;
+            out += '?';
+        }
+    }
+    return out;
+}
+
+double charWidth(unsigned char c) {
+    return (c >= 0x20 && c <= 0x7E) ? kHelvetica[c - 0x20] : 556;
+}
+
+std::string number(double value) {
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.2f", value);
+    return text;
+}
+
+} // namespace
+
+PdfWriter::PdfWriter(const std::string& path) : out_(path, std::ios::binary | std::ios::trunc) {
+    if (!out_) {
+        throw std::runtime_error("Cannot create " + path);
+    }
+    // The binary comment marks the file as 8-bit for transfer tools
+    write("%PDF-1.4\n%\xE2\xE3\xCF\xD3\n");
+    offsets_.resize(kBoldFont);
+    beginObject(kFont);
+    write("<< /Type /Font /Subtype /Type1 /BaseFont /Helvetica /Encoding /WinAnsiEncoding >>\n");
+    endObject();
+    beginObject(kBoldFont);
+    write("<< /Type /Font /Subtype /Type1 /BaseFont /Helvetica-Bold /Encoding /WinAnsiEncoding >>\n");
+    endObject();
+}
+
+int PdfWriter::reserve() {
+    offsets_.push_back(0);
+    return static_cast<int>(offsets_.size());
+}
+
+void PdfWriter::beginObject(int id) {
+    offsets_[id - 1] = offset_;
+    write(std::to_string(id) + " 0 obj\n");
+}
+
+void PdfWriter::endObject() {
+    write("endobj\n");
+}
+
+void PdfWriter::write(std::string_view bytes) {
+    out_.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    if (!out_) {
+        throw std::runtime_error("Writing the PDF failed");
+    }
+    offset_ += bytes.size();
+}
+
+int PdfWriter::addJpeg(const std::string& jpeg, int width, int height) {
+    const int id = reserve();
+    beginObject(id);
+    write("<< /Type /XObject /Subtype /Image /Width " + std::to_string(width) + " /Height " +
+          std::to_string(height) + " /ColorSpace /DeviceRGB /BitsPerComponent 8 /Filter /DCTDecode /Length " +
+          std::to_string(jpeg.size()) + " >>\nstream\n");
+    write(jpeg);
+    write("\nendstream\n");
+    endObject();
+    images_.push_back(id);
+    return static_cast<int>(images_.size()) - 1;
+}
+
+void PdfWriter::beginPage() {
+    if (in_page_) endPage();
+    content_.clear();
+    in_page_ = true;
+}
+
+void PdfWriter::text(double x, double y, double size, bool bold, std::string_view utf8) {
+    std::string escaped;
+    for (char c : winAnsi(utf8)) {
+        if (c == '(' || c == ')' || c == '\\') escaped += '\\';
+        escaped += c;
+    }
+    content_ += "BT /" + std::string(bold ? "F2 " : "F1 ") + number(size) + " Tf " + number(x) + " " + number(y) +
+                " Td (" + escaped + ") Tj ET\n";
+}
+
+void PdfWriter::line(double x1, double y1, double x2, double y2, double width) {
+    content_ += number(width) + " w " + number(x1) + " " + number(y1) + " m " + number(x2) + " " + number(y2) +
+                " l S\n";
+}
+
+void PdfWriter::fillRect(double x, double y, double width, double height, double grey) {
+    content_ += "q " + number(grey) + " g " + number(x) + " " + number(y) + " " + number(width) + " " +
+                number(height) + " re f Q\n";
+}
+
+void PdfWriter::fillRect(double x, double y, double width, double height, double r, double g, double b) {
+    content_ += "q " + number(r) + " " + number(g) + " " + number(b) + " rg " + number(x) + " " + number(y) + " " +
+                number(width) + " " + number(height) + " re f Q\n";
+}
+
+void PdfWriter::image(int image, double x, double y, double width, double height) {
+    content_ += "q " + number(width) + " 0 0 " + number(height) + " " + number(x) + " " + number(y) + " cm /Im" +
+                std::to_string(image) + " Do Q\n";
+}
+
+void PdfWriter::endPage() {
+    if (!in_page_) return;
+    in_page_ = false;
+
+    uLongf size = compressBound(static_cast<uLong>(content_.size()));
+    std::string deflated(size, '\0');
+    if (compress2(reinterpret_cast<Bytef*>(deflated.data()), &size, reinterpret_cast<const Bytef*>(content_.data()),
+                  static_cast<uLong>(content_.size()), Z_DEFAULT_COMPRESSION) != Z_OK) {
+        throw std::runtime_error("Compressing a PDF page failed");
+    }
+    deflated.resize(size);
+
+    const int contents = reserve();
+    beginObject(contents);
+    write("<< /Length " + std::to_string(deflated.size()) + " /Filter /FlateDecode >>\nstream\n");
+    write(deflated);
+    write("\nendstream\n");
+    endObject();
+
+    std::string xobjects;
+    for (size_t i = 0; i < images_.size(); i++) {
+        xobjects += "/Im" + std::to_string(i) + " " + std::to_string(images_[i]) + " 0 R ";
+    }
+    const int page = reserve();
+    beginObject(page);
+    write("<< /Type /Page /Parent " + std::to_string(kPages) + " 0 R /MediaBox [0 0 " + number(kPageWidth) + " " +
+          number(kPageHeight) + "] /Resources << /Font << /F1 " + std::to_string(kFont) + " 0 R /F2 " +
+          std::to_string(kBoldFont) + " 0 R >> /XObject << " + xobjects + ">> >> /Contents " +
+          std::to_string(contents) + " 0 R >>\n");
+    endObject();
+    pages_.push_back(page);
+    content_.clear();
+    content_.shrink_to_fit();
+}
+
+size_t PdfWriter::finish() {
+    endPage();
+    if (pages_.empty()) {
+        beginPage();
+        endPage();
+    }
+
+    std::string kids;
+    for (int page : pages_) {
+        kids += std::to_string(page) + " 0 R ";
+    }
+    beginObject(kPages);
+    write("<< /Type /Pages /Kids [" + kids + "] /Count " + std::to_string(pages_.size()) + " >>\n");
+    endObject();
+    beginObject(kCatalog);
+    write("<< /Type /Catalog /Pages " + std::to_string(kPages) + " 0 R >>\n");
+    endObject();
+
+    const size_t xref = offset_;
+    write("xref\n0 " + std::to_string(offsets_.size() + 1) + "\n0000000000 65535 f \n");
+    for (size_t offset : offsets_) {
+        char entry[24];
+        std::snprintf(entry, sizeof(entry), "%010zu 00000 n \n", offset);
+        write(entry);
+    }
+    write("trailer\n<< /Size " + std::to_string(offsets_.size() + 1) + " /Root " + std::to_string(kCatalog) +
+          " 0 R >>\nstartxref\n" + std::to_string(xref) + "\n%%EOF\n");
+    out_.close();
+    if (!out_) {
+        throw std::runtime_error("Closing the PDF failed");
+    }
+    return offset_;
+}
+
+double PdfWriter::textWidth(std::string_view utf8, double size, bool bold) {
+    double width = 0;
+    for (char c : winAnsi(utf8)) {
+        width += charWidth(static_cast<unsigned char>(c));
+    }
+    return width * size / 1000.0 * (bold ? kBoldFactor : 1.0);
+}
+
+std::vector<std::string> PdfWriter::wrap(std::string_view utf8, double size, bool bold, double width) {
+    std::vector<std::string> lines;
+    std::string current;
+    auto fits = [&](const std::string& text) { return textWidth(text, size, bold) <= width; };
+    size_t start = 0;
+    while (start <= utf8.size()) {
+        size_t end = utf8.find_first_of(" \n", start);
+        if (end == std::string_view::npos) end = utf8.size();
+        std::string word(utf8.substr(start, end - start));
+        const bool newline = end < utf8.size() && utf8[end] == '\n';
+
+        std::string candidate = current.empty() ? word : current + " " + word;
+        if (fits(candidate)) {
+            current = std::move(candidate);
+        } else {
+            if (!current.empty()) lines.push_back(std::move(current));
+            current.clear();
+            // Cut at a character boundary until the rest fits
+            while (!fits(word)) {
+                size_t cut = word.size();
+                while (cut > 1 && !fits(word.substr(0, cut))) {
+                    do cut--; while (cut > 1 && (static_cast<unsigned char>(word[cut]) & 0xC0) == 0x80);
+                }
+                lines.push_back(word.substr(0, cut));
+                word.erase(0, cut);
+            }
+            current = std::move(word);
+        }
+        if (newline) {
+            lines.push_back(std::move(current));
+            current.clear();
+        }
+        start = end + 1;
+    }
+    if (!current.empty()) lines.push_back(std::move(current));
+    return lines;
+}
+
+} // namespace aeronautical
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace aeronautical {
+
+// Minimal PDF 1.4 writer for generated reports: A4 pages of text in the
+// standard Helvetica fonts, lines, grey boxes and JPEG images. Every object
+// goes to the file as soon as it is complete (an image when added, a page
+// when ended, its content deflated), so a document of any length holds one
+// page in memory; the page tree, catalog and cross-reference table follow
+// at finish(). Text is UTF-8 and written in WinAnsi: Latin-1 characters
+// come out as they are, anything else as '?'. Coordinates are PDF points
+// from the bottom-left corner. Throws std::runtime_error on I/O failure.
+class PdfWriter {
+public:
+    static constexpr double kPageWidth = 595.28;  // A4
+    static constexpr double kPageHeight = 841.89;
+
+    explicit PdfWriter(const std::string& path);
+
+    PdfWriter(const PdfWriter&) = delete;
+    PdfWriter& operator=(const PdfWriter&) = delete;
+
+    // JPEG (baseline, RGB) of width x height pixels; the returned id can be
+    // drawn on any later page
+    int addJpeg(const std::string& jpeg, int width, int height);
+
+    void beginPage();
+    // Baseline at y
+    void text(double x, double y, double size, bool bold, std::string_view utf8);
+    void line(double x1, double y1, double x2, double y2, double width = 0.5);
+    // grey: 0 black .. 1 white
+    void fillRect(double x, double y, double width, double height, double grey);
+    // r, g, b: 0 .. 1
+    void fillRect(double x, double y, double width, double height, double r, double g, double b);
+    void image(int image, double x, double y, double width, double height);
+    void endPage();
+    size_t pageCount() const { return pages_.size(); }
+
+    // Closes the document; the file size
+    size_t finish();
+
+    // Width of the text in points, from the Helvetica metrics
+    static double textWidth(std::string_view utf8, double size, bool bold);
+    // The text broken at spaces into lines no wider than width; a word
+    // longer than a line is cut
+    static std::vector<std::string> wrap(std::string_view utf8, double size, bool bold, double width);
+
+private:
+    static constexpr int kCatalog = 1;
+    static constexpr int kPages = 2;
+    static constexpr int kFont = 3;
+    static constexpr int kBoldFont = 4;
+
+    int reserve();
+    void beginObject(int id);
+    void endObject();
+    void write(std::string_view bytes);
+
+    std::ofstream out_;
+    size_t offset_ = 0;
+    std::vector<size_t> offsets_; // by object id - 1
+    std::vector<int> pages_;      // page object ids
+    std::vector<int> images_;     // image object ids
+    std::string content_;         // of the open page
+    bool in_page_ = false;
+};
+
+} // namespace aeronautical
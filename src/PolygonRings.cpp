@@ -0,0 +1,214 @@
+#include "PolygonRings.h"
+#include <algorithm>
+
+namespace aeronautical {
+
+namespace {
+
+// > 0 when p lies left of a->b, < 0 right of it, 0 on its line
+inline double orient(double ax, double ay, double bx, double by, double px, double py) {
+    return (bx - ax) * (py - ay) - (by - ay) * (px - ax);
+}
+
+// p is known to lie on the line through a and b
+inline bool withinSegment(double ax, double ay, double bx, double by, double px, double py) {
+    return std::min(ax, bx) <= px && px <= std::max(ax, bx) && std::min(ay, by) <= py && py <= std::max(ay, by);
+}
+
+bool segmentsMeet(double ax, double ay, double bx, double by, double cx, double cy, double dx, double dy) {
+    const double d1 = orient(cx, cy, dx, dy, ax, ay);
+    const double d2 = orient(cx, cy, dx, dy, bx, by);
+    const double d3 = orient(ax, ay, bx, by, cx, cy);
+    const double d4 = orient(ax, ay, bx, by, dx, dy);
+    if (((d1 > 0 && d2 < 0) || (d1 < 0 && d2 > 0)) && ((d3 > 0 && d4 < 0) || (d3 < 0 && d4 > 0))) {
+        return true;
+    }
+    return (d1 == 0 && withinSegment(cx, cy, dx, dy, ax, ay)) || (d2 == 0 && withinSegment(cx, cy, dx, dy, bx, by)) ||
+           (d3 == 0 && withinSegment(ax, ay, bx, by, cx, cy)) || (d4 == 0 && withinSegment(ax, ay, bx, by, dx, dy));
+}
+
+// Vertex locations and boundary contacts of a feature, accumulated part by part
+struct Contact {
+    bool any_vertex = false;
+    bool all_interior = true;
+    bool any_touching = false; // a vertex in the zone (boundary included) or an edge crossing
+
+    void vertex(int location) {
+        any_vertex = true;
+        all_interior = all_interior && location == 1;
+        any_touching = any_touching || location >= 0;
+    }
+};
+
+} // namespace
+
+std::unique_ptr<PolygonRings> PolygonRings::build(const OGRGeometry& zone) {
+    const auto type = wkbFlatten(zone.getGeometryType());
+    if (type != wkbPolygon && type != wkbMultiPolygon) {
+        return nullptr;
+    }
+
+    auto rings = std::unique_ptr<PolygonRings>(new PolygonRings());
+    zone.getEnvelope(&rings->envelope_);
+    if (type == wkbPolygon) {
+        rings->addPolygon(*zone.toPolygon());
+    } else {
+        for (const auto* polygon : *zone.toMultiPolygon()) {
+            rings->addPolygon(*polygon);
+        }
+    }
+    return rings;
+}
+
+void PolygonRings::addPolygon(const OGRPolygon& polygon) {
+    if (polygon.IsEmpty()) return;
+
+    Polygon entry{static_cast<uint32_t>(rings_.size()), 0};
+    for (const auto* ring : polygon) {
+        const int count = ring->getNumPoints();
+        if (count == 0) continue;
+
+        Ring flat{static_cast<uint32_t>(x_.size()), 0, ring->getX(0), ring->getY(0), ring->getX(0), ring->getY(0)};
+        for (int i = 0; i < count; i++) {
+            const double x = ring->getX(i);
+            const double y = ring->getY(i);
+            x_.push_back(x);
+            y_.push_back(y);
+            flat.min_x = std::min(flat.min_x, x);
+            flat.max_x = std::max(flat.max_x, x);
+            flat.min_y = std::min(flat.min_y, y);
+            flat.max_y = std::max(flat.max_y, y);
+        }
+        // Edges run from each vertex to the next, so close an open ring
+        if (x_.back() != x_[flat.begin] || y_.back() != y_[flat.begin]) {
+            x_.push_back(x_[flat.begin]);
+            y_.push_back(y_[flat.begin]);
+        }
+        flat.end = static_cast<uint32_t>(x_.size());
+        rings_.push_back(flat);
+        entry.ring_count++;
+    }
+    if (entry.ring_count > 0) {
+        polygons_.push_back(entry);
+    }
+}
+
+int PolygonRings::locateInRing(const Ring& ring, double x, double y) const {
+    if (x < ring.min_x || x > ring.max_x || y < ring.min_y || y > ring.max_y) {
+        return -1;
+    }
+    // Crossings of a ray towards +x; the columns are walked in order with
+    // no data-dependent exits, so the loop stays friendly to vectorizers
+    const double* xs = x_.data();
+    const double* ys = y_.data();
+    bool inside = false;
+    bool boundary = false;
+    for (uint32_t i = ring.begin; i + 1 < ring.end; i++) {
+        const double ax = xs[i], ay = ys[i], bx = xs[i + 1], by = ys[i + 1];
+        const double side = orient(ax, ay, bx, by, x, y);
+        boundary |= side == 0 && withinSegment(ax, ay, bx, by, x, y);
+        inside ^= ((ay > y) != (by > y)) & ((side > 0) == (by > ay));
+    }
+    return boundary ? 0 : inside ? 1 : -1;
+}
+
+int PolygonRings::locate(double x, double y) const {
+    int best = -1;
+    for (const auto& polygon : polygons_) {
+        const Ring* shell = &rings_[polygon.first_ring];
+        int location = locateInRing(*shell, x, y);
+        if (location == -1) continue;
+        for (uint32_t h = 1; h < polygon.ring_count && location == 1; h++) {
+            const int in_hole = locateInRing(shell[h], x, y);
+            location = in_hole == 1 ? -1 : in_hole == 0 ? 0 : 1;
+        }
+        if (location == 1) return 1;
+        best = std::max(best, location);
+    }
+    return best;
+}
+
+bool PolygonRings::meetsBoundary(double ax, double ay, double bx, double by) const {
+    const double min_x = std::min(ax, bx), max_x = std::max(ax, bx);
+    const double min_y = std::min(ay, by), max_y = std::max(ay, by);
+    const double* xs = x_.data();
+    const double* ys = y_.data();
+    for (const auto& ring : rings_) {
+        if (max_x < ring.min_x || min_x > ring.max_x || max_y < ring.min_y || min_y > ring.max_y) continue;
+        for (uint32_t i = ring.begin; i + 1 < ring.end; i++) {
+            if (segmentsMeet(ax, ay, bx, by, xs[i], ys[i], xs[i + 1], ys[i + 1])) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool PolygonRings::supports(const OGRGeometry& feature) {
+    switch (wkbFlatten(feature.getGeometryType())) {
+        case wkbPoint:
+        case wkbMultiPoint:
+        case wkbLineString:
+        case wkbMultiLineString:
+            return true;
+        default:
+            return false;
+    }
+}
+
+PolygonRings::Relation PolygonRings::relate(const OGRGeometry& feature) const {
+    OGREnvelope envelope;
+    feature.getEnvelope(&envelope);
+    if (feature.IsEmpty() || !envelope.Intersects(envelope_)) {
+        return Relation::Disjoint;
+    }
+
+    Contact contact;
+    auto addLine = [&](const OGRLineString& line) {
+        const int count = line.getNumPoints();
+        for (int i = 0; i < count; i++) {
+            contact.vertex(locate(line.getX(i), line.getY(i)));
+        }
+        // An edge meeting the boundary makes the line intersect without
+        // lying inside; segments stop mattering once that is settled
+        for (int i = 0; i + 1 < count && contact.all_interior; i++) {
+            if (meetsBoundary(line.getX(i), line.getY(i), line.getX(i + 1), line.getY(i + 1))) {
+                contact.any_touching = true;
+                contact.all_interior = false;
+            }
+        }
+        for (int i = 0; i + 1 < count && !contact.any_touching; i++) {
+            contact.any_touching = meetsBoundary(line.getX(i), line.getY(i), line.getX(i + 1), line.getY(i + 1));
+        }
+    };
+
+    switch (wkbFlatten(feature.getGeometryType())) {
+        case wkbPoint: {
+            const auto* point = feature.toPoint();
+            contact.vertex(locate(point->getX(), point->getY()));
+            break;
+        }
+        case wkbMultiPoint:
+            for (const auto* point : *feature.toMultiPoint()) {
+                if (!point->IsEmpty()) contact.vertex(locate(point->getX(), point->getY()));
+            }
+            break;
+        case wkbLineString:
+            addLine(*feature.toLineString());
+            break;
+        case wkbMultiLineString:
+            for (const auto* line : *feature.toMultiLineString()) {
+                addLine(*line);
+            }
+            break;
+        default:
+            break;
+    }
+
+    if (!contact.any_vertex || !contact.any_touching) {
+        return Relation::Disjoint;
+    }
+    return contact.all_interior ? Relation::Inside : Relation::Intersects;
+}
+
+} // namespace aeronautical
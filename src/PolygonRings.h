@@ -0,0 +1,57 @@
+#pragma once
+
+#include "ogr_geometry.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace aeronautical {
+
+// The rings of a polygonal protection zone flattened into x and y columns,
+// for the point and line features of a project: point-in-polygon and
+// segment crossing tests run on them directly instead of through GEOS.
+// Each ring keeps its bounding box so a test skips rings it cannot reach.
+// Z is ignored, as in the GEOS predicates.
+class PolygonRings {
+public:
+    enum class Relation { Disjoint, Intersects, Inside };
+
+    // nullptr unless zone is a Polygon or MultiPolygon
+    static std::unique_ptr<PolygonRings> build(const OGRGeometry& zone);
+
+    // Points, multipoints, line strings and multi line strings
+    static bool supports(const OGRGeometry& feature);
+
+    // Inside when every vertex is interior and no edge meets the boundary,
+    // which implies a GEOS contains; Intersects matches a GEOS intersects
+    // otherwise. feature must be supported
+    Relation relate(const OGRGeometry& feature) const;
+
+private:
+    struct Ring {
+        uint32_t begin; // first vertex in x_/y_; the ring is closed at end - 1
+        uint32_t end;
+        double min_x, min_y, max_x, max_y;
+    };
+
+    struct Polygon {
+        uint32_t first_ring; // the shell, followed by its holes
+        uint32_t ring_count;
+    };
+
+    void addPolygon(const OGRPolygon& polygon);
+
+    // 1 in the interior, 0 on the boundary, -1 outside
+    int locate(double x, double y) const;
+    int locateInRing(const Ring& ring, double x, double y) const;
+    // Whether segment a-b meets any ring edge, touching included
+    bool meetsBoundary(double ax, double ay, double bx, double by) const;
+
+    std::vector<double> x_;
+    std::vector<double> y_;
+    std::vector<Ring> rings_;
+    std::vector<Polygon> polygons_;
+    OGREnvelope envelope_;
+};
+
+} // namespace aeronautical
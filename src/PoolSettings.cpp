@@ -0,0 +1,20 @@
+#include "PoolSettings.h"
+
+namespace aeronautical {
+
+nlohmann::json PoolMetrics::toJson() const {
+    nlohmann::json j;
+    j["total"] = total;
+    j["in_use"] = in_use;
+    j["idle"] = idle;
+    j["waiters"] = waiters;
+    j["acquisitions"] = acquisitions;
+    j["timeouts"] = timeouts;
+    j["created"] = created;
+    j["closed"] = closed;
+    j["avg_wait_ms"] = acquisitions ? total_wait_ms / static_cast<double>(acquisitions) : 0.0;
+    j["max_wait_ms"] = max_wait_ms;
+    return j;
+}
+
+} // namespace aeronautical
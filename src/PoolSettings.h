@@ -0,0 +1,35 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <json.hpp>
+
+namespace aeronautical {
+
+// Sizing and health settings of a database pool, shared by the C API
+// ConnectionPool and the X DevAPI session pool
+struct PoolSettings {
+    size_t max_size = 16;
+    size_t min_idle = 2;
+    std::chrono::seconds validation_interval{30}; // idle connections are pinged this often
+    std::chrono::seconds max_lifetime{1800};      // connections older than this are retired
+    std::chrono::milliseconds acquire_timeout{5000};
+};
+
+struct PoolMetrics {
+    size_t total = 0;
+    size_t in_use = 0;
+    size_t idle = 0;
+    size_t waiters = 0;
+    uint64_t acquisitions = 0;
+    uint64_t timeouts = 0;
+    uint64_t created = 0;
+    uint64_t closed = 0;
+    double total_wait_ms = 0.0;
+    double max_wait_ms = 0.0;
+
+    nlohmann::json toJson() const;
+};
+
+} // namespace aeronautical
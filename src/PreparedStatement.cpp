@@ -0,0 +1,306 @@
+#include "PreparedStatement.h"
+#include "MysqlResult.h"
+#include "Timestamp.h"
+#include <charconv>
+
+namespace aeronautical {
+
+namespace {
+
+std::chrono::system_clock::time_point fromMysqlTime(const MYSQL_TIME& t) {
+    // Same zone as stringToTimePoint
+    return timestampFromFields(static_cast<int>(t.year), static_cast<int>(t.month), static_cast<int>(t.day),
+                               static_cast<int>(t.hour), static_cast<int>(t.minute), static_cast<int>(t.second));
+}
+
+enum class ColumnKind { Integer, Real, Time, Text };
+
+ColumnKind columnKind(enum_field_types type) {
+    switch (type) {
+        case MYSQL_TYPE_TINY:
+        case MYSQL_TYPE_SHORT:
+        case MYSQL_TYPE_INT24:
+        case MYSQL_TYPE_LONG:
+        case MYSQL_TYPE_LONGLONG:
+        case MYSQL_TYPE_YEAR:
+            return ColumnKind::Integer;
+        case MYSQL_TYPE_FLOAT:
+        case MYSQL_TYPE_DOUBLE:
+            return ColumnKind::Real;
+        case MYSQL_TYPE_DATE:
+        case MYSQL_TYPE_DATETIME:
+        case MYSQL_TYPE_TIMESTAMP:
+            return ColumnKind::Time;
+        default:
+            // DECIMAL stays text so no precision is lost; getDouble parses it
+            return ColumnKind::Text;
+    }
+}
+
+struct ResultColumn {
+    ColumnKind kind = ColumnKind::Text;
+    int64_t integer = 0;
+    double real = 0.0;
+    MYSQL_TIME time{};
+    std::vector<char> text;
+    unsigned long length = 0;
+    BindFlag is_null = 0;
+    BindFlag error = 0;
+};
+
+struct ResultGuard {
+    MYSQL_STMT* stmt;
+    MysqlResult metadata;
+    ~ResultGuard() {
+        metadata.reset();
+        mysql_stmt_free_result(stmt);
+    }
+};
+
+} // namespace
+
+bool PreparedRow::isNull(size_t index) const {
+    return std::holds_alternative<std::monostate>(values_.at(index));
+}
+
+int64_t PreparedRow::getInt(size_t index, int64_t fallback) const {
+    const auto& v = values_.at(index);
+    if (auto i = std::get_if<int64_t>(&v)) return *i;
+    if (auto d = std::get_if<double>(&v)) return static_cast<int64_t>(*d);
+    if (auto s = std::get_if<std::string>(&v)) {
+        int64_t parsed = 0;
+        auto res = std::from_chars(s->data(), s->data() + s->size(), parsed);
+        if (res.ec == std::errc()) return parsed;
+        // DECIMAL columns: truncate like std::stoi would
+        double real = 0.0;
+        if (std::from_chars(s->data(), s->data() + s->size(), real).ec == std::errc()) {
+            return static_cast<int64_t>(real);
+        }
+    }
+    return fallback;
+}
+
+double PreparedRow::getDouble(size_t index, double fallback) const {
+    const auto& v = values_.at(index);
+    if (auto d = std::get_if<double>(&v)) return *d;
+    if (auto i = std::get_if<int64_t>(&v)) return static_cast<double>(*i);
+    if (auto s = std::get_if<std::string>(&v)) {
+        double parsed = 0.0;
+        if (std::from_chars(s->data(), s->data() + s->size(), parsed).ec == std::errc()) return parsed;
+    }
+    return fallback;
+}
+
+bool PreparedRow::getBool(size_t index, bool fallback) const {
+    const auto& v = values_.at(index);
+    if (auto i = std::get_if<int64_t>(&v)) return *i != 0;
+    if (auto d = std::get_if<double>(&v)) return *d != 0.0;
+    if (auto s = std::get_if<std::string>(&v)) return *s == "1" || *s == "true";
+    return fallback;
+}
+
+std::string PreparedRow::getString(size_t index) const {
+    return getOptionalString(index).value_or("");
+}
+
+std::optional<std::string> PreparedRow::getOptionalString(size_t index) const {
+    const auto& v = values_.at(index);
+    if (auto s = std::get_if<std::string>(&v)) return *s;
+    if (auto i = std::get_if<int64_t>(&v)) return std::to_string(*i);
+    if (auto d = std::get_if<double>(&v)) return std::to_string(*d);
+    if (auto t = std::get_if<std::chrono::system_clock::time_point>(&v)) {
+        return formatTimestamp(*t);
+    }
+    return std::nullopt;
+}
+
+std::optional<std::chrono::system_clock::time_point> PreparedRow::getTimePoint(size_t index) const {
+    const auto& v = values_.at(index);
+    if (auto t = std::get_if<std::chrono::system_clock::time_point>(&v)) return *t;
+    return std::nullopt;
+}
+
+PreparedStatement::PreparedStatement(MYSQL* connection, std::string sql) : sql_(std::move(sql)) {
+    stmt_ = mysql_stmt_init(connection);
+    if (!stmt_) {
+        throw SqlError("mysql_stmt_init failed: " + std::string(mysql_error(connection)), mysql_errno(connection));
+    }
+
+    if (mysql_stmt_prepare(stmt_, sql_.c_str(), sql_.size())) {
+        SqlError error = lastError("prepare");
+        mysql_stmt_close(stmt_);
+        stmt_ = nullptr;
+        throw error;
+    }
+
+    // Have mysql_stmt_store_result compute max_length so text buffers fit exactly
+    BindFlag update_max_length = 1;
+    mysql_stmt_attr_set(stmt_, STMT_ATTR_UPDATE_MAX_LENGTH, &update_max_length);
+
+    param_count_ = mysql_stmt_param_count(stmt_);
+}
+
+PreparedStatement::~PreparedStatement() {
+    if (stmt_) {
+        mysql_stmt_close(stmt_);
+    }
+}
+
+SqlError PreparedStatement::lastError(const std::string& context) const {
+    return SqlError("Prepared statement " + context + " failed: " + std::string(mysql_stmt_error(stmt_)),
+                    mysql_stmt_errno(stmt_));
+}
+
+PreparedResult PreparedStatement::execute(const std::vector<SqlParam>& params) {
+    if (params.size() != param_count_) {
+        throw SqlError("Prepared statement expects " + std::to_string(param_count_) + " parameters, got " +
+                       std::to_string(params.size()), 0);
+    }
+
+    // Parameter buffers must stay alive until mysql_stmt_execute returns
+    std::vector<MYSQL_BIND> param_binds(params.size());
+    std::vector<int64_t> integers(params.size());
+    std::vector<double> reals(params.size());
+    std::vector<unsigned long> lengths(params.size());
+    for (size_t i = 0; i < params.size(); i++) {
+        MYSQL_BIND& bind = param_binds[i];
+        bind = MYSQL_BIND{};
+        if (auto v = std::get_if<int64_t>(&params[i])) {
+            integers[i] = *v;
+            bind.buffer_type = MYSQL_TYPE_LONGLONG;
+            bind.buffer = &integers[i];
+        } else if (auto d = std::get_if<double>(&params[i])) {
+            reals[i] = *d;
+            bind.buffer_type = MYSQL_TYPE_DOUBLE;
+            bind.buffer = &reals[i];
+        } else if (auto s = std::get_if<std::string>(&params[i])) {
+            lengths[i] = s->size();
+            bind.buffer_type = MYSQL_TYPE_STRING;
+            bind.buffer = const_cast<char*>(s->data());
+            bind.buffer_length = s->size();
+            bind.length = &lengths[i];
+        } else {
+            bind.buffer_type = MYSQL_TYPE_NULL;
+        }
+    }
+
+    if (!param_binds.empty() && mysql_stmt_bind_param(stmt_, param_binds.data())) {
+        throw lastError("bind");
+    }
+    if (mysql_stmt_execute(stmt_)) {
+        throw lastError("execute");
+    }
+
+    PreparedResult result;
+    unsigned int field_count = mysql_stmt_field_count(stmt_);
+    if (field_count == 0) {
+        result.affected_rows = mysql_stmt_affected_rows(stmt_);
+        result.insert_id = mysql_stmt_insert_id(stmt_);
+        return result;
+    }
+
+    if (mysql_stmt_store_result(stmt_)) {
+        mysql_stmt_free_result(stmt_);
+        throw lastError("store");
+    }
+
+    ResultGuard guard{stmt_, MysqlResult(mysql_stmt_result_metadata(stmt_))};
+    if (!guard.metadata) {
+        throw lastError("metadata");
+    }
+    MYSQL_FIELD* fields = mysql_fetch_fields(guard.metadata.get());
+
+    std::vector<ResultColumn> columns(field_count);
+    std::vector<MYSQL_BIND> result_binds(field_count);
+    result.columns.reserve(field_count);
+    for (unsigned int i = 0; i < field_count; i++) {
+        ResultColumn& column = columns[i];
+        MYSQL_BIND& bind = result_binds[i];
+        bind = MYSQL_BIND{};
+        column.kind = columnKind(fields[i].type);
+        result.columns.emplace_back(fields[i].name ? fields[i].name : "");
+
+        switch (column.kind) {
+            case ColumnKind::Integer:
+                bind.buffer_type = MYSQL_TYPE_LONGLONG;
+                bind.buffer = &column.integer;
+                bind.is_unsigned = (fields[i].flags & UNSIGNED_FLAG) != 0;
+                break;
+            case ColumnKind::Real:
+                bind.buffer_type = MYSQL_TYPE_DOUBLE;
+                bind.buffer = &column.real;
+                break;
+            case ColumnKind::Time:
+                bind.buffer_type = MYSQL_TYPE_DATETIME;
+                bind.buffer = &column.time;
+                break;
+            case ColumnKind::Text:
+                column.text.resize(fields[i].max_length + 1);
+                bind.buffer_type = MYSQL_TYPE_STRING;
+                bind.buffer = column.text.data();
+                bind.buffer_length = column.text.size();
+                break;
+        }
+        bind.length = &column.length;
+        bind.is_null = &column.is_null;
+        bind.error = &column.error;
+    }
+
+    if (mysql_stmt_bind_result(stmt_, result_binds.data())) {
+        throw lastError("bind result");
+    }
+
+    result.rows.reserve(mysql_stmt_num_rows(stmt_));
+    while (true) {
+        int rc = mysql_stmt_fetch(stmt_);
+        if (rc == MYSQL_NO_DATA) {
+            break;
+        }
+        if (rc == 1) {
+            throw lastError("fetch");
+        }
+
+        std::vector<SqlValue> values;
+        values.reserve(field_count);
+        for (unsigned int i = 0; i < field_count; i++) {
+            ResultColumn& column = columns[i];
+            if (column.is_null) {
+                values.emplace_back(std::monostate{});
+                continue;
+            }
+            switch (column.kind) {
+                case ColumnKind::Integer:
+                    values.emplace_back(column.integer);
+                    break;
+                case ColumnKind::Real:
+                    values.emplace_back(column.real);
+                    break;
+                case ColumnKind::Time:
+                    values.emplace_back(fromMysqlTime(column.time));
+                    break;
+                case ColumnKind::Text:
+                    if (rc == MYSQL_DATA_TRUNCATED && column.error) {
+                        // max_length was stale; fetch this column again with room for it
+                        std::string full(column.length, '\0');
+                        MYSQL_BIND refetch{};
+                        refetch.buffer_type = MYSQL_TYPE_STRING;
+                        refetch.buffer = full.data();
+                        refetch.buffer_length = full.size();
+                        if (mysql_stmt_fetch_column(stmt_, &refetch, i, 0)) {
+                            throw lastError("fetch column");
+                        }
+                        values.emplace_back(std::move(full));
+                    } else {
+                        values.emplace_back(std::string(column.text.data(), column.length));
+                    }
+                    break;
+            }
+        }
+        result.rows.emplace_back(std::move(values));
+    }
+
+    result.affected_rows = mysql_stmt_affected_rows(stmt_);
+    return result;
+}
+
+} // namespace aeronautical
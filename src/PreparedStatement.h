@@ -0,0 +1,86 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <variant>
+#include <vector>
+#include <mysql/mysql.h>
+
+namespace aeronautical {
+
+// Value bound to a '?' placeholder
+using SqlParam = std::variant<std::nullptr_t, int64_t, double, std::string>;
+
+// One column decoded from the binary protocol (monostate is SQL NULL)
+using SqlValue = std::variant<std::monostate, int64_t, double, std::string, std::chrono::system_clock::time_point>;
+
+// MySQL 8 declares these flags as bool, MariaDB and older clients as my_bool
+using BindFlag = decltype(MYSQL_BIND::is_null_value);
+
+class SqlError : public std::runtime_error {
+public:
+    SqlError(const std::string& message, unsigned int code) : std::runtime_error(message), code_(code) {}
+    unsigned int code() const { return code_; }
+
+private:
+    unsigned int code_;
+};
+
+// Typed view of a result row. Getters convert leniently between the
+// numeric/text representations and return the fallback for NULL.
+class PreparedRow {
+public:
+    explicit PreparedRow(std::vector<SqlValue> values) : values_(std::move(values)) {}
+
+    size_t size() const { return values_.size(); }
+    const SqlValue& value(size_t index) const { return values_.at(index); }
+    bool isNull(size_t index) const;
+
+    int64_t getInt(size_t index, int64_t fallback = 0) const;
+    double getDouble(size_t index, double fallback = 0.0) const;
+    bool getBool(size_t index, bool fallback = false) const;
+    std::string getString(size_t index) const; // empty for NULL
+    std::optional<std::string> getOptionalString(size_t index) const;
+    std::optional<std::chrono::system_clock::time_point> getTimePoint(size_t index) const;
+
+private:
+    std::vector<SqlValue> values_;
+};
+
+struct PreparedResult {
+    std::vector<std::string> columns;
+    std::vector<PreparedRow> rows;
+    uint64_t affected_rows = 0;
+    uint64_t insert_id = 0;
+};
+
+// Server-side prepared statement owned by one pooled connection. Parsed and
+// planned once by MySQL, then re-executed with new parameters; results use
+// the binary protocol so numbers and dates arrive already typed.
+class PreparedStatement {
+public:
+    // Throws SqlError if the server rejects the statement
+    PreparedStatement(MYSQL* connection, std::string sql);
+    ~PreparedStatement();
+
+    PreparedStatement(const PreparedStatement&) = delete;
+    PreparedStatement& operator=(const PreparedStatement&) = delete;
+
+    // Throws SqlError on failure; the statement stays usable unless the connection died
+    PreparedResult execute(const std::vector<SqlParam>& params);
+
+    const std::string& sql() const { return sql_; }
+    unsigned long paramCount() const { return param_count_; }
+
+private:
+    SqlError lastError(const std::string& context) const;
+
+    MYSQL_STMT* stmt_ = nullptr;
+    std::string sql_;
+    unsigned long param_count_ = 0;
+};
+
+} // namespace aeronautical
@@ -0,0 +1,190 @@
+#include "ProcessSupervisor.h"
+#include "Config.h"
+#include <spdlog/spdlog.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <pthread.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace aeronautical {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// A worker that exits sooner than this after starting counts as failing
+constexpr auto kStableUptime = std::chrono::seconds(10);
+constexpr auto kMaxRestartDelay = std::chrono::seconds(30);
+
+struct Worker {
+    pid_t pid = 0;
+    Clock::time_point started;
+    Clock::time_point restart_at;
+    int failures = 0; // consecutive exits before kStableUptime
+};
+
+size_t residentBytes(pid_t pid) {
+    std::ifstream statm("/proc/" + std::to_string(pid) + "/statm");
+    size_t pages = 0;
+    size_t resident = 0;
+    if (!(statm >> pages >> resident)) return 0;
+    return resident * static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+}
+
+std::string describeExit(int status) {
+    if (WIFEXITED(status)) return "exited with " + std::to_string(WEXITSTATUS(status));
+    if (WIFSIGNALED(status)) return std::string("killed by ") + strsignal(WTERMSIG(status));
+    return "stopped";
+}
+
+} // namespace
+
+std::optional<size_t> ProcessSupervisor::workerIndex() {
+    const char* index = std::getenv("PREFORK_WORKER");
+    if (!index || !*index) return std::nullopt;
+    return static_cast<size_t>(std::strtoul(index, nullptr, 10));
+}
+
+int ProcessSupervisor::run(const PreforkSettings& settings, char* argv[]) {
+    // Synchronous and thread-free: the supervisor forks, so it starts no threads
+    auto logger = spdlog::stdout_color_mt("supervisor");
+    logger->set_pattern("[%Y-%m-%d %H:%M:%S.%e] [%n] [%^%l%$] %v");
+
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGTERM);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGHUP);
+    sigaddset(&signals, SIGCHLD);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    auto spawn = [&](size_t index, Worker& worker) {
+        const pid_t pid = ::fork();
+        if (pid == 0) {
+            // The server blocks what it waits for itself
+            sigset_t none;
+            sigemptyset(&none);
+            pthread_sigmask(SIG_SETMASK, &none, nullptr);
+            // Workers stop with the supervisor, also when it is killed
+            prctl(PR_SET_PDEATHSIG, SIGTERM);
+            setenv("PREFORK_WORKER", std::to_string(index).c_str(), 1);
+            Config::getInstance().unexport();
+            ::execv("/proc/self/exe", argv);
+            _exit(127);
+        }
+        if (pid < 0) {
+            logger->error("Could not start worker {}: {}", index, std::strerror(errno));
+            worker.restart_at = Clock::now() + std::chrono::seconds(1);
+            return;
+        }
+        worker.pid = pid;
+        worker.started = Clock::now();
+        logger->info("Worker {} started as pid {}", index, pid);
+    };
+
+    std::vector<Worker> workers(settings.workers);
+    std::vector<pid_t> retiring; // replaced for memory, draining
+    for (size_t i = 0; i < workers.size(); i++) {
+        spawn(i, workers[i]);
+    }
+    logger->info("Supervising {} workers{}", workers.size(),
+                 settings.max_rss_bytes ? fmt::format(", replaced above {} MB resident", settings.max_rss_bytes >> 20) : "");
+
+    bool stopping = false;
+    auto forward = [&](int signal_number) {
+        for (const auto& worker : workers) {
+            if (worker.pid > 0) ::kill(worker.pid, signal_number);
+        }
+        for (pid_t pid : retiring) {
+            ::kill(pid, signal_number);
+        }
+    };
+    auto next_check = Clock::now() + settings.check_interval;
+
+    while (true) {
+        // Sleep until a signal, the next memory check or the next due restart
+        auto wake = next_check;
+        if (!stopping) {
+            for (const auto& worker : workers) {
+                if (worker.pid == 0) wake = std::min(wake, worker.restart_at);
+            }
+        }
+        const auto wait = std::max(std::chrono::nanoseconds(0), wake - Clock::now());
+        timespec timeout{static_cast<time_t>(wait.count() / 1000000000), static_cast<long>(wait.count() % 1000000000)};
+        const int signal_number = sigtimedwait(&signals, nullptr, &timeout);
+
+        if ((signal_number == SIGTERM || signal_number == SIGINT) && !stopping) {
+            logger->info("Signal {} received; stopping workers", signal_number);
+            stopping = true;
+            forward(SIGTERM);
+        } else if (signal_number == SIGHUP) {
+            forward(SIGHUP);
+        }
+
+        int status = 0;
+        pid_t pid;
+        while ((pid = ::waitpid(-1, &status, WNOHANG)) > 0) {
+            auto old = std::find(retiring.begin(), retiring.end(), pid);
+            if (old != retiring.end()) {
+                retiring.erase(old);
+                continue;
+            }
+            for (size_t i = 0; i < workers.size(); i++) {
+                Worker& worker = workers[i];
+                if (worker.pid != pid) continue;
+                worker.pid = 0;
+                if (stopping) break;
+                const auto now = Clock::now();
+                worker.failures = now - worker.started < kStableUptime ? worker.failures + 1 : 0;
+                const auto delay = worker.failures == 0
+                    ? std::chrono::seconds(0)
+                    : std::min<std::chrono::seconds>(kMaxRestartDelay, std::chrono::seconds(1 << std::min(worker.failures - 1, 5)));
+                worker.restart_at = now + delay;
+                logger->warn("Worker {} (pid {}) {}; restarting in {} s", i, pid, describeExit(status), delay.count());
+            }
+        }
+
+        if (stopping) {
+            const bool running = std::any_of(workers.begin(), workers.end(), [](const Worker& w) { return w.pid > 0; });
+            if (!running && retiring.empty()) {
+                logger->info("All workers stopped");
+                return 0;
+            }
+            continue;
+        }
+
+        const auto now = Clock::now();
+        for (size_t i = 0; i < workers.size(); i++) {
+            if (workers[i].pid == 0 && now >= workers[i].restart_at) {
+                spawn(i, workers[i]);
+            }
+        }
+        if (now >= next_check) {
+            next_check = now + settings.check_interval;
+            if (settings.max_rss_bytes == 0) continue;
+            for (size_t i = 0; i < workers.size(); i++) {
+                Worker& worker = workers[i];
+                if (worker.pid == 0) continue;
+                const size_t resident = residentBytes(worker.pid);
+                if (resident <= settings.max_rss_bytes) continue;
+                logger->warn("Worker {} (pid {}) at {} MB resident; replacing it", i, worker.pid, resident >> 20);
+                ::kill(worker.pid, SIGTERM);
+                retiring.push_back(worker.pid);
+                worker.pid = 0;
+                worker.failures = 0;
+                spawn(i, worker);
+            }
+        }
+    }
+}
+
+} // namespace aeronautical
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <optional>
+
+namespace aeronautical {
+
+struct PreforkSettings {
+    size_t workers = 0;                     // server processes; 0 serves from this one
+    size_t max_rss_bytes = 0;               // a worker above this is replaced; 0: no limit
+    std::chrono::seconds check_interval{5}; // how often worker memory is read
+};
+
+// Prefork mode: the process the operator starts stays a small supervisor
+// and runs `workers` copies of the same binary and arguments, each with
+// PREFORK_WORKER=<index>. Every worker binds SERVER_PORT with SO_REUSEPORT,
+// so the kernel spreads connections across them and a crash takes down one
+// GDAL/GEOS state and heap, not the service. Reference data is shared
+// through REFERENCE_SNAPSHOT_PATH: the workers save and start from the same
+// file, read from one copy in the page cache.
+//
+// A worker that exits is started again, after a pause that doubles (up to
+// 30 s) while it keeps dying within seconds of starting. A worker whose
+// resident memory passes max_rss_bytes is replaced: the new one starts at
+// once and the old one gets SIGTERM and drains as a single server would.
+// SIGHUP is passed on to the workers; SIGTERM and SIGINT are passed on and
+// the supervisor returns once every worker has exited.
+class ProcessSupervisor {
+public:
+    // Index of this process when a supervisor started it
+    static std::optional<size_t> workerIndex();
+
+    // Supervises until terminated; returns the exit code for main()
+    static int run(const PreforkSettings& settings, char* argv[]);
+};
+
+} // namespace aeronautical
@@ -0,0 +1,411 @@
+#include "Profiler.h"
+#include "MemoryArenas.h"
+#include "TokenVerifier.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <ctime>
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <sys/time.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+#ifdef HAVE_GPERFTOOLS
+#include <gperftools/malloc_extension.h>
+#include <gperftools/profiler.h>
+#endif
+
+namespace aeronautical {
+
+namespace {
+
+constexpr int kMaxDepth = 64;
+// The handler and the signal trampoline sit above the interrupted frame
+constexpr int kSkipFrames = 2;
+// About 34 MB of buffer; samples beyond it are dropped
+constexpr size_t kMaxSamples = size_t(1) << 16;
+
+struct Sample {
+    std::atomic<bool> ready{false};
+    int depth = 0;
+    void* frames[kMaxDepth];
+};
+
+// Written by the SIGPROF handler, so plain globals rather than members
+std::unique_ptr<Sample[]> g_samples;
+size_t g_capacity = 0;
+std::atomic<size_t> g_next{0};
+std::atomic<uint64_t> g_dropped{0};
+std::atomic<bool> g_sampling{false};
+
+void onProfileSignal(int, siginfo_t*, void*) {
+    const int saved_errno = errno;
+    if (g_sampling.load(std::memory_order_acquire)) {
+        const size_t slot = g_next.fetch_add(1, std::memory_order_relaxed);
+        if (slot < g_capacity) {
+            Sample& sample = g_samples[slot];
+            sample.depth = backtrace(sample.frames, kMaxDepth);
+            sample.ready.store(true, std::memory_order_release);
+        } else {
+            g_dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    errno = saved_errno;
+}
+
+// Installed before every profile, since gperftools' profiler takes SIGPROF
+// over, and never removed: a SIGPROF arriving after the timer stops would
+// otherwise end the process.
+void installHandler() {
+    // backtrace() loads libgcc on first use, which must not happen in the handler
+    void* warm_up[1];
+    backtrace(warm_up, 1);
+
+    struct sigaction action {};
+    action.sa_sigaction = onProfileSignal;
+    action.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGPROF, &action, nullptr);
+}
+
+void setTimer(int hz) {
+    struct itimerval timer {};
+    if (hz > 0) {
+        timer.it_interval.tv_sec = 0;
+        timer.it_interval.tv_usec = 1000000 / hz;
+        timer.it_value = timer.it_interval;
+    }
+    setitimer(ITIMER_PROF, &timer, nullptr);
+}
+
+std::string symbolize(void* address) {
+    Dl_info info{};
+    if (dladdr(address, &info) && info.dli_sname) {
+        int status = 0;
+        std::unique_ptr<char, void (*)(void*)> demangled(abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status),
+                                                         std::free);
+        std::string name = status == 0 && demangled ? demangled.get() : info.dli_sname;
+        // Folded stacks use ';' between frames and ' ' before the count
+        std::replace(name.begin(), name.end(), ';', ':');
+        return name;
+    }
+    if (info.dli_fname) {
+        const auto offset = reinterpret_cast<uintptr_t>(address) - reinterpret_cast<uintptr_t>(info.dli_fbase);
+        std::ostringstream out;
+        out << std::filesystem::path(info.dli_fname).filename().string() << "+0x" << std::hex << offset;
+        return out.str();
+    }
+    std::ostringstream out;
+    out << address;
+    return out.str();
+}
+
+std::string timestamp() {
+    char buffer[32];
+    const std::time_t now = std::time(nullptr);
+    std::tm tm{};
+    gmtime_r(&now, &tm);
+    std::strftime(buffer, sizeof(buffer), "%Y%m%dT%H%M%SZ", &tm);
+    return buffer;
+}
+
+crow::response jsonError(int code, const std::string& message) {
+    nlohmann::json body = {{"error", true}, {"message", message}};
+    crow::response res(code, body.dump());
+    res.add_header("Content-Type", "application/json");
+    return res;
+}
+
+crow::response attachment(std::string body, const std::string& filename) {
+    crow::response res(200, std::move(body));
+    res.add_header("Content-Type", "application/octet-stream");
+    res.add_header("Content-Disposition", "attachment; filename=\"" + filename + "\"");
+    return res;
+}
+
+// VmRSS and VmHWM from /proc/self/status, in bytes
+void addResidentSet(nlohmann::json& j) {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        const bool rss = line.rfind("VmRSS:", 0) == 0;
+        const bool peak = line.rfind("VmHWM:", 0) == 0;
+        if (!rss && !peak) continue;
+        const uint64_t kb = std::strtoull(line.c_str() + 6, nullptr, 10);
+        j[rss ? "rss_bytes" : "peak_rss_bytes"] = kb * 1024;
+    }
+}
+
+} // namespace
+
+Profiler& Profiler::getInstance() {
+    static Profiler instance;
+    return instance;
+}
+
+void Profiler::configure(const ProfilerSettings& settings) {
+    settings_ = settings;
+    settings_.max_frequency = std::max(1, settings_.max_frequency);
+    if (settings_.enabled) {
+        spdlog::info("Profiling endpoints enabled (CPU profiles up to {} s)", settings_.max_duration.count());
+    }
+}
+
+nlohmann::json Profiler::status() const {
+    nlohmann::json j;
+    j["enabled"] = settings_.enabled;
+    j["running"] = running_.load(std::memory_order_relaxed);
+    j["max_seconds"] = settings_.max_duration.count();
+    j["max_hz"] = settings_.max_frequency;
+#ifdef HAVE_GPERFTOOLS
+    j["formats"] = {"folded", "pprof"};
+    j["allocator"] = "tcmalloc";
+#else
+    j["formats"] = {"folded"};
+    j["allocator"] = MemoryArenas::getInstance().allocator();
+#endif
+    j["profiles"] = profiles_.load(std::memory_order_relaxed);
+    j["last_samples"] = last_samples_.load(std::memory_order_relaxed);
+    j["last_dropped"] = last_dropped_.load(std::memory_order_relaxed);
+    return j;
+}
+
+nlohmann::json Profiler::heapStats() const {
+    nlohmann::json j;
+#ifdef HAVE_GPERFTOOLS
+    j["allocator"] = "tcmalloc";
+    auto* extension = MallocExtension::instance();
+    for (const char* property : {"generic.current_allocated_bytes", "generic.heap_size",
+                                 "tcmalloc.pageheap_free_bytes", "tcmalloc.pageheap_unmapped_bytes",
+                                 "tcmalloc.central_cache_free_bytes", "tcmalloc.thread_cache_free_bytes"}) {
+        size_t value = 0;
+        if (extension->GetNumericProperty(property, &value)) {
+            j[property] = value;
+        }
+    }
+    char text[8192];
+    extension->GetStats(text, sizeof(text));
+    j["text"] = text;
+#else
+    j = MemoryArenas::getInstance().stats();
+#endif
+    addResidentSet(j);
+    return j;
+}
+
+bool Profiler::admitted(const crow::request& req, crow::response& res) const {
+    if (!settings_.enabled) {
+        res = jsonError(403, "Profiling is disabled; set PROFILING=1 to enable it");
+        return false;
+    }
+    std::string error;
+    if (!TokenVerifier::getInstance().authorizes(req.get_header_value("Authorization"), error)) {
+        res = jsonError(401, error);
+        return false;
+    }
+    return true;
+}
+
+void Profiler::waitFor(std::chrono::seconds duration) {
+    std::unique_lock<std::mutex> lock(wait_mutex_);
+    wait_cv_.wait_for(lock, duration, [this]() { return stop_requested_; });
+}
+
+void Profiler::stop() {
+    {
+        std::lock_guard<std::mutex> lock(wait_mutex_);
+        stop_requested_ = true;
+    }
+    wait_cv_.notify_all();
+}
+
+crow::response Profiler::cpuProfile(const crow::request& req) {
+    int seconds = 10;
+    int hz = 99; // off the round numbers, so sampling does not beat with periodic work
+    if (const char* value = req.url_params.get("seconds")) seconds = std::atoi(value);
+    if (const char* value = req.url_params.get("hz")) hz = std::atoi(value);
+    const std::string format = req.url_params.get("format") ? req.url_params.get("format") : "folded";
+    if (seconds <= 0 || seconds > settings_.max_duration.count()) {
+        return jsonError(400, "seconds must be between 1 and " + std::to_string(settings_.max_duration.count()));
+    }
+    if (hz <= 0 || hz > settings_.max_frequency) {
+        return jsonError(400, "hz must be between 1 and " + std::to_string(settings_.max_frequency));
+    }
+#ifdef HAVE_GPERFTOOLS
+    const bool pprof = format == "pprof";
+#else
+    const bool pprof = false;
+    if (format == "pprof") {
+        return jsonError(501, "format=pprof needs a build with gperftools (ENABLE_PROFILING)");
+    }
+#endif
+    if (!pprof && format != "folded") {
+        return jsonError(400, "format must be folded or pprof");
+    }
+
+    bool idle = false;
+    if (!running_.compare_exchange_strong(idle, true)) {
+        return jsonError(409, "A CPU profile is already running");
+    }
+    {
+        std::lock_guard<std::mutex> lock(wait_mutex_);
+        stop_requested_ = false;
+    }
+    spdlog::info("CPU profile started for {} s at {} Hz ({})", seconds, hz, format);
+    crow::response res = pprof ? cpuProfilePprof(std::chrono::seconds(seconds))
+                               : cpuProfileFolded(std::chrono::seconds(seconds), hz);
+    profiles_.fetch_add(1, std::memory_order_relaxed);
+    running_.store(false, std::memory_order_release);
+    return res;
+}
+
+crow::response Profiler::cpuProfileFolded(std::chrono::seconds duration, int hz) {
+    // Every CPU may be sampled hz times a second; beyond the buffer samples
+    // are counted as dropped. The previous buffer is only freed here, long
+    // after its last handler returned.
+    const long cpus = std::max(1L, sysconf(_SC_NPROCESSORS_ONLN));
+    g_capacity = std::min(kMaxSamples, static_cast<size_t>(hz) * static_cast<size_t>(duration.count()) *
+                                           static_cast<size_t>(cpus));
+    g_samples = std::make_unique<Sample[]>(g_capacity);
+    g_next.store(0, std::memory_order_relaxed);
+    g_dropped.store(0, std::memory_order_relaxed);
+
+    installHandler();
+    g_sampling.store(true, std::memory_order_release);
+    setTimer(hz);
+    waitFor(duration);
+    setTimer(0);
+    g_sampling.store(false, std::memory_order_release);
+
+    const size_t taken = std::min(g_next.load(std::memory_order_acquire), g_capacity);
+    std::map<std::vector<void*>, uint64_t> stacks;
+    for (size_t i = 0; i < taken; i++) {
+        const Sample& sample = g_samples[i];
+        if (!sample.ready.load(std::memory_order_acquire) || sample.depth <= kSkipFrames) continue;
+        // Root first, as folded stacks read
+        std::vector<void*> frames(sample.frames + kSkipFrames, sample.frames + sample.depth);
+        std::reverse(frames.begin(), frames.end());
+        stacks[std::move(frames)]++;
+    }
+
+    // Addresses within one function fold into the same line
+    std::unordered_map<void*, std::string> names;
+    std::map<std::string, uint64_t> folded;
+    for (const auto& [frames, count] : stacks) {
+        std::string line;
+        for (size_t i = 0; i < frames.size(); i++) {
+            auto it = names.find(frames[i]);
+            if (it == names.end()) {
+                it = names.emplace(frames[i], symbolize(frames[i])).first;
+            }
+            if (i > 0) line += ';';
+            line += it->second;
+        }
+        folded[std::move(line)] += count;
+    }
+    std::string body;
+    for (const auto& [line, count] : folded) {
+        body += line;
+        body += ' ';
+        body += std::to_string(count);
+        body += '\n';
+    }
+
+    last_samples_.store(taken, std::memory_order_relaxed);
+    last_dropped_.store(g_dropped.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    spdlog::info("CPU profile finished: {} samples, {} distinct stacks, {} dropped", taken, folded.size(),
+                 g_dropped.load(std::memory_order_relaxed));
+    return attachment(std::move(body), "cpu-" + timestamp() + ".folded");
+}
+
+crow::response Profiler::cpuProfilePprof(std::chrono::seconds duration) {
+#ifdef HAVE_GPERFTOOLS
+    const std::filesystem::path path =
+        std::filesystem::temp_directory_path() / ("cpu-" + std::to_string(getpid()) + "-" + timestamp() + ".prof");
+    if (!ProfilerStart(path.c_str())) {
+        return jsonError(503, "gperftools could not start the profiler");
+    }
+    waitFor(duration);
+    ProfilerStop();
+
+    std::ifstream file(path, std::ios::binary);
+    std::string body((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    std::error_code ignored;
+    std::filesystem::remove(path, ignored);
+    last_samples_.store(0, std::memory_order_relaxed);
+    last_dropped_.store(0, std::memory_order_relaxed);
+    spdlog::info("CPU profile finished: {} bytes of pprof output", body.size());
+    return attachment(std::move(body), "cpu-" + timestamp() + ".prof");
+#else
+    (void)duration;
+    return jsonError(501, "format=pprof needs a build with gperftools (ENABLE_PROFILING)");
+#endif
+}
+
+void Profiler::registerRoutes(HttpApp& app) {
+    CROW_ROUTE(app, "/api/admin/profile")
+        .methods(crow::HTTPMethod::GET)
+        ([this]() {
+            crow::response res(200, status().dump());
+            res.add_header("Content-Type", "application/json");
+            return res;
+        });
+
+    // Blocks for the duration and answers with the profile
+    CROW_ROUTE(app, "/api/admin/profile/cpu")
+        .methods(crow::HTTPMethod::POST)
+        ([this](const crow::request& req) {
+            crow::response res;
+            if (!admitted(req, res)) return res;
+            return cpuProfile(req);
+        });
+
+    CROW_ROUTE(app, "/api/admin/profile/cpu/stop")
+        .methods(crow::HTTPMethod::POST)
+        ([this](const crow::request& req) {
+            crow::response res;
+            if (!admitted(req, res)) return res;
+            const bool running = running_.load(std::memory_order_acquire);
+            if (running) stop();
+            nlohmann::json body = {{"stopped", running}};
+            res = crow::response(200, body.dump());
+            res.add_header("Content-Type", "application/json");
+            return res;
+        });
+
+    CROW_ROUTE(app, "/api/admin/profile/heap")
+        .methods(crow::HTTPMethod::GET)
+        ([this](const crow::request& req) {
+            crow::response res;
+            if (!admitted(req, res)) return res;
+            res = crow::response(200, heapStats().dump());
+            res.add_header("Content-Type", "application/json");
+            return res;
+        });
+
+    // Needs TCMALLOC_SAMPLE_PARAMETER set (e.g. 524288) when the process starts
+    CROW_ROUTE(app, "/api/admin/profile/heap/sites")
+        .methods(crow::HTTPMethod::GET)
+        ([this](const crow::request& req) {
+            crow::response res;
+            if (!admitted(req, res)) return res;
+#ifdef HAVE_GPERFTOOLS
+            std::string sample;
+            MallocExtension::instance()->GetHeapSample(&sample);
+            return attachment(std::move(sample), "heap-" + timestamp() + ".prof");
+#else
+            return jsonError(501, "Allocation sites need a build with gperftools (ENABLE_PROFILING)");
+#endif
+        });
+}
+
+} // namespace aeronautical
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <crow.h>
+#include "HttpApp.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <json.hpp>
+
+namespace aeronautical {
+
+struct ProfilerSettings {
+    bool enabled = false;                    // the routes answer 403 until enabled
+    std::chrono::seconds max_duration{60};   // longest CPU profile one request may take
+    int max_frequency = 1000;                // samples per second of CPU time, at most
+};
+
+// On-demand CPU and heap profiles of the running process, for reproducing
+// slowness seen in production.
+//
+// CPU profiles sample the stack on SIGPROF (every 1/hz s of CPU time used by
+// the process) into a buffer sized up front, and return it as folded stacks
+// ("root;...;leaf count" lines, the input of flamegraph.pl and speedscope).
+// Built with gperftools (ENABLE_PROFILING), format=pprof returns its profile
+// instead. One profile runs at a time, for at most max_duration; the signal
+// handler only copies a backtrace into a free slot, so a profile costs a few
+// microseconds per sample and is safe to take under load.
+//
+// Heap statistics come from the allocator in use (MemoryArenas), or from
+// tcmalloc's counters and sampled allocation sites with gperftools.
+//
+//   GET  /api/admin/profile                   what is available and running
+//   POST /api/admin/profile/cpu?seconds=&hz=&format=folded|pprof
+//   POST /api/admin/profile/cpu/stop          ends the running profile early
+//   GET  /api/admin/profile/heap              allocator statistics
+//   GET  /api/admin/profile/heap/sites        top allocation sites (tcmalloc only)
+class Profiler {
+public:
+    static Profiler& getInstance();
+
+    Profiler(const Profiler&) = delete;
+    Profiler& operator=(const Profiler&) = delete;
+
+    void configure(const ProfilerSettings& settings);
+
+    nlohmann::json status() const;
+    nlohmann::json heapStats() const;
+
+    void registerRoutes(HttpApp& app);
+
+private:
+    Profiler() = default;
+
+    crow::response cpuProfile(const crow::request& req);
+    crow::response cpuProfileFolded(std::chrono::seconds duration, int hz);
+    crow::response cpuProfilePprof(std::chrono::seconds duration);
+    // Sleeps until the duration is up or stop() is called
+    void waitFor(std::chrono::seconds duration);
+    void stop();
+
+    // 403 when profiling is off, 401 when the bearer token is refused, else nothing
+    bool admitted(const crow::request& req, crow::response& res) const;
+
+    ProfilerSettings settings_;
+    std::atomic<bool> running_{false};
+    std::mutex wait_mutex_;
+    std::condition_variable wait_cv_;
+    bool stop_requested_ = false;
+    std::atomic<uint64_t> profiles_{0};
+    std::atomic<uint64_t> last_samples_{0};
+    std::atomic<uint64_t> last_dropped_{0};
+};
+
+} // namespace aeronautical
@@ -1,60 +1,63 @@
 #include "Project.h"
-#include <sstream>
-#include <iomanip>
-#include <ctime>
+#include "EnumNames.h"
+#include "JsonWriter.h"
+#include "Timestamp.h"
 
 namespace aeronautical {
 
+// Enum conversion functions
+namespace {
+
+constexpr EnumNames<ProjectStatus, 6> kProjectStatuses({{
+    {ProjectStatus::Created, "Created"},
+    {ProjectStatus::Pending, "Pending"},
+    {ProjectStatus::UnderReview, "Under_Review"},
+    {ProjectStatus::Accepted, "Accepted"},
+    {ProjectStatus::Refused, "Refused"},
+    {ProjectStatus::Cancelled, "Cancelled"}}},
+    ProjectStatus::Created);
+
+constexpr EnumNames<ProjectPriority, 4> kProjectPriorities({{
+    {ProjectPriority::Low, "Low"},
+    {ProjectPriority::Normal, "Normal"},
+    {ProjectPriority::High, "High"},
+    {ProjectPriority::Critical, "Critical"}}},
+    ProjectPriority::Normal);
+
+} // namespace
+
+std::string_view statusName(ProjectStatus status) {
+    return kProjectStatuses.name(status);
+}
+
 std::string statusToString(ProjectStatus status) {
-    switch (status) {
-        case ProjectStatus::Created: return "Created";
-        case ProjectStatus::Pending: return "Pending";
-        case ProjectStatus::UnderReview: return "Under_Review";
-        case ProjectStatus::Accepted: return "Accepted";
-        case ProjectStatus::Refused: return "Refused";
-        case ProjectStatus::Cancelled: return "Cancelled";
-        default: return "Created";
-    }
+    return std::string(kProjectStatuses.name(status));
+}
+
+ProjectStatus stringToStatus(std::string_view str) {
+    return kProjectStatuses.parse(str);
 }
 
-ProjectStatus stringToStatus(const std::string& str) {
-    if (str == "Pending") return ProjectStatus::Pending;
-    if (str == "Under_Review") return ProjectStatus::UnderReview;
-    if (str == "Accepted") return ProjectStatus::Accepted;
-    if (str == "Refused") return ProjectStatus::Refused;
-    if (str == "Cancelled") return ProjectStatus::Cancelled;
-    return ProjectStatus::Created;
+std::string_view priorityName(ProjectPriority priority) {
+    return kProjectPriorities.name(priority);
 }
 
 std::string priorityToString(ProjectPriority priority) {
-    switch (priority) {
-        case ProjectPriority::Low: return "Low";
-        case ProjectPriority::Normal: return "Normal";
-        case ProjectPriority::High: return "High";
-        case ProjectPriority::Critical: return "Critical";
-        default: return "Normal";
-    }
+    return std::string(kProjectPriorities.name(priority));
 }
 
-ProjectPriority stringToPriority(const std::string& str) {
-    if (str == "Low") return ProjectPriority::Low;
-    if (str == "High") return ProjectPriority::High;
-    if (str == "Critical") return ProjectPriority::Critical;
-    return ProjectPriority::Normal;
+ProjectPriority stringToPriority(std::string_view str) {
+    return kProjectPriorities.parse(str);
 }
 
 std::string timePointToString(const std::chrono::system_clock::time_point& tp) {
-    auto time_t = std::chrono::system_clock::to_time_t(tp);
-    std::stringstream ss;
-    ss << std::put_time(std::localtime(&time_t), "%Y-%m-%d %H:%M:%S");
-    return ss.str();
+    return formatTimestamp(tp);
 }
 
 std::chrono::system_clock::time_point stringToTimePoint(const std::string& str) {
-    std::tm tm = {};
-    std::istringstream ss(str);
-    ss >> std::get_time(&tm, "%Y-%m-%d %H:%M:%S");
-    return std::chrono::system_clock::from_time_t(std::mktime(&tm));
+    std::chrono::system_clock::time_point tp{};
+    parseTimestamp(str, tp);
+    return tp;
 }
 
 nlohmann::json Project::toJson() const {
@@ -90,6 +93,39 @@ nlohmann::json Project::toJson() const {
     return j;
 }
 
+// Keys in sorted order, as nlohmann's object dumps them; unset optionals are omitted
+void Project::writeJson(JsonWriter& writer) const {
+    writer.beginObject();
+    if (altitude_max) writer.rawField("altitude_max", *altitude_max);
+    if (altitude_min) writer.rawField("altitude_min", *altitude_min);
+    if (approval_date) writer.rawField("approval_date", *approval_date);
+    if (assigned_reviewer_id) writer.rawField("assigned_reviewer_id", *assigned_reviewer_id);
+    if (comment) writer.rawField("comment", *comment);
+    writer.rawField("conflict_count", conflict_count);
+    writer.rawField("created_at", created_at);
+    writer.rawField("demander_email", demander_email);
+    writer.rawField("demander_id", demander_id);
+    writer.rawField("demander_name", demander_name);
+    if (demander_organization) writer.rawField("demander_organization", *demander_organization);
+    if (demander_phone) writer.rawField("demander_phone", *demander_phone);
+    if (description) writer.rawField("description", *description);
+    writer.rawField("document_count", document_count);
+    if (end_date) writer.rawField("end_date", *end_date);
+    writer.rawField("geometry_count", geometry_count);
+    writer.rawField("id", id);
+    if (internal_notes) writer.rawField("internal_notes", *internal_notes);
+    if (operation_type) writer.rawField("operation_type", *operation_type);
+    writer.rawField("priority", priorityName(priority));
+    writer.rawField("project_code", project_code);
+    if (rejection_reason) writer.rawField("rejection_reason", *rejection_reason);
+    if (review_deadline) writer.rawField("review_deadline", *review_deadline);
+    if (start_date) writer.rawField("start_date", *start_date);
+    writer.rawField("status", statusName(status));
+    writer.rawField("title", title);
+    writer.rawField("updated_at", updated_at);
+    writer.endObject();
+}
+
 Project Project::fromJson(const nlohmann::json& j) {
     Project p;
     
@@ -105,8 +141,8 @@ Project Project::fromJson(const nlohmann::json& j) {
     if (j.contains("demander_email")) p.demander_email = j["demander_email"];
     if (j.contains("demander_phone") && !j["demander_phone"].is_null()) 
         p.demander_phone = j["demander_phone"];
-    if (j.contains("status")) p.status = stringToStatus(j["status"]);
-    if (j.contains("priority")) p.priority = stringToPriority(j["priority"]);
+    if (j.contains("status")) p.status = stringToStatus(j["status"].get_ref<const std::string&>());
+    if (j.contains("priority")) p.priority = stringToPriority(j["priority"].get_ref<const std::string&>());
     if (j.contains("operation_type") && !j["operation_type"].is_null()) 
         p.operation_type = j["operation_type"];
     if (j.contains("altitude_min") && !j["altitude_min"].is_null()) 
@@ -1,12 +1,15 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <optional>
 #include <chrono>
 #include <json.hpp>
 
 namespace aeronautical {
 
+class JsonWriter;
+
 enum class ProjectStatus {
     Created,
     Pending,
@@ -23,11 +26,14 @@ enum class ProjectPriority {
     Critical
 };
 
-// Convert enums to/from strings
+// Convert enums to/from strings. *Name returns a view of a static string;
+// unknown names parse to the enum's default.
+std::string_view statusName(ProjectStatus status);
 std::string statusToString(ProjectStatus status);
-ProjectStatus stringToStatus(const std::string& str);
+ProjectStatus stringToStatus(std::string_view str);
+std::string_view priorityName(ProjectPriority priority);
 std::string priorityToString(ProjectPriority priority);
-ProjectPriority stringToPriority(const std::string& str);
+ProjectPriority stringToPriority(std::string_view str);
 
 struct Project {
     int id;
@@ -62,6 +68,8 @@ struct Project {
     
     // Convert to/from JSON
     nlohmann::json toJson() const;
+    // Same output as toJson().dump(), written straight into the writer
+    void writeJson(JsonWriter& writer) const;
     static Project fromJson(const nlohmann::json& j);
 };
 
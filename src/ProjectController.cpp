@@ -1,11 +1,51 @@
 #include "ProjectController.h"
+#include "JsonWriter.h"
 #include <json.hpp>
+#include <algorithm>
 #include <spdlog/sinks/stdout_color_sinks.h>
 #include "DatabaseManager.h"
+#include "AnalysisJobQueue.h"
+#include "ConditionalGet.h"
+#include "GeometryEncoder.h"
+#include "GeoJsonReader.h"
+#include "CoordinateNormalizer.h"
+#include "VertexReducer.h"
+#include "DbExecutor.h"
+#include "ResultCache.h"
+#include "Tracing.h"
+#include "TokenVerifier.h"
+#include "OgrHandles.h"
+#include "GeometryBlob.h"
+#include "ProjectSpatialIndex.h"
+#include "ProjectSearchIndex.h"
+#include <charconv>
+#include <cmath>
+#include <cstring>
 
 
 namespace aeronautical {
 
+namespace {
+
+// Exactly count comma-separated finite numbers
+bool parseNumberList(const char* text, size_t count, std::vector<double>& values) {
+    values.clear();
+    const char* p = text;
+    const char* end = text + std::strlen(text);
+    while (values.size() < count) {
+        double value = 0;
+        auto [next, ec] = std::from_chars(p, end, value);
+        if (ec != std::errc() || !std::isfinite(value)) return false;
+        values.push_back(value);
+        p = next;
+        if (p == end) break;
+        if (*p++ != ',') return false;
+    }
+    return values.size() == count && p == end;
+}
+
+} // namespace
+
 ProjectController::ProjectController() 
     : repository_(std::make_unique<ProjectRepository>()) {
     // Fixed spdlog initialization
@@ -23,61 +63,68 @@ ProjectController::ProjectController()
     }
 }
 
-void ProjectController::registerRoutes(crow::SimpleApp& app) {
+void ProjectController::registerRoutes(HttpApp& app) {
     // GET /api/projects
     CROW_ROUTE(app, "/api/projects")
         .methods(crow::HTTPMethod::GET)
-        ([this](const crow::request& req) {
-            return getProjects(req);
+        ([this](const crow::request& req, crow::response& res) {
+            DbExecutor::getInstance().respond(req, res, [this, &req]() { return getProjects(req); });
+        });
+    
+    // GET /api/projects/search?q= - ranked text search with facet counts
+    CROW_ROUTE(app, "/api/projects/search")
+        .methods(crow::HTTPMethod::GET)
+        ([this](const crow::request& req, crow::response& res) {
+            DbExecutor::getInstance().respond(req, res, [this, &req]() { return searchProjects(req); });
         });
     
     // GET /api/projects/:id
     CROW_ROUTE(app, "/api/projects/<int>")
         .methods(crow::HTTPMethod::GET)
-        ([this](int id) {
-            return getProject(id);
+        ([this](const crow::request& req, crow::response& res, int id) {
+            DbExecutor::getInstance().respond(req, res, [this, id]() { return getProject(id); });
         });
     
     // GET /api/projects/code/:code
     CROW_ROUTE(app, "/api/projects/code/<string>")
         .methods(crow::HTTPMethod::GET)
-        ([this](const std::string& code) {
-            return getProjectByCode(code);
+        ([this](const crow::request& req, crow::response& res, const std::string& code) {
+            DbExecutor::getInstance().respond(req, res, [this, code]() { return getProjectByCode(code); });
         });
     
     // POST /api/projects
     CROW_ROUTE(app, "/api/projects")
         .methods(crow::HTTPMethod::POST)
-        ([this](const crow::request& req) {
-            return createProject(req);
+        ([this](const crow::request& req, crow::response& res) {
+            DbExecutor::getInstance().respond(req, res, [this, &req]() { return createProject(req); });
         });
     
     // PUT /api/projects/:id
     CROW_ROUTE(app, "/api/projects/<int>")
         .methods(crow::HTTPMethod::PUT)
-        ([this](const crow::request& req, int id) {
-            return updateProject(id, req);
+        ([this](const crow::request& req, crow::response& res, int id) {
+            DbExecutor::getInstance().respond(req, res, [this, &req, id]() { return updateProject(id, req); });
         });
     
     // DELETE /api/projects/:id
     CROW_ROUTE(app, "/api/projects/<int>")
         .methods(crow::HTTPMethod::DELETE)
-        ([this](int id) {
-            return deleteProject(id);
+        ([this](const crow::request& req, crow::response& res, int id) {
+            DbExecutor::getInstance().respond(req, res, [this, id]() { return deleteProject(id); });
         });
 
         // POST /api/projects/:id/submit
     CROW_ROUTE(app, "/api/projects/<int>/submit")
         .methods(crow::HTTPMethod::POST)
-        ([this](const crow::request& req, int id) {
-            return submitProject(id, req);
+        ([this](const crow::request& req, crow::response& res, int id) {
+            DbExecutor::getInstance().respond(req, res, [this, &req, id]() { return submitProject(id, req); });
         });
     
         // GET /api/projects/:id/geometries
     CROW_ROUTE(app, "/api/projects/<int>/geometries")
         .methods(crow::HTTPMethod::GET)
-        ([this](int id) {
-            return getProjectGeometries(id);
+        ([this](const crow::request& req, crow::response& res, int id) {
+            DbExecutor::getInstance().respond(req, res, [this, &req, id]() { return getProjectGeometries(req, id); });
         });
 
     logger_->info("Project routes registered");
@@ -110,20 +157,98 @@ crow::response ProjectController::getProjects(const crow::request& req) {
         if (query.get("offset")) {
             filter.offset = std::stoi(query.get("offset"));
         }
-        
+
+        if (query.get("after")) {
+            filter.after = PageCursor::decode(query.get("after"));
+            if (!filter.after || !ProjectRepository::isValidCursor(*filter.after)) {
+                return errorResponse(400, "Invalid after cursor");
+            }
+        }
+
+        // Spatial filters over the feature envelopes: bbox=min_lng,min_lat,max_lng,max_lat
+        // and near=lat,lng,radius_km; both given means projects matching both
+        if (query.get("bbox") || query.get("near")) {
+            auto& index = ProjectSpatialIndex::getInstance();
+            if (!index.loaded()) {
+                auto res = errorResponse(503, "Project spatial index is loading, please retry later");
+                res.add_header("Retry-After", "5");
+                return res;
+            }
+            std::vector<double> values;
+            if (query.get("bbox")) {
+                std::optional<GeoBounds> bounds;
+                if (parseNumberList(query.get("bbox"), 4, values)) {
+                    bounds = GeoBounds::fromBox(values[1], values[3], values[0], values[2]);
+                }
+                if (!bounds) {
+                    return errorResponse(400, "bbox must be min_lng,min_lat,max_lng,max_lat");
+                }
+                filter.ids = index.intersecting(*bounds);
+            }
+            if (query.get("near")) {
+                if (!parseNumberList(query.get("near"), 3, values) || values[0] < -90.0 || values[0] > 90.0 ||
+                    values[2] <= 0.0 || values[2] > 20015.1) {
+                    return errorResponse(400, "near must be lat,lng,radius_km with a radius up to 20015 km");
+                }
+                auto near = index.near(values[0], values[1], values[2]);
+                if (filter.ids) {
+                    std::vector<int> both;
+                    std::set_intersection(filter.ids->begin(), filter.ids->end(), near.begin(), near.end(),
+                                          std::back_inserter(both));
+                    near = std::move(both);
+                }
+                filter.ids = std::move(near);
+            }
+        }
+
+        auto total_mode = parseTotalMode(query.get("total"));
+        if (!total_mode) {
+            return errorResponse(400, "total must be exact, approx or none");
+        }
+        // Approximate totals are shared per filter; a spatial match is counted exactly
+        if (filter.ids && *total_mode == TotalMode::Approximate) {
+            total_mode = TotalMode::Exact;
+        }
+
+        // One row past the page tells whether there is a next one
+        const int limit = std::max(filter.limit, 1);
+        filter.limit = limit + 1;
         auto projects = repository_->findAll(filter);
-        int total = repository_->count(filter);
+        std::optional<PageCursor> next;
+        if (projects.size() > static_cast<size_t>(limit)) {
+            projects.resize(limit);
+            next = ProjectRepository::cursorAfter(projects.back());
+        }
+        filter.limit = limit;
+
+        std::optional<int> total;
+        if (*total_mode == TotalMode::Exact) {
+            total = repository_->count(filter);
+        } else if (*total_mode == TotalMode::Approximate) {
+            const std::string key = (filter.status ? statusToString(*filter.status) : "") + "|" +
+                                    (filter.demander_id ? std::to_string(*filter.demander_id) : "") + "|" +
+                                    (filter.priority ? priorityToString(*filter.priority) : "");
+            total = ListCountCache::getInstance().get(ListCountCache::Table::Projects, key,
+                                                      [&]() { return repository_->count(filter); });
+        }
         
-        nlohmann::json response;
-        response["data"] = nlohmann::json::array();
+        // Write each project straight into the body instead of a DOM of the page
+        std::string body;
+        JsonWriter writer(body);
+        writer.beginObject().key("data").beginArray();
         for (const auto& project : projects) {
-            response["data"].push_back(project.toJson());
+            project.writeJson(writer);
+        }
+        writer.endArray()
+              .field("limit", filter.limit)
+              .field("offset", filter.after ? 0 : filter.offset)
+              .field("next_cursor", next ? std::optional<std::string>(next->encode()) : std::nullopt);
+        if (total) {
+            writer.field("total", *total).field("total_approximate", *total_mode == TotalMode::Approximate);
         }
-        response["total"] = total;
-        response["limit"] = filter.limit;
-        response["offset"] = filter.offset;
+        writer.endObject();
         
-        return successResponse(response);
+        return successResponse(std::move(body));
         
     } catch (const std::exception& e) {
         logger_->error("Failed to get projects: {}", e.what());
@@ -131,16 +256,91 @@ crow::response ProjectController::getProjects(const crow::request& req) {
     }
 }
 
+crow::response ProjectController::searchProjects(const crow::request& req) {
+    try {
+        auto& index = ProjectSearchIndex::getInstance();
+        if (!index.loaded()) {
+            auto res = errorResponse(503, "Project search index is loading, please retry later");
+            res.add_header("Retry-After", "5");
+            return res;
+        }
+
+        ProjectSearchQuery search;
+        auto query = crow::query_string(req.url_params);
+        if (query.get("q")) {
+            search.text = query.get("q");
+        }
+        if (query.get("status")) {
+            search.status = stringToStatus(query.get("status"));
+        }
+        if (query.get("priority")) {
+            search.priority = stringToPriority(query.get("priority"));
+        }
+        if (query.get("operation_type")) {
+            search.operation_type = query.get("operation_type");
+        }
+        if (query.get("limit")) {
+            search.limit = static_cast<size_t>(std::clamp(std::stoi(query.get("limit")), 1, 100));
+        }
+        if (query.get("offset")) {
+            search.offset = static_cast<size_t>(std::max(0, std::stoi(query.get("offset"))));
+        }
+
+        auto result = index.search(search);
+
+        // The page's rows are read fresh, then put back in rank order
+        std::vector<Project> projects;
+        if (!result.hits.empty()) {
+            ProjectFilter filter;
+            filter.ids = std::vector<int>();
+            for (const auto& hit : result.hits) {
+                filter.ids->push_back(hit.project_id);
+            }
+            filter.limit = static_cast<int>(result.hits.size());
+            projects = repository_->findAll(filter);
+        }
+        std::unordered_map<int, const Project*> by_id;
+        for (const auto& project : projects) {
+            by_id.emplace(project.id, &project);
+        }
+
+        nlohmann::json data = nlohmann::json::array();
+        for (const auto& hit : result.hits) {
+            auto found = by_id.find(hit.project_id);
+            if (found == by_id.end()) continue; // deleted through another instance
+            nlohmann::json item = found->second->toJson();
+            item["score"] = hit.score;
+            data.push_back(std::move(item));
+        }
+
+        nlohmann::json response;
+        response["data"] = std::move(data);
+        response["total"] = result.total;
+        response["limit"] = search.limit;
+        response["offset"] = search.offset;
+        response["facets"] = result.facets;
+        return successResponse(response);
+
+    } catch (const std::logic_error&) {
+        return errorResponse(400, "limit and offset must be integers");
+    } catch (const std::exception& e) {
+        logger_->error("Failed to search projects: {}", e.what());
+        return errorResponse(500, "Internal server error");
+    }
+}
+
 crow::response ProjectController::getProject(int id) {
     try {
-        auto project = repository_->findById(id);
+        auto project = ResultCache::getInstance().get<std::optional<Project>>(
+            "project.byId:" + std::to_string(id), {ResultCache::projectTag(id)},
+            [&]() { return repository_->findById(id); });
         
-        if (!project) {
+        if (!*project) {
             return errorResponse(404, "Project not found");
         }
         
         nlohmann::json response;
-        response["data"] = project->toJson();
+        response["data"] = (*project)->toJson();
         
         return successResponse(response);
         
@@ -169,21 +369,57 @@ crow::response ProjectController::getProjectByCode(const std::string& code) {
     }
 }
 
-crow::response ProjectController::getProjectGeometries(int project_id) {
+crow::response ProjectController::getProjectGeometries(const crow::request& req, int project_id) {
     try {
+        std::optional<int> precision;
+        std::string encodingError;
+        if (!GeometryEncoder::fromRequest(req, precision, encodingError)) {
+            return errorResponse(400, encodingError);
+        }
+
+        // One indexed lookup of the primary row decides 304 before the collection is read
+        std::optional<CacheValidator> validator;
+        std::string cache_key;
+        auto revision = ResultCache::getInstance().get<std::optional<std::string>>(
+            "project.geometryRevision:" + std::to_string(project_id), {ResultCache::projectTag(project_id)},
+            [&]() { return repository_->findGeometryRevision(project_id); });
+        if (*revision) {
+            cache_key = "geom-" + std::to_string(project_id) + "-" + **revision;
+            validator = ConditionalGet::fromVersion("geom-" + std::to_string(project_id), **revision);
+            if (ConditionalGet::isCurrent(req, *validator)) {
+                return ConditionalGet::notModified(*validator);
+            }
+        }
+        auto tagged = [&](crow::response res) {
+            if (validator) ConditionalGet::tag(res, *validator);
+            return res;
+        };
+
         auto geometry_json_str = repository_->findGeometriesByProjectId(project_id);
         
         if (geometry_json_str) {
-            // If geometry is found, return it as JSON
+            // Stored collections are validated and dumped by saveOrUpdateProjectGeometryCollection,
+            // so send the text as-is instead of a parse/dump round trip of the whole collection
+            if (JsonWriter::looksLikeContainer(*geometry_json_str)) {
+                if (precision) {
+                    return tagged(successResponse(
+                        GeometryEncoder::getInstance().encode(cache_key, *geometry_json_str, *precision)));
+                }
+                return tagged(successResponse(std::move(*geometry_json_str)));
+            }
+            logger_->warn("Stored geometry for project {} is not a JSON object, re-parsing", project_id);
             auto json_response = nlohmann::json::parse(*geometry_json_str);
-            return successResponse(json_response);
+            if (precision) {
+                return tagged(successResponse(GeometryEncoder::encodeGeoJson(json_response.dump(), *precision)));
+            }
+            return tagged(successResponse(json_response));
         } else {
             // If no geometry is found, return an empty FeatureCollection
             nlohmann::json empty_collection = {
                 {"type", "FeatureCollection"},
                 {"features", nlohmann::json::array()}
             };
-            return successResponse(empty_collection);
+            return tagged(successResponse(empty_collection));
         }
         
     } catch (const std::exception& e) {
@@ -200,6 +436,10 @@ crow::response ProjectController::createProject(const crow::request& req) {
             return errorResponse(401, authError);
         }
         
+        if (req.body.size() > upload_limits_.max_body_bytes) {
+            return errorResponse(413, "Request body exceeds " + std::to_string(upload_limits_.max_body_bytes) + " bytes");
+        }
+
         // Parse request body
         auto body = nlohmann::json::parse(req.body);
         
@@ -214,6 +454,8 @@ crow::response ProjectController::createProject(const crow::request& req) {
         
         // Save to database
         auto created = repository_->create(project);
+        ListCountCache::getInstance().bump(ListCountCache::Table::Projects);
+        ResultCache::getInstance().invalidate(ResultCache::projectTag(created.id));
         
         nlohmann::json response;
         response["data"] = created.toJson();
@@ -246,6 +488,10 @@ crow::response ProjectController::updateProject(int id, const crow::request& req
             return errorResponse(404, "Project not found");
         }
         
+        if (req.body.size() > upload_limits_.max_body_bytes) {
+            return errorResponse(413, "Request body exceeds " + std::to_string(upload_limits_.max_body_bytes) + " bytes");
+        }
+
         // Parse request body
         auto body = nlohmann::json::parse(req.body);
         
@@ -266,6 +512,13 @@ crow::response ProjectController::updateProject(int id, const crow::request& req
         if (!updated) {
             return errorResponse(500, "Failed to update project");
         }
+        ListCountCache::getInstance().bump(ListCountCache::Table::Projects);
+        ResultCache::getInstance().invalidate(ResultCache::projectTag(id));
+        if (project.status != existing->status) {
+            addProjectComment(id, "Status changed from " + statusToString(existing->status) + " to " +
+                                      statusToString(project.status),
+                              existing->status, project.status);
+        }
         
         // Get updated project
         auto updatedProject = repository_->findById(id);
@@ -300,6 +553,9 @@ crow::response ProjectController::deleteProject(int id) {
         if (!deleted) {
             return errorResponse(404, "Project not found");
         }
+        ProjectSpatialIndex::getInstance().remove(id);
+        ListCountCache::getInstance().bump(ListCountCache::Table::Projects);
+        ResultCache::getInstance().invalidate(ResultCache::projectTag(id));
         
         nlohmann::json response;
         response["message"] = "Project deleted successfully";
@@ -322,56 +578,132 @@ crow::response ProjectController::submitProject(int id, const crow::request& req
             return errorResponse(401, authError);
         }
         
-        // Parse request body
-        auto body = nlohmann::json::parse(req.body);
+        if (req.body.size() > upload_limits_.max_body_bytes) {
+            return errorResponse(413, "Request body exceeds " + std::to_string(upload_limits_.max_body_bytes) + " bytes");
+        }
         
         // Check if project exists
         auto project = repository_->findById(id);
         if (!project) {
             return errorResponse(404, "Project not found");
         }
-        
-        // Validate and save GeoJSON if provided
-        if (body.contains("geometry") && !body["geometry"].is_null()) {
+
+        // Refuse early when the analysis backlog is full, before touching the project
+        auto& jobQueue = AnalysisJobQueue::getInstance();
+        if (jobQueue.full()) {
+            return busyResponse();
+        }
+
+        // Parse request body one feature at a time: each is validated,
+        // repaired and serialized as soon as it is read, so a large
+        // collection is never held as a whole DOM
+        const bool per_feature = ProjectRepository::probeFeatureTable();
+        nlohmann::json body;
+        std::vector<ProjectRepository::FeatureText> features;
+        nlohmann::json legacy_features = nlohmann::json::array();
+        {
+            Span span("json.parse");
+            span.setAttribute("bytes", static_cast<int64_t>(req.body.size()));
+            size_t index = 0;
+            auto onFeature = [&](nlohmann::json& feature, std::string& error) {
+                std::string geometryError;
+                if (!validateGeoJSON(feature, geometryError)) {
+                    error = "Invalid GeoJSON: " + geometryError;
+                    return false;
+                }
+                if (per_feature) {
+                    features.push_back(ingestFeature(feature, index));
+                } else {
+                    legacy_features.push_back(std::move(feature));
+                }
+                index++;
+                return true;
+            };
+            std::string error;
+            size_t vertices = 0;
+            const auto status = FeatureStream::read(req.body, upload_limits_, body, onFeature, error, &vertices);
+            span.setAttribute("features", static_cast<int64_t>(index));
+            span.setAttribute("vertices", static_cast<int64_t>(vertices));
+            switch (status) {
+                case FeatureStream::Status::Ok:
+                    break;
+                case FeatureStream::Status::Malformed:
+                    logger_->error("Invalid JSON in submit project request: {}", error);
+                    return errorResponse(400, "Invalid JSON format");
+                case FeatureStream::Status::TooLarge:
+                    return errorResponse(413, error);
+                case FeatureStream::Status::Rejected:
+                    return errorResponse(400, error);
+            }
+        }
+
+        const bool has_geometry = body.contains("geometry") && !body["geometry"].is_null();
+        const bool is_collection = has_geometry && body["geometry"].is_object() &&
+                                   body["geometry"].value("type", "") == "FeatureCollection";
+        if (has_geometry && !is_collection) {
             std::string geometryError;
             if (!validateGeoJSON(body["geometry"], geometryError)) {
                 return errorResponse(400, "Invalid GeoJSON: " + geometryError);
             }
-            
-            // 👇 REPLACE the old saveProjectGeometry call with the new one
-            if (!saveOrUpdateProjectGeometryCollection(id, body["geometry"])) {
-                return errorResponse(500, "Failed to save project geometry");
-            }
         }
-        
-        // Update project status to Pending
-        project->status = ProjectStatus::Pending;
-        project->updated_at = std::chrono::system_clock::now();
+        if (has_geometry && !per_feature && body["geometry"].contains("features")) {
+            body["geometry"]["features"] = std::move(legacy_features);
+        }
 
+        SPDLOG_LOGGER_DEBUG(logger_, "Received geometry payload for project ID {} ({} bytes)", id, req.body.size());
 
-        //dumping the body for debug purposes : this should be removed for production
-        logger_->info("Received geometry payload for project ID {}:\n{}", id, body.dump(2));
+        // Geometry, status and comment commit together, before the analysis
+        // job can read them from another connection
+        {
+            DatabaseManager::Transaction transaction(DatabaseManager::getInstance());
 
-        
-        // Save the updated project
-        bool updated = repository_->update(id, *project);
-        
-        if (!updated) {
-            return errorResponse(500, "Failed to submit project");
+            if (is_collection && per_feature) {
+                Span span("geometry.store");
+                if (!repository_->saveFeatures(id, features)) {
+                    return errorResponse(500, "Failed to save project geometry");
+                }
+            } else if (has_geometry && !saveOrUpdateProjectGeometryCollection(id, body["geometry"])) {
+                return errorResponse(500, "Failed to save project geometry");
+            }
+
+            // Update project status to Pending
+            project->status = ProjectStatus::Pending;
+            project->updated_at = std::chrono::system_clock::now();
+            if (!repository_->update(id, *project)) {
+                return errorResponse(500, "Failed to submit project");
+            }
+
+            if (!transaction.commit()) {
+                return errorResponse(500, "Failed to submit project");
+            }
+        }
+        // The submission is the record the review starts from, so it waits for the row
+        if (!addProjectComment(id, "Project submitted for review", ProjectStatus::Created, ProjectStatus::Pending,
+                               AuditWriter::Durability::Durable)) {
+            logger_->error("Project {} submitted without its status change comment", id);
+        }
+        if (has_geometry) {
+            ProjectSpatialIndex::getInstance().refresh(*repository_, id);
         }
+        ListCountCache::getInstance().bump(ListCountCache::Table::Projects);
+        ResultCache::getInstance().invalidate(ResultCache::projectTag(id));
 
-        // ✨ LAUNCH CONFLICT DETECTION IN THE BACKGROUND
-        logger_->info("Launching background conflict analysis for project ID: {}", id);
-        std::async(std::launch::async, &ConflictController::analyzeProject, &ConflictController::getInstance(), id);        
-        
-        // Add project comment for status change
-        addProjectComment(id, "Project submitted for review", ProjectStatus::Created, ProjectStatus::Pending);
+        // ✨ QUEUE CONFLICT DETECTION IN THE BACKGROUND
+        auto jobId = jobQueue.enqueue(id, project->priority, project->review_deadline,
+                                      project->demander_organization.value_or(""));
+        if (!jobId) {
+            logger_->warn("Analysis queue full, project {} left pending", id);
+            return busyResponse();
+        }
+        logger_->info("Queued background conflict analysis job {} for project ID: {}", *jobId, id);
         
          // 3. Immediately return a 202 Accepted response
         // This tells the client the request was accepted and is being processed.
         nlohmann::json response;
         response["message"] = "Project submission accepted. Analysis is in progress.";
         response["data"] = project->toJson(); // Return the project in its "Pending" state
+        response["job_id"] = *jobId;
+        response["status_url"] = "/api/analysis/jobs/" + std::to_string(*jobId);
         
         // Use status code 202 for "Accepted"
         crow::response res(202, response.dump());
@@ -394,7 +726,25 @@ bool ProjectController::saveOrUpdateProjectGeometryCollection(int project_id, co
     }
 
     try {
+        // Per-feature storage writes only the features this request carries
+        if (ProjectRepository::probeFeatureTable()) {
+            std::vector<ProjectRepository::FeatureText> features;
+            {
+                Span span("geometry.validate");
+                const auto& incoming = incoming_geojson["features"];
+                span.setAttribute("features", static_cast<int64_t>(incoming.size()));
+                features.reserve(incoming.size());
+                for (size_t i = 0; i < incoming.size(); i++) {
+                    nlohmann::json feature = incoming[i];
+                    features.push_back(ingestFeature(feature, i));
+                }
+            }
+            Span span("geometry.store");
+            return repository_->saveFeatures(project_id, features);
+        }
+
         auto& db = DatabaseManager::getInstance();
+        DatabaseManager::Transaction transaction(db);
         nlohmann::json final_collection;
 
         // 1. First, DELETE existing primary geometry for this project
@@ -402,27 +752,27 @@ bool ProjectController::saveOrUpdateProjectGeometryCollection(int project_id, co
         std::string delete_query = "DELETE FROM project_geometries WHERE project_id = " + 
                                   std::to_string(project_id) + " AND is_primary = 1";
         db.executeQuery(delete_query);
-        logger_->debug("Deleted existing primary geometry for project {}", project_id);
+        SPDLOG_LOGGER_DEBUG(logger_, "Deleted existing primary geometry for project {}", project_id);
 
         // 2. Check if there was a previous collection to merge with
         // (Optional: if you want to preserve non-primary geometries)
         std::string select_query = "SELECT geometry_data FROM project_geometries WHERE project_id = " + 
                                    std::to_string(project_id) + " ORDER BY created_at DESC LIMIT 1";
-        MYSQL_RES* result = db.executeSelectQuery(select_query);
+        MysqlResult result = db.executeSelectQuery(select_query);
         
-        if (result && mysql_num_rows(result) > 0) {
-            MYSQL_ROW row = mysql_fetch_row(result);
+        if (result && mysql_num_rows(result.get()) > 0) {
+            MYSQL_ROW row = mysql_fetch_row(result.get());
             if (row && row[0]) {
                 // An existing collection was found, parse it
                 try {
-                    final_collection = nlohmann::json::parse(row[0]);
-                    logger_->debug("Found existing geometry collection for project {}. Merging.", project_id);
+                    unsigned long* lengths = mysql_fetch_lengths(result.get());
+                    final_collection = nlohmann::json::parse(GeometryBlob::view(row[0], lengths[0]));
+                    SPDLOG_LOGGER_DEBUG(logger_, "Found existing geometry collection for project {}. Merging.", project_id);
                 } catch (...) {
                     // If parsing fails, start fresh
                     final_collection = nlohmann::json::object();
                 }
             }
-            mysql_free_result(result);
         }
 
         // 3. Ensure we have a valid FeatureCollection structure
@@ -433,12 +783,47 @@ bool ProjectController::saveOrUpdateProjectGeometryCollection(int project_id, co
             });
         }
 
-        // 4. Add all new features from the incoming request
+        // 4. Merge the incoming features by id: a known id replaces that
+        //    feature (a null geometry removes it), anything else is appended
+        //    under the next free numeric id so it keeps one across resubmissions
+        auto& features = final_collection["features"];
+        int64_t next_id = 1;
+        for (const auto& feature : features) {
+            if (feature.contains("id") && feature["id"].is_number_integer()) {
+                next_id = std::max(next_id, feature["id"].get<int64_t>() + 1);
+            }
+        }
+        for (auto& feature : features) {
+            if (!feature.contains("id") || feature["id"].is_null()) {
+                feature["id"] = next_id++;
+            }
+        }
         for (const auto& feature : incoming_geojson["features"]) {
-            final_collection["features"].push_back(feature);
+            auto existing = features.end();
+            if (feature.contains("id") && !feature["id"].is_null()) {
+                existing = std::find_if(features.begin(), features.end(),
+                                        [&](const nlohmann::json& f) { return f["id"] == feature["id"]; });
+            }
+            const bool removed = !feature.contains("geometry") || feature["geometry"].is_null();
+            if (existing != features.end()) {
+                if (removed) {
+                    features.erase(existing);
+                } else {
+                    *existing = feature;
+                }
+            } else if (!removed) {
+                features.push_back(feature);
+                if (!feature.contains("id") || feature["id"].is_null()) {
+                    features.back()["id"] = next_id++;
+                }
+            }
         }
         
-        // 5. Prepare the data for INSERT (not UPSERT)
+        // 5. Validate once here instead of on every analysis
+        const std::vector<bool> repaired = repairFeatureGeometries(features);
+        const bool validated = std::all_of(repaired.begin(), repaired.end(), [](bool valid) { return valid; });
+
+        // 6. Prepare the data for INSERT (not UPSERT)
         std::string geo_json_string = final_collection.dump();
         std::string escaped_json = geo_json_string;
         
@@ -451,22 +836,31 @@ bool ProjectController::saveOrUpdateProjectGeometryCollection(int project_id, co
 
         std::string project_name = "Aggregated Project Geometry";
         
-        // 6. Execute a simple INSERT query
+        // 7. Execute a simple INSERT query
+        const bool flag = ProjectRepository::probeValidatedColumn();
         std::stringstream query;
         query << "INSERT INTO project_geometries "
-              << "(project_id, name, geometry_data, is_primary, geometry_type, created_at, updated_at) "
+              << "(project_id, name, geometry_data, is_primary, geometry_type, "
+              << (flag ? "geometry_validated, " : "") << "created_at, updated_at) "
               << "VALUES (" 
               << project_id << ", "
               << "'" << project_name << "', "
-              << "'" << escaped_json << "', "
+              << GeometryBlob::packedLiteral(geo_json_string, "project_geometries", "geometry_data")
+                     .value_or("'" + escaped_json + "'") << ", "
               << "1, "
               << "'collection', "
+              << (flag ? (validated ? "1, " : "0, ") : "")
               << "NOW(), NOW())";
 
         if (!db.executeQuery(query.str())) {
             logger_->error("Failed to insert geometry collection for project {}", project_id);
             return false;
         }
+        if (!ProjectRepository::updateCounter(project_id, "geometry_count", std::to_string(features.size())) ||
+            !transaction.commit()) {
+            logger_->error("Failed to commit geometry collection for project {}", project_id);
+            return false;
+        }
 
         logger_->info("Successfully saved/updated geometry collection for project {} with {} features", 
                      project_id, final_collection["features"].size());
@@ -478,6 +872,94 @@ bool ProjectController::saveOrUpdateProjectGeometryCollection(int project_id, co
     }
 }
 
+std::vector<bool> ProjectController::repairFeatureGeometries(nlohmann::json& features) {
+    std::vector<bool> valid(features.size(), true);
+    for (size_t i = 0; i < features.size(); i++) {
+        valid[i] = repairFeatureGeometry(features[i], i);
+    }
+    return valid;
+}
+
+bool ProjectController::repairFeatureGeometry(nlohmann::json& feature, size_t index) {
+    if (!feature.contains("geometry") || !feature["geometry"].is_object()) return true;
+
+    std::vector<GeoJsonFeature> parsed;
+    std::string error;
+    if (!GeoJsonReader::read(feature["geometry"].dump(), parsed, error) || parsed.size() != 1 ||
+        !parsed[0].geometry) {
+        return true;
+    }
+    GeoJsonGeometry& shape = *parsed[0].geometry;
+
+    // Coordinate problems first, without GEOS
+    const auto checked = CoordinateNormalizer::normalize(shape);
+    if (!checked.usable()) {
+        logger_->warn("Feature {} has {} invalid coordinates{}", index, checked.invalid_positions,
+                      checked.collapsed ? " or a line collapsed to one vertex" : "");
+        return false;
+    }
+    if (checked.changed()) {
+        CoordinateNormalizer::writeCoordinates(shape, feature["geometry"]);
+        SPDLOG_LOGGER_DEBUG(logger_, "Feature {}: removed {} repeated vertices, closed {} rings", index,
+                            checked.duplicates_removed, checked.rings_closed);
+    }
+    // Points and lines are valid once their coordinates are
+    if (!checked.has_rings) return true;
+
+    auto geometry = shape.toOGR();
+    if (!geometry || geometry->IsValid()) return true;
+
+    std::unique_ptr<OGRGeometry> fixed(geometry->Buffer(0));
+    CplString json(fixed ? fixed->exportToJson() : nullptr);
+    if (!json) {
+        logger_->warn("Feature {} has an invalid geometry that could not be repaired", index);
+        return false;
+    }
+    feature["geometry"] = nlohmann::json::parse(json.get());
+    logger_->info("Repaired invalid geometry of feature {}", index);
+    return true;
+}
+
+ProjectRepository::FeatureText ProjectController::ingestFeature(nlohmann::json& feature, size_t index) {
+    std::string uploaded;
+    const bool polygonal = reduction_tolerance_m_ && feature.contains("geometry") && feature["geometry"].is_object() &&
+                           feature["geometry"].value("type", "").find("Polygon") != std::string::npos;
+    if (polygonal && ProjectRepository::probeOriginalColumn()) {
+        uploaded = feature.dump();
+    }
+    const bool valid = repairFeatureGeometry(feature, index);
+    auto text = ProjectRepository::FeatureText::of(feature, valid);
+    if (valid && polygonal && reduceFeatureGeometry(feature, index)) {
+        text = ProjectRepository::FeatureText::of(feature, valid);
+        text.original_json = std::move(uploaded);
+    }
+    return text;
+}
+
+bool ProjectController::reduceFeatureGeometry(nlohmann::json& feature, size_t index) {
+    std::vector<GeoJsonFeature> parsed;
+    std::string error;
+    if (!GeoJsonReader::read(feature["geometry"].dump(), parsed, error) || parsed.size() != 1 ||
+        !parsed[0].geometry) {
+        return false;
+    }
+    GeoJsonGeometry& shape = *parsed[0].geometry;
+    const auto reduced = VertexReducer::reduce(shape, *reduction_tolerance_m_);
+    if (reduced.vertices_removed == 0) return false;
+
+    // Dropping a vertex next to another part of the ring can make it cross
+    // itself; such a feature keeps all its vertices
+    auto geometry = shape.toOGR();
+    if (!geometry || !geometry->IsValid()) {
+        SPDLOG_LOGGER_DEBUG(logger_, "Feature {} kept as uploaded: its reduction is not valid", index);
+        return false;
+    }
+    CoordinateNormalizer::writeCoordinates(shape, feature["geometry"]);
+    SPDLOG_LOGGER_DEBUG(logger_, "Feature {}: {} of {} vertices removed", index, reduced.vertices_removed,
+                        reduced.vertices_before);
+    return true;
+}
+
 bool ProjectController::validateGeoJSON(const nlohmann::json& geojson, std::string& error) {
     // Basic GeoJSON validation
     if (!geojson.contains("type")) {
@@ -493,6 +975,10 @@ bool ProjectController::validateGeoJSON(const nlohmann::json& geojson, std::stri
             error = "Feature must have a 'geometry' field";
             return false;
         }
+        // A null geometry removes the stored feature with this id
+        if (geojson["geometry"].is_null() && geojson.contains("id") && !geojson["id"].is_null()) {
+            return true;
+        }
         return validateGeometry(geojson["geometry"], error);
     } else if (type == "FeatureCollection") {
         if (!geojson.contains("features")) {
@@ -763,6 +1249,7 @@ bool ProjectController::saveIndividualGeometry(int project_id, const nlohmann::j
         
         // Prepare geometry data as JSON string
         std::string jsonStr = geometry.dump();
+        const auto packed_json = GeometryBlob::packedLiteral(jsonStr, "project_geometries", "geometry_data");
         
         // Escape single quotes for SQL
         size_t pos = 0;
@@ -802,7 +1289,7 @@ bool ProjectController::saveIndividualGeometry(int project_id, const nlohmann::j
             query << "NULL, ";
         }
         
-        query << "'" << jsonStr << "', ";
+        query << packed_json.value_or("'" + jsonStr + "'") << ", ";
         
         if (centerLat != 0 && centerLng != 0) {
             query << centerLat << ", " << centerLng << ", ";
@@ -823,7 +1310,7 @@ bool ProjectController::saveIndividualGeometry(int project_id, const nlohmann::j
         bool result = db.executeQuery(query.str());
         
         if (result) {
-            logger_->debug("Saved geometry: type={}, name={}, geometry_type={}, primary={}", 
+            SPDLOG_LOGGER_DEBUG(logger_, "Saved geometry: type={}, name={}, geometry_type={}, primary={}", 
                          geoType, geometryName, geometryType, isPrimary);
         }
         
@@ -861,32 +1348,17 @@ double ProjectController::calculatePolygonArea(const nlohmann::json& coordinates
     return area;
 }
 
-void ProjectController::addProjectComment(int project_id, const std::string& comment, 
-                                         ProjectStatus oldStatus, ProjectStatus newStatus) {
-    try {
-        auto& db = DatabaseManager::getInstance();
-        
-        // For now, use a default user_id (1) - you should get this from the authenticated user
-        int user_id = 1; // TODO: Get from JWT token
-        
-        std::stringstream query;
-        query << "INSERT INTO project_comments "
-              << "(project_id, user_id, comment_type, comment, old_status, new_status, is_internal) "
-              << "VALUES ("
-              << project_id << ", "
-              << user_id << ", "
-              << "'status_change', "
-              << "'" << comment << "', "
-              << "'" << statusToString(oldStatus) << "', "
-              << "'" << statusToString(newStatus) << "', "
-              << "0)"; // Not internal
-        
-        db.executeQuery(query.str());
-        
-    } catch (const std::exception& e) {
-        logger_->warn("Failed to add project comment: {}", e.what());
-        // Don't fail the whole operation if comment fails
-    }
+bool ProjectController::addProjectComment(int project_id, const std::string& comment, ProjectStatus oldStatus,
+                                          ProjectStatus newStatus, AuditWriter::Durability durability) {
+    AuditEvent event;
+    event.project_id = project_id;
+    // For now, use a default user_id (1) - you should get this from the authenticated user
+    event.user_id = 1; // TODO: Get from JWT token
+    event.comment = comment;
+    event.old_status = oldStatus;
+    event.new_status = newStatus;
+    // Written off the request path; a failure never fails the whole operation
+    return AuditWriter::getInstance().record(std::move(event), durability);
 }
 
 crow::response ProjectController::errorResponse(int code, const std::string& message) {
@@ -899,12 +1371,24 @@ crow::response ProjectController::errorResponse(int code, const std::string& mes
     return res;
 }
 
+crow::response ProjectController::busyResponse() {
+    auto res = errorResponse(429, "Analysis queue is full, please retry later");
+    res.add_header("Retry-After", "30");
+    return res;
+}
+
 crow::response ProjectController::successResponse(const nlohmann::json& data) {
     crow::response res(200, data.dump());
     res.add_header("Content-Type", "application/json");
     return res;
 }
 
+crow::response ProjectController::successResponse(std::string&& body) {
+    crow::response res(200, std::move(body));
+    res.add_header("Content-Type", "application/json");
+    return res;
+}
+
 bool ProjectController::validateProjectInput(const nlohmann::json& input, std::string& error) {
     // Required fields
     if (!input.contains("title") || input["title"].get<std::string>().empty()) {
@@ -970,9 +1454,6 @@ bool ProjectController::validateProjectInput(const nlohmann::json& input, std::s
 }
 
 bool ProjectController::checkAuthorization(const crow::request& req, std::string& error) {
-    // TODO: Implement proper JWT token validation
-    // For now, just check for presence of Authorization header
-    
     auto auth_header = req.get_header_value("Authorization");
     if (auth_header.empty()) {
         error = "Authorization header required";
@@ -985,10 +1466,8 @@ bool ProjectController::checkAuthorization(const crow::request& req, std::string
         return false;
     }
     
-    // TODO: Validate JWT token
-    // For now, accept any bearer token
-    
-    return true;
+    // Signature and claims are checked once per token, then served from the verification cache
+    return TokenVerifier::getInstance().verify(std::string_view(auth_header).substr(7), error);
 }
 
 } // namespace aeronautical
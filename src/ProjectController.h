@@ -1,8 +1,11 @@
 #pragma once
 
 #include <crow.h>
+#include "HttpApp.h"
 #include "ProjectRepository.h"
 #include "ConflictController.h" 
+#include "FeatureStream.h"
+#include "AuditWriter.h"
 #include <memory>
 #include <spdlog/spdlog.h>
 
@@ -13,15 +16,24 @@ public:
     ProjectController();
     ~ProjectController() = default;
     
-    void registerRoutes(crow::SimpleApp& app);
+    void registerRoutes(HttpApp& app);
+
+    // Bounds on one project body; a submission is also held to max_vertices
+    void setUploadLimits(const UploadLimits& limits) { upload_limits_ = limits; }
+    // Ingest-time vertex reduction of polygon features (VertexReducer) at
+    // this tolerance in metres; unset stores geometry as uploaded
+    void setVertexReduction(std::optional<double> tolerance_m) { reduction_tolerance_m_ = tolerance_m; }
     
 private:
     std::unique_ptr<ProjectRepository> repository_;
     std::unique_ptr<ConflictController> conflict_controller_; 
     std::shared_ptr<spdlog::logger> logger_;
+    UploadLimits upload_limits_;
+    std::optional<double> reduction_tolerance_m_;
     
     // Route handlers
     crow::response getProjects(const crow::request& req);
+    crow::response searchProjects(const crow::request& req);
     crow::response getProject(int id);
     crow::response getProjectByCode(const std::string& code);
     crow::response createProject(const crow::request& req);
@@ -33,20 +45,36 @@ private:
     bool validatePointGeometry(const nlohmann::json& geometry, std::string& error);
 
     bool saveProjectGeometry(int project_id, const nlohmann::json& geojson);
-    void addProjectComment(int project_id, const std::string& comment, 
-                          ProjectStatus oldStatus, ProjectStatus newStatus);
+    // Queues a status_change row of project_comments; false when a durable write failed
+    bool addProjectComment(int project_id, const std::string& comment, ProjectStatus oldStatus,
+                           ProjectStatus newStatus, AuditWriter::Durability durability = AuditWriter::Durability::Async);
     bool saveIndividualGeometry(int project_id, const nlohmann::json& feature, 
                                int defaultAltMin, int defaultAltMax, bool isPrimary);
     double calculatePolygonArea(const nlohmann::json& coordinates);
     bool saveOrUpdateProjectGeometryCollection(int project_id, const nlohmann::json& incoming_geojson);
+    // Normalizes feature coordinates (CoordinateNormalizer) and replaces
+    // invalid polygons with their Buffer(0) repair, so analysis can skip the
+    // validity check; per feature, false where the geometry has unusable
+    // coordinates or could not be repaired
+    std::vector<bool> repairFeatureGeometries(nlohmann::json& features);
+    bool repairFeatureGeometry(nlohmann::json& feature, size_t index);
+    // Repairs, then reduces, one feature of a per-feature save; the feature
+    // as uploaded goes with it when reduction changed it
+    ProjectRepository::FeatureText ingestFeature(nlohmann::json& feature, size_t index);
+    // Replaces the polygons of feature with their reduction; false, leaving
+    // feature as it was, when nothing was removed or the result is invalid
+    bool reduceFeatureGeometry(nlohmann::json& feature, size_t index);
 
-    crow::response getProjectGeometries(int project_id);
+    crow::response getProjectGeometries(const crow::request& req, int project_id);
 
 
     
     // Helper methods
     crow::response errorResponse(int code, const std::string& message);
+    crow::response busyResponse();
     crow::response successResponse(const nlohmann::json& data);
+    // Body already serialized as JSON text
+    crow::response successResponse(std::string&& body);
     bool validateProjectInput(const nlohmann::json& input, std::string& error);
     bool checkAuthorization(const crow::request& req, std::string& error);
 };
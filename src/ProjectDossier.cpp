@@ -0,0 +1,804 @@
+#include "ProjectDossier.h"
+#include "ConditionalGet.h"
+#include "ConflictRepository.h"
+#include "DatabaseManager.h"
+#include "FileResponse.h"
+#include "GdalDrivers.h"
+#include "GeoJsonReader.h"
+#include "GeometryBlob.h"
+#include "PdfWriter.h"
+#include "ProjectRepository.h"
+#include "TerrainService.h"
+#include "gdal.h"
+#include "gdal_alg.h"
+#include "cpl_conv.h"
+#include "cpl_string.h"
+#include "cpl_vsi.h"
+#include <openssl/evp.h>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <functional>
+#include <stdexcept>
+
+namespace aeronautical {
+
+namespace {
+
+// Bumped when the layout changes, so cached dossiers are written again
+constexpr const char* kLayoutVersion = "1";
+
+constexpr double kLeft = 50;
+constexpr double kRight = PdfWriter::kPageWidth - 50;
+constexpr double kTop = PdfWriter::kPageHeight - 60;
+constexpr double kBottom = 60;
+constexpr double kBodySize = 9;
+constexpr double kLeading = 11.5;
+
+crow::response errorResponse(int code, const std::string& message) {
+    nlohmann::json response;
+    response["error"] = true;
+    response["message"] = message;
+    crow::response res(code, response.dump());
+    res.add_header("Content-Type", "application/json");
+    return res;
+}
+
+crow::response jsonResponse(int code, const nlohmann::json& body) {
+    crow::response res(code, body.dump());
+    res.add_header("Content-Type", "application/json");
+    return res;
+}
+
+std::string sha256Hex(const std::string& data, size_t hex_digits) {
+    std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> ctx(EVP_MD_CTX_new(), EVP_MD_CTX_free);
+    EVP_DigestInit_ex(ctx.get(), EVP_sha256(), nullptr);
+    EVP_DigestUpdate(ctx.get(), data.data(), data.size());
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int length = 0;
+    EVP_DigestFinal_ex(ctx.get(), digest, &length);
+    static const char* hex = "0123456789abcdef";
+    std::string out;
+    for (unsigned int i = 0; i < length && out.size() < hex_digits; ++i) {
+        out.push_back(hex[digest[i] >> 4]);
+        out.push_back(hex[digest[i] & 0xf]);
+    }
+    return out;
+}
+
+std::string column(MYSQL_ROW row, unsigned long* lengths, int i) {
+    return row[i] ? std::string(row[i], lengths[i]) : std::string();
+}
+
+struct Rgb {
+    double r, g, b;
+};
+
+constexpr Rgb kProtectionFill{255, 224, 178};
+constexpr Rgb kProtectionEdge{230, 126, 34};
+constexpr Rgb kProjectFill{187, 222, 251};
+constexpr Rgb kProjectEdge{21, 101, 192};
+constexpr Rgb kConflictFill{229, 57, 53};
+
+struct Dataset {
+    GDALDatasetH handle = nullptr;
+    ~Dataset() {
+        if (handle) GDALClose(handle);
+    }
+};
+
+// Map extract of the project's geometry, as a JPEG
+struct MapExtract {
+    std::string jpeg;
+    int width = 0;
+    int height = 0;
+};
+
+// The geometries burnt into the RGB bands of dataset; outline draws their
+// edges (lines and points as they are) instead of filling them
+void burn(GDALDatasetH dataset, const std::vector<const OGRGeometry*>& geometries, const Rgb& colour, bool outline) {
+    std::vector<std::unique_ptr<OGRGeometry>> edges;
+    std::vector<OGRGeometryH> handles;
+    for (const OGRGeometry* geometry : geometries) {
+        const auto family = wkbFlatten(geometry->getGeometryType());
+        if (outline && (family == wkbPolygon || family == wkbMultiPolygon)) {
+            edges.emplace_back(geometry->Boundary());
+            if (edges.back()) handles.push_back(OGRGeometry::ToHandle(edges.back().get()));
+        } else {
+            handles.push_back(OGRGeometry::ToHandle(const_cast<OGRGeometry*>(geometry)));
+        }
+    }
+    if (handles.empty()) return;
+    int bands[3] = {1, 2, 3};
+    std::vector<double> values;
+    values.reserve(handles.size() * 3);
+    for (size_t i = 0; i < handles.size(); i++) {
+        values.insert(values.end(), {colour.r, colour.g, colour.b});
+    }
+    char** options = nullptr;
+    // Thin features would otherwise miss every pixel centre
+    if (outline) options = CSLSetNameValue(options, "ALL_TOUCHED", "TRUE");
+    GDALRasterizeGeometries(dataset, 3, bands, static_cast<int>(handles.size()), handles.data(), nullptr, nullptr,
+                            values.data(), options, nullptr, nullptr);
+    CSLDestroy(options);
+}
+
+// Terrain under the map as hypsometric shading lit from the north-west,
+// one row of DEM samples at a time; a flat grey without a DEM
+void shadeTerrain(std::vector<uint8_t>& pixels, int width, int height, const double transform[6]) {
+    auto& terrain = TerrainService::getInstance();
+    if (!terrain.enabled()) {
+        std::fill(pixels.begin(), pixels.end(), 244);
+        return;
+    }
+    std::vector<double> lng(width), lat(width), row(width), north(width, std::nan(""));
+    for (int x = 0; x < width; x++) {
+        lng[x] = transform[0] + (x + 0.5) * transform[1];
+    }
+    const double dy_m = -transform[5] * 110540.0;
+    for (int y = 0; y < height; y++) {
+        const double latitude = transform[3] + (y + 0.5) * transform[5];
+        std::fill(lat.begin(), lat.end(), latitude);
+        terrain.sample(lng, lat, row);
+        const double dx_m = transform[1] * 111320.0 * std::cos(latitude * M_PI / 180.0);
+        for (int x = 0; x < width; x++) {
+            uint8_t* pixel = &pixels[(static_cast<size_t>(y) * width + x) * 3];
+            if (std::isnan(row[x])) {
+                pixel[0] = pixel[1] = pixel[2] = 244;
+                continue;
+            }
+            const double left = x > 0 && !std::isnan(row[x - 1]) ? row[x - 1] : row[x];
+            const double above = !std::isnan(north[x]) ? north[x] : row[x];
+            // Surface normal (-dz/dx, -dz/dy, 1) against light from the north-west at 45 degrees
+            const double nx = -(row[x] - left) / dx_m;
+            const double ny = -(above - row[x]) / dy_m;
+            const double light = std::clamp((-0.5 * nx + 0.5 * ny + 0.707) / std::sqrt(nx * nx + ny * ny + 1), 0.0, 1.0);
+            // Green lowlands to brown heights over 0..3000 m
+            const double t = std::clamp(row[x] / 3000.0, 0.0, 1.0);
+            const double shade = 0.6 + 0.4 * light;
+            pixel[0] = static_cast<uint8_t>((214 + 24 * t) * shade);
+            pixel[1] = static_cast<uint8_t>((232 - 20 * t) * shade);
+            pixel[2] = static_cast<uint8_t>((206 - 30 * t) * shade);
+        }
+        north.swap(row);
+    }
+}
+
+// Protection areas of the procedures the project conflicts with, then the
+// project, then the conflict areas, over the terrain; nullopt without a
+// project geometry to centre on
+std::optional<MapExtract> renderMap(int project_id, const std::vector<std::unique_ptr<OGRGeometry>>& project,
+                                    int max_px, uint64_t job_id) {
+    OGREnvelope envelope;
+    bool any = false;
+    for (const auto& geometry : project) {
+        OGREnvelope part;
+        geometry->getEnvelope(&part);
+        if (any) {
+            envelope.Merge(part);
+        } else {
+            envelope = part;
+            any = true;
+        }
+    }
+    if (!any) return std::nullopt;
+
+    // 20 % around the project, at least ~1 km, square pixels on the ground
+    const double pad_x = std::max((envelope.MaxX - envelope.MinX) * 0.2, 0.01);
+    const double pad_y = std::max((envelope.MaxY - envelope.MinY) * 0.2, 0.01);
+    envelope.MinX -= pad_x;
+    envelope.MaxX += pad_x;
+    envelope.MinY = std::max(-85.0, envelope.MinY - pad_y);
+    envelope.MaxY = std::min(85.0, envelope.MaxY + pad_y);
+    const double aspect = (envelope.MaxX - envelope.MinX) *
+                          std::cos((envelope.MinY + envelope.MaxY) / 2 * M_PI / 180.0) /
+                          (envelope.MaxY - envelope.MinY);
+    // Not taller than wide by more than the page allows
+    const double clamped = std::max(aspect, 0.75);
+    int width = clamped >= 1 ? max_px : static_cast<int>(std::lround(max_px * clamped));
+    int height = clamped >= 1 ? static_cast<int>(std::lround(max_px / clamped)) : max_px;
+    width = std::max(width, 16);
+    height = std::max(height, 16);
+    if (clamped != aspect) {
+        // Widen the box instead of stretching the map
+        const double centre = (envelope.MinX + envelope.MaxX) / 2;
+        const double half = (envelope.MaxX - envelope.MinX) / 2 * clamped / aspect;
+        envelope.MinX = centre - half;
+        envelope.MaxX = centre + half;
+    }
+    const double transform[6] = {envelope.MinX, (envelope.MaxX - envelope.MinX) / width, 0,
+                                 envelope.MaxY, 0, -(envelope.MaxY - envelope.MinY) / height};
+
+    std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 3);
+    shadeTerrain(pixels, width, height, transform);
+
+    registerGdalDrivers();
+    GDALDriverH mem = GDALGetDriverByName("MEM");
+    GDALDriverH jpeg = GDALGetDriverByName("JPEG");
+    if (!mem || !jpeg) {
+        throw std::runtime_error("GDAL MEM or JPEG driver is not available");
+    }
+    Dataset map;
+    map.handle = GDALCreate(mem, "", width, height, 3, GDT_Byte, nullptr);
+    if (!map.handle) {
+        throw std::runtime_error("Cannot create the map raster");
+    }
+    GDALSetGeoTransform(map.handle, const_cast<double*>(transform));
+    int band_map[3] = {1, 2, 3};
+    GDALDatasetRasterIO(map.handle, GF_Write, 0, 0, width, height, pixels.data(), width, height, GDT_Byte, 3,
+                        band_map, 3, static_cast<int>(width) * 3, 1);
+    pixels.clear();
+    pixels.shrink_to_fit();
+
+    // Protection areas one at a time as the cursor yields them
+    auto& db = DatabaseManager::getInstance();
+    const std::string conflicts = ConflictRepository::tableOf(project_id);
+    db.streamSelectQuery(
+        "SELECT fp.protection_geometry FROM flight_procedures fp WHERE fp.id IN"
+        " (SELECT DISTINCT flight_procedure_id FROM " + conflicts + " WHERE project_id = " + std::to_string(project_id) +
+            ") AND fp.protection_geometry IS NOT NULL AND fp.protection_geometry != ''",
+        [&](MYSQL_ROW row, unsigned long* lengths) {
+            if (!row[0]) return true;
+            auto geometry = GeoJsonReader::readGeometry(GeometryBlob::view(row[0], lengths[0]));
+            if (geometry) {
+                burn(map.handle, {geometry.get()}, kProtectionFill, false);
+                burn(map.handle, {geometry.get()}, kProtectionEdge, true);
+            }
+            return true;
+        });
+
+    std::vector<const OGRGeometry*> project_parts;
+    for (const auto& geometry : project) project_parts.push_back(geometry.get());
+    burn(map.handle, project_parts, kProjectFill, false);
+
+    db.streamSelectQuery(
+        std::string("SELECT ") +
+            (ConflictRepository::probeSpatialSupport() ? "ST_AsGeoJSON(conflicting_geometry)" : "conflicting_geometry") +
+            " FROM " + conflicts + " WHERE project_id = " + std::to_string(project_id),
+        [&](MYSQL_ROW row, unsigned long* lengths) {
+            if (!row[0]) return true;
+            auto geometry = GeoJsonReader::readGeometry(std::string_view(row[0], lengths[0]));
+            if (geometry) burn(map.handle, {geometry.get()}, kConflictFill, false);
+            return true;
+        });
+    burn(map.handle, project_parts, kProjectEdge, true);
+
+    const std::string path = "/vsimem/dossiers/map-" + std::to_string(job_id) + ".jpg";
+    char** options = CSLSetNameValue(nullptr, "QUALITY", "85");
+    Dataset encoded;
+    encoded.handle = GDALCreateCopy(jpeg, path.c_str(), map.handle, FALSE, options, nullptr, nullptr);
+    CSLDestroy(options);
+    if (!encoded.handle) {
+        throw std::runtime_error(std::string("Cannot encode the map: ") + CPLGetLastErrorMsg());
+    }
+    GDALClose(encoded.handle); // flushes the file
+    encoded.handle = nullptr;
+
+    vsi_l_offset size = 0;
+    GByte* data = VSIGetMemFileBuffer(path.c_str(), &size, TRUE);
+    if (!data) {
+        throw std::runtime_error("The map was not written");
+    }
+    MapExtract extract;
+    extract.jpeg.assign(reinterpret_cast<const char*>(data), static_cast<size_t>(size));
+    extract.width = width;
+    extract.height = height;
+    CPLFree(data);
+    return extract;
+}
+
+// Pages of flowing content: a header with the project and the page number
+// on each, and a cursor that moves to a new page when the next block does
+// not fit
+class Layout {
+public:
+    Layout(PdfWriter& pdf, std::string header) : pdf_(pdf), header_(std::move(header)) {}
+
+    double y() const { return y_; }
+    void advance(double height) { y_ -= height; }
+
+    // True when a new page was started for the block
+    bool ensure(double height) {
+        if (page_ > 0 && y_ - height >= kBottom) return false;
+        pdf_.beginPage();
+        page_++;
+        pdf_.text(kLeft, PdfWriter::kPageHeight - 40, 8, false, header_);
+        const std::string number = "Page " + std::to_string(page_);
+        pdf_.text(kRight - PdfWriter::textWidth(number, 8, false), PdfWriter::kPageHeight - 40, 8, false, number);
+        pdf_.line(kLeft, PdfWriter::kPageHeight - 45, kRight, PdfWriter::kPageHeight - 45);
+        y_ = kTop;
+        return true;
+    }
+
+    void heading(const std::string& text) {
+        ensure(40);
+        advance(20);
+        pdf_.text(kLeft, y_, 13, true, text);
+        advance(10);
+    }
+
+    void paragraph(const std::string& text, double size = kBodySize, bool bold = false) {
+        for (const auto& line : PdfWriter::wrap(text, size, bold, kRight - kLeft)) {
+            ensure(kLeading);
+            advance(kLeading);
+            pdf_.text(kLeft, y_, size, bold, line);
+        }
+    }
+
+    // Label and value on one row; the value wraps under itself
+    void field(const std::string& label, const std::string& value) {
+        constexpr double kLabelWidth = 130;
+        const auto lines = PdfWriter::wrap(value.empty() ? "-" : value, kBodySize, false, kRight - kLeft - kLabelWidth);
+        for (size_t i = 0; i < lines.size(); i++) {
+            ensure(kLeading);
+            advance(kLeading);
+            if (i == 0) pdf_.text(kLeft, y_, kBodySize, true, label);
+            pdf_.text(kLeft + kLabelWidth, y_, kBodySize, false, lines[i]);
+        }
+    }
+
+private:
+    PdfWriter& pdf_;
+    std::string header_;
+    double y_ = kTop;
+    int page_ = 0;
+};
+
+// Rows of wrapped cells; the column titles are repeated on every page
+class Table {
+public:
+    struct Column {
+        const char* title;
+        double width;
+    };
+
+    Table(PdfWriter& pdf, Layout& layout, std::vector<Column> columns)
+        : pdf_(pdf), layout_(layout), columns_(std::move(columns)) {}
+
+    void row(const std::vector<std::string>& cells) {
+        std::vector<std::vector<std::string>> lines;
+        size_t height = 1;
+        for (size_t i = 0; i < columns_.size(); i++) {
+            lines.push_back(PdfWriter::wrap(i < cells.size() ? cells[i] : "", kBodySize, false, columns_[i].width - 6));
+            height = std::max(height, lines.back().size());
+        }
+        const double block = height * kLeading + 4;
+        if (layout_.ensure(block + (header_drawn_ ? 0 : kLeading + 6)) || !header_drawn_) {
+            header();
+        }
+        double x = kLeft;
+        for (size_t i = 0; i < columns_.size(); i++) {
+            for (size_t l = 0; l < lines[i].size(); l++) {
+                pdf_.text(x, layout_.y() - (l + 1) * kLeading, kBodySize, false, lines[i][l]);
+            }
+            x += columns_[i].width;
+        }
+        layout_.advance(block);
+        pdf_.line(kLeft, layout_.y() + 1, kRight, layout_.y() + 1, 0.25);
+    }
+
+private:
+    void header() {
+        layout_.ensure(kLeading + 6);
+        pdf_.fillRect(kLeft, layout_.y() - kLeading - 4, kRight - kLeft, kLeading + 4, 0.9);
+        double x = kLeft;
+        for (const auto& column : columns_) {
+            pdf_.text(x, layout_.y() - kLeading, kBodySize, true, column.title);
+            x += column.width;
+        }
+        layout_.advance(kLeading + 6);
+        header_drawn_ = true;
+    }
+
+    PdfWriter& pdf_;
+    Layout& layout_;
+    std::vector<Column> columns_;
+    bool header_drawn_ = false;
+};
+
+std::string dateText(const std::optional<std::chrono::system_clock::time_point>& time) {
+    return time ? timePointToString(*time).substr(0, 10) : std::string();
+}
+
+std::string formatNumber(const char* format, double value) {
+    char text[48];
+    std::snprintf(text, sizeof(text), format, value);
+    return text;
+}
+
+} // namespace
+
+ProjectDossier& ProjectDossier::getInstance() {
+    static ProjectDossier instance;
+    return instance;
+}
+
+ProjectDossier::ProjectDossier() : jobs_("Dossier job", [this](const Job& job) { return jobJson(job); }) {}
+
+ProjectDossier::~ProjectDossier() {
+    shutdown();
+}
+
+void ProjectDossier::configure(const DossierSettings& settings) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    settings_ = settings;
+    settings_.workers = std::max<size_t>(1, settings_.workers);
+    settings_.max_jobs = std::max<size_t>(1, settings_.max_jobs);
+    settings_.cache_entries = std::max<size_t>(1, settings_.cache_entries);
+    settings_.map_px = std::clamp(settings_.map_px, 256, 4096);
+    if (settings_.directory.empty()) {
+        settings_.directory = (std::filesystem::temp_directory_path() / "aero-dossiers").string();
+    }
+    if (settings_.enabled) {
+        std::error_code ec;
+        if (!prepareJobDirectory(settings_.directory, "dossier-", ec)) {
+            spdlog::error("Dossier directory {} is not usable: {}", settings_.directory, ec.message());
+            settings_.enabled = false;
+        }
+    }
+    if (settings_.enabled) {
+        jobs_.start(settings_.workers, "dossiers", settings_.max_jobs);
+    }
+    spdlog::info("Project dossiers {}: {} workers, {} cached, files in {}",
+                 settings_.enabled ? "enabled" : "disabled", settings_.workers, settings_.cache_entries,
+                 settings_.directory);
+}
+
+void ProjectDossier::shutdown() {
+    jobs_.shutdown(false); // joins after the running dossiers
+}
+
+bool ProjectDossier::enabled() const {
+    return jobs_.running();
+}
+
+void ProjectDossier::registerRoutes(HttpApp& app) {
+    CROW_ROUTE(app, "/api/projects/<int>/dossier")
+        .methods(crow::HTTPMethod::GET)
+        ([this](const crow::request& req, crow::response& res, int project_id) {
+            download(req, res, project_id);
+            res.end();
+        });
+
+    CROW_ROUTE(app, "/api/dossiers/jobs/<uint>")
+        .methods(crow::HTTPMethod::GET)
+        ([this](uint64_t id) { return jobs_.status(id); });
+}
+
+std::optional<std::string> ProjectDossier::revisionOf(int project_id) {
+    auto& db = DatabaseManager::getInstance();
+    auto result = db.executePrepared(
+        "SELECT CONCAT_WS('/', CAST(p.updated_at AS CHAR),"
+        " (SELECT CONCAT_WS(':', COUNT(*), MAX(id), CAST(MAX(updated_at) AS CHAR)) FROM " +
+            ConflictRepository::tableOf(project_id) + " WHERE project_id = p.id),"
+        " (SELECT CONCAT_WS(':', COUNT(*), MAX(id)) FROM project_comments WHERE project_id = p.id))"
+        " FROM projects p WHERE p.id = ?",
+        {SqlParam(static_cast<int64_t>(project_id))});
+    if (result.rows.empty()) {
+        return std::nullopt;
+    }
+    ProjectRepository repository;
+    const auto geometry = repository.findGeometryRevision(project_id);
+    if (!geometry) {
+        throw std::runtime_error("Geometry revision lookup failed");
+    }
+    return sha256Hex(std::string(kLayoutVersion) + "/" + result.rows[0].getString(0) + "/" + *geometry, 16);
+}
+
+void ProjectDossier::download(const crow::request& req, crow::response& res, int project_id) {
+    if (!enabled()) {
+        res = errorResponse(503, "Project dossiers are disabled");
+        return;
+    }
+    std::optional<std::string> revision;
+    try {
+        revision = revisionOf(project_id);
+    } catch (const std::exception& e) {
+        spdlog::error("Dossier revision of project {} failed: {}", project_id, e.what());
+        res = errorResponse(500, "Could not read the project");
+        return;
+    }
+    if (!revision) {
+        res = errorResponse(404, "Project not found");
+        return;
+    }
+
+    const CacheValidator validator{"\"dossier-" + *revision + "\"", std::nullopt};
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto cached = cache_.find(project_id);
+        if (cached != cache_.end() && cached->second.revision == *revision) {
+            lru_.splice(lru_.begin(), lru_, cached->second.position);
+            path = cached->second.path;
+        }
+    }
+    if (!path.empty()) {
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        if (ConditionalGet::isCurrent(req, validator)) {
+            res = ConditionalGet::notModified(validator);
+            return;
+        }
+        FileResponse::prepare(req, res, path, "application/pdf", validator.etag);
+        ConditionalGet::tag(res, validator);
+        res.add_header("Content-Disposition",
+                       "inline; filename=\"project-" + std::to_string(project_id) + "-dossier.pdf\"");
+        return;
+    }
+    misses_.fetch_add(1, std::memory_order_relaxed);
+
+    Job job;
+    job.project_id = project_id;
+    job.revision = *revision;
+    const auto submitted = jobs_.submit(
+        std::move(job), [this, project_id, revision = *revision](uint64_t id) { process(id, project_id, revision); },
+        std::to_string(project_id) + "/" + *revision);
+    if (!submitted) {
+        res = errorResponse(429, "Too many dossiers in progress, please retry later");
+        res.add_header("Retry-After", "10");
+        return;
+    }
+    const uint64_t id = submitted->id;
+    if (!submitted->joined) {
+        spdlog::info("Queued dossier job {} for project {} ({})", id, project_id, *revision);
+    }
+
+    nlohmann::json response;
+    response["message"] = "Dossier is being written; download it again once the job completed.";
+    response["job_id"] = id;
+    response["status_url"] = "/api/dossiers/jobs/" + std::to_string(id);
+    response["file_url"] = "/api/projects/" + std::to_string(project_id) + "/dossier";
+    res = jsonResponse(202, response);
+}
+
+nlohmann::json ProjectDossier::jobJson(const Job& job) const {
+    nlohmann::json j = job.toJson();
+    j["project_id"] = job.project_id;
+    j["revision"] = job.revision;
+    j["pages"] = job.pages;
+    if (job.state == BackgroundJobState::Completed) {
+        j["file_url"] = "/api/projects/" + std::to_string(job.project_id) + "/dossier";
+    }
+    return j;
+}
+
+std::string ProjectDossier::pathFor(int project_id, const std::string& revision) const {
+    return settings_.directory + "/dossier-" + std::to_string(project_id) + "-" + revision + ".pdf";
+}
+
+void ProjectDossier::setStage(uint64_t job_id, const char* stage, size_t pages) {
+    jobs_.update(job_id, [stage, pages](Job& job) {
+        job.state = BackgroundJobState::Running;
+        job.stage = stage;
+        job.pages = pages;
+    });
+}
+
+void ProjectDossier::process(uint64_t job_id, int project_id, std::string revision) {
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        path = pathFor(project_id, revision);
+    }
+    // Written aside and renamed, so a download never sees half a file
+    const std::string partial = path + ".part";
+    const auto started = std::chrono::steady_clock::now();
+    try {
+        const size_t pages = render(job_id, project_id, partial);
+        std::filesystem::rename(partial, path);
+        const size_t bytes = static_cast<size_t>(std::filesystem::file_size(path));
+        const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - started;
+        spdlog::info("Dossier job {} done in {:.0f} ms: project {}, {} pages, {} bytes", job_id, elapsed.count(),
+                     project_id, pages, bytes);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            remember(project_id, revision, path, bytes);
+        }
+        jobs_.update(job_id, [pages](Job& job) { job.pages = pages; });
+        jobs_.finish(job_id, std::nullopt);
+    } catch (const std::exception& e) {
+        std::error_code ec;
+        std::filesystem::remove(partial, ec);
+        spdlog::error("Dossier job {} for project {} failed: {}", job_id, project_id, e.what());
+        jobs_.finish(job_id, std::string("Rendering failed: ") + e.what());
+    }
+}
+
+size_t ProjectDossier::render(uint64_t job_id, int project_id, const std::string& path) {
+    setStage(job_id, "reading project");
+    ProjectRepository repository;
+    auto project = repository.findById(project_id);
+    if (!project) {
+        throw std::runtime_error("Project not found");
+    }
+    std::vector<std::unique_ptr<OGRGeometry>> geometries;
+    if (auto collection = repository.findGeometriesByProjectId(project_id)) {
+        std::vector<GeoJsonFeature> features;
+        std::string error;
+        if (GeoJsonReader::read(*collection, features, error)) {
+            for (const auto& feature : features) {
+                if (!feature.geometry) continue;
+                if (auto geometry = feature.geometry->toOGR()) geometries.push_back(std::move(geometry));
+            }
+        }
+    }
+
+    PdfWriter pdf(path);
+    Layout layout(pdf, project->project_code + " - " + project->title);
+
+    layout.ensure(0);
+    layout.advance(6);
+    layout.paragraph("Review dossier: " + project->project_code, 16, true);
+    layout.advance(4);
+    layout.paragraph(project->title, 11);
+    layout.paragraph("Generated " + timePointToString(std::chrono::system_clock::now()), 8);
+
+    layout.heading("Project");
+    layout.field("Status", statusToString(project->status));
+    layout.field("Priority", priorityToString(project->priority));
+    layout.field("Operation type", project->operation_type.value_or(""));
+    layout.field("Demander", project->demander_name +
+                                 (project->demander_organization ? " (" + *project->demander_organization + ")" : ""));
+    layout.field("Contact", project->demander_email +
+                                (project->demander_phone ? ", " + *project->demander_phone : ""));
+    layout.field("Altitudes (ft)", (project->altitude_min ? std::to_string(*project->altitude_min) : "?") + " - " +
+                                       (project->altitude_max ? std::to_string(*project->altitude_max) : "?"));
+    layout.field("Period", dateText(project->start_date) + " - " + dateText(project->end_date));
+    layout.field("Review deadline", dateText(project->review_deadline));
+    layout.field("Created", timePointToString(project->created_at));
+    layout.field("Last updated", timePointToString(project->updated_at));
+    if (project->description) {
+        layout.field("Description", *project->description);
+    }
+    if (project->rejection_reason) {
+        layout.field("Rejection reason", *project->rejection_reason);
+    }
+
+    setStage(job_id, "rendering map", pdf.pageCount());
+    layout.heading("Map extract");
+    if (auto map = renderMap(project_id, geometries, settings_.map_px, job_id)) {
+        const int image = pdf.addJpeg(map->jpeg, map->width, map->height);
+        map->jpeg.clear();
+        double width = kRight - kLeft;
+        double height = width * map->height / map->width;
+        // A tall map is shrunk to fit under the heading of a fresh page
+        const double room = kTop - kBottom - 20;
+        if (height > room) {
+            width *= room / height;
+            height = room;
+        }
+        layout.ensure(height + 20);
+        layout.advance(height + 4);
+        pdf.image(image, kLeft, layout.y(), width, height);
+        layout.advance(14);
+        double x = kLeft;
+        for (const auto& [colour, label] : {std::pair{kProjectFill, "Project"}, std::pair{kProtectionFill, "Protection area"},
+                                            std::pair{kConflictFill, "Conflict"}}) {
+            pdf.fillRect(x, layout.y(), 9, 7, colour.r / 255, colour.g / 255, colour.b / 255);
+            pdf.text(x + 13, layout.y(), 8, false, label);
+            x += 100;
+        }
+        if (TerrainService::getInstance().enabled()) {
+            pdf.text(x, layout.y(), 8, false, "Terrain shading from the DEM");
+        }
+    } else {
+        layout.paragraph("The project has no geometry.");
+    }
+    geometries.clear();
+
+    setStage(job_id, "writing conflicts", pdf.pageCount());
+    layout.heading("Conflicts");
+    size_t conflicts = 0;
+    std::string failure;
+    {
+        Table table(pdf, layout, {{"#", 32}, {"Procedure", 80}, {"Airport", 42}, {"Severity", 55}, {"Overlap", 70},
+                                  {"Description", kRight - kLeft - 279}});
+        const bool metrics = ConflictRepository::probeMetricColumns();
+        const bool streamed = DatabaseManager::getInstance().streamSelectQuery(
+            std::string("SELECT c.id, fp.procedure_code, fp.airport_icao, ") +
+                (metrics ? "c.severity, c.overlap_area, c.overlap_ratio" : "NULL, NULL, NULL") +
+                ", c.description FROM " + ConflictRepository::tableOf(project_id) + " c LEFT JOIN flight_procedures fp ON fp.id = c.flight_procedure_id"
+                " WHERE c.project_id = " + std::to_string(project_id) + " ORDER BY c.id",
+            [&](MYSQL_ROW row, unsigned long* lengths) {
+                try {
+                    std::string overlap;
+                    if (row[4]) overlap = formatNumber("%.0f m2", std::atof(row[4]));
+                    if (row[5]) overlap += (overlap.empty() ? "" : ", ") + formatNumber("%.1f %%", std::atof(row[5]) * 100);
+                    table.row({column(row, lengths, 0), column(row, lengths, 1), column(row, lengths, 2),
+                               column(row, lengths, 3), overlap, column(row, lengths, 6)});
+                    if (++conflicts % 200 == 0) setStage(job_id, "writing conflicts", pdf.pageCount());
+                    return true;
+                } catch (const std::exception& e) {
+                    failure = e.what();
+                    return false;
+                }
+            });
+        if (!failure.empty()) throw std::runtime_error(failure);
+        if (!streamed) throw std::runtime_error("Reading the conflicts failed");
+    }
+    if (conflicts == 0) {
+        layout.paragraph("No conflicts recorded.");
+    }
+
+    setStage(job_id, "writing comments", pdf.pageCount());
+    layout.heading("Comments");
+    size_t comments = 0;
+    const bool streamed = DatabaseManager::getInstance().streamSelectQuery(
+        "SELECT CAST(created_at AS CHAR), comment_type, old_status, new_status, comment, is_internal"
+        " FROM project_comments WHERE project_id = " + std::to_string(project_id) + " ORDER BY created_at, id",
+        [&](MYSQL_ROW row, unsigned long* lengths) {
+            try {
+                std::string title = column(row, lengths, 0) + "  " + column(row, lengths, 1);
+                if (row[2] || row[3]) title += "  " + column(row, lengths, 2) + " -> " + column(row, lengths, 3);
+                if (row[5] && std::atoi(row[5]) != 0) title += "  [internal]";
+                layout.ensure(2 * kLeading + 4);
+                layout.advance(4);
+                layout.paragraph(title, kBodySize, true);
+                layout.paragraph(column(row, lengths, 4));
+                comments++;
+                return true;
+            } catch (const std::exception& e) {
+                failure = e.what();
+                return false;
+            }
+        });
+    if (!failure.empty()) throw std::runtime_error(failure);
+    if (!streamed) throw std::runtime_error("Reading the comments failed");
+    if (comments == 0) {
+        layout.paragraph("No comments.");
+    }
+
+    setStage(job_id, "closing", pdf.pageCount());
+    pdf.finish();
+    return pdf.pageCount();
+}
+
+void ProjectDossier::remember(int project_id, const std::string& revision, const std::string& path, size_t bytes) {
+    std::error_code ec;
+    auto known = cache_.find(project_id);
+    if (known != cache_.end()) {
+        // The project's older revision is never served again
+        if (known->second.path != path) std::filesystem::remove(known->second.path, ec);
+        cache_bytes_ -= known->second.bytes;
+        lru_.erase(known->second.position);
+        cache_.erase(known);
+    }
+    lru_.push_front(project_id);
+    cache_.emplace(project_id, CachedDossier{revision, path, bytes, lru_.begin()});
+    cache_bytes_ += bytes;
+    while (cache_.size() > settings_.cache_entries) {
+        auto oldest = cache_.find(lru_.back());
+        std::filesystem::remove(oldest->second.path, ec);
+        cache_bytes_ -= oldest->second.bytes;
+        cache_.erase(oldest);
+        lru_.pop_back();
+    }
+}
+
+nlohmann::json ProjectDossier::cacheStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return {{"entries", cache_.size()},
+            {"capacity", settings_.cache_entries},
+            {"bytes", cache_bytes_},
+            {"hits", hits_.load(std::memory_order_relaxed)},
+            {"misses", misses_.load(std::memory_order_relaxed)}};
+}
+
+void ProjectDossier::clearCache() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::error_code ec;
+    for (const auto& [project_id, cached] : cache_) {
+        std::filesystem::remove(cached.path, ec);
+    }
+    cache_.clear();
+    lru_.clear();
+    cache_bytes_ = 0;
+}
+
+nlohmann::json ProjectDossier::poolStats() const {
+    return jobs_.stats();
+}
+
+} // namespace aeronautical
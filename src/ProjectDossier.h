@@ -0,0 +1,111 @@
+#pragma once
+
+#include <crow.h>
+#include "BackgroundJobs.h"
+#include "HttpApp.h"
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <json.hpp>
+
+namespace aeronautical {
+
+struct DossierSettings {
+    bool enabled = true;
+    size_t workers = 1;
+    size_t max_jobs = 8;        // dossiers queued or running before 429
+    size_t cache_entries = 64;  // projects whose latest dossier is kept on disk
+    std::string directory;      // empty: <temp>/aero-dossiers
+    int map_px = 1400;          // longest side of the map extract
+};
+
+// Review dossier of a project rendered server-side as a PDF: the project's
+// data, a map extract of its geometry with the protection areas it
+// conflicts with and the conflict areas, the conflict table and the
+// comment history. The map is rasterized with GDAL over a terrain shading
+// read from TerrainService's cached DEM tiles, when a DEM is configured;
+// the tables are read through unbuffered cursors and every page is written
+// to the file as soon as it is full (see PdfWriter), so a project with
+// thousands of conflicts holds one page at a time.
+//
+// Dossiers are cached by project revision: the project row's updated_at,
+// the geometry revision, and the count and newest change of its conflicts
+// and comments. A download whose revision has a file is served from disk
+// at once; anything else queues a job on the pool, or joins the one
+// already running for that revision.
+//
+//   GET /api/projects/<id>/dossier     the PDF (200), or 202 with the job while it is written
+//   GET /api/dossiers/jobs/<id>        job state and stage; file_url once completed
+class ProjectDossier {
+public:
+    static ProjectDossier& getInstance();
+
+    ProjectDossier(const ProjectDossier&) = delete;
+    ProjectDossier& operator=(const ProjectDossier&) = delete;
+
+    // Starts the workers and removes files left by a previous run; routes
+    // answer 503 until then or when disabled
+    void configure(const DossierSettings& settings);
+    // Lets running dossiers finish and joins the workers
+    void shutdown();
+    bool enabled() const;
+
+    void registerRoutes(HttpApp& app);
+
+    // Dossiers held, their bytes and the hit and miss counts
+    nlohmann::json cacheStats() const;
+    void clearCache();
+    nlohmann::json poolStats() const;
+
+private:
+    struct Job : BackgroundJob {
+        int project_id = 0;
+        std::string revision;
+        size_t pages = 0;
+    };
+
+    struct CachedDossier {
+        std::string revision;
+        std::string path;
+        size_t bytes = 0;
+        std::list<int>::iterator position; // in lru_
+    };
+
+    ProjectDossier();
+    ~ProjectDossier();
+
+    void download(const crow::request& req, crow::response& res, int project_id);
+
+    // Revision key of the project's current state; nullopt when it does not exist
+    static std::optional<std::string> revisionOf(int project_id);
+
+    // Runs on the pool
+    void process(uint64_t job_id, int project_id, std::string revision);
+    // Renders the dossier into path; the number of pages
+    size_t render(uint64_t job_id, int project_id, const std::string& path);
+    void setStage(uint64_t job_id, const char* stage, size_t pages = 0);
+
+    // Records the file as the project's dossier, evicting past cache_entries; caller holds mutex_
+    void remember(int project_id, const std::string& revision, const std::string& path, size_t bytes);
+    nlohmann::json jobJson(const Job& job) const;
+    std::string pathFor(int project_id, const std::string& revision) const;
+
+    DossierSettings settings_;
+    // Keyed by project and revision, so downloads of one revision share its job
+    BackgroundJobs<Job> jobs_;
+
+    mutable std::mutex mutex_; // settings and cache
+
+    std::unordered_map<int, CachedDossier> cache_;
+    std::list<int> lru_; // project ids, most recent first
+    size_t cache_bytes_ = 0;
+    mutable std::atomic<uint64_t> hits_{0};
+    mutable std::atomic<uint64_t> misses_{0};
+};
+
+} // namespace aeronautical
@@ -1,6 +1,16 @@
 #include "ProjectRepository.h"
+#include "ConflictHeatmap.h"
+#include "ProjectSearchIndex.h"
 #include "DatabaseManager.h"
+#include "RowDecoder.h"
+#include "GeometryBlob.h"
+#include "SchemaMigrations.h"
+#include <algorithm>
+#include <mutex>
 #include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
 #include <spdlog/sinks/stdout_color_sinks.h>
 
 namespace aeronautical {
@@ -23,6 +33,36 @@ ProjectRepository::ProjectRepository() {
 
 #ifdef USE_MYSQL_C_API
 
+// Column map for buildSelectQuery()
+using ProjectRow = RowMap<Project,
+    Field<&Project::id>,
+    Field<&Project::project_code>,
+    Field<&Project::title>,
+    Field<&Project::description>,
+    Field<&Project::demander_id>,
+    Field<&Project::demander_name>,
+    Field<&Project::demander_organization>,
+    Field<&Project::demander_email>,
+    Field<&Project::demander_phone>,
+    Converted<&Project::status, stringToStatus>,
+    Converted<&Project::priority, stringToPriority>,
+    Field<&Project::operation_type>,
+    Field<&Project::altitude_min>,
+    Field<&Project::altitude_max>,
+    Field<&Project::start_date>,
+    Field<&Project::end_date>,
+    Field<&Project::assigned_reviewer_id>,
+    Field<&Project::review_deadline>,
+    Field<&Project::approval_date>,
+    Field<&Project::rejection_reason>,
+    Field<&Project::comment>,
+    Field<&Project::internal_notes>,
+    Field<&Project::created_at>,
+    Field<&Project::updated_at>,
+    Field<&Project::document_count>,
+    Field<&Project::geometry_count>,
+    Field<&Project::conflict_count>>;
+
 std::string ProjectRepository::buildSelectQuery() const {
       return "SELECT p.id, p.project_code, p.title, p.description, p.demander_id, "
            "p.demander_name, p.demander_organization, p.demander_email, "
@@ -30,8 +70,9 @@ std::string ProjectRepository::buildSelectQuery() const {
            "p.altitude_min, p.altitude_max, p.start_date, p.end_date, "
            "p.assigned_reviewer_id, p.review_deadline, p.approval_date, "
            "p.rejection_reason, p.comment, p.internal_notes, "
-           "p.created_at, p.updated_at, "
-           "0 as doc_count, 0 as geo_count, 0 as conflict_count " // Placeholder values
+           "p.created_at, p.updated_at, " +
+           std::string(probeCounterColumns() ? "p.document_count, p.geometry_count, p.conflict_count "
+                                             : "0 as doc_count, 0 as geo_count, 0 as conflict_count ") +
            "FROM projects p";
 }
 
@@ -39,11 +80,29 @@ std::string ProjectRepository::buildCountQuery() const {
     return "SELECT COUNT(*) FROM projects p";
 }
 
+namespace {
+
+// " AND p.id IN (...)"; an empty list matches no row
+void appendIdCondition(std::stringstream& query, const std::vector<int>& ids) {
+    if (ids.empty()) {
+        query << " AND 1=0";
+        return;
+    }
+    query << " AND p.id IN (";
+    for (size_t i = 0; i < ids.size(); i++) {
+        query << (i ? "," : "") << ids[i];
+    }
+    query << ")";
+}
+
+} // namespace
+
 std::vector<Project> ProjectRepository::findAll(const ProjectFilter& filter) {
     std::vector<Project> projects;
     
     try {
         auto& db = DatabaseManager::getInstance();
+        DatabaseManager::ReadScope read(db);
         
         std::stringstream query;
         query << buildSelectQuery() << " WHERE 1=1";
@@ -59,26 +118,38 @@ std::vector<Project> ProjectRepository::findAll(const ProjectFilter& filter) {
         if (filter.priority) {
             query << " AND p.priority = '" << priorityToString(*filter.priority) << "'";
         }
+
+        if (filter.ids) {
+            appendIdCondition(query, *filter.ids);
+        }
         
-        query << " ORDER BY p.created_at DESC";
-        query << " LIMIT " << filter.limit << " OFFSET " << filter.offset;
+        // Keyset condition; the created_at text was checked by isValidCursor
+        if (filter.after) {
+            query << " AND (p.created_at < '" << filter.after->key << "' OR (p.created_at = '"
+                  << filter.after->key << "' AND p.id < " << filter.after->id << "))";
+        }
+
+        query << " ORDER BY p.created_at DESC, p.id DESC";
+        query << " LIMIT " << filter.limit;
+        if (!filter.after) {
+            query << " OFFSET " << filter.offset;
+        }
         
-        logger_->debug("About to execute query: {}", query.str());
+        SPDLOG_LOGGER_DEBUG(logger_, "About to execute query: {}", query.str());
         
-        MYSQL_RES* result = db.executeSelectQuery(query.str());
+        MysqlResult result = db.executeSelectQuery(query.str());
         if (!result) {
             logger_->warn("Query returned no result set, returning empty projects list");
             return projects; // Return empty list instead of throwing
         }
         
-        unsigned long num_rows = mysql_num_rows(result);
-        logger_->debug("Processing {} rows from projects query", num_rows);
+        SPDLOG_LOGGER_DEBUG(logger_, "Processing {} rows from projects query", mysql_num_rows(result.get()));
         
         MYSQL_ROW row;
         int rowCount = 0;
-        while ((row = mysql_fetch_row(result))) {
+        while ((row = mysql_fetch_row(result.get()))) {
             try {
-                unsigned long* lengths = mysql_fetch_lengths(result);
+                unsigned long* lengths = mysql_fetch_lengths(result.get());
                 if (!lengths) {
                     logger_->warn("Failed to get field lengths for row {}", rowCount);
                     continue;
@@ -93,8 +164,7 @@ std::vector<Project> ProjectRepository::findAll(const ProjectFilter& filter) {
             }
         }
         
-        mysql_free_result(result);
-        logger_->debug("Successfully processed {} projects", projects.size());
+        SPDLOG_LOGGER_DEBUG(logger_, "Successfully processed {} projects", projects.size());
         
     } catch (const std::exception& err) {
         logger_->error("Failed to fetch projects: {}", err.what());
@@ -109,23 +179,10 @@ std::optional<Project> ProjectRepository::findById(int id) {
     try {
         auto& db = DatabaseManager::getInstance();
         
-        std::stringstream query;
-        query << buildSelectQuery() << " WHERE p.id = " << id;
-        
-        MYSQL_RES* result = db.executeSelectQuery(query.str());
-        if (!result) {
-            throw std::runtime_error("Failed to execute query");
-        }
-        
-        MYSQL_ROW row = mysql_fetch_row(result);
-        if (row) {
-            unsigned long* lengths = mysql_fetch_lengths(result);
-            Project project = rowToProject(row, lengths);
-            mysql_free_result(result);
-            return project;
+        PreparedResult result = db.executePrepared(buildSelectQuery() + " WHERE p.id = ?", {static_cast<int64_t>(id)});
+        if (!result.rows.empty()) {
+            return rowToProject(result.rows.front());
         }
-        
-        mysql_free_result(result);
     } catch (const std::exception& err) {
         logger_->error("Failed to find project by id {}: {}", id, err.what());
         throw;
@@ -137,25 +194,22 @@ std::optional<Project> ProjectRepository::findById(int id) {
 std::optional<Project> ProjectRepository::findByCode(const std::string& code) {
     try {
         auto& db = DatabaseManager::getInstance();
-        MYSQL* conn = db.getConnection();
         
         std::stringstream query;
         query << buildSelectQuery() << " WHERE p.project_code = '" << code << "'";
         
-        MYSQL_RES* result = db.executeSelectQuery(query.str());
+        MysqlResult result = db.executeSelectQuery(query.str());
         if (!result) {
             throw std::runtime_error("Failed to execute query");
         }
         
-        MYSQL_ROW row = mysql_fetch_row(result);
+        MYSQL_ROW row = mysql_fetch_row(result.get());
         if (row) {
-            unsigned long* lengths = mysql_fetch_lengths(result);
+            unsigned long* lengths = mysql_fetch_lengths(result.get());
             Project project = rowToProject(row, lengths);
-            mysql_free_result(result);
             return project;
         }
         
-        mysql_free_result(result);
     } catch (const std::exception& err) {
         logger_->error("Failed to find project by code {}: {}", code, err.what());
         throw;
@@ -165,31 +219,463 @@ std::optional<Project> ProjectRepository::findByCode(const std::string& code) {
 }
 
 // Add this new function at the end of the file
-std::optional<std::string> ProjectRepository::findGeometriesByProjectId(int project_id) {
+std::optional<std::string> ProjectRepository::findGeometriesByProjectId(int project_id, bool* validated) {
+    if (validated) *validated = false;
+    try {
+        if (probeFeatureTable()) {
+            if (auto collection = findFeatureCollection(project_id, validated)) {
+                return collection;
+            }
+        }
+        return findPrimaryCollection(project_id, validated);
+    } catch (const std::exception& err) {
+        logger_->error("Failed to find geometries for project {}: {}", project_id, err.what());
+        throw;
+    }
+}
+
+std::optional<std::string> ProjectRepository::findPrimaryCollection(int project_id, bool* validated) {
+    auto& db = DatabaseManager::getInstance();
+    const bool flag = probeValidatedColumn();
+    std::string query = std::string("SELECT geometry_data") + (flag ? ", geometry_validated" : "") +
+                        " FROM project_geometries WHERE project_id = " + std::to_string(project_id) +
+                        " AND is_primary = 1 LIMIT 1";
+
+    MysqlResult result = db.executeSelectQuery(query);
+    if (result && mysql_num_rows(result.get()) > 0) {
+        MYSQL_ROW row = mysql_fetch_row(result.get());
+        if (row && row[0]) {
+            unsigned long* lengths = mysql_fetch_lengths(result.get());
+            std::string geometry_json = GeometryBlob::text(row[0], lengths[0]);
+            if (validated && flag) *validated = row[1] && std::atoi(row[1]) != 0;
+            return geometry_json;
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<std::string> ProjectRepository::findFeatureCollection(int project_id, bool* validated) {
+    auto& db = DatabaseManager::getInstance();
+    MysqlResult result = db.executeSelectQuery(
+        "SELECT feature_json, geometry_validated FROM project_features WHERE project_id = " +
+        std::to_string(project_id) + " ORDER BY id");
+    if (!result) {
+        throw std::runtime_error("project_features query failed");
+    }
+    if (mysql_num_rows(result.get()) == 0) {
+        return std::nullopt;
+    }
+
+    // Rows hold dumped features, so the collection is spliced, not parsed
+    std::string collection = "{\"type\":\"FeatureCollection\",\"features\":[";
+    bool all_validated = true;
+    bool first = true;
+    MYSQL_ROW row;
+    while ((row = mysql_fetch_row(result.get()))) {
+        if (!row[0]) continue; // removed
+        unsigned long* lengths = mysql_fetch_lengths(result.get());
+        if (!first) collection += ',';
+        collection.append(row[0], lengths[0]);
+        all_validated = all_validated && row[1] && std::atoi(row[1]) != 0;
+        first = false;
+    }
+    collection += "]}";
+    if (validated) *validated = all_validated;
+    return collection;
+}
+
+bool ProjectRepository::probeFeatureTable() {
+    static std::once_flag once;
+    static bool available = false;
+
+    std::call_once(once, []() {
+        available = SchemaMigrations::hasTable("project_features");
+        spdlog::info("Project geometries stored {}", available ? "per feature" : "as one collection");
+    });
+
+    return available;
+}
+
+bool ProjectRepository::probeOriginalColumn() {
+    static std::once_flag once;
+    static bool available = false;
+
+    std::call_once(once, []() {
+        available = SchemaMigrations::hasColumn("project_features", "original_json");
+        spdlog::info("Features as uploaded {}",
+                     available ? "kept beside reduced ones" : "not kept (no original_json column)");
+    });
+
+    return available;
+}
+
+bool ProjectRepository::probeEnvelopeTable() {
+    static std::once_flag once;
+    static bool available = false;
+
+    std::call_once(once, []() {
+        available = SchemaMigrations::hasTable("project_mbrs");
+        spdlog::info("Project envelopes {}", available ? "indexed in project_mbrs" : "kept in memory only");
+    });
+
+    return available;
+}
+
+namespace {
+
+// Planar polygon of an envelope; a point or axis-parallel line is widened
+// a little so the ring stays valid
+std::string envelopeWkt(const OGREnvelope& envelope) {
+    constexpr double kMinExtent = 1e-9;
+    const double min_x = envelope.MinX;
+    const double min_y = envelope.MinY;
+    const double max_x = std::max(envelope.MaxX, envelope.MinX + kMinExtent);
+    const double max_y = std::max(envelope.MaxY, envelope.MinY + kMinExtent);
+    std::ostringstream wkt;
+    wkt.precision(17);
+    wkt << "POLYGON((" << min_x << ' ' << min_y << ", " << max_x << ' ' << min_y << ", " << max_x << ' ' << max_y
+        << ", " << min_x << ' ' << max_y << ", " << min_x << ' ' << min_y << "))";
+    return wkt.str();
+}
+
+} // namespace
+
+std::optional<std::unordered_map<int, StoredProjectEnvelope>> ProjectRepository::findStoredEnvelopes(
+    ProjectStatus status, const OGREnvelope& envelope) {
+    if (!probeEnvelopeTable()) {
+        return std::nullopt;
+    }
     try {
         auto& db = DatabaseManager::getInstance();
-        std::string query = "SELECT geometry_data FROM project_geometries WHERE project_id = " + std::to_string(project_id) + " AND is_primary = 1 LIMIT 1";
-        
-        MYSQL_RES* result = db.executeSelectQuery(query);
-        if (result && mysql_num_rows(result) > 0) {
-            MYSQL_ROW row = mysql_fetch_row(result);
+        std::unordered_map<int, StoredProjectEnvelope> stored;
+        auto all = db.executePrepared("SELECT m.project_id, m.revision FROM project_mbrs m "
+                                      "JOIN projects p ON p.id = m.project_id WHERE p.status = ?",
+                                      {statusToString(status)});
+        for (const auto& row : all.rows) {
+            stored[static_cast<int>(row.getInt(0))].revision = row.getString(1);
+        }
+        // The overlap test is the one answered from the spatial index
+        auto near = db.executePrepared("SELECT m.project_id FROM project_mbrs m "
+                                       "JOIN projects p ON p.id = m.project_id "
+                                       "WHERE p.status = ? AND MBRIntersects(m.mbr, ST_GeomFromText(?, 0))",
+                                       {statusToString(status), envelopeWkt(envelope)});
+        for (const auto& row : near.rows) {
+            auto it = stored.find(static_cast<int>(row.getInt(0)));
+            if (it != stored.end()) it->second.overlaps = true;
+        }
+        return stored;
+    } catch (const std::exception& e) {
+        logger_->error("Failed to read stored project envelopes: {}", e.what());
+        return std::nullopt;
+    }
+}
+
+bool ProjectRepository::saveEnvelope(int project_id, const std::string& revision, const OGREnvelope& envelope) {
+    if (!probeEnvelopeTable()) {
+        return false;
+    }
+    try {
+        DatabaseManager::getInstance().executePrepared(
+            "REPLACE INTO project_mbrs (project_id, revision, mbr) VALUES (?, ?, ST_GeomFromText(?, 0))",
+            {static_cast<int64_t>(project_id), revision, envelopeWkt(envelope)});
+        return true;
+    } catch (const std::exception& e) {
+        logger_->warn("Failed to store the envelope of project {}: {}", project_id, e.what());
+        return false;
+    }
+}
+
+ProjectRepository::FeatureText ProjectRepository::FeatureText::of(const nlohmann::json& feature, bool validated) {
+    FeatureText text;
+    if (feature.contains("id")) text.id = feature["id"];
+    if (feature.contains("geometry") && !feature["geometry"].is_null()) text.json = feature.dump();
+    text.validated = validated;
+    return text;
+}
+
+bool ProjectRepository::saveFeatures(int project_id, std::vector<FeatureText>& features) {
+    auto& db = DatabaseManager::getInstance();
+    const std::string project = std::to_string(project_id);
+
+    try {
+        DatabaseManager::Transaction transaction(db);
+        MYSQL* con = transaction.get();
+        auto text = [con](const std::string& value) {
+            std::string escaped(value.size() * 2 + 1, '\0');
+            escaped.resize(mysql_real_escape_string(con, escaped.data(), value.c_str(), value.size()));
+            return "'" + escaped + "'";
+        };
+
+        auto rollback = [&](const char* what) {
+            transaction.rollback();
+            logger_->error("Rolled back geometry save of project {}: {}", project_id, what);
+            return false;
+        };
+
+        // Locks the project's rows, so concurrent saves take revisions in turn
+        MysqlResult result = db.executeSelectQuery(
+            "SELECT COUNT(*), COALESCE(MAX(revision), 0), COALESCE(MAX(feature_number), 0) "
+            "FROM project_features WHERE project_id = " + project + " FOR UPDATE");
+        if (!result) {
+            return rollback("revision lookup failed");
+        }
+        MYSQL_ROW row = mysql_fetch_row(result.get());
+        const int64_t stored_rows = row && row[0] ? std::atoll(row[0]) : 0;
+        const int64_t revision = (row && row[1] ? std::atoll(row[1]) : 0) + 1;
+        int64_t next_number = (row && row[2] ? std::atoll(row[2]) : 0) + 1;
+
+        // Final state per feature key in first-seen order; nullopt removes
+        struct Change {
+            std::string key;
+            std::optional<int64_t> number;
+            std::optional<std::string> json;
+            bool validated = false;
+            std::string original;
+        };
+        std::vector<Change> changes;
+        std::unordered_map<std::string, size_t> change_of;
+        auto apply = [&](FeatureText& feature) {
+            const bool removed = feature.json.empty();
+            if (feature.id.is_null()) {
+                if (removed) return;
+                // Only this feature is parsed again, to carry its new id
+                feature.id = next_number++;
+                auto parsed = nlohmann::json::parse(feature.json);
+                parsed["id"] = feature.id;
+                feature.json = parsed.dump();
+            }
+            const auto& id = feature.id;
+            Change change{id.dump(), std::nullopt, std::nullopt, feature.validated, std::move(feature.original_json)};
+            if (id.is_number_integer()) change.number = id.get<int64_t>();
+            if (!removed) change.json = std::move(feature.json);
+            auto [it, inserted] = change_of.emplace(change.key, changes.size());
+            if (inserted) {
+                changes.push_back(std::move(change));
+            } else {
+                changes[it->second] = std::move(change);
+            }
+        };
+
+        // First save with rows: the stored blob's features come first, then
+        // the blob goes; ids are assigned as the blob merge used to
+        if (stored_rows == 0) {
+            bool blob_validated = false;
+            if (auto blob = findPrimaryCollection(project_id, &blob_validated)) {
+                auto collection = nlohmann::json::parse(*blob, nullptr, false);
+                if (collection.is_object() && collection.contains("features") && collection["features"].is_array()) {
+                    for (const auto& feature : collection["features"]) {
+                        if (feature.contains("id") && feature["id"].is_number_integer()) {
+                            next_number = std::max(next_number, feature["id"].get<int64_t>() + 1);
+                        }
+                    }
+                    for (const auto& feature : collection["features"]) {
+                        FeatureText stored = FeatureText::of(feature, blob_validated);
+                        apply(stored);
+                    }
+                }
+            }
+            if (!db.executeQuery("DELETE FROM project_geometries WHERE project_id = " + project + " AND is_primary = 1")) {
+                return rollback("could not remove the collection blob");
+            }
+        }
+
+        // Integer ids sent in this save are taken before any are handed out
+        for (const auto& feature : features) {
+            if (feature.id.is_number_integer()) {
+                next_number = std::max(next_number, feature.id.get<int64_t>() + 1);
+            }
+        }
+        for (auto& feature : features) {
+            apply(feature);
+        }
+
+        const bool originals = probeOriginalColumn();
+        const std::string prefix = std::string("INSERT INTO project_features (project_id, feature_key, feature_number, "
+                                               "feature_json, geometry_validated, revision") +
+                                   (originals ? ", original_json" : "") + ") VALUES ";
+        const std::string suffix = std::string(" ON DUPLICATE KEY UPDATE feature_number = VALUES(feature_number), "
+                                               "feature_json = VALUES(feature_json), "
+                                               "geometry_validated = VALUES(geometry_validated), revision = VALUES(revision)") +
+                                   (originals ? ", original_json = VALUES(original_json)" : "");
+        std::string statement;
+        std::string removed_keys;
+        size_t rows_in_statement = 0;
+        bool ok = true;
+        for (size_t i = 0; ok && i < changes.size(); i++) {
+            const auto& change = changes[i];
+            if (change.key.size() > 191) {
+                return rollback("feature id longer than 191 characters");
+            }
+            if (!change.json) {
+                removed_keys += (removed_keys.empty() ? "" : ", ") + text(change.key);
+                continue;
+            }
+            std::string values = "(" + project + ", " + text(change.key) + ", " +
+                                  (change.number ? std::to_string(*change.number) : "NULL") + ", " +
+                                  text(*change.json) + ", " + (change.validated ? "1" : "0") + ", " +
+                                  std::to_string(revision) +
+                                  (originals ? (change.original.empty() ? ", NULL" : ", " + text(change.original)) : "") +
+                                  ")";
+            // Flush before this row would push the statement past the size limit
+            if (rows_in_statement > 0 &&
+                statement.size() + values.size() + suffix.size() + 1 > kMaxInsertStatementBytes) {
+                ok = db.executeQuery(statement + suffix);
+                statement.clear();
+                rows_in_statement = 0;
+            }
+            statement += rows_in_statement == 0 ? prefix : ",";
+            statement += values;
+            rows_in_statement++;
+        }
+        if (ok && rows_in_statement > 0) {
+            ok = db.executeQuery(statement + suffix);
+        }
+        // Removed rows stay as tombstones so the revision still moves forward
+        if (ok && !removed_keys.empty()) {
+            ok = db.executeQuery(std::string("UPDATE project_features SET feature_json = NULL, ") +
+                                 (originals ? "original_json = NULL, " : "") + "revision = " +
+                                 std::to_string(revision) + " WHERE project_id = " + project +
+                                 " AND feature_json IS NOT NULL AND feature_key IN (" + removed_keys + ")");
+        }
+        if (ok) {
+            ok = updateCounter(project_id, "geometry_count",
+                               "(SELECT COUNT(*) FROM project_features WHERE project_id = " + project +
+                               " AND feature_json IS NOT NULL)");
+        }
+
+        if (!ok) {
+            return rollback("feature write failed");
+        }
+        if (!transaction.commit()) {
+            logger_->error("Failed to commit geometry save of project {}", project_id);
+            return false;
+        }
+        logger_->info("Saved {} feature changes of project {} at geometry revision {}", changes.size(), project_id,
+                      revision);
+        return true;
+
+    } catch (const std::exception& err) {
+        logger_->error("Exception saving features of project {}: {}", project_id, err.what());
+        return false;
+    }
+}
+
+bool ProjectRepository::probeValidatedColumn() {
+    static std::once_flag once;
+    static bool available = false;
+
+    std::call_once(once, []() {
+        available = SchemaMigrations::hasColumn("project_geometries", "geometry_validated");
+        spdlog::info("Project geometries {}", available ? "validated when saved" : "validated on every analysis");
+    });
+
+    return available;
+}
+
+bool ProjectRepository::probeCounterColumns() {
+    static std::once_flag once;
+    static bool available = false;
+
+    std::call_once(once, []() {
+        available = SchemaMigrations::hasColumn("projects", "document_count") &&
+                    SchemaMigrations::hasColumn("projects", "geometry_count") &&
+                    SchemaMigrations::hasColumn("projects", "conflict_count");
+        spdlog::info("Project counts {}", available ? "read from maintained counters" : "not stored (reported as 0)");
+    });
+
+    return available;
+}
+
+bool ProjectRepository::updateCounter(int project_id, const char* column, const std::string& value_sql) {
+    if (!probeCounterColumns()) {
+        return true;
+    }
+    auto& db = DatabaseManager::getInstance();
+    return db.executeQuery(std::string("UPDATE projects SET ") + column + " = " + value_sql +
+                           " WHERE id = " + std::to_string(project_id));
+}
+
+std::optional<std::string> ProjectRepository::findGeometryRevision(int project_id) {
+    try {
+        auto& db = DatabaseManager::getInstance();
+        // Feature rows win over a blob; "f" keeps the two kinds apart
+        if (probeFeatureTable()) {
+            MysqlResult result = db.executeSelectQuery(
+                "SELECT MAX(revision) FROM project_features WHERE project_id = " + std::to_string(project_id));
+            if (!result) {
+                return std::nullopt;
+            }
+            MYSQL_ROW row = mysql_fetch_row(result.get());
+            std::optional<std::string> revision;
             if (row && row[0]) {
-                std::string geometry_json(row[0]);
-                mysql_free_result(result);
-                return geometry_json;
+                revision = std::string("f") + row[0];
+            }
+            if (revision) {
+                return revision;
             }
         }
-        if (result) {
-            mysql_free_result(result);
+
+        std::string query = "SELECT id, UNIX_TIMESTAMP(updated_at) FROM project_geometries WHERE project_id = " +
+                            std::to_string(project_id) + " AND is_primary = 1 LIMIT 1";
+
+        MysqlResult result = db.executeSelectQuery(query);
+        if (!result) {
+            return std::nullopt;
         }
+        std::string revision = "0";
+        MYSQL_ROW row = mysql_fetch_row(result.get());
+        if (row) {
+            revision = std::string(row[0] ? row[0] : "0") + "." + (row[1] ? row[1] : "0");
+        }
+        return revision;
     } catch (const std::exception& err) {
-        logger_->error("Failed to find geometries for project {}: {}", project_id, err.what());
-        throw;
+        logger_->error("Failed to read geometry revision for project {}: {}", project_id, err.what());
     }
-    
     return std::nullopt;
 }
 
+std::vector<std::pair<int, std::string>> ProjectRepository::findGeometryRevisions(ProjectStatus status) {
+    std::vector<std::pair<int, std::string>> revisions;
+    try {
+        auto& db = DatabaseManager::getInstance();
+        std::unordered_set<int> per_feature;
+        if (probeFeatureTable()) {
+            MysqlResult result = db.executeSelectQuery(
+                "SELECT pf.project_id, MAX(pf.revision) FROM project_features pf "
+                "JOIN projects p ON p.id = pf.project_id WHERE p.status = '" + statusToString(status) +
+                "' GROUP BY pf.project_id");
+            if (!result) {
+                return revisions;
+            }
+            MYSQL_ROW row;
+            while ((row = mysql_fetch_row(result.get()))) {
+                if (!row[0]) continue;
+                const int project_id = std::atoi(row[0]);
+                per_feature.insert(project_id);
+                revisions.emplace_back(project_id, std::string("f") + (row[1] ? row[1] : "0"));
+            }
+        }
+
+        std::string query = "SELECT pg.project_id, pg.id, UNIX_TIMESTAMP(pg.updated_at) FROM project_geometries pg "
+                            "JOIN projects p ON p.id = pg.project_id WHERE pg.is_primary = 1 AND p.status = '" +
+                            statusToString(status) + "'";
+
+        MysqlResult result = db.executeSelectQuery(query);
+        if (!result) {
+            return revisions;
+        }
+        MYSQL_ROW row;
+        while ((row = mysql_fetch_row(result.get()))) {
+            if (!row[0] || per_feature.count(std::atoi(row[0]))) continue;
+            revisions.emplace_back(std::atoi(row[0]),
+                                   std::string(row[1] ? row[1] : "0") + "." + (row[2] ? row[2] : "0"));
+        }
+    } catch (const std::exception& err) {
+        logger_->error("Failed to read geometry revisions of {} projects: {}", statusToString(status), err.what());
+    }
+    return revisions;
+}
+
 Project ProjectRepository::create(const Project& project) {
     try {
         auto& db = DatabaseManager::getInstance();
@@ -225,19 +711,22 @@ Project ProjectRepository::create(const Project& project) {
         query << (project.internal_notes ? ("'" + *project.internal_notes + "'") : "NULL");
         query << ")";
         
-        if (!db.executeQuery(query.str())) {
-            throw std::runtime_error("Failed to execute insert query");
+        // mysql_insert_id must read the connection that ran the INSERT
+        my_ulonglong insertedId = 0;
+        {
+            DatabaseManager::ConnectionScope scope(db);
+            if (!db.executeQuery(query.str())) {
+                throw std::runtime_error("Failed to execute insert query");
+            }
+            insertedId = mysql_insert_id(scope.get());
         }
         
-        // Get the inserted ID
-        MYSQL* conn = db.getConnection();
-        my_ulonglong insertedId = mysql_insert_id(conn);
-        
         logger_->info("Created project with ID {} and code {}", insertedId, projectCode);
         
         // Return the created project
         auto created = findById(insertedId);
         if (created) {
+            ProjectSearchIndex::getInstance().put(*created);
             return *created;
         }
         
@@ -280,6 +769,9 @@ bool ProjectRepository::update(int id, const Project& project) {
         bool result = db.executeQuery(query.str());
         
         if (result) {
+            Project indexed = project;
+            indexed.id = id;
+            ProjectSearchIndex::getInstance().put(indexed);
             logger_->info("Updated project with ID {}", id);
         } else {
             logger_->warn("No project found with ID {} to update", id);
@@ -296,13 +788,22 @@ bool ProjectRepository::update(int id, const Project& project) {
 bool ProjectRepository::deleteById(int id) {
     try {
         auto& db = DatabaseManager::getInstance();
+        DatabaseManager::Transaction transaction(db);
         
         std::stringstream query;
         query << "DELETE FROM projects WHERE id = " << id;
         
-        bool result = db.executeQuery(query.str());
+        // The project's conflicts stop counting once it is gone
+        bool result = ConflictHeatmap::record("c.project_id = " + std::to_string(id), false) &&
+                      db.executeQuery(query.str());
+        if (result) {
+            result = transaction.commit();
+        } else {
+            transaction.rollback();
+        }
         
         if (result) {
+            ProjectSearchIndex::getInstance().remove(id);
             logger_->info("Deleted project with ID {}", id);
         } else {
             logger_->warn("No project found with ID {} to delete", id);
@@ -358,6 +859,7 @@ bool ProjectRepository::deleteById(int id) {
 int ProjectRepository::count(const ProjectFilter& filter) {
     try {
         auto& db = DatabaseManager::getInstance();
+        DatabaseManager::ReadScope read(db);
         
         std::stringstream query;
         query << "SELECT COUNT(*) FROM projects p WHERE 1=1";
@@ -373,25 +875,28 @@ int ProjectRepository::count(const ProjectFilter& filter) {
         if (filter.priority) {
             query << " AND p.priority = '" << priorityToString(*filter.priority) << "'";
         }
+
+        if (filter.ids) {
+            appendIdCondition(query, *filter.ids);
+        }
         
-        logger_->debug("Executing project count query: {}", query.str());
+        SPDLOG_LOGGER_DEBUG(logger_, "Executing project count query: {}", query.str());
         
-        MYSQL_RES* result = db.executeSelectQuery(query.str());
+        MysqlResult result = db.executeSelectQuery(query.str());
         if (!result) {
             logger_->error("Project count query failed");
             return 0;
         }
         
-        MYSQL_ROW row = mysql_fetch_row(result);
+        MYSQL_ROW row = mysql_fetch_row(result.get());
         int count = 0;
         if (row && row[0]) {
             count = std::atoi(row[0]);
-            logger_->debug("Project count query returned: {}", count);
+            SPDLOG_LOGGER_DEBUG(logger_, "Project count query returned: {}", count);
         } else {
             logger_->warn("Project count query returned NULL result");
         }
         
-        mysql_free_result(result);
         return count;
         
     } catch (const std::exception& err) {
@@ -400,43 +905,27 @@ int ProjectRepository::count(const ProjectFilter& filter) {
     }
 }
 
+PageCursor ProjectRepository::cursorAfter(const Project& project) {
+    return PageCursor{timePointToString(project.created_at), project.id};
+}
+
+bool ProjectRepository::isValidCursor(const PageCursor& cursor) {
+    // "YYYY-MM-DD HH:MM:SS", the only text that reaches the query unescaped
+    static constexpr std::string_view pattern = "0000-00-00 00:00:00";
+    if (cursor.key.size() != pattern.size()) return false;
+    for (size_t i = 0; i < pattern.size(); i++) {
+        const char c = cursor.key[i];
+        if (pattern[i] == '0' ? (c < '0' || c > '9') : c != pattern[i]) return false;
+    }
+    return true;
+}
+
 Project ProjectRepository::rowToProject(MYSQL_ROW row, unsigned long* lengths) {
-    Project p;
-    
-    int col = 0;
-    p.id = row[col] ? std::atoi(row[col]) : 0; col++;
-    p.project_code = row[col] ? std::string(row[col]) : ""; col++;
-    p.title = row[col] ? std::string(row[col]) : ""; col++;
-    if (row[col]) p.description = std::string(row[col]); col++;
-    p.demander_id = row[col] ? std::atoi(row[col]) : 0; col++;
-    p.demander_name = row[col] ? std::string(row[col]) : ""; col++;
-    if (row[col]) p.demander_organization = std::string(row[col]); col++;
-    p.demander_email = row[col] ? std::string(row[col]) : ""; col++;
-    if (row[col]) p.demander_phone = std::string(row[col]); col++;
-    p.status = row[col] ? stringToStatus(std::string(row[col])) : ProjectStatus::Created; col++;
-    p.priority = row[col] ? stringToPriority(std::string(row[col])) : ProjectPriority::Normal; col++;
-    if (row[col]) p.operation_type = std::string(row[col]); col++;
-    if (row[col]) p.altitude_min = std::atoi(row[col]); col++;
-    if (row[col]) p.altitude_max = std::atoi(row[col]); col++;
-    if (row[col]) p.start_date = stringToTimePoint(std::string(row[col])); col++;
-    if (row[col]) p.end_date = stringToTimePoint(std::string(row[col])); col++;
-    if (row[col]) p.assigned_reviewer_id = std::atoi(row[col]); col++;
-    if (row[col]) p.review_deadline = stringToTimePoint(std::string(row[col])); col++;
-    if (row[col]) p.approval_date = stringToTimePoint(std::string(row[col])); col++;
-    if (row[col]) p.rejection_reason = std::string(row[col]); col++;
-    if (row[col]) p.comment = std::string(row[col]); col++;
-    if (row[col]) p.internal_notes = std::string(row[col]); col++;
-    
-    // created_at and updated_at
-    if (row[col]) p.created_at = stringToTimePoint(std::string(row[col])); col++;
-    if (row[col]) p.updated_at = stringToTimePoint(std::string(row[col])); col++;
-    
-    // Additional computed fields if present
-    if (row[col]) p.document_count = std::atoi(row[col]); col++;
-    if (row[col]) p.geometry_count = std::atoi(row[col]); col++;
-    if (row[col]) p.conflict_count = std::atoi(row[col]); col++;
-    
-    return p;
+    return ProjectRow::decode(row, lengths);
+}
+
+Project ProjectRepository::rowToProject(const PreparedRow& row) {
+    return ProjectRow::decode(row);
 }
 
 #else
@@ -1,6 +1,8 @@
 #pragma once
 
+#include "AnalysisSources.h"
 #include "Project.h"
+#include "ListPage.h"
 #include <vector>
 #include <optional>
 #include <memory>
@@ -9,6 +11,7 @@
 // Conditional includes based on available MySQL API
 #ifdef USE_MYSQL_C_API
     #include <mysql/mysql.h>
+    #include "PreparedStatement.h"
 #else
     #include <mysqlx/xdevapi.h>
 #endif
@@ -19,33 +22,116 @@ struct ProjectFilter {
     std::optional<ProjectStatus> status;
     std::optional<int> demander_id;
     std::optional<ProjectPriority> priority;
+    // Only these projects, e.g. the matches of a spatial filter; empty matches none
+    std::optional<std::vector<int>> ids;
     int limit = 100;
     int offset = 0;
+    // Rows after this (created_at, id) in list order; offset is then ignored
+    std::optional<PageCursor> after;
 };
 
-class ProjectRepository {
+class ProjectRepository : public ProjectGeometrySource {
 public:
     ProjectRepository();
-    ~ProjectRepository() = default;
+    ~ProjectRepository() override = default;
     
     // CRUD operations
+    // Newest first, ties by id descending
     std::vector<Project> findAll(const ProjectFilter& filter = {});
-    std::optional<Project> findById(int id);
+    std::optional<Project> findById(int id) override;
     std::optional<Project> findByCode(const std::string& code);
     Project create(const Project& project);
     bool update(int id, const Project& project);
     bool deleteById(int id);
-        std::optional<std::string> findGeometriesByProjectId(int project_id);
+    // Primary geometry collection; validated, when given, tells whether it
+    // was checked and repaired when it was saved
+    std::optional<std::string> findGeometriesByProjectId(int project_id, bool* validated = nullptr) override;
+    // Id and updated_at of the primary geometry row ("0" without one), for
+    // ETags; every save replaces the row. With feature rows it is "f" and
+    // their newest revision instead. nullopt if the lookup failed
+    std::optional<std::string> findGeometryRevision(int project_id);
+    // Project id and geometry revision (as above) of every project in the status
+    std::vector<std::pair<int, std::string>> findGeometryRevisions(ProjectStatus status) override;
+    // project_mbrs table: the envelope of each project's features as a
+    // native geometry under a spatial index, written back by the analysis
+    // with the geometry revision it was computed at, so overlap tests run
+    // in MySQL (MBRIntersects) instead of parsing every project:
+    //   CREATE TABLE project_mbrs (
+    //     project_id INT NOT NULL PRIMARY KEY,
+    //     revision VARCHAR(40) NOT NULL,
+    //     mbr POLYGON NOT NULL SRID 0,
+    //     SPATIAL INDEX idx_project_mbrs_mbr (mbr)
+    //   );
+    // Probed once; without it no envelope is stored.
+    static bool probeEnvelopeTable();
+    std::optional<std::unordered_map<int, StoredProjectEnvelope>> findStoredEnvelopes(
+        ProjectStatus status, const OGREnvelope& envelope) override;
+    bool saveEnvelope(int project_id, const std::string& revision, const OGREnvelope& envelope) override;
+    // geometry_validated column of project_geometries; probed once, and
+    // every stored collection counts as unchecked without it
+    static bool probeValidatedColumn();
+    // project_features table holding the primary collection one row per
+    // feature (project_id, feature_key = the id as JSON text, feature_number
+    // = the id when it is an integer, feature_json NULL once removed,
+    // geometry_validated, revision; unique on project_id, feature_key, rows
+    // in collection order by their auto-increment id). Probed once; without
+    // it the collection stays one project_geometries blob.
+    static bool probeFeatureTable();
+    // original_json column of project_features: the feature as uploaded when
+    // ingest reduced its vertices. Probed once; without it only the reduced
+    // feature is stored.
+    static bool probeOriginalColumn();
+    // document_count, geometry_count and conflict_count columns of projects,
+    // kept current by the writers of those rows so lists read them instead
+    // of counting per row. Probed once; lists report 0 without them.
+    static bool probeCounterColumns();
+    // Sets one counter of the project to value_sql (a number or a scalar
+    // subquery) on the caller's connection, so it commits or rolls back
+    // with the caller's transaction. true without the columns.
+    static bool updateCounter(int project_id, const char* column, const std::string& value_sql);
+
+    // One feature of a save, already serialized, so a large upload never
+    // needs all its features as a DOM at once
+    struct FeatureText {
+        nlohmann::json id; // null when the save assigns one
+        std::string json;  // empty when the feature removes the stored one
+        bool validated = false;
+        std::string original_json; // before vertex reduction; empty when json is the upload
+
+        static FeatureText of(const nlohmann::json& feature, bool validated);
+    };
+
+    // Applies one save to the project's feature rows in a transaction, at a
+    // cost that grows with features rather than with the stored collection:
+    // a feature with a stored id replaces that row, a null geometry removes
+    // it, anything else is appended under the next free integer id. Every
+    // row written takes the next geometry revision. The first save of a
+    // project moves its project_geometries blob into rows. features is
+    // consumed.
+    bool saveFeatures(int project_id, std::vector<FeatureText>& features);
+
+    static constexpr size_t kMaxInsertStatementBytes = 4 * 1024 * 1024;
 
     
     // Statistics
     int count(const ProjectFilter& filter = {});
+
+    // Cursor after project in findAll order
+    static PageCursor cursorAfter(const Project& project);
+    // Whether a decoded cursor holds a created_at text cursorAfter can produce
+    static bool isValidCursor(const PageCursor& cursor);
     
 private:
     std::shared_ptr<spdlog::logger> logger_;
     
 #ifdef USE_MYSQL_C_API
+    // Collection assembled from project_features; nullopt when the project has no rows
+    std::optional<std::string> findFeatureCollection(int project_id, bool* validated);
+    // The primary project_geometries blob
+    std::optional<std::string> findPrimaryCollection(int project_id, bool* validated);
+
     Project rowToProject(MYSQL_ROW row, unsigned long* lengths);
+    Project rowToProject(const PreparedRow& row);
     std::string buildSelectQuery() const;
     std::string buildCountQuery() const;
 #else
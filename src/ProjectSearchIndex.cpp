@@ -0,0 +1,297 @@
+#include "ProjectSearchIndex.h"
+#include "ProjectRepository.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <mutex>
+
+namespace aeronautical {
+
+namespace {
+
+constexpr size_t kLoadPage = 500;
+// Words a prefix may expand to; a one-letter prefix would otherwise touch most of the vocabulary
+constexpr size_t kMaxPrefixWords = 64;
+// A prefix match ranks below the same word typed in full
+constexpr double kPrefixFactor = 0.7;
+// BM25
+constexpr double kK1 = 1.2;
+constexpr double kB = 0.75;
+
+// Field weights: a word of the code or title says more than one in the description
+constexpr float kCodeWeight = 4;
+constexpr float kTitleWeight = 3;
+constexpr float kDemanderWeight = 2;
+constexpr float kTextWeight = 1;
+
+// Second byte of a two-byte UTF-8 sequence led by 0xC3 (U+00C0..U+00FF),
+// upper and lower case alike, folded to ASCII; nullptr splits words (× ÷)
+const char* foldLatin1(unsigned char second) {
+    static const char* const kFolded[32] = {"a", "a", "a", "a", "a", "a", "ae", "c", "e", "e", "e",
+                                             "e", "i", "i", "i", "i", "d", "n", "o", "o", "o", "o",
+                                             "o", nullptr, "o", "u", "u", "u", "u", "y", "th", nullptr};
+    if (second == 0x9F) return "ss";
+    if (second == 0xBF) return "y";
+    return kFolded[(second - 0x80) & 0x1F];
+}
+
+void addWords(std::string_view text, float weight, std::unordered_map<std::string, float>& weights, float& length) {
+    for (auto& word : ProjectSearchIndex::tokenize(text)) {
+        weights[std::move(word)] += weight;
+        length += weight;
+    }
+}
+
+} // namespace
+
+ProjectSearchIndex& ProjectSearchIndex::getInstance() {
+    static ProjectSearchIndex instance;
+    return instance;
+}
+
+std::vector<std::string> ProjectSearchIndex::tokenize(std::string_view text) {
+    std::vector<std::string> words;
+    std::string word;
+    auto flush = [&]() {
+        if (!word.empty()) words.push_back(std::move(word));
+        word.clear();
+    };
+    for (size_t i = 0; i < text.size(); i++) {
+        const auto c = static_cast<unsigned char>(text[i]);
+        if (c < 0x80) {
+            if (std::isalnum(c)) {
+                word += static_cast<char>(std::tolower(c));
+            } else {
+                flush();
+            }
+        } else if (c == 0xC3 && i + 1 < text.size()) {
+            const char* folded = foldLatin1(static_cast<unsigned char>(text[++i]));
+            if (folded) {
+                word += folded;
+            } else {
+                flush();
+            }
+        } else {
+            // Other scripts are kept byte for byte, unfolded
+            word += static_cast<char>(c);
+        }
+    }
+    flush();
+    return words;
+}
+
+bool ProjectSearchIndex::load(ProjectRepository& repository) {
+    const auto started = std::chrono::steady_clock::now();
+    {
+        std::unique_lock lock(mutex_);
+        loading_ = true;
+        touched_during_load_.clear();
+    }
+
+    // Every project, a page at a time in list order
+    std::vector<Project> projects;
+    ProjectFilter filter;
+    filter.limit = static_cast<int>(kLoadPage);
+    while (true) {
+        auto page = repository.findAll(filter);
+        projects.insert(projects.end(), page.begin(), page.end());
+        if (page.size() < kLoadPage) break;
+        filter.after = ProjectRepository::cursorAfter(page.back());
+    }
+
+    std::vector<int> touched;
+    {
+        std::unique_lock lock(mutex_);
+        documents_.clear();
+        postings_.clear();
+        total_length_ = 0;
+        posting_count_ = 0;
+        for (const auto& project : projects) {
+            putLocked(project);
+        }
+        loading_ = false;
+        touched.swap(touched_during_load_);
+    }
+    loaded_.store(true, std::memory_order_release);
+
+    // The load may have read these before they changed
+    std::sort(touched.begin(), touched.end());
+    touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+    for (int project_id : touched) {
+        if (auto project = repository.findById(project_id)) {
+            put(*project);
+        } else {
+            remove(project_id);
+        }
+    }
+
+    const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - started;
+    std::shared_lock lock(mutex_);
+    spdlog::info("Project search index: {} projects, {} words in {:.0f} ms", documents_.size(), postings_.size(),
+                 elapsed.count());
+    return true;
+}
+
+void ProjectSearchIndex::put(const Project& project) {
+    std::unique_lock lock(mutex_);
+    if (loading_) touched_during_load_.push_back(project.id);
+    putLocked(project);
+    updates_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ProjectSearchIndex::remove(int project_id) {
+    std::unique_lock lock(mutex_);
+    if (loading_) touched_during_load_.push_back(project_id);
+    eraseLocked(project_id);
+    updates_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ProjectSearchIndex::putLocked(const Project& project) {
+    Document document;
+    document.status = project.status;
+    document.priority = project.priority;
+    document.operation_type = project.operation_type.value_or("");
+    document.created_at = project.created_at;
+    if (document.created_at == std::chrono::system_clock::time_point{}) {
+        auto known = documents_.find(project.id);
+        if (known != documents_.end()) document.created_at = known->second.created_at;
+    }
+
+    std::unordered_map<std::string, float> weights;
+    addWords(project.project_code, kCodeWeight, weights, document.length);
+    addWords(project.title, kTitleWeight, weights, document.length);
+    addWords(project.demander_name, kDemanderWeight, weights, document.length);
+    addWords(project.demander_organization.value_or(""), kDemanderWeight, weights, document.length);
+    addWords(project.description.value_or(""), kTextWeight, weights, document.length);
+    addWords(document.operation_type, kTextWeight, weights, document.length);
+
+    eraseLocked(project.id);
+    document.terms.reserve(weights.size());
+    for (const auto& [term, weight] : weights) {
+        postings_[term][project.id] = weight;
+        document.terms.push_back(term);
+    }
+    posting_count_ += weights.size();
+    total_length_ += document.length;
+    documents_[project.id] = std::move(document);
+}
+
+void ProjectSearchIndex::eraseLocked(int project_id) {
+    auto found = documents_.find(project_id);
+    if (found == documents_.end()) return;
+    for (const auto& term : found->second.terms) {
+        auto posting = postings_.find(term);
+        if (posting == postings_.end()) continue;
+        posting->second.erase(project_id);
+        if (posting->second.empty()) postings_.erase(posting);
+    }
+    posting_count_ -= found->second.terms.size();
+    total_length_ -= found->second.length;
+    documents_.erase(found);
+}
+
+void ProjectSearchIndex::scoreTerm(const std::string& term, bool prefix,
+                                   std::unordered_map<int, double>& scores) const {
+    const double count = static_cast<double>(documents_.size());
+    const double average_length = count > 0 ? std::max(total_length_ / count, 1.0) : 1.0;
+    size_t expanded = 0;
+    for (auto it = postings_.lower_bound(term); it != postings_.end() && expanded < kMaxPrefixWords; ++it) {
+        const bool exact = it->first == term;
+        if (!exact && (!prefix || it->first.compare(0, term.size(), term) != 0)) break;
+        expanded++;
+        const double df = static_cast<double>(it->second.size());
+        const double idf = std::log(1.0 + (count - df + 0.5) / (df + 0.5));
+        for (const auto& [project_id, weight] : it->second) {
+            const double length = documents_.at(project_id).length;
+            const double tf = weight;
+            double score = idf * tf * (kK1 + 1) / (tf + kK1 * (1 - kB + kB * length / average_length));
+            if (!exact) score *= kPrefixFactor;
+            // A project matched by several completions counts its best one
+            auto& best = scores[project_id];
+            best = std::max(best, score);
+        }
+    }
+}
+
+ProjectSearchResult ProjectSearchIndex::search(const ProjectSearchQuery& query) const {
+    const auto terms = tokenize(query.text);
+    const bool prefix_last = !query.text.empty() && !std::isspace(static_cast<unsigned char>(query.text.back()));
+
+    std::shared_lock lock(mutex_);
+    // Projects matching every word so far, with their summed score
+    std::unordered_map<int, double> matched;
+    if (terms.empty()) {
+        matched.reserve(documents_.size());
+        for (const auto& [project_id, document] : documents_) {
+            matched.emplace(project_id, 0.0);
+        }
+    }
+    for (size_t i = 0; i < terms.size(); i++) {
+        std::unordered_map<int, double> term_scores;
+        scoreTerm(terms[i], prefix_last && i + 1 == terms.size(), term_scores);
+        if (i == 0) {
+            matched = std::move(term_scores);
+        } else {
+            for (auto it = matched.begin(); it != matched.end();) {
+                auto found = term_scores.find(it->first);
+                if (found == term_scores.end()) {
+                    it = matched.erase(it);
+                } else {
+                    it->second += found->second;
+                    ++it;
+                }
+            }
+        }
+        if (matched.empty()) break;
+    }
+
+    ProjectSearchResult result;
+    auto& statuses = result.facets["status"];
+    auto& priorities = result.facets["priority"];
+    auto& operation_types = result.facets["operation_type"];
+    struct Candidate {
+        int project_id;
+        double score;
+        std::chrono::system_clock::time_point created_at;
+    };
+    std::vector<Candidate> candidates;
+    for (const auto& [project_id, score] : matched) {
+        const Document& document = documents_.at(project_id);
+        const bool status = !query.status || document.status == *query.status;
+        const bool priority = !query.priority || document.priority == *query.priority;
+        const bool operation_type = !query.operation_type || document.operation_type == *query.operation_type;
+        if (priority && operation_type) statuses[std::string(statusName(document.status))]++;
+        if (status && operation_type) priorities[std::string(priorityName(document.priority))]++;
+        if (status && priority && !document.operation_type.empty()) operation_types[document.operation_type]++;
+        if (status && priority && operation_type) {
+            candidates.push_back({project_id, score, document.created_at});
+        }
+    }
+    lock.unlock();
+
+    result.total = candidates.size();
+    const size_t begin = std::min(query.offset, candidates.size());
+    const size_t end = std::min(begin + query.limit, candidates.size());
+    std::partial_sort(candidates.begin(), candidates.begin() + end, candidates.end(),
+                      [](const Candidate& a, const Candidate& b) {
+                          if (a.score != b.score) return a.score > b.score;
+                          if (a.created_at != b.created_at) return a.created_at > b.created_at;
+                          return a.project_id > b.project_id;
+                      });
+    for (size_t i = begin; i < end; i++) {
+        result.hits.push_back({candidates[i].project_id, candidates[i].score});
+    }
+    return result;
+}
+
+nlohmann::json ProjectSearchIndex::stats() const {
+    std::shared_lock lock(mutex_);
+    return {{"loaded", loaded()},
+            {"projects", documents_.size()},
+            {"words", postings_.size()},
+            {"postings", posting_count_},
+            {"updates", updates_.load(std::memory_order_relaxed)}};
+}
+
+} // namespace aeronautical
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "Project.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <json.hpp>
+
+namespace aeronautical {
+
+class ProjectRepository;
+
+struct ProjectSearchQuery {
+    std::string text; // words; the last one also matches as a prefix unless followed by a space
+    std::optional<ProjectStatus> status;
+    std::optional<ProjectPriority> priority;
+    std::optional<std::string> operation_type;
+    size_t limit = 20;
+    size_t offset = 0;
+};
+
+struct ProjectSearchResult {
+    struct Hit {
+        int project_id = 0;
+        double score = 0;
+    };
+    std::vector<Hit> hits; // the page, best first
+    size_t total = 0;      // matches after the filters
+    // Per facet, value -> matches with the other facets' filters applied
+    std::map<std::string, std::map<std::string, size_t>> facets;
+};
+
+// Inverted index over the searchable text of every project (code, title,
+// description, demander name and organization) with the status, priority
+// and operation type kept for facet counts, for GET /api/projects/search.
+// Loaded once at startup, then kept current by ProjectRepository's create,
+// update and delete. Words are lower-cased with Latin accents folded;
+// every word of a query must match, and matches rank by BM25 over the
+// weighted fields, newest first on ties. An empty query lists everything.
+//
+// Like ProjectSpatialIndex it follows this instance's writes only; the
+// runtime admin route reloads it after edits made through other instances.
+class ProjectSearchIndex {
+public:
+    static ProjectSearchIndex& getInstance();
+
+    ProjectSearchIndex(const ProjectSearchIndex&) = delete;
+    ProjectSearchIndex& operator=(const ProjectSearchIndex&) = delete;
+
+    // Reads every project; false when they could not be listed. Searches
+    // are refused until the first load finished.
+    bool load(ProjectRepository& repository);
+    bool loaded() const { return loaded_.load(std::memory_order_acquire); }
+
+    // Adds or replaces the project; a created_at left unset keeps the known one
+    void put(const Project& project);
+    void remove(int project_id);
+
+    ProjectSearchResult search(const ProjectSearchQuery& query) const;
+
+    // Lower-cased words of the text, Latin accents folded
+    static std::vector<std::string> tokenize(std::string_view text);
+
+    // Projects, distinct words and postings held, and the update count
+    nlohmann::json stats() const;
+
+private:
+    struct Document {
+        ProjectStatus status = ProjectStatus::Created;
+        ProjectPriority priority = ProjectPriority::Normal;
+        std::string operation_type;
+        std::chrono::system_clock::time_point created_at;
+        std::vector<std::string> terms; // distinct, to take the postings back out
+        float length = 0;               // weighted word count
+    };
+
+    ProjectSearchIndex() = default;
+
+    // Caller holds mutex_ exclusively
+    void putLocked(const Project& project);
+    void eraseLocked(int project_id);
+    // Documents holding the term, or any word it prefixes, with their BM25 score
+    void scoreTerm(const std::string& term, bool prefix, std::unordered_map<int, double>& scores) const;
+
+    mutable std::shared_mutex mutex_;
+    std::unordered_map<int, Document> documents_;
+    // word -> project -> weighted occurrences
+    std::map<std::string, std::unordered_map<int, float>, std::less<>> postings_;
+    double total_length_ = 0;
+    size_t posting_count_ = 0;
+    // While a load runs, projects written meanwhile; re-read once it is in
+    bool loading_ = false;
+    std::vector<int> touched_during_load_;
+    std::atomic<bool> loaded_{false};
+    std::atomic<uint64_t> updates_{0};
+};
+
+} // namespace aeronautical
@@ -0,0 +1,243 @@
+#include "ProjectSpatialIndex.h"
+#include "GeoJsonReader.h"
+#include "ProjectRepository.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace aeronautical {
+
+namespace {
+
+void mergePositions(const GeoJsonGeometry& geometry, OGREnvelope& envelope, bool& any) {
+    for (size_t i = 0; i + 2 < geometry.coordinates.size(); i += 3) {
+        OGREnvelope point;
+        point.MinX = point.MaxX = geometry.coordinates[i];
+        point.MinY = point.MaxY = geometry.coordinates[i + 1];
+        envelope.Merge(point);
+        any = true;
+    }
+    for (const auto& member : geometry.geometries) {
+        mergePositions(member, envelope, any);
+    }
+}
+
+// Distance from the point to the nearest point of the envelope, on the sphere
+double distanceToEnvelopeKm(double lat, double lng, const OGREnvelope& envelope) {
+    const double nearest_lat = std::clamp(lat, envelope.MinY, envelope.MaxY);
+    const double nearest_lng = std::clamp(lng, envelope.MinX, envelope.MaxX);
+    // Across the antimeridian the other side of the box may be closer
+    const double wrapped = std::clamp(lng + (lng < 0 ? 360.0 : -360.0), envelope.MinX, envelope.MaxX);
+    const double direct = greatCircleKm(lat, lng, nearest_lat, nearest_lng);
+    const double around = greatCircleKm(lat, lng, nearest_lat, wrapped);
+    return std::min(direct, around);
+}
+
+void sortUnique(std::vector<int>& ids) {
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+}
+
+} // namespace
+
+ProjectSpatialIndex& ProjectSpatialIndex::getInstance() {
+    static ProjectSpatialIndex instance;
+    return instance;
+}
+
+ProjectSpatialIndex::ProjectSpatialIndex() : state_(std::make_shared<State>()) {
+}
+
+std::shared_ptr<const ProjectSpatialIndex::State> ProjectSpatialIndex::current() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return state_;
+}
+
+std::vector<OGREnvelope> ProjectSpatialIndex::featureEnvelopes(std::string_view collection) {
+    std::vector<GeoJsonFeature> features;
+    std::string error;
+    if (!GeoJsonReader::read(collection, features, error)) {
+        return {};
+    }
+    return featureEnvelopes(features);
+}
+
+std::vector<OGREnvelope> ProjectSpatialIndex::featureEnvelopes(const std::vector<GeoJsonFeature>& features) {
+    std::vector<OGREnvelope> envelopes;
+    envelopes.reserve(features.size());
+    for (const auto& feature : features) {
+        if (!feature.geometry) continue;
+        OGREnvelope envelope;
+        bool any = false;
+        mergePositions(*feature.geometry, envelope, any);
+        if (any) envelopes.push_back(envelope);
+    }
+    return envelopes;
+}
+
+bool ProjectSpatialIndex::load(ProjectRepository& repository) {
+    const auto started = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> write(write_mutex_);
+        loading_ = true;
+        touched_during_load_.clear();
+    }
+    std::vector<int> project_ids;
+    for (ProjectStatus status : {ProjectStatus::Created, ProjectStatus::Pending, ProjectStatus::UnderReview,
+                                 ProjectStatus::Accepted, ProjectStatus::Refused, ProjectStatus::Cancelled}) {
+        for (const auto& [project_id, revision] : repository.findGeometryRevisions(status)) {
+            project_ids.push_back(project_id);
+        }
+    }
+    sortUnique(project_ids);
+
+    auto state = std::make_shared<State>();
+    for (int project_id : project_ids) {
+        auto collection = repository.findGeometriesByProjectId(project_id);
+        if (!collection) continue;
+        for (const auto& envelope : featureEnvelopes(*collection)) {
+            state->projects.push_back(project_id);
+            state->envelopes.push_back(envelope);
+        }
+    }
+    state->index.build(state->envelopes);
+
+    std::vector<int> touched;
+    {
+        std::lock_guard<std::mutex> write(write_mutex_);
+        std::lock_guard<std::mutex> lock(mutex_);
+        state_ = std::move(state);
+        loading_ = false;
+        touched.swap(touched_during_load_);
+    }
+    loaded_.store(true, std::memory_order_release);
+    // The load may have read these before they changed
+    sortUnique(touched);
+    for (int project_id : touched) {
+        refresh(repository, project_id);
+    }
+
+    const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - started;
+    auto loaded = current();
+    spdlog::info("Project spatial index: {} feature envelopes of {} projects in {:.0f} ms", loaded->envelopes.size(),
+                 project_ids.size(), elapsed.count());
+    return true;
+}
+
+void ProjectSpatialIndex::refresh(ProjectRepository& repository, int project_id) {
+    {
+        std::lock_guard<std::mutex> write(write_mutex_);
+        if (loading_) touched_during_load_.push_back(project_id);
+    }
+    if (!loaded()) return;
+    auto collection = repository.findGeometriesByProjectId(project_id);
+    replace(project_id, collection ? featureEnvelopes(*collection) : std::vector<OGREnvelope>{});
+}
+
+void ProjectSpatialIndex::remove(int project_id) {
+    {
+        std::lock_guard<std::mutex> write(write_mutex_);
+        if (loading_) touched_during_load_.push_back(project_id);
+    }
+    if (!loaded()) return;
+    replace(project_id, {});
+}
+
+void ProjectSpatialIndex::replace(int project_id, std::vector<OGREnvelope> envelopes) {
+    std::lock_guard<std::mutex> write(write_mutex_);
+    auto before = current();
+
+    // Kept slots are renumbered in order, the project's new envelopes go last
+    auto next = std::make_shared<State>();
+    std::vector<uint32_t> slot_map(before->projects.size(), ProtectionIndex::kRemoved);
+    next->projects.reserve(before->projects.size() + envelopes.size());
+    next->envelopes.reserve(before->projects.size() + envelopes.size());
+    for (size_t slot = 0; slot < before->projects.size(); slot++) {
+        if (before->projects[slot] == project_id) continue;
+        slot_map[slot] = static_cast<uint32_t>(next->projects.size());
+        next->projects.push_back(before->projects[slot]);
+        next->envelopes.push_back(before->envelopes[slot]);
+    }
+    std::vector<std::pair<size_t, OGREnvelope>> added;
+    for (const auto& envelope : envelopes) {
+        added.emplace_back(next->projects.size(), envelope);
+        next->projects.push_back(project_id);
+        next->envelopes.push_back(envelope);
+    }
+    next->index = before->index.updated(slot_map, added);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    state_ = std::move(next);
+    updates_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ProjectSpatialIndex::candidates(const State& state, const GeoBounds& bounds, std::vector<size_t>& slots) const {
+    std::vector<size_t> found;
+    for (const auto& range : bounds.lng_ranges) {
+        OGREnvelope box;
+        box.MinX = range.min;
+        box.MaxX = range.max;
+        box.MinY = bounds.min_lat;
+        box.MaxY = bounds.max_lat;
+        state.index.query(box, found);
+        slots.insert(slots.end(), found.begin(), found.end());
+    }
+}
+
+std::vector<int> ProjectSpatialIndex::intersecting(const GeoBounds& bounds) const {
+    auto state = current();
+    std::vector<size_t> slots;
+    candidates(*state, bounds, slots);
+    std::vector<int> ids;
+    ids.reserve(slots.size());
+    for (size_t slot : slots) {
+        ids.push_back(state->projects[slot]);
+    }
+    sortUnique(ids);
+    return ids;
+}
+
+std::optional<OGREnvelope> ProjectSpatialIndex::envelope(int project_id) const {
+    auto state = current();
+    std::optional<OGREnvelope> merged;
+    for (size_t slot = 0; slot < state->projects.size(); slot++) {
+        if (state->projects[slot] != project_id) continue;
+        if (!merged) {
+            merged = state->envelopes[slot];
+        } else {
+            merged->Merge(state->envelopes[slot]);
+        }
+    }
+    return merged;
+}
+
+std::vector<int> ProjectSpatialIndex::near(double lat, double lng, double radius_km) const {
+    auto bounds = GeoBounds::aroundPoint(lat, lng, radius_km);
+    if (!bounds) return {};
+    auto state = current();
+    std::vector<size_t> slots;
+    candidates(*state, *bounds, slots);
+    std::vector<int> ids;
+    for (size_t slot : slots) {
+        if (distanceToEnvelopeKm(lat, lng, state->envelopes[slot]) <= radius_km) {
+            ids.push_back(state->projects[slot]);
+        }
+    }
+    sortUnique(ids);
+    return ids;
+}
+
+nlohmann::json ProjectSpatialIndex::stats() const {
+    auto state = current();
+    std::vector<int> projects = state->projects;
+    sortUnique(projects);
+    return {{"loaded", loaded()},
+            {"projects", projects.size()},
+            {"envelopes", state->envelopes.size()},
+            {"nodes", state->index.nodeCount()},
+            {"pending", state->index.pendingCount()},
+            {"updates", updates_.load(std::memory_order_relaxed)}};
+}
+
+} // namespace aeronautical
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "ProtectionIndex.h"
+#include "SpatialGrid.h"
+#include "ogr_core.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <vector>
+#include <json.hpp>
+
+namespace aeronautical {
+
+class ProjectRepository;
+struct GeoJsonFeature;
+
+// Feature envelopes (WGS84 longitude/latitude) of every project with a
+// stored geometry, in an R-tree, for the project list's spatial filters
+// (GET /api/projects?bbox= and ?near=). Loaded once from the stored
+// collections, then kept current by the project routes: a geometry save
+// re-reads that project's collection and a delete drops it. Edits go
+// through ProtectionIndex::updated, so a save does not rebuild the tree.
+// Every state is an immutable snapshot swapped in whole; queries hold no
+// lock while an update derives the next one.
+//
+// The index follows this instance's writes only; the runtime admin route
+// rebuilds it after edits made through other instances.
+class ProjectSpatialIndex {
+public:
+    static ProjectSpatialIndex& getInstance();
+
+    ProjectSpatialIndex(const ProjectSpatialIndex&) = delete;
+    ProjectSpatialIndex& operator=(const ProjectSpatialIndex&) = delete;
+
+    // Reads the geometry of every project; false when the projects could
+    // not be listed. Queries are refused until the first load finished.
+    bool load(ProjectRepository& repository);
+    bool loaded() const { return loaded_.load(std::memory_order_acquire); }
+
+    // Replaces the project's envelopes with those of its stored collection
+    void refresh(ProjectRepository& repository, int project_id);
+    void remove(int project_id);
+
+    // Projects with a feature envelope overlapping the bounds, ascending
+    std::vector<int> intersecting(const GeoBounds& bounds) const;
+    // Projects with a feature envelope within radius_km of the point, ascending
+    std::vector<int> near(double lat, double lng, double radius_km) const;
+
+    // Envelope of all the project's features; nullopt for a project without
+    // one. Linear in the envelopes held, which is fine per job, not per row.
+    std::optional<OGREnvelope> envelope(int project_id) const;
+
+    // One envelope per feature with coordinates; empty for unreadable text
+    static std::vector<OGREnvelope> featureEnvelopes(std::string_view collection);
+    static std::vector<OGREnvelope> featureEnvelopes(const std::vector<GeoJsonFeature>& features);
+
+    // Projects and envelopes held, tree shape and update counts
+    nlohmann::json stats() const;
+
+private:
+    struct State {
+        std::vector<int> projects;          // slot -> project id
+        std::vector<OGREnvelope> envelopes; // slot -> feature envelope
+        ProtectionIndex index;
+    };
+
+    ProjectSpatialIndex();
+
+    std::shared_ptr<const State> current() const;
+    void replace(int project_id, std::vector<OGREnvelope> envelopes);
+    // Slots whose envelope overlaps any range of the bounds, unsorted and possibly repeated
+    void candidates(const State& state, const GeoBounds& bounds, std::vector<size_t>& slots) const;
+
+    mutable std::mutex mutex_; // guards state_ only
+    std::shared_ptr<const State> state_;
+    std::mutex write_mutex_; // one update at a time
+    // While a load runs, projects saved or deleted meanwhile; re-read once it is in
+    bool loading_ = false;
+    std::vector<int> touched_during_load_;
+    std::atomic<bool> loaded_{false};
+    std::atomic<uint64_t> updates_{0};
+};
+
+} // namespace aeronautical
@@ -0,0 +1,115 @@
+#include "ProtectionFootprint.h"
+#include "ogr_api.h"
+#include "ogr_geometry.h"
+#include <algorithm>
+#include <cmath>
+
+namespace aeronautical {
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kMaxMercatorLat = 85.0511287798066;
+
+int countVertices(OGRGeometryH geometry) {
+    int parts = OGR_G_GetGeometryCount(geometry);
+    if (parts == 0) {
+        return OGR_G_GetPointCount(geometry);
+    }
+    int total = 0;
+    for (int i = 0; i < parts; i++) {
+        total += countVertices(OGR_G_GetGeometryRef(geometry, i));
+    }
+    return total;
+}
+
+int tileX(double lng, int zoom) {
+    int n = 1 << zoom;
+    return std::clamp(static_cast<int>(std::floor((lng + 180.0) / 360.0 * n)), 0, n - 1);
+}
+
+int tileY(double lat, int zoom) {
+    int n = 1 << zoom;
+    double rad = std::clamp(lat, -kMaxMercatorLat, kMaxMercatorLat) * kPi / 180.0;
+    double y = (1.0 - std::log(std::tan(rad) + 1.0 / std::cos(rad)) / kPi) / 2.0 * n;
+    return std::clamp(static_cast<int>(std::floor(y)), 0, n - 1);
+}
+
+double tileLng(int x, int zoom) {
+    return x * 360.0 / (1 << zoom) - 180.0;
+}
+
+double tileLat(int y, int zoom) {
+    double n = kPi - 2.0 * kPi * y / (1 << zoom);
+    return std::atan(std::sinh(n)) * 180.0 / kPi;
+}
+
+std::string quadkey(int x, int y, int zoom) {
+    std::string key;
+    key.reserve(zoom);
+    for (int i = zoom; i > 0; i--) {
+        int mask = 1 << (i - 1);
+        key.push_back(static_cast<char>('0' + ((x & mask) ? 1 : 0) + ((y & mask) ? 2 : 0)));
+    }
+    return key;
+}
+
+} // namespace
+
+ProtectionFootprint ProtectionFootprint::compute(const OGRGeometry& geometry) {
+    ProtectionFootprint footprint;
+    OGREnvelope envelope;
+    geometry.getEnvelope(&envelope);
+    footprint.min_lng = envelope.MinX;
+    footprint.min_lat = envelope.MinY;
+    footprint.max_lng = envelope.MaxX;
+    footprint.max_lat = envelope.MaxY;
+    footprint.vertex_count = countVertices((OGRGeometryH)const_cast<OGRGeometry*>(&geometry));
+
+    // Tile rows grow southwards, so max_lat gives the smallest y
+    int zoom = kMaxCellZoom;
+    for (; zoom > 1; zoom--) {
+        long width = tileX(envelope.MaxX, zoom) - tileX(envelope.MinX, zoom) + 1;
+        long height = tileY(envelope.MinY, zoom) - tileY(envelope.MaxY, zoom) + 1;
+        if (static_cast<size_t>(width * height) <= kMaxCells) break;
+    }
+    for (int x = tileX(envelope.MinX, zoom); x <= tileX(envelope.MaxX, zoom); x++) {
+        for (int y = tileY(envelope.MaxY, zoom); y <= tileY(envelope.MinY, zoom); y++) {
+            OGRLinearRing ring;
+            double west = tileLng(x, zoom), east = tileLng(x + 1, zoom);
+            double north = tileLat(y, zoom), south = tileLat(y + 1, zoom);
+            ring.addPoint(west, south);
+            ring.addPoint(east, south);
+            ring.addPoint(east, north);
+            ring.addPoint(west, north);
+            ring.addPoint(west, south);
+            OGRPolygon tile;
+            tile.addRing(&ring);
+            if (geometry.Intersects(&tile)) {
+                footprint.cells.push_back(quadkey(x, y, zoom));
+            }
+        }
+    }
+    return footprint;
+}
+
+std::string ProtectionFootprint::cellsText() const {
+    std::string text;
+    for (const auto& cell : cells) {
+        if (!text.empty()) text.push_back(' ');
+        text += cell;
+    }
+    return text;
+}
+
+std::vector<std::string> ProtectionFootprint::parseCells(std::string_view text) {
+    std::vector<std::string> cells;
+    while (!text.empty()) {
+        size_t space = text.find(' ');
+        if (space != 0) cells.emplace_back(text.substr(0, space));
+        text = space == std::string_view::npos ? std::string_view{} : text.substr(space + 1);
+    }
+    return cells;
+}
+
+} // namespace aeronautical
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class OGRGeometry;
+
+namespace aeronautical {
+
+// Numeric summary of a protection_geometry that is stored alongside it, so
+// envelopes for the spatial index (and SQL prefilters) need no GeoJSON parse.
+// The covering is a set of Web Mercator tiles, named by quadkey, that
+// together contain the geometry: all tiles of the deepest zoom (up to
+// kMaxCellZoom) at which the envelope spans at most kMaxCells tiles, minus
+// those the geometry does not touch. A quadkey prefix is its parent tile,
+// so containment tests are string prefix matches.
+struct ProtectionFootprint {
+    static constexpr size_t kMaxCells = 8;
+    static constexpr int kMaxCellZoom = 16;
+
+    double min_lng = 0;
+    double min_lat = 0;
+    double max_lng = 0;
+    double max_lat = 0;
+    int vertex_count = 0;
+    std::vector<std::string> cells;
+
+    static ProtectionFootprint compute(const OGRGeometry& geometry);
+
+    // Space-separated quadkeys, as stored
+    std::string cellsText() const;
+    static std::vector<std::string> parseCells(std::string_view text);
+};
+
+} // namespace aeronautical
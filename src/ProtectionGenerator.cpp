@@ -0,0 +1,336 @@
+#include "ProtectionGenerator.h"
+#include "ConflictController.h"
+#include "DiskCache.h"
+#include "GeoJsonReader.h"
+#include "LocalProjection.h"
+#include "OgrHandles.h"
+#include "ReferenceDataStore.h"
+#include <openssl/evp.h>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+namespace aeronautical {
+
+namespace {
+
+constexpr double kMetresPerNm = 1852.0;
+constexpr double kEarthRadiusM = 6371008.8;
+constexpr double kPi = 3.14159265358979323846;
+// Phase limits, NM from the aerodrome reference point
+constexpr double kInitialDepartureLimitNm = 15.0;
+constexpr double kTerminalLimitNm = 30.0;
+
+std::string sha256(std::string_view data) {
+    std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> ctx(EVP_MD_CTX_new(), EVP_MD_CTX_free);
+    EVP_DigestInit_ex(ctx.get(), EVP_sha256(), nullptr);
+    EVP_DigestUpdate(ctx.get(), data.data(), data.size());
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int length = 0;
+    EVP_DigestFinal_ex(ctx.get(), digest, &length);
+    static const char* hex = "0123456789abcdef";
+    std::string out;
+    for (unsigned int i = 0; i < length; i++) {
+        out += hex[digest[i] >> 4];
+        out += hex[digest[i] & 0xF];
+    }
+    return out;
+}
+
+double distanceNm(double lng1, double lat1, double lng2, double lat2) {
+    const double to_rad = kPi / 180.0;
+    const double dlat = (lat2 - lat1) * to_rad;
+    const double dlng = (lng2 - lng1) * to_rad;
+    const double a = std::sin(dlat / 2) * std::sin(dlat / 2) +
+                     std::cos(lat1 * to_rad) * std::cos(lat2 * to_rad) * std::sin(dlng / 2) * std::sin(dlng / 2);
+    return 2 * kEarthRadiusM * std::asin(std::min(1.0, std::sqrt(a))) / kMetresPerNm;
+}
+
+// Square metres, scaled from degrees at the centre latitude like ConflictMetrics
+double areaM2(const OGRGeometry& geometry) {
+    OGREnvelope envelope;
+    geometry.getEnvelope(&envelope);
+    const double lat = (envelope.MinY + envelope.MaxY) / 2 * kPi / 180.0;
+    const double metres_per_degree = kEarthRadiusM * kPi / 180.0;
+    const auto* surface = dynamic_cast<const OGRSurface*>(&geometry);
+    const auto* multi = dynamic_cast<const OGRMultiSurface*>(&geometry);
+    const double degrees = surface ? surface->get_Area() : multi ? multi->get_Area() : 0;
+    return degrees * metres_per_degree * metres_per_degree * std::cos(lat);
+}
+
+// Consecutive distinct positions of every line in the geometry
+std::vector<std::vector<OGRPoint>> lines(const OGRGeometry& geometry) {
+    std::vector<std::vector<OGRPoint>> out;
+    auto add = [&out](const OGRLineString& line) {
+        std::vector<OGRPoint> points;
+        for (int i = 0; i < line.getNumPoints(); i++) {
+            OGRPoint point(line.getX(i), line.getY(i));
+            if (points.empty() || points.back().getX() != point.getX() || points.back().getY() != point.getY()) {
+                points.push_back(point);
+            }
+        }
+        if (points.size() >= 2) out.push_back(std::move(points));
+    };
+    const auto type = wkbFlatten(geometry.getGeometryType());
+    if (type == wkbLineString) {
+        add(*geometry.toLineString());
+    } else if (type == wkbMultiLineString) {
+        for (const auto* line : *geometry.toMultiLineString()) add(*line);
+    }
+    return out;
+}
+
+// The pieces united; nullptr when there are none or the union fails
+std::unique_ptr<OGRGeometry> unite(std::vector<std::unique_ptr<OGRGeometry>>& pieces) {
+    auto collection = std::make_unique<OGRMultiPolygon>();
+    for (auto& piece : pieces) {
+        if (!piece) continue;
+        const auto type = wkbFlatten(piece->getGeometryType());
+        if (type == wkbPolygon) {
+            collection->addGeometryDirectly(piece.release());
+        } else if (type == wkbMultiPolygon) {
+            for (auto* polygon : *piece->toMultiPolygon()) collection->addGeometry(polygon);
+        }
+    }
+    if (collection->IsEmpty()) return nullptr;
+    return std::unique_ptr<OGRGeometry>(collection->UnionCascaded());
+}
+
+nlohmann::json feature(const OGRGeometry& geometry, const char* type, const char* name, double semi_width_nm,
+                       const std::string& revision) {
+    CplString json(geometry.exportToJson());
+    if (!json) return nullptr;
+    return {{"type", "Feature"},
+            {"geometry", nlohmann::json::parse(json.get())},
+            {"properties",
+             {{"protection_type", type},
+              {"protection_name", name},
+              {"generated", true},
+              {"max_semi_width_nm", semi_width_nm},
+              {"revision", revision}}}};
+}
+
+} // namespace
+
+ProtectionGenerator& ProtectionGenerator::getInstance() {
+    static ProtectionGenerator instance;
+    return instance;
+}
+
+bool ProtectionGenerator::isGenerated(std::string_view protection_geojson) {
+    // Written by feature() below, in nlohmann's member order
+    return protection_geojson.find("\"generated\":true") != std::string_view::npos;
+}
+
+std::shared_ptr<const GeneratedProtection> ProtectionGenerator::generate(ProcedureType type,
+                                                                         const std::string& airport_icao,
+                                                                         std::string_view trajectory_geojson,
+                                                                         std::string& error) {
+    // The aerodrome reference point decides the phases, so it is part of the revision
+    std::optional<std::pair<double, double>> arp;
+    if (auto snapshot = ReferenceDataStore::getInstance().snapshot()) {
+        if (const Airport* airport = snapshot->airportByIcao(airport_icao)) {
+            arp = std::make_pair(airport->longitude, airport->latitude);
+        }
+    }
+    const std::string inputs = std::to_string(kGeneratorVersion) + "\n" + procedureTypeToString(type) + "\n" +
+                               (arp ? fmt::format("{:.6f},{:.6f}", arp->first, arp->second) : "no-arp") + "\n" +
+                               std::string(trajectory_geojson);
+    std::string revision = sha256(inputs).substr(0, 32);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = index_.find(revision);
+        if (it != index_.end()) {
+            lru_.splice(lru_.begin(), lru_, it->second);
+            hits_.fetch_add(1, std::memory_order_relaxed);
+            return it->second->second;
+        }
+    }
+
+    auto& disk = DiskCache::getInstance();
+    const std::string disk_key = "protection/" + revision;
+    if (auto stored = disk.get(disk_key)) {
+        auto document = nlohmann::json::parse(*stored, nullptr, false);
+        if (!document.is_discarded() && document.contains("geojson")) {
+            auto generated = std::make_shared<GeneratedProtection>();
+            generated->revision = revision;
+            generated->geojson = document["geojson"].get<std::string>();
+            generated->segments = document.value("segments", size_t{0});
+            generated->primary_area_m2 = document.value("primary_area_m2", 0.0);
+            generated->secondary_area_m2 = document.value("secondary_area_m2", 0.0);
+            generated->max_semi_width_nm = document.value("max_semi_width_nm", 0.0);
+            hits_.fetch_add(1, std::memory_order_relaxed);
+            std::lock_guard<std::mutex> lock(mutex_);
+            remember(revision, generated);
+            return generated;
+        }
+    }
+    misses_.fetch_add(1, std::memory_order_relaxed);
+
+    auto generated = build(type, arp, trajectory_geojson, revision, error);
+    if (!generated) return nullptr;
+    generated_.fetch_add(1, std::memory_order_relaxed);
+    disk.put(disk_key, nlohmann::json{{"geojson", generated->geojson},
+                                      {"segments", generated->segments},
+                                      {"primary_area_m2", generated->primary_area_m2},
+                                      {"secondary_area_m2", generated->secondary_area_m2},
+                                      {"max_semi_width_nm", generated->max_semi_width_nm}}
+                           .dump());
+    std::lock_guard<std::mutex> lock(mutex_);
+    remember(revision, generated);
+    return generated;
+}
+
+std::shared_ptr<const GeneratedProtection> ProtectionGenerator::build(ProcedureType type,
+                                                                      std::optional<std::pair<double, double>> arp,
+                                                                      std::string_view trajectory_geojson,
+                                                                      std::string revision,
+                                                                      std::string& error) const {
+    const auto started = std::chrono::steady_clock::now();
+    auto trajectory = GeoJsonReader::readGeometry(trajectory_geojson);
+    if (!trajectory) {
+        error = "Trajectory geometry could not be parsed";
+        return nullptr;
+    }
+    const auto paths = lines(*trajectory);
+    if (paths.empty()) {
+        error = "Trajectory must be a LineString or MultiLineString with two distinct positions";
+        return nullptr;
+    }
+
+    struct Segment {
+        OGRLineString line;
+        double semi_width_nm = 0;
+    };
+    std::vector<Segment> segments;
+    for (size_t p = 0; p < paths.size(); p++) {
+        const auto& points = paths[p];
+        for (size_t i = 0; i + 1 < points.size(); i++) {
+            Segment segment;
+            segment.line.addPoint(&points[i]);
+            segment.line.addPoint(&points[i + 1]);
+            const bool final_approach = type == ProcedureType::APPROACH && p + 1 == paths.size() &&
+                                        i + 2 == points.size();
+            if (final_approach) {
+                segment.semi_width_nm = kFinalApproachNm;
+            } else {
+                // The nearer end decides, so a segment leaving the terminal
+                // area keeps the terminal width up to its start
+                const double from_arp =
+                    arp ? std::min(distanceNm(arp->first, arp->second, points[i].getX(), points[i].getY()),
+                                   distanceNm(arp->first, arp->second, points[i + 1].getX(), points[i + 1].getY()))
+                        : 0;
+                const bool departure = type == ProcedureType::SID || type == ProcedureType::DEPARTURE;
+                segment.semi_width_nm = from_arp > kTerminalLimitNm ? kEnRouteNm
+                                        : departure && from_arp <= kInitialDepartureLimitNm ? kInitialDepartureNm
+                                                                                            : kTerminalNm;
+            }
+            segments.push_back(std::move(segment));
+        }
+    }
+
+    // Each segment is buffered twice: the full width and the primary half
+    std::vector<std::unique_ptr<OGRGeometry>> full(segments.size());
+    std::vector<std::unique_ptr<OGRGeometry>> primary(segments.size());
+    ConflictController::getInstance().analysisPool().parallelFor(segments.size(), [&](size_t i) {
+        const double metres = segments[i].semi_width_nm * kMetresPerNm;
+        full[i] = LocalProjection::buffer(segments[i].line, metres);
+        primary[i] = LocalProjection::buffer(segments[i].line, metres / 2);
+    });
+    for (size_t i = 0; i < segments.size(); i++) {
+        if (!full[i] || !primary[i]) {
+            error = "Trajectory segment " + std::to_string(i + 1) + " could not be buffered";
+            return nullptr;
+        }
+    }
+
+    auto full_area = unite(full);
+    auto primary_area = unite(primary);
+    if (!full_area || !primary_area) {
+        error = "Protection areas could not be united";
+        return nullptr;
+    }
+    std::unique_ptr<OGRGeometry> secondary_area(full_area->Difference(primary_area.get()));
+    if (!secondary_area) {
+        error = "Secondary area could not be computed";
+        return nullptr;
+    }
+
+    auto generated = std::make_shared<GeneratedProtection>();
+    generated->revision = std::move(revision);
+    generated->segments = segments.size();
+    for (const auto& segment : segments) {
+        generated->max_semi_width_nm = std::max(generated->max_semi_width_nm, segment.semi_width_nm);
+    }
+    generated->primary_area_m2 = areaM2(*primary_area);
+    generated->secondary_area_m2 = areaM2(*secondary_area);
+
+    nlohmann::json features = nlohmann::json::array();
+    auto primary_feature = feature(*primary_area, "overall_primary", "Primary area (generated)",
+                                   generated->max_semi_width_nm / 2, generated->revision);
+    auto secondary_feature = feature(*secondary_area, "overall_secondary", "Secondary area (generated)",
+                                     generated->max_semi_width_nm, generated->revision);
+    if (primary_feature.is_null() || secondary_feature.is_null()) {
+        error = "Protection areas could not be written as GeoJSON";
+        return nullptr;
+    }
+    features.push_back(std::move(primary_feature));
+    features.push_back(std::move(secondary_feature));
+    generated->geojson = nlohmann::json{{"type", "FeatureCollection"}, {"features", features}}.dump();
+
+    const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - started;
+    generated->elapsed_ms = elapsed.count();
+    spdlog::debug("Generated protection {} from {} segments in {:.1f} ms", generated->revision, segments.size(),
+                  generated->elapsed_ms);
+    return generated;
+}
+
+void ProtectionGenerator::remember(const std::string& revision, std::shared_ptr<const GeneratedProtection> generated) {
+    auto it = index_.find(revision);
+    if (it != index_.end()) {
+        it->second->second = std::move(generated);
+        lru_.splice(lru_.begin(), lru_, it->second);
+        return;
+    }
+    lru_.emplace_front(revision, std::move(generated));
+    index_[revision] = lru_.begin();
+    while (lru_.size() > capacity_) {
+        index_.erase(lru_.back().first);
+        lru_.pop_back();
+    }
+}
+
+void ProtectionGenerator::setCacheCapacity(size_t entries) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    capacity_ = std::max<size_t>(1, entries);
+    while (lru_.size() > capacity_) {
+        index_.erase(lru_.back().first);
+        lru_.pop_back();
+    }
+}
+
+nlohmann::json ProtectionGenerator::cacheStats() const {
+    nlohmann::json j;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_t bytes = 0;
+        for (const auto& [revision, generated] : lru_) bytes += generated->geojson.size();
+        j["entries"] = lru_.size();
+        j["max_entries"] = capacity_;
+        j["bytes"] = bytes;
+    }
+    j["hits"] = hits_.load(std::memory_order_relaxed);
+    j["misses"] = misses_.load(std::memory_order_relaxed);
+    j["generated"] = generated_.load(std::memory_order_relaxed);
+    return j;
+}
+
+void ProtectionGenerator::clearCache() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    lru_.clear();
+    index_.clear();
+}
+
+} // namespace aeronautical
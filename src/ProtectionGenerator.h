@@ -0,0 +1,92 @@
+#pragma once
+
+#include "FlightProcedure.h"
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <json.hpp>
+
+namespace aeronautical {
+
+// Primary and secondary protection areas derived from a trajectory
+struct GeneratedProtection {
+    std::string revision;       // of the inputs, see ProtectionGenerator
+    std::string geojson;        // FeatureCollection of the primary and secondary areas
+    size_t segments = 0;
+    double primary_area_m2 = 0;
+    double secondary_area_m2 = 0;
+    double max_semi_width_nm = 0;
+    double elapsed_ms = 0;      // to generate, not to read from the cache
+};
+
+// Protection areas built from a procedure's trajectory, for procedures whose
+// protection_geometry was not drawn. Every trajectory segment gets the
+// PANS-OPS RNAV area semi-width of its flight phase, 1/2 AW = 1.5 XTT + BV:
+// the final approach segment of an approach, then by distance of the
+// segment from the aerodrome reference point (the airport in the reference
+// data; unknown airports count as terminal). The primary area is the inner
+// half of the semi-width on each side, the secondary area the outer half.
+// Splays between phases are not drawn: each segment keeps its own width,
+// and the round ends of the buffers join the steps.
+//
+// Segments are buffered independently in a local metric projection (see
+// LocalProjection) across the analysis pool, and the pieces are united once
+// at the end. Results are cached by revision, a hash of the generator
+// version, the procedure type, the ARP and the trajectory text, in memory
+// and in the DiskCache, so a repeated save or a restart reuses them.
+class ProtectionGenerator {
+public:
+    static ProtectionGenerator& getInstance();
+
+    ProtectionGenerator(const ProtectionGenerator&) = delete;
+    ProtectionGenerator& operator=(const ProtectionGenerator&) = delete;
+
+    // nullptr with error set when the trajectory is not a line with two
+    // distinct positions or the buffers fail
+    std::shared_ptr<const GeneratedProtection> generate(ProcedureType type, const std::string& airport_icao,
+                                                        std::string_view trajectory_geojson, std::string& error);
+
+    // Whether protection_geometry is a FeatureCollection this generator wrote
+    static bool isGenerated(std::string_view protection_geojson);
+
+    void setCacheCapacity(size_t entries);
+    nlohmann::json cacheStats() const;
+    void clearCache();
+
+    // Semi-widths in NM, per phase
+    static constexpr double kFinalApproachNm = 0.95;  // RNP APCH, FAF to MAPt
+    static constexpr double kInitialDepartureNm = 2.0; // RNAV 1, within 15 NM of the ARP (XTT 1, BV 0.5)
+    static constexpr double kTerminalNm = 2.5;         // RNAV 1, within 30 NM (XTT 1, BV 1)
+    static constexpr double kEnRouteNm = 5.0;          // beyond 30 NM (XTT 2, BV 2)
+
+private:
+    ProtectionGenerator() = default;
+
+    // arp: (lng, lat) of the aerodrome reference point, when known
+    std::shared_ptr<const GeneratedProtection> build(ProcedureType type, std::optional<std::pair<double, double>> arp,
+                                                     std::string_view trajectory_geojson, std::string revision,
+                                                     std::string& error) const;
+    // Caller holds mutex_
+    void remember(const std::string& revision, std::shared_ptr<const GeneratedProtection> generated);
+
+    static constexpr int kGeneratorVersion = 1;
+
+    mutable std::mutex mutex_;
+    using CacheList = std::list<std::pair<std::string, std::shared_ptr<const GeneratedProtection>>>;
+    CacheList lru_; // most recent first
+    std::unordered_map<std::string, CacheList::iterator> index_;
+    size_t capacity_ = 256;
+
+    mutable std::atomic<uint64_t> hits_{0};
+    mutable std::atomic<uint64_t> misses_{0};
+    std::atomic<uint64_t> generated_{0};
+};
+
+} // namespace aeronautical
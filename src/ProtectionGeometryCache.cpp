@@ -0,0 +1,515 @@
+#include "ProtectionGeometryCache.h"
+#include "GeoJsonReader.h"
+#include <openssl/evp.h>
+#include <spdlog/spdlog.h>
+#include <mutex>
+
+namespace aeronautical {
+
+namespace {
+
+size_t countVertices(const OGRGeometry& geometry) {
+    switch (wkbFlatten(geometry.getGeometryType())) {
+        case wkbPoint:
+            return 1;
+        case wkbLineString:
+        case wkbLinearRing:
+            return static_cast<size_t>(geometry.toLineString()->getNumPoints());
+        case wkbPolygon: {
+            size_t total = 0;
+            for (const auto* ring : *geometry.toPolygon()) total += countVertices(*ring);
+            return total;
+        }
+        case wkbMultiPoint:
+        case wkbMultiLineString:
+        case wkbMultiPolygon:
+        case wkbGeometryCollection: {
+            const auto* collection = geometry.toGeometryCollection();
+            size_t total = 0;
+            for (int i = 0; i < collection->getNumGeometries(); i++) total += countVertices(*collection->getGeometryRef(i));
+            return total;
+        }
+        default:
+            return 0;
+    }
+}
+
+// The polygonal part of a clip result; lines and points left where the zone
+// only touches the box belong to a neighbouring box as well
+std::unique_ptr<OGRGeometry> polygonalPart(std::unique_ptr<OGRGeometry> clipped) {
+    const auto type = wkbFlatten(clipped->getGeometryType());
+    if (type == wkbPolygon || type == wkbMultiPolygon) {
+        return clipped;
+    }
+    if (type != wkbGeometryCollection) {
+        return nullptr;
+    }
+    auto multi = std::make_unique<OGRMultiPolygon>();
+    const auto* collection = clipped->toGeometryCollection();
+    for (int i = 0; i < collection->getNumGeometries(); i++) {
+        const OGRGeometry* part = collection->getGeometryRef(i);
+        const auto part_type = wkbFlatten(part->getGeometryType());
+        if (part_type == wkbPolygon) {
+            multi->addGeometry(part);
+        } else if (part_type == wkbMultiPolygon) {
+            for (const auto* polygon : *part->toMultiPolygon()) multi->addGeometry(polygon);
+        }
+    }
+    if (multi->IsEmpty()) {
+        return nullptr;
+    }
+    return multi;
+}
+
+// False when a clip fails; the tiles would then miss part of the zone
+bool subdivideInto(const OGRGeometry& zone, const OGREnvelope& box, size_t budget, int depth,
+                   std::vector<ZoneTile>& out) {
+    OGRLinearRing ring;
+    ring.addPoint(box.MinX, box.MinY);
+    ring.addPoint(box.MaxX, box.MinY);
+    ring.addPoint(box.MaxX, box.MaxY);
+    ring.addPoint(box.MinX, box.MaxY);
+    ring.addPoint(box.MinX, box.MinY);
+    OGRPolygon rect;
+    rect.addRing(&ring);
+
+    std::unique_ptr<OGRGeometry> clipped(zone.Intersection(&rect));
+    if (!clipped) {
+        return false;
+    }
+    if (clipped->IsEmpty()) {
+        return true;
+    }
+    auto piece = polygonalPart(std::move(clipped));
+    if (!piece) {
+        return true;
+    }
+    if (countVertices(*piece) > budget && depth < ProtectionGeometryCache::kMaxTileDepth) {
+        // Quadrants of this box; the piece is clipped further rather than the whole zone
+        const double mid_x = (box.MinX + box.MaxX) / 2;
+        const double mid_y = (box.MinY + box.MaxY) / 2;
+        for (int q = 0; q < 4; q++) {
+            OGREnvelope quadrant;
+            quadrant.MinX = (q & 1) ? mid_x : box.MinX;
+            quadrant.MaxX = (q & 1) ? box.MaxX : mid_x;
+            quadrant.MinY = (q & 2) ? mid_y : box.MinY;
+            quadrant.MaxY = (q & 2) ? box.MaxY : mid_y;
+            if (!subdivideInto(*piece, quadrant, budget, depth + 1, out)) return false;
+        }
+        return true;
+    }
+    ZoneTile tile;
+    piece->getEnvelope(&tile.envelope);
+    tile.rings = PolygonRings::build(*piece);
+    tile.piece = std::move(piece);
+    out.push_back(std::move(tile));
+    return true;
+}
+
+} // namespace
+
+bool CachedProtectionGeometry::intersects(const OGRGeometry& other, const GEOSGeom_t* other_geos) const {
+    if (tiled()) {
+        OGREnvelope envelope;
+        other.getEnvelope(&envelope);
+        for (size_t t : tile_index.query(envelope)) {
+            const auto& tile = tiles[t];
+            if (other_geos && tile.geos ? GeosBackend::intersects(tile.geos.get(), other_geos)
+                                        : tile.piece->Intersects(&other)) {
+                return true;
+            }
+        }
+        return false;
+    }
+    if (other_geos && geos_prepared) {
+        std::lock_guard lock(prepared_mutex_);
+        return GeosBackend::preparedIntersects(geos_prepared.get(), other_geos);
+    }
+    if (other_geos && geos) {
+        return GeosBackend::intersects(geos.get(), other_geos);
+    }
+    if (prepared) {
+        std::lock_guard lock(prepared_mutex_);
+        return OGRPreparedGeometryIntersects(prepared.get(), &other) != 0;
+    }
+    return geometry->Intersects(&other);
+}
+
+bool CachedProtectionGeometry::contains(const OGRGeometry& other, const GEOSGeom_t* other_geos) const {
+    if (other_geos && geos_prepared) {
+        std::lock_guard lock(prepared_mutex_);
+        return GeosBackend::preparedContains(geos_prepared.get(), other_geos);
+    }
+    if (other_geos && geos) {
+        return GeosBackend::contains(geos.get(), other_geos);
+    }
+    if (prepared) {
+        std::lock_guard lock(prepared_mutex_);
+        return OGRPreparedGeometryContains(prepared.get(), &other) != 0;
+    }
+    return geometry->Contains(&other);
+}
+
+bool CachedProtectionGeometry::tileContains(const OGRGeometry& other, const GEOSGeom_t* other_geos) const {
+    if (!tiled()) {
+        return false;
+    }
+    OGREnvelope envelope;
+    other.getEnvelope(&envelope);
+    for (size_t t : tile_index.query(envelope)) {
+        const auto& tile = tiles[t];
+        if (!tile.envelope.Contains(envelope)) continue;
+        if (other_geos && tile.geos ? GeosBackend::contains(tile.geos.get(), other_geos)
+                                    : tile.piece->Contains(&other)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool CachedProtectionGeometry::touches(const OGREnvelope& other) const {
+    if (!tiled()) {
+        return this->envelope.Intersects(other);
+    }
+    return !tile_index.query(other).empty();
+}
+
+// On tiles: disjoint from every tile is disjoint, inside one is inside, and
+// meeting exactly one tile without being inside it is a partial overlap.
+// Meeting several tiles without being inside one leaves it open, since the
+// feature may cross tile edges inside the zone.
+std::optional<PolygonRings::Relation> CachedProtectionGeometry::relate(const OGRGeometry& feature) const {
+    if (!PolygonRings::supports(feature)) {
+        return std::nullopt;
+    }
+    if (!tiled()) {
+        if (!rings) return std::nullopt;
+        return rings->relate(feature);
+    }
+    OGREnvelope envelope;
+    feature.getEnvelope(&envelope);
+    size_t meeting = 0;
+    for (size_t t : tile_index.query(envelope)) {
+        if (!tiles[t].rings) return std::nullopt;
+        const auto relation = tiles[t].rings->relate(feature);
+        if (relation == PolygonRings::Relation::Inside) return relation;
+        if (relation == PolygonRings::Relation::Intersects) meeting++;
+    }
+    if (meeting == 0) return PolygonRings::Relation::Disjoint;
+    if (meeting == 1) return PolygonRings::Relation::Intersects;
+    return std::nullopt;
+}
+
+ProtectionGeometryCache& ProtectionGeometryCache::getInstance() {
+    static ProtectionGeometryCache instance;
+    return instance;
+}
+
+std::shared_ptr<const CachedProtectionGeometry> ProtectionGeometryCache::find(
+    int procedure_id, std::chrono::system_clock::time_point updated_at) const {
+    std::shared_lock lock(mutex_);
+    auto it = entries_.find(procedure_id);
+    if (it == entries_.end() || it->second.updated_at != updated_at) {
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    hits_.fetch_add(1, std::memory_order_relaxed);
+    return it->second.geometry;
+}
+
+std::shared_ptr<const CachedProtectionGeometry> ProtectionGeometryCache::adopt(
+    int procedure_id, std::chrono::system_clock::time_point updated_at, const std::string& content_hash) {
+    if (content_hash.empty()) {
+        return nullptr;
+    }
+    std::unique_lock lock(mutex_);
+    return adoptLocked(procedure_id, updated_at, content_hash);
+}
+
+std::shared_ptr<const CachedProtectionGeometry> ProtectionGeometryCache::adoptLocked(
+    int procedure_id, std::chrono::system_clock::time_point updated_at, const std::string& content_hash) {
+    auto it = by_hash_.find(content_hash);
+    if (it == by_hash_.end()) {
+        return nullptr;
+    }
+    auto shared = it->second.lock();
+    if (!shared) {
+        by_hash_.erase(it);
+        return nullptr;
+    }
+    entries_[procedure_id] = {updated_at, shared};
+    return shared;
+}
+
+void ProtectionGeometryCache::pruneLocked() {
+    std::erase_if(by_hash_, [](const auto& item) { return item.second.expired(); });
+}
+
+std::shared_ptr<const CachedProtectionGeometry> ProtectionGeometryCache::insert(
+    int procedure_id, std::chrono::system_clock::time_point updated_at, const std::string& geometry_text) {
+    auto geometry = parseProtectionGeometry(geometry_text);
+    if (!geometry) {
+        spdlog::warn("Could not parse protection geometry for procedure {}, skipping", procedure_id);
+        return nullptr;
+    }
+    std::string content_hash = contentHash(toWkb(*geometry));
+    return publish(procedure_id, updated_at, std::move(geometry), std::move(content_hash));
+}
+
+std::shared_ptr<const CachedProtectionGeometry> ProtectionGeometryCache::insertWkb(
+    int procedure_id, std::chrono::system_clock::time_point updated_at, const std::string& wkb,
+    const std::string& content_hash) {
+    std::string hash = content_hash.empty() ? contentHash(wkb) : content_hash;
+    if (auto shared = adopt(procedure_id, updated_at, hash)) {
+        return shared;
+    }
+    auto geometry = parseProtectionWkb(wkb);
+    if (!geometry) {
+        spdlog::warn("Could not decode stored WKB of procedure {}, skipping", procedure_id);
+        return nullptr;
+    }
+    return publish(procedure_id, updated_at, std::move(geometry), std::move(hash));
+}
+
+std::shared_ptr<const CachedProtectionGeometry> ProtectionGeometryCache::publish(
+    int procedure_id, std::chrono::system_clock::time_point updated_at, std::unique_ptr<OGRGeometry> geometry,
+    std::string content_hash) {
+    {
+        // Another procedure published the same geometry first
+        std::unique_lock lock(mutex_);
+        if (auto shared = adoptLocked(procedure_id, updated_at, content_hash)) {
+            return shared;
+        }
+    }
+
+    auto entry = std::make_shared<CachedProtectionGeometry>();
+    entry->procedure_id = procedure_id;
+    entry->updated_at = updated_at;
+    entry->content_hash = content_hash;
+    geometry->getEnvelope(&entry->envelope);
+    // Converted once here rather than on every predicate
+    entry->geos = GeosBackend::fromOgr(*geometry);
+    if (entry->geos && preparedGeometryEnabled()) {
+        entry->geos_prepared = GeosBackend::prepare(entry->geos.get());
+    } else if (preparedGeometryEnabled() && OGRHasPreparedGeometrySupport()) {
+        entry->prepared = OGRPreparedGeometryUniquePtr(OGRCreatePreparedGeometry(geometry.get()));
+    }
+    const size_t budget = tileVertexBudget();
+    if (budget > 0 && countVertices(*geometry) > budget) {
+        entry->tiles = subdivide(*geometry, budget);
+        std::vector<OGREnvelope> tile_envelopes;
+        tile_envelopes.reserve(entry->tiles.size());
+        for (auto& tile : entry->tiles) {
+            tile_envelopes.push_back(tile.envelope);
+            tile.geos = GeosBackend::fromOgr(*tile.piece);
+        }
+        entry->tile_index.build(tile_envelopes);
+        spdlog::debug("Protection zone of procedure {} split into {} tiles", procedure_id, entry->tiles.size());
+    }
+    if (!entry->tiled()) {
+        entry->rings = PolygonRings::build(*geometry);
+    }
+    entry->geometry = std::move(geometry);
+
+    std::unique_lock lock(mutex_);
+    // Built twice when two procedures raced to it; the first one stays
+    if (auto shared = adoptLocked(procedure_id, updated_at, content_hash)) {
+        return shared;
+    }
+    entries_[procedure_id] = {updated_at, entry};
+    by_hash_[content_hash] = entry;
+    return entry;
+}
+
+void ProtectionGeometryCache::invalidate(int procedure_id) {
+    {
+        std::unique_lock lock(mutex_);
+        invalidated_.fetch_add(entries_.erase(procedure_id), std::memory_order_relaxed);
+        pruneLocked();
+    }
+    generation_.fetch_add(1, std::memory_order_acq_rel);
+    spdlog::debug("Invalidated cached protection geometry for procedure {}", procedure_id);
+}
+
+void ProtectionGeometryCache::invalidate(const std::vector<int>& procedure_ids) {
+    {
+        std::unique_lock lock(mutex_);
+        for (int procedure_id : procedure_ids) {
+            invalidated_.fetch_add(entries_.erase(procedure_id), std::memory_order_relaxed);
+        }
+        pruneLocked();
+    }
+    generation_.fetch_add(1, std::memory_order_acq_rel);
+    spdlog::debug("Invalidated cached protection geometry for {} procedures", procedure_ids.size());
+}
+
+void ProtectionGeometryCache::clear() {
+    {
+        std::unique_lock lock(mutex_);
+        invalidated_.fetch_add(entries_.size(), std::memory_order_relaxed);
+        entries_.clear();
+        by_hash_.clear();
+    }
+    generation_.fetch_add(1, std::memory_order_acq_rel);
+}
+
+void ProtectionGeometryCache::setPreparedGeometryEnabled(bool enabled) {
+    if (enabled && !OGRHasPreparedGeometrySupport()) {
+        spdlog::warn("GDAL was built without prepared geometry support, using plain predicates");
+        enabled = false;
+    }
+    if (prepared_enabled_.exchange(enabled) != enabled) {
+        clear();
+    }
+}
+
+void ProtectionGeometryCache::setTileVertexBudget(size_t vertices) {
+    if (tile_vertex_budget_.exchange(vertices) != vertices) {
+        clear();
+    }
+}
+
+// Empty when a clip fails
+std::vector<ZoneTile> ProtectionGeometryCache::subdivide(const OGRGeometry& zone, size_t budget) {
+    std::vector<ZoneTile> tiles;
+    OGREnvelope envelope;
+    zone.getEnvelope(&envelope);
+    // Quadrants from the start: the whole zone is over budget
+    const double mid_x = (envelope.MinX + envelope.MaxX) / 2;
+    const double mid_y = (envelope.MinY + envelope.MaxY) / 2;
+    for (int q = 0; q < 4; q++) {
+        OGREnvelope quadrant;
+        quadrant.MinX = (q & 1) ? mid_x : envelope.MinX;
+        quadrant.MaxX = (q & 1) ? envelope.MaxX : mid_x;
+        quadrant.MinY = (q & 2) ? mid_y : envelope.MinY;
+        quadrant.MaxY = (q & 2) ? envelope.MaxY : mid_y;
+        if (!subdivideInto(zone, quadrant, budget, 1, tiles)) {
+            spdlog::warn("Could not subdivide a protection zone, keeping it whole");
+            return {};
+        }
+    }
+    return tiles;
+}
+
+size_t ProtectionGeometryCache::size() const {
+    std::shared_lock lock(mutex_);
+    return entries_.size();
+}
+
+size_t ProtectionGeometryCache::distinctGeometries() const {
+    std::shared_lock lock(mutex_);
+    size_t live = 0;
+    for (const auto& [hash, entry] : by_hash_) live += entry.expired() ? 0 : 1;
+    return live;
+}
+
+nlohmann::json ProtectionGeometryCache::stats() const {
+    nlohmann::json j;
+    j["entries"] = size();
+    j["distinct_geometries"] = distinctGeometries();
+    j["hits"] = hits_.load(std::memory_order_relaxed);
+    j["misses"] = misses_.load(std::memory_order_relaxed);
+    j["invalidated"] = invalidated_.load(std::memory_order_relaxed);
+    j["generation"] = generation();
+    j["prepared"] = preparedGeometryEnabled();
+    j["tile_vertex_budget"] = tileVertexBudget();
+    return j;
+}
+
+std::unique_ptr<OGRGeometry> ProtectionGeometryCache::parseProtectionGeometry(const std::string& geometry_text) {
+    std::unique_ptr<OGRGeometry> geometry;
+
+    try {
+        std::vector<GeoJsonFeature> features;
+        std::string error;
+        std::string type;
+        if (!GeoJsonReader::read(geometry_text, features, error, &type)) {
+            spdlog::error("Could not read protection GeoJSON: {}", error);
+            return nullptr;
+        }
+
+        if (type == "FeatureCollection") {
+            // Collect the polygon features straight into one MultiPolygon
+            auto multi = std::make_unique<OGRMultiPolygon>();
+            for (const auto& feature : features) {
+                if (!feature.geometry) continue;
+
+                const auto kind = feature.geometry->type;
+                if (kind != GeoJsonGeometry::Type::Polygon && kind != GeoJsonGeometry::Type::MultiPolygon) continue;
+
+                auto part = feature.geometry->toOGR();
+                if (!part) continue;
+
+                if (kind == GeoJsonGeometry::Type::Polygon) {
+                    multi->addGeometryDirectly(part.release());
+                } else {
+                    // Take the polygons over rather than copying them; detach them
+                    // from the back so no removal shifts the rest
+                    auto* parts = part->toGeometryCollection();
+                    std::vector<OGRGeometry*> polygons(parts->getNumGeometries());
+                    for (int i = (int)polygons.size() - 1; i >= 0; i--) {
+                        polygons[i] = parts->getGeometryRef(i);
+                        parts->removeGeometry(i, FALSE);
+                    }
+                    for (OGRGeometry* polygon : polygons) {
+                        multi->addGeometryDirectly(polygon);
+                    }
+                }
+            }
+
+            if (multi->getNumGeometries() == 0) {
+                return nullptr;
+            }
+            geometry = std::move(multi);
+        } else if (!features.empty() && features[0].geometry) {
+            geometry = features[0].geometry->toOGR();
+        }
+    } catch (const std::exception& e) {
+        spdlog::error("Exception while parsing protection GeoJSON: {}", e.what());
+        return nullptr;
+    }
+
+    if (geometry && !geometry->IsValid()) {
+        spdlog::warn("Protection geometry is invalid, attempting to fix");
+        OGRGeometry* fixed = geometry->Buffer(0);
+        if (fixed) {
+            geometry.reset(fixed);
+        }
+    }
+
+    if (geometry && geometry->IsEmpty()) {
+        return nullptr;
+    }
+    return geometry;
+}
+
+std::unique_ptr<OGRGeometry> ProtectionGeometryCache::parseProtectionWkb(const std::string& wkb) {
+    OGRGeometry* geometry = nullptr;
+    if (OGRGeometryFactory::createFromWkb(wkb.data(), nullptr, &geometry, wkb.size(), wkbVariantIso) != OGRERR_NONE) {
+        delete geometry;
+        return nullptr;
+    }
+    return std::unique_ptr<OGRGeometry>(geometry);
+}
+
+std::string ProtectionGeometryCache::toWkb(const OGRGeometry& geometry) {
+    std::string wkb(geometry.WkbSize(), '\0');
+    geometry.exportToWkb(wkbNDR, reinterpret_cast<unsigned char*>(wkb.data()), wkbVariantIso);
+    return wkb;
+}
+
+std::string ProtectionGeometryCache::contentHash(std::string_view wkb) {
+    static const char hex[] = "0123456789abcdef";
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int length = 0;
+    EVP_Digest(wkb.data(), wkb.size(), digest, &length, EVP_sha256(), nullptr);
+    std::string out;
+    out.reserve(length * 2);
+    for (unsigned int i = 0; i < length; i++) {
+        out += hex[digest[i] >> 4];
+        out += hex[digest[i] & 0xf];
+    }
+    return out;
+}
+
+} // namespace aeronautical
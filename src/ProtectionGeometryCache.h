@@ -0,0 +1,192 @@
+#pragma once
+
+#include "GeosBackend.h"
+#include "LockStats.h"
+#include "ogr_geometry.h"
+#include "PolygonRings.h"
+#include "ProtectionIndex.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <json.hpp>
+
+namespace aeronautical {
+
+// One piece of a subdivided zone: the zone clipped to a box of a quad split
+struct ZoneTile {
+    OGREnvelope envelope; // of the piece, not the box
+    std::unique_ptr<OGRGeometry> piece;
+    std::unique_ptr<const PolygonRings> rings;
+    GeosBackend::Geometry geos; // piece in GEOS form, with the GEOS backend
+};
+
+// A parsed, validated protection zone geometry. Entries are immutable once
+// published and are shared read-only between analysis threads.
+//
+// A zone with more vertices than the tile budget is also kept as tiles: its
+// envelope is split into quadrants, recursively, until each clipped piece is
+// within budget. The pieces together are the zone, so predicates only test
+// the few pieces whose envelope meets the other geometry, each a small
+// polygon, and a feature far from the zone's outline inside one huge
+// envelope is rejected from the tile envelopes alone. geometry stays whole
+// for display, metrics and intersection output.
+//
+// Entries are content addressed: procedures whose geometry has the same
+// normalized WKB (see contentHash) share one entry, so a protection stored on
+// a SID and its transitions is parsed, prepared and held once.
+struct CachedProtectionGeometry {
+    // Of the procedure the entry was first published for
+    int procedure_id = 0;
+    std::chrono::system_clock::time_point updated_at;
+    std::unique_ptr<OGRGeometry> geometry; // never null for a published entry
+    OGREnvelope envelope;
+    std::string content_hash;
+
+    // GEOS prepared form of geometry, built when prepared mode is enabled
+    OGRPreparedGeometryUniquePtr prepared;
+    // With the GEOS backend: geometry in GEOS form, and in prepared mode its
+    // prepared form in place of the OGR one
+    GeosBackend::Geometry geos;
+    GeosBackend::Prepared geos_prepared;
+    // Flattened rings of a polygonal zone for point and line features;
+    // left unset for a tiled zone, whose tiles carry their own
+    std::unique_ptr<const PolygonRings> rings;
+
+    // Empty unless the zone was subdivided; tile_index slots index tiles
+    std::vector<ZoneTile> tiles;
+    ProtectionIndex tile_index;
+
+    bool hasPrepared() const { return prepared || geos_prepared; }
+    bool tiled() const { return !tiles.empty(); }
+
+    // Predicates against a project geometry; tiles first, then the prepared
+    // form when present. other_geos is other in GEOS form; given, and with
+    // the zone in GEOS form, the predicate is a direct GEOS call.
+    bool intersects(const OGRGeometry& other, const GEOSGeom_t* other_geos = nullptr) const;
+    bool contains(const OGRGeometry& other, const GEOSGeom_t* other_geos = nullptr) const;
+    // Whether one tile holds other entirely, which implies contains; false
+    // says nothing for a feature spanning tiles or an untiled zone
+    bool tileContains(const OGRGeometry& other, const GEOSGeom_t* other_geos = nullptr) const;
+    // Whether any tile's envelope meets envelope; the zone envelope when untiled
+    bool touches(const OGREnvelope& envelope) const;
+    // Relation of a point or line feature (see PolygonRings::supports) from
+    // the rings, or nullopt when the zone has none to answer from
+    std::optional<PolygonRings::Relation> relate(const OGRGeometry& feature) const;
+
+private:
+    // A prepared geometry owns its GEOS context and is not safe for concurrent calls
+    mutable InstrumentedMutex<std::mutex> prepared_mutex_{"protection_prepared"};
+};
+
+// Process-wide cache of protection geometries keyed by procedure id and the
+// procedure's updated_at, so an edited procedure is never served stale.
+// Behind the procedures, entries are held by content hash: a procedure
+// edited without touching its geometry, or one sharing another's, finds the
+// entry already built.
+class ProtectionGeometryCache {
+public:
+    static ProtectionGeometryCache& getInstance();
+
+    ProtectionGeometryCache(const ProtectionGeometryCache&) = delete;
+    ProtectionGeometryCache& operator=(const ProtectionGeometryCache&) = delete;
+
+    // Returns the entry for this procedure version, or nullptr on a miss
+    std::shared_ptr<const CachedProtectionGeometry> find(int procedure_id,
+                                                         std::chrono::system_clock::time_point updated_at) const;
+    // Records the entry of content_hash for this procedure version without
+    // loading anything; nullptr when no live entry has that hash
+    std::shared_ptr<const CachedProtectionGeometry> adopt(int procedure_id,
+                                                          std::chrono::system_clock::time_point updated_at,
+                                                          const std::string& content_hash);
+
+    // Parses and validates the stored protection_geometry text and publishes it.
+    // Returns nullptr if the text holds no usable geometry.
+    std::shared_ptr<const CachedProtectionGeometry> insert(int procedure_id,
+                                                           std::chrono::system_clock::time_point updated_at,
+                                                           const std::string& geometry_text);
+    // Publishes a geometry stored as WKB by toWkb; it was validated before
+    // it was written, so it is only decoded, and not even that when an entry
+    // with its hash is live. content_hash is computed when not given.
+    // nullptr if it cannot be decoded.
+    std::shared_ptr<const CachedProtectionGeometry> insertWkb(int procedure_id,
+                                                              std::chrono::system_clock::time_point updated_at,
+                                                              const std::string& wkb,
+                                                              const std::string& content_hash = {});
+
+    // Drops a procedure after it was created, updated or deleted
+    void invalidate(int procedure_id);
+    // Several procedures at once, with a single generation bump
+    void invalidate(const std::vector<int>& procedure_ids);
+    void clear();
+
+    // Bumped on every invalidation so dependent indexes know to rebuild
+    uint64_t generation() const { return generation_.load(std::memory_order_acquire); }
+    // Procedures cached, and distinct geometries behind them
+    size_t size() const;
+    size_t distinctGeometries() const;
+    // Entries, lookups and the generation, for GET /api/admin/runtime
+    nlohmann::json stats() const;
+
+    // Turns a stored FeatureCollection (or plain geometry) into one valid geometry
+    static std::unique_ptr<OGRGeometry> parseProtectionGeometry(const std::string& geometry_text);
+    // Little-endian ISO WKB of a parsed geometry, as stored in protection_wkb
+    static std::string toWkb(const OGRGeometry& geometry);
+    // Hex SHA-256 of that WKB, the key of the content-addressed store
+    // (geometry_blobs) and of shared entries
+    static std::string contentHash(std::string_view wkb);
+    static std::unique_ptr<OGRGeometry> parseProtectionWkb(const std::string& wkb);
+
+    // Builds GEOS prepared geometries for new entries; toggling clears the cache
+    void setPreparedGeometryEnabled(bool enabled);
+    bool preparedGeometryEnabled() const { return prepared_enabled_.load(std::memory_order_relaxed); }
+
+    // Zones with more vertices are subdivided into tiles of at most this
+    // many (down to kMaxTileDepth splits); 0 keeps every zone whole.
+    // Changing it clears the cache.
+    static constexpr size_t kDefaultTileVertexBudget = 2048;
+    static constexpr int kMaxTileDepth = 8;
+    void setTileVertexBudget(size_t vertices);
+    size_t tileVertexBudget() const { return tile_vertex_budget_.load(std::memory_order_relaxed); }
+    // Tiles of zone clipped to quadrants of its envelope, each within budget
+    // where the depth allows; empty when clipping fails
+    static std::vector<ZoneTile> subdivide(const OGRGeometry& zone, size_t budget);
+
+private:
+    ProtectionGeometryCache() = default;
+
+    std::shared_ptr<const CachedProtectionGeometry> publish(int procedure_id,
+                                                            std::chrono::system_clock::time_point updated_at,
+                                                            std::unique_ptr<OGRGeometry> geometry,
+                                                            std::string content_hash);
+    // The live entry of content_hash recorded for the procedure; caller holds mutex_ exclusively
+    std::shared_ptr<const CachedProtectionGeometry> adoptLocked(int procedure_id,
+                                                                std::chrono::system_clock::time_point updated_at,
+                                                                const std::string& content_hash);
+    // Drops hashes no procedure holds any more; caller holds mutex_ exclusively
+    void pruneLocked();
+
+    struct Entry {
+        std::chrono::system_clock::time_point updated_at;
+        std::shared_ptr<const CachedProtectionGeometry> geometry;
+    };
+    mutable InstrumentedMutex<std::shared_mutex> mutex_{"protection_cache"};
+    std::unordered_map<int, Entry> entries_;
+    // Expired once no procedure holds the entry; pruned on invalidation
+    std::unordered_map<std::string, std::weak_ptr<const CachedProtectionGeometry>> by_hash_;
+    std::atomic<uint64_t> generation_{0};
+    mutable std::atomic<uint64_t> hits_{0};
+    mutable std::atomic<uint64_t> misses_{0};
+    std::atomic<uint64_t> invalidated_{0};
+    std::atomic<bool> prepared_enabled_{false};
+    std::atomic<size_t> tile_vertex_budget_{kDefaultTileVertexBudget};
+};
+
+} // namespace aeronautical
@@ -0,0 +1,294 @@
+#include "ProtectionIndex.h"
+#include "HilbertCurve.h"
+#include <algorithm>
+#include <cmath>
+
+namespace aeronautical {
+
+namespace {
+
+inline double centerX(const OGREnvelope& e) { return (e.MinX + e.MaxX) * 0.5; }
+inline double centerY(const OGREnvelope& e) { return (e.MinY + e.MaxY) * 0.5; }
+inline double area(const OGREnvelope& e) { return (e.MaxX - e.MinX) * (e.MaxY - e.MinY); }
+
+} // namespace
+
+ProtectionIndex::ProtectionIndex(size_t node_capacity)
+    : node_capacity_(node_capacity < 2 ? 2 : node_capacity) {
+}
+
+// Orders items along a Hilbert curve over their centres, so consecutive
+// runs of node_capacity_ are compact leaves and zones near each other sit
+// near each other in items and in the node array
+void ProtectionIndex::hilbertSort(std::vector<Item>& items) {
+    if (items.size() < 2) {
+        return;
+    }
+    OGREnvelope centres;
+    centres.MinX = centres.MaxX = centerX(items.front().envelope);
+    centres.MinY = centres.MaxY = centerY(items.front().envelope);
+    for (const auto& item : items) {
+        centres.MinX = std::min(centres.MinX, centerX(item.envelope));
+        centres.MaxX = std::max(centres.MaxX, centerX(item.envelope));
+        centres.MinY = std::min(centres.MinY, centerY(item.envelope));
+        centres.MaxY = std::max(centres.MaxY, centerY(item.envelope));
+    }
+    const HilbertCurve curve(centres.MinX, centres.MinY, centres.MaxX, centres.MaxY);
+    std::vector<std::pair<uint32_t, uint32_t>> keys(items.size()); // key, position
+    for (size_t i = 0; i < items.size(); i++) {
+        keys[i] = {curve.key(centerX(items[i].envelope), centerY(items[i].envelope)), static_cast<uint32_t>(i)};
+    }
+    std::sort(keys.begin(), keys.end());
+    std::vector<Item> sorted;
+    sorted.reserve(items.size());
+    for (const auto& [key, i] : keys) sorted.push_back(items[i]);
+    items = std::move(sorted);
+}
+
+void ProtectionIndex::build(const std::vector<OGREnvelope>& envelopes) {
+    slot_map_.clear();
+    pending_.clear();
+    size_ = envelopes.size();
+    changes_ = 0;
+    tree_.reset();
+    if (envelopes.empty()) {
+        return;
+    }
+
+    auto tree = std::make_shared<Tree>();
+    auto& items = tree->items;
+    auto& nodes = tree->nodes;
+    items.reserve(envelopes.size());
+    for (size_t i = 0; i < envelopes.size(); i++) {
+        items.push_back({envelopes[i], static_cast<uint32_t>(i)});
+    }
+
+    // Leaf level: pack consecutive items
+    hilbertSort(items);
+    std::vector<Node> level;
+    for (size_t start = 0; start < items.size(); start += node_capacity_) {
+        size_t count = std::min(node_capacity_, items.size() - start);
+        Node node{items[start].envelope, static_cast<uint32_t>(start), static_cast<uint32_t>(count), true};
+        for (size_t i = start + 1; i < start + count; i++) {
+            node.envelope.Merge(items[i].envelope);
+        }
+        level.push_back(node);
+    }
+
+    // Upper levels: the previous level is already in curve order, so
+    // consecutive nodes are packed again; each parent's children occupy a
+    // contiguous range of nodes
+    while (true) {
+        const uint32_t offset = static_cast<uint32_t>(nodes.size());
+        nodes.insert(nodes.end(), level.begin(), level.end());
+        if (level.size() == 1) {
+            break;
+        }
+
+        std::vector<Node> parents;
+        for (size_t start = 0; start < level.size(); start += node_capacity_) {
+            size_t count = std::min(node_capacity_, level.size() - start);
+            Node node{level[start].envelope, offset + static_cast<uint32_t>(start), static_cast<uint32_t>(count), false};
+            for (size_t i = start + 1; i < start + count; i++) {
+                node.envelope.Merge(level[i].envelope);
+            }
+            parents.push_back(node);
+        }
+        level = std::move(parents);
+    }
+    tree_ = std::move(tree);
+}
+
+ProtectionIndex ProtectionIndex::updated(std::span<const uint32_t> slot_map,
+                                         const std::vector<std::pair<size_t, OGREnvelope>>& added) const {
+    ProtectionIndex next(node_capacity_);
+    next.tree_ = tree_;
+    size_t removed = 0;
+    if (tree_) {
+        next.slot_map_.resize(tree_->items.size());
+        for (size_t i = 0; i < next.slot_map_.size(); i++) {
+            const uint32_t slot = currentSlot(static_cast<uint32_t>(i));
+            next.slot_map_[i] = slot == kRemoved ? kRemoved : slot_map[slot];
+            if (slot != kRemoved && next.slot_map_[i] == kRemoved) removed++;
+        }
+    }
+    for (const auto& item : pending_) {
+        if (slot_map[item.slot] != kRemoved) {
+            next.pending_.push_back({item.envelope, slot_map[item.slot]});
+        } else {
+            removed++;
+        }
+    }
+    for (const auto& [slot, envelope] : added) {
+        next.pending_.push_back({envelope, static_cast<uint32_t>(slot)});
+    }
+    next.size_ = size_ - removed + added.size();
+    next.changes_ = changes_ + removed + added.size();
+    if (next.changes_ <= std::max(kMinRebuildChanges, next.size_ / 4)) {
+        return next;
+    }
+
+    // Too many zones outside the tree or dead in it: bulk load again
+    std::vector<OGREnvelope> envelopes(next.size_);
+    if (tree_) {
+        for (const auto& item : tree_->items) {
+            const uint32_t slot = next.slot_map_[item.slot];
+            if (slot != kRemoved) envelopes[slot] = item.envelope;
+        }
+    }
+    for (const auto& item : next.pending_) {
+        envelopes[item.slot] = item.envelope;
+    }
+    next.build(envelopes);
+    return next;
+}
+
+std::vector<size_t> ProtectionIndex::query(const OGREnvelope& envelope) const {
+    std::vector<size_t> out;
+    query(envelope, out);
+    return out;
+}
+
+void ProtectionIndex::query(const OGREnvelope& envelope, std::vector<size_t>& out) const {
+    out.clear();
+    for (const auto& item : pending_) {
+        if (item.envelope.Intersects(envelope)) {
+            out.push_back(item.slot);
+        }
+    }
+    queryTree(envelope, out);
+
+    // Callers process candidates in protection order
+    std::sort(out.begin(), out.end());
+}
+
+void ProtectionIndex::queryTree(const OGREnvelope& envelope, std::vector<size_t>& out) const {
+    if (!tree_) {
+        return;
+    }
+
+    const auto& items = tree_->items;
+    const auto& nodes = tree_->nodes;
+    std::vector<uint32_t> stack;
+    stack.push_back(static_cast<uint32_t>(nodes.size() - 1));
+
+    while (!stack.empty()) {
+        const Node& node = nodes[stack.back()];
+        stack.pop_back();
+
+        if (!node.envelope.Intersects(envelope)) {
+            continue;
+        }
+
+        if (node.leaf) {
+            for (uint32_t i = node.first; i < node.first + node.count; i++) {
+                if (items[i].envelope.Intersects(envelope)) {
+                    const uint32_t slot = currentSlot(items[i].slot);
+                    if (slot != kRemoved) out.push_back(slot);
+                }
+            }
+        } else {
+            for (uint32_t i = node.first; i < node.first + node.count; i++) {
+                stack.push_back(i);
+            }
+        }
+    }
+}
+
+std::vector<ProtectionIndex::JoinTask> ProtectionIndex::joinTasks(const ProtectionIndex& other, size_t min_tasks) const {
+    std::vector<JoinTask> tasks;
+    if (tree_ && other.tree_) {
+        const auto& nodes = tree_->nodes;
+        const auto& other_nodes = other.tree_->nodes;
+        const uint32_t root = static_cast<uint32_t>(nodes.size() - 1);
+        const uint32_t other_root = static_cast<uint32_t>(other_nodes.size() - 1);
+        if (nodes[root].envelope.Intersects(other_nodes[other_root].envelope)) {
+            tasks.push_back({root, other_root});
+        }
+
+        // One level at a time, so the parts stay of similar size
+        bool split = true;
+        while (split && tasks.size() < min_tasks) {
+            split = false;
+            std::vector<JoinTask> next;
+            for (const JoinTask& task : tasks) {
+                const Node& a = nodes[task.node];
+                const Node& b = other_nodes[task.other_node];
+                if (a.leaf && b.leaf) {
+                    next.push_back(task);
+                    continue;
+                }
+                split = true;
+                if (!a.leaf && (b.leaf || area(a.envelope) >= area(b.envelope))) {
+                    for (uint32_t i = a.first; i < a.first + a.count; i++) {
+                        if (nodes[i].envelope.Intersects(b.envelope)) next.push_back({i, task.other_node});
+                    }
+                } else {
+                    for (uint32_t i = b.first; i < b.first + b.count; i++) {
+                        if (other_nodes[i].envelope.Intersects(a.envelope)) next.push_back({task.node, i});
+                    }
+                }
+            }
+            tasks = std::move(next);
+        }
+    }
+    if (!pending_.empty() || !other.pending_.empty()) {
+        tasks.push_back({kPendingTask, 0});
+    }
+    return tasks;
+}
+
+void ProtectionIndex::joinTask(const ProtectionIndex& other, const JoinTask& task,
+                               std::vector<std::pair<uint32_t, uint32_t>>& out) const {
+    std::vector<size_t> found;
+    if (task.node == kPendingTask) {
+        // Pending zones here against all of other, other's pending zones
+        // against the tree here only, so no pair is counted twice
+        for (const auto& item : pending_) {
+            other.query(item.envelope, found);
+            for (size_t slot : found) out.emplace_back(item.slot, static_cast<uint32_t>(slot));
+        }
+        for (const auto& item : other.pending_) {
+            found.clear();
+            queryTree(item.envelope, found);
+            for (size_t slot : found) out.emplace_back(static_cast<uint32_t>(slot), item.slot);
+        }
+        return;
+    }
+
+    const auto& items = tree_->items;
+    const auto& nodes = tree_->nodes;
+    const auto& other_items = other.tree_->items;
+    const auto& other_nodes = other.tree_->nodes;
+    std::vector<JoinTask> stack{task};
+    while (!stack.empty()) {
+        const JoinTask pair = stack.back();
+        stack.pop_back();
+        const Node& a = nodes[pair.node];
+        const Node& b = other_nodes[pair.other_node];
+
+        if (a.leaf && b.leaf) {
+            for (uint32_t i = a.first; i < a.first + a.count; i++) {
+                if (!items[i].envelope.Intersects(b.envelope)) continue;
+                const uint32_t slot = currentSlot(items[i].slot);
+                if (slot == kRemoved) continue;
+                for (uint32_t j = b.first; j < b.first + b.count; j++) {
+                    if (!items[i].envelope.Intersects(other_items[j].envelope)) continue;
+                    const uint32_t other_slot = other.currentSlot(other_items[j].slot);
+                    if (other_slot != kRemoved) out.emplace_back(slot, other_slot);
+                }
+            }
+        } else if (!a.leaf && (b.leaf || area(a.envelope) >= area(b.envelope))) {
+            // Descend the larger node, so the two sides shrink together
+            for (uint32_t i = a.first; i < a.first + a.count; i++) {
+                if (nodes[i].envelope.Intersects(b.envelope)) stack.push_back({i, pair.other_node});
+            }
+        } else {
+            for (uint32_t i = b.first; i < b.first + b.count; i++) {
+                if (other_nodes[i].envelope.Intersects(a.envelope)) stack.push_back({pair.node, i});
+            }
+        }
+    }
+}
+
+} // namespace aeronautical
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "ogr_core.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace aeronautical {
+
+// R-tree over protection zone envelopes, bulk loaded in Hilbert curve order
+// of their centres (see HilbertCurve): leaves and the nodes above them are
+// consecutive runs of that order, so a query's nodes and items are close
+// together in memory. The tree stores slot numbers (positions in
+// the caller's protection vector) so it never owns any geometry.
+//
+// An edit to a few zones does not rebuild it: updated() returns an index that
+// shares the bulk-loaded tree, renumbers its slots and keeps the inserted
+// zones in a short list scanned linearly. Once the zones inserted and removed
+// since the last build pass a quarter of the index, updated() rebuilds.
+// An index is never modified after it is built or updated, so readers of one
+// need no lock while a writer derives the next.
+class ProtectionIndex {
+public:
+    static constexpr uint32_t kRemoved = UINT32_MAX;
+    static constexpr size_t kMinRebuildChanges = 32;
+
+    explicit ProtectionIndex(size_t node_capacity = 16);
+
+    // Rebuilds the tree; slot i refers to envelopes[i]
+    void build(const std::vector<OGREnvelope>& envelopes);
+
+    // This index after an edit: slot_map[i] is the new slot of slot i, or
+    // kRemoved; added holds the new slot and envelope of each inserted zone
+    ProtectionIndex updated(std::span<const uint32_t> slot_map,
+                            const std::vector<std::pair<size_t, OGREnvelope>>& added) const;
+
+    // Returns the slots whose envelope overlaps the given envelope, in ascending order
+    std::vector<size_t> query(const OGREnvelope& envelope) const;
+    void query(const OGREnvelope& envelope, std::vector<size_t>& out) const;
+
+    // One independent part of a join; node is kPendingTask for the part
+    // covering the zones kept outside the trees
+    struct JoinTask {
+        uint32_t node = 0;
+        uint32_t other_node = 0;
+    };
+    static constexpr uint32_t kPendingTask = UINT32_MAX;
+
+    // Splits the join of this index with other into parts that can run on
+    // separate threads: pairs of overlapping nodes, one from each tree, taken
+    // from the top of both until there are at least min_tasks or only leaves
+    // are left. Running joinTask over every part yields each (slot, other
+    // slot) pair with overlapping envelopes exactly once.
+    std::vector<JoinTask> joinTasks(const ProtectionIndex& other, size_t min_tasks) const;
+    // Appends the overlapping (slot here, slot in other) pairs of one part,
+    // descending both trees together
+    void joinTask(const ProtectionIndex& other, const JoinTask& task,
+                  std::vector<std::pair<uint32_t, uint32_t>>& out) const;
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    size_t nodeCount() const { return tree_ ? tree_->nodes.size() : 0; }
+    // Zones inserted since the last build, outside the tree
+    size_t pendingCount() const { return pending_.size(); }
+
+private:
+    struct Item {
+        OGREnvelope envelope;
+        uint32_t slot;
+    };
+
+    struct Node {
+        OGREnvelope envelope;
+        uint32_t first;   // first child (node index, or item index for leaves)
+        uint32_t count;
+        bool leaf;
+    };
+
+    struct Tree {
+        std::vector<Item> items; // slots as numbered at build time
+        std::vector<Node> nodes; // root is the last node
+    };
+
+    static void hilbertSort(std::vector<Item>& items);
+    // Appends the slots in the tree overlapping envelope, leaving pending_ out
+    void queryTree(const OGREnvelope& envelope, std::vector<size_t>& out) const;
+    uint32_t currentSlot(uint32_t built_slot) const {
+        return slot_map_.empty() ? built_slot : slot_map_[built_slot];
+    }
+
+    size_t node_capacity_;
+    std::shared_ptr<const Tree> tree_;
+    std::vector<uint32_t> slot_map_; // build-time slot -> current slot; empty while unchanged
+    std::vector<Item> pending_;      // inserted since the build, with current slots
+    size_t size_ = 0;
+    size_t changes_ = 0;             // zones inserted or removed since the build
+};
+
+} // namespace aeronautical
@@ -0,0 +1,254 @@
+#include "QueryStats.h"
+#include <algorithm>
+#include <ctime>
+#include <vector>
+
+namespace aeronautical {
+
+namespace {
+
+constexpr size_t kMaxShapeLength = 1024;
+
+bool isIdentifierChar(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '$';
+}
+
+bool endsWith(const std::string& text, std::string_view suffix) {
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// Strips a trailing ", " or "," and returns how much was stripped
+size_t listSeparator(const std::string& text, size_t end) {
+    if (end >= 2 && text.compare(end - 2, 2, ", ") == 0) return 2;
+    if (end >= 1 && text[end - 1] == ',') return 1;
+    return 0;
+}
+
+double bucketBoundMs(size_t index) {
+    return 0.1 * static_cast<double>(uint64_t{1} << index);
+}
+
+} // namespace
+
+QueryStats& QueryStats::getInstance() {
+    static QueryStats instance;
+    return instance;
+}
+
+void QueryStats::configure(std::chrono::milliseconds slow_threshold, std::shared_ptr<spdlog::logger> slow_log) {
+    std::lock_guard lock(mutex_);
+    slow_threshold_ = slow_threshold;
+    slow_log_ = std::move(slow_log);
+}
+
+std::string QueryStats::normalize(std::string_view sql) {
+    std::string out;
+    out.reserve(std::min(sql.size(), kMaxShapeLength));
+    std::vector<size_t> groups; // output positions of open parentheses
+
+    auto placeholder = [&]() {
+        // "?, ?, ?" folds to "?..."
+        const size_t separator = listSeparator(out, out.size());
+        if (separator && endsWith(out.substr(0, out.size() - separator), "?...")) {
+            out.resize(out.size() - separator);
+            return;
+        }
+        if (separator && out[out.size() - separator - 1] == '?') {
+            out.resize(out.size() - separator);
+            out += "...";
+            return;
+        }
+        out += '?';
+    };
+
+    size_t i = 0;
+    while (i < sql.size() && out.size() < kMaxShapeLength) {
+        const char c = sql[i];
+        if (c == ' ' || c == '\n' || c == '\t' || c == '\r') {
+            while (i < sql.size() && (sql[i] == ' ' || sql[i] == '\n' || sql[i] == '\t' || sql[i] == '\r')) i++;
+            if (!out.empty() && out.back() != ' ' && out.back() != '(') out += ' ';
+            continue;
+        }
+        if (c == '\'' || c == '"') {
+            // Quoted literal; backslash escapes and doubled quotes stay inside it
+            i++;
+            while (i < sql.size()) {
+                if (sql[i] == '\\') {
+                    i += 2;
+                } else if (sql[i] == c) {
+                    if (i + 1 < sql.size() && sql[i + 1] == c) {
+                        i += 2;
+                    } else {
+                        i++;
+                        break;
+                    }
+                } else {
+                    i++;
+                }
+            }
+            placeholder();
+            continue;
+        }
+        if (c == '`') {
+            const size_t end = sql.find('`', i + 1);
+            const size_t stop = end == std::string_view::npos ? sql.size() : end + 1;
+            out.append(sql.substr(i, stop - i));
+            i = stop;
+            continue;
+        }
+        if (c >= '0' && c <= '9' && (out.empty() || !isIdentifierChar(out.back()))) {
+            while (i < sql.size() && (isIdentifierChar(sql[i]) || sql[i] == '.')) i++;
+            placeholder();
+            continue;
+        }
+        if (c == '?') {
+            i++;
+            placeholder();
+            continue;
+        }
+        if (c == ')' && !out.empty() && out.back() == ' ') {
+            out.pop_back();
+        }
+        if (c == ',' && !out.empty() && out.back() == ' ') {
+            out.pop_back();
+        }
+        out += c;
+        i++;
+        if (c == ',') {
+            out += ' ';
+            while (i < sql.size() && (sql[i] == ' ' || sql[i] == '\n' || sql[i] == '\t' || sql[i] == '\r')) i++;
+        } else if (c == '(') {
+            groups.push_back(out.size() - 1);
+        } else if (c == ')' && !groups.empty()) {
+            // "(?...), (?...)" rows of a multi-row VALUES fold to "(?...)..."
+            const size_t open = groups.back();
+            groups.pop_back();
+            const std::string group = out.substr(open);
+            const size_t separator = listSeparator(out, open);
+            if (separator) {
+                const std::string before = out.substr(0, open - separator);
+                if (endsWith(before, group + "...")) {
+                    out.resize(open - separator);
+                } else if (endsWith(before, group)) {
+                    out.resize(open - separator);
+                    out += "...";
+                }
+            }
+        }
+    }
+    while (!out.empty() && out.back() == ' ') out.pop_back();
+    return out;
+}
+
+void QueryStats::record(std::string_view sql, std::chrono::steady_clock::duration elapsed, uint64_t rows,
+                        uint64_t bytes, bool failed) {
+    const double ms = std::chrono::duration<double, std::milli>(elapsed).count();
+    std::string shape = normalize(sql);
+
+    size_t bucket = 0;
+    while (bucket + 1 < kBuckets && ms > bucketBoundMs(bucket)) bucket++;
+
+    std::shared_ptr<spdlog::logger> slow_log;
+    {
+        std::lock_guard lock(mutex_);
+        auto it = shapes_.find(shape);
+        if (it == shapes_.end() && shapes_.size() < kMaxShapes) {
+            it = shapes_.emplace(shape, Shape{}).first;
+        }
+        if (it != shapes_.end()) {
+            Shape& entry = it->second;
+            entry.calls++;
+            if (failed) entry.failures++;
+            entry.rows += rows;
+            entry.bytes += bytes;
+            entry.total_ms += ms;
+            entry.max_ms = std::max(entry.max_ms, ms);
+            entry.buckets[bucket]++;
+        } else {
+            overflow_calls_++;
+        }
+
+        if (ms < static_cast<double>(slow_threshold_.count())) {
+            return;
+        }
+        slow_total_++;
+        if (slow_.size() >= kSlowKept) slow_.pop_front();
+        slow_.push_back(SlowQuery{std::string(sql.substr(0, 4096)), ms, rows, static_cast<int64_t>(std::time(nullptr))});
+        slow_log = slow_log_;
+    }
+    if (slow_log) {
+        slow_log->warn("{:.1f} ms, {} rows, {} bytes{}: {}", ms, rows, bytes, failed ? ", failed" : "",
+                       sql.substr(0, 4096));
+    }
+}
+
+double QueryStats::percentile(const Shape& shape, double q) {
+    if (shape.calls == 0) return 0;
+    const double target = q * static_cast<double>(shape.calls);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBuckets; i++) {
+        const uint64_t count = shape.buckets[i];
+        if (count == 0) continue;
+        if (static_cast<double>(seen + count) >= target) {
+            // Linear within the bucket; the open last bucket ends at the slowest call
+            const double low = i == 0 ? 0.0 : bucketBoundMs(i - 1);
+            const double high = i + 1 == kBuckets ? shape.max_ms : std::min(bucketBoundMs(i), shape.max_ms);
+            const double fraction = (target - static_cast<double>(seen)) / static_cast<double>(count);
+            return low + (std::max(high, low) - low) * fraction;
+        }
+        seen += count;
+    }
+    return shape.max_ms;
+}
+
+nlohmann::json QueryStats::snapshot(size_t limit) const {
+    std::lock_guard lock(mutex_);
+    std::vector<const std::pair<const std::string, Shape>*> ordered;
+    ordered.reserve(shapes_.size());
+    for (const auto& entry : shapes_) ordered.push_back(&entry);
+    std::sort(ordered.begin(), ordered.end(),
+              [](const auto* a, const auto* b) { return a->second.total_ms > b->second.total_ms; });
+    if (ordered.size() > limit) ordered.resize(limit);
+
+    nlohmann::json shapes = nlohmann::json::array();
+    for (const auto* entry : ordered) {
+        const Shape& shape = entry->second;
+        nlohmann::json j;
+        j["query"] = entry->first;
+        j["calls"] = shape.calls;
+        j["failures"] = shape.failures;
+        j["rows"] = shape.rows;
+        j["bytes"] = shape.bytes;
+        j["total_ms"] = shape.total_ms;
+        j["mean_ms"] = shape.total_ms / static_cast<double>(shape.calls);
+        j["p50_ms"] = percentile(shape, 0.50);
+        j["p95_ms"] = percentile(shape, 0.95);
+        j["p99_ms"] = percentile(shape, 0.99);
+        j["max_ms"] = shape.max_ms;
+        shapes.push_back(std::move(j));
+    }
+
+    nlohmann::json slow = nlohmann::json::array();
+    for (auto it = slow_.rbegin(); it != slow_.rend(); ++it) {
+        slow.push_back({{"query", it->sql}, {"ms", it->ms}, {"rows", it->rows}, {"at", it->at}});
+    }
+
+    nlohmann::json j;
+    j["shapes"] = std::move(shapes);
+    j["shape_count"] = shapes_.size();
+    j["untracked_calls"] = overflow_calls_;
+    j["slow_threshold_ms"] = slow_threshold_.count();
+    j["slow_total"] = slow_total_;
+    j["slow_recent"] = std::move(slow);
+    return j;
+}
+
+void QueryStats::reset() {
+    std::lock_guard lock(mutex_);
+    shapes_.clear();
+    overflow_calls_ = 0;
+    slow_.clear();
+    slow_total_ = 0;
+}
+
+} // namespace aeronautical
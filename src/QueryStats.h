@@ -0,0 +1,79 @@
+#pragma once
+
+#include "LockStats.h"
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <json.hpp>
+#include <spdlog/spdlog.h>
+
+namespace aeronautical {
+
+// Timings of every statement DatabaseManager runs, grouped by query shape:
+// the SQL with literals replaced by '?' and IN/VALUES lists folded, so
+// "WHERE id = 12" and "WHERE id = 40" count as one. Each shape keeps a
+// call count, a latency histogram (p50/p95/p99), failures, rows and
+// bytes fetched. Statements slower than the threshold also go to the
+// slow-query logger and a short list of the latest ones.
+class QueryStats {
+public:
+    static QueryStats& getInstance();
+
+    QueryStats(const QueryStats&) = delete;
+    QueryStats& operator=(const QueryStats&) = delete;
+
+    // slow_log nullptr keeps slow statements out of the logs (they are still listed)
+    void configure(std::chrono::milliseconds slow_threshold, std::shared_ptr<spdlog::logger> slow_log);
+
+    void record(std::string_view sql, std::chrono::steady_clock::duration elapsed, uint64_t rows, uint64_t bytes,
+                bool failed);
+
+    // Shapes by total time spent, the top `limit` of them, and the slow list
+    nlohmann::json snapshot(size_t limit) const;
+    void reset();
+
+    static std::string normalize(std::string_view sql);
+
+private:
+    QueryStats() = default;
+
+    // Upper bounds 100 us, 200 us, ... ~52 s; the last bucket is open
+    static constexpr size_t kBuckets = 21;
+    static constexpr size_t kMaxShapes = 2000;
+    static constexpr size_t kSlowKept = 100;
+
+    struct Shape {
+        uint64_t calls = 0;
+        uint64_t failures = 0;
+        uint64_t rows = 0;
+        uint64_t bytes = 0;
+        double total_ms = 0;
+        double max_ms = 0;
+        std::array<uint64_t, kBuckets> buckets{};
+    };
+
+    struct SlowQuery {
+        std::string sql;
+        double ms = 0;
+        uint64_t rows = 0;
+        int64_t at = 0; // unix seconds
+    };
+
+    static double percentile(const Shape& shape, double q);
+
+    mutable InstrumentedMutex<std::mutex> mutex_{"query_stats"};
+    std::unordered_map<std::string, Shape> shapes_;
+    uint64_t overflow_calls_ = 0; // calls of shapes past kMaxShapes
+    std::deque<SlowQuery> slow_;
+    uint64_t slow_total_ = 0;
+    std::chrono::milliseconds slow_threshold_{500};
+    std::shared_ptr<spdlog::logger> slow_log_;
+};
+
+} // namespace aeronautical
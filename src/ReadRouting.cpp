@@ -0,0 +1,68 @@
+#include "ReadRouting.h"
+#include "DatabaseManager.h"
+#include "TokenVerifier.h"
+
+namespace aeronautical {
+
+namespace {
+
+// Clients tracked at once; past it expired entries are dropped
+constexpr size_t kMaxTrackedClients = 10000;
+
+} // namespace
+
+bool ReadRouting::isRead(const crow::request& req) {
+    if (req.method == crow::HTTPMethod::POST) {
+        // A batch only carries GET sub-requests
+        return req.url == "/api/batch";
+    }
+    return req.method == crow::HTTPMethod::GET || req.method == crow::HTTPMethod::HEAD;
+}
+
+std::string ReadRouting::clientKey(const crow::request& req) {
+    // A header the client chose freely would let it pose as another client,
+    // or as a new one per request; a verified token cannot be made up
+    auto& verifier = TokenVerifier::getInstance();
+    const std::string& authorization = req.get_header_value("Authorization");
+    if (!authorization.empty() && verifier.enabled()) {
+        std::string error;
+        if (verifier.authorizes(authorization, error)) return "a:" + authorization;
+    }
+    return "r:" + req.remote_ip_address;
+}
+
+void ReadRouting::recordWrite(const std::string& client, std::chrono::steady_clock::duration window) {
+    const auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (read_primary_until_.size() >= kMaxTrackedClients) {
+        std::erase_if(read_primary_until_, [now](const auto& entry) { return entry.second <= now; });
+    }
+    read_primary_until_[client] = now + window;
+}
+
+bool ReadRouting::wroteRecently(const std::string& client) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = read_primary_until_.find(client);
+    if (it == read_primary_until_.end()) return false;
+    if (it->second > std::chrono::steady_clock::now()) return true;
+    read_primary_until_.erase(it);
+    return false;
+}
+
+void ReadRouting::before_handle(crow::request& req, crow::response&, context&) {
+    auto& db = DatabaseManager::getInstance();
+    if (!db.hasReplicas()) return;
+    DatabaseManager::setReplicaReadsAllowed(isRead(req) && !wroteRecently(clientKey(req)));
+}
+
+void ReadRouting::after_handle(crow::request& req, crow::response&, context&) {
+    auto& db = DatabaseManager::getInstance();
+    if (!db.hasReplicas()) return;
+    DatabaseManager::setReplicaReadsAllowed(false);
+    // Counted from the end of the write, when it has committed
+    if (!isRead(req) && req.method != crow::HTTPMethod::OPTIONS) {
+        recordWrite(clientKey(req), db.replicas()->readYourWritesWindow());
+    }
+}
+
+} // namespace aeronautical
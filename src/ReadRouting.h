@@ -0,0 +1,36 @@
+#pragma once
+
+#include <crow.h>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace aeronautical {
+
+// Crow middleware deciding per request whether the repository reads it
+// makes (DatabaseManager::ReadScope) may go to a replica: only GET and
+// HEAD requests may, and not while the same client wrote within the
+// replicas' read-your-writes window, so a client that just submitted
+// reads its own change back from the primary. Clients are told apart by
+// their bearer token once TokenVerifier accepted it, else remote address.
+// Does nothing unless DatabaseManager has replicas.
+class ReadRouting {
+public:
+    struct context {};
+
+    void before_handle(crow::request& req, crow::response& res, context& ctx);
+    void after_handle(crow::request& req, crow::response& res, context& ctx);
+
+    static std::string clientKey(const crow::request& req);
+
+private:
+    static bool isRead(const crow::request& req);
+    void recordWrite(const std::string& client, std::chrono::steady_clock::duration window);
+    bool wroteRecently(const std::string& client);
+
+    std::mutex mutex_;
+    std::unordered_map<std::string, std::chrono::steady_clock::time_point> read_primary_until_;
+};
+
+} // namespace aeronautical
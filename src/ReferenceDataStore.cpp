@@ -0,0 +1,843 @@
+#include "ReferenceDataStore.h"
+#include "AirportRepository.h"
+#include "WaypointRepository.h"
+#include "ReferenceSnapshotFile.h"
+#include "ReferenceImport.h"
+#include "CacheEvents.h"
+#include "ChangeLog.h"
+#include "ConditionalGet.h"
+#include "FileResponse.h"
+#include "JsonWriter.h"
+#include "MemoryArenas.h"
+#include "Project.h"
+#include "TokenVerifier.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <functional>
+#include <unordered_set>
+
+namespace aeronautical {
+
+namespace {
+
+char asciiUpper(char c) { return (c >= 'a' && c <= 'z') ? static_cast<char>(c - 'a' + 'A') : c; }
+char asciiLower(char c) { return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c; }
+
+std::string upperKey(std::string_view text) {
+    std::string key(text);
+    std::transform(key.begin(), key.end(), key.begin(), asciiUpper);
+    return key;
+}
+
+// Builds the all-types cluster index and one per type over the active rows
+template <typename T, typename TypeOf>
+void buildClusters(const std::vector<T>& rows, TypeOf type_of, ClusterIndex& all,
+                   std::unordered_map<std::string, ClusterIndex>& by_type) {
+    std::vector<ClusterIndex::Point> points;
+    std::unordered_map<std::string, std::vector<ClusterIndex::Point>> typed;
+    for (size_t i = 0; i < rows.size(); i++) {
+        const T& row = rows[i];
+        if (!row.is_active) continue;
+        ClusterIndex::Point point{row.latitude, row.longitude, static_cast<uint32_t>(i), type_of(row)};
+        points.push_back(point);
+        typed[upperKey(point.type)].push_back(point);
+    }
+    all.build(points);
+    by_type.clear();
+    for (const auto& [type, type_points] : typed) {
+        by_type[type].build(type_points);
+    }
+}
+
+std::vector<ClusterIndex::Cluster> queryClusters(const ClusterIndex& all,
+                                                 const std::unordered_map<std::string, ClusterIndex>& by_type,
+                                                 const GeoBounds& bounds, int zoom, std::string_view type) {
+    if (type.empty()) {
+        return all.query(bounds, zoom);
+    }
+    auto it = by_type.find(upperKey(type));
+    return it == by_type.end() ? std::vector<ClusterIndex::Cluster>{} : it->second.query(bounds, zoom);
+}
+
+// Column comparison under MySQL's case-insensitive collation (ASCII folding)
+bool sameText(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (asciiLower(a[i]) != asciiLower(b[i])) return false;
+    }
+    return true;
+}
+
+template <typename T, typename TypeOf>
+void buildColumns(const std::vector<T>& rows, TypeOf type_of, RowColumns& columns) {
+    columns.active.resize(rows.size());
+    columns.type.resize(rows.size());
+    for (size_t i = 0; i < rows.size(); i++) {
+        columns.active[i] = rows[i].is_active;
+        auto [it, added] = columns.type_ids.emplace(upperKey(type_of(rows[i])),
+                                                    static_cast<uint16_t>(columns.type_ids.size()));
+        columns.type[i] = it->second;
+    }
+}
+
+// Filter value for an optional ?type=: empty matches every row
+int typeFilter(const RowColumns& columns, std::string_view type) {
+    return type.empty() ? RowColumns::kAnyType : columns.typeId(type);
+}
+
+template <typename T>
+std::vector<const T*> select(const std::vector<T>& rows, const RowColumns& columns, bool active_only, int type_id) {
+    std::vector<const T*> out;
+    if (type_id == RowColumns::kUnknownType) return out;
+    for (size_t i = 0; i < rows.size(); i++) {
+        if (columns.matches(i, active_only, type_id)) out.push_back(&rows[i]);
+    }
+    return out;
+}
+
+template <typename T, typename Pred>
+std::vector<const T*> select(const std::vector<T>& rows, Pred&& pred) {
+    std::vector<const T*> out;
+    for (const auto& row : rows) {
+        if (pred(row)) out.push_back(&row);
+    }
+    return out;
+}
+
+template <typename T>
+std::vector<const T*> selectIds(const std::vector<T>& rows, std::span<const int> ids) {
+    if (ids.empty()) return {};
+    std::unordered_set<int> wanted(ids.begin(), ids.end());
+    return select(rows, [&](const T& row) { return wanted.count(row.id) > 0; });
+}
+
+template <typename T>
+std::vector<const T*> selectIndexed(const std::vector<T>& rows, const RowColumns& columns,
+                                    const std::unordered_map<std::string, std::vector<size_t>>& index,
+                                    std::string_view key, bool active_only) {
+    std::vector<const T*> out;
+    auto it = index.find(upperKey(key));
+    if (it == index.end()) return out;
+    out.reserve(it->second.size());
+    for (size_t i : it->second) {
+        if (!active_only || columns.active[i]) out.push_back(&rows[i]);
+    }
+    return out;
+}
+
+template <typename T>
+std::vector<const T*> search(const std::vector<T>& rows, const SearchIndex& index, std::string_view query, int limit) {
+    std::vector<const T*> out;
+    for (uint32_t row : index.search(query, static_cast<size_t>(std::max(0, limit)))) {
+        out.push_back(&rows[row]);
+    }
+    return out;
+}
+
+uint8_t airportTier(std::string_view airport_type) {
+    if (sameText(airport_type, "large_airport")) return 0;
+    if (sameText(airport_type, "medium_airport")) return 1;
+    if (sameText(airport_type, "small_airport")) return 2;
+    return 3;
+}
+
+// Active rows among indices that carry type_id
+template <typename T>
+std::vector<const T*> selectRows(const std::vector<T>& rows, const std::vector<size_t>& indices,
+                                 const RowColumns& columns, int type_id) {
+    std::vector<const T*> out;
+    if (type_id == RowColumns::kUnknownType) return out;
+    out.reserve(indices.size());
+    for (size_t i : indices) {
+        if (columns.matches(i, true, type_id)) out.push_back(&rows[i]);
+    }
+    return out;
+}
+
+template <typename T>
+uint64_t rowFingerprint(std::string& scratch, const T& row) {
+    scratch.clear();
+    JsonWriter writer(scratch);
+    row.writeJson(writer);
+    return std::hash<std::string>{}(scratch);
+}
+
+struct RowChanges {
+    std::vector<int> inserted;
+    std::vector<int> updated;
+    std::vector<int> deleted;
+
+    bool empty() const { return inserted.empty() && updated.empty() && deleted.empty(); }
+};
+
+// Ids of next that were added, changed (any serialized field) or removed relative to previous
+template <typename T>
+RowChanges diffRows(const std::vector<T>& previous, const std::vector<T>& next) {
+    std::string scratch;
+    std::unordered_map<int, uint64_t> before;
+    before.reserve(previous.size());
+    for (const T& row : previous) {
+        before.emplace(row.id, rowFingerprint(scratch, row));
+    }
+    RowChanges changes;
+    for (const T& row : next) {
+        auto it = before.find(row.id);
+        if (it == before.end()) {
+            changes.inserted.push_back(row.id);
+            continue;
+        }
+        if (it->second != rowFingerprint(scratch, row)) {
+            changes.updated.push_back(row.id);
+        }
+        before.erase(it);
+    }
+    for (const auto& [id, fingerprint] : before) {
+        changes.deleted.push_back(id);
+    }
+    return changes;
+}
+
+template <typename T>
+bool sameRows(const std::vector<T>& a, const std::vector<T>& b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    std::string scratch;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (rowFingerprint(scratch, a[i]) != rowFingerprint(scratch, b[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint64_t wallClockMs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                     std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+// One bitmap per upper-cased value of a column
+template <typename T, typename ValueOf>
+std::unordered_map<std::string, RowBitmap> buildBitmaps(const std::vector<T>& rows, ValueOf value_of) {
+    std::unordered_map<std::string, std::vector<uint32_t>> grouped;
+    for (size_t i = 0; i < rows.size(); i++) {
+        grouped[upperKey(value_of(rows[i]))].push_back(static_cast<uint32_t>(i));
+    }
+    std::unordered_map<std::string, RowBitmap> bitmaps;
+    bitmaps.reserve(grouped.size());
+    for (auto& [value, group] : grouped) {
+        bitmaps.emplace(value, RowBitmap(std::move(group), rows.size()));
+    }
+    return bitmaps;
+}
+
+crow::response unauthorized(const std::string& error) {
+    crow::response res(401, nlohmann::json{{"error", true}, {"message", error}}.dump());
+    res.add_header("Content-Type", "application/json");
+    return res;
+}
+
+} // namespace
+
+int RowColumns::typeId(std::string_view type_name) const {
+    auto it = type_ids.find(upperKey(type_name));
+    return it == type_ids.end() ? kUnknownType : it->second;
+}
+
+void ReferenceSnapshot::buildIndexes() {
+    airport_by_icao_.reserve(airports.size());
+    for (size_t i = 0; i < airports.size(); i++) {
+        const Airport& a = airports[i];
+        // First row wins, as with "... LIMIT 1"
+        if (!a.icao_code.empty()) airport_by_icao_.emplace(upperKey(a.icao_code), i);
+        if (!a.iata_code.empty()) airport_by_iata_.emplace(upperKey(a.iata_code), i);
+        airports_by_country_[upperKey(a.country_code)].push_back(i);
+        if (a.is_active) {
+            airport_search_.add(static_cast<uint32_t>(i), {a.icao_code, a.iata_code}, {a.name, a.municipality},
+                                airportTier(a.airport_type));
+        }
+    }
+
+    waypoint_by_code_.reserve(waypoints.size());
+    for (size_t i = 0; i < waypoints.size(); i++) {
+        const Waypoint& w = waypoints[i];
+        if (!w.waypoint_code.empty()) {
+            auto [it, inserted] = waypoint_by_code_.emplace(upperKey(w.waypoint_code), i);
+            if (!inserted) {
+                auto& rows = waypoint_code_duplicates_[it->first];
+                if (rows.empty()) rows.push_back(it->second);
+                rows.push_back(i);
+            }
+        }
+        if (w.is_active) {
+            waypoint_search_.add(static_cast<uint32_t>(i), {w.waypoint_code}, {w.name, w.waypoint_type});
+        }
+    }
+
+    // Stable, so rows keep the ORDER BY runway_identifier of the load
+    std::stable_sort(runways.begin(), runways.end(),
+                     [](const AirportRunway& a, const AirportRunway& b) { return a.airport_id < b.airport_id; });
+    for (size_t i = 0; i < runways.size();) {
+        size_t end = i;
+        while (end < runways.size() && runways[end].airport_id == runways[i].airport_id) end++;
+        runways_by_airport_.emplace(runways[i].airport_id,
+                                    std::make_pair(static_cast<uint32_t>(i), static_cast<uint32_t>(end)));
+        i = end;
+    }
+
+    airport_search_.build();
+    waypoint_search_.build();
+
+    buildColumns(airports, [](const Airport& a) { return std::string_view(a.airport_type); }, airport_columns_);
+    buildColumns(waypoints, [](const Waypoint& w) { return std::string_view(w.waypoint_type); }, waypoint_columns_);
+
+    waypoint_type_bitmaps_ = buildBitmaps(waypoints, [](const Waypoint& w) { return std::string_view(w.waypoint_type); });
+    waypoint_usage_bitmaps_ = buildBitmaps(waypoints, [](const Waypoint& w) { return std::string_view(w.usage_type); });
+    waypoint_country_bitmaps_ = buildBitmaps(waypoints, [](const Waypoint& w) { return std::string_view(w.country_code); });
+    std::vector<uint32_t> active;
+    for (size_t i = 0; i < waypoints.size(); i++) {
+        if (waypoints[i].is_active) active.push_back(static_cast<uint32_t>(i));
+    }
+    waypoint_active_bitmap_ = RowBitmap(std::move(active), waypoints.size());
+
+    airport_grid_.build(airports);
+    waypoint_grid_.build(waypoints);
+
+    buildClusters(airports, [](const Airport& a) { return std::string_view(a.airport_type); },
+                  airport_clusters_, airport_clusters_by_type_);
+    buildClusters(waypoints, [](const Waypoint& w) { return std::string_view(w.waypoint_type); },
+                  waypoint_clusters_, waypoint_clusters_by_type_);
+}
+
+const Airport* ReferenceSnapshot::airportByIcao(std::string_view icao_code) const {
+    auto it = airport_by_icao_.find(upperKey(icao_code));
+    return it == airport_by_icao_.end() ? nullptr : &airports[it->second];
+}
+
+const Airport* ReferenceSnapshot::airportByIata(std::string_view iata_code) const {
+    auto it = airport_by_iata_.find(upperKey(iata_code));
+    return it == airport_by_iata_.end() ? nullptr : &airports[it->second];
+}
+
+std::vector<const Airport*> ReferenceSnapshot::allAirports(std::string_view airport_type, bool active_only) const {
+    return select(airports, airport_columns_, active_only, typeFilter(airport_columns_, airport_type));
+}
+
+std::vector<const Airport*> ReferenceSnapshot::airportsByCountry(std::string_view country_code, bool active_only) const {
+    return selectIndexed(airports, airport_columns_, airports_by_country_, country_code, active_only);
+}
+
+std::vector<const Airport*> ReferenceSnapshot::airportsInBounds(const GeoBounds& bounds,
+                                                                std::string_view airport_type) const {
+    return selectRows(airports, airport_grid_.query(bounds), airport_columns_, typeFilter(airport_columns_, airport_type));
+}
+
+std::vector<const Airport*> ReferenceSnapshot::airportsByIds(std::span<const int> ids) const {
+    return selectIds(airports, ids);
+}
+
+std::vector<const Airport*> ReferenceSnapshot::searchAirports(std::string_view query, int limit) const {
+    return search(airports, airport_search_, query, limit);
+}
+
+std::span<const AirportRunway> ReferenceSnapshot::runwaysForAirport(int airport_id) const {
+    auto it = runways_by_airport_.find(airport_id);
+    if (it == runways_by_airport_.end()) return {};
+    return std::span<const AirportRunway>(runways.data() + it->second.first, it->second.second - it->second.first);
+}
+
+std::vector<ClusterIndex::Cluster> ReferenceSnapshot::airportClusters(const GeoBounds& bounds, int zoom,
+                                                                     std::string_view airport_type) const {
+    return queryClusters(airport_clusters_, airport_clusters_by_type_, bounds, zoom, airport_type);
+}
+
+const Waypoint* ReferenceSnapshot::waypointByCode(std::string_view waypoint_code) const {
+    auto it = waypoint_by_code_.find(upperKey(waypoint_code));
+    return it == waypoint_by_code_.end() ? nullptr : &waypoints[it->second];
+}
+
+std::vector<const Waypoint*> ReferenceSnapshot::waypointsByCode(std::string_view waypoint_code) const {
+    std::vector<const Waypoint*> out;
+    const std::string key = upperKey(waypoint_code);
+    if (auto dup = waypoint_code_duplicates_.find(key); dup != waypoint_code_duplicates_.end()) {
+        out.reserve(dup->second.size());
+        for (size_t row : dup->second) out.push_back(&waypoints[row]);
+    } else if (auto it = waypoint_by_code_.find(key); it != waypoint_by_code_.end()) {
+        out.push_back(&waypoints[it->second]);
+    }
+    return out;
+}
+
+std::vector<const Waypoint*> ReferenceSnapshot::waypointsByIds(std::span<const int> ids) const {
+    return selectIds(waypoints, ids);
+}
+
+std::vector<const Waypoint*> ReferenceSnapshot::allWaypoints(std::string_view waypoint_type, bool active_only) const {
+    return findWaypoints({.waypoint_type = waypoint_type, .active_only = active_only});
+}
+
+std::vector<const Waypoint*> ReferenceSnapshot::waypointsByCountry(std::string_view country_code, bool active_only) const {
+    // An empty code is a value here, as in "WHERE country_code = ''"
+    auto it = waypoint_country_bitmaps_.find(upperKey(country_code));
+    if (it == waypoint_country_bitmaps_.end()) return {};
+    std::vector<const Waypoint*> out;
+    out.reserve(it->second.count());
+    it->second.forEach([&](size_t row) {
+        if (!active_only || waypoint_active_bitmap_.contains(row)) out.push_back(&waypoints[row]);
+    });
+    return out;
+}
+
+std::vector<const Waypoint*> ReferenceSnapshot::waypointsByType(std::string_view waypoint_type, bool active_only) const {
+    return select(waypoints, waypoint_columns_, active_only, waypoint_columns_.typeId(waypoint_type));
+}
+
+std::vector<const Waypoint*> ReferenceSnapshot::waypointsByUsage(std::string_view usage_type, bool active_only) const {
+    if (usage_type.empty()) {
+        return select(waypoints, [&](const Waypoint& w) { return (!active_only || w.is_active) && w.usage_type.empty(); });
+    }
+    return findWaypoints({.usage_type = usage_type, .active_only = active_only});
+}
+
+std::vector<const Waypoint*> ReferenceSnapshot::waypointsInBounds(const GeoBounds& bounds,
+                                                                  std::string_view waypoint_type) const {
+    return findWaypointsInBounds(bounds, {.waypoint_type = waypoint_type});
+}
+
+bool ReferenceSnapshot::waypointBitmaps(const WaypointFilter& filter, std::vector<const RowBitmap*>& bitmaps) const {
+    bitmaps.clear();
+    for (auto [value, index] : {std::pair{filter.waypoint_type, &waypoint_type_bitmaps_},
+                                std::pair{filter.usage_type, &waypoint_usage_bitmaps_},
+                                std::pair{filter.country_code, &waypoint_country_bitmaps_}}) {
+        if (value.empty()) continue;
+        auto it = index->find(upperKey(value));
+        if (it == index->end()) return false;
+        bitmaps.push_back(&it->second);
+    }
+    if (filter.active_only) {
+        bitmaps.push_back(&waypoint_active_bitmap_);
+    }
+    std::sort(bitmaps.begin(), bitmaps.end(),
+              [](const RowBitmap* a, const RowBitmap* b) { return a->count() < b->count(); });
+    return true;
+}
+
+std::vector<const Waypoint*> ReferenceSnapshot::findWaypoints(const WaypointFilter& filter) const {
+    std::vector<const RowBitmap*> bitmaps;
+    if (!waypointBitmaps(filter, bitmaps)) return {};
+    std::vector<const Waypoint*> out;
+    if (bitmaps.empty()) {
+        out.reserve(waypoints.size());
+        for (const auto& w : waypoints) out.push_back(&w);
+        return out;
+    }
+    if (bitmaps.size() == 1) {
+        out.reserve(bitmaps[0]->count());
+        bitmaps[0]->forEach([&](size_t row) { out.push_back(&waypoints[row]); });
+        return out;
+    }
+    RowBitmap rows = RowBitmap::intersect(*bitmaps[0], *bitmaps[1]);
+    for (size_t i = 2; i < bitmaps.size() && !rows.empty(); i++) {
+        rows = RowBitmap::intersect(rows, *bitmaps[i]);
+    }
+    out.reserve(rows.count());
+    rows.forEach([&](size_t row) { out.push_back(&waypoints[row]); });
+    return out;
+}
+
+std::vector<const Waypoint*> ReferenceSnapshot::findWaypointsInBounds(const GeoBounds& bounds,
+                                                                      const WaypointFilter& filter) const {
+    WaypointFilter active = filter;
+    active.active_only = true;
+    std::vector<const RowBitmap*> bitmaps;
+    if (!waypointBitmaps(active, bitmaps)) return {};
+    std::vector<const Waypoint*> out;
+    for (size_t row : waypoint_grid_.query(bounds)) {
+        // Smallest first, so most rows fail on the first probe
+        if (std::all_of(bitmaps.begin(), bitmaps.end(), [row](const RowBitmap* b) { return b->contains(row); })) {
+            out.push_back(&waypoints[row]);
+        }
+    }
+    return out;
+}
+
+size_t ReferenceSnapshot::waypointBitmapBytes() const {
+    size_t bytes = waypoint_active_bitmap_.bytes();
+    for (const auto* index : {&waypoint_type_bitmaps_, &waypoint_usage_bitmaps_, &waypoint_country_bitmaps_}) {
+        for (const auto& [value, bitmap] : *index) bytes += bitmap.bytes();
+    }
+    return bytes;
+}
+
+std::vector<const Waypoint*> ReferenceSnapshot::searchWaypoints(std::string_view query, int limit) const {
+    return search(waypoints, waypoint_search_, query, limit);
+}
+
+std::vector<std::pair<const Waypoint*, double>> ReferenceSnapshot::nearestWaypoints(
+    double lat, double lng, size_t k, std::string_view waypoint_type) const {
+    std::vector<std::pair<const Waypoint*, double>> out;
+    int type_id = typeFilter(waypoint_columns_, waypoint_type);
+    if (type_id == RowColumns::kUnknownType) return out;
+    auto accept = [&](size_t row) { return waypoint_columns_.matches(row, true, type_id); };
+    for (const auto& [row, distance] : waypoint_grid_.nearest(lat, lng, k, accept)) {
+        out.emplace_back(&waypoints[row], distance);
+    }
+    return out;
+}
+
+std::vector<ClusterIndex::Cluster> ReferenceSnapshot::waypointClusters(const GeoBounds& bounds, int zoom,
+                                                                      std::string_view waypoint_type) const {
+    return queryClusters(waypoint_clusters_, waypoint_clusters_by_type_, bounds, zoom, waypoint_type);
+}
+
+ReferenceDataStore& ReferenceDataStore::getInstance() {
+    static ReferenceDataStore instance;
+    return instance;
+}
+
+ReferenceDataStore::~ReferenceDataStore() {
+    stop();
+}
+
+bool ReferenceDataStore::refresh() {
+    auto logger = spdlog::get("aeronautical");
+    std::lock_guard<std::mutex> lock(refresh_mutex_);
+    // The snapshot outlives the request or thread that loads it
+    ArenaScope arena("reference");
+    auto started = std::chrono::steady_clock::now();
+
+    auto previous = snapshot();
+    auto next = std::make_shared<ReferenceSnapshot>();
+    bool ok = false;
+    try {
+        // Inactive rows too, so active_only=false requests can be served
+        AirportRepository airports;
+        WaypointRepository waypoints;
+        ok = airports.streamAllAirports("", false, [&](const Airport& a) { next->airports.push_back(a); }) &&
+             waypoints.streamAllWaypoints("", false, [&](const Waypoint& w) { next->waypoints.push_back(w); });
+    } catch (const std::exception& e) {
+        if (logger) logger->error("Reference data load failed: {}", e.what());
+        ok = false;
+    }
+
+    if (ok) {
+        // A deployment without airport_runways still gets airports and waypoints cached
+        bool runways_ok = false;
+        try {
+            AirportRepository airports;
+            runways_ok = airports.streamAllRunways(false, [&](const AirportRunway& r) { next->runways.push_back(r); });
+        } catch (const std::exception& e) {
+            if (logger) logger->error("Runway load failed: {}", e.what());
+        }
+        if (!runways_ok) {
+            next->runways = previous ? previous->runways : std::vector<AirportRunway>{};
+            if (logger) logger->warn("Runway load failed; keeping {} previous runways", next->runways.size());
+        }
+    }
+
+    if (!ok) {
+        refresh_failures_.fetch_add(1, std::memory_order_relaxed);
+        if (logger) logger->warn("Reference data refresh failed; keeping the previous snapshot");
+        return false;
+    }
+
+    // Unchanged content keeps its version, so ETags stay valid across reloads
+    RowChanges airport_changes, waypoint_changes;
+    bool changed = !previous;
+    if (previous) {
+        airport_changes = diffRows(previous->airports, next->airports);
+        waypoint_changes = diffRows(previous->waypoints, next->waypoints);
+        changed = !airport_changes.empty() || !waypoint_changes.empty() || !sameRows(previous->runways, next->runways);
+    }
+    next->version = changed ? std::max(previous ? previous->version + 1 : 0, wallClockMs()) : previous->version;
+
+    next->loaded_at = std::chrono::system_clock::now();
+    next->buildIndexes();
+    std::shared_ptr<const ReferenceSnapshot> published = next;
+    snapshot_.publish(std::move(next));
+    served_from_file_.store(false, std::memory_order_relaxed);
+
+    auto& change_log = ChangeLog::getInstance();
+    if (previous) {
+        change_log.record(ChangeLog::Table::Airports, std::move(airport_changes.inserted),
+                          std::move(airport_changes.updated), std::move(airport_changes.deleted));
+        change_log.record(ChangeLog::Table::Waypoints, std::move(waypoint_changes.inserted),
+                          std::move(waypoint_changes.updated), std::move(waypoint_changes.deleted));
+    } else {
+        change_log.restart(ChangeLog::Table::Airports);
+        change_log.restart(ChangeLog::Table::Waypoints);
+    }
+
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - started;
+    last_refresh_ms_.store(elapsed.count(), std::memory_order_relaxed);
+    refresh_count_.fetch_add(1, std::memory_order_relaxed);
+    if (logger) {
+        logger->info("Reference data loaded: {} airports, {} waypoints, {} runways in {:.1f} ms",
+                     published->airports.size(), published->waypoints.size(), published->runways.size(),
+                     elapsed.count());
+    }
+
+    if (!snapshot_path_.empty() && !ReferenceSnapshotFile::save(*published, snapshot_path_)) {
+        if (logger) logger->warn("Reference data could not be saved to {}", snapshot_path_);
+    }
+    return true;
+}
+
+void ReferenceDataStore::setSnapshotPath(std::string path) {
+    snapshot_path_ = std::move(path);
+}
+
+bool ReferenceDataStore::restoreFromFile() {
+    if (snapshot_path_.empty()) {
+        return false;
+    }
+    ArenaScope arena("reference");
+    auto started = std::chrono::steady_clock::now();
+    auto restored = ReferenceSnapshotFile::load(snapshot_path_);
+    if (!restored) {
+        return false;
+    }
+    restored->buildIndexes();
+    auto logger = spdlog::get("aeronautical");
+    if (logger) {
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - started;
+        logger->info("Reference data restored from {} ({}): {} airports, {} waypoints, {} runways in {:.1f} ms",
+                     snapshot_path_, timePointToString(restored->loaded_at), restored->airports.size(),
+                     restored->waypoints.size(), restored->runways.size(), elapsed.count());
+    }
+    snapshot_.publish(std::move(restored));
+    served_from_file_.store(true, std::memory_order_relaxed);
+    ChangeLog::getInstance().restart(ChangeLog::Table::Airports);
+    ChangeLog::getInstance().restart(ChangeLog::Table::Waypoints);
+    return true;
+}
+
+void ReferenceDataStore::start(std::chrono::seconds refresh_interval) {
+    bool restored = restoreFromFile();
+    if (!restored) {
+        refresh();
+    }
+
+    std::lock_guard<std::mutex> lock(thread_mutex_);
+    if (refresh_thread_.joinable() || (refresh_interval.count() <= 0 && !restored)) {
+        return;
+    }
+    refresh_interval_ = refresh_interval;
+    stopping_ = false;
+    refresh_thread_ = std::thread([this, restored]() {
+        // The file may be hours old; replace it with MySQL data right away
+        if (restored) {
+            refresh();
+        }
+        if (refresh_interval_.count() > 0) {
+            refreshLoop();
+        }
+    });
+}
+
+void ReferenceDataStore::stop() {
+    {
+        std::lock_guard<std::mutex> lock(thread_mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    if (refresh_thread_.joinable()) {
+        refresh_thread_.join();
+    }
+}
+
+void ReferenceDataStore::refreshLoop() {
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(thread_mutex_);
+            wake_.wait_for(lock, refresh_interval_, [this]() { return stopping_; });
+            if (stopping_) {
+                return;
+            }
+        }
+        refresh();
+    }
+}
+
+nlohmann::json ReferenceDataStore::status() const {
+    nlohmann::json j;
+    auto current = snapshot();
+    j["loaded"] = static_cast<bool>(current);
+    j["airports"] = current ? current->airports.size() : 0;
+    j["waypoints"] = current ? current->waypoints.size() : 0;
+    j["runways"] = current ? current->runways.size() : 0;
+    j["waypoint_bitmap_bytes"] = current ? current->waypointBitmapBytes() : 0;
+    const auto interned = InternedString::poolStats();
+    j["interned_values"] = interned.values;
+    j["interned_bytes"] = interned.bytes;
+    if (current) {
+        j["loaded_at"] = timePointToString(current->loaded_at);
+    }
+    j["source"] = !current ? "none" : served_from_file_.load(std::memory_order_relaxed) ? "file" : "mysql";
+    if (!snapshot_path_.empty()) {
+        j["snapshot_path"] = snapshot_path_;
+    }
+    j["data_version"] = ChangeLog::getInstance().version();
+    j["refresh_count"] = refresh_count_.load(std::memory_order_relaxed);
+    j["refresh_failures"] = refresh_failures_.load(std::memory_order_relaxed);
+    j["last_refresh_ms"] = last_refresh_ms_.load(std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(thread_mutex_);
+    j["refresh_interval_s"] = refresh_interval_.count();
+    return j;
+}
+
+crow::response ReferenceDataStore::importCsv(const std::string& table, const std::string& csv) {
+    auto logger = spdlog::get("aeronautical");
+    auto respond = [](int code, const nlohmann::json& body) {
+        crow::response res(code, body.dump());
+        res.add_header("Content-Type", "application/json");
+        return res;
+    };
+    const auto started = std::chrono::steady_clock::now();
+    const auto current = snapshot();
+
+    // Parse, match codes against the current snapshot, write; the same for both tables
+    auto run = [&](auto& parsed, bool parsed_ok, const std::string& error, auto existing_id, auto write) {
+        if (!parsed_ok) {
+            return respond(400, {{"error", true}, {"message", error}});
+        }
+        if (!parsed.invalid.empty()) {
+            nlohmann::json invalid = nlohmann::json::array();
+            for (const auto& [line, reason] : parsed.invalid) {
+                if (invalid.size() == 100) break;
+                invalid.push_back({{"line", line}, {"error", reason}});
+            }
+            return respond(400, {{"error", true},
+                                 {"message", "Import rejected, no " + table + " row was written"},
+                                 {"invalid_count", parsed.invalid.size()},
+                                 {"invalid", invalid}});
+        }
+        if (parsed.rows.empty()) {
+            return respond(400, {{"error", true}, {"message", "No rows to import"}});
+        }
+
+        size_t updated = 0;
+        if (current) {
+            for (auto& row : parsed.rows) {
+                row.id = existing_id(*current, row);
+                if (row.id > 0) updated++;
+            }
+        }
+        const auto matched = std::chrono::steady_clock::now();
+
+        if (!write(parsed.rows, parsed.columns)) {
+            return respond(500, {{"error", true}, {"message", "Import failed, no " + table + " row was written"}});
+        }
+        const auto written = std::chrono::steady_clock::now();
+        const bool refreshed = refresh();
+        const auto finished = std::chrono::steady_clock::now();
+        CacheEvents::getInstance().publishReload(table);
+
+        auto ms = [](auto from, auto to) { return std::chrono::duration<double, std::milli>(to - from).count(); };
+        const double load_ms = ms(started, written);
+        const size_t rows = parsed.rows.size();
+        if (logger) {
+            logger->info("Imported {} {} rows ({} updated) in {:.0f} ms, refresh {:.0f} ms", rows, table, updated,
+                         load_ms, ms(written, finished));
+        }
+        nlohmann::json body;
+        body["data"] = {{"table", table},
+                        {"rows", rows},
+                        {"inserted", rows - updated},
+                        {"updated", updated},
+                        {"duplicates_skipped", parsed.duplicates},
+                        {"columns", parsed.columns},
+                        {"parse_ms", ms(started, matched)},
+                        {"write_ms", ms(matched, written)},
+                        {"refresh_ms", ms(written, finished)},
+                        {"rows_per_second", load_ms > 0 ? rows * 1000.0 / load_ms : 0.0},
+                        {"refreshed", refreshed}};
+        body["status"] = status();
+        // The rows are committed either way; a failed refresh is picked up by the next one
+        return respond(refreshed ? 200 : 503, body);
+    };
+
+    std::string error;
+    if (table == "airports") {
+        ImportedRows<Airport> parsed;
+        const bool parsed_ok = ReferenceImport::parseAirports(csv, parsed, error);
+        return run(parsed, parsed_ok, error,
+                   [](const ReferenceSnapshot& s, const Airport& a) {
+                       const Airport* existing = s.airportByIcao(a.icao_code);
+                       return existing ? existing->id : 0;
+                   },
+                   [](const std::vector<Airport>& rows, const std::vector<std::string>& columns) {
+                       return AirportRepository().upsertBatch(rows, columns);
+                   });
+    }
+    if (table == "waypoints") {
+        ImportedRows<Waypoint> parsed;
+        const bool parsed_ok = ReferenceImport::parseWaypoints(csv, parsed, error);
+        return run(parsed, parsed_ok, error,
+                   [](const ReferenceSnapshot& s, const Waypoint& w) {
+                       const Waypoint* existing = s.waypointByCode(w.waypoint_code);
+                       return existing ? existing->id : 0;
+                   },
+                   [](const std::vector<Waypoint>& rows, const std::vector<std::string>& columns) {
+                       return WaypointRepository().upsertBatch(rows, columns);
+                   });
+    }
+    return respond(404, {{"error", true}, {"message", "Unknown reference table: " + table}});
+}
+
+void ReferenceDataStore::registerRoutes(HttpApp& app) {
+    CROW_ROUTE(app, "/api/admin/reference")
+        .methods(crow::HTTPMethod::GET)
+        ([this]() {
+            crow::response res(200, status().dump());
+            res.add_header("Content-Type", "application/json");
+            return res;
+        });
+
+    CROW_ROUTE(app, "/api/admin/reference/refresh")
+        .methods(crow::HTTPMethod::POST)
+        ([this](const crow::request& req) {
+            std::string error;
+            if (!TokenVerifier::getInstance().authorizes(req.get_header_value("Authorization"), error)) {
+                return unauthorized(error);
+            }
+            bool ok = refresh();
+            // Other instances reload every reference table on any reload event
+            if (ok) CacheEvents::getInstance().publishReload("airports");
+            nlohmann::json body = status();
+            body["refreshed"] = ok;
+            crow::response res(ok ? 200 : 503, body.dump());
+            res.add_header("Content-Type", "application/json");
+            return res;
+        });
+
+    // The persisted snapshot file, e.g. to seed another instance; supports Range
+    CROW_ROUTE(app, "/api/admin/reference/snapshot")
+        .methods(crow::HTTPMethod::GET)
+        ([this](const crow::request& req, crow::response& res) {
+            auto validator = ConditionalGet::forReferenceData();
+            if (snapshot_path_.empty()) {
+                res = crow::response(404, "{\"error\":true,\"message\":\"No reference snapshot file configured\"}");
+                res.add_header("Content-Type", "application/json");
+            } else if (validator && ConditionalGet::isCurrent(req, *validator)) {
+                res = ConditionalGet::notModified(*validator);
+            } else {
+                FileResponse::prepare(req, res, snapshot_path_, "application/octet-stream", validator ? validator->etag : "");
+            }
+            res.end();
+        });
+
+    // Body is the CSV file; table is airports or waypoints
+    CROW_ROUTE(app, "/api/admin/reference/import/<string>")
+        .methods(crow::HTTPMethod::POST)
+        ([this](const crow::request& req, const std::string& table) {
+            // Replaces the table's rows
+            std::string error;
+            if (!TokenVerifier::getInstance().authorizes(req.get_header_value("Authorization"), error)) {
+                return unauthorized(error);
+            }
+            return importCsv(table, req.body);
+        });
+}
+
+} // namespace aeronautical
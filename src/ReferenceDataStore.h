@@ -0,0 +1,208 @@
+#pragma once
+
+#include "Airport.h"
+#include "Waypoint.h"
+#include "SpatialGrid.h"
+#include "ClusterIndex.h"
+#include "SearchIndex.h"
+#include "RowBitmap.h"
+#include "HttpApp.h"
+#include "SnapshotPublisher.h"
+
+#include <crow.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace aeronautical {
+
+// Per-row filter values kept apart from the row structs, so scans and
+// index post-filters read a few dense bytes per row instead of a struct
+// full of strings. Types are interned by their upper-cased text.
+struct RowColumns {
+    static constexpr int kAnyType = -1;
+    static constexpr int kUnknownType = -2;
+
+    std::vector<uint8_t> active;
+    std::vector<uint16_t> type;
+    std::unordered_map<std::string, uint16_t> type_ids;
+
+    // Interned id of type, or kUnknownType when no row has it
+    int typeId(std::string_view type_name) const;
+
+    bool matches(size_t row, bool active_only, int type_id) const {
+        return (!active_only || active[row]) && (type_id == kAnyType || type[row] == type_id);
+    }
+};
+
+// Waypoint list and bounds filters; an empty value matches every row
+struct WaypointFilter {
+    std::string_view waypoint_type{};
+    std::string_view usage_type{};
+    std::string_view country_code{};
+    bool active_only = true;
+};
+
+// One immutable copy of the airports and waypoints tables with lookup
+// indexes. Matching follows the MySQL queries it replaces: codes and
+// filters compare case-insensitively, airports keep table order and
+// waypoints are sorted by waypoint_code. Search covers the same columns
+// and active rows as the LIKE queries but is ranked (see SearchIndex). Returned pointers stay valid while the snapshot is held.
+struct ReferenceSnapshot {
+    std::vector<Airport> airports;
+    std::vector<Waypoint> waypoints;
+    std::vector<AirportRunway> runways; // grouped by airport_id, runway_identifier order within
+    std::chrono::system_clock::time_point loaded_at;
+    // Wall-clock ms of the load that last changed any table; equal versions
+    // mean equal content, also across restarts (kept in the snapshot file)
+    uint64_t version = 0;
+
+    const Airport* airportByIcao(std::string_view icao_code) const;
+    const Airport* airportByIata(std::string_view iata_code) const;
+    std::vector<const Airport*> allAirports(std::string_view airport_type, bool active_only) const;
+    std::vector<const Airport*> airportsByCountry(std::string_view country_code, bool active_only) const;
+    std::vector<const Airport*> airportsInBounds(const GeoBounds& bounds, std::string_view airport_type) const;
+    std::vector<const Airport*> searchAirports(std::string_view query, int limit) const;
+    // Rows with these ids, active or not, in table order (delta sync)
+    std::vector<const Airport*> airportsByIds(std::span<const int> ids) const;
+    // Contiguous slice of runways; empty for an unknown id
+    std::span<const AirportRunway> runwaysForAirport(int airport_id) const;
+    // Active airports in bounds grouped for this zoom; first_row indexes airports
+    std::vector<ClusterIndex::Cluster> airportClusters(const GeoBounds& bounds, int zoom,
+                                                       std::string_view airport_type) const;
+
+    const Waypoint* waypointByCode(std::string_view waypoint_code) const;
+    // Every row with this code in table order, first the one waypointByCode returns
+    std::vector<const Waypoint*> waypointsByCode(std::string_view waypoint_code) const;
+    std::vector<const Waypoint*> allWaypoints(std::string_view waypoint_type, bool active_only) const;
+    std::vector<const Waypoint*> waypointsByCountry(std::string_view country_code, bool active_only) const;
+    std::vector<const Waypoint*> waypointsByType(std::string_view waypoint_type, bool active_only) const;
+    std::vector<const Waypoint*> waypointsByUsage(std::string_view usage_type, bool active_only) const;
+    std::vector<const Waypoint*> waypointsInBounds(const GeoBounds& bounds, std::string_view waypoint_type) const;
+    // Rows matching every filter, in table order: the filters' bitmaps
+    // intersected smallest first
+    std::vector<const Waypoint*> findWaypoints(const WaypointFilter& filter) const;
+    // Active rows in bounds matching every filter, checked against the
+    // bitmaps per row the grid returns
+    std::vector<const Waypoint*> findWaypointsInBounds(const GeoBounds& bounds, const WaypointFilter& filter) const;
+    // Bytes held by the waypoint filter bitmaps
+    size_t waypointBitmapBytes() const;
+    std::vector<const Waypoint*> searchWaypoints(std::string_view query, int limit) const;
+    std::vector<const Waypoint*> waypointsByIds(std::span<const int> ids) const;
+    // Up to k active waypoints nearest (lat, lng) with great-circle km, nearest first
+    std::vector<std::pair<const Waypoint*, double>> nearestWaypoints(double lat, double lng, size_t k,
+                                                                     std::string_view waypoint_type) const;
+    // Active waypoints in bounds grouped for this zoom; first_row indexes waypoints
+    std::vector<ClusterIndex::Cluster> waypointClusters(const GeoBounds& bounds, int zoom,
+                                                        std::string_view waypoint_type) const;
+
+    // Builds the indexes; called once before the snapshot is published
+    void buildIndexes();
+
+private:
+    // The bitmaps filter names, smallest first; false when a value matches no row
+    bool waypointBitmaps(const WaypointFilter& filter, std::vector<const RowBitmap*>& bitmaps) const;
+
+    // Keys are upper-cased codes
+    std::unordered_map<std::string, size_t> airport_by_icao_;
+    std::unordered_map<std::string, size_t> airport_by_iata_;
+    std::unordered_map<std::string, std::vector<size_t>> airports_by_country_;
+    std::unordered_map<int, std::pair<uint32_t, uint32_t>> runways_by_airport_; // [begin, end) into runways
+    std::unordered_map<std::string, size_t> waypoint_by_code_;
+    // Only codes held by more than one row; all of their rows
+    std::unordered_map<std::string, std::vector<size_t>> waypoint_code_duplicates_;
+    // One RowBitmap per upper-cased value of each waypoint filter column
+    std::unordered_map<std::string, RowBitmap> waypoint_type_bitmaps_;
+    std::unordered_map<std::string, RowBitmap> waypoint_usage_bitmaps_;
+    std::unordered_map<std::string, RowBitmap> waypoint_country_bitmaps_;
+    RowBitmap waypoint_active_bitmap_;
+
+    RowColumns airport_columns_;
+    RowColumns waypoint_columns_;
+
+    SpatialGrid airport_grid_;
+    SpatialGrid waypoint_grid_;
+
+    // All active rows, plus one index per upper-cased type for ?type= requests
+    ClusterIndex airport_clusters_;
+    ClusterIndex waypoint_clusters_;
+    std::unordered_map<std::string, ClusterIndex> airport_clusters_by_type_;
+    std::unordered_map<std::string, ClusterIndex> waypoint_clusters_by_type_;
+
+    // Active rows; airports tiered large, medium, small, other
+    SearchIndex airport_search_;
+    SearchIndex waypoint_search_;
+};
+
+// Process-wide in-memory copy of the read-only reference tables. Readers
+// take the current snapshot with one atomic load and never block; refresh()
+// builds a complete new snapshot off to the side and swaps it in.
+class ReferenceDataStore {
+public:
+    static ReferenceDataStore& getInstance();
+
+    ReferenceDataStore(const ReferenceDataStore&) = delete;
+    ReferenceDataStore& operator=(const ReferenceDataStore&) = delete;
+
+    // nullptr until the first successful load, or when disabled
+    std::shared_ptr<const ReferenceSnapshot> snapshot() const {
+        return snapshot_.load();
+    }
+
+    // Reloads the tables from MySQL; on failure the previous snapshot stays.
+    // Runways alone failing keeps the previous runways instead. Airport and
+    // waypoint ids that differ from the previous snapshot go to ChangeLog.
+    bool refresh();
+
+    // Where to persist each loaded snapshot (see ReferenceSnapshotFile); set before start()
+    void setSnapshotPath(std::string path);
+
+    // Loads now, then reloads every interval on a background thread. With a
+    // snapshot file the file is served at once and MySQL loads in the background.
+    void start(std::chrono::seconds refresh_interval);
+    void stop();
+    // Serves the snapshot file alone, without MySQL; false when there is no
+    // file or it cannot be read
+    bool restoreFromFile();
+
+    // Loads a CSV upload of the airports or waypoints table (see
+    // ReferenceImport) in one transaction, then refreshes. Rows whose code
+    // the current snapshot has update that row; the rest are inserted.
+    crow::response importCsv(const std::string& table, const std::string& csv);
+
+    // POST /api/admin/reference/refresh, POST /api/admin/reference/import/<table>
+    // and GET /api/admin/reference
+    void registerRoutes(HttpApp& app);
+
+    nlohmann::json status() const;
+
+private:
+    ReferenceDataStore() = default;
+    ~ReferenceDataStore();
+
+    void refreshLoop();
+
+    SnapshotPublisher<ReferenceSnapshot> snapshot_;
+    std::mutex refresh_mutex_; // one load at a time
+    std::atomic<uint64_t> refresh_count_{0};
+    std::atomic<uint64_t> refresh_failures_{0};
+    std::atomic<double> last_refresh_ms_{0.0};
+    std::string snapshot_path_;
+    std::atomic<bool> served_from_file_{false}; // until the first MySQL load
+
+    mutable std::mutex thread_mutex_;
+    std::condition_variable wake_;
+    std::thread refresh_thread_;
+    std::chrono::seconds refresh_interval_{0};
+    bool stopping_ = false;
+};
+
+} // namespace aeronautical
@@ -0,0 +1,307 @@
+#include "ReferenceImport.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <initializer_list>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace aeronautical {
+
+namespace {
+
+std::string_view trim(std::string_view text) {
+    while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) text.remove_prefix(1);
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\t')) text.remove_suffix(1);
+    return text;
+}
+
+std::string lower(std::string_view text) {
+    std::string out(text);
+    for (char& c : out) {
+        if (c >= 'A' && c <= 'Z') c = static_cast<char>(c - 'A' + 'a');
+    }
+    return out;
+}
+
+std::string upper(std::string_view text) {
+    std::string out(text);
+    for (char& c : out) {
+        if (c >= 'a' && c <= 'z') c = static_cast<char>(c - 'a' + 'A');
+    }
+    return out;
+}
+
+// Records of an RFC 4180 document, one at a time
+class CsvCursor {
+public:
+    explicit CsvCursor(std::string_view text) : text_(text) {
+        if (text_.starts_with("\xEF\xBB\xBF")) text_.remove_prefix(3);
+    }
+
+    // Next record into fields; false at the end. line() is where it started.
+    bool next(std::vector<std::string>& fields) {
+        if (pos_ >= text_.size()) return false;
+        fields.clear();
+        line_ = next_line_;
+        std::string field;
+        bool quoted = false;
+        while (pos_ < text_.size()) {
+            const char c = text_[pos_++];
+            if (quoted) {
+                if (c == '"') {
+                    if (pos_ < text_.size() && text_[pos_] == '"') {
+                        field += '"';
+                        pos_++;
+                    } else {
+                        quoted = false;
+                    }
+                } else {
+                    if (c == '\n') next_line_++;
+                    field += c;
+                }
+            } else if (c == '"') {
+                quoted = true;
+            } else if (c == ',') {
+                fields.push_back(std::move(field));
+                field.clear();
+            } else if (c == '\n') {
+                next_line_++;
+                break;
+            } else if (c != '\r') {
+                field += c;
+            }
+        }
+        fields.push_back(std::move(field));
+        return true;
+    }
+
+    size_t line() const { return line_; }
+
+private:
+    std::string_view text_;
+    size_t pos_ = 0;
+    size_t line_ = 0;
+    size_t next_line_ = 1;
+};
+
+// Header positions of one table column: those of its names the file has,
+// in order of preference
+struct Column {
+    std::vector<size_t> positions;
+
+    bool present() const { return !positions.empty(); }
+
+    // First non-empty value, trimmed
+    std::string_view in(const std::vector<std::string>& fields) const {
+        for (size_t position : positions) {
+            if (position >= fields.size()) continue;
+            std::string_view value = trim(fields[position]);
+            if (!value.empty()) return value;
+        }
+        return {};
+    }
+};
+
+class Header {
+public:
+    explicit Header(const std::vector<std::string>& names) {
+        for (size_t i = 0; i < names.size(); i++) {
+            positions_.emplace(lower(trim(names[i])), i);
+        }
+    }
+
+    // Column read from the first of names, falling back to the later ones;
+    // table_column goes to supplied when the file has any of them
+    Column bind(const char* table_column, std::initializer_list<std::string_view> names) {
+        Column column;
+        for (std::string_view name : names) {
+            auto it = positions_.find(std::string(name));
+            if (it != positions_.end()) column.positions.push_back(it->second);
+        }
+        if (column.present()) supplied.emplace_back(table_column);
+        return column;
+    }
+
+    std::vector<std::string> supplied;
+
+private:
+    std::unordered_map<std::string, size_t> positions_;
+};
+
+bool parseNumber(std::string_view text, double& out) {
+    if (text.starts_with('+')) text.remove_prefix(1);
+    auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), out);
+    return ec == std::errc() && end == text.data() + text.size() && std::isfinite(out);
+}
+
+// Empty is 0; fractional values round
+bool parseWhole(std::string_view text, int& out) {
+    double value = 0;
+    if (text.empty()) {
+        out = 0;
+        return true;
+    }
+    if (!parseNumber(text, value) || std::abs(value) > 2e9) return false;
+    out = static_cast<int>(std::lround(value));
+    return true;
+}
+
+bool parseFlag(std::string_view text, bool fallback, bool& out) {
+    const std::string value = lower(text);
+    if (value.empty()) {
+        out = fallback;
+    } else if (value == "1" || value == "true" || value == "yes" || value == "y" || value == "t") {
+        out = true;
+    } else if (value == "0" || value == "false" || value == "no" || value == "n" || value == "f") {
+        out = false;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Shared record loop: header, then each non-blank record through read,
+// which returns an error message or empty, keeping the first row per code
+template <typename T, typename Read>
+void readRows(CsvCursor& cursor, ImportedRows<T>& out, Read&& read) {
+    std::vector<std::string> fields;
+    std::unordered_set<std::string> codes;
+    while (cursor.next(fields)) {
+        if (fields.size() == 1 && trim(fields[0]).empty()) continue;
+        T row{};
+        std::string code;
+        std::string problem = read(fields, row, code);
+        if (!problem.empty()) {
+            out.invalid.emplace_back(cursor.line(), std::move(problem));
+        } else if (!codes.insert(std::move(code)).second) {
+            out.duplicates++;
+        } else {
+            out.rows.push_back(std::move(row));
+        }
+    }
+}
+
+// Latitude and longitude of a row, range checked
+std::string readPosition(const std::vector<std::string>& fields, const Column& lat_column,
+                         const Column& lng_column, double& lat, double& lng) {
+    if (!parseNumber(lat_column.in(fields), lat) || lat < -90 || lat > 90) return "latitude is missing or out of range";
+    if (!parseNumber(lng_column.in(fields), lng) || lng < -180 || lng > 180) return "longitude is missing or out of range";
+    return {};
+}
+
+} // namespace
+
+bool ReferenceImport::parseAirports(std::string_view csv, ImportedRows<Airport>& out, std::string& error) {
+    CsvCursor cursor(csv);
+    std::vector<std::string> names;
+    if (!cursor.next(names)) {
+        error = "Empty file";
+        return false;
+    }
+
+    // OurAirports idents are ICAO codes where one exists, otherwise local
+    // codes; its newer exports carry icao_code and gps_code separately
+    Header header(names);
+    const Column code = header.bind("icao_code", {"icao_code", "gps_code", "ident"});
+    const Column iata = header.bind("iata_code", {"iata_code"});
+    const Column name = header.bind("name", {"name"});
+    const Column full_name = header.bind("full_name", {"full_name", "name"});
+    const Column lat = header.bind("latitude", {"latitude", "latitude_deg"});
+    const Column lng = header.bind("longitude", {"longitude", "longitude_deg"});
+    const Column elevation = header.bind("elevation_ft", {"elevation_ft"});
+    const Column type = header.bind("airport_type", {"airport_type", "type"});
+    const Column municipality = header.bind("municipality", {"municipality"});
+    const Column region = header.bind("region", {"region", "iso_region"});
+    const Column country_code = header.bind("country_code", {"country_code", "iso_country"});
+    const Column country_name = header.bind("country_name", {"country_name"});
+    const Column active = header.bind("is_active", {"is_active"});
+    const Column tower = header.bind("has_tower", {"has_tower"});
+    const Column ils = header.bind("has_ils", {"has_ils"});
+    const Column runways = header.bind("runway_count", {"runway_count"});
+    const Column longest = header.bind("longest_runway_ft", {"longest_runway_ft"});
+    // Without is_active an OurAirports type of "closed" marks inactive rows
+    if (!active.present() && type.present()) header.supplied.emplace_back("is_active");
+
+    if (!code.present() || !name.present() || !lat.present() || !lng.present()) {
+        error = "Header needs an airport code (icao_code, gps_code or ident), name, and latitude and longitude columns";
+        return false;
+    }
+    out.columns = std::move(header.supplied);
+
+    readRows(cursor, out, [&](const std::vector<std::string>& fields, Airport& a, std::string& key) -> std::string {
+        a.icao_code = upper(code.in(fields));
+        if (a.icao_code.empty()) return "airport code is empty";
+        a.name = std::string(name.in(fields));
+        if (a.name.empty()) return "name is empty";
+        if (auto problem = readPosition(fields, lat, lng, a.latitude, a.longitude); !problem.empty()) return problem;
+        if (!parseWhole(elevation.in(fields), a.elevation_ft)) return "elevation_ft is not a number";
+        if (!parseWhole(runways.in(fields), a.runway_count)) return "runway_count is not a number";
+        if (!parseWhole(longest.in(fields), a.longest_runway_ft)) return "longest_runway_ft is not a number";
+
+        a.iata_code = upper(iata.in(fields));
+        a.full_name = std::string(full_name.in(fields));
+        a.airport_type = std::string(type.in(fields));
+        a.municipality = std::string(municipality.in(fields));
+        a.region = std::string(region.in(fields));
+        a.country_code = upper(country_code.in(fields));
+        a.country_name = std::string(country_name.in(fields));
+        if (!parseFlag(active.in(fields), lower(a.airport_type) != "closed", a.is_active)) return "is_active is not a flag";
+        if (!parseFlag(tower.in(fields), false, a.has_tower)) return "has_tower is not a flag";
+        if (!parseFlag(ils.in(fields), false, a.has_ils)) return "has_ils is not a flag";
+        key = a.icao_code;
+        return {};
+    });
+    return true;
+}
+
+bool ReferenceImport::parseWaypoints(std::string_view csv, ImportedRows<Waypoint>& out, std::string& error) {
+    CsvCursor cursor(csv);
+    std::vector<std::string> names;
+    if (!cursor.next(names)) {
+        error = "Empty file";
+        return false;
+    }
+
+    Header header(names);
+    const Column code = header.bind("waypoint_code", {"waypoint_code", "ident"});
+    const Column name = header.bind("name", {"name"});
+    const Column lat = header.bind("latitude", {"latitude", "latitude_deg"});
+    const Column lng = header.bind("longitude", {"longitude", "longitude_deg"});
+    const Column elevation = header.bind("elevation_ft", {"elevation_ft"});
+    const Column type = header.bind("waypoint_type", {"waypoint_type", "type"});
+    const Column country_code = header.bind("country_code", {"country_code", "iso_country"});
+    const Column country_name = header.bind("country_name", {"country_name"});
+    const Column region = header.bind("region", {"region"});
+    const Column frequency = header.bind("frequency", {"frequency", "frequency_khz"});
+    const Column usage = header.bind("usage_type", {"usage_type", "usagetype"});
+    const Column active = header.bind("is_active", {"is_active"});
+
+    if (!code.present() || !lat.present() || !lng.present()) {
+        error = "Header needs a waypoint code (waypoint_code or ident), and latitude and longitude columns";
+        return false;
+    }
+    out.columns = std::move(header.supplied);
+
+    // Navaid idents repeat across regions; the table holds one row per code
+    readRows(cursor, out, [&](const std::vector<std::string>& fields, Waypoint& w, std::string& key) -> std::string {
+        w.waypoint_code = upper(code.in(fields));
+        if (w.waypoint_code.empty()) return "waypoint code is empty";
+        if (auto problem = readPosition(fields, lat, lng, w.latitude, w.longitude); !problem.empty()) return problem;
+        if (!parseWhole(elevation.in(fields), w.elevation_ft)) return "elevation_ft is not a number";
+
+        w.name = std::string(name.in(fields));
+        w.waypoint_type = upper(type.in(fields));
+        w.country_code = upper(country_code.in(fields));
+        w.country_name = std::string(country_name.in(fields));
+        w.region = std::string(region.in(fields));
+        w.frequency = std::string(frequency.in(fields));
+        w.usage_type = upper(usage.in(fields));
+        if (!parseFlag(active.in(fields), true, w.is_active)) return "is_active is not a flag";
+        key = w.waypoint_code;
+        return {};
+    });
+    return true;
+}
+
+} // namespace aeronautical
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "Airport.h"
+#include "Waypoint.h"
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace aeronautical {
+
+// Rows read from one CSV upload for the airports or waypoints table
+template <typename T>
+struct ImportedRows {
+    std::vector<T> rows; // id 0
+    // Table columns the file supplies; existing rows keep their stored value for the others
+    std::vector<std::string> columns;
+    std::vector<std::pair<size_t, std::string>> invalid; // line (header is 1), reason
+    size_t duplicates = 0; // rows repeating an earlier code, skipped
+};
+
+// CSV readers for the reference tables. Columns are matched by header
+// name, either the table's own or the OurAirports export names
+// (airports.csv, navaids.csv), so a table dump and an OurAirports
+// download both load as they are. Fields follow RFC 4180: quoted fields
+// may hold commas, doubled quotes and line breaks.
+class ReferenceImport {
+public:
+    // false with error when the header lacks a required column
+    static bool parseAirports(std::string_view csv, ImportedRows<Airport>& out, std::string& error);
+    static bool parseWaypoints(std::string_view csv, ImportedRows<Waypoint>& out, std::string& error);
+};
+
+} // namespace aeronautical
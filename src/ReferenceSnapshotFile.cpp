@@ -0,0 +1,381 @@
+#include "ReferenceSnapshotFile.h"
+#include "ReferenceDataStore.h"
+#include <spdlog/spdlog.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+#include <unordered_map>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace aeronautical {
+
+namespace {
+
+constexpr char kMagic[8] = {'A', 'P', 'M', 'R', 'E', 'F', 'S', '\0'};
+constexpr uint32_t kFormatVersion = 2;
+constexpr uint32_t kByteOrderMark = 0x01020304;
+
+struct Str {
+    uint32_t offset;
+    uint32_t length;
+};
+
+struct Header {
+    char magic[8];
+    uint32_t format_version;
+    uint32_t byte_order;
+    int64_t loaded_at_us;
+    uint64_t data_version;
+    uint64_t airport_count;
+    uint64_t waypoint_count;
+    uint64_t runway_count;
+    uint64_t airports_offset;
+    uint64_t waypoints_offset;
+    uint64_t runways_offset;
+    uint64_t pool_offset;
+    uint64_t pool_size;
+    uint64_t checksum; // FNV-1a of every byte after the header
+};
+
+// Doubles first so records have no interior padding
+struct AirportRecord {
+    double latitude;
+    double longitude;
+    int32_t id;
+    int32_t elevation_ft;
+    int32_t runway_count;
+    int32_t longest_runway_ft;
+    Str icao_code, iata_code, name, full_name, airport_type, municipality, region, country_code, country_name;
+    uint8_t is_active, has_tower, has_ils, reserved[5];
+};
+
+struct WaypointRecord {
+    double latitude;
+    double longitude;
+    int32_t id;
+    int32_t elevation_ft;
+    Str waypoint_code, name, waypoint_type, country_code, country_name, region, frequency, usage_type;
+    uint8_t is_active, reserved[7];
+};
+
+struct RunwayRecord {
+    double le_heading_deg, le_latitude, le_longitude;
+    double he_heading_deg, he_latitude, he_longitude;
+    int32_t id;
+    int32_t airport_id;
+    int32_t length_ft;
+    int32_t width_ft;
+    Str runway_identifier, surface_type, le_ident, he_ident;
+    uint8_t is_active, reserved[7];
+};
+
+static_assert(std::is_trivially_copyable_v<Header> && sizeof(Header) % 8 == 0);
+static_assert(std::is_trivially_copyable_v<AirportRecord> && sizeof(AirportRecord) % 8 == 0);
+static_assert(std::is_trivially_copyable_v<WaypointRecord> && sizeof(WaypointRecord) % 8 == 0);
+static_assert(std::is_trivially_copyable_v<RunwayRecord> && sizeof(RunwayRecord) % 8 == 0);
+
+uint64_t fnv1a(const char* data, size_t size) {
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// String pool with repeated values (countries, types) stored once
+class PoolWriter {
+public:
+    Str add(const std::string& text) {
+        auto it = seen_.find(text);
+        if (it != seen_.end()) return it->second;
+        Str ref{static_cast<uint32_t>(pool_.size()), static_cast<uint32_t>(text.size())};
+        pool_ += text;
+        seen_.emplace(text, ref);
+        return ref;
+    }
+    const std::string& bytes() const { return pool_; }
+
+private:
+    std::string pool_;
+    std::unordered_map<std::string, Str> seen_;
+};
+
+template <typename Record>
+void appendRecord(std::string& out, const Record& record) {
+    out.append(reinterpret_cast<const char*>(&record), sizeof(Record));
+}
+
+// Bounds-checked view of the mapped file
+class ImageReader {
+public:
+    ImageReader(const char* data, const Header& header) : data_(data), header_(header) {}
+
+    template <typename Record>
+    Record record(uint64_t table_offset, size_t index) const {
+        Record out;
+        std::memcpy(&out, data_ + table_offset + index * sizeof(Record), sizeof(Record));
+        return out;
+    }
+
+    bool text(Str ref, std::string& out) const {
+        if (ref.offset > header_.pool_size || ref.length > header_.pool_size - ref.offset) return false;
+        out.assign(data_ + header_.pool_offset + ref.offset, ref.length);
+        return true;
+    }
+
+    bool text(Str ref, InternedString& out) const {
+        if (ref.offset > header_.pool_size || ref.length > header_.pool_size - ref.offset) return false;
+        out = InternedString(std::string_view(data_ + header_.pool_offset + ref.offset, ref.length));
+        return true;
+    }
+
+private:
+    const char* data_;
+    const Header& header_;
+};
+
+bool tableFits(uint64_t offset, uint64_t count, size_t record_size, uint64_t file_size) {
+    if (offset > file_size) return false;
+    return count <= (file_size - offset) / record_size;
+}
+
+struct Mapping {
+    void* data = MAP_FAILED;
+    size_t size = 0;
+    ~Mapping() {
+        if (data != MAP_FAILED) munmap(data, size);
+    }
+};
+
+} // namespace
+
+bool ReferenceSnapshotFile::save(const ReferenceSnapshot& snapshot, const std::string& path) {
+    PoolWriter pool;
+    std::string airports, waypoints, runways;
+    airports.reserve(snapshot.airports.size() * sizeof(AirportRecord));
+    waypoints.reserve(snapshot.waypoints.size() * sizeof(WaypointRecord));
+    runways.reserve(snapshot.runways.size() * sizeof(RunwayRecord));
+
+    for (const Airport& a : snapshot.airports) {
+        AirportRecord r;
+        std::memset(&r, 0, sizeof(r));
+        r.latitude = a.latitude;
+        r.longitude = a.longitude;
+        r.id = a.id;
+        r.elevation_ft = a.elevation_ft;
+        r.runway_count = a.runway_count;
+        r.longest_runway_ft = a.longest_runway_ft;
+        r.icao_code = pool.add(a.icao_code);
+        r.iata_code = pool.add(a.iata_code);
+        r.name = pool.add(a.name);
+        r.full_name = pool.add(a.full_name);
+        r.airport_type = pool.add(a.airport_type);
+        r.municipality = pool.add(a.municipality);
+        r.region = pool.add(a.region);
+        r.country_code = pool.add(a.country_code);
+        r.country_name = pool.add(a.country_name);
+        r.is_active = a.is_active;
+        r.has_tower = a.has_tower;
+        r.has_ils = a.has_ils;
+        appendRecord(airports, r);
+    }
+    for (const Waypoint& w : snapshot.waypoints) {
+        WaypointRecord r;
+        std::memset(&r, 0, sizeof(r));
+        r.latitude = w.latitude;
+        r.longitude = w.longitude;
+        r.id = w.id;
+        r.elevation_ft = w.elevation_ft;
+        r.waypoint_code = pool.add(w.waypoint_code);
+        r.name = pool.add(w.name);
+        r.waypoint_type = pool.add(w.waypoint_type);
+        r.country_code = pool.add(w.country_code);
+        r.country_name = pool.add(w.country_name);
+        r.region = pool.add(w.region);
+        r.frequency = pool.add(w.frequency);
+        r.usage_type = pool.add(w.usage_type);
+        r.is_active = w.is_active;
+        appendRecord(waypoints, r);
+    }
+    for (const AirportRunway& rw : snapshot.runways) {
+        RunwayRecord r;
+        std::memset(&r, 0, sizeof(r));
+        r.le_heading_deg = rw.le_heading_deg;
+        r.le_latitude = rw.le_latitude;
+        r.le_longitude = rw.le_longitude;
+        r.he_heading_deg = rw.he_heading_deg;
+        r.he_latitude = rw.he_latitude;
+        r.he_longitude = rw.he_longitude;
+        r.id = rw.id;
+        r.airport_id = rw.airport_id;
+        r.length_ft = rw.length_ft;
+        r.width_ft = rw.width_ft;
+        r.runway_identifier = pool.add(rw.runway_identifier);
+        r.surface_type = pool.add(rw.surface_type);
+        r.le_ident = pool.add(rw.le_ident);
+        r.he_ident = pool.add(rw.he_ident);
+        r.is_active = rw.is_active;
+        appendRecord(runways, r);
+    }
+
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.format_version = kFormatVersion;
+    header.byte_order = kByteOrderMark;
+    header.loaded_at_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                              snapshot.loaded_at.time_since_epoch()).count();
+    header.data_version = snapshot.version;
+    header.airport_count = snapshot.airports.size();
+    header.waypoint_count = snapshot.waypoints.size();
+    header.runway_count = snapshot.runways.size();
+    header.airports_offset = sizeof(Header);
+    header.waypoints_offset = header.airports_offset + airports.size();
+    header.runways_offset = header.waypoints_offset + waypoints.size();
+    header.pool_offset = header.runways_offset + runways.size();
+    header.pool_size = pool.bytes().size();
+
+    std::string body;
+    body.reserve(airports.size() + waypoints.size() + runways.size() + pool.bytes().size());
+    body += airports;
+    body += waypoints;
+    body += runways;
+    body += pool.bytes();
+    header.checksum = fnv1a(body.data(), body.size());
+
+    // Per process: prefork workers save the same file
+    std::string tmp_path = path + ".tmp." + std::to_string(::getpid());
+    {
+        std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(body.data(), static_cast<std::streamsize>(body.size()));
+        out.flush();
+        if (!out) {
+            spdlog::error("Reference snapshot: failed to write {}", tmp_path);
+            std::remove(tmp_path.c_str());
+            return false;
+        }
+    }
+    if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+        spdlog::error("Reference snapshot: failed to rename {} to {}: {}", tmp_path, path, std::strerror(errno));
+        std::remove(tmp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+std::shared_ptr<ReferenceSnapshot> ReferenceSnapshotFile::load(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        if (errno != ENOENT) spdlog::warn("Reference snapshot: cannot open {}: {}", path, std::strerror(errno));
+        return nullptr;
+    }
+    struct stat st;
+    Mapping mapping;
+    if (fstat(fd, &st) == 0 && st.st_size >= static_cast<off_t>(sizeof(Header))) {
+        mapping.size = static_cast<size_t>(st.st_size);
+        mapping.data = mmap(nullptr, mapping.size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    ::close(fd);
+    if (mapping.data == MAP_FAILED) {
+        spdlog::warn("Reference snapshot: cannot map {}", path);
+        return nullptr;
+    }
+    madvise(mapping.data, mapping.size, MADV_SEQUENTIAL);
+
+    const char* data = static_cast<const char*>(mapping.data);
+    Header header;
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.format_version != kFormatVersion ||
+        header.byte_order != kByteOrderMark) {
+        spdlog::warn("Reference snapshot: {} has an unknown format, ignoring it", path);
+        return nullptr;
+    }
+    const uint64_t size = mapping.size;
+    if (!tableFits(header.airports_offset, header.airport_count, sizeof(AirportRecord), size) ||
+        !tableFits(header.waypoints_offset, header.waypoint_count, sizeof(WaypointRecord), size) ||
+        !tableFits(header.runways_offset, header.runway_count, sizeof(RunwayRecord), size) ||
+        header.pool_offset > size || header.pool_size != size - header.pool_offset) {
+        spdlog::warn("Reference snapshot: {} is truncated, ignoring it", path);
+        return nullptr;
+    }
+    if (fnv1a(data + sizeof(Header), size - sizeof(Header)) != header.checksum) {
+        spdlog::warn("Reference snapshot: {} fails its checksum, ignoring it", path);
+        return nullptr;
+    }
+
+    auto snapshot = std::make_shared<ReferenceSnapshot>();
+    ImageReader image(data, header);
+    bool ok = true;
+
+    snapshot->airports.resize(header.airport_count);
+    for (size_t i = 0; i < header.airport_count && ok; i++) {
+        auto r = image.record<AirportRecord>(header.airports_offset, i);
+        Airport& a = snapshot->airports[i];
+        a.id = r.id;
+        a.latitude = r.latitude;
+        a.longitude = r.longitude;
+        a.elevation_ft = r.elevation_ft;
+        a.runway_count = r.runway_count;
+        a.longest_runway_ft = r.longest_runway_ft;
+        a.is_active = r.is_active;
+        a.has_tower = r.has_tower;
+        a.has_ils = r.has_ils;
+        ok = image.text(r.icao_code, a.icao_code) && image.text(r.iata_code, a.iata_code) &&
+             image.text(r.name, a.name) && image.text(r.full_name, a.full_name) &&
+             image.text(r.airport_type, a.airport_type) && image.text(r.municipality, a.municipality) &&
+             image.text(r.region, a.region) && image.text(r.country_code, a.country_code) &&
+             image.text(r.country_name, a.country_name);
+    }
+
+    snapshot->waypoints.resize(header.waypoint_count);
+    for (size_t i = 0; i < header.waypoint_count && ok; i++) {
+        auto r = image.record<WaypointRecord>(header.waypoints_offset, i);
+        Waypoint& w = snapshot->waypoints[i];
+        w.id = r.id;
+        w.latitude = r.latitude;
+        w.longitude = r.longitude;
+        w.elevation_ft = r.elevation_ft;
+        w.is_active = r.is_active;
+        ok = image.text(r.waypoint_code, w.waypoint_code) && image.text(r.name, w.name) &&
+             image.text(r.waypoint_type, w.waypoint_type) && image.text(r.country_code, w.country_code) &&
+             image.text(r.country_name, w.country_name) && image.text(r.region, w.region) &&
+             image.text(r.frequency, w.frequency) && image.text(r.usage_type, w.usage_type);
+    }
+
+    snapshot->runways.resize(header.runway_count);
+    for (size_t i = 0; i < header.runway_count && ok; i++) {
+        auto r = image.record<RunwayRecord>(header.runways_offset, i);
+        AirportRunway& rw = snapshot->runways[i];
+        rw.id = r.id;
+        rw.airport_id = r.airport_id;
+        rw.length_ft = r.length_ft;
+        rw.width_ft = r.width_ft;
+        rw.le_heading_deg = r.le_heading_deg;
+        rw.le_latitude = r.le_latitude;
+        rw.le_longitude = r.le_longitude;
+        rw.he_heading_deg = r.he_heading_deg;
+        rw.he_latitude = r.he_latitude;
+        rw.he_longitude = r.he_longitude;
+        rw.is_active = r.is_active;
+        ok = image.text(r.runway_identifier, rw.runway_identifier) && image.text(r.surface_type, rw.surface_type) &&
+             image.text(r.le_ident, rw.le_ident) && image.text(r.he_ident, rw.he_ident);
+    }
+
+    if (!ok) {
+        spdlog::warn("Reference snapshot: {} has a string outside its pool, ignoring it", path);
+        return nullptr;
+    }
+    snapshot->loaded_at = std::chrono::system_clock::time_point(
+        std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::microseconds(header.loaded_at_us)));
+    snapshot->version = header.data_version;
+    return snapshot;
+}
+
+} // namespace aeronautical
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+namespace aeronautical {
+
+struct ReferenceSnapshot;
+
+// On-disk image of a ReferenceSnapshot so a restart can serve reference
+// data before MySQL answers. The file is a header, fixed-size records per
+// table and one string pool; strings are (offset, length) into the pool, so
+// the image has no pointers and is read straight out of an mmap. Records are
+// host byte order; a file written by another version or byte order is
+// rejected rather than converted.
+class ReferenceSnapshotFile {
+public:
+    // Written to path + ".tmp.<pid>" and renamed over path; false on I/O error
+    static bool save(const ReferenceSnapshot& snapshot, const std::string& path);
+
+    // Tables only, without indexes; nullptr when missing, stale-format or corrupt
+    static std::shared_ptr<ReferenceSnapshot> load(const std::string& path);
+};
+
+} // namespace aeronautical
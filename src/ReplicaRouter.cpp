@@ -0,0 +1,181 @@
+#include "ReplicaRouter.h"
+#include "MysqlResult.h"
+#include <spdlog/spdlog.h>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+namespace aeronautical {
+
+ReplicaRouter::ReplicaRouter(const std::string& user, const std::string& password, const std::string& database,
+                             const ReplicaSettings& settings, const PoolSettings& pool_settings)
+    : settings_(settings) {
+    for (const auto& endpoint : settings_.endpoints) {
+        auto replica = std::make_unique<Replica>();
+        replica->endpoint = endpoint;
+        replica->pool = std::make_unique<ConnectionPool>(endpoint.host, endpoint.port, user, password, database,
+                                                         pool_settings);
+        replicas_.push_back(std::move(replica));
+    }
+
+    // Replicas serve nothing until their first check passed
+    for (auto& replica : replicas_) {
+        check(*replica);
+    }
+    monitor_thread_ = std::thread([this]() { monitorLoop(); });
+}
+
+ReplicaRouter::~ReplicaRouter() {
+    shutdown();
+}
+
+std::vector<ReplicaEndpoint> ReplicaRouter::parseEndpoints(const std::string& list, int default_port) {
+    std::vector<ReplicaEndpoint> endpoints;
+    size_t start = 0;
+    while (start <= list.size()) {
+        size_t end = list.find(',', start);
+        if (end == std::string::npos) end = list.size();
+        std::string item = list.substr(start, end - start);
+        while (!item.empty() && item.front() == ' ') item.erase(item.begin());
+        while (!item.empty() && item.back() == ' ') item.pop_back();
+        if (!item.empty()) {
+            ReplicaEndpoint endpoint;
+            const size_t colon = item.rfind(':');
+            if (colon != std::string::npos) {
+                endpoint.host = item.substr(0, colon);
+                endpoint.port = std::atoi(item.c_str() + colon + 1);
+            } else {
+                endpoint.host = item;
+                endpoint.port = default_port;
+            }
+            if (endpoint.host.empty() || endpoint.port <= 0) {
+                throw std::invalid_argument("Invalid replica endpoint '" + item + "'");
+            }
+            endpoints.push_back(std::move(endpoint));
+        }
+        start = end + 1;
+    }
+    return endpoints;
+}
+
+ConnectionPool::Lease ReplicaRouter::acquire() {
+    const size_t count = replicas_.size();
+    const size_t first = next_.fetch_add(1, std::memory_order_relaxed);
+    for (size_t i = 0; i < count; i++) {
+        Replica& replica = *replicas_[(first + i) % count];
+        if (!replica.healthy.load(std::memory_order_relaxed)) continue;
+        try {
+            auto lease = replica.pool->acquire();
+            replica.reads.fetch_add(1, std::memory_order_relaxed);
+            return lease;
+        } catch (const std::exception& e) {
+            // Saturated or unreachable; the next check decides whether it comes back
+            replica.healthy.store(false, std::memory_order_relaxed);
+            spdlog::warn("Replica {}:{} taken out of rotation: {}", replica.endpoint.host, replica.endpoint.port,
+                         e.what());
+        }
+    }
+    primary_fallbacks_.fetch_add(1, std::memory_order_relaxed);
+    return {};
+}
+
+void ReplicaRouter::check(Replica& replica) {
+    bool healthy = false;
+    int64_t lag = -1;
+    try {
+        auto lease = replica.pool->acquire();
+        MYSQL* mysql = lease.get();
+        // SHOW SLAVE STATUS on servers older than 8.0.22
+        if (mysql_query(mysql, "SHOW REPLICA STATUS") != 0 && mysql_query(mysql, "SHOW SLAVE STATUS") != 0) {
+            throw std::runtime_error(mysql_error(mysql));
+        }
+        MysqlResult result(mysql_store_result(mysql));
+        if (!result) {
+            throw std::runtime_error(mysql_error(mysql));
+        }
+        MYSQL_ROW row = mysql_fetch_row(result.get());
+        if (!row) {
+            // Not replicating at all, e.g. a read endpoint behind a proxy
+            healthy = true;
+            lag = 0;
+        } else {
+            MYSQL_FIELD* fields = mysql_fetch_fields(result.get());
+            const unsigned int field_count = mysql_num_fields(result.get());
+            for (unsigned int i = 0; i < field_count; i++) {
+                if (std::strcmp(fields[i].name, "Seconds_Behind_Source") == 0 ||
+                    std::strcmp(fields[i].name, "Seconds_Behind_Master") == 0) {
+                    // NULL while the SQL thread is stopped
+                    if (row[i]) {
+                        lag = std::atoll(row[i]);
+                        healthy = lag <= settings_.max_lag.count();
+                    }
+                    break;
+                }
+            }
+        }
+    } catch (const std::exception& e) {
+        spdlog::debug("Replica {}:{} check failed: {}", replica.endpoint.host, replica.endpoint.port, e.what());
+    }
+
+    replica.lag_s.store(lag, std::memory_order_relaxed);
+    const bool was_healthy = replica.healthy.exchange(healthy, std::memory_order_relaxed);
+    if (was_healthy != healthy) {
+        spdlog::info("Replica {}:{} {} (lag {} s)", replica.endpoint.host, replica.endpoint.port,
+                     healthy ? "serving reads" : "out of rotation", lag);
+    }
+}
+
+void ReplicaRouter::monitorLoop() {
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait_for(lock, settings_.check_interval, [this]() { return stopping_; });
+            if (stopping_) {
+                return;
+            }
+        }
+        for (auto& replica : replicas_) {
+            check(*replica);
+        }
+    }
+}
+
+void ReplicaRouter::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) {
+            return;
+        }
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    if (monitor_thread_.joinable()) {
+        monitor_thread_.join();
+    }
+    for (auto& replica : replicas_) {
+        replica->healthy.store(false, std::memory_order_relaxed);
+        replica->pool->shutdown();
+    }
+}
+
+nlohmann::json ReplicaRouter::status() const {
+    nlohmann::json replicas = nlohmann::json::array();
+    for (const auto& replica : replicas_) {
+        nlohmann::json j;
+        j["host"] = replica->endpoint.host;
+        j["port"] = replica->endpoint.port;
+        j["healthy"] = replica->healthy.load(std::memory_order_relaxed);
+        const int64_t lag = replica->lag_s.load(std::memory_order_relaxed);
+        j["lag_s"] = lag >= 0 ? nlohmann::json(lag) : nlohmann::json(nullptr);
+        j["reads"] = replica->reads.load(std::memory_order_relaxed);
+        j["pool"] = replica->pool->metrics().toJson();
+        replicas.push_back(std::move(j));
+    }
+    nlohmann::json j;
+    j["replicas"] = std::move(replicas);
+    j["max_lag_s"] = settings_.max_lag.count();
+    j["primary_fallbacks"] = primary_fallbacks_.load(std::memory_order_relaxed);
+    return j;
+}
+
+} // namespace aeronautical
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "ConnectionPool.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <json.hpp>
+
+namespace aeronautical {
+
+struct ReplicaEndpoint {
+    std::string host;
+    int port = 3306;
+};
+
+struct ReplicaSettings {
+    std::vector<ReplicaEndpoint> endpoints;
+    std::chrono::seconds max_lag{5};        // replicas further behind serve no reads
+    std::chrono::seconds check_interval{5}; // how often lag is read
+};
+
+// Read-only MySQL replicas next to the primary pool, one ConnectionPool
+// each. A monitor thread reads every replica's lag (SHOW REPLICA STATUS)
+// each check_interval; a replica that is unreachable, has replication
+// stopped or lags more than max_lag takes no reads until a later check
+// passes. acquire() spreads leases round-robin over the healthy ones.
+class ReplicaRouter {
+public:
+    ReplicaRouter(const std::string& user, const std::string& password, const std::string& database,
+                  const ReplicaSettings& settings, const PoolSettings& pool_settings);
+    ~ReplicaRouter();
+
+    ReplicaRouter(const ReplicaRouter&) = delete;
+    ReplicaRouter& operator=(const ReplicaRouter&) = delete;
+
+    // Lease on a healthy replica; an empty lease when there is none, so
+    // the caller falls back to the primary
+    ConnectionPool::Lease acquire();
+
+    // How long a client's reads stay on the primary after it wrote: a
+    // replica judged healthy may be up to max_lag behind, plus the time
+    // until the next check notices it fell further
+    std::chrono::steady_clock::duration readYourWritesWindow() const {
+        return settings_.max_lag + settings_.check_interval;
+    }
+
+    void shutdown();
+    nlohmann::json status() const;
+
+    // "host:port,host:port"; port defaults to default_port
+    static std::vector<ReplicaEndpoint> parseEndpoints(const std::string& list, int default_port);
+
+private:
+    struct Replica {
+        ReplicaEndpoint endpoint;
+        std::unique_ptr<ConnectionPool> pool;
+        std::atomic<bool> healthy{false};
+        std::atomic<int64_t> lag_s{-1}; // -1 unknown
+        std::atomic<uint64_t> reads{0};
+    };
+
+    void monitorLoop();
+    void check(Replica& replica);
+
+    ReplicaSettings settings_;
+    std::vector<std::unique_ptr<Replica>> replicas_;
+    std::atomic<size_t> next_{0};
+    std::atomic<uint64_t> primary_fallbacks_{0};
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stopping_ = false;
+    std::thread monitor_thread_;
+};
+
+} // namespace aeronautical
@@ -0,0 +1,116 @@
+#include "RequestAccounting.h"
+#include <cstddef>
+#include <cstdlib>
+#include <ctime>
+#include <new>
+#include <utility>
+
+namespace aeronautical {
+
+namespace {
+
+// Plain thread-locals, constant-initialized, so operator new can touch
+// them on any thread at any time without an initialization guard
+thread_local uint64_t thread_alloc_bytes = 0;
+thread_local uint64_t thread_allocations = 0;
+
+struct Segment {
+    std::shared_ptr<RequestAccounting::Tally> tally;
+    RequestAccounting::Usage start;
+};
+thread_local Segment segment;
+
+uint64_t threadCpuNs() {
+    timespec ts{};
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) return 0;
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000u + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+void* allocate(std::size_t size, std::size_t alignment) {
+    if (size == 0) size = 1;
+    // aligned_alloc wants a multiple of the alignment
+    if (alignment > alignof(std::max_align_t)) size = (size + alignment - 1) / alignment * alignment;
+    for (;;) {
+        void* p = alignment > alignof(std::max_align_t) ? std::aligned_alloc(alignment, size) : std::malloc(size);
+        if (p) {
+            thread_alloc_bytes += size;
+            thread_allocations++;
+            return p;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) throw std::bad_alloc();
+        handler();
+    }
+}
+
+} // namespace
+
+void RequestAccounting::Tally::add(const Usage& usage) {
+    alloc_bytes.fetch_add(usage.alloc_bytes, std::memory_order_relaxed);
+    allocations.fetch_add(usage.allocations, std::memory_order_relaxed);
+    cpu_ns.fetch_add(usage.cpu_ns, std::memory_order_relaxed);
+}
+
+RequestAccounting::Usage RequestAccounting::Tally::read() const {
+    return {alloc_bytes.load(std::memory_order_relaxed), allocations.load(std::memory_order_relaxed),
+            cpu_ns.load(std::memory_order_relaxed)};
+}
+
+RequestAccounting::Usage RequestAccounting::threadUsage() {
+    return {thread_alloc_bytes, thread_allocations, threadCpuNs()};
+}
+
+const std::shared_ptr<RequestAccounting::Tally>& RequestAccounting::current() {
+    return segment.tally;
+}
+
+void RequestAccounting::begin(std::shared_ptr<Tally> tally) {
+    end();
+    if (!tally) return;
+    segment.tally = std::move(tally);
+    segment.start = threadUsage();
+}
+
+std::shared_ptr<RequestAccounting::Tally> RequestAccounting::end(const Tally* only) {
+    if (!segment.tally || (only && segment.tally.get() != only)) return nullptr;
+    const Usage now = threadUsage();
+    segment.tally->add({now.alloc_bytes - segment.start.alloc_bytes, now.allocations - segment.start.allocations,
+                        now.cpu_ns - segment.start.cpu_ns});
+    return std::exchange(segment.tally, nullptr);
+}
+
+RequestAccounting::Scope::Scope(std::shared_ptr<Tally> tally) {
+    if (!tally || tally == segment.tally) return;
+    previous_ = end();
+    begin(std::move(tally));
+    active_ = true;
+}
+
+RequestAccounting::Scope::~Scope() {
+    if (!active_) return;
+    end();
+    if (previous_) begin(std::move(previous_));
+}
+
+} // namespace aeronautical
+
+// The replaceable allocation functions; the array and nothrow forms of
+// libstdc++ forward to these
+void* operator new(std::size_t size) {
+    return aeronautical::allocate(size, 0);
+}
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    return aeronautical::allocate(size, static_cast<std::size_t>(alignment));
+}
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+void operator delete(void* p, std::align_val_t) noexcept {
+    std::free(p);
+}
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept {
+    std::free(p);
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace aeronautical {
+
+// What a request costs its threads: bytes and number of allocations made
+// through operator new (replaced in RequestAccounting.cpp to count them in
+// thread-local counters) and CPU time from CLOCK_THREAD_CPUTIME_ID. A
+// request owns a Tally; each thread working for it opens a segment on it
+// and adds the difference of its own counters when the segment closes, so
+// the work a request hands to the DB threads is charged to it as well.
+// malloc calls made by C libraries (GDAL, the MySQL client) bypass
+// operator new and are not counted; their CPU time is.
+class RequestAccounting {
+public:
+    struct Usage {
+        uint64_t alloc_bytes = 0;
+        uint64_t allocations = 0;
+        uint64_t cpu_ns = 0;
+    };
+
+    struct Tally {
+        std::atomic<uint64_t> alloc_bytes{0};
+        std::atomic<uint64_t> allocations{0};
+        std::atomic<uint64_t> cpu_ns{0};
+
+        void add(const Usage& usage);
+        Usage read() const;
+    };
+
+    // Totals of the calling thread since it started
+    static Usage threadUsage();
+
+    // Tally of the calling thread's open segment, if any
+    static const std::shared_ptr<Tally>& current();
+    // Opens a segment on tally, closing the one open before
+    static void begin(std::shared_ptr<Tally> tally);
+    // Closes the open segment and returns its tally; with only set, does
+    // nothing and returns null unless the segment belongs to that tally
+    static std::shared_ptr<Tally> end(const Tally* only = nullptr);
+
+    // Charges the calling thread to tally for its lifetime, then resumes
+    // the segment it interrupted. Does nothing for a null tally or the one
+    // already open.
+    class Scope {
+    public:
+        explicit Scope(std::shared_ptr<Tally> tally);
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        bool active_ = false;
+        std::shared_ptr<Tally> previous_;
+    };
+};
+
+} // namespace aeronautical
@@ -0,0 +1,44 @@
+#include "RequestMetrics.h"
+#include "MemoryArenas.h"
+#include "Metrics.h"
+#include <spdlog/spdlog.h>
+
+namespace aeronautical {
+
+void RequestMetrics::configure(const RequestAccountingSettings& settings) {
+    settings_ = settings;
+}
+
+void RequestMetrics::before_handle(crow::request& req, crow::response&, context& ctx) {
+    // Crow's workers have no start hook, so each binds on its first request
+    static thread_local const bool bound = (MemoryArenas::getInstance().bindCurrentThread("http"), true);
+    (void)bound;
+    ctx.started = std::chrono::steady_clock::now();
+    ctx.route = Metrics::getInstance().routeSlot(crow::method_name(req.method), req.url);
+    Metrics::getInstance().requestStarted();
+    if (settings_.enabled) {
+        ctx.tally = std::make_shared<RequestAccounting::Tally>();
+        RequestAccounting::begin(ctx.tally);
+    }
+}
+
+void RequestMetrics::after_handle(crow::request& req, crow::response& res, context& ctx) {
+    const auto elapsed = std::chrono::steady_clock::now() - ctx.started;
+    Metrics::getInstance().requestFinished(ctx.route, res.code, elapsed);
+    if (!ctx.tally) return;
+
+    // A no-op when DbExecutor has already moved the segment off this thread
+    RequestAccounting::end(ctx.tally.get());
+    const RequestAccounting::Usage usage = ctx.tally->read();
+    const std::chrono::nanoseconds cpu(usage.cpu_ns);
+    Metrics::getInstance().requestCost(ctx.route, usage.alloc_bytes, usage.allocations, cpu);
+    if ((settings_.log_alloc_bytes && usage.alloc_bytes >= settings_.log_alloc_bytes) ||
+        (settings_.log_cpu.count() && cpu >= settings_.log_cpu)) {
+        spdlog::warn("Costly request {} {}: {:.1f} MB in {} allocations, {:.1f} ms CPU, {:.1f} ms total",
+                     crow::method_name(req.method), req.url, static_cast<double>(usage.alloc_bytes) / (1 << 20),
+                     usage.allocations, std::chrono::duration<double, std::milli>(cpu).count(),
+                     std::chrono::duration<double, std::milli>(elapsed).count());
+    }
+}
+
+} // namespace aeronautical
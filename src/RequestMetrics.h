@@ -0,0 +1,43 @@
+#pragma once
+
+#include "RequestAccounting.h"
+#include <crow.h>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+namespace aeronautical {
+
+struct RequestAccountingSettings {
+    bool enabled = false;
+    // Requests over either bound are logged with their cost; 0 disables a bound
+    uint64_t log_alloc_bytes = 64u << 20;
+    std::chrono::milliseconds log_cpu{500};
+};
+
+// Crow middleware feeding Metrics: counts each request in flight from
+// before_handle, and on completion its status class and latency under
+// its route. Listed ahead of the encoding middlewares in HttpApp, so the
+// latency includes encoding and compression of the body; for
+// handlers answering from DbExecutor it ends when the response does.
+// With accounting enabled it also charges the request's allocations and
+// CPU time (see RequestAccounting), on the Crow thread and on the DB
+// threads DbExecutor hands it to, to its route.
+class RequestMetrics {
+public:
+    struct context {
+        std::chrono::steady_clock::time_point started;
+        uint16_t route = 0;
+        std::shared_ptr<RequestAccounting::Tally> tally;
+    };
+
+    void configure(const RequestAccountingSettings& settings);
+
+    void before_handle(crow::request& req, crow::response& res, context& ctx);
+    void after_handle(crow::request& req, crow::response& res, context& ctx);
+
+private:
+    RequestAccountingSettings settings_;
+};
+
+} // namespace aeronautical
@@ -0,0 +1,30 @@
+#include "RequestTracing.h"
+#include "Metrics.h"
+
+namespace aeronautical {
+
+void RequestTracing::before_handle(crow::request& req, crow::response&, context& ctx) {
+    ctx.trace = Tracer::getInstance().startTrace(req.get_header_value("traceparent"), ctx.parent_span_id);
+    ctx.started = std::chrono::system_clock::now();
+    Tracer::setCurrent(ctx.trace);
+}
+
+void RequestTracing::after_handle(crow::request& req, crow::response& res, context& ctx) {
+    res.set_header("X-Trace-Id", ctx.trace.traceIdHex());
+    if (ctx.trace.sampled) {
+        const std::string method = crow::method_name(req.method);
+        const std::string route = Metrics::foldPath(req.url);
+        Tracer::getInstance().exportSpan(ctx.trace, ctx.parent_span_id, method + " " + route, ctx.started,
+                                         std::chrono::system_clock::now(),
+                                         {{"http.request.method", method},
+                                          {"http.route", route},
+                                          {"url.path", req.url},
+                                          {"http.response.status_code", std::to_string(res.code)}},
+                                         res.code >= 500, "", true);
+    }
+    // Handlers answering from DbExecutor finish here later, while this
+    // thread already serves other requests; none of them may inherit it
+    Tracer::setCurrent(TraceContext{});
+}
+
+} // namespace aeronautical
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <crow.h>
+#include <chrono>
+#include <cstdint>
+#include "Tracing.h"
+
+namespace aeronautical {
+
+// Crow middleware opening the server span of each request. It continues
+// the client's trace when a W3C traceparent header comes in, else starts
+// one sampled at the configured rate; either way the context is current
+// while the handler runs (for child spans and the [trace=...] log field)
+// and its trace id goes back in X-Trace-Id. Listed first in HttpApp, so
+// the span covers every other middleware.
+class RequestTracing {
+public:
+    struct context {
+        TraceContext trace;
+        uint64_t parent_span_id = 0;
+        std::chrono::system_clock::time_point started;
+    };
+
+    void before_handle(crow::request& req, crow::response& res, context& ctx);
+    void after_handle(crow::request& req, crow::response& res, context& ctx);
+};
+
+} // namespace aeronautical
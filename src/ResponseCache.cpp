@@ -0,0 +1,194 @@
+#include "ResponseCache.h"
+#include "BinaryFormat.h"
+#include "ConditionalGet.h"
+#include "DbExecutor.h"
+#include "ReferenceDataStore.h"
+#include "ResponseCompression.h"
+#include "ResultCache.h"
+#include <algorithm>
+
+namespace aeronautical {
+
+ResponseCache::ResponseCache() {
+    settings_.publish(std::make_shared<const ResponseCacheSettings>());
+}
+
+void ResponseCache::configure(const ResponseCacheSettings& settings) {
+    settings_.publish(std::make_shared<const ResponseCacheSettings>(settings));
+    clear();
+}
+
+bool ResponseCache::cacheable(const std::string& path, const ResponseCacheSettings& settings) {
+    for (const auto& prefix : settings.prefixes) {
+        if (path.rfind(prefix, 0) == 0) return true;
+    }
+    return false;
+}
+
+std::string ResponseCache::makeKey(const crow::request& req, const std::string& path) {
+    std::string key = path;
+    const size_t query_at = req.raw_url.find('?');
+    if (query_at != std::string::npos) {
+        // Parameter order does not change the answer
+        std::vector<std::string> params;
+        size_t start = query_at + 1;
+        while (start <= req.raw_url.size()) {
+            size_t end = req.raw_url.find('&', start);
+            if (end == std::string::npos) end = req.raw_url.size();
+            if (end > start) params.emplace_back(req.raw_url, start, end - start);
+            start = end + 1;
+        }
+        std::sort(params.begin(), params.end());
+        for (size_t i = 0; i < params.size(); i++) {
+            key += i == 0 ? '?' : '&';
+            key += params[i];
+        }
+    }
+    // The representation the response middlewares will pick, not the raw headers
+    key += ' ';
+    key += BinaryFormat::contentType(BinaryFormat::negotiate(req.get_header_value("Accept")));
+    key += ' ';
+    key += ResponseCompression::name(ResponseCompression::negotiate(req.get_header_value("Accept-Encoding")));
+    return key;
+}
+
+uint64_t ResponseCache::referenceVersion() {
+    auto snapshot = ReferenceDataStore::getInstance().snapshot();
+    return snapshot ? snapshot->version : 0;
+}
+
+void ResponseCache::before_handle(crow::request& req, crow::response& res, context& ctx) {
+    DbExecutor::shareNext({});
+    const auto settings = settings_.load();
+    if (!settings->enabled || settings->max_bytes == 0 || req.method != crow::HTTPMethod::GET) return;
+    const std::string path = req.url.substr(0, req.url.find('?'));
+    if (!cacheable(path, *settings)) return;
+
+    std::string key = makeKey(req, path);
+    const uint64_t epoch = ResultCache::getInstance().epoch();
+    const uint64_t reference_version = referenceVersion();
+    bool hit = false;
+    {
+        std::lock_guard lock(mutex_);
+        auto it = index_.find(key);
+        if (it != index_.end()) {
+            Entry& entry = *it->second;
+            if (entry.epoch == epoch && entry.reference_version == reference_version &&
+                entry.expires > std::chrono::steady_clock::now()) {
+                lru_.splice(lru_.begin(), lru_, it->second);
+                hits_.fetch_add(1, std::memory_order_relaxed);
+                hit = true;
+                res.code = entry.code;
+                for (const auto& [name, value] : entry.headers) {
+                    res.add_header(name, value);
+                }
+                res.body = *entry.body;
+            } else {
+                stale_.fetch_add(1, std::memory_order_relaxed);
+                erase(it->second);
+            }
+        }
+    }
+    if (hit) {
+        // A client already holding this body only needs to hear so
+        const std::string etag = crow::get_header_value(res.headers, "ETag");
+        if (!etag.empty() && ConditionalGet::isCurrent(req, CacheValidator{etag, std::nullopt})) {
+            res = ConditionalGet::notModified(CacheValidator{etag, std::nullopt});
+        }
+        res.add_header("X-Response-Cache", "hit");
+        res.end();
+        return;
+    }
+    misses_.fetch_add(1, std::memory_order_relaxed);
+
+    // Identical requests, conditional headers included, may share one handler run
+    DbExecutor::shareNext(key + ' ' + req.get_header_value("If-None-Match") + ' ' +
+                          req.get_header_value("If-Modified-Since"));
+    ctx.key = std::move(key);
+    ctx.epoch = epoch;
+    ctx.reference_version = reference_version;
+}
+
+void ResponseCache::after_handle(crow::request&, crow::response& res, context& ctx) {
+    if (ctx.key.empty() || res.code != 200 || res.is_static_type()) return;
+    const std::string& cache_control = crow::get_header_value(res.headers, "Cache-Control");
+    if (cache_control.find("no-store") != std::string::npos || cache_control.find("private") != std::string::npos) {
+        return;
+    }
+
+    const auto settings = settings_.load();
+    Entry entry;
+    entry.key = ctx.key;
+    entry.code = res.code;
+    entry.size = ctx.key.size() + res.body.size();
+    for (const auto& [name, value] : res.headers) {
+        entry.headers.emplace_back(name, value);
+        entry.size += name.size() + value.size();
+    }
+    entry.body = std::make_shared<const std::string>(res.body);
+    entry.epoch = ctx.epoch;
+    entry.reference_version = ctx.reference_version;
+    entry.expires = std::chrono::steady_clock::now() + settings->ttl;
+
+    std::lock_guard lock(mutex_);
+    // One body should not flush the whole cache
+    if (entry.size > settings->max_bytes / 4 || ResultCache::getInstance().epoch() != ctx.epoch) return;
+    if (auto it = index_.find(entry.key); it != index_.end()) erase(it->second);
+    size_ += entry.size;
+    lru_.push_front(std::move(entry));
+    index_[lru_.front().key] = lru_.begin();
+    stored_.fetch_add(1, std::memory_order_relaxed);
+    while (size_ > settings->max_bytes && !lru_.empty()) {
+        erase(std::prev(lru_.end()));
+        evicted_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void ResponseCache::erase(List::iterator it) {
+    size_ -= it->size;
+    index_.erase(it->key);
+    lru_.erase(it);
+}
+
+void ResponseCache::clear() {
+    std::lock_guard lock(mutex_);
+    lru_.clear();
+    index_.clear();
+    size_ = 0;
+}
+
+size_t ResponseCache::bytes() const {
+    std::lock_guard lock(mutex_);
+    return size_;
+}
+
+size_t ResponseCache::trim(size_t target) {
+    std::lock_guard lock(mutex_);
+    const size_t before = size_;
+    while (size_ > target && !lru_.empty()) {
+        erase(std::prev(lru_.end()));
+        evicted_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return before - size_;
+}
+
+nlohmann::json ResponseCache::stats() const {
+    const auto settings = settings_.load();
+    nlohmann::json j;
+    j["enabled"] = settings->enabled;
+    j["ttl_s"] = settings->ttl.count();
+    j["max_bytes"] = settings->max_bytes;
+    {
+        std::lock_guard lock(mutex_);
+        j["entries"] = lru_.size();
+        j["bytes"] = size_;
+    }
+    j["hits"] = hits();
+    j["misses"] = misses();
+    j["stale"] = stale_.load(std::memory_order_relaxed);
+    j["stored"] = stored_.load(std::memory_order_relaxed);
+    j["evicted"] = evicted_.load(std::memory_order_relaxed);
+    return j;
+}
+
+} // namespace aeronautical
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <crow.h>
+#include "SnapshotPublisher.h"
+#include "LockStats.h"
+#include <json.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace aeronautical {
+
+struct ResponseCacheSettings {
+    bool enabled = true;
+    size_t max_bytes = 64u << 20;
+    std::chrono::seconds ttl{30};
+    // GET routes cached, by path prefix
+    std::vector<std::string> prefixes{"/api/airports", "/api/waypoints", "/api/procedures"};
+};
+
+// Crow middleware keeping whole 200 responses of hot reference GETs as
+// they leave the server: already encoded by BinaryFormat and compressed
+// by ResponseCompression, so a hit costs a lookup and no serialization.
+// The key is the path, the query string with its parameters sorted, and
+// the representation negotiated from Accept and Accept-Encoding. An entry
+// is served until its TTL, a write (ResultCache's epoch moves) or a new
+// reference snapshot, whichever comes first. A miss asks DbExecutor to
+// share the work of an identical request already running, so a burst of
+// misses after a flush runs the handler once.
+// It must run outside the response middlewares, i.e. be listed before
+// ReadRouting in HttpApp.
+class ResponseCache {
+public:
+    struct context {
+        std::string key; // set when the response is to be stored
+        uint64_t epoch = 0;
+        uint64_t reference_version = 0;
+    };
+
+    ResponseCache();
+
+    // Drops what is cached; the new settings apply from the next request
+    void configure(const ResponseCacheSettings& settings);
+
+    void before_handle(crow::request& req, crow::response& res, context& ctx);
+    void after_handle(crow::request& req, crow::response& res, context& ctx);
+
+    void clear();
+
+    uint64_t hits() const { return hits_.load(std::memory_order_relaxed); }
+    uint64_t misses() const { return misses_.load(std::memory_order_relaxed); }
+    size_t bytes() const;
+    // Drops least recent responses until at most target bytes are held;
+    // returns the bytes dropped
+    size_t trim(size_t target);
+    nlohmann::json stats() const;
+
+private:
+    struct Entry {
+        std::string key;
+        int code = 200;
+        std::vector<std::pair<std::string, std::string>> headers;
+        std::shared_ptr<const std::string> body;
+        uint64_t epoch = 0;
+        uint64_t reference_version = 0;
+        std::chrono::steady_clock::time_point expires;
+        size_t size = 0;
+    };
+    // Front is most recent
+    using List = std::list<Entry>;
+
+    static bool cacheable(const std::string& path, const ResponseCacheSettings& settings);
+    static std::string makeKey(const crow::request& req, const std::string& path);
+    static uint64_t referenceVersion();
+    void erase(List::iterator it); // caller holds mutex_
+
+    SnapshotPublisher<ResponseCacheSettings> settings_;
+    mutable InstrumentedMutex<std::mutex> mutex_{"response_cache"};
+    List lru_;
+    std::unordered_map<std::string, List::iterator> index_;
+    size_t size_ = 0;
+
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+    std::atomic<uint64_t> stale_{0};
+    std::atomic<uint64_t> stored_{0};
+    std::atomic<uint64_t> evicted_{0};
+};
+
+} // namespace aeronautical
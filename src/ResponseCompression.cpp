@@ -0,0 +1,203 @@
+#include "ResponseCompression.h"
+#include <zlib.h>
+#ifdef HAVE_BROTLI
+#include <brotli/encode.h>
+#endif
+#include <algorithm>
+#include <cstdlib>
+
+namespace aeronautical {
+
+namespace {
+
+char asciiLower(char c) { return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c; }
+
+std::string_view trim(std::string_view text) {
+    while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) text.remove_prefix(1);
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\t')) text.remove_suffix(1);
+    return text;
+}
+
+bool equalsLower(std::string_view text, std::string_view lower) {
+    if (text.size() != lower.size()) return false;
+    for (size_t i = 0; i < text.size(); i++) {
+        if (asciiLower(text[i]) != lower[i]) return false;
+    }
+    return true;
+}
+
+std::string zlibCompress(std::string_view body, int window_bits, int level) {
+    z_stream stream{};
+    if (deflateInit2(&stream, std::clamp(level, 1, 9), Z_DEFLATED, window_bits, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return {};
+    }
+    std::string out(deflateBound(&stream, static_cast<uLong>(body.size())) + 32, '\0');
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(body.data()));
+    stream.avail_in = static_cast<uInt>(body.size());
+    stream.next_out = reinterpret_cast<Bytef*>(out.data());
+    stream.avail_out = static_cast<uInt>(out.size());
+    int code = deflate(&stream, Z_FINISH);
+    out.resize(stream.total_out);
+    deflateEnd(&stream);
+    return code == Z_STREAM_END ? out : std::string{};
+}
+
+} // namespace
+
+void ResponseCompression::configure(const CompressionSettings& settings) {
+    settings_ = settings;
+    cache_.setCapacity(settings.cache_bytes);
+}
+
+ResponseCompression::Encoding ResponseCompression::negotiate(std::string_view accept_encoding) {
+    // q-values per coding; "*" covers codings not named
+    double q_br = -1, q_gzip = -1, q_deflate = -1, q_any = -1;
+    while (!accept_encoding.empty()) {
+        size_t comma = accept_encoding.find(',');
+        std::string_view item = trim(accept_encoding.substr(0, comma));
+        accept_encoding = comma == std::string_view::npos ? std::string_view{} : accept_encoding.substr(comma + 1);
+
+        double q = 1.0;
+        size_t semi = item.find(';');
+        std::string_view coding = trim(item.substr(0, semi));
+        if (semi != std::string_view::npos) {
+            std::string_view params = trim(item.substr(semi + 1));
+            if (params.size() > 2 && asciiLower(params[0]) == 'q' && params[1] == '=') {
+                q = std::strtod(std::string(params.substr(2)).c_str(), nullptr);
+            }
+        }
+        if (equalsLower(coding, "br")) q_br = q;
+        else if (equalsLower(coding, "gzip") || equalsLower(coding, "x-gzip")) q_gzip = q;
+        else if (equalsLower(coding, "deflate")) q_deflate = q;
+        else if (coding == "*") q_any = q;
+    }
+    if (q_br < 0) q_br = q_any;
+    if (q_gzip < 0) q_gzip = q_any;
+    if (q_deflate < 0) q_deflate = q_any;
+
+    // Server preference breaks ties; a higher client q-value wins otherwise
+    Encoding best = Encoding::Identity;
+    double best_q = 0.0;
+    auto consider = [&](Encoding encoding, double q) {
+        if (q > best_q) {
+            best = encoding;
+            best_q = q;
+        }
+    };
+    if (brotliAvailable()) consider(Encoding::Brotli, q_br);
+    consider(Encoding::Gzip, q_gzip);
+    consider(Encoding::Deflate, q_deflate);
+    return best;
+}
+
+std::string ResponseCompression::compress(std::string_view body, Encoding encoding, int level) {
+    switch (encoding) {
+        case Encoding::Gzip:
+            return zlibCompress(body, 15 | 16, level);
+        case Encoding::Deflate:
+            // HTTP "deflate" is the zlib format, not raw deflate
+            return zlibCompress(body, 15, level);
+        case Encoding::Brotli: {
+#ifdef HAVE_BROTLI
+            size_t size = BrotliEncoderMaxCompressedSize(body.size());
+            std::string out(size ? size : body.size() + 1024, '\0');
+            int quality = std::clamp(level * 11 / 9, 1, 11);
+            if (BrotliEncoderCompress(quality, BROTLI_DEFAULT_WINDOW, BROTLI_MODE_TEXT, body.size(),
+                                      reinterpret_cast<const uint8_t*>(body.data()), &size,
+                                      reinterpret_cast<uint8_t*>(out.data())) == BROTLI_TRUE) {
+                out.resize(size);
+                return out;
+            }
+#endif
+            return {};
+        }
+        default:
+            return {};
+    }
+}
+
+const char* ResponseCompression::name(Encoding encoding) {
+    switch (encoding) {
+        case Encoding::Brotli: return "br";
+        case Encoding::Gzip: return "gzip";
+        case Encoding::Deflate: return "deflate";
+        default: return "identity";
+    }
+}
+
+bool ResponseCompression::brotliAvailable() {
+#ifdef HAVE_BROTLI
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool ResponseCompression::compressibleType(std::string_view content_type) {
+    // Handlers that set no type send JSON
+    if (content_type.empty()) return true;
+    std::string lower(content_type);
+    std::transform(lower.begin(), lower.end(), lower.begin(), asciiLower);
+    return lower.rfind("text/", 0) == 0 || lower.find("json") != std::string::npos ||
+           lower.find("javascript") != std::string::npos || lower.find("xml") != std::string::npos ||
+           lower.find("vnd.mapbox-vector-tile") != std::string::npos || lower.find("cbor") != std::string::npos ||
+           lower.find("msgpack") != std::string::npos;
+}
+
+void ResponseCompression::before_handle(crow::request&, crow::response&, context&) {}
+
+void ResponseCompression::after_handle(crow::request& req, crow::response& res, context&) {
+    if (!settings_.enabled || res.body.size() < settings_.min_bytes || res.is_static_type() ||
+        !res.get_header_value("Content-Encoding").empty() || !compressibleType(res.get_header_value("Content-Type"))) {
+        return;
+    }
+    res.add_header("Vary", "Accept-Encoding");
+    Encoding encoding = negotiate(req.get_header_value("Accept-Encoding"));
+    if (encoding == Encoding::Identity) {
+        return;
+    }
+
+    // An ETag pins the body of one representation (see BinaryFormat), so the
+    // compressed form can be reused for this URL and content type
+    const std::string& etag = res.get_header_value("ETag");
+    std::string key;
+    if (!etag.empty() && settings_.cache_bytes > 0) {
+        key = std::string(name(encoding)) + " " + res.get_header_value("Content-Type") + " " + etag + " " + req.raw_url;
+        if (auto hit = cache_.get(key)) {
+            cache_hits_.fetch_add(1, std::memory_order_relaxed);
+            bytes_in_.fetch_add(res.body.size(), std::memory_order_relaxed);
+            bytes_out_.fetch_add(hit->size(), std::memory_order_relaxed);
+            res.body = *hit;
+            res.set_header("Content-Encoding", name(encoding));
+            return;
+        }
+    }
+
+    std::string compressed = compress(res.body, encoding, settings_.level);
+    if (compressed.empty() || compressed.size() >= res.body.size()) {
+        return;
+    }
+    compressed_.fetch_add(1, std::memory_order_relaxed);
+    bytes_in_.fetch_add(res.body.size(), std::memory_order_relaxed);
+    bytes_out_.fetch_add(compressed.size(), std::memory_order_relaxed);
+    if (!key.empty()) {
+        cache_.put(key, std::make_shared<const std::string>(compressed));
+    }
+    res.body = std::move(compressed);
+    res.set_header("Content-Encoding", name(encoding));
+}
+
+nlohmann::json ResponseCompression::stats() const {
+    nlohmann::json j;
+    j["enabled"] = settings_.enabled;
+    j["min_bytes"] = settings_.min_bytes;
+    j["level"] = settings_.level;
+    j["brotli"] = brotliAvailable();
+    j["compressed_responses"] = compressed_.load(std::memory_order_relaxed);
+    j["cache_hits"] = cache_hits_.load(std::memory_order_relaxed);
+    j["bytes_in"] = bytes_in_.load(std::memory_order_relaxed);
+    j["bytes_out"] = bytes_out_.load(std::memory_order_relaxed);
+    return j;
+}
+
+} // namespace aeronautical
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "BodyCache.h"
+#include <crow.h>
+#include <json.hpp>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace aeronautical {
+
+struct CompressionSettings {
+    bool enabled = true;
+    size_t min_bytes = 1024;         // smaller bodies go out as-is
+    int level = 6;                   // zlib 1..9; brotli quality is scaled from it
+    size_t cache_bytes = 64u << 20;  // compressed bodies of ETag-tagged responses
+};
+
+// Crow middleware that compresses response bodies with the best coding the
+// client's Accept-Encoding allows: br (when built with brotli), then gzip,
+// then deflate. Only text-like types above the size threshold are touched.
+// Responses carrying an ETag are immutable for that tag (see
+// ConditionalGet), so their compressed form is kept in an LRU keyed by URL,
+// ETag, content type and coding and reused instead of compressed again.
+class ResponseCompression {
+public:
+    enum class Encoding { Identity, Brotli, Gzip, Deflate };
+
+    struct context {};
+
+    void configure(const CompressionSettings& settings);
+
+    void before_handle(crow::request& req, crow::response& res, context& ctx);
+    void after_handle(crow::request& req, crow::response& res, context& ctx);
+
+    // Highest-preference coding with a non-zero q-value; Identity if none
+    static Encoding negotiate(std::string_view accept_encoding);
+    // Empty on failure or for Identity
+    static std::string compress(std::string_view body, Encoding encoding, int level);
+    static const char* name(Encoding encoding);
+    static bool brotliAvailable();
+
+    nlohmann::json stats() const;
+    // Compressed bodies kept for reuse
+    BodyCache& cache() { return cache_; }
+
+private:
+    static bool compressibleType(std::string_view content_type);
+
+    CompressionSettings settings_;
+
+    BodyCache cache_;
+
+    std::atomic<uint64_t> compressed_{0};
+    std::atomic<uint64_t> cache_hits_{0};
+    std::atomic<uint64_t> bytes_in_{0};
+    std::atomic<uint64_t> bytes_out_{0};
+};
+
+} // namespace aeronautical
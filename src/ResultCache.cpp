@@ -0,0 +1,154 @@
+#include "ResultCache.h"
+
+namespace aeronautical {
+
+ResultCache& ResultCache::getInstance() {
+    static ResultCache instance;
+    return instance;
+}
+
+void ResultCache::configure(size_t max_entries, std::chrono::seconds ttl) {
+    std::lock_guard lock(mutex_);
+    max_entries_ = max_entries;
+    ttl_ = ttl;
+    while (lru_.size() > max_entries_) {
+        erase(std::prev(lru_.end()));
+        evicted_++;
+    }
+}
+
+std::shared_ptr<const void> ResultCache::find(const std::string& key) {
+    std::lock_guard lock(mutex_);
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+        misses_++;
+        return nullptr;
+    }
+    if (it->second->expires <= std::chrono::steady_clock::now()) {
+        erase(it->second);
+        misses_++;
+        return nullptr;
+    }
+    lru_.splice(lru_.begin(), lru_, it->second);
+    hits_++;
+    return it->second->value;
+}
+
+std::optional<std::shared_future<std::shared_ptr<const void>>> ResultCache::join(const std::string& key, uint64_t& epoch,
+                                                                                    std::shared_ptr<Flight>& flight) {
+    std::lock_guard lock(mutex_);
+    epoch = epoch_;
+    if (auto it = flights_.find(key); it != flights_.end()) {
+        // A load that began before the latest invalidation may hold rows it dropped
+        if (it->second->epoch == epoch_) {
+            coalesced_++;
+            return it->second->result;
+        }
+        return std::nullopt;
+    }
+    flight = std::make_shared<Flight>();
+    flight->epoch = epoch_;
+    flights_.emplace(key, flight);
+    return std::nullopt;
+}
+
+void ResultCache::land(const std::string& key, const std::shared_ptr<Flight>& flight, std::shared_ptr<const void> value,
+                       std::exception_ptr error) {
+    if (!flight) {
+        return;
+    }
+    {
+        std::lock_guard lock(mutex_);
+        if (auto it = flights_.find(key); it != flights_.end() && it->second == flight) {
+            flights_.erase(it);
+        }
+    }
+    if (error) {
+        flight->promise.set_exception(error);
+    } else {
+        flight->promise.set_value(std::move(value));
+    }
+}
+
+void ResultCache::store(const std::string& key, const std::vector<std::string>& tags,
+                        std::shared_ptr<const void> value, uint64_t epoch) {
+    std::lock_guard lock(mutex_);
+    if (max_entries_ == 0 || epoch != epoch_) {
+        return;
+    }
+    if (auto it = index_.find(key); it != index_.end()) {
+        erase(it->second);
+    }
+    lru_.push_front(Entry{key, std::move(value), tags, std::chrono::steady_clock::now() + ttl_});
+    index_[key] = lru_.begin();
+    for (const auto& tag : tags) {
+        keys_by_tag_[tag].insert(key);
+    }
+    while (lru_.size() > max_entries_) {
+        erase(std::prev(lru_.end()));
+        evicted_++;
+    }
+}
+
+void ResultCache::erase(List::iterator it) {
+    for (const auto& tag : it->tags) {
+        auto keys = keys_by_tag_.find(tag);
+        if (keys == keys_by_tag_.end()) continue;
+        keys->second.erase(it->key);
+        if (keys->second.empty()) keys_by_tag_.erase(keys);
+    }
+    index_.erase(it->key);
+    lru_.erase(it);
+}
+
+uint64_t ResultCache::epoch() const {
+    std::lock_guard lock(mutex_);
+    return epoch_;
+}
+
+void ResultCache::invalidate(const std::string& tag) {
+    invalidate(std::vector<std::string>{tag});
+}
+
+void ResultCache::invalidate(const std::vector<std::string>& tags) {
+    std::lock_guard lock(mutex_);
+    epoch_++;
+    for (const auto& tag : tags) {
+        auto keys = keys_by_tag_.find(tag);
+        if (keys == keys_by_tag_.end()) continue;
+        // erase() edits the set being walked
+        const std::vector<std::string> doomed(keys->second.begin(), keys->second.end());
+        for (const auto& key : doomed) {
+            if (auto it = index_.find(key); it != index_.end()) {
+                erase(it->second);
+                invalidated_++;
+            }
+        }
+    }
+}
+
+void ResultCache::clear() {
+    std::lock_guard lock(mutex_);
+    epoch_++;
+    invalidated_ += lru_.size();
+    lru_.clear();
+    index_.clear();
+    keys_by_tag_.clear();
+}
+
+nlohmann::json ResultCache::stats() const {
+    std::lock_guard lock(mutex_);
+    nlohmann::json j;
+    j["entries"] = lru_.size();
+    j["max_entries"] = max_entries_;
+    j["ttl_s"] = ttl_.count();
+    j["hits"] = hits_;
+    j["misses"] = misses_;
+    j["invalidated"] = invalidated_;
+    j["coalesced"] = coalesced_;
+    j["evicted"] = evicted_;
+    j["epoch"] = epoch_;
+    return j;
+}
+
+} // namespace aeronautical
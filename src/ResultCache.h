@@ -0,0 +1,134 @@
+#pragma once
+
+#include "LockStats.h"
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <json.hpp>
+
+namespace aeronautical {
+
+// Bounded LRU of repository results for read-mostly endpoints, keyed by
+// query shape and parameters ("project.byId:12"). An entry lives for the
+// TTL at most and carries tags naming the rows it was built from
+// ("project:12", "airport:LFPG"); write paths call invalidate() with the
+// tags they touched, which drops exactly the entries built from them.
+// The TTL bounds staleness from writes made by other processes. Misses
+// on the same key load once: callers arriving while a load is running
+// wait for it and share its result (e.g. sub-requests of one batch).
+class ResultCache {
+public:
+    static ResultCache& getInstance();
+
+    ResultCache(const ResultCache&) = delete;
+    ResultCache& operator=(const ResultCache&) = delete;
+
+    // 0 entries disables the cache; load() then runs on every call
+    void configure(size_t max_entries, std::chrono::seconds ttl);
+
+    // Cached result for key, else load() stored under key with tags. tags
+    // is read once load() returned, so the loader may add tags taken from
+    // the result. A result loaded while an invalidation ran is returned
+    // but not stored, so it cannot outlive the write. An exception from
+    // load() reaches every caller waiting on that load.
+    template <typename T>
+    std::shared_ptr<const T> get(const std::string& key, const std::vector<std::string>& tags,
+                                 const std::function<T()>& load) {
+        if (auto hit = find(key)) {
+            return std::static_pointer_cast<const T>(hit);
+        }
+        uint64_t epoch = 0;
+        std::shared_ptr<Flight> flight;
+        if (auto running = join(key, epoch, flight)) {
+            return std::static_pointer_cast<const T>(running->get());
+        }
+        std::shared_ptr<const T> value;
+        try {
+            value = std::make_shared<const T>(load());
+        } catch (...) {
+            land(key, flight, nullptr, std::current_exception());
+            throw;
+        }
+        store(key, tags, value, epoch);
+        land(key, flight, value, nullptr);
+        return value;
+    }
+
+    void invalidate(const std::string& tag);
+    void invalidate(const std::vector<std::string>& tags);
+    // Drops every entry, as an invalidation of all tags would
+    void clear();
+
+    // Moves on every invalidation; data derived from a read made before a
+    // change can tell it is stale
+    uint64_t epoch() const;
+
+    nlohmann::json stats() const;
+
+    static std::string projectTag(int project_id) { return "project:" + std::to_string(project_id); }
+    static std::string procedureTag(int procedure_id) { return "procedure:" + std::to_string(procedure_id); }
+    static std::string airportTag(std::string icao) {
+        for (char& c : icao) {
+            if (c >= 'a' && c <= 'z') c = static_cast<char>(c - 'a' + 'A');
+        }
+        return "airport:" + icao;
+    }
+
+private:
+    ResultCache() = default;
+
+    struct Entry {
+        std::string key;
+        std::shared_ptr<const void> value;
+        std::vector<std::string> tags;
+        std::chrono::steady_clock::time_point expires;
+    };
+    // Front is most recent
+    using List = std::list<Entry>;
+
+    // A load in progress, joined by callers missing on the same key
+    struct Flight {
+        uint64_t epoch = 0;
+        std::promise<std::shared_ptr<const void>> promise;
+        std::shared_future<std::shared_ptr<const void>> result = promise.get_future().share();
+    };
+
+    std::shared_ptr<const void> find(const std::string& key);
+    // The running load of key to wait for, or nothing when the caller is to
+    // load it; flight is then the caller's to land (null when a write since
+    // the running load began makes it unsafe to share)
+    std::optional<std::shared_future<std::shared_ptr<const void>>> join(const std::string& key, uint64_t& epoch,
+                                                                        std::shared_ptr<Flight>& flight);
+    void land(const std::string& key, const std::shared_ptr<Flight>& flight, std::shared_ptr<const void> value,
+              std::exception_ptr error);
+    void store(const std::string& key, const std::vector<std::string>& tags, std::shared_ptr<const void> value,
+               uint64_t epoch);
+    void erase(List::iterator it); // caller holds mutex_
+
+    mutable InstrumentedMutex<std::mutex> mutex_{"result_cache"};
+    List lru_;
+    std::unordered_map<std::string, List::iterator> index_;
+    std::unordered_map<std::string, std::unordered_set<std::string>> keys_by_tag_;
+    std::unordered_map<std::string, std::shared_ptr<Flight>> flights_;
+    size_t max_entries_ = 0;
+    std::chrono::seconds ttl_{30};
+    // Bumped by every invalidation; a load that saw an older value may be stale
+    uint64_t epoch_ = 0;
+
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+    uint64_t invalidated_ = 0;
+    uint64_t coalesced_ = 0;
+    uint64_t evicted_ = 0; // least recently used, for room
+};
+
+} // namespace aeronautical
@@ -0,0 +1,59 @@
+#include "RowBitmap.h"
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+namespace aeronautical {
+
+RowBitmap::RowBitmap(std::vector<uint32_t> rows, size_t row_count)
+    : row_count_(row_count), count_(rows.size()), rows_(std::move(rows)) {
+    compact();
+}
+
+bool RowBitmap::contains(size_t row) const {
+    if (row >= row_count_) return false;
+    if (!words_.empty()) return (words_[row / 64] >> (row % 64)) & 1;
+    return std::binary_search(rows_.begin(), rows_.end(), static_cast<uint32_t>(row));
+}
+
+void RowBitmap::compact() {
+    const bool dense = count_ * 32 > row_count_;
+    if (dense && words_.empty()) {
+        words_.assign((row_count_ + 63) / 64, 0);
+        for (uint32_t row : rows_) words_[row / 64] |= uint64_t(1) << (row % 64);
+        std::vector<uint32_t>().swap(rows_);
+    } else if (!dense && !words_.empty()) {
+        rows_.reserve(count_);
+        forEach([&](size_t row) { rows_.push_back(static_cast<uint32_t>(row)); });
+        std::vector<uint64_t>().swap(words_);
+    } else if (!dense) {
+        rows_.shrink_to_fit();
+    }
+}
+
+RowBitmap RowBitmap::intersect(const RowBitmap& a, const RowBitmap& b) {
+    RowBitmap out;
+    out.row_count_ = std::min(a.row_count_, b.row_count_);
+    if (!a.words_.empty() && !b.words_.empty()) {
+        out.words_.resize(std::min(a.words_.size(), b.words_.size()));
+        for (size_t w = 0; w < out.words_.size(); w++) {
+            out.words_[w] = a.words_[w] & b.words_[w];
+            out.count_ += static_cast<size_t>(std::popcount(out.words_[w]));
+        }
+    } else if (a.words_.empty() && b.words_.empty()) {
+        std::set_intersection(a.rows_.begin(), a.rows_.end(), b.rows_.begin(), b.rows_.end(),
+                              std::back_inserter(out.rows_));
+        out.count_ = out.rows_.size();
+    } else {
+        const RowBitmap& sparse = a.words_.empty() ? a : b;
+        const RowBitmap& dense = a.words_.empty() ? b : a;
+        for (uint32_t row : sparse.rows_) {
+            if (dense.contains(row)) out.rows_.push_back(row);
+        }
+        out.count_ = out.rows_.size();
+    }
+    out.compact();
+    return out;
+}
+
+} // namespace aeronautical
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace aeronautical {
+
+// A set of row numbers below a fixed row count, held the way a roaring
+// container is: a sorted array of rows while that is smaller than one bit
+// per row (fewer than one row in 32 present), 64-bit words otherwise.
+// Intersections pick the cheap pairing: word ANDs for two bitmaps, bit
+// probes for an array against a bitmap, a merge for two arrays.
+class RowBitmap {
+public:
+    RowBitmap() = default;
+    // rows ascending, each below row_count
+    RowBitmap(std::vector<uint32_t> rows, size_t row_count);
+
+    size_t count() const { return count_; }
+    bool empty() const { return count_ == 0; }
+    bool contains(size_t row) const;
+    size_t bytes() const { return rows_.capacity() * sizeof(uint32_t) + words_.capacity() * sizeof(uint64_t); }
+
+    // Rows present in both
+    static RowBitmap intersect(const RowBitmap& a, const RowBitmap& b);
+
+    // Calls f(row) for each row in ascending order
+    template <typename F>
+    void forEach(F&& f) const {
+        if (words_.empty()) {
+            for (uint32_t row : rows_) f(static_cast<size_t>(row));
+            return;
+        }
+        for (size_t w = 0; w < words_.size(); w++) {
+            for (uint64_t word = words_[w]; word; word &= word - 1) {
+                f(w * 64 + static_cast<size_t>(std::countr_zero(word)));
+            }
+        }
+    }
+
+private:
+    // Switches to the smaller form for the current count
+    void compact();
+
+    size_t row_count_ = 0;
+    size_t count_ = 0;
+    std::vector<uint32_t> rows_;  // array form
+    std::vector<uint64_t> words_; // bitmap form; empty in array form
+};
+
+} // namespace aeronautical
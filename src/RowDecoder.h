@@ -0,0 +1,161 @@
+#pragma once
+
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <mysql/mysql.h>
+#include "InternedString.h"
+#include "PreparedStatement.h"
+#include "Timestamp.h"
+
+namespace aeronautical {
+
+// Compile-time column maps for turning result rows into entity structs.
+//
+//   using AirportRow = RowMap<Airport, Field<&Airport::id>, Skip, ...>;
+//   Airport a = AirportRow::decode(row, lengths);
+//
+// Entries follow the SELECT column order. Text rows are parsed in place with
+// std::from_chars using the lengths[] array, so numbers and flags cost no
+// temporary strings; PreparedRow rows are already typed by the binary protocol.
+
+// Decode the column into Member
+template <auto Member>
+struct Field {};
+
+// Decode the column's text with Parse(std::string_view) into Member (enums
+// etc.); NULL is passed as an empty view so Parse picks the default
+template <auto Member, auto Parse>
+struct Converted {};
+
+// Column present in the SELECT but not mapped
+struct Skip {};
+
+namespace rowdecode {
+
+template <typename T>
+struct IsOptional : std::false_type {};
+template <typename T>
+struct IsOptional<std::optional<T>> : std::true_type {};
+
+template <typename T>
+void parseText(const char* data, unsigned long length, T& out) {
+    if constexpr (std::is_same_v<T, bool>) {
+        out = length > 0 && (data[0] == '1' || std::string_view(data, length) == "true");
+    } else if constexpr (std::is_integral_v<T> || std::is_floating_point_v<T>) {
+        T value{};
+        if (std::from_chars(data, data + length, value).ec == std::errc()) {
+            out = value;
+        } else if constexpr (std::is_integral_v<T>) {
+            // DECIMAL text into an integer member: truncate like std::stoi did
+            double real = 0.0;
+            std::from_chars(data, data + length, real);
+            out = static_cast<T>(real);
+        }
+    } else if constexpr (std::is_same_v<T, std::string>) {
+        out.assign(data, length);
+    } else if constexpr (std::is_same_v<T, InternedString>) {
+        out = InternedString(std::string_view(data, length));
+    } else if constexpr (std::is_same_v<T, std::chrono::system_clock::time_point>) {
+        // "YYYY-MM-DD[ HH:MM:SS[.ffffff]]", same zone as stringToTimePoint
+        parseTimestamp(std::string_view(data, length), out);
+    } else if constexpr (IsOptional<T>::value) {
+        typename T::value_type value{};
+        parseText(data, length, value);
+        out = std::move(value);
+    } else {
+        static_assert(sizeof(T) == 0, "No text decoder for this member type");
+    }
+}
+
+template <typename T>
+void readValue(const PreparedRow& row, size_t index, T& out) {
+    if constexpr (std::is_same_v<T, bool>) {
+        out = row.getBool(index);
+    } else if constexpr (std::is_integral_v<T>) {
+        out = static_cast<T>(row.getInt(index));
+    } else if constexpr (std::is_floating_point_v<T>) {
+        out = static_cast<T>(row.getDouble(index));
+    } else if constexpr (std::is_same_v<T, std::string>) {
+        out = row.getString(index);
+    } else if constexpr (std::is_same_v<T, InternedString>) {
+        out = InternedString(row.getString(index));
+    } else if constexpr (std::is_same_v<T, std::chrono::system_clock::time_point>) {
+        if (auto tp = row.getTimePoint(index)) out = *tp;
+    } else if constexpr (IsOptional<T>::value) {
+        typename T::value_type value{};
+        readValue(row, index, value);
+        out = std::move(value);
+    } else {
+        static_assert(sizeof(T) == 0, "No binary decoder for this member type");
+    }
+}
+
+template <typename Column>
+struct ColumnTraits;
+
+template <>
+struct ColumnTraits<Skip> {
+    template <typename Entity>
+    static void fromText(Entity&, const char*, unsigned long) {}
+    template <typename Entity>
+    static void fromPrepared(Entity&, const PreparedRow&, size_t) {}
+};
+
+// NULL leaves the member at its value-initialized default
+template <auto Member>
+struct ColumnTraits<Field<Member>> {
+    template <typename Entity>
+    static void fromText(Entity& entity, const char* data, unsigned long length) {
+        if (data) parseText(data, length, entity.*Member);
+    }
+    template <typename Entity>
+    static void fromPrepared(Entity& entity, const PreparedRow& row, size_t index) {
+        if (!row.isNull(index)) readValue(row, index, entity.*Member);
+    }
+};
+
+template <auto Member, auto Parse>
+struct ColumnTraits<Converted<Member, Parse>> {
+    template <typename Entity>
+    static void fromText(Entity& entity, const char* data, unsigned long length) {
+        entity.*Member = data ? Parse(std::string_view(data, length)) : Parse(std::string_view());
+    }
+    template <typename Entity>
+    static void fromPrepared(Entity& entity, const PreparedRow& row, size_t index) {
+        std::string text = row.getString(index);
+        entity.*Member = Parse(std::string_view(text));
+    }
+};
+
+} // namespace rowdecode
+
+template <typename Entity, typename... Columns>
+struct RowMap {
+    static constexpr size_t kColumnCount = sizeof...(Columns);
+
+    // lengths may be null, in which case cells are measured with strlen
+    static Entity decode(MYSQL_ROW row, const unsigned long* lengths) {
+        Entity entity{};
+        size_t index = 0;
+        ((rowdecode::ColumnTraits<Columns>::fromText(
+              entity, row[index],
+              lengths ? lengths[index] : (row[index] ? std::strlen(row[index]) : 0)),
+          ++index), ...);
+        return entity;
+    }
+
+    static Entity decode(const PreparedRow& row) {
+        Entity entity{};
+        size_t index = 0;
+        ((rowdecode::ColumnTraits<Columns>::fromPrepared(entity, row, index), ++index), ...);
+        return entity;
+    }
+};
+
+} // namespace aeronautical
@@ -0,0 +1,147 @@
+#include "RuntimeRegistry.h"
+#include "TokenVerifier.h"
+#include <spdlog/spdlog.h>
+#include <chrono>
+
+namespace aeronautical {
+
+namespace {
+
+crow::response jsonResponse(int code, const nlohmann::json& body) {
+    crow::response res(code, body.dump());
+    res.add_header("Content-Type", "application/json");
+    return res;
+}
+
+} // namespace
+
+RuntimeRegistry& RuntimeRegistry::getInstance() {
+    static RuntimeRegistry instance;
+    return instance;
+}
+
+void RuntimeRegistry::addCache(const std::string& name, Cache cache) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    caches_[name] = std::move(cache);
+}
+
+void RuntimeRegistry::addPool(const std::string& name, Describe stats) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pools_[name] = std::move(stats);
+}
+
+void RuntimeRegistry::setSnapshot(Describe describe) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    snapshot_ = std::move(describe);
+}
+
+void RuntimeRegistry::setMemory(Describe describe) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    memory_ = std::move(describe);
+}
+
+nlohmann::json RuntimeRegistry::describe() const {
+    // Copied out, so a slow stats function does not hold up registration
+    std::map<std::string, Cache> caches;
+    std::map<std::string, Describe> pools;
+    Describe snapshot;
+    Describe memory;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        caches = caches_;
+        pools = pools_;
+        snapshot = snapshot_;
+        memory = memory_;
+    }
+
+    nlohmann::json j;
+    j["caches"] = nlohmann::json::object();
+    for (const auto& [name, cache] : caches) {
+        nlohmann::json entry = cache.stats ? cache.stats() : nlohmann::json::object();
+        entry["actions"] = nlohmann::json::array();
+        if (cache.flush) entry["actions"].push_back("flush");
+        if (cache.rebuild) entry["actions"].push_back("rebuild");
+        j["caches"][name] = std::move(entry);
+    }
+    j["pools"] = nlohmann::json::object();
+    for (const auto& [name, stats] : pools) {
+        nlohmann::json entry = stats();
+        // Busy workers over all of them, where the pool reports both
+        if (entry.contains("busy") && entry.value("threads", 0) > 0) {
+            entry["utilization"] = entry["busy"].get<double>() / entry["threads"].get<double>();
+        }
+        j["pools"][name] = std::move(entry);
+    }
+    j["snapshot"] = snapshot ? snapshot() : nlohmann::json(nullptr);
+    j["memory"] = memory ? memory() : nlohmann::json(nullptr);
+    return j;
+}
+
+crow::response RuntimeRegistry::runAction(const std::string& name, bool rebuild) {
+    Cache cache;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = caches_.find(name);
+        if (it == caches_.end()) {
+            return jsonResponse(404, {{"error", true}, {"message", "Unknown cache: " + name}});
+        }
+        cache = it->second;
+    }
+    const char* action = rebuild ? "rebuild" : "flush";
+    if (rebuild ? !cache.rebuild : !cache.flush) {
+        return jsonResponse(409, {{"error", true}, {"message", "Cache " + name + " does not support " + action}});
+    }
+
+    const auto started = std::chrono::steady_clock::now();
+    bool ok = true;
+    try {
+        if (rebuild) {
+            ok = cache.rebuild();
+        } else {
+            cache.flush();
+        }
+    } catch (const std::exception& e) {
+        spdlog::error("Runtime {} of cache {} failed: {}", action, name, e.what());
+        ok = false;
+    }
+    const double elapsed_ms =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+    spdlog::info("Runtime {} of cache {} {} in {:.1f} ms", action, name, ok ? "done" : "failed", elapsed_ms);
+
+    nlohmann::json body = {{"cache", name}, {"action", action}, {"ok", ok}, {"elapsed_ms", elapsed_ms}};
+    if (cache.stats) {
+        body["stats"] = cache.stats();
+    }
+    return jsonResponse(ok ? 200 : 503, body);
+}
+
+void RuntimeRegistry::registerRoutes(HttpApp& app) {
+    CROW_ROUTE(app, "/api/admin/runtime")
+        .methods(crow::HTTPMethod::GET)
+        ([this]() {
+            return jsonResponse(200, describe());
+        });
+
+    // Flushing and rebuilding send the load back to the database: bearer token only
+    CROW_ROUTE(app, "/api/admin/runtime/caches/<string>/flush")
+        .methods(crow::HTTPMethod::POST)
+        ([this](const crow::request& req, const std::string& name) {
+            std::string error;
+            if (!TokenVerifier::getInstance().authorizes(req.get_header_value("Authorization"), error)) {
+                return jsonResponse(401, {{"error", true}, {"message", error}});
+            }
+            return runAction(name, false);
+        });
+
+    CROW_ROUTE(app, "/api/admin/runtime/caches/<string>/rebuild")
+        .methods(crow::HTTPMethod::POST)
+        ([this](const crow::request& req, const std::string& name) {
+            std::string error;
+            if (!TokenVerifier::getInstance().authorizes(req.get_header_value("Authorization"), error)) {
+                return jsonResponse(401, {{"error", true}, {"message", error}});
+            }
+            return runAction(name, true);
+        });
+}
+
+} // namespace aeronautical
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <crow.h>
+#include "HttpApp.h"
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <json.hpp>
+
+namespace aeronautical {
+
+// The caches and pools of the process and the reference snapshot being
+// served, as GET /api/admin/runtime lists them. Each component is added in
+// main() with a function describing its current state and, for a cache,
+// how to flush or rebuild it, so none of them depends on the admin routes.
+//
+//   GET  /api/admin/runtime
+//   POST /api/admin/runtime/caches/<name>/flush     drops every entry
+//   POST /api/admin/runtime/caches/<name>/rebuild   reloads from the source
+class RuntimeRegistry {
+public:
+    using Describe = std::function<nlohmann::json()>;
+
+    struct Cache {
+        Describe stats;
+        std::function<void()> flush;   // empty when the cache cannot be flushed
+        std::function<bool()> rebuild; // empty when there is nothing to reload; false when the reload failed
+    };
+
+    static RuntimeRegistry& getInstance();
+
+    RuntimeRegistry(const RuntimeRegistry&) = delete;
+    RuntimeRegistry& operator=(const RuntimeRegistry&) = delete;
+
+    void addCache(const std::string& name, Cache cache);
+    void addPool(const std::string& name, Describe stats);
+    void setSnapshot(Describe describe);
+    // Memory budget and what each cache holds against it
+    void setMemory(Describe describe);
+
+    // {"caches": {...}, "pools": {...}, "snapshot": {...}, "memory": {...}}
+    nlohmann::json describe() const;
+
+    void registerRoutes(HttpApp& app);
+
+private:
+    RuntimeRegistry() = default;
+
+    crow::response runAction(const std::string& name, bool rebuild);
+
+    mutable std::mutex mutex_;
+    std::map<std::string, Cache> caches_;
+    std::map<std::string, Describe> pools_;
+    Describe snapshot_;
+    Describe memory_;
+};
+
+} // namespace aeronautical
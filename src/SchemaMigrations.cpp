@@ -0,0 +1,372 @@
+#include "SchemaMigrations.h"
+#include "DatabaseManager.h"
+#include <spdlog/spdlog.h>
+#include <cctype>
+
+namespace aeronautical {
+
+namespace {
+
+// Waiting longer means another instance is stuck mid-migration; start
+// without the newer migrations rather than hang
+constexpr int kLockTimeoutSeconds = 120;
+
+std::string joinColumns(const std::vector<std::string>& columns) {
+    std::string joined;
+    for (const auto& column : columns) {
+        if (!joined.empty()) joined += ",";
+        joined += column;
+    }
+    return joined;
+}
+
+// Done when an index of that name exists, or any index whose leading
+// columns are these, such as the one a foreign key or unique key created
+SchemaMigrations::Step index(const std::string& table, const std::string& name,
+                             const std::vector<std::string>& columns) {
+    const std::string list = joinColumns(columns);
+    std::string sql = "CREATE INDEX " + name + " ON " + table + " (";
+    for (size_t i = 0; i < columns.size(); i++) {
+        sql += (i ? ", " : "") + columns[i];
+    }
+    sql += ")";
+    return {sql,
+            "SELECT 1 FROM information_schema.statistics WHERE table_schema = DATABASE() AND table_name = '" + table +
+                "' GROUP BY index_name HAVING index_name = '" + name +
+                "' OR GROUP_CONCAT(column_name ORDER BY seq_in_index) = '" + list +
+                "' OR GROUP_CONCAT(column_name ORDER BY seq_in_index) LIKE '" + list + ",%'"};
+}
+
+SchemaMigrations::Step column(const std::string& table, const std::string& name, const std::string& definition) {
+    return {"ALTER TABLE " + table + " ADD COLUMN " + name + " " + definition,
+            "SELECT 1 FROM information_schema.columns WHERE table_schema = DATABASE() AND table_name = '" + table +
+                "' AND column_name = '" + name + "'"};
+}
+
+// For tables the deployment may not have: also done when the table is missing
+SchemaMigrations::Step optionalColumn(const std::string& table, const std::string& name, const std::string& definition) {
+    auto step = column(table, name, definition);
+    step.done_when = "SELECT 1 FROM DUAL WHERE NOT EXISTS (SELECT 1 FROM information_schema.tables WHERE "
+                     "table_schema = DATABASE() AND table_name = '" + table + "') OR EXISTS (" + step.done_when + ")";
+    return step;
+}
+
+// Done when the column already has that type
+SchemaMigrations::Step retype(const std::string& table, const std::string& name, const std::string& type) {
+    std::string lower = type;
+    for (char& c : lower) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return {"ALTER TABLE " + table + " MODIFY COLUMN " + name + " " + type + " NULL",
+            "SELECT 1 FROM information_schema.columns WHERE table_schema = DATABASE() AND table_name = '" + table +
+                "' AND column_name = '" + name + "' AND data_type = '" + lower + "'"};
+}
+
+} // namespace
+
+SchemaMigrations& SchemaMigrations::getInstance() {
+    static SchemaMigrations instance;
+    return instance;
+}
+
+const std::vector<SchemaMigrations::Migration>& SchemaMigrations::migrations() {
+    static const std::vector<Migration> all = {
+        {1, "indexes for the hot list and lookup predicates",
+         {
+             // Project lists filter on status and page by creation time
+             index("projects", "idx_projects_status_created", {"status", "created_at"}),
+             // Procedures of an airport, active only, in code order
+             index("flight_procedures", "idx_flight_procedures_airport", {"airport_icao", "is_active", "procedure_code"}),
+             index("conflicts", "idx_conflicts_project", {"project_id"}),
+             index("waypoints", "idx_waypoints_code", {"waypoint_code"}),
+             index("waypoints", "idx_waypoints_position", {"latitude", "longitude"}),
+         }},
+        {2, "tables of the optional stores",
+         {
+             {"CREATE TABLE IF NOT EXISTS analysis_jobs ("
+              " id BIGINT UNSIGNED AUTO_INCREMENT PRIMARY KEY,"
+              " project_id INT NOT NULL,"
+              " priority TINYINT NOT NULL DEFAULT 1,"
+              " review_deadline DATETIME(3) NULL,"
+              " state ENUM('queued','running','completed','failed','cancelled') NOT NULL DEFAULT 'queued',"
+              " owner VARCHAR(64) NULL,"
+              " lease_expires_at DATETIME(3) NULL,"
+              " attempts INT NOT NULL DEFAULT 0,"
+              " queued_at DATETIME(3) NOT NULL,"
+              " started_at DATETIME(3) NULL,"
+              " finished_at DATETIME(3) NULL,"
+              " protections_total INT NOT NULL DEFAULT 0,"
+              " protections_scanned INT NOT NULL DEFAULT 0,"
+              " conflicts_found INT NOT NULL DEFAULT 0,"
+              " error TEXT NULL,"
+              " KEY idx_analysis_jobs_lease (state, lease_expires_at),"
+              " KEY idx_analysis_jobs_project (project_id, id))",
+              ""},
+             {"CREATE TABLE IF NOT EXISTS cache_events ("
+              " id BIGINT UNSIGNED AUTO_INCREMENT PRIMARY KEY,"
+              " origin VARCHAR(64) NOT NULL,"
+              " table_name ENUM('airports','waypoints','procedures') NOT NULL,"
+              " kind ENUM('inserted','updated','deleted','reloaded') NOT NULL,"
+              " row_id INT NULL,"
+              " airport_icao VARCHAR(8) NULL,"
+              " created_at DATETIME(3) NOT NULL,"
+              " KEY idx_cache_events_created (created_at))",
+              ""},
+             {"CREATE TABLE IF NOT EXISTS project_code_sequences ("
+              " year INT NOT NULL PRIMARY KEY,"
+              " next_value INT NOT NULL)",
+              ""},
+             {"CREATE TABLE IF NOT EXISTS project_mbrs ("
+              " project_id INT NOT NULL PRIMARY KEY,"
+              " revision VARCHAR(40) NOT NULL,"
+              " mbr POLYGON NOT NULL SRID 0,"
+              " SPATIAL INDEX idx_project_mbrs_mbr (mbr))",
+              ""},
+         }},
+        // Values the backend derives and recomputes when missing or stale,
+        // so existing rows need no backfill
+        {3, "derived columns of conflicts and flight_procedures",
+         {
+             column("conflicts", "severity", "VARCHAR(16) NULL"),
+             column("conflicts", "overlap_area", "DOUBLE NULL"),
+             column("conflicts", "overlap_ratio", "DOUBLE NULL"),
+             column("conflicts", "vertical_clearance_ft", "DOUBLE NULL"),
+             column("conflicts", "penetration_depth_ft", "DOUBLE NULL"),
+             column("flight_procedures", "protection_min_lng", "DOUBLE NULL"),
+             column("flight_procedures", "protection_min_lat", "DOUBLE NULL"),
+             column("flight_procedures", "protection_max_lng", "DOUBLE NULL"),
+             column("flight_procedures", "protection_max_lat", "DOUBLE NULL"),
+             column("flight_procedures", "protection_vertex_count", "INT NULL"),
+             column("flight_procedures", "protection_cells", "TEXT NULL"),
+             column("flight_procedures", "protection_footprint_version", "BIGINT NULL"),
+             column("flight_procedures", "protection_wkb", "LONGBLOB NULL"),
+             column("flight_procedures", "protection_wkb_version", "BIGINT NULL"),
+         }},
+        // Binary so GeometryBlob can store large GeoJSON compressed; the
+        // text already there converts byte for byte and reads back as is
+        {4, "geometry columns stored as binary",
+         {
+             retype("project_geometries", "geometry_data", "LONGBLOB"),
+             retype("flight_procedures", "protection_geometry", "LONGBLOB"),
+         }},
+        // Validated protection WKB stored once per distinct geometry and
+        // referenced by its SHA-256; protection_wkb_version still tells
+        // whether the reference is current
+        {5, "content-addressed geometry store",
+         {
+             {"CREATE TABLE IF NOT EXISTS geometry_blobs ("
+              " hash CHAR(64) NOT NULL PRIMARY KEY,"
+              " wkb LONGBLOB NOT NULL,"
+              " created_at DATETIME(3) NOT NULL)",
+              ""},
+             column("flight_procedures", "protection_geometry_hash", "CHAR(64) NULL"),
+         }},
+        // Each analysis run is compared with the previous one: unchanged
+        // conflicts keep their row, resolved ones are listed until the next run
+        {6, "conflict changes between analysis runs",
+         {
+             column("conflicts", "result_signature", "BIGINT UNSIGNED NULL"),
+             column("conflicts", "change_state", "VARCHAR(16) NULL"),
+             {"CREATE TABLE IF NOT EXISTS resolved_conflicts ("
+              " id INT AUTO_INCREMENT PRIMARY KEY,"
+              " project_id INT NOT NULL,"
+              " conflict_id INT NOT NULL,"
+              " flight_procedure_id INT NOT NULL,"
+              " description TEXT NULL,"
+              " result_signature BIGINT UNSIGNED NULL,"
+              " resolved_at DATETIME(3) NOT NULL,"
+              " KEY idx_resolved_conflicts_project (project_id))",
+              ""},
+         }},
+        // Conflict counts per map cell and day, kept by the conflict writers
+        // (see ConflictHeatmap); rows stored before are located at startup
+        {7, "conflict heatmap counters",
+         {
+             column("conflicts", "heat_cell", "BIGINT NULL"),
+             index("conflicts", "idx_conflicts_heat_cell", {"heat_cell"}),
+             {"CREATE TABLE IF NOT EXISTS conflict_heat ("
+              " level TINYINT NOT NULL,"
+              " x INT NOT NULL,"
+              " y INT NOT NULL,"
+              " day DATE NOT NULL,"
+              " severity VARCHAR(16) NOT NULL,"
+              " airport_icao VARCHAR(8) NOT NULL,"
+              " opened INT NOT NULL DEFAULT 0,"
+              " resolved INT NOT NULL DEFAULT 0,"
+              " PRIMARY KEY (level, x, y, day, severity, airport_icao),"
+              " KEY idx_conflict_heat_airport (level, airport_icao, day))",
+              ""},
+         }},
+        // Hours a procedure's zone is in force (see TimeSchedule), compiled
+        // when the protection set is built
+        {8, "applicability columns of flight_procedures",
+         {
+             column("flight_procedures", "time_restriction", "VARCHAR(255) NULL"),
+             column("flight_procedures", "weather_dependent", "TINYINT(1) NOT NULL DEFAULT 0"),
+         }},
+        // AIRAC cycle and content of the protection set a conflict was found
+        // against, e.g. "2611-3f0c9a41d2e87b65"
+        {9, "protection_snapshot column of conflicts",
+         {
+             column("conflicts", "protection_snapshot", "VARCHAR(32) NULL"),
+         }},
+        // Feature as uploaded, kept for audit when ingest reduced its vertices
+        // (see VertexReducer); feature_json holds what analysis reads
+        {10, "original_json column of project_features",
+         {
+             optionalColumn("project_features", "original_json", "LONGTEXT NULL"),
+         }},
+        // Conflicts of projects closed for a while move out of the hot table
+        // into a compressed copy of it (see ConflictArchiver). Rows move with
+        // SELECT *, so a later migration adding a conflicts column adds it
+        // to conflicts_archive as well.
+        {11, "compressed archive table of conflicts",
+         {
+             {"CREATE TABLE IF NOT EXISTS conflicts_archive LIKE conflicts", ""},
+             {"ALTER TABLE conflicts_archive ROW_FORMAT=COMPRESSED KEY_BLOCK_SIZE=8",
+              "SELECT 1 FROM information_schema.tables WHERE table_schema = DATABASE() AND "
+              "table_name = 'conflicts_archive' AND row_format = 'Compressed'"},
+         }},
+    };
+    return all;
+}
+
+bool SchemaMigrations::run() {
+    auto& db = DatabaseManager::getInstance();
+    bool ok = true;
+    try {
+        // GET_LOCK belongs to the connection, so every statement shares one
+        DatabaseManager::ConnectionScope scope(db);
+        MysqlResult lock = db.executeSelectQuery("SELECT GET_LOCK('schema_migrations', " +
+                                                 std::to_string(kLockTimeoutSeconds) + ")");
+        MYSQL_ROW lock_row = lock ? mysql_fetch_row(lock.get()) : nullptr;
+        if (!lock_row || !lock_row[0] || std::atoi(lock_row[0]) != 1) {
+            spdlog::error("Schema migrations skipped: another instance held the lock for {} s", kLockTimeoutSeconds);
+            ok = false;
+        } else {
+            int version = 0;
+            try {
+                if (!db.executeQuery("CREATE TABLE IF NOT EXISTS schema_migrations ("
+                                     " version INT NOT NULL PRIMARY KEY,"
+                                     " description VARCHAR(255) NOT NULL,"
+                                     " applied_at DATETIME(3) NOT NULL)")) {
+                    ok = false;
+                }
+                if (ok) {
+                    auto current = db.executePrepared("SELECT COALESCE(MAX(version), 0) FROM schema_migrations");
+                    version = current.rows.empty() ? 0 : static_cast<int>(current.rows[0].getInt(0));
+                }
+                for (const auto& migration : migrations()) {
+                    if (!ok || migration.version <= version) continue;
+                    ok = apply(migration);
+                    if (ok) version = migration.version;
+                }
+            } catch (const std::exception& e) {
+                spdlog::error("Schema migrations failed: {}", e.what());
+                ok = false;
+            }
+            // Before the connection goes back to the pool still holding it
+            db.executeQuery("DO RELEASE_LOCK('schema_migrations')");
+            {
+                std::lock_guard<std::mutex> guard(mutex_);
+                applied_version_ = version;
+            }
+            spdlog::info("Database schema at version {} of {}", version, migrations().back().version);
+        }
+    } catch (const std::exception& e) {
+        spdlog::error("Schema migrations failed: {}", e.what());
+        ok = false;
+    }
+    return loadCatalog() && ok;
+}
+
+bool SchemaMigrations::apply(const Migration& migration) {
+    auto& db = DatabaseManager::getInstance();
+    for (const auto& step : migration.steps) {
+        if (!step.done_when.empty()) {
+            MysqlResult done = db.executeSelectQuery(step.done_when);
+            if (!done) {
+                spdlog::error("Schema migration {} could not check: {}", migration.version, step.done_when);
+                return false;
+            }
+            if (mysql_num_rows(done.get()) > 0) continue;
+        }
+        if (!db.executeQuery(step.sql)) {
+            spdlog::error("Schema migration {} ({}) failed at: {}", migration.version, migration.description, step.sql);
+            return false;
+        }
+    }
+    db.executePrepared("INSERT INTO schema_migrations (version, description, applied_at) VALUES (?, ?, NOW(3))",
+                       {static_cast<int64_t>(migration.version), migration.description});
+    spdlog::info("Applied schema migration {}: {}", migration.version, migration.description);
+    return true;
+}
+
+bool SchemaMigrations::loadCatalog() {
+    std::unordered_map<std::string, std::unordered_map<std::string, std::string>> catalog;
+    try {
+        MysqlResult result = DatabaseManager::getInstance().executeSelectQuery(
+            "SELECT table_name, column_name, data_type FROM information_schema.columns WHERE table_schema = DATABASE()");
+        if (!result) {
+            return false;
+        }
+        MYSQL_ROW row;
+        while ((row = mysql_fetch_row(result.get()))) {
+            if (row[0] && row[1]) catalog[row[0]][row[1]] = row[2] ? row[2] : "";
+        }
+    } catch (const std::exception& e) {
+        spdlog::error("Could not read the database schema: {}", e.what());
+        return false;
+    }
+    std::lock_guard<std::mutex> guard(mutex_);
+    catalog_ = std::move(catalog);
+    catalog_loaded_ = true;
+    return true;
+}
+
+bool SchemaMigrations::ensureCatalog() {
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        if (catalog_loaded_) return true;
+    }
+    return loadCatalog();
+}
+
+bool SchemaMigrations::hasTable(const std::string& table) {
+    auto& schema = getInstance();
+    if (!schema.ensureCatalog()) return false;
+    std::lock_guard<std::mutex> guard(schema.mutex_);
+    return schema.catalog_.count(table) > 0;
+}
+
+bool SchemaMigrations::hasColumn(const std::string& table, const std::string& column) {
+    auto& schema = getInstance();
+    if (!schema.ensureCatalog()) return false;
+    std::lock_guard<std::mutex> guard(schema.mutex_);
+    auto it = schema.catalog_.find(table);
+    return it != schema.catalog_.end() && it->second.count(column) > 0;
+}
+
+std::string SchemaMigrations::columnType(const std::string& table, const std::string& column) {
+    auto& schema = getInstance();
+    if (!schema.ensureCatalog()) return {};
+    std::lock_guard<std::mutex> guard(schema.mutex_);
+    auto it = schema.catalog_.find(table);
+    if (it == schema.catalog_.end()) return {};
+    auto type = it->second.find(column);
+    return type == it->second.end() ? std::string() : type->second;
+}
+
+int SchemaMigrations::appliedVersion() const {
+    std::lock_guard<std::mutex> guard(mutex_);
+    return applied_version_;
+}
+
+nlohmann::json SchemaMigrations::status() const {
+    std::lock_guard<std::mutex> guard(mutex_);
+    nlohmann::json j;
+    j["version"] = applied_version_;
+    j["latest"] = migrations().back().version;
+    j["tables"] = catalog_.size();
+    return j;
+}
+
+} // namespace aeronautical
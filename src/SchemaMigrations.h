@@ -0,0 +1,84 @@
+#pragma once
+
+#include <json.hpp>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace aeronautical {
+
+// Versioned changes to the database schema, applied at startup in order and
+// recorded in
+//
+//   CREATE TABLE schema_migrations (
+//     version INT NOT NULL PRIMARY KEY,
+//     description VARCHAR(255) NOT NULL,
+//     applied_at DATETIME(3) NOT NULL
+//   );
+//
+// which the runner creates. Instances starting together take turns through
+// GET_LOCK, so each migration runs once. A step skips itself when what it
+// would create is already there, so a migration that failed half-way, or a
+// database where an operator added an index by hand, is finished on the next
+// start rather than broken. The core tables (projects, flight_procedures,
+// waypoints, ...) predate the runner and are expected to exist; migrations
+// add indexes, the optional tables and the derived columns on top of them.
+//
+// After running, the runner reads the tables and columns of the database
+// once; hasTable, hasColumn and columnType answer from that catalog, so
+// repositories no longer send SHOW TABLES or SHOW COLUMNS to find out what
+// they may use.
+class SchemaMigrations {
+public:
+    struct Step {
+        std::string sql;
+        // Returns a row when the step is already done; empty to always run
+        std::string done_when;
+    };
+
+    struct Migration {
+        int version = 0;
+        std::string description;
+        std::vector<Step> steps;
+    };
+
+    static SchemaMigrations& getInstance();
+
+    SchemaMigrations(const SchemaMigrations&) = delete;
+    SchemaMigrations& operator=(const SchemaMigrations&) = delete;
+
+    // Applies the migrations newer than the recorded version, then loads the
+    // catalog. Stops at the first failing migration and returns false; the
+    // features behind what it would have created stay off until a later
+    // start finishes it.
+    bool run();
+    // Loads the catalog without migrating (DB_MIGRATIONS=0)
+    bool loadCatalog();
+
+    // Whether the table or column exists; the catalog loads on first use
+    // when run was not called, and a failed load is retried on the next call
+    static bool hasTable(const std::string& table);
+    static bool hasColumn(const std::string& table, const std::string& column);
+    // information_schema DATA_TYPE of the column, e.g. "longblob"; empty when absent
+    static std::string columnType(const std::string& table, const std::string& column);
+
+    int appliedVersion() const;
+    nlohmann::json status() const;
+
+    static const std::vector<Migration>& migrations();
+
+private:
+    SchemaMigrations() = default;
+
+    bool apply(const Migration& migration);
+    bool ensureCatalog();
+
+    mutable std::mutex mutex_;
+    int applied_version_ = 0;
+    bool catalog_loaded_ = false;
+    // table -> column -> data type
+    std::unordered_map<std::string, std::unordered_map<std::string, std::string>> catalog_;
+};
+
+} // namespace aeronautical
@@ -0,0 +1,181 @@
+#include "SearchIndex.h"
+#include <algorithm>
+
+namespace aeronautical {
+
+namespace {
+
+char asciiLower(char c) { return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c; }
+
+bool isWordChar(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || (static_cast<unsigned char>(c) & 0x80);
+}
+
+uint32_t trigram(std::string_view text, size_t at) {
+    return (static_cast<uint32_t>(static_cast<unsigned char>(text[at])) << 16) |
+           (static_cast<uint32_t>(static_cast<unsigned char>(text[at + 1])) << 8) |
+           static_cast<uint32_t>(static_cast<unsigned char>(text[at + 2]));
+}
+
+std::string_view trimmed(std::string_view text) {
+    while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) text.remove_prefix(1);
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\t')) text.remove_suffix(1);
+    return text;
+}
+
+constexpr uint8_t kSubstringRank = 4;
+
+} // namespace
+
+void SearchIndex::add(uint32_t row, std::initializer_list<std::string_view> codes,
+                      std::initializer_list<std::string_view> texts, uint8_t tier) {
+    uint32_t doc_index = static_cast<uint32_t>(docs_.size());
+    Doc doc{row, tier, 0, {}};
+    auto append = [&](std::string_view field, bool is_code) {
+        if (!doc.text.empty()) doc.text += '\x1f';
+        uint32_t offset = static_cast<uint32_t>(doc.text.size());
+        for (char c : field) doc.text += asciiLower(c);
+        if (!field.empty()) {
+            fields_.push_back({doc_index, offset, static_cast<uint32_t>(field.size()), is_code});
+        }
+    };
+    for (auto code : codes) append(code, true);
+    if (texts.size() > 0) doc.name_length = static_cast<uint32_t>(texts.begin()->size());
+    for (auto text : texts) append(text, false);
+    docs_.push_back(std::move(doc));
+}
+
+void SearchIndex::build() {
+    prefix_keys_.clear();
+    std::vector<std::pair<uint32_t, uint32_t>> grams; // trigram, doc
+
+    // docs_ no longer grows, so views into the texts stay put
+    for (const Field& f : fields_) {
+        std::string_view field = std::string_view(docs_[f.doc].text).substr(f.offset, f.length);
+        if (f.is_code) {
+            prefix_keys_.push_back({field, f.doc, kCode});
+        } else {
+            // Each word start keys the rest of the field, so "new yo" finds "new york"
+            for (size_t i = 0; i < field.size(); i++) {
+                if (i == 0) {
+                    prefix_keys_.push_back({field, f.doc, kTextStart});
+                } else if (isWordChar(field[i]) && !isWordChar(field[i - 1])) {
+                    prefix_keys_.push_back({field.substr(i), f.doc, kWordStart});
+                }
+            }
+        }
+        for (size_t i = 0; i + 3 <= field.size(); i++) {
+            grams.emplace_back(trigram(field, i), f.doc);
+        }
+    }
+    fields_.clear();
+    fields_.shrink_to_fit();
+
+    std::sort(prefix_keys_.begin(), prefix_keys_.end(),
+              [](const PrefixKey& a, const PrefixKey& b) { return a.key < b.key; });
+
+    std::sort(grams.begin(), grams.end());
+    grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+    trigram_keys_.clear();
+    trigram_start_.clear();
+    trigram_docs_.clear();
+    trigram_docs_.reserve(grams.size());
+    for (const auto& [gram, doc] : grams) {
+        if (trigram_keys_.empty() || trigram_keys_.back() != gram) {
+            trigram_keys_.push_back(gram);
+            trigram_start_.push_back(static_cast<uint32_t>(trigram_docs_.size()));
+        }
+        trigram_docs_.push_back(doc);
+    }
+    trigram_start_.push_back(static_cast<uint32_t>(trigram_docs_.size()));
+}
+
+void SearchIndex::collectSubstring(std::string_view needle, std::vector<uint32_t>& docs) const {
+    // Postings of every trigram in the needle, smallest first
+    std::vector<std::pair<uint32_t, uint32_t>> lists;
+    for (size_t i = 0; i + 3 <= needle.size(); i++) {
+        uint32_t gram = trigram(needle, i);
+        auto it = std::lower_bound(trigram_keys_.begin(), trigram_keys_.end(), gram);
+        if (it == trigram_keys_.end() || *it != gram) {
+            return; // some trigram occurs nowhere
+        }
+        size_t k = it - trigram_keys_.begin();
+        lists.emplace_back(trigram_start_[k], trigram_start_[k + 1]);
+    }
+    std::sort(lists.begin(), lists.end(),
+              [](const auto& a, const auto& b) { return a.second - a.first < b.second - b.first; });
+
+    std::vector<uint32_t> candidates(trigram_docs_.begin() + lists[0].first, trigram_docs_.begin() + lists[0].second);
+    std::vector<uint32_t> narrowed;
+    for (size_t l = 1; l < lists.size() && !candidates.empty(); l++) {
+        narrowed.clear();
+        std::set_intersection(candidates.begin(), candidates.end(), trigram_docs_.begin() + lists[l].first,
+                              trigram_docs_.begin() + lists[l].second, std::back_inserter(narrowed));
+        candidates.swap(narrowed);
+    }
+
+    // Trigrams can all be present without the needle being contiguous
+    for (uint32_t d : candidates) {
+        if (docs_[d].text.find(needle) != std::string::npos) {
+            docs.push_back(d);
+        }
+    }
+}
+
+std::vector<uint32_t> SearchIndex::search(std::string_view query, size_t limit) const {
+    std::string needle;
+    for (char c : trimmed(query)) needle += asciiLower(c);
+    if (needle.empty() || limit == 0 || docs_.empty()) {
+        return {};
+    }
+
+    // Best rank per doc seen so far (0 = not seen); reset before returning
+    thread_local std::vector<uint8_t> best;
+    if (best.size() < docs_.size()) best.resize(docs_.size(), 0);
+    std::vector<uint32_t> hits;
+
+    auto offer = [&](uint32_t doc, uint8_t rank) {
+        uint8_t stored = rank + 1;
+        if (best[doc] == 0) {
+            hits.push_back(doc);
+            best[doc] = stored;
+        } else if (stored < best[doc]) {
+            best[doc] = stored;
+        }
+    };
+
+    auto it = std::lower_bound(prefix_keys_.begin(), prefix_keys_.end(), std::string_view(needle),
+                               [](const PrefixKey& entry, std::string_view key) { return entry.key < key; });
+    for (; it != prefix_keys_.end() && it->key.substr(0, needle.size()) == needle; ++it) {
+        uint8_t rank = it->kind == kCode ? (it->key.size() == needle.size() ? 0 : 1) : it->kind;
+        offer(it->doc, rank);
+    }
+
+    if (needle.size() >= 3 && hits.size() < limit) {
+        std::vector<uint32_t> substring_docs;
+        collectSubstring(needle, substring_docs);
+        for (uint32_t d : substring_docs) offer(d, kSubstringRank);
+    }
+
+    // rank | tier | name length | row, so one integer compare orders results
+    std::vector<uint64_t> scored;
+    scored.reserve(hits.size());
+    for (uint32_t d : hits) {
+        const Doc& doc = docs_[d];
+        uint64_t rank = best[d] - 1;
+        uint64_t length = std::min<uint32_t>(doc.name_length, 0xFFFF);
+        scored.push_back(rank << 59 | static_cast<uint64_t>(doc.tier) << 51 | length << 32 | doc.row);
+        best[d] = 0;
+    }
+
+    size_t keep = std::min(limit, scored.size());
+    std::partial_sort(scored.begin(), scored.begin() + keep, scored.end());
+    std::vector<uint32_t> rows;
+    rows.reserve(keep);
+    for (size_t i = 0; i < keep; i++) {
+        rows.push_back(static_cast<uint32_t>(scored[i] & 0xFFFFFFFFu));
+    }
+    return rows;
+}
+
+} // namespace aeronautical
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace aeronautical {
+
+// Autocomplete index over short code columns and free-text columns,
+// matched case-insensitively (ASCII folding). Codes and the words of the
+// text columns sit in one sorted key array, so a prefix lookup is a binary
+// search and a scan of the matching run; queries of three or more
+// characters also find substrings through a trigram index whose hits are
+// checked against the text.
+//
+// Results are ranked: exact code, code prefix, text prefix, word prefix,
+// then any other substring; ties go to the lower tier, the shorter first
+// text column, then the lower row. The substring pass is skipped when the
+// prefix matches already fill the limit.
+class SearchIndex {
+public:
+    // Call for each searchable row, then build() once
+    void add(uint32_t row, std::initializer_list<std::string_view> codes,
+             std::initializer_list<std::string_view> texts, uint8_t tier = 0);
+    void build();
+
+    // Rows matching query, best first, at most limit of them
+    std::vector<uint32_t> search(std::string_view query, size_t limit) const;
+
+    size_t size() const { return docs_.size(); }
+
+private:
+    struct Doc {
+        uint32_t row;
+        uint8_t tier;
+        uint32_t name_length; // first text column
+        std::string text;     // lower-cased fields joined by '\x1f'
+    };
+
+    enum KeyKind : uint8_t { kCode = 1, kTextStart = 2, kWordStart = 3 };
+
+    struct PrefixKey {
+        std::string_view key; // into Doc::text, running to the end of the field
+        uint32_t doc;
+        KeyKind kind;
+    };
+
+    // A code or text column of one doc, recorded by add() for build()
+    struct Field {
+        uint32_t doc;
+        uint32_t offset;
+        uint32_t length;
+        bool is_code;
+    };
+
+    void collectSubstring(std::string_view needle, std::vector<uint32_t>& docs) const;
+
+    std::vector<Doc> docs_;
+    std::vector<Field> fields_;
+    std::vector<PrefixKey> prefix_keys_; // sorted by key
+
+    // Trigram postings in CSR form: trigram_keys_[i] owns
+    // trigram_docs_[trigram_start_[i] .. trigram_start_[i + 1])
+    std::vector<uint32_t> trigram_keys_;
+    std::vector<uint32_t> trigram_start_;
+    std::vector<uint32_t> trigram_docs_;
+};
+
+} // namespace aeronautical
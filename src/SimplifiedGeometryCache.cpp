@@ -0,0 +1,351 @@
+#include "SimplifiedGeometryCache.h"
+#include "DiskCache.h"
+#include <json.hpp>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace aeronautical {
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+
+bool isPosition(const nlohmann::json& j) {
+    if (!j.is_array() || j.size() < 2) return false;
+    for (const auto& v : j) {
+        if (!v.is_number()) return false;
+    }
+    return true;
+}
+
+// Squared distance from p to segment ab, in longitude-degree units: latitude
+// differences are stretched by 1/cos(lat) to match Web Mercator pixels
+double segmentDistance2(const nlohmann::json& p, const nlohmann::json& a, const nlohmann::json& b, double lat_scale) {
+    double ax = a[0].get<double>(), ay = a[1].get<double>() * lat_scale;
+    double bx = b[0].get<double>(), by = b[1].get<double>() * lat_scale;
+    double px = p[0].get<double>(), py = p[1].get<double>() * lat_scale;
+    double dx = bx - ax, dy = by - ay;
+    double length2 = dx * dx + dy * dy;
+    double t = length2 > 0 ? ((px - ax) * dx + (py - ay) * dy) / length2 : 0.0;
+    t = std::max(0.0, std::min(1.0, t));
+    double ex = ax + t * dx - px, ey = ay + t * dy - py;
+    return ex * ex + ey * ey;
+}
+
+// Douglas-Peucker over one position list; min_points keeps lines and rings valid
+nlohmann::json simplifyPositions(const nlohmann::json& positions, double tolerance, size_t min_points) {
+    size_t n = positions.size();
+    if (n <= min_points || tolerance <= 0) return positions;
+    for (const auto& p : positions) {
+        if (!isPosition(p)) return positions;
+    }
+    double lat_scale = 1.0 / std::max(0.01, std::cos(positions[0][1].get<double>() * kPi / 180.0));
+    double tolerance2 = tolerance * tolerance;
+
+    std::vector<char> keep(n, 0);
+    keep[0] = keep[n - 1] = 1;
+    std::vector<std::pair<size_t, size_t>> stack{{0, n - 1}};
+    while (!stack.empty()) {
+        auto [first, last] = stack.back();
+        stack.pop_back();
+        double farthest = 0;
+        size_t index = first;
+        for (size_t i = first + 1; i < last; i++) {
+            double d = segmentDistance2(positions[i], positions[first], positions[last], lat_scale);
+            if (d > farthest) {
+                farthest = d;
+                index = i;
+            }
+        }
+        // A closed ring's anchors coincide, so its first split is always kept
+        if (index != first && (farthest > tolerance2 || (first == 0 && last == n - 1 && positions[0] == positions[n - 1]))) {
+            keep[index] = 1;
+            stack.emplace_back(first, index);
+            stack.emplace_back(index, last);
+        }
+    }
+
+    nlohmann::json result = nlohmann::json::array();
+    for (size_t i = 0; i < n; i++) {
+        if (keep[i]) result.push_back(positions[i]);
+    }
+    if (result.size() < min_points) {
+        // A ring smaller than the tolerance still needs three distinct corners
+        result = nlohmann::json::array({positions[0], positions[n / 3], positions[2 * n / 3], positions[n - 1]});
+    }
+    return result;
+}
+
+void simplifyNode(nlohmann::json& node, double tolerance) {
+    if (node.is_array()) {
+        for (auto& child : node) simplifyNode(child, tolerance);
+        return;
+    }
+    if (!node.is_object()) return;
+
+    auto type = node.find("type");
+    auto coordinates = node.find("coordinates");
+    if (type != node.end() && type->is_string() && coordinates != node.end() && coordinates->is_array()) {
+        const std::string& name = type->get_ref<const std::string&>();
+        if (name == "LineString") {
+            *coordinates = simplifyPositions(*coordinates, tolerance, 2);
+        } else if (name == "MultiLineString") {
+            for (auto& line : *coordinates) line = simplifyPositions(line, tolerance, 2);
+        } else if (name == "Polygon") {
+            for (auto& ring : *coordinates) ring = simplifyPositions(ring, tolerance, 4);
+        } else if (name == "MultiPolygon") {
+            for (auto& polygon : *coordinates) {
+                if (!polygon.is_array()) continue;
+                for (auto& ring : polygon) ring = simplifyPositions(ring, tolerance, 4);
+            }
+        }
+        return;
+    }
+    for (const char* member : {"features", "geometry", "geometries"}) {
+        auto child = node.find(member);
+        if (child != node.end()) simplifyNode(*child, tolerance);
+    }
+}
+
+// Every level of one stored geometry; levels that fail to parse stay empty
+std::array<std::optional<std::string>, SimplifiedGeometry::kLevelZooms.size()> buildLevels(const std::string& text) {
+    std::array<std::optional<std::string>, SimplifiedGeometry::kLevelZooms.size()> levels;
+    nlohmann::json document = nlohmann::json::parse(text, nullptr, false);
+    if (document.is_discarded()) {
+        return levels;
+    }
+    for (size_t level = 0; level < levels.size(); level++) {
+        nlohmann::json copy = document;
+        simplifyNode(copy, SimplifiedGeometryCache::tolerance(level));
+        levels[level] = copy.dump();
+    }
+    return levels;
+}
+
+// DiskCache key of a procedure version, built from what find() compares
+std::string diskKey(const FlightProcedure& procedure) {
+    const auto updated = std::chrono::duration_cast<std::chrono::milliseconds>(
+                             procedure.updated_at.time_since_epoch()).count();
+    return "simplified/" + std::to_string(procedure.id) + "/" + std::to_string(updated) + "/" +
+           std::to_string(procedure.trajectory_geometry ? procedure.trajectory_geometry->size() : 0) + "/" +
+           std::to_string(procedure.protection_geometry ? procedure.protection_geometry->size() : 0);
+}
+
+using Levels = std::array<std::optional<std::string>, SimplifiedGeometry::kLevelZooms.size()>;
+
+nlohmann::json levelsToJson(const Levels& levels) {
+    nlohmann::json j = nlohmann::json::array();
+    for (const auto& level : levels) {
+        j.push_back(level ? nlohmann::json(*level) : nlohmann::json(nullptr));
+    }
+    return j;
+}
+
+bool levelsFromJson(const nlohmann::json& j, Levels& levels) {
+    if (!j.is_array() || j.size() != levels.size()) return false;
+    for (size_t i = 0; i < levels.size(); i++) {
+        if (j[i].is_string()) {
+            levels[i] = j[i].get<std::string>();
+        } else if (!j[i].is_null()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+SimplifiedGeometryCache& SimplifiedGeometryCache::getInstance() {
+    static SimplifiedGeometryCache instance;
+    return instance;
+}
+
+double SimplifiedGeometryCache::pixelDegrees(int zoom) {
+    return 360.0 / (256.0 * std::ldexp(1.0, zoom));
+}
+
+double SimplifiedGeometryCache::tolerance(size_t level) {
+    return pixelDegrees(SimplifiedGeometry::kLevelZooms[level]);
+}
+
+bool SimplifiedGeometryCache::fromRequest(const crow::request& req, std::optional<size_t>& level, std::string& error) {
+    level.reset();
+    double wanted = 0;
+    try {
+        size_t used = 0;
+        if (const char* simplify = req.url_params.get("simplify")) {
+            wanted = std::stod(simplify, &used);
+            if (simplify[used] != '\0' || !(wanted >= 0)) throw std::invalid_argument(simplify);
+        } else if (const char* zoom = req.url_params.get("zoom")) {
+            int z = std::stoi(zoom, &used);
+            if (zoom[used] != '\0' || z < 0 || z > 24) throw std::invalid_argument(zoom);
+            wanted = pixelDegrees(z);
+        } else {
+            return true;
+        }
+    } catch (const std::exception&) {
+        error = "Invalid simplify or zoom parameter";
+        return false;
+    }
+    level = levelFor(wanted);
+    return true;
+}
+
+bool SimplifiedGeometryCache::fromJson(const nlohmann::json& body, std::optional<size_t>& level, std::string& error) {
+    level.reset();
+    double wanted = 0;
+    if (body.contains("simplify")) {
+        const auto& simplify = body["simplify"];
+        if (!simplify.is_number() || !(simplify.get<double>() >= 0)) {
+            error = "simplify must be a tolerance in degrees";
+            return false;
+        }
+        wanted = simplify.get<double>();
+    } else if (body.contains("zoom")) {
+        const auto& zoom = body["zoom"];
+        if (!zoom.is_number_integer() || zoom.get<int>() < 0 || zoom.get<int>() > 24) {
+            error = "zoom must be an integer from 0 to 24";
+            return false;
+        }
+        wanted = pixelDegrees(zoom.get<int>());
+    } else {
+        return true;
+    }
+    level = levelFor(wanted);
+    return true;
+}
+
+std::optional<size_t> SimplifiedGeometryCache::levelFor(double wanted) {
+    for (size_t i = 0; i < SimplifiedGeometry::kLevelZooms.size(); i++) {
+        if (tolerance(i) <= wanted * (1 + 1e-9)) {
+            return i;
+        }
+    }
+    return std::nullopt;
+}
+
+std::shared_ptr<const SimplifiedGeometry> SimplifiedGeometryCache::find(const FlightProcedure& procedure) const {
+    auto entries = entries_.load();
+    if (!entries) {
+        return nullptr;
+    }
+    auto it = entries->find(procedure.id);
+    if (it == entries->end()) {
+        return nullptr;
+    }
+    const auto& entry = it->second;
+    // A geometry the caller did not load (field projection) matches any entry
+    if (entry->updated_at != procedure.updated_at ||
+        (procedure.trajectory_geometry && entry->trajectory_size != procedure.trajectory_geometry->size()) ||
+        (procedure.protection_geometry && entry->protection_size != procedure.protection_geometry->size())) {
+        return nullptr;
+    }
+    return entry;
+}
+
+std::shared_ptr<const SimplifiedGeometry> SimplifiedGeometryCache::insert(const FlightProcedure& procedure) {
+    auto entry = std::make_shared<SimplifiedGeometry>();
+    entry->procedure_id = procedure.id;
+    entry->updated_at = procedure.updated_at;
+    if (procedure.trajectory_geometry) {
+        entry->trajectory_size = procedure.trajectory_geometry->size();
+        entry->trajectory = buildLevels(*procedure.trajectory_geometry);
+    }
+    if (procedure.protection_geometry) {
+        entry->protection_size = procedure.protection_geometry->size();
+        entry->protection = buildLevels(*procedure.protection_geometry);
+    }
+
+    publish(entry);
+    DiskCache::getInstance().put(diskKey(procedure),
+                                 nlohmann::json{{"trajectory", levelsToJson(entry->trajectory)},
+                                                {"protection", levelsToJson(entry->protection)}}
+                                     .dump());
+    return entry;
+}
+
+void SimplifiedGeometryCache::publish(const std::shared_ptr<const SimplifiedGeometry>& entry) {
+    entries_.update([&](std::shared_ptr<const Entries> current) {
+        auto next = current ? std::make_shared<Entries>(*current) : std::make_shared<Entries>();
+        (*next)[entry->procedure_id] = entry;
+        return std::shared_ptr<const Entries>(std::move(next));
+    });
+}
+
+std::shared_ptr<const SimplifiedGeometry> SimplifiedGeometryCache::load(const FlightProcedure& procedure) {
+    auto stored = DiskCache::getInstance().get(diskKey(procedure));
+    if (!stored) {
+        return nullptr;
+    }
+    auto document = nlohmann::json::parse(*stored, nullptr, false);
+    auto entry = std::make_shared<SimplifiedGeometry>();
+    if (document.is_discarded() || !levelsFromJson(document["trajectory"], entry->trajectory) ||
+        !levelsFromJson(document["protection"], entry->protection)) {
+        return nullptr;
+    }
+    entry->procedure_id = procedure.id;
+    entry->updated_at = procedure.updated_at;
+    entry->trajectory_size = procedure.trajectory_geometry ? procedure.trajectory_geometry->size() : 0;
+    entry->protection_size = procedure.protection_geometry ? procedure.protection_geometry->size() : 0;
+    publish(entry);
+    return entry;
+}
+
+void SimplifiedGeometryCache::apply(FlightProcedure& procedure, size_t level) {
+    auto entry = find(procedure);
+    if (!entry) {
+        entry = load(procedure);
+    }
+    if (!entry) {
+        entry = insert(procedure);
+    }
+    if (procedure.trajectory_geometry && entry->trajectory[level]) {
+        procedure.trajectory_geometry = *entry->trajectory[level];
+    }
+    if (procedure.protection_geometry && entry->protection[level]) {
+        procedure.protection_geometry = *entry->protection[level];
+    }
+}
+
+std::shared_ptr<const SimplifiedGeometry> SimplifiedGeometryCache::current(int procedure_id) const {
+    auto entries = entries_.load();
+    if (!entries) {
+        return nullptr;
+    }
+    auto it = entries->find(procedure_id);
+    // An entry built from a projected read may lack a geometry the procedure has
+    if (it == entries->end() || it->second->trajectory_size == 0 || it->second->protection_size == 0) {
+        return nullptr;
+    }
+    return it->second;
+}
+
+void SimplifiedGeometryCache::invalidate(int procedure_id) {
+    entries_.update([&](std::shared_ptr<const Entries> current) {
+        if (!current || !current->count(procedure_id)) {
+            return current;
+        }
+        auto next = std::make_shared<Entries>(*current);
+        next->erase(procedure_id);
+        return std::shared_ptr<const Entries>(std::move(next));
+    });
+}
+
+size_t SimplifiedGeometryCache::size() const {
+    auto entries = entries_.load();
+    return entries ? entries->size() : 0;
+}
+
+std::string SimplifiedGeometryCache::simplifyGeoJson(std::string_view geojson, double tolerance) {
+    nlohmann::json document = nlohmann::json::parse(geojson, nullptr, false);
+    if (document.is_discarded()) {
+        return {};
+    }
+    simplifyNode(document, tolerance);
+    return document.dump();
+}
+
+} // namespace aeronautical
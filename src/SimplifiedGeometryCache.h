@@ -0,0 +1,88 @@
+#pragma once
+
+#include "FlightProcedure.h"
+#include "SnapshotPublisher.h"
+#include <crow.h>
+#include <array>
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace aeronautical {
+
+// Douglas-Peucker simplified copies of a procedure's trajectory and
+// protection geometry, one per level. Level i drops detail finer than one
+// 256 px tile pixel at zoom kLevelZooms[i]; a map view at zoom z uses the
+// first level at or above z, and deeper zooms get the stored geometry.
+struct SimplifiedGeometry {
+    static constexpr std::array<int, 5> kLevelZooms{4, 6, 8, 10, 12};
+
+    int procedure_id = 0;
+    std::chrono::system_clock::time_point updated_at;
+    size_t trajectory_size = 0;  // source text lengths, a cheap second check
+    size_t protection_size = 0;
+    std::array<std::optional<std::string>, kLevelZooms.size()> trajectory;
+    std::array<std::optional<std::string>, kLevelZooms.size()> protection;
+};
+
+// Process-wide cache of SimplifiedGeometry keyed by procedure id and
+// updated_at, like ProtectionGeometryCache. Saving a procedure builds its
+// levels up front; anything else is built on first request. Built levels
+// are also written to the DiskCache, where a miss looks before building,
+// so a restart does not simplify every procedure again. Analysis keeps
+// reading the full-resolution geometry from the repository. Lookups read a
+// published map without a lock; an insert or invalidation publishes a copy.
+class SimplifiedGeometryCache {
+public:
+    static SimplifiedGeometryCache& getInstance();
+
+    SimplifiedGeometryCache(const SimplifiedGeometryCache&) = delete;
+    SimplifiedGeometryCache& operator=(const SimplifiedGeometryCache&) = delete;
+
+    // Tolerance of a level in degrees of longitude (Web Mercator pixel width)
+    static double tolerance(size_t level);
+    static double pixelDegrees(int zoom);
+
+    // ?zoom=<0..24> or ?simplify=<tolerance in degrees>; level is left empty
+    // for full resolution. False with error set for a malformed value.
+    static bool fromRequest(const crow::request& req, std::optional<size_t>& level, std::string& error);
+    // The same from "zoom" or "simplify" members of a JSON request body
+    static bool fromJson(const nlohmann::json& body, std::optional<size_t>& level, std::string& error);
+
+    // Builds and publishes every level for this procedure version
+    std::shared_ptr<const SimplifiedGeometry> insert(const FlightProcedure& procedure);
+
+    // Replaces the procedure's geometries with their copy at level
+    void apply(FlightProcedure& procedure, size_t level);
+
+    // The published entry of a procedure, without a version check, when it
+    // holds both geometries: saves and deletes here and in other instances
+    // (CacheEvents) invalidate entries, so one that is there is current.
+    // Lets a caller skip the database; nullptr when not cached.
+    std::shared_ptr<const SimplifiedGeometry> current(int procedure_id) const;
+
+    void invalidate(int procedure_id);
+    size_t size() const;
+
+    // Simplified GeoJSON text; empty when the input does not parse
+    static std::string simplifyGeoJson(std::string_view geojson, double tolerance);
+
+private:
+    SimplifiedGeometryCache() = default;
+
+    // Coarsest level whose tolerance still fits a wanted one; empty for full resolution
+    static std::optional<size_t> levelFor(double wanted);
+
+    std::shared_ptr<const SimplifiedGeometry> find(const FlightProcedure& procedure) const;
+    // The procedure version's levels from the DiskCache, published; nullptr when not there
+    std::shared_ptr<const SimplifiedGeometry> load(const FlightProcedure& procedure);
+    void publish(const std::shared_ptr<const SimplifiedGeometry>& entry);
+
+    using Entries = std::unordered_map<int, std::shared_ptr<const SimplifiedGeometry>>;
+    SnapshotPublisher<Entries> entries_;
+};
+
+} // namespace aeronautical
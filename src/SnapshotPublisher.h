@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+namespace aeronautical {
+
+// The current version of a read model that many threads read and one
+// occasionally replaces. Readers take it with one atomic load and keep it
+// alive through the shared_ptr for as long as they use it; a writer builds
+// the next version off to the side and publishes it whole, so no reader ever
+// sees a half-made change. A version is never modified once published, and
+// the old one is freed when its last reader lets go.
+template <typename T>
+class SnapshotPublisher {
+public:
+    SnapshotPublisher() = default;
+    SnapshotPublisher(const SnapshotPublisher&) = delete;
+    SnapshotPublisher& operator=(const SnapshotPublisher&) = delete;
+
+    // nullptr until the first publish
+    std::shared_ptr<const T> load() const { return current_.load(std::memory_order_acquire); }
+
+    void publish(std::shared_ptr<const T> next) { current_.store(std::move(next), std::memory_order_release); }
+
+    // Publishes derive(current); writers going through here run one at a
+    // time, so none of them loses another's change. derive returns the next
+    // version, or the one it was given to leave things as they are.
+    template <typename Derive>
+    std::shared_ptr<const T> update(Derive&& derive) {
+        std::lock_guard<std::mutex> lock(writer_mutex_);
+        std::shared_ptr<const T> next = derive(load());
+        publish(next);
+        return next;
+    }
+
+private:
+    std::atomic<std::shared_ptr<const T>> current_;
+    std::mutex writer_mutex_;
+};
+
+} // namespace aeronautical
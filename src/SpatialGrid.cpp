@@ -0,0 +1,228 @@
+#include "SpatialGrid.h"
+#include "BoxFilter.h"
+#include <algorithm>
+#include <cmath>
+
+namespace aeronautical {
+
+namespace {
+
+// Into [-180, 180)
+double wrapLongitude(double lng) {
+    double wrapped = std::fmod(lng + 180.0, 360.0);
+    if (wrapped < 0.0) wrapped += 360.0;
+    return wrapped - 180.0;
+}
+
+constexpr double kEarthRadiusKm = 6371.0088;
+constexpr double kHalfCircumferenceKm = M_PI * kEarthRadiusKm;
+constexpr double kDegToRad = M_PI / 180.0;
+
+int latCell(double lat) {
+    return std::clamp(static_cast<int>(std::floor(lat + 90.0)), 0, 179);
+}
+
+int lngCell(double lng) {
+    return std::clamp(static_cast<int>(std::floor(lng + 180.0)), 0, 359);
+}
+
+} // namespace
+
+std::optional<GeoBounds> GeoBounds::fromBox(double min_lat, double max_lat, double min_lng, double max_lng) {
+    if (!std::isfinite(min_lat) || !std::isfinite(max_lat) || !std::isfinite(min_lng) || !std::isfinite(max_lng)) {
+        return std::nullopt;
+    }
+    if (min_lat > max_lat) {
+        return std::nullopt;
+    }
+
+    GeoBounds bounds;
+    bounds.min_lat = std::clamp(min_lat, -90.0, 90.0);
+    bounds.max_lat = std::clamp(max_lat, -90.0, 90.0);
+
+    double width = max_lng - min_lng;
+    if (width < 0.0) {
+        width += 360.0; // "170 .. -170" form
+    }
+    if (width >= 360.0) {
+        bounds.lng_ranges.push_back({-180.0, 180.0});
+        return bounds;
+    }
+
+    double west = wrapLongitude(min_lng);
+    double east = west + width;
+    if (east <= 180.0) {
+        bounds.lng_ranges.push_back({west, east});
+    } else {
+        bounds.lng_ranges.push_back({west, 180.0});
+        bounds.lng_ranges.push_back({-180.0, east - 360.0});
+    }
+    return bounds;
+}
+
+std::optional<GeoBounds> GeoBounds::aroundPoint(double lat, double lng, double radius_km) {
+    if (!std::isfinite(lat) || !std::isfinite(lng) || !(radius_km >= 0.0)) {
+        return std::nullopt;
+    }
+    double angle = radius_km / kEarthRadiusKm;
+    double dlat = angle / kDegToRad;
+    double min_lat = lat - dlat;
+    double max_lat = lat + dlat;
+    if (min_lat <= -90.0 || max_lat >= 90.0) {
+        return fromBox(min_lat, max_lat, -180.0, 180.0);
+    }
+    // Longitude reach at the circle's widest point
+    double ratio = std::sin(angle) / std::cos(lat * kDegToRad);
+    if (angle >= M_PI / 2.0 || ratio >= 1.0) {
+        return fromBox(min_lat, max_lat, -180.0, 180.0);
+    }
+    double dlng = std::asin(ratio) / kDegToRad;
+    return fromBox(min_lat, max_lat, lng - dlng, lng + dlng);
+}
+
+double greatCircleKm(double lat1, double lng1, double lat2, double lng2) {
+    double dlat = (lat2 - lat1) * kDegToRad;
+    double dlng = (lng2 - lng1) * kDegToRad;
+    double a = std::sin(dlat / 2) * std::sin(dlat / 2) +
+               std::cos(lat1 * kDegToRad) * std::cos(lat2 * kDegToRad) * std::sin(dlng / 2) * std::sin(dlng / 2);
+    return 2.0 * kEarthRadiusKm * std::asin(std::min(1.0, std::sqrt(a)));
+}
+
+bool GeoBounds::contains(double lat, double lng) const {
+    if (!(lat >= min_lat && lat <= max_lat)) {
+        return false;
+    }
+    for (const auto& range : lng_ranges) {
+        if (lng >= range.min && lng <= range.max) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void SpatialGrid::build(std::vector<double> lat, std::vector<double> lng) {
+    cell_start_.assign(kLatCells * kLngCells + 1, 0);
+    cell_rows_.clear();
+    position_.assign(lat.size(), kNoPosition);
+
+    // Counting sort by cell; rows stay in ascending order within a cell
+    std::vector<int> cell_of(lat.size(), -1);
+    for (size_t i = 0; i < lat.size(); i++) {
+        if (!std::isfinite(lat[i]) || !std::isfinite(lng[i])) {
+            continue;
+        }
+        cell_of[i] = latCell(lat[i]) * kLngCells + lngCell(lng[i]);
+        cell_start_[cell_of[i] + 1]++;
+    }
+    for (size_t c = 1; c < cell_start_.size(); c++) {
+        cell_start_[c] += cell_start_[c - 1];
+    }
+
+    cell_rows_.resize(cell_start_.back());
+    lat_.resize(cell_rows_.size());
+    lng_.resize(cell_rows_.size());
+    std::vector<uint32_t> fill(cell_start_.begin(), cell_start_.end() - 1);
+    for (size_t i = 0; i < lat.size(); i++) {
+        if (cell_of[i] >= 0) {
+            const uint32_t k = fill[cell_of[i]]++;
+            cell_rows_[k] = static_cast<uint32_t>(i);
+            lat_[k] = lat[i];
+            lng_[k] = lng[i];
+            position_[i] = k;
+        }
+    }
+}
+
+std::vector<size_t> SpatialGrid::scan(const GeoBounds& bounds) const {
+    std::vector<uint32_t> hits(lat_.size());
+    size_t count = BoxFilter::select(lat_.data(), lng_.data(), lat_.size(), bounds, hits.data());
+    std::vector<size_t> rows(count);
+    for (size_t i = 0; i < count; i++) {
+        rows[i] = cell_rows_[hits[i]];
+    }
+    std::sort(rows.begin(), rows.end());
+    return rows;
+}
+
+std::vector<size_t> SpatialGrid::query(const GeoBounds& bounds) const {
+    std::vector<size_t> rows;
+    if (cell_start_.empty() || bounds.lng_ranges.empty()) {
+        return rows;
+    }
+
+    int lat_first = latCell(bounds.min_lat);
+    int lat_last = latCell(bounds.max_lat);
+
+    // Past a sixteenth of the rows, gathering cells and sorting costs more
+    // than one BoxFilter pass over the columns
+    size_t candidates = 0;
+    for (const auto& range : bounds.lng_ranges) {
+        int lng_first = lngCell(range.min);
+        int lng_last = lngCell(range.max);
+        for (int lat = lat_first; lat <= lat_last; lat++) {
+            candidates += cell_start_[lat * kLngCells + lng_last + 1] - cell_start_[lat * kLngCells + lng_first];
+        }
+    }
+    if (candidates * 16 > lat_.size()) {
+        return scan(bounds);
+    }
+    rows.reserve(candidates);
+
+    for (const auto& range : bounds.lng_ranges) {
+        int lng_first = lngCell(range.min);
+        int lng_last = lngCell(range.max);
+        for (int lat = lat_first; lat <= lat_last; lat++) {
+            // Cells of one latitude band are contiguous
+            uint32_t begin = cell_start_[lat * kLngCells + lng_first];
+            uint32_t end = cell_start_[lat * kLngCells + lng_last + 1];
+            for (uint32_t k = begin; k < end; k++) {
+                if (bounds.contains(lat_[k], lng_[k])) {
+                    rows.push_back(cell_rows_[k]);
+                }
+            }
+        }
+    }
+
+    // Both antimeridian halves can reach the cells at +/-180
+    std::sort(rows.begin(), rows.end());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+    return rows;
+}
+
+std::vector<std::pair<size_t, double>> SpatialGrid::nearest(double lat, double lng, size_t k,
+                                                            const std::function<bool(size_t)>& accept) const {
+    std::vector<std::pair<size_t, double>> found;
+    if (k == 0 || cell_start_.empty()) {
+        return found;
+    }
+
+    // Widen a circle until it holds k rows; every row inside the circle is
+    // inside its box, so the k nearest of those are the k nearest overall
+    for (double radius = 25.0;; radius *= 4.0) {
+        auto bounds = GeoBounds::aroundPoint(lat, lng, radius);
+        if (!bounds) {
+            return found;
+        }
+        found.clear();
+        bool whole_globe = radius >= kHalfCircumferenceKm;
+        for (size_t row : query(*bounds)) {
+            if (!accept(row)) continue;
+            const uint32_t k = position_[row];
+            double distance = greatCircleKm(lat, lng, lat_[k], lng_[k]);
+            if (whole_globe || distance <= radius) {
+                found.emplace_back(row, distance);
+            }
+        }
+        if (found.size() >= k || whole_globe) {
+            break;
+        }
+    }
+
+    auto closer = [](const auto& a, const auto& b) { return a.second != b.second ? a.second < b.second : a.first < b.first; };
+    size_t keep = std::min(k, found.size());
+    std::partial_sort(found.begin(), found.begin() + keep, found.end(), closer);
+    found.resize(keep);
+    return found;
+}
+
+} // namespace aeronautical
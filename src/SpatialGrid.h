@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace aeronautical {
+
+// A lat/lng query box split at the antimeridian. Longitudes may arrive
+// outside [-180, 180] (Leaflet reports e.g. west=170, east=200 after the map
+// wraps), or with min_lng > max_lng for a box that crosses 180.
+struct GeoBounds {
+    struct LngRange {
+        double min;
+        double max;
+    };
+
+    double min_lat = -90.0;
+    double max_lat = 90.0;
+    std::vector<LngRange> lng_ranges; // one, or two when crossing the antimeridian; each within [-180, 180]
+
+    // nullopt for non-finite values or min_lat > max_lat; latitudes are clamped to [-90, 90]
+    static std::optional<GeoBounds> fromBox(double min_lat, double max_lat, double min_lng, double max_lng);
+
+    // Smallest box holding every point within radius_km of (lat, lng); all
+    // longitudes once the circle reaches a pole
+    static std::optional<GeoBounds> aroundPoint(double lat, double lng, double radius_km);
+
+    bool contains(double lat, double lng) const;
+};
+
+// Haversine distance on the mean Earth sphere
+double greatCircleKm(double lat1, double lng1, double lat2, double lng2);
+
+// Uniform 1-degree grid over row indices, built once per reference snapshot.
+// Coordinates are kept as separate latitude and longitude columns in cell
+// order rather than row order, so the points of neighbouring cells are read
+// from one contiguous run whatever order the rows are in; a box whose cells
+// hold a large share of the rows is answered by one BoxFilter pass over the
+// columns instead. Rows with non-finite coordinates are never returned.
+class SpatialGrid {
+public:
+    template <typename T>
+    void build(const std::vector<T>& rows) {
+        std::vector<double> lat, lng;
+        lat.reserve(rows.size());
+        lng.reserve(rows.size());
+        for (const auto& row : rows) {
+            lat.push_back(row.latitude);
+            lng.push_back(row.longitude);
+        }
+        build(std::move(lat), std::move(lng));
+    }
+
+    // Indices of the rows inside bounds, in ascending order
+    std::vector<size_t> query(const GeoBounds& bounds) const;
+
+    // Up to k accepted rows nearest (lat, lng) with their great-circle
+    // distance in km, nearest first; ties by row
+    std::vector<std::pair<size_t, double>> nearest(double lat, double lng, size_t k,
+                                                   const std::function<bool(size_t)>& accept) const;
+
+private:
+    static constexpr int kLatCells = 180;
+    static constexpr int kLngCells = 360;
+
+    void build(std::vector<double> lat, std::vector<double> lng);
+    std::vector<size_t> scan(const GeoBounds& bounds) const;
+
+    static constexpr uint32_t kNoPosition = UINT32_MAX;
+
+    // Parallel to cell_rows_
+    std::vector<double> lat_;
+    std::vector<double> lng_;
+    std::vector<uint32_t> cell_start_; // kLatCells * kLngCells + 1 offsets into cell_rows_
+    std::vector<uint32_t> cell_rows_;
+    std::vector<uint32_t> position_;   // by row: its position in cell_rows_, or kNoPosition
+};
+
+} // namespace aeronautical
@@ -0,0 +1,195 @@
+#include "TerrainService.h"
+#include "GdalDrivers.h"
+#include "gdal_priv.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace aeronautical {
+
+namespace {
+
+constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+
+uint64_t tileKey(int tx, int ty) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(ty)) << 32) | static_cast<uint32_t>(tx);
+}
+
+} // namespace
+
+TerrainService& TerrainService::getInstance() {
+    static TerrainService instance;
+    return instance;
+}
+
+TerrainService::~TerrainService() {
+    if (dataset_) {
+        GDALClose(dataset_);
+    }
+}
+
+bool TerrainService::open(const std::string& path, size_t cache_tiles) {
+    registerGdalDrivers();
+    auto* dataset = static_cast<GDALDataset*>(GDALOpen(path.c_str(), GA_ReadOnly));
+    if (!dataset) {
+        spdlog::error("Could not open DEM {}: {}", path, CPLGetLastErrorMsg());
+        return false;
+    }
+
+    double transform[6];
+    if (dataset->GetRasterCount() < 1 || dataset->GetGeoTransform(transform) != CE_None ||
+        transform[2] != 0 || transform[4] != 0 || !GDALInvGeoTransform(transform, inverse_)) {
+        spdlog::error("DEM {} is not a north-up grid with a geotransform", path);
+        GDALClose(dataset);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    dataset_ = dataset;
+    width_ = dataset->GetRasterXSize();
+    height_ = dataset->GetRasterYSize();
+    capacity_ = std::max<size_t>(cache_tiles, 4);
+    spdlog::info("DEM {} opened: {}x{} pixels, {} tiles cached", path, width_, height_, capacity_);
+    return true;
+}
+
+std::shared_ptr<const TerrainService::Tile> TerrainService::tile(int tx, int ty) {
+    const uint64_t key = tileKey(tx, ty);
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = tiles_.find(key);
+    if (it != tiles_.end()) {
+        lru_.splice(lru_.begin(), lru_, it->second.position);
+        return it->second.tile;
+    }
+
+    auto decoded = std::make_shared<Tile>();
+    decoded->width = std::min(kTileSize, width_ - tx * kTileSize);
+    decoded->height = std::min(kTileSize, height_ - ty * kTileSize);
+    decoded->values.assign(static_cast<size_t>(decoded->width) * decoded->height, static_cast<float>(kNaN));
+
+    GDALRasterBand* band = dataset_->GetRasterBand(1);
+    if (band->RasterIO(GF_Read, tx * kTileSize, ty * kTileSize, decoded->width, decoded->height,
+                       decoded->values.data(), decoded->width, decoded->height, GDT_Float32, 0, 0) == CE_None) {
+        int has_nodata = FALSE;
+        const double nodata = band->GetNoDataValue(&has_nodata);
+        if (has_nodata) {
+            const float marker = static_cast<float>(nodata);
+            std::replace(decoded->values.begin(), decoded->values.end(), marker, static_cast<float>(kNaN));
+        }
+    } else {
+        // Kept as all nodata so a bad tile is not read again for every vertex
+        spdlog::warn("DEM tile {},{} could not be read: {}", tx, ty, CPLGetLastErrorMsg());
+        std::fill(decoded->values.begin(), decoded->values.end(), static_cast<float>(kNaN));
+    }
+
+    lru_.push_front(key);
+    tiles_.emplace(key, Entry{decoded, lru_.begin()});
+    while (tiles_.size() > capacity_) {
+        tiles_.erase(lru_.back());
+        lru_.pop_back();
+    }
+    return decoded;
+}
+
+void TerrainService::sample(std::span<const double> lng, std::span<const double> lat, std::span<double> out) {
+    if (!dataset_) {
+        std::fill(out.begin(), out.end(), kNaN);
+        return;
+    }
+
+    // Consecutive vertices mostly fall in the same tile; remember the last one
+    uint64_t last_key = std::numeric_limits<uint64_t>::max();
+    std::shared_ptr<const Tile> last;
+    auto pixel = [&](int px, int py) -> double {
+        const int tx = px / kTileSize;
+        const int ty = py / kTileSize;
+        const uint64_t key = tileKey(tx, ty);
+        if (key != last_key) {
+            last = tile(tx, ty);
+            last_key = key;
+        }
+        return last->values[static_cast<size_t>(py - ty * kTileSize) * last->width + (px - tx * kTileSize)];
+    };
+
+    for (size_t i = 0; i < out.size(); i++) {
+        // Pixel coordinates relative to pixel centres
+        const double fx = inverse_[0] + inverse_[1] * lng[i] + inverse_[2] * lat[i] - 0.5;
+        const double fy = inverse_[3] + inverse_[4] * lng[i] + inverse_[5] * lat[i] - 0.5;
+        if (!(fx >= -0.5 && fy >= -0.5 && fx <= width_ - 0.5 && fy <= height_ - 0.5)) {
+            out[i] = kNaN;
+            continue;
+        }
+        // Edge pixels are clamped, so the outer half pixel repeats the edge
+        const int x0 = std::clamp(static_cast<int>(std::floor(fx)), 0, width_ - 1);
+        const int y0 = std::clamp(static_cast<int>(std::floor(fy)), 0, height_ - 1);
+        const int x1 = std::min(x0 + 1, width_ - 1);
+        const int y1 = std::min(y0 + 1, height_ - 1);
+        const double wx = std::clamp(fx - x0, 0.0, 1.0);
+        const double wy = std::clamp(fy - y0, 0.0, 1.0);
+        const double top = pixel(x0, y0) * (1 - wx) + pixel(x1, y0) * wx;
+        const double bottom = pixel(x0, y1) * (1 - wx) + pixel(x1, y1) * wx;
+        out[i] = top * (1 - wy) + bottom * wy;
+    }
+}
+
+std::optional<ElevationRange> TerrainService::rangeUnder(std::span<const OGRGeometry* const> geometries) {
+    if (!dataset_) {
+        return std::nullopt;
+    }
+
+    std::vector<double> lng;
+    std::vector<double> lat;
+    auto visit = [&](const OGRGeometry& geometry, auto& self) -> void {
+        switch (wkbFlatten(geometry.getGeometryType())) {
+            case wkbPoint: {
+                const auto* point = geometry.toPoint();
+                if (point->IsEmpty()) break;
+                lng.push_back(point->getX());
+                lat.push_back(point->getY());
+                break;
+            }
+            case wkbLineString:
+            case wkbLinearRing: {
+                const auto* line = geometry.toLineString();
+                for (int i = 0; i < line->getNumPoints(); i++) {
+                    lng.push_back(line->getX(i));
+                    lat.push_back(line->getY(i));
+                }
+                break;
+            }
+            case wkbPolygon:
+                for (const auto* ring : *geometry.toPolygon()) self(*ring, self);
+                break;
+            case wkbMultiPoint:
+            case wkbMultiLineString:
+            case wkbMultiPolygon:
+            case wkbGeometryCollection: {
+                const auto* collection = geometry.toGeometryCollection();
+                for (int i = 0; i < collection->getNumGeometries(); i++) self(*collection->getGeometryRef(i), self);
+                break;
+            }
+            default:
+                break;
+        }
+    };
+    for (const OGRGeometry* geometry : geometries) {
+        if (geometry) visit(*geometry, visit);
+    }
+
+    std::vector<double> heights(lng.size());
+    sample(lng, lat, heights);
+    std::optional<ElevationRange> range;
+    for (double height : heights) {
+        if (std::isnan(height)) continue;
+        if (!range) {
+            range = ElevationRange{height, height};
+        } else {
+            range->min_m = std::min(range->min_m, height);
+            range->max_m = std::max(range->max_m, height);
+        }
+    }
+    return range;
+}
+
+} // namespace aeronautical
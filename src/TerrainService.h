@@ -0,0 +1,79 @@
+#pragma once
+
+#include "ogr_geometry.h"
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class GDALDataset;
+
+namespace aeronautical {
+
+// Terrain heights under a set of positions, metres above mean sea level
+struct ElevationRange {
+    double min_m = 0;
+    double max_m = 0;
+};
+
+// Terrain elevation from a DEM raster read through GDAL (GeoTIFF, VRT, ...)
+// in WGS84 longitude/latitude, north up, band 1 in metres. The raster is
+// read in kTileSize square tiles that are decoded once and kept in an LRU
+// cache, so a batch of vertices costs one read per tile it touches rather
+// than one per vertex. Values are bilinear between pixel centres.
+class TerrainService {
+public:
+    static TerrainService& getInstance();
+
+    TerrainService(const TerrainService&) = delete;
+    TerrainService& operator=(const TerrainService&) = delete;
+
+    static constexpr int kTileSize = 256;
+
+    // Opens the DEM once at startup; false (and disabled) when it cannot be
+    // opened or is not a north-up geographic grid
+    bool open(const std::string& path, size_t cache_tiles);
+    bool enabled() const { return dataset_ != nullptr; }
+
+    // Elevation at each (lng[i], lat[i]) into out[i]; NaN outside the DEM or
+    // next to a nodata pixel. The spans have equal sizes.
+    void sample(std::span<const double> lng, std::span<const double> lat, std::span<double> out);
+
+    // Lowest and highest terrain under the vertices of the geometries;
+    // nullopt when disabled or no vertex has a value
+    std::optional<ElevationRange> rangeUnder(std::span<const OGRGeometry* const> geometries);
+
+private:
+    TerrainService() = default;
+    ~TerrainService();
+
+    struct Tile {
+        int width = 0; // smaller at the right and bottom edges
+        int height = 0;
+        std::vector<float> values; // row major; NaN for nodata
+    };
+
+    // Decoded tile (tx, ty), read on a miss
+    std::shared_ptr<const Tile> tile(int tx, int ty);
+
+    GDALDataset* dataset_ = nullptr;
+    double inverse_[6] = {};
+    int width_ = 0;
+    int height_ = 0;
+
+    std::mutex mutex_; // cache and dataset reads
+    size_t capacity_ = 0;
+    std::list<uint64_t> lru_; // most recent first
+    struct Entry {
+        std::shared_ptr<const Tile> tile;
+        std::list<uint64_t>::iterator position;
+    };
+    std::unordered_map<uint64_t, Entry> tiles_;
+};
+
+} // namespace aeronautical
@@ -0,0 +1,270 @@
+#include "ThreadPool.h"
+#include "MemoryArenas.h"
+#include <spdlog/spdlog.h>
+#include <iterator>
+
+namespace aeronautical {
+
+namespace {
+
+// Identifies the pool and worker slot of the current thread, if any
+thread_local const ThreadPool* current_pool = nullptr;
+thread_local size_t current_worker = 0;
+
+} // namespace
+
+ThreadPool::ThreadPool(size_t threads, std::string name, CpuSet cpus, bool numa_aware)
+    : name_(std::move(name)), cpus_(std::move(cpus)) {
+    if (threads == 0) {
+        threads = 1;
+    }
+
+    if (numa_aware && threads > 1) {
+        for (auto& node : numaNodes()) {
+            CpuSet node_cpus;
+            if (cpus_.empty()) {
+                node_cpus = std::move(node.cpus);
+            } else {
+                std::set_intersection(node.cpus.begin(), node.cpus.end(), cpus_.begin(), cpus_.end(),
+                                      std::back_inserter(node_cpus));
+            }
+            if (node_cpus.empty()) continue;
+            auto slot = std::make_unique<Node>();
+            slot->id = node.id;
+            slot->cpus = std::move(node_cpus);
+            nodes_.push_back(std::move(slot));
+        }
+        if (nodes_.size() < 2) {
+            nodes_.clear();
+        }
+    }
+
+    workers_.reserve(threads);
+    for (size_t i = 0; i < threads; i++) {
+        auto worker = std::make_unique<Worker>();
+        if (!nodes_.empty()) {
+            worker->node = i % nodes_.size();
+            nodes_[worker->node]->workers.push_back(i);
+        }
+        workers_.push_back(std::move(worker));
+    }
+    for (size_t i = 0; i < threads; i++) {
+        auto& victims = workers_[i]->victims;
+        for (size_t offset = 1; offset < threads; offset++) {
+            const size_t other = (i + offset) % threads;
+            if (workers_[other]->node == workers_[i]->node) victims.push_back(other);
+        }
+        for (size_t offset = 1; offset < threads; offset++) {
+            const size_t other = (i + offset) % threads;
+            if (workers_[other]->node != workers_[i]->node) victims.push_back(other);
+        }
+    }
+
+    threads_.reserve(threads);
+    for (size_t i = 0; i < threads; i++) {
+        threads_.emplace_back([this, i]() { workerLoop(i); });
+    }
+
+    if (!nodes_.empty()) {
+        std::string layout;
+        for (const auto& node : nodes_) {
+            if (!layout.empty()) layout += ", ";
+            layout += fmt::format("node {}: {} on CPUs {}", node->id, node->workers.size(), formatCpuList(node->cpus));
+        }
+        spdlog::info("Thread pool '{}' started with {} workers ({})", name_, threads, layout);
+    } else if (cpus_.empty()) {
+        spdlog::info("Thread pool '{}' started with {} workers", name_, threads);
+    } else {
+        spdlog::info("Thread pool '{}' started with {} workers on CPUs {}", name_, threads, formatCpuList(cpus_));
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+
+    for (auto& thread : threads_) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+}
+
+void ThreadPool::post(Task task) {
+    size_t index;
+    if (current_pool == this) {
+        index = current_worker;
+    } else if (const int node = localNode(); node >= 0) {
+        auto& local = *nodes_[static_cast<size_t>(node)];
+        index = local.workers[local.next_worker.fetch_add(1, std::memory_order_relaxed) % local.workers.size()];
+    } else {
+        index = next_worker_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+    }
+
+    {
+        std::lock_guard lock(workers_[index]->mutex);
+        workers_[index]->queue.push_back(std::move(task));
+    }
+    pending_.fetch_add(1, std::memory_order_release);
+
+    {
+        // Taking the wake mutex orders this notify after a sleeper's predicate check
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+    }
+    wake_.notify_one();
+}
+
+bool ThreadPool::popTask(size_t index, Task& task) {
+    // Own queue first, newest task (best cache locality)
+    {
+        auto& own = *workers_[index];
+        std::lock_guard lock(own.mutex);
+        if (!own.queue.empty()) {
+            task = std::move(own.queue.back());
+            own.queue.pop_back();
+            pending_.fetch_sub(1, std::memory_order_acq_rel);
+            return true;
+        }
+    }
+
+    // Steal the oldest task from another worker, on this node first
+    for (size_t other : workers_[index]->victims) {
+        auto& victim = *workers_[other];
+        std::lock_guard lock(victim.mutex);
+        if (!victim.queue.empty()) {
+            task = std::move(victim.queue.front());
+            victim.queue.pop_front();
+            pending_.fetch_sub(1, std::memory_order_acq_rel);
+            stolen_.fetch_add(1, std::memory_order_relaxed);
+            if (victim.node != workers_[index]->node) stolen_remote_.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ThreadPool::workerLoop(size_t index) {
+    current_pool = this;
+    current_worker = index;
+    const Node* node = nodes_.empty() ? nullptr : nodes_[workers_[index]->node].get();
+    const CpuSet& cpus = node ? node->cpus : cpus_;
+    if (!pinCurrentThread(cpus)) {
+        spdlog::warn("Thread pool '{}' worker {} could not be pinned to CPUs {}", name_, index, formatCpuList(cpus));
+    }
+    // Pools named after a subsystem allocate from its arena, per node when there is one
+    auto& arenas = MemoryArenas::getInstance();
+    if (!node || arenas.bindCurrentThread(MemoryArenas::nodeArena(name_, node->id)) < 0) {
+        arenas.bindCurrentThread(name_);
+    }
+
+    while (true) {
+        Task task;
+        if (popTask(index, task)) {
+            busy_.fetch_add(1, std::memory_order_relaxed);
+            try {
+                task();
+            } catch (const std::exception& e) {
+                spdlog::error("Unhandled exception in thread pool '{}' task: {}", name_, e.what());
+            } catch (...) {
+                spdlog::error("Unhandled unknown exception in thread pool '{}' task", name_);
+            }
+            busy_.fetch_sub(1, std::memory_order_relaxed);
+            executed_.fetch_add(1, std::memory_order_relaxed);
+            if (node) nodes_[workers_[index]->node]->executed.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(wake_mutex_);
+        wake_.wait(lock, [this]() {
+            return stopping_ || pending_.load(std::memory_order_acquire) > 0;
+        });
+        if (stopping_ && pending_.load(std::memory_order_acquire) == 0) {
+            return;
+        }
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& fn) {
+    if (count == 0) {
+        return;
+    }
+
+    // Shared with helper tasks, some of which may only start after we return
+    struct State {
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> done{0};
+        size_t count = 0;
+        const std::function<void(size_t)>* fn = nullptr;
+        std::mutex mutex;
+        std::condition_variable finished;
+        std::exception_ptr error;
+    };
+
+    auto state = std::make_shared<State>();
+    state->count = count;
+    state->fn = &fn;
+
+    auto run = [](const std::shared_ptr<State>& s) {
+        size_t i;
+        while ((i = s->next.fetch_add(1, std::memory_order_relaxed)) < s->count) {
+            try {
+                (*s->fn)(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(s->mutex);
+                if (!s->error) {
+                    s->error = std::current_exception();
+                }
+            }
+            if (s->done.fetch_add(1, std::memory_order_acq_rel) + 1 == s->count) {
+                std::lock_guard<std::mutex> lock(s->mutex);
+                s->finished.notify_all();
+            }
+        }
+    };
+
+    const size_t helpers = std::min(count, threads_.size()) - (count <= threads_.size() ? 1 : 0);
+    for (size_t h = 0; h < helpers; h++) {
+        post([state, run]() { run(state); });
+    }
+
+    run(state);
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->finished.wait(lock, [&]() {
+        return state->done.load(std::memory_order_acquire) == state->count;
+    });
+
+    if (state->error) {
+        std::rethrow_exception(state->error);
+    }
+}
+
+ThreadPool::Stats ThreadPool::stats() const {
+    Stats s;
+    s.threads = threads_.size();
+    s.busy = busy_.load(std::memory_order_relaxed);
+    s.executed = executed_.load(std::memory_order_relaxed);
+    s.stolen = stolen_.load(std::memory_order_relaxed);
+    s.stolen_remote = stolen_remote_.load(std::memory_order_relaxed);
+    s.queued = pending_.load(std::memory_order_relaxed);
+    for (const auto& node : nodes_) {
+        s.nodes.push_back(node->id);
+        s.executed_by_node.push_back(node->executed.load(std::memory_order_relaxed));
+    }
+    return s;
+}
+
+int ThreadPool::localNode() const {
+    if (nodes_.empty()) return -1;
+    const int id = currentNumaNode();
+    for (size_t i = 0; i < nodes_.size(); i++) {
+        if (nodes_[i]->id == id) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+} // namespace aeronautical
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "CpuAffinity.h"
+#include "LockStats.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace aeronautical {
+
+// Fixed-size work-stealing pool. Each worker owns a deque: it pushes and pops
+// its own work LIFO and steals FIFO from the other workers when idle. Tasks
+// posted from outside the pool are spread round-robin across the workers.
+//
+// A NUMA-aware pool on a machine with several nodes splits its workers
+// between the nodes, pinned to each node's CPUs (within cpus when given)
+// and, with jemalloc, allocating from an arena of the node's own, so what a
+// task allocates is first touched, and kept, on its node. Tasks posted from
+// outside go to the workers of the poster's node, and an idle worker steals
+// from its own node before it takes work from another; those remote steals
+// are the tasks that run away from the memory they were posted with.
+class ThreadPool {
+public:
+    using Task = std::function<void()>;
+
+    struct Stats {
+        size_t threads = 0;
+        size_t busy = 0; // workers running a task
+        uint64_t executed = 0;
+        uint64_t stolen = 0;
+        uint64_t stolen_remote = 0; // from a worker on another NUMA node
+        size_t queued = 0;
+        std::vector<int> nodes;               // NUMA node ids; empty unless NUMA-aware
+        std::vector<uint64_t> executed_by_node; // same order as nodes
+    };
+
+    // Workers are pinned to cpus when it is not empty
+    explicit ThreadPool(size_t threads, std::string name = "pool", CpuSet cpus = {}, bool numa_aware = false);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void post(Task task);
+
+    template <typename F>
+    auto submit(F&& fn) -> std::future<std::invoke_result_t<std::decay_t<F>>> {
+        using Result = std::invoke_result_t<std::decay_t<F>>;
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(fn));
+        auto future = task->get_future();
+        post([task]() { (*task)(); });
+        return future;
+    }
+
+    // Runs fn(i) for every i in [0, count) and returns once all calls finished.
+    // The calling thread takes part, so this is safe to call from a pool worker.
+    // The first exception thrown by fn is rethrown here.
+    void parallelFor(size_t count, const std::function<void(size_t)>& fn);
+
+    size_t size() const { return threads_.size(); }
+    const std::string& name() const { return name_; }
+    Stats stats() const;
+
+private:
+    struct Worker {
+        std::deque<Task> queue;
+        InstrumentedMutex<std::mutex> mutex{"thread_pool_queue"};
+        size_t node = 0; // slot in nodes_
+        // Other workers in stealing order: own node first
+        std::vector<size_t> victims;
+    };
+    struct Node {
+        int id = 0;
+        CpuSet cpus;
+        std::vector<size_t> workers;
+        std::atomic<size_t> next_worker{0};
+        std::atomic<uint64_t> executed{0};
+    };
+
+    void workerLoop(size_t index);
+    bool popTask(size_t index, Task& task);
+    // Slot in nodes_ of the calling thread's node, or -1
+    int localNode() const;
+
+    std::string name_;
+    CpuSet cpus_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<std::unique_ptr<Node>> nodes_; // empty unless NUMA-aware on a NUMA machine
+    std::vector<std::thread> threads_;
+
+    std::mutex wake_mutex_;
+    std::condition_variable wake_;
+    std::atomic<size_t> pending_{0};
+    std::atomic<size_t> next_worker_{0};
+    std::atomic<uint64_t> executed_{0};
+    std::atomic<uint64_t> stolen_{0};
+    std::atomic<uint64_t> stolen_remote_{0};
+    std::atomic<size_t> busy_{0};
+    bool stopping_ = false;
+};
+
+} // namespace aeronautical
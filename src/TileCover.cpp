@@ -0,0 +1,120 @@
+#include "TileCover.h"
+#include "ResultCache.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+namespace aeronautical {
+
+namespace {
+
+constexpr double kMaxMercatorLat = 85.05112878;
+
+std::atomic<bool> snap_by_default{false};
+
+int tileX(int zoom, double lng) {
+    const int n = 1 << zoom;
+    return std::clamp(static_cast<int>(std::floor((lng + 180.0) / 360.0 * n)), 0, n - 1);
+}
+
+int tileY(int zoom, double lat) {
+    const int n = 1 << zoom;
+    const double rad = std::clamp(lat, -kMaxMercatorLat, kMaxMercatorLat) * M_PI / 180.0;
+    const double unit = (1.0 - std::log(std::tan(rad) + 1.0 / std::cos(rad)) / M_PI) / 2.0;
+    return std::clamp(static_cast<int>(std::floor(unit * n)), 0, n - 1);
+}
+
+// Tiles covering bounds at zoom, columns of both ranges when it crosses the antimeridian
+std::vector<TileCover::Tile> cover(const GeoBounds& bounds, int zoom) {
+    std::vector<int> columns;
+    for (const auto& range : bounds.lng_ranges) {
+        for (int x = tileX(zoom, range.min); x <= tileX(zoom, range.max); x++) {
+            if (std::find(columns.begin(), columns.end(), x) == columns.end()) columns.push_back(x);
+        }
+    }
+    std::vector<TileCover::Tile> tiles;
+    for (int y = tileY(zoom, bounds.max_lat); y <= tileY(zoom, bounds.min_lat); y++) {
+        for (int x : columns) {
+            tiles.push_back({x, y});
+        }
+    }
+    return tiles;
+}
+
+size_t coverSize(const GeoBounds& bounds, int zoom) {
+    size_t columns = 0;
+    for (const auto& range : bounds.lng_ranges) {
+        columns += static_cast<size_t>(tileX(zoom, range.max) - tileX(zoom, range.min) + 1);
+    }
+    return columns * static_cast<size_t>(tileY(zoom, bounds.min_lat) - tileY(zoom, bounds.max_lat) + 1);
+}
+
+} // namespace
+
+TileCover TileCover::of(const GeoBounds& bounds) {
+    TileCover result;
+    result.zoom = kMaxZoom;
+    while (result.zoom > 0 && coverSize(bounds, result.zoom) > kMaxTiles) {
+        result.zoom--;
+    }
+    result.tiles = cover(bounds, result.zoom);
+    return result;
+}
+
+TileCover::Tile TileCover::tileOf(int zoom, double lat, double lng) {
+    return {tileX(zoom, lng), tileY(zoom, lat)};
+}
+
+GeoBounds TileCover::tileBounds(int zoom, Tile tile) {
+    const double n = std::ldexp(1.0, zoom);
+    auto lat = [n](double ty) { return std::atan(std::sinh(M_PI * (1.0 - 2.0 * ty / n))) * 180.0 / M_PI; };
+    GeoBounds box;
+    box.max_lat = tile.y == 0 ? 90.0 : lat(tile.y);
+    box.min_lat = tile.y + 1 >= n ? -90.0 : lat(tile.y + 1);
+    box.lng_ranges.push_back({tile.x / n * 360.0 - 180.0, (tile.x + 1) / n * 360.0 - 180.0});
+    return box;
+}
+
+std::string TileCover::key(int zoom, Tile tile) {
+    return std::to_string(zoom) + "/" + std::to_string(tile.x) + "/" + std::to_string(tile.y);
+}
+
+std::string TileCover::body(const std::string& key_prefix, const Loader& load) const {
+    std::vector<std::shared_ptr<const Rows>> parts;
+    parts.reserve(tiles.size());
+    size_t bytes = 0;
+    for (const Tile& tile : tiles) {
+        parts.push_back(ResultCache::getInstance().get<Rows>(key_prefix + key(zoom, tile), {},
+                                                            [&]() { return load(zoom, tile); }));
+        bytes += parts.back()->json.size() + 1;
+    }
+
+    // Same layout as createSuccessResponse(...).dump(), plus the tiles served
+    std::string out;
+    out.reserve(bytes + 64 + tiles.size() * 16);
+    JsonWriter writer(out);
+    writer.beginObject().rawKey("data").beginArray();
+    for (const auto& part : parts) {
+        if (part->count > 0) writer.raw(part->json);
+    }
+    writer.endArray().rawKey("tiles").beginObject().rawField("zoom", zoom).rawKey("keys").beginArray();
+    for (const Tile& tile : tiles) {
+        writer.value(key(zoom, tile));
+    }
+    writer.endArray().endObject().rawField("status", "success").endObject();
+    return out;
+}
+
+void TileCover::setSnapByDefault(bool snap) {
+    snap_by_default.store(snap, std::memory_order_relaxed);
+}
+
+bool TileCover::snaps(const char* snap_param) {
+    if (!snap_param) {
+        return snap_by_default.load(std::memory_order_relaxed);
+    }
+    return std::strcmp(snap_param, "tiles") == 0;
+}
+
+} // namespace aeronautical
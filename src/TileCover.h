@@ -0,0 +1,72 @@
+#pragma once
+
+#include "JsonWriter.h"
+#include "SpatialGrid.h"
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace aeronautical {
+
+// The web mercator tiles (those of /tiles) a bounds query snaps to. Map
+// clients send whatever box their viewport gives, grown by a margin, so no
+// two /bounds queries repeat and none could be cached. Snapped, a query is
+// the union of the tiles covering its box at the deepest zoom where at most
+// kMaxTiles do, and each tile's rows are cached on their own: panning and
+// zooming a little reuse most of them. Every point falls in exactly one
+// tile of a zoom (the edge rows reach the poles), so the union repeats no
+// row; it does hold rows outside the box asked for, up to the tiles' edges.
+struct TileCover {
+    static constexpr size_t kMaxTiles = 16;
+    static constexpr int kMaxZoom = 16;
+
+    struct Tile {
+        int x = 0;
+        int y = 0;
+    };
+
+    // One tile's rows, serialized as the comma-separated members of a JSON array
+    struct Rows {
+        std::string json;
+        size_t count = 0;
+    };
+
+    int zoom = 0;
+    std::vector<Tile> tiles; // west to east, then north to south
+
+    static TileCover of(const GeoBounds& bounds);
+    static Tile tileOf(int zoom, double lat, double lng);
+    // Closed box of the tile: rows on its edges may belong to a neighbour
+    static GeoBounds tileBounds(int zoom, Tile tile);
+    static std::string key(int zoom, Tile tile);
+
+    // Rows of the tile among candidates queried with its tileBounds()
+    template <typename Row>
+    static Rows rowsIn(int zoom, Tile tile, const std::vector<const Row*>& candidates) {
+        Rows rows;
+        JsonWriter writer(rows.json);
+        writer.beginArray();
+        for (const Row* row : candidates) {
+            const Tile home = tileOf(zoom, row->latitude, row->longitude);
+            if (home.x != tile.x || home.y != tile.y) continue;
+            row->writeJson(writer);
+            rows.count++;
+        }
+        writer.endArray();
+        rows.json = rows.json.substr(1, rows.json.size() - 2);
+        return rows;
+    }
+
+    // List body in createSuccessResponse's layout plus "tiles": {"zoom", "keys"};
+    // each tile's rows come from ResultCache under key_prefix + key(), load()
+    // filling those missing. Keys must name the data version the rows are of.
+    using Loader = std::function<Rows(int zoom, Tile tile)>;
+    std::string body(const std::string& key_prefix, const Loader& load) const;
+
+    // Whether a request snaps: ?snap=tiles or ?snap=none, else the default
+    static void setSnapByDefault(bool snap);
+    static bool snaps(const char* snap_param);
+};
+
+} // namespace aeronautical
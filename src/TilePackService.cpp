@@ -0,0 +1,472 @@
+#include "TilePackService.h"
+#include "FileResponse.h"
+#include "FlightProcedure.h"
+#include "GdalDrivers.h"
+#include "ResponseCompression.h"
+#include "VectorTileService.h"
+#include "gdal.h"
+#include "ogrsf_frmts.h"
+#include "cpl_error.h"
+#include "cpl_string.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <map>
+
+namespace aeronautical {
+
+namespace {
+
+crow::response errorResponse(int code, const std::string& message) {
+    nlohmann::json response;
+    response["error"] = true;
+    response["message"] = message;
+    crow::response res(code, response.dump());
+    res.add_header("Content-Type", "application/json");
+    return res;
+}
+
+crow::response jsonResponse(int code, const nlohmann::json& body) {
+    crow::response res(code, body.dump());
+    res.add_header("Content-Type", "application/json");
+    return res;
+}
+
+const char* const kLayers[] = {"airports", "waypoints", "procedures", "protections"};
+// Web Mercator stops short of the poles
+constexpr double kMaxLatitude = 85.05112878;
+
+// Attributes per layer, as VectorTileService writes them, for the MBTiles
+// vector_layers metadata
+const std::map<std::string, std::vector<std::pair<const char*, const char*>>> kLayerFields = {
+    {"airports", {{"id", "Number"}, {"icao_code", "String"}, {"iata_code", "String"}, {"name", "String"},
+                  {"airport_type", "String"}, {"elevation_ft", "Number"}, {"country_code", "String"},
+                  {"count", "Number"}}},
+    {"waypoints", {{"id", "Number"}, {"waypoint_code", "String"}, {"name", "String"}, {"waypoint_type", "String"},
+                   {"usage_type", "String"}, {"country_code", "String"}, {"count", "Number"}}},
+    {"procedures", {{"id", "Number"}, {"procedure_code", "String"}, {"name", "String"}, {"type", "String"},
+                    {"airport_icao", "String"}}},
+    {"protections", {{"id", "Number"}, {"procedure_code", "String"}, {"name", "String"}, {"type", "String"},
+                     {"airport_icao", "String"}}},
+};
+
+int tileX(double lng, int z) {
+    const int n = 1 << z;
+    return std::clamp(static_cast<int>(std::floor((lng + 180.0) / 360.0 * n)), 0, n - 1);
+}
+
+int tileY(double lat, int z) {
+    const int n = 1 << z;
+    const double rad = std::clamp(lat, -kMaxLatitude, kMaxLatitude) * M_PI / 180.0;
+    const double y = (1.0 - std::asinh(std::tan(rad)) / M_PI) / 2.0 * n;
+    return std::clamp(static_cast<int>(std::floor(y)), 0, n - 1);
+}
+
+struct TileRange {
+    int z, min_x, max_x, min_y, max_y;
+    size_t count() const { return size_t(max_x - min_x + 1) * size_t(max_y - min_y + 1); }
+};
+
+std::vector<TileRange> tileRanges(double west, double south, double east, double north, int min_zoom,
+                                  int max_zoom) {
+    std::vector<TileRange> ranges;
+    for (int z = min_zoom; z <= max_zoom; z++) {
+        ranges.push_back({z, tileX(west, z), tileX(east, z), tileY(north, z), tileY(south, z)});
+    }
+    return ranges;
+}
+
+std::string sqlQuote(const std::string& text) {
+    std::string quoted = "'";
+    for (char c : text) {
+        if (c == '\'') quoted += '\'';
+        quoted += c;
+    }
+    return quoted + "'";
+}
+
+// Runs a statement that returns no rows
+bool execute(GDALDataset& dataset, const std::string& sql) {
+    CPLErrorReset();
+    OGRLayer* result = dataset.ExecuteSQL(sql.c_str(), nullptr, nullptr);
+    if (result) dataset.ReleaseResultSet(result);
+    return CPLGetLastErrorType() < CE_Failure;
+}
+
+// Closes the dataset on every path out of the pack
+struct Output {
+    GDALDataset* dataset = nullptr;
+
+    void close() {
+        if (!dataset) return;
+        GDALClose(GDALDataset::ToHandle(dataset));
+        dataset = nullptr;
+    }
+    ~Output() { close(); }
+};
+
+} // namespace
+
+TilePackService& TilePackService::getInstance() {
+    static TilePackService instance;
+    return instance;
+}
+
+TilePackService::TilePackService()
+    : jobs_("Tile pack job", [this](const Job& job) { return jobJson(job); },
+            [this](const Job& job) { removeJobFile(pathOf(job)); }) {}
+
+TilePackService::~TilePackService() {
+    shutdown();
+}
+
+void TilePackService::configure(const TilePackSettings& settings) {
+    settings_ = settings;
+    if (settings_.workers == 0) {
+        settings_.workers = std::max(1u, std::thread::hardware_concurrency() / 2);
+    }
+    settings_.max_jobs = std::max<size_t>(1, settings_.max_jobs);
+    settings_.max_tiles = std::max<size_t>(1, settings_.max_tiles);
+    if (settings_.directory.empty()) {
+        settings_.directory = (std::filesystem::temp_directory_path() / "aero-tilepacks").string();
+    }
+    if (settings_.enabled) {
+        std::error_code ec;
+        if (!prepareJobDirectory(settings_.directory, "tilepack-", ec)) {
+            spdlog::error("Tile pack directory {} is not usable: {}", settings_.directory, ec.message());
+            settings_.enabled = false;
+        }
+    }
+    if (settings_.enabled) {
+        jobs_.start(settings_.workers, "tile-packs", settings_.max_jobs, settings_.retention);
+    }
+    spdlog::info("Offline tile packs {}: {} workers, {} jobs at once, up to {} tiles, files in {}",
+                 settings_.enabled ? "enabled" : "disabled", settings_.workers, settings_.max_jobs,
+                 settings_.max_tiles, settings_.directory);
+}
+
+void TilePackService::shutdown() {
+    jobs_.shutdown(true); // joins once the running chunks are done
+}
+
+bool TilePackService::enabled() const {
+    return jobs_.running();
+}
+
+void TilePackService::registerRoutes(HttpApp& app) {
+    CROW_ROUTE(app, "/api/tile-packs")
+        .methods(crow::HTTPMethod::POST)
+        ([this](const crow::request& req) { return submit(req); });
+
+    CROW_ROUTE(app, "/api/tile-packs/<uint>")
+        .methods(crow::HTTPMethod::GET, crow::HTTPMethod::DELETE)
+        ([this](const crow::request& req, uint64_t id) {
+            if (req.method == crow::HTTPMethod::DELETE) return jobs_.remove(id);
+            return jobs_.status(id);
+        });
+
+    CROW_ROUTE(app, "/api/tile-packs/<uint>/file")
+        .methods(crow::HTTPMethod::GET)
+        ([this](const crow::request& req, crow::response& res, uint64_t id) {
+            download(req, res, id);
+            res.end();
+        });
+}
+
+crow::response TilePackService::submit(const crow::request& req) {
+    if (!enabled()) {
+        return errorResponse(503, "Offline tile packs are disabled");
+    }
+
+    Job job;
+    try {
+        auto body = nlohmann::json::parse(req.body);
+        const auto& bounds = body.at("bounds");
+        if (!bounds.is_array() || bounds.size() != 4) {
+            return errorResponse(400, "bounds must be [west, south, east, north]");
+        }
+        job.west = bounds[0].get<double>();
+        job.south = bounds[1].get<double>();
+        job.east = bounds[2].get<double>();
+        job.north = bounds[3].get<double>();
+        if (!(job.west >= -180 && job.east <= 180 && job.west < job.east && job.south >= -90 && job.north <= 90 &&
+              job.south < job.north)) {
+            return errorResponse(400, "bounds must be [west, south, east, north] in degrees, not across 180°");
+        }
+        job.min_zoom = body.value("min_zoom", 0);
+        job.max_zoom = body.value("max_zoom", 12);
+        if (job.min_zoom < 0 || job.max_zoom > kMaxZoom || job.min_zoom > job.max_zoom) {
+            return errorResponse(400, "Zoom levels must satisfy 0 <= min_zoom <= max_zoom <= " +
+                                          std::to_string(kMaxZoom));
+        }
+        if (body.contains("layers")) {
+            for (const auto& layer : body["layers"]) {
+                const auto name = layer.get<std::string>();
+                if (!kLayerFields.count(name)) {
+                    return errorResponse(400, "Unknown layer: " + name);
+                }
+                if (std::find(job.layers.begin(), job.layers.end(), name) == job.layers.end()) {
+                    job.layers.push_back(name);
+                }
+            }
+            if (job.layers.empty()) {
+                return errorResponse(400, "layers must name at least one layer");
+            }
+        } else {
+            job.layers.assign(std::begin(kLayers), std::end(kLayers));
+        }
+        job.name = body.value("name", "Offline pack");
+    } catch (const nlohmann::json::exception&) {
+        return errorResponse(400, "Expected {\"bounds\": [west, south, east, north], \"min_zoom\": ..., \"max_zoom\": ...}");
+    }
+
+    size_t tiles = 0;
+    for (const auto& range : tileRanges(job.west, job.south, job.east, job.north, job.min_zoom, job.max_zoom)) {
+        tiles += range.count();
+    }
+
+    if (tiles > settings_.max_tiles) {
+        return errorResponse(400, "The region holds " + std::to_string(tiles) + " tiles, more than the " +
+                                      std::to_string(settings_.max_tiles) + " a pack may hold");
+    }
+    job.progress->total.store(tiles, std::memory_order_relaxed);
+    const auto submitted = jobs_.submit(std::move(job), [this](uint64_t id) { process(id); });
+    if (!submitted) {
+        auto res = errorResponse(429, "Too many tile packs in progress, please retry later");
+        res.add_header("Retry-After", "60");
+        return res;
+    }
+    const uint64_t id = submitted->id;
+    spdlog::info("Queued tile pack job {} ({} tiles)", id, tiles);
+
+    nlohmann::json response;
+    response["message"] = "Tile pack accepted. Generation is in progress.";
+    response["job_id"] = id;
+    response["tiles"] = tiles;
+    response["status_url"] = "/api/tile-packs/" + std::to_string(id);
+    return jsonResponse(202, response);
+}
+
+void TilePackService::download(const crow::request& req, crow::response& res, uint64_t id) {
+    const auto job = jobs_.get(id);
+    if (!job) {
+        res = errorResponse(404, "Tile pack job not found");
+        return;
+    }
+    if (job->state != BackgroundJobState::Completed) {
+        res = errorResponse(409, "Tile pack is " + backgroundJobStateToString(job->state));
+        return;
+    }
+    // Packs run to hundreds of megabytes: sent with sendfile, and an
+    // interrupted download resumes with a Range request
+    FileResponse::prepare(req, res, pathOf(*job), "application/vnd.mapbox-vector-tile+sqlite3",
+                          "\"tilepack-" + std::to_string(id) + "\"");
+    res.add_header("Content-Disposition", "attachment; filename=\"tilepack-" + std::to_string(id) + ".mbtiles\"");
+}
+
+nlohmann::json TilePackService::jobJson(const Job& job) const {
+    nlohmann::json j = job.toJson();
+    j["name"] = job.name;
+    j["bounds"] = {job.west, job.south, job.east, job.north};
+    j["min_zoom"] = job.min_zoom;
+    j["max_zoom"] = job.max_zoom;
+    j["layers"] = job.layers;
+    j["total"] = job.progress->total.load(std::memory_order_relaxed);
+    j["done"] = job.progress->done.load(std::memory_order_relaxed);
+    j["written"] = job.progress->written.load(std::memory_order_relaxed);
+    if (job.state == BackgroundJobState::Completed) {
+        j["bytes"] = job.bytes;
+        j["file_url"] = "/api/tile-packs/" + std::to_string(job.id) + "/file";
+        j["expires_at"] = timePointToString(*job.finished_at + settings_.retention);
+    }
+    return j;
+}
+
+std::string TilePackService::pathOf(const Job& job) const {
+    return settings_.directory + "/tilepack-" + std::to_string(job.id) + ".mbtiles";
+}
+
+void TilePackService::process(uint64_t id) {
+    const auto queued = jobs_.get(id);
+    if (!queued) return;
+    const Job& job = *queued;
+    const std::string path = pathOf(job);
+    if (job.isCancelled()) {
+        jobs_.finish(id, std::nullopt);
+        return;
+    }
+    const auto started = std::chrono::steady_clock::now();
+    std::optional<std::string> error;
+    try {
+        error = write(job);
+    } catch (const std::exception& e) {
+        error = std::string("Tile pack failed: ") + e.what();
+    }
+    const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - started;
+    if (error) {
+        spdlog::error("Tile pack job {} failed after {:.0f} ms: {}", id, elapsed.count(), *error);
+    } else {
+        spdlog::info("Tile pack job {} done in {:.0f} ms: {} of {} tiles hold features, written to {}", id,
+                     elapsed.count(), job.progress->written.load(), job.progress->total.load(), path);
+        std::error_code ec;
+        const auto bytes = static_cast<size_t>(std::filesystem::file_size(path, ec));
+        jobs_.update(id, [bytes](Job& finished) { finished.bytes = bytes; });
+    }
+    if (jobs_.finish(id, std::move(error)) != BackgroundJobState::Completed) {
+        removeJobFile(path);
+    }
+}
+
+std::optional<std::string> TilePackService::write(const Job& job) {
+    Progress& progress = *job.progress;
+    const std::string path = pathOf(job);
+
+    registerGdalDrivers();
+    GDALDriver* driver = GetGDALDriverManager()->GetDriverByName("SQLite");
+    if (!driver) {
+        return std::string("GDAL was built without the SQLite driver");
+    }
+
+    jobs_.setStage(job.id, "creating");
+    Output output;
+    char** options = CSLSetNameValue(nullptr, "METADATA", "NO"); // no OGR geometry_columns tables
+    output.dataset = driver->Create(path.c_str(), 0, 0, 0, GDT_Unknown, options);
+    CSLDestroy(options);
+    if (!output.dataset) {
+        return std::string("Could not create the tile pack: ") + CPLGetLastErrorMsg();
+    }
+    GDALDataset& dataset = *output.dataset;
+
+    // MBTiles 1.3 schema
+    if (!execute(dataset, "CREATE TABLE metadata (name TEXT, value TEXT)") ||
+        !execute(dataset, "CREATE TABLE tiles (zoom_level INTEGER, tile_column INTEGER, tile_row INTEGER, "
+                          "tile_data BLOB)") ||
+        !execute(dataset, "CREATE UNIQUE INDEX tile_index ON tiles (zoom_level, tile_column, tile_row)")) {
+        return std::string("Could not create the MBTiles tables: ") + CPLGetLastErrorMsg();
+    }
+
+    nlohmann::json vector_layers = nlohmann::json::array();
+    for (const auto& layer : job.layers) {
+        nlohmann::json fields = nlohmann::json::object();
+        for (const auto& [field, type] : kLayerFields.at(layer)) {
+            fields[field] = type;
+        }
+        vector_layers.push_back({{"id", layer}, {"fields", fields}, {"minzoom", job.min_zoom},
+                                 {"maxzoom", job.max_zoom}});
+    }
+    const auto bounds = fmt::format("{},{},{},{}", job.west, std::max(job.south, -kMaxLatitude), job.east,
+                                    std::min(job.north, kMaxLatitude));
+    const auto center = fmt::format("{},{},{}", (job.west + job.east) / 2, (job.south + job.north) / 2,
+                                    job.min_zoom);
+    const std::pair<std::string, std::string> metadata[] = {
+        {"name", job.name},
+        {"format", "pbf"},
+        {"type", "overlay"},
+        {"version", "1"},
+        {"bounds", bounds},
+        {"center", center},
+        {"minzoom", std::to_string(job.min_zoom)},
+        {"maxzoom", std::to_string(job.max_zoom)},
+        {"generated", timePointToString(std::chrono::system_clock::now())},
+        {"json", nlohmann::json{{"vector_layers", vector_layers}}.dump()},
+    };
+    for (const auto& [name, value] : metadata) {
+        if (!execute(dataset, "INSERT INTO metadata (name, value) VALUES (" + sqlQuote(name) + ", " +
+                                  sqlQuote(value) + ")")) {
+            return std::string("Could not write the MBTiles metadata: ") + CPLGetLastErrorMsg();
+        }
+    }
+
+    OGRLayer* tiles = dataset.GetLayerByName("tiles");
+    if (!tiles) {
+        return std::string("Could not open the tiles table: ") + CPLGetLastErrorMsg();
+    }
+
+    struct Tile {
+        int z, x, y;
+        std::string data; // gzipped; empty when no layer has features
+    };
+    std::vector<Tile> chunk;
+    chunk.reserve(kChunkTiles);
+
+    ThreadPool* pool = jobs_.pool();
+    if (!pool) return "Tile packs are shutting down";
+    auto& tile_service = VectorTileService::getInstance();
+
+    auto flush = [&]() -> std::optional<std::string> {
+        // Rendered on every worker, the job thread included; the tile
+        // service's own cache answers the tiles the map already drew
+        pool->parallelFor(chunk.size(), [&](size_t i) {
+            if (job.isCancelled()) return;
+            Tile& tile = chunk[i];
+            std::string mvt;
+            for (const auto& layer : job.layers) {
+                mvt += *tile_service.tile(layer, tile.z, tile.x, tile.y, false);
+            }
+            if (!mvt.empty()) {
+                tile.data = ResponseCompression::compress(mvt, ResponseCompression::Encoding::Gzip, 6);
+                if (tile.data.empty()) throw std::runtime_error("Compressing a tile failed");
+            }
+        });
+        if (job.isCancelled()) return "Tile pack cancelled";
+
+        if (dataset.StartTransaction() != OGRERR_NONE) {
+            return std::string("Could not start a transaction: ") + CPLGetLastErrorMsg();
+        }
+        for (Tile& tile : chunk) {
+            if (tile.data.empty()) continue;
+            OGRFeature feature(tiles->GetLayerDefn());
+            feature.SetField("zoom_level", tile.z);
+            feature.SetField("tile_column", tile.x);
+            // MBTiles rows count from the bottom (TMS)
+            feature.SetField("tile_row", (1 << tile.z) - 1 - tile.y);
+            feature.SetField(feature.GetFieldIndex("tile_data"), static_cast<int>(tile.data.size()),
+                             reinterpret_cast<GByte*>(tile.data.data()));
+            if (tiles->CreateFeature(&feature) != OGRERR_NONE) {
+                dataset.RollbackTransaction();
+                return std::string("Could not write a tile: ") + CPLGetLastErrorMsg();
+            }
+            progress.written.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (dataset.CommitTransaction() != OGRERR_NONE) {
+            return std::string("Could not commit the tiles: ") + CPLGetLastErrorMsg();
+        }
+        progress.done.fetch_add(chunk.size(), std::memory_order_relaxed);
+        chunk.clear();
+        return std::nullopt;
+    };
+
+    jobs_.setStage(job.id, "rendering");
+    for (const auto& range : tileRanges(job.west, job.south, job.east, job.north, job.min_zoom, job.max_zoom)) {
+        for (int x = range.min_x; x <= range.max_x; x++) {
+            for (int y = range.min_y; y <= range.max_y; y++) {
+                chunk.push_back({range.z, x, y, {}});
+                if (chunk.size() >= kChunkTiles) {
+                    if (auto error = flush()) return error;
+                }
+            }
+        }
+    }
+    if (!chunk.empty()) {
+        if (auto error = flush()) return error;
+    }
+
+    jobs_.setStage(job.id, "closing");
+    output.close();
+    std::error_code ec;
+    if (!std::filesystem::is_regular_file(path, ec)) {
+        return std::string("Could not finish the tile pack: ") + CPLGetLastErrorMsg();
+    }
+    tiles_.fetch_add(progress.written.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    return std::nullopt;
+}
+
+nlohmann::json TilePackService::poolStats() const {
+    nlohmann::json j = jobs_.stats();
+    j["enabled"] = enabled();
+    j["tiles"] = tiles_.load(std::memory_order_relaxed);
+    return j;
+}
+
+} // namespace aeronautical
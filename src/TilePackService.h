@@ -0,0 +1,103 @@
+#pragma once
+
+#include <crow.h>
+#include "BackgroundJobs.h"
+#include "HttpApp.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include <json.hpp>
+
+namespace aeronautical {
+
+struct TilePackSettings {
+    bool enabled = true;
+    size_t workers = 0;                   // tile renderers; 0: half the cores
+    size_t max_jobs = 2;                  // packs queued or running before 429
+    size_t max_tiles = 250000;            // tiles per pack, over every zoom
+    std::string directory;                // empty: <temp>/aero-tilepacks
+    std::chrono::seconds retention{6 * 3600};
+};
+
+// Offline tile packs for field inspectors: the vector tiles of a region and
+// zoom range written into an MBTiles file (SQLite, gzipped MVT tiles in the
+// TMS row order) that mobile map clients open without a connection. Each
+// tile is read through VectorTileService::tile, so tiles the map has
+// already rendered come from its cache; the layers of a tile are
+// concatenated into one multi-layer MVT (a tile is a repeated protobuf
+// field, so this needs no re-encoding). Tiles are rendered in parallel
+// chunks on the pool, the job itself taking part, and each chunk is written
+// in one SQLite transaction by the job.
+//
+//   POST   /api/tile-packs             {"bounds": [west, south, east, north], "min_zoom": 6, "max_zoom": 12,
+//                                       "layers"?: ["airports", "waypoints", "procedures", "protections"],
+//                                       "name"?: "..."}; 202 with the job
+//   GET    /api/tile-packs/<id>        state, stage and tiles done of the total
+//   GET    /api/tile-packs/<id>/file   the .mbtiles, once completed (sendfile, ranges)
+//   DELETE /api/tile-packs/<id>        cancels the job and removes its file
+class TilePackService {
+public:
+    static TilePackService& getInstance();
+
+    TilePackService(const TilePackService&) = delete;
+    TilePackService& operator=(const TilePackService&) = delete;
+
+    // Starts the renderers over an emptied pack directory; routes answer
+    // 503 until then or when disabled
+    void configure(const TilePackSettings& settings);
+    // Cancels the running packs and joins the workers
+    void shutdown();
+    bool enabled() const;
+
+    void registerRoutes(HttpApp& app);
+
+    nlohmann::json poolStats() const;
+
+    static constexpr int kMaxZoom = 16;
+
+private:
+    struct Progress {
+        std::atomic<size_t> total{0};
+        std::atomic<size_t> done{0};
+        std::atomic<size_t> written{0}; // tiles with features; empty ones are left out
+    };
+
+    struct Job : BackgroundJob {
+        std::string name;
+        double west = 0, south = 0, east = 0, north = 0;
+        int min_zoom = 0;
+        int max_zoom = 0;
+        std::vector<std::string> layers;
+        size_t bytes = 0;
+        std::shared_ptr<Progress> progress = std::make_shared<Progress>();
+    };
+
+    TilePackService();
+    ~TilePackService();
+
+    crow::response submit(const crow::request& req);
+    void download(const crow::request& req, crow::response& res, uint64_t id);
+
+    // Runs on the pool
+    void process(uint64_t id);
+    // Writes the pack; returns the error, if any
+    std::optional<std::string> write(const Job& job);
+
+    nlohmann::json jobJson(const Job& job) const;
+    std::string pathOf(const Job& job) const;
+
+    // Tiles rendered in parallel, then written in one transaction
+    static constexpr size_t kChunkTiles = 256;
+
+    // Written by configure() before the jobs start
+    TilePackSettings settings_;
+    BackgroundJobs<Job> jobs_;
+
+    std::atomic<uint64_t> tiles_{0};
+};
+
+} // namespace aeronautical
@@ -0,0 +1,212 @@
+#include "TimeSchedule.h"
+#include <algorithm>
+#include <cctype>
+#include <optional>
+#include <spdlog/spdlog.h>
+#include <vector>
+
+namespace aeronautical {
+
+namespace {
+
+constexpr int kMinutesPerDay = 24 * 60;
+constexpr std::string_view kDays[7] = {"MON", "TUE", "WED", "THU", "FRI", "SAT", "SUN"};
+
+std::vector<std::string_view> split(std::string_view text, char separator) {
+    std::vector<std::string_view> parts;
+    size_t start = 0;
+    while (start <= text.size()) {
+        size_t end = text.find(separator, start);
+        if (end == std::string_view::npos) end = text.size();
+        parts.push_back(text.substr(start, end - start));
+        start = end + 1;
+    }
+    return parts;
+}
+
+std::optional<int> dayOf(std::string_view name) {
+    for (int day = 0; day < 7; day++) {
+        if (name == kDays[day]) return day;
+    }
+    return std::nullopt;
+}
+
+// MON, MON-FRI or lists of them
+bool parseDays(std::string_view token, std::bitset<7>& days) {
+    for (auto item : split(token, ',')) {
+        const size_t dash = item.find('-');
+        auto first = dayOf(item.substr(0, dash));
+        auto last = dash == std::string_view::npos ? first : dayOf(item.substr(dash + 1));
+        if (!first || !last) return false;
+        for (int day = *first;; day = (day + 1) % 7) {
+            days.set(day);
+            if (day == *last) break;
+        }
+    }
+    return true;
+}
+
+// HHMM or HH:MM, with an optional trailing Z; 2400 is the end of the day
+std::optional<int> minuteOf(std::string_view text) {
+    if (!text.empty() && text.back() == 'Z') text.remove_suffix(1);
+    std::string digits;
+    for (char c : text) {
+        if (c == ':') continue;
+        if (!std::isdigit(static_cast<unsigned char>(c))) return std::nullopt;
+        digits += c;
+    }
+    if (digits.size() != 4) return std::nullopt;
+    const int hours = std::stoi(digits.substr(0, 2));
+    const int minutes = std::stoi(digits.substr(2, 2));
+    if (minutes >= 60 || hours > 24 || (hours == 24 && minutes != 0)) return std::nullopt;
+    return hours * 60 + minutes;
+}
+
+bool parseTimes(std::string_view token, std::vector<std::pair<int, int>>& times) {
+    for (auto item : split(token, ',')) {
+        const size_t dash = item.find('-');
+        if (dash == std::string_view::npos) return false;
+        auto from = minuteOf(item.substr(0, dash));
+        auto to = minuteOf(item.substr(dash + 1));
+        if (!from || !to) return false;
+        times.emplace_back(*from, *to);
+    }
+    return true;
+}
+
+} // namespace
+
+TimeSchedule TimeSchedule::always() {
+    TimeSchedule schedule;
+    schedule.slots_.set();
+    schedule.finish();
+    return schedule;
+}
+
+TimeSchedule TimeSchedule::compile(std::string_view text, bool* understood) {
+    std::string upper(text);
+    std::transform(upper.begin(), upper.end(), upper.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::toupper(c)); });
+
+    TimeSchedule schedule;
+    bool ok = true;
+    for (auto clause : split(upper, ';')) {
+        std::bitset<7> days;
+        std::vector<std::pair<int, int>> times;
+        bool empty = true;
+        size_t start = 0;
+        while (ok && start < clause.size()) {
+            start = clause.find_first_not_of(" \t\r\n", start);
+            if (start == std::string_view::npos) break;
+            size_t end = clause.find_first_of(" \t\r\n", start);
+            if (end == std::string_view::npos) end = clause.size();
+            const auto token = clause.substr(start, end - start);
+            start = end;
+            empty = false;
+            if (token == "H24") {
+                times.emplace_back(0, kMinutesPerDay);
+            } else if (token == "DAILY" || token == "DLY") {
+                days.set();
+            } else if (token == "UTC") {
+                continue;
+            } else if (!parseDays(token, days) && !parseTimes(token, times)) {
+                ok = false;
+            }
+        }
+        if (!ok) break;
+        if (empty) continue;
+        if (days.none()) days.set();
+        if (times.empty()) times.emplace_back(0, kMinutesPerDay);
+        for (int day = 0; day < 7; day++) {
+            if (!days.test(day)) continue;
+            for (const auto& [from, to] : times) schedule.set(day, from, to);
+        }
+    }
+    if (understood) *understood = ok;
+    if (!ok) {
+        return always();
+    }
+    schedule.finish();
+    return schedule;
+}
+
+// Every quarter hour the interval touches; an interval ending at or before
+// its start runs past midnight into the next day, and one with equal ends
+// is the whole day
+void TimeSchedule::set(int day, int from_minute, int to_minute) {
+    auto mark = [this](int first_minute, int end_minute) {
+        const int first = first_minute / kSlotMinutes;
+        const int end = (end_minute + kSlotMinutes - 1) / kSlotMinutes;
+        for (int slot = first; slot < end; slot++) slots_.set(slot % kSlots);
+    };
+    const int base = day * kMinutesPerDay;
+    if (from_minute == to_minute) {
+        mark(base, base + kMinutesPerDay);
+    } else if (from_minute < to_minute) {
+        mark(base + from_minute, base + to_minute);
+    } else {
+        mark(base + from_minute, base + kMinutesPerDay + to_minute);
+    }
+}
+
+void TimeSchedule::finish() {
+    count_[0] = 0;
+    for (int slot = 0; slot < kSlots; slot++) {
+        count_[slot + 1] = static_cast<uint16_t>(count_[slot] + (slots_.test(slot) ? 1 : 0));
+    }
+}
+
+int TimeSchedule::slotOf(std::chrono::system_clock::time_point t) {
+    const int64_t seconds = std::chrono::duration_cast<std::chrono::seconds>(t.time_since_epoch()).count();
+    int64_t days = seconds / 86400;
+    if (seconds % 86400 < 0) days--;
+    const int64_t minute = (seconds - days * 86400) / 60;
+    // 1970-01-01 was a Thursday
+    const int64_t weekday = ((days + 3) % 7 + 7) % 7;
+    return static_cast<int>(weekday * kSlotsPerDay + minute / kSlotMinutes);
+}
+
+bool TimeSchedule::activeAt(std::chrono::system_clock::time_point t) const {
+    return slots_.test(slotOf(t));
+}
+
+bool TimeSchedule::activeBetween(std::chrono::system_clock::time_point from,
+                                 std::chrono::system_clock::time_point to) const {
+    if (to <= from) {
+        return activeAt(from);
+    }
+    if (to - from >= std::chrono::hours(24 * 7) - std::chrono::minutes(kSlotMinutes)) {
+        return !isNever();
+    }
+    const int first = slotOf(from);
+    const int last = slotOf(to);
+    if (first <= last) {
+        return count_[last + 1] - count_[first] > 0;
+    }
+    return count_[kSlots] - count_[first] + count_[last + 1] > 0;
+}
+
+TimeScheduleCache& TimeScheduleCache::getInstance() {
+    static TimeScheduleCache instance;
+    return instance;
+}
+
+std::shared_ptr<const TimeSchedule> TimeScheduleCache::get(const std::string& text) {
+    if (text.find_first_not_of(" \t\r\n") == std::string::npos) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = schedules_.find(text);
+    if (it != schedules_.end()) {
+        return it->second;
+    }
+    bool understood = true;
+    auto schedule = std::make_shared<const TimeSchedule>(TimeSchedule::compile(text, &understood));
+    if (!understood) {
+        spdlog::warn("Time restriction '{}' not understood, the zone is taken as always in force", text);
+    }
+    schedules_.emplace(text, schedule);
+    return schedule;
+}
+
+} // namespace aeronautical
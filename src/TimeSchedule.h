@@ -0,0 +1,80 @@
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace aeronautical {
+
+// Weekly hours of a protection's time_restriction, compiled once into one
+// bit per quarter hour of the week (UTC) with a running count over them, so
+// "in force at t" is one bit test and "in force at some point of [from, to]"
+// two lookups, however the text was written.
+//
+// The text is AIP/NOTAM style, clauses separated by ';':
+//   H24                       always
+//   MON-FRI 0600-2200         days (ranges or comma lists, DAILY) and times
+//   SAT,SUN 0800-1200,1400-1800
+//   2200-0600                 every day; past midnight runs into the next day
+// Times are HHMM or HH:MM, 2400 ends a day. Text that is not understood,
+// including sunrise/sunset hours (HJ, HN) and "HX"/"HO", compiles to always:
+// a zone is never dropped because its hours could not be read.
+class TimeSchedule {
+public:
+    static constexpr int kSlotMinutes = 15;
+    static constexpr int kSlotsPerDay = 24 * 60 / kSlotMinutes;
+    static constexpr int kSlots = 7 * kSlotsPerDay;
+
+    // understood, when given, tells whether every clause was read
+    static TimeSchedule compile(std::string_view text, bool* understood = nullptr);
+    static TimeSchedule always();
+
+    bool activeAt(std::chrono::system_clock::time_point t) const;
+    // Whether any quarter hour of [from, to] is active; a span of a week or
+    // more is whenever the schedule has any hours
+    bool activeBetween(std::chrono::system_clock::time_point from, std::chrono::system_clock::time_point to) const;
+
+    bool isAlways() const { return count_[kSlots] == kSlots; }
+    bool isNever() const { return count_[kSlots] == 0; }
+    // Active quarter hours per week
+    int activeSlots() const { return count_[kSlots]; }
+
+    // Quarter hour of the week of t, Monday 00:00 UTC being 0
+    static int slotOf(std::chrono::system_clock::time_point t);
+
+private:
+    TimeSchedule() = default;
+    void finish();
+    void set(int day, int from_minute, int to_minute);
+
+    std::bitset<kSlots> slots_;
+    std::array<uint16_t, kSlots + 1> count_{}; // active slots before each one
+};
+
+// Compiled schedules shared by their text: zones of one airport usually
+// repeat a handful of restrictions. Thread-safe; grows with the distinct
+// texts only.
+class TimeScheduleCache {
+public:
+    static TimeScheduleCache& getInstance();
+
+    TimeScheduleCache(const TimeScheduleCache&) = delete;
+    TimeScheduleCache& operator=(const TimeScheduleCache&) = delete;
+
+    // nullptr for a missing or blank restriction, which never excludes
+    std::shared_ptr<const TimeSchedule> get(const std::string& text);
+
+private:
+    TimeScheduleCache() = default;
+
+    std::mutex mutex_;
+    std::unordered_map<std::string, std::shared_ptr<const TimeSchedule>> schedules_;
+};
+
+} // namespace aeronautical
@@ -0,0 +1,151 @@
+#include "Timestamp.h"
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+
+namespace aeronautical {
+
+namespace {
+
+std::atomic<TimestampZone> timestamp_zone{TimestampZone::Local};
+
+int64_t floorDiv(int64_t a, int64_t b) {
+    return a / b - ((a % b != 0) && ((a < 0) != (b < 0)));
+}
+
+// Days since 1970-01-01 of a proleptic Gregorian date (H. Hinnant's algorithm)
+int64_t daysFromCivil(int64_t y, int m, int d) {
+    y -= m <= 2;
+    const int64_t era = floorDiv(y, 400);
+    const int64_t yoe = y - era * 400;
+    const int64_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+void civilFromDays(int64_t z, int64_t& y, int& m, int& d) {
+    z += 719468;
+    const int64_t era = floorDiv(z, 146097);
+    const int64_t doe = z - era * 146097;
+    const int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const int64_t mp = (5 * doy + 2) / 153;
+    d = static_cast<int>(doy - (153 * mp + 2) / 5 + 1);
+    m = static_cast<int>(mp < 10 ? mp + 3 : mp - 9);
+    y = yoe + era * 400 + (m <= 2);
+}
+
+// UTC offset of the local zone at seconds since the epoch. localtime_r takes
+// a lock and reads the zone rules each call, so offsets are kept per thread by
+// 15-minute slot (zone transitions fall on slot boundaries).
+int64_t localOffset(int64_t seconds) {
+    struct Slot {
+        int64_t slot = INT64_MIN;
+        int64_t offset = 0;
+    };
+    thread_local Slot slots[256];
+    const int64_t key = floorDiv(seconds, 900);
+    Slot& entry = slots[static_cast<uint64_t>(key) % 256];
+    if (entry.slot != key) {
+        std::time_t t = static_cast<std::time_t>(seconds);
+        std::tm tm{};
+        localtime_r(&t, &tm);
+        entry.slot = key;
+        entry.offset = tm.tm_gmtoff;
+    }
+    return entry.offset;
+}
+
+void putDigits(char* out, int width, int64_t number) {
+    for (int i = width - 1; i >= 0; i--) {
+        out[i] = static_cast<char>('0' + number % 10);
+        number /= 10;
+    }
+}
+
+bool readDigits(std::string_view text, size_t pos, size_t width, int& out) {
+    if (pos + width > text.size()) return false;
+    int value = 0;
+    for (size_t i = pos; i < pos + width; i++) {
+        const char c = text[i];
+        if (c < '0' || c > '9') return false;
+        value = value * 10 + (c - '0');
+    }
+    out = value;
+    return true;
+}
+
+} // namespace
+
+void setTimestampZone(TimestampZone zone) {
+    timestamp_zone.store(zone, std::memory_order_relaxed);
+}
+
+TimestampZone timestampZone() {
+    return timestamp_zone.load(std::memory_order_relaxed);
+}
+
+void formatTimestamp(std::chrono::system_clock::time_point tp, char* out) {
+    int64_t seconds = std::chrono::floor<std::chrono::seconds>(tp).time_since_epoch().count();
+    if (timestampZone() == TimestampZone::Local) {
+        seconds += localOffset(seconds);
+    }
+    const int64_t days = floorDiv(seconds, 86400);
+    const int64_t time_of_day = seconds - days * 86400;
+    int64_t year = 0;
+    int month = 0, day = 0;
+    civilFromDays(days, year, month, day);
+
+    putDigits(out, 4, year < 0 ? 0 : year % 10000);
+    out[4] = '-';
+    putDigits(out + 5, 2, month);
+    out[7] = '-';
+    putDigits(out + 8, 2, day);
+    out[10] = ' ';
+    putDigits(out + 11, 2, time_of_day / 3600);
+    out[13] = ':';
+    putDigits(out + 14, 2, time_of_day / 60 % 60);
+    out[16] = ':';
+    putDigits(out + 17, 2, time_of_day % 60);
+}
+
+std::string formatTimestamp(std::chrono::system_clock::time_point tp) {
+    std::string text(kTimestampLength, '\0');
+    formatTimestamp(tp, text.data());
+    return text;
+}
+
+bool parseTimestamp(std::string_view text, std::chrono::system_clock::time_point& out) {
+    int year = 0, month = 0, day = 0, hour = 0, minute = 0, second = 0;
+    if (!readDigits(text, 0, 4, year) || text.size() < 10 || text[4] != '-' || !readDigits(text, 5, 2, month) ||
+        text[7] != '-' || !readDigits(text, 8, 2, day)) {
+        return false;
+    }
+    if (text.size() > 10 && (text[10] == ' ' || text[10] == 'T')) {
+        if (!readDigits(text, 11, 2, hour) || text.size() < 16 || text[13] != ':' || !readDigits(text, 14, 2, minute)) {
+            return false;
+        }
+        if (text.size() > 16 && text[16] == ':' && !readDigits(text, 17, 2, second)) {
+            return false;
+        }
+    }
+    if (month < 1 || month > 12 || day < 1 || day > 31 || hour > 23 || minute > 59 || second > 60) {
+        return false;
+    }
+    out = timestampFromFields(year, month, day, hour, minute, second);
+    return true;
+}
+
+std::chrono::system_clock::time_point timestampFromFields(int year, int month, int day, int hour, int minute,
+                                                          int second) {
+    const int64_t wall = daysFromCivil(year, month, day) * 86400 + hour * 3600 + minute * 60 + second;
+    int64_t seconds = wall;
+    if (timestampZone() == TimestampZone::Local) {
+        // The offset in force at the result, found from the offset at the
+        // wall time read as UTC; in a DST gap this lands past the gap
+        seconds = wall - localOffset(wall - localOffset(wall));
+    }
+    return std::chrono::system_clock::time_point(std::chrono::seconds(seconds));
+}
+
+} // namespace aeronautical
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace aeronautical {
+
+// DATETIME text as MySQL stores it and the API sends it: "YYYY-MM-DD HH:MM:SS".
+// The text names no zone. Local reads and writes it in the process time zone
+// (TZ), which is what the server has always done; Utc reads and writes UTC and
+// switches every MySQL session to '+00:00' so NOW() agrees.
+enum class TimestampZone { Local, Utc };
+
+// Set once at startup, before any connection is opened
+void setTimestampZone(TimestampZone zone);
+TimestampZone timestampZone();
+
+constexpr size_t kTimestampLength = 19;
+
+// Writes exactly kTimestampLength characters, without a terminator
+void formatTimestamp(std::chrono::system_clock::time_point tp, char* out);
+std::string formatTimestamp(std::chrono::system_clock::time_point tp);
+
+// "YYYY-MM-DD[( |T)HH:MM[:SS[.fraction]]]"; the fraction and anything after it
+// are ignored. Returns false, leaving out untouched, when the fields are invalid.
+bool parseTimestamp(std::string_view text, std::chrono::system_clock::time_point& out);
+
+// The instant a wall-clock time in the configured zone names; month is 1-12
+std::chrono::system_clock::time_point timestampFromFields(int year, int month, int day, int hour, int minute,
+                                                          int second);
+
+} // namespace aeronautical
@@ -0,0 +1,120 @@
+#include "TlsContext.h"
+#include <spdlog/spdlog.h>
+
+#ifdef CROW_ENABLE_SSL
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+#include <fstream>
+#include <iterator>
+#endif
+
+namespace aeronautical {
+
+#ifdef CROW_ENABLE_SSL
+namespace {
+
+std::string opensslError() {
+    const unsigned long code = ERR_get_error();
+    if (code == 0) {
+        return "unknown error";
+    }
+    char text[256];
+    ERR_error_string_n(code, text, sizeof(text));
+    ERR_clear_error();
+    return text;
+}
+
+// Resumed sessions must come from this server's context
+constexpr unsigned char kSessionIdContext[] = "aeronautical_backend";
+constexpr size_t kTicketKeyBytes = 80;
+
+} // namespace
+#endif
+
+TlsContext& TlsContext::getInstance() {
+    static TlsContext instance;
+    return instance;
+}
+
+#ifdef CROW_ENABLE_SSL
+std::optional<asio::ssl::context> TlsContext::build(const TlsSettings& settings, std::string& error) {
+    asio::ssl::context context(asio::ssl::context::tls_server);
+    SSL_CTX* ctx = context.native_handle();
+    context.set_options(asio::ssl::context::default_workarounds | asio::ssl::context::no_sslv2 |
+                        asio::ssl::context::no_sslv3 | asio::ssl::context::no_tlsv1 |
+                        asio::ssl::context::no_tlsv1_1);
+    SSL_CTX_set_options(ctx, SSL_OP_CIPHER_SERVER_PREFERENCE | SSL_OP_NO_RENEGOTIATION);
+    context.set_verify_mode(asio::ssl::verify_none);
+
+    asio::error_code ec;
+    context.use_certificate_chain_file(settings.cert_file, ec);
+    if (!ec) context.use_private_key_file(settings.key_file, asio::ssl::context::pem, ec);
+    if (ec) {
+        error = "cannot load certificate or key: " + ec.message();
+        return std::nullopt;
+    }
+    if (SSL_CTX_check_private_key(ctx) != 1) {
+        error = "private key does not match the certificate";
+        return std::nullopt;
+    }
+    if (!settings.ciphers.empty() && SSL_CTX_set_cipher_list(ctx, settings.ciphers.c_str()) != 1) {
+        error = "TLS_CIPHERS rejected: " + opensslError();
+        return std::nullopt;
+    }
+    if (!settings.ciphersuites.empty() && SSL_CTX_set_ciphersuites(ctx, settings.ciphersuites.c_str()) != 1) {
+        error = "TLS_CIPHERSUITES rejected: " + opensslError();
+        return std::nullopt;
+    }
+    if (!settings.groups.empty() && SSL_CTX_set1_groups_list(ctx, settings.groups.c_str()) != 1) {
+        error = "TLS_GROUPS rejected: " + opensslError();
+        return std::nullopt;
+    }
+
+    // Resumption: tickets for clients that send them, the cache for the rest
+    SSL_CTX_set_session_id_context(ctx, kSessionIdContext, sizeof(kSessionIdContext) - 1);
+    SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_SERVER);
+    SSL_CTX_sess_set_cache_size(ctx, settings.session_cache_size);
+    SSL_CTX_set_timeout(ctx, settings.session_timeout_s);
+    SSL_CTX_clear_options(ctx, SSL_OP_NO_TICKET);
+    if (!settings.ticket_key_file.empty()) {
+        std::ifstream in(settings.ticket_key_file, std::ios::binary);
+        std::string keys((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        if (keys.size() < kTicketKeyBytes) {
+            error = "TLS_TICKET_KEY_FILE must hold at least " + std::to_string(kTicketKeyBytes) + " bytes";
+            return std::nullopt;
+        }
+        if (SSL_CTX_set_tlsext_ticket_keys(ctx, keys.data(), kTicketKeyBytes) != 1) {
+            error = "session ticket keys rejected: " + opensslError();
+            return std::nullopt;
+        }
+    }
+
+    ctx_ = ctx;
+    spdlog::info("TLS enabled with {}; session cache {} entries for {} s, tickets {}", settings.cert_file,
+                 settings.session_cache_size, settings.session_timeout_s,
+                 settings.ticket_key_file.empty() ? "with per-process keys" : "with shared keys");
+    return context;
+}
+#endif
+
+nlohmann::json TlsContext::stats() const {
+    nlohmann::json j;
+    j["enabled"] = ctx_ != nullptr;
+#ifdef CROW_ENABLE_SSL
+    if (ctx_) {
+        SSL_CTX* ctx = static_cast<SSL_CTX*>(ctx_);
+        const long handshakes = SSL_CTX_sess_accept_good(ctx);
+        const long resumed = SSL_CTX_sess_hits(ctx);
+        j["handshakes"] = handshakes;
+        j["resumed"] = resumed;
+        j["full_handshakes"] = handshakes - resumed;
+        j["session_misses"] = SSL_CTX_sess_misses(ctx);
+        j["session_timeouts"] = SSL_CTX_sess_timeouts(ctx);
+        j["sessions_cached"] = SSL_CTX_sess_number(ctx);
+        j["session_cache_size"] = SSL_CTX_sess_get_cache_size(ctx);
+    }
+#endif
+    return j;
+}
+
+} // namespace aeronautical
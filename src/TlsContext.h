@@ -0,0 +1,61 @@
+#pragma once
+
+#include <json.hpp>
+#include <optional>
+#include <string>
+
+#ifdef CROW_ENABLE_SSL
+#include <asio/ssl/context.hpp>
+#endif
+
+namespace aeronautical {
+
+// Settings for serving HTTPS from the Crow app itself (TLS_* variables)
+struct TlsSettings {
+    std::string cert_file; // PEM chain, leaf first
+    std::string key_file;
+    // TLS 1.2 cipher list and TLS 1.3 suites, OpenSSL syntax; empty keeps OpenSSL's
+    std::string ciphers;
+    std::string ciphersuites;
+    // Key exchange groups in preference order; X25519 is the cheapest ECDHE
+    std::string groups = "X25519:P-256:P-384";
+    // Server-side cache of full sessions, for clients resuming by session id
+    long session_cache_size = 20480;
+    long session_timeout_s = 7200;
+    // 80 bytes of ticket keys shared by every instance, so a client resumes
+    // its session with whichever instance the balancer picks; empty gives
+    // each process keys of its own
+    std::string ticket_key_file;
+
+    bool enabled() const { return !cert_file.empty() && !key_file.empty(); }
+};
+
+// The server's TLS context: TLS 1.2 and up, resumption through session
+// tickets and the session cache, so a returning client skips the
+// certificate exchange and signature. OpenSSL draws a fresh ECDHE key per
+// handshake (reusing one would give up forward secrecy); resumption is what
+// saves the key exchange.
+class TlsContext {
+public:
+    static TlsContext& getInstance();
+
+    TlsContext(const TlsContext&) = delete;
+    TlsContext& operator=(const TlsContext&) = delete;
+
+#ifdef CROW_ENABLE_SSL
+    // Context for HttpApp::ssl(); nullopt with error set when a file cannot
+    // be read or a cipher or group list is rejected
+    std::optional<asio::ssl::context> build(const TlsSettings& settings, std::string& error);
+#endif
+
+    bool active() const { return ctx_ != nullptr; }
+    // Handshakes and resumptions since start; {"enabled": false} without TLS
+    nlohmann::json stats() const;
+
+private:
+    TlsContext() = default;
+
+    void* ctx_ = nullptr; // SSL_CTX of the built context, owned by the app
+};
+
+} // namespace aeronautical
@@ -0,0 +1,439 @@
+#include "TokenVerifier.h"
+#include <crow/utility.h>
+#include <asio.hpp>
+#include <asio/ssl.hpp>
+#include <openssl/bn.h>
+#include <openssl/core_names.h>
+#include <openssl/evp.h>
+#include <openssl/param_build.h>
+#include <openssl/sha.h>
+#include <openssl/ssl.h>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <functional>
+#include <sstream>
+
+namespace aeronautical {
+
+namespace {
+
+// A kid the keys do not know triggers at most one early reload per interval
+constexpr std::chrono::seconds kMinReloadInterval{30};
+constexpr std::chrono::seconds kFetchTimeout{10};
+
+bool isBase64Url(std::string_view text) {
+    for (char c : text) {
+        const bool valid = (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '-' ||
+                           c == '_' || c == '=';
+        if (!valid) return false;
+    }
+    return true;
+}
+
+std::string sha256(std::string_view data) {
+    unsigned char digest[SHA256_DIGEST_LENGTH];
+    SHA256(reinterpret_cast<const unsigned char*>(data.data()), data.size(), digest);
+    return std::string(reinterpret_cast<const char*>(digest), sizeof(digest));
+}
+
+// RSA public key from the JWK's base64url modulus and exponent
+std::shared_ptr<EVP_PKEY> rsaKey(const std::string& n, const std::string& e) {
+    const std::string modulus = crow::utility::base64decode(n);
+    const std::string exponent = crow::utility::base64decode(e);
+    BIGNUM* bn_n = BN_bin2bn(reinterpret_cast<const unsigned char*>(modulus.data()), static_cast<int>(modulus.size()), nullptr);
+    BIGNUM* bn_e = BN_bin2bn(reinterpret_cast<const unsigned char*>(exponent.data()), static_cast<int>(exponent.size()), nullptr);
+    OSSL_PARAM_BLD* builder = OSSL_PARAM_BLD_new();
+    OSSL_PARAM* params = nullptr;
+    EVP_PKEY_CTX* ctx = EVP_PKEY_CTX_new_from_name(nullptr, "RSA", nullptr);
+    EVP_PKEY* key = nullptr;
+    if (bn_n && bn_e && builder && ctx && OSSL_PARAM_BLD_push_BN(builder, OSSL_PKEY_PARAM_RSA_N, bn_n) &&
+        OSSL_PARAM_BLD_push_BN(builder, OSSL_PKEY_PARAM_RSA_E, bn_e) && (params = OSSL_PARAM_BLD_to_param(builder)) &&
+        EVP_PKEY_fromdata_init(ctx) > 0) {
+        if (EVP_PKEY_fromdata(ctx, &key, EVP_PKEY_PUBLIC_KEY, params) <= 0) key = nullptr;
+    }
+    EVP_PKEY_CTX_free(ctx);
+    OSSL_PARAM_free(params);
+    OSSL_PARAM_BLD_free(builder);
+    BN_free(bn_n);
+    BN_free(bn_e);
+    if (!key) return nullptr;
+    return std::shared_ptr<EVP_PKEY>(key, EVP_PKEY_free);
+}
+
+// Writes request, then reads until the server closes the connection;
+// buffer and readMore live in the caller's frame, as long as the io_context
+template <typename Stream>
+void exchange(Stream& stream, const std::string& request, std::array<char, 8192>& buffer,
+              std::function<void()>& readMore, std::string& response, bool& failed) {
+    readMore = [&]() {
+        stream.async_read_some(asio::buffer(buffer), [&](const asio::error_code& ec, size_t n) {
+            response.append(buffer.data(), n);
+            if (!ec) {
+                readMore();
+            } else if (ec != asio::error::eof && ec != asio::ssl::error::stream_truncated) {
+                // Servers ending an HTTP/1.0 response often close without close_notify
+                failed = true;
+            }
+        });
+    };
+    asio::async_write(stream, asio::buffer(request), [&](const asio::error_code& ec, size_t) {
+        if (ec) {
+            failed = true;
+            return;
+        }
+        readMore();
+    });
+}
+
+// Body of an HTTPS (or, when allowed, plain HTTP) GET, empty on any
+// failure. The server's certificate must chain to ca_file, or the system's
+// roots, and name the host. HTTP/1.0 keeps the response unchunked and ends
+// it by closing the connection.
+std::string httpGet(const std::string& url, const std::string& ca_file, bool allow_http) {
+    bool tls = true;
+    std::string scheme = "https://";
+    if (url.rfind("http://", 0) == 0) {
+        if (!allow_http) {
+            spdlog::error("JWKS URL must be https:// (JWT_JWKS_ALLOW_HTTP=true permits http://): {}", url);
+            return "";
+        }
+        tls = false;
+        scheme = "http://";
+    } else if (url.rfind(scheme, 0) != 0) {
+        spdlog::error("JWKS URL must be https:// (use JWT_JWKS_PATH for other sources): {}", url);
+        return "";
+    }
+    const size_t host_start = scheme.size();
+    const size_t path_start = url.find('/', host_start);
+    std::string authority = url.substr(host_start, path_start == std::string::npos ? std::string::npos : path_start - host_start);
+    const std::string path = path_start == std::string::npos ? "/" : url.substr(path_start);
+    std::string host = authority;
+    std::string port = tls ? "443" : "80";
+    if (const size_t colon = authority.rfind(':'); colon != std::string::npos) {
+        host = authority.substr(0, colon);
+        port = authority.substr(colon + 1);
+    }
+
+    asio::ssl::context context(asio::ssl::context::tls_client);
+    asio::error_code ec;
+    if (ca_file.empty()) {
+        context.set_default_verify_paths(ec);
+    } else {
+        context.load_verify_file(ca_file, ec);
+    }
+    if (ec) {
+        spdlog::error("Cannot load the CA certificates for {}: {}", url, ec.message());
+        return "";
+    }
+    context.set_verify_mode(asio::ssl::verify_peer);
+
+    asio::io_context io;
+    asio::ssl::stream<asio::ip::tcp::socket> stream(io, context);
+    asio::ip::tcp::resolver resolver(io);
+    if (tls) {
+        // SNI, for servers holding several certificates on one address
+        if (!SSL_set_tlsext_host_name(stream.native_handle(), host.c_str())) {
+            spdlog::error("Cannot set the TLS server name for {}", url);
+            return "";
+        }
+        stream.set_verify_callback(asio::ssl::host_name_verification(host));
+    }
+    std::string request = "GET " + path + " HTTP/1.0\r\nHost: " + authority +
+                          "\r\nAccept: application/json\r\nConnection: close\r\n\r\n";
+    std::string response;
+    std::array<char, 8192> buffer;
+    std::function<void()> readMore;
+    bool failed = false;
+
+    resolver.async_resolve(host, port, [&](const asio::error_code& ec, asio::ip::tcp::resolver::results_type endpoints) {
+        if (ec) {
+            failed = true;
+            return;
+        }
+        asio::async_connect(stream.next_layer(), endpoints, [&](const asio::error_code& ec, const asio::ip::tcp::endpoint&) {
+            if (ec) {
+                failed = true;
+                return;
+            }
+            if (!tls) {
+                exchange(stream.next_layer(), request, buffer, readMore, response, failed);
+                return;
+            }
+            stream.async_handshake(asio::ssl::stream_base::client, [&](const asio::error_code& ec) {
+                if (ec) {
+                    spdlog::error("TLS handshake with {} failed: {}", host, ec.message());
+                    failed = true;
+                    return;
+                }
+                exchange(stream, request, buffer, readMore, response, failed);
+            });
+        });
+    });
+    io.run_for(kFetchTimeout);
+    if (!io.stopped()) {
+        spdlog::error("JWKS fetch from {} timed out", url);
+        return "";
+    }
+    if (failed) return "";
+
+    const size_t header_end = response.find("\r\n\r\n");
+    if (header_end == std::string::npos || (response.compare(0, 9, "HTTP/1.1 ") != 0 && response.compare(0, 9, "HTTP/1.0 ") != 0)) {
+        return "";
+    }
+    if (response.compare(9, 3, "200") != 0) {
+        spdlog::error("JWKS fetch from {} answered {}", url, response.substr(9, 3));
+        return "";
+    }
+    return response.substr(header_end + 4);
+}
+
+bool audienceMatches(const nlohmann::json& claims, const std::string& audience) {
+    if (auto aud = claims.find("aud"); aud != claims.end()) {
+        if (aud->is_string() && aud->get<std::string>() == audience) return true;
+        if (aud->is_array()) {
+            for (const auto& entry : *aud) {
+                if (entry.is_string() && entry.get<std::string>() == audience) return true;
+            }
+        }
+    }
+    // Keycloak access tokens name the client in azp
+    auto azp = claims.find("azp");
+    return azp != claims.end() && azp->is_string() && azp->get<std::string>() == audience;
+}
+
+} // namespace
+
+TokenVerifier& TokenVerifier::getInstance() {
+    static TokenVerifier instance;
+    return instance;
+}
+
+TokenVerifier::~TokenVerifier() {
+    stop();
+}
+
+void TokenVerifier::start(const TokenSettings& settings) {
+    std::lock_guard<std::mutex> lock(thread_mutex_);
+    if (refresh_thread_.joinable() || (settings.jwks_url.empty() && settings.jwks_path.empty())) {
+        return;
+    }
+    settings_ = settings;
+    last_load_ = std::chrono::steady_clock::now();
+    if (!loadKeys()) {
+        spdlog::warn("No signing keys loaded yet; bearer tokens are refused until a JWKS load succeeds");
+    }
+    enabled_.store(true, std::memory_order_release);
+    stopping_ = false;
+    refresh_thread_ = std::thread([this]() { refreshLoop(); });
+}
+
+void TokenVerifier::stop() {
+    {
+        std::lock_guard<std::mutex> lock(thread_mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    if (refresh_thread_.joinable()) {
+        refresh_thread_.join();
+    }
+}
+
+bool TokenVerifier::loadKeys() {
+    std::string body;
+    if (!settings_.jwks_path.empty()) {
+        std::ifstream file(settings_.jwks_path);
+        std::stringstream contents;
+        contents << file.rdbuf();
+        body = contents.str();
+    } else {
+        body = httpGet(settings_.jwks_url, settings_.jwks_ca_file, settings_.jwks_allow_http);
+    }
+
+    auto keys = std::make_shared<KeySet>();
+    try {
+        const auto jwks = nlohmann::json::parse(body);
+        for (const auto& jwk : jwks.at("keys")) {
+            if (jwk.value("kty", "") != "RSA" || jwk.value("use", "sig") != "sig") continue;
+            auto key = rsaKey(jwk.value("n", ""), jwk.value("e", ""));
+            if (key) keys->emplace(jwk.value("kid", ""), std::move(key));
+        }
+    } catch (const std::exception& e) {
+        spdlog::error("Could not read JWKS from {}: {}",
+                      settings_.jwks_path.empty() ? settings_.jwks_url : settings_.jwks_path, e.what());
+    }
+    if (keys->empty()) {
+        key_refresh_failures_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    spdlog::info("Loaded {} token signing keys", keys->size());
+    keys_.publish(std::move(keys));
+    key_refreshes_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void TokenVerifier::refreshLoop() {
+    std::unique_lock<std::mutex> lock(thread_mutex_);
+    while (true) {
+        wake_.wait_for(lock, settings_.refresh_interval, [this]() { return stopping_ || refresh_requested_; });
+        if (stopping_) {
+            return;
+        }
+        refresh_requested_ = false;
+        last_load_ = std::chrono::steady_clock::now();
+        lock.unlock();
+        loadKeys();
+        lock.lock();
+    }
+}
+
+bool TokenVerifier::authorizes(std::string_view authorization, std::string& error) {
+    if (authorization.size() <= 7 || authorization.substr(0, 7) != "Bearer ") {
+        error = authorization.empty() ? "Authorization header required" : "Invalid authorization format";
+        return false;
+    }
+    return verify(authorization.substr(7), error);
+}
+
+bool TokenVerifier::verify(std::string_view token, std::string& error) {
+    if (!enabled()) {
+        return true;
+    }
+    const auto now = std::chrono::system_clock::now();
+    const std::string key = sha256(token);
+    {
+        std::shared_lock<std::shared_mutex> lock(cache_mutex_);
+        auto it = verified_.find(key);
+        if (it != verified_.end() && it->second + settings_.leeway > now) {
+            hits_.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    std::chrono::system_clock::time_point expires;
+    verifications_.fetch_add(1, std::memory_order_relaxed);
+    if (!verifyUncached(token, expires, error)) {
+        rejections_.fetch_add(1, std::memory_order_relaxed);
+        std::unique_lock<std::shared_mutex> lock(cache_mutex_);
+        verified_.erase(key);
+        return false;
+    }
+
+    std::unique_lock<std::shared_mutex> lock(cache_mutex_);
+    if (verified_.size() >= settings_.cache_entries) {
+        std::erase_if(verified_, [&](const auto& entry) { return entry.second + settings_.leeway <= now; });
+        if (verified_.size() >= settings_.cache_entries) verified_.clear();
+    }
+    verified_[key] = expires;
+    return true;
+}
+
+bool TokenVerifier::verifyUncached(std::string_view token, std::chrono::system_clock::time_point& expires,
+                                   std::string& error) {
+    const size_t first = token.find('.');
+    const size_t second = first == std::string_view::npos ? first : token.find('.', first + 1);
+    if (second == std::string_view::npos || token.size() > 16384) {
+        error = "Malformed token";
+        return false;
+    }
+    const std::string_view header_part = token.substr(0, first);
+    const std::string_view payload_part = token.substr(first + 1, second - first - 1);
+    const std::string_view signature_part = token.substr(second + 1);
+    if (!isBase64Url(header_part) || !isBase64Url(payload_part) || !isBase64Url(signature_part)) {
+        error = "Malformed token";
+        return false;
+    }
+
+    nlohmann::json header;
+    nlohmann::json claims;
+    try {
+        header = nlohmann::json::parse(crow::utility::base64decode(header_part.data(), header_part.size()));
+        claims = nlohmann::json::parse(crow::utility::base64decode(payload_part.data(), payload_part.size()));
+    } catch (const nlohmann::json::exception&) {
+        error = "Malformed token";
+        return false;
+    }
+
+    const std::string alg = header.value("alg", "");
+    const EVP_MD* digest = alg == "RS256" ? EVP_sha256() : alg == "RS384" ? EVP_sha384() : alg == "RS512" ? EVP_sha512() : nullptr;
+    if (!digest) {
+        error = "Unsupported token algorithm";
+        return false;
+    }
+
+    const std::string kid = header.value("kid", "");
+    auto keys = keys_.load();
+    std::shared_ptr<EVP_PKEY> public_key;
+    if (keys) {
+        if (auto it = keys->find(kid); it != keys->end()) public_key = it->second;
+    }
+    if (!public_key) {
+        // Keys may have rotated; let the refresh thread reload them early
+        {
+            std::lock_guard<std::mutex> lock(thread_mutex_);
+            if (std::chrono::steady_clock::now() - last_load_ >= kMinReloadInterval) {
+                refresh_requested_ = true;
+            }
+        }
+        wake_.notify_all();
+        error = "Unknown token signing key";
+        return false;
+    }
+
+    const std::string signature = crow::utility::base64decode(signature_part.data(), signature_part.size());
+    const std::string_view signed_part = token.substr(0, second);
+    EVP_MD_CTX* ctx = EVP_MD_CTX_new();
+    const bool valid = ctx && EVP_DigestVerifyInit(ctx, nullptr, digest, nullptr, public_key.get()) == 1 &&
+                       EVP_DigestVerify(ctx, reinterpret_cast<const unsigned char*>(signature.data()), signature.size(),
+                                        reinterpret_cast<const unsigned char*>(signed_part.data()), signed_part.size()) == 1;
+    EVP_MD_CTX_free(ctx);
+    if (!valid) {
+        error = "Invalid token signature";
+        return false;
+    }
+
+    const auto now = std::chrono::system_clock::now();
+    if (!claims.contains("exp") || !claims["exp"].is_number()) {
+        error = "Token has no expiry";
+        return false;
+    }
+    expires = std::chrono::system_clock::time_point(std::chrono::seconds(claims["exp"].get<int64_t>()));
+    if (expires + settings_.leeway <= now) {
+        error = "Token expired";
+        return false;
+    }
+    if (claims.contains("nbf") && claims["nbf"].is_number() &&
+        std::chrono::system_clock::time_point(std::chrono::seconds(claims["nbf"].get<int64_t>())) > now + settings_.leeway) {
+        error = "Token not valid yet";
+        return false;
+    }
+    if (!settings_.issuer.empty() && claims.value("iss", "") != settings_.issuer) {
+        error = "Token issuer not accepted";
+        return false;
+    }
+    if (!settings_.audience.empty() && !audienceMatches(claims, settings_.audience)) {
+        error = "Token audience not accepted";
+        return false;
+    }
+    return true;
+}
+
+nlohmann::json TokenVerifier::stats() const {
+    nlohmann::json j;
+    j["enabled"] = enabled();
+    auto keys = keys_.load();
+    j["signing_keys"] = keys ? keys->size() : 0;
+    j["key_refreshes"] = key_refreshes_.load(std::memory_order_relaxed);
+    j["key_refresh_failures"] = key_refresh_failures_.load(std::memory_order_relaxed);
+    j["cache_hits"] = hits_.load(std::memory_order_relaxed);
+    j["verifications"] = verifications_.load(std::memory_order_relaxed);
+    j["rejections"] = rejections_.load(std::memory_order_relaxed);
+    {
+        std::shared_lock<std::shared_mutex> lock(cache_mutex_);
+        j["cached_tokens"] = verified_.size();
+    }
+    return j;
+}
+
+} // namespace aeronautical
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "SnapshotPublisher.h"
+#include <json.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+
+typedef struct evp_pkey_st EVP_PKEY;
+
+namespace aeronautical {
+
+struct TokenSettings {
+    std::string jwks_url;  // https://host[:port]/path, e.g. Keycloak's .../protocol/openid-connect/certs
+    std::string jwks_path; // local JWKS file, used instead of the URL when set
+    std::string jwks_ca_file;     // PEM roots the JWKS server's certificate must chain to; the system's when empty
+    bool jwks_allow_http = false; // accept an http:// URL, whose keys anyone on the path could replace
+    std::string issuer;    // required iss when not empty
+    std::string audience;  // required in aud or azp when not empty
+    std::chrono::seconds refresh_interval{300};
+    std::chrono::seconds leeway{30}; // clock skew allowed on exp and nbf
+    size_t cache_entries = 10000;
+};
+
+// Verifies RS256/384/512 bearer tokens (Keycloak access tokens) against
+// the realm's JWKS. A token that passed is remembered by its SHA-256
+// until its exp, so the signature is checked once per token rather than
+// once per request. Keys are reloaded every refresh_interval by a
+// background thread, and early when a token names a kid not seen yet.
+// Until started with a JWKS source every bearer token is accepted, as
+// before token validation existed.
+class TokenVerifier {
+public:
+    static TokenVerifier& getInstance();
+
+    TokenVerifier(const TokenVerifier&) = delete;
+    TokenVerifier& operator=(const TokenVerifier&) = delete;
+
+    // Loads the keys once and starts the refresh thread
+    void start(const TokenSettings& settings);
+    void stop();
+    bool enabled() const { return enabled_.load(std::memory_order_acquire); }
+
+    // token is the part after "Bearer "; error says why it was refused
+    bool verify(std::string_view token, std::string& error);
+    // Whether an Authorization header value is "Bearer <token>" with a
+    // token verify() accepts; admin routes that change data call it
+    bool authorizes(std::string_view authorization, std::string& error);
+
+    nlohmann::json stats() const;
+
+private:
+    TokenVerifier() = default;
+    ~TokenVerifier();
+
+    using KeySet = std::unordered_map<std::string, std::shared_ptr<EVP_PKEY>>;
+
+    bool verifyUncached(std::string_view token, std::chrono::system_clock::time_point& expires, std::string& error);
+    bool loadKeys();
+    void refreshLoop();
+
+    TokenSettings settings_;
+    std::atomic<bool> enabled_{false};
+    SnapshotPublisher<KeySet> keys_;
+
+    mutable std::shared_mutex cache_mutex_;
+    std::unordered_map<std::string, std::chrono::system_clock::time_point> verified_; // SHA-256 -> exp
+
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> verifications_{0};
+    std::atomic<uint64_t> rejections_{0};
+    std::atomic<uint64_t> key_refreshes_{0};
+    std::atomic<uint64_t> key_refresh_failures_{0};
+
+    std::mutex thread_mutex_;
+    std::condition_variable wake_;
+    std::thread refresh_thread_;
+    bool stopping_ = false;
+    bool refresh_requested_ = false;
+    std::chrono::steady_clock::time_point last_load_;
+};
+
+} // namespace aeronautical
@@ -0,0 +1,223 @@
+#include "Tracing.h"
+#include <json.hpp>
+#include <algorithm>
+#include <random>
+
+namespace aeronautical {
+
+namespace {
+
+thread_local TraceContext current_context;
+
+std::mt19937_64& generator() {
+    thread_local std::mt19937_64 engine(std::random_device{}() ^
+                                        static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count()));
+    return engine;
+}
+
+void appendHex(std::string& out, uint64_t value, int digits) {
+    static const char hex[] = "0123456789abcdef";
+    for (int shift = (digits - 1) * 4; shift >= 0; shift -= 4) {
+        out += hex[(value >> shift) & 0xf];
+    }
+}
+
+std::string spanIdHex(uint64_t span_id) {
+    std::string out;
+    appendHex(out, span_id, 16);
+    return out;
+}
+
+int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+bool parseHex(std::string_view text, uint8_t* out) {
+    for (size_t i = 0; i < text.size(); i += 2) {
+        const int high = hexValue(text[i]);
+        const int low = hexValue(text[i + 1]);
+        if (high < 0 || low < 0) return false;
+        out[i / 2] = static_cast<uint8_t>(high << 4 | low);
+    }
+    return true;
+}
+
+int64_t unixNanos(std::chrono::system_clock::time_point at) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(at.time_since_epoch()).count();
+}
+
+} // namespace
+
+std::string TraceContext::traceIdHex() const {
+    std::string out;
+    for (uint8_t byte : trace_id) appendHex(out, byte, 2);
+    return out;
+}
+
+std::string TraceContext::traceparent() const {
+    return "00-" + traceIdHex() + "-" + spanIdHex(span_id) + (sampled ? "-01" : "-00");
+}
+
+std::optional<TraceContext> TraceContext::fromTraceparent(std::string_view header) {
+    // version(2) - trace id(32) - parent id(16) - flags(2)
+    if (header.size() < 55 || header[2] != '-' || header[35] != '-' || header[52] != '-') return std::nullopt;
+    if (header.substr(0, 2) == "ff") return std::nullopt;
+
+    TraceContext context;
+    std::array<uint8_t, 8> span{};
+    uint8_t flags = 0;
+    if (!parseHex(header.substr(3, 32), context.trace_id.data()) || !parseHex(header.substr(36, 16), span.data()) ||
+        !parseHex(header.substr(53, 2), &flags)) {
+        return std::nullopt;
+    }
+    for (uint8_t byte : span) context.span_id = context.span_id << 8 | byte;
+    bool zero_trace = true;
+    for (uint8_t byte : context.trace_id) zero_trace = zero_trace && byte == 0;
+    if (zero_trace || context.span_id == 0) return std::nullopt;
+    context.sampled = (flags & 0x01) != 0;
+    return context;
+}
+
+Tracer& Tracer::getInstance() {
+    static Tracer instance;
+    return instance;
+}
+
+void Tracer::configure(double sample_rate, std::shared_ptr<spdlog::logger> exporter) {
+    setSampleRate(sample_rate);
+    exporter_ = std::move(exporter);
+}
+
+void Tracer::setSampleRate(double sample_rate) {
+    sample_rate_.store(std::clamp(sample_rate, 0.0, 1.0), std::memory_order_relaxed);
+}
+
+TraceContext Tracer::startTrace(std::string_view traceparent, uint64_t& parent_span_id) {
+    TraceContext context;
+    if (auto parent = TraceContext::fromTraceparent(traceparent)) {
+        context = *parent;
+        context.sampled = parent->sampled && enabled();
+        parent_span_id = parent->span_id;
+    } else {
+        const uint64_t high = generator()();
+        const uint64_t low = generator()();
+        for (int i = 0; i < 8; i++) {
+            context.trace_id[i] = static_cast<uint8_t>(high >> (56 - 8 * i));
+            context.trace_id[8 + i] = static_cast<uint8_t>(low >> (56 - 8 * i));
+        }
+        // The low trace id bits are random, so they double as the sampling draw
+        context.sampled = enabled() && static_cast<double>(low >> 11) * 0x1.0p-53 < sample_rate_.load(std::memory_order_relaxed);
+        parent_span_id = 0;
+    }
+    context.span_id = newSpanId();
+    return context;
+}
+
+const TraceContext& Tracer::current() {
+    return current_context;
+}
+
+void Tracer::setCurrent(const TraceContext& context) {
+    current_context = context;
+}
+
+uint64_t Tracer::newSpanId() {
+    uint64_t id = 0;
+    while (id == 0) id = generator()();
+    return id;
+}
+
+void Tracer::recordSpan(const char* name, std::chrono::steady_clock::time_point started,
+                        std::chrono::steady_clock::time_point ended, const Attributes& attributes, bool error) {
+    const TraceContext& parent = current_context;
+    if (!parent.sampled) return;
+    TraceContext context = parent;
+    context.span_id = newSpanId();
+    const auto system_ended = std::chrono::system_clock::now() -
+                              std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                                  std::chrono::steady_clock::now() - ended);
+    const auto system_started =
+        system_ended - std::chrono::duration_cast<std::chrono::system_clock::duration>(ended - started);
+    exportSpan(context, parent.span_id, name, system_started, system_ended, attributes, error, "");
+}
+
+void Tracer::exportSpan(const TraceContext& context, uint64_t parent_span_id, const std::string& name,
+                        std::chrono::system_clock::time_point started, std::chrono::system_clock::time_point ended,
+                        const Attributes& attributes, bool error, const std::string& status_message, bool server) {
+    if (!exporter_) return;
+    nlohmann::json span;
+    span["traceId"] = context.traceIdHex();
+    span["spanId"] = spanIdHex(context.span_id);
+    if (parent_span_id) span["parentSpanId"] = spanIdHex(parent_span_id);
+    span["name"] = name;
+    span["kind"] = server ? 2 : 1;
+    span["startTimeUnixNano"] = std::to_string(unixNanos(started));
+    span["endTimeUnixNano"] = std::to_string(unixNanos(ended));
+    nlohmann::json attrs = nlohmann::json::array();
+    for (const auto& [key, value] : attributes) {
+        attrs.push_back({{"key", key}, {"value", {{"stringValue", value}}}});
+    }
+    span["attributes"] = std::move(attrs);
+    span["status"] = error ? nlohmann::json{{"code", 2}, {"message", status_message}} : nlohmann::json{{"code", 0}};
+
+    nlohmann::json line;
+    line["resourceSpans"] = nlohmann::json::array(
+        {{{"resource",
+           {{"attributes",
+             nlohmann::json::array({{{"key", "service.name"}, {"value", {{"stringValue", "aeronautical-platform-backend"}}}}})}}},
+          {"scopeSpans", nlohmann::json::array({{{"scope", {{"name", "aeronautical"}}},
+                                                  {"spans", nlohmann::json::array({std::move(span)})}}})}}});
+    exporter_->info(line.dump());
+}
+
+Span::Span(std::string name) : Span(std::move(name), Tracer::current()) {}
+
+Span::Span(std::string name, const TraceContext& parent) : context_(parent) {
+    if (!parent.sampled) return;
+    name_ = std::move(name);
+    parent_span_id_ = parent.span_id;
+    context_.span_id = Tracer::newSpanId();
+    started_ = std::chrono::system_clock::now();
+    previous_ = Tracer::current();
+    Tracer::setCurrent(context_);
+}
+
+Span::~Span() {
+    end();
+}
+
+void Span::setAttribute(const std::string& key, std::string value) {
+    if (!context_.sampled) return;
+    attributes_.emplace_back(key, std::move(value));
+}
+
+void Span::setError(std::string message) {
+    if (!context_.sampled) return;
+    error_ = true;
+    status_message_ = std::move(message);
+}
+
+void Span::end() {
+    if (ended_ || !context_.sampled) return;
+    ended_ = true;
+    Tracer::setCurrent(previous_);
+    Tracer::getInstance().exportSpan(context_, parent_span_id_, name_, started_, std::chrono::system_clock::now(),
+                                     attributes_, error_, status_message_);
+}
+
+void TracedLogger::sink_it_(const spdlog::details::log_msg& msg) {
+    const TraceContext& context = current_context;
+    if (!context.valid()) {
+        target_->log(msg.time, msg.source, msg.level, msg.payload);
+        return;
+    }
+    spdlog::memory_buf_t tagged;
+    const std::string tag = "[trace=" + context.traceIdHex() + "] ";
+    tagged.append(tag.data(), tag.data() + tag.size());
+    tagged.append(msg.payload.data(), msg.payload.data() + msg.payload.size());
+    target_->log(msg.time, msg.source, msg.level, spdlog::string_view_t(tagged.data(), tagged.size()));
+}
+
+} // namespace aeronautical
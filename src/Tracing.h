@@ -0,0 +1,142 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <spdlog/spdlog.h>
+
+namespace aeronautical {
+
+// Identity of the span work on a thread belongs to, in W3C Trace Context
+// terms. Every request gets one, so log lines correlate even when the
+// trace is not sampled; only sampled traces record spans.
+struct TraceContext {
+    std::array<uint8_t, 16> trace_id{};
+    uint64_t span_id = 0;
+    bool sampled = false;
+
+    bool valid() const {
+        for (uint8_t byte : trace_id) {
+            if (byte) return true;
+        }
+        return false;
+    }
+    std::string traceIdHex() const;
+    // "00-<trace>-<span>-<flags>"
+    std::string traceparent() const;
+    static std::optional<TraceContext> fromTraceparent(std::string_view header);
+};
+
+// Sampled spans written as OTLP/JSON lines (one resourceSpans object per
+// span) to the "trace" logger, for an OpenTelemetry collector to tail.
+// The current context is thread-local: the HTTP middleware sets it for
+// a request, DbExecutor and the analysis queue carry it across their
+// thread hops, and Span makes child spans of it.
+class Tracer {
+public:
+    static Tracer& getInstance();
+
+    Tracer(const Tracer&) = delete;
+    Tracer& operator=(const Tracer&) = delete;
+
+    // Ratio of new traces recorded; a sampled traceparent from the client is always honoured
+    void configure(double sample_rate, std::shared_ptr<spdlog::logger> exporter);
+    // Changes the ratio while requests are being traced
+    void setSampleRate(double sample_rate);
+    bool enabled() const { return exporter_ != nullptr; }
+
+    // Context of a request's server span. Continues the client's trace
+    // when traceparent is valid, setting parent_span_id to its span (else 0)
+    TraceContext startTrace(std::string_view traceparent, uint64_t& parent_span_id);
+
+    static const TraceContext& current();
+    static void setCurrent(const TraceContext& context);
+    static uint64_t newSpanId();
+
+    using Attributes = std::vector<std::pair<std::string, std::string>>;
+    // Span that already happened, as a child of the current context when it is sampled
+    void recordSpan(const char* name, std::chrono::steady_clock::time_point started,
+                    std::chrono::steady_clock::time_point ended, const Attributes& attributes, bool error = false);
+
+    void exportSpan(const TraceContext& context, uint64_t parent_span_id, const std::string& name,
+                    std::chrono::system_clock::time_point started, std::chrono::system_clock::time_point ended,
+                    const Attributes& attributes, bool error, const std::string& status_message,
+                    bool server = false);
+
+private:
+    Tracer() = default;
+
+    std::atomic<double> sample_rate_{0.0};
+    std::shared_ptr<spdlog::logger> exporter_;
+};
+
+// Child span of the current context, made current until it ends; nothing
+// is recorded unless the trace is sampled.
+class Span {
+public:
+    explicit Span(std::string name);
+    // Child of parent instead of the current context
+    Span(std::string name, const TraceContext& parent);
+    ~Span();
+
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+
+    bool recording() const { return context_.sampled; }
+    const TraceContext& context() const { return context_; }
+
+    void setAttribute(const std::string& key, std::string value);
+    void setAttribute(const std::string& key, int64_t value) { setAttribute(key, std::to_string(value)); }
+    void setError(std::string message);
+    // Ends the span and makes the previous context current again
+    void end();
+
+private:
+    std::string name_;
+    TraceContext context_;
+    TraceContext previous_;
+    uint64_t parent_span_id_ = 0;
+    std::chrono::system_clock::time_point started_;
+    Tracer::Attributes attributes_;
+    bool error_ = false;
+    std::string status_message_;
+    bool ended_ = false;
+};
+
+// Front for an async logger that prefixes "[trace=<id>] " to lines written
+// under a trace. The context is thread-local, so the tag is added here on
+// the calling thread rather than by a formatter on the logger thread.
+class TracedLogger : public spdlog::logger {
+public:
+    explicit TracedLogger(std::shared_ptr<spdlog::logger> target)
+        : spdlog::logger(target->name()), target_(std::move(target)) {}
+
+protected:
+    void sink_it_(const spdlog::details::log_msg& msg) override;
+    void flush_() override { target_->flush(); }
+
+private:
+    std::shared_ptr<spdlog::logger> target_;
+};
+
+// Makes a context current for its lifetime, e.g. on a pool thread
+class TraceScope {
+public:
+    explicit TraceScope(const TraceContext& context) : previous_(Tracer::current()) { Tracer::setCurrent(context); }
+    ~TraceScope() { Tracer::setCurrent(previous_); }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    TraceContext previous_;
+};
+
+} // namespace aeronautical
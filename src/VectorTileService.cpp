@@ -0,0 +1,522 @@
+#include "VectorTileService.h"
+#include "AccessProfile.h"
+#include "ReferenceDataStore.h"
+#include "FlightProcedureRepository.h"
+#include "ProtectionGeometryCache.h"
+#include "ConditionalGet.h"
+#include "GeoJsonReader.h"
+#include "GdalDrivers.h"
+#include "DiskCache.h"
+#include "gdal.h"
+#include "ogrsf_frmts.h"
+#include "cpl_string.h"
+#include "cpl_vsi.h"
+#include <spdlog/spdlog.h>
+#include <json.hpp>
+#include <charconv>
+#include <cmath>
+#include <stdexcept>
+
+namespace aeronautical {
+
+namespace {
+
+constexpr int kMaxTileZoom = 22;
+constexpr auto kProcedureReloadInterval = std::chrono::seconds(60);
+
+// Raised for requests the caller got wrong (400) as opposed to server trouble
+struct TileRequestError : std::invalid_argument {
+    using std::invalid_argument::invalid_argument;
+};
+
+// Raised when the data behind a layer is not available yet (503)
+struct TileUnavailableError : std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+struct TileBox {
+    double west, east, south, north;
+};
+
+// WGS84 box of tile z/x/y grown by the MVT buffer (80 of 4096 units)
+TileBox tileBox(int z, int x, int y) {
+    const double n = std::ldexp(1.0, z);
+    auto lat = [n](double ty) { return std::atan(std::sinh(M_PI * (1.0 - 2.0 * ty / n))) * 180.0 / M_PI; };
+    const double pad = 80.0 / 4096.0;
+    TileBox box;
+    box.west = (x - pad) / n * 360.0 - 180.0;
+    box.east = (x + 1 + pad) / n * 360.0 - 180.0;
+    box.north = lat(y - pad);
+    box.south = lat(y + 1 + pad);
+    return box;
+}
+
+bool envelopeTouches(const GeoBounds& bounds, double min_lng, double max_lng, double min_lat, double max_lat) {
+    if (max_lat < bounds.min_lat || min_lat > bounds.max_lat) {
+        return false;
+    }
+    for (const auto& range : bounds.lng_ranges) {
+        if (max_lng >= range.min && min_lng <= range.max) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void addField(OGRLayer& layer, const char* name, OGRFieldType type) {
+    OGRFieldDefn field(name, type);
+    layer.CreateField(&field);
+}
+
+void writeFeature(OGRLayer& layer, OGRFeature& feature) {
+    if (layer.CreateFeature(&feature) != OGRERR_NONE) {
+        spdlog::warn("MVT: failed to add feature: {}", CPLGetLastErrorMsg());
+    }
+}
+
+void writeAirport(OGRLayer& layer, const Airport& airport) {
+    OGRFeature feature(layer.GetLayerDefn());
+    feature.SetField("id", airport.id);
+    feature.SetField("icao_code", airport.icao_code.c_str());
+    feature.SetField("iata_code", airport.iata_code.c_str());
+    feature.SetField("name", airport.name.c_str());
+    feature.SetField("airport_type", airport.airport_type.c_str());
+    feature.SetField("elevation_ft", airport.elevation_ft);
+    feature.SetField("country_code", airport.country_code.c_str());
+    feature.SetField("count", 1);
+    OGRPoint point(airport.longitude, airport.latitude);
+    feature.SetGeometry(&point);
+    writeFeature(layer, feature);
+}
+
+void writeWaypoint(OGRLayer& layer, const Waypoint& waypoint) {
+    OGRFeature feature(layer.GetLayerDefn());
+    feature.SetField("id", waypoint.id);
+    feature.SetField("waypoint_code", waypoint.waypoint_code.c_str());
+    feature.SetField("name", waypoint.name.c_str());
+    feature.SetField("waypoint_type", waypoint.waypoint_type.c_str());
+    feature.SetField("usage_type", waypoint.usage_type.c_str());
+    feature.SetField("country_code", waypoint.country_code.c_str());
+    feature.SetField("count", 1);
+    OGRPoint point(waypoint.longitude, waypoint.latitude);
+    feature.SetGeometry(&point);
+    writeFeature(layer, feature);
+}
+
+void writeCluster(OGRLayer& layer, const ClusterIndex::Cluster& cluster, const char* type_field) {
+    OGRFeature feature(layer.GetLayerDefn());
+    feature.SetField("count", static_cast<int>(cluster.count));
+    feature.SetField(type_field, cluster.dominant_type->c_str());
+    OGRPoint point(cluster.longitude, cluster.latitude);
+    feature.SetGeometry(&point);
+    writeFeature(layer, feature);
+}
+
+// Closes the dataset and removes everything the driver wrote under /vsimem
+struct MvtScratch {
+    std::string dir;
+    GDALDataset* dataset = nullptr;
+
+    void close() {
+        if (dataset) {
+            GDALClose(GDALDataset::ToHandle(dataset));
+            dataset = nullptr;
+        }
+    }
+    ~MvtScratch() {
+        close();
+        VSIRmdirRecursive(dir.c_str());
+        VSIUnlink((dir + ".db").c_str());
+    }
+};
+
+} // namespace
+
+VectorTileService& VectorTileService::getInstance() {
+    static VectorTileService instance;
+    return instance;
+}
+
+VectorTileService::~VectorTileService() = default;
+
+void VectorTileService::setCacheCapacity(size_t entries) {
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    cache_capacity_ = std::max<size_t>(1, entries);
+    while (cache_lru_.size() > cache_capacity_) {
+        cache_index_.erase(cache_lru_.back().first);
+        cache_lru_.pop_back();
+    }
+}
+
+nlohmann::json VectorTileService::cacheStats() {
+    nlohmann::json j;
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex_);
+        size_t bytes = 0;
+        for (const auto& [key, tile] : cache_lru_) {
+            bytes += key.size() + tile->size();
+        }
+        j["entries"] = cache_lru_.size();
+        j["max_entries"] = cache_capacity_;
+        j["bytes"] = bytes;
+    }
+    j["hits"] = cache_hits_.load(std::memory_order_relaxed);
+    j["misses"] = cache_misses_.load(std::memory_order_relaxed);
+    j["evicted"] = cache_evictions_.load(std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(procedures_mutex_);
+        j["procedures_version"] = procedures_ ? procedures_->version : 0;
+        j["procedures_loads"] = procedures_loads_;
+    }
+    return j;
+}
+
+void VectorTileService::clearCache() {
+    {
+        std::lock_guard<std::mutex> lock(procedures_mutex_);
+        procedures_.reset();
+    }
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    cache_lru_.clear();
+    cache_index_.clear();
+}
+
+void VectorTileService::reloadProcedures() {
+    clearCache();
+    procedureLayers();
+}
+
+std::shared_ptr<const VectorTileService::ProcedureLayers> VectorTileService::procedureLayers() {
+    std::lock_guard<std::mutex> lock(procedures_mutex_);
+    uint64_t generation = ProtectionGeometryCache::getInstance().generation();
+    auto now = std::chrono::steady_clock::now();
+    if (procedures_ && procedures_->generation == generation && now - procedures_->loaded_at < kProcedureReloadInterval) {
+        return procedures_;
+    }
+
+    auto layers = std::make_shared<ProcedureLayers>();
+    ++procedures_loads_;
+    layers->generation = generation;
+    layers->loaded_at = now;
+
+    FlightProcedureFilter filter;
+    filter.is_active = true;
+    filter.limit = 100000;
+    FlightProcedureRepository repository;
+    // FNV-1a over what the layers are built from: the same procedures give
+    // the same version after a restart, so disk-cached tiles stay valid
+    uint64_t version = 1469598103934665603ull;
+    auto mix = [&version](uint64_t value) {
+        for (int i = 0; i < 8; i++) {
+            version = (version ^ ((value >> (i * 8)) & 0xFF)) * 1099511628211ull;
+        }
+    };
+    for (const auto& procedure : repository.findAll(filter)) {
+        mix(static_cast<uint64_t>(procedure.id));
+        mix(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                      procedure.updated_at.time_since_epoch()).count()));
+        mix(procedure.trajectory_geometry ? procedure.trajectory_geometry->size() : 0);
+        mix(procedure.protection_geometry ? procedure.protection_geometry->size() : 0);
+        auto add = [&](std::vector<ProcedureFeature>& into, std::unique_ptr<OGRGeometry> geometry) {
+            if (!geometry || geometry->IsEmpty()) {
+                return;
+            }
+            OGREnvelope envelope;
+            geometry->getEnvelope(&envelope);
+            into.push_back(ProcedureFeature{procedure.id, procedure.procedure_code, procedure.name,
+                                            procedureTypeToString(procedure.type), procedure.airport_icao,
+                                            std::move(geometry), envelope.MinX, envelope.MaxX, envelope.MinY,
+                                            envelope.MaxY});
+        };
+        if (procedure.trajectory_geometry && !procedure.trajectory_geometry->empty()) {
+            add(layers->trajectories, GeoJsonReader::readGeometry(*procedure.trajectory_geometry));
+        }
+        if (procedure.protection_geometry && !procedure.protection_geometry->empty()) {
+            add(layers->protections, ProtectionGeometryCache::parseProtectionGeometry(*procedure.protection_geometry));
+        }
+    }
+
+    layers->version = version;
+
+    spdlog::debug("MVT: loaded {} trajectories and {} protections", layers->trajectories.size(),
+                  layers->protections.size());
+    procedures_ = std::move(layers);
+    return procedures_;
+}
+
+std::string VectorTileService::render(const std::string& layer, int z, int x, int y) {
+    static std::atomic<uint64_t> scratch_counter{0};
+
+    // Pick the data first so unknown layers fail before touching GDAL
+    std::shared_ptr<const ReferenceSnapshot> snapshot;
+    std::shared_ptr<const ProcedureLayers> procedures;
+    if (layer == "airports" || layer == "waypoints") {
+        snapshot = ReferenceDataStore::getInstance().snapshot();
+        if (!snapshot) {
+            throw TileUnavailableError("Reference data is not loaded");
+        }
+    } else if (layer == "procedures" || layer == "protections") {
+        procedures = procedureLayers();
+    } else {
+        throw TileRequestError("Unknown tile layer: " + layer);
+    }
+
+    registerGdalDrivers();
+    GDALDriver* driver = GetGDALDriverManager()->GetDriverByName("MVT");
+    if (!driver) {
+        throw std::runtime_error("GDAL was built without the MVT driver");
+    }
+
+    MvtScratch scratch;
+    scratch.dir = "/vsimem/tiles/" + std::to_string(scratch_counter.fetch_add(1));
+    const std::string zoom = std::to_string(z);
+
+    char** options = nullptr;
+    options = CSLSetNameValue(options, "FORMAT", "DIRECTORY");
+    options = CSLSetNameValue(options, "MINZOOM", zoom.c_str());
+    options = CSLSetNameValue(options, "MAXZOOM", zoom.c_str());
+    options = CSLSetNameValue(options, "COMPRESS", "NO");
+    options = CSLSetNameValue(options, "EXTENT", "4096");
+    options = CSLSetNameValue(options, "BUFFER", "80");
+    options = CSLSetNameValue(options, "SIMPLIFICATION", "1");
+    options = CSLSetNameValue(options, "TEMPORARY_DB", (scratch.dir + ".db").c_str());
+    scratch.dataset = driver->Create(scratch.dir.c_str(), 0, 0, 0, GDT_Unknown, options);
+    CSLDestroy(options);
+    if (!scratch.dataset) {
+        throw std::runtime_error(std::string("MVT dataset creation failed: ") + CPLGetLastErrorMsg());
+    }
+
+    OGRSpatialReference wgs84;
+    wgs84.importFromEPSG(4326);
+    wgs84.SetAxisMappingStrategy(OAMS_TRADITIONAL_GIS_ORDER);
+    OGRLayer* out = scratch.dataset->CreateLayer(layer.c_str(), &wgs84, wkbUnknown, nullptr);
+    if (!out) {
+        throw std::runtime_error(std::string("MVT layer creation failed: ") + CPLGetLastErrorMsg());
+    }
+
+    TileBox box = tileBox(z, x, y);
+    auto bounds = GeoBounds::fromBox(box.south, box.north, box.west, box.east);
+    if (!bounds) {
+        throw TileRequestError("Invalid tile");
+    }
+
+    if (layer == "airports") {
+        addField(*out, "id", OFTInteger);
+        addField(*out, "icao_code", OFTString);
+        addField(*out, "iata_code", OFTString);
+        addField(*out, "name", OFTString);
+        addField(*out, "airport_type", OFTString);
+        addField(*out, "elevation_ft", OFTInteger);
+        addField(*out, "country_code", OFTString);
+        addField(*out, "count", OFTInteger);
+        if (z <= ClusterIndex::kMaxZoom) {
+            for (const auto& cluster : snapshot->airportClusters(*bounds, z, "")) {
+                if (cluster.count == 1) {
+                    writeAirport(*out, snapshot->airports[cluster.first_row]);
+                } else {
+                    writeCluster(*out, cluster, "airport_type");
+                }
+            }
+        } else {
+            for (const Airport* airport : snapshot->airportsInBounds(*bounds, "")) {
+                writeAirport(*out, *airport);
+            }
+        }
+    } else if (layer == "waypoints") {
+        addField(*out, "id", OFTInteger);
+        addField(*out, "waypoint_code", OFTString);
+        addField(*out, "name", OFTString);
+        addField(*out, "waypoint_type", OFTString);
+        addField(*out, "usage_type", OFTString);
+        addField(*out, "country_code", OFTString);
+        addField(*out, "count", OFTInteger);
+        if (z <= ClusterIndex::kMaxZoom) {
+            for (const auto& cluster : snapshot->waypointClusters(*bounds, z, "")) {
+                if (cluster.count == 1) {
+                    writeWaypoint(*out, snapshot->waypoints[cluster.first_row]);
+                } else {
+                    writeCluster(*out, cluster, "waypoint_type");
+                }
+            }
+        } else {
+            for (const Waypoint* waypoint : snapshot->waypointsInBounds(*bounds, "")) {
+                writeWaypoint(*out, *waypoint);
+            }
+        }
+    } else {
+        addField(*out, "id", OFTInteger);
+        addField(*out, "procedure_code", OFTString);
+        addField(*out, "name", OFTString);
+        addField(*out, "type", OFTString);
+        addField(*out, "airport_icao", OFTString);
+        const auto& features = layer == "procedures" ? procedures->trajectories : procedures->protections;
+        for (const auto& source : features) {
+            if (!envelopeTouches(*bounds, source.min_lng, source.max_lng, source.min_lat, source.max_lat)) {
+                continue;
+            }
+            OGRFeature feature(out->GetLayerDefn());
+            feature.SetField("id", source.id);
+            feature.SetField("procedure_code", source.procedure_code.c_str());
+            feature.SetField("name", source.name.c_str());
+            feature.SetField("type", source.type.c_str());
+            feature.SetField("airport_icao", source.airport_icao.c_str());
+            feature.SetGeometry(source.geometry.get());
+            writeFeature(*out, feature);
+        }
+    }
+
+    // Tiles are written when the dataset closes
+    scratch.close();
+    std::string path = scratch.dir + "/" + zoom + "/" + std::to_string(x) + "/" + std::to_string(y) + ".pbf";
+    unsigned long long size = 0;
+    unsigned char* data = VSIGetMemFileBuffer(path.c_str(), &size, FALSE);
+    if (!data) {
+        return std::string(); // no features reached this tile
+    }
+    return std::string(reinterpret_cast<const char*>(data), size);
+}
+
+std::shared_ptr<const std::string> VectorTileService::tile(const std::string& layer, int z, int x, int y, bool keep) {
+    if (z < 0 || z > kMaxTileZoom) {
+        throw TileRequestError("Tile zoom out of range");
+    }
+    const int n = 1 << z;
+    if (x < 0 || x >= n || y < 0 || y >= n) {
+        throw TileRequestError("Tile coordinates out of range");
+    }
+
+    // Data version in the key: a reload or procedure edit gives new keys and
+    // the old tiles simply age out of the LRU
+    uint64_t version = 0;
+    if (layer == "airports" || layer == "waypoints") {
+        if (auto snapshot = ReferenceDataStore::getInstance().snapshot()) {
+            version = snapshot->version;
+        }
+    } else if (layer == "procedures" || layer == "protections") {
+        version = procedureLayers()->version;
+    }
+    std::string key = layer + "/" + std::to_string(z) + "/" + std::to_string(x) + "/" + std::to_string(y) + "@" +
+                      std::to_string(version);
+
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex_);
+        auto it = cache_index_.find(key);
+        if (it != cache_index_.end()) {
+            cache_lru_.splice(cache_lru_.begin(), cache_lru_, it->second);
+            cache_hits_.fetch_add(1, std::memory_order_relaxed);
+            return it->second->second;
+        }
+    }
+    cache_misses_.fetch_add(1, std::memory_order_relaxed);
+
+    // Then the disk cache, which outlives restarts; rendered outside the
+    // lock, two racing misses both render and the second insert wins
+    auto& disk = DiskCache::getInstance();
+    std::shared_ptr<const std::string> encoded;
+    if (auto stored = disk.get("mvt/" + key)) {
+        encoded = std::make_shared<const std::string>(std::move(*stored));
+    } else {
+        encoded = std::make_shared<const std::string>(render(layer, z, x, y));
+        if (keep) disk.put("mvt/" + key, *encoded);
+    }
+    if (!keep) {
+        return encoded;
+    }
+
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    auto it = cache_index_.find(key);
+    if (it != cache_index_.end()) {
+        it->second->second = encoded;
+        cache_lru_.splice(cache_lru_.begin(), cache_lru_, it->second);
+    } else {
+        cache_lru_.emplace_front(key, encoded);
+        cache_index_[key] = cache_lru_.begin();
+        while (cache_lru_.size() > cache_capacity_) {
+            cache_index_.erase(cache_lru_.back().first);
+            cache_lru_.pop_back();
+            cache_evictions_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    return encoded;
+}
+
+bool VectorTileService::warmTile(const std::string& profile_key) {
+    // "<layer>/<z>/<x>/<y>", as the tile route records it
+    const auto slash = profile_key.find('/');
+    if (slash == std::string::npos) {
+        return false;
+    }
+    int zxy[3] = {0, 0, 0};
+    const char* p = profile_key.data() + slash;
+    const char* end = profile_key.data() + profile_key.size();
+    for (int& value : zxy) {
+        if (p == end || *p != '/') return false;
+        auto parsed = std::from_chars(p + 1, end, value);
+        if (parsed.ec != std::errc()) return false;
+        p = parsed.ptr;
+    }
+    if (p != end) {
+        return false;
+    }
+    try {
+        tile(profile_key.substr(0, slash), zxy[0], zxy[1], zxy[2]);
+    } catch (const TileRequestError&) {
+        return false;
+    }
+    return true;
+}
+
+void VectorTileService::registerRoutes(HttpApp& app) {
+    CROW_ROUTE(app, "/tiles/<string>/<int>/<int>/<string>")
+        .methods(crow::HTTPMethod::GET)
+        ([this](const crow::request& req, const std::string& layer, int z, int x, const std::string& y_file) {
+            auto error = [](int code, const std::string& message) {
+                nlohmann::json body = {{"status", "error"}, {"code", code}, {"message", message}};
+                crow::response res(code, body.dump());
+                res.add_header("Content-Type", "application/json");
+                return res;
+            };
+
+            // "<y>.mvt"; ".pbf" is accepted too
+            int y = 0;
+            auto parsed = std::from_chars(y_file.data(), y_file.data() + y_file.size(), y);
+            std::string_view suffix(parsed.ptr, y_file.data() + y_file.size() - parsed.ptr);
+            if (parsed.ec != std::errc() || (suffix != ".mvt" && suffix != ".pbf")) {
+                return error(400, "Expected /tiles/<layer>/<z>/<x>/<y>.mvt");
+            }
+
+            // Reference layers revalidate against the snapshot version; procedure
+            // layers have no version that survives a restart, so they are not tagged
+            std::optional<CacheValidator> validator;
+            if (layer == "airports" || layer == "waypoints") {
+                validator = ConditionalGet::forReferenceData();
+            }
+            if (validator && ConditionalGet::isCurrent(req, *validator)) {
+                crow::response res = ConditionalGet::notModified(*validator);
+                res.add_header("Cache-Control", "public, max-age=60");
+                return res;
+            }
+
+            try {
+                auto encoded = tile(layer, z, x, y);
+                AccessProfile::getInstance().record(AccessProfile::Kind::Tile, layer + "/" + std::to_string(z) + "/" +
+                                                                                   std::to_string(x) + "/" + std::to_string(y));
+                crow::response res(200, *encoded);
+                res.add_header("Content-Type", "application/vnd.mapbox-vector-tile");
+                res.add_header("Cache-Control", "public, max-age=60");
+                if (validator) {
+                    ConditionalGet::tag(res, *validator);
+                }
+                return res;
+            } catch (const TileRequestError& e) {
+                return error(400, e.what());
+            } catch (const TileUnavailableError& e) {
+                return error(503, e.what());
+            } catch (const std::exception& e) {
+                spdlog::error("MVT tile {}/{}/{}/{} failed: {}", layer, z, x, y, e.what());
+                return error(500, "Internal server error");
+            }
+        });
+}
+
+} // namespace aeronautical
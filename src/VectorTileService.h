@@ -0,0 +1,97 @@
+#pragma once
+
+#include <crow.h>
+#include "HttpApp.h"
+#include "ogr_geometry.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <json.hpp>
+
+namespace aeronautical {
+
+// Mapbox Vector Tiles for the map layers, encoded with GDAL's MVT driver
+// (quantized to a 4096 extent, lines and polygons simplified per zoom):
+//
+//   GET /tiles/<layer>/<z>/<x>/<y>.mvt   layer = airports | waypoints | procedures | protections
+//
+// Airports and waypoints come from the reference snapshot and are clustered
+// up to ClusterIndex::kMaxZoom; procedure layers come from MySQL and are
+// re-read when a procedure changes. Encoded tiles are kept in an LRU keyed
+// by layer, tile and data version, so a reload never serves stale tiles,
+// and behind it in the DiskCache under the same key: both versions are
+// derived from the data, so tiles rendered before a restart are reused.
+class VectorTileService {
+public:
+    static VectorTileService& getInstance();
+
+    VectorTileService(const VectorTileService&) = delete;
+    VectorTileService& operator=(const VectorTileService&) = delete;
+
+    void registerRoutes(HttpApp& app);
+
+    void setCacheCapacity(size_t entries);
+    // Encoded tiles held, their bytes and the hit, miss and eviction counts
+    nlohmann::json cacheStats();
+    // Drops every encoded tile and the parsed procedure layers
+    void clearCache();
+    // clearCache, then reads the procedure layers again
+    void reloadProcedures();
+
+    // Encoded tile, empty for a tile with no features; throws on bad layer or coordinates.
+    // keep = false reads the cache but does not add a rendered miss, so bulk
+    // readers (TilePackService) do not evict the tiles the map is viewing.
+    std::shared_ptr<const std::string> tile(const std::string& layer, int z, int x, int y, bool keep = true);
+    // Renders the tile an AccessProfile tile key ("<layer>/<z>/<x>/<y>")
+    // names into the caches; false for a key naming no tile
+    bool warmTile(const std::string& profile_key);
+
+private:
+    struct ProcedureFeature {
+        int id;
+        std::string procedure_code;
+        std::string name;
+        std::string type;
+        std::string airport_icao;
+        std::unique_ptr<OGRGeometry> geometry;
+        double min_lng, max_lng, min_lat, max_lat;
+    };
+
+    // Parsed procedure geometries; reloaded when ProtectionGeometryCache's
+    // generation moves (a procedure was edited) or after a minute
+    struct ProcedureLayers {
+        uint64_t version = 0;
+        uint64_t generation = 0;
+        std::chrono::steady_clock::time_point loaded_at;
+        std::vector<ProcedureFeature> trajectories;
+        std::vector<ProcedureFeature> protections;
+    };
+
+    VectorTileService() = default;
+    ~VectorTileService();
+
+    std::shared_ptr<const ProcedureLayers> procedureLayers();
+    std::string render(const std::string& layer, int z, int x, int y);
+
+    std::mutex procedures_mutex_;
+    std::shared_ptr<const ProcedureLayers> procedures_;
+    uint64_t procedures_loads_ = 0;
+
+    // LRU of encoded tiles; front is most recent
+    using CacheList = std::list<std::pair<std::string, std::shared_ptr<const std::string>>>;
+    std::mutex cache_mutex_;
+    CacheList cache_lru_;
+    std::unordered_map<std::string, CacheList::iterator> cache_index_;
+    size_t cache_capacity_ = 4096;
+    std::atomic<uint64_t> cache_hits_{0};
+    std::atomic<uint64_t> cache_misses_{0};
+    std::atomic<uint64_t> cache_evictions_{0};
+};
+
+} // namespace aeronautical
@@ -0,0 +1,139 @@
+#include "VertexReducer.h"
+#include <algorithm>
+#include <cmath>
+
+namespace aeronautical {
+
+namespace {
+
+using Type = GeoJsonGeometry::Type;
+
+constexpr double kMetresPerDegree = 111320.0;
+// Rounding in the degree-to-metre conversion; "collinear" means within this
+constexpr double kCollinearM = 1e-6;
+// Longest run replaced by one chord, bounding the checks per vertex
+constexpr size_t kMaxRun = 32;
+
+struct Ring {
+    const double* c; // x, y, z triples
+    size_t n;        // positions, the closing one included
+    double cos_lat;
+
+    double x(size_t i) const { return c[3 * i] * cos_lat * kMetresPerDegree; }
+    double y(size_t i) const { return c[3 * i + 1] * kMetresPerDegree; }
+
+    // Twice the signed area; positive counter-clockwise
+    double area2() const {
+        double sum = 0.0;
+        for (size_t i = 0; i + 1 < n; i++) {
+            sum += x(i) * y(i + 1) - x(i + 1) * y(i);
+        }
+        return sum;
+    }
+};
+
+// Whether every vertex strictly between from and to is within tolerance of
+// the chord and on the polygon's side of it (inside > 0: left of the chord)
+bool chordCovers(const Ring& ring, size_t from, size_t to, double inside, double tolerance) {
+    const double ax = ring.x(from), ay = ring.y(from);
+    const double dx = ring.x(to) - ax, dy = ring.y(to) - ay;
+    const double length = std::hypot(dx, dy);
+    if (length == 0.0) return false;
+    for (size_t i = from + 1; i < to; i++) {
+        // Signed distance from the chord, positive on the polygon's side
+        const double side = inside * (dx * (ring.y(i) - ay) - dy * (ring.x(i) - ax)) / length;
+        if (side < -kCollinearM || side > tolerance) return false;
+    }
+    return true;
+}
+
+// Kept positions of one closed ring, appended to out; the first vertex is
+// always kept, so the ring stays closed on it
+size_t reduceRing(const Ring& ring, bool exterior, double tolerance, std::pmr::vector<double>& out) {
+    const size_t start = out.size();
+    auto keep = [&](size_t i) { out.insert(out.end(), ring.c + 3 * i, ring.c + 3 * i + 3); };
+
+    const double area2 = ring.area2();
+    if (ring.n < 5 || area2 == 0.0) {
+        for (size_t i = 0; i < ring.n; i++) keep(i);
+        return ring.n;
+    }
+    // The polygon lies left of a counter-clockwise shell and right of a
+    // counter-clockwise hole
+    const double inside = (area2 > 0.0 ? 1.0 : -1.0) * (exterior ? 1.0 : -1.0);
+
+    size_t anchor = 0;
+    keep(0);
+    while (anchor + 1 < ring.n) {
+        // The farthest vertex the chord can reach; a nearer one failing does
+        // not rule it out (a zigzag fails every other chord)
+        size_t end = anchor + 1;
+        const size_t last = std::min(ring.n - 1, anchor + kMaxRun);
+        for (size_t to = last; to > end; to--) {
+            if (chordCovers(ring, anchor, to, inside, tolerance)) {
+                end = to;
+                break;
+            }
+        }
+        keep(end);
+        anchor = end;
+    }
+
+    const size_t kept = (out.size() - start) / 3;
+    // A ring needs three corners; give up on a run that would fold it flat
+    if (kept < 4) {
+        out.resize(start);
+        for (size_t i = 0; i < ring.n; i++) keep(i);
+        return ring.n;
+    }
+    return kept;
+}
+
+void reducePolygons(GeoJsonGeometry& geometry, double tolerance, VertexReducer::Result& result) {
+    if (geometry.type == Type::GeometryCollection) {
+        for (auto& member : geometry.geometries) {
+            reducePolygons(member, tolerance, result);
+        }
+        return;
+    }
+    if (geometry.type != Type::Polygon && geometry.type != Type::MultiPolygon) return;
+
+    // Rings are counted one level above the positions, polygons (for the
+    // shell / hole split) one above that
+    const size_t ring_level = geometry.type == Type::Polygon ? 1 : 2;
+    std::vector<uint32_t> polygon_rings;
+    if (geometry.type == Type::Polygon) {
+        polygon_rings.push_back(static_cast<uint32_t>(geometry.counts[1].size()));
+    } else {
+        polygon_rings.assign(geometry.counts[1].begin(), geometry.counts[1].end());
+    }
+
+    std::pmr::vector<double> out(geometry.coordinates.get_allocator());
+    out.reserve(geometry.coordinates.size());
+    auto& rings = geometry.counts[ring_level];
+    size_t ring_index = 0;
+    size_t position = 0;
+    for (uint32_t count : polygon_rings) {
+        for (uint32_t r = 0; r < count && ring_index < rings.size(); r++, ring_index++) {
+            const uint32_t n = rings[ring_index];
+            const double* c = geometry.coordinates.data() + 3 * position;
+            const double cos_lat = n > 0 ? std::cos(c[1] * M_PI / 180.0) : 1.0;
+            const size_t kept = reduceRing(Ring{c, n, cos_lat}, r == 0, tolerance, out);
+            result.vertices_before += n;
+            result.vertices_removed += n - kept;
+            rings[ring_index] = static_cast<uint32_t>(kept);
+            position += n;
+        }
+    }
+    geometry.coordinates = std::move(out);
+}
+
+} // namespace
+
+VertexReducer::Result VertexReducer::reduce(GeoJsonGeometry& geometry, double tolerance_m) {
+    Result result;
+    reducePolygons(geometry, std::max(tolerance_m, kCollinearM), result);
+    return result;
+}
+
+} // namespace aeronautical
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "GeoJsonReader.h"
+#include <cstddef>
+
+namespace aeronautical {
+
+// Drops polygon vertices that add nothing at the given tolerance: each run
+// of vertices between two kept ones is replaced by the chord only when every
+// vertex of the run lies within tolerance of the chord and on the polygon's
+// side of it. The boundary can then only move outward, so the reduced
+// polygon covers the original and a conflict found with the original is
+// still found. Lines and points are left as they are.
+class VertexReducer {
+public:
+    struct Result {
+        size_t vertices_before = 0;
+        size_t vertices_removed = 0;
+    };
+
+    // Reduces the polygons of geometry in place; tolerance in metres, with
+    // 0 still removing collinear vertices
+    static Result reduce(GeoJsonGeometry& geometry, double tolerance_m);
+};
+
+} // namespace aeronautical
@@ -0,0 +1,190 @@
+#include "VerticalProfile.h"
+#include "ogr_geometry.h"
+#include <json.hpp>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+namespace aeronautical {
+
+namespace {
+
+constexpr double kMetresPerDegree = 111320.0;
+
+// Positions of a GeoJSON LineString, bare or as a Feature's geometry
+std::vector<std::pair<double, double>> linePositions(const std::string& geojson) {
+    std::vector<std::pair<double, double>> positions;
+    auto json = nlohmann::json::parse(geojson, nullptr, false);
+    if (json.is_object() && json.value("type", "") == "Feature" && json.contains("geometry")) {
+        json = json["geometry"];
+    }
+    if (!json.is_object() || json.value("type", "") != "LineString" || !json.contains("coordinates") ||
+        !json["coordinates"].is_array()) {
+        return positions;
+    }
+    for (const auto& position : json["coordinates"]) {
+        if (!position.is_array() || position.size() < 2 || !position[0].is_number() || !position[1].is_number()) {
+            continue;
+        }
+        positions.emplace_back(position[0].get<double>(), position[1].get<double>());
+    }
+    return positions;
+}
+
+std::optional<double> segmentFloor(const ProcedureSegment& segment) {
+    if (segment.altitude_min) return *segment.altitude_min;
+    if (segment.altitude_max && segment.altitude_restriction == AltitudeRestriction::At) return *segment.altitude_max;
+    return std::nullopt;
+}
+
+} // namespace
+
+std::shared_ptr<const VerticalProfile> VerticalProfile::build(std::span<const ProcedureSegment> segments) {
+    std::shared_ptr<VerticalProfile> profile(new VerticalProfile());
+    std::vector<std::pair<double, double>> track; // lng, lat
+    std::vector<std::pair<size_t, double>> fixes; // track vertex and its floor
+    for (const auto& segment : segments) {
+        auto positions = linePositions(segment.trajectory_geometry);
+        for (const auto& position : positions) {
+            // A segment usually starts at the previous one's last fix
+            if (!track.empty() && track.back() == position) continue;
+            track.push_back(position);
+        }
+        auto floor = segmentFloor(segment);
+        if (floor && !positions.empty() && !track.empty()) {
+            fixes.emplace_back(track.size() - 1, *floor);
+        }
+    }
+    if (fixes.empty() || track.size() < 2) {
+        return nullptr;
+    }
+
+    profile->ref_lng_ = track.front().first;
+    profile->ref_lat_ = track.front().second;
+    profile->metres_x_ = kMetresPerDegree * std::cos(profile->ref_lat_ * M_PI / 180.0);
+    std::vector<double> along(track.size(), 0);
+    for (size_t i = 0; i < track.size(); i++) {
+        double x = 0, y = 0;
+        profile->toLocal(track[i].first, track[i].second, x, y);
+        profile->x_.push_back(x);
+        profile->y_.push_back(y);
+        if (i > 0) along[i] = along[i - 1] + std::hypot(x - profile->x_[i - 1], y - profile->y_[i - 1]);
+        OGREnvelope point;
+        point.MinX = point.MaxX = track[i].first;
+        point.MinY = point.MaxY = track[i].second;
+        profile->envelope_.Merge(point);
+    }
+
+    // Linear along track between fixes, level beyond the outer ones
+    profile->floor_ft_.resize(track.size());
+    size_t next = 0;
+    for (size_t i = 0; i < track.size(); i++) {
+        while (next < fixes.size() && fixes[next].first < i) next++;
+        if (next == 0) {
+            profile->floor_ft_[i] = fixes.front().second;
+        } else if (next == fixes.size()) {
+            profile->floor_ft_[i] = fixes.back().second;
+        } else {
+            const auto& [from, from_ft] = fixes[next - 1];
+            const auto& [to, to_ft] = fixes[next];
+            const double span = along[to] - along[from];
+            const double t = span > 0 ? (along[i] - along[from]) / span : 1.0;
+            profile->floor_ft_[i] = from_ft + t * (to_ft - from_ft);
+        }
+    }
+    profile->constraints_ = fixes.size();
+    profile->min_floor_ft_ = *std::min_element(profile->floor_ft_.begin(), profile->floor_ft_.end());
+    profile->max_floor_ft_ = *std::max_element(profile->floor_ft_.begin(), profile->floor_ft_.end());
+    return profile;
+}
+
+void VerticalProfile::toLocal(double lng, double lat, double& x, double& y) const {
+    x = (lng - ref_lng_) * metres_x_;
+    y = (lat - ref_lat_) * kMetresPerDegree;
+}
+
+double VerticalProfile::floorNear(double x, double y) const {
+    double best_distance = std::numeric_limits<double>::max();
+    double best_floor = floor_ft_.front();
+    for (size_t i = 0; i + 1 < x_.size(); i++) {
+        const double dx = x_[i + 1] - x_[i];
+        const double dy = y_[i + 1] - y_[i];
+        const double length2 = dx * dx + dy * dy;
+        double t = length2 > 0 ? ((x - x_[i]) * dx + (y - y_[i]) * dy) / length2 : 0;
+        t = std::clamp(t, 0.0, 1.0);
+        const double ex = x_[i] + t * dx - x;
+        const double ey = y_[i] + t * dy - y;
+        const double distance = ex * ex + ey * ey;
+        if (distance < best_distance) {
+            best_distance = distance;
+            best_floor = floor_ft_[i] + t * (floor_ft_[i + 1] - floor_ft_[i]);
+        }
+    }
+    return best_floor;
+}
+
+double VerticalProfile::floorAt(double lng, double lat) const {
+    double x = 0, y = 0;
+    toLocal(lng, lat, x, y);
+    return floorNear(x, y);
+}
+
+double VerticalProfile::clearance(const OGRGeometry& feature, double top_ft, double margin_ft) const {
+    // Every vertex first, so the track is scanned in one tight loop per vertex
+    std::vector<double> xs;
+    std::vector<double> ys;
+    auto vertex = [&](double lng, double lat) {
+        double x = 0, y = 0;
+        toLocal(lng, lat, x, y);
+        xs.push_back(x);
+        ys.push_back(y);
+    };
+    auto visit = [&](const OGRGeometry& geometry, auto& self) -> void {
+        switch (wkbFlatten(geometry.getGeometryType())) {
+            case wkbPoint: {
+                const auto* point = geometry.toPoint();
+                if (!point->IsEmpty()) vertex(point->getX(), point->getY());
+                break;
+            }
+            case wkbLineString:
+            case wkbLinearRing: {
+                const auto* line = geometry.toLineString();
+                for (int i = 0; i < line->getNumPoints(); i++) vertex(line->getX(i), line->getY(i));
+                break;
+            }
+            case wkbPolygon:
+                for (const auto* ring : *geometry.toPolygon()) self(*ring, self);
+                break;
+            case wkbMultiPoint:
+            case wkbMultiLineString:
+            case wkbMultiPolygon:
+            case wkbGeometryCollection: {
+                const auto* collection = geometry.toGeometryCollection();
+                for (int i = 0; i < collection->getNumGeometries(); i++) self(*collection->getGeometryRef(i), self);
+                break;
+            }
+            default:
+                break;
+        }
+    };
+    visit(feature, visit);
+
+    double lowest = max_floor_ft_;
+    for (size_t i = 0; i < xs.size() && lowest > min_floor_ft_; i++) {
+        lowest = std::min(lowest, floorNear(xs[i], ys[i]));
+    }
+    OGREnvelope feature_envelope;
+    feature.getEnvelope(&feature_envelope);
+    for (size_t i = 0; i < x_.size() && lowest > min_floor_ft_; i++) {
+        const double lng = ref_lng_ + x_[i] / metres_x_;
+        const double lat = ref_lat_ + y_[i] / kMetresPerDegree;
+        if (lng >= feature_envelope.MinX && lng <= feature_envelope.MaxX && lat >= feature_envelope.MinY &&
+            lat <= feature_envelope.MaxY) {
+            lowest = std::min(lowest, floor_ft_[i]);
+        }
+    }
+    return lowest - margin_ft - top_ft;
+}
+
+} // namespace aeronautical
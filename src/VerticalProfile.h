@@ -0,0 +1,63 @@
+#pragma once
+
+#include "FlightProcedure.h"
+#include "ogr_core.h"
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+
+class OGRGeometry;
+
+namespace aeronautical {
+
+// Lowest altitude a procedure is flown at along its track, from the
+// altitude constraints of its segments (ProcedureSegment::altitude_min, or
+// altitude_max for an At restriction). A constraint holds at the segment's
+// last fix; between fixes the floor is interpolated along track, before the
+// first and after the last it stays level. A protection zone under such a
+// profile only matters where a project reaches up to it, which a flat
+// altitude band cannot tell for a descending approach or climbing departure.
+//
+// The track joins the segments' LineStrings in segment order, in an
+// equirectangular frame in metres at its first vertex, like AirportSurfaces.
+class VerticalProfile {
+public:
+    // nullptr without a segment that has both a trajectory and a floor
+    static std::shared_ptr<const VerticalProfile> build(std::span<const ProcedureSegment> segments);
+
+    // Floor in feet MSL at a position, taken at its nearest point on the track
+    double floorAt(double lng, double lat) const;
+
+    // Least clearance in feet between the floor less margin_ft and a feature
+    // whose top is top_ft MSL, negative once the feature reaches it. The
+    // feature's vertices are projected in one pass and each is taken at its
+    // nearest track point; track vertices inside the feature's envelope count
+    // too, so a polygon straddling the track is held to the lowest floor over it.
+    double clearance(const OGRGeometry& feature, double top_ft, double margin_ft = 0) const;
+
+    size_t constraints() const { return constraints_; }
+    double minFloor() const { return min_floor_ft_; }
+    double maxFloor() const { return max_floor_ft_; }
+    const OGREnvelope& envelope() const { return envelope_; }
+
+private:
+    VerticalProfile() = default;
+
+    void toLocal(double lng, double lat, double& x, double& y) const;
+    // Floor at the nearest track point of (x, y), local metres
+    double floorNear(double x, double y) const;
+
+    double ref_lng_ = 0;
+    double ref_lat_ = 0;
+    double metres_x_ = 0; // per degree of longitude at ref_lat_
+    std::vector<double> x_;
+    std::vector<double> y_;
+    std::vector<double> floor_ft_; // per track vertex
+    size_t constraints_ = 0;
+    double min_floor_ft_ = 0;
+    double max_floor_ft_ = 0;
+    OGREnvelope envelope_; // degrees
+};
+
+} // namespace aeronautical
@@ -1,4 +1,5 @@
 #include "Waypoint.h"
+#include "JsonWriter.h"
 #include <json.hpp>
 
 namespace aeronautical {
@@ -18,12 +19,12 @@ nlohmann::json Waypoint::toJson() const {
         json_obj["elevation_ft"] = elevation_ft;
         
         // String fields
-        json_obj["waypoint_type"] = waypoint_type.empty() ? "" : waypoint_type;
-        json_obj["country_code"] = country_code.empty() ? "" : country_code;
-        json_obj["country_name"] = country_name.empty() ? "" : country_name;
-        json_obj["region"] = region.empty() ? "" : region;
+        json_obj["waypoint_type"] = waypoint_type.str();
+        json_obj["country_code"] = country_code.str();
+        json_obj["country_name"] = country_name.str();
+        json_obj["region"] = region.str();
         json_obj["frequency"] = frequency.empty() ? "" : frequency;
-        json_obj["usage_type"] = usage_type.empty() ? "" : usage_type;
+        json_obj["usage_type"] = usage_type.str();
         
         // Boolean field
         json_obj["is_active"] = is_active;
@@ -41,4 +42,23 @@ nlohmann::json Waypoint::toJson() const {
     }
 }
 
+// Keys in sorted order, as nlohmann's object dumps them
+void Waypoint::writeJson(JsonWriter& writer) const {
+    writer.beginObject()
+          .rawField("country_code", country_code)
+          .rawField("country_name", country_name)
+          .rawField("elevation_ft", elevation_ft)
+          .rawField("frequency", frequency)
+          .rawField("id", id)
+          .rawField("is_active", is_active)
+          .rawField("latitude", std::isfinite(latitude) ? latitude : 0.0)
+          .rawField("longitude", std::isfinite(longitude) ? longitude : 0.0)
+          .rawField("name", name)
+          .rawField("region", region)
+          .rawField("usage_type", usage_type)
+          .rawField("waypoint_code", waypoint_code)
+          .rawField("waypoint_type", waypoint_type)
+          .endObject();
+}
+
 } // namespace aeronautical
\ No newline at end of file
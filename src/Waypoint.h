@@ -1,10 +1,13 @@
 #pragma once
 
 #include <string>
+#include "InternedString.h"
 #include <json.hpp>
 
 namespace aeronautical {
 
+class JsonWriter;
+
 struct Waypoint {
     int id;
     std::string waypoint_code;
@@ -12,15 +15,17 @@ struct Waypoint {
     double latitude;
     double longitude;
     int elevation_ft;
-    std::string waypoint_type;  // "VOR", "NDB", "GPS", "TACAN", "DME", "FIX", etc.
-    std::string country_code;
-    std::string country_name;
-    std::string region;
+    InternedString waypoint_type;  // "VOR", "NDB", "GPS", "TACAN", "DME", "FIX", etc.
+    InternedString country_code;
+    InternedString country_name;
+    InternedString region;
     std::string frequency;  // For radio navaids (empty for GPS waypoints)
-    std::string usage_type; // "ENROUTE", "TERMINAL", "APPROACH", "SID", "STAR"
+    InternedString usage_type; // "ENROUTE", "TERMINAL", "APPROACH", "SID", "STAR"
     bool is_active;
     
     nlohmann::json toJson() const;
+    // Same output as toJson().dump(), written straight into the writer
+    void writeJson(JsonWriter& writer) const;
 };
 
 } // namespace aeronautical
\ No newline at end of file
@@ -1,9 +1,35 @@
 #include "WaypointController.h"
+#include "JsonWriter.h"
+#include "ReferenceDataStore.h"
+#include "ChangeLog.h"
+#include "ConditionalGet.h"
+#include "TileCover.h"
+#include <charconv>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
 #include <string>
 #include <spdlog/sinks/stdout_color_sinks.h>
 
 namespace aeronautical {
 
+namespace {
+
+// ?usage= and ?country= as the MySQL fallback applies them, after the query
+// (case-insensitive, like the column collation); empty matches any row
+bool matchesColumns(const Waypoint& waypoint, std::string_view usage_type, std::string_view country_code) {
+    auto same = [](std::string_view a, std::string_view b) {
+        return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+                   return std::tolower(static_cast<unsigned char>(x)) == std::tolower(static_cast<unsigned char>(y));
+               });
+    };
+    return (usage_type.empty() || same(waypoint.usage_type, usage_type)) &&
+           (country_code.empty() || same(waypoint.country_code, country_code));
+}
+
+} // namespace
+
 WaypointController::WaypointController() {
     try {
         logger_ = spdlog::get("aeronautical");
@@ -18,40 +44,56 @@ WaypointController::WaypointController() {
     logger_->set_level(spdlog::level::debug);
 }
 
-void WaypointController::registerRoutes(crow::SimpleApp& app) {
-    // GET /api/waypoints - Get all waypoints with optional filtering
+void WaypointController::registerRoutes(HttpApp& app) {
+    // Reference reads answer 304 while the snapshot version is unchanged
+    // GET /api/waypoints?type=&usage=&country=&active_only=|ids= - Get all waypoints with optional filtering, or the listed ids
     CROW_ROUTE(app, "/api/waypoints")([this](const crow::request& req) { 
-        return getAllWaypoints(req); 
+        return ConditionalGet::serve(req, ConditionalGet::forReferenceData(), [&] { return getAllWaypoints(req); }); 
     });
     
     // GET /api/waypoints/code/:code - Get specific waypoint by code
-    CROW_ROUTE(app, "/api/waypoints/code/<string>")([this](const std::string& code) { 
-        return getWaypointByCode(code); 
+    CROW_ROUTE(app, "/api/waypoints/code/<string>")([this](const crow::request& req, const std::string& code) { 
+        return ConditionalGet::serve(req, ConditionalGet::forReferenceData(), [&] { return getWaypointByCode(code); }); 
     });
     
     // GET /api/waypoints/country/:country - Get waypoints by country
-    CROW_ROUTE(app, "/api/waypoints/country/<string>")([this](const std::string& country) { 
-        return getWaypointsByCountry(country); 
+    CROW_ROUTE(app, "/api/waypoints/country/<string>")([this](const crow::request& req, const std::string& country) { 
+        return ConditionalGet::serve(req, ConditionalGet::forReferenceData(), [&] { return getWaypointsByCountry(country); }); 
     });
     
     // GET /api/waypoints/type/:type - Get waypoints by type (VOR, NDB, GPS, etc.)
-    CROW_ROUTE(app, "/api/waypoints/type/<string>")([this](const std::string& type) { 
-        return getWaypointsByType(type); 
+    CROW_ROUTE(app, "/api/waypoints/type/<string>")([this](const crow::request& req, const std::string& type) { 
+        return ConditionalGet::serve(req, ConditionalGet::forReferenceData(), [&] { return getWaypointsByType(type); }); 
     });
     
     // GET /api/waypoints/usage/:usage - Get waypoints by usage (ENROUTE, TERMINAL, etc.)
-    CROW_ROUTE(app, "/api/waypoints/usage/<string>")([this](const std::string& usage) { 
-        return getWaypointsByUsage(usage); 
+    CROW_ROUTE(app, "/api/waypoints/usage/<string>")([this](const crow::request& req, const std::string& usage) { 
+        return ConditionalGet::serve(req, ConditionalGet::forReferenceData(), [&] { return getWaypointsByUsage(usage); }); 
     });
     
-    // GET /api/waypoints/bounds - Get waypoints within geographical bounds
+    // GET /api/waypoints/bounds?min_lat=&max_lat=&min_lng=&max_lng=[&type=&usage=&country=&zoom=&snap=tiles|none] - Get waypoints within geographical bounds
     CROW_ROUTE(app, "/api/waypoints/bounds")([this](const crow::request& req) { 
-        return getWaypointsInBounds(req); 
+        return ConditionalGet::serve(req, ConditionalGet::forReferenceData(), [&] { return getWaypointsInBounds(req); }); 
     });
     
     // GET /api/waypoints/search - Search waypoints
     CROW_ROUTE(app, "/api/waypoints/search")([this](const crow::request& req) { 
-        return searchWaypoints(req); 
+        return ConditionalGet::serve(req, ConditionalGet::forReferenceData(), [&] { return searchWaypoints(req); }); 
+    });
+    
+    // GET /api/waypoints/nearest?lat=&lng=&k=&type= - Nearest waypoints by great-circle distance
+    CROW_ROUTE(app, "/api/waypoints/nearest")([this](const crow::request& req) {
+        return ConditionalGet::serve(req, ConditionalGet::forReferenceData(), [&] { return getNearestWaypoints(req); });
+    });
+    
+    // POST /api/waypoints/resolve - Many codes in one request, {"codes": [...], "lat": .., "lng": ..}
+    CROW_ROUTE(app, "/api/waypoints/resolve").methods(crow::HTTPMethod::POST)([this](const crow::request& req) {
+        return resolveWaypoints(req);
+    });
+    
+    // GET /api/waypoints/changes?since=<version> - Waypoint ids inserted, updated or deleted since a data version
+    CROW_ROUTE(app, "/api/waypoints/changes")([this](const crow::request& req) {
+        return getWaypointChanges(req);
     });
     
     logger_->info("Waypoint routes registered");
@@ -59,25 +101,56 @@ void WaypointController::registerRoutes(crow::SimpleApp& app) {
 
 crow::response WaypointController::getAllWaypoints(const crow::request& req) {
     try {
-        logger_->debug("Getting all waypoints");
+        SPDLOG_LOGGER_DEBUG(logger_, "Getting all waypoints");
         
         std::string filter_type = req.url_params.get("type") ? req.url_params.get("type") : "";
+        std::string usage_type = req.url_params.get("usage") ? req.url_params.get("usage") : "";
+        std::string country_code = req.url_params.get("country") ? req.url_params.get("country") : "";
         bool active_only = !req.url_params.get("active_only") || std::string(req.url_params.get("active_only")) != "false";
         
-        auto waypoints = waypointRepository_.fetchAllWaypoints(filter_type, active_only);
-        nlohmann::json json_waypoints = nlohmann::json::array();
+        // ?ids= fetches the rows a delta sync (/changes) named, whatever their state
+        if (const char* ids_param = req.url_params.get("ids")) {
+            auto ids = ChangeLog::parseIds(ids_param);
+            if (!ids) {
+                return crow::response(400, createErrorResponse("Invalid parameter: ids (at most " +
+                                                               std::to_string(ChangeLog::kMaxIds) + " comma-separated ids)").dump());
+            }
+            // Without the store /changes always resets, so there is no delta to fetch
+            auto snapshot = ReferenceDataStore::getInstance().snapshot();
+            if (!snapshot) {
+                return crow::response(503, createErrorResponse("Reference data store not loaded", 503).dump());
+            }
+            return listResponse(snapshot->waypointsByIds(*ids));
+        }
+
+        if (auto snapshot = ReferenceDataStore::getInstance().snapshot()) {
+            return listResponse(snapshot->findWaypoints({filter_type, usage_type, country_code, active_only}));
+        }
         
-        for (const auto& waypoint : waypoints) {
+        // Serialize rows straight into the body as they stream from MySQL
+        // instead of holding the result set, a vector and a JSON array at once.
+        // Same layout as createSuccessResponse(...).dump().
+        std::string body;
+        JsonWriter writer(body);
+        writer.beginObject().key("data").beginArray();
+        size_t count = 0;
+        bool ok = waypointRepository_.streamAllWaypoints(filter_type, active_only, [&](const Waypoint& waypoint) {
+            if (!matchesColumns(waypoint, usage_type, country_code)) return;
             try {
-                json_waypoints.push_back(waypoint.toJson());
+                waypoint.writeJson(writer);
+                count++;
             } catch (const std::exception& e) {
                 logger_->warn("Error serializing waypoint {}: {}", waypoint.waypoint_code, e.what());
-                continue; // Skip this waypoint and continue with others
             }
+        });
+        
+        if (!ok) {
+            return crow::response(500, createErrorResponse("Internal server error", 500).dump());
         }
+        writer.endArray().field("status", "success").endObject();
         
-        logger_->debug("Successfully serialized {} waypoints", json_waypoints.size());
-        return crow::response(200, createSuccessResponse(json_waypoints).dump());
+        SPDLOG_LOGGER_DEBUG(logger_, "Successfully serialized {} waypoints", count);
+        return crow::response(200, body);
         
     } catch (const std::exception& e) {
         logger_->error("Error in getAllWaypoints: {}", e.what());
@@ -87,7 +160,15 @@ crow::response WaypointController::getAllWaypoints(const crow::request& req) {
 
 crow::response WaypointController::getWaypointByCode(const std::string& waypoint_code) {
     try {
-        logger_->debug("Getting waypoint by code: {}", waypoint_code);
+        SPDLOG_LOGGER_DEBUG(logger_, "Getting waypoint by code: {}", waypoint_code);
+        
+        if (auto snapshot = ReferenceDataStore::getInstance().snapshot()) {
+            const Waypoint* waypoint = snapshot->waypointByCode(waypoint_code);
+            if (!waypoint) {
+                return crow::response(404, createErrorResponse("Waypoint not found").dump());
+            }
+            return crow::response(200, createSuccessResponse(waypoint->toJson()).dump());
+        }
         
         auto waypoint = waypointRepository_.fetchWaypointByCode(waypoint_code);
         
@@ -105,7 +186,11 @@ crow::response WaypointController::getWaypointByCode(const std::string& waypoint
 
 crow::response WaypointController::getWaypointsByCountry(const std::string& country_code) {
     try {
-        logger_->debug("Getting waypoints by country: {}", country_code);
+        SPDLOG_LOGGER_DEBUG(logger_, "Getting waypoints by country: {}", country_code);
+        
+        if (auto snapshot = ReferenceDataStore::getInstance().snapshot()) {
+            return listResponse(snapshot->waypointsByCountry(country_code, true));
+        }
         
         auto waypoints = waypointRepository_.fetchWaypointsByCountry(country_code, true);
         nlohmann::json json_waypoints = nlohmann::json::array();
@@ -119,7 +204,7 @@ crow::response WaypointController::getWaypointsByCountry(const std::string& coun
             }
         }
         
-        logger_->debug("Successfully found {} waypoints for country {}", json_waypoints.size(), country_code);
+        SPDLOG_LOGGER_DEBUG(logger_, "Successfully found {} waypoints for country {}", json_waypoints.size(), country_code);
         return crow::response(200, createSuccessResponse(json_waypoints).dump());
         
     } catch (const std::exception& e) {
@@ -130,7 +215,11 @@ crow::response WaypointController::getWaypointsByCountry(const std::string& coun
 
 crow::response WaypointController::getWaypointsByType(const std::string& waypoint_type) {
     try {
-        logger_->debug("Getting waypoints by type: {}", waypoint_type);
+        SPDLOG_LOGGER_DEBUG(logger_, "Getting waypoints by type: {}", waypoint_type);
+        
+        if (auto snapshot = ReferenceDataStore::getInstance().snapshot()) {
+            return listResponse(snapshot->waypointsByType(waypoint_type, true));
+        }
         
         auto waypoints = waypointRepository_.fetchWaypointsByType(waypoint_type, true);
         nlohmann::json json_waypoints = nlohmann::json::array();
@@ -144,7 +233,7 @@ crow::response WaypointController::getWaypointsByType(const std::string& waypoin
             }
         }
         
-        logger_->debug("Successfully found {} waypoints of type {}", json_waypoints.size(), waypoint_type);
+        SPDLOG_LOGGER_DEBUG(logger_, "Successfully found {} waypoints of type {}", json_waypoints.size(), waypoint_type);
         return crow::response(200, createSuccessResponse(json_waypoints).dump());
         
     } catch (const std::exception& e) {
@@ -155,7 +244,11 @@ crow::response WaypointController::getWaypointsByType(const std::string& waypoin
 
 crow::response WaypointController::getWaypointsByUsage(const std::string& usage_type) {
     try {
-        logger_->debug("Getting waypoints by usage: {}", usage_type);
+        SPDLOG_LOGGER_DEBUG(logger_, "Getting waypoints by usage: {}", usage_type);
+        
+        if (auto snapshot = ReferenceDataStore::getInstance().snapshot()) {
+            return listResponse(snapshot->waypointsByUsage(usage_type, true));
+        }
         
         auto waypoints = waypointRepository_.fetchWaypointsByUsage(usage_type, true);
         nlohmann::json json_waypoints = nlohmann::json::array();
@@ -169,7 +262,7 @@ crow::response WaypointController::getWaypointsByUsage(const std::string& usage_
             }
         }
         
-        logger_->debug("Successfully found {} waypoints for usage {}", json_waypoints.size(), usage_type);
+        SPDLOG_LOGGER_DEBUG(logger_, "Successfully found {} waypoints for usage {}", json_waypoints.size(), usage_type);
         return crow::response(200, createSuccessResponse(json_waypoints).dump());
         
     } catch (const std::exception& e) {
@@ -180,7 +273,7 @@ crow::response WaypointController::getWaypointsByUsage(const std::string& usage_
 
 crow::response WaypointController::getWaypointsInBounds(const crow::request& req) {
     try {
-        logger_->debug("Getting waypoints in bounds with params: {}", req.url);
+        SPDLOG_LOGGER_DEBUG(logger_, "Getting waypoints in bounds with params: {}", req.url);
         
         // Validate required parameters exist
         const char* min_lat_param = req.url_params.get("min_lat");
@@ -208,16 +301,56 @@ crow::response WaypointController::getWaypointsInBounds(const crow::request& req
             return crow::response(400, createErrorResponse("Boundary parameter out of range").dump());
         }
         
-        // Validate bounds
-        if (!validateBounds(min_lat, max_lat, min_lng, max_lng)) {
+        // Validate bounds; boxes across the antimeridian come back split in two
+        auto bounds = normalizeBounds(min_lat, max_lat, min_lng, max_lng);
+        if (!bounds) {
             logger_->warn("Invalid boundary values: lat({}, {}), lng({}, {})", min_lat, max_lat, min_lng, max_lng);
             return crow::response(400, createErrorResponse("Invalid boundary values").dump());
         }
         
-        logger_->debug("Validated bounds: lat({}, {}), lng({}, {})", min_lat, max_lat, min_lng, max_lng);
+        SPDLOG_LOGGER_DEBUG(logger_, "Validated bounds: lat({}, {}), lng({}, {})", min_lat, max_lat, min_lng, max_lng);
         
         std::string filter_type = req.url_params.get("type") ? req.url_params.get("type") : "";
-        auto waypoints = waypointRepository_.fetchWaypointsInBounds(min_lat, max_lat, min_lng, max_lng, filter_type);
+        std::string usage_type = req.url_params.get("usage") ? req.url_params.get("usage") : "";
+        std::string country_code = req.url_params.get("country") ? req.url_params.get("country") : "";
+        if (auto snapshot = ReferenceDataStore::getInstance().snapshot()) {
+            // ?zoom=N at or below ClusterIndex::kMaxZoom returns clusters instead of every row;
+            // clusters are kept per type only, so ?usage= or ?country= always lists rows
+            const char* zoom_param = req.url_params.get("zoom");
+            if (zoom_param && usage_type.empty() && country_code.empty()) {
+                int zoom = 0;
+                auto res = std::from_chars(zoom_param, zoom_param + std::strlen(zoom_param), zoom);
+                if (res.ec != std::errc() || zoom < 0) {
+                    return crow::response(400, createErrorResponse("Invalid zoom").dump());
+                }
+                if (zoom <= ClusterIndex::kMaxZoom) {
+                    return clusterResponse(*snapshot, snapshot->waypointClusters(*bounds, zoom, filter_type));
+                }
+            }
+            // ?snap=tiles answers with the rows of the tiles covering the box, each cached on its own
+            if (TileCover::snaps(req.url_params.get("snap"))) {
+                const std::string prefix = "waypoints.tile:" + std::to_string(snapshot->version) + ":" + filter_type +
+                                           ":" + usage_type + ":" + country_code + ":";
+                return crow::response(200, TileCover::of(*bounds).body(prefix, [&](int zoom, TileCover::Tile tile) {
+                    return TileCover::rowsIn(zoom, tile,
+                                             snapshot->findWaypointsInBounds(TileCover::tileBounds(zoom, tile),
+                                                                             {filter_type, usage_type, country_code}));
+                }));
+            }
+            return listResponse(snapshot->findWaypointsInBounds(*bounds, {filter_type, usage_type, country_code}));
+        }
+        std::vector<Waypoint> waypoints;
+        for (const auto& range : bounds->lng_ranges) {
+            auto part = waypointRepository_.fetchWaypointsInBounds(bounds->min_lat, bounds->max_lat, range.min, range.max, filter_type);
+            for (auto& waypoint : part) {
+                if (matchesColumns(waypoint, usage_type, country_code)) waypoints.push_back(std::move(waypoint));
+            }
+        }
+        if (bounds->lng_ranges.size() > 1) {
+            // Keep the ORDER BY waypoint_code of a single query
+            std::sort(waypoints.begin(), waypoints.end(),
+                      [](const Waypoint& a, const Waypoint& b) { return a.waypoint_code < b.waypoint_code; });
+        }
 
         nlohmann::json json_waypoints = nlohmann::json::array();
         for (const auto& waypoint : waypoints) {
@@ -229,7 +362,7 @@ crow::response WaypointController::getWaypointsInBounds(const crow::request& req
             }
         }
         
-        logger_->debug("Successfully found {} waypoints in bounds", json_waypoints.size());
+        SPDLOG_LOGGER_DEBUG(logger_, "Successfully found {} waypoints in bounds", json_waypoints.size());
         return crow::response(200, createSuccessResponse(json_waypoints).dump());
         
     } catch (const std::exception& e) {
@@ -240,7 +373,7 @@ crow::response WaypointController::getWaypointsInBounds(const crow::request& req
 
 crow::response WaypointController::searchWaypoints(const crow::request& req) {
     try {
-        logger_->debug("Searching waypoints with params: {}", req.url);
+        SPDLOG_LOGGER_DEBUG(logger_, "Searching waypoints with params: {}", req.url);
         
         auto query = req.url_params.get("q");
         if (!query) {
@@ -261,7 +394,11 @@ crow::response WaypointController::searchWaypoints(const crow::request& req) {
             }
         }
 
-        logger_->debug("Searching for '{}' with limit {}", query, limit);
+        SPDLOG_LOGGER_DEBUG(logger_, "Searching for '{}' with limit {}", query, limit);
+        
+        if (auto snapshot = ReferenceDataStore::getInstance().snapshot()) {
+            return listResponse(snapshot->searchWaypoints(query, limit));
+        }
         
         auto waypoints = waypointRepository_.searchWaypointsByQuery(query, limit);
         nlohmann::json json_waypoints = nlohmann::json::array();
@@ -275,7 +412,7 @@ crow::response WaypointController::searchWaypoints(const crow::request& req) {
             }
         }
         
-        logger_->debug("Search for '{}' returned {} waypoints", query, json_waypoints.size());
+        SPDLOG_LOGGER_DEBUG(logger_, "Search for '{}' returned {} waypoints", query, json_waypoints.size());
         return crow::response(200, createSuccessResponse(json_waypoints).dump());
         
     } catch (const std::exception& e) {
@@ -284,19 +421,253 @@ crow::response WaypointController::searchWaypoints(const crow::request& req) {
     }
 }
 
+crow::response WaypointController::getNearestWaypoints(const crow::request& req) {
+    try {
+        SPDLOG_LOGGER_DEBUG(logger_, "Getting nearest waypoints with params: {}", req.url);
+
+        const char* lat_param = req.url_params.get("lat");
+        const char* lng_param = req.url_params.get("lng");
+        if (!lat_param || !lng_param) {
+            return crow::response(400, createErrorResponse("Missing required parameters: lat, lng").dump());
+        }
+
+        double lat, lng;
+        try {
+            lat = std::stod(lat_param);
+            lng = std::stod(lng_param);
+        } catch (const std::exception& e) {
+            logger_->warn("Invalid nearest point format: {}", e.what());
+            return crow::response(400, createErrorResponse("Invalid number format in lat/lng").dump());
+        }
+        if (!std::isfinite(lat) || !std::isfinite(lng) || lat < -90.0 || lat > 90.0) {
+            return crow::response(400, createErrorResponse("Invalid point").dump());
+        }
+
+        int k = 10;
+        if (const char* k_param = req.url_params.get("k")) {
+            auto res = std::from_chars(k_param, k_param + std::strlen(k_param), k);
+            if (res.ec != std::errc() || k <= 0 || k > 100) {
+                return crow::response(400, createErrorResponse("k must be between 1 and 100").dump());
+            }
+        }
+
+        std::string filter_type = req.url_params.get("type") ? req.url_params.get("type") : "";
+        if (auto snapshot = ReferenceDataStore::getInstance().snapshot()) {
+            return nearestResponse(snapshot->nearestWaypoints(lat, lng, static_cast<size_t>(k), filter_type));
+        }
+
+        // Same widening circle as SpatialGrid::nearest, one bounds query per step
+        std::vector<Waypoint> waypoints;
+        std::vector<std::pair<size_t, double>> found;
+        for (double radius = 25.0;; radius *= 4.0) {
+            auto bounds = GeoBounds::aroundPoint(lat, lng, radius);
+            waypoints.clear();
+            for (const auto& range : bounds->lng_ranges) {
+                auto part = waypointRepository_.fetchWaypointsInBounds(bounds->min_lat, bounds->max_lat, range.min, range.max, filter_type);
+                waypoints.insert(waypoints.end(), part.begin(), part.end());
+            }
+            bool whole_globe = radius >= 20015.1; // half the circumference
+            found.clear();
+            for (size_t i = 0; i < waypoints.size(); i++) {
+                double distance = greatCircleKm(lat, lng, waypoints[i].latitude, waypoints[i].longitude);
+                if (whole_globe || distance <= radius) {
+                    found.emplace_back(i, distance);
+                }
+            }
+            if (found.size() >= static_cast<size_t>(k) || whole_globe) {
+                break;
+            }
+        }
+
+        std::sort(found.begin(), found.end(), [&](const auto& a, const auto& b) {
+            return a.second != b.second ? a.second < b.second : waypoints[a.first].waypoint_code < waypoints[b.first].waypoint_code;
+        });
+        found.resize(std::min(found.size(), static_cast<size_t>(k)));
+        std::vector<std::pair<const Waypoint*, double>> nearest;
+        for (const auto& [i, distance] : found) {
+            nearest.emplace_back(&waypoints[i], distance);
+        }
+        return nearestResponse(nearest);
+
+    } catch (const std::exception& e) {
+        logger_->error("Error in getNearestWaypoints: {}", e.what());
+        return crow::response(500, createErrorResponse("Internal server error", 500).dump());
+    }
+}
+
 // Helper Methods
-bool WaypointController::validateBounds(double min_lat, double max_lat, double min_lng, double max_lng) {
-    // Check latitude bounds
-    if (min_lat < -90.0 || min_lat > 90.0) return false;
-    if (max_lat < -90.0 || max_lat > 90.0) return false;
-    if (min_lat > max_lat) return false;
-    
-    // Check longitude bounds
-    if (min_lng < -180.0 || min_lng > 180.0) return false;
-    if (max_lng < -180.0 || max_lng > 180.0) return false;
-    if (min_lng > max_lng) return false;
-    
-    return true;
+crow::response WaypointController::getWaypointChanges(const crow::request& req) {
+    try {
+        auto since = ChangeLog::parseVersion(req.url_params.get("since"));
+        if (!since) {
+            return crow::response(400, createErrorResponse("Missing or invalid parameter: since").dump());
+        }
+
+        // Without the in-memory store nothing tracks changes, so always reload
+        ChangeSet changes;
+        if (ReferenceDataStore::getInstance().snapshot()) {
+            changes = ChangeLog::getInstance().changesSince(ChangeLog::Table::Waypoints, *since);
+        } else {
+            changes.since = *since;
+            changes.version = ChangeLog::getInstance().version();
+            changes.reset = true;
+        }
+        return crow::response(200, createSuccessResponse(changes.toJson()).dump());
+
+    } catch (const std::exception& e) {
+        logger_->error("Error in getWaypointChanges: {}", e.what());
+        return crow::response(500, createErrorResponse("Internal server error", 500).dump());
+    }
+}
+
+// Codes held by several rows go to the one nearest lat/lng when given,
+// active rows before inactive ones, else to the row /code/<code> returns.
+// Answers keep the order of the codes.
+crow::response WaypointController::resolveWaypoints(const crow::request& req) {
+    constexpr size_t kMaxCodes = 1000;
+    try {
+        nlohmann::json body;
+        try {
+            body = nlohmann::json::parse(req.body);
+        } catch (const nlohmann::json::exception&) {
+            return crow::response(400, createErrorResponse("Invalid JSON format").dump());
+        }
+        if (!body.is_object() || !body.contains("codes") || !body["codes"].is_array()) {
+            return crow::response(400, createErrorResponse("Body must be an object with a codes array").dump());
+        }
+        const auto& codes = body["codes"];
+        if (codes.size() > kMaxCodes) {
+            return crow::response(400, createErrorResponse("At most " + std::to_string(kMaxCodes) + " codes per request").dump());
+        }
+        std::optional<std::pair<double, double>> reference;
+        if (body.contains("lat") || body.contains("lng")) {
+            if (!body.value("lat", nlohmann::json()).is_number() || !body.value("lng", nlohmann::json()).is_number()) {
+                return crow::response(400, createErrorResponse("lat and lng must both be numbers").dump());
+            }
+            const double lat = body["lat"].get<double>();
+            const double lng = body["lng"].get<double>();
+            if (lat < -90.0 || lat > 90.0 || lng < -180.0 || lng > 180.0) {
+                return crow::response(400, createErrorResponse("Invalid reference point").dump());
+            }
+            reference.emplace(lat, lng);
+        }
+        for (const auto& code : codes) {
+            if (!code.is_string()) {
+                return crow::response(400, createErrorResponse("codes must be strings").dump());
+            }
+        }
+
+        auto snapshot = ReferenceDataStore::getInstance().snapshot();
+        std::string out;
+        JsonWriter writer(out);
+        writer.beginObject().rawKey("data").beginArray();
+        size_t resolved = 0;
+        for (const auto& entry : codes) {
+            const std::string& code = entry.get_ref<const std::string&>();
+            writer.beginObject().rawField("code", code);
+
+            // Without the in-memory store each code is one query and duplicates are not seen
+            std::optional<Waypoint> fetched;
+            std::vector<const Waypoint*> candidates;
+            if (snapshot) {
+                candidates = snapshot->waypointsByCode(code);
+            } else if ((fetched = waypointRepository_.fetchWaypointByCode(code))) {
+                candidates.push_back(&*fetched);
+            }
+
+            const Waypoint* best = nullptr;
+            double best_km = 0.0;
+            for (const Waypoint* candidate : candidates) {
+                const double km = reference ? greatCircleKm(reference->first, reference->second,
+                                                            candidate->latitude, candidate->longitude)
+                                            : 0.0;
+                if (!best || (candidate->is_active && !best->is_active) ||
+                    (candidate->is_active == best->is_active && reference && km < best_km)) {
+                    best = candidate;
+                    best_km = km;
+                }
+            }
+
+            writer.rawField("found", best != nullptr);
+            if (best) {
+                writer.rawField("candidates", static_cast<int64_t>(candidates.size()));
+                if (reference) writer.rawField("distance_km", best_km);
+                writer.rawKey("waypoint");
+                best->writeJson(writer);
+                resolved++;
+            }
+            writer.endObject();
+        }
+        writer.endArray()
+              .rawField("resolved", static_cast<int64_t>(resolved))
+              .rawField("unresolved", static_cast<int64_t>(codes.size() - resolved))
+              .rawField("status", "success")
+              .endObject();
+
+        SPDLOG_LOGGER_DEBUG(logger_, "Resolved {} of {} waypoint codes", resolved, codes.size());
+        return crow::response(200, out);
+
+    } catch (const std::exception& e) {
+        logger_->error("Error in resolveWaypoints: {}", e.what());
+        return crow::response(500, createErrorResponse("Internal server error", 500).dump());
+    }
+}
+
+crow::response WaypointController::nearestResponse(const std::vector<std::pair<const Waypoint*, double>>& nearest) {
+    std::string body;
+    JsonWriter writer(body);
+    writer.beginObject().rawKey("data").beginArray();
+    for (const auto& [waypoint, distance_km] : nearest) {
+        writer.beginObject()
+              .rawField("distance_km", distance_km)
+              .rawField("distance_nm", distance_km / 1.852)
+              .rawKey("waypoint");
+        waypoint->writeJson(writer);
+        writer.endObject();
+    }
+    writer.endArray().rawField("status", "success").endObject();
+    return crow::response(200, body);
+}
+
+crow::response WaypointController::listResponse(const std::vector<const Waypoint*>& waypoints) {
+    // Same layout as createSuccessResponse(...).dump()
+    std::string body;
+    JsonWriter writer(body);
+    writer.beginObject().rawKey("data").beginArray();
+    for (const Waypoint* waypoint : waypoints) {
+        waypoint->writeJson(writer);
+    }
+    writer.endArray().rawField("status", "success").endObject();
+    return crow::response(200, body);
+}
+
+crow::response WaypointController::clusterResponse(const ReferenceSnapshot& snapshot,
+                                                 const std::vector<ClusterIndex::Cluster>& clusters) {
+    // Single-member clusters are sent as the waypoint itself; the rest carry "cluster": true
+    std::string body;
+    JsonWriter writer(body);
+    writer.beginObject().rawField("clustered", true).rawKey("data").beginArray();
+    for (const auto& cluster : clusters) {
+        if (cluster.count == 1) {
+            snapshot.waypoints[cluster.first_row].writeJson(writer);
+            continue;
+        }
+        writer.beginObject()
+              .rawField("cluster", true)
+              .rawField("count", static_cast<int64_t>(cluster.count))
+              .rawField("latitude", cluster.latitude)
+              .rawField("longitude", cluster.longitude)
+              .rawField("waypoint_type", *cluster.dominant_type)
+              .endObject();
+    }
+    writer.endArray().rawField("status", "success").endObject();
+    return crow::response(200, body);
+}
+
+std::optional<GeoBounds> WaypointController::normalizeBounds(double min_lat, double max_lat, double min_lng, double max_lng) {
+    // Latitudes must at least overlap the globe; the map's padded box may overshoot the poles
+    if (max_lat < -90.0 || min_lat > 90.0) return std::nullopt;
+    return GeoBounds::fromBox(min_lat, max_lat, min_lng, max_lng);
 }
 
 nlohmann::json WaypointController::createErrorResponse(const std::string& message, int code) {
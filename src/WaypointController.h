@@ -1,22 +1,28 @@
 #pragma once
 
 #include <crow.h>
+#include "HttpApp.h"
 #include <json.hpp>
 #include <string>
 #include <vector>
 #include <memory>
+#include <optional>
 #include <spdlog/spdlog.h>
 #include "Waypoint.h"
+#include "SpatialGrid.h"
+#include "ClusterIndex.h"
 #include "WaypointRepository.h"
 
 namespace aeronautical {
 
+struct ReferenceSnapshot;
+
 class WaypointController {
 public:
     WaypointController();
     ~WaypointController() = default;
     
-    void registerRoutes(crow::SimpleApp& app);
+    void registerRoutes(HttpApp& app);
     
 private:
     std::shared_ptr<spdlog::logger> logger_;
@@ -28,11 +34,17 @@ private:
     crow::response getWaypointsByCountry(const std::string& country_code);
     crow::response getWaypointsInBounds(const crow::request& req);
     crow::response searchWaypoints(const crow::request& req);
+    crow::response getNearestWaypoints(const crow::request& req);
+    crow::response getWaypointChanges(const crow::request& req);
+    crow::response resolveWaypoints(const crow::request& req);
     crow::response getWaypointsByType(const std::string& waypoint_type);
     crow::response getWaypointsByUsage(const std::string& usage_type);
         
     // Helper methods
-    bool validateBounds(double min_lat, double max_lat, double min_lng, double max_lng);
+    crow::response listResponse(const std::vector<const Waypoint*>& waypoints);
+    crow::response nearestResponse(const std::vector<std::pair<const Waypoint*, double>>& nearest);
+    crow::response clusterResponse(const ReferenceSnapshot& snapshot, const std::vector<ClusterIndex::Cluster>& clusters);
+    std::optional<GeoBounds> normalizeBounds(double min_lat, double max_lat, double min_lng, double max_lng);
     nlohmann::json createErrorResponse(const std::string& message, int code = 400);
     nlohmann::json createSuccessResponse(const nlohmann::json& data);
 };
@@ -1,6 +1,8 @@
 #include "WaypointRepository.h"
 #include "DatabaseManager.h"
+#include "RowDecoder.h"
 #include <mysql/mysql.h>
+#include <optional>
 #include <sstream>
 #include <stdexcept>
 #include <spdlog/sinks/stdout_color_sinks.h>
@@ -19,22 +21,21 @@ static std::string escapeString(MYSQL* con, const std::string& str) {
     return result;
 }
 
-// Helper to populate a Waypoint struct from a MYSQL_ROW
-static void populateWaypointFromRow(Waypoint& waypoint, MYSQL_ROW row) {
-    waypoint.id = row[0] ? std::stoi(row[0]) : 0;
-    waypoint.waypoint_code = row[1] ? row[1] : "";
-    waypoint.name = row[2] ? row[2] : "";
-    waypoint.latitude = row[3] ? std::stod(row[3]) : 0.0;
-    waypoint.longitude = row[4] ? std::stod(row[4]) : 0.0;
-    waypoint.elevation_ft = row[5] ? std::stoi(row[5]) : 0;
-    waypoint.waypoint_type = row[6] ? row[6] : "";
-    waypoint.country_code = row[7] ? row[7] : "";
-    waypoint.country_name = row[8] ? row[8] : "";
-    waypoint.region = row[9] ? row[9] : "";
-    waypoint.frequency = row[10] ? row[10] : "";
-    waypoint.usage_type = row[11] ? row[11] : "";
-    waypoint.is_active = row[12] ? (std::string(row[12]) == "1") : false;
-}
+// Column map for the waypoint SELECT lists below
+using WaypointRow = RowMap<Waypoint,
+    Field<&Waypoint::id>,
+    Field<&Waypoint::waypoint_code>,
+    Field<&Waypoint::name>,
+    Field<&Waypoint::latitude>,
+    Field<&Waypoint::longitude>,
+    Field<&Waypoint::elevation_ft>,
+    Field<&Waypoint::waypoint_type>,
+    Field<&Waypoint::country_code>,
+    Field<&Waypoint::country_name>,
+    Field<&Waypoint::region>,
+    Field<&Waypoint::frequency>,
+    Field<&Waypoint::usage_type>,
+    Field<&Waypoint::is_active>>;
 
 WaypointRepository::WaypointRepository() {
     try {
@@ -49,9 +50,8 @@ WaypointRepository::WaypointRepository() {
     }
 }
 
-std::vector<Waypoint> WaypointRepository::fetchAllWaypoints(const std::string& filter_type, bool active_only) {
-    std::vector<Waypoint> waypoints;
-    MYSQL* con = DatabaseManager::getInstance().getConnection();
+// SELECT shared by fetchAllWaypoints and streamAllWaypoints
+static std::string allWaypointsQuery(MYSQL* con, const std::string& filter_type, bool active_only) {
     std::stringstream ss;
     
     // Base query - adjust column names based on your actual table structure
@@ -66,59 +66,78 @@ std::vector<Waypoint> WaypointRepository::fetchAllWaypoints(const std::string& f
         ss << " AND waypoint_type = '" << escapeString(con, filter_type) << "'";
     }
     ss << " ORDER BY waypoint_code ASC";
+    return ss.str();
+}
 
-    if (mysql_query(con, ss.str().c_str())) {
+std::vector<Waypoint> WaypointRepository::fetchAllWaypoints(const std::string& filter_type, bool active_only) {
+    std::vector<Waypoint> waypoints;
+    DatabaseManager::ReadScope scope(DatabaseManager::getInstance());
+    MYSQL* con = scope.get();
+
+    if (mysql_query(con, allWaypointsQuery(con, filter_type, active_only).c_str())) {
         logger_->error("Waypoints query failed: {}", mysql_error(con));
         return waypoints;
     }
 
-    MYSQL_RES* result = mysql_store_result(con);
+    MysqlResult result(mysql_store_result(con));
     if (result == NULL) {
         logger_->warn("No waypoints result set returned");
         return waypoints;
     }
 
     MYSQL_ROW row;
-    while ((row = mysql_fetch_row(result))) {
-        Waypoint waypoint;
-        populateWaypointFromRow(waypoint, row);
-        waypoints.push_back(waypoint);
+    while ((row = mysql_fetch_row(result.get()))) {
+        waypoints.push_back(WaypointRow::decode(row, mysql_fetch_lengths(result.get())));
     }
-    mysql_free_result(result);
     
-    logger_->debug("Found {} waypoints", waypoints.size());
+    SPDLOG_LOGGER_DEBUG(logger_, "Found {} waypoints", waypoints.size());
     return waypoints;
 }
 
-std::optional<Waypoint> WaypointRepository::fetchWaypointByCode(const std::string& waypoint_code) {
-    MYSQL* con = DatabaseManager::getInstance().getConnection();
-    std::stringstream ss;
-    ss << "SELECT id, waypoint_code, name, latitude, longitude, elevation_ft, "
-       << "waypoint_type, country_code, country_name, region, frequency, usage_type, is_active "
-       << "FROM waypoints WHERE waypoint_code = '" << escapeString(con, waypoint_code) << "' LIMIT 1";
+bool WaypointRepository::streamAllWaypoints(const std::string& filter_type, bool active_only,
+                                            const std::function<void(const Waypoint&)>& on_waypoint) {
+    auto& db = DatabaseManager::getInstance();
+    DatabaseManager::ReadScope scope(db);
+    std::string query = allWaypointsQuery(scope.get(), filter_type, active_only);
 
-    if (mysql_query(con, ss.str().c_str())) {
-        logger_->error("Waypoint by code query failed: {}", mysql_error(con));
+    size_t count = 0;
+    bool ok = db.streamSelectQuery(query, [&](MYSQL_ROW row, unsigned long* lengths) {
+        on_waypoint(WaypointRow::decode(row, lengths));
+        count++;
+        return true;
+    });
+
+    if (!ok) {
+        logger_->error("Streaming waypoints failed after {} rows", count);
+    } else {
+        SPDLOG_LOGGER_DEBUG(logger_, "Streamed {} waypoints", count);
+    }
+    return ok;
+}
+
+std::optional<Waypoint> WaypointRepository::fetchWaypointByCode(const std::string& waypoint_code) {
+    PreparedResult result;
+    try {
+        result = DatabaseManager::getInstance().executePrepared(
+            "SELECT id, waypoint_code, name, latitude, longitude, elevation_ft, "
+            "waypoint_type, country_code, country_name, region, frequency, usage_type, is_active "
+            "FROM waypoints WHERE waypoint_code = ? LIMIT 1", {waypoint_code});
+    } catch (const SqlError& e) {
+        logger_->error("Waypoint by code query failed: {}", e.what());
         return std::nullopt;
     }
 
-    MYSQL_RES* result = mysql_store_result(con);
-    if (result == NULL || mysql_num_rows(result) == 0) {
-        if(result) mysql_free_result(result);
+    if (result.rows.empty()) {
         return std::nullopt;
     }
 
-    MYSQL_ROW row = mysql_fetch_row(result);
-    Waypoint waypoint;
-    populateWaypointFromRow(waypoint, row);
-    
-    mysql_free_result(result);
-    return waypoint;
+    return WaypointRow::decode(result.rows.front());
 }
 
 std::vector<Waypoint> WaypointRepository::fetchWaypointsByCountry(const std::string& country_code, bool active_only) {
     std::vector<Waypoint> waypoints;
-    MYSQL* con = DatabaseManager::getInstance().getConnection();
+    DatabaseManager::ReadScope scope(DatabaseManager::getInstance());
+    MYSQL* con = scope.get();
     std::stringstream ss;
     ss << "SELECT id, waypoint_code, name, latitude, longitude, elevation_ft, "
        << "waypoint_type, country_code, country_name, region, frequency, usage_type, is_active "
@@ -133,18 +152,15 @@ std::vector<Waypoint> WaypointRepository::fetchWaypointsByCountry(const std::str
         return waypoints;
     }
 
-    MYSQL_RES* result = mysql_store_result(con);
+    MysqlResult result(mysql_store_result(con));
     if (result == NULL) return waypoints;
 
     MYSQL_ROW row;
-    while ((row = mysql_fetch_row(result))) {
-        Waypoint waypoint;
-        populateWaypointFromRow(waypoint, row);
-        waypoints.push_back(waypoint);
+    while ((row = mysql_fetch_row(result.get()))) {
+        waypoints.push_back(WaypointRow::decode(row, mysql_fetch_lengths(result.get())));
     }
-    mysql_free_result(result);
     
-    logger_->debug("Found {} waypoints for country {}", waypoints.size(), country_code);
+    SPDLOG_LOGGER_DEBUG(logger_, "Found {} waypoints for country {}", waypoints.size(), country_code);
     return waypoints;
 }
 
@@ -152,7 +168,8 @@ std::vector<Waypoint> WaypointRepository::fetchWaypointsInBounds(double min_lat,
                                                                 double min_lng, double max_lng, 
                                                                 const std::string& filter_type) {
     std::vector<Waypoint> waypoints;
-    MYSQL* con = DatabaseManager::getInstance().getConnection();
+    DatabaseManager::ReadScope scope(DatabaseManager::getInstance());
+    MYSQL* con = scope.get();
     std::stringstream ss;
     ss << "SELECT id, waypoint_code, name, latitude, longitude, elevation_ft, "
        << "waypoint_type, country_code, country_name, region, frequency, usage_type, is_active "
@@ -168,24 +185,22 @@ std::vector<Waypoint> WaypointRepository::fetchWaypointsInBounds(double min_lat,
         return waypoints;
     }
     
-    MYSQL_RES* result = mysql_store_result(con);
+    MysqlResult result(mysql_store_result(con));
     if (result == NULL) return waypoints;
 
     MYSQL_ROW row;
-    while ((row = mysql_fetch_row(result))) {
-        Waypoint waypoint;
-        populateWaypointFromRow(waypoint, row);
-        waypoints.push_back(waypoint);
+    while ((row = mysql_fetch_row(result.get()))) {
+        waypoints.push_back(WaypointRow::decode(row, mysql_fetch_lengths(result.get())));
     }
-    mysql_free_result(result);
     
-    logger_->debug("Found {} waypoints in bounds", waypoints.size());
+    SPDLOG_LOGGER_DEBUG(logger_, "Found {} waypoints in bounds", waypoints.size());
     return waypoints;
 }
 
 std::vector<Waypoint> WaypointRepository::searchWaypointsByQuery(const std::string& query, int limit) {
     std::vector<Waypoint> waypoints;
-    MYSQL* con = DatabaseManager::getInstance().getConnection();
+    DatabaseManager::ReadScope scope(DatabaseManager::getInstance());
+    MYSQL* con = scope.get();
     std::string search_query = "%" + escapeString(con, query) + "%";
     std::stringstream ss;
     ss << "SELECT id, waypoint_code, name, latitude, longitude, elevation_ft, "
@@ -200,24 +215,22 @@ std::vector<Waypoint> WaypointRepository::searchWaypointsByQuery(const std::stri
         return waypoints;
     }
     
-    MYSQL_RES* result = mysql_store_result(con);
+    MysqlResult result(mysql_store_result(con));
     if (result == NULL) return waypoints;
 
     MYSQL_ROW row;
-    while ((row = mysql_fetch_row(result))) {
-        Waypoint waypoint;
-        populateWaypointFromRow(waypoint, row);
-        waypoints.push_back(waypoint);
+    while ((row = mysql_fetch_row(result.get()))) {
+        waypoints.push_back(WaypointRow::decode(row, mysql_fetch_lengths(result.get())));
     }
-    mysql_free_result(result);
     
-    logger_->debug("Found {} waypoints for search '{}'", waypoints.size(), query);
+    SPDLOG_LOGGER_DEBUG(logger_, "Found {} waypoints for search '{}'", waypoints.size(), query);
     return waypoints;
 }
 
 std::vector<Waypoint> WaypointRepository::fetchWaypointsByType(const std::string& waypoint_type, bool active_only) {
     std::vector<Waypoint> waypoints;
-    MYSQL* con = DatabaseManager::getInstance().getConnection();
+    DatabaseManager::ReadScope scope(DatabaseManager::getInstance());
+    MYSQL* con = scope.get();
     std::stringstream ss;
     ss << "SELECT id, waypoint_code, name, latitude, longitude, elevation_ft, "
        << "waypoint_type, country_code, country_name, region, frequency, usage_type, is_active "
@@ -232,24 +245,22 @@ std::vector<Waypoint> WaypointRepository::fetchWaypointsByType(const std::string
         return waypoints;
     }
 
-    MYSQL_RES* result = mysql_store_result(con);
+    MysqlResult result(mysql_store_result(con));
     if (result == NULL) return waypoints;
 
     MYSQL_ROW row;
-    while ((row = mysql_fetch_row(result))) {
-        Waypoint waypoint;
-        populateWaypointFromRow(waypoint, row);
-        waypoints.push_back(waypoint);
+    while ((row = mysql_fetch_row(result.get()))) {
+        waypoints.push_back(WaypointRow::decode(row, mysql_fetch_lengths(result.get())));
     }
-    mysql_free_result(result);
     
-    logger_->debug("Found {} waypoints of type {}", waypoints.size(), waypoint_type);
+    SPDLOG_LOGGER_DEBUG(logger_, "Found {} waypoints of type {}", waypoints.size(), waypoint_type);
     return waypoints;
 }
 
 std::vector<Waypoint> WaypointRepository::fetchWaypointsByUsage(const std::string& usage_type, bool active_only) {
     std::vector<Waypoint> waypoints;
-    MYSQL* con = DatabaseManager::getInstance().getConnection();
+    DatabaseManager::ReadScope scope(DatabaseManager::getInstance());
+    MYSQL* con = scope.get();
     std::stringstream ss;
     ss << "SELECT id, waypoint_code, name, latitude, longitude, elevation_ft, "
        << "waypoint_type, country_code, country_name, region, frequency, usage_type, is_active "
@@ -264,19 +275,84 @@ std::vector<Waypoint> WaypointRepository::fetchWaypointsByUsage(const std::strin
         return waypoints;
     }
 
-    MYSQL_RES* result = mysql_store_result(con);
+    MysqlResult result(mysql_store_result(con));
     if (result == NULL) return waypoints;
 
     MYSQL_ROW row;
-    while ((row = mysql_fetch_row(result))) {
-        Waypoint waypoint;
-        populateWaypointFromRow(waypoint, row);
-        waypoints.push_back(waypoint);
+    while ((row = mysql_fetch_row(result.get()))) {
+        waypoints.push_back(WaypointRow::decode(row, mysql_fetch_lengths(result.get())));
     }
-    mysql_free_result(result);
     
-    logger_->debug("Found {} waypoints for usage {}", waypoints.size(), usage_type);
+    SPDLOG_LOGGER_DEBUG(logger_, "Found {} waypoints for usage {}", waypoints.size(), usage_type);
     return waypoints;
 }
 
+bool WaypointRepository::upsertBatch(const std::vector<Waypoint>& waypoints,
+                                     const std::vector<std::string>& update_columns) {
+    auto& db = DatabaseManager::getInstance();
+
+    std::string suffix = " ON DUPLICATE KEY UPDATE ";
+    for (size_t i = 0; i < update_columns.size(); i++) {
+        suffix += (i ? ", " : "") + update_columns[i] + " = VALUES(" + update_columns[i] + ")";
+    }
+    if (update_columns.empty()) {
+        suffix += "id = id";
+    }
+
+    try {
+        DatabaseManager::Transaction transaction(db);
+        MYSQL* con = transaction.get();
+
+        auto rowSql = [con](const Waypoint& w) {
+            std::stringstream row;
+            row.precision(10);
+            row << "(" << (w.id > 0 ? std::to_string(w.id) : "NULL") << ", '" << escapeString(con, w.waypoint_code)
+                << "', '" << escapeString(con, w.name) << "', " << w.latitude << ", " << w.longitude << ", "
+                << w.elevation_ft << ", '" << escapeString(con, w.waypoint_type) << "', '"
+                << escapeString(con, w.country_code) << "', '" << escapeString(con, w.country_name) << "', '"
+                << escapeString(con, w.region) << "', '" << escapeString(con, w.frequency) << "', '"
+                << escapeString(con, w.usage_type) << "', " << (w.is_active ? 1 : 0) << ")";
+            return row.str();
+        };
+
+        const std::string prefix =
+            "INSERT INTO waypoints (id, waypoint_code, name, latitude, longitude, elevation_ft, waypoint_type, "
+            "country_code, country_name, region, frequency, usage_type, is_active) VALUES ";
+        std::string statement;
+        size_t rows_in_statement = 0;
+        bool ok = true;
+        for (size_t i = 0; ok && i < waypoints.size(); i++) {
+            std::string row = rowSql(waypoints[i]);
+            // Flush before this row would push the statement past the size limit
+            if (rows_in_statement > 0 &&
+                statement.size() + row.size() + suffix.size() + 1 > kMaxInsertStatementBytes) {
+                ok = db.executeQuery(statement + suffix);
+                statement.clear();
+                rows_in_statement = 0;
+            }
+            statement += rows_in_statement == 0 ? prefix : ",";
+            statement += row;
+            rows_in_statement++;
+        }
+        if (ok && rows_in_statement > 0) {
+            ok = db.executeQuery(statement + suffix);
+        }
+
+        if (!ok) {
+            transaction.rollback();
+            logger_->error("Rolled back import of {} waypoints", waypoints.size());
+            return false;
+        }
+        if (!transaction.commit()) {
+            logger_->error("Failed to commit import of {} waypoints", waypoints.size());
+            return false;
+        }
+        return true;
+
+    } catch (const std::exception& err) {
+        logger_->error("Exception importing waypoints: {}", err.what());
+        return false;
+    }
+}
+
 } // namespace aeronautical
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include <vector>
 #include <string>
 #include <optional>
+#include <functional>
 #include <spdlog/spdlog.h>
 
 #ifdef USE_MYSQL_C_API
@@ -21,6 +22,9 @@ public:
     
     // Read-only operations
     std::vector<Waypoint> fetchAllWaypoints(const std::string& filter_type = "", bool active_only = true);
+    // Same rows as fetchAllWaypoints, handed over one at a time as they stream from MySQL
+    bool streamAllWaypoints(const std::string& filter_type, bool active_only,
+                            const std::function<void(const Waypoint&)>& on_waypoint);
     std::optional<Waypoint> fetchWaypointByCode(const std::string& waypoint_code);
     std::vector<Waypoint> fetchWaypointsByCountry(const std::string& country_code, bool active_only = true);
     std::vector<Waypoint> fetchWaypointsInBounds(double min_lat, double max_lat, 
@@ -30,6 +34,14 @@ public:
     std::vector<Waypoint> fetchWaypointsByType(const std::string& waypoint_type, bool active_only = true);
     std::vector<Waypoint> fetchWaypointsByUsage(const std::string& usage_type, bool active_only = true);
 
+    // Writes waypoints in one transaction as multi-row INSERT ... ON DUPLICATE
+    // KEY UPDATE statements of at most kMaxInsertStatementBytes each. Rows
+    // with an id replace that row, id 0 gets a new one; a row that already
+    // exists only takes update_columns. Nothing is written on failure.
+    bool upsertBatch(const std::vector<Waypoint>& waypoints, const std::vector<std::string>& update_columns);
+
+    static constexpr size_t kMaxInsertStatementBytes = 4 * 1024 * 1024;
+
 private:
     std::shared_ptr<spdlog::logger> logger_;
     
@@ -0,0 +1,110 @@
+#include "ZoneEvaluator.h"
+#include "GeometryJson.h"
+#include "PolygonRings.h"
+#include <spdlog/spdlog.h>
+
+namespace aeronautical {
+
+ZoneEvaluator::Result ZoneEvaluator::evaluate(const CachedProtectionGeometry& zone, int procedure_id,
+                                              const std::vector<GeometryHandle>& project_geometries,
+                                              std::span<const size_t> features, bool materialize, bool metrics,
+                                              std::pmr::memory_resource* resource,
+                                              std::span<const GeosBackend::Geometry> geos_features, Timing* timing) {
+    Result result(resource);
+    // Time since the last charge goes to the given bucket; free without timing
+    auto mark = timing ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+    auto charge = [&](std::chrono::nanoseconds Timing::*bucket) {
+        if (timing) {
+            const auto now = std::chrono::steady_clock::now();
+            timing->*bucket += now - mark;
+            mark = now;
+        }
+    };
+
+    for (size_t i : features) {
+        OGRGeometryH hProject = project_geometries[i].get();
+        OGRGeometry* project_geometry = geometryOf(project_geometries[i]);
+        const GEOSGeom_t* project_geos = i < geos_features.size() ? geos_features[i].get() : nullptr;
+
+        try {
+            // Points and lines are located on the zone's rings without GEOS; other
+            // features use it, and with a prepared zone (or inside one tile of a
+            // subdivided zone) one lying inside needs no overlay
+            bool inside = false;
+            bool intersects = false;
+            if (auto relation = zone.relate(*project_geometry)) {
+                inside = *relation == PolygonRings::Relation::Inside;
+                intersects = *relation != PolygonRings::Relation::Disjoint;
+            } else {
+                inside = zone.hasPrepared() ? zone.contains(*project_geometry, project_geos)
+                                            : zone.tileContains(*project_geometry, project_geos);
+                intersects = inside || zone.intersects(*project_geometry, project_geos);
+            }
+            charge(&Timing::predicate);
+
+            if (inside) {
+                result.conflict = true;
+                result.hits.push_back({i, true, materialize ? GeometryJson::write(hProject) : std::string()});
+                charge(&Timing::export_json);
+                if (metrics) {
+                    result.hits.back().overlap = FeatureOverlap::whole(hProject);
+                    charge(&Timing::intersection);
+                }
+                spdlog::debug("Project geometry {} lies inside procedure {}", i, procedure_id);
+            } else if (intersects) {
+                result.conflict = true;
+                result.hits.push_back({i, false, {}});
+                if (!materialize) {
+                    if (metrics) {
+                        result.hits.back().overlap = FeatureOverlap::estimate(
+                            hProject, (OGRGeometryH)zone.geometry.get(), zone.envelope);
+                        charge(&Timing::intersection);
+                    }
+                    continue;
+                }
+
+                // Compute intersection for this specific geometry pair; in GEOS
+                // form only the result is converted
+                GeometryHandle intersection;
+                if (project_geos && zone.geos) {
+                    intersection = GeosBackend::toOgr(GeosBackend::intersection(project_geos, zone.geos.get()).get());
+                } else {
+                    intersection.reset(OGR_G_Intersection(hProject, (OGRGeometryH)zone.geometry.get()));
+                }
+                if (metrics) {
+                    result.hits.back().overlap = FeatureOverlap::fromIntersection(hProject, intersection.get());
+                }
+                charge(&Timing::intersection);
+                if (intersection) {
+                    result.hits.back().intersection_json = GeometryJson::write(intersection.get());
+                    charge(&Timing::export_json);
+                    spdlog::debug("Conflict found between project geometry {} and procedure {}",
+                                i, procedure_id);
+                }
+            }
+        } catch (const std::exception& e) {
+            charge(&Timing::predicate);
+            result.errors++;
+            spdlog::error("Exception during intersection check between project geometry {} and procedure {}: {}",
+                        i, procedure_id, e.what());
+        }
+    }
+    return result;
+}
+
+std::vector<GeosBackend::Geometry> ZoneEvaluator::toGeos(const std::vector<GeometryHandle>& project_geometries,
+                                                         std::span<const size_t> features) {
+    std::vector<GeosBackend::Geometry> converted;
+    if (!GeosBackend::available()) {
+        return converted;
+    }
+    converted.resize(project_geometries.size());
+    for (size_t i : features) {
+        if (const OGRGeometry* geometry = geometryOf(project_geometries[i])) {
+            converted[i] = GeosBackend::fromOgr(*geometry);
+        }
+    }
+    return converted;
+}
+
+} // namespace aeronautical
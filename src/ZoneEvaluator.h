@@ -0,0 +1,63 @@
+#pragma once
+
+#include "ConflictMetrics.h"
+#include "ProtectionGeometryCache.h"
+#include "OgrHandles.h"
+#include "ogr_api.h"
+#include <chrono>
+#include <memory_resource>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace aeronautical {
+
+// The geometry work of a conflict analysis for one protection zone, free of
+// repositories and MySQL so the engine can be measured on its own
+// (bench/bench_conflicts.cpp).
+class ZoneEvaluator {
+public:
+    struct Hit {
+        size_t feature = 0;
+        bool inside = false;           // entirely within the zone
+        std::string intersection_json; // empty unless materialized
+        std::optional<FeatureOverlap> overlap{};
+    };
+
+    struct Result {
+        Result() = default;
+        explicit Result(std::pmr::memory_resource* resource) : hits(resource) {}
+
+        bool conflict = false;
+        std::pmr::vector<Hit> hits; // in feature order
+        size_t errors = 0;          // features whose check threw; absent from hits
+    };
+
+    // Where evaluate spent its time, added to across calls
+    struct Timing {
+        std::chrono::nanoseconds predicate{0};    // intersects / contains
+        std::chrono::nanoseconds intersection{0}; // overlays and overlap metrics
+        std::chrono::nanoseconds export_json{0};  // GeoJSON of the intersections
+    };
+
+    // Predicates of the listed project features against one zone; with
+    // materialize, also the GeoJSON of their intersections, and with metrics
+    // the overlap of each feature (exact when materialized, bounds-first otherwise).
+    // The hit list is allocated from resource; intersection texts are not.
+    // geos_features, when given, holds the project features in GEOS form
+    // (see toGeos), indexed like project_geometries; predicates and overlays
+    // then run on them directly. timing, when given, is added to.
+    static Result evaluate(const CachedProtectionGeometry& zone, int procedure_id,
+                           const std::vector<GeometryHandle>& project_geometries, std::span<const size_t> features,
+                           bool materialize, bool metrics,
+                           std::pmr::memory_resource* resource = std::pmr::get_default_resource(),
+                           std::span<const GeosBackend::Geometry> geos_features = {}, Timing* timing = nullptr);
+
+    // The listed features in GEOS form, once per analysis, indexed like
+    // project_geometries; empty without the GEOS backend
+    static std::vector<GeosBackend::Geometry> toGeos(const std::vector<GeometryHandle>& project_geometries,
+                                                     std::span<const size_t> features);
+};
+
+} // namespace aeronautical
@@ -1,36 +1,568 @@
 #include <crow.h>
 #include <spdlog/spdlog.h>
+#include <spdlog/async.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
 #include <spdlog/sinks/rotating_file_sink.h>
 #include <json.hpp>
 
 #include "DatabaseManager.h"
+#include "DbExecutor.h"
+#include "ResultCache.h"
+#include "QueryStats.h"
+#include "Metrics.h"
+#include "Tracing.h"
 #include "ProjectController.h"
 #include "FlightProcedureController.h"
 #include "AirportController.h"
 #include "WaypointController.h"
+#include "AnalysisController.h"
+#include "BatchController.h"
+#include "FrontendController.h"
+#include "AnalysisEventHub.h"
+#include "ProtectionGeometryCache.h"
+#include "ConflictArchiver.h"
+#include "AccessProfile.h"
+#include "AnalysisShadow.h"
+#include "SimplifiedGeometryCache.h"
+#include "ConflictController.h"
+#include "ConflictMemo.h"
+#include "AnalysisJobQueue.h"
+#include "AnalysisJobStore.h"
+#include "CacheEvents.h"
+#include "ReferenceDataStore.h"
+#include "TerrainService.h"
+#include "DocumentPipeline.h"
+#include "ProjectSpatialIndex.h"
+#include "ProjectSearchIndex.h"
+#include "ConflictHeatmap.h"
+#include "AuditWriter.h"
+#include "ExportService.h"
+#include "ProjectDossier.h"
+#include "TilePackService.h"
+#include "VectorTileService.h"
+#include "DiskCache.h"
+#include "ProtectionGenerator.h"
+#include "GeometryEncoder.h"
+#include "CpuAffinity.h"
+#include "TokenVerifier.h"
+#include "Lifecycle.h"
+#include "LockStats.h"
+#include "HttpApp.h"
+#include "Timestamp.h"
+#include "SchemaMigrations.h"
+#include "GeometryBlob.h"
+#include "GeosBackend.h"
+#include "GdalDrivers.h"
+#include "RuntimeRegistry.h"
+#include "Profiler.h"
+#include "MemoryArenas.h"
+#include "TlsContext.h"
+#include "GeometryJson.h"
+#include "Config.h"
+#include "ProcessSupervisor.h"
+#include "MemoryGovernor.h"
+#include "TileCover.h"
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+#include <filesystem>
+#include <optional>
+#include <pthread.h>
+#include <unistd.h>
 
+// Current value of a setting: the environment's, else config.json's.
+// Startup code may read std::getenv directly; settings applied again on
+// reload must come through here.
+static std::optional<std::string> setting(const char* name) {
+    return aeronautical::Config::getInstance().get(name);
+}
+
+static int settingInt(const char* name, int default_value) {
+    const auto value = setting(name);
+    return value ? std::stoi(*value) : default_value;
+}
+
+// Reads a boolean switch ("0", "false", "off" disable it)
+static bool envFlag(const char* name, bool default_value) {
+    const auto value = setting(name);
+    if (!value) {
+        return default_value;
+    }
+    const std::string& v = *value;
+    return !(v == "0" || v == "false" || v == "off" || v == "no");
+}
+
+// Default size of the CPU-bound pools: the machine's cores, shared out
+// between prefork workers
+static int coresPerProcess() {
+    const int cores = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    if (!aeronautical::ProcessSupervisor::workerIndex()) return cores;
+    return std::max(1, cores / std::max(1, settingInt("PREFORK_WORKERS", 1)));
+}
+
+// Per-client token buckets and per-route-class caps on requests in progress
+static aeronautical::AdmissionSettings admissionSettings() {
+    aeronautical::AdmissionSettings admission;
+    admission.enabled = envFlag("ADMISSION_CONTROL", true);
+    if (auto v = setting("RATE_LIMIT_RPS")) admission.client_rate = std::max(0.0, std::stod(*v));
+    if (auto v = setting("RATE_LIMIT_BURST")) admission.client_burst = std::max(1.0, std::stod(*v));
+    if (auto v = setting("RATE_LIMIT_CLIENTS")) admission.max_clients = static_cast<size_t>(std::max(1, std::stoi(*v)));
+    if (auto v = setting("RATE_LIMIT_API_KEYS")) {
+        // Comma-separated
+        for (size_t start = 0; start <= v->size();) {
+            const size_t comma = std::min(v->find(',', start), v->size());
+            if (comma > start) admission.api_keys.insert(v->substr(start, comma - start));
+            start = comma + 1;
+        }
+    }
+    if (auto v = setting("MAX_INFLIGHT_REFERENCE")) admission.max_reference = static_cast<size_t>(std::max(0, std::stoi(*v)));
+    if (auto v = setting("MAX_INFLIGHT_READ")) admission.max_read = static_cast<size_t>(std::max(0, std::stoi(*v)));
+    if (auto v = setting("MAX_INFLIGHT_WRITE")) admission.max_write = static_cast<size_t>(std::max(0, std::stoi(*v)));
+    if (auto v = setting("MAX_INFLIGHT_ANALYSIS")) admission.max_analysis = static_cast<size_t>(std::max(0, std::stoi(*v)));
+    return admission;
+}
+
+// Finished responses of hot reference GETs, served without running the handler
+static aeronautical::ResponseCacheSettings responseCacheSettings() {
+    aeronautical::ResponseCacheSettings response_cache;
+    response_cache.enabled = envFlag("RESPONSE_CACHE", true);
+    if (auto v = setting("RESPONSE_CACHE_MB")) response_cache.max_bytes = static_cast<size_t>(std::max(0, std::stoi(*v))) << 20;
+    if (auto v = setting("RESPONSE_CACHE_TTL_S")) response_cache.ttl = std::chrono::seconds(std::max(1, std::stoi(*v)));
+    return response_cache;
+}
+
+// Settings config.json can change without a restart (SIGHUP or
+// POST /api/admin/config/reload); the HTTP ones are added with the app
+static void registerLiveSettings() {
+    auto& config = aeronautical::Config::getInstance();
+    config.onChange({"LOG_LEVEL"}, []() {
+        const auto level = setting("LOG_LEVEL");
+        spdlog::get("aeronautical")->set_level(spdlog::level::from_str(level ? *level : "info"));
+    });
+    config.onChange({"RESULT_CACHE_ENTRIES", "RESULT_CACHE_TTL_S"}, []() {
+        aeronautical::ResultCache::getInstance().configure(
+            static_cast<size_t>(std::max(0, settingInt("RESULT_CACHE_ENTRIES", 4096))),
+            std::chrono::seconds(std::max(1, settingInt("RESULT_CACHE_TTL_S", 30))));
+    });
+    config.onChange({"ANALYSIS_MEMO_MB"}, []() {
+        aeronautical::ConflictMemo::getInstance().setCapacity(static_cast<size_t>(std::max(0, settingInt("ANALYSIS_MEMO_MB", 64))) << 20);
+    });
+    config.onChange({"PROTECTION_GENERATOR_CACHE_ENTRIES"}, []() {
+        aeronautical::ProtectionGenerator::getInstance().setCacheCapacity(
+            static_cast<size_t>(std::max(0, settingInt("PROTECTION_GENERATOR_CACHE_ENTRIES", 256))));
+    });
+    config.onChange({"SLOW_QUERY_MS"}, []() {
+        aeronautical::QueryStats::getInstance().configure(std::chrono::milliseconds(std::max(0, settingInt("SLOW_QUERY_MS", 500))),
+                                                          spdlog::get("slow_query"));
+    });
+    config.onChange({"TRACE_SAMPLE_RATE"}, []() {
+        const auto rate = setting("TRACE_SAMPLE_RATE");
+        aeronautical::Tracer::getInstance().setSampleRate(rate ? std::stod(*rate) : 0.01);
+    });
+    config.onChange({"CONFLICT_GEOMETRY_PRECISION"}, []() {
+        aeronautical::GeometryJson::setPrecision(settingInt("CONFLICT_GEOMETRY_PRECISION", aeronautical::GeometryJson::kDefaultPrecision));
+    });
+}
+
+// Caches of encoded bodies under the memory governor; cheap to refill, so
+// they give up memory before the conflict memo does
+static void governHttpCaches(aeronautical::HttpApp& app) {
+    using Cache = aeronautical::MemoryGovernor::Cache;
+    auto& governor = aeronautical::MemoryGovernor::getInstance();
+    auto& responses = app.get_middleware<aeronautical::ResponseCache>();
+    governor.add("response", Cache{[&responses]() { return responses.bytes(); },
+                                   [&responses](size_t target) { return responses.trim(target); }, 1.0});
+    for (auto [name, cache] : {std::pair<const char*, aeronautical::BodyCache*>{"compression", &app.get_middleware<aeronautical::ResponseCompression>().cache()},
+                               {"binary_format", &app.get_middleware<aeronautical::BinaryFormat>().cache()},
+                               {"geometry_encoding", &aeronautical::GeometryEncoder::getInstance().cache()}}) {
+        governor.add(name, Cache{[cache]() { return cache->bytes(); }, [cache](size_t target) { return cache->trim(target); }, 1.0});
+    }
+}
+
+static void registerLiveHttpSettings(aeronautical::HttpApp& app) {
+    auto& config = aeronautical::Config::getInstance();
+    // MAX_INFLIGHT_ANALYSIS is how many analyses run at once from HTTP; the
+    // ANALYSIS_WORKERS threads are fixed at start
+    config.onChange({"ADMISSION_CONTROL", "RATE_LIMIT_RPS", "RATE_LIMIT_BURST", "RATE_LIMIT_CLIENTS", "RATE_LIMIT_API_KEYS",
+                     "MAX_INFLIGHT_REFERENCE", "MAX_INFLIGHT_READ", "MAX_INFLIGHT_WRITE", "MAX_INFLIGHT_ANALYSIS"},
+                    [&app]() { app.get_middleware<aeronautical::AdmissionControl>().configure(admissionSettings()); });
+    config.onChange({"RESPONSE_CACHE", "RESPONSE_CACHE_MB", "RESPONSE_CACHE_TTL_S"},
+                    [&app]() { app.get_middleware<aeronautical::ResponseCache>().configure(responseCacheSettings()); });
+    config.onChange({"GEOMETRY_ENCODING_CACHE_MB"}, []() {
+        const auto mb = setting("GEOMETRY_ENCODING_CACHE_MB");
+        if (mb) aeronautical::GeometryEncoder::getInstance().setCacheCapacity(static_cast<size_t>(std::max(0, std::stoi(*mb))) << 20);
+    });
+}
+
+// CPU set of a thread pool from the environment, e.g. ANALYSIS_CPUS=8-31
+static aeronautical::CpuSet envCpus(const char* name) {
+    const char* value = std::getenv(name);
+    return value ? aeronautical::parseCpuList(value) : aeronautical::CpuSet{};
+}
+
+// Application loggers write through one background thread: a call site
+// only formats its line and queues it, and when the queue is full the
+// oldest lines are dropped instead of stalling request threads.
 void setupLogger() {
+    const int queue_size = std::getenv("LOG_QUEUE_SIZE") ? std::stoi(std::getenv("LOG_QUEUE_SIZE")) : 8192;
+    spdlog::init_thread_pool(static_cast<size_t>(std::max(64, queue_size)), 1);
+    const spdlog::level::level_enum level =
+        spdlog::level::from_str(std::getenv("LOG_LEVEL") ? std::getenv("LOG_LEVEL") : "info");
+    const std::string pattern = "[%Y-%m-%d %H:%M:%S.%e] [%n] [%^%l%$] [%t] %v";
+    // Prefork workers write files of their own: logs/aeronautical.<index>.log
+    const auto worker = aeronautical::ProcessSupervisor::workerIndex();
+    const std::string suffix = worker ? "." + std::to_string(*worker) : "";
+
+    auto asyncLogger = [](const std::string& name, std::vector<spdlog::sink_ptr> sinks) {
+        auto logger = std::make_shared<spdlog::async_logger>(name, sinks.begin(), sinks.end(), spdlog::thread_pool(),
+                                                             spdlog::async_overflow_policy::overrun_oldest);
+        logger->set_level(spdlog::level::trace); // the TracedLogger in front filters
+        return logger;
+    };
+
     // Console sink
     auto console_sink = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
     console_sink->set_level(spdlog::level::debug);
     
     // File sink
     auto file_sink = std::make_shared<spdlog::sinks::rotating_file_sink_mt>(
-        "logs/aeronautical.log", 1048576 * 5, 3);
+        "logs/aeronautical" + suffix + ".log", 1048576 * 5, 3);
     file_sink->set_level(spdlog::level::info);
     
     // Create logger with both sinks
-    std::vector<spdlog::sink_ptr> sinks {console_sink, file_sink};
-    auto logger = std::make_shared<spdlog::logger>("aeronautical", sinks.begin(), sinks.end());
-    logger->set_level(spdlog::level::debug);
+    auto app_log = asyncLogger("aeronautical", {console_sink, file_sink});
+    app_log->set_pattern(pattern);
+    auto logger = std::make_shared<aeronautical::TracedLogger>(app_log);
+    logger->set_level(level);
+    logger->flush_on(spdlog::level::warn);
     
     // Register as default logger
     spdlog::register_logger(logger);
     spdlog::set_default_logger(logger);
+
+    // Statements over SLOW_QUERY_MS, kept apart from the application log
+    auto slow_sink = std::make_shared<spdlog::sinks::rotating_file_sink_mt>(
+        "logs/slow_query" + suffix + ".log", 1048576 * 5, 3);
+    auto slow_async = asyncLogger("slow_query", {slow_sink});
+    slow_async->set_pattern(pattern);
+    spdlog::register_logger(std::make_shared<aeronautical::TracedLogger>(slow_async));
+
+    // Sampled spans, one OTLP/JSON line each
+    auto trace_sink = std::make_shared<spdlog::sinks::rotating_file_sink_mt>(
+        "logs/traces" + suffix + ".jsonl", 1048576 * 20, 3);
+    auto trace_log = asyncLogger("trace", {trace_sink});
+    trace_log->set_pattern("%v");
+    spdlog::register_logger(trace_log);
+
+    spdlog::flush_every(std::chrono::seconds(2));
 }
 
-void setupCORS(crow::SimpleApp& app) {
+// Gauges and counters of the pool, queues and caches, read on each /metrics scrape
+void exposeMetrics(aeronautical::HttpApp& app) {
+    using aeronautical::Metrics;
+    auto& metrics = Metrics::getInstance();
+    auto pool = []() { return aeronautical::DatabaseManager::getInstance().poolMetrics(); };
+
+    metrics.expose("aeronautical_db_pool_connections", "Pooled MySQL connections by state.", Metrics::Kind::Gauge,
+                   [pool]() { return static_cast<double>(pool().in_use); }, "state=\"in_use\"");
+    metrics.expose("aeronautical_db_pool_connections", "", Metrics::Kind::Gauge,
+                   [pool]() { return static_cast<double>(pool().idle); }, "state=\"idle\"");
+    metrics.expose("aeronautical_db_pool_waiters", "Threads waiting for a pooled connection.", Metrics::Kind::Gauge,
+                   [pool]() { return static_cast<double>(pool().waiters); });
+    metrics.expose("aeronautical_db_pool_acquisitions_total", "Connections leased from the pool.", Metrics::Kind::Counter,
+                   [pool]() { return static_cast<double>(pool().acquisitions); });
+    metrics.expose("aeronautical_db_pool_timeouts_total", "Leases that timed out waiting.", Metrics::Kind::Counter,
+                   [pool]() { return static_cast<double>(pool().timeouts); });
+    metrics.expose("aeronautical_db_pool_wait_seconds_total", "Time spent waiting for a connection.", Metrics::Kind::Counter,
+                   [pool]() { return pool().total_wait_ms / 1000.0; });
+
+    metrics.expose("aeronautical_db_executor_pending", "Handler queries queued or running on DB threads.", Metrics::Kind::Gauge,
+                   []() { return aeronautical::DbExecutor::getInstance().stats()["pending"].get<double>(); });
+    metrics.expose("aeronautical_db_executor_rejected_total", "Requests answered 503 because the DB queue was full.", Metrics::Kind::Counter,
+                   []() { return aeronautical::DbExecutor::getInstance().stats()["rejected"].get<double>(); });
+
+    using RouteClass = aeronautical::AdmissionControl::RouteClass;
+    auto& admission = app.get_middleware<aeronautical::AdmissionControl>();
+    metrics.expose("aeronautical_admission_rate_limited_total", "Requests answered 429 by the per-client rate limit.",
+                   Metrics::Kind::Counter, [&admission]() { return static_cast<double>(admission.rateLimited()); });
+    for (RouteClass route_class : {RouteClass::Reference, RouteClass::Read, RouteClass::Write, RouteClass::Analysis}) {
+        const std::string label = std::string("class=\"") + aeronautical::AdmissionControl::name(route_class) + "\"";
+        metrics.expose("aeronautical_admission_in_flight", "Admitted requests in progress by route class.", Metrics::Kind::Gauge,
+                       [&admission, route_class]() { return static_cast<double>(admission.inFlight(route_class)); }, label);
+        metrics.expose("aeronautical_admission_rejected_total", "Requests answered 503 because their route class was full.",
+                       Metrics::Kind::Counter,
+                       [&admission, route_class]() { return static_cast<double>(admission.overloaded(route_class)); }, label);
+    }
+
+    auto tls = [](const char* field) {
+        const auto stats = aeronautical::TlsContext::getInstance().stats();
+        return stats.contains(field) ? stats[field].get<double>() : 0.0;
+    };
+    metrics.expose("aeronautical_tls_handshakes_total", "TLS handshakes completed, by whether the session was resumed.",
+                   Metrics::Kind::Counter, [tls]() { return tls("full_handshakes"); }, "resumed=\"false\"");
+    metrics.expose("aeronautical_tls_handshakes_total", "", Metrics::Kind::Counter,
+                   [tls]() { return tls("resumed"); }, "resumed=\"true\"");
+
+    metrics.expose("aeronautical_analysis_queue_depth", "Analysis jobs waiting for a worker.", Metrics::Kind::Gauge,
+                   []() { return static_cast<double>(aeronautical::AnalysisJobQueue::getInstance().depth()); });
+    metrics.expose("aeronautical_analysis_jobs_started_total", "Analysis jobs started, by whether their region's worker ran them.",
+                   Metrics::Kind::Counter,
+                   []() { return static_cast<double>(aeronautical::AnalysisJobQueue::getInstance().startedLocal()); },
+                   "placement=\"local\"");
+    metrics.expose("aeronautical_analysis_jobs_started_total", "", Metrics::Kind::Counter,
+                   []() { return static_cast<double>(aeronautical::AnalysisJobQueue::getInstance().startedElsewhere()); },
+                   "placement=\"stolen\"");
+    metrics.expose("aeronautical_analysis_queue_capacity", "Analysis jobs the queue accepts.", Metrics::Kind::Gauge,
+                   []() { return static_cast<double>(aeronautical::AnalysisJobQueue::getInstance().capacity()); });
+    auto organization_loads = [](auto field) {
+        return [field]() {
+            std::vector<std::pair<std::string, double>> samples;
+            for (const auto& load : aeronautical::AnalysisJobQueue::getInstance().organizationLoads()) {
+                samples.emplace_back(load.organization, static_cast<double>(load.*field));
+            }
+            return samples;
+        };
+    };
+    metrics.exposeLabelled("aeronautical_analysis_organization_queue_depth",
+                           "Analysis jobs waiting for a worker, by demander organization.", Metrics::Kind::Gauge,
+                           "organization", organization_loads(&aeronautical::OrganizationLoad::queued));
+    metrics.exposeLabelled("aeronautical_analysis_organization_running", "Analysis jobs running, by demander organization.",
+                           Metrics::Kind::Gauge, "organization",
+                           organization_loads(&aeronautical::OrganizationLoad::running));
+    metrics.exposeLabelled("aeronautical_analysis_organization_started_total",
+                           "Analysis jobs started, by demander organization.", Metrics::Kind::Counter, "organization",
+                           organization_loads(&aeronautical::OrganizationLoad::started));
+    for (const char* cache : {"response", "compression", "binary_format", "geometry_encoding", "conflict_memo"}) {
+        metrics.expose("aeronautical_cache_bytes", std::string(cache) == "response" ? "Bytes a cache under the memory budget holds." : "",
+                       Metrics::Kind::Gauge, [cache]() { return aeronautical::MemoryGovernor::getInstance().cacheBytes(cache); },
+                       fmt::format("cache=\"{}\"", cache));
+    }
+    auto governor = [](const char* field) {
+        const auto stats = aeronautical::MemoryGovernor::getInstance().stats();
+        return stats[field].is_number() ? stats[field].get<double>() : 0.0;
+    };
+    metrics.expose("aeronautical_memory_usage_bytes", "Memory charged to the process, as the memory governor reads it.",
+                   Metrics::Kind::Gauge, [governor]() { return governor("usage"); });
+    metrics.expose("aeronautical_memory_limit_bytes", "Memory limit the governor keeps the process under; 0 when none.",
+                   Metrics::Kind::Gauge, [governor]() { return governor("limit"); });
+    metrics.expose("aeronautical_cache_trimmed_bytes_total", "Cache bytes the memory governor evicted.",
+                   Metrics::Kind::Counter, [governor]() { return governor("trimmed_bytes"); });
+    for (auto kind : {aeronautical::AccessProfile::Kind::Tile, aeronautical::AccessProfile::Kind::Airport,
+                      aeronautical::AccessProfile::Kind::Procedure}) {
+        metrics.expose("aeronautical_access_profile_prewarmed_total",
+                       kind == aeronautical::AccessProfile::Kind::Tile ? "Cache entries the access profile prewarmed." : "",
+                       Metrics::Kind::Counter,
+                       [kind]() { return static_cast<double>(aeronautical::AccessProfile::getInstance().warmed(kind)); },
+                       fmt::format("kind=\"{}\"", aeronautical::AccessProfile::name(kind)));
+    }
+    auto* shadow = &aeronautical::AnalysisShadow::getInstance();
+    metrics.expose("aeronautical_analysis_shadow_runs_total", "Analyses rerun by the reference engine and compared.",
+                   Metrics::Kind::Counter, [shadow]() { return static_cast<double>(shadow->runs()); });
+    metrics.expose("aeronautical_analysis_shadow_mismatched_runs_total",
+                   "Shadowed analyses whose stored conflicts differ from the reference engine's.", Metrics::Kind::Counter,
+                   [shadow]() { return static_cast<double>(shadow->mismatchedRuns()); });
+    for (auto kind : {aeronautical::AnalysisShadow::Mismatch::Missing, aeronautical::AnalysisShadow::Mismatch::Extra,
+                      aeronautical::AnalysisShadow::Mismatch::Severity, aeronautical::AnalysisShadow::Mismatch::Area}) {
+        metrics.expose("aeronautical_analysis_shadow_mismatches_total",
+                       kind == aeronautical::AnalysisShadow::Mismatch::Missing
+                           ? "Conflicts on which a shadowed analysis and the reference engine disagree."
+                           : "",
+                       Metrics::Kind::Counter, [shadow, kind]() { return static_cast<double>(shadow->mismatches(kind)); },
+                       fmt::format("kind=\"{}\"", aeronautical::AnalysisShadow::name(kind)));
+    }
+    metrics.expose("aeronautical_analysis_shadow_failures_total", "Shadow runs the reference engine could not finish.",
+                   Metrics::Kind::Counter, [shadow]() { return static_cast<double>(shadow->failures()); });
+    metrics.expose("aeronautical_analysis_shadow_seconds_total",
+                   "Time of the shadowed analyses, by engine; the ratio is the fast engine's speed-up.",
+                   Metrics::Kind::Counter, [shadow]() { return shadow->fastSeconds(); }, "engine=\"fast\"");
+    metrics.expose("aeronautical_analysis_shadow_seconds_total", "", Metrics::Kind::Counter,
+                   [shadow]() { return shadow->referenceSeconds(); }, "engine=\"reference\"");
+    metrics.expose("aeronautical_conflicts_archived_projects_total", "Closed projects whose conflicts were archived.",
+                   Metrics::Kind::Counter, []() {
+                       return static_cast<double>(aeronautical::ConflictArchiver::getInstance().archivedProjects());
+                   });
+
+    // Waits on the shared caches' and pools' locks; growth here under load is
+    // where added cores stop helping
+    bool first_lock = true;
+    for (const char* lock : {"conflict_memo", "protection_cache", "protection_prepared", "result_cache",
+                             "response_cache", "body_cache", "query_stats", "thread_pool_queue"}) {
+        const auto* site = &aeronautical::LockStats::site(lock);
+        const std::string label = std::string("lock=\"") + lock + "\"";
+        metrics.expose("aeronautical_lock_contended_total",
+                       first_lock ? "Lock acquisitions that found the lock taken." : "", Metrics::Kind::Counter,
+                       [site]() { return static_cast<double>(site->contended.load(std::memory_order_relaxed)); },
+                       label);
+        metrics.expose("aeronautical_lock_wait_seconds_total",
+                       first_lock ? "Time spent waiting for a taken lock." : "", Metrics::Kind::Counter,
+                       [site]() { return static_cast<double>(site->wait_ns.load(std::memory_order_relaxed)) / 1e9; },
+                       label);
+        first_lock = false;
+    }
+
+    // Remote steals run a task on another NUMA node than the one it was posted on
+    auto analysis_pool = []() { return aeronautical::ConflictController::getInstance().analysisPool().stats(); };
+    metrics.expose("aeronautical_analysis_tasks_stolen_total", "Analysis pool tasks taken from another worker's queue.",
+                   Metrics::Kind::Counter,
+                   [analysis_pool]() {
+                       const auto pool = analysis_pool();
+                       return static_cast<double>(pool.stolen - pool.stolen_remote);
+                   },
+                   "scope=\"local\"");
+    metrics.expose("aeronautical_analysis_tasks_stolen_total", "", Metrics::Kind::Counter,
+                   [analysis_pool]() { return static_cast<double>(analysis_pool().stolen_remote); }, "scope=\"remote\"");
+    const auto analysis_nodes = analysis_pool().nodes;
+    for (size_t i = 0; i < analysis_nodes.size(); i++) {
+        metrics.expose("aeronautical_analysis_tasks_total", i == 0 ? "Analysis pool tasks run, by NUMA node." : "",
+                       Metrics::Kind::Counter,
+                       [analysis_pool, i]() { return static_cast<double>(analysis_pool().executed_by_node[i]); },
+                       fmt::format("node=\"{}\"", analysis_nodes[i]));
+    }
+
+    auto result_cache = [](const char* field) {
+        return aeronautical::ResultCache::getInstance().stats()[field].get<double>();
+    };
+    metrics.expose("aeronautical_cache_hits_total", "Lookups answered from a cache.", Metrics::Kind::Counter,
+                   [result_cache]() { return result_cache("hits"); }, "cache=\"result\"");
+    metrics.expose("aeronautical_cache_hits_total", "", Metrics::Kind::Counter,
+                   [&app]() { return app.get_middleware<aeronautical::ResponseCompression>().stats()["cache_hits"].get<double>(); },
+                   "cache=\"compression\"");
+    metrics.expose("aeronautical_cache_hits_total", "", Metrics::Kind::Counter,
+                   [&app]() { return app.get_middleware<aeronautical::BinaryFormat>().stats()["cache_hits"].get<double>(); },
+                   "cache=\"binary_format\"");
+    metrics.expose("aeronautical_cache_hits_total", "", Metrics::Kind::Counter,
+                   [&app]() { return static_cast<double>(app.get_middleware<aeronautical::ResponseCache>().hits()); },
+                   "cache=\"response\"");
+    metrics.expose("aeronautical_cache_misses_total", "Lookups a cache had to load.", Metrics::Kind::Counter,
+                   [result_cache]() { return result_cache("misses"); }, "cache=\"result\"");
+    metrics.expose("aeronautical_cache_misses_total", "", Metrics::Kind::Counter,
+                   [&app]() { return static_cast<double>(app.get_middleware<aeronautical::ResponseCache>().misses()); },
+                   "cache=\"response\"");
+    metrics.expose("aeronautical_cache_hit_ratio", "Hits over lookups since start.", Metrics::Kind::Gauge,
+                   [result_cache]() {
+                       const double hits = result_cache("hits");
+                       const double lookups = hits + result_cache("misses");
+                       return lookups > 0 ? hits / lookups : 0.0;
+                   },
+                   "cache=\"result\"");
+
+    // Allocator bytes per subsystem arena, and for the whole process
+    auto& memory = aeronautical::MemoryArenas::getInstance();
+    std::vector<std::string> arenas = memory.arenas();
+    if (!arenas.empty()) arenas.push_back("other");
+    arenas.push_back("total");
+    for (const auto& arena : arenas) {
+        for (const char* kind : {"allocated", "active", "resident"}) {
+            metrics.expose("aeronautical_memory_bytes", "Allocator bytes by arena and kind.", Metrics::Kind::Gauge,
+                           [&memory, arena, kind]() { return memory.bytes(arena, kind); },
+                           "arena=\"" + arena + "\",kind=\"" + kind + "\"");
+        }
+    }
+}
+
+// Caches, pools and the reference snapshot, for GET /api/admin/runtime
+void registerRuntime(aeronautical::HttpApp& app, int http_threads) {
+    using Cache = aeronautical::RuntimeRegistry::Cache;
+    auto& runtime = aeronautical::RuntimeRegistry::getInstance();
+
+    runtime.addCache("reference_store",
+                     Cache{[]() { return aeronautical::ReferenceDataStore::getInstance().status(); }, nullptr, []() {
+                               bool ok = aeronautical::ReferenceDataStore::getInstance().refresh();
+                               if (ok) aeronautical::CacheEvents::getInstance().publishReload("airports");
+                               return ok;
+                           }});
+    runtime.addCache("protection_index",
+                     Cache{[]() { return aeronautical::ConflictController::getInstance().protectionIndexStats(); },
+                           []() { aeronautical::ConflictController::getInstance().resetProtectionIndex(); },
+                           []() {
+                               aeronautical::ConflictController::getInstance().warmUp();
+                               return true;
+                           }});
+    runtime.addCache("protection_geometries",
+                     Cache{[]() { return aeronautical::ProtectionGeometryCache::getInstance().stats(); },
+                           []() { aeronautical::ProtectionGeometryCache::getInstance().clear(); },
+                           []() {
+                               aeronautical::ConflictController::getInstance().warmUp();
+                               return true;
+                           }});
+    runtime.addCache("conflict_memo", Cache{[]() { return aeronautical::ConflictMemo::getInstance().stats(); },
+                                            []() { aeronautical::ConflictMemo::getInstance().clear(); }, nullptr});
+    runtime.addCache("result_cache", Cache{[]() { return aeronautical::ResultCache::getInstance().stats(); },
+                                           []() { aeronautical::ResultCache::getInstance().clear(); }, nullptr});
+    runtime.addCache("response_cache",
+                     Cache{[&app]() { return app.get_middleware<aeronautical::ResponseCache>().stats(); },
+                           [&app]() { app.get_middleware<aeronautical::ResponseCache>().clear(); }, nullptr});
+    runtime.addCache("tile_cache", Cache{[]() { return aeronautical::VectorTileService::getInstance().cacheStats(); },
+                                         []() { aeronautical::VectorTileService::getInstance().clearCache(); },
+                                         []() {
+                                             aeronautical::VectorTileService::getInstance().reloadProcedures();
+                                             return true;
+                                         }});
+    runtime.addCache("tls_sessions", Cache{[]() { return aeronautical::TlsContext::getInstance().stats(); }, nullptr, nullptr});
+    runtime.addCache("disk_cache", Cache{[]() { return aeronautical::DiskCache::getInstance().stats(); },
+                                         []() { aeronautical::DiskCache::getInstance().clear(); }, nullptr});
+    runtime.addCache("generated_protections",
+                     Cache{[]() { return aeronautical::ProtectionGenerator::getInstance().cacheStats(); },
+                           []() { aeronautical::ProtectionGenerator::getInstance().clearCache(); }, nullptr});
+
+    runtime.addCache("project_spatial_index",
+                     Cache{[]() { return aeronautical::ProjectSpatialIndex::getInstance().stats(); }, nullptr, []() {
+                               aeronautical::ProjectRepository repository;
+                               return aeronautical::ProjectSpatialIndex::getInstance().load(repository);
+                           }});
+    runtime.addCache("project_search_index",
+                     Cache{[]() { return aeronautical::ProjectSearchIndex::getInstance().stats(); }, nullptr, []() {
+                               aeronautical::ProjectRepository repository;
+                               return aeronautical::ProjectSearchIndex::getInstance().load(repository);
+                           }});
+    runtime.addCache("conflict_heatmap",
+                     Cache{[]() { return aeronautical::ConflictHeatmap::getInstance().stats(); }, nullptr,
+                           []() { return aeronautical::ConflictHeatmap::getInstance().rebuild(); }});
+    runtime.addCache("document_results",
+                     Cache{[]() { return aeronautical::DocumentPipeline::getInstance().cacheStats(); },
+                           []() { aeronautical::DocumentPipeline::getInstance().clearCache(); }, nullptr});
+    runtime.addCache("project_dossiers",
+                     Cache{[]() { return aeronautical::ProjectDossier::getInstance().cacheStats(); },
+                           []() { aeronautical::ProjectDossier::getInstance().clearCache(); }, nullptr});
+
+    runtime.addPool("db", []() { return aeronautical::DatabaseManager::getInstance().poolMetrics().toJson(); });
+    runtime.addPool("db_executor", []() { return aeronautical::DbExecutor::getInstance().stats(); });
+    runtime.addPool("analysis", []() {
+        const auto pool = aeronautical::ConflictController::getInstance().analysisPool().stats();
+        auto& jobs = aeronautical::AnalysisJobQueue::getInstance();
+        return nlohmann::json{{"threads", pool.threads},
+                              {"busy", pool.busy},
+                              {"queued", pool.queued},
+                              {"executed", pool.executed},
+                              {"stolen", pool.stolen},
+                              {"stolen_remote", pool.stolen_remote},
+                              {"numa_nodes", pool.nodes},
+                              {"executed_by_node", pool.executed_by_node},
+                              {"jobs_queued", jobs.depth()},
+                              {"jobs_capacity", jobs.capacity()},
+                              {"job_workers", jobs.workerCount()}};
+    });
+    runtime.addPool("documents", []() { return aeronautical::DocumentPipeline::getInstance().poolStats(); });
+    runtime.addPool("audit", []() { return aeronautical::AuditWriter::getInstance().stats(); });
+    runtime.addPool("exports", []() { return aeronautical::ExportService::getInstance().poolStats(); });
+    runtime.addPool("dossiers", []() { return aeronautical::ProjectDossier::getInstance().poolStats(); });
+    runtime.addPool("tile_packs", []() { return aeronautical::TilePackService::getInstance().poolStats(); });
+    runtime.addPool("http", [&app, http_threads]() {
+        nlohmann::json j = app.get_middleware<aeronautical::AdmissionControl>().stats();
+        j["threads"] = http_threads;
+        return j;
+    });
+
+    runtime.setSnapshot([]() {
+        auto reference = aeronautical::ReferenceDataStore::getInstance().snapshot();
+        return nlohmann::json{
+            {"reference_version", reference ? nlohmann::json(reference->version) : nlohmann::json(nullptr)},
+            {"protection_generation", aeronautical::ProtectionGeometryCache::getInstance().generation()}};
+    });
+    runtime.setMemory([]() { return aeronautical::MemoryGovernor::getInstance().stats(); });
+}
+
+void setupCORS(aeronautical::HttpApp& app) {
     // CORS middleware
     struct CORSHandler {
         struct context {};
@@ -59,12 +591,106 @@ void setupCORS(crow::SimpleApp& app) {
         });
 }
 
+// SIGTERM and SIGINT, and SIGHUP (reload config.json), blocked in every
+// thread so only sigwait() sees them
+static sigset_t terminationSignals() {
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGTERM);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGHUP);
+    return signals;
+}
+
+// Waits for SIGTERM or SIGINT, reloading the configuration on each SIGHUP
+static int waitForTermination(const sigset_t& signals) {
+    int signal_number = 0;
+    while (sigwait(&signals, &signal_number) == 0 && signal_number == SIGHUP) {
+        aeronautical::Config::getInstance().reload();
+    }
+    return signal_number;
+}
+
+// Waits for a termination signal, then drains: readiness fails at once so
+// the load balancer moves traffic away, new requests are refused after
+// delay, and the server stops once requests in progress finish (or after
+// timeout). Returns without draining when done is set and a signal arrives.
+static void drainOnSignal(aeronautical::HttpApp& app, const std::atomic<bool>& done, std::chrono::seconds delay,
+                          std::chrono::seconds timeout) {
+    const sigset_t signals = terminationSignals();
+    const int signal_number = waitForTermination(signals);
+    if (done.load()) {
+        return;
+    }
+    auto logger = spdlog::get("aeronautical");
+    auto& lifecycle = aeronautical::Lifecycle::getInstance();
+    lifecycle.beginDrain();
+    logger->info("Signal {} received; draining for {} s before refusing new requests", signal_number, delay.count());
+    std::this_thread::sleep_for(delay);
+
+    lifecycle.stopAccepting();
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (aeronautical::Metrics::getInstance().inFlight() > 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    const uint64_t left = aeronautical::Metrics::getInstance().inFlight();
+    if (left > 0) {
+        logger->warn("Drain timed out with {} requests in progress", left);
+    }
+    logger->info("Stopping HTTP server");
+    app.stop();
+}
+
 int main(int argc, char* argv[]) {
+    // Before any thread starts, so all of them inherit the mask
+    const sigset_t termination = terminationSignals();
+    pthread_sigmask(SIG_BLOCK, &termination, nullptr);
+
+    // --worker: no HTTP server, only analysis jobs claimed from analysis_jobs
+    const bool worker_mode = argc > 1 && std::string(argv[1]) == "--worker";
+
+    // Settings file under the environment: CONFIG_FILE must exist when given,
+    // the default is used when present
+    const char* config_file = std::getenv("CONFIG_FILE");
+    std::string config_error;
+    if (!aeronautical::Config::getInstance().load(config_file ? config_file : "config/config.json", config_file != nullptr,
+                                                 config_error)) {
+        std::fprintf(stderr, "Configuration not loaded: %s\n", config_error.c_str());
+        return 1;
+    }
+
     try {
+        // PREFORK_WORKERS=N: this process only supervises N server processes
+        if (!worker_mode && !aeronautical::ProcessSupervisor::workerIndex() && settingInt("PREFORK_WORKERS", 0) > 0) {
+            // SO_REUSEPORT hands a client's next request to any worker, so jobs and
+            // uploads polled by id must not live in one worker's memory
+            std::string per_process;
+            for (const char* service : {"DOCUMENTS", "EXPORTS", "DOSSIERS", "TILE_PACKS"}) {
+                if (envFlag(service, true)) per_process += std::string(per_process.empty() ? "" : ", ") + service;
+            }
+            if (!per_process.empty()) {
+                std::fprintf(stderr, "PREFORK_WORKERS needs %s set to false: their jobs live in one worker\n",
+                             per_process.c_str());
+                return 1;
+            }
+            aeronautical::PreforkSettings prefork;
+            prefork.workers = static_cast<size_t>(settingInt("PREFORK_WORKERS", 0));
+            prefork.max_rss_bytes = static_cast<size_t>(std::max(0, settingInt("PREFORK_MAX_RSS_MB", 0))) << 20;
+            return aeronautical::ProcessSupervisor::run(prefork, argv);
+        }
+
+        // Each phase of the start is timed and listed in /api/health/ready
+        auto& lifecycle = aeronautical::Lifecycle::getInstance();
+        lifecycle.startupPhase("logging");
         // Setup logging
         setupLogger();
         auto logger = spdlog::get("aeronautical");
-        logger->info("===== Aeronautical Platform Backend Starting =====");
+        logger->info("===== Aeronautical Platform {} Starting =====", worker_mode ? "Analysis Worker" : "Backend");
+        if (aeronautical::Config::getInstance().loaded()) {
+            logger->info("Settings read from {} under the environment", config_file ? config_file : "config/config.json");
+        }
+        // One jemalloc arena per subsystem, created before any pool starts
+        aeronautical::MemoryArenas::getInstance().configure(envFlag("MEMORY_ARENAS", true));
         
         // Load configuration (can be from file or environment variables)
         std::string db_host = std::getenv("DB_HOST") ? std::getenv("DB_HOST") : "localhost";
@@ -73,36 +699,502 @@ int main(int argc, char* argv[]) {
         std::string db_pass = std::getenv("DB_PASS") ? std::getenv("DB_PASS") : "oper";
         std::string db_name = std::getenv("DB_NAME") ? std::getenv("DB_NAME") : "aeronautical_platform";
         int server_port = std::getenv("SERVER_PORT") ? std::stoi(std::getenv("SERVER_PORT")) : 8081;
+        // Crow workers serving HTTP; defaults to one per core
+        int http_threads = std::getenv("HTTP_THREADS") ? std::stoi(std::getenv("HTTP_THREADS"))
+                                                       : coresPerProcess();
+        // Optional CPU sets per pool, so GEOS work cannot crowd out request handling
+        const aeronautical::CpuSet http_cpus = envCpus("HTTP_CPUS");
+        const aeronautical::CpuSet analysis_cpus = envCpus("ANALYSIS_CPUS");
+        const aeronautical::CpuSet db_io_cpus = envCpus("DB_IO_CPUS");
+        bool prepared_geometry = envFlag("ANALYSIS_PREPARED_GEOMETRY", true);
+        // Conflict predicates straight on GEOS with a context per thread, when built with it
+        const bool geos_backend = envFlag("ANALYSIS_GEOS_BACKEND", true);
+        // Zones with more vertices are subdivided into tiles for the index and predicates; 0 keeps them whole
+        const int protection_tile_vertices = std::getenv("PROTECTION_TILE_VERTICES")
+            ? std::stoi(std::getenv("PROTECTION_TILE_VERTICES"))
+            : static_cast<int>(aeronautical::ProtectionGeometryCache::kDefaultTileVertexBudget);
+        bool deferred_intersections = envFlag("ANALYSIS_DEFERRED_INTERSECTIONS", false);
+        // (feature, zone) results remembered across projects; 0 disables
+        const int analysis_memo_mb = std::getenv("ANALYSIS_MEMO_MB") ? std::stoi(std::getenv("ANALYSIS_MEMO_MB")) : 64;
+        bool analysis_triage = envFlag("ANALYSIS_TRIAGE", false);
+        // Projects outside every zone's footprint are answered before any geometry is parsed
+        const bool coverage_mask = envFlag("ANALYSIS_COVERAGE_MASK", true);
+        int analysis_threads = std::getenv("ANALYSIS_THREADS") ? std::stoi(std::getenv("ANALYSIS_THREADS"))
+                                                               : coresPerProcess();
+        int analysis_workers = std::getenv("ANALYSIS_WORKERS") ? std::stoi(std::getenv("ANALYSIS_WORKERS")) : 2;
+        int analysis_queue_capacity = std::getenv("ANALYSIS_QUEUE_CAPACITY") ? std::stoi(std::getenv("ANALYSIS_QUEUE_CAPACITY")) : 64;
+        bool reference_cache = envFlag("REFERENCE_CACHE", true);
+        int reference_refresh_s = std::getenv("REFERENCE_REFRESH_INTERVAL_S") ? std::stoi(std::getenv("REFERENCE_REFRESH_INTERVAL_S")) : 300;
+        std::string reference_snapshot_path = std::getenv("REFERENCE_SNAPSHOT_PATH") ? std::getenv("REFERENCE_SNAPSHOT_PATH") : "";
+        int tile_cache_entries = std::getenv("TILE_CACHE_ENTRIES") ? std::stoi(std::getenv("TILE_CACHE_ENTRIES")) : 4096;
+        // Most requested tiles, bundles and procedures, prewarmed at start and on a new snapshot
+        aeronautical::AccessProfileSettings access_profile;
+        if (auto v = setting("ACCESS_PROFILE_PATH")) access_profile.path = *v;
+        access_profile.interval = std::chrono::seconds(std::max(10, settingInt("ACCESS_PROFILE_INTERVAL_S", 300)));
+        access_profile.top = static_cast<size_t>(std::max(0, settingInt("ACCESS_PROFILE_TOP", 500)));
+        access_profile.pause = std::chrono::milliseconds(std::max(0, settingInt("ACCESS_PROFILE_PAUSE_MS", 5)));
+        // Zero-downtime deploys: warm caches before reporting ready, drain on SIGTERM
+        const bool warm_up = envFlag("WARMUP", true);
+        const int drain_delay_s = std::getenv("DRAIN_DELAY_S") ? std::stoi(std::getenv("DRAIN_DELAY_S")) : 5;
+        const int drain_timeout_s = std::getenv("DRAIN_TIMEOUT_S") ? std::stoi(std::getenv("DRAIN_TIMEOUT_S")) : 30;
+        // Analyses still queued at shutdown are saved here and resumed on the next start
+        std::string analysis_checkpoint_path = std::getenv("ANALYSIS_CHECKPOINT_PATH") ? std::getenv("ANALYSIS_CHECKPOINT_PATH") : "";
+        // Jobs persisted in analysis_jobs (when the table exists) under leases
+        // held by this instance; the id must stay the same across restarts
+        const bool analysis_persist = envFlag("ANALYSIS_JOB_PERSISTENCE", true);
+        const int analysis_lease_s = std::getenv("ANALYSIS_LEASE_S") ? std::stoi(std::getenv("ANALYSIS_LEASE_S")) : 60;
+        std::string analysis_worker_id = std::getenv("ANALYSIS_WORKER_ID") ? std::getenv("ANALYSIS_WORKER_ID") : "";
+        if (analysis_worker_id.empty()) {
+            char host[256] = {};
+            gethostname(host, sizeof(host) - 1);
+            analysis_worker_id = std::string(host) + ":" + std::to_string(server_port);
+        }
+        // Prefork workers are separate instances with caches and queues of their own
+        const auto prefork_worker = aeronautical::ProcessSupervisor::workerIndex();
+        if (prefork_worker) {
+            analysis_worker_id += "/" + std::to_string(*prefork_worker);
+            if (!analysis_checkpoint_path.empty()) analysis_checkpoint_path += "." + std::to_string(*prefork_worker);
+            if (!access_profile.path.empty()) access_profile.path += "." + std::to_string(*prefork_worker);
+        }
+
+        // Response compression negotiated from Accept-Encoding
+        aeronautical::CompressionSettings compression;
+        compression.enabled = envFlag("COMPRESSION", true);
+        if (std::getenv("COMPRESSION_MIN_BYTES")) compression.min_bytes = static_cast<size_t>(std::max(0, std::stoi(std::getenv("COMPRESSION_MIN_BYTES"))));
+        if (std::getenv("COMPRESSION_LEVEL")) compression.level = std::clamp(std::stoi(std::getenv("COMPRESSION_LEVEL")), 1, 9);
+        if (std::getenv("COMPRESSION_CACHE_MB")) compression.cache_bytes = static_cast<size_t>(std::max(0, std::stoi(std::getenv("COMPRESSION_CACHE_MB")))) << 20;
+
+        // Bearer tokens checked against the Keycloak realm's keys; without a JWKS source any bearer token passes
+        aeronautical::TokenSettings token_settings;
+        if (std::getenv("JWT_JWKS_URL")) token_settings.jwks_url = std::getenv("JWT_JWKS_URL");
+        if (std::getenv("JWT_JWKS_PATH")) token_settings.jwks_path = std::getenv("JWT_JWKS_PATH");
+        if (std::getenv("JWT_JWKS_CA_FILE")) token_settings.jwks_ca_file = std::getenv("JWT_JWKS_CA_FILE");
+        token_settings.jwks_allow_http = envFlag("JWT_JWKS_ALLOW_HTTP", false);
+        if (std::getenv("JWT_ISSUER")) token_settings.issuer = std::getenv("JWT_ISSUER");
+        if (std::getenv("JWT_AUDIENCE")) token_settings.audience = std::getenv("JWT_AUDIENCE");
+        if (std::getenv("JWT_JWKS_REFRESH_S")) token_settings.refresh_interval = std::chrono::seconds(std::max(10, std::stoi(std::getenv("JWT_JWKS_REFRESH_S"))));
+        if (std::getenv("JWT_CACHE_ENTRIES")) token_settings.cache_entries = static_cast<size_t>(std::max(1, std::stoi(std::getenv("JWT_CACHE_ENTRIES"))));
+
+        const aeronautical::AdmissionSettings admission = admissionSettings();
+
+        // CBOR / MessagePack bodies for clients that ask for them in Accept
+        aeronautical::BinaryFormatSettings binary_format;
+        binary_format.enabled = envFlag("BINARY_FORMATS", true);
+        if (std::getenv("BINARY_FORMAT_CACHE_MB")) binary_format.cache_bytes = static_cast<size_t>(std::max(0, std::stoi(std::getenv("BINARY_FORMAT_CACHE_MB")))) << 20;
+        const aeronautical::ResponseCacheSettings response_cache = responseCacheSettings();
+        // On-demand CPU and heap profiles under /api/admin/profile
+        aeronautical::ProfilerSettings profiler;
+        profiler.enabled = envFlag("PROFILING", false);
+        if (std::getenv("PROFILING_MAX_S")) profiler.max_duration = std::chrono::seconds(std::max(1, std::stoi(std::getenv("PROFILING_MAX_S"))));
+        if (std::getenv("PROFILING_MAX_HZ")) profiler.max_frequency = std::max(1, std::stoi(std::getenv("PROFILING_MAX_HZ")));
+        // Allocations and CPU time per request, by route in /metrics; costly requests are logged
+        aeronautical::RequestAccountingSettings request_accounting;
+        request_accounting.enabled = envFlag("REQUEST_ACCOUNTING", false);
+        if (std::getenv("REQUEST_LOG_ALLOC_MB")) request_accounting.log_alloc_bytes = static_cast<uint64_t>(std::max(0, std::stoi(std::getenv("REQUEST_LOG_ALLOC_MB")))) << 20;
+        if (std::getenv("REQUEST_LOG_CPU_MS")) request_accounting.log_cpu = std::chrono::milliseconds(std::max(0, std::stoi(std::getenv("REQUEST_LOG_CPU_MS"))));
+        // Project bodies above these bounds are refused with 413 before any DOM is built
+        aeronautical::UploadLimits upload_limits;
+        if (std::getenv("PROJECT_MAX_BODY_MB")) upload_limits.max_body_bytes = static_cast<size_t>(std::max(1, std::stoi(std::getenv("PROJECT_MAX_BODY_MB")))) << 20;
+        if (std::getenv("PROJECT_MAX_VERTICES")) upload_limits.max_vertices = static_cast<size_t>(std::max(1, std::stoi(std::getenv("PROJECT_MAX_VERTICES"))));
+        // The frontend served from memory by this process (FRONTEND_DIR, e.g. ../frontend)
+        aeronautical::FrontendSettings frontend;
+        if (std::getenv("FRONTEND_DIR")) frontend.root = std::getenv("FRONTEND_DIR");
+        if (std::getenv("FRONTEND_STREAM_KB")) frontend.stream_bytes = static_cast<size_t>(std::max(1, std::stoi(std::getenv("FRONTEND_STREAM_KB")))) << 10;
+        // Polyline-encoded geometries (?geometry_encoding=polyline), cached per geometry revision
+        if (std::getenv("GEOMETRY_ENCODING_CACHE_MB")) {
+            aeronautical::GeometryEncoder::getInstance().setCacheCapacity(static_cast<size_t>(std::max(0, std::stoi(std::getenv("GEOMETRY_ENCODING_CACHE_MB")))) << 20);
+        }
+
+        // Connection pool shared by HTTP handlers and analysis workers
+        aeronautical::PoolSettings pool_settings;
+        if (std::getenv("DB_POOL_SIZE")) pool_settings.max_size = std::max(1, std::stoi(std::getenv("DB_POOL_SIZE")));
+        if (std::getenv("DB_POOL_MIN_IDLE")) pool_settings.min_idle = std::max(0, std::stoi(std::getenv("DB_POOL_MIN_IDLE")));
+        if (std::getenv("DB_POOL_VALIDATION_INTERVAL_S")) pool_settings.validation_interval = std::chrono::seconds(std::max(1, std::stoi(std::getenv("DB_POOL_VALIDATION_INTERVAL_S"))));
+        if (std::getenv("DB_POOL_MAX_LIFETIME_S")) pool_settings.max_lifetime = std::chrono::seconds(std::max(1, std::stoi(std::getenv("DB_POOL_MAX_LIFETIME_S"))));
+        if (std::getenv("DB_POOL_ACQUIRE_TIMEOUT_MS")) pool_settings.acquire_timeout = std::chrono::milliseconds(std::max(1, std::stoi(std::getenv("DB_POOL_ACQUIRE_TIMEOUT_MS"))));
         
         // Initialize database
+        lifecycle.startupPhase("database");
         logger->info("Connecting to database at {}:{}/{}", db_host, db_port, db_name);
+        // Share of requests traced; 0 keeps only traces the client asked to sample
+        const double trace_sample_rate = std::getenv("TRACE_SAMPLE_RATE") ? std::stod(std::getenv("TRACE_SAMPLE_RATE")) : 0.01;
+        aeronautical::Tracer::getInstance().configure(trace_sample_rate, spdlog::get("trace"));
+        const int slow_query_ms = std::getenv("SLOW_QUERY_MS") ? std::stoi(std::getenv("SLOW_QUERY_MS")) : 500;
+        aeronautical::QueryStats::getInstance().configure(std::chrono::milliseconds(std::max(0, slow_query_ms)), spdlog::get("slow_query"));
+        // DATETIME columns in the process time zone (TIMESTAMP_ZONE=local) or UTC
+        if (const char* zone = std::getenv("TIMESTAMP_ZONE"); zone && std::string(zone) == "utc") {
+            aeronautical::setTimestampZone(aeronautical::TimestampZone::Utc);
+        }
         aeronautical::DatabaseManager::getInstance().initialize(
-            db_host, db_port, db_user, db_pass, db_name
+            db_host, db_port, db_user, db_pass, db_name, pool_settings
         );
+        lifecycle.startupPhase("schema");
+        // Versioned schema changes (indexes, optional tables, derived columns);
+        // DB_MIGRATIONS=0 where the schema is managed elsewhere. The repositories
+        // read which tables and columns exist from the catalog loaded here.
+        // Project and protection GeoJSON at least this long is stored compressed
+        // once its column is binary (migration 4); 0 writes plain text
+        if (std::getenv("GEOMETRY_COMPRESSION_MIN_BYTES")) {
+            aeronautical::GeometryBlob::setMinBytes(static_cast<size_t>(std::max(0, std::stoi(std::getenv("GEOMETRY_COMPRESSION_MIN_BYTES")))));
+        }
+        if (envFlag("DB_MIGRATIONS", true)) {
+            aeronautical::SchemaMigrations::getInstance().run();
+        } else {
+            aeronautical::SchemaMigrations::getInstance().loadCatalog();
+        }
+        // Reads tagged by the repositories go to replicas: DB_REPLICA_HOSTS=host[:port],...
+        if (const char* replica_hosts = std::getenv("DB_REPLICA_HOSTS"); replica_hosts && *replica_hosts) {
+            aeronautical::ReplicaSettings replicas;
+            replicas.endpoints = aeronautical::ReplicaRouter::parseEndpoints(replica_hosts, db_port);
+            if (std::getenv("DB_REPLICA_MAX_LAG_S")) replicas.max_lag = std::chrono::seconds(std::max(0, std::stoi(std::getenv("DB_REPLICA_MAX_LAG_S"))));
+            if (std::getenv("DB_REPLICA_CHECK_INTERVAL_S")) replicas.check_interval = std::chrono::seconds(std::max(1, std::stoi(std::getenv("DB_REPLICA_CHECK_INTERVAL_S"))));
+            aeronautical::DatabaseManager::getInstance().enableReplicas(replicas);
+        }
+        lifecycle.startupPhase("services");
+        // Project and procedure handlers hand their queries to these threads
+        const int db_io_threads = std::getenv("DB_IO_THREADS") ? std::stoi(std::getenv("DB_IO_THREADS")) : static_cast<int>(pool_settings.max_size);
+        const int db_io_max_pending = std::getenv("DB_IO_MAX_PENDING") ? std::stoi(std::getenv("DB_IO_MAX_PENDING")) : 512;
+        aeronautical::DbExecutor::getInstance().start(static_cast<size_t>(std::max(1, db_io_threads)), static_cast<size_t>(std::max(1, db_io_max_pending)), db_io_cpus);
+        const int result_cache_entries = std::getenv("RESULT_CACHE_ENTRIES") ? std::stoi(std::getenv("RESULT_CACHE_ENTRIES")) : 4096;
+        const int result_cache_ttl_s = std::getenv("RESULT_CACHE_TTL_S") ? std::stoi(std::getenv("RESULT_CACHE_TTL_S")) : 30;
+        aeronautical::ResultCache::getInstance().configure(static_cast<size_t>(std::max(0, result_cache_entries)), std::chrono::seconds(std::max(1, result_cache_ttl_s)));
+        // Tiles and simplified geometries kept on disk across restarts
+        aeronautical::DiskCacheSettings disk_cache;
+        disk_cache.enabled = envFlag("DISK_CACHE", true);
+        if (std::getenv("DISK_CACHE_DIR")) disk_cache.directory = std::getenv("DISK_CACHE_DIR");
+        if (std::getenv("DISK_CACHE_MB")) disk_cache.max_bytes = static_cast<uint64_t>(std::max(1, std::stoi(std::getenv("DISK_CACHE_MB")))) << 20;
+        // Each prefork worker keeps its own directory and its share of the budget
+        if (prefork_worker) {
+            if (disk_cache.directory.empty()) disk_cache.directory = (std::filesystem::temp_directory_path() / "aero-cache").string();
+            disk_cache.directory += "." + std::to_string(*prefork_worker);
+            disk_cache.max_bytes /= static_cast<uint64_t>(std::max(1, settingInt("PREFORK_WORKERS", 1)));
+        }
+        aeronautical::DiskCache::getInstance().configure(disk_cache);
+        const int generated_protections = std::getenv("PROTECTION_GENERATOR_CACHE_ENTRIES") ? std::stoi(std::getenv("PROTECTION_GENERATOR_CACHE_ENTRIES")) : 256;
+        aeronautical::ProtectionGenerator::getInstance().setCacheCapacity(static_cast<size_t>(std::max(0, generated_protections)));
+        aeronautical::ConflictRepository::probeSpatialSupport();
+        if (!worker_mode) {
+            aeronautical::TokenVerifier::getInstance().start(token_settings);
+            logger->info("Bearer token verification {}", aeronautical::TokenVerifier::getInstance().enabled() ? "enabled" : "disabled (any bearer token accepted)");
+        }
+        
+        // Airports and waypoints are served from memory; 0 disables the periodic reload.
+        // With REFERENCE_SNAPSHOT_PATH each load is also kept on disk and restored on restart.
+        // The first load happens during warm-up, once the server listens.
+        if (reference_cache) {
+            aeronautical::ReferenceDataStore::getInstance().setSnapshotPath(reference_snapshot_path);
+        }
+        logger->info("Reference data cache {}", reference_cache ? "enabled" : "disabled");
         
+        // Conflict engine: GEOS prepared geometries for protection zones
+        aeronautical::GeosBackend::setEnabled(geos_backend);
+        logger->info("Conflict geometry backend: {}", aeronautical::GeosBackend::available()
+                                                          ? "GEOS, one context per thread" : "OGR");
+        aeronautical::ProtectionGeometryCache::getInstance().setPreparedGeometryEnabled(prepared_geometry);
+        logger->info("Prepared geometry predicates {}", prepared_geometry ? "enabled" : "disabled");
+        aeronautical::ProtectionGeometryCache::getInstance().setTileVertexBudget(static_cast<size_t>(std::max(0, protection_tile_vertices)));
+        // One sub-pool per NUMA node on multi-socket machines; nothing changes on one node
+        aeronautical::ConflictController::getInstance().setAnalysisThreads(std::max(1, analysis_threads), analysis_cpus,
+                                                                           envFlag("ANALYSIS_NUMA", true));
+        aeronautical::ConflictController::getInstance().setDeferredIntersections(deferred_intersections);
+        aeronautical::ConflictMemo::getInstance().setCapacity(static_cast<size_t>(std::max(0, analysis_memo_mb)) << 20);
+        logger->info("Conflict result memo {}", analysis_memo_mb > 0 ? fmt::format("{} MB", analysis_memo_mb) : "disabled");
+        aeronautical::ConflictController::getInstance().setTriage(analysis_triage);
+        aeronautical::ConflictController::getInstance().setCoverageMask(coverage_mask);
+        // A sample of analyses is rerun by the plain reference engine and compared; nothing of it is stored
+        aeronautical::AnalysisShadow::getInstance().configure(
+            setting("ANALYSIS_SHADOW_SAMPLE") ? std::stod(*setting("ANALYSIS_SHADOW_SAMPLE")) : 0.0,
+            setting("ANALYSIS_SHADOW_AREA_TOLERANCE") ? std::stod(*setting("ANALYSIS_SHADOW_AREA_TOLERANCE")) : 0.01);
+        logger->info("Conflict intersection geometry {}", analysis_triage ? "deferred, overlap metrics computed (triage)"
+                                                          : deferred_intersections ? "computed on request"
+                                                                                   : "computed during analysis");
+        // Only the GDAL drivers for the DEM and tiles, registered on first use
+        aeronautical::setGdalAllDrivers(envFlag("GDAL_ALL_DRIVERS", false));
+        if (std::getenv("DEM_PATH")) {
+            lifecycle.startupPhase("terrain");
+            const int dem_cache_tiles = std::getenv("DEM_CACHE_TILES") ? std::stoi(std::getenv("DEM_CACHE_TILES")) : 256;
+            aeronautical::TerrainService::getInstance().open(std::getenv("DEM_PATH"),
+                                                             static_cast<size_t>(std::max(1, dem_cache_tiles)));
+        }
+        // Uploaded plans: thumbnails, OCR (with Tesseract) and coordinate
+        // extraction on their own pool, results cached by content hash
+        aeronautical::DocumentSettings documents;
+        documents.enabled = envFlag("DOCUMENTS", true);
+        if (std::getenv("DOCUMENT_WORKERS")) documents.workers = static_cast<size_t>(std::max(1, std::stoi(std::getenv("DOCUMENT_WORKERS"))));
+        if (std::getenv("DOCUMENT_QUEUE")) documents.max_queue = static_cast<size_t>(std::max(1, std::stoi(std::getenv("DOCUMENT_QUEUE"))));
+        if (std::getenv("DOCUMENT_MAX_MB")) documents.max_upload_bytes = static_cast<size_t>(std::max(1, std::stoi(std::getenv("DOCUMENT_MAX_MB")))) * 1024 * 1024;
+        if (std::getenv("DOCUMENT_CACHE_ENTRIES")) documents.cache_entries = static_cast<size_t>(std::max(1, std::stoi(std::getenv("DOCUMENT_CACHE_ENTRIES"))));
+        if (std::getenv("DOCUMENT_UPLOAD_SESSIONS")) documents.max_upload_sessions = static_cast<size_t>(std::max(1, std::stoi(std::getenv("DOCUMENT_UPLOAD_SESSIONS"))));
+        if (std::getenv("OCR_LANGUAGE")) documents.ocr_language = std::getenv("OCR_LANGUAGE");
+        if (std::getenv("TESSDATA_PATH")) documents.tessdata_path = std::getenv("TESSDATA_PATH");
+        aeronautical::DocumentPipeline::getInstance().configure(documents);
+        // GeoPackage / Shapefile / KML exports of conflicts and protections, written to EXPORT_DIR
+        aeronautical::ExportSettings exports;
+        exports.enabled = envFlag("EXPORTS", true);
+        if (std::getenv("EXPORT_WORKERS")) exports.workers = static_cast<size_t>(std::max(1, std::stoi(std::getenv("EXPORT_WORKERS"))));
+        if (std::getenv("EXPORT_MAX_JOBS")) exports.max_jobs = static_cast<size_t>(std::max(1, std::stoi(std::getenv("EXPORT_MAX_JOBS"))));
+        if (std::getenv("EXPORT_DIR")) exports.directory = std::getenv("EXPORT_DIR");
+        if (std::getenv("EXPORT_RETENTION_S")) exports.retention = std::chrono::seconds(std::max(60, std::stoi(std::getenv("EXPORT_RETENTION_S"))));
+        aeronautical::ExportService::getInstance().configure(exports);
+        // PDF review dossiers, cached on disk by project revision
+        aeronautical::DossierSettings dossiers;
+        dossiers.enabled = envFlag("DOSSIERS", true);
+        if (std::getenv("DOSSIER_WORKERS")) dossiers.workers = static_cast<size_t>(std::max(1, std::stoi(std::getenv("DOSSIER_WORKERS"))));
+        if (std::getenv("DOSSIER_CACHE_ENTRIES")) dossiers.cache_entries = static_cast<size_t>(std::max(1, std::stoi(std::getenv("DOSSIER_CACHE_ENTRIES"))));
+        if (std::getenv("DOSSIER_DIR")) dossiers.directory = std::getenv("DOSSIER_DIR");
+        if (std::getenv("DOSSIER_MAP_PX")) dossiers.map_px = std::stoi(std::getenv("DOSSIER_MAP_PX"));
+        aeronautical::ProjectDossier::getInstance().configure(dossiers);
+        // Offline MBTiles packs of a region, rendered through the tile cache
+        aeronautical::TilePackSettings tile_packs;
+        tile_packs.enabled = envFlag("TILE_PACKS", true);
+        if (std::getenv("TILE_PACK_WORKERS")) tile_packs.workers = static_cast<size_t>(std::max(1, std::stoi(std::getenv("TILE_PACK_WORKERS"))));
+        if (std::getenv("TILE_PACK_MAX_JOBS")) tile_packs.max_jobs = static_cast<size_t>(std::max(1, std::stoi(std::getenv("TILE_PACK_MAX_JOBS"))));
+        if (std::getenv("TILE_PACK_MAX_TILES")) tile_packs.max_tiles = static_cast<size_t>(std::max(1, std::stoi(std::getenv("TILE_PACK_MAX_TILES"))));
+        if (std::getenv("TILE_PACK_DIR")) tile_packs.directory = std::getenv("TILE_PACK_DIR");
+        if (std::getenv("TILE_PACK_RETENTION_S")) tile_packs.retention = std::chrono::seconds(std::max(60, std::stoi(std::getenv("TILE_PACK_RETENTION_S"))));
+        aeronautical::TilePackService::getInstance().configure(tile_packs);
+        // project_comments rows (status changes) batched off the request path
+        aeronautical::AuditSettings audit;
+        audit.async = envFlag("AUDIT_ASYNC", true);
+        if (std::getenv("AUDIT_FLUSH_MS")) audit.flush_interval = std::chrono::milliseconds(std::max(1, std::stoi(std::getenv("AUDIT_FLUSH_MS"))));
+        if (std::getenv("AUDIT_BATCH")) audit.max_batch = static_cast<size_t>(std::max(1, std::stoi(std::getenv("AUDIT_BATCH"))));
+        if (std::getenv("AUDIT_QUEUE")) audit.max_queue = static_cast<size_t>(std::max(1, std::stoi(std::getenv("AUDIT_QUEUE"))));
+        aeronautical::AuditWriter::getInstance().start(audit);
+        if (std::getenv("OBSTACLE_BUFFER_M")) {
+            aeronautical::ConflictController::getInstance().setObstacleBuffer(std::stod(std::getenv("OBSTACLE_BUFFER_M")));
+            logger->info("Point and line features buffered by {} m before conflict checks",
+                         aeronautical::ConflictController::getInstance().obstacleBuffer());
+        }
+        // Decimals of the conflict geometries analyses store (7: ~1 cm)
+        if (std::getenv("CONFLICT_GEOMETRY_PRECISION")) {
+            aeronautical::GeometryJson::setPrecision(std::stoi(std::getenv("CONFLICT_GEOMETRY_PRECISION")));
+        }
+        if (std::getenv("PROFILE_MARGIN_FT")) {
+            aeronautical::ConflictController::getInstance().setProfileMargin(std::stod(std::getenv("PROFILE_MARGIN_FT")));
+        }
+        registerLiveSettings();
+        // One budget over the caches that can give memory back, trimmed before the cgroup limit is reached
+        aeronautical::MemoryGovernor::getInstance().add(
+            "conflict_memo",
+            aeronautical::MemoryGovernor::Cache{[]() { return aeronautical::ConflictMemo::getInstance().bytes(); },
+                                                [](size_t target) { return aeronautical::ConflictMemo::getInstance().trim(target); },
+                                                4.0});
+        aeronautical::MemorySettings memory;
+        memory.cache_budget = static_cast<size_t>(std::max(0, settingInt("MEMORY_CACHE_BUDGET_MB", 0))) << 20;
+        memory.limit = static_cast<size_t>(std::max(0, settingInt("MEMORY_LIMIT_MB", 0))) << 20;
+        if (auto v = setting("MEMORY_HIGH_WATERMARK")) memory.high_watermark = std::clamp(std::stod(*v), 0.5, 0.99);
+        memory.interval = std::chrono::milliseconds(std::max(100, settingInt("MEMORY_GOVERNOR_INTERVAL_MS", 1000)));
+        aeronautical::MemoryGovernor::getInstance().start(memory);
+        lifecycle.startupPhase("analysis_jobs");
+        // Procedure and reference changes made through other instances, read from
+        // cache_events when the table exists; 0 keeps invalidations local
+        const int cache_events_poll_ms = std::getenv("CACHE_EVENTS_POLL_MS") ? std::stoi(std::getenv("CACHE_EVENTS_POLL_MS")) : 1000;
+        aeronautical::CacheEvents::getInstance().start(analysis_worker_id, std::chrono::milliseconds(std::max(0, cache_events_poll_ms)));
+        // Conflicts of closed projects move to conflicts_archive; 0 days keeps them all hot
+        aeronautical::ConflictArchiveSettings archive;
+        archive.after = std::chrono::hours(24 * std::max(0, settingInt("CONFLICT_ARCHIVE_AFTER_DAYS", 30)));
+        archive.interval = std::chrono::minutes(std::max(1, settingInt("CONFLICT_ARCHIVE_INTERVAL_MIN", 60)));
+        aeronautical::ConflictArchiver::getInstance().start(archive);
+        if (analysis_persist && aeronautical::AnalysisJobStore::probeTable()) {
+            aeronautical::AnalysisJobQueue::getInstance().persistTo(std::make_unique<aeronautical::AnalysisJobStore>(
+                analysis_worker_id, std::chrono::seconds(analysis_lease_s)));
+            logger->info("Analysis jobs leased as {} for {} s", analysis_worker_id, analysis_lease_s);
+        } else if (worker_mode || prefork_worker) {
+            // A prefork worker's in-memory jobs could not be polled through the others
+            logger->critical("{} needs the analysis_jobs table and ANALYSIS_JOB_PERSISTENCE enabled",
+                             worker_mode ? "Worker mode" : "Prefork");
+            spdlog::shutdown();
+            return 1;
+        }
+        // Queued jobs gain one priority level per ANALYSIS_AGING_S waited (0: strict priority)
+        if (std::getenv("ANALYSIS_AGING_S")) {
+            aeronautical::AnalysisJobQueue::getInstance().setAging(std::chrono::seconds(std::stoi(std::getenv("ANALYSIS_AGING_S"))));
+        }
+        // Organizations share the workers by weight ("name=weight;..." in ANALYSIS_ORG_WEIGHTS), each
+        // running at most ANALYSIS_ORG_MAX_RUNNING jobs ("name=n;...", default ANALYSIS_ORG_DEFAULT_MAX_RUNNING)
+        {
+            aeronautical::OrganizationShares shares;
+            if (setting("ANALYSIS_ORG_DEFAULT_WEIGHT")) {
+                shares.default_weight = std::stod(*setting("ANALYSIS_ORG_DEFAULT_WEIGHT"));
+            }
+            if (setting("ANALYSIS_ORG_WEIGHTS")) {
+                shares.weights = aeronautical::OrganizationShares::parseList(*setting("ANALYSIS_ORG_WEIGHTS"));
+            }
+            shares.default_max_running = static_cast<size_t>(std::max(0, settingInt("ANALYSIS_ORG_DEFAULT_MAX_RUNNING", 0)));
+            if (setting("ANALYSIS_ORG_MAX_RUNNING")) {
+                for (const auto& [organization, cap] :
+                     aeronautical::OrganizationShares::parseList(*setting("ANALYSIS_ORG_MAX_RUNNING"))) {
+                    shares.max_running[organization] = static_cast<size_t>(std::max(0.0, cap));
+                }
+            }
+            if (!shares.weights.empty() || !shares.max_running.empty() || shares.default_max_running > 0) {
+                logger->info("Analysis shares: {} weighted organizations, {} capped, default cap {}",
+                             shares.weights.size(), shares.max_running.size(), shares.default_max_running);
+            }
+            aeronautical::AnalysisJobQueue::getInstance().setOrganizationShares(std::move(shares));
+        }
+        // Projects meeting the same airports' protection shards prefer one analysis worker
+        if (envFlag("ANALYSIS_REGIONS", true)) {
+            aeronautical::AnalysisJobQueue::getInstance().setRegionKey([](int project_id) -> uint64_t {
+                const auto envelope = aeronautical::ProjectSpatialIndex::getInstance().envelope(project_id);
+                return envelope ? aeronautical::ConflictController::getInstance().regionOf(*envelope) : 0;
+            });
+        }
+        // ANALYSIS_WORKERS=0 with analysis_jobs leaves every analysis to --worker processes
+        aeronautical::AnalysisJobQueue::getInstance().start(
+            std::max(worker_mode ? 1 : 0, analysis_workers), std::max(1, analysis_queue_capacity),
+            [](const aeronautical::AnalysisJob& job) {
+                aeronautical::ConflictController::getInstance().analyzeProject(job.project_id, job.progress.get());
+            },
+            analysis_cpus);
+        if (!analysis_checkpoint_path.empty()) {
+            aeronautical::AnalysisJobQueue::getInstance().resumeCheckpoint(analysis_checkpoint_path);
+        }
+
+        if (worker_mode) {
+            // Conflicts and project status are written straight to MySQL;
+            // HTTP nodes see them once their result cache TTL runs out
+            lifecycle.startupPhase("warm_up");
+            lifecycle.warmUp("protection_index", []() {
+                return aeronautical::ConflictController::getInstance().warmUp() > 0;
+            });
+            lifecycle.markReady();
+            logger->info("Analysis worker {} waiting for jobs", analysis_worker_id);
+
+            const int signal_number = waitForTermination(termination);
+            logger->info("Signal {} received; releasing queued jobs and finishing running ones", signal_number);
+            lifecycle.beginDrain();
+            aeronautical::AnalysisJobQueue::getInstance().drain();
+            aeronautical::AnalysisJobQueue::getInstance().shutdown();
+            aeronautical::CacheEvents::getInstance().stop();
+            aeronautical::ConflictArchiver::getInstance().stop();
+            aeronautical::MemoryGovernor::getInstance().stop();
+            aeronautical::DbExecutor::getInstance().shutdown();
+            spdlog::shutdown();
+            return 0;
+        }
+        
+        lifecycle.startupPhase("http_setup");
         // Create Crow application
-        crow::SimpleApp app;
+        aeronautical::HttpApp app;
+        // HTTPS straight from the app when a certificate is given, instead of
+        // a TLS proxy in front
+        aeronautical::TlsSettings tls;
+        if (const char* v = std::getenv("TLS_CERT_FILE")) tls.cert_file = v;
+        if (const char* v = std::getenv("TLS_KEY_FILE")) tls.key_file = v;
+        if (const char* v = std::getenv("TLS_CIPHERS")) tls.ciphers = v;
+        if (const char* v = std::getenv("TLS_CIPHERSUITES")) tls.ciphersuites = v;
+        if (const char* v = std::getenv("TLS_GROUPS")) tls.groups = v;
+        if (const char* v = std::getenv("TLS_SESSION_CACHE_SIZE")) tls.session_cache_size = std::stol(v);
+        if (const char* v = std::getenv("TLS_SESSION_TIMEOUT_S")) tls.session_timeout_s = std::stol(v);
+        if (const char* v = std::getenv("TLS_TICKET_KEY_FILE")) tls.ticket_key_file = v;
+        if (tls.enabled()) {
+#ifdef CROW_ENABLE_SSL
+            std::string tls_error;
+            auto context = aeronautical::TlsContext::getInstance().build(tls, tls_error);
+            if (!context) {
+                logger->critical("TLS not configured: {}", tls_error);
+                return 1;
+            }
+            app.ssl(std::move(*context));
+#else
+            logger->critical("TLS_CERT_FILE is set but the server was built with ENABLE_TLS=OFF");
+            return 1;
+#endif
+        }
+        app.get_middleware<aeronautical::RequestMetrics>().configure(request_accounting);
+        if (request_accounting.enabled) {
+            logger->info("Request accounting enabled (logging requests over {} MB or {} ms CPU)",
+                         request_accounting.log_alloc_bytes >> 20, request_accounting.log_cpu.count());
+        }
+        app.get_middleware<aeronautical::ResponseCompression>().configure(compression);
+        logger->info("Response compression {} (min {} bytes, level {}, brotli {})", compression.enabled ? "enabled" : "disabled",
+                     compression.min_bytes, compression.level, aeronautical::ResponseCompression::brotliAvailable() ? "yes" : "no");
+        app.get_middleware<aeronautical::AdmissionControl>().configure(admission);
+        logger->info("Admission control {} ({} requests/s per client, burst {})", admission.enabled ? "enabled" : "disabled",
+                     admission.client_rate, admission.client_burst);
+        app.get_middleware<aeronautical::BinaryFormat>().configure(binary_format);
+        app.get_middleware<aeronautical::ResponseCache>().configure(response_cache);
+        logger->info("Response cache {} ({} MB, {} s TTL)", response_cache.enabled ? "enabled" : "disabled",
+                     response_cache.max_bytes >> 20, response_cache.ttl.count());
+        logger->info("CBOR/MessagePack responses {}", binary_format.enabled ? "enabled" : "disabled");
+        registerLiveHttpSettings(app);
+        governHttpCaches(app);
         
         // Setup CORS
         setupCORS(app);
+
+        aeronautical::FrontendController frontendController;
+        const bool serve_frontend = frontendController.load(frontend);
+        if (!frontend.root.empty() && !serve_frontend) {
+            logger->warn("FRONTEND_DIR {} is not a readable directory; frontend not served", frontend.root);
+        }
         
         // Health check endpoint
         CROW_ROUTE(app, "/api/health")
             .methods(crow::HTTPMethod::GET)
-            ([]() {
+            ([&app, &frontendController]() {
                 nlohmann::json response;
                 response["status"] = "healthy";
                 response["service"] = "aeronautical-platform-backend";
                 response["version"] = "1.0.0";
                 response["timestamp"] = std::time(nullptr);
+                response["db_pool"] = aeronautical::DatabaseManager::getInstance().poolMetrics().toJson();
+                response["db_executor"] = aeronautical::DbExecutor::getInstance().stats();
+                response["result_cache"] = aeronautical::ResultCache::getInstance().stats();
+                if (auto* replicas = aeronautical::DatabaseManager::getInstance().replicas()) {
+                    response["db_replicas"] = replicas->status();
+                }
+                response["reference_data"] = aeronautical::ReferenceDataStore::getInstance().status();
+                response["cache_events"] = aeronautical::CacheEvents::getInstance().status();
+                response["schema"] = aeronautical::SchemaMigrations::getInstance().status();
+                response["compression"] = app.get_middleware<aeronautical::ResponseCompression>().stats();
+                response["binary_format"] = app.get_middleware<aeronautical::BinaryFormat>().stats();
+                response["admission"] = app.get_middleware<aeronautical::AdmissionControl>().stats();
+                response["response_cache"] = app.get_middleware<aeronautical::ResponseCache>().stats();
+                response["frontend"] = frontendController.stats();
+                response["lifecycle"] = aeronautical::Lifecycle::getInstance().status();
+                response["token_verification"] = aeronautical::TokenVerifier::getInstance().stats();
+                response["access_profile"] = aeronautical::AccessProfile::getInstance().stats();
                 
                 crow::response res(200, response.dump());
                 res.add_header("Content-Type", "application/json");
                 return res;
             });
         
+        // Prometheus scrape target
+        exposeMetrics(app);
+        CROW_ROUTE(app, "/metrics")
+            .methods(crow::HTTPMethod::GET)
+            ([]() {
+                crow::response res(200, aeronautical::Metrics::getInstance().render());
+                res.add_header("Content-Type", "text/plain; version=0.0.4; charset=utf-8");
+                return res;
+            });
+        
+        // Per-query-shape timings and the latest slow statements; ?limit= caps the shapes listed
+        CROW_ROUTE(app, "/api/metrics/queries")
+            .methods(crow::HTTPMethod::GET)
+            ([](const crow::request& req) {
+                int limit = 50;
+                if (const char* limit_text = req.url_params.get("limit")) {
+                    limit = std::clamp(std::atoi(limit_text), 1, 1000);
+                }
+                crow::response res(200, aeronautical::QueryStats::getInstance().snapshot(static_cast<size_t>(limit)).dump());
+                res.add_header("Content-Type", "application/json");
+                return res;
+            });
+        
         // Register controllers
         aeronautical::ProjectController projectController;
+        projectController.setUploadLimits(upload_limits);
+        // Outward-only vertex reduction of uploaded polygons, tolerance in
+        // metres (0 drops collinear vertices only); unset keeps uploads as sent
+        if (std::getenv("INGEST_REDUCE_TOLERANCE_M")) {
+            const double tolerance = std::max(0.0, std::stod(std::getenv("INGEST_REDUCE_TOLERANCE_M")));
+            projectController.setVertexReduction(tolerance);
+            logger->info("Uploaded polygons reduced within {} m, outward only", tolerance);
+        }
         projectController.registerRoutes(app);
         logger->info("Project controller registered");
         
@@ -115,6 +1207,8 @@ int main(int argc, char* argv[]) {
         aeronautical::ConflictController::getInstance().registerRoutes(app);
         logger->info("Conflict controller registered");
 
+        // Map bounds queries answered from per-tile cached rows unless ?snap=none
+        aeronautical::TileCover::setSnapByDefault(envFlag("BOUNDS_SNAP_TILES", false));
         aeronautical::AirportController airportController;
         airportController.registerRoutes(app);
         logger->info("Airport controller registered");
@@ -123,6 +1217,65 @@ int main(int argc, char* argv[]) {
         waypointController.registerRoutes(app);
         logger->info("Waypoint controller registered");
 
+        aeronautical::AnalysisController analysisController;
+        analysisController.registerRoutes(app);
+        logger->info("Analysis controller registered");
+
+        aeronautical::BatchController batchController;
+        batchController.registerRoutes(app);
+        logger->info("Batch controller registered");
+
+        if (serve_frontend) {
+            frontendController.registerRoutes(app);
+        }
+
+        aeronautical::AnalysisEventHub::getInstance().registerRoutes(app);
+        aeronautical::ReferenceDataStore::getInstance().registerRoutes(app);
+        aeronautical::Lifecycle::getInstance().registerRoutes(app);
+
+        aeronautical::VectorTileService::getInstance().setCacheCapacity(static_cast<size_t>(std::max(1, tile_cache_entries)));
+        aeronautical::VectorTileService::getInstance().registerRoutes(app);
+        logger->info("Vector tile routes registered");
+
+        auto& profile = aeronautical::AccessProfile::getInstance();
+        profile.setWarmer(aeronautical::AccessProfile::Kind::Tile, [](const std::string& key) {
+            return aeronautical::VectorTileService::getInstance().warmTile(key);
+        });
+        profile.setWarmer(aeronautical::AccessProfile::Kind::Airport,
+                          [&airportController](const std::string& key) { return airportController.warmBundle(key); });
+        profile.setWarmer(aeronautical::AccessProfile::Kind::Procedure,
+                          [repository = std::make_shared<aeronautical::FlightProcedureRepository>()](const std::string& key) {
+                              auto procedure = repository->findById(std::stoi(key));
+                              if (!procedure) return false;
+                              // Builds, or reads back from the DiskCache, every simplified level
+                              aeronautical::SimplifiedGeometryCache::getInstance().apply(*procedure, 0);
+                              return true;
+                          });
+        profile.start(access_profile);
+
+        aeronautical::DocumentPipeline::getInstance().registerRoutes(app);
+        logger->info("Document routes registered");
+
+        aeronautical::ConflictHeatmap::getInstance().registerRoutes(app);
+        logger->info("Conflict heatmap routes registered");
+
+        aeronautical::ExportService::getInstance().registerRoutes(app);
+        logger->info("Export routes registered");
+
+        aeronautical::ProjectDossier::getInstance().registerRoutes(app);
+        logger->info("Dossier routes registered");
+
+        aeronautical::TilePackService::getInstance().registerRoutes(app);
+        logger->info("Tile pack routes registered");
+
+        registerRuntime(app, http_threads);
+        aeronautical::RuntimeRegistry::getInstance().registerRoutes(app);
+        aeronautical::Config::getInstance().registerRoutes(app);
+        logger->info("Runtime admin routes registered");
+
+        aeronautical::Profiler::getInstance().configure(profiler);
+        aeronautical::Profiler::getInstance().registerRoutes(app);
+
         
         // TODO: Add more controllers as needed
         // aeronautical::GeometryController geometryController;
@@ -132,10 +1285,98 @@ int main(int argc, char* argv[]) {
         // conflictController.registerRoutes(app);
         
         // Start server
-        logger->info("Starting server on port {}", server_port);
+        logger->info("Starting server on port {} with {} HTTP threads", server_port, http_threads);
+        // Crow's workers are created by run() and inherit the main thread's CPU set
+        if (!http_cpus.empty()) {
+            if (aeronautical::pinCurrentThread(http_cpus)) {
+                logger->info("HTTP threads pinned to CPUs {}", aeronautical::formatCpuList(http_cpus));
+            } else {
+                logger->warn("Could not pin HTTP threads to CPUs {}", aeronautical::formatCpuList(http_cpus));
+            }
+        }
+        std::atomic<bool> server_done{false};
+        std::thread drain_thread(drainOnSignal, std::ref(app), std::cref(server_done),
+                                 std::chrono::seconds(std::max(0, drain_delay_s)),
+                                 std::chrono::seconds(std::max(1, drain_timeout_s)));
+        // Liveness answers while the caches fill; readiness waits for them.
+        // The steps are independent, so they run side by side and the time
+        // to ready is that of the slowest.
+        lifecycle.startupPhase("listen");
+        std::thread warm_up_thread([&app, &lifecycle, warm_up, reference_cache, reference_refresh_s]() {
+            app.wait_for_server_start(std::chrono::seconds(30));
+            lifecycle.startupPhase("warm_up");
+            std::vector<std::pair<std::string, aeronautical::Lifecycle::Step>> steps;
+            if (reference_cache) {
+                steps.emplace_back("reference_data", [reference_refresh_s]() {
+                    auto& store = aeronautical::ReferenceDataStore::getInstance();
+                    store.start(std::chrono::seconds(std::max(0, reference_refresh_s)));
+                    return store.snapshot() != nullptr;
+                });
+            }
+            // The project list's bbox and near filters answer 503 until this is in
+            steps.emplace_back("project_index", []() {
+                aeronautical::ProjectRepository repository;
+                return aeronautical::ProjectSpatialIndex::getInstance().load(repository);
+            });
+            // GET /api/projects/search answers 503 until this is in
+            steps.emplace_back("project_search", []() {
+                aeronautical::ProjectRepository repository;
+                return aeronautical::ProjectSearchIndex::getInstance().load(repository);
+            });
+            // Counts conflicts stored before the heatmap existed; once done it finds none
+            steps.emplace_back("conflict_heatmap", []() {
+                return !aeronautical::ConflictHeatmap::probeTables() ||
+                       aeronautical::ConflictHeatmap::getInstance().backfill();
+            });
+            if (warm_up) {
+                steps.emplace_back("db_pool", []() { return aeronautical::DatabaseManager::getInstance().warmUpPool() > 0; });
+                steps.emplace_back("protection_index", []() {
+                    aeronautical::ConflictController::getInstance().warmUp();
+                    return true;
+                });
+            }
+            lifecycle.warmUpConcurrently(steps);
+            lifecycle.markReady();
+        });
+
         app.port(server_port)
-           .multithreaded()
+           .reuse_port(prefork_worker.has_value())
+           .concurrency(static_cast<unsigned int>(std::max(1, http_threads)))
+           .signal_clear()
            .run();
+
+        // Wake the drain thread if the server stopped for another reason
+        server_done = true;
+        pthread_kill(drain_thread.native_handle(), SIGTERM);
+        drain_thread.join();
+        warm_up_thread.join();
+        // Its warmers call into the controllers above
+        aeronautical::AccessProfile::getInstance().stop();
+        // It trims caches held by app's middlewares
+        aeronautical::MemoryGovernor::getInstance().stop();
+
+        // Requests still on a DB thread reference connections owned by app
+        aeronautical::DbExecutor::getInstance().shutdown();
+        // Queued analyses are released to analysis_jobs or saved for the next
+        // start when a checkpoint is configured, else run before the process
+        // exits; running ones finish
+        if (aeronautical::AnalysisJobQueue::getInstance().persistent()) {
+            aeronautical::AnalysisJobQueue::getInstance().drain();
+        } else if (!analysis_checkpoint_path.empty()) {
+            aeronautical::AnalysisJobQueue::writeCheckpoint(analysis_checkpoint_path,
+                                                            aeronautical::AnalysisJobQueue::getInstance().drain());
+        }
+        aeronautical::AnalysisJobQueue::getInstance().shutdown();
+        aeronautical::DocumentPipeline::getInstance().shutdown();
+        aeronautical::ExportService::getInstance().shutdown();
+        aeronautical::ProjectDossier::getInstance().shutdown();
+        aeronautical::TilePackService::getInstance().shutdown();
+        // After the analyses, which record their status changes
+        aeronautical::AuditWriter::getInstance().stop();
+        aeronautical::ReferenceDataStore::getInstance().stop();
+        aeronautical::CacheEvents::getInstance().stop();
+        aeronautical::ConflictArchiver::getInstance().stop();
+        aeronautical::TokenVerifier::getInstance().stop();
         
     } catch (const std::exception& e) {
         if (auto logger = spdlog::get("aeronautical")) {
@@ -143,8 +1384,11 @@ int main(int argc, char* argv[]) {
         } else {
             std::cerr << "Fatal error: " << e.what() << std::endl;
         }
+        spdlog::shutdown();
         return 1;
     }
     
+    // Drains the queued lines
+    spdlog::shutdown();
     return 0;
 }
\ No newline at end of file
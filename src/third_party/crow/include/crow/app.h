@@ -360,6 +360,19 @@ namespace crow
             return bindaddr_;
         }
 
+        /// \brief Set SO_REUSEPORT on the TCP listening socket, so several processes can bind the same port
+        self_t& reuse_port(bool enabled)
+        {
+            reuse_port_ = enabled;
+            return *this;
+        }
+
+        /// \brief Whether the TCP listening socket is bound with SO_REUSEPORT
+        bool reuse_port() const
+        {
+            return reuse_port_;
+        }
+
         /// \brief Disable tcp/ip and use unix domain socket instead
         self_t& local_socket_path(std::string path)
         {
@@ -818,6 +831,7 @@ namespace crow
         std::string server_name_ = std::string("Crow/") + VERSION;
         std::string bindaddr_ = "0.0.0.0";
         bool use_unix_ = false;
+        bool reuse_port_ = false;
         size_t res_stream_threshold_ = 1048576;
         Router router_;
         bool static_routes_added_{false};
@@ -13,7 +13,13 @@
 #include <atomic>
 #include <chrono>
 #include <memory>
+#include <type_traits>
 #include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
 
 #include "crow/http_parser_merged.h"
 #include "crow/common.h"
@@ -396,16 +402,53 @@ namespace crow
 
             if (res.file_info.statResult == 0)
             {
-                std::ifstream is(res.file_info.path.c_str(), std::ios::in | std::ios::binary);
-                std::vector<asio::const_buffer> buffers{1};
-                char buf[16384];
-                is.read(buf, sizeof(buf));
-                while (is.gcount() > 0)
+                const off_t end = res.file_info.length < 0 ? res.file_info.statbuf.st_size : res.file_info.offset + res.file_info.length;
+                off_t offset = res.file_info.offset;
+                int fd = ::open(res.file_info.path.c_str(), O_RDONLY | O_CLOEXEC);
+                if (fd < 0)
+                {
+                    CROW_LOG_ERROR << "Could not open " << res.file_info.path;
+                    close_connection_ = true;
+                }
+#ifdef __linux__
+                // Plain sockets get the file straight from the page cache
+                else if constexpr (std::is_same<Adaptor, SocketAdaptor>::value || std::is_same<Adaptor, UnixSocketAdaptor>::value)
                 {
-                    buffers[0] = asio::buffer(buf, is.gcount());
-                    do_write_sync(buffers);
-                    is.read(buf, sizeof(buf));
+                    const int socket_fd = adaptor_.raw_socket().native_handle();
+                    while (offset < end)
+                    {
+                        const ssize_t sent = ::sendfile(socket_fd, fd, &offset, static_cast<size_t>(end - offset));
+                        if (sent > 0) continue;
+                        error_code ec;
+                        if (sent < 0 && (errno == EAGAIN || errno == EINTR))
+                        {
+                            if (errno == EAGAIN) adaptor_.raw_socket().wait(asio::socket_base::wait_write, ec);
+                            if (!ec) continue;
+                        }
+                        CROW_LOG_ERROR << "sendfile failed for " << res.file_info.path;
+                        close_connection_ = true;
+                        break;
+                    }
+                }
+#endif
+                else
+                {
+                    std::vector<asio::const_buffer> buffers{1};
+                    char buf[16384];
+                    while (offset < end)
+                    {
+                        const ssize_t count = ::pread(fd, buf, static_cast<size_t>(std::min<off_t>(sizeof(buf), end - offset)), offset);
+                        if (count <= 0)
+                        {
+                            close_connection_ = true;
+                            break;
+                        }
+                        buffers[0] = asio::buffer(buf, static_cast<size_t>(count));
+                        do_write_sync(buffers);
+                        offset += count;
+                    }
                 }
+                if (fd >= 0) ::close(fd);
             }
             if (close_connection_)
             {
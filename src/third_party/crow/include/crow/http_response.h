@@ -282,6 +282,9 @@ namespace crow
             std::string path = "";
             struct stat statbuf;
             int statResult;
+            // Part of the file sent, for Range responses; length -1 means to the end
+            off_t offset = 0;
+            off_t length = -1;
         };
 
         /// Return a static file as the response body
@@ -318,6 +321,13 @@ namespace crow
             }
         }
 
+        /// Send only length bytes of the static file starting at offset (for Range responses)
+        void set_static_file_range(off_t offset, off_t length)
+        {
+            file_info.offset = offset;
+            file_info.length = length;
+        }
+
     private:
         bool completed_{};
         std::function<void()> complete_request_handler_;
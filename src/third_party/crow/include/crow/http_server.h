@@ -20,6 +20,7 @@
 #include <cstdint>
 #include <future>
 #include <memory>
+#include <type_traits>
 #include <vector>
 
 #include "crow/version.h"
@@ -83,6 +84,21 @@ namespace crow // NOTE: Already documented in "crow/app.h"
                 return;
             }
 
+#ifdef SO_REUSEPORT
+            if constexpr (std::is_same<Acceptor, TCPAcceptor>::value)
+            {
+                if (handler->reuse_port())
+                {
+                    acceptor_.raw_acceptor().set_option(asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>(true), ec);
+                    if (ec) {
+                        CROW_LOG_ERROR << "Failed to set SO_REUSEPORT: " << ec.message();
+                        startup_failed_ = true;
+                        return;
+                    }
+                }
+            }
+#endif
+
             acceptor_.raw_acceptor().bind(endpoint, ec);
             if (ec) {
                 CROW_LOG_ERROR << "Failed to bind to " << acceptor_.address()